@@ -20,235 +20,222 @@
   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 */
 
+/* Build a forest on the tetgen bunny in a way that scales to many processes.
+ * Usage: t8_bunny [options] <tetgen file prefix>
+ * Each stage works on a partitioned cmesh, such that no process holds the
+ * whole mesh:
+ *  - The .node and .ele files are read partitioned, each process parses
+ *    only its part of the files.
+ *  - The trees are repartitioned along a space-filling curve of their
+ *    centroids, which gives compact partitions.
+ *  - The cmesh is refined in place with -c, each process refines its own
+ *    trees without communication.
+ *  - A uniform forest of level -l is created on the cmesh and the elements
+ *    in a cylinder through the bunny are refined -r times.
+ * At the end the runtimes of the stages are printed as statistics over
+ * the processes. */
+
 #include <sc_options.h>
+#include <sc_statistics.h>
 #include <t8.h>
 #include <t8_cmesh.h>
 #include <t8_cmesh_tetgen.h>
-#include <t8_cmesh_vtk.h>
 #include <t8_forest.h>
 #include <t8_default_cxx.hxx>
-#include <p8est.h>
-#include <p8est_connectivity.h>
-#include <p8est_tets_hexes.h>
-#include <sc_flops.h>
-#include <sc_statistics.h>
-#include <sc_options.h>
 
+/* The stages whose runtime is measured */
+typedef enum
+{
+  BUNNY_READ = 0,               /* partitioned read of the tetgen files */
+  BUNNY_REORDER,                /* space-filling curve reordering */
+  BUNNY_CMESH_REFINE,           /* in place refinement of the cmesh */
+  BUNNY_FOREST_NEW,             /* uniform forest */
+  BUNNY_FOREST_ADAPT,           /* refinement of the cylinder */
+  BUNNY_TOTAL,                  /* all of the above */
+  BUNNY_NUM_STATS
+} bunny_stats_t;
+
+static const char  *bunny_stat_names[BUNNY_NUM_STATS] = {
+  "read", "reorder", "cmesh_refine", "forest_new", "forest_adapt", "total"
+};
+
+/* The bounding box of the bunny */
 typedef struct
 {
   double              xm, xM, ym, yM, zm, zM;
 }
 box_t;
 
-#if 0
-
-/** Get the coordinates of the midpoint of a quadrant.
- *
- * \param [in]  p4est      the forest
- * \param [in]  which_tree the tree in the forest containing \a q
- * \param [in]  q          the quadrant
- * \param [out] xyz        the coordinates of the midpoint of \a q
- */
-static void
-bunny_get_midpoint (p8est_t * p8est, p4est_topidx_t which_tree,
-                    p8est_quadrant_t * q, double xyz[3])
+/* The refinement of the cylinder */
+typedef struct
 {
-  p4est_qcoord_t      half_length = P8EST_QUADRANT_LEN (q->level) / 2;
-
-  p8est_qcoord_to_vertex (p8est->connectivity, which_tree,
-                          q->x + half_length, q->y + half_length,
-                          q->z + half_length, xyz);
-}
+  box_t               box;      /* The box that defines the cylinder */
+  int                 max_level;        /* Elements are not refined
+                                           above this level */
+} bunny_refine_t;
 
 /* Refine if we lie in a cylinder defined by a bounding box */
 static int
-bunny_refine (p8est_t * p8est, p4est_topidx_t which_tree,
-              p8est_quadrant_t * quadrant)
+bunny_refine (t8_forest_t forest, t8_forest_t forest_from,
+              t8_locidx_t which_tree, t8_locidx_t lelement_id,
+              t8_eclass_scheme_c * ts, int num_elements,
+              t8_element_t * elements[])
 {
-  box_t              *box;
+  const bunny_refine_t *refine;
+  const box_t        *box;
   double              coords[3];
   double              R, r;
 
-  box = (box_t *) p8est->user_pointer;
-
-  bunny_get_midpoint (p8est, which_tree, quadrant, coords);
+  refine = (const bunny_refine_t *) t8_forest_get_user_data (forest);
+  box = &refine->box;
+  if (ts->t8_element_level (elements[0]) >= refine->max_level) {
+    return 0;
+  }
+  t8_forest_element_centroid (forest_from, which_tree, elements[0],
+                              t8_forest_get_tree_vertices (forest_from,
+                                                           which_tree),
+                              coords);
   R = (box->xM - box->xm) / 4.;
   r = (coords[1] - box->ym) / (box->yM - box->ym) * R;
-  if (pow ((coords[0] - (box->xM + box->xm) / 2), 2)
-      + pow ((coords[2] - (box->zM + box->zm) / 2), 2) <= r * r) {
-    return 1;
+  return pow ((coords[0] - (box->xM + box->xm) / 2), 2)
+    + pow ((coords[2] - (box->zM + box->zm) / 2), 2) <= r * r;
+}
+
+/* Run all stages and print their runtimes */
+static void
+bunny_run (const char *prefix, int cmesh_level, int level, int rlevel,
+           int do_vtk, sc_MPI_Comm comm)
+{
+  sc_statinfo_t       stats[BUNNY_NUM_STATS];
+  t8_cmesh_t          cmesh, cmesh_refined;
+  t8_forest_t         forest, forest_adapt;
+  bunny_refine_t      refine;
+  double              total_time, stage_time;
+  int                 i;
+
+  for (i = 0; i < BUNNY_NUM_STATS; i++) {
+    sc_stats_init (&stats[i], bunny_stat_names[i]);
   }
-  else
-    return 0;
+  total_time = -sc_MPI_Wtime ();
+
+  /* Each process reads its part of the tetgen files */
+  stage_time = -sc_MPI_Wtime ();
+  cmesh = t8_cmesh_from_tetgen_file ((char *) prefix, 1, comm, 0);
+  SC_CHECK_ABORTF (cmesh != NULL, "Failed to read tetgen %s", prefix);
+  sc_stats_set1 (&stats[BUNNY_READ], stage_time + sc_MPI_Wtime (),
+                 bunny_stat_names[BUNNY_READ]);
+  t8_global_productionf ("Read %lli tets\n",
+                         (long long) t8_cmesh_get_num_trees (cmesh));
+
+  /* Sort the trees along a space-filling curve */
+  stage_time = -sc_MPI_Wtime ();
+  cmesh = t8_cmesh_reorder_sfc (cmesh, comm);
+  sc_stats_set1 (&stats[BUNNY_REORDER], stage_time + sc_MPI_Wtime (),
+                 bunny_stat_names[BUNNY_REORDER]);
+
+  /* Refine the partitioned cmesh in place */
+  stage_time = -sc_MPI_Wtime ();
+  if (cmesh_level > 0) {
+    t8_cmesh_init (&cmesh_refined);
+    t8_cmesh_set_derive (cmesh_refined, cmesh);
+    t8_cmesh_set_refine (cmesh_refined, cmesh_level,
+                         t8_scheme_new_default_cxx ());
+    t8_cmesh_commit (cmesh_refined, comm);
+    cmesh = cmesh_refined;
+  }
+  sc_stats_set1 (&stats[BUNNY_CMESH_REFINE], stage_time + sc_MPI_Wtime (),
+                 bunny_stat_names[BUNNY_CMESH_REFINE]);
+  t8_global_productionf ("The cmesh has %lli trees\n",
+                         (long long) t8_cmesh_get_num_trees (cmesh));
+
+  /* Create a uniform forest */
+  stage_time = -sc_MPI_Wtime ();
+  forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (),
+                                  level, 0, comm);
+  sc_stats_set1 (&stats[BUNNY_FOREST_NEW], stage_time + sc_MPI_Wtime (),
+                 bunny_stat_names[BUNNY_FOREST_NEW]);
+
+  /* Refine the elements in a cylinder through the bunny */
+  stage_time = -sc_MPI_Wtime ();
+  if (rlevel > 0) {
+    refine.box.xm = refine.box.ym = refine.box.zm = -6;
+    refine.box.xM = refine.box.yM = refine.box.zM = 7;
+    refine.max_level = level + rlevel;
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_user_data (forest_adapt, &refine);
+    t8_forest_set_adapt (forest_adapt, forest, bunny_refine, 1);
+    t8_forest_set_partition (forest_adapt, NULL, 0);
+    t8_forest_commit (forest_adapt);
+    forest = forest_adapt;
+  }
+  sc_stats_set1 (&stats[BUNNY_FOREST_ADAPT], stage_time + sc_MPI_Wtime (),
+                 bunny_stat_names[BUNNY_FOREST_ADAPT]);
+  total_time += sc_MPI_Wtime ();
+  sc_stats_set1 (&stats[BUNNY_TOTAL], total_time,
+                 bunny_stat_names[BUNNY_TOTAL]);
+  t8_global_productionf ("The forest has %lli elements\n",
+                         (long long)
+                         t8_forest_get_global_num_elements (forest));
+
+  if (do_vtk) {
+    t8_forest_write_vtk (forest, "t8_bunny");
+  }
+  t8_forest_unref (&forest);
+
+  sc_stats_compute (comm, BUNNY_NUM_STATS, stats);
+  sc_stats_print (t8_get_package_id (), SC_LP_ESSENTIAL, BUNNY_NUM_STATS,
+                  stats, 1, 1);
 }
-#endif
 
 int
 main (int argc, char **argv)
 {
-  int                 mpiret;
-  int                 mpirank;
-  const char         *argbasename;
-/* char                afilename[BUFSIZ]; */
-  p4est_topidx_t      tnum_flips;
-  p8est_tets_t       *ptg;
-  p8est_connectivity_t *connectivity;
-  sc_MPI_Comm         mpicomm;
-#if 0
-  box_t               Box_ex1;
-#endif
-  sc_flopinfo_t       fi, snapshot;
-  sc_statinfo_t       stats[9];
-
-  t8_cmesh_t          cmesh_p8, cmesh_t8;
-  t8_forest_t         forest_p8, forest_t8;
-
-  const int           level = 4;
+  int                 mpiret, first_argc, helpme = 0, retval = 0;
+  int                 cmesh_level, level, rlevel, do_vtk;
+  sc_options_t       *opt;
 
   mpiret = sc_MPI_Init (&argc, &argv);
   SC_CHECK_MPI (mpiret);
 
-  mpicomm = sc_MPI_COMM_WORLD;
-  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
-
-  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
-  p4est_init (NULL, SC_LP_STATISTICS);
-  t8_init (SC_LP_DEFAULT);
-
-  if (argc != 2) {
-    SC_GLOBAL_LERRORF ("Usage: %s <tetgen file base name>\n", argv[0]);
-    sc_abort ();
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_PRODUCTION);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &helpme,
+                         "Display a short help message.");
+  sc_options_add_int (opt, 'c', "cmesh-level", &cmesh_level, 0,
+                      "Refine each tet of the cmesh into 8^c trees.");
+  sc_options_add_int (opt, 'l', "level", &level, 4,
+                      "The uniform level of the forest.");
+  sc_options_add_int (opt, 'r', "rlevel", &rlevel, 0,
+                      "The number of levels refined in a cylinder through "
+                      "the bunny.");
+  sc_options_add_switch (opt, 'o', "vtk", &do_vtk,
+                         "Write the final forest to vtk.");
+
+  first_argc = sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt,
+                                 argc, argv);
+  if (helpme) {
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt,
+                            "<tetgen file prefix>");
   }
-  argbasename = argv[1];
-
-#if 0
-  Box_ex1.xm = -6;
-  Box_ex1.ym = -6;
-  Box_ex1.zm = -6;
-  Box_ex1.xM = 7;
-  Box_ex1.yM = 7;
-  Box_ex1.zM = 7;
-#endif
-
-  sc_flops_start (&fi);
-  sc_flops_snap (&fi, &snapshot);
-  /* read tetgen nodes and tetrahedra from files */
-  ptg = p8est_tets_read (argbasename);
-
-  sc_flops_shot (&fi, &snapshot);
-  sc_stats_set1 (&stats[0], snapshot.iwtime, "Read");
-  sc_flops_snap (&fi, &snapshot);
-
-  SC_CHECK_ABORTF (ptg != NULL, "Failed to read tetgen %s", argbasename);
-  P4EST_GLOBAL_STATISTICSF ("Read %d nodes and %d tets %s attributes\n",
-                            (int) ptg->nodes->elem_count / 3,
-                            (int) ptg->tets->elem_count / 4,
-                            ptg->tet_attributes != NULL ? "with" : "without");
-
-  /* flip orientation to right-handed */
-  tnum_flips = p8est_tets_make_righthanded (ptg);
-  P4EST_GLOBAL_STATISTICSF ("Performed %ld orientation flip(s)\n",
-                            (long) tnum_flips);
-
-  sc_flops_shot (&fi, &snapshot);
-  sc_stats_set1 (&stats[1], snapshot.iwtime, "Right handed");
-
-  /* create a connectivity from the tet mesh and save it */
-  if (mpirank == 0) {
-    connectivity = p8est_connectivity_new_tets (ptg);
+  else if (first_argc >= 0 && first_argc == argc - 1 && cmesh_level >= 0
+           && level >= 0 && rlevel >= 0) {
+    bunny_run (argv[first_argc], cmesh_level, level, rlevel, do_vtk,
+               sc_MPI_COMM_WORLD);
   }
   else {
-    connectivity = NULL;
+    /* wrong usage */
+    t8_global_productionf ("\n\tERROR: Wrong usage.\n\n");
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt,
+                            "<tetgen file prefix>");
+    retval = 1;
   }
-  sc_flops_snap (&fi, &snapshot);
-  connectivity =
-    p8est_connectivity_bcast (connectivity, 0, sc_MPI_COMM_WORLD);
-
-  sc_flops_shot (&fi, &snapshot);
-  sc_stats_set1 (&stats[2], snapshot.iwtime, "Bcast");
-  sc_flops_snap (&fi, &snapshot);
-
-  P4EST_GLOBAL_LDEBUGF ("Created and broadcasted %s\n", "conn");
-
-  p8est_connectivity_complete (connectivity);
-  sc_flops_shot (&fi, &snapshot);
-  sc_stats_set1 (&stats[3], snapshot.iwtime, "Connectivity complete");
-
-  P4EST_GLOBAL_LDEBUGF ("Connectivity has %ld edges and %ld corners\n",
-                        (long) connectivity->num_edges,
-                        (long) connectivity->num_corners);
-  sc_flops_snap (&fi, &snapshot);
-
-  cmesh_p8 = t8_cmesh_new_from_p8est (connectivity, sc_MPI_COMM_WORLD, 0);
-
-  sc_flops_shot (&fi, &snapshot);
-  sc_stats_set1 (&stats[4], snapshot.iwtime, "Cmesh from Connectivity");
-  sc_flops_snap (&fi, &snapshot);
-
-  /*
-     if (mpirank == 0) {
-     snprintf (afilename, BUFSIZ, "%s", "read_tetgen.p8c");
-     retval = p8est_connectivity_save (afilename, connectivity);
-     SC_CHECK_ABORT (retval == 0, "Failed connectivity_save");
-     }
-   */
-
-  /* create a forest and visualize */
-
-  sc_flops_snap (&fi, &snapshot);
-
-  t8_forest_init (&forest_p8);
-  t8_forest_set_cmesh (forest_p8, cmesh_p8, sc_MPI_COMM_WORLD);
-  t8_forest_set_level (forest_p8, level);
-  t8_forest_set_scheme (forest_p8, t8_scheme_new_default_cxx ());
-  sc_flops_shot (&fi, &snapshot);
-  sc_stats_set1 (&stats[5], snapshot.iwtime, "t8 forest p8 New level 4");
-  sc_flops_snap (&fi, &snapshot);
-  t8_forest_commit (forest_p8);
-  sc_flops_shot (&fi, &snapshot);
-  sc_stats_set1 (&stats[6], snapshot.iwtime, "t8 forest p8 commit level 4");
-
-  t8_forest_unref (&forest_p8);
-  // p8est_refine (p8est, 0,bunny_refine, NULL);
-  // p8est_refine (p8est, 0,bunny_refine, NULL);
-
-//  sc_flops_shot (&fi, &snapshot);
-//  sc_stats_set1 (&stats[5], snapshot.iwtime, "Refine 1 times");
-
-/*
-  snprintf (afilename, BUFSIZ, "%s", "read_tetgen");
-  p8est_vtk_write_file (p8est, NULL, afilename);
-*/
-
-  sc_flops_snap (&fi, &snapshot);
-  cmesh_t8 =
-    t8_cmesh_from_tetgen_file ((char *) argbasename, 0, sc_MPI_COMM_WORLD, 0);
-  t8_cmesh_unref (&cmesh_t8);
-  sc_flops_shot (&fi, &snapshot);
-  sc_stats_set1 (&stats[5], snapshot.iwtime, "t8 cmesh from tetgen");
-
-  sc_flops_snap (&fi, &snapshot);
-
-  t8_forest_init (&forest_t8);
-  t8_forest_set_cmesh (forest_t8, cmesh_p8, sc_MPI_COMM_WORLD);
-  t8_forest_set_level (forest_t8, level);
-  t8_forest_set_scheme (forest_t8, t8_scheme_new_default_cxx ());
-  sc_flops_shot (&fi, &snapshot);
-  sc_stats_set1 (&stats[7], snapshot.iwtime, "t8 forest t8 New Level 4");
-  sc_flops_snap (&fi, &snapshot);
-  t8_forest_commit (forest_t8);
-  sc_flops_shot (&fi, &snapshot);
-  sc_stats_set1 (&stats[8], snapshot.iwtime, "t8 forest t8 commit Level 4");
-
-  /* clean up */
-  p8est_tets_destroy (ptg);
-
-  sc_stats_compute (sc_MPI_COMM_WORLD, 9, stats);
-  sc_stats_print (p4est_package_id, SC_LP_STATISTICS, 9, stats, 1, 1);
-
+  sc_options_destroy (opt);
   sc_finalize ();
+
   mpiret = sc_MPI_Finalize ();
   SC_CHECK_MPI (mpiret);
-
-  return 0;
+  return retval;
 }
@@ -0,0 +1,341 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* A driver for weak and strong scaling studies of the full AMR cycle.
+ * Each cycle adapts the forest to a spherical front that expands through
+ * the bounding box of the mesh, and balances, partitions and creates the
+ * ghosts of the adapted forest in the same commit. Then the ghost values
+ * of one double per element are exchanged.
+ * The cmesh is either a bigmesh, the hybrid hypercube, or it is read
+ * from a tetgen or a .msh file.
+ * For strong scaling the initial uniform level is given with -l.
+ * For weak scaling the number of elements per process is given with -E,
+ * and the number of bigmesh trees or the initial level of the other meshes
+ * is chosen from the number of processes. Thus, a job script only needs to
+ * set the number of processes.
+ * At the end the runtimes of the phases are printed as statistics over
+ * the processes, accumulated over all cycles. */
+
+#include <float.h>
+#include <sc_options.h>
+#include <sc_statistics.h>
+#include <t8_cmesh.h>
+#include <t8_cmesh_tetgen.h>
+#include <t8_cmesh_readmshfile.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* The front of the adaptation */
+typedef struct
+{
+  double              center[3];        /* The center of the sphere */
+  double              radius;   /* The current radius of the sphere */
+  double              width;    /* The width of the refined band */
+  int                 base_level;       /* Elements are not coarsened
+                                           below this level */
+  int                 max_level;        /* Elements are not refined
+                                           above this level */
+} t8_scaling_front_t;
+
+/* Refine the elements in a band around the sphere and coarsen the others
+ * down to the base level */
+static int
+t8_scaling_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                  t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                  t8_eclass_scheme_c * ts, int num_elements,
+                  t8_element_t * elements[])
+{
+  const t8_scaling_front_t *front;
+  double              centroid[3], dist = 0;
+  int                 level, i;
+
+  front = (const t8_scaling_front_t *) t8_forest_get_user_data (forest);
+  level = ts->t8_element_level (elements[0]);
+  t8_forest_element_centroid (forest_from, which_tree, elements[0],
+                              t8_forest_get_tree_vertices (forest_from,
+                                                           which_tree),
+                              centroid);
+  for (i = 0; i < 3; i++) {
+    dist += (centroid[i] - front->center[i]) * (centroid[i] -
+                                                front->center[i]);
+  }
+  if (fabs (sqrt (dist) - front->radius) < .5 * front->width) {
+    return level < front->max_level;
+  }
+  return num_elements > 1 && level > front->base_level ? -1 : 0;
+}
+
+/* Compute the bounding box of the trees of a forest over all processes.
+ * On output box[i] is the minimum and box[3 + i] the maximum coordinate
+ * in direction i. */
+static void
+t8_scaling_bounding_box (t8_forest_t forest, sc_MPI_Comm comm,
+                         double box[6])
+{
+  double              local[6];
+  const double       *vertices;
+  t8_locidx_t         itree;
+  int                 ivertex, num_vertices, i, mpiret;
+
+  for (i = 0; i < 3; i++) {
+    local[i] = local[3 + i] = DBL_MAX;
+  }
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    vertices = t8_forest_get_tree_vertices (forest, itree);
+    num_vertices =
+      t8_eclass_num_vertices[t8_forest_get_tree_class (forest, itree)];
+    for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+      for (i = 0; i < 3; i++) {
+        /* We store the negative maximum to use one reduction */
+        local[i] = SC_MIN (local[i], vertices[3 * ivertex + i]);
+        local[3 + i] = SC_MIN (local[3 + i], -vertices[3 * ivertex + i]);
+      }
+    }
+  }
+  mpiret = sc_MPI_Allreduce (local, box, 6, sc_MPI_DOUBLE, sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  for (i = 0; i < 3; i++) {
+    box[3 + i] = -box[3 + i];
+  }
+}
+
+/* Return the smallest level at which num_trees trees of dimension dim
+ * have at least num_elements elements */
+static int
+t8_scaling_weak_level (t8_gloidx_t num_trees, int dim, double num_elements)
+{
+  int                 level = 0;
+  double              count = num_trees;
+
+  while (count < num_elements) {
+    count *= 1 << dim;
+    level++;
+  }
+  return level;
+}
+
+/* Create the cmesh of the scaling run. If elements_per_rank is positive,
+ * level is set for weak scaling. */
+static t8_cmesh_t
+t8_scaling_cmesh (const char *cmesh_type, const char *fileprefix, int dim,
+                  t8_eclass_t eclass, int num_trees, double elements_per_rank,
+                  int *level, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  double              num_elements;
+  int                 mpisize, mpiret;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  num_elements = elements_per_rank * mpisize;
+
+  if (!strcmp (cmesh_type, "bigmesh")) {
+    t8_gloidx_t         num_global_trees = num_trees;
+
+    if (elements_per_rank > 0) {
+      /* Keep the level and scale the number of trees */
+      num_global_trees = (t8_gloidx_t) ceil (num_elements /
+                                             t8_eclass_count_leaf (eclass,
+                                                                   *level));
+    }
+    t8_global_productionf ("Creating a bigmesh of %lli %s trees.\n",
+                           (long long) num_global_trees,
+                           t8_eclass_to_string[eclass]);
+    return t8_cmesh_new_bigmesh_partitioned (eclass, num_global_trees, comm);
+  }
+  else if (!strcmp (cmesh_type, "hybrid")) {
+    cmesh = t8_cmesh_new_hypercube_hybrid (3, comm, 0, 0);
+    dim = 3;
+  }
+  else if (!strcmp (cmesh_type, "tetgen") && fileprefix != NULL) {
+    cmesh = t8_cmesh_from_tetgen_file ((char *) fileprefix, 0, comm, 0);
+    dim = 3;
+  }
+  else if (!strcmp (cmesh_type, "msh") && fileprefix != NULL) {
+    cmesh = t8_cmesh_from_msh_file (fileprefix, 0, comm, dim, 0);
+  }
+  else {
+    SC_GLOBAL_LERRORF ("Unknown cmesh %s or missing file prefix.\n",
+                       cmesh_type);
+    return NULL;
+  }
+  SC_CHECK_ABORTF (cmesh != NULL, "Could not create the %s cmesh",
+                   cmesh_type);
+  if (elements_per_rank > 0) {
+    *level = t8_scaling_weak_level (t8_cmesh_get_num_trees (cmesh), dim,
+                                    num_elements);
+  }
+  return cmesh;
+}
+
+static void
+t8_scaling_run (t8_cmesh_t cmesh, int level, int rlevel, int num_cycles,
+                double width, sc_MPI_Comm comm)
+{
+  t8_forest_t         forest, forest_adapt;
+  t8_forest_profile_accum_t accum;
+  t8_scaling_front_t  front;
+  sc_statinfo_t       stats[2];
+  sc_array_t         *data;
+  double              box[6], diameter = 0, exchange_time = 0;
+  double              cycle_time = 0, t_cycle;
+  t8_locidx_t         ielement;
+  int                 icycle, i;
+
+  forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), level,
+                                  0, comm);
+  t8_global_productionf ("Created a uniform forest of level %i with %lli "
+                         "elements.\n", level,
+                         (long long) t8_forest_get_global_num_elements
+                         (forest));
+
+  /* The front expands from the center to the corners of the box */
+  t8_scaling_bounding_box (forest, comm, box);
+  for (i = 0; i < 3; i++) {
+    front.center[i] = .5 * (box[i] + box[3 + i]);
+    diameter += (box[3 + i] - box[i]) * (box[3 + i] - box[i]);
+  }
+  diameter = sqrt (diameter);
+  front.width = width * diameter;
+  front.base_level = level;
+  front.max_level = level + rlevel;
+
+  t8_forest_profile_accum_init (&accum);
+  for (icycle = 0; icycle < num_cycles; icycle++) {
+    t_cycle = -sc_MPI_Wtime ();
+    front.radius = .5 * diameter * (icycle + 1) / num_cycles;
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_user_data (forest_adapt, &front);
+    t8_forest_set_adapt (forest_adapt, forest, t8_scaling_adapt, 1);
+    t8_forest_set_balance (forest_adapt, NULL, 0);
+    t8_forest_set_partition (forest_adapt, NULL, 0);
+    t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+    t8_forest_set_profiling (forest_adapt, 1);
+    t8_forest_commit (forest_adapt);
+    forest = forest_adapt;
+
+    /* Exchange one value per element */
+    data = sc_array_new_count (sizeof (double),
+                               t8_forest_get_num_element (forest)
+                               + t8_forest_get_num_ghosts (forest));
+    for (ielement = 0; ielement < t8_forest_get_num_element (forest);
+         ielement++) {
+      *(double *) sc_array_index_int (data, ielement) = ielement;
+    }
+    exchange_time -= sc_MPI_Wtime ();
+    t8_forest_ghost_exchange_data (forest, data);
+    exchange_time += sc_MPI_Wtime ();
+    sc_array_destroy (data);
+
+    t_cycle += sc_MPI_Wtime ();
+    cycle_time += t_cycle;
+    t8_forest_profile_accumulate (&accum, forest);
+    t8_global_productionf ("Cycle %i: %lli elements in %.3f s.\n", icycle,
+                           (long long)
+                           t8_forest_get_global_num_elements (forest),
+                           t_cycle);
+  }
+
+  t8_forest_profile_accum_print (&accum, comm);
+  sc_stats_set1 (&stats[0], exchange_time, "Ghost exchange runtime.");
+  sc_stats_set1 (&stats[1], cycle_time, "Cycle runtime.");
+  sc_stats_compute (comm, 2, stats);
+  sc_stats_print (t8_get_package_id (), SC_LP_ESSENTIAL, 2, stats, 1, 1);
+  t8_forest_unref (&forest);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, parsed, helpme = 0, retval = 0;
+  int                 level, rlevel, num_cycles, num_trees, dim, eclass_int;
+  double              elements_per_rank, width;
+  const char         *cmesh_type, *fileprefix;
+  t8_cmesh_t          cmesh;
+  sc_options_t       *opt;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_STATISTICS);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &helpme,
+                         "Display a short help message.");
+  sc_options_add_string (opt, 'c', "cmesh", &cmesh_type, "bigmesh",
+                         "The cmesh: bigmesh, hybrid, tetgen, or msh.");
+  sc_options_add_string (opt, 'f', "fileprefix", &fileprefix, NULL,
+                         "The file prefix of the tetgen and msh cmeshes.");
+  sc_options_add_int (opt, 'd', "dim", &dim, 3,
+                      "The dimension of the msh cmesh.");
+  sc_options_add_int (opt, 'e', "elements", &eclass_int, T8_ECLASS_HEX,
+                      "The tree class of the bigmesh.");
+  sc_options_add_int (opt, 't', "trees", &num_trees, 64,
+                      "The number of bigmesh trees for strong scaling.");
+  sc_options_add_int (opt, 'l', "level", &level, 2,
+                      "The initial uniform level. For weak scaling of the "
+                      "bigmesh it is kept and the number of trees is scaled.");
+  sc_options_add_double (opt, 'E', "elements-per-rank", &elements_per_rank,
+                         0, "If positive, scale the mesh to this number of "
+                         "initial elements per process for weak scaling.");
+  sc_options_add_int (opt, 'r', "rlevel", &rlevel, 2,
+                      "The number of levels refined at the front.");
+  sc_options_add_int (opt, 'C', "cycles", &num_cycles, 10,
+                      "The number of AMR cycles.");
+  sc_options_add_double (opt, 'w', "width", &width, .05,
+                         "The width of the refined band relative to the "
+                         "diameter of the mesh.");
+
+  parsed =
+    sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
+  if (helpme) {
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  else if (parsed >= 0 && level >= 0 && rlevel >= 0 && num_cycles > 0
+           && num_trees > 0 && width > 0 && (dim == 2 || dim == 3)
+           && T8_ECLASS_LINE <= eclass_int && eclass_int < T8_ECLASS_COUNT) {
+    cmesh = t8_scaling_cmesh (cmesh_type, fileprefix, dim,
+                              (t8_eclass_t) eclass_int, num_trees,
+                              elements_per_rank, &level, sc_MPI_COMM_WORLD);
+    if (cmesh != NULL) {
+      t8_scaling_run (cmesh, level, rlevel, num_cycles, width,
+                      sc_MPI_COMM_WORLD);
+    }
+    else {
+      retval = 1;
+    }
+  }
+  else {
+    /* wrong usage */
+    t8_global_productionf ("\n\tERROR: Wrong usage.\n\n");
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+    retval = 1;
+  }
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+  return retval;
+}
@@ -35,8 +35,12 @@
 #include <t8_cmesh_vtk.h>
 #include <t8_vec.h>
 
-#define MAX_FACES 8             /* The maximum number of faces of an element */
-/* TODO: This is not memory efficient. If we run out of memory, we can optimize here. */
+/* Let the compiler vectorize the loops over the faces */
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP) && _OPENMP >= 201307
+#define T8_ADVECT_SIMD _Pragma ("omp simd")
+#else
+#define T8_ADVECT_SIMD
+#endif
 
 /* Enum for statistics. */
 typedef enum
@@ -51,12 +55,15 @@ typedef enum
   ADVECT_GHOST_SENT,            /* number of ghosts sent to other processes */
   ADVECT_GHOST_EXCHANGE,        /* ghost exchange runtime */
   ADVECT_GHOST_WAIT,            /* ghost exchange waittime */
+  ADVECT_GHOST_OVERLAP,         /* ghost exchange time hidden by the interior flux computation */
   ADVECT_REPLACE,               /* forest_iterate_replace runtime */
   ADVECT_IO,                    /* vtk runtime */
   ADVECT_ELEM_AVG,              /* average global number of elements (per time step) */
+  ADVECT_UPDATES,               /* number of element updates per unit of simulated time */
   ADVECT_INIT,                  /* initialization runtime */
   ADVECT_AMR,                   /* AMR runtime (adapt+partition+ghost+balance) including data exchange (partition/ghost) */
-  ADVECT_NEIGHS,                /* neighbor finding runtime */
+  ADVECT_NUM_ADAPT,             /* number of adaptations during the time loop */
+  ADVECT_NEIGHS,                /* neighbor finding runtime (building the face list) */
   ADVECT_FLUX,                  /* flux computation runtime */
   ADVECT_DUMMY,                 /* dummy operations to increase load (see -s option) */
   ADVECT_SOLVE,                 /* solver runtime */
@@ -79,11 +86,14 @@ const char         *advect_stat_names[ADVECT_NUM_STATS] = {
   "ghost_sent",
   "ghost_exchange",
   "ghost_exchange_wait",
+  "ghost_exchange_overlap",
   "replace",
   "vtk_print",
   "number_elements",
+  "element_updates_per_time",
   "init",
   "AMR",
+  "number_adapts",
   "neighbor_finding",
   "flux_computation",
   "dummy_ops",
@@ -94,6 +104,57 @@ const char         *advect_stat_names[ADVECT_NUM_STATS] = {
   "volume_loss_[%]"
 };
 
+/* The JSON keys of the values of t8_forest_profile_value_t */
+static const char  *advect_profile_names[T8_FOREST_PROFILE_COUNT] = {
+  "elements", "ghosts", "partition_bytes_sent", "adapt_runtime",
+  "partition_runtime", "ghost_runtime", "balance_runtime", "commit_runtime"
+};
+
+/** The faces of the local elements as structure of arrays.
+ * Each entry is the part of a face between a local element (plus) and a
+ * local element, a ghost or the domain boundary (minus). A hanging face has
+ * one entry for each of its fine neighbors. Each entry appears once, such
+ * that its flux is computed once per time step and added to both sides.
+ * The entries without a ghost come first, such that their fluxes can be
+ * computed while the ghost values are exchanged. Within both parts the
+ * entries are sorted by descending rate, see t8_advect_level_rate.
+ * The rate of a face is the rate of its finer side.
+ * The list is rebuilt whenever the forest changes.
+ */
+typedef struct
+{
+  t8_locidx_t         num_faces; /**< The number of face entries */
+  t8_locidx_t         num_interior; /**< The number of entries without a ghost,
+                                         they are the first ones */
+  t8_locidx_t        *rate_offsets; /**< 2 num_rates + 1 offsets. The interior entries
+                                         of rate r are rate_offsets[num_rates - 1 - r],
+                                         ..., rate_offsets[num_rates - r] - 1, the
+                                         ones with a ghost are shifted by num_rates */
+  t8_locidx_t         num_elements; /**< The number of local elements */
+  t8_locidx_t        *plus; /**< The local element of each entry */
+  t8_locidx_t        *minus; /**< The local or ghost element on the other side,
+                                  -1 at the domain boundary */
+  double             *center[3]; /**< The coordinates of the face centers */
+  double             *normal[3]; /**< The outward normals of plus, scaled by the
+                                      face area */
+  double             *normal_u; /**< The product of the (scaled) normal and u at the
+                                     face center in the current time step */
+  double             *phi_plus; /**< The phi value of plus */
+  double             *phi_minus; /**< The phi value of minus */
+  double             *flux; /**< The flux into plus */
+  double             *flux_sum; /**< For each local element the sum of its fluxes
+                                       times their time steps since its last update */
+} t8_advect_face_list_t;
+
+/** The data of the local elements as structure of arrays.
+ * Each array has one entry for each local element. */
+typedef struct
+{
+  sc_array_t         *midpoints; /**< 3 doubles per element, the coordinates of its midpoint in R^3 */
+  sc_array_t         *volumes; /**< The volume of each element */
+  sc_array_t         *levels; /**< The refinement level of each element, as int */
+} t8_advect_element_data_t;
+
 /** The description of the problem configuration.
  *  We store all necessary parameters, such as the initial level-set function, the flow function,
  *  data needed for adaptation etc.
@@ -106,23 +167,26 @@ typedef struct
   void               *udata_for_phi; /**< User data passed to phi */
   t8_forest_t         forest; /**< The forest in use */
   t8_forest_t         forest_adapt; /**< The forest after adaptation */
-  sc_array_t         *element_data; /**< Array of type t8_advect_element_data_t of length
-                              num_local_elements + num_ghosts */
-  /* TODO: shorten element_data by number of ghosts */
-  sc_array_t         *element_data_adapt; /**< element_data for the adapted forest, used during adaptation to interpolate values */
+  t8_advect_element_data_t element_data; /**< The data of the local elements */
+  t8_advect_element_data_t element_data_adapt; /**< element_data for the adapted forest, used during adaptation to interpolate values */
   /* We store the phi values in an extra array, since this data must exist for ghost
    * element as well and is communicated with other processes in ghost_exchange. */
   sc_array_t         *phi_values; /**< For each element and ghost its phi value. */
   sc_array_t         *phi_values_adapt; /**< phi values for the adapted forest, used during adaptaption to interpolate values. */
+  t8_advect_face_list_t faces; /**< The faces of the current forest */
   sc_MPI_Comm         comm; /**< MPI communicator used */
   sc_statinfo_t       stats[ADVECT_NUM_STATS]; /**< Runtimes and other statistics. */
   double              t; /**< Current simulation time */
   double              T; /**< End time */
   double              cfl; /**< CFL number */
-  double              delta_t; /**< Current time step */
+  double              delta_t; /**< Current time step. With local time stepping
+                                    the step of the elements of rate 0 */
   double              min_grad, max_grad; /**< bounds for refinement */
   double              min_vol; /**< minimum element volume at level 'level' */
+  double              min_diam; /**< global minimum element diameter */
   double              band_width; /**< width of the refinement band */
+  double              partition_imbalance; /**< Skip the repartition if the load imbalance is at most this.
+                                                \see t8_forest_set_partition_imbalance */
   int                 num_time_steps; /**< Number of time steps computed so far.
                                         (If delta_t is constant then t = num_time_steps * delta_t) */
   int                 vtk_count; /**< If vtk output is enabled, count the number of pvtu files written. */
@@ -133,24 +197,59 @@ typedef struct
   int                 dim; /**< The dimension of the mesh */
   int                 dummy_op; /**< If true, we carry out more (but useless) operations
                                      per element, in order to simulate more computation load */
+  int                 lts; /**< If true, the elements advance with level dependent
+                                time steps, see t8_advect_level_rate */
+  int                 num_rates; /**< The number of different time step rates */
+  long long           num_updates; /**< The number of local element updates so far */
+  t8_forest_profile_accum_t profile_adapt; /**< The profiles of the adapted forests */
+  t8_forest_profile_accum_t profile_partition; /**< The profiles of the partitioned forests */
 } t8_advect_problem_t;
 
-/** The per element data */
-typedef struct
+/* Return a pointer to the midpoint of a local element */
+static double      *
+t8_advect_element_midpoint (const t8_advect_element_data_t * data,
+                            t8_locidx_t ielement)
 {
-  double              midpoint[3]; /**< coordinates of element midpoint in R^3 */
-  double              vol; /**< Volume of this element */
-  double              phi_new; /**< Value of solution at midpoint in next time step */
-  double             *fluxes[MAX_FACES]; /**< The fluxes to each neeighbor at a given face */
-  int                 flux_valid[MAX_FACES];  /**< If > 0, this flux was computed, if 0 memory was allocated
-                                                   for this flux, but not computed. If < 0, no memory was allocated. */
-  int                 level; /**< The refinement level of the element. */
-  int                 num_faces; /**< The number of faces */
-  int                 num_neighbors[MAX_FACES]; /**< Number of neighbors for each face */
-  int                *dual_faces[MAX_FACES]; /**< The face indices of the neighbor elements */
-  t8_locidx_t        *neighs[MAX_FACES]; /**< Indices of the neighbor elements */
-  int8_t              neigh_level[MAX_FACES]; /**< The level of the face neighbors at this face. */
-} t8_advect_element_data_t;
+  return (double *) t8_sc_array_index_locidx (data->midpoints, ielement);
+}
+
+/* Return a pointer to the volume of a local element */
+static double      *
+t8_advect_element_volume (const t8_advect_element_data_t * data,
+                          t8_locidx_t ielement)
+{
+  return (double *) t8_sc_array_index_locidx (data->volumes, ielement);
+}
+
+/* Return a pointer to the level of a local element */
+static int         *
+t8_advect_element_level (const t8_advect_element_data_t * data,
+                         t8_locidx_t ielement)
+{
+  return (int *) t8_sc_array_index_locidx (data->levels, ielement);
+}
+
+/* Allocate the element data for a given number of local elements */
+static void
+t8_advect_element_data_init (t8_advect_element_data_t * data,
+                             t8_locidx_t num_elements)
+{
+  data->midpoints = sc_array_new_count (3 * sizeof (double), num_elements);
+  data->volumes = sc_array_new_count (sizeof (double), num_elements);
+  data->levels = sc_array_new_count (sizeof (int), num_elements);
+}
+
+/* Free the element data. It may be uninitialized (all arrays NULL). */
+static void
+t8_advect_element_data_reset (t8_advect_element_data_t * data)
+{
+  if (data->midpoints != NULL) {
+    sc_array_destroy (data->midpoints);
+    sc_array_destroy (data->volumes);
+    sc_array_destroy (data->levels);
+  }
+  memset (data, 0, sizeof (*data));
+}
 
 /* Return the phi value of a given local or ghost element.
  * 0 <= ielement < num_elements + num_ghosts
@@ -257,9 +356,9 @@ t8_advect_adapt (t8_forest_t forest, t8_forest_t forest_from,
                  t8_element_t * elements[])
 {
   t8_advect_problem_t *problem;
-  t8_advect_element_data_t *elem_data;
-  double              band_width, elem_diam;
+  double              band_width, elem_diam, vol;
   double             *tree_vertices;
+  const double       *diameters;
   int                 level;
   t8_locidx_t         offset;
   double              phi;
@@ -288,21 +387,27 @@ t8_advect_adapt (t8_forest_t forest, t8_forest_t forest_from,
   offset = t8_forest_get_tree_element_offset (forest_from, ltree_id);
   phi = t8_advect_element_get_phi (problem, lelement_id + offset);
 
-  /* Get a pointer to the element data */
-  elem_data = (t8_advect_element_data_t *)
-    t8_sc_array_index_locidx (problem->element_data, lelement_id + offset);
+  /* Get the volume of the element */
+  vol = *t8_advect_element_volume (&problem->element_data,
+                                   lelement_id + offset);
 
   /* Refine if close to levelset, coarsen if not */
   band_width = problem->band_width;
-  tree_vertices = t8_forest_get_tree_vertices (forest_from, ltree_id);
-  elem_diam =
-    t8_forest_element_diam (forest_from, ltree_id, elements[0],
-                            tree_vertices);
+  if (!t8_forest_adapt_get_geometry (forest_from, ltree_id, lelement_id,
+                                     elements[0], NULL, NULL, &diameters)) {
+    tree_vertices = t8_forest_get_tree_vertices (forest_from, ltree_id);
+    elem_diam =
+      t8_forest_element_diam (forest_from, ltree_id, elements[0],
+                              tree_vertices);
+  }
+  else {
+    elem_diam = diameters[0];
+  }
   if (fabs (phi) > 2 * band_width * elem_diam) {
     /* coarsen if this is a family and level is not too small */
     return -(num_elements > 1 && level > problem->level);
   }
-  else if (fabs (phi) < band_width * elem_diam && elem_data->vol > vol_thresh) {
+  else if (fabs (phi) < band_width * elem_diam && vol > vol_thresh) {
     /* refine if level is not too large */
     return level < problem->maxlevel;
   }
@@ -314,18 +419,17 @@ static double
 t8_advect_level_set_volume (const t8_advect_problem_t * problem)
 {
   t8_locidx_t         num_local_elements, ielem;
-  t8_advect_element_data_t *elem_data;
+  const double       *vol =
+    (const double *) problem->element_data.volumes->array;
   double              volume = 0, global_volume = 0;
   double              phi;
 
   num_local_elements = t8_forest_get_num_element (problem->forest);
 
   for (ielem = 0; ielem < num_local_elements; ielem++) {
-    elem_data = (t8_advect_element_data_t *)
-      t8_sc_array_index_locidx (problem->element_data, ielem);
     phi = t8_advect_element_get_phi (problem, ielem);
     if (phi < 0) {
-      volume += elem_data->vol;
+      volume += vol[ielem];
     }
   }
   sc_MPI_Allreduce (&volume, &global_volume, 1, sc_MPI_DOUBLE, sc_MPI_SUM,
@@ -341,7 +445,6 @@ t8_advect_l_infty_rel (const t8_advect_problem_t * problem,
                        double distance)
 {
   t8_locidx_t         num_local_elements, ielem;
-  t8_advect_element_data_t *elem_data;
   double              phi;
   double              ana_sol;
   double              error[2] = {
@@ -350,12 +453,10 @@ t8_advect_l_infty_rel (const t8_advect_problem_t * problem,
 
   num_local_elements = t8_forest_get_num_element (problem->forest);
   for (ielem = 0; ielem < num_local_elements; ielem++) {
-    elem_data = (t8_advect_element_data_t *)
-      t8_sc_array_index_locidx (problem->element_data, ielem);
-
     /* Compute the analytical solution */
     ana_sol =
-      analytical_sol (elem_data->midpoint, problem->t,
+      analytical_sol (t8_advect_element_midpoint
+                      (&problem->element_data, ielem), problem->t,
                       problem->udata_for_phi);
 #if 1
     if (fabs (ana_sol) < distance)
@@ -384,7 +485,8 @@ t8_advect_l_2_rel (const t8_advect_problem_t * problem,
                    t8_example_level_set_fn analytical_sol, double distance)
 {
   t8_locidx_t         num_local_elements, ielem, count = 0;
-  t8_advect_element_data_t *elem_data;
+  const double       *vol =
+    (const double *) problem->element_data.volumes->array;
   double              phi;
   double              diff, ana_sol;
   double              error[2] = {
@@ -393,11 +495,10 @@ t8_advect_l_2_rel (const t8_advect_problem_t * problem,
 
   num_local_elements = t8_forest_get_num_element (problem->forest);
   for (ielem = 0; ielem < num_local_elements; ielem++) {
-    elem_data = (t8_advect_element_data_t *)
-      t8_sc_array_index_locidx (problem->element_data, ielem);
     /* Compute the analytical solution */
     ana_sol =
-      analytical_sol (elem_data->midpoint, problem->t,
+      analytical_sol (t8_advect_element_midpoint
+                      (&problem->element_data, ielem), problem->t,
                       problem->udata_for_phi);
 #if 1
     if (fabs (ana_sol) < distance)
@@ -408,9 +509,9 @@ t8_advect_l_2_rel (const t8_advect_problem_t * problem,
        * minus the solution at this midpoint */
       phi = t8_advect_element_get_phi (problem, ielem);
       diff = fabs (phi - ana_sol);
-      el_error = diff * diff * elem_data->vol;
+      el_error = diff * diff * vol[ielem];
       error[0] += el_error;
-      error[1] += ana_sol * ana_sol * elem_data->vol;
+      error[1] += ana_sol * ana_sol * vol[ielem];
     }
   }
   t8_debugf ("[advect] L_2 %e  %e\n", error[0], error[1]);
@@ -424,121 +525,72 @@ t8_advect_l_2_rel (const t8_advect_problem_t * problem,
   return sqrt (global_error[0]) / sqrt (global_error[1]);
 }
 
-static double
-t8_advect_flux_upwind_1d (const t8_advect_problem_t * problem,
-                          const t8_locidx_t el_plus,
-                          const t8_locidx_t el_minus, int face)
+/* The time step rate of an element of a given level.
+ * An element of rate r does 2^r steps of length delta_t / 2^r in each time
+ * step. Without local time stepping all elements have rate 0, otherwise
+ * the rate grows by one with each level above the initial level. */
+static int
+t8_advect_level_rate (const t8_advect_problem_t * problem, int level)
 {
-  double              x_j_half[3];
-  int                 idim;
-  double              u_at_x_j_half[3];
-  double              phi;
-  int                 sign;
-  t8_advect_element_data_t *el_data_plus;
-
-  /*
-   *    | --x-- | --x-- |   Two elements, midpoints marked with 'x'
-   *       x_j     x_j+1
-   *          x_j_half
-   */
-  /* Compute x_j_half */
-  el_data_plus = (t8_advect_element_data_t *)
-    t8_sc_array_index_locidx (problem->element_data, el_plus);
-  for (idim = 0; idim < 3; idim++) {
-    x_j_half[idim] =
-      (el_data_plus->midpoint[idim] -
-       (idim == 0 ? el_data_plus->vol / 2 : 0));
-  }
-  /* Compute u at the interval boundary. */
-  problem->u (x_j_half, problem->t, u_at_x_j_half);
-  /* In 1D we are only interested in the firs coordinate of u */
-
-  sign = face == 0 ? -1 : 1;
-  if (sign * u_at_x_j_half[0] >= 0) {
-    /* we have outflow */
-    phi = -t8_advect_element_get_phi (problem, el_plus);
-  }
-  else {
-    /* we have inflow */
-    /* el_minus may be negative, in this case, el_plus is at the boundary
-     * and we use phi = 0. */
-    phi = el_minus >= 0 ? t8_advect_element_get_phi (problem, el_minus) : 0;
+  if (!problem->lts) {
+    return 0;
   }
-  return u_at_x_j_half[0] * phi;
+  return SC_MAX (0, SC_MIN (level - problem->level, problem->num_rates - 1));
 }
 
-/* Compute the flux across a given face between two elements */
-/* face is the face number as seen from el_data_plus */
-/* This works also if element_plus hangs on element_minus.
- * It does not work if it hangs the other way around. */
-static double
-t8_advect_flux_upwind (const t8_advect_problem_t * problem,
-                       double el_plus_phi,
-                       double el_minus_phi,
-                       t8_locidx_t ltreeid,
-                       const t8_element_t * element_plus,
-                       const double *tree_vertices, int face)
+/* The context of t8_advect_face_list_add while the face list is built */
+typedef struct
 {
-  double              face_center[3];
-  double              u_at_face_center[3];
-  double              normal[3], normal_times_u;
+  const t8_advect_problem_t *problem; /**< The problem */
+  sc_array_t          rate; /**< The rate of each entry */
+  sc_array_t          plus; /**< The plus index of each entry */
+  sc_array_t          minus; /**< The minus index of each entry */
+  sc_array_t          center; /**< 3 doubles per entry, the face center */
+  sc_array_t          normal; /**< 3 doubles per entry, the scaled normal */
+} t8_advect_face_build_t;
+
+/* Append a face entry between plus and minus to the face list.
+ * The geometry is the one of the face 'face' of 'element' */
+static void
+t8_advect_face_list_push (t8_advect_face_build_t * build,
+                          t8_forest_t forest, t8_locidx_t ltreeid,
+                          const t8_element_t * element, int face,
+                          const double *tree_vertices, int rate,
+                          t8_locidx_t plus, t8_locidx_t minus)
+{
+  double             *center, *normal;
   double              area;
+  int                 idim;
 
-  /*
-   *    | --x-- | --x-- |   Two elements, midpoints marked with 'x'
-   *       x_j     x_j+1
-   *          face_center
-   */
-
+  *(int *) sc_array_push (&build->rate) = rate;
+  *(t8_locidx_t *) sc_array_push (&build->plus) = plus;
+  *(t8_locidx_t *) sc_array_push (&build->minus) = minus;
+  center = (double *) sc_array_push (&build->center);
+  normal = (double *) sc_array_push (&build->normal);
   /* Compute the center coordinate of the face */
-  t8_forest_element_face_centroid (problem->forest, ltreeid, element_plus,
-                                   face, tree_vertices, face_center);
-  /* Compute u at the face center. */
-  problem->u (face_center, problem->t, u_at_face_center);
-  /* Compute the normal of the element at this face */
-  t8_forest_element_face_normal (problem->forest, ltreeid, element_plus,
-                                 face, tree_vertices, normal);
-  /* Compute the area of the face */
-  area =
-    t8_forest_element_face_area (problem->forest, ltreeid, element_plus,
-                                 face, tree_vertices);
-
-  /* Compute the dot-product of u and the normal vector */
-  normal_times_u = t8_vec_dot (normal, u_at_face_center);
-
-#if 0
-  /* Output, mainly for debugging */
-  t8_debugf ("[advect] face %i\n", face);
-  t8_debugf ("[advect] normal %f %f %f\n", normal[0], normal[1], normal[2]);
-  t8_debugf ("[advect] face center %f %f %f\n", face_center[0],
-             face_center[1], face_center[2]);
-  t8_debugf ("[advect] u %f %f %f\n", u_at_face_center[0],
-             u_at_face_center[1], u_at_face_center[2]);
-  t8_debugf ("[advect] norm t u: %f\n", normal_times_u);
-  t8_debugf ("[advect] area %f\n", area);
-  t8_debugf ("[advect] phi+ %f\n", el_plus_phi);
-  t8_debugf ("[advect] phi- %f\n", el_minus_phi);
-#endif
-
-  if (normal_times_u >= 0) {
-#if 0
-    /* u flows out of the element_plus */
-    t8_debugf ("[advect] out flux: %f\n",
-               -el_plus_phi * normal_times_u * area);
-#endif
-    return -el_plus_phi * normal_times_u * area;
+  t8_forest_element_face_centroid (forest, ltreeid, element, face,
+                                   tree_vertices, center);
+  if (build->problem->dim == 1) {
+    /* The faces of a line are points, face 0 is the left one */
+    normal[0] = face == 0 ? -1 : 1;
+    normal[1] = normal[2] = 0;
+    return;
   }
-  else {
-    /* u flows into the element_plus */
-#if 0
-    t8_debugf ("[advect] in flux: %f\n",
-               -el_minus_phi * normal_times_u * area);
-#endif
-    return -el_minus_phi * normal_times_u * area;
+  /* Compute the normal of the element at this face and scale it
+   * with the area of the face */
+  t8_forest_element_face_normal (forest, ltreeid, element, face,
+                                 tree_vertices, normal);
+  area =
+    t8_forest_element_face_area (forest, ltreeid, element, face,
+                                 tree_vertices);
+  for (idim = 0; idim < 3; idim++) {
+    normal[idim] *= area;
   }
 }
 
-/* Compute the flux if the element has hanging neighbors:
+/* The callback of t8_forest_iterate_unique_faces to build the face list.
+ * If the face is hanging, we add one entry for each child of the coarse
+ * element at this face:
  *
  *  x -- x ---- x
  *  |    |      |
@@ -546,100 +598,270 @@ t8_advect_flux_upwind (const t8_advect_problem_t * problem,
  *  |    |      |
  *  x -- x ---- x
  *
- * neighs  el_hang
- *
+ * neighbors  element
  */
-int                 a = 0;
-static double
-t8_advect_flux_upwind_hanging (const t8_advect_problem_t * problem,
-                               t8_locidx_t iel_hang,
-                               t8_locidx_t ltreeid,
-                               t8_element_t * element_hang,
-                               const double *tree_vertices, int face,
-                               int adapted_or_partitioned)
+static void
+t8_advect_face_list_add (t8_forest_t forest, t8_locidx_t ltreeid,
+                         const t8_element_t * element, t8_locidx_t lelement,
+                         int face, t8_eclass_scheme_c * neigh_scheme,
+                         int num_neighbors, t8_element_t ** neighbors,
+                         const t8_locidx_t * neigh_indices,
+                         const int *dual_faces, void *user_data)
 {
-  int                 i, num_face_children, child_face;
+  t8_advect_face_build_t *build = (t8_advect_face_build_t *) user_data;
   t8_eclass_scheme_c *ts;
-  t8_eclass           eclass;
   t8_element_t      **face_children;
-  t8_advect_element_data_t *neigh_data;
-  double              flux = 0;
-  int                 dual_face;
-  t8_locidx_t         neigh_id;
-  int                 neigh_is_ghost;
-  t8_advect_element_data_t *el_hang;
-  double              phi_plus, phi_minus;
-
-  /* Get a pointer to the element */
-  el_hang = (t8_advect_element_data_t *)
-    t8_sc_array_index_locidx (problem->element_data, iel_hang);
-  /* Get the eclass and the scheme for the element */
-  eclass = t8_forest_get_tree_class (problem->forest, ltreeid);
-  ts = t8_forest_get_eclass_scheme (problem->forest, eclass);
-  /* Compute the children of the element at the face */
-  num_face_children = ts->t8_element_num_face_children (element_hang, face);
-  T8_ASSERT (num_face_children == el_hang->num_neighbors[face]);
-
-  face_children = T8_ALLOC (t8_element_t *, num_face_children);
-  ts->t8_element_new (num_face_children, face_children);
-  ts->t8_element_children_at_face (element_hang, face, face_children,
-                                   num_face_children, NULL);
-
-  /* Store the phi value of el_hang. We use it as the phi value of the
-   * children to compute the flux */
-  phi_plus = t8_advect_element_get_phi (problem, iel_hang);
-
-  for (i = 0; i < num_face_children; i++) {
-    child_face = ts->t8_element_face_child_face (element_hang, face, i);
-    /* Get a pointer to the neighbor's element data */
-    neigh_id = el_hang->neighs[face][i];
-    neigh_data = (t8_advect_element_data_t *)
-      t8_sc_array_index_locidx (problem->element_data, neigh_id);
-    neigh_is_ghost = neigh_id >= t8_forest_get_num_element (problem->forest);
-    phi_minus = t8_advect_element_get_phi (problem, neigh_id);
-    /* Compute the flux */
-    el_hang->fluxes[face][i] =
-      t8_advect_flux_upwind (problem, phi_plus, phi_minus, ltreeid,
-                             face_children[i], tree_vertices, child_face);
-    // if (a == 1) printf  ("%i %i %f\n",face, i, el_hang->fluxes[face][i]);
-    /* Set the flux of the neighbor element */
-    dual_face = el_hang->dual_faces[face][i];
-    if (!adapted_or_partitioned && !neigh_is_ghost) {
-
-      if (neigh_data->flux_valid[dual_face] < 0) {
-        /* We need to allocate the fluxes */
-        neigh_data->fluxes[dual_face] = T8_ALLOC (double, 1);
-      }
-      // printf ("face %i neigh %i df %i\n", face, neigh_id, dual_face);
-      SC_CHECK_ABORT (dual_face < neigh_data->num_faces, "num\n");
-      // SC_CHECK_ABORT (neigh_data->num_neighbors[dual_face] == 1, "entry\n");
-      neigh_data->num_neighbors[dual_face] = 1;
-      neigh_data->fluxes[dual_face][0] = -el_hang->fluxes[face][i];
-      neigh_data->flux_valid[dual_face] = 1;
+  const double       *tree_vertices;
+  int                 ichild, rate;
+
+  tree_vertices = t8_forest_get_tree_vertices (forest, ltreeid);
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  rate = t8_advect_level_rate (build->problem, ts->t8_element_level (element));
+  if (num_neighbors <= 1) {
+    /* The face is at the boundary or has one neighbor */
+    if (num_neighbors == 1) {
+      rate = SC_MAX (rate, t8_advect_level_rate (build->problem,
+                                                 neigh_scheme->t8_element_level
+                                                 (neighbors[0])));
     }
+    t8_advect_face_list_push (build, forest, ltreeid, element, face,
+                              tree_vertices, rate, lelement,
+                              num_neighbors == 1 ? neigh_indices[0] : -1);
+    return;
+  }
+  /* The face is hanging and element is the coarse side.
+   * Compute the children of the element at the face, they have the
+   * geometry of the faces of the neighbors. */
+  T8_ASSERT (num_neighbors == ts->t8_element_num_face_children (element,
+                                                                face));
+  face_children = T8_ALLOC (t8_element_t *, num_neighbors);
+  ts->t8_element_new (num_neighbors, face_children);
+  ts->t8_element_children_at_face (element, face, face_children,
+                                   num_neighbors, NULL);
+  for (ichild = 0; ichild < num_neighbors; ichild++) {
+    t8_advect_face_list_push (build, forest, ltreeid, face_children[ichild],
+                              ts->t8_element_face_child_face (element, face,
+                                                              ichild),
+                              tree_vertices,
+                              SC_MAX (rate, t8_advect_level_rate
+                                      (build->problem,
+                                       neigh_scheme->t8_element_level
+                                       (neighbors[ichild]))),
+                              lelement, neigh_indices[ichild]);
+  }
+  ts->t8_element_destroy (num_neighbors, face_children);
+  T8_FREE (face_children);
+}
+
+/* Free the face list of a problem */
+static void
+t8_advect_face_list_destroy (t8_advect_face_list_t * faces)
+{
+  int                 idim;
 
-    flux += el_hang->fluxes[face][i];
+  T8_FREE (faces->rate_offsets);
+  T8_FREE (faces->plus);
+  T8_FREE (faces->minus);
+  for (idim = 0; idim < 3; idim++) {
+    T8_FREE (faces->center[idim]);
+    T8_FREE (faces->normal[idim]);
   }
+  T8_FREE (faces->normal_u);
+  T8_FREE (faces->phi_plus);
+  T8_FREE (faces->phi_minus);
+  T8_FREE (faces->flux);
+  T8_FREE (faces->flux_sum);
+  memset (faces, 0, sizeof (*faces));
+}
 
-  el_hang->flux_valid[face] = 1;
-  /* clean-up */
-  ts->t8_element_destroy (num_face_children, face_children);
-  T8_FREE (face_children);
+/* (Re)build the face list of a problem from its current forest.
+ * This has to be called whenever the forest changes. */
+static void
+t8_advect_face_list_build (t8_advect_problem_t * problem)
+{
+  t8_advect_face_list_t *faces = &problem->faces;
+  t8_advect_face_build_t build;
+  t8_locidx_t         iface, ientry, num_faces, num_elements;
+  t8_locidx_t        *plus, *minus;
+  double             *center, *normal;
+  double              neighbor_time;
+  int                 idim, ghost_pass, rate, *rates;
+  const int           num_rates = problem->num_rates;
+
+  neighbor_time = -sc_MPI_Wtime ();
+  t8_advect_face_list_destroy (faces);
+  /* Collect the entries, each face is visited once */
+  build.problem = problem;
+  sc_array_init (&build.rate, sizeof (int));
+  sc_array_init (&build.plus, sizeof (t8_locidx_t));
+  sc_array_init (&build.minus, sizeof (t8_locidx_t));
+  sc_array_init (&build.center, 3 * sizeof (double));
+  sc_array_init (&build.normal, 3 * sizeof (double));
+  t8_forest_iterate_unique_faces (problem->forest, t8_advect_face_list_add,
+                                  &build);
+
+  /* Store the entries as structure of arrays. We first copy the entries
+   * whose minus side is local or the boundary and then those with a ghost,
+   * both sorted by descending rate. */
+  num_faces = (t8_locidx_t) build.plus.elem_count;
+  num_elements = t8_forest_get_num_element (problem->forest);
+  plus = (t8_locidx_t *) build.plus.array;
+  minus = (t8_locidx_t *) build.minus.array;
+  center = (double *) build.center.array;
+  normal = (double *) build.normal.array;
+  rates = (int *) build.rate.array;
+  faces->num_faces = num_faces;
+  faces->num_elements = num_elements;
+  faces->plus = T8_ALLOC (t8_locidx_t, num_faces);
+  faces->minus = T8_ALLOC (t8_locidx_t, num_faces);
+  faces->rate_offsets = T8_ALLOC (t8_locidx_t, 2 * num_rates + 1);
+  for (idim = 0; idim < 3; idim++) {
+    faces->center[idim] = T8_ALLOC (double, num_faces);
+    faces->normal[idim] = T8_ALLOC (double, num_faces);
+  }
+  ientry = 0;
+  faces->rate_offsets[0] = 0;
+  for (ghost_pass = 0; ghost_pass < 2; ghost_pass++) {
+    for (rate = num_rates - 1; rate >= 0; rate--) {
+      for (iface = 0; iface < num_faces; iface++) {
+        if ((minus[iface] >= num_elements) != ghost_pass
+            || rates[iface] != rate) {
+          continue;
+        }
+        faces->plus[ientry] = plus[iface];
+        faces->minus[ientry] = minus[iface];
+        for (idim = 0; idim < 3; idim++) {
+          faces->center[idim][ientry] = center[3 * iface + idim];
+          faces->normal[idim][ientry] = normal[3 * iface + idim];
+        }
+        ientry++;
+      }
+      faces->rate_offsets[ghost_pass * num_rates + num_rates - rate] =
+        ientry;
+    }
+  }
+  faces->num_interior = faces->rate_offsets[num_rates];
+  T8_ASSERT (ientry == num_faces);
+  faces->normal_u = T8_ALLOC (double, num_faces);
+  faces->phi_plus = T8_ALLOC (double, num_faces);
+  faces->phi_minus = T8_ALLOC (double, num_faces);
+  faces->flux = T8_ALLOC (double, num_faces);
+  faces->flux_sum = T8_ALLOC_ZERO (double, num_elements);
+  sc_array_reset (&build.rate);
+  sc_array_reset (&build.plus);
+  sc_array_reset (&build.minus);
+  sc_array_reset (&build.center);
+  sc_array_reset (&build.normal);
+
+  neighbor_time += sc_MPI_Wtime ();
+  sc_stats_accumulate (&problem->stats[ADVECT_NEIGHS], neighbor_time);
+  /* We want to count all runs over the solver time as one */
+  problem->stats[ADVECT_NEIGHS].count = 1;
+}
 
-  a = 2;
-  return flux;
+/* Compute the upwind flux across the face entries first_face, ...,
+ * last_face - 1 of the face list and add them times the time step dt to
+ * the flux sums of the local elements.
+ * At the domain boundary we enforce outflow boundary conditions by taking
+ * the phi value of the element itself for the imaginative neighbor.
+ * In 1D the inflow at the boundary is 0. */
+static void
+t8_advect_compute_fluxes (t8_advect_problem_t * problem,
+                          t8_locidx_t first_face, t8_locidx_t last_face,
+                          double dt)
+{
+  t8_advect_face_list_t *faces = &problem->faces;
+  const t8_locidx_t  *plus = faces->plus, *minus = faces->minus;
+  const double       *phi = (const double *) problem->phi_values->array;
+  const size_t        stride =
+    problem->phi_values->elem_size / sizeof (double);
+  const double        boundary_scale = problem->dim == 1 ? 0 : 1;
+  double             *normal_u = faces->normal_u;
+  double             *phi_plus = faces->phi_plus;
+  double             *phi_minus = faces->phi_minus;
+  double             *flux = faces->flux;
+  double             *flux_sum = faces->flux_sum;
+  double              center[3], u[3];
+  t8_locidx_t         iface;
+
+  T8_ASSERT (0 <= first_face && first_face <= last_face);
+  T8_ASSERT (last_face <= faces->num_faces);
+  /* Evaluate the flow at the face centers. u is called through a
+   * function pointer, thus this loop is not vectorized. */
+  for (iface = first_face; iface < last_face; iface++) {
+    center[0] = faces->center[0][iface];
+    center[1] = faces->center[1][iface];
+    center[2] = faces->center[2][iface];
+    problem->u (center, problem->t, u);
+    normal_u[iface] = u[0] * faces->normal[0][iface]
+      + u[1] * faces->normal[1][iface] + u[2] * faces->normal[2][iface];
+  }
+  /* Gather the phi values at both sides of each face */
+  for (iface = first_face; iface < last_face; iface++) {
+    phi_plus[iface] = phi[stride * plus[iface]];
+    phi_minus[iface] = minus[iface] >= 0 ? phi[stride * minus[iface]]
+      : boundary_scale * phi_plus[iface];
+  }
+  /* The upwind flux into plus */
+  T8_ADVECT_SIMD
+  for (iface = first_face; iface < last_face; iface++) {
+    const double        upwind_phi =
+      normal_u[iface] >= 0 ? phi_plus[iface] : phi_minus[iface];
+
+    flux[iface] = -dt * upwind_phi * normal_u[iface];
+  }
+  /* Add the fluxes to both sides. The flux of a ghost is computed
+   * by its owner process. */
+  for (iface = first_face; iface < last_face; iface++) {
+    flux_sum[plus[iface]] += flux[iface];
+    if (0 <= minus[iface] && minus[iface] < faces->num_elements) {
+      flux_sum[minus[iface]] -= flux[iface];
+    }
+  }
 }
 
-/* If an element is at the domain boundary, we encode boundary conditions
- * by setting a phi value for an imaginative neighbor element.
- * We currently set the phi value
- * to the value of the element itself. */
+/* Advance the phi values of the local elements whose step ends with the
+ * substep 'substep' of the current time step and reset their flux sums.
+ * The fluxes of these steps must have been computed with
+ * t8_advect_compute_fluxes. */
 static void
-t8_advect_boundary_set_phi (const t8_advect_problem_t * problem,
-                            t8_locidx_t ielement, double *boundary_phi)
+t8_advect_advance_elements (t8_advect_problem_t * problem, int substep)
 {
+  t8_advect_face_list_t *faces = &problem->faces;
+  double             *phi = (double *) problem->phi_values->array;
+  const size_t        stride =
+    problem->phi_values->elem_size / sizeof (double);
+  const double       *vol =
+    (const double *) problem->element_data.volumes->array;
+  const int          *level = (const int *) problem->element_data.levels->array;
+  t8_locidx_t         ielem;
+  int                 rate;
+
+  for (ielem = 0; ielem < faces->num_elements; ielem++) {
+    rate = t8_advect_level_rate (problem, level[ielem]);
+    if ((substep + 1) % (1 << (problem->num_rates - 1 - rate)) != 0) {
+      /* This element is in the middle of its step */
+      continue;
+    }
+    /* Phi^t = dt/dx * (f_(j-1/2) - f_(j+1/2)) + Phi^(t-1) */
+    phi[stride * ielem] += faces->flux_sum[ielem] / vol[ielem];
+    faces->flux_sum[ielem] = 0;
+    problem->num_updates++;
+  }
+}
 
-  *boundary_phi = t8_advect_element_get_phi (problem, ielement);
+/* The partition weight of an element is its number of steps per time step */
+static double
+t8_advect_partition_weight (t8_forest_t forest_from, t8_locidx_t which_tree,
+                            t8_locidx_t lelement_id, t8_eclass_scheme_c * ts,
+                            const t8_element_t * element)
+{
+  const t8_advect_problem_t *problem =
+    (const t8_advect_problem_t *) t8_forest_get_user_data (forest_from);
+
+  return 1 << t8_advect_level_rate (problem, ts->t8_element_level (element));
 }
 
 #if 0
@@ -709,43 +931,12 @@ t8_advect_flux_lax_friedrich_1d (const t8_advect_problem_t * problem,
 }
 #endif
 
-static void
-t8_advect_advance_element (t8_advect_problem_t * problem,
-                           t8_locidx_t lelement)
-{
-  int                 iface, ineigh;
-  double              flux_sum = 0;
-  int                 num_faces;
-  double              phi;
-  t8_advect_element_data_t *elem;
-
-  /* Get a pointer to the element */
-  elem = (t8_advect_element_data_t *)
-    t8_sc_array_index_locidx (problem->element_data, lelement);
-  /* Get the phi value of the element */
-  phi = t8_advect_element_get_phi (problem, lelement);
-  num_faces = elem->num_faces;
-  /* Sum all the fluxes */
-  for (iface = 0; iface < num_faces; iface++) {
-    for (ineigh = 0; ineigh < SC_MAX (1, elem->num_neighbors[iface]);
-         ineigh++) {
-      flux_sum += elem->fluxes[iface][ineigh];
-    }
-  }
-  /* Phi^t = dt/dx * (f_(j-1/2) - f_(j+1/2)) + Phi^(t-1) */
-  elem->phi_new = (problem->delta_t / elem->vol) * flux_sum + phi;
-#if 0
-  t8_debugf
-    ("[advect] advance el with delta_t %f vol %f phi %f  flux %f to %f\n",
-     problem->delta_t, elem->vol, phi, flux_sum, elem->phi_new);
-#endif
-}
-
-/* Compute element midpoint and vol and store at element_data field.
+/* Compute element midpoint and vol and store them as entry idata of data.
  * tree_vertices can be NULL, if not it should point to the vertex coordinates of the tree */
 static void
 t8_advect_compute_element_data (t8_advect_problem_t * problem,
-                                t8_advect_element_data_t * elem_data,
+                                t8_advect_element_data_t * data,
+                                t8_locidx_t idata,
                                 t8_element_t * element,
                                 t8_locidx_t ltreeid,
                                 t8_eclass_scheme_c * ts,
@@ -760,9 +951,10 @@ t8_advect_compute_element_data (t8_advect_problem_t * problem,
   }
   /* Compute the midpoint coordinates of element */
   t8_forest_element_centroid (problem->forest, ltreeid, element,
-                              tree_vertices, elem_data->midpoint);
+                              tree_vertices,
+                              t8_advect_element_midpoint (data, idata));
   /* Compute the length of this element */
-  elem_data->vol =
+  *t8_advect_element_volume (data, idata) =
     t8_forest_element_volume (problem->forest, ltreeid, element,
                               tree_vertices);
 }
@@ -786,10 +978,10 @@ t8_advect_replace (t8_forest_t forest_old,
                    int num_incoming, t8_locidx_t first_incoming)
 {
   t8_advect_problem_t *problem;
-  t8_advect_element_data_t *elem_data_in, *elem_data_out;
+  t8_advect_element_data_t *data_in, *data_out;
   t8_locidx_t         first_incoming_data, first_outgoing_data;
   t8_element_t       *element;
-  int                 i, iface;
+  int                 i, level_old;
   double              phi_old;
 
   /* Get the problem description */
@@ -804,31 +996,22 @@ t8_advect_replace (t8_forest_t forest_old,
   first_outgoing_data =
     first_outgoing + t8_forest_get_tree_element_offset (forest_old,
                                                         which_tree);
-  elem_data_out = (t8_advect_element_data_t *)
-    t8_sc_array_index_locidx (problem->element_data, first_outgoing_data);
-  elem_data_in = (t8_advect_element_data_t *)
-    t8_sc_array_index_locidx (problem->element_data_adapt,
-                              first_incoming_data);
+  data_out = &problem->element_data;
+  data_in = &problem->element_data_adapt;
 
-  /* Get the old phi value (used in the cases with num_outgoing = 1) */
+  /* Get the old phi value and level (used in the cases with
+   * num_outgoing = 1) */
   phi_old = t8_advect_element_get_phi (problem, first_outgoing_data);
+  level_old = *t8_advect_element_level (data_out, first_outgoing_data);
   if (num_incoming == num_outgoing && num_incoming == 1) {
-    /* The element is not changed, copy phi and vol */
-    memcpy (elem_data_in, elem_data_out, sizeof (t8_advect_element_data_t));
+    /* The element is not changed, copy phi, midpoint, vol and level */
+    memcpy (t8_advect_element_midpoint (data_in, first_incoming_data),
+            t8_advect_element_midpoint (data_out, first_outgoing_data),
+            3 * sizeof (double));
+    *t8_advect_element_volume (data_in, first_incoming_data) =
+      *t8_advect_element_volume (data_out, first_outgoing_data);
+    *t8_advect_element_level (data_in, first_incoming_data) = level_old;
     t8_advect_element_set_phi_adapt (problem, first_incoming_data, phi_old);
-    /* Get a pointer to the new element */
-    element =
-      t8_forest_get_element_in_tree (problem->forest_adapt, which_tree,
-                                     first_incoming);
-    /* Set the neighbor entries to uninitialized */
-    T8_ASSERT (elem_data_in->num_faces == ts->t8_element_num_faces (element));
-    for (iface = 0; iface < elem_data_in->num_faces; iface++) {
-      elem_data_in->num_neighbors[iface] = 0;
-      elem_data_in->flux_valid[iface] = -1;
-      elem_data_in->dual_faces[iface] = NULL;
-      elem_data_in->fluxes[iface] = NULL;
-      elem_data_in->neighs[iface] = NULL;
-    }
   }
   else if (num_outgoing == 1) {
     T8_ASSERT (num_incoming == 1 << problem->dim);
@@ -839,23 +1022,14 @@ t8_advect_replace (t8_forest_t forest_old,
         t8_forest_get_element_in_tree (problem->forest_adapt, which_tree,
                                        first_incoming + i);
       /* Compute midpoint and vol of the new element */
-      t8_advect_compute_element_data (problem, elem_data_in + i, element,
+      t8_advect_compute_element_data (problem, data_in,
+                                      first_incoming_data + i, element,
                                       which_tree, ts, NULL);
       t8_advect_element_set_phi_adapt (problem, first_incoming_data + i,
                                        phi_old);
-      /* Set the neighbor entries to uninitialized */
-      elem_data_in[i].num_faces = elem_data_out->num_faces;
-      T8_ASSERT (elem_data_in[i].num_faces ==
-                 ts->t8_element_num_faces (element));
-      for (iface = 0; iface < elem_data_in[i].num_faces; iface++) {
-        elem_data_in[i].num_neighbors[iface] = 0;
-        elem_data_in[i].flux_valid[iface] = -1;
-        elem_data_in[i].dual_faces[iface] = NULL;
-        elem_data_in[i].fluxes[iface] = NULL;
-        elem_data_in[i].neighs[iface] = NULL;
-      }
       /* Update the level */
-      elem_data_in[i].level = elem_data_out->level + 1;
+      *t8_advect_element_level (data_in, first_incoming_data + i) =
+        level_old + 1;
     }
   }
   else {
@@ -868,8 +1042,8 @@ t8_advect_replace (t8_forest_t forest_old,
       t8_forest_get_element_in_tree (problem->forest_adapt, which_tree,
                                      first_incoming);
     /* Compute midpoint and vol of the new element */
-    t8_advect_compute_element_data (problem, elem_data_in, element,
-                                    which_tree, ts, NULL);
+    t8_advect_compute_element_data (problem, data_in, first_incoming_data,
+                                    element, which_tree, ts, NULL);
 
     /* Compute average of phi */
     for (i = 0; i < num_outgoing; i++) {
@@ -877,49 +1051,8 @@ t8_advect_replace (t8_forest_t forest_old,
     }
     phi /= num_outgoing;
     t8_advect_element_set_phi_adapt (problem, first_incoming_data, phi);
-    /* Set the neighbor entries to uninitialized */
-    elem_data_in->num_faces = elem_data_out[0].num_faces;
-    T8_ASSERT (elem_data_in->num_faces == ts->t8_element_num_faces (element));
-    for (iface = 0; iface < elem_data_in->num_faces; iface++) {
-      elem_data_in->num_neighbors[iface] = 0;
-      elem_data_in->flux_valid[iface] = -1;
-      elem_data_in->dual_faces[iface] = NULL;
-      elem_data_in->fluxes[iface] = NULL;
-      elem_data_in->neighs[iface] = NULL;
-    }
     /* update the level */
-    elem_data_in->level = elem_data_out->level - 1;
-  }
-}
-
-static void
-t8_advect_problem_elements_destroy (t8_advect_problem_t * problem)
-{
-
-  t8_locidx_t         lelement, num_local_elem;
-  int                 iface;
-  t8_advect_element_data_t *elem_data;
-
-  num_local_elem = t8_forest_get_num_element (problem->forest);
-  T8_ASSERT (num_local_elem <=
-             (t8_locidx_t) problem->element_data->elem_count);
-  /* destroy all elements */
-  for (lelement = 0; lelement < num_local_elem; lelement++) {
-    elem_data = (t8_advect_element_data_t *)
-      t8_sc_array_index_locidx (problem->element_data, lelement);
-    for (iface = 0; iface < elem_data->num_faces; iface++) {
-      /* TODO: make face number dim independent */
-      if (elem_data->num_neighbors[iface] > 0) {
-        T8_FREE (elem_data->neighs[iface]);
-        T8_FREE (elem_data->dual_faces[iface]);
-        T8_FREE (elem_data->fluxes[iface]);
-        elem_data->num_neighbors[iface] = 0;
-        elem_data->flux_valid[iface] = -1;
-      }
-      else {
-        T8_FREE (elem_data->fluxes[iface]);
-      }
-    }
+    *t8_advect_element_level (data_in, first_incoming_data) = level_old - 1;
   }
 }
 
@@ -979,14 +1112,15 @@ t8_advect_problem_adapt (t8_advect_problem_t * problem, int measure_time)
     problem->stats[ADVECT_BALANCE].count = 1;
     problem->stats[ADVECT_GHOST].count = 1;
     problem->stats[ADVECT_GHOST_SENT].count = 1;
+    t8_forest_profile_accumulate (&problem->profile_adapt,
+                                  problem->forest_adapt);
   }
 
   /* Allocate new memory for the element_data of the advected forest */
   num_elems = t8_forest_get_num_element (problem->forest_adapt);
   num_elems_p_ghosts = num_elems +
     t8_forest_get_num_ghosts (problem->forest_adapt);
-  problem->element_data_adapt =
-    sc_array_new_count (sizeof (t8_advect_element_data_t), num_elems);
+  t8_advect_element_data_init (&problem->element_data_adapt, num_elems);
   problem->phi_values_adapt =
     sc_array_new_count ((problem->dummy_op ? 2 : 1) * sizeof (double),
                         num_elems_p_ghosts);
@@ -1007,8 +1141,7 @@ t8_advect_problem_adapt (t8_advect_problem_t * problem, int measure_time)
     problem->stats[ADVECT_AMR].count = 1;
   }
   /* clean the old element data */
-  t8_advect_problem_elements_destroy (problem);
-  sc_array_destroy (problem->element_data);
+  t8_advect_element_data_reset (&problem->element_data);
   sc_array_destroy (problem->phi_values);
   /* Free memory for the forest */
   t8_forest_unref (&problem->forest);
@@ -1017,7 +1150,8 @@ t8_advect_problem_adapt (t8_advect_problem_t * problem, int measure_time)
   problem->forest_adapt = NULL;
   /* Set the elem data to the adapted elem data */
   problem->element_data = problem->element_data_adapt;
-  problem->element_data_adapt = NULL;
+  memset (&problem->element_data_adapt, 0,
+          sizeof (problem->element_data_adapt));
   /* Set the phi values to the adapted phi values */
   problem->phi_values = problem->phi_values_adapt;
   problem->phi_values_adapt = NULL;
@@ -1028,13 +1162,17 @@ static void
 t8_advect_problem_partition (t8_advect_problem_t * problem, int measure_time)
 {
   t8_forest_t         forest_partition;
-  sc_array_t          data_view, data_view_new, phi_view, phi_view_new;
-  sc_array_t         *new_data, *new_phi;
+  sc_array_t          views[4], views_new[4];
+  sc_array_t         *fields[4], *new_fields[4];
+  t8_forest_partition_data_exchange_t *exchange[4];
+  t8_advect_element_data_t new_data;
+  sc_array_t         *new_phi;
   t8_locidx_t         num_local_elements, num_local_elements_new;
   t8_locidx_t         num_ghosts_new;
   int                 procs_sent;
   t8_locidx_t         ghost_sent;
   double              partition_time, ghost_time;
+  int                 ifield;
 
   /* Partition the forest and create its ghost layer */
   /* ref the current forest, since we still need access to it */
@@ -1044,6 +1182,14 @@ t8_advect_problem_partition (t8_advect_problem_t * problem, int measure_time)
   t8_forest_set_profiling (forest_partition, 1);
   /* Partition the forest and create ghosts */
   t8_forest_set_partition (forest_partition, problem->forest, 0);
+  t8_forest_set_partition_imbalance (forest_partition,
+                                     problem->partition_imbalance);
+  if (problem->lts) {
+    /* Balance the number of element updates */
+    t8_forest_set_user_data (problem->forest, problem);
+    t8_forest_set_partition_weights (forest_partition,
+                                     t8_advect_partition_weight, NULL);
+  }
   t8_forest_set_ghost (forest_partition, 1, T8_GHOST_FACES);
   t8_forest_commit (forest_partition);
   /* Add runtimes to internal stats */
@@ -1059,31 +1205,41 @@ t8_advect_problem_partition (t8_advect_problem_t * problem, int measure_time)
     /* We want to count all runs over the solver time as one */
     problem->stats[ADVECT_PARTITION].count = 1;
     problem->stats[ADVECT_GHOST].count = 1;
+    t8_forest_profile_accumulate (&problem->profile_partition,
+                                  forest_partition);
   }
   /* Partition the data */
   num_local_elements = t8_forest_get_num_element (problem->forest);
   num_local_elements_new = t8_forest_get_num_element (forest_partition);
   num_ghosts_new = t8_forest_get_num_ghosts (forest_partition);
-  /* Create a view array of the entries for the local elements */
-  sc_array_init_view (&data_view, problem->element_data, 0,
-                      num_local_elements);
-  sc_array_init_view (&phi_view, problem->phi_values, 0, num_local_elements);
-  /* Allocate the data array for the partitioned elements */
-  new_data =
-    sc_array_new_count (sizeof (t8_advect_element_data_t),
-                        num_local_elements_new + num_ghosts_new);
+  /* Allocate the data arrays for the partitioned elements */
+  t8_advect_element_data_init (&new_data, num_local_elements_new);
   new_phi =
-    sc_array_new_count (sizeof (double),
+    sc_array_new_count (problem->phi_values->elem_size,
                         num_local_elements_new + num_ghosts_new);
-  /* Create a view array of the entries for the local elements */
-  sc_array_init_view (&data_view_new, new_data, 0, num_local_elements_new);
-  sc_array_init_view (&phi_view_new, new_phi, 0, num_local_elements_new);
-  /* Perform the data partition */
+  fields[0] = problem->element_data.midpoints;
+  fields[1] = problem->element_data.volumes;
+  fields[2] = problem->element_data.levels;
+  fields[3] = problem->phi_values;
+  new_fields[0] = new_data.midpoints;
+  new_fields[1] = new_data.volumes;
+  new_fields[2] = new_data.levels;
+  new_fields[3] = new_phi;
+  /* Perform the data partition, all arrays are sent at the same time */
   partition_time = -sc_MPI_Wtime ();
-  t8_forest_partition_data (problem->forest, forest_partition, &data_view,
-                            &data_view_new);
-  t8_forest_partition_data (problem->forest, forest_partition, &phi_view,
-                            &phi_view_new);
+  for (ifield = 0; ifield < 4; ifield++) {
+    /* Create view arrays of the entries for the local elements */
+    sc_array_init_view (&views[ifield], fields[ifield], 0,
+                        num_local_elements);
+    sc_array_init_view (&views_new[ifield], new_fields[ifield], 0,
+                        num_local_elements_new);
+    exchange[ifield] =
+      t8_forest_partition_data_begin (problem->forest, forest_partition,
+                                      &views[ifield], &views_new[ifield]);
+  }
+  for (ifield = 0; ifield < 4; ifield++) {
+    t8_forest_partition_data_end (exchange[ifield]);
+  }
   partition_time += sc_MPI_Wtime ();
   if (measure_time) {
     sc_stats_accumulate (&problem->stats[ADVECT_PARTITION_DATA],
@@ -1095,10 +1251,9 @@ t8_advect_problem_partition (t8_advect_problem_t * problem, int measure_time)
   }
 
   /* destroy the old forest and the element data */
-  t8_advect_problem_elements_destroy (problem);
   t8_forest_unref (&problem->forest);
   problem->forest = forest_partition;
-  sc_array_destroy (problem->element_data);
+  t8_advect_element_data_reset (&problem->element_data);
   problem->element_data = new_data;
   sc_array_destroy (problem->phi_values);
   problem->phi_values = new_phi;
@@ -1169,7 +1324,8 @@ t8_advect_problem_init (t8_cmesh_t cmesh,
                         int level, int maxlevel,
                         double T, double cfl, sc_MPI_Comm comm,
                         double band_width, int dim, int dummy_op,
-                        int volume_refine)
+                        int volume_refine, double partition_imbalance,
+                        int lts)
 {
   t8_advect_problem_t *problem;
   t8_scheme_cxx_t    *default_scheme;
@@ -1200,6 +1356,12 @@ t8_advect_problem_init (t8_cmesh_t cmesh,
   problem->band_width = band_width;     /* width of the refinemen band around 0 level-set */
   problem->dim = dim;           /* dimension of the mesh */
   problem->dummy_op = dummy_op; /* If true, emulate more computational load per element */
+  problem->partition_imbalance = partition_imbalance;   /* tolerance to skip the repartition */
+  problem->lts = lts;           /* local time stepping */
+  problem->num_rates = lts ? maxlevel - level + 1 : 1;  /* number of time step rates */
+  problem->num_updates = 0;     /* number of element updates */
+  t8_forest_profile_accum_init (&problem->profile_adapt);
+  t8_forest_profile_accum_init (&problem->profile_partition);
 
   for (i = 0; i < ADVECT_NUM_STATS; i++) {
     sc_stats_init (&problem->stats[i], advect_stat_names[i]);
@@ -1213,10 +1375,10 @@ t8_advect_problem_init (t8_cmesh_t cmesh,
 
   /* Initialize the element array with num_local_elements + num_ghosts entries. */
 
-  problem->element_data =
-    sc_array_new_count (sizeof (t8_advect_element_data_t),
-                        t8_forest_get_num_element (problem->forest));
-  problem->element_data_adapt = NULL;
+  t8_advect_element_data_init (&problem->element_data,
+                               t8_forest_get_num_element (problem->forest));
+  memset (&problem->element_data_adapt, 0,
+          sizeof (problem->element_data_adapt));
 
   /* initialize the phi array */
   problem->phi_values =
@@ -1224,44 +1386,19 @@ t8_advect_problem_init (t8_cmesh_t cmesh,
                         t8_forest_get_num_element (problem->forest) +
                         t8_forest_get_num_ghosts (problem->forest));
   problem->phi_values_adapt = NULL;
+  /* The face list is built with the element data */
+  memset (&problem->faces, 0, sizeof (problem->faces));
   return problem;
 }
 
-/* Project the solution at the last time step to the forest.
- * Also set the fluxes to invalid */
-static void
-t8_advect_project_element_data (t8_advect_problem_t * problem)
-{
-  t8_locidx_t         num_local_elements, ielem;
-  t8_advect_element_data_t *elem_data;
-  int                 iface;
-
-  num_local_elements = t8_forest_get_num_element (problem->forest);
-  for (ielem = 0; ielem < num_local_elements; ielem++) {
-    elem_data = (t8_advect_element_data_t *)
-      t8_sc_array_index_locidx (problem->element_data, ielem);
-    /* Currently the mesh does not change, thus the projected value is
-     * just the computed value */
-    t8_advect_element_set_phi (problem, ielem, elem_data->phi_new);
-    /* Set all fluxes to invalid */
-    for (iface = 0; iface < elem_data->num_faces; iface++) {
-      if (elem_data->flux_valid[iface] >= 0) {
-        /* If they are allocated (>= 0), set to allocated and not computed (=0) */
-        elem_data->flux_valid[iface] = 0;
-      }
-    }
-  }
-}
-
 static void
 t8_advect_problem_init_elements (t8_advect_problem_t * problem)
 {
   t8_locidx_t         itree, ielement, idata;
   t8_locidx_t         num_trees, num_elems_in_tree;
-  t8_element_t       *element, **neighbors;
-  int                 iface, ineigh;
-  t8_advect_element_data_t *elem_data;
-  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_t       *element;
+  t8_advect_element_data_t *data = &problem->element_data;
+  t8_eclass_scheme_c *ts;
   double             *tree_vertices;
   double              speed, max_speed = 0, min_diam =
     -1, delta_t, min_delta_t;
@@ -1284,10 +1421,8 @@ t8_advect_problem_init_elements (t8_advect_problem_t * problem)
     for (ielement = 0; ielement < num_elems_in_tree; ielement++, idata++) {
       element =
         t8_forest_get_element_in_tree (problem->forest, itree, ielement);
-      elem_data = (t8_advect_element_data_t *)
-        t8_sc_array_index_locidx (problem->element_data, idata);
       /* Initialize the element's midpoint and volume */
-      t8_advect_compute_element_data (problem, elem_data, element, itree,
+      t8_advect_compute_element_data (problem, data, idata, element, itree,
                                       ts, tree_vertices);
       /* Compute the minimum diameter */
       diam =
@@ -1296,63 +1431,48 @@ t8_advect_problem_init_elements (t8_advect_problem_t * problem)
       T8_ASSERT (diam > 0);
       min_diam = min_diam < 0 ? diam : SC_MIN (min_diam, diam);
       /* Compute the maximum velocity */
-      problem->u (elem_data->midpoint, problem->t, u);
+      problem->u (t8_advect_element_midpoint (data, idata), problem->t, u);
       speed = t8_vec_norm (u);
       max_speed = SC_MAX (max_speed, speed);
 
-      /* Compute minimum necessary time step */
+      /* Compute minimum necessary time step. With local time stepping
+       * the element does 2^rate steps per time step. */
       delta_t = problem->T - problem->t;
       if (speed > 0) {
-        delta_t = problem->cfl * diam / speed;
+        delta_t = problem->cfl * diam / speed *
+          (1 << t8_advect_level_rate (problem,
+                                      ts->t8_element_level (element)));
       }
       min_delta_t = SC_MIN (delta_t, min_delta_t);
       if (problem->volume_refine >= 0 && problem->min_vol <= 0) {
         /* Compute the minimum volume */
-        min_vol = SC_MIN (min_vol, elem_data->vol);
+        min_vol = SC_MIN (min_vol, *t8_advect_element_volume (data, idata));
       }
       /* Set the initial condition */
       t8_advect_element_set_phi (problem, idata,
-                                 problem->phi_0 (elem_data->midpoint, 0,
+                                 problem->phi_0 (t8_advect_element_midpoint
+                                                 (data, idata), 0,
                                                  problem->udata_for_phi));
       /* Set the level */
-      elem_data->level = ts->t8_element_level (element);
-      /* Set the faces */
-      elem_data->num_faces = ts->t8_element_num_faces (element);
-      for (iface = 0; iface < elem_data->num_faces; iface++) {
-        /* Compute the indices of the face neighbors */
-
-        t8_forest_leaf_face_neighbors (problem->forest, itree, element,
-                                       &neighbors, iface,
-                                       &elem_data->dual_faces[iface],
-                                       &elem_data->num_neighbors[iface],
-                                       &elem_data->neighs[iface],
-                                       &neigh_scheme, 1);
-        for (ineigh = 0; ineigh < elem_data->num_neighbors[iface]; ineigh++) {
-          elem_data->neigh_level[iface] =
-            neigh_scheme->t8_element_level (neighbors[ineigh]);
-        }
-
-        if (elem_data->num_neighbors[iface] > 0) {
-          neigh_scheme->t8_element_destroy (elem_data->num_neighbors[iface],
-                                            neighbors);
-          T8_FREE (neighbors);
-          //t8_global_essentialf("alloc face %i of elem %i\n", iface, ielement);
-          elem_data->fluxes[iface] =
-            T8_ALLOC (double, elem_data->num_neighbors[iface]);
-        }
-        else {
-          elem_data->fluxes[iface] = T8_ALLOC (double, 1);
-        }
-        elem_data->flux_valid[iface] = 0;
-      }
+      *t8_advect_element_level (data, idata) =
+        ts->t8_element_level (element);
     }
   }
   /* Exchange ghost values */
   t8_forest_ghost_exchange_data (problem->forest, problem->phi_values);
+  /* Build the face list of the forest */
+  t8_advect_face_list_build (problem);
 
   /* Compute the timestep, this has to be done globally */
   sc_MPI_Allreduce (&min_delta_t, &problem->delta_t, 1, sc_MPI_DOUBLE,
                     sc_MPI_MIN, problem->comm);
+  /* Compute the minimum diameter */
+  if (min_diam < 0) {
+    /* This process has no elements */
+    min_diam = 1e9;
+  }
+  sc_MPI_Allreduce (&min_diam, &problem->min_diam, 1, sc_MPI_DOUBLE,
+                    sc_MPI_MIN, problem->comm);
   if (problem->volume_refine >= 0 && problem->min_vol <= 0) {
     /* Compute the minimum volume.
      * Only in first run and only if volume refinement is active */
@@ -1363,13 +1483,46 @@ t8_advect_problem_init_elements (t8_advect_problem_t * problem)
                         min_diam, max_speed, problem->delta_t);
 }
 
+/* Estimate after how many time steps the mesh must be adapted again.
+ * After adaptation, the zero level-set lies about band_width times the
+ * minimum element diameter inside the band of finest elements.
+ * The front moves at most with the maximum flow speed at the finest
+ * elements, so we adapt before it can have travelled this distance. */
+static int
+t8_advect_adapt_interval (t8_advect_problem_t * problem)
+{
+  t8_locidx_t         ielem, num_elements;
+  const int          *level = (const int *) problem->element_data.levels->array;
+  double              u[3], speed, local_speed = 0, max_speed;
+  double              steps;
+
+  num_elements = t8_forest_get_num_element (problem->forest);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    if (level[ielem] == problem->maxlevel) {
+      problem->u (t8_advect_element_midpoint (&problem->element_data, ielem),
+                  problem->t, u);
+      speed = t8_vec_norm (u);
+      local_speed = SC_MAX (local_speed, speed);
+    }
+  }
+  sc_MPI_Allreduce (&local_speed, &max_speed, 1, sc_MPI_DOUBLE, sc_MPI_MAX,
+                    problem->comm);
+  if (max_speed <= 0) {
+    /* The front does not move, we never adapt again */
+    return INT_MAX;
+  }
+  steps = problem->band_width * problem->min_diam
+    / (max_speed * problem->delta_t);
+  return steps < 1 ? 1 : steps >= INT_MAX ? INT_MAX : (int) steps;
+}
+
 static void
 t8_advect_write_vtk (t8_advect_problem_t * problem)
 {
   double             *u_and_phi_array[4], u_temp[3];
   t8_locidx_t         num_local_elements, ielem;
   t8_vtk_data_field_t vtk_data[5];
-  t8_advect_element_data_t *elem_data;
+  double             *midpoint;
   char                fileprefix[BUFSIZ];
   int                 idim;
   double              phi;
@@ -1387,15 +1540,13 @@ t8_advect_write_vtk (t8_advect_problem_t * problem)
 
   /* Fill u and phi arrays with their values */
   for (ielem = 0; ielem < num_local_elements; ielem++) {
-    elem_data = (t8_advect_element_data_t *)
-      t8_sc_array_index_locidx (problem->element_data, ielem);
+    midpoint = t8_advect_element_midpoint (&problem->element_data, ielem);
     phi = t8_advect_element_get_phi (problem, ielem);
     u_and_phi_array[0][ielem] = phi;
     u_and_phi_array[1][ielem] =
-      problem->phi_0 (elem_data->midpoint, problem->t,
-                      problem->udata_for_phi);
+      problem->phi_0 (midpoint, problem->t, problem->udata_for_phi);
     u_and_phi_array[2][ielem] = phi - u_and_phi_array[1][ielem];
-    problem->u (elem_data->midpoint, problem->t, u_temp);
+    problem->u (midpoint, problem->t, u_temp);
     for (idim = 0; idim < 3; idim++) {
       u_and_phi_array[3][3 * ielem + idim] = u_temp[idim];
     }
@@ -1450,7 +1601,7 @@ t8_advect_print_phi (t8_advect_problem_t * problem)
   num_local_els = t8_forest_get_num_element (problem->forest);
   for (ielement = 0;
        ielement <
-       (t8_locidx_t) problem->element_data->elem_count; ielement++) {
+       (t8_locidx_t) problem->phi_values->elem_count; ielement++) {
     phi = t8_advect_element_get_phi (problem, ielement);
     snprintf (buffer + strlen (buffer),
               BUFSIZ - strlen (buffer), "%.2f |%s ",
@@ -1472,13 +1623,11 @@ t8_advect_problem_destroy (t8_advect_problem_t ** pproblem)
   if (problem == NULL) {
     return;
   }
-  /* destroy elements */
-  t8_advect_problem_elements_destroy (problem);
+  /* destroy the face list */
+  t8_advect_face_list_destroy (&problem->faces);
   /* Free the element array */
-  sc_array_destroy (problem->element_data);
-  if (problem->element_data_adapt != NULL) {
-    sc_array_destroy (problem->element_data_adapt);
-  }
+  t8_advect_element_data_reset (&problem->element_data);
+  t8_advect_element_data_reset (&problem->element_data_adapt);
   sc_array_destroy (problem->phi_values);
   if (problem->phi_values_adapt != NULL) {
     sc_array_destroy (problem->phi_values_adapt);
@@ -1490,44 +1639,128 @@ t8_advect_problem_destroy (t8_advect_problem_t ** pproblem)
   *pproblem = NULL;
 }
 
+/* Write the profile values of one phase as a JSON object */
 static void
+t8_advect_write_json_profile (FILE * file, const char *phase,
+                              const t8_profile_value_t * profile,
+                              int num_commits)
+{
+  int                 i;
+
+  fprintf (file, "    \"%s\": {\n      \"commits\": %i", phase, num_commits);
+  /* The profile values are means over the commits */
+  num_commits = SC_MAX (num_commits, 1);
+  for (i = 0; i < T8_FOREST_PROFILE_COUNT; i++) {
+    fprintf (file, ",\n      \"%s\": {\"min\": %.9e, \"avg\": %.9e, "
+             "\"max\": %.9e, \"imbalance\": %.6f}", advect_profile_names[i],
+             profile[i].min / num_commits, profile[i].avg / num_commits,
+             profile[i].max / num_commits, profile[i].imbalance);
+  }
+  fprintf (file, "\n    }");
+}
+
+/* Write the statistics of a benchmark run and the profiles of its adapted
+ * and partitioned forests as one JSON object on rank 0.
+ * The statistics must have been computed with sc_stats_compute.
+ * This function is collective.
+ * Return 0 on success and nonzero if the file cannot be written. */
+static int
+t8_advect_write_json (t8_advect_problem_t * problem, const char *json_file)
+{
+  t8_profile_value_t  profile_adapt[T8_FOREST_PROFILE_COUNT];
+  t8_profile_value_t  profile_partition[T8_FOREST_PROFILE_COUNT];
+  const sc_statinfo_t *stat;
+  FILE               *file;
+  int                 mpirank, mpisize, mpiret, i, retval = 0;
+
+  mpiret = sc_MPI_Comm_rank (problem->comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (problem->comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  t8_forest_profile_accum_reduce (&problem->profile_adapt, problem->comm,
+                                  profile_adapt);
+  t8_forest_profile_accum_reduce (&problem->profile_partition,
+                                  problem->comm, profile_partition);
+  if (mpirank != 0) {
+    return 0;
+  }
+  file = json_file != NULL ? fopen (json_file, "w") : stdout;
+  if (file == NULL) {
+    t8_errorf ("Could not open %s for writing.\n", json_file);
+    return 1;
+  }
+  fprintf (file, "{\n  \"benchmark\": \"advection\",\n");
+  fprintf (file, "  \"level\": %i,\n  \"rlevel\": %i,\n", problem->level,
+           problem->maxlevel - problem->level);
+  fprintf (file, "  \"dim\": %i,\n  \"lts\": %i,\n", problem->dim,
+           problem->lts);
+  fprintf (file, "  \"mpisize\": %i,\n  \"steps\": %i,\n", mpisize,
+           problem->num_time_steps);
+  fprintf (file, "  \"elements\": %lli,\n", (long long)
+           t8_forest_get_global_num_elements (problem->forest));
+  fprintf (file, "  \"stats\": {");
+  for (i = 0; i < ADVECT_NUM_STATS; i++) {
+    stat = &problem->stats[i];
+    fprintf (file, "%s\n    \"%s\": {\"count\": %li, \"min\": %.9e, "
+             "\"avg\": %.9e, \"max\": %.9e, \"stddev\": %.9e}",
+             i ? "," : "", advect_stat_names[i], (long) stat->count,
+             stat->min, stat->average, stat->max, stat->standard_deviation);
+  }
+  fprintf (file, "\n  },\n  \"profile\": {\n");
+  t8_advect_write_json_profile (file, "adapt", profile_adapt,
+                                problem->profile_adapt.num_commits);
+  fprintf (file, ",\n");
+  t8_advect_write_json_profile (file, "partition", profile_partition,
+                                problem->profile_partition.num_commits);
+  fprintf (file, "\n  }\n}\n");
+  if (file != stdout) {
+    retval = fclose (file);
+  }
+  return retval;
+}
+
+/* Solve the advection problem. If num_steps is positive, exactly num_steps
+ * time steps are computed instead of advancing to the end time T, and the
+ * statistics are written as JSON to json_file, or to stdout if it is NULL.
+ * Return nonzero if the JSON file cannot be written. */
+static int
 t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
                  t8_example_level_set_fn phi_0, void *ls_data,
                  const int level, const int maxlevel, double T, double cfl,
                  sc_MPI_Comm comm, int adapt_freq, int no_vtk,
                  int vtk_freq, double band_width, int dim, int dummy_op,
-                 int volume_refine)
+                 int volume_refine, double partition_imbalance, int lts,
+                 int num_steps, const char *json_file)
 {
   t8_advect_problem_t *problem;
-  int                 iface, ineigh;
-  t8_locidx_t         itree, ielement, lelement;
-  t8_advect_element_data_t *elem_data, *neigh_data = NULL;
-  double              flux;
+  t8_locidx_t         lelement;
   double              l_infty, L_2;
-  double             *tree_vertices;
   int                 modulus, time_steps;
-  int                 num_faces;
   int                 done = 0;
-  int                 adapted_or_partitioned = 0;
-  int                 dual_face;
-  t8_element_t       *elem, **neighs;
-  t8_eclass_scheme_c *neigh_scheme;
   double              total_time, solve_time = 0;
-  double              ghost_exchange_time, ghost_waittime, neighbor_time,
-    flux_time;
+  double              ghost_exchange_time, flux_time;
+  double              ghost_waittime, ghost_overlaptime, t_start;
+  t8_forest_ghost_exchange_t *exchange;
+  int                 isub, num_substeps, rate, min_rate, num_rates;
+  int                 do_adapt, num_adapts = 0;
+  int                 adapt_interval = 0, steps_since_adapt = 0;
+  t8_locidx_t        *rate_offsets;
   double              vtk_time = 0;
   double              start_volume, end_volume;
-  int                 hanging, neigh_is_ghost;
-  t8_locidx_t         neigh_index = -1;
-  double              phi_plus, phi_minus;
+  int                 retval = 0;
 
   /* Initialize problem */
   /* start timing */
   total_time = -sc_MPI_Wtime ();
+  if (adapt_freq == 0 && partition_imbalance == 0) {
+    /* With adaptive scheduling, only repartition if the load imbalance
+     * exceeds 5 percent */
+    partition_imbalance = 1.05;
+  }
   problem =
     t8_advect_problem_init (cmesh, u, phi_0, ls_data, level, maxlevel, T,
                             cfl, comm, band_width, dim, dummy_op,
-                            volume_refine);
+                            volume_refine, partition_imbalance, lts);
   t8_advect_problem_init_elements (problem);
 
   if (maxlevel > level) {
@@ -1541,7 +1774,9 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
       /* Re initialize the elements */
       t8_advect_problem_init_elements (problem);
     }
-    adapted_or_partitioned = 1;
+  }
+  if (maxlevel > level && adapt_freq == 0) {
+    adapt_interval = t8_advect_adapt_interval (problem);
   }
   start_volume = t8_advect_level_set_volume (problem);
   t8_global_essentialf ("[advect] Start volume %e\n", start_volume);
@@ -1554,7 +1789,7 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
   sc_stats_set1 (&problem->stats[ADVECT_INIT], total_time + sc_MPI_Wtime (),
                  advect_stat_names[ADVECT_INIT]);
 
-  time_steps = (int) (T / problem->delta_t);
+  time_steps = num_steps > 0 ? num_steps : (int) (T / problem->delta_t);
   t8_global_essentialf ("[advect] Starting with Computation. Level %i."
                         " Adaptive levels %i."
                         " End time %g. delta_t %g. cfl %g. %i time steps.\n",
@@ -1585,182 +1820,47 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
                          t8_forest_get_global_num_elements (problem->forest));
 
     solve_time -= sc_MPI_Wtime ();
-    for (itree = 0, lelement = 0;
-         itree < t8_forest_get_num_local_trees (problem->forest); itree++) {
-      /* tree loop */
-      /* Get the vertices of this tree */
-      tree_vertices = t8_forest_get_tree_vertices (problem->forest, itree);
-      /* Get the scheme of this tree */
-      for (ielement = 0;
-           ielement < t8_forest_get_tree_num_elements (problem->forest,
-                                                       itree);
-           ielement++, lelement++) {
-        /* element loop */
-        /* Get a pointer to the element data */
-        elem_data = (t8_advect_element_data_t *)
-          t8_sc_array_index_locidx (problem->element_data, lelement);
-        elem =
-          t8_forest_get_element_in_tree (problem->forest, itree, ielement);
-        num_faces = elem_data->num_faces;
-        /* Compute left and right flux */
-        for (iface = 0; iface < num_faces; iface++) {
-          if (elem_data->flux_valid[iface] <= 0 || adapted_or_partitioned) {
-
-            /* Compute flux at this face */
-            if (adapted_or_partitioned) {
-              /* We changed the mesh, so that we have to calculate the neighbor
-               * indices again. */
-              if (elem_data->num_neighbors[iface] > 0) {
-                T8_FREE (elem_data->neighs[iface]);
-                T8_FREE (elem_data->dual_faces[iface]);
-                elem_data->flux_valid[iface] = -1;
-              }
-              T8_FREE (elem_data->fluxes[iface]);
-              neighbor_time = -sc_MPI_Wtime ();
-              t8_forest_leaf_face_neighbors (problem->forest, itree, elem,
-                                             &neighs, iface,
-                                             &elem_data->dual_faces[iface],
-                                             &elem_data->num_neighbors[iface],
-                                             &elem_data->neighs[iface],
-                                             &neigh_scheme, 1);
-              for (ineigh = 0; ineigh < elem_data->num_neighbors[iface];
-                   ineigh++) {
-                elem_data->neigh_level[iface] =
-                  neigh_scheme->t8_element_level (neighs[ineigh]);
-              }
-
-
-
-              /* *INDENT-OFF* */
-              neigh_scheme->t8_element_destroy (elem_data->num_neighbors[iface],
-                                                neighs);
-              /* *INDENT-ON* */
-
-              T8_FREE (neighs);
-
-              /* Allocate flux storage */
-              elem_data->fluxes[iface] =
-                T8_ALLOC (double,
-                          SC_MAX (1, elem_data->num_neighbors[iface]));
-              elem_data->flux_valid[iface] = 0;
-
-              neighbor_time += sc_MPI_Wtime ();
-              sc_stats_accumulate (&problem->stats[ADVECT_NEIGHS],
-                                   neighbor_time);
-              /* We want to count all runs over the solver time as one */
-              problem->stats[ADVECT_NEIGHS].count = 1;
-            }
-
-            /* sensible default */
-            neigh_data = NULL;
-            neigh_is_ghost = 0;
-            /* Compute whether this is a hanging face
-             * and whether the first neighbor is a ghost */
-            if (elem_data->num_neighbors[iface] >= 1) {
-
-              neigh_index = elem_data->neighs[iface][0];
-              neigh_is_ghost = neigh_index >=
-                t8_forest_get_num_element (problem->forest);
-              hanging = elem_data->level != elem_data->neigh_level[iface];
-            }
-            else {
-              hanging = 0;
-              neigh_is_ghost = 0;
-            }
-            flux_time = -sc_MPI_Wtime ();
-            if (problem->dim == 1) {
-              if (elem_data->num_neighbors[iface] == 0) {
-                T8_ASSERT (elem_data->num_neighbors[iface] <= 0);
-                /* This is a boundary */
-                neigh_index = -1;
-              }
-#if 0
-              flux =
-                t8_advect_flux_lax_friedrich_1d (problem, plus_data,
-                                                 minus_data);
-#else
-              flux =
-                t8_advect_flux_upwind_1d (problem, lelement, neigh_index,
-                                          iface);
-#endif
-              elem_data->fluxes[iface][0] = flux;
-              elem_data->flux_valid[iface] = 1;
-            }
-            else {
-              T8_ASSERT (problem->dim == 2 || problem->dim == 3);
-              /* Check whether the flux for the neighbor element was computed */
-              /* Get a pointer to the neighbor element */
-              if (elem_data->num_neighbors[iface] >= 1 && !neigh_is_ghost) {
-                neigh_data = (t8_advect_element_data_t *)
-                  t8_sc_array_index_locidx (problem->element_data,
-                                            neigh_index);
-              }
-
-              /* Get the phi value at the current element */
-              phi_plus = t8_advect_element_get_phi (problem, lelement);
-              if (elem_data->num_neighbors[iface] == 1) {
-                dual_face = elem_data->dual_faces[iface][0];
-                /* There is exactly one face-neighbor */
-                /* get the phi value at the neighbor element */
-                phi_minus = t8_advect_element_get_phi (problem, neigh_index);
-                flux =
-                  t8_advect_flux_upwind (problem, phi_plus, phi_minus,
-                                         itree, elem, tree_vertices, iface);
-
-                elem_data->flux_valid[iface] = 1;
-                elem_data->fluxes[iface][0] = flux;
-
-                /* If this face is not hanging, we can set the
-                 * flux of the neighbor element as well */
-                if (!adapted_or_partitioned && !neigh_is_ghost && !hanging) {
-                  if (neigh_data->flux_valid[dual_face] < 0) {
-                    neigh_data->fluxes[dual_face] = T8_ALLOC (double, 1);
-                    neigh_data->dual_faces[dual_face] = T8_ALLOC (int, 1);
-                    neigh_data->neighs[dual_face] = T8_ALLOC (t8_locidx_t, 1);
-                  }
-                  SC_CHECK_ABORT (dual_face < neigh_data->num_faces, "num\n");
-                  //         SC_CHECK_ABORT (neigh_data->num_neighbors[dual_face] == 1, "dual face\n");
-                  neigh_data->fluxes[dual_face][0] = -flux;
-                  neigh_data->dual_faces[dual_face][0] = iface;
-                  neigh_data->neighs[dual_face][0] = lelement;
-                  neigh_data->flux_valid[dual_face] = 1;
-                }
-              }
-              else if (elem_data->num_neighbors[iface] > 1) {
-                flux =
-                  t8_advect_flux_upwind_hanging (problem, lelement, itree,
-                                                 elem, tree_vertices, iface,
-                                                 adapted_or_partitioned);
-              }
-              else {
-                /* This element is at the domain boundary */
-                /* We enforce outflow boundary conditions */
-                T8_ASSERT (elem_data->num_neighbors[iface] <= 0);
-                t8_advect_boundary_set_phi (problem, lelement, &phi_minus);
-
-                flux =
-                  t8_advect_flux_upwind (problem, phi_plus, phi_minus,
-                                         itree, elem, tree_vertices, iface);
-
-                elem_data->flux_valid[iface] = 1;
-                elem_data->fluxes[iface][0] = flux;
-              }
-            }
-            flux_time += sc_MPI_Wtime ();
-
-            sc_stats_accumulate (&problem->stats[ADVECT_FLUX], flux_time);
-            /* We want to count all runs over the solver time as one */
-            problem->stats[ADVECT_FLUX].count = 1;
-          }
-        }
-        if (problem->dummy_op) {
-          /* simulate more load per element */
-          int                 i, j;
-          double             *phi_values;
-          double              dummy_time = -sc_MPI_Wtime ();
+    /* The elements of rate r do a step in every 2^(num_rates - 1 - r)-th
+     * substep. Without local time stepping there is one substep. */
+    num_rates = problem->num_rates;
+    num_substeps = 1 << (num_rates - 1);
+    t_start = problem->t;
+    ghost_exchange_time = flux_time = 0;
+    ghost_waittime = ghost_overlaptime = 0;
+    for (isub = 0; isub < num_substeps; isub++) {
+      problem->t = t_start + isub * problem->delta_t / num_substeps;
+      /* The faces of rate at least min_rate start a step in this substep */
+      min_rate = num_rates - 1;
+      while (min_rate > 0 && isub % (1 << (num_rates - min_rate)) == 0) {
+        min_rate--;
+      }
+      rate_offsets = problem->faces.rate_offsets;
+      /* Start to exchange the ghost values. While they are in flight, we
+       * compute the fluxes of the faces without a ghost. */
+      ghost_exchange_time -= sc_MPI_Wtime ();
+      exchange =
+        t8_forest_ghost_exchange_begin (problem->forest, problem->phi_values);
+      ghost_exchange_time += sc_MPI_Wtime ();
+      flux_time -= sc_MPI_Wtime ();
+      for (rate = num_rates - 1; rate >= min_rate; rate--) {
+        t8_advect_compute_fluxes (problem,
+                                  rate_offsets[num_rates - 1 - rate],
+                                  rate_offsets[num_rates - rate],
+                                  problem->delta_t / (1 << rate));
+      }
+      flux_time += sc_MPI_Wtime ();
+      if (problem->dummy_op && isub == 0) {
+        /* simulate more load per element */
+        int                 i, j;
+        double             *phi_values;
+        double              dummy_time = -sc_MPI_Wtime ();
+
+        for (lelement = 0;
+             lelement < t8_forest_get_num_element (problem->forest);
+             lelement++) {
           phi_values =
             (double *) t8_sc_array_index_locidx (problem->phi_values,
-                                                 ielement);
+                                                 lelement);
           phi_values[1] = 0;
           for (i = 1; i < 5; i++) {
             phi_values[1] *= i;
@@ -1768,55 +1868,79 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
               phi_values[1] += pow (i, j);
             }
           }
-          dummy_time += sc_MPI_Wtime ();
-          sc_stats_accumulate (&problem->stats[ADVECT_DUMMY], dummy_time);
-          problem->stats[ADVECT_DUMMY].count = 1;
         }
-        /* Compute time step */
-        //      printf ("advance %i\n", ielement);
-        t8_advect_advance_element (problem, lelement);
+        dummy_time += sc_MPI_Wtime ();
+        sc_stats_accumulate (&problem->stats[ADVECT_DUMMY], dummy_time);
+        problem->stats[ADVECT_DUMMY].count = 1;
       }
-    }
-    adapted_or_partitioned = 0;
-    /* Store the advanced phi value in each element */
-    t8_advect_project_element_data (problem);
-    solve_time += sc_MPI_Wtime ();
-#if 0
-    /* test adapt, adapt and balance 3 times during the whole computation */
-    if (adapt && time_steps / 3 > 0
-        && problem->num_time_steps % (time_steps / 3) == (time_steps / 3) - 1)
-#else
-    if (maxlevel > level) {
-      /* Adapt the mesh after adapt_freq time steps */
-      if (problem->num_time_steps % adapt_freq == adapt_freq - 1)
-#endif
-      {
-        adapted_or_partitioned = 1;
-        t8_advect_problem_adapt (problem, 1);
-        t8_advect_problem_partition (problem, 1);
+      /* Finish the ghost exchange and compute the fluxes at the ghosts */
+      ghost_exchange_time -= sc_MPI_Wtime ();
+      t8_forest_ghost_exchange_end (exchange);
+      ghost_exchange_time += sc_MPI_Wtime ();
+      ghost_waittime +=
+        t8_forest_profile_get_ghostexchange_waittime (problem->forest);
+      ghost_overlaptime +=
+        t8_forest_profile_get_ghostexchange_overlaptime (problem->forest);
+      flux_time -= sc_MPI_Wtime ();
+      for (rate = num_rates - 1; rate >= min_rate; rate--) {
+        t8_advect_compute_fluxes (problem,
+                                  rate_offsets[2 * num_rates - 1 - rate],
+                                  rate_offsets[2 * num_rates - rate],
+                                  problem->delta_t / (1 << rate));
       }
+      t8_advect_advance_elements (problem, isub);
+      flux_time += sc_MPI_Wtime ();
     }
-
-    /* Exchange ghost values */
-    ghost_exchange_time = -sc_MPI_Wtime ();
-    t8_forest_ghost_exchange_data (problem->forest, problem->phi_values);
-    ghost_exchange_time += sc_MPI_Wtime ();
+    problem->t = t_start;
+    sc_stats_accumulate (&problem->stats[ADVECT_FLUX], flux_time);
     sc_stats_accumulate (&problem->stats[ADVECT_GHOST_EXCHANGE],
                          ghost_exchange_time);
-    ghost_waittime =
-      t8_forest_profile_get_ghostexchange_waittime (problem->forest);
     sc_stats_accumulate (&problem->stats[ADVECT_GHOST_WAIT], ghost_waittime);
+    sc_stats_accumulate (&problem->stats[ADVECT_GHOST_OVERLAP],
+                         ghost_overlaptime);
     /* We want to count all runs over the solver time as one */
+    problem->stats[ADVECT_FLUX].count = 1;
     problem->stats[ADVECT_GHOST_EXCHANGE].count = 1;
     problem->stats[ADVECT_GHOST_WAIT].count = 1;
+    problem->stats[ADVECT_GHOST_OVERLAP].count = 1;
+    solve_time += sc_MPI_Wtime ();
+    /* The ghost exchange is measured separately */
+    solve_time -= ghost_exchange_time;
+    if (maxlevel > level) {
+      /* Adapt the mesh after adapt_freq time steps. If adapt_freq is 0,
+       * adapt before the front can leave the band of finest elements. */
+      if (adapt_freq > 0) {
+        do_adapt = problem->num_time_steps % adapt_freq == adapt_freq - 1;
+      }
+      else {
+        do_adapt = ++steps_since_adapt >= adapt_interval;
+      }
+      if (do_adapt) {
+        t8_advect_problem_adapt (problem, 1);
+        t8_advect_problem_partition (problem, 1);
+        /* The faces changed */
+        t8_advect_face_list_build (problem);
+        num_adapts++;
+        if (adapt_freq == 0) {
+          adapt_interval = t8_advect_adapt_interval (problem);
+          steps_since_adapt = 0;
+        }
+      }
+    }
 
-    if (problem->t + problem->delta_t > problem->T) {
-      /* Ensure that the last time step is always the given end time */
-      problem->delta_t = problem->T - problem->t;
+    if (num_steps > 0) {
+      /* A benchmark run ends after a fixed number of steps */
+      done = problem->num_time_steps + 1 >= num_steps;
     }
-    /* Check whether we are finished */
-    if (problem->t >= problem->T) {
-      done = 1;
+    else {
+      if (problem->t + problem->delta_t > problem->T) {
+        /* Ensure that the last time step is always the given end time */
+        problem->delta_t = problem->T - problem->t;
+      }
+      /* Check whether we are finished */
+      if (problem->t >= problem->T) {
+        done = 1;
+      }
     }
   }                             /* End element loop */
   if (!no_vtk) {
@@ -1833,6 +1957,11 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
                  advect_stat_names[ADVECT_SOLVE]);
   sc_stats_set1 (&problem->stats[ADVECT_IO], vtk_time,
                  advect_stat_names[ADVECT_IO]);
+  sc_stats_set1 (&problem->stats[ADVECT_NUM_ADAPT], num_adapts,
+                 advect_stat_names[ADVECT_NUM_ADAPT]);
+  sc_stats_set1 (&problem->stats[ADVECT_UPDATES],
+                 problem->num_updates / problem->t,
+                 advect_stat_names[ADVECT_UPDATES]);
   /* Compute volume loss */
 
   end_volume = t8_advect_level_set_volume (problem);
@@ -1856,8 +1985,12 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
   sc_stats_compute (problem->comm, ADVECT_NUM_STATS, problem->stats);
   sc_stats_print (t8_get_package_id (), SC_LP_ESSENTIAL, ADVECT_NUM_STATS,
                   problem->stats, 1, 1);
+  if (num_steps > 0) {
+    retval = t8_advect_write_json (problem, json_file);
+  }
   /* clean-up */
   t8_advect_problem_destroy (&problem);
+  return retval;
 }
 
 int
@@ -1870,8 +2003,9 @@ main (int argc, char *argv[])
   int                 level, reflevel, dim, eclass_int, dummy_op;
   int                 parsed, helpme, no_vtk, vtk_freq, adapt_freq;
   int                 volume_refine;
-  int                 flow_arg;
-  double              T, cfl, band_width;
+  int                 flow_arg, lts, num_steps, retval = 0;
+  const char         *json_file;
+  double              T, cfl, band_width, partition_imbalance;
   t8_levelset_sphere_data_t ls_data;
   /* brief help message */
 
@@ -1935,7 +2069,11 @@ main (int argc, char *argv[])
 
   sc_options_add_int (opt, 'a', "adapt-freq", &adapt_freq, 1,
                       "Controls how often the mesh is readapted. "
-                      "A value of i means, every i-th time step.");
+                      "A value of i means, every i-th time step.\n"
+                      "\t\t\t\t     A value of 0 adapts before the front "
+                      "can leave the refinement band\n"
+                      "\t\t\t\t     and only repartitions if the "
+                      "imbalance exceeds -I (default 1.05).");
 
   sc_options_add_int (opt, 'v', "vtk-freq", &vtk_freq, 1,
                       "How often the vtk output is produced "
@@ -1965,6 +2103,25 @@ main (int argc, char *argv[])
                       "if their volume is smaller than the l+V-times refined\n"
                       " smallest element int the mesh.");
 
+  sc_options_add_double (opt, 'I', "imbalance", &partition_imbalance, 0,
+                         "Do not repartition if the ratio of the maximum and "
+                         "the average number\n\t\t\t\t     of elements is at "
+                         "most this value. Default 0, always repartition.");
+
+  sc_options_add_switch (opt, 'L', "local-time-stepping", &lts,
+                         "Advance the elements with level dependent time "
+                         "steps.\n\t\t\t\t     An element of level l does "
+                         "2^(l - level) steps per time step.");
+
+  sc_options_add_int (opt, 'N', "bench-steps", &num_steps, 0,
+                      "If positive, run as a benchmark: Compute this "
+                      "number of time steps instead\n\t\t\t\t     of "
+                      "advancing to -T, suppress vtk output, and write "
+                      "the statistics as JSON.");
+  sc_options_add_string (opt, 'j', "json", &json_file, NULL,
+                         "Together with -N: Write the JSON statistics to "
+                         "this file instead of stdout.");
+
   parsed =
     sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
   if (helpme) {
@@ -1973,7 +2130,8 @@ main (int argc, char *argv[])
     sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
   }
   else if (parsed >= 0 && 1 <= flow_arg && flow_arg <= 6 && 0 <= level
-           && 0 <= reflevel && 0 <= vtk_freq
+           && 0 <= reflevel && 0 <= vtk_freq && 0 <= adapt_freq
+           && 0 <= num_steps
            && ((mshfile != NULL && 0 < dim && dim <= 3)
                || (1 <= eclass_int && eclass_int <= 8)) && band_width >= 0) {
     t8_cmesh_t          cmesh;
@@ -2004,16 +2162,21 @@ main (int argc, char *argv[])
       t8_advect_create_cmesh (sc_MPI_COMM_WORLD, (t8_eclass_t) eclass_int,
                               mshfile, level, dim);
     u = t8_advect_choose_flow (flow_arg);
+    if (num_steps > 0) {
+      /* The benchmark measures the solver only */
+      no_vtk = 1;
+    }
     if (!no_vtk) {
       t8_cmesh_vtk_write_file (cmesh, "advection_cmesh", 1.0);
     }
     /* Computation */
-    t8_advect_solve (cmesh, u,
-                     t8_levelset_sphere, &ls_data,
-                     level,
-                     level + reflevel, T, cfl, sc_MPI_COMM_WORLD, adapt_freq,
-                     no_vtk, vtk_freq, band_width, dim, dummy_op,
-                     volume_refine);
+    retval = t8_advect_solve (cmesh, u,
+                              t8_levelset_sphere, &ls_data,
+                              level,
+                              level + reflevel, T, cfl, sc_MPI_COMM_WORLD,
+                              adapt_freq, no_vtk, vtk_freq, band_width, dim,
+                              dummy_op, volume_refine, partition_imbalance,
+                              lts, num_steps, json_file);
   }
   else {
     /* wrong usage */
@@ -2025,5 +2188,5 @@ main (int argc, char *argv[])
   sc_finalize ();
   mpiret = sc_MPI_Finalize ();
   SC_CHECK_MPI (mpiret);
-  return 0;
+  return retval;
 }
@@ -153,8 +153,10 @@ t8_common_adapt_level_set (t8_forest_t forest,
 {
   t8_example_level_set_struct_t *data;
   int                 within_band;
-  int                 level;
+  int                 level, i;
   double             *tree_vertices;
+  const double       *centroids[3], *diameters;
+  double              centroid[3];
 
   T8_ASSERT (num_elements == 1 || num_elements ==
              ts->t8_element_num_children (elements[0]));
@@ -181,10 +183,24 @@ t8_common_adapt_level_set (t8_forest_t forest,
   if (level < data->min_level) {
     return 1;
   }
-  within_band =
-    t8_common_within_levelset (forest_from, which_tree, elements[0],
-                               ts, tree_vertices, data->L,
-                               data->band_width / 2, data->t, data->udata);
+  if (data->band_width > 0
+      && t8_forest_adapt_get_geometry (forest_from, which_tree, lelement_id,
+                                       elements[0], NULL, centroids,
+                                       &diameters)) {
+    /* Use the cached centroid and diameter of the element */
+    for (i = 0; i < 3; i++) {
+      centroid[i] = centroids[i][0];
+    }
+    within_band = fabs (data->L (centroid, data->t, data->udata))
+      < data->band_width / 2 * diameters[0];
+  }
+  else {
+    within_band =
+      t8_common_within_levelset (forest_from, which_tree, elements[0],
+                                 ts, tree_vertices, data->L,
+                                 data->band_width / 2, data->t,
+                                 data->udata);
+  }
   if (within_band && level < data->max_level) {
     /* The element can be refined and lies inside the refinement region */
     return 1;
@@ -147,6 +147,19 @@ typedef struct
 double              t8_levelset_sphere (const double x[3], double t,
                                         void *data);
 
+/** Distance to a sphere for a batch of points.
+ * This is \ref t8_levelset_sphere as a \ref t8_forest_levelset_fn.
+ * \param [in]  n       The number of points.
+ * \param [in]  points  The points as a batch of 3 \a n doubles.
+ * \param [in]  t       Not used.
+ * \param [in]  data    Interpreted as t8_levelset_sphere_data_t.
+ * \param [out] values  The distance of each point to the sphere.
+ */
+void                t8_levelset_sphere_batch (size_t n,
+                                              const double *points,
+                                              double t, void *data,
+                                              double *values);
+
 /** Returns always 1.
  * \return 1
  */
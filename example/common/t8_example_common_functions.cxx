@@ -37,6 +37,24 @@ t8_levelset_sphere (const double x[3], double t, void *data)
   return t8_vec_dist (x, ls_data->M) - ls_data->radius;
 }
 
+void
+t8_levelset_sphere_batch (size_t n, const double *points, double t,
+                          void *data, double *values)
+{
+  const t8_levelset_sphere_data_t *ls_data =
+    (const t8_levelset_sphere_data_t *) data;
+  const double       *x = points, *y = points + n, *z = points + 2 * n;
+  const double        mx = ls_data->M[0], my = ls_data->M[1];
+  const double        mz = ls_data->M[2], radius = ls_data->radius;
+  size_t              i;
+
+  T8_ASSERT (ls_data->radius > 0);
+  for (i = 0; i < n; i++) {
+    values[i] = sqrt ((x[i] - mx) * (x[i] - mx) + (y[i] - my) * (y[i] - my)
+                      + (z[i] - mz) * (z[i] - mz)) - radius;
+  }
+}
+
 double
 t8_scalar3d_constant_one (const double x[3], double t)
 {
@@ -26,6 +26,7 @@
 #include <t8_element_cxx.hxx>
 #include <t8_default_cxx.hxx>
 #include <t8_forest.h>
+#include <t8_forest/t8_forest_levelset.h>
 #include <t8_cmesh.h>
 #include <t8_cmesh_readmshfile.h>
 #include <t8_cmesh_vtk.h>
@@ -81,10 +82,10 @@ t8_test_ghost_set_levelset_data (t8_forest_t forest_adapt,
                                  const double radius, const double band_width)
 {
   /* Build the struct containing all information about the levelset refinement */
-  t8_example_level_set_struct_t *levelSetData;
+  t8_forest_levelset_t *levelSetData;
   t8_levelset_sphere_data_t *sphere_data;
   /* Allocate memory */
-  levelSetData = T8_ALLOC (t8_example_level_set_struct_t, 1);
+  levelSetData = T8_ALLOC (t8_forest_levelset_t, 1);
   sphere_data = T8_ALLOC (t8_levelset_sphere_data_t, 1);
 
   /* Set the midpount of the sphere */
@@ -95,12 +96,13 @@ t8_test_ghost_set_levelset_data (t8_forest_t forest_adapt,
   sphere_data->radius = radius;
 
   /* Set levelSetData members */
-  levelSetData->L = t8_levelset_sphere;
-  levelSetData->band_width = band_width;
+  levelSetData->levelset = t8_levelset_sphere_batch;
+  /* The same band as with t8_common_adapt_level_set */
+  levelSetData->band_width = band_width / 2;
   levelSetData->max_level = max_level;
   levelSetData->min_level = min_level;
   levelSetData->t = 0;
-  levelSetData->udata = sphere_data;
+  levelSetData->user = sphere_data;
   /* Attach levelSetData to forest */
   t8_forest_set_user_data (forest_adapt, levelSetData);
 }
@@ -110,9 +112,9 @@ t8_test_ghost_set_levelset_data (t8_forest_t forest_adapt,
 static void
 t8_test_ghost_clean_levelset_data (t8_forest_t forest)
 {
-  t8_example_level_set_struct_t *data = (t8_example_level_set_struct_t *)
+  t8_forest_levelset_t *data = (t8_forest_levelset_t *)
     t8_forest_get_user_data (forest);
-  T8_FREE (data->udata);
+  T8_FREE (data->user);
   T8_FREE (data);
 }
 
@@ -163,7 +165,8 @@ t8_test_ghost_refine_and_partition (t8_cmesh_t cmesh, const int level,
       adapt_fn = t8_refine_p8est;
       break;
     case REFINE_SPHERE:
-      adapt_fn = t8_common_adapt_level_set;
+      /* The level-set is evaluated for whole trees */
+      adapt_fn = NULL;
       break;
     default:
       SC_ABORT_NOT_REACHED ();  /* Invalid value */
@@ -187,7 +190,13 @@ t8_test_ghost_refine_and_partition (t8_cmesh_t cmesh, const int level,
         t8_forest_set_user_data (forest_ghost,
                                  t8_forest_get_user_data (forest));
       }
-      t8_forest_set_adapt (forest_ghost, forest, adapt_fn, 0);
+      if (adapt_fn != NULL) {
+        t8_forest_set_adapt (forest_ghost, forest, adapt_fn, 0);
+      }
+      else {
+        t8_forest_set_adapt_tree (forest_ghost, forest,
+                                  t8_forest_adapt_levelset);
+      }
       t8_forest_commit (forest_ghost);
       forest = forest_ghost;
       t8_forest_init (&forest_ghost);
@@ -0,0 +1,550 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* A benchmark driver for the main operations of t8code.
+ * Usage: t8_bench [options] <benchmark>
+ * where <benchmark> is one of uniform, adapt, partition, balance, ghost,
+ * ghost_exchange, ghost_plan, ghost_rma, search, or vtk.
+ * ghost_plan and ghost_rma time one exchange with a two-sided and a
+ * one-sided ghost exchange plan; the plans are created outside of the
+ * timed region.
+ * The chosen operation is repeated several times on the same input forest.
+ * Rank 0 writes one JSON object with the minimum, median, and maximum
+ * runtime over the repetitions, the accumulated forest profile, and,
+ * if available, the hardware counters of the repetitions.
+ * The runtime of a repetition is the maximum over all processes. */
+
+#include <sc_options.h>
+#include <t8_cmesh.h>
+#include <t8_cmesh_readmshfile.h>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_iterate.h>
+#include <t8_default_cxx.hxx>
+#include <t8_counters.h>
+#include <t8_threads.h>
+
+/* The benchmarks */
+typedef enum t8_bench
+{
+  T8_BENCH_UNIFORM = 0,
+  T8_BENCH_ADAPT,
+  T8_BENCH_PARTITION,
+  T8_BENCH_BALANCE,
+  T8_BENCH_GHOST,
+  T8_BENCH_GHOST_EXCHANGE,
+  T8_BENCH_GHOST_PLAN,
+  T8_BENCH_GHOST_RMA,
+  T8_BENCH_SEARCH,
+  T8_BENCH_VTK,
+  T8_BENCH_COUNT
+} t8_bench_t;
+
+static const char  *t8_bench_names[T8_BENCH_COUNT] = {
+  "uniform", "adapt", "partition", "balance", "ghost", "ghost_exchange",
+  "ghost_plan", "ghost_rma", "search", "vtk"
+};
+
+/* The JSON keys of the values of t8_forest_profile_value_t */
+static const char  *t8_bench_profile_names[T8_FOREST_PROFILE_COUNT] = {
+  "elements", "ghosts", "partition_bytes_sent", "adapt_runtime",
+  "partition_runtime", "ghost_runtime", "balance_runtime", "commit_runtime"
+};
+
+/* The JSON keys of the values of t8_counter_t */
+static const char  *t8_bench_counter_names[T8_COUNTER_COUNT] = {
+  "cycles", "instructions", "llc_misses", "branch_misses"
+};
+
+/* The settings of a benchmark run */
+typedef struct
+{
+  t8_bench_t          bench;    /* The benchmark */
+  t8_eclass_t         eclass;   /* The tree class of the built-in cmeshes */
+  const char         *cmesh;    /* The name of the built-in cmesh */
+  const char         *mshfile;  /* If not NULL, read the cmesh from this file */
+  int                 dim;      /* The dimension of mshfile */
+  int                 num_trees;        /* The number of trees of bigmesh */
+  int                 level;    /* The uniform level of the input forest */
+  int                 rlevel;   /* The number of levels refined by adapt */
+  int                 repetitions;      /* The number of timed repetitions */
+  const char         *vtk_prefix;       /* The prefix of the vtk files */
+} t8_bench_options_t;
+
+/* The results of a benchmark run on this process */
+typedef struct
+{
+  double             *times;    /* The runtime of each repetition */
+  t8_forest_profile_accum_t profile;    /* The profile of the output forests */
+  double              counters[T8_COUNTER_COUNT];       /* The sums of the
+                                                           hardware counters */
+} t8_bench_result_t;
+
+/* Refine the elements whose centroid lies in a band around the plane
+ * x + y + z = 1 up to the maximum level given as user data.
+ * This produces a forest with several levels that is not balanced. */
+static int
+t8_bench_adapt_band (t8_forest_t forest, t8_forest_t forest_from,
+                     t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                     t8_eclass_scheme_c * ts, int num_elements,
+                     t8_element_t * elements[])
+{
+  double              centroid[3];
+  int                 max_level;
+
+  max_level = *(int *) t8_forest_get_user_data (forest);
+  if (ts->t8_element_level (elements[0]) >= max_level) {
+    return 0;
+  }
+  t8_forest_element_centroid (forest_from, which_tree, elements[0],
+                              t8_forest_get_tree_vertices (forest_from,
+                                                           which_tree),
+                              centroid);
+  return fabs (centroid[0] + centroid[1] + centroid[2] - 1) < .2;
+}
+
+/* Count the elements visited by a search of the whole forest */
+static int
+t8_bench_search_all (t8_forest_t forest, t8_locidx_t ltreeid,
+                     const t8_element_t * element,
+                     t8_element_array_t * leaf_elements, void *user_data,
+                     t8_locidx_t tree_leaf_index)
+{
+  (*(t8_locidx_t *) user_data)++;
+  return 1;
+}
+
+/* Create the cmesh of the benchmark */
+static t8_cmesh_t
+t8_bench_cmesh (const t8_bench_options_t * opts, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+
+  if (opts->mshfile != NULL) {
+    cmesh = t8_cmesh_from_msh_file (opts->mshfile, 0, comm, opts->dim, 0);
+  }
+  else if (!strcmp (opts->cmesh, "hypercube")) {
+    cmesh = t8_cmesh_new_hypercube (opts->eclass, comm, 0, 0, 0);
+  }
+  else if (!strcmp (opts->cmesh, "periodic")) {
+    cmesh = t8_cmesh_new_hypercube (opts->eclass, comm, 0, 0, 1);
+  }
+  else if (!strcmp (opts->cmesh, "hybrid")) {
+    cmesh = t8_cmesh_new_hypercube_hybrid (3, comm, 0, 0);
+  }
+  else if (!strcmp (opts->cmesh, "bigmesh")) {
+    cmesh = t8_cmesh_new_bigmesh (opts->eclass, opts->num_trees, comm);
+  }
+  else {
+    cmesh = NULL;
+  }
+  SC_CHECK_ABORTF (cmesh != NULL, "Could not create the cmesh %s",
+                   opts->mshfile != NULL ? opts->mshfile : opts->cmesh);
+  return cmesh;
+}
+
+/* Derive a forest from forest_from. Each of the arguments adapt,
+ * partition, balance, and ghost enables the respective step.
+ * forest_from is not unreferenced. */
+static t8_forest_t
+t8_bench_derive (t8_forest_t forest_from, int *max_level, int adapt,
+                 int partition, int balance, int ghost, int profiling)
+{
+  t8_forest_t         forest;
+
+  t8_forest_ref (forest_from);
+  t8_forest_init (&forest);
+  if (adapt) {
+    t8_forest_set_user_data (forest, max_level);
+    t8_forest_set_adapt (forest, forest_from, t8_bench_adapt_band, 1);
+  }
+  else if (!partition && !balance) {
+    t8_forest_set_copy (forest, forest_from);
+  }
+  if (partition) {
+    t8_forest_set_partition (forest, adapt ? NULL : forest_from, 0);
+  }
+  if (balance) {
+    t8_forest_set_balance (forest, adapt
+                           || partition ? NULL : forest_from, 0);
+  }
+  if (ghost) {
+    t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+  }
+  t8_forest_set_profiling (forest, profiling);
+  t8_forest_commit (forest);
+  return forest;
+}
+
+/* Run one repetition of the benchmark on the input forest and add the
+ * output forest to the profile. Return the runtime on this process. */
+static double
+t8_bench_run_once (const t8_bench_options_t * opts, t8_cmesh_t cmesh,
+                   t8_scheme_cxx_t * scheme, t8_forest_t input,
+                   t8_bench_result_t * result, sc_MPI_Comm comm)
+{
+  int                 max_level = opts->level + opts->rlevel;
+  int                 mpiret;
+  t8_locidx_t         ielement, num_visited;
+  t8_forest_t         output = NULL;
+  sc_array_t         *data;
+  t8_forest_ghost_plan_t *plan = NULL;
+  int64_t             counts[T8_COUNTER_COUNT];
+  double              runtime;
+  int                 icounter;
+
+  data = NULL;
+  if (opts->bench == T8_BENCH_GHOST_EXCHANGE
+      || opts->bench == T8_BENCH_GHOST_PLAN
+      || opts->bench == T8_BENCH_GHOST_RMA) {
+    data = sc_array_new_count (sizeof (double),
+                               t8_forest_get_num_element (input)
+                               + t8_forest_get_num_ghosts (input));
+    for (ielement = 0; ielement < t8_forest_get_num_element (input);
+         ielement++) {
+      *(double *) sc_array_index_int (data, ielement) = ielement;
+    }
+  }
+  if (opts->bench == T8_BENCH_GHOST_PLAN) {
+    plan = t8_forest_ghost_plan_new (input, sizeof (double));
+  }
+  else if (opts->bench == T8_BENCH_GHOST_RMA) {
+    plan = t8_forest_ghost_plan_new_rma (input, sizeof (double));
+  }
+  /* Start all processes at the same time */
+  mpiret = sc_MPI_Barrier (comm);
+  SC_CHECK_MPI (mpiret);
+  t8_counters_start (counts);
+  runtime = -sc_MPI_Wtime ();
+  switch (opts->bench) {
+  case T8_BENCH_UNIFORM:
+    t8_cmesh_ref (cmesh);
+    t8_scheme_cxx_ref (scheme);
+    t8_forest_init (&output);
+    t8_forest_set_cmesh (output, cmesh, comm);
+    t8_forest_set_scheme (output, scheme);
+    t8_forest_set_level (output, opts->level);
+    t8_forest_set_profiling (output, 1);
+    t8_forest_commit (output);
+    break;
+  case T8_BENCH_ADAPT:
+    output = t8_bench_derive (input, &max_level, 1, 0, 0, 0, 1);
+    break;
+  case T8_BENCH_PARTITION:
+    output = t8_bench_derive (input, NULL, 0, 1, 0, 0, 1);
+    break;
+  case T8_BENCH_BALANCE:
+    output = t8_bench_derive (input, NULL, 0, 0, 1, 0, 1);
+    break;
+  case T8_BENCH_GHOST:
+    output = t8_bench_derive (input, NULL, 0, 0, 0, 1, 1);
+    break;
+  case T8_BENCH_GHOST_EXCHANGE:
+    t8_forest_ghost_exchange_data (input, data);
+    break;
+  case T8_BENCH_GHOST_PLAN:
+  case T8_BENCH_GHOST_RMA:
+    t8_forest_ghost_plan_exchange (plan, data);
+    break;
+  case T8_BENCH_SEARCH:
+    num_visited = 0;
+    t8_forest_search (input, t8_bench_search_all, &num_visited);
+    T8_ASSERT (num_visited >= t8_forest_get_num_element (input));
+    break;
+  case T8_BENCH_VTK:
+    t8_forest_write_vtk (input, opts->vtk_prefix);
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  runtime += sc_MPI_Wtime ();
+  t8_counters_stop (counts);
+  for (icounter = 0; icounter < T8_COUNTER_COUNT; icounter++) {
+    result->counters[icounter] += counts[icounter];
+  }
+
+  if (plan != NULL) {
+    t8_forest_ghost_plan_destroy (&plan);
+  }
+  if (data != NULL) {
+    sc_array_destroy (data);
+  }
+  if (output != NULL) {
+    t8_forest_profile_accumulate (&result->profile, output);
+    t8_forest_unref (&output);
+  }
+  else {
+    t8_forest_profile_accumulate (&result->profile, input);
+  }
+  return runtime;
+}
+
+/* Create the input forest of a benchmark. It is NULL for uniform. */
+static t8_forest_t
+t8_bench_input (const t8_bench_options_t * opts, t8_cmesh_t cmesh,
+                t8_scheme_cxx_t * scheme, sc_MPI_Comm comm)
+{
+  int                 max_level = opts->level + opts->rlevel;
+  t8_forest_t         uniform, adapted, input;
+
+  if (opts->bench == T8_BENCH_UNIFORM) {
+    return NULL;
+  }
+  t8_cmesh_ref (cmesh);
+  t8_scheme_cxx_ref (scheme);
+  uniform = t8_forest_new_uniform (cmesh, scheme, opts->level, 0, comm);
+  if (opts->bench == T8_BENCH_ADAPT) {
+    return uniform;
+  }
+  /* Partition benchmarks the adapted forest with its load imbalance */
+  adapted = t8_bench_derive (uniform, &max_level, 1, 0, 0, 0, 0);
+  t8_forest_unref (&uniform);
+  if (opts->bench == T8_BENCH_PARTITION) {
+    return adapted;
+  }
+  input = t8_bench_derive (adapted, NULL, 0, 1, 0,
+                           opts->bench >= T8_BENCH_GHOST_EXCHANGE, 0);
+  t8_forest_unref (&adapted);
+  return input;
+}
+
+/* Compare two doubles for qsort */
+static int
+t8_bench_compare_double (const void *a, const void *b)
+{
+  const double        x = *(const double *) a, y = *(const double *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/* Write the timing statistics of a result as a JSON object */
+static void
+t8_bench_write_json (FILE * file, const t8_bench_options_t * opts,
+                     const double *times, const t8_profile_value_t * profile,
+                     const t8_profile_value_t * counters, int num_commits,
+                     int mpisize)
+{
+  double             *sorted;
+  double              median;
+  int                 n = opts->repetitions, i;
+
+  sorted = T8_ALLOC (double, n);
+  memcpy (sorted, times, n * sizeof (double));
+  qsort (sorted, n, sizeof (double), t8_bench_compare_double);
+  median = n % 2 ? sorted[n / 2] : .5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+
+  fprintf (file, "{\n  \"benchmark\": \"%s\",\n", t8_bench_names[opts->bench]);
+  fprintf (file, "  \"cmesh\": \"%s\",\n",
+           opts->mshfile != NULL ? opts->mshfile : opts->cmesh);
+  fprintf (file, "  \"eclass\": \"%s\",\n",
+           t8_eclass_to_string[opts->eclass]);
+  fprintf (file, "  \"level\": %i,\n  \"rlevel\": %i,\n", opts->level,
+           opts->rlevel);
+  fprintf (file, "  \"mpisize\": %i,\n  \"num_threads\": %i,\n", mpisize,
+           t8_get_num_threads ());
+  fprintf (file, "  \"repetitions\": %i,\n", n);
+  fprintf (file, "  \"time\": {\"min\": %.9e, \"median\": %.9e, "
+           "\"max\": %.9e},\n", sorted[0], median, sorted[n - 1]);
+  fprintf (file, "  \"times\": [");
+  for (i = 0; i < n; i++) {
+    fprintf (file, "%s%.9e", i ? ", " : "", times[i]);
+  }
+  fprintf (file, "],\n");
+  /* The profile values are means over the commits */
+  fprintf (file, "  \"profile\": {");
+  for (i = 0; i < T8_FOREST_PROFILE_COUNT; i++) {
+    fprintf (file, "%s\n    \"%s\": {\"min\": %.9e, \"avg\": %.9e, "
+             "\"max\": %.9e, \"imbalance\": %.6f}", i ? "," : "",
+             t8_bench_profile_names[i], profile[i].min / num_commits,
+             profile[i].avg / num_commits, profile[i].max / num_commits,
+             profile[i].imbalance);
+  }
+  fprintf (file, "\n  }");
+  /* The counters are means over the repetitions */
+  if (counters != NULL) {
+    fprintf (file, ",\n  \"counters\": {");
+    for (i = 0; i < T8_COUNTER_COUNT; i++) {
+      fprintf (file, "%s\n    \"%s\": {\"min\": %.0f, \"avg\": %.0f, "
+               "\"max\": %.0f}", i ? "," : "", t8_bench_counter_names[i],
+               counters[i].min / n, counters[i].avg / n,
+               counters[i].max / n);
+    }
+    fprintf (file, "\n  }");
+  }
+  fprintf (file, "\n}\n");
+  T8_FREE (sorted);
+}
+
+/* Run a benchmark and write its results on rank 0.
+ * Return 0 on success and nonzero if the output file cannot be written. */
+static int
+t8_bench_run (const t8_bench_options_t * opts, const char *json_file,
+              sc_MPI_Comm comm)
+{
+  t8_bench_result_t   result;
+  t8_profile_value_t  profile[T8_FOREST_PROFILE_COUNT];
+  t8_profile_value_t  counters[T8_COUNTER_COUNT];
+  t8_scheme_cxx_t    *scheme;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         input;
+  double             *times;
+  int                 irep, mpirank, mpisize, mpiret, retval = 0;
+  int                 have_counters;
+  FILE               *file;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  cmesh = t8_bench_cmesh (opts, comm);
+  scheme = t8_scheme_new_default_cxx ();
+  input = t8_bench_input (opts, cmesh, scheme, comm);
+
+  result.times = T8_ALLOC (double, opts->repetitions);
+  times = T8_ALLOC (double, opts->repetitions);
+  t8_forest_profile_accum_init (&result.profile);
+  memset (result.counters, 0, sizeof (result.counters));
+  for (irep = 0; irep < opts->repetitions; irep++) {
+    result.times[irep] =
+      t8_bench_run_once (opts, cmesh, scheme, input, &result, comm);
+  }
+
+  /* A repetition takes as long as its slowest process */
+  mpiret = sc_MPI_Allreduce (result.times, times, opts->repetitions,
+                             sc_MPI_DOUBLE, sc_MPI_MAX, comm);
+  SC_CHECK_MPI (mpiret);
+  t8_forest_profile_accum_reduce (&result.profile, comm, profile);
+  have_counters = t8_counters_available ();
+  if (have_counters) {
+    t8_profile_reduce (T8_COUNTER_COUNT, result.counters, comm, counters);
+  }
+
+  if (mpirank == 0) {
+    file = json_file != NULL ? fopen (json_file, "w") : stdout;
+    if (file != NULL) {
+      t8_bench_write_json (file, opts, times, profile,
+                           have_counters ? counters : NULL,
+                           result.profile.num_commits, mpisize);
+      if (file != stdout) {
+        retval = fclose (file);
+      }
+    }
+    else {
+      t8_errorf ("Could not open %s for writing.\n", json_file);
+      retval = 1;
+    }
+  }
+
+  T8_FREE (times);
+  T8_FREE (result.times);
+  if (input != NULL) {
+    t8_forest_unref (&input);
+  }
+  t8_cmesh_unref (&cmesh);
+  t8_scheme_cxx_unref (&scheme);
+  return retval;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, first_argc, help = 0, ibench, eclass_int;
+  int                 retval = 0;
+  const char         *json_file;
+  t8_bench_options_t  opts;
+  sc_options_t       *opt;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_ESSENTIAL);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &help,
+                         "Display a short help message.");
+  sc_options_add_int (opt, 'e', "elements", &eclass_int, T8_ECLASS_QUAD,
+                      "The tree class of the built-in cmeshes.\n"
+                      "\t\t1 - line\n\t\t2 - quad\n"
+                      "\t\t3 - triangle\n\t\t4 - hexahedron\n"
+                      "\t\t5 - tetrahedron\n\t\t6 - prism\n\t\t7 - pyramid");
+  sc_options_add_string (opt, 'c', "cmesh", &opts.cmesh, "hypercube",
+                         "The built-in cmesh: hypercube, periodic, hybrid, "
+                         "or bigmesh.");
+  sc_options_add_int (opt, 't', "trees", &opts.num_trees, 16,
+                      "The number of trees of the bigmesh cmesh.");
+  sc_options_add_string (opt, 'f', "mshfile", &opts.mshfile, NULL,
+                         "If specified, the cmesh is read from a .msh file "
+                         "with this prefix instead.");
+  sc_options_add_int (opt, 'd', "dim", &opts.dim, 2,
+                      "Together with -f: The dimension of the mesh.");
+  sc_options_add_int (opt, 'l', "level", &opts.level, 3,
+                      "The uniform refinement level of the input forest.");
+  sc_options_add_int (opt, 'r', "rlevel", &opts.rlevel, 2,
+                      "The number of levels that adapt refines.");
+  sc_options_add_int (opt, 'n', "repetitions", &opts.repetitions, 5,
+                      "The number of timed repetitions.");
+  sc_options_add_string (opt, 'j', "json", &json_file, NULL,
+                         "Write the results to this file instead of stdout.");
+  sc_options_add_string (opt, 'o', "vtk-prefix", &opts.vtk_prefix,
+                         "t8_bench", "The prefix of the vtk benchmark.");
+
+  first_argc = sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt,
+                                 argc, argv);
+  opts.bench = T8_BENCH_COUNT;
+  if (first_argc >= 0 && first_argc == argc - 1) {
+    for (ibench = 0; ibench < T8_BENCH_COUNT; ibench++) {
+      if (!strcmp (argv[first_argc], t8_bench_names[ibench])) {
+        opts.bench = (t8_bench_t) ibench;
+      }
+    }
+  }
+  if (help) {
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt,
+                            "<benchmark>");
+  }
+  else if (opts.bench == T8_BENCH_COUNT || eclass_int <= T8_ECLASS_VERTEX
+           || eclass_int >= T8_ECLASS_COUNT || opts.level < 0
+           || opts.rlevel < 0 || opts.repetitions <= 0
+           || opts.num_trees <= 0) {
+    t8_global_productionf ("\n\t ERROR: Wrong usage.\n\n"
+                           "\t The benchmark is one of uniform, adapt, "
+                           "partition, balance, ghost, ghost_exchange, "
+                           "ghost_plan, ghost_rma, search, or vtk.\n\n");
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt,
+                            "<benchmark>");
+    retval = 1;
+  }
+  else {
+    opts.eclass = (t8_eclass_t) eclass_int;
+    retval = t8_bench_run (&opts, json_file, sc_MPI_COMM_WORLD);
+  }
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return retval;
+}
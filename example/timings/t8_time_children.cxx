@@ -0,0 +1,144 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* This program measures the time to construct all children of the
+ * elements of a uniform refinement, once by computing all children at once
+ * with t8_element_children and once by computing each child separately
+ * with t8_element_child. */
+
+#include <sc_flops.h>
+#include <sc_statistics.h>
+#include <sc_options.h>
+#include <t8_eclass.h>
+#include <t8_default_cxx.hxx>
+#include <t8_element_cxx.hxx>
+#include <t8_data/t8_containers.h>
+
+static void
+t8_time_children (t8_eclass_t eclass, int level, int repetitions)
+{
+  t8_scheme_cxx_t    *scheme;
+  t8_eclass_scheme_c *ts;
+  t8_element_array_t  elements;
+  t8_element_t      **children;
+  t8_locidx_t         ielem, num_elements;
+  int                 num_children, ichild, irep;
+  sc_flopinfo_t       fi, snapshot;
+  sc_statinfo_t       stats[2];
+
+  scheme = t8_scheme_new_default_cxx ();
+  ts = scheme->eclass_schemes[eclass];
+
+  /* Build all elements of the uniform refinement */
+  num_elements = t8_eclass_count_leaf (eclass, level);
+  t8_element_array_init_size (&elements, ts, num_elements);
+  ts->t8_element_set_linear_id_range (t8_element_array_get_data (&elements),
+                                      num_elements, level, 0);
+  num_children =
+    ts->t8_element_num_children (t8_element_array_index_locidx
+                                 (&elements, 0));
+  children = T8_ALLOC (t8_element_t *, num_children);
+  ts->t8_element_new (num_children, children);
+
+  sc_flops_start (&fi);
+  sc_flops_snap (&fi, &snapshot);
+  for (irep = 0; irep < repetitions; irep++) {
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      ts->t8_element_children (t8_element_array_index_locidx
+                               (&elements, ielem), num_children, children);
+    }
+  }
+  sc_flops_shot (&fi, &snapshot);
+  sc_stats_set1 (&stats[0], snapshot.iwtime, "All children");
+
+  sc_flops_snap (&fi, &snapshot);
+  for (irep = 0; irep < repetitions; irep++) {
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      for (ichild = 0; ichild < num_children; ichild++) {
+        ts->t8_element_child (t8_element_array_index_locidx
+                              (&elements, ielem), ichild, children[ichild]);
+      }
+    }
+  }
+  sc_flops_shot (&fi, &snapshot);
+  sc_stats_set1 (&stats[1], snapshot.iwtime, "Single children");
+
+  t8_global_productionf ("Computed the children of %li %s elements "
+                         "%i times.\n", (long) num_elements,
+                         t8_eclass_to_string[eclass], repetitions);
+  sc_stats_compute (sc_MPI_COMM_WORLD, 2, stats);
+  sc_stats_print (t8_get_package_id (), SC_LP_ESSENTIAL, 2, stats, 1, 1);
+
+  ts->t8_element_destroy (num_children, children);
+  T8_FREE (children);
+  t8_element_array_reset (&elements);
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_options_t       *opt;
+  int                 level, repetitions, eclass_int;
+  int                 parsed, helpme;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &helpme,
+                         "Display a short help message.");
+  sc_options_add_int (opt, 'l', "level", &level, 6,
+                      "The level of the uniform refinement.");
+  sc_options_add_int (opt, 'r', "repetitions", &repetitions, 10,
+                      "The number of repetitions.");
+  sc_options_add_int (opt, 'e', "elements", &eclass_int, 5,
+                      "The element class. 3 for triangles, 5 for tetrahedra,"
+                      " 6 for prisms.");
+
+  parsed =
+    sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
+  if (helpme) {
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  else if (parsed >= 0 && 0 <= level && repetitions > 0
+           && T8_ECLASS_ZERO <= eclass_int && eclass_int < T8_ECLASS_COUNT
+           && eclass_int != T8_ECLASS_VERTEX
+           && eclass_int != T8_ECLASS_PYRAMID) {
+    t8_time_children ((t8_eclass_t) eclass_int, level, repetitions);
+  }
+  else {
+    /* wrong usage */
+    t8_global_productionf ("\n\tERROR: Wrong usage.\n\n");
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+  return 0;
+}
@@ -0,0 +1,354 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* This program measures the cost of single operations of the default
+ * element schemes in nanoseconds per call.
+ * For each element class and level we create random elements with
+ * t8_element_set_linear_id and call each operation in a tight loop over
+ * these elements. The loops are run a few times without timing to warm up
+ * the caches and then timed for a given number of repetitions.
+ * Operations that a scheme does not implement are skipped.
+ * The results are printed as a table and optionally written as JSON. */
+
+#include <sc_options.h>
+#include <t8_eclass.h>
+#include <t8_default_cxx.hxx>
+#include <t8_element_cxx.hxx>
+
+/* The timed operations */
+typedef enum t8_time_op
+{
+  T8_TIME_OP_PARENT = 0,
+  T8_TIME_OP_CHILD,
+  T8_TIME_OP_CHILDREN,
+  T8_TIME_OP_SUCCESSOR,
+  T8_TIME_OP_LINEAR_ID,
+  T8_TIME_OP_FACE_NEIGHBOR,
+  T8_TIME_OP_TRANSFORM_FACE,
+  T8_TIME_OP_VERTEX_COORDS,
+  T8_TIME_OP_NCA,
+  T8_TIME_OP_COUNT
+} t8_time_op_t;
+
+static const char  *t8_time_op_names[T8_TIME_OP_COUNT] = {
+  "parent", "child", "children", "successor", "linear_id", "face_neighbor",
+  "transform_face", "vertex_coords", "nca"
+};
+
+/* The elements of one measurement */
+typedef struct
+{
+  t8_eclass_scheme_c *ts;       /* The scheme of the elements */
+  int                 level;    /* The level of the elements */
+  size_t              num_elements;     /* The number of elements */
+  t8_element_t      **elements;         /* Random elements of level */
+  t8_element_t      **out;      /* Storage for the maximum number of
+                                   children of an element */
+  int                 num_out;  /* The number of elements in out */
+} t8_time_ops_t;
+
+/* Return true if the scheme implements an operation at a level */
+static int
+t8_time_op_supported (const t8_time_ops_t * ops, t8_time_op_t op)
+{
+  t8_eclass_t         eclass = ops->ts->eclass;
+
+  switch (op) {
+  case T8_TIME_OP_PARENT:
+    return ops->level > 0;
+  case T8_TIME_OP_CHILD:
+  case T8_TIME_OP_CHILDREN:
+    return ops->level < ops->ts->t8_element_maxlevel ();
+  case T8_TIME_OP_SUCCESSOR:
+    /* The elements are not the last element of the level */
+    return t8_eclass_count_leaf (eclass, ops->level) > 1;
+  case T8_TIME_OP_FACE_NEIGHBOR:
+    return t8_eclass_num_faces[eclass] > 0;
+  case T8_TIME_OP_TRANSFORM_FACE:
+    /* Only the schemes of the face classes transform faces */
+    return t8_eclass_to_dimension[eclass] <= 2;
+  default:
+    return 1;
+  }
+}
+
+/* Call an operation once for each element */
+static void
+t8_time_op_loop (const t8_time_ops_t * ops, t8_time_op_t op)
+{
+  t8_eclass_scheme_c *ts = ops->ts;
+  t8_element_t      **elements = ops->elements;
+  t8_element_t       *out = ops->out[0];
+  const size_t        n = ops->num_elements;
+  const int           level = ops->level;
+  int                 num_faces, num_corners, num_children;
+  int                 neigh_face, coords[3];
+  t8_linearidx_t      id;
+  size_t              ielem;
+
+  num_faces = ts->t8_element_num_faces (elements[0]);
+  num_corners = ts->t8_element_num_corners (elements[0]);
+  switch (op) {
+  case T8_TIME_OP_PARENT:
+    for (ielem = 0; ielem < n; ielem++) {
+      ts->t8_element_parent (elements[ielem], out);
+    }
+    break;
+  case T8_TIME_OP_CHILD:
+    for (ielem = 0; ielem < n; ielem++) {
+      num_children = ts->t8_element_num_children (elements[ielem]);
+      ts->t8_element_child (elements[ielem], ielem % num_children, out);
+    }
+    break;
+  case T8_TIME_OP_CHILDREN:
+    for (ielem = 0; ielem < n; ielem++) {
+      num_children = ts->t8_element_num_children (elements[ielem]);
+      ts->t8_element_children (elements[ielem], num_children, ops->out);
+    }
+    break;
+  case T8_TIME_OP_SUCCESSOR:
+    for (ielem = 0; ielem < n; ielem++) {
+      ts->t8_element_successor (elements[ielem], out, level);
+    }
+    break;
+  case T8_TIME_OP_LINEAR_ID:
+    for (ielem = 0; ielem < n; ielem++) {
+      id = ts->t8_element_get_linear_id (elements[ielem], level);
+      ts->t8_element_set_linear_id (out, level, id);
+    }
+    break;
+  case T8_TIME_OP_FACE_NEIGHBOR:
+    for (ielem = 0; ielem < n; ielem++) {
+      ts->t8_element_face_neighbor_inside (elements[ielem], out,
+                                           ielem % num_faces, &neigh_face);
+    }
+    break;
+  case T8_TIME_OP_TRANSFORM_FACE:
+    for (ielem = 0; ielem < n; ielem++) {
+      ts->t8_element_transform_face (elements[ielem], out,
+                                     ielem % num_corners, ielem & 1, 1);
+    }
+    break;
+  case T8_TIME_OP_VERTEX_COORDS:
+    for (ielem = 0; ielem < n; ielem++) {
+      ts->t8_element_vertex_coords (elements[ielem], ielem % num_corners,
+                                    coords);
+    }
+    break;
+  case T8_TIME_OP_NCA:
+    for (ielem = 0; ielem + 1 < n; ielem++) {
+      ts->t8_element_nca (elements[ielem], elements[ielem + 1], out);
+    }
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+}
+
+/* Return a random linear id of an element of a level */
+static t8_linearidx_t
+t8_time_random_id (t8_eclass_t eclass, int level, int avoid_last)
+{
+  t8_linearidx_t      count, id;
+
+  count = t8_eclass_count_leaf (eclass, level);
+  if (avoid_last && count > 1) {
+    count--;
+  }
+  id = ((t8_linearidx_t) rand () << 31) ^ (t8_linearidx_t) rand ();
+  return id % count;
+}
+
+/* Time all operations of one scheme at one level and write the results
+ * to ns_per_op. Unsupported operations get a negative entry. */
+static void
+t8_time_scheme_level (t8_eclass_scheme_c * ts, int level,
+                      size_t num_elements, int warmup, int repetitions,
+                      double ns_per_op[T8_TIME_OP_COUNT])
+{
+  t8_time_ops_t       ops;
+  size_t              ielem;
+  int                 iop, irep;
+  double              runtime;
+
+  ops.ts = ts;
+  ops.level = level;
+  ops.num_elements = num_elements;
+  ops.elements = T8_ALLOC (t8_element_t *, num_elements);
+  ts->t8_element_new (num_elements, ops.elements);
+  /* The random elements are never the last element of their level,
+   * such that they have a successor */
+  srand (level);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    ts->t8_element_set_linear_id (ops.elements[ielem], level,
+                                  t8_time_random_id (ts->eclass, level, 1));
+  }
+  ops.num_out = ts->t8_element_num_children (ops.elements[0]);
+  ops.out = T8_ALLOC (t8_element_t *, ops.num_out);
+  ts->t8_element_new (ops.num_out, ops.out);
+  /* Initialize the output element for transform_face */
+  ts->t8_element_copy (ops.elements[0], ops.out[0]);
+
+  for (iop = 0; iop < T8_TIME_OP_COUNT; iop++) {
+    if (!t8_time_op_supported (&ops, (t8_time_op_t) iop)) {
+      ns_per_op[iop] = -1;
+      continue;
+    }
+    for (irep = 0; irep < warmup; irep++) {
+      t8_time_op_loop (&ops, (t8_time_op_t) iop);
+    }
+    runtime = -sc_MPI_Wtime ();
+    for (irep = 0; irep < repetitions; irep++) {
+      t8_time_op_loop (&ops, (t8_time_op_t) iop);
+    }
+    runtime += sc_MPI_Wtime ();
+    ns_per_op[iop] = 1e9 * runtime / ((double) repetitions * num_elements);
+  }
+
+  ts->t8_element_destroy (ops.num_out, ops.out);
+  ts->t8_element_destroy (num_elements, ops.elements);
+  T8_FREE (ops.out);
+  T8_FREE (ops.elements);
+}
+
+/* Time the operations of the given element classes and levels */
+static int
+t8_time_scheme_ops (int eclass_int, int min_level, int max_level,
+                    size_t num_elements, int warmup, int repetitions,
+                    const char *json_file)
+{
+  t8_scheme_cxx_t    *scheme;
+  t8_eclass_scheme_c *ts;
+  double              ns_per_op[T8_TIME_OP_COUNT];
+  int                 eclass, level, iop, first = 1, retval = 0;
+  int                 mpirank, mpiret;
+  FILE               *file = NULL;
+
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  if (json_file != NULL && mpirank == 0) {
+    file = fopen (json_file, "w");
+    if (file == NULL) {
+      t8_errorf ("Could not open %s for writing.\n", json_file);
+      return 1;
+    }
+    fprintf (file, "[");
+  }
+
+  scheme = t8_scheme_new_default_cxx ();
+  t8_global_productionf ("%-16s %5s %-16s %10s\n", "eclass", "level",
+                         "operation", "ns/op");
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    ts = scheme->eclass_schemes[eclass];
+    if ((eclass_int >= 0 && eclass != eclass_int) || ts == NULL) {
+      continue;
+    }
+    for (level = min_level;
+         level <= SC_MIN (max_level, ts->t8_element_maxlevel ()); level++) {
+      t8_time_scheme_level (ts, level, num_elements, warmup, repetitions,
+                            ns_per_op);
+      for (iop = 0; iop < T8_TIME_OP_COUNT; iop++) {
+        if (ns_per_op[iop] < 0) {
+          continue;
+        }
+        t8_global_productionf ("%-16s %5i %-16s %10.2f\n",
+                               t8_eclass_to_string[eclass], level,
+                               t8_time_op_names[iop], ns_per_op[iop]);
+        if (file != NULL) {
+          fprintf (file, "%s\n  {\"eclass\": \"%s\", \"level\": %i, "
+                   "\"operation\": \"%s\", \"ns_per_op\": %.4f}",
+                   first ? "" : ",", t8_eclass_to_string[eclass], level,
+                   t8_time_op_names[iop], ns_per_op[iop]);
+          first = 0;
+        }
+      }
+    }
+  }
+  t8_scheme_cxx_unref (&scheme);
+
+  if (file != NULL) {
+    fprintf (file, "\n]\n");
+    retval = fclose (file);
+  }
+  return retval;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, retval = 0;
+  sc_options_t       *opt;
+  int                 min_level, max_level, repetitions, warmup;
+  int                 num_elements, eclass_int;
+  int                 parsed, helpme;
+  const char         *json_file;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &helpme,
+                         "Display a short help message.");
+  sc_options_add_int (opt, 'e', "elements", &eclass_int, -1,
+                      "The element class. -1 for all classes.");
+  sc_options_add_int (opt, 'l', "level", &min_level, 1,
+                      "The minimum level of the elements.");
+  sc_options_add_int (opt, 'L', "maxlevel", &max_level, 10,
+                      "The maximum level of the elements. It is capped at "
+                      "the maximum level of each scheme.");
+  sc_options_add_int (opt, 'n', "num-elements", &num_elements, 1 << 14,
+                      "The number of random elements per level.");
+  sc_options_add_int (opt, 'w', "warmup", &warmup, 2,
+                      "The number of untimed loops before timing.");
+  sc_options_add_int (opt, 'r', "repetitions", &repetitions, 20,
+                      "The number of timed loops.");
+  sc_options_add_string (opt, 'j', "json", &json_file, NULL,
+                         "Additionally write the results to this JSON file.");
+
+  parsed =
+    sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
+  if (helpme) {
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  else if (parsed >= 0 && 0 <= min_level && min_level <= max_level
+           && num_elements > 1 && warmup >= 0 && repetitions > 0
+           && -1 <= eclass_int && eclass_int < T8_ECLASS_COUNT) {
+    retval = t8_time_scheme_ops (eclass_int, min_level, max_level,
+                                 num_elements, warmup, repetitions,
+                                 json_file);
+  }
+  else {
+    /* wrong usage */
+    t8_global_productionf ("\n\tERROR: Wrong usage.\n\n");
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+    retval = 1;
+  }
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+  return retval;
+}
@@ -21,9 +21,20 @@
 */
 
 #include <t8.h>
+#include <t8_threads.h>
+#if defined (T8_HAVE_MADVISE) && defined (T8_HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#endif
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#include <omp.h>
+#endif
 
 static int          t8_package_id = -1;
 
+/* The allocation policy set by t8_init_ext */
+static int          t8_alloc_policy = T8_ALLOC_DEFAULT;
+static size_t       t8_alloc_large_threshold = T8_ALLOC_LARGE_THRESHOLD;
+
 int
 t8_get_package_id (void)
 {
@@ -132,11 +143,35 @@ t8_errorf (const char *fmt, ...)
 
 void
 t8_init (int log_threshold)
+{
+  t8_init_options_t   options;
+
+  t8_init_options_default (&options);
+  options.log_threshold = log_threshold;
+  t8_init_ext (&options);
+}
+
+void
+t8_init_options_default (t8_init_options_t * options)
+{
+  T8_ASSERT (options != NULL);
+  options->log_threshold = SC_LP_DEFAULT;
+  options->alloc_policy = T8_ALLOC_DEFAULT;
+  options->alloc_large_threshold = T8_ALLOC_LARGE_THRESHOLD;
+  options->num_threads = 0;
+}
+
+void
+t8_init_ext (const t8_init_options_t * options)
 {
   int                 w;
 
-  t8_package_id = sc_package_register (NULL, log_threshold,
+  T8_ASSERT (options != NULL);
+  t8_package_id = sc_package_register (NULL, options->log_threshold,
                                        "t8", "Adaptive discretizations");
+  t8_alloc_policy = options->alloc_policy;
+  t8_alloc_large_threshold = options->alloc_large_threshold;
+  t8_set_num_threads (options->num_threads);
 
   w = 24;
   t8_global_essentialf ("This is %s\n", T8_PACKAGE_STRING);
@@ -146,6 +181,95 @@ t8_init (int log_threshold)
   t8_global_productionf ("%-*s %s\n", w, "CFLAGS", T8_CFLAGS);
   t8_global_productionf ("%-*s %s\n", w, "LDFLAGS", T8_LDFLAGS);
   t8_global_productionf ("%-*s %s\n", w, "LIBS", T8_LIBS);
+  t8_global_productionf ("%-*s %s%s\n", w, "Allocation policy",
+                         t8_alloc_policy & T8_ALLOC_HUGEPAGES ?
+                         "hugepages " : "",
+                         t8_alloc_policy & T8_ALLOC_FIRST_TOUCH ?
+                         "first-touch" : "");
+  t8_global_productionf ("%-*s %d\n", w, "Threads", t8_get_num_threads ());
+}
+
+/* Return true if a block of bytes is allocated with posix_memalign
+ * instead of the libsc allocator. */
+static int
+t8_alloc_is_aligned (size_t bytes)
+{
+#ifdef T8_HAVE_POSIX_MEMALIGN
+  return (t8_alloc_policy & T8_ALLOC_HUGEPAGES)
+    && bytes >= t8_alloc_large_threshold;
+#else
+  return 0;
+#endif
+}
+
+/* Touch the pages of a block, each thread a contiguous part of the
+ * block, such that the pages are placed near the thread that touches
+ * them first. */
+static void
+t8_alloc_first_touch (char *ptr, size_t bytes)
+{
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+  const long          page = 4096;
+  long                num_pages, ipage;
+
+  num_pages = (long) ((bytes + page - 1) / page);
+#pragma omp parallel for schedule(static)
+  for (ipage = 0; ipage < num_pages; ipage++) {
+    size_t              offset = (size_t) ipage * page;
+
+    memset (ptr + offset, 0, SC_MIN ((size_t) page, bytes - offset));
+  }
+#else
+  /* Without threads the pages are placed where we run anyway */
+  (void) ptr;
+  (void) bytes;
+#endif
+}
+
+void               *
+t8_alloc_large (size_t bytes)
+{
+  void               *ptr = NULL;
+
+  if (bytes == 0) {
+    return NULL;
+  }
+  if (t8_alloc_is_aligned (bytes)) {
+#ifdef T8_HAVE_POSIX_MEMALIGN
+    int                 retval;
+
+    retval = posix_memalign (&ptr, T8_HUGEPAGE_SIZE, bytes);
+    SC_CHECK_ABORT (retval == 0 && ptr != NULL,
+                    "Could not allocate aligned memory");
+#if defined (T8_HAVE_MADVISE) && defined (T8_HAVE_SYS_MMAN_H) \
+  && defined (MADV_HUGEPAGE)
+    /* This is only advice, it does not matter if the kernel refuses */
+    (void) madvise (ptr, bytes, MADV_HUGEPAGE);
+#endif
+#endif
+  }
+  else {
+    ptr = T8_ALLOC (char, bytes);
+  }
+  if ((t8_alloc_policy & T8_ALLOC_FIRST_TOUCH)
+      && bytes >= t8_alloc_large_threshold) {
+    t8_alloc_first_touch ((char *) ptr, bytes);
+  }
+  return ptr;
+}
+
+void
+t8_free_large (void *ptr, size_t bytes)
+{
+  if (ptr == NULL) {
+    return;
+  }
+  if (t8_alloc_is_aligned (bytes)) {
+    free (ptr);
+  }
+  else {
+    T8_FREE (ptr);
+  }
 }
 
 void               *
@@ -163,3 +287,46 @@ t8_sc_array_index_locidx (sc_array_t * array, t8_locidx_t it)
 
   return array->array + array->elem_size * (size_t) it;
 }
+
+void
+t8_mpi_bcast_bytes (void *buffer, size_t num_bytes, int root,
+                    sc_MPI_Comm comm)
+{
+#ifdef SC_ENABLE_MPI
+  MPI_Request         requests[T8_MPI_BCAST_WINDOW];
+  int                 mpiret;
+  size_t              offset, chunk_bytes;
+  int                 ichunk, num_chunks, islot;
+
+  T8_ASSERT (buffer != NULL || num_bytes == 0);
+  if (num_bytes <= T8_MPI_BCAST_CHUNK) {
+    /* A single broadcast is sufficient */
+    mpiret = sc_MPI_Bcast (buffer, (int) num_bytes, sc_MPI_BYTE, root, comm);
+    SC_CHECK_MPI (mpiret);
+    return;
+  }
+  num_chunks = (int) ((num_bytes + T8_MPI_BCAST_CHUNK - 1)
+                      / T8_MPI_BCAST_CHUNK);
+  for (islot = 0; islot < T8_MPI_BCAST_WINDOW; islot++) {
+    requests[islot] = MPI_REQUEST_NULL;
+  }
+  for (ichunk = 0; ichunk < num_chunks; ichunk++) {
+    /* Reuse the slot of the chunk that was started a window ago.
+     * We wait for it first, such that at most T8_MPI_BCAST_WINDOW
+     * broadcasts are active. */
+    islot = ichunk % T8_MPI_BCAST_WINDOW;
+    mpiret = MPI_Wait (requests + islot, MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    offset = ichunk * T8_MPI_BCAST_CHUNK;
+    chunk_bytes = SC_MIN (T8_MPI_BCAST_CHUNK, num_bytes - offset);
+    mpiret = MPI_Ibcast ((char *) buffer + offset, (int) chunk_bytes,
+                         MPI_BYTE, root, comm, requests + islot);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_Waitall (T8_MPI_BCAST_WINDOW, requests, MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+#else
+  /* Without MPI there is only one process, which already has the data */
+  T8_ASSERT (root == 0);
+#endif
+}
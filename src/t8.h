@@ -104,6 +104,49 @@ typedef uint64_t    t8_linearidx_t;
 #define T8_ADD_PADDING(_x) \
   ((T8_PADDING_SIZE - ((_x) %  T8_PADDING_SIZE)) %  T8_PADDING_SIZE)
 
+/** The size in bytes of the chunks of \ref t8_mpi_bcast_bytes. */
+#define T8_MPI_BCAST_CHUNK ((size_t) 1 << 22)
+
+/** The maximum number of chunks that \ref t8_mpi_bcast_bytes
+ * broadcasts at the same time. */
+#define T8_MPI_BCAST_WINDOW 4
+
+/** Flags for the allocation of large, long-lived memory blocks such as
+ * the element storage of forests and the buffers of ghost exchange plans.
+ * \see t8_init_ext */
+typedef enum
+{
+  T8_ALLOC_DEFAULT = 0,         /**< Allocate with the libsc allocator. */
+  T8_ALLOC_HUGEPAGES = 1,       /**< Align large blocks to huge pages and
+                                     advise the kernel to back them by
+                                     transparent huge pages where available. */
+  T8_ALLOC_FIRST_TOUCH = 2      /**< Touch large blocks with all OpenMP
+                                     threads, each a contiguous part, such that
+                                     their pages are placed by first touch in
+                                     the NUMA domain of the thread. */
+}
+t8_alloc_policy_t;
+
+/** The size of a huge page that large blocks are aligned to. */
+#define T8_HUGEPAGE_SIZE ((size_t) 1 << 21)
+
+/** The default minimum number of bytes of a block to which the
+ * allocation policy is applied. */
+#define T8_ALLOC_LARGE_THRESHOLD T8_HUGEPAGE_SIZE
+
+/** Options of \ref t8_init_ext. */
+typedef struct t8_init_options
+{
+  int                 log_threshold; /**< Declared in sc.h. */
+  int                 alloc_policy;  /**< A bitwise or of \ref t8_alloc_policy_t flags. */
+  size_t              alloc_large_threshold; /**< The policy is applied to blocks of
+                                                  at least this many bytes. */
+  int                 num_threads;   /**< The number of threads, see \ref t8_set_num_threads.
+                                          If smaller than 1, the environment variable
+                                          T8_NUM_THREADS is used. */
+}
+t8_init_options_t;
+
 /** Communication tags used internal to t8code. */
 typedef enum
 {
@@ -112,6 +155,12 @@ typedef enum
   T8_MPI_PARTITION_FOREST,  /**< Used for forest partitioning */
   T8_MPI_GHOST_FOREST,  /**< Used for for ghost layer creation */
   T8_MPI_GHOST_EXC_FOREST,  /**< Used for ghost data exchange */
+  T8_MPI_PARTITION_FAMILY_FOREST, /**< Used for the family keys in a forest partition for coarsening */
+  T8_MPI_PARTITION_DATA_FOREST, /**< Used for element data in forest partition */
+  T8_MPI_PARTICLES_FOREST,      /**< Used for particle migration */
+  T8_MPI_TRANSFER_FOREST,       /**< Used for data transfer between forests */
+  T8_MPI_LOCATE_FOREST,         /**< Used for distributed point location queries */
+  T8_MPI_LOCATE_REPLY_FOREST,   /**< Used for the replies to point location queries */
   T8_MPI_TAG_LAST
 }
 t8_MPI_tag_t;
@@ -218,12 +267,76 @@ void                t8_errorf (const char *fmt, ...)
 
 /* *INDENT-ON* */
 
+/** The lowest log priority that the T8_*F logging macros compile in.
+ * Calls of these macros with a lower priority are removed by the compiler,
+ * including the evaluation of their arguments, such that they may be used
+ * in loops and other hot paths. The default keeps all priorities in debug
+ * builds and removes SC_LP_INFO and below otherwise. Define it, for example
+ * with CPPFLAGS=-DT8_LP_THRESHOLD=SC_LP_ESSENTIAL, to remove more.
+ * The logging functions like \ref t8_global_productionf are not affected.
+ */
+#ifndef T8_LP_THRESHOLD
+#ifdef T8_ENABLE_DEBUG
+#define T8_LP_THRESHOLD SC_LP_ALWAYS
+#else
+#define T8_LP_THRESHOLD SC_LP_STATISTICS
+#endif
+#endif
+
+/** Log a message with \ref t8_logf if \a priority is at least
+ * \ref T8_LP_THRESHOLD, and compile to nothing otherwise.
+ * The format string and its arguments follow \a priority. */
+#define T8_LOGF(category,priority,...) \
+  do {                                                                  \
+    if ((priority) >= T8_LP_THRESHOLD) {                                \
+      t8_logf ((category), (priority), __VA_ARGS__);                    \
+    }                                                                   \
+  } while (0)
+
+/** Log a message, no matter what rank, with priority SC_LP_DEBUG.
+ * Unlike \ref t8_debugf it is removed in builds without debug mode. */
+#define T8_DEBUGF(...) T8_LOGF (SC_LC_NORMAL, SC_LP_DEBUG, __VA_ARGS__)
+/** Log a message, no matter what rank, with priority SC_LP_INFO. */
+#define T8_INFOF(...) T8_LOGF (SC_LC_NORMAL, SC_LP_INFO, __VA_ARGS__)
+/** Log a message on the root rank with priority SC_LP_INFO. */
+#define T8_GLOBAL_INFOF(...) T8_LOGF (SC_LC_GLOBAL, SC_LP_INFO, __VA_ARGS__)
+/** Log a message on the root rank with priority SC_LP_PRODUCTION. */
+#define T8_GLOBAL_PRODUCTIONF(...) \
+  T8_LOGF (SC_LC_GLOBAL, SC_LP_PRODUCTION, __VA_ARGS__)
+
 /** Register t8code with libsc and print version and variable information.
  * \param [in] log_threshold Declared in sc.h.  SC_LP_DEFAULT is fine.
  *                           You can also choose from log levels SC_LP_*.
  */
 void                t8_init (int log_threshold);
 
+/** Set the options of \ref t8_init_ext to their defaults, which are those
+ * used by \ref t8_init with log level SC_LP_DEFAULT.
+ * \param [out] options     The options.
+ */
+void                t8_init_options_default (t8_init_options_t * options);
+
+/** Register t8code with libsc like \ref t8_init with further options.
+ * \param [in] options      The options. The allocation policy must not
+ *                          be changed while memory allocated by a forest
+ *                          or a ghost plan exists.
+ */
+void                t8_init_ext (const t8_init_options_t * options);
+
+/** Allocate a large, long-lived block of memory according to the
+ * allocation policy of \ref t8_init_ext.
+ * \param [in] bytes        The number of bytes.
+ * \return                  The block, which must be freed with
+ *                          \ref t8_free_large. NULL if \a bytes is 0.
+ */
+void               *t8_alloc_large (size_t bytes);
+
+/** Free a block allocated with \ref t8_alloc_large.
+ * \param [in] ptr          The block, may be NULL.
+ * \param [in] bytes        The number of bytes that were allocated.
+ */
+void                t8_free_large (void *ptr, size_t bytes);
+
 /** Return a pointer to an array element indexed by a t8_topidx_t.
  * \param [in] index needs to be in [0]..[elem_count-1].
  * \return           A void * pointing to entry \a it in \a array.
@@ -238,6 +351,24 @@ void               *t8_sc_array_index_topidx (sc_array_t * array,
 void               *t8_sc_array_index_locidx (sc_array_t * array,
                                               t8_locidx_t it);
 
+/** Broadcast a memory buffer of arbitrary size from a root process.
+ * Large buffers are split into chunks of \ref T8_MPI_BCAST_CHUNK bytes
+ * and several chunks are broadcast at the same time with nonblocking
+ * broadcasts. Thus, the transfer of one chunk overlaps with the
+ * forwarding of the previous ones and the size is not limited by the
+ * int count of MPI.
+ * \param [in,out] buffer    On root the data to send, on the other
+ *                           processes allocated memory of \a num_bytes
+ *                           bytes that is filled on output.
+ * \param [in]     num_bytes The number of bytes. Must be the same on all
+ *                           processes.
+ * \param [in]     root      The rank of the sending process.
+ * \param [in]     comm      The MPI communicator.
+ * \note This function is collective on \a comm.
+ */
+void                t8_mpi_bcast_bytes (void *buffer, size_t num_bytes,
+                                        int root, sc_MPI_Comm comm);
+
 /* call this at the end of a header file to match T8_EXTERN_C_BEGIN (). */
 T8_EXTERN_C_END ();
 
@@ -29,6 +29,7 @@
 
 #include <t8.h>
 #include <t8_data/t8_shmem.h>
+#include <t8_profile.h>
 #include <t8_cmesh/t8_cmesh_save.h>
 #include <t8_element.h>
 
@@ -54,6 +55,40 @@ typedef struct t8_cmesh *t8_cmesh_t;
 typedef struct t8_ctree *t8_ctree_t;
 typedef struct t8_cghost *t8_cghost_t;
 
+/** The components of the memory used by a cmesh.
+ * \see t8_cmesh_memory_usage */
+typedef enum
+{
+  T8_CMESH_MEMORY_STRUCT = 0, /**< The cmesh struct and its profile. */
+  T8_CMESH_MEMORY_TREES,      /**< The trees and ghosts with their face
+                                   neighbors and attributes. */
+  T8_CMESH_MEMORY_TREE_TO_PROC, /**< The part and tree to process tables. */
+  T8_CMESH_MEMORY_GHOST_HASH, /**< The global to local ghost id hash table. */
+  T8_CMESH_MEMORY_OFFSETS,    /**< The partition table and the eclass
+                                   prefix counts of the trees. */
+  T8_CMESH_MEMORY_COUNT       /**< The number of components. */
+} t8_cmesh_memory_t;
+
+/** The values of an accumulated cmesh profile */
+typedef enum t8_cmesh_profile_value
+{
+  T8_CMESH_PROFILE_TREES = 0,   /**< The number of local trees. */
+  T8_CMESH_PROFILE_GHOSTS,      /**< The number of ghost trees. */
+  T8_CMESH_PROFILE_BYTES_SENT,  /**< The bytes sent by partition. */
+  T8_CMESH_PROFILE_PARTITION_RUNTIME,   /**< The runtime of partition. */
+  T8_CMESH_PROFILE_COMMIT_RUNTIME,      /**< The runtime of commit. */
+  T8_CMESH_PROFILE_COUNT        /**< The number of values. */
+} t8_cmesh_profile_value_t;
+
+/** The sums of the profiled values of many commits on one process,
+ * \see t8_cmesh_profile_accumulate. */
+typedef struct t8_cmesh_profile_accum
+{
+  int                 num_commits;      /**< The number of accumulated commits. */
+  double              sums[T8_CMESH_PROFILE_COUNT];     /**< The sum of each value
+                                                             over the commits. */
+} t8_cmesh_profile_accum_t;
+
 T8_EXTERN_C_BEGIN ();
 
 /** Create a new cmesh with reference count one.
@@ -114,6 +149,52 @@ int                 t8_cmesh_tree_vertices_negative_volume (t8_eclass_t
                                                             double *vertices,
                                                             int num_vertices);
 
+/** The relative tolerance below which \ref t8_cmesh_set_validate_geometry
+ * reports a tree as degenerate. */
+#define T8_CMESH_VALIDATE_TOLERANCE 1e-12
+
+/** The result of \ref t8_cmesh_validate_geometry over all processes. */
+typedef struct t8_cmesh_geometry_report
+{
+  t8_gloidx_t         num_checked;      /**< The number of trees with vertices that were checked. */
+  t8_gloidx_t         num_inverted;     /**< The number of inverted trees. */
+  t8_gloidx_t         num_degenerate;   /**< The number of degenerate trees that are not inverted. */
+  t8_gloidx_t         first_inverted;   /**< The smallest global id of an inverted tree, -1 if none. */
+  t8_gloidx_t         first_degenerate; /**< The smallest global id of a degenerate tree, -1 if none. */
+  double              min_quality;      /**< The minimal scaled Jacobian of all checked corners,
+                                             1 if no tree was checked. */
+} t8_cmesh_geometry_report_t;
+
+/** Check the geometry of all trees of a committed cmesh.
+ * At each corner of a tree we compute the scaled Jacobian of the map
+ * that interpolates its vertices: the determinant of the edge vectors along
+ * the reference directions divided by the product of their lengths. It is
+ * 1 for a right angled corner. For two dimensional trees it is the norm of
+ * the cross product of the edge vectors divided by their lengths, with
+ * negative sign if the normal at the corner points away from the normal at
+ * the first corner. Lines have
+ * quality 1 if their length is positive and 0 otherwise. Simplices are
+ * checked once, since their map is affine.
+ * A tree is inverted if its minimal quality is smaller than -\a tolerance
+ * and degenerate if it lies in [-\a tolerance, \a tolerance]. Unlike
+ * \ref t8_cmesh_tree_vertices_negative_volume, which only checks one corner,
+ * this finds tangled hexahedra, prisms and pyramids and folded quadrilaterals.
+ * The corners are processed in batches with the vectorized functions of
+ * \ref t8_vec.h, the batches are distributed over the OpenMP threads, and
+ * a replicated cmesh is split between the processes.
+ * This function does not abort on invalid trees.
+ * \param [in]  cmesh      A committed cmesh. Trees without vertices are skipped.
+ * \param [in]  tolerance  A nonnegative relative tolerance.
+ * \param [in]  comm       The communicator of \a cmesh.
+ * \param [out] report     The summary over all processes.
+ * This function is collective.
+ */
+void                t8_cmesh_validate_geometry (t8_cmesh_t cmesh,
+                                                double tolerance,
+                                                sc_MPI_Comm comm,
+                                                t8_cmesh_geometry_report_t *
+                                                report);
+
 /* TODO: Currently it is not possible to destroy set_from before
  *       cmesh is destroyed. */
 /** This function sets a cmesh to be derived from.
@@ -205,6 +286,53 @@ void                t8_cmesh_set_partition_offsets (t8_cmesh_t cmesh,
 void                t8_cmesh_set_partition_uniform (t8_cmesh_t cmesh,
                                                     int element_level);
 
+/** Set the cost of an element of each element class for partitions that
+ * are derived from an assumed uniform refinement.
+ * With these costs, \ref t8_cmesh_set_partition_uniform balances the sum
+ * of the element costs instead of the number of elements. Uniform forests
+ * on the committed cmesh are partitioned in the same way, and so are
+ * partitioned forests on it that do not set their own costs,
+ * see \ref t8_forest_set_partition_eclass_costs.
+ * A derived cmesh keeps the costs of the cmesh it is derived from,
+ * unless it sets its own.
+ * This call is only valid when the cmesh is not yet committed via a call
+ * to \ref t8_cmesh_commit.
+ * \param [in,out] cmesh        The cmesh to be updated.
+ * \param [in]     costs        An array of \ref T8_ECLASS_COUNT positive costs,
+ *                              for example 1 for hexahedra and 0.6 for tetrahedra.
+ *                              The values are copied. If NULL, the costs are unset
+ *                              and the number of elements is balanced.
+ */
+void                t8_cmesh_set_partition_eclass_costs (t8_cmesh_t cmesh,
+                                                         const double *costs);
+
+/** Select whether the ghost trees that a partition sends carry copies of
+ * the attributes of their trees, such as the vertices.
+ * Without them the ghosts only store their connectivity, which keeps the
+ * partition messages and the ghost memory small if the trees have large
+ * attributes. Attributes of ghosts can be fetched later on demand with
+ * \ref t8_cmesh_fetch_ghost_attribute.
+ * A derived cmesh keeps the setting of the cmesh it is derived from,
+ * unless it sets its own. By default the attributes are sent.
+ * This call is only valid when the cmesh is not yet committed via a call
+ * to \ref t8_cmesh_commit.
+ * \param [in,out] cmesh        The cmesh to be updated.
+ * \param [in]     ghost_attributes If false, the ghosts are sent with their
+ *                              connectivity only.
+ */
+void                t8_cmesh_set_partition_ghost_attributes (t8_cmesh_t
+                                                             cmesh,
+                                                             int
+                                                             ghost_attributes);
+
+/** Query whether the ghosts that a partition sends carry attributes.
+ * \param [in]     cmesh        The cmesh.
+ * \return                      True if the ghosts carry their attributes.
+ * \see t8_cmesh_set_partition_ghost_attributes
+ */
+int                 t8_cmesh_get_partition_ghost_attributes (t8_cmesh_t
+                                                             cmesh);
+
 /* TODO: This function is no longer needed.  Scavenge documentation if helpful. */
 #if 0
 /* TODO: Currently cmesh_from needs to be partitioned as well.
@@ -303,6 +431,35 @@ void                t8_cmesh_set_join (t8_cmesh_t cmesh, t8_gloidx_t gtree1,
                                        t8_gloidx_t gtree2, int face1,
                                        int face2, int orientation);
 
+/** Store the trees of a replicated cmesh only once per node.
+ * After commit the trees, their face neighbors and their attributes are
+ * stored in shared memory that is written by one process of each node and
+ * read by the others. This needs MPI-3 shared memory windows, otherwise
+ * each process stores its own copy.
+ * Each process still builds its own copy of the trees during commit and
+ * frees it afterwards, so this reduces the memory after commit but not
+ * its peak during commit.
+ * The trees of such a cmesh must not be modified after commit and
+ * destroying the cmesh is collective.
+ * This setting has no effect for partitioned cmeshes.
+ * \param [in,out] cmesh        The cmesh to be updated.
+ * \param [in]     set_shared   If true, the trees are shared.
+ * The cmesh must not be committed before calling this function.
+ */
+void                t8_cmesh_set_shared_trees (t8_cmesh_t cmesh,
+                                               int set_shared);
+
+/** Check the geometry of the trees when a cmesh is committed.
+ * Commit calls \ref t8_cmesh_validate_geometry with the tolerance
+ * \ref T8_CMESH_VALIDATE_TOLERANCE and prints the summary. An error is
+ * printed if any tree is inverted or degenerate, but commit does not abort.
+ * \param [in,out] cmesh        The cmesh to be updated.
+ * \param [in]     validate     If true, the geometry is checked.
+ * The cmesh must not be committed before calling this function.
+ */
+void                t8_cmesh_set_validate_geometry (t8_cmesh_t cmesh,
+                                                    int validate);
+
 /** Enable or disable profiling for a cmesh. If profiling is enabled, runtimes
  * and statistics are collected during cmesh_commit.
  * \param [in,out] cmesh        The cmesh to be updated.
@@ -355,7 +512,53 @@ t8_cmesh_t          t8_cmesh_bcast (t8_cmesh_t cmesh_in, int root,
 /* TODO: think about making this a pre-commit set_reorder function. */
 void                t8_cmesh_reorder (t8_cmesh_t cmesh, sc_MPI_Comm comm);
 
-/* TODO: think about a sensible interface for a parmetis reordering. */
+#endif
+
+/** Repartition a partitioned cmesh along a space-filling curve.
+ * The centroids of the trees are sorted along a Morton curve in their
+ * bounding box with a parallel sample sort. The trees get new global
+ * ids in this order and are split evenly among the processes.
+ * Each tree is redistributed with its face connections and attributes.
+ * The ghosts of the new cmesh know all their face connections and carry
+ * their attributes, unless \a cmesh has no ghost attributes, see
+ * \ref t8_cmesh_set_partition_ghost_attributes.
+ * This is much cheaper than \ref t8_cmesh_reorder_partitioned and also
+ * results in compact partitions.
+ * This function is collective on \a comm.
+ * \param [in] cmesh    A committed and partitioned cmesh with vertex
+ *                      coordinates for each tree. The reference to it is
+ *                      taken over by this function.
+ * \param [in] comm     The communicator of \a cmesh.
+ * \return              A committed and partitioned cmesh with the
+ *                      reordered trees. If a tree has no vertices,
+ *                      \a cmesh is returned unchanged.
+ */
+t8_cmesh_t          t8_cmesh_reorder_sfc (t8_cmesh_t cmesh,
+                                          sc_MPI_Comm comm);
+
+#if defined (T8_WITH_PARMETIS) && defined (SC_ENABLE_MPI)
+/** Repartition a partitioned cmesh along the dual graph of its trees.
+ * The face connections of the trees are partitioned with ParMETIS into one
+ * part per process. The trees get new global ids such that the trees of
+ * each part are consecutive and the trees of process p come before those
+ * of process p + 1. The trees are then redistributed, each with its face
+ * connections and attributes, and the ghosts as in
+ * \ref t8_cmesh_reorder_sfc.
+ * The partitioned readers keep the numbering of the file, which usually
+ * results in fragmented partitions. Call this function afterwards to
+ * reorder their cmeshes.
+ * This function is collective on \a comm.
+ * \param [in] cmesh    A committed and partitioned cmesh. The reference
+ *                      to it is taken over by this function.
+ * \param [in] comm     The communicator of \a cmesh.
+ * \return              A committed and partitioned cmesh with the
+ *                      reordered trees. If a process has no tree that it
+ *                      does not share with a smaller process or if the
+ *                      trees do not fit into the index type of ParMETIS,
+ *                      \a cmesh is returned unchanged.
+ */
+t8_cmesh_t          t8_cmesh_reorder_partitioned (t8_cmesh_t cmesh,
+                                                  sc_MPI_Comm comm);
 #endif
 
 /** After allocating and adding properties to a cmesh, finish its construction.
@@ -381,6 +584,106 @@ t8_cmesh_t          t8_cmesh_load_and_distribute (const char *fileprefix,
                                                   t8_load_mode_t mode,
                                                   int procs_per_node);
 
+/** Save a cmesh collectively to a single binary file.
+ * The file stores a header with the partition table of \a cmesh
+ * followed by one fixed-size record per tree, sorted by global id.
+ * Each process writes the trees that it owns, using collective MPI-IO
+ * if t8code is configured with it.
+ * Tree attributes other than the vertex coordinates are not stored.
+ * \param [in] cmesh       A committed cmesh.
+ * \param [in] filename    The name of the file to write.
+ * \param [in] comm        The communicator of \a cmesh.
+ * \return                 True on all processes if the file was written.
+ * \see t8_cmesh_load_parallel
+ */
+int                 t8_cmesh_save_parallel (t8_cmesh_t cmesh,
+                                            const char *filename,
+                                            sc_MPI_Comm comm);
+
+/** Load a cmesh collectively from a file written with
+ * \ref t8_cmesh_save_parallel.
+ * The number of processes can differ from the number of saving processes.
+ * A partitioned cmesh keeps its partition if the numbers agree and is
+ * partitioned uniformly otherwise. Each process only reads the bytes
+ * describing its own trees.
+ * \param [in] filename    The name of the file to read.
+ * \param [in] comm        The communicator of the new cmesh.
+ * \return                 The committed cmesh or NULL on all processes
+ *                         if the file could not be read.
+ */
+t8_cmesh_t          t8_cmesh_load_parallel (const char *filename,
+                                            sc_MPI_Comm comm);
+
+/** Save a replicated cmesh to a file that can be loaded without copying.
+ * The file stores the memory of the trees as it is laid out in memory.
+ * It can only be loaded on machines with the same byte order and type
+ * sizes. Only rank 0 writes the file.
+ * \param [in] cmesh       A committed replicated cmesh.
+ * \param [in] filename    The name of the file to write.
+ * \return                 True if successful.
+ * \see t8_cmesh_load_mapped
+ */
+int                 t8_cmesh_save_mapped (t8_cmesh_t cmesh,
+                                          const char *filename);
+
+/** Load a replicated cmesh from a file written with
+ * \ref t8_cmesh_save_mapped.
+ * If possible, the file is memory-mapped and the trees of the cmesh point
+ * directly into the file contents, such that loading takes constant time
+ * and only the pages that are accessed later are read from disk.
+ * Each process maps the file independently.
+ * The file is mapped read-only, hence the trees and their attributes must
+ * not be modified, for example through the pointer returned by
+ * \ref t8_cmesh_get_attribute. This also holds for cmeshes that are
+ * derived from the loaded one and share its trees.
+ * The trees are checked to lie within the file when loading.
+ * \param [in] filename    The name of the file to read.
+ * \param [in] comm        The communicator of the new cmesh.
+ * \return                 The committed cmesh or NULL if the file could
+ *                         not be read (process local).
+ */
+t8_cmesh_t          t8_cmesh_load_mapped (const char *filename,
+                                          sc_MPI_Comm comm);
+
+/** The environment variable holding the default directory of
+ * \ref t8_cmesh_new_cached. */
+#define T8_CMESH_CACHE_DIR_ENV "T8_CMESH_CACHE_DIR"
+
+/** A function that builds a committed cmesh, for example by reading and
+ * partitioning a mesh file.
+ * \param [in] comm        The communicator passed to \ref t8_cmesh_new_cached.
+ * \param [in] user_data   The user data passed to \ref t8_cmesh_new_cached.
+ * \return                 The committed cmesh.
+ */
+typedef t8_cmesh_t  (*t8_cmesh_build_fn) (sc_MPI_Comm comm, void *user_data);
+
+/** Build a cmesh or load it from an on-disk cache.
+ * The cache key is a hash of the content of \a input_file, the string
+ * \a options and the number of processes. The options should describe
+ * all processing that \a build applies to the file, such as reordering
+ * or partitioning parameters. If a cmesh with this key was stored before,
+ * it is loaded with \ref t8_cmesh_load_parallel and \a build is not
+ * called. Otherwise, the cmesh is built and stored with
+ * \ref t8_cmesh_save_parallel.
+ * As with \ref t8_cmesh_save_parallel, only vertex attributes are cached.
+ * \param [in] input_file  The file from which \a build creates the cmesh.
+ * \param [in] options     A string describing the processing, may be NULL.
+ * \param [in] cache_dir   The directory of the cache. If NULL, the value of
+ *                         the environment variable \ref T8_CMESH_CACHE_DIR_ENV
+ *                         is used. If neither is set, the cmesh is built
+ *                         without caching.
+ * \param [in] comm        The communicator of the new cmesh.
+ * \param [in] build       The function creating the cmesh.
+ * \param [in] user_data   Passed to \a build.
+ * \return                 The committed cmesh.
+ */
+t8_cmesh_t          t8_cmesh_new_cached (const char *input_file,
+                                         const char *options,
+                                         const char *cache_dir,
+                                         sc_MPI_Comm comm,
+                                         t8_cmesh_build_fn build,
+                                         void *user_data);
+
 /** Check whether a given MPI communicator assigns the same rank and mpisize
   * as stored in a cmesh.
   * \param [in] cmesh       The cmesh to be considered.
@@ -534,6 +837,57 @@ t8_locidx_t         t8_cmesh_get_local_id (t8_cmesh_t cmesh,
  */
 void                t8_cmesh_print_profile (t8_cmesh_t cmesh);
 
+/** Initialize an accumulated cmesh profile with zero values.
+ * \param [out] accum   The accumulated profile.
+ */
+void                t8_cmesh_profile_accum_init (t8_cmesh_profile_accum_t *
+                                                 accum);
+
+/** Add the values of the last commit of a cmesh to an accumulated
+ * profile.
+ * \param [in,out] accum   An initialized accumulated profile.
+ * \param [in]     cmesh   A committed cmesh. If profiling is enabled, the
+ *                         runtimes and the bytes sent are added,
+ *                         otherwise only the numbers of trees and ghosts.
+ */
+void                t8_cmesh_profile_accumulate (t8_cmesh_profile_accum_t *
+                                                 accum, t8_cmesh_t cmesh);
+
+/** Reduce an accumulated profile over the processes.
+ * This function is collective.
+ * \param [in]  accum    An accumulated profile.
+ * \param [in]  comm     The communicator of the cmeshes.
+ * \param [out] values   \ref T8_CMESH_PROFILE_COUNT values, indexed by
+ *                       \ref t8_cmesh_profile_value_t.
+ */
+void                t8_cmesh_profile_accum_reduce (const
+                                                   t8_cmesh_profile_accum_t *
+                                                   accum, sc_MPI_Comm comm,
+                                                   t8_profile_value_t *
+                                                   values);
+
+/** Reduce an accumulated profile and print it on rank 0.
+ * This function is collective.
+ * \param [in]  accum    An accumulated profile.
+ * \param [in]  comm     The communicator of the cmeshes.
+ */
+void                t8_cmesh_profile_accum_print (const
+                                                  t8_cmesh_profile_accum_t *
+                                                  accum, sc_MPI_Comm comm);
+
+/** Compute the number of bytes that a cmesh uses on this process.
+ * \param [in]    cmesh         The cmesh.
+ * \param [out]   usage         If not NULL, an array of
+ *                              \ref T8_CMESH_MEMORY_COUNT entries. On output
+ *                              entry i is the number of bytes of the
+ *                              component \ref t8_cmesh_memory_t i.
+ * \return                      The total number of bytes.
+ * \note Trees and partition tables in shared memory or in a mapped file are
+ * counted on each process.
+ * \a cmesh must be committed before calling this function.
+ */
+size_t              t8_cmesh_memory_usage (t8_cmesh_t cmesh, size_t * usage);
+
 /** Return a pointer to the vertex coordinates of a tree.
  * \param [in]    cmesh         The cmesh.
  * \param [in]    ltreeid       The id of a loca tree.
@@ -558,6 +912,23 @@ void               *t8_cmesh_get_attribute (t8_cmesh_t cmesh,
                                             int package_id, int key,
                                             t8_locidx_t ltree_id);
 
+/** Fetch one attribute of all ghosts that do not store it from the owners
+ * of their trees. Afterwards \ref t8_cmesh_get_attribute returns the
+ * fetched values for the ghosts. This is meant for cmeshes that are
+ * partitioned without ghost attributes, see
+ * \ref t8_cmesh_set_partition_ghost_attributes, and fetches for example
+ * only the vertices with package id \ref t8_get_package_id and key 0.
+ * Fetching an attribute again replaces its previous values.
+ * This function is collective over \a comm.
+ * \param [in,out] cmesh        A committed cmesh.
+ * \param [in]     package_id   The package id of the attribute.
+ * \param [in]     key          The key of the attribute.
+ * \param [in]     comm         The communicator of \a cmesh.
+ */
+void                t8_cmesh_fetch_ghost_attribute (t8_cmesh_t cmesh,
+                                                    int package_id, int key,
+                                                    sc_MPI_Comm comm);
+
 /** Return the shared memory array storing the partition table of
  * a partitioned cmesh.
  * \param [in]      cmesh       The cmesh.
@@ -568,6 +939,14 @@ void               *t8_cmesh_get_attribute (t8_cmesh_t cmesh,
  */
 t8_shmem_array_t    t8_cmesh_get_partition_table (t8_cmesh_t cmesh);
 
+/** Return the element class costs of a cmesh for uniform partitions.
+ * \param [in] cmesh       The cmesh.
+ * \return                 An array of \ref T8_ECLASS_COUNT costs, or NULL
+ *                         if no costs are set.
+ * \see t8_cmesh_set_partition_eclass_costs
+ */
+const double       *t8_cmesh_get_partition_eclass_costs (t8_cmesh_t cmesh);
+
 /* TODO: remove get_ when there is no risk of confusion? Convention?
  *       Update: use get throughout for access functions that do not change the object.
  * */
@@ -583,6 +962,8 @@ t8_shmem_array_t    t8_cmesh_get_partition_table (t8_cmesh_t cmesh);
  * \param [out[   first_tree_shared If not NULL, 1 or 0 is stored here depending on whether \a first_local_tree is the
  *                                 same as \a last_local_tree on the next process.
  * \a cmesh must be committed before calling this function. *
+ * This function balances the number of elements and ignores the costs
+ * of \ref t8_cmesh_set_partition_eclass_costs, see \ref t8_cmesh_uniform_bounds_costs.
  */
 void                t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
                                              t8_gloidx_t * first_local_tree,
@@ -592,6 +973,37 @@ void                t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
                                              t8_gloidx_t * child_in_tree_end,
                                              int8_t * first_tree_shared);
 
+/** Calculate the section of a uniform forest for the current rank, such
+ * that each process gets about the same sum of element costs.
+ * The cost of an element is the cost of the element class of its tree.
+ * This is useful for hybrid meshes, where the elements of different
+ * classes need different amounts of work.
+ * \param [in]    cmesh         The cmesh to be considered.
+ * \param [in]    level         The uniform refinement level to be created.
+ * \param [in]    eclass_costs  An array of \ref T8_ECLASS_COUNT positive costs,
+ *                              one for each element class. If NULL, the
+ *                              number of elements is balanced as in
+ *                              \ref t8_cmesh_uniform_bounds.
+ * \param [in]    comm          The communicator of \a cmesh. Only used if
+ *                              \a eclass_costs is not NULL and \a cmesh is
+ *                              partitioned. In this case the call is collective.
+ * \see t8_cmesh_uniform_bounds for the other parameters.
+ */
+void                t8_cmesh_uniform_bounds_costs (t8_cmesh_t cmesh,
+                                                   int level,
+                                                   const double *eclass_costs,
+                                                   sc_MPI_Comm comm,
+                                                   t8_gloidx_t *
+                                                   first_local_tree,
+                                                   t8_gloidx_t *
+                                                   child_in_tree_begin,
+                                                   t8_gloidx_t *
+                                                   last_local_tree,
+                                                   t8_gloidx_t *
+                                                   child_in_tree_end,
+                                                   int8_t *
+                                                   first_tree_shared);
+
 /** Increase the reference counter of a cmesh.
  * \param [in,out] cmesh        On input, this cmesh must exist with positive
  *                              reference count.  It may be in any state.
@@ -732,6 +1144,22 @@ t8_cmesh_t          t8_cmesh_new_periodic_line_more_trees (sc_MPI_Comm comm);
 t8_cmesh_t          t8_cmesh_new_bigmesh (t8_eclass_t eclass, int num_trees,
                                           sc_MPI_Comm comm);
 
+/** Construct a partitioned mesh consisting of a given number of same type
+ * trees that are connected as in \ref t8_cmesh_new_bigmesh.
+ * Each process only creates its own trees and their ghosts and the
+ * uniform partition table is computed without communication. Thus, the
+ * run time and the memory usage only depend on the number of local trees.
+ * \param [in] eclass       This element class determines the dimension and
+ *                          the type trees used.
+ * \param [in] num_trees    The global number of trees to use.
+ * \param [in] comm         The MPI_Communicator used to commit the cmesh.
+ * \return                  A valid partitioned cmesh, as if _init and
+ *                          _commit had been called.
+ */
+t8_cmesh_t          t8_cmesh_new_bigmesh_partitioned (t8_eclass_t eclass,
+                                                      t8_gloidx_t num_trees,
+                                                      sc_MPI_Comm comm);
+
 /** Construct a forest of three connected askew lines
   * \param [in] comm         The mpi communicator to use.
   * \return                  A valid cmesh, as if _init and _commit had been called.
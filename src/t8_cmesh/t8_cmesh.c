@@ -30,6 +30,8 @@
 #include <metis.h>
 #endif
 #include "t8_cmesh_trees.h"
+#include "t8_cmesh_partition.h"
+#include "t8_cmesh_offset.h"
 
 /** \file t8_cmesh.c
  *
@@ -179,6 +181,7 @@ t8_cmesh_init (t8_cmesh_t * pcmesh)
   /* sensible (hard error) defaults */
   cmesh->set_refine_level = 0;  /*< sensible default TODO document */
   cmesh->set_partition_level = -1;
+  cmesh->set_partition_ghost_attributes = -1;
   cmesh->dimension = -1;        /*< ok; force user to select dimension */
   cmesh->mpirank = -1;
   cmesh->mpisize = -1;
@@ -420,6 +423,33 @@ t8_cmesh_get_first_treeid (t8_cmesh_t cmesh)
   return cmesh->first_tree;
 }
 
+void
+t8_cmesh_set_partition_eclass_costs (t8_cmesh_t cmesh, const double *costs)
+{
+  int                 eclass;
+
+  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
+
+  if (costs == NULL) {
+    cmesh->set_partition_use_costs = 0;
+    return;
+  }
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    SC_CHECK_ABORT (costs[eclass] > 0,
+                    "The partition costs of all element classes must be positive.");
+    cmesh->set_partition_costs[eclass] = costs[eclass];
+  }
+  cmesh->set_partition_use_costs = 1;
+}
+
+const double       *
+t8_cmesh_get_partition_eclass_costs (t8_cmesh_t cmesh)
+{
+  T8_ASSERT (cmesh != NULL);
+
+  return cmesh->set_partition_use_costs ? cmesh->set_partition_costs : NULL;
+}
+
 /* TODO: should get a gloidx?
  *       place after commit */
 t8_ctree_t
@@ -481,11 +511,32 @@ t8_cmesh_get_tree_vertices (t8_cmesh_t cmesh, t8_locidx_t ltreeid)
                                             ltreeid);
 }
 
+/* Return the fetched attribute of a ghost or NULL if it was not fetched */
+static void        *
+t8_cmesh_get_ghost_fetched (t8_cmesh_t cmesh, int package_id, int key,
+                            t8_locidx_t lghost_id)
+{
+  t8_cmesh_ghost_fetched_t *fetched;
+  size_t              ifetched;
+
+  for (ifetched = 0; ifetched < cmesh->ghost_fetched->elem_count;
+       ifetched++) {
+    fetched = (t8_cmesh_ghost_fetched_t *)
+      sc_array_index (cmesh->ghost_fetched, ifetched);
+    if (fetched->package_id == package_id && fetched->key == key) {
+      return fetched->sizes[lghost_id] > 0 ?
+        fetched->data + fetched->offsets[lghost_id] : NULL;
+    }
+  }
+  return NULL;
+}
+
 void               *
 t8_cmesh_get_attribute (t8_cmesh_t cmesh, int package_id, int key,
                         t8_locidx_t ltree_id)
 {
   int                 is_ghost;
+  void               *attribute;
 
   T8_ASSERT (cmesh->committed);
   T8_ASSERT (0 <= ltree_id &&
@@ -494,8 +545,14 @@ t8_cmesh_get_attribute (t8_cmesh_t cmesh, int package_id, int key,
   if (is_ghost) {
     ltree_id = ltree_id - cmesh->num_local_trees;
   }
-  return t8_cmesh_trees_get_attribute (cmesh->trees, ltree_id, package_id,
-                                       key, NULL, is_ghost);
+  attribute = t8_cmesh_trees_get_attribute (cmesh->trees, ltree_id,
+                                            package_id, key, NULL, is_ghost);
+  if (attribute == NULL && is_ghost && cmesh->ghost_fetched != NULL) {
+    /* The ghost may have been shipped without its attributes */
+    attribute = t8_cmesh_get_ghost_fetched (cmesh, package_id, key,
+                                            ltree_id);
+  }
+  return attribute;
 }
 
 t8_shmem_array_t
@@ -676,36 +733,95 @@ t8_cmesh_tree_vertices_negative_volume (t8_eclass_t eclass,
 }
 
 #ifdef T8_ENABLE_DEBUG
+/* The number of trees whose volumes are checked in one batch */
+#define T8_CMESH_VOLUME_BATCH 64
+
+/* Check the volumes of n trees of which t8_cmesh_no_negative_volume stored
+ * the vertex 0, 1, 2 and j in the batches of corners, see
+ * t8_cmesh_tree_vertices_negative_volume for the choice of j.
+ * Returns true if one of the trees has negative volume. */
+static int
+t8_cmesh_negative_volume_batch (t8_cmesh_t cmesh, size_t n, double *corners,
+                                const t8_locidx_t * trees)
+{
+  double             *base = corners, *v_1 = corners + 3 * n;
+  double             *v_2 = corners + 6 * n, *v_j = corners + 9 * n;
+  double              cross[3 * T8_CMESH_VOLUME_BATCH];
+  double              sc_prod[T8_CMESH_VOLUME_BATCH];
+  t8_eclass_t         eclass;
+  size_t              i;
+  int                 ret, res = 0;
+
+  T8_ASSERT (n <= T8_CMESH_VOLUME_BATCH);
+  /* build the vectors v_i as vertices_i - vertices_0 */
+  t8_vec_batch_axpy (n, base, v_1, -1);
+  t8_vec_batch_axpy (n, base, v_2, -1);
+  t8_vec_batch_axpy (n, base, v_j, -1);
+  /* compute cross = v_1 x v_2 and sc_prod = <v_j, cross> */
+  t8_vec_batch_cross (n, v_1, v_2, cross);
+  t8_vec_batch_dot (n, v_j, cross, sc_prod);
+  for (i = 0; i < n; i++) {
+    T8_ASSERT (sc_prod[i] != 0);
+    eclass = t8_cmesh_get_tree_class (cmesh, trees[i]);
+    ret = eclass == T8_ECLASS_TET ? sc_prod[i] > 0 : sc_prod[i] < 0;
+    if (ret) {
+      t8_debugf ("Detected negative volume in tree %li\n", (long) trees[i]);
+    }
+    res |= ret;                 /* res is true if one ret value is true */
+  }
+  return res;
+}
+
 /* After a cmesh is committed, check whether all trees in a cmesh do have positive volume.
  * Returns true if all trees have positive volume.
  */
 int
 t8_cmesh_no_negative_volume (t8_cmesh_t cmesh)
 {
-  t8_locidx_t         itree;
+  t8_locidx_t         itree, trees[T8_CMESH_VOLUME_BATCH];
+  double              corners[4 * 3 * T8_CMESH_VOLUME_BATCH];
   double             *vertices;
   t8_eclass_t         eclass;
-  int                 ret, res = 0;
+  size_t              num_batch = 0;
+  int                 icorner, corner, irow, res = 0;
 
   if (cmesh == NULL) {
     return 0;
   }
-  /* Iterate over all trees, get their vertices and check the volume */
+  /* Iterate over all trees, get their vertices and check the volume of
+   * T8_CMESH_VOLUME_BATCH trees at once */
   for (itree = 0; itree < cmesh->num_local_trees; itree++) {
     vertices = t8_cmesh_get_tree_vertices (cmesh, itree);
-    ret = 1;
-    if (vertices != NULL) {
-      /* Vertices are set */
-      eclass = t8_cmesh_get_tree_class (cmesh, itree);
-      ret = t8_cmesh_tree_vertices_negative_volume (eclass, vertices,
-                                                    t8_eclass_num_vertices
-                                                    [eclass]);
-      if (ret) {
-        t8_debugf ("Detected negative volume in tree %li\n", (long) itree);
-      }
-      res |= ret;               /* res is true if one ret value is true */
+    eclass = t8_cmesh_get_tree_class (cmesh, itree);
+    if (vertices == NULL || t8_eclass_to_dimension[eclass] <= 2) {
+      /* Vertices are not set or the tree does not have a volume */
+      continue;
+    }
+    for (icorner = 0; icorner < 4; icorner++) {
+      /* The vertices 0, 1, 2 and 3 for tets and prisms, 4 otherwise */
+      corner = icorner < 3 ? icorner : eclass == T8_ECLASS_TET
+        || eclass == T8_ECLASS_PRISM ? 3 : 4;
+      t8_vec_batch_set (corners + 3 * T8_CMESH_VOLUME_BATCH * icorner,
+                        T8_CMESH_VOLUME_BATCH, num_batch,
+                        vertices + 3 * corner);
+    }
+    trees[num_batch++] = itree;
+    if (num_batch == T8_CMESH_VOLUME_BATCH) {
+      res |= t8_cmesh_negative_volume_batch (cmesh, num_batch, corners,
+                                             trees);
+      num_batch = 0;
     }
   }
+  if (num_batch > 0) {
+    /* The batch functions expect consecutive coordinate arrays of length
+     * num_batch, so we move the y and z coordinates of the last batch */
+    for (irow = 0; irow < 4 * 3; irow++) {
+      memmove (corners + num_batch * irow,
+               corners + T8_CMESH_VOLUME_BATCH * irow,
+               num_batch * sizeof (double));
+    }
+    res |= t8_cmesh_negative_volume_batch (cmesh, num_batch, corners, trees);
+  }
   return !res;
 }
 #endif
@@ -734,6 +850,39 @@ t8_cmesh_set_join (t8_cmesh_t cmesh, t8_gloidx_t gtree1, t8_gloidx_t gtree2,
                          orientation);
 }
 
+void
+t8_cmesh_set_shared_trees (t8_cmesh_t cmesh, int set_shared)
+{
+  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
+
+  cmesh->set_shared_trees = set_shared != 0;
+}
+
+void
+t8_cmesh_set_validate_geometry (t8_cmesh_t cmesh, int validate)
+{
+  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
+
+  cmesh->set_validate_geometry = validate != 0;
+}
+
+void
+t8_cmesh_set_partition_ghost_attributes (t8_cmesh_t cmesh,
+                                         int ghost_attributes)
+{
+  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
+
+  cmesh->set_partition_ghost_attributes = ghost_attributes != 0;
+}
+
+int
+t8_cmesh_get_partition_ghost_attributes (t8_cmesh_t cmesh)
+{
+  T8_ASSERT (cmesh != NULL);
+
+  return cmesh->set_partition_ghost_attributes != 0;
+}
+
 void
 t8_cmesh_set_profiling (t8_cmesh_t cmesh, int set_profiling)
 {
@@ -976,6 +1125,8 @@ t8_cmesh_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
       /* destroy stash and set to committed */
       t8_stash_destroy (&cmesh_out->stash);
       cmesh_out->committed = 1;
+      t8_cmesh_trees_build_compact (cmesh_out->trees, cmesh_out->dimension,
+                                    cmesh_out->num_local_trees, 0);
     }
   }
 
@@ -1010,6 +1161,8 @@ t8_cmesh_reorder (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   /* cmesh must be commited and not partitioned */
   T8_ASSERT (cmesh->committed);
   T8_ASSERT (!cmesh->set_partition);
+  /* We modify the trees */
+  T8_ASSERT (!t8_cmesh_trees_is_shared (cmesh->trees));
 
   mpiret = sc_MPI_Comm_size (comm, &mpisize);
   idx_mpisize = mpisize;
@@ -1092,6 +1245,9 @@ t8_cmesh_reorder (t8_cmesh_t cmesh, sc_MPI_Comm comm)
       }
     }
   }
+  /* The face neighbors changed, update their compact layout */
+  t8_cmesh_trees_build_compact (cmesh->trees, cmesh->dimension,
+                                cmesh->num_local_trees, cmesh->num_ghosts);
   T8_FREE (partition);
   T8_FREE (xadj);
   T8_FREE (adjncy);
@@ -1140,15 +1296,15 @@ int
 t8_cmesh_tree_face_is_boundary (t8_cmesh_t cmesh,
                                 t8_locidx_t ltree_id, int face)
 {
-  t8_locidx_t        *face_neighbor;
-  int8_t             *ttf;
+  t8_locidx_t         face_neighbor;
+  int8_t              ttf;
 
   T8_ASSERT (t8_cmesh_is_committed (cmesh));
 
-  (void) t8_cmesh_trees_get_tree_ext (cmesh->trees, ltree_id, &face_neighbor,
-                                      &ttf);
+  face_neighbor =
+    t8_cmesh_trees_get_face_neighbor_ext (cmesh->trees, ltree_id, face, &ttf);
 
-  if (face_neighbor[face] == ltree_id && ttf[face] == face) {
+  if (face_neighbor == ltree_id && ttf == face) {
     /* The tree is connected to itself at the same face.
      * Thus this is a domain boundary */
     return 1;
@@ -1159,12 +1315,11 @@ t8_cmesh_tree_face_is_boundary (t8_cmesh_t cmesh,
 t8_eclass_t
 t8_cmesh_get_tree_class (t8_cmesh_t cmesh, t8_locidx_t ltree_id)
 {
-  t8_ctree_t          tree;
-
   T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (0 <= ltree_id && ltree_id < cmesh->num_local_trees);
 
-  tree = t8_cmesh_get_tree (cmesh, ltree_id);
-  return tree->eclass;
+  return t8_cmesh_trees_get_class (cmesh->trees, ltree_id,
+                                   cmesh->num_local_trees);
 }
 
 t8_eclass_t
@@ -1217,14 +1372,27 @@ t8_cmesh_get_local_id (t8_cmesh_t cmesh, t8_gloidx_t global_id)
   }
 }
 
+#ifdef T8_ENABLE_PERF_COUNTERS
+/* The names of the hardware counter stats of a cmesh profile */
+static const char  *t8_cmesh_counter_names[T8_CPROFILE_NUM_COUNTED]
+[T8_COUNTER_COUNT] = {
+  {"cmesh: Partition cycles.", "cmesh: Partition instructions.",
+   "cmesh: Partition LLC misses.", "cmesh: Partition branch misses."},
+  {"cmesh: Commit cycles.", "cmesh: Commit instructions.",
+   "cmesh: Commit LLC misses.", "cmesh: Commit branch misses."}
+};
+#endif
+
 void
 t8_cmesh_print_profile (t8_cmesh_t cmesh)
 {
   T8_ASSERT (t8_cmesh_is_committed (cmesh));
   if (cmesh->profile != NULL) {
     /* Only print something if profiling is enabled */
-    sc_statinfo_t       stats[T8_CPROFILE_NUM_STATS];
+    sc_statinfo_t       stats[T8_CPROFILE_NUM_STATS +
+                              T8_CPROFILE_NUM_COUNTED * T8_COUNTER_COUNT];
     t8_cprofile_t      *profile = cmesh->profile;
+    int                 num_stats = T8_CPROFILE_NUM_STATS;
 
     /* Set the stats */
     sc_stats_set1 (&stats[0], profile->partition_trees_shipped,
@@ -1246,15 +1414,389 @@ t8_cmesh_print_profile (t8_cmesh_t cmesh)
                    "cmesh: Partition runtime.");
     sc_stats_set1 (&stats[8], profile->commit_runtime,
                    "cmesh: Commit runtime.");
+#ifdef T8_ENABLE_PERF_COUNTERS
+    {
+      const int64_t      *counters[T8_CPROFILE_NUM_COUNTED] = {
+        profile->partition_counters, profile->commit_counters
+      };
+      int                 iphase, icounter;
+
+      for (iphase = 0; iphase < T8_CPROFILE_NUM_COUNTED; iphase++) {
+        for (icounter = 0; icounter < T8_COUNTER_COUNT; icounter++) {
+          sc_stats_set1 (&stats[num_stats++], counters[iphase][icounter],
+                         t8_cmesh_counter_names[iphase][icounter]);
+        }
+      }
+    }
+#endif
     /* compute stats */
-    sc_stats_compute (sc_MPI_COMM_WORLD, T8_CPROFILE_NUM_STATS, stats);
+    sc_stats_compute (sc_MPI_COMM_WORLD, num_stats, stats);
     /* print stats */
     t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS, "Printing stats for cmesh.\n");
     sc_stats_print (t8_get_package_id (), SC_LP_STATISTICS,
-                    T8_CPROFILE_NUM_STATS, stats, 1, 1);
+                    num_stats, stats, 1, 1);
   }
 }
 
+void
+t8_cmesh_profile_accum_init (t8_cmesh_profile_accum_t * accum)
+{
+  T8_ASSERT (accum != NULL);
+
+  memset (accum, 0, sizeof (*accum));
+}
+
+void
+t8_cmesh_profile_accumulate (t8_cmesh_profile_accum_t * accum,
+                             t8_cmesh_t cmesh)
+{
+  double             *sums;
+
+  T8_ASSERT (accum != NULL);
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+
+  sums = accum->sums;
+  sums[T8_CMESH_PROFILE_TREES] += t8_cmesh_get_num_local_trees (cmesh);
+  sums[T8_CMESH_PROFILE_GHOSTS] += t8_cmesh_get_num_ghosts (cmesh);
+  if (cmesh->profile != NULL) {
+    sums[T8_CMESH_PROFILE_BYTES_SENT] += cmesh->profile->partition_bytes_sent;
+    sums[T8_CMESH_PROFILE_PARTITION_RUNTIME] +=
+      cmesh->profile->partition_runtime;
+    sums[T8_CMESH_PROFILE_COMMIT_RUNTIME] += cmesh->profile->commit_runtime;
+  }
+  accum->num_commits++;
+}
+
+void
+t8_cmesh_profile_accum_reduce (const t8_cmesh_profile_accum_t * accum,
+                               sc_MPI_Comm comm, t8_profile_value_t * values)
+{
+  T8_ASSERT (accum != NULL);
+
+  t8_profile_reduce (T8_CMESH_PROFILE_COUNT, accum->sums, comm, values);
+}
+
+void
+t8_cmesh_profile_accum_print (const t8_cmesh_profile_accum_t * accum,
+                              sc_MPI_Comm comm)
+{
+  static const char  *names[T8_CMESH_PROFILE_COUNT] = {
+    "cmesh: Trees.", "cmesh: Ghost trees.", "cmesh: Partition bytes sent.",
+    "cmesh: Partition runtime.", "cmesh: Commit runtime."
+  };
+  t8_profile_value_t  values[T8_CMESH_PROFILE_COUNT];
+
+  t8_cmesh_profile_accum_reduce (accum, comm, values);
+  t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS,
+           "Printing the accumulated profile of %i cmesh commits.\n",
+           accum->num_commits);
+  t8_profile_print (T8_CMESH_PROFILE_COUNT, names, values);
+}
+
+size_t
+t8_cmesh_memory_usage (t8_cmesh_t cmesh, size_t *usage)
+{
+  size_t              bytes[T8_CMESH_MEMORY_COUNT];
+  size_t              total;
+  t8_cmesh_trees_t    trees;
+  t8_locidx_t         num_blocks;
+  int                 icomp;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  memset (bytes, 0, sizeof (bytes));
+  bytes[T8_CMESH_MEMORY_STRUCT] = sizeof (t8_cmesh_struct_t);
+  if (cmesh->profile != NULL) {
+    bytes[T8_CMESH_MEMORY_STRUCT] += sizeof (t8_cprofile_t);
+  }
+  trees = cmesh->trees;
+  if (trees != NULL) {
+    bytes[T8_CMESH_MEMORY_STRUCT] += sizeof (t8_cmesh_trees_struct_t);
+    bytes[T8_CMESH_MEMORY_TREES] = t8_cmesh_trees_size (trees)
+      + t8_cmesh_trees_compact_size (trees);
+    if (trees->from_proc != NULL) {
+      bytes[T8_CMESH_MEMORY_TREE_TO_PROC] =
+        sc_array_memory_used (trees->from_proc, 1);
+    }
+    if (trees->tree_to_proc != NULL) {
+      bytes[T8_CMESH_MEMORY_TREE_TO_PROC] +=
+        cmesh->num_local_trees * sizeof (int);
+    }
+    if (trees->ghost_to_proc != NULL) {
+      bytes[T8_CMESH_MEMORY_TREE_TO_PROC] += cmesh->num_ghosts * sizeof (int);
+    }
+    if (trees->ghost_globalid_to_local_id != NULL) {
+      bytes[T8_CMESH_MEMORY_GHOST_HASH] =
+        sc_hash_memory_used (trees->ghost_globalid_to_local_id);
+    }
+    if (trees->global_local_mempool != NULL) {
+      bytes[T8_CMESH_MEMORY_GHOST_HASH] +=
+        sc_mempool_memory_used (trees->global_local_mempool);
+    }
+  }
+  if (cmesh->tree_offsets != NULL) {
+    bytes[T8_CMESH_MEMORY_OFFSETS] =
+      t8_shmem_array_get_elem_size (cmesh->tree_offsets)
+      * t8_shmem_array_get_elem_count (cmesh->tree_offsets);
+  }
+  if (cmesh->tree_class_prefix != NULL) {
+    /* One block for each T8_CMESH_CLASS_PREFIX_BLOCK owned trees */
+    num_blocks = (cmesh->num_local_trees - (cmesh->first_tree_shared ? 1 : 0))
+      / T8_CMESH_CLASS_PREFIX_BLOCK + 1;
+    bytes[T8_CMESH_MEMORY_OFFSETS] +=
+      num_blocks * T8_ECLASS_COUNT * sizeof (t8_locidx_t);
+  }
+
+  total = 0;
+  for (icomp = 0; icomp < T8_CMESH_MEMORY_COUNT; icomp++) {
+    total += bytes[icomp];
+  }
+  if (usage != NULL) {
+    memcpy (usage, bytes, sizeof (bytes));
+  }
+  return total;
+}
+
+/* Return the sum of the element costs of num_trees[eclass] uniform trees
+ * of each element class with children_per_tree elements each.
+ * We always sum in the same order, such that all processes compute the
+ * same value from the same counts. */
+static long double
+t8_cmesh_uniform_trees_cost (const t8_gloidx_t * num_trees,
+                             t8_gloidx_t children_per_tree,
+                             const double *eclass_costs)
+{
+  long double         cost = 0;
+  int                 eclass;
+
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    cost += (long double) eclass_costs[eclass] * num_trees[eclass]
+      * children_per_tree;
+  }
+  return cost;
+}
+
+/* The cost prefix sum at which process iproc starts */
+static long double
+t8_cmesh_uniform_target (long double total_cost, int iproc, int mpisize)
+{
+  return total_cost * iproc / mpisize;
+}
+
+/* Count for every T8_CMESH_CLASS_PREFIX_BLOCK-th owned local tree the
+ * owned local trees of each class before it. The result is stored at the
+ * cmesh and reused by all further calls. */
+static void
+t8_cmesh_uniform_class_prefix (t8_cmesh_t cmesh, t8_locidx_t first_owned)
+{
+  t8_locidx_t         ltree, num_blocks, iblock;
+  t8_locidx_t         counts[T8_ECLASS_COUNT];
+  int                 eclass;
+
+  if (cmesh->tree_class_prefix != NULL) {
+    return;
+  }
+  num_blocks = (cmesh->num_local_trees - first_owned)
+    / T8_CMESH_CLASS_PREFIX_BLOCK + 1;
+  cmesh->tree_class_prefix =
+    T8_ALLOC (t8_locidx_t, num_blocks * T8_ECLASS_COUNT);
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    counts[eclass] = 0;
+  }
+  iblock = 0;
+  for (ltree = first_owned; ltree <= cmesh->num_local_trees; ltree++) {
+    if ((ltree - first_owned) % T8_CMESH_CLASS_PREFIX_BLOCK == 0) {
+      /* Store the counts of the trees before the block */
+      T8_ASSERT (iblock < num_blocks);
+      memcpy (cmesh->tree_class_prefix + iblock * T8_ECLASS_COUNT, counts,
+              sizeof (counts));
+      iblock++;
+    }
+    if (ltree < cmesh->num_local_trees) {
+      counts[t8_cmesh_get_tree_class (cmesh, ltree)]++;
+    }
+  }
+  T8_ASSERT (iblock == num_blocks);
+}
+
+/* Compute the global index of the first element of a uniform refinement
+ * whose cost prefix sum reaches target. The tree of this element must be
+ * an owned local tree starting at first_owned. trees_before holds the
+ * number of trees of each class before first_owned. */
+static t8_gloidx_t
+t8_cmesh_uniform_first_child (t8_cmesh_t cmesh, t8_locidx_t first_owned,
+                              const t8_gloidx_t * trees_before,
+                              t8_gloidx_t children_per_tree,
+                              const double *eclass_costs, long double target)
+{
+  t8_locidx_t         low, high, mid, ltree, num_blocks;
+  t8_gloidx_t         counts[T8_ECLASS_COUNT], child;
+  t8_eclass_t         tree_class;
+  long double         prefix;
+  int                 eclass;
+  const t8_locidx_t  *block_prefix = cmesh->tree_class_prefix;
+
+  num_blocks = (cmesh->num_local_trees - first_owned)
+    / T8_CMESH_CLASS_PREFIX_BLOCK + 1;
+  /* Find the last block whose cost prefix is at most target */
+  low = 0;
+  high = num_blocks - 1;
+  while (low < high) {
+    mid = (low + high + 1) / 2;
+    for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+      counts[eclass] = trees_before[eclass]
+        + block_prefix[mid * T8_ECLASS_COUNT + eclass];
+    }
+    if (t8_cmesh_uniform_trees_cost (counts, children_per_tree,
+                                     eclass_costs) <= target) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    counts[eclass] = trees_before[eclass]
+      + block_prefix[low * T8_ECLASS_COUNT + eclass];
+  }
+  /* In this block, find the last tree whose cost prefix is at most target.
+   * The cost prefix after this tree exceeds target. */
+  ltree = first_owned + low * T8_CMESH_CLASS_PREFIX_BLOCK;
+  prefix = t8_cmesh_uniform_trees_cost (counts, children_per_tree,
+                                        eclass_costs);
+  T8_ASSERT (prefix <= target);
+  for (;;) {
+    tree_class = t8_cmesh_get_tree_class (cmesh, ltree);
+    counts[tree_class]++;
+    if (ltree + 1 >= cmesh->num_local_trees
+        || t8_cmesh_uniform_trees_cost (counts, children_per_tree,
+                                        eclass_costs) > target) {
+      break;
+    }
+    prefix = t8_cmesh_uniform_trees_cost (counts, children_per_tree,
+                                          eclass_costs);
+    ltree++;
+  }
+  child = eclass_costs[tree_class] > 0 ?
+    (t8_gloidx_t) ceill ((target - prefix) / eclass_costs[tree_class])
+    : children_per_tree;
+  /* Due to rounding the process may start in the next tree */
+  child = SC_MIN (child, children_per_tree);
+  return (cmesh->first_tree + ltree) * children_per_tree + child;
+}
+
+/* Compute the global index of the first element of each process of a
+ * uniform refinement, such that each process gets about the same sum of
+ * element costs. The cost of an element is the cost of the element class
+ * of its tree. Process p starts at the first element whose cost prefix
+ * sum reaches p / mpisize times the total cost.
+ * On output first_child and end_child are the first element of this
+ * process and of the next process, or the global number of elements.
+ * The cost prefix sums are computed from integer tree counts, thus
+ * the result does not depend on whether cmesh is partitioned.
+ * The start of a process is found with a binary search in the prefix
+ * counts of the tree classes, which are computed once per cmesh.
+ * If cmesh is partitioned, this function is collective over comm. */
+static void
+t8_cmesh_uniform_offsets_costs (t8_cmesh_t cmesh,
+                                t8_gloidx_t children_per_tree,
+                                const double *eclass_costs,
+                                sc_MPI_Comm comm,
+                                t8_gloidx_t * first_child,
+                                t8_gloidx_t * end_child)
+{
+  t8_locidx_t         ltree, first_owned, num_local_trees;
+  t8_gloidx_t        *local_first, *first_children;
+  t8_gloidx_t         local_count[T8_ECLASS_COUNT];
+  t8_gloidx_t         trees_before[T8_ECLASS_COUNT];
+  t8_gloidx_t         trees_after[T8_ECLASS_COUNT];
+  long double         total_cost, first_cost, end_cost, target;
+  int                 iproc, eclass, mpiret;
+  const int           mpisize = cmesh->mpisize;
+  const t8_gloidx_t   num_children = cmesh->num_trees * children_per_tree;
+
+  num_local_trees = t8_cmesh_get_num_local_trees (cmesh);
+  /* A shared first tree is counted by the previous process */
+  first_owned = cmesh->set_partition && cmesh->first_tree_shared == 1;
+  total_cost = t8_cmesh_uniform_trees_cost (cmesh->num_trees_per_eclass,
+                                            children_per_tree, eclass_costs);
+  t8_cmesh_uniform_class_prefix (cmesh, first_owned);
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    trees_before[eclass] = 0;
+  }
+
+  if (!cmesh->set_partition) {
+    /* All trees are local, we compute the start of this process and of
+     * the next one. */
+    target = t8_cmesh_uniform_target (total_cost, cmesh->mpirank, mpisize);
+    *first_child = target < total_cost ?
+      t8_cmesh_uniform_first_child (cmesh, 0, trees_before,
+                                    children_per_tree, eclass_costs,
+                                    target) : num_children;
+    target = t8_cmesh_uniform_target (total_cost, cmesh->mpirank + 1,
+                                      mpisize);
+    *end_child = cmesh->mpirank + 1 < mpisize && target < total_cost ?
+      t8_cmesh_uniform_first_child (cmesh, 0, trees_before,
+                                    children_per_tree, eclass_costs,
+                                    target) : num_children;
+    return;
+  }
+
+  /* Count the trees of each class on the smaller ranks */
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    local_count[eclass] = 0;
+  }
+  for (ltree = first_owned; ltree < num_local_trees; ltree++) {
+    local_count[t8_cmesh_get_tree_class (cmesh, ltree)]++;
+  }
+  mpiret = sc_MPI_Scan (local_count, trees_after, T8_ECLASS_COUNT,
+                        T8_MPI_GLOIDX, sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    trees_before[eclass] = trees_after[eclass] - local_count[eclass];
+  }
+  /* The processes whose start lies in our owned trees are those
+   * with first_cost <= target < end_cost */
+  first_cost = t8_cmesh_uniform_trees_cost (trees_before, children_per_tree,
+                                            eclass_costs);
+  end_cost = t8_cmesh_uniform_trees_cost (trees_after, children_per_tree,
+                                          eclass_costs);
+  local_first = T8_ALLOC (t8_gloidx_t, mpisize + 1);
+  for (iproc = 0; iproc <= mpisize; iproc++) {
+    local_first[iproc] = num_children;
+  }
+  if (first_cost < end_cost) {
+    /* Guess the first such process and correct the guess */
+    iproc = total_cost > 0 ?
+      (int) SC_MIN (first_cost * mpisize / total_cost, mpisize) : mpisize;
+    while (iproc > 0 && t8_cmesh_uniform_target (total_cost, iproc - 1,
+                                                 mpisize) >= first_cost) {
+      iproc--;
+    }
+    while (iproc < mpisize && t8_cmesh_uniform_target (total_cost, iproc,
+                                                       mpisize) <
+           first_cost) {
+      iproc++;
+    }
+    for (; iproc < mpisize
+         && (target = t8_cmesh_uniform_target (total_cost, iproc, mpisize))
+         < end_cost; iproc++) {
+      local_first[iproc] =
+        t8_cmesh_uniform_first_child (cmesh, first_owned, trees_before,
+                                      children_per_tree, eclass_costs,
+                                      target);
+    }
+  }
+  /* Each entry was computed by the process owning the tree */
+  first_children = T8_ALLOC (t8_gloidx_t, mpisize + 1);
+  mpiret = sc_MPI_Allreduce (local_first, first_children, mpisize + 1,
+                             T8_MPI_GLOIDX, sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  *first_child = first_children[cmesh->mpirank];
+  *end_child = first_children[cmesh->mpirank + 1];
+  T8_FREE (local_first);
+  T8_FREE (first_children);
+}
+
 void
 t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
                          t8_gloidx_t * first_local_tree,
@@ -1262,6 +1804,21 @@ t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
                          t8_gloidx_t * last_local_tree,
                          t8_gloidx_t * child_in_tree_end,
                          int8_t * first_tree_shared)
+{
+  t8_cmesh_uniform_bounds_costs (cmesh, level, NULL, sc_MPI_COMM_NULL,
+                                 first_local_tree, child_in_tree_begin,
+                                 last_local_tree, child_in_tree_end,
+                                 first_tree_shared);
+}
+
+void
+t8_cmesh_uniform_bounds_costs (t8_cmesh_t cmesh, int level,
+                               const double *eclass_costs, sc_MPI_Comm comm,
+                               t8_gloidx_t * first_local_tree,
+                               t8_gloidx_t * child_in_tree_begin,
+                               t8_gloidx_t * last_local_tree,
+                               t8_gloidx_t * child_in_tree_end,
+                               int8_t * first_tree_shared)
 {
   int                 is_empty;
 
@@ -1291,11 +1848,12 @@ t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
     children_per_tree = one << cmesh->dimension * level;
     global_num_children = cmesh->num_trees * children_per_tree;
 
-    if (cmesh->mpirank == 0) {
-      first_global_child = 0;
-      if (child_in_tree_begin != NULL) {
-        *child_in_tree_begin = 0;
-      }
+    if (eclass_costs != NULL) {
+      T8_ASSERT (!cmesh->set_partition || comm != sc_MPI_COMM_NULL);
+      t8_cmesh_uniform_offsets_costs (cmesh, children_per_tree,
+                                      eclass_costs, comm,
+                                      &first_global_child,
+                                      &last_global_child);
     }
     else {
       /* The first global child of processor p
@@ -1303,18 +1861,14 @@ t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
        * (total_num_children * p) / P
        * We cast to long double and double first to prevent integer overflow.
        */
-      first_global_child =
+      first_global_child = cmesh->mpirank == 0 ? 0 :
         ((long double) global_num_children *
          cmesh->mpirank) / (double) cmesh->mpisize;
-    }
-    if (cmesh->mpirank != cmesh->mpisize - 1) {
-      last_global_child =
+      last_global_child = cmesh->mpirank == cmesh->mpisize - 1 ?
+        global_num_children :
         ((long double) global_num_children *
          (cmesh->mpirank + 1)) / (double) cmesh->mpisize;
     }
-    else {
-      last_global_child = global_num_children;
-    }
 
     T8_ASSERT (0 <= first_global_child
                && first_global_child <= global_num_children);
@@ -1414,13 +1968,19 @@ t8_cmesh_reset (t8_cmesh_t * pcmesh)
   }
   else {
     if (cmesh->trees != NULL) {
-      t8_cmesh_trees_destroy (&cmesh->trees);
+      t8_cmesh_trees_unref (&cmesh->trees);
     }
     T8_ASSERT (cmesh->set_from == NULL);
   }
   if (cmesh->profile != NULL) {
     T8_FREE (cmesh->profile);
   }
+  if (cmesh->tree_class_prefix != NULL) {
+    T8_FREE (cmesh->tree_class_prefix);
+  }
+  if (cmesh->ghost_fetched != NULL) {
+    t8_cmesh_free_ghost_fetched (cmesh);
+  }
   if (cmesh->set_refine_scheme != NULL) {
     t8_scheme_cxx_unref (&cmesh->set_refine_scheme);
   }
@@ -2265,16 +2825,11 @@ t8_cmesh_new_hypercube (t8_eclass_t eclass, sc_MPI_Comm comm, int do_bcast,
   }
 
   if (do_partition) {
-    int                 mpirank, mpisize, mpiret;
-    int                 first_tree, last_tree, num_trees;
-    mpiret = sc_MPI_Comm_rank (comm, &mpirank);
-    SC_CHECK_MPI (mpiret);
-    mpiret = sc_MPI_Comm_size (comm, &mpisize);
-    SC_CHECK_MPI (mpiret);
-    num_trees = num_trees_for_hypercube[eclass];
-    first_tree = (mpirank * num_trees) / mpisize;
-    last_tree = ((mpirank + 1) * num_trees) / mpisize - 1;
-    t8_cmesh_set_partition_range (cmesh, 3, first_tree, last_tree);
+    t8_shmem_array_t    offsets;
+
+    /* The uniform partition table is known without communication */
+    offsets = t8_cmesh_offset_uniform (comm, num_trees_for_hypercube[eclass]);
+    t8_cmesh_set_partition_offsets (cmesh, offsets);
   }
 
   t8_cmesh_commit (cmesh, comm);
@@ -2483,6 +3038,57 @@ t8_cmesh_new_bigmesh (t8_eclass_t eclass, int num_trees, sc_MPI_Comm comm)
   return cmesh;
 }
 
+t8_cmesh_t
+t8_cmesh_new_bigmesh_partitioned (t8_eclass_t eclass, t8_gloidx_t num_trees,
+                                  sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_shmem_array_t    offsets;
+  t8_gloidx_t        *offset_array, first_tree, last_tree, gtree;
+  int                 mpirank, mpiret;
+
+  T8_ASSERT (num_trees >= 0);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  t8_cmesh_init (&cmesh);
+  /* Each process only adds its own trees and ghosts to the stash.
+   * The partition table is computed locally. */
+  offsets = t8_cmesh_offset_uniform (comm, num_trees);
+  offset_array = t8_shmem_array_get_gloidx_array (offsets);
+  first_tree = t8_offset_first (mpirank, offset_array);
+  last_tree = first_tree + t8_offset_num_trees (mpirank, offset_array) - 1;
+  for (gtree = first_tree; gtree <= last_tree; gtree++) {
+    t8_cmesh_set_tree_class (cmesh, gtree, eclass);
+  }
+  if (t8_eclass_to_dimension[eclass] > 0 && first_tree <= last_tree) {
+    /* We join each tree with its successor along faces 0 and 1
+     * as in t8_cmesh_new_bigmesh. The neighbors of the first and
+     * last local tree are ghosts. */
+    for (gtree = first_tree; gtree <= last_tree; gtree++) {
+      t8_cmesh_set_join (cmesh, gtree, (gtree + 1) % num_trees, 0, 1, 0);
+    }
+    if (last_tree - first_tree + 1 < num_trees) {
+      /* The predecessor of the first tree and the successor of the
+       * last tree are not local */
+      t8_cmesh_set_join (cmesh, (first_tree + num_trees - 1) % num_trees,
+                         first_tree, 0, 1, 0);
+      t8_cmesh_set_tree_class (cmesh,
+                               (first_tree + num_trees - 1) % num_trees,
+                               eclass);
+      if ((last_tree + 1) % num_trees
+          != (first_tree + num_trees - 1) % num_trees) {
+        t8_cmesh_set_tree_class (cmesh, (last_tree + 1) % num_trees,
+                                 eclass);
+      }
+    }
+  }
+  t8_cmesh_set_partition_offsets (cmesh, offsets);
+  t8_cmesh_commit (cmesh, comm);
+
+  return cmesh;
+}
+
 t8_cmesh_t
 t8_cmesh_new_line_zigzag (sc_MPI_Comm comm)
 {
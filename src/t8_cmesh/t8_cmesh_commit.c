@@ -81,6 +81,10 @@ t8_cmesh_set_shmem_type (sc_MPI_Comm comm)
   t8_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
 }
 
+/* The minimum number of attributes for which the data is copied by
+ * several threads */
+#define T8_CMESH_COMMIT_THREADED_COPY_MIN 4096
+
 void
 t8_cmesh_add_attributes (t8_cmesh_t cmesh)
 {
@@ -88,7 +92,16 @@ t8_cmesh_add_attributes (t8_cmesh_t cmesh)
   t8_stash_t          stash = cmesh->stash;
   t8_locidx_t         ltree;
   size_t              si, sj;
-
+  long                num_copies, icopy;
+  t8_stash_attribute_struct_t **sources;
+  char              **dests;
+
+  /* We first set the attribute infos, since the offset of an attribute
+   * depends on the previous one. The data is copied afterwards. */
+  sources = T8_ALLOC (t8_stash_attribute_struct_t *,
+                      SC_MAX (stash->attributes.elem_count, 1));
+  dests = T8_ALLOC (char *, SC_MAX (stash->attributes.elem_count, 1));
+  num_copies = 0;
   ltree = -1;
   for (si = 0, sj = 0; si < stash->attributes.elem_count; si++, sj++) {
     attribute = (t8_stash_attribute_struct_t *)
@@ -104,10 +117,24 @@ t8_cmesh_add_attributes (t8_cmesh_t cmesh)
        * Should not cause problems, since mesh is replicated */
       T8_ASSERT (attribute->id - cmesh->first_tree ==
                  (t8_locidx_t) attribute->id - cmesh->first_tree);
-      t8_cmesh_trees_add_attribute (cmesh->trees, 0, attribute,
-                                    attribute->id - cmesh->first_tree, sj);
+      sources[num_copies] = attribute;
+      dests[num_copies] =
+        t8_cmesh_trees_add_attribute_info (cmesh->trees, 0, attribute,
+                                           attribute->id - cmesh->first_tree,
+                                           sj);
+      num_copies++;
     }
   }
+  /* The attributes do not overlap, so we can copy them in parallel */
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp parallel for if (num_copies >= T8_CMESH_COMMIT_THREADED_COPY_MIN)
+#endif
+  for (icopy = 0; icopy < num_copies; icopy++) {
+    memcpy (dests[icopy], sources[icopy]->attr_data,
+            sources[icopy]->attr_size);
+  }
+  T8_FREE (sources);
+  T8_FREE (dests);
 }
 
 static void
@@ -118,24 +145,24 @@ t8_cmesh_commit_replicated_new (t8_cmesh_t cmesh)
   int8_t             *ttf, *ttf2;
   t8_stash_joinface_struct_t *joinface;
   t8_ctree_t          tree1;
-  int                 F;
+  int                 F, ieclass;
   size_t              si;
 
   if (cmesh->stash != NULL && cmesh->stash->classes.elem_count > 0) {
     t8_stash_t          stash = cmesh->stash;
     sc_array_t         *class_entries = &stash->classes;
-    t8_stash_class_struct_t *entry;
-    t8_locidx_t         num_trees = class_entries->elem_count, ltree;
+    t8_locidx_t         num_trees = class_entries->elem_count;
 
     t8_cmesh_trees_init (&cmesh->trees, 1, num_trees, 0);
     t8_cmesh_trees_start_part (cmesh->trees, 0, 0, num_trees, 0, 0, 1);
     /* set tree classes */
-    for (ltree = 0; ltree < num_trees; ltree++) {
-      entry = (t8_stash_class_struct_t *)
-        t8_sc_array_index_locidx (class_entries, ltree);
-      t8_cmesh_trees_add_tree (cmesh->trees, entry->id, 0, entry->eclass);
-      cmesh->num_trees_per_eclass[entry->eclass]++;
-      cmesh->num_local_trees_per_eclass[entry->eclass]++;
+    t8_cmesh_trees_add_trees (cmesh->trees, 0,
+                              (t8_stash_class_struct_t *)
+                              class_entries->array, num_trees, 0,
+                              cmesh->num_local_trees_per_eclass);
+    for (ieclass = 0; ieclass < T8_ECLASS_COUNT; ieclass++) {
+      cmesh->num_trees_per_eclass[ieclass] =
+        cmesh->num_local_trees_per_eclass[ieclass];
     }
     for (si = 0; si < stash->attributes.elem_count; si++) {
       attribute = (t8_stash_attribute_struct_t *)
@@ -200,12 +227,12 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   struct ghost_facejoins_struct *ghost_facejoin = NULL, *temp_facejoin,
     **facejoin_pp;
   size_t              joinfaces_it, iz;
-  t8_gloidx_t         last_tree = cmesh->num_local_trees +
-    cmesh->first_tree - 1, id1, id2;
+  t8_gloidx_t         last_tree, id1, id2;
   t8_locidx_t         temp_local_id = 0;
   t8_locidx_t         num_hashs;
   t8_gloidx_t        *face_neigh_g, *face_neigh_g2;
   t8_stash_class_struct_t *classentry;
+  ssize_t             first_class;
   int                 id1_istree, id2_istree;
 #if T8_ENABLE_DEBUG
   t8_cghost_t         ghost1, ghost2;
@@ -247,6 +274,7 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   /* The first_tree and first_tree_shared entries must be set by now */
   T8_ASSERT (cmesh->first_tree >= 0);
   T8_ASSERT (cmesh->first_tree_shared >= 0);
+  last_tree = cmesh->first_tree + cmesh->num_local_trees - 1;
 
   num_hashs = cmesh->num_local_trees > 0 ? cmesh->num_local_trees : 10;
   ghost_facejoin_mempool = sc_mempool_new (sizeof (t8_ghost_facejoin_t));
@@ -327,28 +355,46 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
     /* Iterate through classes and add ghosts and trees */
     /* We need a temporary ghost_facejoin to check the hash for existing global ids */
     temp_facejoin->local_id = -10;
+    /* After sorting the classes by tree id, the local trees are
+     * a consecutive range of the classes */
+    t8_stash_class_sort (cmesh->stash);
+    first_class = 0;
+    if (cmesh->num_local_trees > 0) {
+      first_class = t8_stash_class_bsearch (cmesh->stash, cmesh->first_tree);
+      SC_CHECK_ABORTF (first_class >= 0 && (size_t) first_class +
+                       cmesh->num_local_trees <=
+                       cmesh->stash->classes.elem_count,
+                       "The classes of the local trees [%lli,%lli] are "
+                       "not set.\n", (long long) cmesh->first_tree,
+                       (long long) last_tree);
+      T8_ASSERT (((t8_stash_class_struct_t *)
+                  sc_array_index (&cmesh->stash->classes, first_class +
+                                  cmesh->num_local_trees - 1))->id ==
+                 last_tree);
+      t8_cmesh_trees_add_trees (cmesh->trees, 0, (t8_stash_class_struct_t *)
+                                sc_array_index (&cmesh->stash->classes,
+                                                first_class),
+                                cmesh->num_local_trees, cmesh->first_tree,
+                                cmesh->num_local_trees_per_eclass);
+    }
     for (iz = 0; iz < cmesh->stash->classes.elem_count; iz++) {
+      if (iz == (size_t) first_class && cmesh->num_local_trees > 0) {
+        /* skip the local trees */
+        iz += cmesh->num_local_trees - 1;
+        continue;
+      }
       /* get class and tree id */
       classentry = (t8_stash_class_struct_t *)
         sc_array_index (&cmesh->stash->classes, iz);
       temp_facejoin->ghost_id = classentry->id;
-      if (cmesh->first_tree <= classentry->id && classentry->id <= last_tree) {
-        /* initialize tree */
-        t8_cmesh_trees_add_tree (cmesh->trees,
-                                 classentry->id - cmesh->first_tree, 0,
-                                 classentry->eclass);
-        cmesh->num_local_trees_per_eclass[classentry->eclass]++;
-      }
-      else {
-        if (sc_hash_lookup (ghost_ids, temp_facejoin,
-                            (void ***) &facejoin_pp)) {
-          /* The classentry belongs to a local ghost */
-          ghost_facejoin = *facejoin_pp;
-          t8_cmesh_trees_add_ghost (cmesh->trees, ghost_facejoin->local_id,
-                                    ghost_facejoin->ghost_id, 0,
-                                    classentry->eclass,
-                                    cmesh->num_local_trees);
-        }
+      T8_ASSERT (classentry->id < cmesh->first_tree
+                 || last_tree < classentry->id);
+      if (sc_hash_lookup (ghost_ids, temp_facejoin, (void ***) &facejoin_pp)) {
+        /* The classentry belongs to a local ghost */
+        ghost_facejoin = *facejoin_pp;
+        t8_cmesh_trees_add_ghost (cmesh->trees, ghost_facejoin->local_id,
+                                  ghost_facejoin->ghost_id, 0,
+                                  classentry->eclass, cmesh->num_local_trees);
       }
     }
     /* We are done with stash->classes now  so we free memory.
@@ -483,12 +529,7 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
       /* Done with setting face join */
     }
 
-    /* Add attributes */
-    /* TODO: attribute is required to be sorted right now. Think this over
-     *       if we cant work around it, at least use the sorted array above when
-     *       counting the attributes per tree. */
-
-    t8_stash_attribute_sort (cmesh->stash);
+    /* Add attributes. They were sorted at the beginning of this function. */
     t8_cmesh_add_attributes (cmesh);
 
     /* compute global number of trees. id1 serves as buffer since
@@ -575,7 +616,7 @@ t8_cmesh_commit_refine (t8_cmesh_t cmesh, sc_MPI_Comm comm)
      * set it temporarily. */
     cmesh->set_refine_level = 1;
   }
-  t8_cmesh_refine (cmesh);
+  t8_cmesh_refine (cmesh, comm);
   if (level > 1) {
     /* reset the refinement level and
      * cmesh_from. */
@@ -611,6 +652,7 @@ t8_cmesh_commit (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   /* If profiling is enabled, we measure the runtime of  commit. */
   if (cmesh->profile != NULL) {
     cmesh->profile->commit_runtime = sc_MPI_Wtime ();
+    t8_counters_start (cmesh->profile->commit_counters);
   }
   /* Get mpisize and rank */
   mpiret = sc_MPI_Comm_size (comm, &cmesh->mpisize);
@@ -620,6 +662,17 @@ t8_cmesh_commit (t8_cmesh_t cmesh, sc_MPI_Comm comm)
 
   if (cmesh->set_from != NULL) {
     cmesh->dimension = cmesh->set_from->dimension;
+    if (!cmesh->set_partition_use_costs) {
+      /* Keep the partition costs of the from cmesh */
+      t8_cmesh_set_partition_eclass_costs (cmesh,
+                                           t8_cmesh_get_partition_eclass_costs
+                                           (cmesh->set_from));
+    }
+    if (cmesh->set_partition_ghost_attributes < 0) {
+      /* Keep the ghost attribute setting of the from cmesh */
+      cmesh->set_partition_ghost_attributes =
+        cmesh->set_from->set_partition_ghost_attributes;
+    }
     if (cmesh->face_knowledge == -1) {
       /* Keep the face knowledge of the from cmesh, if -1 was specified */
       cmesh->face_knowledge = cmesh->set_from->face_knowledge;
@@ -632,6 +685,12 @@ t8_cmesh_commit (t8_cmesh_t cmesh, sc_MPI_Comm comm)
          * create the new cmesh. */
         t8_cmesh_init (&cmesh_temp);
         t8_cmesh_set_derive (cmesh_temp, cmesh->set_from);
+        t8_cmesh_set_partition_eclass_costs (cmesh_temp,
+                                             t8_cmesh_get_partition_eclass_costs
+                                             (cmesh));
+        t8_cmesh_set_partition_ghost_attributes (cmesh_temp,
+                                                 t8_cmesh_get_partition_ghost_attributes
+                                                 (cmesh));
         /* TODO: This code is duplicated below and may also be shorter */
         if (cmesh->tree_offsets != NULL) {
           t8_cmesh_set_partition_offsets (cmesh_temp, cmesh->tree_offsets);
@@ -702,16 +761,58 @@ t8_cmesh_commit (t8_cmesh_t cmesh, sc_MPI_Comm comm)
     }
   }
 
+  if (cmesh->set_partition_ghost_attributes < 0) {
+    /* By default the ghosts carry their attributes */
+    cmesh->set_partition_ghost_attributes = 1;
+  }
   cmesh->committed = 1;
 
+  if (cmesh->trees != NULL && cmesh->trees->compact_eclass == NULL) {
+    /* Build the lookup layout of the face neighbors. Trees that were
+     * taken over from a derived cmesh already have it. */
+    t8_cmesh_trees_build_compact (cmesh->trees, cmesh->dimension,
+                                  cmesh->num_local_trees, cmesh->num_ghosts);
+  }
+
   /* Compute trees_per_eclass */
   t8_cmesh_gather_trees_per_eclass (cmesh, comm);
 
+  if (cmesh->set_shared_trees && !cmesh->set_partition
+      && !t8_cmesh_trees_is_shared (cmesh->trees)) {
+    /* Store the replicated trees once per node */
+    t8_cmesh_trees_share (cmesh->trees, comm);
+  }
+
   if (cmesh->set_partition) {
     t8_cmesh_gather_treecount (cmesh, comm);
   }
   T8_ASSERT (cmesh->set_partition || cmesh->tree_offsets == NULL);
 
+  if (cmesh->set_validate_geometry) {
+    t8_cmesh_geometry_report_t report;
+
+    /* Check all trees and print a summary instead of aborting */
+    t8_cmesh_validate_geometry (cmesh, T8_CMESH_VALIDATE_TOLERANCE, comm,
+                                &report);
+    if (report.num_inverted > 0 || report.num_degenerate > 0) {
+      t8_global_errorf ("Cmesh geometry: %lld of %lld trees are inverted "
+                        "(first %lld) and %lld are degenerate (first %lld)."
+                        " Minimal quality %g.\n",
+                        (long long) report.num_inverted,
+                        (long long) report.num_checked,
+                        (long long) report.first_inverted,
+                        (long long) report.num_degenerate,
+                        (long long) report.first_degenerate,
+                        report.min_quality);
+    }
+    else {
+      t8_global_productionf ("Cmesh geometry: %lld trees are valid."
+                             " Minimal quality %g.\n",
+                             (long long) report.num_checked,
+                             report.min_quality);
+    }
+  }
+
 #if T8_ENABLE_DEBUG
   t8_debugf ("Cmesh is %spartitioned.\n", cmesh->set_partition ? "" : "not ");
   if (cmesh->set_partition) {
@@ -738,6 +839,7 @@ t8_cmesh_commit (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   if (cmesh->profile != NULL) {
     cmesh->profile->commit_runtime = sc_MPI_Wtime () -
       cmesh->profile->commit_runtime;
+    t8_counters_stop (cmesh->profile->commit_counters);
     /* We also measure the number of shared trees,
      * it is the average over all first_tree_shared*mpisize values. */
     cmesh->profile->first_tree_shared = cmesh->first_tree_shared
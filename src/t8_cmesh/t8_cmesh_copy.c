@@ -22,7 +22,9 @@
 
 /** \file t8_cmesh_copy.c
  *
- * TODO: document this file
+ * Copy a cmesh when it is derived without changes.
+ * A committed cmesh does not change its trees, therefore the copy
+ * references the trees of the original cmesh instead of duplicating them.
  */
 
 #include <t8_data/t8_shmem.h>
@@ -32,6 +34,23 @@
 #include "t8_cmesh_trees.h"
 #include "t8_cmesh_copy.h"
 
+void
+t8_cmesh_share_trees (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from)
+{
+  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
+  T8_ASSERT (!cmesh->committed);
+  T8_ASSERT (cmesh->trees == NULL);
+  T8_ASSERT (t8_cmesh_is_committed (cmesh_from));
+
+  cmesh->num_local_trees = cmesh_from->num_local_trees;
+  cmesh->num_ghosts = cmesh_from->num_ghosts;
+  memcpy (cmesh->num_local_trees_per_eclass,
+          cmesh_from->num_local_trees_per_eclass,
+          T8_ECLASS_COUNT * sizeof (t8_locidx_t));
+  t8_cmesh_trees_ref (cmesh_from->trees);
+  cmesh->trees = cmesh_from->trees;
+}
+
 void
 t8_cmesh_copy (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from, sc_MPI_Comm comm)
 {
@@ -72,6 +91,16 @@ t8_cmesh_copy (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from, sc_MPI_Comm comm)
           cmesh_from->num_local_trees_per_eclass,
           T8_ECLASS_COUNT * sizeof (t8_locidx_t));
 
+  if (!cmesh->set_shared_trees
+      || t8_cmesh_trees_is_shared (cmesh_from->trees)) {
+    /* The trees of cmesh_from are not changed anymore and we can use them.
+     * Only if the trees of cmesh are moved to shared memory in commit and
+     * those of cmesh_from are not, we need our own copy. */
+    cmesh->trees = NULL;
+    t8_cmesh_share_trees (cmesh, cmesh_from);
+    return;
+  }
+
   /* Copy the tree info */
   num_parts = t8_cmesh_trees_get_numproc (cmesh_from->trees);
   cmesh->trees = NULL;
@@ -34,9 +34,27 @@
 
 T8_EXTERN_C_BEGIN ();
 
+/** Copy a committed cmesh to a cmesh that is being committed.
+ * The trees of \a cmesh_from are shared with \a cmesh by reference, unless
+ * \a cmesh stores its trees in shared memory and \a cmesh_from does not.
+ * Then the trees are copied.
+ * \param [in,out] cmesh      An initialized, not committed cmesh.
+ * \param [in]     cmesh_from A committed cmesh.
+ * \param [in]     comm       The communicator of \a cmesh.
+ */
 void                t8_cmesh_copy (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
                                    sc_MPI_Comm comm);
 
+/** Let a cmesh that is being committed use the trees of a committed cmesh.
+ * The trees are not copied, but referenced. This requires that \a cmesh
+ * has the same local trees and ghosts as \a cmesh_from.
+ * The local tree and ghost counts are set in \a cmesh.
+ * \param [in,out] cmesh      An initialized, not committed cmesh without trees.
+ * \param [in]     cmesh_from A committed cmesh.
+ */
+void                t8_cmesh_share_trees (t8_cmesh_t cmesh,
+                                          t8_cmesh_t cmesh_from);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_CMESH_COPY_H */
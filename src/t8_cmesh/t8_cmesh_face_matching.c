@@ -0,0 +1,243 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include "t8_cmesh_face_matching.h"
+#include "t8_cmesh_reader.h"
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#include <omp.h>
+#endif
+
+/* The number of bits of a radix sort digit */
+#define T8_FACE_MATCHING_RADIX_BITS 8
+
+/* The record of one face of a tree */
+typedef struct
+{
+  /* The vertex indices of the face plus one in ascending order.
+   * Unused entries are zero. */
+  unsigned long       key[T8_ECLASS_MAX_CORNERS_2D];
+  t8_locidx_t         tree;     /* The index of the tree */
+  int8_t              face;     /* The face number in the tree */
+} t8_cmesh_face_record_t;
+
+/* Fill the record of a face of a tree */
+static void
+t8_cmesh_face_record_init (t8_cmesh_face_record_t * record,
+                           t8_eclass_t eclass, const long *vertices,
+                           t8_locidx_t tree, int face)
+{
+  const int           face_class = t8_eclass_face_types[eclass][face];
+  const int           num_vertices = t8_eclass_num_vertices[face_class];
+  unsigned long       key;
+  int                 iv, jv;
+
+  record->tree = tree;
+  record->face = face;
+  /* Insertion sort of the face vertices */
+  for (iv = 0; iv < num_vertices; iv++) {
+    T8_ASSERT (vertices[t8_face_vertex_to_tree_vertex[eclass][face][iv]]
+               >= 0);
+    key = vertices[t8_face_vertex_to_tree_vertex[eclass][face][iv]] + 1;
+    for (jv = iv; jv > 0 && record->key[jv - 1] > key; jv--) {
+      record->key[jv] = record->key[jv - 1];
+    }
+    record->key[jv] = key;
+  }
+  for (iv = num_vertices; iv < T8_ECLASS_MAX_CORNERS_2D; iv++) {
+    record->key[iv] = 0;
+  }
+}
+
+/* Store the vertex indices of a face of a tree in face order */
+static void
+t8_cmesh_face_record_vertices (t8_eclass_t eclass, const long *vertices,
+                               int face, long *face_vertices)
+{
+  const int           face_class = t8_eclass_face_types[eclass][face];
+  int                 iv;
+
+  for (iv = 0; iv < t8_eclass_num_vertices[face_class]; iv++) {
+    face_vertices[iv] =
+      vertices[t8_face_vertex_to_tree_vertex[eclass][face][iv]];
+  }
+}
+
+/* Return true if two records have the same vertices */
+static int
+t8_cmesh_face_record_equal (const t8_cmesh_face_record_t * record_a,
+                            const t8_cmesh_face_record_t * record_b)
+{
+  return !memcmp (record_a->key, record_b->key, sizeof (record_a->key));
+}
+
+/* Sort records by their keys with a stable least significant digit
+ * radix sort. The key entries are compared from the last to the first,
+ * and we skip the passes in which all records have the same digit.
+ * On output records is sorted, buffer is used as temporary storage. */
+static void
+t8_cmesh_face_records_sort (t8_cmesh_face_record_t ** records,
+                            t8_cmesh_face_record_t ** buffer,
+                            size_t num_records, unsigned long max_key)
+{
+  const size_t        num_buckets = (size_t) 1 << T8_FACE_MATCHING_RADIX_BITS;
+  const unsigned long mask = num_buckets - 1;
+  size_t             *counts, iz, sum, count;
+  t8_cmesh_face_record_t *swap;
+  int                 ikey, shift, max_shift = 0;
+
+  while (max_shift < (int) (8 * sizeof (unsigned long))
+         && (max_key >> max_shift) > mask) {
+    max_shift += T8_FACE_MATCHING_RADIX_BITS;
+  }
+  counts = T8_ALLOC (size_t, num_buckets);
+  for (ikey = T8_ECLASS_MAX_CORNERS_2D - 1; ikey >= 0; ikey--) {
+    for (shift = 0; shift <= max_shift;
+         shift += T8_FACE_MATCHING_RADIX_BITS) {
+      memset (counts, 0, num_buckets * sizeof (size_t));
+      for (iz = 0; iz < num_records; iz++) {
+        counts[((*records)[iz].key[ikey] >> shift) & mask]++;
+      }
+      if (num_records == 0
+          || counts[((*records)[0].key[ikey] >> shift) & mask] ==
+          num_records) {
+        /* All records have the same digit */
+        continue;
+      }
+      for (iz = 0, sum = 0; iz < num_buckets; iz++) {
+        count = counts[iz];
+        counts[iz] = sum;
+        sum += count;
+      }
+      for (iz = 0; iz < num_records; iz++) {
+        (*buffer)[counts[((*records)[iz].key[ikey] >> shift) & mask]++] =
+          (*records)[iz];
+      }
+      swap = *records;
+      *records = *buffer;
+      *buffer = swap;
+    }
+  }
+  T8_FREE (counts);
+}
+
+t8_locidx_t
+t8_cmesh_face_matching_set_joins (t8_cmesh_t cmesh, t8_locidx_t num_trees,
+                                  t8_gloidx_t first_tree,
+                                  const t8_eclass_t * eclasses,
+                                  const long *tree_vertices, int stride,
+                                  int set_boundaries, int num_threads)
+{
+  t8_cmesh_face_record_t *records, *buffer, *record_a, *record_b;
+  long                face_vertices_a[T8_ECLASS_MAX_CORNERS_2D];
+  long                face_vertices_b[T8_ECLASS_MAX_CORNERS_2D];
+  size_t             *face_offsets, num_records, iz, jz;
+  unsigned long       max_key = 0;
+  t8_locidx_t         itree, num_joins = 0;
+  t8_eclass_t         class_a, class_b;
+  int                 iface, iv, orientation;
+
+  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
+  T8_ASSERT (num_trees >= 0);
+
+  /* Compute the position of the first record of each tree */
+  face_offsets = T8_ALLOC (size_t, num_trees + 1);
+  face_offsets[0] = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    face_offsets[itree + 1] = face_offsets[itree]
+      + t8_eclass_num_faces[eclasses[itree]];
+    for (iv = 0; iv < t8_eclass_num_vertices[eclasses[itree]]; iv++) {
+      max_key = SC_MAX (max_key, (unsigned long)
+                        tree_vertices[(size_t) itree * stride + iv]);
+    }
+  }
+  max_key++;
+  num_records = face_offsets[num_trees];
+  records = T8_ALLOC (t8_cmesh_face_record_t, SC_MAX (num_records, 1));
+  buffer = T8_ALLOC (t8_cmesh_face_record_t, SC_MAX (num_records, 1));
+
+  /* Generate the face records. The trees are independent. */
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp parallel for private (iface) num_threads (SC_MAX (num_threads, 1))
+#else
+  (void) num_threads;
+#endif
+  for (itree = 0; itree < num_trees; itree++) {
+    for (iface = 0; iface < t8_eclass_num_faces[eclasses[itree]]; iface++) {
+      t8_cmesh_face_record_init (records + face_offsets[itree] + iface,
+                                 eclasses[itree],
+                                 tree_vertices + (size_t) itree * stride,
+                                 itree, iface);
+    }
+  }
+  T8_FREE (face_offsets);
+
+  t8_cmesh_face_records_sort (&records, &buffer, num_records, max_key);
+  T8_FREE (buffer);
+
+  /* Faces with the same vertices are adjacent now */
+  for (iz = 0; iz < num_records; iz = jz) {
+    record_a = records + iz;
+    for (jz = iz + 1;
+         jz < num_records && t8_cmesh_face_record_equal (record_a,
+                                                         records + jz);
+         jz++) {
+    }
+    if (jz - iz == 1) {
+      if (set_boundaries) {
+        t8_cmesh_set_join (cmesh, first_tree + record_a->tree,
+                           first_tree + record_a->tree, record_a->face,
+                           record_a->face, 0);
+      }
+      continue;
+    }
+    if (jz - iz > 2) {
+      t8_global_errorf ("More than two trees share a face of tree %li\n",
+                        (long) (first_tree + record_a->tree));
+      T8_FREE (records);
+      return -1;
+    }
+    record_b = records + iz + 1;
+    class_a = eclasses[record_a->tree];
+    class_b = eclasses[record_b->tree];
+    t8_cmesh_face_record_vertices (class_a, tree_vertices + (size_t)
+                                   record_a->tree * stride, record_a->face,
+                                   face_vertices_a);
+    t8_cmesh_face_record_vertices (class_b, tree_vertices + (size_t)
+                                   record_b->tree * stride, record_b->face,
+                                   face_vertices_b);
+    orientation =
+      t8_cmesh_reader_face_orientation (class_a, record_a->tree,
+                                        face_vertices_a, class_b,
+                                        record_b->tree, face_vertices_b,
+                                        t8_eclass_num_vertices
+                                        [t8_eclass_face_types[class_a]
+                                         [record_a->face]]);
+    T8_ASSERT (orientation >= 0);
+    t8_cmesh_set_join (cmesh, first_tree + record_a->tree,
+                       first_tree + record_b->tree, record_a->face,
+                       record_b->face, orientation);
+    num_joins++;
+  }
+  T8_FREE (records);
+  return num_joins;
+}
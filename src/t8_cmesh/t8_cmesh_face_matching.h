@@ -0,0 +1,77 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_cmesh_face_matching.h
+ *
+ * Find the face connections of a set of trees that are given by the
+ * indices of their vertices.
+ *
+ * For each face of each tree a record with the sorted vertex indices of
+ * the face is written into a flat array. The array is radix sorted by the
+ * vertex indices and two faces are neighbors if they are adjacent in the
+ * sorted array and have the same vertices. This is used by the
+ * mesh file readers.
+ */
+
+#ifndef T8_CMESH_FACE_MATCHING_H
+#define T8_CMESH_FACE_MATCHING_H
+
+#include <t8.h>
+#include <t8_cmesh.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Find the face connections of trees and set them in a cmesh.
+ * \param [in,out] cmesh  An initialized but not committed cmesh.
+ * \param [in] num_trees  The number of trees.
+ * \param [in] first_tree The global id of the first tree. Tree i has the
+ *                        global id \a first_tree + i.
+ * \param [in] eclasses   The class of each tree.
+ * \param [in] tree_vertices The nonnegative vertex indices of the trees in
+ *                        t8code order. The vertices of tree i start at
+ *                        \a tree_vertices[i * \a stride]. Two trees share
+ *                        a vertex if they have the same index for it.
+ * \param [in] stride     The number of entries of \a tree_vertices per tree.
+ *                        At least the maximum number of vertices of the
+ *                        classes in \a eclasses.
+ * \param [in] set_boundaries If true, faces without neighbor are set as
+ *                        domain boundaries by joining them with themselves.
+ * \param [in] num_threads The number of threads used to generate the face
+ *                        records. Only used if t8code was configured
+ *                        with OpenMP.
+ * \return                The number of face connections that were set, or
+ *                        -1 if more than two faces have the same vertices.
+ */
+t8_locidx_t         t8_cmesh_face_matching_set_joins (t8_cmesh_t cmesh,
+                                                      t8_locidx_t num_trees,
+                                                      t8_gloidx_t first_tree,
+                                                      const t8_eclass_t *
+                                                      eclasses,
+                                                      const long
+                                                      *tree_vertices,
+                                                      int stride,
+                                                      int set_boundaries,
+                                                      int num_threads);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_CMESH_FACE_MATCHING_H */
@@ -27,10 +27,13 @@
 
 #include <t8_data/t8_shmem.h>
 #include <t8_cmesh.h>
+#include <t8_peer_volume.h>
 #include "t8_cmesh_types.h"
 #include "t8_cmesh_trees.h"
 #include "t8_cmesh_partition.h"
 #include "t8_cmesh_offset.h"
+#include "t8_cmesh_copy.h"
+#include "t8_cmesh_reader.h"
 
 #if 0
 /* Return the minimum of two t8_gloidx_t's */
@@ -1222,10 +1225,11 @@ t8_partition_compute_gnb (t8_cmesh_t cmesh_from, sc_array_t * send_as_ghost)
 }
 
 /* Compute the number of bytes that need to be allocated in the send buffer
- * for the attribute entries of all ghosts. */
+ * for the attribute entries of all ghosts.
+ * If with_attributes is false, the ghosts are sent without attributes. */
 static size_t
 t8_partition_compute_gab (t8_cmesh_t cmesh_from, sc_array_t * send_as_ghost,
-                          size_t * attr_info_bytes)
+                          int with_attributes, size_t * attr_info_bytes)
 {
   size_t              ghost_attribute_bytes = 0, ighost;
   t8_locidx_t         ghost_id, ghost_id_min_offset;
@@ -1234,6 +1238,9 @@ t8_partition_compute_gab (t8_cmesh_t cmesh_from, sc_array_t * send_as_ghost,
 
   T8_ASSERT (attr_info_bytes != NULL);
   *attr_info_bytes = 0;
+  if (!with_attributes) {
+    return 0;
+  }
   for (ighost = 0; ighost < send_as_ghost->elem_count; ighost++) {
     ghost_id = *(t8_locidx_t *) sc_array_index (send_as_ghost, ighost);
     T8_ASSERT (ghost_id >= 0);
@@ -1281,8 +1288,6 @@ t8_cmesh_send_ghost (t8_cmesh_t cmesh, const struct t8_cmesh *cmesh_from,
   t8_ctree_t          ctree = NULL;
   t8_eclass_t         eclass;
   int                 proc, iface;
-  size_t              left = 0, right = cmesh->mpirank;
-  int                 found = 0;
   t8_gloidx_t        *offset_to;
 
   offset_to = t8_shmem_array_get_gloidx_array (cmesh->tree_offsets);
@@ -1341,47 +1346,17 @@ t8_cmesh_send_ghost (t8_cmesh_t cmesh, const struct t8_cmesh *cmesh_from,
     if (t8_offset_in_range (neighbor, p, from_offsets)) {
       return 0;
     }
-    /* We perform a binary search in the offset array to find the
-     * process proc that owns the neighbor iface.
-     * We start with checking mpirank, since it is most probable.
-     */
-    found = 0;
-    proc = cmesh->mpirank;
     if (!cmesh_from->set_partition) {
       /* If the original cmesh is replicated then we already own
        * all trees */
-      found = 1;
-    }
-    left = 0, right = cmesh->mpisize;
-    while (!found) {
-      if (t8_offset_first (proc, from_offsets) + (from_offsets[proc] < 0)
-          > neighbor) {
-        /* look left */
-        right = proc;
-        proc = left + (proc - left) / 2;
-      }
-      else if (t8_offset_last (proc, from_offsets)
-               < neighbor) {
-        /* look right */
-        left = proc;
-        proc++;
-        proc += (right - proc) / 2;
-      }
-      else {
-        found = 1;
-      }
+      proc = cmesh->mpirank;
     }
-    if (cmesh_from->set_partition) {
-      /* We have to consider the special case where neighbor is owned by more
-       * than one process. We find the smallest one of them. */
-      while (neighbor == t8_offset_first (proc, from_offsets)
-             && from_offsets[proc] < 0) {
-        proc--;
-        while (t8_offset_empty (proc, from_offsets)) {
-          /* Skip empty processes */
-          proc--;
-        }
-      }
+    else {
+      /* Find the smallest process that owns the neighbor with a binary
+       * search in the offset array */
+      proc = -1;
+      proc = t8_offset_first_owner_of_tree (cmesh->mpisize, neighbor,
+                                            from_offsets, &proc);
     }
     T8_ASSERT (0 <= proc && proc < cmesh->mpisize);
     T8_ASSERT (t8_offset_in_range (neighbor, proc, from_offsets));
@@ -1642,6 +1617,10 @@ t8_cmesh_partition_copy_data (char *send_buffer, t8_cmesh_t cmesh,
       memcpy (ttf_ghost, ttf, t8_eclass_num_faces[ghost_cpy->eclass]
               * sizeof (int8_t));
     }                           /* Done distinction between from tree and from ghost */
+    if (!t8_cmesh_get_partition_ghost_attributes (cmesh)) {
+      /* The ghost is sent with its connectivity only */
+      ghost_cpy->num_attributes = num_attributes = 0;
+    }
 
     /* Compute and store new attribute offset of this ghost */
     ghosts_left = send_as_ghost->elem_count - iz;
@@ -1787,7 +1766,7 @@ t8_cmesh_partition_sendloop (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
   size_t              attr_bytes = 0, tree_neighbor_bytes,
     ghost_neighbor_bytes, attr_info_bytes, ghost_attribute_bytes,
     ghost_attr_info_bytes;
-  size_t              total_alloc;
+  size_t              total_alloc, iz;
   int                 iproc, flag;
   int                 mpiret, num_send_mpi = 0;
   char               *buffer;
@@ -1800,8 +1779,8 @@ t8_cmesh_partition_sendloop (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
   /* We use two different flag arrays here, since ghost_flag_send needs to
    * be reset for each process we send to, while ghost_flag_keep keeps is entries.
    * Otherwise we could have set bitflags and only use one array */
-  ghost_flag_send = T8_ALLOC (int8_t, cmesh_from->num_local_trees +
-                              cmesh_from->num_ghosts);
+  ghost_flag_send = T8_ALLOC_ZERO (int8_t, cmesh_from->num_local_trees +
+                                   cmesh_from->num_ghosts);
 
   sc_array_init (&send_as_ghost, sizeof (t8_locidx_t));
 
@@ -1865,9 +1844,12 @@ t8_cmesh_partition_sendloop (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
     ghost_attribute_bytes = 0;
     ghost_attr_info_bytes = 0;
 
-    memset (ghost_flag_send, 0,
-            (cmesh_from->num_local_trees + cmesh_from->num_ghosts)
-            * sizeof (int8_t)); /* Yes, i know that sizeof(int8_t) is always 1, so what?! */
+    /* Reset the flags of the ghosts that we sent to the previous process.
+     * Only these are set, so we do not need to clear the whole array. */
+    for (iz = 0; iz < send_as_ghost.elem_count; iz++) {
+      ghost_flag_send[*(t8_locidx_t *) sc_array_index (&send_as_ghost,
+                                                       iz)] = 0;
+    }
     sc_array_truncate (&send_as_ghost);
     /* loop over trees to calculate buffersize and which trees and ghosts to send */
     t8_cmesh_partition_sendtreeloop (cmesh, cmesh_from, range_start,
@@ -1910,9 +1892,10 @@ t8_cmesh_partition_sendloop (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
     ghost_neighbor_bytes = t8_partition_compute_gnb (cmesh_from,
                                                      &send_as_ghost);
     /* parse through send_as_ghost to compute ghost_attribute_bytes and attr_info_bytes */
-    ghost_attribute_bytes = t8_partition_compute_gab (cmesh_from,
-                                                      &send_as_ghost,
-                                                      &ghost_attr_info_bytes);
+    ghost_attribute_bytes =
+      t8_partition_compute_gab (cmesh_from, &send_as_ghost,
+                                t8_cmesh_get_partition_ghost_attributes
+                                (cmesh), &ghost_attr_info_bytes);
     /* Total number of bytes that we send to the other process */
     total_alloc = num_trees * sizeof (t8_ctree_struct_t) +
       num_ghost_send * sizeof (t8_cghost_struct_t) + ghost_neighbor_bytes +
@@ -1983,6 +1966,7 @@ t8_cmesh_partition_sendloop (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
                         sc_MPI_BYTE, iproc, T8_MPI_PARTITION_CMESH,
                         comm, *requests + iproc - flag - *send_first);
         SC_CHECK_MPI (mpiret);
+        t8_peer_volume_send (T8_PEER_CMESH_PARTITION, iproc, total_alloc);
         num_send_mpi++;
       }
       else {
@@ -2086,6 +2070,7 @@ t8_cmesh_partition_receive_message (t8_cmesh_t cmesh, sc_MPI_Comm comm,
                         proc_recv, T8_MPI_PARTITION_CMESH, comm,
                         sc_MPI_STATUS_IGNORE);
   SC_CHECK_MPI (mpiret);
+  t8_peer_volume_receive (T8_PEER_CMESH_PARTITION, proc_recv, recv_bytes);
   /* Read num trees and num ghosts */
   recv_part->num_trees =
     *((t8_locidx_t *) (recv_part->first_tree + recv_bytes -
@@ -2412,6 +2397,7 @@ t8_cmesh_partition_recvloop (t8_cmesh_t cmesh,
   T8_FREE (local_procid);
 }
 
+#ifdef T8_ENABLE_DEBUG
 static void
 t8_cmesh_partition_debug_listprocs (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
                                     sc_MPI_Comm comm, int *fs, int *ls,
@@ -2460,6 +2446,7 @@ t8_cmesh_partition_debug_listprocs (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
   }
   t8_debugf ("I receive from: %s\n", out);
 }
+#endif
 
 /* Given an initial cmesh (cmesh_from) and a new partition table (tree_offset)
  * create the new partition on the destination cmesh (cmesh) */
@@ -2499,10 +2486,15 @@ t8_cmesh_partition_given (t8_cmesh_t cmesh, const struct t8_cmesh *cmesh_from,
   cmesh->first_tree = t8_offset_first (cmesh->mpirank, tree_offset);
   cmesh->num_local_trees = t8_offset_num_trees (cmesh->mpirank, tree_offset);
 
+  fs = ls = fr = lr = -1;
+#ifdef T8_ENABLE_DEBUG
+  /* The lists are computed by a loop over all processes and are only
+   * used to check the send and receive ranges */
   if (cmesh_from->set_partition) {
     t8_cmesh_partition_debug_listprocs (cmesh, (t8_cmesh_t) cmesh_from, comm,
                                         &fs, &ls, &fr, &lr);
   }
+#endif
 
   /*********************************************/
   /*        Done with setup                    */
@@ -2593,6 +2585,7 @@ t8_cmesh_partition (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   /* If profiling is enabled, we measure the runtime of this routine. */
   if (cmesh->profile != NULL) {
     cmesh->profile->partition_runtime = sc_MPI_Wtime ();
+    t8_counters_start (cmesh->profile->partition_counters);
   }
   cmesh_from = (t8_cmesh_t) cmesh->set_from;
   cmesh->num_trees = cmesh_from->num_trees;
@@ -2604,9 +2597,11 @@ t8_cmesh_partition (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   if (cmesh->set_partition_level >= 0) {
     /* Compute first and last tree index */
     T8_ASSERT (cmesh->tree_offsets == NULL);
-    t8_cmesh_uniform_bounds (cmesh_from, cmesh->set_partition_level,
-                             &cmesh->first_tree, NULL, &last_tree, NULL,
-                             &cmesh->first_tree_shared);
+    t8_cmesh_uniform_bounds_costs (cmesh_from, cmesh->set_partition_level,
+                                   t8_cmesh_get_partition_eclass_costs
+                                   (cmesh), comm, &cmesh->first_tree, NULL,
+                                   &last_tree, NULL,
+                                   &cmesh->first_tree_shared);
     cmesh->num_local_trees = last_tree - cmesh->first_tree + 1;
     /* Compute the tree offset */
     t8_cmesh_gather_treecount_nocommit (cmesh, comm);
@@ -2637,12 +2632,30 @@ t8_cmesh_partition (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   /***************************************************/
   /*        Done with local num and tree_offset      */
   /***************************************************/
-  t8_cmesh_partition_given (cmesh, cmesh->set_from, tree_offsets, comm);
+  if (cmesh_from->set_partition && cmesh->face_knowledge ==
+      cmesh_from->face_knowledge
+      && !memcmp (tree_offsets,
+                  t8_shmem_array_get_gloidx_array (cmesh_from->tree_offsets),
+                  (cmesh->mpisize + 1) * sizeof (t8_gloidx_t))) {
+    /* The partition does not change. Each process keeps its trees and
+     * ghosts, which we share with cmesh_from instead of sending them.
+     * Since the partition tables are the same on all processes, all
+     * processes take this branch. */
+    t8_debugf ("Partition is unchanged, sharing the trees.\n");
+    cmesh->first_tree = t8_offset_first (cmesh->mpirank, tree_offsets);
+    t8_cmesh_share_trees (cmesh, cmesh_from);
+    T8_ASSERT (cmesh->num_local_trees ==
+               t8_offset_num_trees (cmesh->mpirank, tree_offsets));
+  }
+  else {
+    t8_cmesh_partition_given (cmesh, cmesh->set_from, tree_offsets, comm);
+  }
   /* If profiling is enabled, we measure the runtime of this routine. */
   if (cmesh->profile) {
     /* Runtime = current_time - start_time */
     cmesh->profile->partition_runtime = sc_MPI_Wtime ()
       - cmesh->profile->partition_runtime;
+    t8_counters_stop (cmesh->profile->partition_counters);
   }
   t8_global_productionf ("Done cmesh partition\n");
 }
@@ -2715,6 +2728,37 @@ t8_cmesh_offset_concentrate (int proc, sc_MPI_Comm comm,
   return shmem_array;
 }
 
+/* Create a uniform partition without shared trees */
+t8_shmem_array_t
+t8_cmesh_offset_uniform (sc_MPI_Comm comm, t8_gloidx_t num_trees)
+{
+  int                 mpiret, mpisize, iproc;
+  t8_shmem_array_t    shmem_array;
+  t8_gloidx_t        *offsets, quotient, remainder;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  t8_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
+  shmem_array = t8_cmesh_alloc_offsets (mpisize, comm);
+  if (t8_shmem_array_start_writing (shmem_array)) {
+    offsets = t8_shmem_array_get_gloidx_array (shmem_array);
+    quotient = num_trees / mpisize;
+    remainder = num_trees % mpisize;
+    for (iproc = 0; iproc <= mpisize; iproc++) {
+      /* This is iproc * num_trees / mpisize without overflowing
+       * the product */
+      offsets[iproc] = iproc * quotient + (iproc * remainder) / mpisize;
+    }
+  }
+  t8_shmem_array_end_writing (shmem_array);
+
+  T8_ASSERT (t8_offset_consistent (mpisize,
+                                   t8_shmem_array_get_gloidx_array
+                                   (shmem_array), num_trees));
+  return shmem_array;
+}
+
 /* Create a random partition */
 /* if shared is nonzero than first trees can be shared */
 t8_shmem_array_t
@@ -2871,3 +2915,182 @@ t8_cmesh_offset_half (t8_cmesh_t cmesh, sc_MPI_Comm comm)
 {
   return t8_cmesh_offset_percent (cmesh, comm, 50);
 }
+
+void
+t8_cmesh_free_ghost_fetched (t8_cmesh_t cmesh)
+{
+  t8_cmesh_ghost_fetched_t *fetched;
+  size_t              ifetched;
+
+  T8_ASSERT (cmesh->ghost_fetched != NULL);
+  for (ifetched = 0; ifetched < cmesh->ghost_fetched->elem_count;
+       ifetched++) {
+    fetched = (t8_cmesh_ghost_fetched_t *)
+      sc_array_index (cmesh->ghost_fetched, ifetched);
+    T8_FREE (fetched->offsets);
+    T8_FREE (fetched->sizes);
+    T8_FREE (fetched->data);
+  }
+  sc_array_destroy (cmesh->ghost_fetched);
+  cmesh->ghost_fetched = NULL;
+}
+
+/* Return the storage of a fetched ghost attribute.
+ * If it does not exist yet, an empty entry is added. */
+static t8_cmesh_ghost_fetched_t *
+t8_cmesh_ghost_fetched_entry (t8_cmesh_t cmesh, int package_id, int key)
+{
+  t8_cmesh_ghost_fetched_t *fetched;
+  size_t              ifetched;
+
+  if (cmesh->ghost_fetched == NULL) {
+    cmesh->ghost_fetched = sc_array_new (sizeof (t8_cmesh_ghost_fetched_t));
+  }
+  for (ifetched = 0; ifetched < cmesh->ghost_fetched->elem_count;
+       ifetched++) {
+    fetched = (t8_cmesh_ghost_fetched_t *)
+      sc_array_index (cmesh->ghost_fetched, ifetched);
+    if (fetched->package_id == package_id && fetched->key == key) {
+      /* Replace the previously fetched values */
+      T8_FREE (fetched->offsets);
+      T8_FREE (fetched->sizes);
+      T8_FREE (fetched->data);
+      return fetched;
+    }
+  }
+  fetched = (t8_cmesh_ghost_fetched_t *) sc_array_push (cmesh->ghost_fetched);
+  fetched->package_id = package_id;
+  fetched->key = key;
+  return fetched;
+}
+
+void
+t8_cmesh_fetch_ghost_attribute (t8_cmesh_t cmesh, int package_id, int key,
+                                sc_MPI_Comm comm)
+{
+  t8_cmesh_ghost_fetched_t *fetched;
+  sc_array_t         *send, *requested, recv, replies;
+  t8_gloidx_t        *offsets, gtree_id;
+  t8_locidx_t         ighost, ltree_id;
+  int                 mpisize, mpirank, irank, owner, some_owner, mpiret;
+  int                *recv_counts;
+  size_t              iz, num_requests, attr_size, total_size, pos;
+  void               *attribute;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (t8_cmesh_comm_is_valid (cmesh, comm));
+
+  if (!cmesh->set_partition) {
+    /* A replicated cmesh has no ghosts */
+    return;
+  }
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  t8_cmesh_gather_treecount (cmesh, comm);
+  offsets = t8_shmem_array_get_gloidx_array (cmesh->tree_offsets);
+
+  /* Request each ghost without the attribute from the first owner of its
+   * tree. requested[p] stores the ghosts that we ask process p for. */
+  send = T8_ALLOC (sc_array_t, 2 * mpisize);
+  requested = send + mpisize;
+  for (irank = 0; irank < mpisize; irank++) {
+    sc_array_init (&send[irank], sizeof (t8_gloidx_t));
+    sc_array_init (&requested[irank], sizeof (t8_locidx_t));
+  }
+  for (ighost = 0; ighost < cmesh->num_ghosts; ighost++) {
+    if (t8_cmesh_trees_get_attribute (cmesh->trees, ighost, package_id, key,
+                                      NULL, 1) != NULL) {
+      /* The ghost was shipped with this attribute */
+      continue;
+    }
+    gtree_id = t8_cmesh_get_global_id (cmesh,
+                                       cmesh->num_local_trees + ighost);
+    some_owner = -1;
+    owner = t8_offset_first_owner_of_tree (mpisize, gtree_id, offsets,
+                                           &some_owner);
+    T8_ASSERT (owner != mpirank);
+    *(t8_gloidx_t *) sc_array_push (&send[owner]) = gtree_id;
+    *(t8_locidx_t *) sc_array_push (&requested[owner]) = ighost;
+  }
+  recv_counts = T8_ALLOC (int, mpisize);
+  sc_array_init (&recv, sizeof (t8_gloidx_t));
+  t8_cmesh_reader_exchange (send, &recv, recv_counts, mpisize, comm);
+
+  /* Answer each request with the size of the attribute followed by its
+   * values. The attribute is missing if the size is zero. */
+  t8_cmesh_reader_exchange_reinit (send, 1, mpisize);
+  pos = 0;
+  for (irank = 0; irank < mpisize; irank++) {
+    for (iz = 0; iz < (size_t) recv_counts[irank]; iz++, pos++) {
+      gtree_id = *(t8_gloidx_t *) sc_array_index (&recv, pos);
+      ltree_id = (t8_locidx_t) (gtree_id - cmesh->first_tree);
+      T8_ASSERT (0 <= ltree_id && ltree_id < cmesh->num_local_trees);
+      attr_size = 0;
+      attribute = t8_cmesh_trees_get_attribute (cmesh->trees, ltree_id,
+                                                package_id, key, &attr_size,
+                                                0);
+      if (attribute == NULL) {
+        attr_size = 0;
+      }
+      memcpy (sc_array_push_count (&send[irank], sizeof (size_t)),
+              &attr_size, sizeof (size_t));
+      if (attr_size > 0) {
+        memcpy (sc_array_push_count (&send[irank], attr_size), attribute,
+                attr_size);
+      }
+    }
+  }
+  sc_array_reset (&recv);
+  sc_array_init (&replies, 1);
+  t8_cmesh_reader_exchange (send, &replies, recv_counts, mpisize, comm);
+
+  /* The replies of each process arrive in the order of our requests.
+   * We parse them twice, first for the sizes and then for the values. */
+  fetched = t8_cmesh_ghost_fetched_entry (cmesh, package_id, key);
+  fetched->offsets = T8_ALLOC (size_t, cmesh->num_ghosts + 1);
+  fetched->sizes = T8_ALLOC_ZERO (size_t, SC_MAX (cmesh->num_ghosts, 1));
+  pos = 0;
+  for (irank = 0; irank < mpisize; irank++) {
+    num_requests = requested[irank].elem_count;
+    for (iz = 0; iz < num_requests; iz++) {
+      ighost = *(t8_locidx_t *) sc_array_index (&requested[irank], iz);
+      memcpy (&attr_size, sc_array_index (&replies, pos), sizeof (size_t));
+      fetched->sizes[ighost] = attr_size;
+      pos += sizeof (size_t) + attr_size;
+    }
+  }
+  T8_ASSERT (pos == replies.elem_count);
+  total_size = 0;
+  for (ighost = 0; ighost < cmesh->num_ghosts; ighost++) {
+    fetched->offsets[ighost] = total_size;
+    total_size += fetched->sizes[ighost]
+      + T8_ADD_PADDING (fetched->sizes[ighost]);
+  }
+  fetched->offsets[cmesh->num_ghosts] = total_size;
+  fetched->data = T8_ALLOC (char, SC_MAX (total_size, 1));
+  pos = 0;
+  for (irank = 0; irank < mpisize; irank++) {
+    num_requests = requested[irank].elem_count;
+    for (iz = 0; iz < num_requests; iz++) {
+      ighost = *(t8_locidx_t *) sc_array_index (&requested[irank], iz);
+      attr_size = fetched->sizes[ighost];
+      pos += sizeof (size_t);
+      if (attr_size > 0) {
+        memcpy (fetched->data + fetched->offsets[ighost],
+                sc_array_index (&replies, pos), attr_size);
+      }
+      pos += attr_size;
+    }
+  }
+  t8_debugf ("Fetched %zd bytes of ghost attributes\n", total_size);
+
+  sc_array_reset (&replies);
+  for (irank = 0; irank < mpisize; irank++) {
+    sc_array_reset (&send[irank]);
+    sc_array_reset (&requested[irank]);
+  }
+  T8_FREE (send);
+  T8_FREE (recv_counts);
+}
@@ -90,6 +90,18 @@ void                t8_cmesh_offset_print (t8_cmesh_t cmesh,
 t8_shmem_array_t    t8_cmesh_offset_concentrate (int proc, sc_MPI_Comm comm,
                                                  t8_gloidx_t num_trees);
 
+/** Create the partition table of a uniform partition without shared trees.
+ * Process p gets the trees p * num_trees / P up to
+ * (p + 1) * num_trees / P - 1, where P is the size of \a comm.
+ * The table is computed on each process without communication.
+ * \param[in]        comm    The communicator to use.
+ * \param[in]        num_trees The number of global trees in the partition.
+ * \return                   A valid partition table for a cmesh with \a num_trees trees
+ *                           and communicator \a comm.
+ */
+t8_shmem_array_t    t8_cmesh_offset_uniform (sc_MPI_Comm comm,
+                                             t8_gloidx_t num_trees);
+
 /** Create a random partition table.
  * The use of this function is only reasonable for debugging.
  * \param[in]        comm    The communicator to use.
@@ -127,6 +139,13 @@ t8_shmem_array_t    t8_cmesh_offset_half (t8_cmesh_t cmesh, sc_MPI_Comm comm);
 t8_shmem_array_t    t8_cmesh_offset_percent (t8_cmesh_t cmesh,
                                              sc_MPI_Comm comm, int percent);
 
+/** Free the ghost attributes that were fetched with
+ * \ref t8_cmesh_fetch_ghost_attribute.
+ * \param [in,out]  cmesh   A cmesh with fetched ghost attributes.
+ *                          On output its ghost_fetched array is NULL.
+ */
+void                t8_cmesh_free_ghost_fetched (t8_cmesh_t cmesh);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_CMESH_PARTITION_H */
@@ -0,0 +1,780 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "t8_cmesh_reader.h"
+#include "t8_cmesh_types.h"
+#if defined (T8_HAVE_MMAP) && defined (T8_HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* The parallel reader works as follows.
+ * The nodes are sent to a directory process, which is the node index
+ * modulo the number of processes. Each process requests the coordinates of
+ * the vertices of its trees from the directory. The faces of the trees are
+ * sent to a process determined by a hash of their vertices, which matches
+ * the faces and sends each face connection to the processes of both trees.
+ * These processes add the neighbor trees of other processes as ghosts. */
+
+/* A tree face of the parallel reader */
+typedef struct
+{
+  /* The sorted vertex indices, unused entries are -1 */
+  long                key[T8_ECLASS_MAX_CORNERS_2D];
+  /* The vertex indices in face order */
+  long                vertices[T8_ECLASS_MAX_CORNERS_2D];
+  t8_gloidx_t         gtree_id; /* The global id of the tree */
+  int8_t              face_number;      /* The face number in the tree */
+  int8_t              eclass;   /* The class of the tree */
+  int8_t              num_vertices;     /* The number of face vertices */
+} t8_cmesh_reader_face_t;
+
+/* A face connection of the parallel reader */
+typedef struct
+{
+  t8_gloidx_t         gtree_id[2];
+  int8_t              face[2];
+  int8_t              eclass[2];
+  int8_t              orientation;
+} t8_cmesh_reader_join_t;
+
+/* A ghost tree of the parallel reader */
+typedef struct
+{
+  t8_gloidx_t         gtree_id;
+  int8_t              eclass;
+} t8_cmesh_reader_ghost_t;
+
+static int
+t8_cmesh_reader_long_compare (const void *a, const void *b)
+{
+  const long          la = *(const long *) a, lb = *(const long *) b;
+
+  return la < lb ? -1 : la > lb;
+}
+
+int
+t8_cmesh_reader_node_compare (const void *a, const void *b)
+{
+  const long          ia = ((const t8_cmesh_reader_node_t *) a)->index;
+  const long          ib = ((const t8_cmesh_reader_node_t *) b)->index;
+
+  return ia < ib ? -1 : ia > ib;
+}
+
+static int
+t8_cmesh_reader_face_compare (const void *a, const void *b)
+{
+  const t8_cmesh_reader_face_t *face_a = (const t8_cmesh_reader_face_t *) a;
+  const t8_cmesh_reader_face_t *face_b = (const t8_cmesh_reader_face_t *) b;
+  int                 iv;
+
+  for (iv = 0; iv < T8_ECLASS_MAX_CORNERS_2D; iv++) {
+    if (face_a->key[iv] != face_b->key[iv]) {
+      return face_a->key[iv] < face_b->key[iv] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+static int
+t8_cmesh_reader_ghost_compare (const void *a, const void *b)
+{
+  const t8_gloidx_t   ga = ((const t8_cmesh_reader_ghost_t *) a)->gtree_id;
+  const t8_gloidx_t   gb = ((const t8_cmesh_reader_ghost_t *) b)->gtree_id;
+
+  return ga < gb ? -1 : ga > gb;
+}
+
+/* The entries of an exchange are sent as items of elem_size bytes. Thus the
+ * int counts and displacements of MPI count entries and not bytes.
+ * We abort if the entries of one process do not fit into these counts. */
+/* Order face connections by the first tree and its face. The faces are
+ * matched only once, so this identifies a connection. */
+static int
+t8_cmesh_reader_join_compare (const void *a, const void *b)
+{
+  const t8_cmesh_reader_join_t *join_a = (const t8_cmesh_reader_join_t *) a;
+  const t8_cmesh_reader_join_t *join_b = (const t8_cmesh_reader_join_t *) b;
+
+  if (join_a->gtree_id[0] != join_b->gtree_id[0]) {
+    return join_a->gtree_id[0] < join_b->gtree_id[0] ? -1 : 1;
+  }
+  return join_a->face[0] < join_b->face[0] ? -1 : join_a->face[0] >
+    join_b->face[0];
+}
+
+void
+t8_cmesh_reader_exchange (sc_array_t * send, sc_array_t * recv,
+                          int *recv_counts, int mpisize, sc_MPI_Comm comm)
+{
+  const size_t        elem_size = recv->elem_size;
+  int                *send_counts, *send_displs, *rcounts, *recv_displs;
+  int                 irank;
+  size_t              total_send = 0, total_recv = 0;
+  char               *sendbuf;
+#ifdef SC_ENABLE_MPI
+  MPI_Datatype        item;
+  int                 mpiret;
+#endif
+
+  T8_ASSERT (elem_size > 0 && elem_size <= INT_MAX);
+  send_counts = T8_ALLOC (int, 4 * mpisize);
+  send_displs = send_counts + mpisize;
+  rcounts = send_displs + mpisize;
+  recv_displs = rcounts + mpisize;
+  for (irank = 0; irank < mpisize; irank++) {
+    T8_ASSERT (send[irank].elem_size == elem_size);
+    send_counts[irank] = (int) send[irank].elem_count;
+    send_displs[irank] = (int) total_send;
+    total_send += send[irank].elem_count;
+  }
+  SC_CHECK_ABORT (total_send <= INT_MAX,
+                  "Too many entries to send in a mesh file exchange.");
+  sendbuf = T8_ALLOC (char, SC_MAX (total_send * elem_size, 1));
+  for (irank = 0; irank < mpisize; irank++) {
+    if (send_counts[irank] > 0) {
+      memcpy (sendbuf + (size_t) send_displs[irank] * elem_size,
+              send[irank].array, send[irank].elem_count * elem_size);
+    }
+  }
+#ifdef SC_ENABLE_MPI
+  mpiret = MPI_Alltoall (send_counts, 1, MPI_INT, rcounts, 1, MPI_INT,
+                         comm);
+  SC_CHECK_MPI (mpiret);
+#else
+  T8_ASSERT (mpisize == 1);
+  rcounts[0] = send_counts[0];
+#endif
+  for (irank = 0; irank < mpisize; irank++) {
+    recv_displs[irank] = (int) total_recv;
+    total_recv += rcounts[irank];
+    if (recv_counts != NULL) {
+      recv_counts[irank] = rcounts[irank];
+    }
+  }
+  SC_CHECK_ABORT (total_recv <= INT_MAX,
+                  "Too many entries to receive in a mesh file exchange.");
+  sc_array_resize (recv, total_recv);
+#ifdef SC_ENABLE_MPI
+  mpiret = MPI_Type_contiguous ((int) elem_size, MPI_BYTE, &item);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_commit (&item);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Alltoallv (sendbuf, send_counts, send_displs, item,
+                          recv->array, rcounts, recv_displs, item, comm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_free (&item);
+  SC_CHECK_MPI (mpiret);
+#else
+  if (total_recv > 0) {
+    memcpy (recv->array, sendbuf, total_recv * elem_size);
+  }
+#endif
+  T8_FREE (sendbuf);
+  T8_FREE (send_counts);
+}
+
+void
+t8_cmesh_reader_exchange_reinit (sc_array_t * send, size_t elem_size,
+                                 int mpisize)
+{
+  int                 irank;
+
+  for (irank = 0; irank < mpisize; irank++) {
+    sc_array_reset (&send[irank]);
+    sc_array_init (&send[irank], elem_size);
+  }
+}
+
+/* Return true on all processes if ok is true on all processes */
+int
+t8_cmesh_reader_all_ok (int ok, sc_MPI_Comm comm)
+{
+  int                 all_ok, mpiret;
+
+  mpiret = sc_MPI_Allreduce (&ok, &all_ok, 1, sc_MPI_INT, sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  return all_ok;
+}
+
+/* Map a file into memory. If mmap is not available, the file is read
+ * into a buffer instead. Return 0 on success. */
+int
+t8_cmesh_reader_file_map (const char *filename,
+                          t8_cmesh_reader_file_t * map)
+{
+  FILE               *fp;
+  long                size;
+
+  map->data = NULL;
+  map->size = 0;
+  map->is_mapped = 0;
+#if defined (T8_HAVE_MMAP) && defined (T8_HAVE_SYS_MMAN_H)
+  {
+    int                 fd;
+    struct stat         st;
+
+    fd = open (filename, O_RDONLY);
+    if (fd < 0) {
+      return -1;
+    }
+    if (fstat (fd, &st) || st.st_size <= 0) {
+      close (fd);
+      return -1;
+    }
+    map->data = (char *) mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+                               fd, 0);
+    /* The mapping stays valid after the file is closed */
+    close (fd);
+    if (map->data != MAP_FAILED) {
+      map->size = st.st_size;
+      map->is_mapped = 1;
+      return 0;
+    }
+    map->data = NULL;
+  }
+#endif
+  fp = fopen (filename, "rb");
+  if (fp == NULL) {
+    return -1;
+  }
+  fseek (fp, 0, SEEK_END);
+  size = ftell (fp);
+  fseek (fp, 0, SEEK_SET);
+  if (size <= 0) {
+    fclose (fp);
+    return -1;
+  }
+  map->data = T8_ALLOC (char, size);
+  map->size = size;
+  if (fread (map->data, 1, size, fp) != (size_t) size) {
+    fclose (fp);
+    T8_FREE (map->data);
+    map->data = NULL;
+    return -1;
+  }
+  fclose (fp);
+  return 0;
+}
+
+/* Free a view of a file that was created with t8_cmesh_reader_file_map */
+void
+t8_cmesh_reader_file_unmap (t8_cmesh_reader_file_t * map)
+{
+#if defined (T8_HAVE_MMAP) && defined (T8_HAVE_SYS_MMAN_H)
+  if (map->is_mapped) {
+    munmap (map->data, map->size);
+    map->data = NULL;
+    return;
+  }
+#endif
+  T8_FREE (map->data);
+  map->data = NULL;
+}
+
+/* Position a file at the first line that starts in the part of the bytes
+ * [begin, end) that this process reads and return the end of this part. */
+long
+t8_cmesh_reader_seek_range (FILE * fp, long begin, long end, int mpirank,
+                            int mpisize, char **line, size_t * linen)
+{
+  const long          length = end - begin;
+  long                my_begin, my_end;
+
+  my_begin = begin + length / mpisize * mpirank
+    + SC_MIN (mpirank, length % mpisize);
+  my_end = begin + length / mpisize * (mpirank + 1)
+    + SC_MIN (mpirank + 1, length % mpisize);
+  if (my_begin > begin) {
+    /* Skip the rest of the line that contains the byte before our range.
+     * This line belongs to the previous process. */
+    fseek (fp, my_begin - 1, SEEK_SET);
+    (void) getline (line, linen, fp);
+  }
+  else {
+    fseek (fp, begin, SEEK_SET);
+  }
+  return my_end;
+}
+
+/* Return the process that the face with given sorted vertices is sent to */
+static int
+t8_cmesh_reader_face_process (const long key[T8_ECLASS_MAX_CORNERS_2D],
+                              int mpisize)
+{
+  unsigned long       hash = 0;
+  int                 iv;
+
+  for (iv = 0; iv < T8_ECLASS_MAX_CORNERS_2D; iv++) {
+    hash = hash * 2654435761ul + (unsigned long) key[iv];
+  }
+  return (int) (hash % (unsigned long) mpisize);
+}
+
+/* Return the process that owns a tree given the first tree of each process */
+static int
+t8_cmesh_reader_tree_owner (const t8_gloidx_t * first_trees, int mpisize,
+                            t8_gloidx_t gtree_id)
+{
+  int                 low = 0, high = mpisize - 1, mid;
+
+  /* Find the last process whose first tree is not bigger than gtree_id.
+   * Empty processes before it have the same first tree. */
+  while (low < high) {
+    mid = (low + high + 1) / 2;
+    if (first_trees[mid] <= gtree_id) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  return low;
+}
+
+/* If the vertices of a tree describe a negative volume, switch the
+ * coordinates and the indices of vertex 0 and vertex 1. */
+void
+t8_cmesh_reader_correct_volume (t8_cmesh_reader_tree_t * tree,
+                                double *tree_vertices, t8_gloidx_t gtree_id)
+{
+  const int           num_vertices = t8_eclass_num_vertices[tree->eclass];
+  double              temp;
+  long                index;
+  int                 i;
+
+  if (t8_cmesh_tree_vertices_negative_volume ((t8_eclass_t) tree->eclass,
+                                              tree_vertices, num_vertices)) {
+    T8_ASSERT (t8_eclass_to_dimension[tree->eclass] == 3);
+    t8_debugf ("Correcting negative volume of tree %li\n", (long) gtree_id);
+    for (i = 0; i < 3; i++) {
+      temp = tree_vertices[i];
+      tree_vertices[i] = tree_vertices[3 + i];
+      tree_vertices[3 + i] = temp;
+    }
+    index = tree->vertices[0];
+    tree->vertices[0] = tree->vertices[1];
+    tree->vertices[1] = index;
+  }
+}
+
+int
+t8_cmesh_reader_face_orientation (t8_eclass_t eclass_a, t8_gloidx_t gtree_a,
+                                  const long *face_vertices_a,
+                                  t8_eclass_t eclass_b, t8_gloidx_t gtree_b,
+                                  const long *face_vertices_b,
+                                  int num_face_vertices)
+{
+  const long         *smaller, *bigger;
+  int                 compare, iv;
+
+  compare = t8_eclass_compare (eclass_a, eclass_b);
+  if (compare < 0 || (compare == 0 && gtree_a < gtree_b)) {
+    smaller = face_vertices_a;
+    bigger = face_vertices_b;
+  }
+  else {
+    smaller = face_vertices_b;
+    bigger = face_vertices_a;
+  }
+  for (iv = 0; iv < num_face_vertices; iv++) {
+    if (bigger[iv] == smaller[0]) {
+      return iv;
+    }
+  }
+  SC_ABORT_NOT_REACHED ();
+  return -1;
+}
+
+t8_cmesh_t
+t8_cmesh_reader_build (sc_array_t * nodes, sc_array_t * trees, int dim,
+                       sc_MPI_Comm comm, int do_dup)
+{
+  int                 mpirank, mpisize, mpiret, ok = 1, irank;
+  int                *recv_counts;
+  t8_cmesh_t          cmesh = NULL;
+  long                index;
+  size_t              iz, jz, num_needed, first;
+  t8_cmesh_reader_node_t node, *pnode;
+  t8_cmesh_reader_tree_t *ptree;
+  t8_cmesh_reader_face_t pface, *face_a, *face_b;
+  t8_cmesh_reader_join_t join, *pjoin;
+  t8_cmesh_reader_ghost_t *pghost;
+  sc_array_t         *send, directory, needed, coords, faces;
+  sc_array_t          joins, ghosts;
+  t8_gloidx_t         num_local_trees, first_tree, *first_trees;
+  t8_eclass_t         face_class;
+  double              tree_vertices[3 * T8_ECLASS_MAX_CORNERS];
+  int                 eclass, num_vertices, iv, iface;
+  int                 owner_a, owner_b, ilocal;
+  sc_MPI_Comm         exchange_comm = comm;
+  int                *ghost_ranks, *ranks;
+
+  T8_ASSERT (nodes->elem_size == sizeof (t8_cmesh_reader_node_t));
+  T8_ASSERT (trees->elem_size == sizeof (t8_cmesh_reader_tree_t));
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  if (do_dup) {
+    /* The messages of the reader do not interfere with those of the
+     * caller. The cmesh is committed with comm. */
+    mpiret = sc_MPI_Comm_dup (comm, &exchange_comm);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  send = T8_ALLOC (sc_array_t, mpisize);
+  recv_counts = T8_ALLOC (int, mpisize);
+  first_trees = T8_ALLOC (t8_gloidx_t, mpisize);
+  sc_array_init (&directory, sizeof (t8_cmesh_reader_node_t));
+  sc_array_init (&needed, sizeof (long));
+  sc_array_init (&coords, 3 * sizeof (double));
+  sc_array_init (&faces, sizeof (t8_cmesh_reader_face_t));
+  sc_array_init (&joins, sizeof (t8_cmesh_reader_join_t));
+  sc_array_init (&ghosts, sizeof (t8_cmesh_reader_ghost_t));
+
+  /* Send each node to its directory, which is its index modulo the
+   * number of processes */
+  for (irank = 0; irank < mpisize; irank++) {
+    sc_array_init (&send[irank], sizeof (t8_cmesh_reader_node_t));
+  }
+  for (iz = 0; iz < nodes->elem_count; iz++) {
+    pnode = (t8_cmesh_reader_node_t *) sc_array_index (nodes, iz);
+    if (pnode->index < 0) {
+      ok = 0;
+      break;
+    }
+    *(t8_cmesh_reader_node_t *)
+      sc_array_push (&send[pnode->index % mpisize]) = *pnode;
+  }
+  sc_array_reset (nodes);
+  ok = t8_cmesh_reader_all_ok (ok, exchange_comm);
+  if (!ok) {
+    t8_global_errorf ("Invalid node index in a mesh file\n");
+    goto die_parallel;
+  }
+  t8_cmesh_reader_exchange (send, &directory, NULL, mpisize, exchange_comm);
+  sc_array_sort (&directory, t8_cmesh_reader_node_compare);
+
+  /* The trees are numbered in the order of the file */
+  num_local_trees = trees->elem_count;
+  mpiret = sc_MPI_Scan (&num_local_trees, &first_tree, 1, T8_MPI_GLOIDX,
+                        sc_MPI_SUM, exchange_comm);
+  SC_CHECK_MPI (mpiret);
+  first_tree -= num_local_trees;
+  mpiret = sc_MPI_Allgather (&first_tree, 1, T8_MPI_GLOIDX, first_trees, 1,
+                             T8_MPI_GLOIDX, exchange_comm);
+  SC_CHECK_MPI (mpiret);
+
+  /* Request the coordinates of the vertices of our trees from their
+   * directories */
+  for (iz = 0; iz < trees->elem_count; iz++) {
+    ptree = (t8_cmesh_reader_tree_t *) sc_array_index (trees, iz);
+    for (iv = 0; iv < t8_eclass_num_vertices[ptree->eclass]; iv++) {
+      *(long *) sc_array_push (&needed) = ptree->vertices[iv];
+    }
+  }
+  sc_array_sort (&needed, t8_cmesh_reader_long_compare);
+  sc_array_uniq (&needed, t8_cmesh_reader_long_compare);
+  num_needed = needed.elem_count;
+  t8_cmesh_reader_exchange_reinit (send, sizeof (long), mpisize);
+  for (iz = 0; iz < num_needed; iz++) {
+    index = *(long *) sc_array_index (&needed, iz);
+    if (index < 0) {
+      ok = 0;
+      break;
+    }
+    *(long *) sc_array_push (&send[index % mpisize]) = index;
+  }
+  ok = t8_cmesh_reader_all_ok (ok, exchange_comm);
+  if (!ok) {
+    t8_global_errorf ("Invalid node index in a mesh file\n");
+    goto die_parallel;
+  }
+  {
+    sc_array_t          requests;
+
+    sc_array_init (&requests, sizeof (long));
+    t8_cmesh_reader_exchange (send, &requests, recv_counts, mpisize,
+                              exchange_comm);
+    t8_cmesh_reader_exchange_reinit (send, 3 * sizeof (double), mpisize);
+    /* Answer the requests in the order in which we received them */
+    first = 0;
+    for (irank = 0; irank < mpisize; irank++) {
+      for (iz = first; iz < first + recv_counts[irank]; iz++) {
+        node.index = *(long *) sc_array_index (&requests, iz);
+        jz = sc_array_bsearch (&directory, &node,
+                               t8_cmesh_reader_node_compare);
+        if (jz == (size_t) - 1) {
+          t8_errorf ("Node %li is not in the file.\n", node.index);
+          ok = 0;
+          memset (sc_array_push (&send[irank]), 0, 3 * sizeof (double));
+          continue;
+        }
+        pnode = (t8_cmesh_reader_node_t *) sc_array_index (&directory, jz);
+        memcpy (sc_array_push (&send[irank]), pnode->coordinates,
+                3 * sizeof (double));
+      }
+      first += recv_counts[irank];
+    }
+    sc_array_reset (&requests);
+    sc_array_reset (&directory);
+  }
+  {
+    sc_array_t          answers;
+    size_t             *cursor;
+
+    sc_array_init (&answers, 3 * sizeof (double));
+    t8_cmesh_reader_exchange (send, &answers, recv_counts, mpisize,
+                              exchange_comm);
+    /* The answers of each directory are in the order of our requests
+     * to it. We sort them into the order of needed. */
+    cursor = T8_ALLOC (size_t, mpisize);
+    first = 0;
+    for (irank = 0; irank < mpisize; irank++) {
+      cursor[irank] = first;
+      first += recv_counts[irank];
+    }
+    sc_array_resize (&coords, num_needed);
+    for (iz = 0; iz < num_needed; iz++) {
+      irank = *(long *) sc_array_index (&needed, iz) % mpisize;
+      memcpy (sc_array_index (&coords, iz),
+              sc_array_index (&answers, cursor[irank]++),
+              3 * sizeof (double));
+    }
+    T8_FREE (cursor);
+    sc_array_reset (&answers);
+  }
+  ok = t8_cmesh_reader_all_ok (ok, exchange_comm);
+  if (!ok) {
+    goto die_parallel;
+  }
+
+  /* Add our trees to the cmesh and send their faces to the
+   * processes that match them */
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_dimension (cmesh, dim);
+  t8_cmesh_reader_exchange_reinit (send, sizeof (t8_cmesh_reader_face_t),
+                                   mpisize);
+  for (iz = 0; iz < trees->elem_count; iz++) {
+    ptree = (t8_cmesh_reader_tree_t *) sc_array_index (trees, iz);
+    eclass = ptree->eclass;
+    num_vertices = t8_eclass_num_vertices[eclass];
+    for (iv = 0; iv < num_vertices; iv++) {
+      jz = sc_array_bsearch (&needed, &ptree->vertices[iv],
+                             t8_cmesh_reader_long_compare);
+      T8_ASSERT (jz != (size_t) - 1);
+      memcpy (tree_vertices + 3 * iv, sc_array_index (&coords, jz),
+              3 * sizeof (double));
+    }
+    t8_cmesh_reader_correct_volume (ptree, tree_vertices, first_tree + iz);
+    t8_cmesh_set_tree_class (cmesh, first_tree + iz, (t8_eclass_t) eclass);
+    t8_cmesh_set_tree_vertices (cmesh, first_tree + iz, t8_get_package_id (),
+                                0, tree_vertices, num_vertices);
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      face_class = (t8_eclass_t) t8_eclass_face_types[eclass][iface];
+      pface.num_vertices = t8_eclass_num_vertices[face_class];
+      for (iv = 0; iv < T8_ECLASS_MAX_CORNERS_2D; iv++) {
+        pface.vertices[iv] = iv < pface.num_vertices ?
+          ptree->vertices[t8_face_vertex_to_tree_vertex[eclass][iface][iv]]
+          : -1;
+        pface.key[iv] = pface.vertices[iv];
+      }
+      qsort (pface.key, pface.num_vertices, sizeof (long),
+             t8_cmesh_reader_long_compare);
+      pface.gtree_id = first_tree + iz;
+      pface.face_number = iface;
+      pface.eclass = eclass;
+      irank = t8_cmesh_reader_face_process (pface.key, mpisize);
+      *(t8_cmesh_reader_face_t *) sc_array_push (&send[irank]) = pface;
+    }
+  }
+  sc_array_reset (&coords);
+  sc_array_reset (&needed);
+  sc_array_reset (trees);
+
+  /* Match the faces that we received. Faces with the same vertices
+   * are neighbors and we send their connection to the owners of the
+   * two trees. */
+  t8_cmesh_reader_exchange (send, &faces, NULL, mpisize, exchange_comm);
+  sc_array_sort (&faces, t8_cmesh_reader_face_compare);
+  t8_cmesh_reader_exchange_reinit (send, sizeof (t8_cmesh_reader_join_t),
+                                   mpisize);
+  for (iz = 0; iz < faces.elem_count; iz = jz) {
+    face_a = (t8_cmesh_reader_face_t *) sc_array_index (&faces, iz);
+    for (jz = iz + 1; jz < faces.elem_count &&
+         !t8_cmesh_reader_face_compare (face_a, sc_array_index (&faces, jz));
+         jz++) {
+    }
+    if (jz - iz == 1) {
+      /* This face is a domain boundary */
+      continue;
+    }
+    if (jz - iz > 2) {
+      t8_errorf ("More than two trees share a face of tree %li\n",
+                 (long) face_a->gtree_id);
+      ok = 0;
+      continue;
+    }
+    face_b = (t8_cmesh_reader_face_t *) sc_array_index (&faces, iz + 1);
+    join.gtree_id[0] = face_a->gtree_id;
+    join.gtree_id[1] = face_b->gtree_id;
+    join.face[0] = face_a->face_number;
+    join.face[1] = face_b->face_number;
+    join.eclass[0] = face_a->eclass;
+    join.eclass[1] = face_b->eclass;
+    join.orientation =
+      t8_cmesh_reader_face_orientation ((t8_eclass_t) face_a->eclass,
+                                        face_a->gtree_id, face_a->vertices,
+                                        (t8_eclass_t) face_b->eclass,
+                                        face_b->gtree_id, face_b->vertices,
+                                        face_a->num_vertices);
+    owner_a =
+      t8_cmesh_reader_tree_owner (first_trees, mpisize, face_a->gtree_id);
+    owner_b =
+      t8_cmesh_reader_tree_owner (first_trees, mpisize, face_b->gtree_id);
+    *(t8_cmesh_reader_join_t *) sc_array_push (&send[owner_a]) = join;
+    if (owner_b != owner_a) {
+      *(t8_cmesh_reader_join_t *) sc_array_push (&send[owner_b]) = join;
+    }
+  }
+  sc_array_reset (&faces);
+  ok = t8_cmesh_reader_all_ok (ok, exchange_comm);
+  if (!ok) {
+    goto die_parallel;
+  }
+
+  /* The neighbor trees of other processes are our ghosts. */
+  t8_cmesh_reader_exchange (send, &joins, NULL, mpisize, exchange_comm);
+  /* A committed cmesh knows all face connections of its ghosts, also those
+   * to other ghosts and to trees that are neither local nor ghost.
+   * The owner of a tree knows all its connections. Thus we send all
+   * connections of a local tree to each process that has it as ghost. */
+  ghost_ranks = T8_ALLOC (int, SC_MAX (num_local_trees, 1) *
+                          T8_ECLASS_MAX_FACES);
+  for (iz = 0; iz < (size_t) num_local_trees * T8_ECLASS_MAX_FACES; iz++) {
+    ghost_ranks[iz] = -1;
+  }
+  for (iz = 0; iz < joins.elem_count; iz++) {
+    pjoin = (t8_cmesh_reader_join_t *) sc_array_index (&joins, iz);
+    for (ilocal = 0; ilocal < 2; ilocal++) {
+      if (pjoin->gtree_id[ilocal] < first_tree
+          || pjoin->gtree_id[ilocal] >= first_tree + num_local_trees) {
+        pghost = (t8_cmesh_reader_ghost_t *) sc_array_push (&ghosts);
+        pghost->gtree_id = pjoin->gtree_id[ilocal];
+        pghost->eclass = pjoin->eclass[ilocal];
+        /* Store the owner of the ghost with the local tree */
+        irank = t8_cmesh_reader_tree_owner (first_trees, mpisize,
+                                            pghost->gtree_id);
+        ranks = ghost_ranks + (pjoin->gtree_id[1 - ilocal] - first_tree)
+          * T8_ECLASS_MAX_FACES;
+        for (iface = 0; ranks[iface] >= 0 && ranks[iface] != irank;
+             iface++) {
+        }
+        ranks[iface] = irank;
+      }
+    }
+  }
+  t8_cmesh_reader_exchange_reinit (send, sizeof (t8_cmesh_reader_join_t),
+                                   mpisize);
+  for (iz = 0; iz < joins.elem_count; iz++) {
+    pjoin = (t8_cmesh_reader_join_t *) sc_array_index (&joins, iz);
+    for (ilocal = 0; ilocal < 2; ilocal++) {
+      if (first_tree <= pjoin->gtree_id[ilocal]
+          && pjoin->gtree_id[ilocal] < first_tree + num_local_trees) {
+        ranks = ghost_ranks + (pjoin->gtree_id[ilocal] - first_tree)
+          * T8_ECLASS_MAX_FACES;
+        for (iface = 0; iface < T8_ECLASS_MAX_FACES && ranks[iface] >= 0;
+             iface++) {
+          *(t8_cmesh_reader_join_t *) sc_array_push (&send[ranks[iface]]) =
+            *pjoin;
+        }
+      }
+    }
+  }
+  T8_FREE (ghost_ranks);
+  {
+    sc_array_t          ghost_joins;
+
+    sc_array_init (&ghost_joins, sizeof (t8_cmesh_reader_join_t));
+    t8_cmesh_reader_exchange (send, &ghost_joins, NULL, mpisize,
+                              exchange_comm);
+    sc_array_push_count (&joins, ghost_joins.elem_count);
+    if (ghost_joins.elem_count > 0) {
+      memcpy (sc_array_index (&joins, joins.elem_count -
+                              ghost_joins.elem_count), ghost_joins.array,
+              ghost_joins.elem_count * sizeof (t8_cmesh_reader_join_t));
+    }
+    sc_array_reset (&ghost_joins);
+  }
+  /* A connection may have arrived more than once */
+  sc_array_sort (&joins, t8_cmesh_reader_join_compare);
+  sc_array_uniq (&joins, t8_cmesh_reader_join_compare);
+  for (iz = 0; iz < joins.elem_count; iz++) {
+    pjoin = (t8_cmesh_reader_join_t *) sc_array_index (&joins, iz);
+    t8_cmesh_set_join (cmesh, pjoin->gtree_id[0], pjoin->gtree_id[1],
+                       pjoin->face[0], pjoin->face[1], pjoin->orientation);
+  }
+  sc_array_sort (&ghosts, t8_cmesh_reader_ghost_compare);
+  sc_array_uniq (&ghosts, t8_cmesh_reader_ghost_compare);
+  for (iz = 0; iz < ghosts.elem_count; iz++) {
+    pghost = (t8_cmesh_reader_ghost_t *) sc_array_index (&ghosts, iz);
+    t8_cmesh_set_tree_class (cmesh, pghost->gtree_id,
+                             (t8_eclass_t) pghost->eclass);
+  }
+  t8_cmesh_set_partition_range (cmesh, 3, first_tree,
+                                first_tree + num_local_trees - 1);
+  if (do_dup) {
+    mpiret = sc_MPI_Comm_free (&exchange_comm);
+    SC_CHECK_MPI (mpiret);
+  }
+  t8_cmesh_commit (cmesh, comm);
+
+die_parallel:
+  if (!ok) {
+    if (do_dup) {
+      mpiret = sc_MPI_Comm_free (&exchange_comm);
+      SC_CHECK_MPI (mpiret);
+    }
+    if (cmesh != NULL) {
+      t8_cmesh_destroy (&cmesh);
+    }
+  }
+  for (irank = 0; irank < mpisize; irank++) {
+    sc_array_reset (&send[irank]);
+  }
+  T8_FREE (send);
+  T8_FREE (recv_counts);
+  T8_FREE (first_trees);
+  sc_array_reset (&directory);
+  sc_array_reset (nodes);
+  sc_array_reset (trees);
+  sc_array_reset (&needed);
+  sc_array_reset (&coords);
+  sc_array_reset (&faces);
+  sc_array_reset (&joins);
+  sc_array_reset (&ghosts);
+  return cmesh;
+}
@@ -0,0 +1,207 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_cmesh_reader.h
+ *
+ * Shared parts of the parallel mesh file readers.
+ *
+ * A parallel reader lets each process read a part of the nodes and a
+ * contiguous part of the trees of a mesh file. The trees are given by the
+ * indices of their vertices. \ref t8_cmesh_reader_build then sends the
+ * nodes to directory processes, collects the coordinates of the vertices of
+ * the local trees, matches the tree faces and commits a partitioned cmesh.
+ * No process needs to store the whole mesh.
+ */
+
+#ifndef T8_CMESH_READER_H
+#define T8_CMESH_READER_H
+
+#include <t8.h>
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+
+/** A node of a mesh file */
+typedef struct
+{
+  long                index;    /**< The nonnegative index of the node */
+  double              coordinates[3];   /**< The coordinates of the node */
+} t8_cmesh_reader_node_t;
+
+/** A tree of a mesh file */
+typedef struct
+{
+  /** The node indices of the vertices in t8code order */
+  long                vertices[T8_ECLASS_MAX_CORNERS];
+  int8_t              eclass;   /**< The class of the tree */
+} t8_cmesh_reader_tree_t;
+
+/** A read-only view of the contents of a file */
+typedef struct t8_cmesh_reader_file
+{
+  char               *data;     /**< The contents of the file */
+  size_t              size;     /**< The number of bytes of the file */
+  int                 is_mapped;        /**< True if data is memory-mapped */
+} t8_cmesh_reader_file_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Compare two nodes by their index.
+ * Can be used to sort and search arrays of \ref t8_cmesh_reader_node_t.
+ */
+int                 t8_cmesh_reader_node_compare (const void *a,
+                                                  const void *b);
+
+/** Compute the logical and of a flag on all processes.
+ * \param [in] ok     A flag on this process.
+ * \param [in] comm   The communicator.
+ * \return            True on all processes if \a ok is true on all processes.
+ */
+int                 t8_cmesh_reader_all_ok (int ok, sc_MPI_Comm comm);
+
+/** Send the entries of send[p] to process p for each process p and
+ * receive the entries that the other processes send to us.
+ * The entries are counted in units of the element size of \a recv, and
+ * the program aborts if a process sends or receives more than INT_MAX
+ * entries.
+ * This function is collective on \a comm.
+ * \param [in] send      An array of \a mpisize arrays with the element size
+ *                       of \a recv.
+ * \param [in,out] recv  An initialized array. On output the received
+ *                       entries ordered by the rank of their sender.
+ * \param [out] recv_counts If not NULL, an array of \a mpisize integers.
+ *                       On output the number of entries received from each
+ *                       process.
+ * \param [in] mpisize   The number of processes.
+ * \param [in] comm      The communicator.
+ */
+void                t8_cmesh_reader_exchange (sc_array_t * send,
+                                              sc_array_t * recv,
+                                              int *recv_counts, int mpisize,
+                                              sc_MPI_Comm comm);
+
+/** Empty the send arrays of an exchange and set their element size.
+ * \param [in,out] send  An array of \a mpisize initialized arrays.
+ * \param [in] elem_size The new element size.
+ * \param [in] mpisize   The number of processes.
+ */
+void                t8_cmesh_reader_exchange_reinit (sc_array_t * send,
+                                                     size_t elem_size,
+                                                     int mpisize);
+
+/** Map a file into memory. If mmap is not available, the file is read
+ * into a buffer instead. The contents are not terminated by a zero byte.
+ * \param [in] filename  The name of the file.
+ * \param [out] map      On success the contents of the file.
+ * \return               0 on success, -1 if the file could not be read or
+ *                       is empty.
+ */
+int                 t8_cmesh_reader_file_map (const char *filename,
+                                              t8_cmesh_reader_file_t * map);
+
+/** Free a view of a file that was created with \ref t8_cmesh_reader_file_map.
+ * \param [in,out] map   The contents of a file.
+ */
+void                t8_cmesh_reader_file_unmap (t8_cmesh_reader_file_t *
+                                                map);
+
+/** Split the bytes [\a begin, \a end) of a file evenly among the processes
+ * and position the file at the first line that starts in the part of this
+ * process. A line belongs to the process whose part contains its first byte.
+ * \param [in] fp       An open file.
+ * \param [in] begin    The position of the first byte to split.
+ * \param [in] end      The position after the last byte to split.
+ * \param [in] mpirank  The rank of this process.
+ * \param [in] mpisize  The number of processes.
+ * \param [in,out] line An allocated line buffer, as for getline.
+ * \param [in,out] linen The size of \a line, as for getline.
+ * \return              The end of the part of this process. This process
+ *                      reads all lines that start before this position.
+ */
+long                t8_cmesh_reader_seek_range (FILE * fp, long begin,
+                                                long end, int mpirank,
+                                                int mpisize, char **line,
+                                                size_t *linen);
+
+/** If the vertices of a tree describe a negative volume, switch the
+ * coordinates and the indices of vertex 0 and vertex 1.
+ * \param [in,out] tree   A tree.
+ * \param [in,out] tree_vertices The coordinates of the vertices of \a tree.
+ * \param [in] gtree_id   The global id of the tree, for debugging output.
+ */
+void                t8_cmesh_reader_correct_volume (t8_cmesh_reader_tree_t *
+                                                    tree,
+                                                    double *tree_vertices,
+                                                    t8_gloidx_t gtree_id);
+
+/** Compute the orientation of a face connection of two trees.
+ * This is the number of the vertex in the face of the bigger tree that is
+ * vertex 0 of the face of the smaller tree. A tree is smaller if its class
+ * is smaller, or if the classes are the same and its id is smaller.
+ * \param [in] eclass_a  The class of the first tree.
+ * \param [in] gtree_a   The global id of the first tree.
+ * \param [in] face_vertices_a The vertex indices of the face of the first
+ *                       tree in the order of the face vertices.
+ * \param [in] eclass_b  The class of the second tree.
+ * \param [in] gtree_b   The global id of the second tree.
+ * \param [in] face_vertices_b The vertex indices of the face of the second
+ *                       tree in the order of the face vertices.
+ * \param [in] num_face_vertices The number of vertices of the faces.
+ * \return               The orientation of the face connection.
+ *                       The two faces must have the same vertices.
+ */
+int                 t8_cmesh_reader_face_orientation (t8_eclass_t eclass_a,
+                                                      t8_gloidx_t gtree_a,
+                                                      const long
+                                                      *face_vertices_a,
+                                                      t8_eclass_t eclass_b,
+                                                      t8_gloidx_t gtree_b,
+                                                      const long
+                                                      *face_vertices_b,
+                                                      int
+                                                      num_face_vertices);
+
+/** Build a partitioned cmesh from the nodes and trees that the processes
+ * have read. Each node of the file must have been read by exactly one
+ * process. The trees of a process must be consecutive in the file and the
+ * trees of process p must come before those of process p + 1. The trees
+ * are numbered in this order. The ghosts of the cmesh know all their face
+ * connections, including those to other ghosts and to trees that are
+ * neither local nor ghost trees.
+ * This function is collective on \a comm.
+ * \param [in,out] nodes  The nodes read by this process. Emptied on output.
+ * \param [in,out] trees  The trees read by this process. Emptied on output.
+ * \param [in] dim        The dimension of the cmesh.
+ * \param [in] comm       The communicator of the cmesh.
+ * \param [in] do_dup     If true, the messages of the reader are sent on a
+ *                        duplicate of \a comm that is freed before the
+ *                        cmesh is committed with \a comm.
+ * \return                A committed and partitioned cmesh, or NULL on all
+ *                        processes if a vertex index is not in the nodes or
+ *                        more than two trees share a face.
+ */
+t8_cmesh_t          t8_cmesh_reader_build (sc_array_t * nodes,
+                                           sc_array_t * trees, int dim,
+                                           sc_MPI_Comm comm, int do_dup);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_CMESH_READER_H */
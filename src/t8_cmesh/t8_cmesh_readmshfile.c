@@ -23,13 +23,18 @@
 #include <t8_eclass.h>
 #include <t8_cmesh_readmshfile.h>
 #include <t8_cmesh_vtk.h>
+#include <t8_geometry.h>
 #include "t8_cmesh_types.h"
 #include "t8_cmesh_stash.h"
+#include "t8_cmesh_face_matching.h"
+#include "t8_cmesh_reader.h"
 
 /* The supported number of gmesh tree classes.
- * Currently, we only support first order trees.
+ * Of the higher order trees we read the nodes of the complete Lagrange
+ * trees of degree 2 and the lines and triangles of degree 3, of the other
+ * trees only their vertices.
  */
-#define       T8_NUM_GMSH_ELEM_CLASSES  15
+#define       T8_NUM_GMSH_ELEM_CLASSES  26
 /* look-up table to translate the gmsh tree class to a t8code tree class.
  */
 const t8_eclass_t   t8_msh_tree_type_to_eclass[T8_NUM_GMSH_ELEM_CLASSES + 1] = {
@@ -42,10 +47,119 @@ const t8_eclass_t   t8_msh_tree_type_to_eclass[T8_NUM_GMSH_ELEM_CLASSES + 1] = {
   T8_ECLASS_PRISM,
   T8_ECLASS_PYRAMID,            /* 7 This is the last first order tree type,
                                    except the Point, which is type 15 */
-  /* We do not support type 8 to 14 */
-  T8_ECLASS_COUNT, T8_ECLASS_COUNT, T8_ECLASS_COUNT, T8_ECLASS_COUNT,
-  T8_ECLASS_COUNT, T8_ECLASS_COUNT, T8_ECLASS_COUNT,
-  T8_ECLASS_VERTEX              /* 15 */
+  T8_ECLASS_LINE,               /* 8 The second order trees */
+  T8_ECLASS_TRIANGLE,
+  T8_ECLASS_QUAD,               /* 10 */
+  T8_ECLASS_TET,
+  T8_ECLASS_HEX,
+  T8_ECLASS_PRISM,
+  T8_ECLASS_PYRAMID,
+  T8_ECLASS_VERTEX,             /* 15 */
+  T8_ECLASS_QUAD,               /* 16 The incomplete second order trees */
+  T8_ECLASS_HEX,
+  T8_ECLASS_PRISM,
+  T8_ECLASS_PYRAMID,
+  T8_ECLASS_TRIANGLE,           /* 20 The third to fifth order triangles */
+  T8_ECLASS_TRIANGLE,
+  T8_ECLASS_TRIANGLE,
+  T8_ECLASS_TRIANGLE,
+  T8_ECLASS_TRIANGLE,
+  T8_ECLASS_TRIANGLE,           /* 25 */
+  T8_ECLASS_LINE                /* 26 The third order line */
+};
+
+/* The number of nodes of each gmsh element type up to
+ * T8_NUM_GMSH_ELEM_CLASSES. We need it to skip unsupported elements. */
+const int           t8_msh_element_type_num_nodes[T8_NUM_GMSH_ELEM_CLASSES
+                                                  + 1] = {
+  0, 2, 3, 4, 4, 8, 6, 5, 3, 6, 9, 10, 27, 18, 14, 1,
+  8, 20, 15, 13, 9, 10, 12, 15, 15, 21, 4
+};
+
+/* The maximum number of nodes of a tree that we read */
+#define       T8_MSH_MAX_NODES 27
+
+/* Each higher order node is the mean of up to 8 vertices of the tree,
+ * given by their number followed by their gmsh vertex numbers.
+ * A vertex may be repeated to weight it. */
+#define       T8_MSH_NODE_VERTICES 9
+
+static const int    t8_msh_line3_nodes[][T8_MSH_NODE_VERTICES] = {
+  {2, 0, 1}
+};
+
+static const int    t8_msh_line4_nodes[][T8_MSH_NODE_VERTICES] = {
+  {3, 0, 0, 1}, {3, 0, 1, 1}
+};
+
+static const int    t8_msh_triangle6_nodes[][T8_MSH_NODE_VERTICES] = {
+  {2, 0, 1}, {2, 1, 2}, {2, 2, 0}
+};
+
+static const int    t8_msh_triangle10_nodes[][T8_MSH_NODE_VERTICES] = {
+  {3, 0, 0, 1}, {3, 0, 1, 1}, {3, 1, 1, 2}, {3, 1, 2, 2},
+  {3, 2, 2, 0}, {3, 2, 0, 0}, {3, 0, 1, 2}
+};
+
+static const int    t8_msh_quad9_nodes[][T8_MSH_NODE_VERTICES] = {
+  {2, 0, 1}, {2, 1, 2}, {2, 2, 3}, {2, 3, 0}, {4, 0, 1, 2, 3}
+};
+
+static const int    t8_msh_tet10_nodes[][T8_MSH_NODE_VERTICES] = {
+  {2, 0, 1}, {2, 1, 2}, {2, 0, 2}, {2, 0, 3}, {2, 2, 3}, {2, 1, 3}
+};
+
+static const int    t8_msh_hex27_nodes[][T8_MSH_NODE_VERTICES] = {
+  {2, 0, 1}, {2, 0, 3}, {2, 0, 4}, {2, 1, 2}, {2, 1, 5}, {2, 2, 3},
+  {2, 2, 6}, {2, 3, 7}, {2, 4, 5}, {2, 4, 7}, {2, 5, 6}, {2, 6, 7},
+  {4, 0, 1, 2, 3}, {4, 0, 1, 4, 5}, {4, 0, 3, 4, 7}, {4, 1, 2, 5, 6},
+  {4, 2, 3, 6, 7}, {4, 4, 5, 6, 7}, {8, 0, 1, 2, 3, 4, 5, 6, 7}
+};
+
+static const int    t8_msh_prism18_nodes[][T8_MSH_NODE_VERTICES] = {
+  {2, 0, 1}, {2, 0, 2}, {2, 0, 3}, {2, 1, 2}, {2, 1, 4}, {2, 2, 5},
+  {2, 3, 4}, {2, 3, 5}, {2, 4, 5},
+  {4, 0, 1, 3, 4}, {4, 0, 2, 3, 5}, {4, 1, 2, 4, 5}
+};
+
+/* The degree and the higher order nodes of a gmsh element type.
+ * The degree is 0 if we only read the vertices. */
+typedef struct
+{
+  int                 degree;
+  const int           (*nodes)[T8_MSH_NODE_VERTICES];
+} t8_msh_file_highorder_t;
+
+static const t8_msh_file_highorder_t
+  t8_msh_highorder[T8_NUM_GMSH_ELEM_CLASSES + 1] = {
+  {0, NULL}, {0, NULL}, {0, NULL}, {0, NULL}, {0, NULL}, {0, NULL},
+  {0, NULL}, {0, NULL},
+  {2, t8_msh_line3_nodes},      /* 8 */
+  {2, t8_msh_triangle6_nodes},
+  {2, t8_msh_quad9_nodes},      /* 10 */
+  {2, t8_msh_tet10_nodes},
+  {2, t8_msh_hex27_nodes},
+  {2, t8_msh_prism18_nodes},
+  {0, NULL}, {0, NULL}, {0, NULL}, {0, NULL}, {0, NULL}, {0, NULL},
+  {0, NULL},                    /* 20 */
+  {3, t8_msh_triangle10_nodes},
+  {0, NULL}, {0, NULL}, {0, NULL}, {0, NULL},
+  {3, t8_msh_line4_nodes}       /* 26 */
+};
+
+/* The reference coordinates of the t8code vertices of each tree class,
+ * as they are passed to a geometry. */
+static const double t8_msh_t8_vertex_ref_coords[T8_ECLASS_COUNT][8][3] = {
+  {{0, 0, 0}},                  /* VERTEX */
+  {{0, 0, 0}, {1, 0, 0}},       /* LINE */
+  {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}}, /* QUAD */
+  {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}},    /* TRIANGLE */
+  {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0},
+   {0, 0, 1}, {1, 0, 1}, {0, 1, 1}, {1, 1, 1}},       /* HEX */
+  {{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {1, 1, 1}}, /* TET */
+  {{0, 0, 0}, {1, 0, 0}, {1, 1, 0},
+   {0, 0, 1}, {1, 0, 1}, {1, 1, 1}},    /* PRISM */
+  {{0}}                         /* PYRAMID, not used */
 };
 
 /* translate the msh file vertex number to the t8code vertex number */
@@ -275,6 +389,62 @@ die_node:
   return NULL;
 }
 
+/* Store the nodes of a higher order tree as the nodes of a curved tree.
+ * node_indices are the node indices of the tree in gmsh order and
+ * vertex_num stores for each gmsh vertex its t8code vertex number.
+ * Return 0 on success and -1 if a node was not found. */
+static int
+t8_msh_file_set_highorder_nodes (t8_cmesh_t cmesh, t8_gloidx_t gtree_id,
+                                 t8_eclass_t eclass, int ele_type,
+                                 const long *node_indices,
+                                 const int *vertex_num, sc_hash_t * vertices)
+{
+  const t8_msh_file_highorder_t *highorder = t8_msh_highorder + ele_type;
+  const int           num_nodes = t8_msh_element_type_num_nodes[ele_type];
+  const int           num_vertices = t8_eclass_num_vertices[eclass];
+  double              ref_coords[3 * T8_MSH_MAX_NODES];
+  double              coords[3 * T8_MSH_MAX_NODES];
+  t8_msh_file_node_t  Node, **found_node;
+  const int          *node;
+  int                 inode, iv, i;
+
+  T8_ASSERT (highorder->degree > 0);
+  T8_ASSERT (num_nodes <= T8_MSH_MAX_NODES);
+  for (inode = 0; inode < num_nodes; inode++) {
+    Node.index = node_indices[inode];
+    if (!sc_hash_lookup (vertices, (void *) &Node, (void ***) &found_node)) {
+      t8_global_errorf ("Node %li of tree %li not found.\n",
+                        node_indices[inode], (long) gtree_id);
+      return -1;
+    }
+    for (i = 0; i < 3; i++) {
+      coords[3 * inode + i] = (*found_node)->coordinates[i];
+    }
+    if (inode < num_vertices) {
+      /* A vertex of the tree */
+      for (i = 0; i < 3; i++) {
+        ref_coords[3 * inode + i] =
+          t8_msh_t8_vertex_ref_coords[eclass][vertex_num[inode]][i];
+      }
+    }
+    else {
+      /* The mean of some vertices */
+      node = highorder->nodes[inode - num_vertices];
+      for (i = 0; i < 3; i++) {
+        ref_coords[3 * inode + i] = 0;
+        for (iv = 1; iv <= node[0]; iv++) {
+          ref_coords[3 * inode + i] +=
+            t8_msh_t8_vertex_ref_coords[eclass][vertex_num[node[iv]]][i];
+        }
+        ref_coords[3 * inode + i] /= node[0];
+      }
+    }
+  }
+  t8_geometry_set_tree_lagrange_nodes (cmesh, gtree_id, highorder->degree,
+                                       num_nodes, ref_coords, coords);
+  return 0;
+}
+
 /* fp should be set after the Nodes section, right before the tree section.
  * If vertex_indices is not NULL, it is allocated and will store
  * for each tree the indices of its vertices.
@@ -294,8 +464,9 @@ t8_cmesh_msh_file_read_eles (t8_cmesh_t cmesh, FILE * fp,
   long                lnum_trees;
   int                 retval, i;
   int                 ele_type, num_tags;
-  int                 num_nodes, t8_vertex_num;
-  long                node_indices[8], *stored_indices;
+  int                 num_nodes, num_read_nodes, t8_vertex_num;
+  int                 vertex_num[8];
+  long                node_indices[T8_MSH_MAX_NODES], *stored_indices;
   double              tree_vertices[24];
 
   T8_ASSERT (fp != NULL);
@@ -372,9 +543,12 @@ t8_cmesh_msh_file_read_eles (t8_cmesh_t cmesh, FILE * fp,
         /* move line_modify to the next word in the line */
         (void) strsep (&line_modify, " ");
       }
-      /* At this point line_modify contains only the node indices. */
+      /* At this point line_modify contains only the node indices.
+       * Of a curved tree we read all nodes, otherwise only the vertices. */
       num_nodes = t8_eclass_num_vertices[eclass];
-      for (i = 0; i < num_nodes; i++) {
+      num_read_nodes = t8_msh_highorder[ele_type].degree > 0 ?
+        t8_msh_element_type_num_nodes[ele_type] : num_nodes;
+      for (i = 0; i < num_read_nodes; i++) {
         T8_ASSERT (strcmp (line_modify, "\0"));
         retval = sscanf (line_modify, "%li", node_indices + i);
         if (retval != 1) {
@@ -392,6 +566,7 @@ t8_cmesh_msh_file_read_eles (t8_cmesh_t cmesh, FILE * fp,
         sc_hash_lookup (vertices, (void *) &Node, (void ***) &found_node);
         /* Add node coordinates to the tree vertices */
         t8_vertex_num = t8_msh_tree_vertex_to_t8_vertex_num[eclass][i];
+        vertex_num[i] = t8_vertex_num;
         tree_vertices[3 * t8_vertex_num] = (*found_node)->coordinates[0];
         tree_vertices[3 * t8_vertex_num + 1] = (*found_node)->coordinates[1];
         tree_vertices[3 * t8_vertex_num + 2] = (*found_node)->coordinates[2];
@@ -409,12 +584,23 @@ t8_cmesh_msh_file_read_eles (t8_cmesh_t cmesh, FILE * fp,
           tree_vertices[i] = tree_vertices[3 + i];
           tree_vertices[3 + i] = temp;
         }
+        for (i = 0; i < num_nodes; i++) {
+          /* The gmsh vertices at the t8code vertices 0 and 1 switch too */
+          vertex_num[i] = vertex_num[i] == 0 ? 1 :
+            vertex_num[i] == 1 ? 0 : vertex_num[i];
+        }
         T8_ASSERT (!t8_cmesh_tree_vertices_negative_volume
                    (eclass, tree_vertices, num_nodes));
       }
       /* Set the vertices of this tree */
       t8_cmesh_set_tree_vertices (cmesh, tree_count, t8_get_package_id (),
                                   0, tree_vertices, num_nodes);
+      if (t8_msh_highorder[ele_type].degree > 0
+          && t8_msh_file_set_highorder_nodes (cmesh, tree_count, eclass,
+                                              ele_type, node_indices,
+                                              vertex_num, vertices) != 0) {
+        goto die_ele;
+      }
       /* If wished, we store the vertex indices of that tree. */
       if (vertex_indices != NULL) {
         /* Allocate memory for the inices */
@@ -440,261 +626,531 @@ die_ele:
   return -1;
 }
 
-/* This struct stores all information associated to a tree's face.
- * We need it to find neighbor trees.
- */
-typedef struct
+/* Given the number of vertices and for each element a list of its
+ * vertices, find the neighborship relations of each element */
+/* This routine does only find neighbors between local trees.
+ * Use with care if cmesh is partitioned. */
+static void
+t8_cmesh_msh_file_find_neighbors (t8_cmesh_t cmesh,
+                                  sc_array_t * vertex_indices)
 {
-  t8_locidx_t         ltree_id; /* The local id of the tree this face belongs to */
-  int8_t              face_number;      /* The number of that face whitin the tree */
-  int                 num_vertices;     /* The number of vertices of this face. */
-  long               *vertices; /* The indices of these vertices. */
-} t8_msh_file_face_t;
+  t8_eclass_t        *eclasses;
+  t8_locidx_t         num_trees, itree;
+  t8_stash_class_struct_t *class_entry;
+  long               *tree_vertices;
 
-/* Hash a face. The hash value is the sum of its vertex indices */
-static unsigned
-t8_msh_file_face_hash (const void *face, const void *data)
+  /* TODO: Does currently not work with partitioned cmesh */
+  T8_ASSERT (!cmesh->set_partition);
+  /* The cmesh is not allowed to be committed yet */
+  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
+  t8_debugf ("Starting to find tree neighbors\n");
+  num_trees = cmesh->stash->classes.elem_count;
+  T8_ASSERT ((size_t) num_trees == vertex_indices->elem_count);
+  eclasses = T8_ALLOC (t8_eclass_t, SC_MAX (num_trees, 1));
+  tree_vertices = T8_ALLOC (long, SC_MAX (num_trees, 1)
+                            * T8_ECLASS_MAX_CORNERS);
+  for (itree = 0; itree < num_trees; itree++) {
+    /* We get the class of the current tree.
+     * Since we know that the trees were put into the stash in order
+     * of their tree id's, we can just read the correspoding entry from
+     * the stash.
+     * !WARNING: This does not work in general to find the class of a tree
+     *    since the order in which the trees are added to the stash is arbitrary.
+     *    Use t8_stash_class_bsearch in tat case.
+     */
+    class_entry = (t8_stash_class_struct_t *)
+      t8_sc_array_index_locidx (&cmesh->stash->classes, itree);
+    T8_ASSERT (class_entry->id == itree);
+    eclasses[itree] = class_entry->eclass;
+    memcpy (tree_vertices + (size_t) itree * T8_ECLASS_MAX_CORNERS,
+            *(long **) t8_sc_array_index_locidx (vertex_indices, itree),
+            t8_eclass_num_vertices[eclasses[itree]] * sizeof (long));
+  }
+  /* The faces without neighbor are set as domain boundaries */
+  (void) t8_cmesh_face_matching_set_joins (cmesh, num_trees, 0, eclasses,
+                                           tree_vertices,
+                                           T8_ECLASS_MAX_CORNERS, 1, 1);
+  T8_FREE (eclasses);
+  T8_FREE (tree_vertices);
+  t8_debugf ("Done finding tree neighbors.\n");
+}
+
+/* The parallel reader.
+ * Each process reads a byte range of the node section and of the element
+ * section of the file. A line belongs to the process whose range contains
+ * its first byte. Binary files of version 4.1 are mapped into memory instead
+ * and each process reads an equal share of the nodes and of the elements.
+ * The cmesh is then built with t8_cmesh_reader_build. */
+
+/* Find the node and element sections of an open .msh file.
+ * On output sections stores the number of nodes, the position of the first
+ * node line, the position of the line $EndNodes, and the same three values
+ * for the elements.
+ * Return 0 on success and -1 if a section was not found. */
+static int
+t8_msh_file_find_sections (FILE * fp, long sections[6])
 {
-  t8_msh_file_face_t *Face;
-  int                 iv;
-  long                sum = 0;
+  char               *line = (char *) malloc (1024);
+  char                first_word[2048];
+  size_t              linen = 1024;
+  long                pos;
+  int                 state = 0;
 
-  Face = (t8_msh_file_face_t *) face;
-  for (iv = 0; iv < Face->num_vertices; iv++) {
-    sum += Face->vertices[iv];
+  fseek (fp, 0, SEEK_SET);
+  /* The states are: 0 before the nodes, 1 in the nodes,
+   * 2 before the elements, 3 in the elements, 4 done. */
+  while (state < 4) {
+    pos = ftell (fp);
+    if (getline (&line, &linen, fp) < 0) {
+      break;
+    }
+    if (sscanf (line, "%2047s", first_word) != 1) {
+      continue;
+    }
+    if ((state == 0 && !strcmp (first_word, "$Nodes"))
+        || (state == 2 && !strcmp (first_word, "$Elements"))) {
+      /* The next line is the number of entries */
+      if (t8_cmesh_msh_read_next_line (&line, &linen, fp) < 0
+          || sscanf (line, "%li", &sections[state == 0 ? 0 : 3]) != 1) {
+        break;
+      }
+      sections[state == 0 ? 1 : 4] = ftell (fp);
+      state++;
+    }
+    else if ((state == 1 && !strcmp (first_word, "$EndNodes"))
+             || (state == 3 && !strcmp (first_word, "$EndElements"))) {
+      sections[state == 1 ? 2 : 5] = pos;
+      state++;
+    }
   }
-  T8_ASSERT (sum >= 0);
-  return (unsigned) sum;
+  free (line);
+  return state == 4 ? 0 : -1;
 }
 
-/* Two face are considered equal if they have the same vertices up
- * to renumeration. */
+/* Parse an element line of a .msh file.
+ * Return the class of the element or T8_ECLASS_COUNT if it is not
+ * supported, and -1 on a read error. On success the node indices
+ * are stored in t8code order. */
 static int
-t8_msh_file_face_equal (const void *facea, const void *faceb,
-                        const void *data)
+t8_msh_file_parse_element (char *line, long vertices[T8_ECLASS_MAX_CORNERS])
 {
-  int                 iv, jv, ret;
-  long                vertex;
-  t8_msh_file_face_t *Face_a, *Face_b;
-
-  Face_a = (t8_msh_file_face_t *) facea;
-  Face_b = (t8_msh_file_face_t *) faceb;
-  /* If both have different number of vertices they can't be equal */
-  ret = Face_a->num_vertices == Face_b->num_vertices;
-  if (!ret) {
-    return 0;
+  long                values[3], node_indices[T8_ECLASS_MAX_CORNERS];
+  char               *pos = line, *next;
+  t8_eclass_t         eclass;
+  int                 i, num_nodes;
+
+  /* The line has the format
+   * tree_number tree_type Number_tags tag_1 ... tag_n Node_1 ... Node_m */
+  for (i = 0; i < 3; i++) {
+    values[i] = strtol (pos, &next, 10);
+    if (next == pos) {
+      return -1;
+    }
+    pos = next;
+  }
+  if (values[1] > T8_NUM_GMSH_ELEM_CLASSES || values[1] < 0
+      || t8_msh_tree_type_to_eclass[values[1]] == T8_ECLASS_COUNT) {
+    return T8_ECLASS_COUNT;
   }
-  /* Check for each vertex of Face_a whether it is a vertex
-   * of Face_b */
-  for (iv = 0; iv < Face_a->num_vertices; iv++) {
-    vertex = Face_a->vertices[iv];
-    ret = 0;
-    for (jv = 0; jv < Face_b->num_vertices; jv++) {
-      ret |= vertex == Face_b->vertices[jv];
+  eclass = t8_msh_tree_type_to_eclass[values[1]];
+  /* Skip the tags */
+  for (i = 0; i < values[2]; i++) {
+    (void) strtol (pos, &next, 10);
+    if (next == pos) {
+      return -1;
     }
-    /* if vertex was a vertex of Face_b then ret is true here */
-    if (!ret) {
-      return 0;
+    pos = next;
+  }
+  num_nodes = t8_eclass_num_vertices[eclass];
+  for (i = 0; i < num_nodes; i++) {
+    node_indices[i] = strtol (pos, &next, 10);
+    if (next == pos) {
+      return -1;
     }
+    pos = next;
+  }
+  for (i = 0; i < num_nodes; i++) {
+    vertices[i] = node_indices[t8_vertex_to_msh_vertex_num[eclass][i]];
   }
-  return 1;
+  return eclass;
 }
 
-/* We use this function in a loop over all elements
- * in the hash table, to free the memory of the vertices array */
+/* The binary reader for the .msh format of version 4.1.
+ * The binary file is mapped into memory and the node and element blocks
+ * are read from there without converting them to text. */
+
+/* Parse the line after $MeshFormat of a .msh file.
+ * We read ASCII files of version 2 and binary files of version 4.1.
+ * The block layout of binary files of version 4.0 is different.
+ * Return 1 for a binary file and store the size of a size_t in the file in
+ * data_size, 0 for an ASCII file and -1 if the version is not supported. */
 static int
-t8_msh_file_face_free (void **face, const void *data)
+t8_msh_file_parse_format (const char *line, int *data_size)
 {
-  t8_msh_file_face_t *Face;
+  int                 major, minor, file_type;
 
-  Face = *(t8_msh_file_face_t **) face;
-  T8_FREE (Face->vertices);
-  return 1;
+  if (sscanf (line, "%d.%d %d %d", &major, &minor, &file_type,
+              data_size) != 4) {
+    t8_global_errorf ("Could not read the version of the .msh file.\n");
+    return -1;
+  }
+  if (file_type == 0 && major == 2) {
+    return 0;
+  }
+  if (file_type == 1 && major == 4 && minor == 1) {
+    return 1;
+  }
+  t8_global_errorf ("Version %i.%i of %s .msh files is not supported. "
+                    "Supported are ASCII files of version 2 and binary "
+                    "files of version 4.1.\n", major, minor,
+                    file_type ? "binary" : "ASCII");
+  return -1;
 }
 
-/* Given a face and a cmesh set the face as a domain boundary.
- * We use this function in a loop over all hashed faces.
- */
+/* Read the format of an open .msh file from its $MeshFormat section.
+ * Return 1 if the file is a binary file of version 4.1 and
+ * store the size of a size_t in the file in data_size.
+ * Return -1 if the version of the file is not supported and 0 otherwise.
+ * A file without $MeshFormat section is read as ASCII file. */
 static int
-t8_msh_file_face_set_boundary (void **face, const void *data)
+t8_msh_file_is_binary_v4 (FILE * fp, int *data_size)
 {
-  t8_msh_file_face_t *Face;
-  t8_cmesh_t          cmesh;
-  t8_gloidx_t         gtree_id;
+  char                line[BUFSIZ];
+  int                 retval = 0;
+
+  fseek (fp, 0, SEEK_SET);
+  if (fgets (line, BUFSIZ, fp) != NULL && !strncmp (line, "$MeshFormat", 11)) {
+    retval = fgets (line, BUFSIZ, fp) != NULL ?
+      t8_msh_file_parse_format (line, data_size) : -1;
+  }
+  fseek (fp, 0, SEEK_SET);
+  return retval;
+}
+
+/* Read a size_t of the file, which has data_size bytes */
+static size_t
+t8_msh_file_binary_size (const char *data, int data_size)
+{
+  uint32_t            value32;
+  uint64_t            value64;
+
+  if (data_size == 4) {
+    memcpy (&value32, data, 4);
+    return value32;
+  }
+  memcpy (&value64, data, 8);
+  return value64;
+}
+
+/* Read an int of the file */
+static int
+t8_msh_file_binary_int (const char *data)
+{
+  int                 value;
+
+  memcpy (&value, data, sizeof (int));
+  return value;
+}
 
-  cmesh = (t8_cmesh_t) data;
-  Face = *(t8_msh_file_face_t **) face;
+/* Return the position after the next newline at or after pos */
+static size_t
+t8_msh_file_binary_next_line (const t8_cmesh_reader_file_t * map,
+                              size_t pos)
+{
+  const char         *newline;
 
-  /* Get the global tree id */
-  gtree_id = Face->ltree_id;
-  /* Set the Face as a domain boundary */
-  t8_cmesh_set_join (cmesh, gtree_id, gtree_id, Face->face_number,
-                     Face->face_number, 0);
-  return 1;
+  newline = (const char *) memchr (map->data + pos, '\n', map->size - pos);
+  return newline == NULL ? map->size : (size_t) (newline - map->data) + 1;
 }
 
-/* Given two faces and the classes of their volume trees,
- * compute the orientation of the faces to each other */
+/* Read the node section of a mapped binary .msh file of version 4.1.
+ * The nodes are split evenly among the processes in the order of the file.
+ * Each node of this process is pushed to nodes if nodes is not NULL.
+ * On output end is the position after the node data.
+ * Return 0 on success. */
 static int
-t8_msh_file_face_orientation (t8_msh_file_face_t * Face_a,
-                              t8_msh_file_face_t * Face_b,
-                              t8_eclass_t tree_class_a,
-                              t8_eclass_t tree_class_b)
+t8_msh_file_binary_nodes (const t8_cmesh_reader_file_t * map, size_t offset,
+                          int data_size, int mpirank, int mpisize,
+                          sc_array_t * nodes, size_t *end)
 {
-  long                vertex_zero;      /* The number of the first vertex of the smaller face */
-  t8_msh_file_face_t *smaller_Face, *bigger_Face;
-  int                 compare, iv;
-  t8_eclass_t         bigger_class;
-  int                 orientation = -1;
-
-  compare = t8_eclass_compare (tree_class_a, tree_class_b);
-  if (compare > 0) {
-    /* tree_class_a is bigger than tree_class_b */
-    smaller_Face = Face_b;
-    bigger_Face = Face_a;
-    bigger_class =
-      (t8_eclass_t) t8_eclass_face_types[tree_class_a][Face_a->face_number];
-  }
-  else if (compare < 0) {
-    /* tree_class_a is smaller than tree_class_b */
-    smaller_Face = Face_a;
-    bigger_Face = Face_b;
-    bigger_class =
-      (t8_eclass_t) t8_eclass_face_types[tree_class_b][Face_b->face_number];
+  const char         *data = map->data;
+  const size_t        header_size = 3 * sizeof (int) + data_size;
+  size_t              pos = offset, num_blocks, num_nodes, num_block_nodes;
+  size_t              my_first, my_last, position = 0, in, block_first;
+  size_t              block_last, num_coords, iblock;
+  t8_cmesh_reader_node_t node;
+
+  if (pos + 4 * data_size > map->size) {
+    return -1;
   }
-  else {
-    /* both classes are the same, thus
-     * the face with the smaller tree id is the smaller one */
-    if (Face_a->ltree_id < Face_b->ltree_id) {
-      smaller_Face = Face_a;
-      bigger_Face = Face_b;
-      bigger_class =
-        (t8_eclass_t) t8_eclass_face_types[tree_class_b][Face_b->face_number];
+  /* The section starts with the number of blocks, the number of nodes
+   * and the minimum and maximum node tag */
+  num_blocks = t8_msh_file_binary_size (data + pos, data_size);
+  num_nodes = t8_msh_file_binary_size (data + pos + data_size, data_size);
+  pos += 4 * data_size;
+  my_first = num_nodes / mpisize * mpirank
+    + SC_MIN ((size_t) mpirank, num_nodes % mpisize);
+  my_last = num_nodes / mpisize * (mpirank + 1)
+    + SC_MIN ((size_t) mpirank + 1, num_nodes % mpisize);
+  for (iblock = 0; iblock < num_blocks; iblock++) {
+    /* Each block has the entity dimension, the entity tag, a parametric
+     * flag and the number of nodes. Then follow all node tags and then
+     * the coordinates of all nodes. */
+    if (pos + header_size > map->size) {
+      return -1;
     }
-    else {
-      smaller_Face = Face_b;
-      bigger_Face = Face_a;
-      bigger_class =
-        (t8_eclass_t) t8_eclass_face_types[tree_class_a][Face_a->face_number];
+    num_coords = 3;
+    if (t8_msh_file_binary_int (data + pos + 2 * sizeof (int))) {
+      num_coords += t8_msh_file_binary_int (data + pos);
     }
-  }
-  vertex_zero = smaller_Face->vertices[0];
-  /* Find which point in the bigger face is vertex_zero */
-  for (iv = 0; iv < t8_eclass_num_vertices[bigger_class]; iv++) {
-    if (vertex_zero == bigger_Face->vertices[iv]) {
-      /* We found the corresponding vertex */
-      orientation = iv;
-      /* set condition to break the loop */
-      iv = t8_eclass_num_vertices[bigger_class];
+    num_block_nodes =
+      t8_msh_file_binary_size (data + pos + 3 * sizeof (int), data_size);
+    pos += header_size;
+    if (pos + num_block_nodes * (data_size + num_coords * sizeof (double))
+        > map->size) {
+      return -1;
+    }
+    block_first = SC_MAX (my_first, position);
+    block_last = SC_MIN (my_last, position + num_block_nodes);
+    if (nodes == NULL) {
+      block_last = block_first;
+    }
+    for (in = block_first; in < block_last; in++) {
+      node.index = (long)
+        t8_msh_file_binary_size (data + pos + (in - position) * data_size,
+                                 data_size);
+      memcpy (node.coordinates, data + pos + num_block_nodes * data_size
+              + (in - position) * num_coords * sizeof (double),
+              3 * sizeof (double));
+      *(t8_cmesh_reader_node_t *) sc_array_push (nodes) = node;
     }
+    pos += num_block_nodes * (data_size + num_coords * sizeof (double));
+    position += num_block_nodes;
   }
-  T8_ASSERT (orientation >= 0);
-  return orientation;
+  *end = pos;
+  return 0;
 }
 
-/* Given the number of vertices and for each element a list of its
- * vertices, find the neighborship relations of each element */
-/* This routine does only find neighbors between local trees.
- * Use with care if cmesh is partitioned. */
-static void
-t8_cmesh_msh_file_find_neighbors (t8_cmesh_t cmesh,
-                                  sc_array_t * vertex_indices)
+/* Read the element section of a mapped binary .msh file of version 4.1.
+ * The elements are split evenly among the processes in the order of
+ * the file. Each element of this process with dimension dim is pushed
+ * to trees if trees is not NULL. On output end is the position after the
+ * element data. Return 0 on success. */
+static int
+t8_msh_file_binary_elements (const t8_cmesh_reader_file_t * map,
+                             size_t offset, int data_size, int dim,
+                             int mpirank, int mpisize, sc_array_t * trees,
+                             size_t *end)
 {
-  sc_hash_t          *faces;
-  t8_msh_file_face_t *Face, **pNeighbor, *Neighbor;
-  sc_mempool_t       *face_mempool;
-  t8_gloidx_t         gtree_it;
-  t8_gloidx_t         gtree_id, gtree_neighbor;
-  t8_eclass_t         eclass, face_class, neighbor_tclass;
-  int                 num_face_vertices, face_it, vertex_it;
-  int                 retval, orientation;
-  long               *tree_vertices;
-  t8_stash_class_struct_t *class_entry;
+  const char         *data = map->data;
+  const size_t        header_size = 3 * sizeof (int) + data_size;
+  size_t              pos = offset, num_blocks, num_elements;
+  size_t              num_block_elements, entry_size, my_first, my_last;
+  size_t              position = 0, ie, block_first, block_last, iblock;
+  long                node_indices[T8_ECLASS_MAX_CORNERS];
+  const char         *entry;
+  t8_cmesh_reader_tree_t tree;
+  t8_eclass_t         eclass;
+  int                 element_type, iv, num_vertices;
 
-  face_mempool = sc_mempool_new (sizeof (t8_msh_file_face_t));
-  faces = sc_hash_new (t8_msh_file_face_hash, t8_msh_file_face_equal,
-                       cmesh, NULL);
+  if (pos + 4 * data_size > map->size) {
+    return -1;
+  }
+  num_blocks = t8_msh_file_binary_size (data + pos, data_size);
+  num_elements = t8_msh_file_binary_size (data + pos + data_size, data_size);
+  pos += 4 * data_size;
+  my_first = num_elements / mpisize * mpirank
+    + SC_MIN ((size_t) mpirank, num_elements % mpisize);
+  my_last = num_elements / mpisize * (mpirank + 1)
+    + SC_MIN ((size_t) mpirank + 1, num_elements % mpisize);
+  for (iblock = 0; iblock < num_blocks; iblock++) {
+    /* Each block has the entity dimension, the entity tag, the element
+     * type and the number of elements. Then follow the elements, each
+     * with its tag and its node tags. */
+    if (pos + header_size > map->size) {
+      return -1;
+    }
+    element_type = t8_msh_file_binary_int (data + pos + 2 * sizeof (int));
+    if (element_type <= 0 || element_type > T8_NUM_GMSH_ELEM_CLASSES) {
+      t8_global_errorf ("Unsupported gmsh element type %i\n", element_type);
+      return -1;
+    }
+    num_block_elements =
+      t8_msh_file_binary_size (data + pos + 3 * sizeof (int), data_size);
+    pos += header_size;
+    entry_size = (1 + t8_msh_element_type_num_nodes[element_type])
+      * data_size;
+    if (pos + num_block_elements * entry_size > map->size) {
+      return -1;
+    }
+    eclass = t8_msh_tree_type_to_eclass[element_type];
+    if (trees != NULL && eclass != T8_ECLASS_COUNT
+        && t8_eclass_to_dimension[eclass] == dim) {
+      num_vertices = t8_eclass_num_vertices[eclass];
+      block_first = SC_MAX (my_first, position);
+      block_last = SC_MIN (my_last, position + num_block_elements);
+      for (ie = block_first; ie < block_last; ie++) {
+        entry = data + pos + (ie - position) * entry_size + data_size;
+        for (iv = 0; iv < num_vertices; iv++) {
+          node_indices[iv] = (long)
+            t8_msh_file_binary_size (entry + iv * data_size, data_size);
+        }
+        for (iv = 0; iv < num_vertices; iv++) {
+          tree.vertices[iv] =
+            node_indices[t8_vertex_to_msh_vertex_num[eclass][iv]];
+        }
+        tree.eclass = eclass;
+        *(t8_cmesh_reader_tree_t *) sc_array_push (trees) = tree;
+      }
+    }
+    pos += num_block_elements * entry_size;
+    position += num_block_elements;
+  }
+  *end = pos;
+  return 0;
+}
 
-  /* TODO: Does currently not work with partitioned cmesh */
-  T8_ASSERT (!cmesh->set_partition);
-  /* The cmesh is not allowed to be committed yet */
-  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
-  t8_debugf ("Starting to find tree neighbors\n");
-  /* Iterate over all local trees */
-  for (gtree_it = 0;
-       gtree_it < (t8_gloidx_t) cmesh->stash->classes.elem_count;
-       gtree_it++) {
-    /* We get the class of the current tree.
-     * Since we know that the trees were put into the stash in order
-     * of their tree id's, we can just read the correspoding entry from
-     * the stash.
-     * !WARNING: This does not work in general to find the class of a tree
-     *    since the order in which the trees are added to the stash is arbitrary.
-     *    Use t8_stash_class_bsearch in tat case.
-     */
-    class_entry = (t8_stash_class_struct_t *)
-      t8_sc_array_index_locidx (&cmesh->stash->classes, gtree_it);
-    T8_ASSERT (class_entry->id == gtree_it);
-    eclass = class_entry->eclass;
-    /* Get the vertices of that tree */
-    tree_vertices = *(long **) t8_sc_array_index_locidx (vertex_indices,
-                                                         gtree_it);
-    /* loop over all faces of the tree */
-    for (face_it = 0; face_it < t8_eclass_num_faces[eclass]; face_it++) {
-      /* Create the Face struct */
-      Face = (t8_msh_file_face_t *) sc_mempool_alloc (face_mempool);
-      /* Get its eclass and the number of vertices */
-      face_class = (t8_eclass_t) t8_eclass_face_types[eclass][face_it];
-      num_face_vertices = t8_eclass_num_vertices[face_class];
-      Face->vertices = T8_ALLOC (long, num_face_vertices);
-      Face->num_vertices = num_face_vertices;
-      Face->ltree_id = gtree_it;
-      Face->face_number = face_it;
-      /* Copy the vertices of the face to the face struct */
-      for (vertex_it = 0; vertex_it < num_face_vertices; vertex_it++) {
-        Face->vertices[vertex_it] =
-          tree_vertices[t8_face_vertex_to_tree_vertex[eclass][face_it]
-                        [vertex_it]];
+/* Find the data of the $Nodes and $Elements sections of a mapped binary
+ * .msh file of version 4.1 and check that the file has our endianness.
+ * On output offsets stores the positions of the first data byte
+ * of the two sections. Return 0 on success. */
+static int
+t8_msh_file_binary_find_sections (const t8_cmesh_reader_file_t * map,
+                                  int *data_size, size_t offsets[2])
+{
+  char                name[BUFSIZ], end_name[BUFSIZ + 8];
+  size_t              pos = 0, line_end, end_length;
+  int                 found = 0;
+
+  offsets[0] = offsets[1] = 0;
+  *data_size = 0;
+  while (pos < map->size && found < 2) {
+    /* Skip whitespace between the sections */
+    while (pos < map->size && isspace ((unsigned char) map->data[pos])) {
+      pos++;
+    }
+    if (pos >= map->size) {
+      break;
+    }
+    line_end = t8_msh_file_binary_next_line (map, pos);
+    if (map->data[pos] != '$' || line_end - pos >= BUFSIZ) {
+      return -1;
+    }
+    memcpy (name, map->data + pos + 1, line_end - pos - 1);
+    name[line_end - pos - 1] = '\0';
+    /* Remove the trailing newline and carriage return */
+    name[strcspn (name, "\r\n")] = '\0';
+    pos = line_end;
+    if (!strcmp (name, "MeshFormat")) {
+      line_end = t8_msh_file_binary_next_line (map, pos);
+      if (line_end - pos >= BUFSIZ) {
+        return -1;
+      }
+      memcpy (end_name, map->data + pos, line_end - pos);
+      end_name[line_end - pos] = '\0';
+      if (t8_msh_file_parse_format (end_name, data_size) != 1
+          || (*data_size != 4 && *data_size != 8)
+          || line_end + sizeof (int) > map->size
+          || t8_msh_file_binary_int (map->data + line_end) != 1) {
+        /* This is not a binary file of version 4.1 or it was written
+         * with a different endianness. */
+        return -1;
+      }
+      pos = line_end + sizeof (int);
+    }
+    else if (*data_size == 0) {
+      /* The format must be the first section */
+      return -1;
+    }
+    else if (!strcmp (name, "Nodes")) {
+      /* We skip the node data by reading the block headers */
+      offsets[0] = pos;
+      found++;
+      if (t8_msh_file_binary_nodes (map, pos, *data_size, 0, 1, NULL, &pos)) {
+        return -1;
       }
-      /* Try to insert the face into the hash */
-      retval = sc_hash_insert_unique (faces, Face, (void ***) &pNeighbor);
-      if (!retval) {
-        /* The face was already in the hash */
-        Neighbor = *pNeighbor;
-        T8_ASSERT (Neighbor->ltree_id != gtree_it);
-        /* The current tree is a neighbor to the tree Neighbor->ltree_id */
-        /* We need to identify the face number and the orientation */
-        gtree_id = gtree_it;
-        gtree_neighbor = Neighbor->ltree_id;
-        /* Compute the orientation of the face connection */
-        /* Get the element class of the neighbor tree */
-        class_entry = (t8_stash_class_struct_t *)
-          t8_sc_array_index_locidx (&cmesh->stash->classes,
-                                    Neighbor->ltree_id);
-        T8_ASSERT (class_entry->id == Neighbor->ltree_id);
-        neighbor_tclass = class_entry->eclass;
-        /* Calculate the orientation */
-        orientation = t8_msh_file_face_orientation (Face, Neighbor, eclass,
-                                                    neighbor_tclass);
-        /* Set the face connection */
-        t8_cmesh_set_join (cmesh, gtree_id, gtree_neighbor, face_it,
-                           Neighbor->face_number, orientation);
-        T8_FREE (Face->vertices);
-        sc_mempool_free (face_mempool, Face);
-        /* We can free the neighbor here as well */
-        sc_hash_remove (faces, Neighbor, NULL);
-        T8_FREE (Neighbor->vertices);
-        sc_mempool_free (face_mempool, Neighbor);
+    }
+    else if (!strcmp (name, "Elements")) {
+      offsets[1] = pos;
+      found++;
+      if (t8_msh_file_binary_elements (map, pos, *data_size, 0, 0, 1, NULL,
+                                       &pos)) {
+        return -1;
       }
     }
+    /* Skip the rest of the section by searching for its end */
+    snprintf (end_name, BUFSIZ + 8, "$End%s", name);
+    end_length = strlen (end_name);
+    while (pos + end_length <= map->size
+           && (map->data[pos] != '$'
+               || memcmp (map->data + pos, end_name, end_length))) {
+      pos++;
+    }
+    pos = t8_msh_file_binary_next_line (map, SC_MIN (pos, map->size - 1));
   }
-  /* The remaining faces are domain boundaries */
-  sc_hash_foreach (faces, t8_msh_file_face_set_boundary);
-  /* Free the faces and the hash */
-  sc_hash_foreach (faces, t8_msh_file_face_free);
-  sc_mempool_destroy (face_mempool);
-  sc_hash_destroy (faces);
-  t8_debugf ("Done finding tree neighbors.\n");
+  return found == 2 && offsets[0] > 0 && offsets[1] > 0 ? 0 : -1;
+}
+
+/* Read the trees of a binary .msh file of version 4.1 into a cmesh.
+ * As in t8_cmesh_msh_file_read_eles, the vertex indices of each tree are
+ * stored in vertex_indices in t8code order. Return 0 on success. */
+static int
+t8_cmesh_msh_file_read_binary (t8_cmesh_t cmesh, const char *filename,
+                               int dim, sc_array_t ** vertex_indices)
+{
+  t8_cmesh_reader_file_t map;
+  sc_array_t          nodes, trees;
+  t8_cmesh_reader_node_t node, *pnode;
+  t8_cmesh_reader_tree_t *ptree;
+  double              tree_vertices[3 * T8_ECLASS_MAX_CORNERS];
+  size_t              offsets[2], end, iz, jz;
+  long               *stored_indices;
+  int                 data_size, iv, num_vertices, retval = -1;
+
+  *vertex_indices = sc_array_new (sizeof (long *));
+  if (t8_cmesh_reader_file_map (filename, &map)) {
+    t8_global_errorf ("Could not map file %s\n", filename);
+    return -1;
+  }
+  sc_array_init (&nodes, sizeof (t8_cmesh_reader_node_t));
+  sc_array_init (&trees, sizeof (t8_cmesh_reader_tree_t));
+  if (t8_msh_file_binary_find_sections (&map, &data_size, offsets)
+      || t8_msh_file_binary_nodes (&map, offsets[0], data_size, 0, 1, &nodes,
+                                   &end)
+      || t8_msh_file_binary_elements (&map, offsets[1], data_size, dim, 0, 1,
+                                      &trees, &end)) {
+    t8_global_errorf ("Error reading binary file %s\n", filename);
+    goto die_binary;
+  }
+  sc_array_sort (&nodes, t8_cmesh_reader_node_compare);
+  for (iz = 0; iz < trees.elem_count; iz++) {
+    ptree = (t8_cmesh_reader_tree_t *) sc_array_index (&trees, iz);
+    num_vertices = t8_eclass_num_vertices[ptree->eclass];
+    for (iv = 0; iv < num_vertices; iv++) {
+      node.index = ptree->vertices[iv];
+      jz = sc_array_bsearch (&nodes, &node, t8_cmesh_reader_node_compare);
+      if (jz == (size_t) - 1) {
+        t8_global_errorf ("Node %li is not in the file.\n", node.index);
+        goto die_binary;
+      }
+      pnode = (t8_cmesh_reader_node_t *) sc_array_index (&nodes, jz);
+      memcpy (tree_vertices + 3 * iv, pnode->coordinates,
+              3 * sizeof (double));
+    }
+    t8_cmesh_reader_correct_volume (ptree, tree_vertices, iz);
+    t8_cmesh_set_tree_class (cmesh, iz, (t8_eclass_t) ptree->eclass);
+    t8_cmesh_set_tree_vertices (cmesh, iz, t8_get_package_id (), 0,
+                                tree_vertices, num_vertices);
+    stored_indices = T8_ALLOC (long, num_vertices);
+    memcpy (stored_indices, ptree->vertices, num_vertices * sizeof (long));
+    *(long **) sc_array_push (*vertex_indices) = stored_indices;
+  }
+  retval = 0;
+die_binary:
+  sc_array_reset (&nodes);
+  sc_array_reset (&trees);
+  t8_cmesh_reader_file_unmap (&map);
+  return retval;
 }
 
 t8_cmesh_t
@@ -711,6 +1167,7 @@ t8_cmesh_from_msh_file (const char *fileprefix, int partition,
   char                current_file[BUFSIZ];
   FILE               *file;
   t8_gloidx_t         num_trees, first_tree, last_tree = -1;
+  int                 data_size, binary;
 
   mpiret = sc_MPI_Comm_size (comm, &mpisize);
   SC_CHECK_MPI (mpiret);
@@ -737,16 +1194,39 @@ t8_cmesh_from_msh_file (const char *fileprefix, int partition,
       t8_global_errorf ("Could not open file %s\n", current_file);
       return NULL;
     }
-    /* read nodes from the file */
-    vertices = t8_msh_file_read_nodes (file, &num_vertices, &node_mempool);
-    t8_cmesh_msh_file_read_eles (cmesh, file, vertices, &vertex_indices, dim);
-    /* close the file and free the memory for the nodes */
-    fclose (file);
-    t8_cmesh_msh_file_find_neighbors (cmesh, vertex_indices);
-    if (vertices != NULL) {
-      sc_hash_destroy (vertices);
+    binary = t8_msh_file_is_binary_v4 (file, &data_size);
+    if (binary < 0) {
+      fclose (file);
+      t8_cmesh_destroy (&cmesh);
+      return NULL;
+    }
+    if (binary) {
+      /* Binary files are read from a memory map */
+      fclose (file);
+      if (t8_cmesh_msh_file_read_binary (cmesh, current_file, dim,
+                                         &vertex_indices)) {
+        while (vertex_indices->elem_count > 0) {
+          indices_entry = *(long **) sc_array_pop (vertex_indices);
+          T8_FREE (indices_entry);
+        }
+        sc_array_destroy (vertex_indices);
+        t8_cmesh_destroy (&cmesh);
+        return NULL;
+      }
     }
-    sc_mempool_destroy (node_mempool);
+    else {
+      /* read nodes from the file */
+      vertices = t8_msh_file_read_nodes (file, &num_vertices, &node_mempool);
+      t8_cmesh_msh_file_read_eles (cmesh, file, vertices, &vertex_indices,
+                                   dim);
+      /* close the file and free the memory for the nodes */
+      fclose (file);
+      if (vertices != NULL) {
+        sc_hash_destroy (vertices);
+      }
+      sc_mempool_destroy (node_mempool);
+    }
+    t8_cmesh_msh_file_find_neighbors (cmesh, vertex_indices);
     while (vertex_indices->elem_count > 0) {
       indices_entry = *(long **) sc_array_pop (vertex_indices);
       T8_FREE (indices_entry);
@@ -785,3 +1265,159 @@ t8_cmesh_from_msh_file (const char *fileprefix, int partition,
   }
   return cmesh;
 }
+
+t8_cmesh_t
+t8_cmesh_from_msh_file_parallel (const char *fileprefix, sc_MPI_Comm comm,
+                                 int dim)
+{
+  int                 mpirank, mpisize, mpiret, ok = 1;
+  char                current_file[BUFSIZ];
+  char               *line = NULL;
+  size_t              linen = 0;
+  FILE               *file;
+  long                sections[6], my_end = 0;
+  size_t              offsets[2], end;
+  t8_cmesh_reader_file_t map;
+  int                 binary, data_size, eclass;
+  t8_cmesh_reader_node_t node;
+  t8_cmesh_reader_tree_t tree;
+  sc_array_t          nodes, trees;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  snprintf (current_file, BUFSIZ, "%s.msh", fileprefix);
+  t8_debugf ("Opening file %s\n", current_file);
+  file = fopen (current_file, "r");
+  if (!t8_cmesh_reader_all_ok (file != NULL, comm)) {
+    t8_global_errorf ("Could not open file %s\n", current_file);
+    if (file != NULL) {
+      fclose (file);
+    }
+    return NULL;
+  }
+  binary = t8_msh_file_is_binary_v4 (file, &data_size);
+  if (!t8_cmesh_reader_all_ok (binary >= 0, comm)) {
+    fclose (file);
+    return NULL;
+  }
+  if (binary) {
+    /* Each process maps the file and finds the sections by reading
+     * the block headers */
+    fclose (file);
+    file = NULL;
+    if (t8_cmesh_reader_file_map (current_file, &map)) {
+      ok = 0;
+    }
+    else if (t8_msh_file_binary_find_sections (&map, &data_size, offsets)) {
+      t8_cmesh_reader_file_unmap (&map);
+      ok = 0;
+    }
+    if (!t8_cmesh_reader_all_ok (ok, comm)) {
+      if (ok) {
+        t8_cmesh_reader_file_unmap (&map);
+      }
+      t8_global_errorf ("Could not find the nodes and elements in %s\n",
+                        current_file);
+      return NULL;
+    }
+  }
+  else {
+    /* The first process finds the sections and tells the others */
+    if (mpirank == 0 && t8_msh_file_find_sections (file, sections)) {
+      t8_global_errorf ("Could not find the nodes and elements in %s\n",
+                        current_file);
+      sections[0] = -1;
+    }
+    mpiret = sc_MPI_Bcast (sections, 6, sc_MPI_LONG, 0, comm);
+    SC_CHECK_MPI (mpiret);
+    if (sections[0] < 0) {
+      fclose (file);
+      return NULL;
+    }
+  }
+
+  sc_array_init (&nodes, sizeof (t8_cmesh_reader_node_t));
+  sc_array_init (&trees, sizeof (t8_cmesh_reader_tree_t));
+
+  /* Read our part of the nodes */
+  if (binary) {
+    ok = !t8_msh_file_binary_nodes (&map, offsets[0], data_size, mpirank,
+                                    mpisize, &nodes, &end);
+  }
+  else {
+    my_end = t8_cmesh_reader_seek_range (file, sections[1], sections[2],
+                                         mpirank, mpisize, &line, &linen);
+  }
+  while (!binary && ok && ftell (file) < my_end
+         && getline (&line, &linen, file) >= 0) {
+    if (strspn (line, " \t\r\v\n") == strlen (line)) {
+      continue;
+    }
+    if (sscanf (line, "%li %lf %lf %lf", &node.index, &node.coordinates[0],
+                &node.coordinates[1], &node.coordinates[2]) != 4
+        || node.index < 0) {
+      t8_errorf ("Error reading node line %s", line);
+      ok = 0;
+      break;
+    }
+    *(t8_cmesh_reader_node_t *) sc_array_push (&nodes) = node;
+  }
+  ok = t8_cmesh_reader_all_ok (ok, comm);
+  if (!ok) {
+    if (binary) {
+      t8_cmesh_reader_file_unmap (&map);
+    }
+    else {
+      fclose (file);
+      free (line);
+    }
+    goto die_parallel;
+  }
+
+  /* Read our part of the elements */
+  if (binary) {
+    ok = !t8_msh_file_binary_elements (&map, offsets[1], data_size, dim,
+                                       mpirank, mpisize, &trees, &end);
+  }
+  else {
+    my_end = t8_cmesh_reader_seek_range (file, sections[4], sections[5],
+                                         mpirank, mpisize, &line, &linen);
+  }
+  while (!binary && ok && ftell (file) < my_end
+         && getline (&line, &linen, file) >= 0) {
+    if (strspn (line, " \t\r\v\n") == strlen (line)) {
+      continue;
+    }
+    eclass = t8_msh_file_parse_element (line, tree.vertices);
+    if (eclass < 0 || eclass == T8_ECLASS_COUNT) {
+      t8_errorf ("Error reading element line %s", line);
+      ok = 0;
+      break;
+    }
+    if (t8_eclass_to_dimension[eclass] == dim) {
+      tree.eclass = eclass;
+      *(t8_cmesh_reader_tree_t *) sc_array_push (&trees) = tree;
+    }
+  }
+  if (binary) {
+    t8_cmesh_reader_file_unmap (&map);
+  }
+  else {
+    fclose (file);
+    free (line);
+  }
+  ok = t8_cmesh_reader_all_ok (ok, comm);
+  if (!ok) {
+    goto die_parallel;
+  }
+  /* The trees are numbered in the order of the file */
+  return t8_cmesh_reader_build (&nodes, &trees, dim, comm, 0);
+
+die_parallel:
+  sc_array_reset (&nodes);
+  sc_array_reset (&trees);
+  return NULL;
+}
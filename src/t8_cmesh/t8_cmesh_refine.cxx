@@ -886,8 +886,35 @@ t8_cmesh_refine_count_ghost (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
   return num_ghosts;
 }
 
+/* Compute the partition table of a cmesh that is refined from a
+ * partitioned cmesh. Each process keeps the children of its trees, thus
+ * the new offsets are the old offsets times the refinement factor and
+ * no communication is needed. */
+static void
+t8_cmesh_refine_offsets (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
+                         int factor, sc_MPI_Comm comm)
+{
+  const t8_gloidx_t  *from_offsets;
+  int                 iproc;
+
+  T8_ASSERT (cmesh_from->tree_offsets != NULL);
+  from_offsets = t8_shmem_array_get_gloidx_array (cmesh_from->tree_offsets);
+  for (iproc = 0; iproc < cmesh->mpisize; iproc++) {
+    /* We check the offsets of all processes, such that all processes
+     * abort if any process has a shared first tree */
+    SC_CHECK_ABORT (from_offsets[iproc] >= 0,
+                    "Refining a partioned cmesh with shared first trees "
+                    "is not implemented yet.\n");
+  }
+  cmesh->tree_offsets = t8_cmesh_alloc_offsets (cmesh->mpisize, comm);
+  for (iproc = 0; iproc <= cmesh->mpisize; iproc++) {
+    t8_shmem_array_set_gloidx (cmesh->tree_offsets, iproc,
+                               from_offsets[iproc] * factor);
+  }
+}
+
 void
-t8_cmesh_refine (t8_cmesh_t cmesh)
+t8_cmesh_refine (t8_cmesh_t cmesh, sc_MPI_Comm comm)
 {
   t8_cmesh_t          cmesh_from;
   t8_locidx_t         itree, firstnewtree;
@@ -923,9 +950,20 @@ t8_cmesh_refine (t8_cmesh_t cmesh)
     /* TODO: This does not work with pyramids */
     cmesh->num_trees_per_eclass[iclass] =
       cmesh_from->num_trees_per_eclass[iclass] * factor;
+    cmesh->num_local_trees_per_eclass[iclass] =
+      cmesh_from->num_local_trees_per_eclass[iclass] * factor;
   }
 
   cmesh->first_tree = cmesh_from->first_tree * factor;
+  if (cmesh_from->set_partition) {
+    /* A partitioned cmesh is refined in place. Each process refines its
+     * local trees and ghosts, the refined cmesh is partitioned as well. */
+    cmesh->set_partition = 1;
+    cmesh->first_tree_shared = 0;
+    if (cmesh->tree_offsets == NULL) {
+      t8_cmesh_refine_offsets (cmesh, cmesh_from, factor, comm);
+    }
+  }
 
   /* Count the number of new ghosts and temporarily store their local ids */
   idarray = t8_cmesh_refine_init_idarray (cmesh_from);
@@ -61,11 +61,15 @@ T8_EXTERN_C_BEGIN ();
  */
 
 /** Populate a cmesh that is derived via refinement from another cmesh.
+ * If the cmesh to refine is partitioned, each process refines its local
+ * trees and ghosts and the refined cmesh is partitioned in the same way.
+ * Its partition table is computed without communication.
  * \param [in,out]  cmesh       The cmesh to be populated. Its set_from entry has
  *                              to be set to a committed cmesh and its set_refine_level
  *                              entry has to be positive.
+ * \param [in]      comm        The communicator of the cmesh.
  */
-void                t8_cmesh_refine (t8_cmesh_t cmesh);
+void                t8_cmesh_refine (t8_cmesh_t cmesh, sc_MPI_Comm comm);
 
 T8_EXTERN_C_END ();
 
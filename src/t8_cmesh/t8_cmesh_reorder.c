@@ -0,0 +1,909 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <float.h>
+#include <t8_data/t8_shmem.h>
+#include "t8_cmesh_types.h"
+#include "t8_cmesh_trees.h"
+#include "t8_cmesh_offset.h"
+#include "t8_cmesh_reader.h"
+#if defined (T8_WITH_PARMETIS) && defined (SC_ENABLE_MPI)
+#include <parmetis.h>
+#endif
+
+/* The partitioned reorderings work as follows.
+ * Each tree belongs to the smallest process that has it as local tree.
+ * The reordering computes a new global id and a new process for each tree
+ * such that the trees of process p get consecutive ids and come before
+ * those of process p + 1.
+ * Each process asks the owners of its neighbor trees for their new ids.
+ * Then each tree is sent together with its face connections and its
+ * attributes to its new process, which builds the new cmesh.
+ * A committed cmesh knows all face connections of its ghosts, also those
+ * to other ghosts. Thus each tree is also sent with its face connections,
+ * but without its attributes, to each new process of a neighbor tree.
+ * If the old cmesh carries ghost attributes, the new ghosts fetch them
+ * from the new owners of their trees afterwards. */
+
+/* The records of a tree are padded to this many bytes */
+#define T8_CMESH_REORDER_ALIGN 8
+
+/* The header of a tree record. It is followed by one
+ * t8_cmesh_reorder_face_t for each face of the tree and one
+ * t8_cmesh_reorder_attribute_t plus the attribute data for each attribute. */
+typedef struct
+{
+  t8_gloidx_t         new_id;   /* The new global id of the tree */
+  int                 eclass;   /* The class of the tree */
+  int                 is_ghost; /* True for a ghost of the receiver */
+  int                 num_attributes;   /* The number of attributes */
+} t8_cmesh_reorder_tree_t;
+
+/* A face of a tree record */
+typedef struct
+{
+  /* The new global id of the neighbor tree, -1 at the domain boundary */
+  t8_gloidx_t         neighbor;
+  int8_t              face;     /* The face number in the neighbor */
+  int8_t              orientation;      /* The orientation of the connection */
+} t8_cmesh_reorder_face_t;
+
+/* The header of an attribute of a tree record */
+typedef struct
+{
+  int                 package_id;
+  int                 key;
+  size_t              size;     /* The number of bytes of the data */
+} t8_cmesh_reorder_attribute_t;
+
+/* The identifier of an attribute */
+typedef struct
+{
+  int                 package_id;
+  int                 key;
+} t8_cmesh_reorder_key_t;
+
+static int
+t8_cmesh_reorder_gloidx_compare (const void *a, const void *b)
+{
+  const t8_gloidx_t   ga = *(const t8_gloidx_t *) a;
+  const t8_gloidx_t   gb = *(const t8_gloidx_t *) b;
+
+  return ga < gb ? -1 : ga > gb;
+}
+
+static int
+t8_cmesh_reorder_key_compare (const void *a, const void *b)
+{
+  const t8_cmesh_reorder_key_t *ka = (const t8_cmesh_reorder_key_t *) a;
+  const t8_cmesh_reorder_key_t *kb = (const t8_cmesh_reorder_key_t *) b;
+
+  if (ka->package_id != kb->package_id) {
+    return ka->package_id < kb->package_id ? -1 : 1;
+  }
+  return ka->key < kb->key ? -1 : ka->key > kb->key;
+}
+
+/* Append bytes to a record buffer of element size 1, padded to
+ * T8_CMESH_REORDER_ALIGN, and return a pointer to them. */
+static void        *
+t8_cmesh_reorder_push (sc_array_t * buffer, size_t bytes)
+{
+  const size_t        padded = (bytes + T8_CMESH_REORDER_ALIGN - 1)
+    / T8_CMESH_REORDER_ALIGN * T8_CMESH_REORDER_ALIGN;
+  void               *data;
+
+  T8_ASSERT (buffer->elem_size == 1);
+  data = sc_array_push_count (buffer, padded);
+  memset (data, 0, padded);
+  return data;
+}
+
+/* Read bytes from a record buffer that were appended with
+ * t8_cmesh_reorder_push and advance the position. */
+static void        *
+t8_cmesh_reorder_pop (sc_array_t * buffer, size_t * pos, size_t bytes)
+{
+  void               *data = sc_array_index (buffer, *pos);
+
+  *pos += (bytes + T8_CMESH_REORDER_ALIGN - 1)
+    / T8_CMESH_REORDER_ALIGN * T8_CMESH_REORDER_ALIGN;
+  T8_ASSERT (*pos <= buffer->elem_count);
+  return data;
+}
+
+/* Compute the old global id of the face neighbor of a local tree, together
+ * with the face number and the orientation of the connection.
+ * Return -1 if the face is at the domain boundary. */
+static              t8_gloidx_t
+t8_cmesh_reorder_neighbor (t8_cmesh_t cmesh, t8_locidx_t ltree, int iface,
+                           int *face, int *orientation)
+{
+  const int           F = t8_eclass_max_num_faces[cmesh->dimension];
+  t8_locidx_t        *face_neighbor, lneighbor;
+  int8_t             *ttf;
+
+  (void) t8_cmesh_trees_get_tree_ext (cmesh->trees, ltree, &face_neighbor,
+                                      &ttf);
+  lneighbor = face_neighbor[iface];
+  *face = ttf[iface] % F;
+  *orientation = ttf[iface] / F;
+  if (lneighbor == ltree && *face == iface) {
+    /* The face is connected to itself, this is a boundary face */
+    return -1;
+  }
+  if (lneighbor < cmesh->num_local_trees) {
+    return cmesh->first_tree + lneighbor;
+  }
+  return t8_cmesh_trees_get_ghost (cmesh->trees,
+                                   lneighbor - cmesh->num_local_trees)->treeid;
+}
+
+/* Return the new id of a tree that is owned by this process or that
+ * is a requested neighbor. */
+static              t8_gloidx_t
+t8_cmesh_reorder_lookup (t8_gloidx_t gtree, t8_gloidx_t first_owned,
+                         t8_locidx_t num_owned, const t8_gloidx_t * new_ids,
+                         sc_array_t * requests, sc_array_t * replies)
+{
+  ssize_t             index;
+
+  if (first_owned <= gtree && gtree < first_owned + num_owned) {
+    return new_ids[gtree - first_owned];
+  }
+  index = sc_array_bsearch (requests, &gtree,
+                            t8_cmesh_reorder_gloidx_compare);
+  T8_ASSERT (index >= 0);
+  return *(t8_gloidx_t *) sc_array_index (replies, index);
+}
+
+/* A received tree record */
+typedef struct
+{
+  t8_cmesh_reorder_tree_t *tree;
+  t8_cmesh_reorder_face_t *faces;
+} t8_cmesh_reorder_parsed_t;
+
+/* Build the new cmesh from the received tree records. The identifiers of
+ * the attributes of the local trees are stored in keys. */
+static              t8_cmesh_t
+t8_cmesh_reorder_build (sc_array_t * records, int dim,
+                        t8_gloidx_t first_tree, t8_gloidx_t num_trees,
+                        int ghost_attributes, sc_array_t * keys,
+                        sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_cmesh_reorder_tree_t *tree;
+  t8_cmesh_reorder_face_t *faces;
+  t8_cmesh_reorder_attribute_t *attribute;
+  t8_cmesh_reorder_parsed_t *parsed;
+  t8_cmesh_reorder_key_t *key;
+  sc_array_t          parsed_records, ghost_ids;
+  t8_gloidx_t         neighbor;
+  size_t              pos, iz;
+  void               *data;
+  int                 iface, iatt, both_set;
+
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_dimension (cmesh, dim);
+  t8_cmesh_set_partition_ghost_attributes (cmesh, ghost_attributes);
+  /* We first set the classes and attributes and collect the ghosts */
+  sc_array_init (&parsed_records, sizeof (t8_cmesh_reorder_parsed_t));
+  sc_array_init (&ghost_ids, sizeof (t8_gloidx_t));
+  for (pos = 0; pos < records->elem_count;) {
+    tree = (t8_cmesh_reorder_tree_t *)
+      t8_cmesh_reorder_pop (records, &pos, sizeof (*tree));
+    T8_ASSERT (tree->is_ghost == (tree->new_id < first_tree
+                                  || tree->new_id >=
+                                  first_tree + num_trees));
+    t8_cmesh_set_tree_class (cmesh, tree->new_id, (t8_eclass_t) tree->eclass);
+    if (tree->is_ghost) {
+      *(t8_gloidx_t *) sc_array_push (&ghost_ids) = tree->new_id;
+    }
+    parsed = (t8_cmesh_reorder_parsed_t *) sc_array_push (&parsed_records);
+    parsed->tree = tree;
+    parsed->faces = (t8_cmesh_reorder_face_t *)
+      t8_cmesh_reorder_pop (records, &pos, t8_eclass_num_faces[tree->eclass]
+                            * sizeof (t8_cmesh_reorder_face_t));
+    for (iatt = 0; iatt < tree->num_attributes; iatt++) {
+      attribute = (t8_cmesh_reorder_attribute_t *)
+        t8_cmesh_reorder_pop (records, &pos, sizeof (*attribute));
+      data = t8_cmesh_reorder_pop (records, &pos, attribute->size);
+      t8_cmesh_set_attribute (cmesh, tree->new_id, attribute->package_id,
+                              attribute->key, data, attribute->size, 0);
+      key = (t8_cmesh_reorder_key_t *) sc_array_push (keys);
+      key->package_id = attribute->package_id;
+      key->key = attribute->key;
+    }
+  }
+  sc_array_sort (&ghost_ids, t8_cmesh_reorder_gloidx_compare);
+  sc_array_sort (keys, t8_cmesh_reorder_key_compare);
+  sc_array_uniq (keys, t8_cmesh_reorder_key_compare);
+
+  /* Set the face connections. A connection between two local trees or two
+   * ghosts arrives with both trees and we set it only once. A connection
+   * between a local tree and a ghost is set with the local tree. */
+  for (iz = 0; iz < parsed_records.elem_count; iz++) {
+    parsed = (t8_cmesh_reorder_parsed_t *)
+      sc_array_index (&parsed_records, iz);
+    tree = parsed->tree;
+    faces = parsed->faces;
+    for (iface = 0; iface < t8_eclass_num_faces[tree->eclass]; iface++) {
+      neighbor = faces[iface].neighbor;
+      if (neighbor < 0) {
+        continue;
+      }
+      both_set = first_tree <= neighbor && neighbor < first_tree + num_trees;
+      if (tree->is_ghost) {
+        if (both_set) {
+          continue;
+        }
+        both_set = sc_array_bsearch (&ghost_ids, &neighbor,
+                                     t8_cmesh_reorder_gloidx_compare) >= 0;
+      }
+      if (both_set && (neighbor < tree->new_id
+                       || (neighbor == tree->new_id
+                           && faces[iface].face < iface))) {
+        continue;
+      }
+      t8_cmesh_set_join (cmesh, tree->new_id, neighbor, iface,
+                         faces[iface].face, faces[iface].orientation);
+    }
+  }
+  sc_array_reset (&parsed_records);
+  sc_array_reset (&ghost_ids);
+  t8_cmesh_set_partition_range (cmesh, 3, first_tree,
+                                first_tree + num_trees - 1);
+  t8_cmesh_commit (cmesh, comm);
+  return cmesh;
+}
+
+/* Fetch the attributes with the identifiers keys of the ghosts of a
+ * reordered cmesh. The identifiers of all processes are fetched. */
+static void
+t8_cmesh_reorder_fetch_ghost_attributes (t8_cmesh_t cmesh, sc_array_t * keys,
+                                         sc_MPI_Comm comm)
+{
+  int                 mpisize, mpiret, irank, num_keys;
+  int                *counts, *displs;
+  sc_array_t          all_keys;
+  t8_cmesh_reorder_key_t *key;
+  size_t              iz;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  counts = T8_ALLOC (int, 2 * mpisize);
+  displs = counts + mpisize;
+  /* Each key is sent as two integers */
+  num_keys = 2 * (int) keys->elem_count;
+  mpiret = sc_MPI_Allgather (&num_keys, 1, sc_MPI_INT, counts, 1, sc_MPI_INT,
+                             comm);
+  SC_CHECK_MPI (mpiret);
+  for (irank = 0, num_keys = 0; irank < mpisize; irank++) {
+    displs[irank] = num_keys;
+    num_keys += counts[irank];
+  }
+  sc_array_init_size (&all_keys, sizeof (t8_cmesh_reorder_key_t),
+                      num_keys / 2);
+  mpiret = sc_MPI_Allgatherv (keys->array, 2 * (int) keys->elem_count,
+                              sc_MPI_INT, all_keys.array, counts, displs,
+                              sc_MPI_INT, comm);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (counts);
+  sc_array_sort (&all_keys, t8_cmesh_reorder_key_compare);
+  sc_array_uniq (&all_keys, t8_cmesh_reorder_key_compare);
+  for (iz = 0; iz < all_keys.elem_count; iz++) {
+    key = (t8_cmesh_reorder_key_t *) sc_array_index (&all_keys, iz);
+    t8_cmesh_fetch_ghost_attribute (cmesh, key->package_id, key->key, comm);
+  }
+  sc_array_reset (&all_keys);
+}
+
+/* Return the new process of a tree with the new id new_id */
+static int
+t8_cmesh_reorder_new_owner (t8_gloidx_t new_id, const t8_gloidx_t * part_first,
+                            int mpisize)
+{
+  int                 low = 0, high = mpisize - 1, mid;
+
+  /* Find the last process p with part_first[p] <= new_id */
+  while (low < high) {
+    mid = (low + high + 1) / 2;
+    if (part_first[mid] <= new_id) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  T8_ASSERT (part_first[low] <= new_id && new_id < part_first[low + 1]);
+  return low;
+}
+
+/* Compute the range of the local trees that this process owns */
+static void
+t8_cmesh_reorder_owned (t8_cmesh_t cmesh, t8_locidx_t * first_lowned,
+                        t8_locidx_t * num_owned, t8_gloidx_t * first_owned)
+{
+  /* The first local tree belongs to the previous process if it is shared */
+  *first_lowned = cmesh->first_tree_shared && cmesh->num_local_trees > 0;
+  *num_owned = cmesh->num_local_trees - *first_lowned;
+  *first_owned = cmesh->first_tree + *first_lowned;
+}
+
+/* Append the record of a local tree with the new id new_id and the face
+ * connections faces to a send buffer. The record of a ghost is sent
+ * without the attributes of the tree. */
+static void
+t8_cmesh_reorder_push_tree (sc_array_t * buffer, t8_gloidx_t new_id,
+                            t8_ctree_t tree,
+                            const t8_cmesh_reorder_face_t * faces,
+                            int is_ghost)
+{
+  t8_cmesh_reorder_tree_t *record;
+  t8_cmesh_reorder_attribute_t *record_attribute;
+  t8_attribute_info_struct_t *attribute_info;
+  const int           num_faces = t8_eclass_num_faces[tree->eclass];
+  int                 iatt;
+
+  record = (t8_cmesh_reorder_tree_t *)
+    t8_cmesh_reorder_push (buffer, sizeof (*record));
+  record->new_id = new_id;
+  record->eclass = tree->eclass;
+  record->is_ghost = is_ghost;
+  record->num_attributes = is_ghost ? 0 : tree->num_attributes;
+  memcpy (t8_cmesh_reorder_push (buffer, num_faces
+                                 * sizeof (t8_cmesh_reorder_face_t)),
+          faces, num_faces * sizeof (t8_cmesh_reorder_face_t));
+  for (iatt = 0; iatt < record->num_attributes; iatt++) {
+    attribute_info = T8_TREE_ATTR_INFO (tree, iatt);
+    record_attribute = (t8_cmesh_reorder_attribute_t *)
+      t8_cmesh_reorder_push (buffer, sizeof (*record_attribute));
+    record_attribute->package_id = attribute_info->package_id;
+    record_attribute->key = attribute_info->key;
+    record_attribute->size = attribute_info->attribute_size;
+    memcpy (t8_cmesh_reorder_push (buffer, attribute_info->attribute_size),
+            T8_TREE_ATTR (tree, attribute_info),
+            attribute_info->attribute_size);
+  }
+}
+
+/* Send the owned trees of a cmesh to their new processes and build the
+ * reordered cmesh. The owned tree i gets the id new_ids[i] and is sent to
+ * process dest[i]. The new trees of process p are [part_first[p],
+ * part_first[p + 1]). The reference to cmesh is taken over. */
+static              t8_cmesh_t
+t8_cmesh_reorder_redistribute (t8_cmesh_t cmesh, sc_MPI_Comm comm,
+                               const t8_gloidx_t * new_ids, const int *dest,
+                               const t8_gloidx_t * part_first)
+{
+  int                 mpisize, mpirank, mpiret, irank, iface;
+  int                 eclass, face, orientation, some_owner;
+  int                 ghost_attributes, *recv_counts;
+  int                 ghost_ranks[T8_ECLASS_MAX_FACES];
+  t8_gloidx_t        *offsets, first_owned, gneighbor, *pgtree;
+  t8_locidx_t         first_lowned, num_owned, itree, ltree;
+  sc_array_t         *send, requests, asked, replies, records, keys;
+  t8_ctree_t          tree;
+  t8_cmesh_reorder_face_t faces[T8_ECLASS_MAX_FACES];
+  size_t              iz, num_ghost_ranks;
+  t8_cmesh_t          cmesh_new;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  t8_cmesh_reorder_owned (cmesh, &first_lowned, &num_owned, &first_owned);
+
+  /* Ask the owners of the neighbor trees for their new ids.
+   * Since the requests are sorted, so are their owners, and the replies
+   * arrive in the order of the requests. */
+  sc_array_init (&requests, sizeof (t8_gloidx_t));
+  for (itree = 0; itree < num_owned; itree++) {
+    ltree = itree + first_lowned;
+    eclass = t8_cmesh_get_tree_class (cmesh, ltree);
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      gneighbor = t8_cmesh_reorder_neighbor (cmesh, ltree, iface,
+                                             &face, &orientation);
+      if (gneighbor >= 0 && (gneighbor < first_owned
+                             || gneighbor >= first_owned + num_owned)) {
+        *(t8_gloidx_t *) sc_array_push (&requests) = gneighbor;
+      }
+    }
+  }
+  sc_array_sort (&requests, t8_cmesh_reorder_gloidx_compare);
+  sc_array_uniq (&requests, t8_cmesh_reorder_gloidx_compare);
+  offsets = t8_shmem_array_get_gloidx_array (cmesh->tree_offsets);
+  send = T8_ALLOC (sc_array_t, mpisize);
+  for (irank = 0; irank < mpisize; irank++) {
+    sc_array_init (&send[irank], sizeof (t8_gloidx_t));
+  }
+  some_owner = -1;
+  for (iz = 0; iz < requests.elem_count; iz++) {
+    pgtree = (t8_gloidx_t *) sc_array_index (&requests, iz);
+    some_owner = t8_offset_first_owner_of_tree (mpisize, *pgtree, offsets,
+                                                &some_owner);
+    *(t8_gloidx_t *) sc_array_push (&send[some_owner]) = *pgtree;
+  }
+  recv_counts = T8_ALLOC (int, mpisize);
+  sc_array_init (&asked, sizeof (t8_gloidx_t));
+  t8_cmesh_reader_exchange (send, &asked, recv_counts, mpisize, comm);
+  t8_cmesh_reader_exchange_reinit (send, sizeof (t8_gloidx_t), mpisize);
+  for (irank = 0, iz = 0; irank < mpisize; irank++) {
+    for (; recv_counts[irank] > 0; recv_counts[irank]--, iz++) {
+      pgtree = (t8_gloidx_t *) sc_array_index (&asked, iz);
+      T8_ASSERT (first_owned <= *pgtree
+                 && *pgtree < first_owned + num_owned);
+      *(t8_gloidx_t *) sc_array_push (&send[irank]) =
+        new_ids[*pgtree - first_owned];
+    }
+  }
+  sc_array_reset (&asked);
+  sc_array_init (&replies, sizeof (t8_gloidx_t));
+  t8_cmesh_reader_exchange (send, &replies, NULL, mpisize, comm);
+  T8_ASSERT (replies.elem_count == requests.elem_count);
+
+  /* Send each tree to its new process and to the new processes of its
+   * neighbor trees, which have it as a ghost */
+  t8_cmesh_reader_exchange_reinit (send, 1, mpisize);
+  for (itree = 0; itree < num_owned; itree++) {
+    ltree = itree + first_lowned;
+    tree = t8_cmesh_trees_get_tree (cmesh->trees, ltree);
+    memset (faces, 0, sizeof (faces));
+    num_ghost_ranks = 0;
+    for (iface = 0; iface < t8_eclass_num_faces[tree->eclass]; iface++) {
+      gneighbor = t8_cmesh_reorder_neighbor (cmesh, ltree, iface,
+                                             &face, &orientation);
+      faces[iface].neighbor = gneighbor < 0 ? -1 :
+        t8_cmesh_reorder_lookup (gneighbor, first_owned, num_owned, new_ids,
+                                 &requests, &replies);
+      faces[iface].face = face;
+      faces[iface].orientation = orientation;
+      if (gneighbor < 0) {
+        continue;
+      }
+      irank = t8_cmesh_reorder_new_owner (faces[iface].neighbor, part_first,
+                                          mpisize);
+      for (iz = 0; iz < num_ghost_ranks && ghost_ranks[iz] != irank; iz++) {
+      }
+      if (irank != dest[itree] && iz == num_ghost_ranks) {
+        ghost_ranks[num_ghost_ranks++] = irank;
+      }
+    }
+    t8_cmesh_reorder_push_tree (&send[dest[itree]], new_ids[itree], tree,
+                                faces, 0);
+    for (iz = 0; iz < num_ghost_ranks; iz++) {
+      t8_cmesh_reorder_push_tree (&send[ghost_ranks[iz]], new_ids[itree],
+                                  tree, faces, 1);
+    }
+  }
+  sc_array_init (&records, 1);
+  t8_cmesh_reader_exchange (send, &records, NULL, mpisize, comm);
+
+  ghost_attributes = t8_cmesh_get_partition_ghost_attributes (cmesh);
+  sc_array_init (&keys, sizeof (t8_cmesh_reorder_key_t));
+  cmesh_new = t8_cmesh_reorder_build (&records, cmesh->dimension,
+                                      part_first[mpirank],
+                                      part_first[mpirank + 1]
+                                      - part_first[mpirank],
+                                      ghost_attributes, &keys, comm);
+  if (ghost_attributes) {
+    t8_cmesh_reorder_fetch_ghost_attributes (cmesh_new, &keys, comm);
+  }
+  sc_array_reset (&keys);
+
+  for (irank = 0; irank < mpisize; irank++) {
+    sc_array_reset (&send[irank]);
+  }
+  T8_FREE (send);
+  T8_FREE (recv_counts);
+  sc_array_reset (&requests);
+  sc_array_reset (&replies);
+  sc_array_reset (&records);
+  t8_cmesh_unref (&cmesh);
+  return cmesh_new;
+}
+
+/* The number of bits per coordinate of the Morton keys */
+#define T8_CMESH_REORDER_SFC_BITS 21
+
+/* The maximal number of samples per process of the parallel sort */
+#define T8_CMESH_REORDER_SFC_SAMPLES 32
+
+/* A tree in the parallel sort along the space-filling curve */
+typedef struct
+{
+  uint64_t            key;      /* The Morton key of the centroid */
+  t8_gloidx_t         gtree_id; /* The old global id, -1 for no tree */
+  int                 origin;   /* The process that owns the tree */
+  t8_locidx_t         index;    /* The index in the owned trees of origin */
+} t8_cmesh_reorder_sfc_t;
+
+/* A new id that is sent back to the owner of a tree */
+typedef struct
+{
+  t8_gloidx_t         new_id;
+  t8_locidx_t         index;    /* The index in the owned trees */
+} t8_cmesh_reorder_sfc_id_t;
+
+/* Order trees by their Morton key and then by their old id */
+static int
+t8_cmesh_reorder_sfc_compare (const void *a, const void *b)
+{
+  const t8_cmesh_reorder_sfc_t *ta = (const t8_cmesh_reorder_sfc_t *) a;
+  const t8_cmesh_reorder_sfc_t *tb = (const t8_cmesh_reorder_sfc_t *) b;
+
+  if (ta->key != tb->key) {
+    return ta->key < tb->key ? -1 : 1;
+  }
+  return ta->gtree_id < tb->gtree_id ? -1 : ta->gtree_id > tb->gtree_id;
+}
+
+/* Insert two zero bits after each of the lowest
+ * T8_CMESH_REORDER_SFC_BITS bits of x */
+static              uint64_t
+t8_cmesh_reorder_spread (uint64_t x)
+{
+  x &= 0x1fffffULL;
+  x = (x | x << 32) & 0x1f00000000ffffULL;
+  x = (x | x << 16) & 0x1f0000ff0000ffULL;
+  x = (x | x << 8) & 0x100f00f00f00f00fULL;
+  x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+  x = (x | x << 2) & 0x1249249249249249ULL;
+  return x;
+}
+
+t8_cmesh_t
+t8_cmesh_reorder_sfc (t8_cmesh_t cmesh, sc_MPI_Comm comm)
+{
+  int                 mpisize, mpirank, mpiret, irank, ivertex, idim;
+  int                 num_vertices, num_samples, ok, *dest;
+  t8_gloidx_t         first_owned, num_trees, offset, *new_ids, *part_first;
+  t8_locidx_t         first_lowned, num_owned, itree;
+  double             *centroids, *vertices, bounds[6], global_bounds[6];
+  double              extent;
+  uint64_t            coord;
+  const uint64_t      scale = (1ULL << T8_CMESH_REORDER_SFC_BITS) - 1;
+  t8_cmesh_reorder_sfc_t *sfc_tree, *samples, *all_samples;
+  t8_cmesh_reorder_sfc_id_t *sfc_id;
+  sc_array_t          local, sorted, sample_array, ids, *send;
+  size_t              iz, num_valid;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (t8_cmesh_is_partitioned (cmesh));
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  t8_cmesh_reorder_owned (cmesh, &first_lowned, &num_owned, &first_owned);
+
+  /* Compute the centroids of the owned trees and their bounding box.
+   * We store the negative upper bounds to use a single reduction. */
+  centroids = T8_ALLOC_ZERO (double, 3 * SC_MAX (num_owned, 1));
+  for (idim = 0; idim < 3; idim++) {
+    bounds[idim] = bounds[3 + idim] = DBL_MAX;
+  }
+  ok = 1;
+  for (itree = 0; itree < num_owned; itree++) {
+    vertices = t8_cmesh_get_tree_vertices (cmesh, itree + first_lowned);
+    if (vertices == NULL) {
+      ok = 0;
+      break;
+    }
+    num_vertices = t8_eclass_num_vertices[t8_cmesh_get_tree_class
+                                          (cmesh, itree + first_lowned)];
+    for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+      for (idim = 0; idim < 3; idim++) {
+        centroids[3 * itree + idim] += vertices[3 * ivertex + idim];
+      }
+    }
+    for (idim = 0; idim < 3; idim++) {
+      centroids[3 * itree + idim] /= num_vertices;
+      bounds[idim] = SC_MIN (bounds[idim], centroids[3 * itree + idim]);
+      bounds[3 + idim] = SC_MIN (bounds[3 + idim],
+                                 -centroids[3 * itree + idim]);
+    }
+  }
+  if (!t8_cmesh_reader_all_ok (ok, comm)) {
+    t8_global_errorf ("Cannot reorder a cmesh without tree vertices.\n");
+    T8_FREE (centroids);
+    return cmesh;
+  }
+  mpiret = sc_MPI_Allreduce (bounds, global_bounds, 6, sc_MPI_DOUBLE,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+
+  /* Compute the Morton keys of the centroids and sort the owned trees */
+  sc_array_init_size (&local, sizeof (t8_cmesh_reorder_sfc_t), num_owned);
+  for (itree = 0; itree < num_owned; itree++) {
+    sfc_tree = (t8_cmesh_reorder_sfc_t *) sc_array_index (&local, itree);
+    sfc_tree->key = 0;
+    for (idim = 0; idim < 3; idim++) {
+      extent = -global_bounds[3 + idim] - global_bounds[idim];
+      coord = extent > 0 ? (uint64_t) ((centroids[3 * itree + idim]
+                                        - global_bounds[idim]) / extent
+                                       * scale) : 0;
+      sfc_tree->key |= t8_cmesh_reorder_spread (coord) << idim;
+    }
+    sfc_tree->gtree_id = first_owned + itree;
+    sfc_tree->origin = mpirank;
+    sfc_tree->index = itree;
+  }
+  T8_FREE (centroids);
+  sc_array_sort (&local, t8_cmesh_reorder_sfc_compare);
+
+  /* Choose the splitters of the sample sort from regular samples of the
+   * sorted trees of each process */
+  num_samples = SC_MIN (mpisize, T8_CMESH_REORDER_SFC_SAMPLES);
+  samples = T8_ALLOC (t8_cmesh_reorder_sfc_t, num_samples);
+  for (irank = 0; irank < num_samples; irank++) {
+    if (num_owned > 0) {
+      samples[irank] = *(t8_cmesh_reorder_sfc_t *)
+        sc_array_index (&local, (irank * (size_t) num_owned) / num_samples);
+    }
+    else {
+      samples[irank].gtree_id = -1;
+    }
+  }
+  sc_array_init_size (&sample_array, sizeof (t8_cmesh_reorder_sfc_t),
+                      num_samples * (size_t) mpisize);
+  all_samples = (t8_cmesh_reorder_sfc_t *) sample_array.array;
+  mpiret = sc_MPI_Allgather (samples, num_samples * sizeof (*samples),
+                             sc_MPI_BYTE, all_samples,
+                             num_samples * sizeof (*samples), sc_MPI_BYTE,
+                             comm);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (samples);
+  for (iz = 0, num_valid = 0; iz < sample_array.elem_count; iz++) {
+    if (all_samples[iz].gtree_id >= 0) {
+      all_samples[num_valid++] = all_samples[iz];
+    }
+  }
+  sc_array_resize (&sample_array, num_valid);
+  sc_array_sort (&sample_array, t8_cmesh_reorder_sfc_compare);
+  all_samples = (t8_cmesh_reorder_sfc_t *) sample_array.array;
+
+  /* Send each tree to the process of its bucket. The splitter of process p
+   * is the sample (p * num_valid) / mpisize. */
+  send = T8_ALLOC (sc_array_t, mpisize);
+  for (irank = 0; irank < mpisize; irank++) {
+    sc_array_init (&send[irank], sizeof (t8_cmesh_reorder_sfc_t));
+  }
+  for (itree = 0, irank = 0; itree < num_owned; itree++) {
+    sfc_tree = (t8_cmesh_reorder_sfc_t *) sc_array_index (&local, itree);
+    while (irank + 1 < mpisize
+           && t8_cmesh_reorder_sfc_compare
+           (sfc_tree, all_samples + ((irank + 1) * num_valid) / mpisize) >=
+           0) {
+      irank++;
+    }
+    *(t8_cmesh_reorder_sfc_t *) sc_array_push (&send[irank]) = *sfc_tree;
+  }
+  sc_array_reset (&sample_array);
+  sc_array_reset (&local);
+  sc_array_init (&sorted, sizeof (t8_cmesh_reorder_sfc_t));
+  t8_cmesh_reader_exchange (send, &sorted, NULL, mpisize, comm);
+  sc_array_sort (&sorted, t8_cmesh_reorder_sfc_compare);
+
+  /* The trees get their new ids in the order of the curve. We send the new
+   * ids back to the owners of the trees. */
+  num_trees = sorted.elem_count;
+  mpiret = sc_MPI_Scan (&num_trees, &offset, 1, T8_MPI_GLOIDX, sc_MPI_SUM,
+                        comm);
+  SC_CHECK_MPI (mpiret);
+  offset -= num_trees;
+  t8_cmesh_reader_exchange_reinit (send, sizeof (t8_cmesh_reorder_sfc_id_t),
+                                   mpisize);
+  for (iz = 0; iz < sorted.elem_count; iz++) {
+    sfc_tree = (t8_cmesh_reorder_sfc_t *) sc_array_index (&sorted, iz);
+    sfc_id = (t8_cmesh_reorder_sfc_id_t *)
+      sc_array_push (&send[sfc_tree->origin]);
+    sfc_id->new_id = offset + iz;
+    sfc_id->index = sfc_tree->index;
+  }
+  sc_array_reset (&sorted);
+  sc_array_init (&ids, sizeof (t8_cmesh_reorder_sfc_id_t));
+  t8_cmesh_reader_exchange (send, &ids, NULL, mpisize, comm);
+  for (irank = 0; irank < mpisize; irank++) {
+    sc_array_reset (&send[irank]);
+  }
+  T8_FREE (send);
+  T8_ASSERT (ids.elem_count == (size_t) num_owned);
+  new_ids = T8_ALLOC (t8_gloidx_t, SC_MAX (num_owned, 1));
+  for (iz = 0; iz < ids.elem_count; iz++) {
+    sfc_id = (t8_cmesh_reorder_sfc_id_t *) sc_array_index (&ids, iz);
+    new_ids[sfc_id->index] = sfc_id->new_id;
+  }
+  sc_array_reset (&ids);
+
+  /* Split the curve evenly among the processes */
+  num_trees = t8_cmesh_get_num_trees (cmesh);
+  part_first = T8_ALLOC (t8_gloidx_t, mpisize + 1);
+  for (irank = 0; irank <= mpisize; irank++) {
+    part_first[irank] = (irank * num_trees) / mpisize;
+  }
+  dest = T8_ALLOC (int, SC_MAX (num_owned, 1));
+  for (itree = 0; itree < num_owned; itree++) {
+    irank = (int) ((new_ids[itree] * mpisize) / num_trees);
+    while (part_first[irank] > new_ids[itree]) {
+      irank--;
+    }
+    while (part_first[irank + 1] <= new_ids[itree]) {
+      irank++;
+    }
+    dest[itree] = irank;
+  }
+  t8_debugf ("Reordering %li trees along the Morton curve.\n",
+             (long) num_owned);
+  cmesh = t8_cmesh_reorder_redistribute (cmesh, comm, new_ids, dest,
+                                         part_first);
+  T8_FREE (new_ids);
+  T8_FREE (dest);
+  T8_FREE (part_first);
+  return cmesh;
+}
+
+#if defined (T8_WITH_PARMETIS) && defined (SC_ENABLE_MPI)
+
+t8_cmesh_t
+t8_cmesh_reorder_partitioned (t8_cmesh_t cmesh, sc_MPI_Comm comm)
+{
+  int                 mpisize, mpirank, mpiret, irank, iface, retval, ok;
+  int                 eclass, face, orientation, *dest;
+  t8_gloidx_t        *owned_counts, *part_sizes, *part_offsets, num_edges;
+  t8_gloidx_t        *part_first, *new_ids, first_owned, gneighbor;
+  t8_locidx_t         first_lowned, num_owned, itree, ltree;
+  idx_t              *vtxdist, *xadj, *adjncy, *part;
+  idx_t               wgtflag = 0, numflag = 0, ncon = 1, nparts, edgecut;
+  idx_t               options[3] = { 0, 0, 0 }, iadj;
+  real_t             *tpwgts, ubvec = 1.05;
+  MPI_Comm            mpicomm = comm;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (t8_cmesh_is_partitioned (cmesh));
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  t8_cmesh_reorder_owned (cmesh, &first_lowned, &num_owned, &first_owned);
+  /* The global tree ids are the vertices of the dual graph and each owned
+   * tree has at most T8_ECLASS_MAX_FACES edges */
+  num_edges = (t8_gloidx_t) num_owned * T8_ECLASS_MAX_FACES;
+  ok = (t8_gloidx_t) (idx_t) t8_cmesh_get_num_trees (cmesh) ==
+    t8_cmesh_get_num_trees (cmesh) && (t8_gloidx_t) (idx_t) num_edges ==
+    num_edges;
+  if (!t8_cmesh_reader_all_ok (ok, comm)) {
+    t8_global_errorf ("Cannot reorder a cmesh with more trees than the "
+                      "ParMETIS index type can store.\n");
+    return cmesh;
+  }
+
+  /* The distribution of the dual graph */
+  owned_counts = T8_ALLOC (t8_gloidx_t, mpisize);
+  {
+    t8_gloidx_t         num_owned_glo = num_owned;
+
+    mpiret = sc_MPI_Allgather (&num_owned_glo, 1, T8_MPI_GLOIDX,
+                               owned_counts, 1, T8_MPI_GLOIDX, comm);
+    SC_CHECK_MPI (mpiret);
+  }
+  vtxdist = T8_ALLOC (idx_t, mpisize + 1);
+  vtxdist[0] = 0;
+  for (irank = 0; irank < mpisize; irank++) {
+    if (owned_counts[irank] == 0) {
+      /* ParMETIS cannot handle processes without vertices */
+      t8_global_errorf ("Cannot reorder a cmesh with empty processes.\n");
+      T8_FREE (owned_counts);
+      T8_FREE (vtxdist);
+      return cmesh;
+    }
+    vtxdist[irank + 1] = vtxdist[irank] + owned_counts[irank];
+  }
+  T8_FREE (owned_counts);
+  T8_ASSERT ((t8_gloidx_t) vtxdist[mpirank] == first_owned);
+
+  /* Fill the dual graph in CSR format. We skip boundary faces and
+   * connections of a tree to itself and store each neighbor only once. */
+  xadj = T8_ALLOC (idx_t, num_owned + 1);
+  adjncy = T8_ALLOC (idx_t, num_owned * T8_ECLASS_MAX_FACES);
+  xadj[0] = 0;
+  for (itree = 0; itree < num_owned; itree++) {
+    ltree = itree + first_lowned;
+    xadj[itree + 1] = xadj[itree];
+    eclass = t8_cmesh_get_tree_class (cmesh, ltree);
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      gneighbor = t8_cmesh_reorder_neighbor (cmesh, ltree, iface,
+                                             &face, &orientation);
+      if (gneighbor < 0 || gneighbor == first_owned + itree) {
+        continue;
+      }
+      for (iadj = xadj[itree]; iadj < xadj[itree + 1]; iadj++) {
+        if (adjncy[iadj] == (idx_t) gneighbor) {
+          break;
+        }
+      }
+      if (iadj == xadj[itree + 1]) {
+        adjncy[xadj[itree + 1]++] = gneighbor;
+      }
+    }
+  }
+
+  /* Partition the dual graph into one part per process */
+  nparts = mpisize;
+  tpwgts = T8_ALLOC (real_t, nparts);
+  for (irank = 0; irank < mpisize; irank++) {
+    tpwgts[irank] = 1. / nparts;
+  }
+  part = T8_ALLOC (idx_t, num_owned);
+  retval = ParMETIS_V3_PartKway (vtxdist, xadj, adjncy, NULL, NULL, &wgtflag,
+                                 &numflag, &ncon, &nparts, tpwgts, &ubvec,
+                                 options, &edgecut, part, &mpicomm);
+  SC_CHECK_ABORT (retval == METIS_OK, "ParMETIS partitioning failed");
+  T8_FREE (tpwgts);
+  T8_FREE (xadj);
+  T8_FREE (adjncy);
+  T8_FREE (vtxdist);
+  t8_global_productionf ("Partitioned the cmesh dual graph with edgecut "
+                         "%lli.\n", (long long) edgecut);
+
+  /* Compute the new ids. The trees of part p are numbered in the order of
+   * their old ids, starting at part_first[p]. */
+  part_sizes = T8_ALLOC_ZERO (t8_gloidx_t, 4 * mpisize + 1);
+  part_offsets = part_sizes + mpisize;
+  part_first = part_offsets + mpisize;
+  for (itree = 0; itree < num_owned; itree++) {
+    part_sizes[part[itree]]++;
+  }
+  mpiret = MPI_Exscan (part_sizes, part_offsets, mpisize, T8_MPI_GLOIDX,
+                       MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    memset (part_offsets, 0, mpisize * sizeof (t8_gloidx_t));
+  }
+  mpiret = sc_MPI_Allreduce (part_sizes, part_first + mpisize + 1, mpisize,
+                             T8_MPI_GLOIDX, sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  part_first[0] = 0;
+  for (irank = 0; irank < mpisize; irank++) {
+    part_first[irank + 1] = part_first[irank] + part_first[mpisize + 1
+                                                           + irank];
+  }
+  new_ids = T8_ALLOC (t8_gloidx_t, SC_MAX (num_owned, 1));
+  dest = T8_ALLOC (int, SC_MAX (num_owned, 1));
+  for (itree = 0; itree < num_owned; itree++) {
+    new_ids[itree] = part_first[part[itree]] + part_offsets[part[itree]]++;
+    dest[itree] = part[itree];
+  }
+  T8_FREE (part);
+
+  cmesh = t8_cmesh_reorder_redistribute (cmesh, comm, new_ids, dest,
+                                         part_first);
+  T8_FREE (new_ids);
+  T8_FREE (dest);
+  T8_FREE (part_sizes);
+  return cmesh;
+}
+
+#endif /* T8_WITH_PARMETIS && SC_ENABLE_MPI */
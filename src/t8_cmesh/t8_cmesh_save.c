@@ -33,6 +33,9 @@
 #include <t8_cmesh/t8_cmesh_save.h>
 #include <t8_cmesh/t8_cmesh_partition.h>
 #include <t8_cmesh/t8_cmesh_offset.h>
+#include <t8_cmesh/t8_cmesh_reader.h>
+#include <t8_data/t8_shmem.h>
+#include <t8_data/t8_file.h>
 
 /* This macro is called to check a condition and if not fulfilled
  * close the file and exit the function */
@@ -933,3 +936,823 @@ t8_cmesh_load_and_distribute (const char *fileprefix, int num_files,
   T8_ASSERT (t8_cmesh_is_committed (cmesh));
   return cmesh;
 }
+
+/* The single-file parallel format.
+ * The file starts with a header, followed by the partition table of
+ * the saving processes and the tree records.
+ * Each tree is stored in a record of fixed size, sorted by global id,
+ * such that the records of a range of trees form a contiguous byte range
+ * that can be computed without reading any other part of the file. */
+
+#define T8_CMESH_PARALLEL_MAGIC "T8CMESH"
+#define T8_CMESH_PARALLEL_FORMAT 0x0001
+
+typedef struct
+{
+  char                magic[8];         /**< T8_CMESH_PARALLEL_MAGIC */
+  int32_t             format;           /**< T8_CMESH_PARALLEL_FORMAT */
+  int32_t             record_size;      /**< The size of a tree record in bytes */
+  int32_t             dimension;        /**< The dimension of the cmesh */
+  int32_t             partitioned;      /**< Nonzero if the cmesh was partitioned */
+  int32_t             mpisize;          /**< The number of saving processes */
+  int32_t             padding;
+  int64_t             num_trees;        /**< The global number of trees */
+  int64_t             data_offset;      /**< The position of the first record */
+} t8_cmesh_parallel_header_t;
+
+typedef struct
+{
+  int64_t             neighbors[T8_ECLASS_MAX_FACES];   /**< Global ids of the face neighbors,
+                                                             -1 for unused faces */
+  double              vertices[3 * T8_ECLASS_MAX_CORNERS];
+  int8_t              ttf[T8_ECLASS_MAX_FACES];
+  int8_t              neighbor_eclass[T8_ECLASS_MAX_FACES];
+  int8_t              eclass;
+  int8_t              has_vertices;
+  int8_t              padding[2];
+} t8_cmesh_parallel_record_t;
+
+/* An entry of the list of ghosts of a loaded tree range */
+typedef struct
+{
+  t8_gloidx_t         id;
+} t8_cmesh_parallel_ghost_t;
+
+
+static int
+t8_cmesh_parallel_ghost_compare (const void *a, const void *b)
+{
+  const t8_cmesh_parallel_ghost_t *ga = (const t8_cmesh_parallel_ghost_t *) a;
+  const t8_cmesh_parallel_ghost_t *gb = (const t8_cmesh_parallel_ghost_t *) b;
+
+  return ga->id < gb->id ? -1 : ga->id > gb->id;
+}
+
+/* Fill the record of a local tree */
+static void
+t8_cmesh_parallel_fill_record (t8_cmesh_t cmesh, t8_locidx_t ltree,
+                               t8_cmesh_parallel_record_t * record)
+{
+  t8_ctree_t          tree;
+  t8_cghost_t         ghost;
+  t8_locidx_t        *face_neigh;
+  int8_t             *ttf;
+  double             *vertices;
+  int                 iface, num_faces;
+
+  tree = t8_cmesh_trees_get_tree_ext (cmesh->trees, ltree, &face_neigh, &ttf);
+  record->eclass = (int8_t) tree->eclass;
+  num_faces = t8_eclass_num_faces[tree->eclass];
+  for (iface = 0; iface < T8_ECLASS_MAX_FACES; iface++) {
+    record->neighbors[iface] = -1;
+  }
+  for (iface = 0; iface < num_faces; iface++) {
+    if (face_neigh[iface] < cmesh->num_local_trees) {
+      /* The neighbor is a local tree */
+      record->neighbors[iface] = cmesh->first_tree + face_neigh[iface];
+      record->neighbor_eclass[iface] = (int8_t)
+        t8_cmesh_trees_get_tree (cmesh->trees, face_neigh[iface])->eclass;
+    }
+    else {
+      /* The neighbor is a ghost */
+      ghost = t8_cmesh_trees_get_ghost (cmesh->trees, face_neigh[iface]
+                                        - cmesh->num_local_trees);
+      record->neighbors[iface] = ghost->treeid;
+      record->neighbor_eclass[iface] = (int8_t) ghost->eclass;
+    }
+    record->ttf[iface] = ttf[iface];
+  }
+  vertices = t8_cmesh_get_tree_vertices (cmesh, ltree);
+  if (vertices != NULL) {
+    record->has_vertices = 1;
+    memcpy (record->vertices, vertices,
+            3 * t8_eclass_num_vertices[tree->eclass] * sizeof (double));
+  }
+}
+
+int
+t8_cmesh_save_parallel (t8_cmesh_t cmesh, const char *filename,
+                        sc_MPI_Comm comm)
+{
+  t8_cmesh_parallel_header_t header;
+  t8_cmesh_parallel_record_t *records;
+  t8_file_t           file;
+  t8_gloidx_t        *table, first_owned;
+  t8_locidx_t         num_owned, first_ltree, ltree;
+  int                 mpirank, mpisize, mpiret, ok;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (t8_cmesh_comm_is_valid (cmesh, comm));
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  /* Each tree is written by exactly one process.
+   * For a partitioned cmesh this is the process that owns it without
+   * sharing it with a smaller rank, for a replicated cmesh process 0. */
+  if (cmesh->set_partition) {
+    first_ltree = cmesh->num_local_trees > 0 ? cmesh->first_tree_shared : 0;
+    first_owned = cmesh->first_tree + first_ltree;
+    num_owned = cmesh->num_local_trees - first_ltree;
+  }
+  else {
+    first_ltree = 0;
+    first_owned = mpirank == 0 ? 0 : cmesh->num_trees;
+    num_owned = mpirank == 0 ? cmesh->num_local_trees : 0;
+  }
+  table = T8_ALLOC (t8_gloidx_t, mpisize + 1);
+  mpiret = sc_MPI_Allgather (&first_owned, 1, T8_MPI_GLOIDX, table, 1,
+                             T8_MPI_GLOIDX, comm);
+  SC_CHECK_MPI (mpiret);
+  table[mpisize] = cmesh->num_trees;
+
+  records = T8_ALLOC_ZERO (t8_cmesh_parallel_record_t, num_owned);
+  for (ltree = 0; ltree < num_owned; ltree++) {
+    t8_cmesh_parallel_fill_record (cmesh, first_ltree + ltree,
+                                   records + ltree);
+  }
+
+  memset (&header, 0, sizeof (header));
+  strncpy (header.magic, T8_CMESH_PARALLEL_MAGIC, sizeof (header.magic));
+  header.format = T8_CMESH_PARALLEL_FORMAT;
+  header.record_size = sizeof (t8_cmesh_parallel_record_t);
+  header.dimension = cmesh->dimension;
+  header.partitioned = cmesh->set_partition;
+  header.mpisize = mpisize;
+  header.num_trees = cmesh->num_trees;
+  header.data_offset = sizeof (header) + (mpisize + 1) * sizeof (int64_t);
+
+  ok = t8_file_open (&file, filename, 1, comm);
+  if (ok) {
+    if (mpirank == 0) {
+      ok = t8_file_write_at (&file, 0, 0, &header, 1, sizeof (header))
+        && t8_file_write_at (&file, 0, sizeof (header), table,
+                             mpisize + 1, sizeof (int64_t));
+    }
+    /* Each process writes its records to a contiguous section */
+    ok = t8_file_write_at (&file, 1, header.data_offset
+                           + first_owned * header.record_size,
+                           records, num_owned, header.record_size) && ok;
+    ok = t8_file_close (&file) && ok;
+    ok = t8_cmesh_reader_all_ok (ok, comm);
+    if (!ok) {
+      t8_global_errorf ("Error when writing to file %s.\n", filename);
+    }
+  }
+  T8_FREE (records);
+  T8_FREE (table);
+  return ok;
+}
+
+/* Check that the records of the trees first to first + num_trees - 1
+ * describe valid trees of a cmesh */
+static int
+t8_cmesh_parallel_check_records (t8_cmesh_parallel_record_t * records,
+                                 t8_gloidx_t num_trees,
+                                 const t8_cmesh_parallel_header_t * header)
+{
+  t8_gloidx_t         itree;
+  int                 iface, F;
+
+  F = t8_eclass_max_num_faces[header->dimension];
+  for (itree = 0; itree < num_trees; itree++) {
+    if (records[itree].eclass < 0 || records[itree].eclass >= T8_ECLASS_COUNT
+        || t8_eclass_to_dimension[records[itree].eclass]
+        != header->dimension) {
+      return 0;
+    }
+    for (iface = 0; iface < t8_eclass_num_faces[records[itree].eclass];
+         iface++) {
+      if (records[itree].neighbors[iface] < 0
+          || records[itree].neighbors[iface] >= header->num_trees
+          || records[itree].neighbor_eclass[iface] < 0
+          || records[itree].neighbor_eclass[iface] >= T8_ECLASS_COUNT
+          || records[itree].ttf[iface] < 0
+          || records[itree].ttf[iface] >= T8_ECLASS_MAX_CORNERS_2D * F) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+t8_cmesh_t
+t8_cmesh_load_parallel (const char *filename, sc_MPI_Comm comm)
+{
+  t8_cmesh_parallel_header_t header;
+  t8_cmesh_parallel_record_t *records = NULL, *ghost_records;
+  t8_file_t           file;
+  t8_cmesh_parallel_ghost_t *ghost, search;
+  t8_shmem_array_t    offsets = NULL;
+  t8_gloidx_t        *table = NULL, *offset_array;
+  t8_gloidx_t         first_tree, num_trees, itree, gtree, neighbor;
+  t8_cmesh_t          cmesh;
+  sc_array_t          ghosts;
+  size_t              ighost;
+  int                 mpirank, mpisize, mpiret, ok, iface, F;
+  int                 neighbor_face, orientation;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  if (!t8_file_open (&file, filename, 0, comm)) {
+    return NULL;
+  }
+  /* All processes read and validate the header */
+  ok = t8_file_read_at (&file, 1, 0, &header, 1, sizeof (header));
+  ok = ok && !strncmp (header.magic, T8_CMESH_PARALLEL_MAGIC,
+                       sizeof (header.magic))
+    && header.format == T8_CMESH_PARALLEL_FORMAT
+    && header.record_size == (int32_t) sizeof (t8_cmesh_parallel_record_t)
+    && 0 <= header.dimension && header.dimension <= T8_ECLASS_MAX_DIM
+    && header.mpisize > 0 && header.num_trees >= 0
+    && header.data_offset == (int64_t) (sizeof (header)
+                                        + (header.mpisize + 1)
+                                        * sizeof (int64_t));
+  if (!t8_cmesh_reader_all_ok (ok, comm)) {
+    t8_global_errorf ("File %s is not a valid cmesh file.\n", filename);
+    t8_file_close (&file);
+    return NULL;
+  }
+
+  /* Determine the range of trees to read on this process */
+  if (header.partitioned) {
+    if (header.mpisize == mpisize) {
+      /* Reuse the partition of the saved cmesh */
+      table = T8_ALLOC (t8_gloidx_t, mpisize + 1);
+      ok = t8_file_read_at (&file, 1, sizeof (header), table,
+                            mpisize + 1, sizeof (int64_t));
+      ok = ok && t8_offset_consistent (mpisize, table, header.num_trees);
+      ok = t8_cmesh_reader_all_ok (ok, comm);
+      if (ok) {
+        offsets = t8_cmesh_alloc_offsets (mpisize, comm);
+        if (t8_shmem_array_start_writing (offsets)) {
+          memcpy (t8_shmem_array_get_gloidx_array (offsets), table,
+                  (mpisize + 1) * sizeof (t8_gloidx_t));
+        }
+        t8_shmem_array_end_writing (offsets);
+      }
+      T8_FREE (table);
+    }
+    else {
+      offsets = t8_cmesh_offset_uniform (comm, header.num_trees);
+    }
+    if (offsets == NULL) {
+      t8_global_errorf ("File %s has an invalid partition table.\n",
+                        filename);
+      t8_file_close (&file);
+      return NULL;
+    }
+    offset_array = t8_shmem_array_get_gloidx_array (offsets);
+    first_tree = t8_offset_first (mpirank, offset_array);
+    num_trees = t8_offset_num_trees (mpirank, offset_array);
+  }
+  else {
+    /* A replicated cmesh is read completely by each process */
+    first_tree = 0;
+    num_trees = header.num_trees;
+  }
+
+  /* Each process reads only the byte range of its trees */
+  records = T8_ALLOC (t8_cmesh_parallel_record_t, num_trees);
+  ok = t8_file_read_at (&file, 1, header.data_offset
+                        + first_tree * header.record_size, records,
+                        num_trees, header.record_size);
+  ok = ok && t8_cmesh_parallel_check_records (records, num_trees, &header);
+
+  /* Collect the non-local face neighbors of the local trees, these are
+   * the ghosts */
+  sc_array_init (&ghosts, sizeof (t8_cmesh_parallel_ghost_t));
+  for (itree = 0; ok && itree < num_trees; itree++) {
+    gtree = first_tree + itree;
+    for (iface = 0; iface < t8_eclass_num_faces[records[itree].eclass];
+         iface++) {
+      neighbor = records[itree].neighbors[iface];
+      if (neighbor < first_tree || neighbor >= first_tree + num_trees) {
+        ghost = (t8_cmesh_parallel_ghost_t *) sc_array_push (&ghosts);
+        ghost->id = neighbor;
+      }
+    }
+  }
+  sc_array_sort (&ghosts, t8_cmesh_parallel_ghost_compare);
+  sc_array_uniq (&ghosts, t8_cmesh_parallel_ghost_compare);
+  /* The commit expects all face connections of the ghosts, even those to
+   * other ghosts or to trees that are neither local nor ghosts.
+   * Thus, we read the record of each ghost, too. */
+  ghost_records = T8_ALLOC (t8_cmesh_parallel_record_t, ghosts.elem_count);
+  for (ighost = 0; ok && ighost < ghosts.elem_count; ighost++) {
+    ghost = (t8_cmesh_parallel_ghost_t *) sc_array_index (&ghosts, ighost);
+    ok = t8_file_read_at (&file, 0, header.data_offset
+                          + ghost->id * header.record_size,
+                          ghost_records + ighost, 1, header.record_size);
+  }
+  ok = ok && t8_cmesh_parallel_check_records (ghost_records,
+                                              ghosts.elem_count, &header);
+  ok = t8_file_close (&file) && ok;
+  if (!t8_cmesh_reader_all_ok (ok, comm)) {
+    t8_global_errorf ("Error when reading from file %s.\n", filename);
+    sc_array_reset (&ghosts);
+    T8_FREE (ghost_records);
+    T8_FREE (records);
+    if (offsets != NULL) {
+      t8_shmem_array_destroy (&offsets);
+    }
+    return NULL;
+  }
+
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_dimension (cmesh, header.dimension);
+  F = t8_eclass_max_num_faces[header.dimension];
+  for (itree = 0; itree < num_trees; itree++) {
+    gtree = first_tree + itree;
+    t8_cmesh_set_tree_class (cmesh, gtree,
+                             (t8_eclass_t) records[itree].eclass);
+    if (records[itree].has_vertices) {
+      t8_cmesh_set_tree_vertices (cmesh, gtree, t8_get_package_id (), 0,
+                                  records[itree].vertices,
+                                  t8_eclass_num_vertices[records[itree].
+                                                         eclass]);
+    }
+    for (iface = 0; iface < t8_eclass_num_faces[records[itree].eclass];
+         iface++) {
+      neighbor = records[itree].neighbors[iface];
+      neighbor_face = records[itree].ttf[iface] % F;
+      orientation = records[itree].ttf[iface] / F;
+      if (neighbor < first_tree || neighbor >= first_tree + num_trees
+          || gtree < neighbor
+          || (gtree == neighbor && iface < neighbor_face)) {
+        /* We set joins with ghosts from the local side and joins of two
+         * local trees only once. */
+        t8_cmesh_set_join (cmesh, gtree, neighbor, iface, neighbor_face,
+                           orientation);
+      }
+    }
+  }
+  for (ighost = 0; ighost < ghosts.elem_count; ighost++) {
+    ghost = (t8_cmesh_parallel_ghost_t *) sc_array_index (&ghosts, ighost);
+    gtree = ghost->id;
+    t8_cmesh_set_tree_class (cmesh, gtree,
+                             (t8_eclass_t) ghost_records[ighost].eclass);
+    for (iface = 0;
+         iface < t8_eclass_num_faces[ghost_records[ighost].eclass];
+         iface++) {
+      neighbor = ghost_records[ighost].neighbors[iface];
+      neighbor_face = ghost_records[ighost].ttf[iface] % F;
+      orientation = ghost_records[ighost].ttf[iface] / F;
+      if (first_tree <= neighbor && neighbor < first_tree + num_trees) {
+        /* This join was set by the local tree */
+        continue;
+      }
+      search.id = neighbor;
+      if (sc_array_bsearch (&ghosts, &search,
+                            t8_cmesh_parallel_ghost_compare) < 0
+          || gtree < neighbor
+          || (gtree == neighbor && iface < neighbor_face)) {
+        /* The neighbor is no local tree and no ghost, or it is a ghost
+         * and we set the join only once. */
+        t8_cmesh_set_join (cmesh, gtree, neighbor, iface, neighbor_face,
+                           orientation);
+      }
+    }
+  }
+  sc_array_reset (&ghosts);
+  T8_FREE (ghost_records);
+  T8_FREE (records);
+
+  if (header.partitioned) {
+    t8_cmesh_set_partition_offsets (cmesh, offsets);
+  }
+  t8_cmesh_commit (cmesh, comm);
+  return cmesh;
+}
+
+/* The mapped format stores the memory of the trees of a replicated cmesh
+ * exactly as it is laid out in memory. Since all positions within this
+ * memory are stored as offsets, a process can use the file contents as
+ * the trees without reading or converting them. The format thus depends
+ * on the byte order and the type sizes of the saving machine, which we
+ * store in the header to check them when loading. */
+#define T8_CMESH_MAPPED_MAGIC "T8CMMAP"
+#define T8_CMESH_MAPPED_FORMAT 0x0001
+#define T8_CMESH_MAPPED_BYTE_ORDER 0x01020304
+/* The position of the trees in the file is a multiple of this */
+#define T8_CMESH_MAPPED_ALIGN 64
+
+typedef struct
+{
+  char                magic[8];         /**< T8_CMESH_MAPPED_MAGIC */
+  int32_t             format;           /**< T8_CMESH_MAPPED_FORMAT */
+  int32_t             byte_order;       /**< T8_CMESH_MAPPED_BYTE_ORDER */
+  int32_t             tree_size;        /**< sizeof (t8_ctree_struct_t) */
+  int32_t             attribute_info_size;      /**< sizeof (t8_attribute_info_struct_t) */
+  int32_t             locidx_size;      /**< sizeof (t8_locidx_t) */
+  int32_t             dimension;        /**< The dimension of the cmesh */
+  int32_t             package_id;       /**< The package id of t8code when saving */
+  int32_t             padding;
+  int64_t             num_trees;        /**< The number of trees */
+  int64_t             num_trees_per_eclass[T8_ECLASS_COUNT];    /**< The number of trees of each class */
+  int64_t             part_offset;      /**< The position of the trees in the file */
+  int64_t             part_bytes;       /**< The number of bytes of the trees */
+} t8_cmesh_mapped_header_t;
+
+int
+t8_cmesh_save_mapped (t8_cmesh_t cmesh, const char *filename)
+{
+  t8_cmesh_mapped_header_t header;
+  t8_part_tree_t      part;
+  char                padding[T8_CMESH_MAPPED_ALIGN] = { 0 };
+  FILE               *fp;
+  int                 eclass, ok;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  if (cmesh->set_partition) {
+    t8_global_errorf ("Only replicated cmeshes can be saved in the mapped "
+                      "format.\n");
+    return 0;
+  }
+  if (cmesh->mpirank != 0) {
+    /* The cmesh is replicated, only rank 0 writes it */
+    return 1;
+  }
+  T8_ASSERT (cmesh->trees->from_proc->elem_count == 1);
+  part = t8_cmesh_trees_get_part (cmesh->trees, 0);
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, T8_CMESH_MAPPED_MAGIC, sizeof (header.magic));
+  header.format = T8_CMESH_MAPPED_FORMAT;
+  header.byte_order = T8_CMESH_MAPPED_BYTE_ORDER;
+  header.tree_size = sizeof (t8_ctree_struct_t);
+  header.attribute_info_size = sizeof (t8_attribute_info_struct_t);
+  header.locidx_size = sizeof (t8_locidx_t);
+  header.dimension = cmesh->dimension;
+  header.package_id = t8_get_package_id ();
+  header.num_trees = cmesh->num_trees;
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    header.num_trees_per_eclass[eclass] = cmesh->num_trees_per_eclass[eclass];
+  }
+  header.part_offset = (sizeof (header) + T8_CMESH_MAPPED_ALIGN - 1)
+    / T8_CMESH_MAPPED_ALIGN * T8_CMESH_MAPPED_ALIGN;
+  /* The trees of a replicated cmesh are stored in a single part */
+  header.part_bytes = t8_cmesh_trees_size (cmesh->trees);
+
+  fp = fopen (filename, "wb");
+  if (fp == NULL) {
+    t8_errorf ("Error when opening file %s.\n", filename);
+    return 0;
+  }
+  ok = fwrite (&header, sizeof (header), 1, fp) == 1
+    && fwrite (padding, 1, header.part_offset - sizeof (header), fp)
+    == (size_t) header.part_offset - sizeof (header)
+    && fwrite (part->first_tree, 1, header.part_bytes, fp)
+    == (size_t) header.part_bytes;
+  ok = !fclose (fp) && ok;
+  if (!ok) {
+    t8_errorf ("Error when writing to file %s.\n", filename);
+  }
+  return ok;
+}
+
+/* Check that length bytes at offset lie within size bytes,
+ * without overflowing */
+static int
+t8_cmesh_mapped_in_range (size_t offset, size_t length, size_t size)
+{
+  return offset <= size && length <= size - offset;
+}
+
+/* Check that the trees of a mapped cmesh file, their face neighbors and
+ * their attributes lie within the part memory, and that the face neighbors
+ * are valid tree ids. Since all lookups of the trees trust these values,
+ * we check them before the trees are used. Only the tree structs, the face
+ * neighbors and the attribute infos are read, not the attribute data. */
+static int
+t8_cmesh_mapped_check_trees (const char *first_tree,
+                             const t8_cmesh_mapped_header_t * header)
+{
+  const t8_ctree_struct_t *tree;
+  const t8_locidx_t  *face_neighbors;
+  const t8_attribute_info_struct_t *attributes, *info;
+  const int8_t       *ttf;
+  size_t              position, info_bytes, size = header->part_bytes;
+  t8_locidx_t         itree;
+  int                 iface, iattribute, num_faces, max_num_faces;
+
+  max_num_faces = t8_eclass_max_num_faces[header->dimension];
+  if (!t8_cmesh_mapped_in_range (0, header->num_trees
+                                 * sizeof (t8_ctree_struct_t), size)) {
+    return 0;
+  }
+  for (itree = 0; itree < header->num_trees; itree++) {
+    tree = (const t8_ctree_struct_t *) first_tree + itree;
+    position = itree * sizeof (t8_ctree_struct_t);
+    if (tree->treeid != itree || (int) tree->eclass < T8_ECLASS_ZERO
+        || (int) tree->eclass >= T8_ECLASS_COUNT
+        || t8_eclass_to_dimension[tree->eclass] != header->dimension
+        || tree->num_attributes < 0) {
+      return 0;
+    }
+    /* The face neighbors and tree to face values */
+    num_faces = t8_eclass_num_faces[tree->eclass];
+    if ((position + tree->neigh_offset) % sizeof (t8_locidx_t) != 0
+        || !t8_cmesh_mapped_in_range (position + tree->neigh_offset,
+                                      num_faces * (sizeof (t8_locidx_t) + 1),
+                                      size)) {
+      return 0;
+    }
+    face_neighbors = (const t8_locidx_t *) T8_TREE_FACE (tree);
+    ttf = (const int8_t *) T8_TREE_TTF (tree);
+    for (iface = 0; iface < num_faces; iface++) {
+      if (face_neighbors[iface] < 0
+          || face_neighbors[iface] >= header->num_trees || ttf[iface] < 0
+          || ttf[iface] >= T8_ECLASS_MAX_CORNERS_2D * max_num_faces) {
+        return 0;
+      }
+    }
+    /* The attribute infos and the attributes */
+    info_bytes = tree->num_attributes * sizeof (t8_attribute_info_struct_t);
+    if ((position + tree->att_offset) % sizeof (size_t) != 0
+        || !t8_cmesh_mapped_in_range (position + tree->att_offset,
+                                      info_bytes, size)) {
+      return 0;
+    }
+    attributes = (const t8_attribute_info_struct_t *)
+      T8_TREE_FIRST_ATT (tree);
+    for (iattribute = 0; iattribute < tree->num_attributes; iattribute++) {
+      /* The attributes are stored behind the attribute infos */
+      info = attributes + iattribute;
+      if (info->attribute_offset < info_bytes
+          || !t8_cmesh_mapped_in_range (info->attribute_offset,
+                                        info->attribute_size,
+                                        size - position - tree->att_offset)) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+/* Replace the package id of the attributes of all trees */
+static void
+t8_cmesh_mapped_set_package_id (char *first_tree, t8_locidx_t num_trees,
+                                int old_package_id)
+{
+  t8_ctree_t          tree;
+  t8_attribute_info_struct_t *attribute;
+  t8_locidx_t         itree;
+  int                 iattribute;
+
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = (t8_ctree_t) first_tree + itree;
+    attribute = (t8_attribute_info_struct_t *) ((char *) tree
+                                                + tree->att_offset);
+    for (iattribute = 0; iattribute < tree->num_attributes; iattribute++) {
+      if (attribute[iattribute].package_id == old_package_id) {
+        attribute[iattribute].package_id = t8_get_package_id ();
+      }
+    }
+  }
+}
+
+t8_cmesh_t
+t8_cmesh_load_mapped (const char *filename, sc_MPI_Comm comm)
+{
+  t8_cmesh_mapped_header_t header;
+  t8_cmesh_reader_file_t file;
+  t8_cmesh_t          cmesh;
+  t8_part_tree_t      part;
+  int                 eclass, ok, mpiret;
+
+  if (t8_cmesh_reader_file_map (filename, &file)) {
+    t8_errorf ("Error when opening file %s.\n", filename);
+    return NULL;
+  }
+  ok = file.size >= sizeof (header);
+  if (ok) {
+    memcpy (&header, file.data, sizeof (header));
+    ok = !memcmp (header.magic, T8_CMESH_MAPPED_MAGIC, sizeof (header.magic))
+      && header.format == T8_CMESH_MAPPED_FORMAT
+      && header.byte_order == T8_CMESH_MAPPED_BYTE_ORDER
+      && header.tree_size == (int32_t) sizeof (t8_ctree_struct_t)
+      && header.attribute_info_size ==
+      (int32_t) sizeof (t8_attribute_info_struct_t)
+      && header.locidx_size == (int32_t) sizeof (t8_locidx_t)
+      && 0 <= header.dimension && header.dimension <= 3
+      && 0 <= header.num_trees && header.num_trees <= T8_LOCIDX_MAX
+      && header.part_offset % T8_CMESH_MAPPED_ALIGN == 0
+      && header.part_offset >= (int64_t) sizeof (header)
+      && header.part_bytes >= 0
+      && t8_cmesh_mapped_in_range (header.part_offset, header.part_bytes,
+                                   file.size)
+      && t8_cmesh_mapped_check_trees (file.data + header.part_offset,
+                                      &header);
+  }
+  if (!ok) {
+    t8_errorf ("File %s is not a mapped cmesh file of this machine.\n",
+               filename);
+    t8_cmesh_reader_file_unmap (&file);
+    return NULL;
+  }
+
+  t8_cmesh_init (&cmesh);
+  cmesh->dimension = header.dimension;
+  cmesh->num_trees = header.num_trees;
+  cmesh->num_local_trees = header.num_trees;
+  cmesh->num_ghosts = 0;
+  cmesh->first_tree = 0;
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    cmesh->num_trees_per_eclass[eclass] = header.num_trees_per_eclass[eclass];
+    cmesh->num_local_trees_per_eclass[eclass] =
+      header.num_trees_per_eclass[eclass];
+  }
+  t8_cmesh_trees_init (&cmesh->trees, 1, cmesh->num_local_trees, 0);
+  t8_cmesh_trees_start_part (cmesh->trees, 0, 0, cmesh->num_local_trees, 0,
+                             0, 0);
+  if (header.package_id == t8_get_package_id ()) {
+    /* Use the file contents as the trees */
+    t8_cmesh_trees_set_mapped_part (cmesh->trees, &file, header.part_offset);
+  }
+  else {
+    /* The attributes are keyed with another package id, so we need to
+     * change them in a copy of the trees */
+    part = t8_cmesh_trees_get_part (cmesh->trees, 0);
+    part->first_tree = T8_ALLOC (char, SC_MAX (header.part_bytes, 1));
+    memcpy (part->first_tree, file.data + header.part_offset,
+            header.part_bytes);
+    t8_cmesh_reader_file_unmap (&file);
+    t8_cmesh_mapped_set_package_id (part->first_tree, cmesh->num_local_trees,
+                                    header.package_id);
+  }
+
+  cmesh->committed = 1;
+  mpiret = sc_MPI_Comm_rank (comm, &cmesh->mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &cmesh->mpisize);
+  SC_CHECK_MPI (mpiret);
+  t8_stash_destroy (&cmesh->stash);
+  return cmesh;
+}
+
+/* The number of bytes that a process hashes at once */
+#define T8_CMESH_CACHE_BLOCK (1 << 22)
+
+/* The FNV-1a hash of a byte range, continued from hash */
+static              uint64_t
+t8_cmesh_cache_hash_bytes (uint64_t hash, const void *data, size_t size)
+{
+  const unsigned char *bytes = (const unsigned char *) data;
+  size_t              ibyte;
+
+  for (ibyte = 0; ibyte < size; ibyte++) {
+    hash ^= bytes[ibyte];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/* Compute the key of an input file and options on all processes.
+ * Each process hashes one contiguous part of the file, and the hashes of
+ * the parts are combined in the order of the ranks.
+ * Return false on all processes if the file cannot be read. */
+static int
+t8_cmesh_cache_key (const char *input_file, const char *options,
+                    sc_MPI_Comm comm, uint64_t * key)
+{
+  t8_file_t           file;
+  FILE               *fp;
+  char               *buffer;
+  int64_t             file_size, begin, end, offset;
+  uint64_t            hash, *hashes;
+  size_t              count;
+  int                 mpirank, mpisize, mpiret, iproc, ok, all_ok;
+  const uint64_t      fnv_offset = 0xcbf29ce484222325ULL;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  /* The size of the input file */
+  file_size = -1;
+  if (mpirank == 0) {
+    fp = fopen (input_file, "rb");
+    if (fp != NULL) {
+      if (fseek (fp, 0, SEEK_END) == 0) {
+        file_size = (int64_t) ftell (fp);
+      }
+      fclose (fp);
+    }
+  }
+  mpiret = sc_MPI_Bcast (&file_size, 1, sc_MPI_LONG_LONG_INT, 0, comm);
+  SC_CHECK_MPI (mpiret);
+  if (file_size < 0 || !t8_file_open (&file, input_file, 0, comm)) {
+    return 0;
+  }
+
+  /* Hash our part of the file */
+  begin = file_size * mpirank / mpisize;
+  end = file_size * (mpirank + 1) / mpisize;
+  buffer = T8_ALLOC (char, T8_CMESH_CACHE_BLOCK);
+  hash = fnv_offset;
+  ok = 1;
+  for (offset = begin; ok && offset < end; offset += count) {
+    count = (size_t) SC_MIN (end - offset, T8_CMESH_CACHE_BLOCK);
+    ok = t8_file_read_at (&file, 0, offset, buffer, count, 1);
+    hash = t8_cmesh_cache_hash_bytes (hash, buffer, count);
+  }
+  T8_FREE (buffer);
+  t8_file_close (&file);
+  mpiret = sc_MPI_Allreduce (&ok, &all_ok, 1, sc_MPI_INT, sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  if (!all_ok) {
+    return 0;
+  }
+
+  /* Combine the parts with the options, the size and the number of
+   * processes, in particular, the partition depends on it */
+  hashes = T8_ALLOC (uint64_t, mpisize);
+  mpiret = sc_MPI_Allgather (&hash, 1, sc_MPI_UNSIGNED_LONG_LONG, hashes, 1,
+                             sc_MPI_UNSIGNED_LONG_LONG, comm);
+  SC_CHECK_MPI (mpiret);
+  hash = t8_cmesh_cache_hash_bytes (fnv_offset, hashes,
+                                    mpisize * sizeof (uint64_t));
+  T8_FREE (hashes);
+  hash = t8_cmesh_cache_hash_bytes (hash, &file_size, sizeof (file_size));
+  hash = t8_cmesh_cache_hash_bytes (hash, &mpisize, sizeof (mpisize));
+  iproc = T8_CMESH_PARALLEL_FORMAT;
+  hash = t8_cmesh_cache_hash_bytes (hash, &iproc, sizeof (iproc));
+  if (options != NULL) {
+    hash = t8_cmesh_cache_hash_bytes (hash, options, strlen (options));
+  }
+  *key = hash;
+  return 1;
+}
+
+t8_cmesh_t
+t8_cmesh_new_cached (const char *input_file, const char *options,
+                     const char *cache_dir, sc_MPI_Comm comm,
+                     t8_cmesh_build_fn build, void *user_data)
+{
+  t8_cmesh_t          cmesh;
+  FILE               *fp;
+  char                filename[BUFSIZ], tmpname[BUFSIZ];
+  uint64_t            key;
+  int                 mpirank, mpiret, exists, ok;
+
+  T8_ASSERT (input_file != NULL && build != NULL);
+  if (cache_dir == NULL) {
+    cache_dir = getenv (T8_CMESH_CACHE_DIR_ENV);
+  }
+  if (cache_dir == NULL || cache_dir[0] == '\0'
+      || !t8_cmesh_cache_key (input_file, options, comm, &key)) {
+    /* No cache */
+    return build (comm, user_data);
+  }
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  snprintf (filename, BUFSIZ, "%s/t8_cmesh_%016llx.t8c", cache_dir,
+            (unsigned long long) key);
+
+  /* Load the cmesh if it is in the cache */
+  exists = 0;
+  if (mpirank == 0) {
+    fp = fopen (filename, "rb");
+    if (fp != NULL) {
+      exists = 1;
+      fclose (fp);
+    }
+  }
+  mpiret = sc_MPI_Bcast (&exists, 1, sc_MPI_INT, 0, comm);
+  SC_CHECK_MPI (mpiret);
+  if (exists) {
+    cmesh = t8_cmesh_load_parallel (filename, comm);
+    if (cmesh != NULL) {
+      t8_global_productionf ("Loaded cmesh of %s from cache %s\n",
+                             input_file, filename);
+      return cmesh;
+    }
+    t8_global_errorf ("Could not load the cache file %s\n", filename);
+  }
+
+  /* Build the cmesh and store it under a temporary name, such that no
+   * other job loads an incomplete file */
+  cmesh = build (comm, user_data);
+  if (cmesh == NULL) {
+    return NULL;
+  }
+  snprintf (tmpname, BUFSIZ, "%s.tmp", filename);
+  ok = t8_cmesh_save_parallel (cmesh, tmpname, comm);
+  if (mpirank == 0) {
+    if (ok && rename (tmpname, filename) == 0) {
+      t8_global_productionf ("Stored cmesh of %s in cache %s\n", input_file,
+                             filename);
+    }
+    else {
+      t8_global_errorf ("Could not store the cache file %s\n", filename);
+      remove (tmpname);
+    }
+  }
+  return cmesh;
+}
@@ -28,6 +28,92 @@
 #include <t8_eclass.h>
 #include "t8_cmesh_stash.h"
 
+/* The number of bits of a digit of the radix sort */
+#define T8_STASH_RADIX_BITS 8
+
+/* Return the global tree id at offset id_offset of an entry as an unsigned
+ * integer with the same order */
+static inline uint64_t
+t8_stash_radix_key (const char *entry, size_t id_offset)
+{
+  t8_gloidx_t         id;
+
+  memcpy (&id, entry + id_offset, sizeof (t8_gloidx_t));
+  /* Flipping the sign bit maps the signed order to the unsigned order */
+  return (uint64_t) id ^ ((uint64_t) 1 << 63);
+}
+
+/* Sort the entries of an array stably by the global tree id at offset
+ * id_offset of each entry. We use a least significant digit radix sort
+ * and skip the digits in which all ids agree. If the array is already
+ * sorted, nothing is done. */
+static void
+t8_stash_radix_sort (sc_array_t * array, size_t id_offset)
+{
+  const size_t        count = array->elem_count;
+  const size_t        size = array->elem_size;
+  const size_t        num_buckets = (size_t) 1 << T8_STASH_RADIX_BITS;
+  size_t              ientry, ibucket, sum, temp;
+  size_t              bucket_offsets[(size_t) 1 << T8_STASH_RADIX_BITS];
+  uint64_t            key, last_key, keys_and, keys_or;
+  char               *source, *dest, *swap;
+  int                 shift, is_sorted = 1;
+
+  if (count < 2) {
+    return;
+  }
+  keys_and = ~(uint64_t) 0;
+  keys_or = 0;
+  last_key = 0;
+  for (ientry = 0; ientry < count; ientry++) {
+    key = t8_stash_radix_key (array->array + ientry * size, id_offset);
+    is_sorted = is_sorted && last_key <= key;
+    last_key = key;
+    keys_and &= key;
+    keys_or |= key;
+  }
+  if (is_sorted) {
+    return;
+  }
+
+  source = array->array;
+  dest = T8_ALLOC (char, count * size);
+  for (shift = 0; shift < 64; shift += T8_STASH_RADIX_BITS) {
+    if ((((keys_and ^ keys_or) >> shift) & (num_buckets - 1)) == 0) {
+      /* All ids have the same digit, this pass would not change anything */
+      continue;
+    }
+    memset (bucket_offsets, 0, sizeof (bucket_offsets));
+    for (ientry = 0; ientry < count; ientry++) {
+      key = t8_stash_radix_key (source + ientry * size, id_offset);
+      bucket_offsets[(key >> shift) & (num_buckets - 1)]++;
+    }
+    /* Exclusive prefix sum of the bucket sizes */
+    for (ibucket = 0, sum = 0; ibucket < num_buckets; ibucket++) {
+      temp = bucket_offsets[ibucket];
+      bucket_offsets[ibucket] = sum;
+      sum += temp;
+    }
+    for (ientry = 0; ientry < count; ientry++) {
+      key = t8_stash_radix_key (source + ientry * size, id_offset);
+      ibucket = (key >> shift) & (num_buckets - 1);
+      memcpy (dest + bucket_offsets[ibucket]++ * size, source + ientry * size,
+              size);
+    }
+    swap = source;
+    source = dest;
+    dest = swap;
+  }
+  if (source != array->array) {
+    /* The sorted entries are in the temporary buffer */
+    memcpy (array->array, source, count * size);
+    T8_FREE (source);
+  }
+  else {
+    T8_FREE (dest);
+  }
+}
+
 void
 t8_stash_init (t8_stash_t * pstash)
 {
@@ -76,26 +162,13 @@ t8_stash_add_class (t8_stash_t stash, t8_gloidx_t id, t8_eclass_t eclass)
   sclass->id = id;
 }
 
-/* returns -1 if treeid1 < treeid2
- *          0            =
- *         +1            >
- */
-static int
-t8_stash_class_compare (const void *c1, const void *c2)
-{
-  t8_stash_class_struct_t *class1, *class2;
-
-  class1 = (t8_stash_class_struct_t *) c1;
-  class2 = (t8_stash_class_struct_t *) c2;
-  return class1->id < class2->id ? -1 : class1->id != class2->id;
-}
-
 void
 t8_stash_class_sort (t8_stash_t stash)
 {
   T8_ASSERT (stash != NULL);
 
-  sc_array_sort (&stash->classes, t8_stash_class_compare);
+  t8_stash_radix_sort (&stash->classes,
+                       offsetof (t8_stash_class_struct_t, id));
 }
 
 static int
@@ -133,27 +206,13 @@ t8_stash_add_facejoin (t8_stash_t stash, t8_gloidx_t gid1, t8_gloidx_t gid2,
   sjoin->orientation = orientation;
 }
 
-/* return -1 if face1.id1 < face2.id1
- *         0              =
- *        +1              >
- */
-static int
-t8_stash_facejoin_compare (const void *j1, const void *j2)
-{
-  t8_stash_joinface_struct_t *join1, *join2;
-
-  join1 = (t8_stash_joinface_struct_t *) j1;
-  join2 = (t8_stash_joinface_struct_t *) j2;
-
-  return join1->id1 < join2->id1 ? -1 : join1->id1 != join2->id1;
-}
-
 void
 t8_stash_joinface_sort (t8_stash_t stash)
 {
   T8_ASSERT (stash != NULL);
 
-  sc_array_sort (&stash->joinfaces, t8_stash_facejoin_compare);
+  t8_stash_radix_sort (&stash->joinfaces,
+                       offsetof (t8_stash_joinface_struct_t, id1));
 }
 
 void
@@ -242,7 +301,29 @@ t8_stash_attribute_compare (const void *v1, const void *v2)
 void
 t8_stash_attribute_sort (t8_stash_t stash)
 {
-  sc_array_sort (&stash->attributes, t8_stash_attribute_compare);
+  sc_array_t         *attributes = &stash->attributes;
+  t8_stash_attribute_struct_t *attrs, temp;
+  size_t              first, last, iattr, jattr;
+
+  t8_stash_radix_sort (attributes,
+                       offsetof (t8_stash_attribute_struct_t, id));
+  /* A tree has only a few attributes. We sort the attributes of each tree
+   * by package id and key with insertion sort. */
+  attrs = (t8_stash_attribute_struct_t *) attributes->array;
+  for (first = 0; first < attributes->elem_count; first = last) {
+    for (last = first + 1; last < attributes->elem_count
+         && attrs[last].id == attrs[first].id; last++) {
+    }
+    for (iattr = first + 1; iattr < last; iattr++) {
+      temp = attrs[iattr];
+      for (jattr = iattr; jattr > first
+           && t8_stash_attribute_compare (&temp, attrs + jattr - 1) < 0;
+           jattr--) {
+        attrs[jattr] = attrs[jattr - 1];
+      }
+      attrs[jattr] = temp;
+    }
+  }
 }
 
 static void
@@ -280,7 +361,7 @@ t8_stash_bcast_attributes (sc_array_t * attributes, int root,
     }
   }
   /* broadcast buffer */
-  sc_MPI_Bcast (buffer, att_size, sc_MPI_BYTE, root, comm);
+  t8_mpi_bcast_bytes (buffer, att_size, root, comm);
   /* Copy attributes from buffer back to stash */
   if (mpirank != root) {
     copied_bytes = 0;
@@ -312,25 +393,20 @@ t8_stash_bcast (t8_stash_t stash, int root, sc_MPI_Comm comm,
     sc_array_resize (&stash->joinfaces, elem_counts[2]);
   }
   if (elem_counts[0] > 0) {
-    mpiret = sc_MPI_Bcast (stash->attributes.array,
-                           elem_counts[0] *
-                           sizeof (t8_stash_attribute_struct_t), sc_MPI_BYTE,
-                           0, comm);
-    SC_CHECK_MPI (mpiret);
+    t8_mpi_bcast_bytes (stash->attributes.array,
+                        elem_counts[0] * sizeof (t8_stash_attribute_struct_t),
+                        root, comm);
     t8_stash_bcast_attributes (&stash->attributes, root, comm);
   }
   if (elem_counts[1] > 0) {
-    mpiret = sc_MPI_Bcast (stash->classes.array,
-                           elem_counts[1] * sizeof (t8_stash_class_struct_t),
-                           sc_MPI_BYTE, 0, comm);
-    SC_CHECK_MPI (mpiret);
+    t8_mpi_bcast_bytes (stash->classes.array,
+                        elem_counts[1] * sizeof (t8_stash_class_struct_t),
+                        root, comm);
   }
   if (elem_counts[2] > 0) {
-    mpiret = sc_MPI_Bcast (stash->joinfaces.array,
-                           elem_counts[2] *
-                           sizeof (t8_stash_joinface_struct_t), sc_MPI_BYTE,
-                           0, comm);
-    SC_CHECK_MPI (mpiret);
+    t8_mpi_bcast_bytes (stash->joinfaces.array,
+                        elem_counts[2] * sizeof (t8_stash_joinface_struct_t),
+                        root, comm);
   }
   return stash;
 }
@@ -76,6 +76,7 @@ t8_cmesh_trees_init (t8_cmesh_trees_t * ptrees, int num_procs,
   T8_ASSERT (num_ghosts >= 0);
 
   trees = *ptrees = T8_ALLOC (t8_cmesh_trees_struct_t, 1);
+  t8_refcount_init (&trees->rc);
   trees->from_proc = sc_array_new_size (sizeof (t8_part_tree_struct_t),
                                         num_procs);
   trees->tree_to_proc = T8_ALLOC_ZERO (int, num_trees);
@@ -88,7 +89,14 @@ t8_cmesh_trees_init (t8_cmesh_trees_t * ptrees, int num_procs,
   trees->ghost_globalid_to_local_id =
     sc_hash_new (t8_cmesh_trees_glo_lo_hash_func,
                  t8_cmesh_trees_glo_lo_hash_equal, NULL, NULL);
-
+  trees->shared_part = NULL;
+  trees->mapped_file = NULL;
+  trees->compact_stride = 0;
+  trees->compact_num_trees = 0;
+  trees->compact_num_ghosts = 0;
+  trees->compact_eclass = NULL;
+  trees->compact_neighbors = NULL;
+  trees->compact_ttf = NULL;
 }
 
 void
@@ -113,6 +121,41 @@ t8_cmesh_trees_add_tree (t8_cmesh_trees_t trees, t8_locidx_t ltree_id,
   trees->tree_to_proc[ltree_id] = proc;
 }
 
+void
+t8_cmesh_trees_add_trees (t8_cmesh_trees_t trees, int proc,
+                          const t8_stash_class_struct_t * classes,
+                          t8_locidx_t num_trees, t8_gloidx_t first_tree,
+                          t8_locidx_t * num_trees_per_eclass)
+{
+  t8_part_tree_t      part;
+  t8_ctree_t          first, tree;
+  t8_locidx_t         itree, ltree_id;
+
+  T8_ASSERT (trees != NULL);
+  T8_ASSERT (proc >= 0);
+  T8_ASSERT (num_trees >= 0);
+
+  part = t8_cmesh_trees_get_part (trees, proc);
+  first = (t8_ctree_t) part->first_tree;
+  for (itree = 0; itree < num_trees; itree++) {
+    ltree_id = classes[itree].id - first_tree;
+    T8_ASSERT (0 <= ltree_id - part->first_tree_id
+               && ltree_id - part->first_tree_id < part->num_trees);
+    tree = first + ltree_id - part->first_tree_id;
+    SC_CHECK_ABORTF ((int) tree->eclass == 0 && tree->treeid == 0,
+                     "A duplicate treeid (%li) was found.\n",
+                     (long) ltree_id);
+    tree->eclass = classes[itree].eclass;
+    tree->treeid = ltree_id;
+    /* The part memory is zeroed, so the offsets and the number of
+     * attributes are already 0 */
+    trees->tree_to_proc[ltree_id] = proc;
+    if (num_trees_per_eclass != NULL) {
+      num_trees_per_eclass[classes[itree].eclass]++;
+    }
+  }
+}
+
 void
 t8_cmesh_trees_add_ghost (t8_cmesh_trees_t trees, t8_locidx_t lghost_index,
                           t8_gloidx_t gtree_id, int proc, t8_eclass_t eclass,
@@ -470,6 +513,53 @@ t8_cmesh_trees_copy_part (t8_cmesh_trees_t trees_dest, int part_dest,
   memcpy (partD->first_tree, partS->first_tree, byte_count);
 }
 
+void
+t8_cmesh_trees_share (t8_cmesh_trees_t trees, sc_MPI_Comm comm)
+{
+  t8_part_tree_t      part;
+  size_t              byte_count;
+
+  T8_ASSERT (trees->from_proc->elem_count == 1);
+  T8_ASSERT (trees->shared_part == NULL);
+
+  part = t8_cmesh_trees_get_part (trees, 0);
+  byte_count = t8_cmesh_trees_get_part_alloc (trees, part);
+  t8_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
+  t8_shmem_array_init (&trees->shared_part, 1, SC_MAX (byte_count, 1), comm);
+  /* One process per node copies the part into the shared array */
+  if (t8_shmem_array_start_writing (trees->shared_part) && byte_count > 0) {
+    memcpy (t8_shmem_array_get_array (trees->shared_part), part->first_tree,
+            byte_count);
+  }
+  t8_shmem_array_end_writing (trees->shared_part);
+  T8_FREE (part->first_tree);
+  part->first_tree = (char *) t8_shmem_array_get_array (trees->shared_part);
+}
+
+int
+t8_cmesh_trees_is_shared (t8_cmesh_trees_t trees)
+{
+  return trees->shared_part != NULL;
+}
+
+void
+t8_cmesh_trees_set_mapped_part (t8_cmesh_trees_t trees,
+                                t8_cmesh_reader_file_t * file, size_t offset)
+{
+  t8_part_tree_t      part;
+
+  T8_ASSERT (trees->from_proc->elem_count == 1);
+  T8_ASSERT (trees->shared_part == NULL && trees->mapped_file == NULL);
+  T8_ASSERT (offset % sizeof (double) == 0 && offset <= file->size);
+
+  part = t8_cmesh_trees_get_part (trees, 0);
+  T8_ASSERT (part->first_tree == NULL);
+  /* We take over the file and release it when the trees are destroyed */
+  trees->mapped_file = T8_ALLOC (t8_cmesh_reader_file_t, 1);
+  *trees->mapped_file = *file;
+  part->first_tree = file->data + offset;
+}
+
 t8_ctree_t
 t8_cmesh_trees_get_tree (t8_cmesh_trees_t trees, t8_locidx_t ltree)
 {
@@ -509,6 +599,134 @@ t8_cmesh_trees_get_face_neighbor (t8_ctree_t tree, int face)
   return face_neighbors[face];
 }
 
+/* Free the arrays of the compact layout, if any */
+static void
+t8_cmesh_trees_free_compact (t8_cmesh_trees_t trees)
+{
+  const size_t        num_faces =
+    (size_t) trees->compact_num_trees * trees->compact_stride;
+
+  t8_free_large (trees->compact_eclass,
+                 (size_t) (trees->compact_num_trees +
+                           trees->compact_num_ghosts) * sizeof (int8_t));
+  t8_free_large (trees->compact_neighbors, num_faces * sizeof (t8_locidx_t));
+  t8_free_large (trees->compact_ttf, num_faces * sizeof (int8_t));
+  trees->compact_eclass = NULL;
+  trees->compact_neighbors = NULL;
+  trees->compact_ttf = NULL;
+  trees->compact_num_trees = 0;
+  trees->compact_num_ghosts = 0;
+  trees->compact_stride = 0;
+}
+
+void
+t8_cmesh_trees_build_compact (t8_cmesh_trees_t trees, int dimension,
+                              t8_locidx_t num_trees, t8_locidx_t num_ghosts)
+{
+  t8_locidx_t         itree, ighost;
+  t8_ctree_t          tree;
+  t8_locidx_t        *face_neigh;
+  int8_t             *ttf;
+  size_t              num_faces;
+  int                 stride, iface, tree_faces;
+
+  T8_ASSERT (trees != NULL);
+  T8_ASSERT (0 <= dimension && dimension <= T8_ECLASS_MAX_DIM);
+  T8_ASSERT (num_trees >= 0 && num_ghosts >= 0);
+
+  t8_cmesh_trees_free_compact (trees);
+  if (num_trees + num_ghosts == 0) {
+    return;
+  }
+  stride = t8_eclass_max_num_faces[dimension];
+  num_faces = (size_t) num_trees * stride;
+  trees->compact_eclass = (int8_t *)
+    t8_alloc_large ((size_t) (num_trees + num_ghosts) * sizeof (int8_t));
+  if (num_faces > 0) {
+    trees->compact_neighbors = (t8_locidx_t *)
+      t8_alloc_large (num_faces * sizeof (t8_locidx_t));
+    trees->compact_ttf = (int8_t *) t8_alloc_large (num_faces);
+  }
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_cmesh_trees_get_tree_ext (trees, itree, &face_neigh, &ttf);
+    trees->compact_eclass[itree] = (int8_t) tree->eclass;
+    tree_faces = t8_eclass_num_faces[tree->eclass];
+    for (iface = 0; iface < stride; iface++) {
+      const size_t        index = (size_t) itree * stride + iface;
+      /* Faces that the tree does not have are padded with -1 */
+      trees->compact_neighbors[index] =
+        iface < tree_faces ? face_neigh[iface] : -1;
+      trees->compact_ttf[index] = iface < tree_faces ? ttf[iface] : -1;
+    }
+  }
+  for (ighost = 0; ighost < num_ghosts; ighost++) {
+    trees->compact_eclass[num_trees + ighost] =
+      (int8_t) t8_cmesh_trees_get_ghost (trees, ighost)->eclass;
+  }
+  trees->compact_stride = stride;
+  trees->compact_num_trees = num_trees;
+  trees->compact_num_ghosts = num_ghosts;
+}
+
+size_t
+t8_cmesh_trees_compact_size (t8_cmesh_trees_t trees)
+{
+  const size_t        num_faces =
+    (size_t) trees->compact_num_trees * trees->compact_stride;
+
+  T8_ASSERT (trees != NULL);
+  return (size_t) (trees->compact_num_trees + trees->compact_num_ghosts)
+    + num_faces * (sizeof (t8_locidx_t) + sizeof (int8_t));
+}
+
+t8_locidx_t
+t8_cmesh_trees_get_face_neighbor_ext (t8_cmesh_trees_t trees,
+                                      t8_locidx_t ltree_id, int face,
+                                      int8_t * ttf)
+{
+  t8_locidx_t        *face_neigh;
+  int8_t             *tree_ttf;
+
+  T8_ASSERT (trees != NULL);
+  T8_ASSERT (ltree_id >= 0);
+  if (trees->compact_neighbors != NULL) {
+    const size_t        index =
+      (size_t) ltree_id * trees->compact_stride + face;
+
+    T8_ASSERT (ltree_id < trees->compact_num_trees);
+    T8_ASSERT (0 <= face && face <
+               t8_eclass_num_faces[trees->compact_eclass[ltree_id]]);
+    if (ttf != NULL) {
+      *ttf = trees->compact_ttf[index];
+    }
+    return trees->compact_neighbors[index];
+  }
+  /* The compact layout was not built, read the tree */
+  (void) t8_cmesh_trees_get_tree_ext (trees, ltree_id, &face_neigh,
+                                      &tree_ttf);
+  if (ttf != NULL) {
+    *ttf = tree_ttf[face];
+  }
+  return face_neigh[face];
+}
+
+t8_eclass_t
+t8_cmesh_trees_get_class (t8_cmesh_trees_t trees, t8_locidx_t ltree_id,
+                          t8_locidx_t num_trees)
+{
+  T8_ASSERT (trees != NULL);
+  T8_ASSERT (ltree_id >= 0);
+  if (trees->compact_eclass != NULL) {
+    T8_ASSERT (num_trees == trees->compact_num_trees);
+    T8_ASSERT (ltree_id < num_trees + trees->compact_num_ghosts);
+    return (t8_eclass_t) trees->compact_eclass[ltree_id];
+  }
+  if (ltree_id < num_trees) {
+    return t8_cmesh_trees_get_tree (trees, ltree_id)->eclass;
+  }
+  return t8_cmesh_trees_get_ghost (trees, ltree_id - num_trees)->eclass;
+}
+
 t8_cghost_t
 t8_cmesh_trees_get_ghost (t8_cmesh_trees_t trees, t8_locidx_t lghost)
 {
@@ -625,6 +843,18 @@ void
 t8_cmesh_trees_add_attribute (t8_cmesh_trees_t trees, int proc,
                               t8_stash_attribute_struct_t * attr,
                               t8_locidx_t tree_id, size_t index)
+{
+  char               *new_attr;
+
+  new_attr = t8_cmesh_trees_add_attribute_info (trees, proc, attr, tree_id,
+                                                index);
+  memcpy (new_attr, attr->attr_data, attr->attr_size);
+}
+
+char               *
+t8_cmesh_trees_add_attribute_info (t8_cmesh_trees_t trees, int proc,
+                                   t8_stash_attribute_struct_t * attr,
+                                   t8_locidx_t tree_id, size_t index)
 {
   t8_part_tree_t      part;
   t8_ctree_t          tree;
@@ -642,8 +872,6 @@ t8_cmesh_trees_add_attribute (t8_cmesh_trees_t trees, int proc,
   attr_info = T8_TREE_ATTR_INFO (tree, index);
   new_attr = T8_TREE_ATTR (tree, attr_info);
 
-  memcpy (new_attr, attr->attr_data, attr->attr_size);
-
   /* Set new values */
   attr_info->key = attr->key;
   attr_info->package_id = attr->package_id;
@@ -660,6 +888,7 @@ t8_cmesh_trees_add_attribute (t8_cmesh_trees_t trees, int proc,
         sizeof (t8_attribute_info_struct_t);
     }
   }
+  return new_attr;
 }
 
 #if 0
@@ -740,6 +969,10 @@ t8_cmesh_trees_compare_keyattr (const void *A1, const void *A2)
   }
 }
 
+/* Up to this number of attributes of a tree we search linearly for an
+ * attribute instead of using a binary search */
+#define T8_CMESH_TREES_ATTR_LINEAR 8
+
 /* The size of the attribute is not returned, but would be accesible */
 void               *
 t8_cmesh_trees_get_attribute (t8_cmesh_trees_t trees, t8_locidx_t ltree_id,
@@ -788,16 +1021,40 @@ t8_cmesh_trees_get_attribute (t8_cmesh_trees_t trees, t8_locidx_t ltree_id,
     return NULL;
   }
 
-  sc_array_init_data (&attr_array, first_att_info,
-                      sizeof (t8_attribute_info_struct_t), num_attributes);
-  index = sc_array_bsearch (&attr_array, &key_id,
-                            t8_cmesh_trees_compare_keyattr);
-
-  if (index < 0) {
-    return NULL;
+  /* The attribute infos are sorted by package id and key.
+   * The tree vertices have the key 0 of the t8code package, which
+   * is registered before any application package. Thus, they are almost
+   * always stored at the first position and we check it directly.
+   * Short lists are searched linearly and only long lists with a
+   * binary search. */
+  attr_info = (t8_attribute_info_struct_t *) first_att_info;
+  if (attr_info->package_id != package_id || attr_info->key != key) {
+    if (num_attributes <= T8_CMESH_TREES_ATTR_LINEAR) {
+      for (index = 1; index < num_attributes; index++) {
+        if (attr_info[index].package_id == package_id
+            && attr_info[index].key == key) {
+          break;
+        }
+      }
+      if (index >= num_attributes) {
+        return NULL;
+      }
+      attr_info += index;
+    }
+    else {
+      sc_array_init_data (&attr_array, first_att_info,
+                          sizeof (t8_attribute_info_struct_t),
+                          num_attributes);
+      index = sc_array_bsearch (&attr_array, &key_id,
+                                t8_cmesh_trees_compare_keyattr);
+
+      if (index < 0) {
+        return NULL;
+      }
+      attr_info = (t8_attribute_info_struct_t *)
+        sc_array_index (&attr_array, index);
+    }
   }
-  attr_info = (t8_attribute_info_struct_t *)
-    sc_array_index (&attr_array, index);
   if (size != NULL) {
     *size = attr_info->attribute_size;
   }
@@ -1001,14 +1258,11 @@ t8_cmesh_trees_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
       part->first_ghost_id = 0;
     }
     /* Bcast the part information */
-    mpiret =
-      sc_MPI_Bcast (part->first_tree, part_info.num_bytes, sc_MPI_BYTE, root,
-                    comm);
-    SC_CHECK_MPI (mpiret);
+    t8_mpi_bcast_bytes (part->first_tree, part_info.num_bytes, root, comm);
   }                             /* end for */
   /* Bcast the tree_to_proc array */
-  sc_MPI_Bcast (trees->tree_to_proc, cmesh_in->num_trees, sc_MPI_INT, root,
-                comm);
+  t8_mpi_bcast_bytes (trees->tree_to_proc,
+                      cmesh_in->num_trees * sizeof (int), root, comm);
 }
 
 /* Check whether for each tree its neighbors are set consistently, that means that
@@ -1224,6 +1478,25 @@ t8_cmesh_trees_is_equal (t8_cmesh_t cmesh, t8_cmesh_trees_t trees_a,
   return 1;
 }
 
+void
+t8_cmesh_trees_ref (t8_cmesh_trees_t trees)
+{
+  T8_ASSERT (trees != NULL);
+  t8_refcount_ref (&trees->rc);
+}
+
+void
+t8_cmesh_trees_unref (t8_cmesh_trees_t * ptrees)
+{
+  T8_ASSERT (ptrees != NULL && *ptrees != NULL);
+
+  if (t8_refcount_unref (&(*ptrees)->rc)) {
+    /* This was the last reference */
+    t8_cmesh_trees_destroy (ptrees);
+  }
+  *ptrees = NULL;
+}
+
 void
 t8_cmesh_trees_destroy (t8_cmesh_trees_t * ptrees)
 {
@@ -1231,10 +1504,23 @@ t8_cmesh_trees_destroy (t8_cmesh_trees_t * ptrees)
   t8_cmesh_trees_t    trees = *ptrees;
   t8_part_tree_t      part;
 
-  for (proc = 0; proc < trees->from_proc->elem_count; proc++) {
-    part = t8_cmesh_trees_get_part (trees, proc);
-    T8_FREE (part->first_tree);
+  T8_ASSERT (trees->rc.refcount <= 1);
+  if (trees->shared_part != NULL) {
+    /* The memory of the part belongs to the shared array */
+    t8_shmem_array_destroy (&trees->shared_part);
+  }
+  else if (trees->mapped_file != NULL) {
+    /* The memory of the part belongs to the file */
+    t8_cmesh_reader_file_unmap (trees->mapped_file);
+    T8_FREE (trees->mapped_file);
+  }
+  else {
+    for (proc = 0; proc < trees->from_proc->elem_count; proc++) {
+      part = t8_cmesh_trees_get_part (trees, proc);
+      T8_FREE (part->first_tree);
+    }
   }
+  t8_cmesh_trees_free_compact (trees);
   T8_FREE (trees->ghost_to_proc);
   T8_FREE (trees->tree_to_proc);
   sc_array_destroy (trees->from_proc);
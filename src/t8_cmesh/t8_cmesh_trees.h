@@ -31,6 +31,7 @@
 #include <t8.h>
 #include <t8_cmesh.h>
 #include "t8_cmesh_types.h"
+#include "t8_cmesh_reader.h"
 
 T8_EXTERN_C_BEGIN ();
 
@@ -266,6 +267,29 @@ void                t8_cmesh_trees_add_tree (t8_cmesh_trees_t trees,
                                              t8_locidx_t ltree_id, int proc,
                                              t8_eclass_t eclass);
 
+/** Add trees with given classes to a trees structure.
+ * This is equivalent to calling \ref t8_cmesh_trees_add_tree for each
+ * entry of \a classes, but does not look up the part for each tree.
+ * \param [in,out]  trees The trees structure to be updated.
+ * \param [in]      proc  The mpirank of the process from which the trees were
+ *                        received.
+ * \param [in]      classes The global ids and classes of the trees.
+ * \param [in]      num_trees The number of entries in \a classes.
+ * \param [in]      first_tree The global id of the first local tree.
+ *                        The local id of a tree is its global id minus
+ *                        \a first_tree.
+ * \param [in,out]  num_trees_per_eclass If not NULL, for each tree the
+ *                        entry of its class is incremented.
+ */
+void                t8_cmesh_trees_add_trees (t8_cmesh_trees_t trees,
+                                              int proc,
+                                              const t8_stash_class_struct_t
+                                              * classes,
+                                              t8_locidx_t num_trees,
+                                              t8_gloidx_t first_tree,
+                                              t8_locidx_t *
+                                              num_trees_per_eclass);
+
 /** Add a ghost to a trees structure.
  * \param [in,out]  trees The trees structure to be updated.
  * \param [in]      ghost_index The index in the part array of the ghost to be inserted.
@@ -329,6 +353,61 @@ t8_ctree_t          t8_cmesh_trees_get_tree_ext (t8_cmesh_trees_t trees,
 t8_locidx_t         t8_cmesh_trees_get_face_neighbor (t8_ctree_t tree,
                                                       int face);
 
+/** Build the compact layout of the face neighbors and element classes.
+ * The trees get separate arrays of the element class of each tree and
+ * ghost and of the face neighbors and tree to face values of each tree,
+ * with a fixed number of faces per tree. The lookups
+ * \ref t8_cmesh_trees_get_face_neighbor_ext and
+ * \ref t8_cmesh_trees_get_class use these arrays.
+ * A previously built compact layout is replaced.
+ * The layout must be rebuilt if the face neighbors of the trees change.
+ * \param [in,out]  trees      The trees of a committed cmesh.
+ * \param [in]      dimension  The dimension of the cmesh.
+ * \param [in]      num_trees  The number of local trees.
+ * \param [in]      num_ghosts The number of ghosts.
+ */
+void                t8_cmesh_trees_build_compact (t8_cmesh_trees_t trees,
+                                                  int dimension,
+                                                  t8_locidx_t num_trees,
+                                                  t8_locidx_t num_ghosts);
+
+/** Return the number of bytes of the compact layout of a trees struct.
+ * \param [in]      trees      The trees.
+ * \return                     The bytes allocated by
+ *                              \ref t8_cmesh_trees_build_compact, 0 if the
+ *                              layout was not built.
+ */
+size_t              t8_cmesh_trees_compact_size (t8_cmesh_trees_t trees);
+
+/** Given a local tree and a face number, return the local id of the
+ * neighbor tree and the tree to face value of the connection.
+ * If the compact layout was built, only its arrays are read.
+ * \param [in]      trees      The trees.
+ * \param [in]      ltree_id   The local id of a local tree.
+ * \param [in]      face       A face of the tree.
+ * \param [out]     ttf        If not NULL, the tree to face value of the
+ *                              face is stored here.
+ * \return                     The local id of the neighbor tree.
+ */
+t8_locidx_t         t8_cmesh_trees_get_face_neighbor_ext (t8_cmesh_trees_t
+                                                          trees,
+                                                          t8_locidx_t
+                                                          ltree_id, int face,
+                                                          int8_t * ttf);
+
+/** Return the element class of a local tree or a ghost.
+ * If the compact layout was built, only its array is read.
+ * \param [in]      trees      The trees.
+ * \param [in]      ltree_id   The local id of a local tree or of a ghost.
+ *                              A ghost has the number of local trees plus
+ *                              its ghost index as id.
+ * \param [in]      num_trees  The number of local trees.
+ * \return                     The element class of the tree or ghost.
+ */
+t8_eclass_t         t8_cmesh_trees_get_class (t8_cmesh_trees_t trees,
+                                              t8_locidx_t ltree_id,
+                                              t8_locidx_t num_trees);
+
 /* TODO: This function return NULL if the ghost is not present.
  *       So far no error checking is done here. */
 /** Return a pointer to a specific ghost in a trees struct.
@@ -436,6 +515,20 @@ void                t8_cmesh_trees_add_attribute (t8_cmesh_trees_t trees,
                                                   * attr, t8_locidx_t tree_id,
                                                   size_t index);
 
+/** Set the key, package id, size and offset of an attribute of a tree as
+ * \ref t8_cmesh_trees_add_attribute does, but do not copy its data.
+ * The attributes of a part must be added in order, but their data can be
+ * copied afterwards in any order, for example by several threads.
+ * \return The memory to which the \a attr->attr_size bytes of the
+ *         attribute data must be copied.
+ */
+char               *t8_cmesh_trees_add_attribute_info (t8_cmesh_trees_t
+                                                       trees, int proc,
+                                                       t8_stash_attribute_struct_t
+                                                       * attr,
+                                                       t8_locidx_t tree_id,
+                                                       size_t index);
+
 /** Return the number of parts of a trees structure.
  * \param [in]        trees The trees structure.
  * \return            The number of parts in \a trees.
@@ -482,9 +575,58 @@ int                 t8_cmesh_trees_is_equal (t8_cmesh_t cmesh,
                                              t8_cmesh_trees_t trees_a,
                                              t8_cmesh_trees_t trees_b);
 
+/** Move the trees of a replicated trees structure into shared memory,
+ * such that they are stored only once on each node.
+ * One process of each node copies the trees and the other processes
+ * free their copy. Afterwards the trees must not be modified.
+ * Since each process passes its own copy, the peak memory is that of
+ * the private copies plus the shared one.
+ * This function is collective on \a comm.
+ * \param [in,out]  trees The tree structure. It must have exactly one part
+ *                        for which \ref t8_cmesh_trees_finish_part was called.
+ * \param [in]      comm  The communicator of the cmesh.
+ */
+void                t8_cmesh_trees_share (t8_cmesh_trees_t trees,
+                                          sc_MPI_Comm comm);
+
+/** Query whether the trees of a trees structure are stored in shared memory.
+ * \param [in]      trees The tree structure.
+ * \return                True if \ref t8_cmesh_trees_share was called.
+ */
+int                 t8_cmesh_trees_is_shared (t8_cmesh_trees_t trees);
+
+/** Let the only part of a trees structure point into the contents of a
+ * file, which store the part's memory as it is laid out in memory.
+ * Afterwards the trees must not be modified.
+ * \param [in,out]  trees  The tree structure. It must have exactly one part
+ *                         that has no memory yet.
+ * \param [in]      file   A file view created with
+ *                         \ref t8_cmesh_reader_file_map. The trees take over
+ *                         the view and release it when they are destroyed.
+ * \param [in]      offset The position of the part's memory in \a file.
+ */
+void                t8_cmesh_trees_set_mapped_part (t8_cmesh_trees_t trees,
+                                                    t8_cmesh_reader_file_t *
+                                                    file, size_t offset);
+
+/** Increase the reference count of a trees structure.
+ * A committed trees structure is not changed anymore and may be shared by
+ * several cmeshes, see \ref t8_cmesh_share_trees.
+ * \param [in,out]  trees A trees structure.
+ */
+void                t8_cmesh_trees_ref (t8_cmesh_trees_t trees);
+
+/** Decrease the reference count of a trees structure.
+ * If it reaches zero, the trees are destroyed with \ref t8_cmesh_trees_destroy.
+ * \param [in,out]  trees The tree structure. Set to NULL on output.
+ */
+void                t8_cmesh_trees_unref (t8_cmesh_trees_t * trees);
+
 /** Free all memory allocated with a trees structure.
  *  This means that all coarse trees and ghosts, their face neighbor entries
  *  and attributes and the additional structures of trees are freed.
+ *  If the trees are stored in shared memory, this function is collective.
+ *  The trees must not be referenced by another cmesh.
  * \param [in,out]  trees The tree structure to be destroyed. Set to NULL on output.
  */
 void                t8_cmesh_trees_destroy (t8_cmesh_trees_t * trees);
@@ -25,6 +25,8 @@
 #include <t8_cmesh_vtk.h>
 #include "t8_cmesh_types.h"
 #include "t8_cmesh_stash.h"
+#include "t8_cmesh_face_matching.h"
+#include "t8_cmesh_reader.h"
 
 /* TODO: if partitioned then only add the needed face-connections to join faces
  *       maybe also only trees and ghosts to classes.
@@ -34,34 +36,151 @@
  *       creating .neigh files with tetgen/triangle is not common and even seems
  *       to not work sometimes */
 
-/* Read a the next line from a file stream that does not start with '#' or
- * contains only whitespaces (tabs etc.)
- *
- * \param [in,out] line     An allocated string to store the line.
- * \param [in,out] n        The number of allocated bytes.
- *                          If more bytes are needed line is reallocated and
- *                          the new number of bytes is stored in n.
- * \param [in]     fp       The file stream to read from.
- * \return                  The number of read arguments of the last line read.
- *                          negative on failure */
+/* The bulk parser for TRIANGLE and TETGEN files.
+ * The file is mapped into memory and the numbers are parsed directly from
+ * there. Integers are converted by hand. Doubles are copied into a short
+ * buffer and converted with strtod, such that they are rounded exactly as
+ * by sscanf. */
+
+/* The maximum number of characters of a double in a file */
+#define T8_CMESH_TRIANGLE_MAX_NUMBER_LENGTH 63
+
+/* A position in the contents of a TRIANGLE or TETGEN file */
+typedef struct
+{
+  const char         *pos;      /* The next character to read */
+  const char         *end;      /* The end of the contents */
+} t8_cmesh_triangle_parser_t;
+
+/* Return true if c ends a number on a line */
 static int
-t8_cmesh_triangle_read_next_line (char **line, size_t * n, FILE * fp)
+t8_cmesh_triangle_is_separator (char c)
 {
-  int                 retval;
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'
+    || c == '\n' || c == '#';
+}
+
+/* Move the parser to the first number of the next line that is neither
+ * a comment nor blank. The parser must be at the beginning of a line.
+ * Return 0 on success and -1 at the end of the file. */
+static int
+t8_cmesh_triangle_parser_next_line (t8_cmesh_triangle_parser_t * parser)
+{
+  const char         *pos = parser->pos;
+
+  while (pos < parser->end) {
+    if (*pos == '#') {
+      /* skip the comment until the end of the line */
+      pos = (const char *) memchr (pos, '\n', parser->end - pos);
+      if (pos == NULL) {
+        pos = parser->end;
+      }
+    }
+    else if (t8_cmesh_triangle_is_separator (*pos)) {
+      pos++;
+    }
+    else {
+      parser->pos = pos;
+      return 0;
+    }
+  }
+  parser->pos = pos;
+  return -1;
+}
+
+/* Move the parser behind the end of the current line. This skips
+ * all numbers of the line that were not read. */
+static void
+t8_cmesh_triangle_parser_skip_line (t8_cmesh_triangle_parser_t * parser)
+{
+  const char         *newline;
+
+  newline =
+    (const char *) memchr (parser->pos, '\n', parser->end - parser->pos);
+  parser->pos = newline == NULL ? parser->end : newline + 1;
+}
+
+/* Move the parser to the next number on the current line.
+ * Return 0 on success and -1 if the line has no further number. */
+static int
+t8_cmesh_triangle_parser_skip_blanks (t8_cmesh_triangle_parser_t * parser)
+{
+  const char         *pos = parser->pos;
+
+  while (pos < parser->end && (*pos == ' ' || *pos == '\t' || *pos == '\r'
+                               || *pos == '\v' || *pos == '\f')) {
+    pos++;
+  }
+  parser->pos = pos;
+  return pos == parser->end || *pos == '\n' || *pos == '#' ? -1 : 0;
+}
 
-  do {
-    /* read first non-comment line from file */
-    /* TODO: getline depends on IEEE Std 1003.1-2008 (``POSIX.1'')
-     *       p4est therefore has its own getline function in p4est_connectivity.h. */
-    retval = getline (line, n, fp);
-    if (retval < 0) {
-      return retval;
+/* Parse the next integer on the current line.
+ * Return 0 on success and -1 on failure or if the integer does not
+ * fit into a long. */
+static int
+t8_cmesh_triangle_parse_long (t8_cmesh_triangle_parser_t * parser,
+                              long *value)
+{
+  const char         *pos;
+  long                result = 0;
+  int                 negative = 0;
+
+  if (t8_cmesh_triangle_parser_skip_blanks (parser)) {
+    return -1;
+  }
+  pos = parser->pos;
+  if (*pos == '-' || *pos == '+') {
+    negative = *pos == '-';
+    pos++;
+  }
+  if (pos == parser->end || *pos < '0' || '9' < *pos) {
+    return -1;
+  }
+  while (pos < parser->end && '0' <= *pos && *pos <= '9') {
+    if (result > (LONG_MAX - (*pos - '0')) / 10) {
+      /* The number does not fit into a long */
+      return -1;
     }
+    result = 10 * result + (*pos - '0');
+    pos++;
+  }
+  if (pos < parser->end && !t8_cmesh_triangle_is_separator (*pos)) {
+    return -1;
   }
-  /* check if line is a comment (trainling '#') or consists solely of
-   * blank spaces/tabs */
-  while (*line[0] == '#' || strspn (*line, " \t\r\v\n") == strlen (*line));
-  return retval;
+  *value = negative ? -result : result;
+  parser->pos = pos;
+  return 0;
+}
+
+/* Parse the next double on the current line.
+ * Return 0 on success and -1 on failure. */
+static int
+t8_cmesh_triangle_parse_double (t8_cmesh_triangle_parser_t * parser,
+                                double *value)
+{
+  char                buffer[T8_CMESH_TRIANGLE_MAX_NUMBER_LENGTH + 1];
+  char               *number_end;
+  size_t              length = 0;
+
+  if (t8_cmesh_triangle_parser_skip_blanks (parser)) {
+    return -1;
+  }
+  while (parser->pos + length < parser->end
+         && !t8_cmesh_triangle_is_separator (parser->pos[length])) {
+    if (length == T8_CMESH_TRIANGLE_MAX_NUMBER_LENGTH) {
+      return -1;
+    }
+    buffer[length] = parser->pos[length];
+    length++;
+  }
+  buffer[length] = '\0';
+  *value = strtod (buffer, &number_end);
+  if (number_end != buffer + length) {
+    return -1;
+  }
+  parser->pos += length;
+  return 0;
 }
 
 /* Open .node file  and read node input
@@ -74,45 +193,40 @@ static int
 t8_cmesh_triangle_read_nodes (t8_cmesh_t cmesh, char *filename,
                               double **vertices, long *num_corners, int dim)
 {
-  FILE               *fp;
-  char               *line = (char *) malloc (1024);
-  size_t              linen = 1024;
-  t8_topidx_t         cit;
+  t8_cmesh_reader_file_t file;
+  t8_cmesh_triangle_parser_t parser;
+  long                cit;
   long                corner;
   t8_topidx_t         corner_offset = 0;
-  double              x, y, z;
-#if 0                           /* used for currently disabeld code */
-  int                 i, bdy_marker;
-#endif
-  int                 num_attributes;
-  int                 nbdy_marker;
-  int                 retval;
-  int                 temp;
-  int                 num_read;
+  long                temp, num_attributes, nbdy_marker;
+  int                 icoord;
 
   T8_ASSERT (filename != NULL);
   T8_ASSERT (dim == 2 || dim == 3);
-  fp = fopen (filename, "r");
-  if (fp == NULL) {
+  *vertices = NULL;
+  if (t8_cmesh_reader_file_map (filename, &file)) {
     t8_global_errorf ("Failed to open %s.\n", filename);
-    goto die_node;
+    return -1;
   }
+  parser.pos = file.data;
+  parser.end = file.data + file.size;
 
   /* read first non-comment line from .node file */
-  retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-  if (retval < 0) {
+  if (t8_cmesh_triangle_parser_next_line (&parser)) {
     t8_global_errorf ("Failed to read first line from %s.\n", filename);
     goto die_node;
   }
 
   /* read number of corners, dimension (must be 2), number of attributes
    * and number of boundary markers (0 or 1) */
-  retval = sscanf (line, "%li %i %i %i", num_corners, &temp,
-                   &num_attributes, &nbdy_marker);
-  if (retval != 4) {
+  if (t8_cmesh_triangle_parse_long (&parser, num_corners)
+      || t8_cmesh_triangle_parse_long (&parser, &temp)
+      || t8_cmesh_triangle_parse_long (&parser, &num_attributes)
+      || t8_cmesh_triangle_parse_long (&parser, &nbdy_marker)) {
     t8_global_errorf ("Premature end of line.\n");
     goto die_node;
   }
+  t8_cmesh_triangle_parser_skip_line (&parser);
   if (temp != dim) {
     t8_global_errorf ("Dimension must equal %i.\n", dim);
     goto die_node;
@@ -123,56 +237,39 @@ t8_cmesh_triangle_read_nodes (t8_cmesh_t cmesh, char *filename,
   *vertices = T8_ALLOC (double, dim * *num_corners);
   /* read all vertex coordinates */
   for (cit = 0; cit < *num_corners; cit++) {
-    retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-    if (retval < 0) {
+    if (t8_cmesh_triangle_parser_next_line (&parser)) {
       t8_global_errorf ("Failed to read line from %s.\n", filename);
       goto die_node;
     }
     /* read corner number and coordinates */
-    retval = sscanf (line, "%li %lf %lf%n", &corner, &x, &y, &num_read);
-    if (dim == 3) {
-      retval += sscanf (line + num_read, "%lf", &z);
-    }
-    if (retval != dim + 1) {
+    if (t8_cmesh_triangle_parse_long (&parser, &corner)) {
       t8_global_errorf ("Premature end of line in %s.\n", filename);
+      goto die_node;
+    }
+    for (icoord = 0; icoord < dim; icoord++) {
+      if (t8_cmesh_triangle_parse_double (&parser,
+                                          *vertices + dim * cit + icoord)) {
+        t8_global_errorf ("Premature end of line in %s.\n", filename);
+        goto die_node;
+      }
     }
+    /* The attributes and the boundary marker are currently not needed */
+    t8_cmesh_triangle_parser_skip_line (&parser);
     /* The corners in a triangle file are indexed starting with zero or one.
      * The corners in the cmesh always start with zero */
     if (cit == 0) {
       T8_ASSERT (corner == 0 || corner == 1);
       corner_offset = corner;
     }
-    (*vertices)[dim * cit] = x;
-    (*vertices)[dim * cit + 1] = y;
-    if (dim == 3) {
-      (*vertices)[dim * cit + 2] = z;
-    }
-
-#if 0                           /* read attributes and boundary marker. This part is currently not needed */
-    /* read attributes but do not save them */
-    for (i = 0; i < num_attributes; i++) {
-      retval = sscanf (line, "%*f ");
-      if (retval != 0) {
-        t8_global_errorf ("Premature end of line in %s.\n", filename);
-      }
-    }
-    retval = sscanf (&line, "%i", &bdy_marker);
-    if (retval != 1) {
-      t8_global_errorf ("Premature end of line in %s.\n", filename);
-    }
-#endif /* if 0 */
   }
-  fclose (fp);
   /* Done reading .node file */
-  free (line);
+  t8_cmesh_reader_file_unmap (&file);
   return corner_offset;
 die_node:
   /* Clean up on error. */
-  /* Close open file */
-  if (fp != NULL) {
-    fclose (fp);
-  }
-  free (line);
+  t8_cmesh_reader_file_unmap (&file);
+  T8_FREE (*vertices);
+  *vertices = NULL;
   return -1;
 }
 
@@ -186,68 +283,75 @@ die_node:
  */
 static int
 t8_cmesh_triangle_read_eles (t8_cmesh_t cmesh, int corner_offset,
-                             char *filename, double *vertices, int dim
+                             char *filename, double *vertices,
+                             long **tree_corners, int dim
 #ifdef T8_ENABLE_DEBUG
                              , long num_vertices
 #endif
   )
 {
-  FILE               *fp;
-  char               *line = (char *) malloc (1024);
-  size_t              linen = 1024;
+  t8_cmesh_reader_file_t file;
+  t8_cmesh_triangle_parser_t parser;
   t8_locidx_t         num_elems, tit;
   t8_locidx_t         triangle, triangle_offset = 0;
   long                temp_triangle;
   long                tcorners[4];      /* in 2d only the first 3 values are needed */
-  int                 retval;
-  int                 temp;
+  long                temp;
   int                 i;
-  int                 num_read;
   double              tree_vertices[12];
 
   /* Open .ele file and read element input */
   T8_ASSERT (filename != NULL);
   T8_ASSERT (dim == 2 || dim == 3);
-  fp = fopen (filename, "r");
-  if (fp == NULL) {
+  *tree_corners = NULL;
+  if (t8_cmesh_reader_file_map (filename, &file)) {
     t8_global_errorf ("Failed to open %s.\n", filename);
-    goto die_ele;
+    T8_FREE (vertices);
+    return -1;
   }
+  parser.pos = file.data;
+  parser.end = file.data + file.size;
   /* read first non-comment line from .ele file */
-  retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-  if (retval < 0) {
+  if (t8_cmesh_triangle_parser_next_line (&parser)) {
     t8_global_errorf ("Failed to read first line from %s.\n", filename);
     goto die_ele;
   }
 
   /* get number of triangles and points per triangle */
-  retval = sscanf (line, "%i %i", &num_elems, &temp);
-  if (retval != 2) {
+  if (t8_cmesh_triangle_parse_long (&parser, &temp_triangle)
+      || t8_cmesh_triangle_parse_long (&parser, &temp)) {
     t8_global_errorf ("Premature end of line in %s.\n", filename);
+    goto die_ele;
   }
+  t8_cmesh_triangle_parser_skip_line (&parser);
+  num_elems = temp_triangle;
   T8_ASSERT (temp >= 3);
   /* This step is actually only necessary if the cmesh will be bcasted and
    * partitioned. Then we use the num_elems variable to compute the partition table
    * on the remote processes */
   cmesh->num_trees = num_elems;
+  /* We store the corners of each tree to find the neighbors if there
+   * is no .neigh file */
+  *tree_corners = T8_ALLOC (long, SC_MAX (num_elems, 1) * (dim + 1));
   /* For each triangle read the corner indices */
   for (tit = 0; tit < num_elems; tit++) {
-    retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-    if (retval < 0) {
+    if (t8_cmesh_triangle_parser_next_line (&parser)) {
       t8_global_errorf ("Failed to read line from %s.\n", filename);
       goto die_ele;
     }
-    retval = sscanf (line, "%li %li %li %li%n", &temp_triangle, tcorners,
-                     tcorners + 1, tcorners + 2, &num_read);
-    triangle = temp_triangle;
-    if (dim == 3) {
-      /* TODO: this is kind of unelegant, can we do it better? */
-      retval += sscanf (line + num_read, "%li", tcorners + 3);
-    }
-    if (retval != dim + 2) {
+    if (t8_cmesh_triangle_parse_long (&parser, &temp_triangle)) {
       t8_global_errorf ("Premature end of line in %s.\n", filename);
       goto die_ele;
     }
+    for (i = 0; i < dim + 1; i++) {
+      if (t8_cmesh_triangle_parse_long (&parser, tcorners + i)) {
+        t8_global_errorf ("Premature end of line in %s.\n", filename);
+        goto die_ele;
+      }
+    }
+    /* Skip further nodes of higher order elements and attributes */
+    t8_cmesh_triangle_parser_skip_line (&parser);
+    triangle = temp_triangle;
     /* The triangles in a triangle file are indexed starting with zero or one.
      * The triangles in the cmesh always start with zero */
     if (tit == 0) {
@@ -291,24 +395,27 @@ t8_cmesh_triangle_read_eles (t8_cmesh_t cmesh, int corner_offset,
       }
       T8_ASSERT (!t8_cmesh_tree_vertices_negative_volume
                  (T8_ECLASS_TET, tree_vertices, dim + 1));
+      temp_triangle = tcorners[0];
+      tcorners[0] = tcorners[1];
+      tcorners[1] = temp_triangle;
+    }
+    for (i = 0; i < dim + 1; i++) {
+      (*tree_corners)[(dim + 1) * tit + i] = tcorners[i];
     }
     t8_cmesh_set_tree_vertices (cmesh, triangle - triangle_offset,
                                 t8_get_package_id (), 0,
                                 tree_vertices, dim + 1);
   }
-  fclose (fp);
+  t8_cmesh_reader_file_unmap (&file);
   T8_FREE (vertices);
-  free (line);
   /* Done reading .ele file */
   return triangle_offset;
 die_ele:
   /* Clean up on error. */
-  /* Close open file */
-  if (fp != NULL) {
-    fclose (fp);
-  }
+  t8_cmesh_reader_file_unmap (&file);
   T8_FREE (vertices);
-  free (line);
+  T8_FREE (*tree_corners);
+  *tree_corners = NULL;
   return -1;
 }
 
@@ -319,15 +426,12 @@ static int
 t8_cmesh_triangle_read_neigh (t8_cmesh_t cmesh, int element_offset,
                               char *filename, int dim)
 {
-  FILE               *fp;
-  char               *line = (char *) malloc (1024);
-  size_t              linen = 1024;
+  t8_cmesh_reader_file_t file;
+  t8_cmesh_triangle_parser_t parser;
   t8_locidx_t         element, num_elems, tit;
-  t8_locidx_t        *tneighbors;
-  int                 retval;
-  int                 temp;
+  t8_locidx_t        *tneighbors = NULL;
+  long                value, temp;
   int                 orientation = 0, face1, face2;
-  int                 num_read;
   const int           num_faces = dim + 1;
   double             *el_vertices1, *el_vertices2;
   int                 ivertex, firstvertex;
@@ -335,22 +439,24 @@ t8_cmesh_triangle_read_neigh (t8_cmesh_t cmesh, int element_offset,
   /* Open .neigh file and read face neighbor information */
   T8_ASSERT (filename != NULL);
   T8_ASSERT (dim == 2 || dim == 3);
-  fp = fopen (filename, "r");
-  if (fp == NULL) {
+  if (t8_cmesh_reader_file_map (filename, &file)) {
     t8_global_errorf ("Failed to open %s.\n", filename);
-    goto die_neigh;
+    return -1;
   }
-  /* read first non-comment line from .ele file */
-  retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-  if (retval < 0) {
+  parser.pos = file.data;
+  parser.end = file.data + file.size;
+  /* read first non-comment line from .neigh file */
+  if (t8_cmesh_triangle_parser_next_line (&parser)) {
     t8_global_errorf ("Failed to read first line from %s.\n", filename);
     goto die_neigh;
   }
-  retval = sscanf (line, "%i %i", &num_elems, &temp);
-  if (retval != 2) {
+  if (t8_cmesh_triangle_parse_long (&parser, &value)
+      || t8_cmesh_triangle_parse_long (&parser, &temp)) {
     t8_global_errorf ("Premature end of line in   %s.\n", filename);
     goto die_neigh;
   }
+  t8_cmesh_triangle_parser_skip_line (&parser);
+  num_elems = value;
   T8_ASSERT (temp == dim + 1);
 
   tneighbors = T8_ALLOC (t8_locidx_t, num_elems * num_faces);
@@ -360,28 +466,28 @@ t8_cmesh_triangle_read_neigh (t8_cmesh_t cmesh, int element_offset,
    * which triangle ist is connected, we still need to find
    * out with which face of this triangle it is connected. */
   for (tit = 0; tit < num_elems; tit++) {
-    retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-    if (retval < 0) {
+    if (t8_cmesh_triangle_parser_next_line (&parser)) {
       t8_global_errorf ("Failed to read line from %s.\n", filename);
       goto die_neigh;
     }
-    retval =
-      sscanf (line, "%i %i %i %i%n", &element, tneighbors + num_faces * tit,
-              tneighbors + num_faces * tit + 1,
-              tneighbors + num_faces * tit + 2, &num_read);
-    if (dim == 3) {
-      retval +=
-        sscanf (line + num_read, "%i", tneighbors + num_faces * tit + 3);
-    }
-    if (retval != dim + 2) {
+    if (t8_cmesh_triangle_parse_long (&parser, &value)) {
       t8_global_errorf ("Premature end of line in %s.\n", filename);
       goto die_neigh;
     }
+    element = value;
+    for (face1 = 0; face1 < num_faces; face1++) {
+      if (t8_cmesh_triangle_parse_long (&parser, &value)) {
+        t8_global_errorf ("Premature end of line in %s.\n", filename);
+        goto die_neigh;
+      }
+      tneighbors[num_faces * tit + face1] = value;
+    }
+    t8_cmesh_triangle_parser_skip_line (&parser);
     T8_ASSERT (element - element_offset == tit);
 
   }
   /* We are done reading the file. */
-  fclose (fp);
+  t8_cmesh_reader_file_unmap (&file);
 
   /* To compute the face neighbor orientations it is necessary to look up the
    * vertices of a given tree_id. This is only possible if the attribute array
@@ -448,19 +554,189 @@ t8_cmesh_triangle_read_neigh (t8_cmesh_t cmesh, int element_offset,
     }
   }
   T8_FREE (tneighbors);
-  free (line);
   return 0;
 die_neigh:
   /* Clean up on error. */
-  /* Close open file */
+  t8_cmesh_reader_file_unmap (&file);
+  T8_FREE (tneighbors);
+  return -1;
+}
+
+/* Find the face connections of the trees. If a .neigh file exists,
+ * it is read. Otherwise the connections are computed from the corners
+ * of the trees.
+ * On success 0 is returned.
+ * On failure -1 is returned. */
+static int
+t8_cmesh_triangle_find_neighbors (t8_cmesh_t cmesh, int element_offset,
+                                  const char *fileprefix, long *tree_corners,
+                                  int dim)
+{
+  char                current_file[BUFSIZ];
+  FILE               *fp;
+  t8_eclass_t        *eclasses;
+  t8_locidx_t         itree;
+  int                 retval;
+
+  snprintf (current_file, BUFSIZ, "%s.neigh", fileprefix);
+  fp = fopen (current_file, "r");
   if (fp != NULL) {
     fclose (fp);
+    return t8_cmesh_triangle_read_neigh (cmesh, element_offset, current_file,
+                                         dim);
   }
-  free (line);
+  t8_debugf ("No file %s, computing the neighbors from the corners.\n",
+             current_file);
+  eclasses = T8_ALLOC (t8_eclass_t, SC_MAX (cmesh->num_trees, 1));
+  for (itree = 0; itree < cmesh->num_trees; itree++) {
+    eclasses[itree] = dim == 2 ? T8_ECLASS_TRIANGLE : T8_ECLASS_TET;
+  }
+  retval = t8_cmesh_face_matching_set_joins (cmesh, cmesh->num_trees, 0,
+                                             eclasses, tree_corners, dim + 1,
+                                             0, 1);
+  T8_FREE (eclasses);
+  return retval < 0 ? -1 : 0;
+}
+
+/* Read the part of this process of the data lines of a .node or a .ele file.
+ * The file is mapped into memory and parsed with the bulk parser.
+ * The lines after the first non-comment line are split evenly by bytes
+ * among the processes. A line belongs to the process whose part contains
+ * its first byte.
+ * If nodes is not NULL the file is a .node file and its nodes are pushed
+ * to nodes. Otherwise the file is a .ele file and its trees are pushed
+ * to trees. Further corners and attributes of a line are ignored.
+ * On success 0 is returned, on failure -1. */
+static int
+t8_cmesh_triangle_read_part (const char *filename, int dim, int mpirank,
+                             int mpisize, sc_array_t * nodes,
+                             sc_array_t * trees)
+{
+  t8_cmesh_reader_file_t file;
+  t8_cmesh_triangle_parser_t parser;
+  size_t              begin, length, my_begin, my_end;
+  long                index;
+  int                 icorner, icoord;
+  t8_cmesh_reader_node_t *node;
+  t8_cmesh_reader_tree_t *tree;
+
+  T8_ASSERT (filename != NULL);
+  T8_ASSERT (dim == 2 || dim == 3);
+  T8_ASSERT ((nodes == NULL) != (trees == NULL));
+  if (t8_cmesh_reader_file_map (filename, &file)) {
+    t8_errorf ("Failed to open %s.\n", filename);
+    return -1;
+  }
+  parser.pos = file.data;
+  parser.end = file.data + file.size;
+  /* skip the header line */
+  if (t8_cmesh_triangle_parser_next_line (&parser)) {
+    t8_errorf ("Failed to read first line from %s.\n", filename);
+    goto die_part;
+  }
+  t8_cmesh_triangle_parser_skip_line (&parser);
+  begin = parser.pos - file.data;
+  length = file.size - begin;
+  my_begin = begin + length / mpisize * mpirank
+    + SC_MIN ((size_t) mpirank, length % mpisize);
+  my_end = begin + length / mpisize * (mpirank + 1)
+    + SC_MIN ((size_t) mpirank + 1, length % mpisize);
+  parser.pos = file.data + my_begin;
+  if (my_begin > begin) {
+    /* Skip the rest of the line that contains the byte before our part.
+     * This line belongs to the previous process. */
+    parser.pos--;
+    t8_cmesh_triangle_parser_skip_line (&parser);
+  }
+
+  while (parser.pos < file.data + my_end) {
+    if (t8_cmesh_triangle_parser_skip_blanks (&parser)) {
+      /* The line is blank or a comment */
+      t8_cmesh_triangle_parser_skip_line (&parser);
+      continue;
+    }
+    if (nodes != NULL) {
+      node = (t8_cmesh_reader_node_t *) sc_array_push (nodes);
+      node->coordinates[2] = 0;
+      if (t8_cmesh_triangle_parse_long (&parser, &node->index)
+          || node->index < 0) {
+        t8_errorf ("Premature end of line in %s.\n", filename);
+        goto die_part;
+      }
+      for (icoord = 0; icoord < dim; icoord++) {
+        if (t8_cmesh_triangle_parse_double (&parser,
+                                            node->coordinates + icoord)) {
+          t8_errorf ("Premature end of line in %s.\n", filename);
+          goto die_part;
+        }
+      }
+    }
+    else {
+      tree = (t8_cmesh_reader_tree_t *) sc_array_push (trees);
+      if (t8_cmesh_triangle_parse_long (&parser, &index)) {
+        t8_errorf ("Premature end of line in %s.\n", filename);
+        goto die_part;
+      }
+      for (icorner = 0; icorner <= dim; icorner++) {
+        if (t8_cmesh_triangle_parse_long (&parser,
+                                          tree->vertices + icorner)) {
+          t8_errorf ("Premature end of line in %s.\n", filename);
+          goto die_part;
+        }
+      }
+      tree->eclass = dim == 2 ? T8_ECLASS_TRIANGLE : T8_ECLASS_TET;
+    }
+    /* The attributes and the boundary markers are not needed */
+    t8_cmesh_triangle_parser_skip_line (&parser);
+  }
+  t8_cmesh_reader_file_unmap (&file);
+  return 0;
+die_part:
+  t8_cmesh_reader_file_unmap (&file);
   return -1;
 }
 
-/* TODO: remove do_dup argument */
+/* Read a TRIANGLE or TETGEN mesh in parallel and build a partitioned cmesh.
+ * Each process reads a part of the .node and the .ele file. The neighbors
+ * are computed from the tree vertices and the .neigh file is not read.
+ * If do_dup is true, the messages are sent on a duplicate of comm.
+ * The trees keep the numbering of the file, callers that want compact
+ * partitions reorder the cmesh afterwards.
+ * On failure NULL is returned on all processes. */
+static              t8_cmesh_t
+t8_cmesh_triangle_read_parallel (const char *fileprefix, sc_MPI_Comm comm,
+                                 int do_dup, int dim)
+{
+  int                 mpirank, mpisize, mpiret, ok;
+  char                current_file[BUFSIZ];
+  sc_array_t          nodes, trees;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_array_init (&nodes, sizeof (t8_cmesh_reader_node_t));
+  sc_array_init (&trees, sizeof (t8_cmesh_reader_tree_t));
+  snprintf (current_file, BUFSIZ, "%s.node", fileprefix);
+  ok = !t8_cmesh_triangle_read_part (current_file, dim, mpirank, mpisize,
+                                     &nodes, NULL);
+  if (ok) {
+    snprintf (current_file, BUFSIZ, "%s.ele", fileprefix);
+    ok = !t8_cmesh_triangle_read_part (current_file, dim, mpirank, mpisize,
+                                       NULL, &trees);
+  }
+  if (!t8_cmesh_reader_all_ok (ok, comm)) {
+    t8_global_errorf ("Error while parsing the files %s.*\n", fileprefix);
+    sc_array_reset (&nodes);
+    sc_array_reset (&trees);
+    return NULL;
+  }
+  return t8_cmesh_reader_build (&nodes, &trees, dim, comm, do_dup);
+}
+
+/* The cmesh does not store a communicator, so do_dup is only used for the
+ * messages of the partitioned reader */
 static              t8_cmesh_t
 t8_cmesh_from_tetgen_or_triangle_file (char *fileprefix, int partition,
                                        sc_MPI_Comm comm, int do_dup, int dim)
@@ -468,7 +744,7 @@ t8_cmesh_from_tetgen_or_triangle_file (char *fileprefix, int partition,
   int                 mpirank, mpisize, mpiret;
   t8_cmesh_t          cmesh;
   double             *vertices;
-  long                num_vertices;
+  long                num_vertices, *tree_corners;
   t8_gloidx_t         first_tree, last_tree;
 
   mpiret = sc_MPI_Comm_size (comm, &mpisize);
@@ -476,6 +752,11 @@ t8_cmesh_from_tetgen_or_triangle_file (char *fileprefix, int partition,
   mpiret = sc_MPI_Comm_rank (comm, &mpirank);
   SC_CHECK_MPI (mpiret);
 
+  if (partition) {
+    /* Each process reads only a part of the files */
+    return t8_cmesh_triangle_read_parallel (fileprefix, comm, do_dup, dim);
+  }
+
   cmesh = NULL;
 #if 0
   /* TODO: Use cmesh_bcast when scanning replicated mesh.
@@ -502,7 +783,7 @@ t8_cmesh_from_tetgen_or_triangle_file (char *fileprefix, int partition,
       snprintf (current_file, BUFSIZ, "%s.ele", fileprefix);
       retval =
         t8_cmesh_triangle_read_eles (cmesh, corner_offset, current_file,
-                                     vertices, dim
+                                     vertices, &tree_corners, dim
 #ifdef T8_ENABLE_DEBUG
                                      , num_vertices
 #endif
@@ -513,11 +794,13 @@ t8_cmesh_from_tetgen_or_triangle_file (char *fileprefix, int partition,
       }
       else {
         /* read .neigh file */
-        snprintf (current_file, BUFSIZ, "%s.neigh", fileprefix);
-        retval = t8_cmesh_triangle_read_neigh (cmesh, corner_offset,
-                                               current_file, dim);
+        retval = t8_cmesh_triangle_find_neighbors (cmesh, corner_offset,
+                                                   fileprefix, tree_corners,
+                                                   dim);
+        T8_FREE (tree_corners);
         if (retval != 0) {
-          t8_global_errorf ("Error while parsing file %s.\n", current_file);
+          t8_global_errorf ("Error while finding the neighbors of %s.\n",
+                            fileprefix);
           t8_cmesh_unref (&cmesh);
         }
       }
@@ -565,7 +848,7 @@ t8_cmesh_from_tetgen_or_triangle_file_time (char *fileprefix,
   int                 mpirank, mpisize, mpiret;
   t8_cmesh_t          cmesh;
   double             *vertices;
-  long                num_vertices;
+  long                num_vertices, *tree_corners;
   t8_gloidx_t         first_tree, last_tree;
 
   mpiret = sc_MPI_Comm_size (comm, &mpisize);
@@ -573,6 +856,16 @@ t8_cmesh_from_tetgen_or_triangle_file_time (char *fileprefix,
   mpiret = sc_MPI_Comm_rank (comm, &mpirank);
   SC_CHECK_MPI (mpiret);
 
+  if (partition) {
+    /* Each process reads only a part of the files */
+    sc_flops_snap (fi, snapshot);
+    cmesh = t8_cmesh_triangle_read_parallel (fileprefix, comm, do_dup, dim);
+    sc_flops_shot (fi, snapshot);
+    sc_stats_set1 (&stats[statindex], snapshot->iwtime,
+                   "Partitioned read and commit");
+    return cmesh;
+  }
+
   cmesh = NULL;
   if (mpirank == 0 || partition) {
     int                 retval, corner_offset;
@@ -594,7 +887,7 @@ t8_cmesh_from_tetgen_or_triangle_file_time (char *fileprefix,
       snprintf (current_file, BUFSIZ, "%s.ele", fileprefix);
       retval =
         t8_cmesh_triangle_read_eles (cmesh, corner_offset, current_file,
-                                     vertices, dim
+                                     vertices, &tree_corners, dim
 #ifdef T8_ENABLE_DEBUG
                                      , num_vertices
 #endif
@@ -605,11 +898,13 @@ t8_cmesh_from_tetgen_or_triangle_file_time (char *fileprefix,
       }
       else {
         /* read .neigh file */
-        snprintf (current_file, BUFSIZ, "%s.neigh", fileprefix);
-        retval = t8_cmesh_triangle_read_neigh (cmesh, corner_offset,
-                                               current_file, dim);
+        retval = t8_cmesh_triangle_find_neighbors (cmesh, corner_offset,
+                                                   fileprefix, tree_corners,
+                                                   dim);
+        T8_FREE (tree_corners);
         if (retval != 0) {
-          t8_global_errorf ("Error while parsing file %s.\n", current_file);
+          t8_global_errorf ("Error while finding the neighbors of %s.\n",
+                            fileprefix);
           t8_cmesh_unref (&cmesh);
         }
       }
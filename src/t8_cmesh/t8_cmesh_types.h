@@ -25,6 +25,7 @@
 
 #include <t8.h>
 #include <t8_refcount.h>
+#include <t8_counters.h>
 #include <t8_data/t8_shmem.h>
 #include "t8_cmesh_stash.h"
 #include "t8_element.h"
@@ -33,6 +34,10 @@
  * We define here the datatypes needed for internal cmesh routines.
  */
 
+/** The number of owned local trees between two entries of the
+ * tree_class_prefix array of a cmesh. */
+#define T8_CMESH_CLASS_PREFIX_BLOCK 64
+
 typedef struct t8_part_tree *t8_part_tree_t;
 typedef struct t8_cmesh_trees *t8_cmesh_trees_t;
 typedef struct t8_cprofile t8_cprofile_t;       /* Defined below */
@@ -97,6 +102,18 @@ typedef struct t8_cmesh
                                            refinement patter. See \ref t8_cmesh_set_refine. */
   int8_t              set_partition_level; /**< Non-negative if the cmesh should be partition from an already existing cmesh
                                          with an assumes \a level uniform mesh underneath.  TODO: fix sentence */
+  int                 set_partition_use_costs; /**< If nonzero, \a set_partition_costs is used for uniform partitions.
+                                                  \ref t8_cmesh_set_partition_eclass_costs */
+  double              set_partition_costs[T8_ECLASS_COUNT]; /**< The cost of an element of each element class
+                                                              in a uniform partition. */
+  int                 set_shared_trees; /**< If nonzero and the cmesh is replicated, the trees are stored
+                                             once per node in shared memory. \ref t8_cmesh_set_shared_trees */
+  int                 set_validate_geometry; /**< If nonzero, commit checks the geometry of the trees.
+                                                  \ref t8_cmesh_set_validate_geometry */
+  int8_t              set_partition_ghost_attributes; /**< If nonzero, the ghosts sent in a partition
+                                                          carry the attributes of their trees. -1 until
+                                                          commit, where it is inherited from \a set_from.
+                                                          \ref t8_cmesh_set_partition_ghost_attributes */
 #if 0
   t8_cmesh_from_t     from_method;      /* TODO: Document */
 #endif
@@ -138,11 +155,34 @@ typedef struct t8_cmesh
   t8_locidx_t         inserted_ghosts; /**< Count the number of inserted ghosts to
                                            check at commit if it equals the total number. */
 #endif
+  t8_locidx_t        *tree_class_prefix; /**< If not NULL, for every \ref T8_CMESH_CLASS_PREFIX_BLOCK-th
+                                             owned local tree the number of owned local trees of each eclass
+                                             before it. Computed on demand by \ref t8_cmesh_uniform_bounds_costs. */
   t8_stash_t          stash; /**< Used as temporary storage for the trees before commit. */
   t8_cprofile_t      *profile; /**< Used to measure runtimes and statistics of the cmesh algorithms. */
+  sc_array_t         *ghost_fetched; /**< If not NULL, the ghost attributes fetched from the owners
+                                          of the ghosts, an array of \ref t8_cmesh_ghost_fetched_t.
+                                          \ref t8_cmesh_fetch_ghost_attribute */
 }
 t8_cmesh_struct_t;
 
+/** The values of one attribute for all ghosts of a cmesh that were fetched
+ * from the owners of the ghost trees, see \ref t8_cmesh_fetch_ghost_attribute.
+ * The attribute of the ghost with local ghost id i is stored at
+ * data + offsets[i] and has sizes[i] bytes. The offsets are padded with
+ * \ref T8_ADD_PADDING. If the owner does not have the attribute, sizes[i]
+ * is zero.
+ */
+typedef struct t8_cmesh_ghost_fetched
+{
+  int                 package_id; /**< The package id of the attribute. */
+  int                 key;        /**< The key of the attribute. */
+  size_t             *offsets;    /**< num_ghosts + 1 offsets into \a data. */
+  size_t             *sizes;      /**< The size of the attribute of each ghost. */
+  char               *data;       /**< The attribute values of all ghosts. */
+}
+t8_cmesh_ghost_fetched_t;
+
 /* TODO: cghost could be the same type as ctree.
  *       treeid for ghosts then negative?!
  *       1. typedef cghost ctree
@@ -226,6 +266,9 @@ typedef struct t8_attribute_info
 /* TODO: document, process is a bad naming, since it does not refer to MPI ranks here */
 typedef struct t8_cmesh_trees
 {
+  t8_refcount_t       rc;               /* The reference count of the trees. Several
+                                           cmeshes with the same trees, for example a
+                                           cmesh and its copy, share one structure. */
   sc_array_t         *from_proc;        /* array of t8_part_tree, one for each process */
   int                *tree_to_proc;     /* for each tree its process */
   int                *ghost_to_proc;    /* for each ghost its process */
@@ -233,6 +276,24 @@ typedef struct t8_cmesh_trees
                                                            global_id -> local_id for the ghost trees.
                                                            The local_id is the local ghost id starting at num_local_trees  */
   sc_mempool_t       *global_local_mempool;     /* Memory pool for the entries in the hash table */
+  t8_shmem_array_t    shared_part;      /* If not NULL, the memory of the only part that
+                                           is shared by all processes of a node */
+  struct t8_cmesh_reader_file *mapped_file;    /* If not NULL, the file whose contents
+                                                   store the memory of the only part */
+  /* The compact layout stores the data needed for neighbor lookups in separate
+   * arrays, so that a lookup does not need to find the part of a tree and
+   * does not load its offsets and attributes. It is built at commit. */
+  int                 compact_stride;   /* The number of faces stored per tree, the
+                                           maximum number of faces of the dimension */
+  t8_locidx_t         compact_num_trees;        /* The number of local trees in the compact
+                                                   layout, 0 if it was not built */
+  t8_locidx_t         compact_num_ghosts;       /* The number of ghosts in the compact layout */
+  int8_t             *compact_eclass;   /* The eclass of each local tree followed by
+                                           that of each ghost */
+  t8_locidx_t        *compact_neighbors;        /* compact_stride face neighbors of each
+                                                   local tree, -1 padded */
+  int8_t             *compact_ttf;      /* compact_stride tree to face values of each
+                                           local tree, -1 padded */
 }
 t8_cmesh_trees_struct_t;
 
@@ -274,10 +335,15 @@ typedef struct t8_cprofile
   int                 first_tree_shared; /**< 1 if this processes' first tree is shared. 0 if not. */
   double              partition_runtime;/**< The runtime of  the last call to \a t8_cmesh_partition. */
   double              commit_runtime;/**< The runtim of the last call to \a t8_cmesh_commit. */
+  int64_t             partition_counters[T8_COUNTER_COUNT];/**< The hardware counts of the last partition,
+                                                                \see t8_counters.h. */
+  int64_t             commit_counters[T8_COUNTER_COUNT];/**< The hardware counts of the last commit. */
 }
 t8_cprofile_struct_t;
 
 /** The number of entries in a cprofile struct */
 #define T8_CPROFILE_NUM_STATS 9
+/** The number of phases whose hardware counters a cprofile struct stores. */
+#define T8_CPROFILE_NUM_COUNTED 2
 
 #endif /* !T8_CMESH_TYPES_H */
@@ -0,0 +1,325 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_vec.h>
+#include <t8_threads.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#include <omp.h>
+#endif
+
+/* The number of trees whose corners are checked in one batch */
+#define T8_CMESH_VALIDATE_BATCH 64
+
+/* The maximal number of corners that are checked per tree */
+#define T8_CMESH_VALIDATE_MAX_CORNERS 8
+
+/* The number of doubles of the work buffer of a thread */
+#define T8_CMESH_VALIDATE_WORK_SIZE \
+  (17 * T8_CMESH_VALIDATE_MAX_CORNERS * T8_CMESH_VALIDATE_BATCH)
+
+/* The number of corners that are checked for each element class.
+ * Simplices have an affine map and are checked once. */
+static const int    t8_cmesh_validate_num_corners[T8_ECLASS_COUNT] = {
+  0, 1, 4, 1, 8, 1, 6, 4
+};
+
+/* For each element class and checked corner the vertices of the three edges
+ * whose vectors are the derivatives of the tree map along the reference
+ * directions at this corner, up to a positive factor. */
+static const int
+  t8_cmesh_validate_edges[T8_ECLASS_COUNT][T8_CMESH_VALIDATE_MAX_CORNERS][3]
+  [2] = {
+  /* vertex */
+  {{{0, 0}, {0, 0}, {0, 0}}},
+  /* line */
+  {{{0, 1}, {0, 0}, {0, 0}}},
+  /* quad */
+  {{{0, 1}, {0, 2}, {0, 0}}, {{0, 1}, {1, 3}, {0, 0}},
+   {{2, 3}, {0, 2}, {0, 0}}, {{2, 3}, {1, 3}, {0, 0}}},
+  /* triangle */
+  {{{0, 1}, {1, 2}, {0, 0}}},
+  /* hex */
+  {{{0, 1}, {0, 2}, {0, 4}}, {{0, 1}, {1, 3}, {1, 5}},
+   {{2, 3}, {0, 2}, {2, 6}}, {{2, 3}, {1, 3}, {3, 7}},
+   {{4, 5}, {4, 6}, {0, 4}}, {{4, 5}, {5, 7}, {1, 5}},
+   {{6, 7}, {4, 6}, {2, 6}}, {{6, 7}, {5, 7}, {3, 7}}},
+  /* tet */
+  {{{0, 1}, {2, 3}, {1, 2}}},
+  /* prism */
+  {{{0, 1}, {1, 2}, {0, 3}}, {{0, 1}, {1, 2}, {1, 4}},
+   {{0, 1}, {1, 2}, {2, 5}}, {{3, 4}, {4, 5}, {0, 3}},
+   {{3, 4}, {4, 5}, {1, 4}}, {{3, 4}, {4, 5}, {2, 5}}},
+  /* pyramid */
+  {{{0, 1}, {0, 2}, {0, 4}}, {{0, 1}, {1, 3}, {1, 4}},
+   {{2, 3}, {0, 2}, {2, 4}}, {{2, 3}, {1, 3}, {3, 4}}}
+};
+
+/* The counts of trees that one thread or process found */
+typedef struct
+{
+  t8_gloidx_t         counts[3];        /* checked, inverted and degenerate */
+  t8_gloidx_t         first[2];         /* first inverted and degenerate */
+  double              min_quality;
+} t8_cmesh_validate_result_t;
+
+/* Add a tree with a given minimal quality to a result */
+static void
+t8_cmesh_validate_result_add (t8_cmesh_validate_result_t * result,
+                              t8_gloidx_t gtree, double quality,
+                              double tolerance)
+{
+  int                 which = -1;
+
+  result->counts[0]++;
+  result->min_quality = SC_MIN (result->min_quality, quality);
+  if (quality < -tolerance) {
+    which = 0;
+  }
+  else if (quality <= tolerance) {
+    which = 1;
+  }
+  if (which >= 0) {
+    result->counts[1 + which]++;
+    result->first[which] = SC_MIN (result->first[which], gtree);
+  }
+}
+
+/* Check the trees first, ..., first + num_trees - 1 and add them to
+ * result. The corner edges are stored in batches of num_evals vectors,
+ * compare t8_cmesh_no_negative_volume. The work array has room for
+ * 17 T8_CMESH_VALIDATE_MAX_CORNERS * T8_CMESH_VALIDATE_BATCH doubles. */
+static void
+t8_cmesh_validate_batch (t8_cmesh_t cmesh, t8_locidx_t first,
+                         t8_locidx_t num_trees, double tolerance,
+                         double *work, t8_cmesh_validate_result_t * result)
+{
+  const size_t        max_evals =
+    T8_CMESH_VALIDATE_MAX_CORNERS * T8_CMESH_VALIDATE_BATCH;
+  double             *edges[3], *cross, *dets, *norms[4];
+  double             *vertices, vec[3], normal[3], normal_first[3];
+  double              quality, tree_quality, length;
+  t8_eclass_t         eclass;
+  t8_locidx_t         itree;
+  size_t              num_evals, ieval;
+  int                 icorner, iedge, i, dim;
+  const int          *edge;
+
+  T8_ASSERT (num_trees <= T8_CMESH_VALIDATE_BATCH);
+  /* Count the corners of this batch, such that the batches have
+   * consecutive coordinate arrays */
+  num_evals = 0;
+  for (itree = first; itree < first + num_trees; itree++) {
+    if (t8_cmesh_get_tree_vertices (cmesh, itree) != NULL) {
+      num_evals +=
+        t8_cmesh_validate_num_corners[t8_cmesh_get_tree_class
+                                      (cmesh, itree)];
+    }
+  }
+  if (num_evals == 0) {
+    return;
+  }
+  for (i = 0; i < 3; i++) {
+    edges[i] = work + 3 * i * max_evals;
+  }
+  cross = work + 9 * max_evals;
+  dets = work + 12 * max_evals;
+  for (i = 0; i < 4; i++) {
+    norms[i] = work + (13 + i) * max_evals;
+  }
+
+  /* Gather the edge vectors of all corners */
+  ieval = 0;
+  for (itree = first; itree < first + num_trees; itree++) {
+    vertices = t8_cmesh_get_tree_vertices (cmesh, itree);
+    if (vertices == NULL) {
+      continue;
+    }
+    eclass = t8_cmesh_get_tree_class (cmesh, itree);
+    for (icorner = 0; icorner < t8_cmesh_validate_num_corners[eclass];
+         icorner++, ieval++) {
+      for (iedge = 0; iedge < 3; iedge++) {
+        edge = t8_cmesh_validate_edges[eclass][icorner][iedge];
+        for (i = 0; i < 3; i++) {
+          vec[i] = vertices[3 * edge[1] + i] - vertices[3 * edge[0] + i];
+        }
+        t8_vec_batch_set (edges[iedge], num_evals, ieval, vec);
+      }
+    }
+  }
+  T8_ASSERT (ieval == num_evals);
+
+  /* The determinants, the normals and the edge lengths of all corners */
+  t8_vec_batch_cross (num_evals, edges[0], edges[1], cross);
+  t8_vec_batch_dot (num_evals, edges[2], cross, dets);
+  for (i = 0; i < 3; i++) {
+    t8_vec_batch_norm (num_evals, edges[i], norms[i]);
+  }
+  t8_vec_batch_norm (num_evals, cross, norms[3]);
+
+  /* Compute the minimal scaled Jacobian of each tree */
+  ieval = 0;
+  for (itree = first; itree < first + num_trees; itree++) {
+    if (t8_cmesh_get_tree_vertices (cmesh, itree) == NULL) {
+      continue;
+    }
+    eclass = t8_cmesh_get_tree_class (cmesh, itree);
+    dim = t8_eclass_to_dimension[eclass];
+    if (dim == 0) {
+      continue;
+    }
+    tree_quality = 1;
+    for (icorner = 0; icorner < t8_cmesh_validate_num_corners[eclass];
+         icorner++, ieval++) {
+      switch (dim) {
+      case 1:
+        quality = norms[0][ieval] > 0 ? 1 : 0;
+        break;
+      case 2:
+        length = norms[0][ieval] * norms[1][ieval];
+        quality = length > 0 ? norms[3][ieval] / length : 0;
+        t8_vec_batch_get (cross, num_evals, ieval, normal);
+        if (icorner == 0) {
+          t8_vec_axb (normal, normal_first, 1, 0);
+        }
+        else if (t8_vec_dot (normal, normal_first) < 0) {
+          /* The tree is folded */
+          quality = -quality;
+        }
+        break;
+      default:
+        length = norms[0][ieval] * norms[1][ieval] * norms[2][ieval];
+        quality = length > 0 ? dets[ieval] / length : 0;
+      }
+      tree_quality = SC_MIN (tree_quality, quality);
+    }
+    t8_cmesh_validate_result_add (result, t8_cmesh_get_first_treeid (cmesh)
+                                  + itree, tree_quality, tolerance);
+  }
+}
+
+void
+t8_cmesh_validate_geometry (t8_cmesh_t cmesh, double tolerance,
+                            sc_MPI_Comm comm,
+                            t8_cmesh_geometry_report_t * report)
+{
+  t8_gloidx_t         counts[3], first[2], global_counts[3], global_first[2];
+  double              min_quality;
+  double             *thread_work;
+  t8_locidx_t         first_tree, last_tree, num_batches;
+  int                 mpiret, mpisize, mpirank, num_threads;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (tolerance >= 0);
+  T8_ASSERT (report != NULL);
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* The local trees that this process checks */
+  if (cmesh->set_partition) {
+    /* A shared first tree is checked by the process that has it last */
+    first_tree = cmesh->first_tree_shared ? 1 : 0;
+    last_tree = cmesh->num_local_trees;
+  }
+  else {
+    /* Each process checks a part of the replicated trees */
+    first_tree = (t8_locidx_t) ((t8_gloidx_t) cmesh->num_local_trees
+                                * mpirank / mpisize);
+    last_tree = (t8_locidx_t) ((t8_gloidx_t) cmesh->num_local_trees
+                               * (mpirank + 1) / mpisize);
+  }
+  first_tree = SC_MIN (first_tree, last_tree);
+  num_batches = (last_tree - first_tree + T8_CMESH_VALIDATE_BATCH - 1)
+    / T8_CMESH_VALIDATE_BATCH;
+
+  counts[0] = counts[1] = counts[2] = 0;
+  first[0] = first[1] = cmesh->num_trees;
+  min_quality = 1;
+  /* Each thread gets its own part of the work buffer, which we allocate
+   * here since the allocator must not be called by several threads */
+  num_threads = t8_get_num_threads ();
+  thread_work = T8_ALLOC (double, (size_t) num_threads
+                          * T8_CMESH_VALIDATE_WORK_SIZE);
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp parallel num_threads (num_threads)
+#endif
+  {
+    t8_cmesh_validate_result_t result;
+    t8_locidx_t         ibatch, batch_first;
+    double             *work;
+
+    result.counts[0] = result.counts[1] = result.counts[2] = 0;
+    result.first[0] = result.first[1] = cmesh->num_trees;
+    result.min_quality = 1;
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+    T8_ASSERT (omp_get_thread_num () < num_threads);
+    work = thread_work + (size_t) omp_get_thread_num ()
+      * T8_CMESH_VALIDATE_WORK_SIZE;
+#else
+    work = thread_work;
+#endif
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp for schedule (dynamic, 16)
+#endif
+    for (ibatch = 0; ibatch < num_batches; ibatch++) {
+      batch_first = first_tree + ibatch * T8_CMESH_VALIDATE_BATCH;
+      t8_cmesh_validate_batch (cmesh, batch_first,
+                               SC_MIN (T8_CMESH_VALIDATE_BATCH,
+                                       last_tree - batch_first), tolerance,
+                               work, &result);
+    }
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp critical
+#endif
+    {
+      counts[0] += result.counts[0];
+      counts[1] += result.counts[1];
+      counts[2] += result.counts[2];
+      first[0] = SC_MIN (first[0], result.first[0]);
+      first[1] = SC_MIN (first[1], result.first[1]);
+      min_quality = SC_MIN (min_quality, result.min_quality);
+    }
+  }
+  T8_FREE (thread_work);
+
+  /* Sum up the counts and find the first bad trees of all processes */
+  mpiret = sc_MPI_Allreduce (counts, global_counts, 3, T8_MPI_GLOIDX,
+                             sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Allreduce (first, global_first, 2, T8_MPI_GLOIDX,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Allreduce (&min_quality, &report->min_quality, 1,
+                             sc_MPI_DOUBLE, sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  report->num_checked = global_counts[0];
+  report->num_inverted = global_counts[1];
+  report->num_degenerate = global_counts[2];
+  report->first_inverted =
+    global_first[0] < cmesh->num_trees ? global_first[0] : -1;
+  report->first_degenerate =
+    global_first[1] < cmesh->num_trees ? global_first[1] : -1;
+}
@@ -56,6 +56,46 @@ t8_cmesh_get_num_vertices (t8_cmesh_t cmesh, int count_ghosts)
   return num_vertices;
 }
 
+/* Return the element class of a local tree or ghost of a cmesh.
+ * The ghosts are numbered after the local trees. */
+static              t8_eclass_t
+t8_cmesh_vtk_tree_class (t8_cmesh_t cmesh, t8_locidx_t itree)
+{
+  t8_locidx_t         num_local_trees = t8_cmesh_get_num_local_trees (cmesh);
+
+  if (itree < num_local_trees) {
+    return t8_cmesh_get_tree_class (cmesh, itree);
+  }
+  return t8_cmesh_get_ghost_class (cmesh, itree - num_local_trees);
+}
+
+/* Write the header of a data array and prepare the buffer for its values.
+ * Returns 0 on success. */
+static int
+t8_cmesh_vtk_begin_array (FILE * vtufile, t8_vtk_buffer_t * buffer,
+                          const char *datatype, const char *dataname,
+                          const char *component_string)
+{
+  if (fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"%s\"%s"
+               " format=\"%s\">\n", datatype, dataname, component_string,
+               T8_VTK_FORMAT_STRING) <= 0) {
+    return -1;
+  }
+  t8_vtk_buffer_write_string (buffer, "         ");
+  return 0;
+}
+
+/* Write the buffered values of a data array and close the array.
+ * Returns 0 on success. */
+static int
+t8_cmesh_vtk_end_array (FILE * vtufile, t8_vtk_buffer_t * buffer)
+{
+  if (t8_vtk_buffer_flush (buffer, vtufile)) {
+    return -1;
+  }
+  return fprintf (vtufile, "        </DataArray>\n") <= 0;
+}
+
 /* TODO: implement for scale < 1 */
 static int
 t8_cmesh_vtk_write_file_ext (t8_cmesh_t cmesh, const char *fileprefix,
@@ -78,24 +118,19 @@ t8_cmesh_vtk_write_file_ext (t8_cmesh_t cmesh, const char *fileprefix,
   if (cmesh->mpirank == 0 || cmesh->set_partition) {
     char                vtufilename[BUFSIZ];
     FILE               *vtufile;
-    t8_topidx_t         num_vertices, ivertex;
-    t8_locidx_t         num_trees;
-    t8_ctree_t          tree;
-    double              x, y, z;
+    t8_vtk_buffer_t     buffer;
+    t8_topidx_t         num_vertices;
+    t8_locidx_t         itree, num_trees, num_loc_trees;
     double             *vertices, *vertex;
-    int                 k, sk;
-    long long           offset, count_vertices;
-    t8_locidx_t         ighost, num_ghosts, num_loc_trees;
-#ifdef T8_ENABLE_DEBUG
-    t8_cghost_t         ghost;
-#endif
+    int                 ivertex, k;
+    long long           offset;
     t8_eclass_t         eclass;
 
     num_vertices = t8_cmesh_get_num_vertices (cmesh, write_ghosts);
-    num_trees = t8_cmesh_get_num_local_trees (cmesh);
-    if (write_ghosts) {
-      num_trees += t8_cmesh_get_num_ghosts (cmesh);
-    }
+    num_loc_trees = t8_cmesh_get_num_local_trees (cmesh);
+    /* The ghosts are written after the local trees */
+    num_trees = num_loc_trees
+      + (write_ghosts ? t8_cmesh_get_num_ghosts (cmesh) : 0);
 
     snprintf (vtufilename, BUFSIZ, "%s_%04d.vtu", fileprefix, cmesh->mpirank);
     vtufile = fopen (vtufilename, "wb");
@@ -103,6 +138,7 @@ t8_cmesh_vtk_write_file_ext (t8_cmesh_t cmesh, const char *fileprefix,
       t8_global_errorf ("Could not open file %s for output.\n", vtufilename);
       return -1;
     }
+    t8_vtk_buffer_init (&buffer);
     fprintf (vtufile, "<?xml version=\"1.0\"?>\n");
     fprintf (vtufile, "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\"");
 #if defined T8_VTK_BINARY && defined T8_VTK_COMPRESSION
@@ -120,218 +156,143 @@ t8_cmesh_vtk_write_file_ext (t8_cmesh_t cmesh, const char *fileprefix,
     fprintf (vtufile, "      <Points>\n");
 
     /* write point position data */
-    fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"Position\""
-             " NumberOfComponents=\"3\" format=\"%s\">\n",
-             T8_VTK_FLOAT_NAME, T8_VTK_FORMAT_STRING);
-
-#ifdef T8_VTK_ASCII
-    for (tree = t8_cmesh_get_first_tree (cmesh); tree != NULL;
-         tree = t8_cmesh_get_next_tree (cmesh, tree)) {
-      vertices = ((double *) t8_cmesh_get_attribute (cmesh,
-                                                     t8_get_package_id (), 0,
-                                                     tree->treeid));
-      for (ivertex = 0; ivertex < t8_eclass_num_vertices[tree->eclass];
-           ivertex++) {
-        vertex = vertices +
-          3 * t8_eclass_vtk_corner_number[tree->eclass][ivertex];
-        x = vertex[0];
-        y = vertex[1];
-        z = vertex[2];
-#ifdef T8_VTK_DOUBLES
-        fprintf (vtufile, "     %24.16e %24.16e %24.16e\n", x, y, z);
-#else
-        fprintf (vtufile, "          %16.8e %16.8e %16.8e\n", x, y, z);
-#endif
-      }
-    }                           /* end tree loop */
-    if (write_ghosts) {
-
-      /* Write the vertices of the ghost trees */
-      num_ghosts = t8_cmesh_get_num_ghosts (cmesh);
-      num_loc_trees = t8_cmesh_get_num_local_trees (cmesh);
-      for (ighost = 0; ighost < num_ghosts; ighost++) {
-        /* Get the eclass of this ghost */
-        eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
-        /* Get a pointer to this ghosts vertices */
-        vertices = (double *) t8_cmesh_get_attribute (cmesh,
-                                                      t8_get_package_id (), 0,
-                                                      ighost + num_loc_trees);
-        T8_ASSERT (vertices != NULL);
-        /* TODO: This code is duplicated above */
-        for (ivertex = 0; ivertex < t8_eclass_num_vertices[eclass]; ivertex++) {
-          vertex = vertices +
-            3 * t8_eclass_vtk_corner_number[eclass][ivertex];
-          x = vertex[0];
-          y = vertex[1];
-          z = vertex[2];
+    if (t8_cmesh_vtk_begin_array (vtufile, &buffer, T8_VTK_FLOAT_NAME,
+                                  "Position", " NumberOfComponents=\"3\"")) {
+      goto t8_cmesh_vtk_failure;
+    }
+    for (itree = 0; itree < num_trees; itree++) {
+      eclass = t8_cmesh_vtk_tree_class (cmesh, itree);
+      /* The ghosts' vertices are stored with local ids after the trees */
+      vertices = (double *) t8_cmesh_get_attribute (cmesh,
+                                                    t8_get_package_id (), 0,
+                                                    itree);
+      T8_ASSERT (vertices != NULL);
+      for (ivertex = 0; ivertex < t8_eclass_num_vertices[eclass]; ivertex++) {
+        vertex = vertices + 3 * t8_eclass_vtk_corner_number[eclass][ivertex];
+        for (k = 0; k < 3; k++) {
 #ifdef T8_VTK_DOUBLES
-          fprintf (vtufile, "     %24.16e %24.16e %24.16e\n", x, y, z);
+          t8_vtk_buffer_write_float (&buffer, " %24.16e", vertex[k]);
 #else
-          fprintf (vtufile, "          %16.8e %16.8e %16.8e\n", x, y, z);
+          t8_vtk_buffer_write_float (&buffer, " %16.8e", vertex[k]);
 #endif
         }
-      }                         /* end ghost loop */
+        t8_vtk_buffer_write_string (&buffer, "\n         ");
+      }
+    }
+    if (t8_cmesh_vtk_end_array (vtufile, &buffer)) {
+      goto t8_cmesh_vtk_failure;
     }
-#else
-    SC_ABORT ("Binary vtk file not implemented\n");
-#endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
     fprintf (vtufile, "      </Points>\n");
     fprintf (vtufile, "      <Cells>\n");
 
     /* write connectivity data */
-    fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"connectivity\""
-             " format=\"%s\">\n", T8_VTK_TOPIDX, T8_VTK_FORMAT_STRING);
-#ifdef T8_VTK_ASCII
-    for (tree = t8_cmesh_get_first_tree (cmesh), count_vertices = 0;
-         tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree)) {
-      fprintf (vtufile, "         ");
-      for (k = 0; k < t8_eclass_num_vertices[tree->eclass]; ++k,
-           count_vertices++) {
-        fprintf (vtufile, " %lld", count_vertices);
-      }
-      fprintf (vtufile, "\n");
+    if (t8_cmesh_vtk_begin_array (vtufile, &buffer, T8_VTK_TOPIDX,
+                                  "connectivity", "")) {
+      goto t8_cmesh_vtk_failure;
     }
-    if (write_ghosts) {
-      /* Write the ghost connectivity */
-      for (ighost = 0; ighost < num_ghosts; ighost++) {
-        eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
-        fprintf (vtufile, "         ");
-        for (k = 0; k < t8_eclass_num_vertices[eclass]; ++k, count_vertices++) {
-          fprintf (vtufile, " %lld", count_vertices);
-        }
-        fprintf (vtufile, "\n");
+    for (itree = 0, offset = 0; itree < num_trees; itree++) {
+      eclass = t8_cmesh_vtk_tree_class (cmesh, itree);
+      for (ivertex = 0; ivertex < t8_eclass_num_vertices[eclass];
+           ivertex++, offset++) {
+        t8_vtk_buffer_write_int (&buffer, offset);
       }
+      t8_vtk_buffer_write_string (&buffer, "\n         ");
+    }
+    if (t8_cmesh_vtk_end_array (vtufile, &buffer)) {
+      goto t8_cmesh_vtk_failure;
     }
-#else
-    SC_ABORT ("Binary vtk file not implemented\n");
-#endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
 
     /* write offset data */
-    fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"offsets\""
-             " format=\"%s\">\n", T8_VTK_TOPIDX, T8_VTK_FORMAT_STRING);
-#ifdef T8_VTK_ASCII
-    fprintf (vtufile, "         ");
-    for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1, offset = 0;
-         tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
-      offset += t8_eclass_num_vertices[tree->eclass];
-      fprintf (vtufile, " %lld", offset);
-      if (!(sk % 8))
-        fprintf (vtufile, "\n         ");
+    if (t8_cmesh_vtk_begin_array (vtufile, &buffer, T8_VTK_TOPIDX,
+                                  "offsets", "")) {
+      goto t8_cmesh_vtk_failure;
     }
-    if (write_ghosts) {
-      /* ghost offset data */
-      for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
-        eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
-        offset += t8_eclass_num_vertices[eclass];
-        fprintf (vtufile, " %lld", offset);
-        if (!(sk % 8))
-          fprintf (vtufile, "\n         ");
+    for (itree = 0, offset = 0; itree < num_trees; itree++) {
+      offset += t8_eclass_num_vertices[t8_cmesh_vtk_tree_class (cmesh,
+                                                                itree)];
+      t8_vtk_buffer_write_int (&buffer, offset);
+      if (!((itree + 1) % 8)) {
+        t8_vtk_buffer_write_string (&buffer, "\n         ");
       }
     }
-    fprintf (vtufile, "\n");
-#else
-    SC_ABORT ("Binary vtk file not implemented\n");
-#endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
-    /* write type data */
-    fprintf (vtufile, "        <DataArray type=\"UInt8\" Name=\"types\""
-             " format=\"%s\">\n", T8_VTK_FORMAT_STRING);
-#ifdef T8_VTK_ASCII
-    fprintf (vtufile, "         ");
-    for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1; tree != NULL;
-         tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
-      fprintf (vtufile, " %d", t8_eclass_vtk_type[tree->eclass]);
-      if (!(sk % 20) && tree->treeid != (cmesh->num_local_trees - 1))
-        fprintf (vtufile, "\n         ");
+    if (t8_cmesh_vtk_end_array (vtufile, &buffer)) {
+      goto t8_cmesh_vtk_failure;
+    }
+
+    /* write type data, as Int32 like in the forest output */
+    if (t8_cmesh_vtk_begin_array (vtufile, &buffer, "Int32", "types", "")) {
+      goto t8_cmesh_vtk_failure;
     }
-    if (write_ghosts) {
-      /* ghost offset types */
-      for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
-        eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
-        fprintf (vtufile, " %d", t8_eclass_vtk_type[eclass]);
-        if (!(sk % 20) && ighost != (num_ghosts - 1))
-          fprintf (vtufile, "\n         ");
+    for (itree = 0; itree < num_trees; itree++) {
+      t8_vtk_buffer_write_int (&buffer,
+                               t8_eclass_vtk_type[t8_cmesh_vtk_tree_class
+                                                  (cmesh, itree)]);
+      if (!((itree + 1) % 20)) {
+        t8_vtk_buffer_write_string (&buffer, "\n         ");
       }
     }
-    fprintf (vtufile, "\n");
-#else
-    SC_ABORT ("Binary vtk file not implemented\n");
-#endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
+    if (t8_cmesh_vtk_end_array (vtufile, &buffer)) {
+      goto t8_cmesh_vtk_failure;
+    }
     fprintf (vtufile, "      </Cells>\n");
-    /* write treeif data */
+
+    /* write treeid data */
     fprintf (vtufile, "      <CellData Scalars=\"treeid,mpirank\">\n");
-    fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"treeid\""
-             " format=\"%s\">\n", T8_VTK_GLOIDX, T8_VTK_FORMAT_STRING);
-#ifdef T8_VTK_ASCII
-    fprintf (vtufile, "         ");
-    for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1, offset = 0;
-         tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
-      /* Since tree_id is actually 64 Bit but we store it as 32, we have to check
-       * that we do not get into conversion errors */
-      /* TODO: We switched to 32 Bit because Paraview could not handle 64 well enough.
-       */
-      T8_ASSERT (tree->treeid + cmesh->first_tree ==
-                 (t8_gloidx_t) ((long) tree->treeid + cmesh->first_tree));
-      fprintf (vtufile, " %ld", (long) tree->treeid + cmesh->first_tree);
-      if (!(sk % 8))
-        fprintf (vtufile, "\n         ");
+    if (t8_cmesh_vtk_begin_array (vtufile, &buffer, T8_VTK_GLOIDX,
+                                  "treeid", "")) {
+      goto t8_cmesh_vtk_failure;
     }
-    if (write_ghosts) {
-      /* ghost offset types */
-      for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
-#ifdef T8_ENABLE_DEBUG
-        ghost = t8_cmesh_trees_get_ghost (cmesh->trees, ighost);
-        /* Check for conversion errors */
-        T8_ASSERT (ghost->treeid == (t8_gloidx_t) ((long) ghost->treeid));
-#endif
-#if 0
-        fprintf (vtufile, " %ld", (long) ghost->treeid);
-#endif
-        /* Write -1 as tree_id so that we can distinguish ghosts from normal trees
-         * in the vtk file */
-        fprintf (vtufile, " %ld", (long) -1);
-        if (!(sk % 8))
-          fprintf (vtufile, "\n         ");
+    for (itree = 0; itree < num_trees; itree++) {
+      if (itree < num_loc_trees) {
+        /* Since tree_id is actually 64 Bit but we store it as 32, we have to
+         * check that we do not get into conversion errors */
+        /* TODO: We switched to 32 Bit because Paraview could not handle 64
+         * well enough. */
+        T8_ASSERT (itree + cmesh->first_tree ==
+                   (t8_gloidx_t) (int32_t) (itree + cmesh->first_tree));
+        t8_vtk_buffer_write_int (&buffer, itree + cmesh->first_tree);
+      }
+      else {
+        /* Write -1 as tree_id so that we can distinguish ghosts from normal
+         * trees in the vtk file */
+        t8_vtk_buffer_write_int (&buffer, -1);
+      }
+      if (!((itree + 1) % 8)) {
+        t8_vtk_buffer_write_string (&buffer, "\n         ");
       }
     }
-    fprintf (vtufile, "\n");
-#else
-    SC_ABORT ("Binary vtk file not implemented\n");
-#endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
+    if (t8_cmesh_vtk_end_array (vtufile, &buffer)) {
+      goto t8_cmesh_vtk_failure;
+    }
+
     /* write mpirank data */
-    fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"mpirank\""
-             " format=\"%s\">\n", "Int32", T8_VTK_FORMAT_STRING);
-#ifdef T8_VTK_ASCII
-    fprintf (vtufile, "         ");
-    for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1, offset = 0;
-         tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
-      fprintf (vtufile, " %i", cmesh->mpirank);
-      if (!(sk % 8))
-        fprintf (vtufile, "\n         ");
+    if (t8_cmesh_vtk_begin_array (vtufile, &buffer, "Int32", "mpirank", "")) {
+      goto t8_cmesh_vtk_failure;
     }
-    if (write_ghosts) {
-      /* write our rank for each ghost */
-      for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
-        fprintf (vtufile, " %i", cmesh->mpirank);
-        if (!(sk % 8))
-          fprintf (vtufile, "\n         ");
+    for (itree = 0; itree < num_trees; itree++) {
+      t8_vtk_buffer_write_int (&buffer, cmesh->mpirank);
+      if (!((itree + 1) % 8)) {
+        t8_vtk_buffer_write_string (&buffer, "\n         ");
       }
     }
-    fprintf (vtufile, "\n");
-#else
-    SC_ABORT ("Binary vtk file not implemented\n");
-#endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
+    if (t8_cmesh_vtk_end_array (vtufile, &buffer)) {
+      goto t8_cmesh_vtk_failure;
+    }
     fprintf (vtufile, "      </CellData>\n");
-    /* write type data */
     fprintf (vtufile, "    </Piece>\n");
     fprintf (vtufile, "  </UnstructuredGrid>\n");
     fprintf (vtufile, "</VTKFile>\n");
+    t8_vtk_buffer_reset (&buffer);
+    if (fclose (vtufile)) {
+      t8_global_errorf ("Error when closing file %s.\n", vtufilename);
+      return -1;
+    }
+    return 0;
+  t8_cmesh_vtk_failure:
+    t8_global_errorf ("Error when writing to file %s.\n", vtufilename);
+    t8_vtk_buffer_reset (&buffer);
     fclose (vtufile);
+    return -1;
   }
   return 0;
 }
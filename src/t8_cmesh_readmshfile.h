@@ -39,6 +39,14 @@ T8_EXTERN_C_BEGIN ();
 /* put declarations here */
 
 /** Read a .msh file and create a cmesh from it.
+ * ASCII files of version 2 and binary files of version 4.1 are supported.
+ * Files of other versions are rejected with an error.
+ * Binary files are memory-mapped if possible.
+ * Of the second order Lagrange trees and the third order lines and triangles
+ * in ASCII files all nodes are stored with
+ * \ref t8_geometry_set_tree_lagrange_nodes, such that
+ * \ref t8_geometry_new_lagrange maps the curved trees. Of the other higher
+ * order trees only the vertices are read.
  * \param [in]    fileprefix    The prefix of the mesh file.
  *                              The file fileprefix.msh is read.
  * \param [in]    partition     If true the file is only opened on one process
@@ -52,12 +60,32 @@ T8_EXTERN_C_BEGIN ();
  * \param [in]    master        If partition is true, a valid MPI rank that will
  *                              read the file and store all the trees alone.
  * \return        A committed cmesh holding the mesh of dimension \a dim in the
- *                specified .msh file.
+ *                specified .msh file, or NULL if the file could not be
+ *                opened or its version is not supported.
  */
 t8_cmesh_t
 t8_cmesh_from_msh_file (const char *fileprefix, int partition,
                         sc_MPI_Comm comm, int dim, int master);
 
+/** Read a .msh file in parallel and create a partitioned cmesh from it.
+ * Each process reads a part of the file. No process stores the whole mesh.
+ * The trees are numbered in the order of the file and each process gets
+ * the trees whose lines start in its part of the element section.
+ * For a binary file of version 4.1 each process reads an equal share of the
+ * nodes and of the elements.
+ * \param [in]    fileprefix    The prefix of the mesh file.
+ *                              The file fileprefix.msh is read by all processes.
+ * \param [in]    comm          The MPI communicator with which the cmesh is to be committed.
+ * \param [in]    dim           The dimension to read from the .msh files.
+ * \return        A committed and partitioned cmesh holding the mesh of
+ *                dimension \a dim in the specified .msh file, or NULL on
+ *                all processes if the file could not be read.
+ * \note This function is collective on \a comm.
+ */
+t8_cmesh_t
+t8_cmesh_from_msh_file_parallel (const char *fileprefix, sc_MPI_Comm comm,
+                                 int dim);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_CMESH_READMSHFILE_H */
@@ -45,8 +45,10 @@ T8_EXTERN_C_BEGIN ();
  * \param [in] fileprefix A string holding the prefix of the TRIANGLE files.
  *                        The files \a fileprefix.node, \a fileprefix.ele and
  *                        \a fileprefix.neigh are read.
- * \param [in] partition  In the future this flag can decide whether the returned
- *                        cmesh is partitioned or not. Currently it is always replicated.
+ * \param [in] partition  If true, each process reads only a part of the
+ *                        .node and .ele files and the returned cmesh is
+ *                        partitioned. The neighbors are then computed from
+ *                        the tree vertices and the .neigh file is not read.
  * \param [in] comm       The mpi communicator to be used.
  * \param [in] do_dup     Whether \a comm should be duplicated by cmesh.
  * \return                A ommited, replicated cmesh constructed from the info
@@ -0,0 +1,129 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_counters.h>
+#if defined (T8_ENABLE_PERF_COUNTERS) && defined (T8_HAVE_LINUX_PERF_EVENT_H)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define T8_COUNTERS_PERF 1
+#endif
+
+const char         *t8_counter_to_string[T8_COUNTER_COUNT] = {
+  "cycles", "instructions", "LLC misses", "branch misses"
+};
+
+#ifdef T8_COUNTERS_PERF
+/* The file descriptors of the counters, -1 if a counter is not available.
+ * They are opened on first use. */
+static int          t8_counters_fd[T8_COUNTER_COUNT];
+static int          t8_counters_opened = 0;
+
+static void
+t8_counters_open (void)
+{
+  const uint64_t      config[T8_COUNTER_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+  };
+  struct perf_event_attr attr;
+  int                 icounter;
+
+  for (icounter = 0; icounter < T8_COUNTER_COUNT; icounter++) {
+    memset (&attr, 0, sizeof (attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof (attr);
+    attr.config = config[icounter];
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    /* Count the calling thread on any cpu */
+    t8_counters_fd[icounter] =
+      (int) syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (t8_counters_fd[icounter] < 0) {
+      t8_debugf ("Could not open the counter of %s\n",
+                 t8_counter_to_string[icounter]);
+    }
+  }
+  t8_counters_opened = 1;
+}
+#endif
+
+/* Add the current count of each counter times sign to counts */
+static void
+t8_counters_add (int64_t counts[T8_COUNTER_COUNT], int sign)
+{
+#ifdef T8_COUNTERS_PERF
+  uint64_t            value;
+  int                 icounter;
+
+  if (!t8_counters_opened) {
+    t8_counters_open ();
+  }
+  for (icounter = 0; icounter < T8_COUNTER_COUNT; icounter++) {
+    if (t8_counters_fd[icounter] >= 0
+        && read (t8_counters_fd[icounter], &value, sizeof (value))
+        == sizeof (value)) {
+      counts[icounter] += sign * (int64_t) value;
+    }
+  }
+#else
+  (void) counts;
+  (void) sign;
+#endif
+}
+
+int
+t8_counters_available (void)
+{
+#ifdef T8_COUNTERS_PERF
+  int                 icounter;
+
+  if (!t8_counters_opened) {
+    t8_counters_open ();
+  }
+  for (icounter = 0; icounter < T8_COUNTER_COUNT; icounter++) {
+    if (t8_counters_fd[icounter] >= 0) {
+      return 1;
+    }
+  }
+#endif
+  return 0;
+}
+
+void
+t8_counters_start (int64_t counts[T8_COUNTER_COUNT])
+{
+  memset (counts, 0, T8_COUNTER_COUNT * sizeof (int64_t));
+  t8_counters_add (counts, -1);
+}
+
+void
+t8_counters_resume (int64_t counts[T8_COUNTER_COUNT])
+{
+  t8_counters_add (counts, -1);
+}
+
+void
+t8_counters_stop (int64_t counts[T8_COUNTER_COUNT])
+{
+  t8_counters_add (counts, 1);
+}
@@ -0,0 +1,83 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_counters.h
+ * Hardware performance counters of the profiled phases of t8code.
+ *
+ * If t8code is configured with --enable-perf-counters on Linux, the
+ * profiles of forests and cmeshes count the cycles, instructions, last
+ * level cache misses and branch misses of their phases next to the
+ * runtimes, see \ref t8_forest_set_profiling. The counters are opened with
+ * perf_event_open on first use and count the calling thread in user
+ * space. Work that other OpenMP threads do is not included.
+ * Otherwise, or if the kernel does not allow the counters, for example
+ * because of /proc/sys/kernel/perf_event_paranoid, all counts are 0.
+ */
+
+#ifndef T8_COUNTERS_H
+#define T8_COUNTERS_H
+
+#include <t8.h>
+
+/** The hardware events that are counted */
+typedef enum t8_counter
+{
+  T8_COUNTER_CYCLES = 0,        /**< The CPU cycles. */
+  T8_COUNTER_INSTRUCTIONS,      /**< The retired instructions. */
+  T8_COUNTER_LLC_MISSES,        /**< The misses of the last level cache. */
+  T8_COUNTER_BRANCH_MISSES,     /**< The mispredicted branches. */
+  T8_COUNTER_COUNT              /**< The number of counters. */
+}
+t8_counter_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** The names of the counters. */
+extern const char  *t8_counter_to_string[T8_COUNTER_COUNT];
+
+/** Query whether the hardware counters can be read.
+ * \return          True if t8code was configured with --enable-perf-counters
+ *                  and at least one counter could be opened.
+ */
+int                 t8_counters_available (void);
+
+/** Start to count a phase.
+ * \param [out] counts  Set to the negative current count of each counter.
+ *                      \ref t8_counters_stop adds the count at the end.
+ */
+void                t8_counters_start (int64_t counts[T8_COUNTER_COUNT]);
+
+/** Continue to count a phase that was counted before.
+ * \param [in,out] counts  The current count of each counter is subtracted.
+ */
+void                t8_counters_resume (int64_t counts[T8_COUNTER_COUNT]);
+
+/** Stop to count a phase.
+ * \param [in,out] counts  The current count of each counter is added, such
+ *                         that \a counts contains the events since
+ *                         \ref t8_counters_start.
+ */
+void                t8_counters_stop (int64_t counts[T8_COUNTER_COUNT]);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_COUNTERS_H */
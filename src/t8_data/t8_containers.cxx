@@ -208,13 +208,32 @@ t8_element_array_copy (t8_element_array_t * dest, t8_element_array_t * src)
   sc_array_copy (&dest->array, &src->array);
 }
 
+/* Append count uninitialized elements to the array and return a pointer
+ * to the first one. Unlike sc_array_push_count we use all memory that is
+ * allocated, since sc_array_resize shrinks the allocation to the next
+ * power of two and would discard the capacity of t8_element_array_reserve. */
+static t8_element_t *
+t8_element_array_grow (t8_element_array_t * element_array, size_t count)
+{
+  sc_array_t         *array = &element_array->array;
+  char               *new_elements;
+
+  if (SC_ARRAY_IS_OWNER (array)
+      && (array->elem_count + count) * array->elem_size
+      <= (size_t) array->byte_alloc) {
+    new_elements = array->array + array->elem_count * array->elem_size;
+    array->elem_count += count;
+    return (t8_element_t *) new_elements;
+  }
+  return (t8_element_t *) sc_array_push_count (array, count);
+}
+
 t8_element_t       *
 t8_element_array_push (t8_element_array_t * element_array)
 {
   t8_element_t       *new_element;
   T8_ASSERT (t8_element_array_is_valid (element_array));
-  new_element = (t8_element_t *)
-    sc_array_push (&element_array->array);
+  new_element = t8_element_array_grow (element_array, 1);
   element_array->scheme->t8_element_init (1, new_element, 0);
   return new_element;
 }
@@ -225,8 +244,7 @@ t8_element_t
   t8_element_t       *new_elements;
   T8_ASSERT (t8_element_array_is_valid (element_array));
   /* grow the array */
-  new_elements = (t8_element_t *)
-    sc_array_push_count (&element_array->array, count);
+  new_elements = t8_element_array_grow (element_array, count);
   /* initialize the elements */
   element_array->scheme->t8_element_init (count, new_elements, 0);
   return new_elements;
@@ -305,4 +323,49 @@ t8_element_array_truncate (t8_element_array_t * element_array)
   sc_array_truncate (&element_array->array);
 }
 
+void
+t8_element_array_rewind (t8_element_array_t * element_array,
+                         size_t new_count)
+{
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  sc_array_rewind (&element_array->array, new_count);
+}
+
+void
+t8_element_array_reserve (t8_element_array_t * element_array, size_t count)
+{
+  sc_array_t         *array = &element_array->array;
+  size_t              bytes;
+
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (SC_ARRAY_IS_OWNER (array));
+  bytes = count * array->elem_size;
+  if (bytes > (size_t) array->byte_alloc) {
+    /* Allocate exactly count elements. sc_array_resize would round up to
+     * a power of two, which may double the memory of a large array. */
+    array->array = SC_REALLOC (array->array, char, bytes);
+    array->byte_alloc = (ssize_t) bytes;
+  }
+}
+
+void
+t8_element_array_shrink_to_fit (t8_element_array_t * element_array)
+{
+  sc_array_t         *array = &element_array->array;
+  size_t              bytes;
+
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  bytes = array->elem_count * array->elem_size;
+  if (!SC_ARRAY_IS_OWNER (array) || (size_t) array->byte_alloc <= bytes) {
+    /* A view or no memory to free */
+    return;
+  }
+  if (bytes == 0) {
+    sc_array_reset (array);
+    return;
+  }
+  array->array = SC_REALLOC (array->array, char, bytes);
+  array->byte_alloc = (ssize_t) bytes;
+}
+
 T8_EXTERN_C_END ();
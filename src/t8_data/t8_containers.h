@@ -233,6 +233,39 @@ void                t8_element_array_reset (t8_element_array_t *
 void                t8_element_array_truncate (t8_element_array_t *
                                                element_array);
 
+/** Shorten an element array without reallocating it.
+ * \param [in,out]  element_array  Element array structure to be shortened.
+ * \param [in]      new_count      The new element count of the array.
+ *                                 Must not be larger than the current count.
+ * \note In contrast to \ref t8_element_array_resize, the memory is kept
+ * such that the array can grow again without reallocation.
+ */
+void                t8_element_array_rewind (t8_element_array_t *
+                                             element_array, size_t new_count);
+
+/** Make sure that an element array can store a number of elements without
+ * reallocating. The element count is not changed.
+ * If the array has to grow, exactly \a count elements are allocated, such
+ * that an array whose final size is known does not use more memory.
+ * \param [in,out]  element_array  Element array structure to be modified.
+ *                                 It must not be a view.
+ * \param [in]      count          The number of elements that should fit
+ *                                 into the allocated memory.
+ * \note The capacity is only kept if the array is not shortened with
+ * \ref t8_element_array_resize, use \ref t8_element_array_rewind instead.
+ * Rewinding to zero elements frees the memory.
+ */
+void                t8_element_array_reserve (t8_element_array_t *
+                                              element_array, size_t count);
+
+/** Free the memory of an element array that is allocated beyond its
+ * element count. The elements are copied if the array is reallocated.
+ * \param [in,out]  element_array  Element array structure to be modified.
+ *                                 Views are not changed.
+ */
+void                t8_element_array_shrink_to_fit (t8_element_array_t *
+                                                    element_array);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_CONTAINERS_HXX */
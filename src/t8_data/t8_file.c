@@ -0,0 +1,179 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_data/t8_file.h>
+
+/* Compute the logical and of a flag on all processes */
+static int
+t8_file_all_ok (int ok, sc_MPI_Comm comm)
+{
+  int                 all_ok, mpiret;
+
+  mpiret = sc_MPI_Allreduce (&ok, &all_ok, 1, sc_MPI_INT, sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  return all_ok;
+}
+
+int
+t8_file_open (t8_file_t * file, const char *filename, int write,
+              sc_MPI_Comm comm)
+{
+  int                 ok;
+#ifdef T8_ENABLE_MPIIO
+  int                 mpirank, mpiret;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  if (write) {
+    /* Delete an existing file, since MPI_File_open does not truncate it */
+    if (mpirank == 0) {
+      (void) MPI_File_delete ((char *) filename, MPI_INFO_NULL);
+    }
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_File_open (comm, (char *) filename,
+                          write ? MPI_MODE_WRONLY | MPI_MODE_CREATE :
+                          MPI_MODE_RDONLY, MPI_INFO_NULL, &file->fh);
+  file->is_open = mpiret == MPI_SUCCESS;
+  ok = t8_file_all_ok (file->is_open, comm);
+  if (!ok && file->is_open) {
+    MPI_File_close (&file->fh);
+    file->is_open = 0;
+  }
+#else
+  int                 mpirank, mpiret;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  ok = 1;
+  if (write) {
+    /* Process 0 creates the file, then all processes open it for
+     * updating, so that no process truncates data written by another */
+    if (mpirank == 0) {
+      file->fp = fopen (filename, "wb");
+      ok = file->fp != NULL;
+      if (ok) {
+        ok = fclose (file->fp) == 0;
+      }
+    }
+    ok = t8_file_all_ok (ok, comm);
+  }
+  file->fp = NULL;
+  if (ok) {
+    file->fp = fopen (filename, write ? "r+b" : "rb");
+  }
+  file->is_open = file->fp != NULL;
+  ok = t8_file_all_ok (file->is_open, comm);
+  if (!ok && file->is_open) {
+    fclose (file->fp);
+    file->is_open = 0;
+  }
+#endif
+  if (!ok) {
+    t8_global_errorf ("Could not open file %s for %s.\n", filename,
+                      write ? "writing" : "reading");
+  }
+  return ok;
+}
+
+/* Write or read count items of size bytes each at a byte offset. */
+static int
+t8_file_access (t8_file_t * file, int write, int collective,
+                int64_t offset, void *data, size_t count, size_t size)
+{
+#ifdef T8_ENABLE_MPIIO
+  MPI_Datatype        item;
+  MPI_Status          status;
+  int                 mpiret, num_accessed;
+
+  T8_ASSERT (file->is_open);
+  T8_ASSERT (count <= INT_MAX && size <= INT_MAX);
+  mpiret = MPI_Type_contiguous ((int) size, MPI_BYTE, &item);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_commit (&item);
+  SC_CHECK_MPI (mpiret);
+  if (write) {
+    mpiret = collective ?
+      MPI_File_write_at_all (file->fh, (MPI_Offset) offset, data,
+                             (int) count, item, &status) :
+      MPI_File_write_at (file->fh, (MPI_Offset) offset, data,
+                         (int) count, item, &status);
+  }
+  else {
+    mpiret = collective ?
+      MPI_File_read_at_all (file->fh, (MPI_Offset) offset, data,
+                            (int) count, item, &status) :
+      MPI_File_read_at (file->fh, (MPI_Offset) offset, data,
+                        (int) count, item, &status);
+  }
+  if (mpiret == MPI_SUCCESS) {
+    mpiret = MPI_Get_count (&status, item, &num_accessed);
+    mpiret = mpiret == MPI_SUCCESS && num_accessed == (int) count ?
+      MPI_SUCCESS : MPI_ERR_IO;
+  }
+  MPI_Type_free (&item);
+  return mpiret == MPI_SUCCESS;
+#else
+  T8_ASSERT (file->is_open);
+  if (count == 0) {
+    return 1;
+  }
+  if (fseek (file->fp, (long) offset, SEEK_SET) != 0) {
+    return 0;
+  }
+  if (write) {
+    return fwrite (data, size, count, file->fp) == count;
+  }
+  return fread (data, size, count, file->fp) == count;
+#endif
+}
+
+int
+t8_file_write_at (t8_file_t * file, int collective, int64_t offset,
+                  const void *data, size_t count, size_t size)
+{
+  return t8_file_access (file, 1, collective, offset, (void *) data, count,
+                         size);
+}
+
+int
+t8_file_read_at (t8_file_t * file, int collective, int64_t offset,
+                 void *data, size_t count, size_t size)
+{
+  return t8_file_access (file, 0, collective, offset, data, count, size);
+}
+
+int
+t8_file_close (t8_file_t * file)
+{
+  int                 ok;
+
+  T8_ASSERT (file->is_open);
+#ifdef T8_ENABLE_MPIIO
+  ok = MPI_File_close (&file->fh) == MPI_SUCCESS;
+#else
+  ok = fclose (file->fp) == 0;
+#endif
+  file->is_open = 0;
+  return ok;
+}
@@ -0,0 +1,90 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_file.h
+ * We define routines to collectively write and read a single file
+ * at explicit byte offsets.
+ * If t8code is configured with MPI-IO, the MPI_File routines are used.
+ * Otherwise each process accesses the file with stdio.
+ */
+
+#ifndef T8_FILE_H
+#define T8_FILE_H
+
+#include <t8.h>
+
+/** A file that is opened on all processes of a communicator. */
+typedef struct
+{
+  int                 is_open;  /**< True if the file is open */
+#ifdef T8_ENABLE_MPIIO
+  MPI_File            fh;       /**< The MPI file handle */
+#else
+  FILE               *fp;       /**< The file handle of this process */
+#endif
+} t8_file_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Open a file collectively for reading or writing.
+ * Opening for writing truncates an existing file.
+ * \param [out] file      The file handle.
+ * \param [in]  filename  The name of the file.
+ * \param [in]  write     If true, open for writing, otherwise for reading.
+ * \param [in]  comm      The communicator of all accessing processes.
+ * \return                True on all processes if the file could be opened
+ *                        on all processes. Otherwise the file is closed.
+ */
+int                 t8_file_open (t8_file_t * file, const char *filename,
+                                  int write, sc_MPI_Comm comm);
+
+/** Write \a count items of \a size bytes each at a byte offset.
+ * \param [in] file       A file opened for writing.
+ * \param [in] collective If true, all processes of the communicator
+ *                        must call this function.
+ * \param [in] offset     The byte offset in the file.
+ * \param [in] data       The data to write.
+ * \param [in] count      The number of items. May be 0.
+ * \param [in] size       The size of one item in bytes.
+ * \return                True if all data was written on this process.
+ */
+int                 t8_file_write_at (t8_file_t * file, int collective,
+                                      int64_t offset, const void *data,
+                                      size_t count, size_t size);
+
+/** Read \a count items of \a size bytes each at a byte offset.
+ * \see t8_file_write_at for the parameters.
+ * \return                True if all data was read on this process.
+ */
+int                 t8_file_read_at (t8_file_t * file, int collective,
+                                     int64_t offset, void *data,
+                                     size_t count, size_t size);
+
+/** Close a file. This function is collective.
+ * \param [in,out] file   An open file.
+ * \return                True if the file was closed on this process.
+ */
+int                 t8_file_close (t8_file_t * file);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FILE_H */
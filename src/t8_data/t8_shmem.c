@@ -27,8 +27,6 @@
 
 #include <t8_data/t8_shmem.h>
 
-/* TODO: Think about whether we include a reference counter */
-
 typedef struct t8_shmem_array
 {
   void               *array;
@@ -40,6 +38,35 @@ typedef struct t8_shmem_array
 #endif
 } t8_shmem_array_struct_t;
 
+/* A communicator whose node communicators were created by t8_shmem_init */
+typedef struct
+{
+  sc_MPI_Comm         comm;
+  int                 num_users;        /* The number of open t8_shmem_init calls */
+} t8_shmem_node_comms_t;
+
+/* The communicators with node communicators that t8_shmem_init created */
+static sc_array_t  *t8_shmem_node_comms = NULL;
+
+/* Return the index of comm in t8_shmem_node_comms or -1 if it is not
+ * stored there */
+static              ssize_t
+t8_shmem_node_comms_find (sc_MPI_Comm comm)
+{
+  size_t              iz;
+
+  if (t8_shmem_node_comms == NULL) {
+    return -1;
+  }
+  for (iz = 0; iz < t8_shmem_node_comms->elem_count; iz++) {
+    if (((t8_shmem_node_comms_t *)
+         sc_array_index (t8_shmem_node_comms, iz))->comm == comm) {
+      return (ssize_t) iz;
+    }
+  }
+  return -1;
+}
+
 int
 t8_shmem_set_type (sc_MPI_Comm comm, sc_shmem_type_t type)
 {
@@ -54,6 +81,115 @@ t8_shmem_set_type (sc_MPI_Comm comm, sc_shmem_type_t type)
   }
 }
 
+void
+t8_shmem_init (sc_MPI_Comm comm)
+{
+  sc_MPI_Comm         intranode = sc_MPI_COMM_NULL;
+  sc_MPI_Comm         internode = sc_MPI_COMM_NULL;
+  t8_shmem_node_comms_t *node_comms;
+  ssize_t             index;
+
+  index = t8_shmem_node_comms_find (comm);
+  if (index >= 0) {
+    /* We created the node communicators before */
+    ((t8_shmem_node_comms_t *)
+     sc_array_index (t8_shmem_node_comms, index))->num_users++;
+    return;
+  }
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  if (intranode == sc_MPI_COMM_NULL) {
+    /* The node communicators do not exist yet */
+    sc_mpi_comm_attach_node_comms (comm, 0);
+    sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+    if (intranode == sc_MPI_COMM_NULL) {
+      /* The node communicators cannot be created */
+      return;
+    }
+    if (t8_shmem_node_comms == NULL) {
+      t8_shmem_node_comms = sc_array_new (sizeof (t8_shmem_node_comms_t));
+    }
+    node_comms = (t8_shmem_node_comms_t *)
+      sc_array_push (t8_shmem_node_comms);
+    node_comms->comm = comm;
+    node_comms->num_users = 1;
+  }
+}
+
+void
+t8_shmem_comm_node_ordered (sc_MPI_Comm comm, sc_MPI_Comm * node_ordered)
+{
+  sc_MPI_Comm         intranode = sc_MPI_COMM_NULL;
+  sc_MPI_Comm         internode = sc_MPI_COMM_NULL;
+  int                 intrarank, intrasize, node_offset, mpiret;
+
+  T8_ASSERT (node_ordered != NULL);
+
+  t8_shmem_init (comm);
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
+    t8_global_infof ("Could not compute the node communicators. "
+                     "Keeping the rank order.\n");
+    mpiret = sc_MPI_Comm_dup (comm, node_ordered);
+    SC_CHECK_MPI (mpiret);
+    t8_shmem_finalize (comm);
+    return;
+  }
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+
+  /* The first processes of the nodes share the internode communicator,
+   * in which they add up the sizes of the preceding nodes */
+  node_offset = 0;
+  if (intrarank == 0) {
+    mpiret = sc_MPI_Scan (&intrasize, &node_offset, 1, sc_MPI_INT,
+                          sc_MPI_SUM, internode);
+    SC_CHECK_MPI (mpiret);
+    node_offset -= intrasize;
+  }
+  mpiret = sc_MPI_Bcast (&node_offset, 1, sc_MPI_INT, 0, intranode);
+  SC_CHECK_MPI (mpiret);
+
+  /* The keys are unique, so they are the ranks in the new communicator */
+  mpiret = sc_MPI_Comm_split (comm, 0, node_offset + intrarank,
+                              node_ordered);
+  SC_CHECK_MPI (mpiret);
+  t8_shmem_finalize (comm);
+}
+
+void
+t8_shmem_finalize (sc_MPI_Comm comm)
+{
+  t8_shmem_node_comms_t *node_comms;
+  ssize_t             index;
+  size_t              last;
+
+  index = t8_shmem_node_comms_find (comm);
+  if (index < 0) {
+    /* The node communicators were not created by t8_shmem_init */
+    return;
+  }
+  node_comms = (t8_shmem_node_comms_t *)
+    sc_array_index (t8_shmem_node_comms, index);
+  T8_ASSERT (node_comms->num_users > 0);
+  if (--node_comms->num_users > 0) {
+    return;
+  }
+  sc_mpi_comm_detach_node_comms (comm);
+  /* Replace the entry with the last one */
+  last = t8_shmem_node_comms->elem_count - 1;
+  if ((size_t) index < last) {
+    *node_comms = *(t8_shmem_node_comms_t *)
+      sc_array_index (t8_shmem_node_comms, last);
+  }
+  sc_array_resize (t8_shmem_node_comms, last);
+  if (last == 0) {
+    sc_array_destroy (t8_shmem_node_comms);
+    t8_shmem_node_comms = NULL;
+  }
+}
+
 void
 t8_shmem_array_init (t8_shmem_array_t * parray, size_t elem_size,
                      size_t elem_count, sc_MPI_Comm comm)
@@ -62,6 +198,10 @@ t8_shmem_array_init (t8_shmem_array_t * parray, size_t elem_size,
 
   T8_ASSERT (parray != NULL);
 
+  /* Attach the node communicators, such that memory of type
+   * SC_SHMEM_WINDOW is allocated once per node and allgathers are
+   * carried out per node. */
+  t8_shmem_init (comm);
   array = *parray = T8_ALLOC_ZERO (t8_shmem_array_struct_t, 1);
   array->array = sc_shmem_malloc (t8_get_package_id (), elem_size, elem_count,
                                   comm);
@@ -73,6 +213,20 @@ t8_shmem_array_init (t8_shmem_array_t * parray, size_t elem_size,
 #endif
 }
 
+int
+t8_shmem_array_start_writing (t8_shmem_array_t array)
+{
+  T8_ASSERT (array != NULL);
+  return sc_shmem_write_start (array->array, array->comm);
+}
+
+void
+t8_shmem_array_end_writing (t8_shmem_array_t array)
+{
+  T8_ASSERT (array != NULL);
+  sc_shmem_write_end (array->array, array->comm);
+}
+
 void
 t8_shmem_array_copy (t8_shmem_array_t dest, t8_shmem_array_t source)
 {
@@ -93,15 +247,139 @@ t8_shmem_array_copy (t8_shmem_array_t dest, t8_shmem_array_t source)
   sc_shmem_memcpy (dest->array, source->array, bytes, source->comm);
 }
 
+#ifdef SC_ENABLE_MPI
+/* Allgather recvbytes bytes of each process of comm into the private
+ * recvbuf of each process with one message per node between the nodes:
+ * The processes of a node gather their data and their ranks at the first
+ * process of the node, these node leaders allgather the data of all their
+ * nodes and broadcast the result on their node.
+ * The ranks of a node do not need to be contiguous. */
+static void
+t8_shmem_allgather_node (void *sendbuf, void *recvbuf, int recvbytes,
+                         sc_MPI_Comm comm, sc_MPI_Comm intranode,
+                         sc_MPI_Comm internode)
+{
+  int                 mpirank, mpisize, intrarank, intrasize;
+  int                 num_nodes, inode, iproc, num_procs, mpiret;
+  int                *node_sizes = NULL, *node_offsets = NULL;
+  int                *node_ranks = NULL, *all_ranks = NULL;
+  int                *byte_counts = NULL, *byte_offsets = NULL;
+  char               *node_data = NULL, *all_data = NULL;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+
+  /* Gather the data and the ranks of this node at its leader */
+  if (intrarank == 0) {
+    node_ranks = T8_ALLOC (int, intrasize);
+    node_data = T8_ALLOC (char, (size_t) intrasize * recvbytes);
+  }
+  mpiret = sc_MPI_Gather (&mpirank, 1, sc_MPI_INT, node_ranks, 1, sc_MPI_INT,
+                          0, intranode);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Gather (sendbuf, recvbytes, sc_MPI_BYTE, node_data,
+                          recvbytes, sc_MPI_BYTE, 0, intranode);
+  SC_CHECK_MPI (mpiret);
+
+  if (intrarank == 0) {
+    /* Exchange the node sizes, ranks and data between the node leaders */
+    mpiret = sc_MPI_Comm_size (internode, &num_nodes);
+    SC_CHECK_MPI (mpiret);
+    node_sizes = T8_ALLOC (int, num_nodes);
+    node_offsets = T8_ALLOC (int, num_nodes);
+    byte_counts = T8_ALLOC (int, num_nodes);
+    byte_offsets = T8_ALLOC (int, num_nodes);
+    mpiret = sc_MPI_Allgather (&intrasize, 1, sc_MPI_INT, node_sizes, 1,
+                               sc_MPI_INT, internode);
+    SC_CHECK_MPI (mpiret);
+    num_procs = 0;
+    for (inode = 0; inode < num_nodes; inode++) {
+      node_offsets[inode] = num_procs;
+      byte_counts[inode] = node_sizes[inode] * recvbytes;
+      byte_offsets[inode] = num_procs * recvbytes;
+      num_procs += node_sizes[inode];
+    }
+    T8_ASSERT (num_procs == mpisize);
+    all_ranks = T8_ALLOC (int, mpisize);
+    all_data = T8_ALLOC (char, (size_t) mpisize * recvbytes);
+    mpiret = sc_MPI_Allgatherv (node_ranks, intrasize, sc_MPI_INT, all_ranks,
+                                node_sizes, node_offsets, sc_MPI_INT,
+                                internode);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Allgatherv (node_data, intrasize * recvbytes,
+                                sc_MPI_BYTE, all_data, byte_counts,
+                                byte_offsets, sc_MPI_BYTE, internode);
+    SC_CHECK_MPI (mpiret);
+    /* Sort the data by rank */
+    for (iproc = 0; iproc < mpisize; iproc++) {
+      T8_ASSERT (0 <= all_ranks[iproc] && all_ranks[iproc] < mpisize);
+      memcpy ((char *) recvbuf + (size_t) all_ranks[iproc] * recvbytes,
+              all_data + (size_t) iproc * recvbytes, recvbytes);
+    }
+    T8_FREE (node_sizes);
+    T8_FREE (node_offsets);
+    T8_FREE (byte_counts);
+    T8_FREE (byte_offsets);
+    T8_FREE (node_ranks);
+    T8_FREE (node_data);
+    T8_FREE (all_ranks);
+    T8_FREE (all_data);
+  }
+  /* Publish the result on this node */
+  mpiret = sc_MPI_Bcast (recvbuf, mpisize * recvbytes, sc_MPI_BYTE, 0,
+                         intranode);
+  SC_CHECK_MPI (mpiret);
+}
+#endif
+
 void
 t8_shmem_array_allgather (void *sendbuf, int sendcount,
                           sc_MPI_Datatype sendtype,
                           t8_shmem_array_t recvarray, int recvcount,
                           sc_MPI_Datatype recvtype)
 {
+#ifdef SC_ENABLE_MPI
+  sc_MPI_Comm         intranode = sc_MPI_COMM_NULL;
+  sc_MPI_Comm         internode = sc_MPI_COMM_NULL;
+  sc_shmem_type_t     type;
+  int                 mpisize, intrasize, mpiret;
+#endif
+
   T8_ASSERT (recvarray != NULL);
   T8_ASSERT (recvarray->array != NULL);
 
+#ifdef SC_ENABLE_MPI
+  type = sc_shmem_get_type (recvarray->comm);
+  if (type == SC_SHMEM_BASIC || type == SC_SHMEM_PRESCAN) {
+    /* Each process stores its own copy of the array. sc_shmem_allgather
+     * would send all data between all processes, so we gather per node
+     * if there are multiple nodes. All processes take the same decision,
+     * since intrasize equals mpisize on all or on no process.
+     * With one of the other types sc_shmem_allgather already gathers per
+     * node into a shared array. */
+    sc_mpi_comm_get_node_comms (recvarray->comm, &intranode, &internode);
+    if (intranode != sc_MPI_COMM_NULL) {
+      mpiret = sc_MPI_Comm_size (recvarray->comm, &mpisize);
+      SC_CHECK_MPI (mpiret);
+      mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+      SC_CHECK_MPI (mpiret);
+      if (intrasize < mpisize) {
+        T8_ASSERT (sendcount * sc_mpi_sizeof (sendtype)
+                   == recvcount * sc_mpi_sizeof (recvtype));
+        t8_shmem_allgather_node (sendbuf, recvarray->array,
+                                 recvcount * (int) sc_mpi_sizeof (recvtype),
+                                 recvarray->comm, intranode, internode);
+        return;
+      }
+    }
+  }
+#endif
   sc_shmem_allgather (sendbuf, sendcount, sendtype, recvarray->array,
                       recvcount, recvtype, recvarray->comm);
 }
@@ -212,6 +490,8 @@ t8_shmem_array_destroy (t8_shmem_array_t * parray)
   T8_ASSERT (parray != NULL && *parray != NULL);
   array = *parray;
   sc_shmem_free (t8_get_package_id (), array->array, array->comm);
+  /* Release the node communicators of t8_shmem_array_init */
+  t8_shmem_finalize (array->comm);
   T8_FREE (array);
   *parray = NULL;
 }
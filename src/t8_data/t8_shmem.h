@@ -64,6 +64,45 @@ T8_EXTERN_C_BEGIN ();
 int                 t8_shmem_set_type (sc_MPI_Comm comm,
                                        sc_shmem_type_t type);
 
+/** Create the intranode and internode communicators of a communicator,
+ * if they do not exist already. They are needed to allocate shared
+ * memory of type SC_SHMEM_WINDOW once per node. If they do not exist,
+ * such memory is allocated on each process.
+ * Each call must be matched by a call to \ref t8_shmem_finalize.
+ * \ref t8_shmem_array_init and \ref t8_shmem_array_destroy do this for
+ * each shared memory array.
+ * \param [in]      comm    The MPI Communicator
+ * \see sc_mpi_comm_attach_node_comms
+ */
+void                t8_shmem_init (sc_MPI_Comm comm);
+
+/** Release the intranode and internode communicators of a communicator.
+ * They are freed with the call that matches the first call of
+ * \ref t8_shmem_init, if that call created them. Communicators that
+ * were attached otherwise are kept.
+ * \param [in]      comm    The MPI Communicator
+ */
+void                t8_shmem_finalize (sc_MPI_Comm comm);
+
+/** Create a communicator with the processes of \a comm whose ranks are
+ * numbered node by node: The processes of the first shared memory node
+ * get the ranks 0 to its size - 1, followed by those of the second node,
+ * and so on. Within a node and between the nodes the order of \a comm is
+ * kept, so for a block placement of the ranks the order does not change.
+ * Since forests and cmeshes assign contiguous pieces of the space-filling
+ * curve to consecutive ranks, building them on this communicator keeps
+ * neighboring pieces and most of their ghost traffic on the same node
+ * for any placement of the ranks.
+ * If the node communicators cannot be created, the result is a duplicate
+ * of \a comm.  Collective on \a comm.
+ * \param [in]      comm          The MPI Communicator.
+ * \param [out]     node_ordered  The new communicator. It must be freed
+ *                                with sc_MPI_Comm_free.
+ * \see sc_mpi_comm_attach_node_comms
+ */
+void                t8_shmem_comm_node_ordered (sc_MPI_Comm comm,
+                                                sc_MPI_Comm * node_ordered);
+
 /** Initialize and allocate a shared memory array structure.
  * \param [in,out]      parray On input this pointer must be non-NULL.
  *                             On return this pointer is set to the new t8_shmem_array.
@@ -72,6 +111,8 @@ int                 t8_shmem_set_type (sc_MPI_Comm comm,
  * \param [in]          comm      The MPI communicator to be associated with the shmem_array.
  *                                The shared memory type must have been set. Best practice would be
  *                                calling \ref sc_shmem_set_type (comm, T8_SHMEM_BEST_TYPE).
+ *                                The node communicators of \a comm are created if
+ *                                they do not exist, see \ref t8_shmem_init.
  */
 void                t8_shmem_array_init (t8_shmem_array_t * parray,
                                          size_t elem_size,
@@ -85,6 +126,23 @@ void                t8_shmem_array_init (t8_shmem_array_t * parray,
 void                t8_shmem_array_set_gloidx (t8_shmem_array_t array,
                                                int index, t8_gloidx_t value);
 
+/** Start writing to a t8_shmem array. Collective on the communicator
+ * of the array. Only the process for which true is returned may write to
+ * the array and all processes must call \ref t8_shmem_array_end_writing
+ * afterwards.
+ * \param [in,out]  array   The array.
+ * \return                  True if this process writes the array.
+ * \see sc_shmem_write_start
+ */
+int                 t8_shmem_array_start_writing (t8_shmem_array_t array);
+
+/** End writing to a t8_shmem array. Collective on the communicator of the
+ * array. After this call all processes see the written data.
+ * \param [in,out]  array   The array.
+ * \see sc_shmem_write_end
+ */
+void                t8_shmem_array_end_writing (t8_shmem_array_t array);
+
 /** Copy the contents of one t8_shmem array into another.
  * \param [in,out]      dest    The array in which should be copied.
  * \param [in]          source  The array to copy.
@@ -94,6 +152,11 @@ void                t8_shmem_array_copy (t8_shmem_array_t dest,
                                          t8_shmem_array_t source);
 
 /** Fill a t8_shmem array with an allgather.
+ * The data is sent once per node between the nodes: With a shared memory
+ * type such as SC_SHMEM_WINDOW the node communicators gather into one
+ * array per node, otherwise the processes of a node gather at one
+ * process, which exchanges the data with the other nodes and broadcasts
+ * it on its node.
  *
  * \param[in] sendbuf         the source from this process
  * \param[in] sendcount       the number of items to allgather
@@ -31,6 +31,8 @@
 #include "t8_default_tri_cxx.hxx"
 #include "t8_default_tet_cxx.hxx"
 #include "t8_default_prism_cxx.hxx"
+#include "t8_hilbert_quad_cxx.hxx"
+#include "t8_hilbert_hex_cxx.hxx"
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -54,4 +56,23 @@ t8_scheme_new_default_cxx (void)
   return s;
 }
 
+t8_scheme_cxx_t    *
+t8_scheme_new_hilbert_cxx (void)
+{
+  t8_scheme_cxx_t    *s;
+
+  s = T8_ALLOC_ZERO (t8_scheme_cxx_t, 1);
+  t8_refcount_init (&s->rc);
+
+  s->eclass_schemes[T8_ECLASS_VERTEX] = new t8_default_scheme_vertex_c ();
+  s->eclass_schemes[T8_ECLASS_LINE] = new t8_default_scheme_line_c ();
+  s->eclass_schemes[T8_ECLASS_QUAD] = new t8_hilbert_scheme_quad_c ();
+  s->eclass_schemes[T8_ECLASS_HEX] = new t8_hilbert_scheme_hex_c ();
+  s->eclass_schemes[T8_ECLASS_TRIANGLE] = new t8_default_scheme_tri_c ();
+  s->eclass_schemes[T8_ECLASS_TET] = new t8_default_scheme_tet_c ();
+  s->eclass_schemes[T8_ECLASS_PRISM] = new t8_default_scheme_prism_c ();
+
+  return s;
+}
+
 T8_EXTERN_C_END ();
@@ -0,0 +1,257 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_default_device.h
+ * Element functions of the default scheme for lines, quadrilaterals and
+ * hexahedra that can be called on the host and on the device.
+ *
+ * The functions work on the element structs that the default scheme
+ * stores, such that they can be applied to the leaf arrays that were
+ * copied with \ref t8_forest_mirror_new. They are inline, do not check
+ * their arguments and do not call library functions.
+ * Elements must be inside the root tree except for the result of a face
+ * neighbor. The functions agree with the scheme functions for these
+ * elements, see t8_test_forest_mirror.
+ * The triangle and tetrahedron functions depend on lookup tables and are
+ * not provided yet.
+ */
+
+#ifndef T8_DEFAULT_DEVICE_H
+#define T8_DEFAULT_DEVICE_H
+
+#include <t8_device.h>
+#include <t8_default/t8_dline.h>
+#include <p4est.h>
+#include <p8est.h>
+
+/** Return the linear id of a line's ancestor or descendant at a level. */
+static inline T8_DEVICE_FUNC t8_linearidx_t
+t8_device_line_linear_id (const t8_dline_t * l, int level)
+{
+  return (t8_linearidx_t) (l->x >> (T8_DLINE_MAXLEVEL - level));
+}
+
+/** Return the child id of a line with level greater zero. */
+static inline T8_DEVICE_FUNC int
+t8_device_line_child_id (const t8_dline_t * l)
+{
+  return (l->x & T8_DLINE_LEN (l->level)) != 0;
+}
+
+/** Compute the parent of a line with level greater zero. */
+static inline T8_DEVICE_FUNC void
+t8_device_line_parent (const t8_dline_t * l, t8_dline_t * parent)
+{
+  parent->x = l->x & ~T8_DLINE_LEN (l->level);
+  parent->level = l->level - 1;
+}
+
+/** Compute the face neighbor of a line and return the face of the neighbor
+ * at which it touches \a l. The neighbor may be outside the root. */
+static inline T8_DEVICE_FUNC int
+t8_device_line_face_neighbor (const t8_dline_t * l, int face,
+                              t8_dline_t * neigh)
+{
+  neigh->level = l->level;
+  neigh->x = l->x + (face ? T8_DLINE_LEN (l->level) :
+                     -T8_DLINE_LEN (l->level));
+  return 1 - face;
+}
+
+/** Return true if a line lies inside the root line. */
+static inline T8_DEVICE_FUNC int
+t8_device_line_is_inside_root (const t8_dline_t * l)
+{
+  return l->x >= 0 && l->x < T8_DLINE_ROOT_LEN;
+}
+
+/** Compute the integer coordinates of a vertex of a line. */
+static inline T8_DEVICE_FUNC void
+t8_device_line_vertex_coords (const t8_dline_t * l, int vertex,
+                              int coords[])
+{
+  coords[0] = l->x + (vertex ? T8_DLINE_LEN (l->level) : 0);
+}
+
+/** Return the linear id of a quadrilateral's ancestor or descendant at a
+ * level. */
+static inline T8_DEVICE_FUNC t8_linearidx_t
+t8_device_quad_linear_id (const p4est_quadrant_t * q, int level)
+{
+  t8_linearidx_t      x, y, id = 0;
+  int                 i;
+
+  x = (t8_linearidx_t) (q->x >> (P4EST_MAXLEVEL - level));
+  y = (t8_linearidx_t) (q->y >> (P4EST_MAXLEVEL - level));
+  for (i = 0; i < level; ++i) {
+    id |= (x & ((t8_linearidx_t) 1 << i)) << i;
+    id |= (y & ((t8_linearidx_t) 1 << i)) << (i + 1);
+  }
+  return id;
+}
+
+/** Return the child id of a quadrilateral with level greater zero. */
+static inline T8_DEVICE_FUNC int
+t8_device_quad_child_id (const p4est_quadrant_t * q)
+{
+  const p4est_qcoord_t h = P4EST_QUADRANT_LEN (q->level);
+
+  return ((q->x & h) ? 1 : 0) | ((q->y & h) ? 2 : 0);
+}
+
+/** Compute the parent of a quadrilateral with level greater zero. */
+static inline T8_DEVICE_FUNC void
+t8_device_quad_parent (const p4est_quadrant_t * q, p4est_quadrant_t * parent)
+{
+  const p4est_qcoord_t h = P4EST_QUADRANT_LEN (q->level);
+
+  /* Keep the embedding of the quadrilateral in the padding fields */
+  *parent = *q;
+  parent->x = q->x & ~h;
+  parent->y = q->y & ~h;
+  parent->level = q->level - 1;
+}
+
+/** Compute the face neighbor of a quadrilateral and return the face of the
+ * neighbor at which it touches \a q. The neighbor may be outside the root. */
+static inline T8_DEVICE_FUNC int
+t8_device_quad_face_neighbor (const p4est_quadrant_t * q, int face,
+                              p4est_quadrant_t * neigh)
+{
+  const p4est_qcoord_t h = P4EST_QUADRANT_LEN (q->level);
+  const p4est_qcoord_t shift = (face & 1) ? h : -h;
+
+  *neigh = *q;
+  if (face >> 1) {
+    neigh->y += shift;
+  }
+  else {
+    neigh->x += shift;
+  }
+  return face ^ 1;
+}
+
+/** Return true if a quadrilateral lies inside the root quadrilateral. */
+static inline T8_DEVICE_FUNC int
+t8_device_quad_is_inside_root (const p4est_quadrant_t * q)
+{
+  return q->x >= 0 && q->x < P4EST_ROOT_LEN
+    && q->y >= 0 && q->y < P4EST_ROOT_LEN;
+}
+
+/** Compute the integer coordinates of a vertex of a quadrilateral. */
+static inline T8_DEVICE_FUNC void
+t8_device_quad_vertex_coords (const p4est_quadrant_t * q, int vertex,
+                              int coords[])
+{
+  const p4est_qcoord_t h = P4EST_QUADRANT_LEN (q->level);
+
+  coords[0] = q->x + ((vertex & 1) ? h : 0);
+  coords[1] = q->y + ((vertex & 2) ? h : 0);
+}
+
+/** Return the linear id of a hexahedron's ancestor or descendant at a
+ * level. */
+static inline T8_DEVICE_FUNC t8_linearidx_t
+t8_device_hex_linear_id (const p8est_quadrant_t * q, int level)
+{
+  t8_linearidx_t      x, y, z, id = 0;
+  int                 i;
+
+  x = (t8_linearidx_t) (q->x >> (P8EST_MAXLEVEL - level));
+  y = (t8_linearidx_t) (q->y >> (P8EST_MAXLEVEL - level));
+  z = (t8_linearidx_t) (q->z >> (P8EST_MAXLEVEL - level));
+  for (i = 0; i < level; ++i) {
+    id |= (x & ((t8_linearidx_t) 1 << i)) << (2 * i);
+    id |= (y & ((t8_linearidx_t) 1 << i)) << (2 * i + 1);
+    id |= (z & ((t8_linearidx_t) 1 << i)) << (2 * i + 2);
+  }
+  return id;
+}
+
+/** Return the child id of a hexahedron with level greater zero. */
+static inline T8_DEVICE_FUNC int
+t8_device_hex_child_id (const p8est_quadrant_t * q)
+{
+  const p4est_qcoord_t h = P8EST_QUADRANT_LEN (q->level);
+
+  return ((q->x & h) ? 1 : 0) | ((q->y & h) ? 2 : 0) | ((q->z & h) ? 4 : 0);
+}
+
+/** Compute the parent of a hexahedron with level greater zero. */
+static inline T8_DEVICE_FUNC void
+t8_device_hex_parent (const p8est_quadrant_t * q, p8est_quadrant_t * parent)
+{
+  const p4est_qcoord_t h = P8EST_QUADRANT_LEN (q->level);
+
+  *parent = *q;
+  parent->x = q->x & ~h;
+  parent->y = q->y & ~h;
+  parent->z = q->z & ~h;
+  parent->level = q->level - 1;
+}
+
+/** Compute the face neighbor of a hexahedron and return the face of the
+ * neighbor at which it touches \a q. The neighbor may be outside the root. */
+static inline T8_DEVICE_FUNC int
+t8_device_hex_face_neighbor (const p8est_quadrant_t * q, int face,
+                             p8est_quadrant_t * neigh)
+{
+  const p4est_qcoord_t h = P8EST_QUADRANT_LEN (q->level);
+  const p4est_qcoord_t shift = (face & 1) ? h : -h;
+
+  *neigh = *q;
+  switch (face >> 1) {
+  case 0:
+    neigh->x += shift;
+    break;
+  case 1:
+    neigh->y += shift;
+    break;
+  default:
+    neigh->z += shift;
+  }
+  return face ^ 1;
+}
+
+/** Return true if a hexahedron lies inside the root hexahedron. */
+static inline T8_DEVICE_FUNC int
+t8_device_hex_is_inside_root (const p8est_quadrant_t * q)
+{
+  return q->x >= 0 && q->x < P8EST_ROOT_LEN
+    && q->y >= 0 && q->y < P8EST_ROOT_LEN
+    && q->z >= 0 && q->z < P8EST_ROOT_LEN;
+}
+
+/** Compute the integer coordinates of a vertex of a hexahedron. */
+static inline T8_DEVICE_FUNC void
+t8_device_hex_vertex_coords (const p8est_quadrant_t * q, int vertex,
+                             int coords[])
+{
+  const p4est_qcoord_t h = P8EST_QUADRANT_LEN (q->level);
+
+  coords[0] = q->x + ((vertex & 1) ? h : 0);
+  coords[1] = q->y + ((vertex & 2) ? h : 0);
+  coords[2] = q->z + ((vertex & 4) ? h : 0);
+}
+
+#endif /* !T8_DEFAULT_DEVICE_H */
@@ -576,6 +576,49 @@ t8_default_scheme_hex_c::t8_element_face_neighbor_inside (const t8_element_t *
   return p8est_quadrant_is_inside_root (n);
 }
 
+int
+t8_default_scheme_hex_c::t8_element_half_face_neighbors_inside (const
+                                                                t8_element_t
+                                                                * elem,
+                                                                int face,
+                                                                t8_element_t
+                                                                * neighs[],
+                                                                int
+                                                                num_neighs,
+                                                                int
+                                                                *dual_faces)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  const p4est_qcoord_t shift = P8EST_QUADRANT_LEN (q->level + 1);
+  p8est_quadrant_t   *n;
+  p4est_qcoord_t      dx, dy, dz;
+  int                 ineigh, child_id;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < P8EST_FACES);
+  T8_ASSERT (num_neighs == P8EST_HALF);
+  T8_ASSERT (q->level < P8EST_QMAXLEVEL);
+
+  /* The children at face are the face corners of q. The neighbor of
+   * each child is shifted by the child's length normal to the face. */
+  dx = face == 0 ? -shift : face == 1 ? shift : 0;
+  dy = face == 2 ? -shift : face == 3 ? shift : 0;
+  dz = face == 4 ? -shift : face == 5 ? shift : 0;
+  for (ineigh = 0; ineigh < P8EST_HALF; ineigh++) {
+    child_id = p8est_face_corners[face][ineigh];
+    n = (p8est_quadrant_t *) neighs[ineigh];
+    n->x = q->x + (child_id & 0x01 ? shift : 0) + dx;
+    n->y = q->y + (child_id & 0x02 ? shift : 0) + dy;
+    n->z = q->z + (child_id & 0x04 ? shift : 0) + dz;
+    n->level = q->level + 1;
+    if (dual_faces != NULL) {
+      dual_faces[ineigh] = p8est_face_dual[face];
+    }
+  }
+  /* The neighbors are all inside or all outside of the root */
+  return p8est_quadrant_is_inside_root ((p8est_quadrant_t *) neighs[0]);
+}
+
 void
 t8_default_scheme_hex_c::t8_element_set_linear_id (t8_element_t * elem,
                                                    int level,
@@ -677,6 +720,82 @@ t8_default_scheme_hex_c::t8_element_vertex_coords (const t8_element_t * t,
   coords[2] = q1->z + (vertex & 4 ? 1 : 0) * len;
 }
 
+void
+t8_default_scheme_hex_c::t8_element_level_array (const t8_element_t * elems,
+                                                 size_t count, int *levels)
+{
+  const p8est_quadrant_t *e = (const p8est_quadrant_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    levels[ielem] = e[ielem].level;
+  }
+}
+
+void
+t8_default_scheme_hex_c::t8_element_child_id_array (const t8_element_t * elems,
+                                                    size_t count, int *child_ids)
+{
+  const p8est_quadrant_t *e = (const p8est_quadrant_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    child_ids[ielem] = p8est_quadrant_child_id (e + ielem);
+  }
+}
+
+void
+t8_default_scheme_hex_c::t8_element_get_linear_id_array (const t8_element_t * elems,
+                                                         size_t count, int level,
+                                                         t8_linearidx_t * ids)
+{
+  const p8est_quadrant_t *e = (const p8est_quadrant_t *) elems;
+  size_t              ielem;
+
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    ids[ielem] = p8est_quadrant_linear_id (e + ielem, level);
+  }
+}
+
+void
+t8_default_scheme_hex_c::t8_element_vertex_coords_array (const t8_element_t * elems,
+                                                         size_t count, int vertex,
+                                                         int *coords)
+{
+  const p8est_quadrant_t *e = (const p8est_quadrant_t *) elems;
+  size_t              ielem;
+  int                 len;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    len = P8EST_QUADRANT_LEN (e[ielem].level);
+    coords[T8_ECLASS_MAX_DIM * ielem] = e[ielem].x + (vertex & 1 ? len : 0);
+    coords[T8_ECLASS_MAX_DIM * ielem + 1] =
+      e[ielem].y + (vertex & 2 ? len : 0);
+    coords[T8_ECLASS_MAX_DIM * ielem + 2] =
+      e[ielem].z + (vertex & 4 ? len : 0);
+  }
+}
+
+int
+t8_default_scheme_hex_c::t8_element_is_family_array (const t8_element_t * elems)
+{
+  const p8est_quadrant_t *e = (const p8est_quadrant_t *) elems;
+
+#ifdef T8_ENABLE_DEBUG
+  int                 i;
+  for (i = 0; i < P8EST_CHILDREN; i++) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + i)));
+  }
+#endif
+  return p8est_quadrant_is_familyv (e);
+}
+
 void
 t8_default_scheme_hex_c::t8_element_new (int length, t8_element_t ** elem)
 {
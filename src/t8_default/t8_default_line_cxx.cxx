@@ -349,6 +349,103 @@ t8_default_scheme_line_c::t8_element_vertex_coords (const t8_element_t * t,
   t8_dline_vertex_coords ((const t8_dline_t *) t, vertex, coords);
 }
 
+void
+t8_default_scheme_line_c::t8_element_level_array (const t8_element_t * elems,
+                                                  size_t count, int *levels)
+{
+  const t8_dline_t *e = (const t8_dline_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    levels[ielem] = t8_dline_get_level (e + ielem);
+  }
+}
+
+void
+t8_default_scheme_line_c::t8_element_child_id_array (const t8_element_t * elems,
+                                                     size_t count, int *child_ids)
+{
+  const t8_dline_t *e = (const t8_dline_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    child_ids[ielem] = t8_dline_child_id (e + ielem);
+  }
+}
+
+void
+t8_default_scheme_line_c::t8_element_get_linear_id_array (const t8_element_t * elems,
+                                                          size_t count, int level,
+                                                          t8_linearidx_t * ids)
+{
+  const t8_dline_t *e = (const t8_dline_t *) elems;
+  size_t              ielem;
+
+  T8_ASSERT (0 <= level && level <= T8_DLINE_MAXLEVEL);
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    ids[ielem] = t8_dline_linear_id (e + ielem, level);
+  }
+}
+
+void
+t8_default_scheme_line_c::t8_element_vertex_coords_array (const t8_element_t * elems,
+                                                          size_t count, int vertex,
+                                                          int *coords)
+{
+  const t8_dline_t *e = (const t8_dline_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    t8_dline_vertex_coords (e + ielem, vertex,
+                            coords + T8_ECLASS_MAX_DIM * ielem);
+  }
+}
+
+int
+t8_default_scheme_line_c::t8_element_is_family_array (const t8_element_t * elems)
+{
+  const t8_dline_t *e = (const t8_dline_t *) elems;
+  const t8_dline_t *fam[T8_DLINE_CHILDREN];
+  int                 i;
+
+  for (i = 0; i < T8_DLINE_CHILDREN; i++) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + i)));
+    fam[i] = e + i;
+  }
+  return t8_dline_is_familypv (fam);
+}
+
+int
+t8_default_scheme_line_c::t8_element_face_neighbor_across_tree (const t8_element_t * elem,
+                                                                int face,
+                                                                t8_eclass_scheme_c * boundary_scheme,
+                                                                t8_eclass_scheme_c * neigh_scheme,
+                                                                const t8_element_face_transform_t * transform,
+                                                                t8_element_t * neigh)
+{
+  const t8_dline_t *l = (const t8_dline_t *) elem;
+  t8_dline_t *n = (t8_dline_t *) neigh;
+
+  if (neigh_scheme != this) {
+    /* The neighbor tree has a different class */
+    return t8_default_scheme_common_c::t8_element_face_neighbor_across_tree
+      (elem, face, boundary_scheme, neigh_scheme, transform, neigh);
+  }
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (neigh));
+  T8_ASSERT (0 <= face && face < T8_DLINE_FACES);
+  /* The boundary vertex carries only the level, we extrude it directly */
+  n->level = l->level;
+  n->x = transform->neigh_face == 0 ? 0
+    : T8_DLINE_ROOT_LEN - T8_DLINE_LEN (n->level);
+  return transform->neigh_face;
+}
+
 int
 t8_default_scheme_line_c::t8_element_root_len (const t8_element_t * elem)
 {
@@ -24,6 +24,7 @@
 #include "t8_default_prism_cxx.hxx"
 #include "t8_dprism_bits.h"
 #include "t8_dprism.h"
+#include "t8_dtri_bits.h"
 
 typedef t8_dprism_t t8_default_prism_t;
 
@@ -390,6 +391,98 @@ t8_default_scheme_prism_c::t8_element_vertex_coords (const t8_element_t * t,
   t8_dprism_vertex_coords ((const t8_dprism_t *) t, vertex, coords);
 }
 
+void
+t8_default_scheme_prism_c::t8_element_level_array (const t8_element_t * elems,
+                                                   size_t count, int *levels)
+{
+  const t8_dprism_t  *e = (const t8_dprism_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    levels[ielem] = t8_dprism_get_level (e + ielem);
+  }
+}
+
+void
+t8_default_scheme_prism_c::t8_element_child_id_array (const t8_element_t *
+                                                      elems, size_t count,
+                                                      int *child_ids)
+{
+  const t8_dprism_t  *e = (const t8_dprism_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    child_ids[ielem] = t8_dprism_child_id (e + ielem);
+  }
+}
+
+void
+t8_default_scheme_prism_c::t8_element_get_linear_id_array (const
+                                                           t8_element_t *
+                                                           elems,
+                                                           size_t count,
+                                                           int level,
+                                                           t8_linearidx_t *
+                                                           ids)
+{
+  const t8_dprism_t  *e = (const t8_dprism_t *) elems;
+  size_t              ielem;
+
+  T8_ASSERT (0 <= level && level <= T8_DPRISM_MAXLEVEL);
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    ids[ielem] = (t8_linearidx_t) t8_dprism_linear_id (e + ielem, level);
+  }
+}
+
+void
+t8_default_scheme_prism_c::t8_element_vertex_coords_array (const
+                                                           t8_element_t *
+                                                           elems,
+                                                           size_t count,
+                                                           int vertex,
+                                                           int *coords)
+{
+  const t8_dprism_t  *e = (const t8_dprism_t *) elems;
+  size_t              ielem;
+
+  T8_ASSERT (0 <= vertex && vertex < T8_DPRISM_CORNERS);
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    t8_dprism_vertex_coords (e + ielem, vertex,
+                             coords + T8_ECLASS_MAX_DIM * ielem);
+  }
+}
+
+int
+t8_default_scheme_prism_c::t8_element_is_family_array (const t8_element_t * elems)
+{
+  const t8_dprism_t *e = (const t8_dprism_t *) elems;
+  const t8_dprism_t *fam[T8_DPRISM_CHILDREN];
+  int                 i;
+
+  for (i = 0; i < T8_DPRISM_CHILDREN; i++) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + i)));
+    fam[i] = e + i;
+  }
+  return t8_dprism_is_familypv ((t8_dprism_t **) fam);
+}
+
+void
+t8_default_scheme_prism_c::t8_element_set_linear_id_range (t8_element_t * elems,
+                                                           size_t count, int level,
+                                                           t8_linearidx_t id)
+{
+  t8_dprism_t *e = (t8_dprism_t *) elems;
+
+  T8_ASSERT (0 <= level && level <= T8_DPRISM_MAXLEVEL);
+  t8_dprism_init_linear_id_range (e, level, id, count);
+}
+
 u_int64_t
   t8_default_scheme_prism_c::t8_element_get_linear_id (const t8_element_t *
                                                        elem, int level)
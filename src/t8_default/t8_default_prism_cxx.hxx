@@ -271,6 +271,37 @@ public:
   virtual void        t8_element_vertex_coords (const t8_element_t * t,
                                                 int vertex, int coords[]);
 
+  /** Compute the levels of an array of contiguous elements. */
+  virtual void        t8_element_level_array (const t8_element_t * elems,
+                                              size_t count, int *levels);
+
+  /** Compute the child ids of an array of contiguous elements. */
+  virtual void        t8_element_child_id_array (const t8_element_t * elems,
+                                                 size_t count,
+                                                 int *child_ids);
+
+  /** Compute the linear ids of an array of contiguous elements. */
+  virtual void        t8_element_get_linear_id_array (const t8_element_t *
+                                                      elems, size_t count,
+                                                      int level,
+                                                      t8_linearidx_t * ids);
+
+  /** Compute the coordinates of a vertex of an array of contiguous elements. */
+  virtual void        t8_element_vertex_coords_array (const t8_element_t *
+                                                      elems, size_t count,
+                                                      int vertex,
+                                                      int *coords);
+
+  /** Return true if the contiguous elements form a family. */
+  virtual int         t8_element_is_family_array (const t8_element_t *
+                                                  elems);
+
+  /** Initialize an array of contiguous elements with consecutive linear ids. */
+  virtual void        t8_element_set_linear_id_range (t8_element_t * elems,
+                                                      size_t count,
+                                                      int level,
+                                                      t8_linearidx_t id);
+
 #ifdef T8_ENABLE_DEBUG
   /** Query whether an element is valid */
   virtual int         t8_element_is_valid (const t8_element_t * t) const
@@ -759,6 +759,48 @@ t8_default_scheme_quad_c::t8_element_face_neighbor_inside (const t8_element_t
   return p4est_quadrant_is_inside_root (n);
 }
 
+int
+t8_default_scheme_quad_c::t8_element_half_face_neighbors_inside (const
+                                                                 t8_element_t
+                                                                 * elem,
+                                                                 int face,
+                                                                 t8_element_t
+                                                                 * neighs[],
+                                                                 int
+                                                                 num_neighs,
+                                                                 int
+                                                                 *dual_faces)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+  const p4est_qcoord_t shift = P4EST_QUADRANT_LEN (q->level + 1);
+  p4est_quadrant_t   *n;
+  p4est_qcoord_t      dx, dy;
+  int                 ineigh, child_id;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < P4EST_FACES);
+  T8_ASSERT (num_neighs == P4EST_HALF);
+  T8_ASSERT (q->level < P4EST_QMAXLEVEL);
+
+  /* The children at face are the face corners of q. The neighbor of
+   * each child is shifted by the child's length normal to the face. */
+  dx = face == 0 ? -shift : face == 1 ? shift : 0;
+  dy = face == 2 ? -shift : face == 3 ? shift : 0;
+  for (ineigh = 0; ineigh < P4EST_HALF; ineigh++) {
+    child_id = p4est_face_corners[face][ineigh];
+    n = (p4est_quadrant_t *) neighs[ineigh];
+    n->x = q->x + (child_id & 0x01 ? shift : 0) + dx;
+    n->y = q->y + (child_id & 0x02 ? shift : 0) + dy;
+    n->level = q->level + 1;
+    T8_QUAD_SET_TDIM (n, 2);
+    if (dual_faces != NULL) {
+      dual_faces[ineigh] = p4est_face_dual[face];
+    }
+  }
+  /* The neighbors are all inside or all outside of the root */
+  return p4est_quadrant_is_inside_root ((p4est_quadrant_t *) neighs[0]);
+}
+
 void
 t8_default_scheme_quad_c::t8_element_anchor (const t8_element_t * elem,
                                              int coord[3])
@@ -796,6 +838,133 @@ t8_default_scheme_quad_c::t8_element_vertex_coords (const t8_element_t * t,
   coords[1] = q1->y + (vertex & 2 ? 1 : 0) * len;
 }
 
+void
+t8_default_scheme_quad_c::t8_element_level_array (const t8_element_t * elems,
+                                                  size_t count, int *levels)
+{
+  const p4est_quadrant_t *e = (const p4est_quadrant_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    levels[ielem] = e[ielem].level;
+  }
+}
+
+void
+t8_default_scheme_quad_c::t8_element_child_id_array (const t8_element_t * elems,
+                                                     size_t count, int *child_ids)
+{
+  const p4est_quadrant_t *e = (const p4est_quadrant_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    child_ids[ielem] = p4est_quadrant_child_id (e + ielem);
+  }
+}
+
+void
+t8_default_scheme_quad_c::t8_element_get_linear_id_array (const t8_element_t * elems,
+                                                          size_t count, int level,
+                                                          t8_linearidx_t * ids)
+{
+  const p4est_quadrant_t *e = (const p4est_quadrant_t *) elems;
+  size_t              ielem;
+
+  T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    ids[ielem] = p4est_quadrant_linear_id (e + ielem, level);
+  }
+}
+
+void
+t8_default_scheme_quad_c::t8_element_vertex_coords_array (const t8_element_t * elems,
+                                                          size_t count, int vertex,
+                                                          int *coords)
+{
+  const p4est_quadrant_t *e = (const p4est_quadrant_t *) elems;
+  size_t              ielem;
+  int                 len;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    len = P4EST_QUADRANT_LEN (e[ielem].level);
+    coords[T8_ECLASS_MAX_DIM * ielem] = e[ielem].x + (vertex & 1 ? len : 0);
+    coords[T8_ECLASS_MAX_DIM * ielem + 1] =
+      e[ielem].y + (vertex & 2 ? len : 0);
+  }
+}
+
+int
+t8_default_scheme_quad_c::t8_element_is_family_array (const t8_element_t * elems)
+{
+  const p4est_quadrant_t *e = (const p4est_quadrant_t *) elems;
+
+#ifdef T8_ENABLE_DEBUG
+  int                 i;
+  for (i = 0; i < P4EST_CHILDREN; i++) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + i)));
+  }
+#endif
+  return p4est_quadrant_is_familyv (e);
+}
+
+int
+t8_default_scheme_quad_c::t8_element_face_neighbor_across_tree (const t8_element_t * elem,
+                                                                int face,
+                                                                t8_eclass_scheme_c * boundary_scheme,
+                                                                t8_eclass_scheme_c * neigh_scheme,
+                                                                const t8_element_face_transform_t * transform,
+                                                                t8_element_t * neigh)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+  p4est_quadrant_t   *n = (p4est_quadrant_t *) neigh;
+  p4est_qcoord_t      coord;
+
+  if (neigh_scheme != this) {
+    /* The neighbor tree has a different class */
+    return t8_default_scheme_common_c::t8_element_face_neighbor_across_tree
+      (elem, face, boundary_scheme, neigh_scheme, transform, neigh);
+  }
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (neigh));
+  T8_ASSERT (0 <= face && face < P4EST_FACES);
+  T8_ASSERT (P4EST_ROOT_LEN == T8_DLINE_ROOT_LEN);
+  /* The coordinate along the face, as in t8_element_boundary_face. Since
+   * the root lengths of quads and lines agree, we do not scale it. */
+  coord = face >> 1 ? q->x : q->y;
+  if (transform->orientation) {
+    /* The faces are connected in opposite directions */
+    coord = P4EST_ROOT_LEN - coord - P4EST_QUADRANT_LEN (q->level);
+  }
+  /* Extrude the face as in t8_element_extrude_face */
+  n->level = q->level;
+  switch (transform->neigh_face) {
+  case 0:
+    n->x = 0;
+    n->y = coord;
+    break;
+  case 1:
+    n->x = P4EST_LAST_OFFSET (n->level);
+    n->y = coord;
+    break;
+  case 2:
+    n->x = coord;
+    n->y = 0;
+    break;
+  case 3:
+    n->x = coord;
+    n->y = P4EST_LAST_OFFSET (n->level);
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  return transform->neigh_face;
+}
+
 void
 t8_default_scheme_quad_c::t8_element_new (int length, t8_element_t ** elem)
 {
@@ -261,6 +261,16 @@ public:
                                                        int face,
                                                        int *neigh_face);
 
+  /** Construct the face neighbors of the children of a quadrant at a
+   * face directly from its coordinates. */
+  virtual int         t8_element_half_face_neighbors_inside (const
+                                                             t8_element_t *
+                                                             elem, int face,
+                                                             t8_element_t *
+                                                             neighs[],
+                                                             int num_neighs,
+                                                             int *dual_faces);
+
 /** Initialize an element according to a given linear id */
   virtual void        t8_element_set_linear_id (t8_element_t * elem,
                                                 int level, t8_linearidx_t id);
@@ -301,6 +311,45 @@ public:
   virtual void        t8_element_vertex_coords (const t8_element_t * t,
                                                 int vertex, int coords[]);
 
+  /** Compute the levels of an array of contiguous elements. */
+  virtual void        t8_element_level_array (const t8_element_t * elems,
+                                              size_t count, int *levels);
+
+  /** Compute the child ids of an array of contiguous elements. */
+  virtual void        t8_element_child_id_array (const t8_element_t * elems,
+                                                 size_t count,
+                                                 int *child_ids);
+
+  /** Compute the linear ids of an array of contiguous elements. */
+  virtual void        t8_element_get_linear_id_array (const t8_element_t *
+                                                      elems, size_t count,
+                                                      int level,
+                                                      t8_linearidx_t * ids);
+
+  /** Compute the coordinates of a vertex of an array of contiguous elements. */
+  virtual void        t8_element_vertex_coords_array (const t8_element_t *
+                                                      elems, size_t count,
+                                                      int vertex,
+                                                      int *coords);
+
+  /** Return true if the contiguous elements form a family. */
+  virtual int         t8_element_is_family_array (const t8_element_t *
+                                                  elems);
+
+  /** Construct the face neighbor across a tree face in one step. */
+  virtual int         t8_element_face_neighbor_across_tree (const
+                                                            t8_element_t *
+                                                            elem, int face,
+                                                            t8_eclass_scheme_c
+                                                            * boundary_scheme,
+                                                            t8_eclass_scheme_c
+                                                            * neigh_scheme,
+                                                            const
+                                                            t8_element_face_transform_t
+                                                            * transform,
+                                                            t8_element_t *
+                                                            neigh);
+
 #ifdef T8_ENABLE_DEBUG
   /** Query whether an element is valid */
   virtual int         t8_element_is_valid (const t8_element_t * t) const;
@@ -293,6 +293,77 @@ t8_default_scheme_vertex_c::t8_element_vertex_coords (const t8_element_t *
   t8_dvertex_vertex_coords ((const t8_dvertex_t *) elem, vertex, coords);
 }
 
+void
+t8_default_scheme_vertex_c::t8_element_level_array (const t8_element_t * elems,
+                                                    size_t count, int *levels)
+{
+  const t8_dvertex_t *e = (const t8_dvertex_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    levels[ielem] = t8_dvertex_get_level (e + ielem);
+  }
+}
+
+void
+t8_default_scheme_vertex_c::t8_element_child_id_array (const t8_element_t * elems,
+                                                       size_t count, int *child_ids)
+{
+  const t8_dvertex_t *e = (const t8_dvertex_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    child_ids[ielem] = t8_dvertex_child_id (e + ielem);
+  }
+}
+
+void
+t8_default_scheme_vertex_c::t8_element_get_linear_id_array (const t8_element_t * elems,
+                                                            size_t count, int level,
+                                                            t8_linearidx_t * ids)
+{
+  const t8_dvertex_t *e = (const t8_dvertex_t *) elems;
+  size_t              ielem;
+
+  T8_ASSERT (0 <= level && level <= T8_DVERTEX_MAXLEVEL);
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    ids[ielem] = t8_dvertex_linear_id (e + ielem, level);
+  }
+}
+
+void
+t8_default_scheme_vertex_c::t8_element_vertex_coords_array (const t8_element_t * elems,
+                                                            size_t count, int vertex,
+                                                            int *coords)
+{
+  const t8_dvertex_t *e = (const t8_dvertex_t *) elems;
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + ielem)));
+    t8_dvertex_vertex_coords (e + ielem, vertex,
+                              coords + T8_ECLASS_MAX_DIM * ielem);
+  }
+}
+
+int
+t8_default_scheme_vertex_c::t8_element_is_family_array (const t8_element_t * elems)
+{
+  const t8_dvertex_t *e = (const t8_dvertex_t *) elems;
+  const t8_dvertex_t *fam[T8_DVERTEX_CHILDREN];
+  int                 i;
+
+  for (i = 0; i < T8_DVERTEX_CHILDREN; i++) {
+    T8_ASSERT (t8_element_is_valid ((const t8_element_t *) (e + i)));
+    fam[i] = e + i;
+  }
+  return t8_dvertex_is_familypv (fam);
+}
+
 #ifdef T8_ENABLE_DEBUG
 /* *INDENT-OFF* */
 /* indent bug, indent adds a second "const" modifier */
@@ -38,8 +38,14 @@
 /** The number of children at a face of a line. */
 #define T8_DLINE_FACE_CHILDREN 1
 
-/** The maximum refinement level allowed for a line. */
+/** The maximum refinement level allowed for a line.
+ *  With --enable-short-coords the coordinates are 16 bit wide and
+ *  the maximum level is lowered accordingly. */
+#ifndef T8_ENABLE_SHORT_COORDS
 #define T8_DLINE_MAXLEVEL 30
+#else
+#define T8_DLINE_MAXLEVEL 14
+#endif
 
 /** The length of the root line in integer coordinates. */
 #define T8_DLINE_ROOT_LEN (1 << (T8_DLINE_MAXLEVEL))
@@ -47,7 +53,11 @@
 /** The length of a line at a given level in integer coordinates. */
 #define T8_DLINE_LEN(l) (1 << (T8_DLINE_MAXLEVEL - (l)))
 
+#ifndef T8_ENABLE_SHORT_COORDS
 typedef int32_t     t8_dline_coord_t;
+#else
+typedef int16_t     t8_dline_coord_t;
+#endif
 
 typedef struct t8_dline
 {
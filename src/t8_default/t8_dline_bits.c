@@ -21,6 +21,7 @@
 */
 
 #include "t8_dline_bits.h"
+#include "t8_default_device.h"
 
 int
 t8_dline_get_level (const t8_dline_t * l)
@@ -55,17 +56,9 @@ t8_dline_compare (const t8_dline_t * l1, const t8_dline_t * l2)
 void
 t8_dline_parent (const t8_dline_t * l, t8_dline_t * parent)
 {
-  t8_dline_coord_t    h;
-
   T8_ASSERT (l->level > 0);
 
-  /* Get the length of l */
-  h = T8_DLINE_LEN (l->level);
-
-  /* Set coordinates of parent */
-  parent->x = l->x & ~h;
-  /* Set the parent's level */
-  parent->level = l->level - 1;
+  t8_device_line_parent (l, parent);
 }
 
 void
@@ -100,20 +93,14 @@ void
 t8_dline_face_neighbour (const t8_dline_t * l, t8_dline_t * neigh,
                          int face, int *dual_face)
 {
+  int                 neigh_face;
+
   T8_ASSERT (0 <= face && face < T8_DLINE_FACES);
 
-  neigh->level = l->level;
-  switch (face) {
-  case 0:
-    neigh->x = l->x - T8_DLINE_LEN (l->level);
-    break;
-  case 1:
-    neigh->x = l->x + T8_DLINE_LEN (l->level);
-    break;
-  }
+  neigh_face = t8_device_line_face_neighbor (l, face, neigh);
   if (dual_face != NULL) {
     /* The dual face is 1 if face=0 and 0 if face=1 */
-    *dual_face = 1 - face;
+    *dual_face = neigh_face;
   }
 }
 
@@ -172,8 +159,7 @@ int
 t8_dline_child_id (const t8_dline_t * elem)
 {
   T8_ASSERT (elem->level < T8_DLINE_MAXLEVEL);
-  /* bitshifting the Levelbit to first position & check if it is 1 or 0 */
-  return ((elem->x >> (T8_DLINE_MAXLEVEL - elem->level)) & 1);
+  return t8_device_line_child_id (elem);
 }
 
 void
@@ -246,7 +232,7 @@ t8_dline_is_root_boundary (const t8_dline_t * p, int face)
 int
 t8_dline_is_inside_root (const t8_dline_t * l)
 {
-  return (l->x >= 0 && l->x < T8_DLINE_ROOT_LEN);
+  return t8_device_line_is_inside_root (l);
 }
 
 void
@@ -329,25 +315,15 @@ void
 t8_dline_vertex_coords (const t8_dline_t * elem, int vertex, int coords[])
 {
   T8_ASSERT (vertex == 0 || vertex == 1);
-  if (vertex == 0) {
-    coords[0] = elem->x;
-  }
-  if (vertex == 1) {
-    coords[0] = elem->x + T8_DLINE_LEN (elem->level);
-  }
+  t8_device_line_vertex_coords (elem, vertex, coords);
 }
 
 t8_linearidx_t
 t8_dline_linear_id (const t8_dline_t * elem, int level)
 {
-  t8_linearidx_t      id;
-
   T8_ASSERT (level <= T8_DLINE_MAXLEVEL && level >= 0);
 
-  /* this preserves the high bits from negative numbers */
-  id = elem->x >> (T8_DLINE_MAXLEVEL - level);
-
-  return id;
+  return t8_device_line_linear_id (elem, level);
 }
 
 int
@@ -40,8 +40,13 @@
 /** The number of corners of a triangle */
 #define T8_DPRISM_CORNERS 6
 
-/** The maximum refinement level allowed for a prism. */
+/** The maximum refinement level allowed for a prism.
+ *  Must be smaller or equal to T8_DTRI_MAXLEVEL and T8_DLINE_MAXLEVEL. */
+#ifndef T8_ENABLE_SHORT_COORDS
 #define T8_DPRISM_MAXLEVEL 21
+#else
+#define T8_DPRISM_MAXLEVEL 13
+#endif
 
 /** The length of the root prism in integer coordinates. */
 #define T8_DPRISM_ROOT_LEN (1 << (T8_DPRISM_MAXLEVEL))
@@ -61,7 +66,11 @@
  *  This is useful to convert boundary coordinates from prism to triangle. */
 #define T8_DPRISM_ROOT_BY_DLINE_ROOT (1 << (T8_DLINE_MAXLEVEL - T8_DPRISM_MAXLEVEL))
 
+#ifndef T8_ENABLE_SHORT_COORDS
 typedef int32_t     t8_dprism_coord_t;
+#else
+typedef int16_t     t8_dprism_coord_t;
+#endif
 
 typedef struct t8_dprism
 {
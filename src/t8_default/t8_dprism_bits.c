@@ -76,30 +76,22 @@ t8_dprism_init_linear_id (t8_dprism_t * p, int level, uint64_t id)
 {
   uint64_t            tri_id = 0;
   uint64_t            line_id = 0;
+  uint64_t            local_id;
   int                 i;
-  int                 triangles_of_size_i = 1;
 
   T8_ASSERT (0 <= level && level <= T8_DPRISM_MAXLEVEL);
   T8_ASSERT (id < sc_intpow64u (T8_DPRISM_CHILDREN, level));
 
-  for (i = 0; i <= level; i++) {
-    /*Get the number of the i-th prism and get the related triangle number
-     * then multiplicate it by the number of triangles of level size.*/
-    tri_id += (id % T8_DTRI_CHILDREN) * triangles_of_size_i;
-
-    /*If id % 8 is larger than 3, the prism is in the upper part of the
-     * parent prism. => line_id + 2^i*/
-    line_id +=
-      (id % T8_DPRISM_CHILDREN) / T8_DTRI_CHILDREN *
-      sc_intpow64u (T8_DLINE_CHILDREN, i);
-
-    /*Each Prism divides into 8 children */
-    id /= T8_DPRISM_CHILDREN;
-    /*Each triangle divides into 4 children */
-    triangles_of_size_i *= T8_DTRI_CHILDREN;
+  /* Split the three bits per level of the prism id into the two bits
+   * of the triangle id and the bit of the line id, see t8_dprism_linear_id */
+  for (i = 0; i < level; i++) {
+    local_id = (id >> (3 * i)) & 7;
+    tri_id |= (local_id & 3) << (2 * i);
+    line_id |= (local_id >> 2) << i;
   }
   t8_dtri_init_linear_id (&p->tri, tri_id, level);
-  t8_dline_init_linear_id (&p->line, level, line_id);
+  p->line.level = level;
+  p->line.x = line_id << (T8_DLINE_MAXLEVEL - level);
 
   T8_ASSERT (p->line.level == p->tri.level);
 }
@@ -282,8 +274,10 @@ t8_dprism_face_neighbour (const t8_dprism_t * p, int face,
                           t8_dprism_t * neigh)
 {
   T8_ASSERT (0 <= face && face < T8_DPRISM_FACES);
+  T8_ASSERT (p->line.level == p->tri.level);
+
   if (face < 3) {
-    t8_dline_copy (&p->line, &neigh->line);
+    neigh->line = p->line;
     t8_dtri_face_neighbour (&p->tri, face, &neigh->tri);
     /* face neighbors face number:
      *  0 -> 2
@@ -291,16 +285,13 @@ t8_dprism_face_neighbour (const t8_dprism_t * p, int face,
      *  2 -> 0 */
     return 2 - face;
   }
-  else if (face == 3) {
-    t8_dtri_copy (&p->tri, &neigh->tri);
-    t8_dline_face_neighbour (&p->line, &neigh->line, 0, NULL);
-    return 4;
-  }
-  else {
-    t8_dtri_copy (&p->tri, &neigh->tri);
-    t8_dline_face_neighbour (&p->line, &neigh->line, 1, NULL);
-    return 3;
-  }
+  /* The neighbor at the bottom (face 3) or top (face 4) has the same
+   * triangle and its line is shifted by its length. */
+  neigh->tri = p->tri;
+  neigh->line.level = p->line.level;
+  neigh->line.x = p->line.x + (face == 3 ? -1 : 1)
+    * T8_DLINE_LEN (p->line.level);
+  return face == 3 ? 4 : 3;
 }
 
 int
@@ -317,12 +308,33 @@ t8_dprism_get_face_corner (const t8_dprism_t * p, int face, int corner)
 void
 t8_dprism_childrenpv (const t8_dprism_t * p, int length, t8_dprism_t * c[])
 {
+  t8_dtri_t          *tri_children[T8_DTRI_CHILDREN];
+  t8_dtri_t           tri;
+  t8_dline_coord_t    line_x, h;
+  int8_t              level;
   int                 i;
+
   T8_ASSERT (length == T8_DPRISM_CHILDREN);
   T8_ASSERT (p->line.level < T8_DPRISM_MAXLEVEL &&
              p->tri.level == p->line.level);
-  for (i = 7; i >= 0; i--) {
-    t8_dprism_child (p, i, c[i]);
+
+  /* We copy the data of p, since p may be c[0] */
+  tri = p->tri;
+  line_x = p->line.x;
+  level = p->line.level + 1;
+  h = T8_DLINE_LEN (level);
+  /* The triangles of the children 0 to 3 are the children of p's triangle,
+   * the children 4 to 7 have the same triangles one plane up. */
+  for (i = 0; i < T8_DTRI_CHILDREN; i++) {
+    tri_children[i] = &c[i]->tri;
+  }
+  t8_dtri_childrenpv (&tri, tri_children);
+  for (i = 0; i < T8_DTRI_CHILDREN; i++) {
+    c[i]->line.x = line_x;
+    c[i]->line.level = level;
+    c[i + T8_DTRI_CHILDREN]->tri = c[i]->tri;
+    c[i + T8_DTRI_CHILDREN]->line.x = line_x + h;
+    c[i + T8_DTRI_CHILDREN]->line.level = level;
   }
 }
 
@@ -461,46 +473,65 @@ t8_dprism_extrude_face (const t8_element_t * face,
 void
 t8_dprism_successor (const t8_dprism_t * p, t8_dprism_t * succ, int level)
 {
-  int                 prism_child_id;
-  t8_dprism_copy (p, succ);
+  int                 tri_child_id, line_child_id;
+
+  T8_ASSERT (1 <= level && level <= T8_DPRISM_MAXLEVEL);
+  T8_ASSERT (p->line.level == p->tri.level);
+
+  *succ = *p;
   /*update the level */
   succ->line.level = level;
   succ->tri.level = level;
-  prism_child_id = t8_dprism_child_id (succ);
-  T8_ASSERT (1 <= level && level <= T8_DPRISM_MAXLEVEL);
-  T8_ASSERT (p->line.level == p->tri.level);
-  /*The next prism is the child with local ID 0 of the next parent prism */
-  if (prism_child_id == T8_DPRISM_CHILDREN - 1) {
+  tri_child_id = t8_dtri_child_id (&succ->tri);
+  line_child_id = (succ->line.x >> (T8_DLINE_MAXLEVEL - level)) & 1;
+  if (tri_child_id < T8_DTRI_CHILDREN - 1) {
+    /*The next Prism is in the same plane, but has the next base-triangle */
+    t8_dtri_successor (&p->tri, &succ->tri, level);
+  }
+  else if (line_child_id == 0) {
+    /*The next prism is one plane up, local_tri_id = 0.
+     * This is the first child of the triangle's parent. */
+    t8_dtri_parent (&succ->tri, &succ->tri);
+    t8_dtri_child (&succ->tri, 0, &succ->tri);
+    succ->line.x |= T8_DLINE_LEN (level);
+  }
+  else {
+    /*The next prism is the child with local ID 0 of the next parent prism */
     t8_dprism_successor (p, succ, level - 1);
     /*Zero out the bits of higher level, caused by recursion */
-#if 1
     succ->tri.x =
       (succ->tri.x >> (T8_DTRI_MAXLEVEL - level + 1)) << (T8_DTRI_MAXLEVEL -
                                                           level + 1);
     succ->tri.y =
       (succ->tri.y >> (T8_DTRI_MAXLEVEL - level + 1)) << (T8_DTRI_MAXLEVEL -
                                                           level + 1);
-#endif
-#if 1
     succ->line.x =
       (succ->line.x >> (T8_DLINE_MAXLEVEL - level + 1)) <<
       (T8_DLINE_MAXLEVEL - level + 1);
-#endif
     /*Set the level to the actual level */
     succ->line.level = level;
     succ->tri.level = level;
   }
-  /*The next prism is one plane up, local_tri_id = 0 */
-  else if ((prism_child_id + 1) % T8_DTRI_CHILDREN == 0) {
-    /*parent is computed with succ, cause there are the updated datas */
-    t8_dprism_parent (succ, succ);
-    t8_dprism_child (succ, prism_child_id + 1, succ);
+  T8_ASSERT (succ->line.level == succ->tri.level);
+}
+
+void
+t8_dprism_init_linear_id_range (t8_dprism_t * p, int level, uint64_t id,
+                                size_t count)
+{
+  size_t              ielem;
+
+  T8_ASSERT (0 <= level && level <= T8_DPRISM_MAXLEVEL);
+  if (count == 0) {
+    return;
   }
-  /*The next Prism is in the same plane, but has the next base-triangle */
-  else {
-    t8_dtri_successor (&p->tri, &succ->tri, level);
+  T8_ASSERT (id + count <= sc_intpow64u (T8_DPRISM_CHILDREN, level));
+  t8_dprism_init_linear_id (p, level, id);
+  /* The successor is amortized constant time, since only every
+   * T8_DPRISM_CHILDREN-th prism is a last child. */
+  for (ielem = 1; ielem < count; ++ielem) {
+    t8_dprism_successor (p + ielem - 1, p + ielem, level);
   }
-  T8_ASSERT (succ->line.level == succ->tri.level);
 }
 
 void
@@ -571,44 +602,19 @@ t8_dprism_linear_id (const t8_dprism_t * p, int level)
   uint64_t            tri_id;
   uint64_t            line_id;
   int                 i;
-  uint64_t            prisms_of_size_i = 1;
-  /*line_level = Num_of_Line_children ^ (level - 1) */
-  uint64_t            line_level;
-  /*prism_shift = Num_of_Prism_children / Num_of_line-Children * 8 ^ (level - 1) */
-  uint64_t            prism_shift;
+
   T8_ASSERT (0 <= level && level <= T8_DPRISM_MAXLEVEL);
   T8_ASSERT (p->line.level == p->tri.level);
-  /*id = 0 for root element */
-  if (level == 0) {
-    return 0;
-  }
 
-  line_level = sc_intpow64u (T8_DLINE_CHILDREN, level - 1);
-  /* *INDENT-OFF* */
-  prism_shift =
-    (T8_DPRISM_CHILDREN / T8_DLINE_CHILDREN) *
-    sc_intpow64u (T8_DPRISM_CHILDREN, level - 1);
-  /* *INDENT-ON* */
+  /* The local index of a prism in its parent is the local index of its
+   * triangle plus T8_DTRI_CHILDREN times the child id of its line.
+   * Thus the prism id interleaves the two bits per level of the triangle
+   * id with the bit per level of the line id. */
   tri_id = t8_dtri_linear_id (&p->tri, level);
-  line_id = t8_dline_linear_id (&p->line, level);
+  line_id = p->line.x >> (T8_DLINE_MAXLEVEL - level);
   for (i = 0; i < level; i++) {
-    /*Compute via getting the local id of each ancestor triangle in which
-     *elem->tri lies, the prism id, that elem would have, if it lies on the
-     * lowest plane of the prism of level 0 */
-    id += (tri_id % T8_DTRI_CHILDREN) * prisms_of_size_i;
-    tri_id /= T8_DTRI_CHILDREN;
-    prisms_of_size_i *= T8_DPRISM_CHILDREN;
+    id |= ((tri_id >> (2 * i)) & 3) << (3 * i)
+      | ((line_id >> i) & 1) << (3 * i + 2);
   }
-  /*Now add the actual plane in which the prism is, which is computed via
-   * line_id*/
-  for (i = level - 1; i >= 0; i--) {
-    /*The number to add to the id computed via the tri_id is 4*8^(level-i)
-     *for each plane in a prism of size i*/
-    id += line_id / line_level * prism_shift;
-    line_id = (uint64_t) (line_id % line_level);
-    prism_shift /= T8_DPRISM_CHILDREN;
-    line_level /= T8_DLINE_CHILDREN;
-  }
-
   return id;
 }
@@ -73,6 +73,17 @@ void                t8_dprism_init_linear_id (t8_dprism_t * p, int level,
 void                t8_dprism_successor (const t8_dprism_t * p,
                                          t8_dprism_t * succ, int level);
 
+/** Initialize an array of prisms as the prisms with consecutive ids
+ *  in a uniform refinement of a given level.
+ * \param [in,out] p  Array of at least \a count existing prisms.
+ * \param [in] level  level of uniform grid to be considered.
+ * \param [in] id     The id of the first prism.
+ * \param [in] count  The number of prisms.
+ */
+void                t8_dprism_init_linear_id_range (t8_dprism_t * p,
+                                                    int level, uint64_t id,
+                                                    size_t count);
+
 /** Compute the parent of a prism.
  * \param [in]  p Input prism.
  * \param [in,out] parent Existing prism whose data will
@@ -45,7 +45,11 @@
 
 /** The maximum refinement level allowed for a tetrahedron.
  *  Must be smaller or equal to T8_DTRI_MAXLEVEL. */
+#ifndef T8_ENABLE_SHORT_COORDS
 #define T8_DTET_MAXLEVEL 21
+#else
+#define T8_DTET_MAXLEVEL 13
+#endif
 
 /** The length of the root tetrahedron in integer coordinates. */
 #define T8_DTET_ROOT_LEN (1 << (T8_DTET_MAXLEVEL))
@@ -64,7 +68,11 @@
 typedef int8_t      t8_dtet_type_t;
 
 /** The coordinates of a tetrahedron are integers relative to the maximum refinement. */
+#ifndef T8_ENABLE_SHORT_COORDS
 typedef int32_t     t8_dtet_coord_t;
+#else
+typedef int16_t     t8_dtet_coord_t;
+#endif
 
 /** This data type stores a tetrahedron. */
 typedef struct t8_dtet
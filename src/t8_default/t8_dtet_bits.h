@@ -276,6 +276,17 @@ void                t8_dtet_init_root (t8_dtet_t * t);
 void                t8_dtet_successor (const t8_dtet_t * t, t8_dtet_t * s,
                                        int level);
 
+/** Initialize an array of tetrahedra as the tetrahedra with consecutive ids
+ *  in a uniform refinement of a given level.
+ * \param [in,out] t  Array of at least \a count existing tetrahedra.
+ * \param [in] id     The id of the first tetrahedron.
+ * \param [in] level  level of uniform grid to be considered.
+ * \param [in] count  The number of tetrahedra.
+ */
+void                t8_dtet_init_linear_id_range (t8_dtet_t * t,
+                                                  t8_linearidx_t id,
+                                                  int level, size_t count);
+
 /** Compute the first descendant of a tetrahedron at a given level. This is the descendant of
  * the tetrahedron in a uniform maxlevel refinement that has the smaller id.
  * \param [in] t        tetrahedron whose descendant is computed.
@@ -43,8 +43,13 @@ T8_EXTERN_C_BEGIN ();
 /** The number of corners of a triangle */
 #define T8_DTRI_CORNERS 3
 
-/** The maximum refinement level allowed for a triangle. */
+/** The maximum refinement level allowed for a triangle.
+ *  Must be smaller or equal to T8_DLINE_MAXLEVEL. */
+#ifndef T8_ENABLE_SHORT_COORDS
 #define T8_DTRI_MAXLEVEL 29
+#else
+#define T8_DTRI_MAXLEVEL 13
+#endif
 
 /** The length of the root triangle in integer coordinates. */
 #define T8_DTRI_ROOT_LEN (1 << (T8_DTRI_MAXLEVEL))
@@ -60,7 +65,11 @@ T8_EXTERN_C_BEGIN ();
 #define T8_DLINE_ROOT_BY_DTRI_ROOT (1 << (T8_DLINE_MAXLEVEL - T8_DTRI_MAXLEVEL))
 
 typedef int8_t      t8_dtri_type_t;
+#ifndef T8_ENABLE_SHORT_COORDS
 typedef int32_t     t8_dtri_coord_t;
+#else
+typedef int16_t     t8_dtri_coord_t;
+#endif
 
 typedef struct t8_dtri
 {
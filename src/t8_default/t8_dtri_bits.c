@@ -442,60 +442,117 @@ t8_dtri_child (const t8_dtri_t * t, int childid, t8_dtri_t * child)
   c->level = t->level + 1;
 }
 
+/* For a parent of type type and a child index (Morton order),
+ * t8_dtri_children_offset stores for each coordinate whether the anchor
+ * of the child is shifted by the length of the child relative to the
+ * anchor of the parent, and t8_dtri_children_type stores the type of the child.
+ * Thus all children can be computed without branches or per child
+ * coordinate computations.
+ * The tables follow from the Bey tables: The offset of a child is 0 for the
+ * Bey child 0 and otherwise the coordinates of the vertex
+ * t8_dtri_beyid_to_vertex of its Bey number of a parent at level
+ * T8_DTRI_MAXLEVEL with anchor 0, and its type is t8_dtri_type_of_child.
+ * Since they are constant, they can be read by any thread at any time. */
+#ifndef T8_DTRI_TO_DTET
+static const t8_dtri_coord_t
+  t8_dtri_children_offset[T8_DTRI_NUM_TYPES][T8_DTRI_DIM][T8_DTRI_CHILDREN] =
+{
+  {{0, 1, 1, 1}, {0, 0, 0, 1}},
+  {{0, 0, 0, 1}, {0, 1, 1, 1}}
+};
+
+static const t8_dtri_type_t
+  t8_dtri_children_type[T8_DTRI_NUM_TYPES][T8_DTRI_CHILDREN] = {
+  {0, 0, 1, 0},
+  {1, 0, 1, 1}
+};
+#else
+static const t8_dtri_coord_t
+  t8_dtri_children_offset[T8_DTRI_NUM_TYPES][T8_DTRI_DIM][T8_DTRI_CHILDREN] =
+{
+  {{0, 1, 1, 1, 1, 1, 1, 1}, {0, 0, 0, 0, 0, 0, 0, 1},
+   {0, 0, 0, 0, 1, 1, 1, 1}},
+  {{0, 1, 1, 1, 1, 1, 1, 1}, {0, 0, 0, 0, 1, 1, 1, 1},
+   {0, 0, 0, 0, 0, 0, 0, 1}},
+  {{0, 0, 0, 0, 1, 1, 1, 1}, {0, 1, 1, 1, 1, 1, 1, 1},
+   {0, 0, 0, 0, 0, 0, 0, 1}},
+  {{0, 0, 0, 0, 0, 0, 0, 1}, {0, 1, 1, 1, 1, 1, 1, 1},
+   {0, 0, 0, 0, 1, 1, 1, 1}},
+  {{0, 0, 0, 0, 0, 0, 0, 1}, {0, 0, 0, 0, 1, 1, 1, 1},
+   {0, 1, 1, 1, 1, 1, 1, 1}},
+  {{0, 0, 0, 0, 1, 1, 1, 1}, {0, 0, 0, 0, 0, 0, 0, 1},
+   {0, 1, 1, 1, 1, 1, 1, 1}}
+};
+
+static const t8_dtri_type_t
+  t8_dtri_children_type[T8_DTRI_NUM_TYPES][T8_DTRI_CHILDREN] = {
+  {0, 0, 4, 5, 0, 1, 2, 0},
+  {1, 1, 2, 3, 0, 1, 5, 1},
+  {2, 0, 1, 2, 2, 3, 4, 2},
+  {3, 3, 4, 5, 1, 2, 3, 3},
+  {4, 2, 3, 4, 0, 4, 5, 4},
+  {5, 0, 1, 5, 3, 4, 5, 5}
+};
+#endif /* T8_DTRI_TO_DTET */
+
 void
 t8_dtri_childrenpv (const t8_dtri_t * t, t8_dtri_t * c[T8_DTRI_CHILDREN])
 {
-  t8_dtri_coord_t     t_coordinates[T8_DTRI_FACES][T8_DTRI_DIM];
+  /* We copy the values of t, since the function must be valid
+   * if called with t = c[0]. */
+  const t8_dtri_coord_t x = t->x;
+  const t8_dtri_coord_t y = t->y;
+#ifdef T8_DTRI_TO_DTET
+  const t8_dtri_coord_t z = t->z;
+#endif
+  const t8_dtri_type_t t_type = t->type;
   const int8_t        level = t->level + 1;
+  const t8_dtri_coord_t h = T8_DTRI_LEN (level);
+  const t8_dtri_coord_t *offset_x, *offset_y;
+#ifdef T8_DTRI_TO_DTET
+  const t8_dtri_coord_t *offset_z;
+#endif
+  const t8_dtri_type_t *child_type;
   int                 i;
-  int                 Bey_cid;
-  int                 vertex;
-  t8_dtri_type_t      t_type = t->type;
 
   T8_ASSERT (t->level < T8_DTRI_MAXLEVEL);
-  t8_dtri_compute_all_coords (t, t_coordinates);
-  /* We use t_coordinates[0] for t->x,y,z to ensure that the function is valid
-   * if called with t = c[0]. If we would use t->x later it would be the newly
-   * computed value c[0]->x. */
-  c[0]->x = t_coordinates[0][0];        /* t->x */
-  c[0]->y = t_coordinates[0][1];        /* t->y */
+  offset_x = t8_dtri_children_offset[t_type][0];
+  offset_y = t8_dtri_children_offset[t_type][1];
 #ifdef T8_DTRI_TO_DTET
-  c[0]->z = t_coordinates[0][2];        /* t->z */
-#endif
-  c[0]->type = t_type;
-  c[0]->level = level;
-  for (i = 1; i < T8_DTRI_CHILDREN; i++) {
-    Bey_cid = t8_dtri_index_to_bey_number[t_type][i];
-    vertex = t8_dtri_beyid_to_vertex[Bey_cid];
-    /* i-th anchor coordinate of child is (X_(0,i)+X_(vertex,i))/2
-     * where X_(i,j) is the j-th coordinate of t's ith node */
-    c[i]->x = (t_coordinates[0][0] + t_coordinates[vertex][0]) >> 1;
-    c[i]->y = (t_coordinates[0][1] + t_coordinates[vertex][1]) >> 1;
+  offset_z = t8_dtri_children_offset[t_type][2];
+#endif
+  child_type = t8_dtri_children_type[t_type];
+  /* The loop body has no branches and the offsets of each coordinate are
+   * contiguous, such that the compiler may vectorize it. */
+  for (i = 0; i < T8_DTRI_CHILDREN; i++) {
+    c[i]->x = x + offset_x[i] * h;
+    c[i]->y = y + offset_y[i] * h;
 #ifdef T8_DTRI_TO_DTET
-    c[i]->z = (t_coordinates[0][2] + t_coordinates[vertex][2]) >> 1;
+    c[i]->z = z + offset_z[i] * h;
 #endif
-    c[i]->type = t8_dtri_type_of_child[t_type][Bey_cid];
+    c[i]->type = child_type[i];
     c[i]->level = level;
+  }
 #ifdef T8_ENABLE_DEBUG
-    {
-      /* We check whether the child computed here equals to the child
-       * computed in the t8_dtri_child function. */
-      t8_dtri_t           check_child;
-      /* We use c[0] here instead of t, since we explicitly allow t=c[0] as input
-       * and thus the values of t may be already overwritten. However the only
-       * difference from c[0] to t is in the level. */
-      c[0]->level--;
-      t8_dtri_child (c[0], i, &check_child);
-      T8_ASSERT (check_child.x == c[i]->x && check_child.y == c[i]->y);
-      T8_ASSERT (check_child.type == c[i]->type
-                 && check_child.level == c[i]->level);
+  for (i = 1; i < T8_DTRI_CHILDREN; i++) {
+    /* We check whether the child computed here equals to the child
+     * computed in the t8_dtri_child function. */
+    t8_dtri_t           check_child;
+    /* We use c[0] here instead of t, since we explicitly allow t=c[0] as input
+     * and thus the values of t may be already overwritten. However the only
+     * difference from c[0] to t is in the level. */
+    T8_ASSERT (c[0]->type == t_type);
+    c[0]->level--;
+    t8_dtri_child (c[0], i, &check_child);
+    T8_ASSERT (check_child.x == c[i]->x && check_child.y == c[i]->y);
+    T8_ASSERT (check_child.type == c[i]->type
+               && check_child.level == c[i]->level);
 #ifdef T8_DTRI_TO_DTET
-      T8_ASSERT (check_child.z == c[i]->z);
-#endif
-      c[0]->level++;
-    }
+    T8_ASSERT (check_child.z == c[i]->z);
 #endif
+    c[0]->level++;
   }
+#endif
 }
 
 #ifndef T8_DTRI_TO_DTET
@@ -1318,8 +1375,211 @@ t8_dtri_linear_id_corner_desc (const t8_dtri_t * t, int corner, int level)
   return id;
 }
 
-t8_linearidx_t
-t8_dtri_linear_id (const t8_dtri_t * t, int level)
+/* We compute the linear id and its inverse two levels at a time.
+ * For the type of an ancestor at level i and the cube-ids of the ancestors
+ * at level i and i - 1, stored as cid_i | cid_{i-1} << T8_DTRI_DIM,
+ * t8_dtri_two_level_Iloc stores the local indices Iloc_i | Iloc_{i-1} << T8_DTRI_DIM
+ * and t8_dtri_two_level_parenttype the type of the ancestor at level i - 2.
+ * For the type of an ancestor at level i and the local indices of the
+ * descendants at level i + 1 and i + 2, stored as Iloc_{i+2} | Iloc_{i+1} << T8_DTRI_DIM,
+ * t8_dtri_two_level_cid stores the cube-ids cid_{i+2} | cid_{i+1} << T8_DTRI_DIM
+ * and t8_dtri_two_level_type the type of the descendant at level i + 2.
+ * The tables are composed of two steps of t8_dtri_type_cid_to_Iloc and
+ * t8_dtri_cid_type_to_parenttype, respectively of
+ * t8_dtri_parenttype_Iloc_to_cid and t8_dtri_parenttype_Iloc_to_type. */
+#define T8_DTRI_TWO_LEVEL_ENTRIES (T8_DTRI_CHILDREN * T8_DTRI_CHILDREN)
+#ifndef T8_DTRI_TO_DTET
+static const int8_t
+  t8_dtri_two_level_Iloc[T8_DTRI_NUM_TYPES][T8_DTRI_TWO_LEVEL_ENTRIES] =
+{
+  {0, 1, 1, 3, 4, 5, 9, 7, 4, 5, 9, 7, 12, 13, 13, 15},
+  {0, 2, 2, 3, 8, 6, 10, 11, 8, 6, 10, 11, 12, 14, 14, 15}
+};
+
+static const int8_t
+  t8_dtri_two_level_parenttype[T8_DTRI_NUM_TYPES][T8_DTRI_TWO_LEVEL_ENTRIES] =
+{
+  {0, 0, 1, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 0},
+  {1, 0, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 1, 1}
+};
+
+static const int8_t
+  t8_dtri_two_level_cid[T8_DTRI_NUM_TYPES][T8_DTRI_TWO_LEVEL_ENTRIES] =
+{
+  {0, 1, 1, 3, 4, 5, 5, 7, 4, 6, 6, 7, 12, 13, 13, 15},
+  {0, 2, 2, 3, 8, 9, 9, 11, 8, 10, 10, 11, 12, 14, 14, 15}
+};
+
+static const int8_t
+  t8_dtri_two_level_type[T8_DTRI_NUM_TYPES][T8_DTRI_TWO_LEVEL_ENTRIES] =
+{
+  {0, 0, 1, 0, 0, 0, 1, 0, 1, 0, 1, 1, 0, 0, 1, 0},
+  {1, 0, 1, 1, 0, 0, 1, 0, 1, 0, 1, 1, 1, 0, 1, 1}
+};
+#else
+static const int8_t
+  t8_dtri_two_level_Iloc[T8_DTRI_NUM_TYPES][T8_DTRI_TWO_LEVEL_ENTRIES] =
+{
+  {0, 1, 1, 4, 1, 4, 4, 7, 8, 9, 17, 12, 25, 12, 20, 15, 8, 9, 25, 20, 25, 12,
+   20, 15, 32, 33, 33, 44, 49, 36, 52, 39, 8, 9, 9, 20, 25, 12, 28, 15, 32, 33,
+   49, 44, 49, 36, 44, 39, 32, 33, 41, 36, 49, 36, 44, 39, 56, 57, 57, 60, 57,
+   60, 60, 63},
+  {0, 1, 2, 5, 2, 5, 4, 7, 8, 9, 18, 13, 26, 13, 28, 15, 16, 17, 26, 21, 26,
+   13, 12, 23, 40, 41, 34, 45, 50, 37, 44, 47, 16, 17, 10, 21, 26, 13, 20, 23,
+   40, 41, 50, 45, 50, 37, 36, 47, 32, 33, 42, 37, 50, 37, 52, 39, 56, 57, 58,
+   61, 58, 61, 60, 63},
+  {0, 2, 3, 4, 1, 6, 5, 7, 16, 10, 19, 20, 17, 14, 29, 23, 24, 18, 27, 28, 17,
+   14, 13, 31, 32, 42, 35, 36, 49, 38, 45, 39, 8, 18, 11, 12, 25, 14, 21, 15,
+   48, 42, 51, 52, 41, 38, 37, 55, 40, 34, 43, 44, 41, 38, 53, 47, 56, 58, 59,
+   60, 57, 62, 61, 63},
+  {0, 3, 1, 5, 2, 4, 6, 7, 24, 11, 25, 21, 18, 28, 30, 31, 8, 19, 9, 29, 18,
+   28, 14, 15, 40, 43, 41, 37, 50, 52, 46, 47, 16, 19, 17, 13, 26, 28, 22, 23,
+   32, 43, 33, 53, 42, 52, 38, 39, 48, 35, 49, 45, 42, 52, 54, 55, 56, 59, 57,
+   61, 58, 60, 62, 63},
+  {0, 2, 2, 6, 3, 5, 5, 7, 16, 10, 26, 22, 19, 29, 21, 23, 16, 10, 10, 30, 19,
+   29, 21, 23, 48, 34, 42, 38, 51, 53, 53, 55, 24, 10, 18, 14, 27, 29, 29, 31,
+   40, 34, 34, 54, 43, 53, 45, 47, 40, 34, 50, 46, 43, 53, 45, 47, 56, 58, 58,
+   62, 59, 61, 61, 63},
+  {0, 3, 3, 6, 3, 6, 6, 7, 24, 11, 27, 14, 27, 30, 22, 31, 24, 11, 11, 22, 27,
+   30, 22, 31, 48, 35, 43, 46, 51, 54, 54, 55, 24, 11, 19, 22, 27, 30, 30, 31,
+   48, 35, 35, 46, 51, 54, 46, 55, 48, 35, 51, 38, 51, 54, 46, 55, 56, 59, 59,
+   62, 59, 62, 62, 63}
+};
+
+static const int8_t
+  t8_dtri_two_level_parenttype[T8_DTRI_NUM_TYPES][T8_DTRI_TWO_LEVEL_ENTRIES] =
+{
+  {0, 0, 2, 1, 5, 0, 4, 0, 0, 0, 1, 1, 0, 0, 0, 0, 2, 2, 2, 2, 3, 2, 3, 2, 1,
+   1, 2, 1, 1, 1, 2, 1, 5, 5, 4, 5, 5, 5, 4, 5, 0, 0, 0, 0, 5, 0, 5, 0, 4, 4,
+   3, 3, 4, 4, 4, 4, 0, 0, 2, 1, 5, 0, 4, 0},
+  {1, 1, 2, 1, 5, 0, 3, 1, 1, 1, 1, 1, 0, 0, 1, 1, 2, 2, 2, 2, 3, 2, 3, 2, 1,
+   1, 2, 1, 1, 1, 2, 1, 5, 5, 4, 5, 5, 5, 4, 5, 0, 0, 0, 0, 5, 0, 5, 0, 3, 3,
+   3, 3, 4, 4, 3, 3, 1, 1, 2, 1, 5, 0, 3, 1},
+  {2, 1, 2, 2, 4, 0, 3, 2, 1, 1, 1, 1, 0, 0, 1, 1, 2, 2, 2, 2, 3, 2, 3, 2, 2,
+   1, 2, 2, 2, 1, 2, 2, 4, 5, 4, 4, 4, 5, 4, 4, 0, 0, 0, 0, 5, 0, 5, 0, 3, 3,
+   3, 3, 4, 4, 3, 3, 2, 1, 2, 2, 4, 0, 3, 2},
+  {3, 1, 3, 2, 4, 5, 3, 3, 1, 1, 1, 1, 0, 0, 1, 1, 3, 2, 3, 2, 3, 3, 3, 3, 2,
+   1, 2, 2, 2, 1, 2, 2, 4, 5, 4, 4, 4, 5, 4, 4, 5, 0, 5, 0, 5, 5, 5, 5, 3, 3,
+   3, 3, 4, 4, 3, 3, 3, 1, 3, 2, 4, 5, 3, 3},
+  {4, 0, 3, 2, 4, 5, 4, 4, 0, 0, 1, 1, 0, 0, 0, 0, 3, 2, 3, 2, 3, 3, 3, 3, 2,
+   1, 2, 2, 2, 1, 2, 2, 4, 5, 4, 4, 4, 5, 4, 4, 5, 0, 5, 0, 5, 5, 5, 5, 4, 4,
+   3, 3, 4, 4, 4, 4, 4, 0, 3, 2, 4, 5, 4, 4},
+  {5, 0, 3, 1, 5, 5, 4, 5, 0, 0, 1, 1, 0, 0, 0, 0, 3, 2, 3, 2, 3, 3, 3, 3, 1,
+   1, 2, 1, 1, 1, 2, 1, 5, 5, 4, 5, 5, 5, 4, 5, 5, 0, 5, 0, 5, 5, 5, 5, 4, 4,
+   3, 3, 4, 4, 4, 4, 5, 0, 3, 1, 5, 5, 4, 5}
+};
+
+static const int8_t
+  t8_dtri_two_level_cid[T8_DTRI_NUM_TYPES][T8_DTRI_TWO_LEVEL_ENTRIES] =
+{
+  {0, 1, 1, 1, 5, 5, 5, 7, 8, 9, 9, 9, 13, 13, 13, 15, 8, 12, 12, 12, 14, 14,
+   14, 15, 8, 12, 12, 12, 13, 13, 13, 15, 40, 41, 41, 41, 45, 45, 45, 47, 40,
+   41, 41, 41, 43, 43, 43, 47, 40, 42, 42, 42, 43, 43, 43, 47, 56, 57, 57, 57,
+   61, 61, 61, 63},
+  {0, 1, 1, 1, 3, 3, 3, 7, 8, 9, 9, 9, 11, 11, 11, 15, 8, 10, 10, 10, 11, 11,
+   11, 15, 8, 10, 10, 10, 14, 14, 14, 15, 24, 25, 25, 25, 29, 29, 29, 31, 24,
+   25, 25, 25, 27, 27, 27, 31, 24, 28, 28, 28, 29, 29, 29, 31, 56, 57, 57, 57,
+   59, 59, 59, 63},
+  {0, 2, 2, 2, 3, 3, 3, 7, 16, 17, 17, 17, 21, 21, 21, 23, 16, 17, 17, 17, 19,
+   19, 19, 23, 16, 18, 18, 18, 19, 19, 19, 23, 24, 26, 26, 26, 27, 27, 27, 31,
+   24, 26, 26, 26, 30, 30, 30, 31, 24, 28, 28, 28, 30, 30, 30, 31, 56, 58, 58,
+   58, 59, 59, 59, 63},
+  {0, 2, 2, 2, 6, 6, 6, 7, 16, 18, 18, 18, 22, 22, 22, 23, 16, 20, 20, 20, 22,
+   22, 22, 23, 16, 20, 20, 20, 21, 21, 21, 23, 48, 49, 49, 49, 51, 51, 51, 55,
+   48, 50, 50, 50, 51, 51, 51, 55, 48, 50, 50, 50, 54, 54, 54, 55, 56, 58, 58,
+   58, 62, 62, 62, 63},
+  {0, 4, 4, 4, 6, 6, 6, 7, 32, 34, 34, 34, 35, 35, 35, 39, 32, 34, 34, 34, 38,
+   38, 38, 39, 32, 36, 36, 36, 38, 38, 38, 39, 48, 49, 49, 49, 53, 53, 53, 55,
+   48, 52, 52, 52, 54, 54, 54, 55, 48, 52, 52, 52, 53, 53, 53, 55, 56, 60, 60,
+   60, 62, 62, 62, 63},
+  {0, 4, 4, 4, 5, 5, 5, 7, 32, 33, 33, 33, 37, 37, 37, 39, 32, 33, 33, 33, 35,
+   35, 35, 39, 32, 36, 36, 36, 37, 37, 37, 39, 40, 42, 42, 42, 46, 46, 46, 47,
+   40, 44, 44, 44, 46, 46, 46, 47, 40, 44, 44, 44, 45, 45, 45, 47, 56, 60, 60,
+   60, 61, 61, 61, 63}
+};
+
+static const int8_t
+  t8_dtri_two_level_type[T8_DTRI_NUM_TYPES][T8_DTRI_TWO_LEVEL_ENTRIES] =
+{
+  {0, 0, 4, 5, 0, 1, 2, 0, 0, 0, 4, 5, 0, 1, 2, 0, 4, 2, 3, 4, 0, 4, 5, 4, 5,
+   0, 1, 5, 3, 4, 5, 5, 0, 0, 4, 5, 0, 1, 2, 0, 1, 1, 2, 3, 0, 1, 5, 1, 2, 0,
+   1, 2, 2, 3, 4, 2, 0, 0, 4, 5, 0, 1, 2, 0},
+  {1, 1, 2, 3, 0, 1, 5, 1, 1, 1, 2, 3, 0, 1, 5, 1, 2, 0, 1, 2, 2, 3, 4, 2, 3,
+   3, 4, 5, 1, 2, 3, 3, 0, 0, 4, 5, 0, 1, 2, 0, 1, 1, 2, 3, 0, 1, 5, 1, 5, 0,
+   1, 5, 3, 4, 5, 5, 1, 1, 2, 3, 0, 1, 5, 1},
+  {2, 0, 1, 2, 2, 3, 4, 2, 0, 0, 4, 5, 0, 1, 2, 0, 1, 1, 2, 3, 0, 1, 5, 1, 2,
+   0, 1, 2, 2, 3, 4, 2, 2, 0, 1, 2, 2, 3, 4, 2, 3, 3, 4, 5, 1, 2, 3, 3, 4, 2,
+   3, 4, 0, 4, 5, 4, 2, 0, 1, 2, 2, 3, 4, 2},
+  {3, 3, 4, 5, 1, 2, 3, 3, 3, 3, 4, 5, 1, 2, 3, 3, 4, 2, 3, 4, 0, 4, 5, 4, 5,
+   0, 1, 5, 3, 4, 5, 5, 1, 1, 2, 3, 0, 1, 5, 1, 2, 0, 1, 2, 2, 3, 4, 2, 3, 3,
+   4, 5, 1, 2, 3, 3, 3, 3, 4, 5, 1, 2, 3, 3},
+  {4, 2, 3, 4, 0, 4, 5, 4, 2, 0, 1, 2, 2, 3, 4, 2, 3, 3, 4, 5, 1, 2, 3, 3, 4,
+   2, 3, 4, 0, 4, 5, 4, 0, 0, 4, 5, 0, 1, 2, 0, 4, 2, 3, 4, 0, 4, 5, 4, 5, 0,
+   1, 5, 3, 4, 5, 5, 4, 2, 3, 4, 0, 4, 5, 4},
+  {5, 0, 1, 5, 3, 4, 5, 5, 0, 0, 4, 5, 0, 1, 2, 0, 1, 1, 2, 3, 0, 1, 5, 1, 5,
+   0, 1, 5, 3, 4, 5, 5, 3, 3, 4, 5, 1, 2, 3, 3, 4, 2, 3, 4, 0, 4, 5, 4, 5, 0,
+   1, 5, 3, 4, 5, 5, 5, 0, 1, 5, 3, 4, 5, 5}
+};
+#endif /* T8_DTRI_TO_DTET */
+
+#if defined (T8_ENABLE_BMI2) && defined (__BMI2__)
+#include <immintrin.h>
+
+/* The bit masks to (de)interleave the coordinates into a word that stores
+ * the cube-ids of all levels. The cube-id of level i is stored at the
+ * bits T8_DTRI_DIM * (T8_DTRI_MAXLEVEL - i) to T8_DTRI_DIM * (T8_DTRI_MAXLEVEL - i + 1) - 1. */
+#ifndef T8_DTRI_TO_DTET
+#define T8_DTRI_BMI2_MASK_X 0x5555555555555555ULL
+#define T8_DTRI_BMI2_MASK_Y 0xAAAAAAAAAAAAAAAAULL
+#else
+#define T8_DTRI_BMI2_MASK_X 0x1249249249249249ULL
+#define T8_DTRI_BMI2_MASK_Y 0x2492492492492492ULL
+#define T8_DTRI_BMI2_MASK_Z 0x4924924924924924ULL
+#endif
+
+/* Interleave the coordinates of t to the cube-ids of all levels */
+static inline       uint64_t
+t8_dtri_cubeids_interleave (const t8_dtri_t * t)
+{
+  uint64_t            cids;
+
+  cids = _pdep_u64 ((uint64_t) t->x, T8_DTRI_BMI2_MASK_X);
+  cids |= _pdep_u64 ((uint64_t) t->y, T8_DTRI_BMI2_MASK_Y);
+#ifdef T8_DTRI_TO_DTET
+  cids |= _pdep_u64 ((uint64_t) t->z, T8_DTRI_BMI2_MASK_Z);
+#endif
+  return cids;
+}
+#endif
+
+/* Return the cube-ids of t's ancestors of level level and level - 1
+ * as cid_level | cid_{level - 1} << T8_DTRI_DIM. */
+static inline int
+t8_dtri_two_level_cubeid (const t8_dtri_t * t, int level)
+{
+  const int           shift = T8_DTRI_MAXLEVEL - level;
+  int                 xbits, ybits, cids;
+#ifdef T8_DTRI_TO_DTET
+  int                 zbits;
+#endif
+
+  T8_ASSERT (2 <= level && level <= T8_DTRI_MAXLEVEL);
+  xbits = (t->x >> shift) & 3;
+  ybits = (t->y >> shift) & 3;
+  cids = (xbits & 1) | (ybits & 1) << 1
+    | ((xbits >> 1) | (ybits >> 1) << 1) << T8_DTRI_DIM;
+#ifdef T8_DTRI_TO_DTET
+  zbits = (t->z >> shift) & 3;
+  cids |= (zbits & 1) << 2 | (zbits >> 1) << (T8_DTRI_DIM + 2);
+#endif
+  return cids;
+}
+
+#ifdef T8_ENABLE_DEBUG
+/* Compute the linear id one level at a time.
+ * We use this to check the two level version. */
+static              t8_linearidx_t
+t8_dtri_linear_id_per_level (const t8_dtri_t * t, int level)
 {
   t8_linearidx_t      id = 0;
   int8_t              type_temp = 0;
@@ -1348,6 +1608,56 @@ t8_dtri_linear_id (const t8_dtri_t * t, int level)
   }
   return id;
 }
+#endif
+
+t8_linearidx_t
+t8_dtri_linear_id (const t8_dtri_t * t, int level)
+{
+  t8_linearidx_t      id = 0;
+  int8_t              type_temp = 0;
+  t8_dtri_cube_id_t   cid;
+  int                 i, cid2;
+  int                 exponent;
+  int                 my_level;
+#if defined (T8_ENABLE_BMI2) && defined (__BMI2__)
+  uint64_t            cids;
+#endif
+
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+  my_level = t->level;
+  exponent = 0;
+  /* If the given level is bigger than t's level
+   * we first fill up with the ids of t's descendants at t's
+   * origin with the same type as t */
+  if (level > my_level) {
+    exponent = (level - my_level) * T8_DTRI_DIM;
+  }
+  type_temp = t->type;
+#if defined (T8_ENABLE_BMI2) && defined (__BMI2__)
+  cids = t8_dtri_cubeids_interleave (t);
+#endif
+  /* Process two levels in each step */
+  for (i = my_level; i > 1; i -= 2) {
+#if defined (T8_ENABLE_BMI2) && defined (__BMI2__)
+    cid2 = (int) (cids >> (T8_DTRI_DIM * (T8_DTRI_MAXLEVEL - i)))
+      & (T8_DTRI_TWO_LEVEL_ENTRIES - 1);
+#else
+    cid2 = t8_dtri_two_level_cubeid (t, i);
+#endif
+    id |=
+      ((t8_linearidx_t) t8_dtri_two_level_Iloc[type_temp][cid2]) << exponent;
+    exponent += 2 * T8_DTRI_DIM;
+    type_temp = t8_dtri_two_level_parenttype[type_temp][cid2];
+  }
+  if (i == 1) {
+    /* There is one level left */
+    cid = compute_cubeid (t, 1);
+    id |=
+      ((t8_linearidx_t) t8_dtri_type_cid_to_Iloc[type_temp][cid]) << exponent;
+  }
+  T8_ASSERT (id == t8_dtri_linear_id_per_level (t, level));
+  return id;
+}
 
 void
 t8_dtri_init_linear_id (t8_dtri_t * t, t8_linearidx_t id, int level)
@@ -1358,6 +1668,10 @@ t8_dtri_init_linear_id (t8_dtri_t * t, t8_linearidx_t id, int level)
   t8_linearidx_t      local_index;
   t8_dtri_cube_id_t   cid;
   t8_dtri_type_t      type;
+  int                 cid2;
+#if defined (T8_ENABLE_BMI2) && defined (__BMI2__)
+  uint64_t            cids = 0;
+#endif
   T8_ASSERT (0 <= id && id <= ((t8_linearidx_t) 1) << (T8_DTRI_DIM * level));
 
   t->level = level;
@@ -1369,12 +1683,39 @@ t8_dtri_init_linear_id (t8_dtri_t * t, t8_linearidx_t id, int level)
   t->n = 0;
 #endif
   type = 0;                     /* This is the type of the root triangle */
-  for (i = 1; i <= level; i++) {
+  /* Process two levels in each step */
+  for (i = 1; i < level; i += 2) {
+    /* The local indices of T's ancestors on level i and i + 1 */
+    offset_index = level - i - 1;
+    local_index = (id >> (T8_DTRI_DIM * offset_index))
+      & (T8_DTRI_TWO_LEVEL_ENTRIES - 1);
+    cid2 = t8_dtri_two_level_cid[type][local_index];
+    type = t8_dtri_two_level_type[type][local_index];
+#if defined (T8_ENABLE_BMI2) && defined (__BMI2__)
+    cids |= ((uint64_t) cid2) << (T8_DTRI_DIM * (T8_DTRI_MAXLEVEL - i - 1));
+#else
+    /* cid2 stores the cube-id of level i + 1 in the lower bits */
+    offset_coords = T8_DTRI_MAXLEVEL - i - 1;
+    t->x |= ((cid2 & 1) | (cid2 >> T8_DTRI_DIM & 1) << 1) << offset_coords;
+    t->y |= ((cid2 >> 1 & 1) | (cid2 >> (T8_DTRI_DIM + 1) & 1) << 1)
+      << offset_coords;
+#ifdef T8_DTRI_TO_DTET
+    t->z |= ((cid2 >> 2 & 1) | (cid2 >> (T8_DTRI_DIM + 2) & 1) << 1)
+      << offset_coords;
+#endif
+#endif
+  }
+#if defined (T8_ENABLE_BMI2) && defined (__BMI2__)
+  t->x = (t8_dtri_coord_t) _pext_u64 (cids, T8_DTRI_BMI2_MASK_X);
+  t->y = (t8_dtri_coord_t) _pext_u64 (cids, T8_DTRI_BMI2_MASK_Y);
+#ifdef T8_DTRI_TO_DTET
+  t->z = (t8_dtri_coord_t) _pext_u64 (cids, T8_DTRI_BMI2_MASK_Z);
+#endif
+#endif
+  if (i == level) {
+    /* There is one level left */
     offset_coords = T8_DTRI_MAXLEVEL - i;
-    offset_index = level - i;
-    /* Get the local index of T's ancestor on level i */
-    local_index = (id >> (T8_DTRI_DIM * offset_index)) & children_m1;
-    /* Get the type and cube-id of T's ancestor on level i */
+    local_index = id & children_m1;
     cid = t8_dtri_parenttype_Iloc_to_cid[type][local_index];
     type = t8_dtri_parenttype_Iloc_to_type[type][local_index];
     t->x |= (cid & 1) ? 1 << offset_coords : 0;
@@ -1384,6 +1725,7 @@ t8_dtri_init_linear_id (t8_dtri_t * t, t8_linearidx_t id, int level)
 #endif
   }
   t->type = type;
+  T8_ASSERT (t8_dtri_linear_id_per_level (t, level) == id);
 }
 
 void
@@ -1454,11 +1796,109 @@ t8_dtri_succ_pred_recursion (const t8_dtri_t * t, t8_dtri_t * s, int level,
 #endif
 }
 
+/* Set the bits of the coordinates of s at level to the cube-id cid. */
+static inline void
+t8_dtri_set_cubeid (t8_dtri_t * s, int level, t8_dtri_cube_id_t cid)
+{
+  const t8_dtri_coord_t h = T8_DTRI_LEN (level);
+
+  s->x = cid & 1 ? s->x | h : s->x & ~h;
+  s->y = cid & 2 ? s->y | h : s->y & ~h;
+#ifdef T8_DTRI_TO_DTET
+  s->z = cid & 4 ? s->z | h : s->z & ~h;
+#endif
+}
+
+/* We compute the successor iteratively. We go up the levels as long as
+ * the ancestor is the last child of its parent and then down again
+ * along the first children. Since only every T8_DTRI_CHILDREN-th element
+ * is a last child, this runs in amortized constant time when iterating
+ * over a uniform refinement. */
 void
 t8_dtri_successor (const t8_dtri_t * t, t8_dtri_t * s, int level)
 {
+  t8_dtri_type_t      type;
+  t8_dtri_cube_id_t   cid;
+  int                 local_index = 0;
+  int                 ilevel;
+
+  /* The root triangle does not have a successor. */
+  T8_ASSERT (1 <= level && level <= t->level);
+
   t8_dtri_copy (t, s);
-  t8_dtri_succ_pred_recursion (t, s, level, 1);
+  type = compute_type (t, level);
+  for (ilevel = level; ilevel > 0; --ilevel) {
+    cid = compute_cubeid (t, ilevel);
+    local_index = t8_dtri_type_cid_to_Iloc[type][cid];
+    /* type is now the type of the ancestor at level ilevel - 1 */
+    type = t8_dtri_cid_type_to_parenttype[cid][type];
+    if (local_index < T8_DTRI_CHILDREN - 1) {
+      break;
+    }
+  }
+  /* If we did not break, t is the last triangle and has no successor. */
+  T8_ASSERT (ilevel > 0);
+  local_index++;
+  for (; ilevel <= level; ++ilevel) {
+    cid = t8_dtri_parenttype_Iloc_to_cid[type][local_index];
+    type = t8_dtri_parenttype_Iloc_to_type[type][local_index];
+    t8_dtri_set_cubeid (s, ilevel, cid);
+    /* All finer ancestors are the first children of their parents */
+    local_index = 0;
+  }
+  s->type = type;
+  s->level = level;
+  T8_ASSERT (t8_dtri_linear_id (s, level) == t8_dtri_linear_id (t, level) + 1);
+}
+
+void
+t8_dtri_init_linear_id_range (t8_dtri_t * t, t8_linearidx_t id, int level,
+                              size_t count)
+{
+  t8_dtri_type_t      types[T8_DTRI_MAXLEVEL + 1];
+  int8_t              local_ids[T8_DTRI_MAXLEVEL + 1];
+  t8_dtri_cube_id_t   cid;
+  t8_dtri_t          *s;
+  size_t              ielem;
+  int                 ilevel;
+
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+  T8_ASSERT (count == 0
+             || id + count <= ((t8_linearidx_t) 1) << (T8_DTRI_DIM * level));
+
+  if (count == 0) {
+    return;
+  }
+  t8_dtri_init_linear_id (t, id, level);
+  /* Store the types of all ancestors and their local indices within
+   * their parents, such that we do not need to recompute them. */
+  types[level] = t->type;
+  for (ilevel = level; ilevel > 0; --ilevel) {
+    cid = compute_cubeid (t, ilevel);
+    local_ids[ilevel] = t8_dtri_type_cid_to_Iloc[types[ilevel]][cid];
+    types[ilevel - 1] = t8_dtri_cid_type_to_parenttype[cid][types[ilevel]];
+  }
+  for (ielem = 1; ielem < count; ++ielem) {
+    s = t + ielem;
+    t8_dtri_copy (s - 1, s);
+    /* Find the finest ancestor that is not a last child */
+    for (ilevel = level; local_ids[ilevel] == T8_DTRI_CHILDREN - 1;
+         --ilevel) {
+      T8_ASSERT (ilevel > 1);
+      local_ids[ilevel] = 0;
+    }
+    local_ids[ilevel]++;
+    /* Go down again and update types and coordinates */
+    for (; ilevel <= level; ++ilevel) {
+      cid =
+        t8_dtri_parenttype_Iloc_to_cid[types[ilevel - 1]][local_ids[ilevel]];
+      types[ilevel] =
+        t8_dtri_parenttype_Iloc_to_type[types[ilevel - 1]][local_ids[ilevel]];
+      t8_dtri_set_cubeid (s, ilevel, cid);
+    }
+    s->type = types[level];
+    T8_ASSERT (t8_dtri_linear_id (s, level) == id + ielem);
+  }
 }
 
 void
@@ -298,6 +298,20 @@ void                t8_dtri_init_root (t8_dtri_t * t);
 void                t8_dtri_successor (const t8_dtri_t * t, t8_dtri_t * s,
                                        int level);
 
+/** Initialize an array of triangles as the triangles with consecutive ids
+ *  in a uniform refinement of a given level.
+ *  This is faster than calling \ref t8_dtri_init_linear_id for each triangle,
+ *  since the types of the ancestors are only computed once.
+ * \param [in,out] t  Array of at least \a count existing triangles.
+ * \param [in] id     The id of the first triangle.
+ * \param [in] level  level of uniform grid to be considered.
+ * \param [in] count  The number of triangles. \a id + \a count must not
+ *                    exceed the number of triangles at \a level.
+ */
+void                t8_dtri_init_linear_id_range (t8_dtri_t * t,
+                                                  t8_linearidx_t id,
+                                                  int level, size_t count);
+
 /** Compute the first descendant of a triangle at a given level. This is the descendant of
  * the triangle in a uniform maxlevel refinement that has the smaller id.
  * \param [in] t        Triangle whose descendant is computed.
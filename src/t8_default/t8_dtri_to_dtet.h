@@ -93,6 +93,7 @@ T8_EXTERN_C_BEGIN ();
 #define t8_dtri_init_linear_id t8_dtet_init_linear_id
 #define t8_dtri_init_root t8_dtet_init_root
 #define t8_dtri_successor t8_dtet_successor
+#define t8_dtri_init_linear_id_range t8_dtet_init_linear_id_range
 #define t8_dtri_first_descendant t8_dtet_first_descendant
 #define t8_dtri_last_descendant t8_dtet_last_descendant
 #define t8_dtri_corner_descendant t8_dtet_corner_descendant
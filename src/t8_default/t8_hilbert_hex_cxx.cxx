@@ -0,0 +1,509 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <p8est_bits.h>
+#include "t8_hilbert_hex_cxx.hxx"
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* The Hilbert curve is described by a finite automaton.  Each element has
+ * a state that determines in which order its children are traversed and
+ * which state each child gets.  The root is in state 0.
+ * t8_hilbert_hex_order[s][pos] is the Morton child id of the child at
+ * position pos along the curve, t8_hilbert_hex_position is its inverse and
+ * t8_hilbert_hex_next[s][pos] is the state of the child at pos. */
+static const int    t8_hilbert_hex_order[24][P8EST_CHILDREN] = {
+  {0, 4, 6, 2, 3, 7, 5, 1},
+  {0, 2, 3, 1, 5, 7, 6, 4},
+  {0, 4, 5, 1, 3, 7, 6, 2},
+  {5, 4, 6, 7, 3, 2, 0, 1},
+  {0, 1, 3, 2, 6, 7, 5, 4},
+  {3, 7, 6, 2, 0, 4, 5, 1},
+  {5, 7, 6, 4, 0, 2, 3, 1},
+  {0, 1, 5, 4, 6, 7, 3, 2},
+  {0, 2, 6, 4, 5, 7, 3, 1},
+  {6, 2, 3, 7, 5, 1, 0, 4},
+  {5, 7, 3, 1, 0, 2, 6, 4},
+  {6, 7, 3, 2, 0, 1, 5, 4},
+  {6, 4, 5, 7, 3, 1, 0, 2},
+  {3, 7, 5, 1, 0, 4, 6, 2},
+  {6, 7, 5, 4, 0, 1, 3, 2},
+  {5, 4, 0, 1, 3, 2, 6, 7},
+  {5, 1, 3, 7, 6, 2, 0, 4},
+  {3, 2, 6, 7, 5, 4, 0, 1},
+  {5, 1, 0, 4, 6, 2, 3, 7},
+  {3, 2, 0, 1, 5, 4, 6, 7},
+  {3, 1, 0, 2, 6, 4, 5, 7},
+  {3, 1, 5, 7, 6, 4, 0, 2},
+  {6, 2, 0, 4, 5, 1, 3, 7},
+  {6, 4, 0, 2, 3, 1, 5, 7}
+};
+
+static const int    t8_hilbert_hex_position[24][P8EST_CHILDREN] = {
+  {0, 7, 3, 4, 1, 6, 2, 5},
+  {0, 3, 1, 2, 7, 4, 6, 5},
+  {0, 3, 7, 4, 1, 2, 6, 5},
+  {6, 7, 5, 4, 1, 0, 2, 3},
+  {0, 1, 3, 2, 7, 6, 4, 5},
+  {4, 7, 3, 0, 5, 6, 2, 1},
+  {4, 7, 5, 6, 3, 0, 2, 1},
+  {0, 1, 7, 6, 3, 2, 4, 5},
+  {0, 7, 1, 6, 3, 4, 2, 5},
+  {6, 5, 1, 2, 7, 4, 0, 3},
+  {4, 3, 5, 2, 7, 0, 6, 1},
+  {4, 5, 3, 2, 7, 6, 0, 1},
+  {6, 5, 7, 4, 1, 2, 0, 3},
+  {4, 3, 7, 0, 5, 2, 6, 1},
+  {4, 5, 7, 6, 3, 2, 0, 1},
+  {2, 3, 5, 4, 1, 0, 6, 7},
+  {6, 1, 5, 2, 7, 0, 4, 3},
+  {6, 7, 1, 0, 5, 4, 2, 3},
+  {2, 1, 5, 6, 3, 0, 4, 7},
+  {2, 3, 1, 0, 5, 4, 6, 7},
+  {2, 1, 3, 0, 5, 6, 4, 7},
+  {6, 1, 7, 0, 5, 2, 4, 3},
+  {2, 5, 1, 6, 3, 4, 0, 7},
+  {2, 5, 3, 4, 1, 6, 0, 7}
+};
+
+static const int    t8_hilbert_hex_next[24][P8EST_CHILDREN] = {
+  {1, 2, 0, 3, 4, 0, 5, 6},
+  {7, 8, 1, 9, 2, 1, 10, 11},
+  {4, 0, 2, 12, 1, 2, 13, 14},
+  {10, 15, 3, 0, 16, 3, 17, 8},
+  {8, 7, 4, 16, 0, 4, 11, 10},
+  {19, 13, 5, 6, 20, 5, 0, 3},
+  {15, 10, 6, 5, 18, 6, 8, 17},
+  {0, 4, 7, 21, 8, 7, 14, 13},
+  {2, 1, 8, 17, 7, 8, 6, 5},
+  {14, 22, 9, 1, 12, 9, 16, 4},
+  {18, 6, 10, 11, 15, 10, 1, 9},
+  {22, 14, 11, 10, 23, 11, 4, 16},
+  {11, 23, 12, 2, 9, 12, 21, 7},
+  {20, 5, 13, 14, 19, 13, 2, 12},
+  {23, 11, 14, 13, 22, 14, 7, 21},
+  {16, 3, 15, 23, 10, 15, 19, 22},
+  {6, 18, 16, 4, 3, 16, 9, 1},
+  {13, 19, 17, 8, 21, 17, 3, 0},
+  {3, 16, 18, 20, 6, 18, 22, 19},
+  {21, 17, 19, 22, 13, 19, 15, 23},
+  {17, 21, 20, 18, 5, 20, 23, 15},
+  {5, 20, 21, 7, 17, 21, 12, 2},
+  {12, 9, 22, 19, 14, 22, 18, 20},
+  {9, 12, 23, 15, 11, 23, 20, 18}
+};
+
+/* Return the Morton child id of the ancestor of q at level. */
+static int
+t8_hilbert_hex_morton_id (const p8est_quadrant_t * q, int level)
+{
+  const p4est_qcoord_t len = P8EST_QUADRANT_LEN (level);
+
+  T8_ASSERT (0 < level && level <= q->level);
+  return (q->x & len ? 1 : 0) | (q->y & len ? 2 : 0) | (q->z & len ? 4 : 0);
+}
+
+/* Return the state of the ancestor of q at level. */
+static int
+t8_hilbert_hex_state (const p8est_quadrant_t * q, int level)
+{
+  int                 ilevel, state = 0;
+
+  T8_ASSERT (0 <= level && level <= q->level);
+  for (ilevel = 1; ilevel <= level; ++ilevel) {
+    state = t8_hilbert_hex_next[state]
+      [t8_hilbert_hex_position[state][t8_hilbert_hex_morton_id (q, ilevel)]];
+  }
+  return state;
+}
+
+/* Return the Hilbert index of q at level.  For a level finer than that
+ * of q this is the index of its first descendant. */
+static t8_linearidx_t
+t8_hilbert_hex_linear_id (const p8est_quadrant_t * q, int level)
+{
+  t8_linearidx_t      id = 0;
+  int                 ilevel, pos, state = 0;
+
+  for (ilevel = 1; ilevel <= SC_MIN (level, (int) q->level); ++ilevel) {
+    pos = t8_hilbert_hex_position[state][t8_hilbert_hex_morton_id (q,
+                                                                     ilevel)];
+    id = (id << P8EST_DIM) | pos;
+    state = t8_hilbert_hex_next[state][pos];
+  }
+  if (level > q->level) {
+    id <<= P8EST_DIM * (level - q->level);
+  }
+  return id;
+}
+
+/* Set the coordinates and level of q to the element with Hilbert index id.
+ * All other members of q are left untouched. */
+static void
+t8_hilbert_hex_set_id (p8est_quadrant_t * q, int level, t8_linearidx_t id)
+{
+  p4est_qcoord_t      x = 0, y = 0, z = 0, len;
+  int                 ilevel, pos, morton, state = 0;
+
+  for (ilevel = 1; ilevel <= level; ++ilevel) {
+    pos = (int) (id >> (P8EST_DIM * (level - ilevel))) &
+      (P8EST_CHILDREN - 1);
+    morton = t8_hilbert_hex_order[state][pos];
+    len = P8EST_QUADRANT_LEN (ilevel);
+    x |= morton & 1 ? len : 0;
+    y |= morton & 2 ? len : 0;
+    z |= morton & 4 ? len : 0;
+    state = t8_hilbert_hex_next[state][pos];
+  }
+  q->x = x;
+  q->y = y;
+  q->z = z;
+  q->level = (int8_t) level;
+}
+
+/* Descend from q to level, choosing at each level the first (or the last if
+ * last is nonzero) child along the curve that touches face. */
+static void
+t8_hilbert_hex_face_descendant (const p8est_quadrant_t * q, int face,
+                                 int level, int last, p8est_quadrant_t * desc)
+{
+  const int           axis = face >> 1, side = face & 1;
+  p4est_qcoord_t      len;
+  int                 ilevel, ipos, pos, morton, state;
+
+  T8_ASSERT (0 <= face && face < P8EST_FACES);
+  T8_ASSERT (q->level <= level && level <= P8EST_QMAXLEVEL);
+
+  state = t8_hilbert_hex_state (q, q->level);
+  *desc = *q;
+  for (ilevel = q->level + 1; ilevel <= level; ++ilevel) {
+    for (ipos = 0; ipos < P8EST_CHILDREN; ++ipos) {
+      pos = last ? P8EST_CHILDREN - 1 - ipos : ipos;
+      morton = t8_hilbert_hex_order[state][pos];
+      if (((morton >> axis) & 1) == side) {
+        break;
+      }
+    }
+    T8_ASSERT (ipos < P8EST_CHILDREN);
+    len = P8EST_QUADRANT_LEN (ilevel);
+    desc->x |= morton & 1 ? len : 0;
+    desc->y |= morton & 2 ? len : 0;
+    desc->z |= morton & 4 ? len : 0;
+    state = t8_hilbert_hex_next[state][pos];
+  }
+  desc->level = (int8_t) level;
+}
+
+int
+t8_hilbert_scheme_hex_c::t8_element_compare (const t8_element_t * elem1,
+                                              const t8_element_t * elem2)
+{
+  const p8est_quadrant_t *q1 = (const p8est_quadrant_t *) elem1;
+  const p8est_quadrant_t *q2 = (const p8est_quadrant_t *) elem2;
+  const int           level = SC_MAX (q1->level, q2->level);
+  t8_linearidx_t      id1, id2;
+
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (t8_element_is_valid (elem2));
+
+  id1 = t8_hilbert_hex_linear_id (q1, level);
+  id2 = t8_hilbert_hex_linear_id (q2, level);
+  if (id1 != id2) {
+    return id1 < id2 ? -1 : 1;
+  }
+  return (int) q1->level - (int) q2->level;
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_sibling (const t8_element_t * elem,
+                                              int sibid,
+                                              t8_element_t * sibling)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  int                 state;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 < q->level);
+  T8_ASSERT (0 <= sibid && sibid < P8EST_CHILDREN);
+
+  state = t8_hilbert_hex_state (q, q->level - 1);
+  t8_default_scheme_hex_c::t8_element_sibling (elem,
+                                                t8_hilbert_hex_order[state]
+                                                [sibid], sibling);
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_child (const t8_element_t * elem,
+                                            int childid, t8_element_t * child)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  int                 state;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= childid && childid < P8EST_CHILDREN);
+
+  state = t8_hilbert_hex_state (q, q->level);
+  t8_default_scheme_hex_c::t8_element_child (elem,
+                                              t8_hilbert_hex_order[state]
+                                              [childid], child);
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_children (const t8_element_t * elem,
+                                               int length, t8_element_t * c[])
+{
+  /* We work on a copy, since the usage allows for elem == c[0]. */
+  const p8est_quadrant_t parent = *(const p8est_quadrant_t *) elem;
+  int                 ichild, state;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (length == P8EST_CHILDREN);
+
+  state = t8_hilbert_hex_state (&parent, parent.level);
+  for (ichild = 0; ichild < P8EST_CHILDREN; ++ichild) {
+    t8_default_scheme_hex_c::t8_element_child ((const t8_element_t *)
+                                                &parent,
+                                                t8_hilbert_hex_order[state]
+                                                [ichild], c[ichild]);
+  }
+}
+
+int
+t8_hilbert_scheme_hex_c::t8_element_child_id (const t8_element_t * elem)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  return t8_element_ancestor_id (elem, q->level);
+}
+
+int
+t8_hilbert_scheme_hex_c::t8_element_ancestor_id (const t8_element_t * elem,
+                                                  int level)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+
+  T8_ASSERT (0 <= level && level <= q->level);
+  if (level == 0) {
+    return 0;
+  }
+  return t8_hilbert_hex_position[t8_hilbert_hex_state (q, level - 1)]
+    [t8_hilbert_hex_morton_id (q, level)];
+}
+
+int
+t8_hilbert_scheme_hex_c::t8_element_is_family (t8_element_t ** fam)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) fam[0];
+  t8_element_t       *morton_fam[P8EST_CHILDREN];
+  int                 ichild, state;
+
+#ifdef T8_ENABLE_DEBUG
+  for (ichild = 0; ichild < P8EST_CHILDREN; ichild++) {
+    T8_ASSERT (t8_element_is_valid (fam[ichild]));
+  }
+#endif
+  if (q->level == 0) {
+    return 0;
+  }
+  /* Sort the family into Morton order and let p4est check it */
+  state = t8_hilbert_hex_state (q, q->level - 1);
+  for (ichild = 0; ichild < P8EST_CHILDREN; ichild++) {
+    morton_fam[t8_hilbert_hex_order[state][ichild]] = fam[ichild];
+  }
+  return t8_default_scheme_hex_c::t8_element_is_family (morton_fam);
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_children_at_face (const t8_element_t *
+                                                       elem, int face,
+                                                       t8_element_t *
+                                                       children[],
+                                                       int num_children,
+                                                       int *child_indices)
+{
+  /* We work on a copy, since the usage allows for elem == children[0]. */
+  const p8est_quadrant_t parent = *(const p8est_quadrant_t *) elem;
+  const int           axis = face >> 1, side = face & 1;
+  int                 morton, ichild = 0, state;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < P8EST_FACES);
+  T8_ASSERT (num_children == t8_element_num_face_children (elem, face));
+
+  /* The children at the face in increasing Morton order are in the order
+   * of the face, exactly as in the default scheme. */
+  state = t8_hilbert_hex_state (&parent, parent.level);
+  for (morton = 0; morton < P8EST_CHILDREN; ++morton) {
+    if (((morton >> axis) & 1) != side) {
+      continue;
+    }
+    t8_default_scheme_hex_c::t8_element_child ((const t8_element_t *)
+                                                &parent, morton,
+                                                children[ichild]);
+    if (child_indices != NULL) {
+      child_indices[ichild] = t8_hilbert_hex_position[state][morton];
+    }
+    ++ichild;
+  }
+  T8_ASSERT (ichild == num_children);
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_first_descendant_face (const
+                                                            t8_element_t *
+                                                            elem, int face,
+                                                            t8_element_t *
+                                                            first_desc,
+                                                            int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_hilbert_hex_face_descendant ((const p8est_quadrant_t *) elem, face,
+                                   level, 0, (p8est_quadrant_t *) first_desc);
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_last_descendant_face (const
+                                                           t8_element_t *
+                                                           elem, int face,
+                                                           t8_element_t *
+                                                           last_desc,
+                                                           int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_hilbert_hex_face_descendant ((const p8est_quadrant_t *) elem, face,
+                                   level, 1, (p8est_quadrant_t *) last_desc);
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_set_linear_id (t8_element_t * elem,
+                                                    int level,
+                                                    t8_linearidx_t id)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+  T8_ASSERT (0 <= id && id < ((t8_linearidx_t) 1) << P8EST_DIM * level);
+
+  t8_hilbert_hex_set_id ((p8est_quadrant_t *) elem, level, id);
+}
+
+t8_linearidx_t
+  t8_hilbert_scheme_hex_c::t8_element_get_linear_id (const t8_element_t *
+                                                      elem, int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+
+  return t8_hilbert_hex_linear_id ((const p8est_quadrant_t *) elem, level);
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_first_descendant (const t8_element_t *
+                                                       elem,
+                                                       t8_element_t * desc,
+                                                       int level)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (desc));
+  T8_ASSERT (q->level <= level && level <= P8EST_QMAXLEVEL);
+
+  t8_hilbert_hex_set_id ((p8est_quadrant_t *) desc, level,
+                          t8_hilbert_hex_linear_id (q, level));
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_last_descendant (const t8_element_t *
+                                                      elem,
+                                                      t8_element_t * desc,
+                                                      int level)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  t8_linearidx_t      id;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (desc));
+  T8_ASSERT (q->level <= level && level <= P8EST_QMAXLEVEL);
+
+  id = t8_hilbert_hex_linear_id (q, q->level) + 1;
+  t8_hilbert_hex_set_id ((p8est_quadrant_t *) desc, level,
+                          (id << P8EST_DIM * (level - q->level)) - 1);
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_successor (const t8_element_t * elem1,
+                                                t8_element_t * elem2,
+                                                int level)
+{
+  t8_linearidx_t      id;
+
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (t8_element_is_valid (elem2));
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+
+  id = t8_hilbert_hex_linear_id ((const p8est_quadrant_t *) elem1, level);
+  T8_ASSERT (id + 1 < ((t8_linearidx_t) 1) << P8EST_DIM * level);
+    t8_element_copy (elem1, elem2);
+  t8_hilbert_hex_set_id ((p8est_quadrant_t *) elem2, level, id + 1);
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_child_id_array (const t8_element_t *
+                                                     elems, size_t count,
+                                                     int *child_ids)
+{
+  t8_eclass_scheme::t8_element_child_id_array (elems, count, child_ids);
+}
+
+void
+t8_hilbert_scheme_hex_c::t8_element_get_linear_id_array (const t8_element_t
+                                                          * elems,
+                                                          size_t count,
+                                                          int level,
+                                                          t8_linearidx_t *
+                                                          ids)
+{
+  t8_eclass_scheme::t8_element_get_linear_id_array (elems, count, level,
+                                                    ids);
+}
+
+int
+t8_hilbert_scheme_hex_c::t8_element_is_family_array (const t8_element_t *
+                                                      elems)
+{
+  return t8_eclass_scheme::t8_element_is_family_array (elems);
+}
+
+/* Constructor */
+t8_hilbert_scheme_hex_c::t8_hilbert_scheme_hex_c (void)
+{
+  /* The element storage is set up by the default hex scheme. */
+}
+
+t8_hilbert_scheme_hex_c::~t8_hilbert_scheme_hex_c ()
+{
+  /* The mempool is destroyed by the default_common scheme. */
+}
+
+T8_EXTERN_C_END ();
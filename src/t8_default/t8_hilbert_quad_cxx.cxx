@@ -0,0 +1,450 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <p4est_bits.h>
+#include "t8_hilbert_quad_cxx.hxx"
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* The Hilbert curve is described by a finite automaton.  Each element has
+ * a state that determines in which order its children are traversed and
+ * which state each child gets.  The root is in state 0.
+ * t8_hilbert_quad_order[s][pos] is the Morton child id of the child at
+ * position pos along the curve, t8_hilbert_quad_position is its inverse and
+ * t8_hilbert_quad_next[s][pos] is the state of the child at pos. */
+static const int    t8_hilbert_quad_order[4][P4EST_CHILDREN] = {
+  {0, 2, 3, 1},
+  {0, 1, 3, 2},
+  {3, 2, 0, 1},
+  {3, 1, 0, 2}
+};
+
+static const int    t8_hilbert_quad_position[4][P4EST_CHILDREN] = {
+  {0, 3, 1, 2},
+  {0, 1, 3, 2},
+  {2, 3, 1, 0},
+  {2, 1, 3, 0}
+};
+
+static const int    t8_hilbert_quad_next[4][P4EST_CHILDREN] = {
+  {1, 0, 0, 2},
+  {0, 1, 1, 3},
+  {3, 2, 2, 0},
+  {2, 3, 3, 1}
+};
+
+/* Return the Morton child id of the ancestor of q at level. */
+static int
+t8_hilbert_quad_morton_id (const p4est_quadrant_t * q, int level)
+{
+  const p4est_qcoord_t len = P4EST_QUADRANT_LEN (level);
+
+  T8_ASSERT (0 < level && level <= q->level);
+  return (q->x & len ? 1 : 0) | (q->y & len ? 2 : 0);
+}
+
+/* Return the state of the ancestor of q at level. */
+static int
+t8_hilbert_quad_state (const p4est_quadrant_t * q, int level)
+{
+  int                 ilevel, state = 0;
+
+  T8_ASSERT (0 <= level && level <= q->level);
+  for (ilevel = 1; ilevel <= level; ++ilevel) {
+    state = t8_hilbert_quad_next[state]
+      [t8_hilbert_quad_position[state][t8_hilbert_quad_morton_id (q, ilevel)]];
+  }
+  return state;
+}
+
+/* Return the Hilbert index of q at level.  For a level finer than that
+ * of q this is the index of its first descendant. */
+static t8_linearidx_t
+t8_hilbert_quad_linear_id (const p4est_quadrant_t * q, int level)
+{
+  t8_linearidx_t      id = 0;
+  int                 ilevel, pos, state = 0;
+
+  for (ilevel = 1; ilevel <= SC_MIN (level, (int) q->level); ++ilevel) {
+    pos = t8_hilbert_quad_position[state][t8_hilbert_quad_morton_id (q,
+                                                                     ilevel)];
+    id = (id << P4EST_DIM) | pos;
+    state = t8_hilbert_quad_next[state][pos];
+  }
+  if (level > q->level) {
+    id <<= P4EST_DIM * (level - q->level);
+  }
+  return id;
+}
+
+/* Set the coordinates and level of q to the element with Hilbert index id.
+ * All other members of q are left untouched. */
+static void
+t8_hilbert_quad_set_id (p4est_quadrant_t * q, int level, t8_linearidx_t id)
+{
+  p4est_qcoord_t      x = 0, y = 0, len;
+  int                 ilevel, pos, morton, state = 0;
+
+  for (ilevel = 1; ilevel <= level; ++ilevel) {
+    pos = (int) (id >> (P4EST_DIM * (level - ilevel))) &
+      (P4EST_CHILDREN - 1);
+    morton = t8_hilbert_quad_order[state][pos];
+    len = P4EST_QUADRANT_LEN (ilevel);
+    x |= morton & 1 ? len : 0;
+    y |= morton & 2 ? len : 0;
+    state = t8_hilbert_quad_next[state][pos];
+  }
+  q->x = x;
+  q->y = y;
+  q->level = (int8_t) level;
+}
+
+/* Descend from q to level, choosing at each level the first (or the last if
+ * last is nonzero) child along the curve that touches face. */
+static void
+t8_hilbert_quad_face_descendant (const p4est_quadrant_t * q, int face,
+                                 int level, int last, p4est_quadrant_t * desc)
+{
+  const int           axis = face >> 1, side = face & 1;
+  p4est_qcoord_t      len;
+  int                 ilevel, ipos, pos, morton, state;
+
+  T8_ASSERT (0 <= face && face < P4EST_FACES);
+  T8_ASSERT (q->level <= level && level <= P4EST_QMAXLEVEL);
+
+  state = t8_hilbert_quad_state (q, q->level);
+  *desc = *q;
+  for (ilevel = q->level + 1; ilevel <= level; ++ilevel) {
+    for (ipos = 0; ipos < P4EST_CHILDREN; ++ipos) {
+      pos = last ? P4EST_CHILDREN - 1 - ipos : ipos;
+      morton = t8_hilbert_quad_order[state][pos];
+      if (((morton >> axis) & 1) == side) {
+        break;
+      }
+    }
+    T8_ASSERT (ipos < P4EST_CHILDREN);
+    len = P4EST_QUADRANT_LEN (ilevel);
+    desc->x |= morton & 1 ? len : 0;
+    desc->y |= morton & 2 ? len : 0;
+    state = t8_hilbert_quad_next[state][pos];
+  }
+  desc->level = (int8_t) level;
+}
+
+int
+t8_hilbert_scheme_quad_c::t8_element_compare (const t8_element_t * elem1,
+                                              const t8_element_t * elem2)
+{
+  const p4est_quadrant_t *q1 = (const p4est_quadrant_t *) elem1;
+  const p4est_quadrant_t *q2 = (const p4est_quadrant_t *) elem2;
+  const int           level = SC_MAX (q1->level, q2->level);
+  t8_linearidx_t      id1, id2;
+
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (t8_element_is_valid (elem2));
+
+  id1 = t8_hilbert_quad_linear_id (q1, level);
+  id2 = t8_hilbert_quad_linear_id (q2, level);
+  if (id1 != id2) {
+    return id1 < id2 ? -1 : 1;
+  }
+  return (int) q1->level - (int) q2->level;
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_sibling (const t8_element_t * elem,
+                                              int sibid,
+                                              t8_element_t * sibling)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+  int                 state;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 < q->level);
+  T8_ASSERT (0 <= sibid && sibid < P4EST_CHILDREN);
+
+  state = t8_hilbert_quad_state (q, q->level - 1);
+  t8_default_scheme_quad_c::t8_element_sibling (elem,
+                                                t8_hilbert_quad_order[state]
+                                                [sibid], sibling);
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_child (const t8_element_t * elem,
+                                            int childid, t8_element_t * child)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+  int                 state;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= childid && childid < P4EST_CHILDREN);
+
+  state = t8_hilbert_quad_state (q, q->level);
+  t8_default_scheme_quad_c::t8_element_child (elem,
+                                              t8_hilbert_quad_order[state]
+                                              [childid], child);
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_children (const t8_element_t * elem,
+                                               int length, t8_element_t * c[])
+{
+  /* We work on a copy, since the usage allows for elem == c[0]. */
+  const p4est_quadrant_t parent = *(const p4est_quadrant_t *) elem;
+  int                 ichild, state;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (length == P4EST_CHILDREN);
+
+  state = t8_hilbert_quad_state (&parent, parent.level);
+  for (ichild = 0; ichild < P4EST_CHILDREN; ++ichild) {
+    t8_default_scheme_quad_c::t8_element_child ((const t8_element_t *)
+                                                &parent,
+                                                t8_hilbert_quad_order[state]
+                                                [ichild], c[ichild]);
+  }
+}
+
+int
+t8_hilbert_scheme_quad_c::t8_element_child_id (const t8_element_t * elem)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  return t8_element_ancestor_id (elem, q->level);
+}
+
+int
+t8_hilbert_scheme_quad_c::t8_element_ancestor_id (const t8_element_t * elem,
+                                                  int level)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+
+  T8_ASSERT (0 <= level && level <= q->level);
+  if (level == 0) {
+    return 0;
+  }
+  return t8_hilbert_quad_position[t8_hilbert_quad_state (q, level - 1)]
+    [t8_hilbert_quad_morton_id (q, level)];
+}
+
+int
+t8_hilbert_scheme_quad_c::t8_element_is_family (t8_element_t ** fam)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) fam[0];
+  t8_element_t       *morton_fam[P4EST_CHILDREN];
+  int                 ichild, state;
+
+#ifdef T8_ENABLE_DEBUG
+  for (ichild = 0; ichild < P4EST_CHILDREN; ichild++) {
+    T8_ASSERT (t8_element_is_valid (fam[ichild]));
+  }
+#endif
+  if (q->level == 0) {
+    return 0;
+  }
+  /* Sort the family into Morton order and let p4est check it */
+  state = t8_hilbert_quad_state (q, q->level - 1);
+  for (ichild = 0; ichild < P4EST_CHILDREN; ichild++) {
+    morton_fam[t8_hilbert_quad_order[state][ichild]] = fam[ichild];
+  }
+  return t8_default_scheme_quad_c::t8_element_is_family (morton_fam);
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_children_at_face (const t8_element_t *
+                                                       elem, int face,
+                                                       t8_element_t *
+                                                       children[],
+                                                       int num_children,
+                                                       int *child_indices)
+{
+  /* We work on a copy, since the usage allows for elem == children[0]. */
+  const p4est_quadrant_t parent = *(const p4est_quadrant_t *) elem;
+  const int           axis = face >> 1, side = face & 1;
+  int                 morton, ichild = 0, state;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < P4EST_FACES);
+  T8_ASSERT (num_children == t8_element_num_face_children (elem, face));
+
+  /* The children at the face in increasing Morton order are in the order
+   * of the face, exactly as in the default scheme. */
+  state = t8_hilbert_quad_state (&parent, parent.level);
+  for (morton = 0; morton < P4EST_CHILDREN; ++morton) {
+    if (((morton >> axis) & 1) != side) {
+      continue;
+    }
+    t8_default_scheme_quad_c::t8_element_child ((const t8_element_t *)
+                                                &parent, morton,
+                                                children[ichild]);
+    if (child_indices != NULL) {
+      child_indices[ichild] = t8_hilbert_quad_position[state][morton];
+    }
+    ++ichild;
+  }
+  T8_ASSERT (ichild == num_children);
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_first_descendant_face (const
+                                                            t8_element_t *
+                                                            elem, int face,
+                                                            t8_element_t *
+                                                            first_desc,
+                                                            int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_hilbert_quad_face_descendant ((const p4est_quadrant_t *) elem, face,
+                                   level, 0, (p4est_quadrant_t *) first_desc);
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_last_descendant_face (const
+                                                           t8_element_t *
+                                                           elem, int face,
+                                                           t8_element_t *
+                                                           last_desc,
+                                                           int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_hilbert_quad_face_descendant ((const p4est_quadrant_t *) elem, face,
+                                   level, 1, (p4est_quadrant_t *) last_desc);
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_set_linear_id (t8_element_t * elem,
+                                                    int level,
+                                                    t8_linearidx_t id)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
+  T8_ASSERT (0 <= id && id < ((t8_linearidx_t) 1) << P4EST_DIM * level);
+
+  t8_hilbert_quad_set_id ((p4est_quadrant_t *) elem, level, id);
+  T8_QUAD_SET_TDIM ((p4est_quadrant_t *) elem, 2);
+}
+
+t8_linearidx_t
+  t8_hilbert_scheme_quad_c::t8_element_get_linear_id (const t8_element_t *
+                                                      elem, int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
+
+  return t8_hilbert_quad_linear_id ((const p4est_quadrant_t *) elem, level);
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_first_descendant (const t8_element_t *
+                                                       elem,
+                                                       t8_element_t * desc,
+                                                       int level)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (desc));
+  T8_ASSERT (q->level <= level && level <= P4EST_QMAXLEVEL);
+
+  t8_hilbert_quad_set_id ((p4est_quadrant_t *) desc, level,
+                          t8_hilbert_quad_linear_id (q, level));
+  T8_QUAD_SET_TDIM ((p4est_quadrant_t *) desc, 2);
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_last_descendant (const t8_element_t *
+                                                      elem,
+                                                      t8_element_t * desc,
+                                                      int level)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+  t8_linearidx_t      id;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (desc));
+  T8_ASSERT (q->level <= level && level <= P4EST_QMAXLEVEL);
+
+  id = t8_hilbert_quad_linear_id (q, q->level) + 1;
+  t8_hilbert_quad_set_id ((p4est_quadrant_t *) desc, level,
+                          (id << P4EST_DIM * (level - q->level)) - 1);
+  T8_QUAD_SET_TDIM ((p4est_quadrant_t *) desc, 2);
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_successor (const t8_element_t * elem1,
+                                                t8_element_t * elem2,
+                                                int level)
+{
+  t8_linearidx_t      id;
+
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (t8_element_is_valid (elem2));
+  T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
+
+  id = t8_hilbert_quad_linear_id ((const p4est_quadrant_t *) elem1, level);
+  T8_ASSERT (id + 1 < ((t8_linearidx_t) 1) << P4EST_DIM * level);
+  /* Copying first keeps the surround of elem1 */
+  t8_element_copy (elem1, elem2);
+  t8_hilbert_quad_set_id ((p4est_quadrant_t *) elem2, level, id + 1);
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_child_id_array (const t8_element_t *
+                                                     elems, size_t count,
+                                                     int *child_ids)
+{
+  t8_eclass_scheme::t8_element_child_id_array (elems, count, child_ids);
+}
+
+void
+t8_hilbert_scheme_quad_c::t8_element_get_linear_id_array (const t8_element_t
+                                                          * elems,
+                                                          size_t count,
+                                                          int level,
+                                                          t8_linearidx_t *
+                                                          ids)
+{
+  t8_eclass_scheme::t8_element_get_linear_id_array (elems, count, level,
+                                                    ids);
+}
+
+int
+t8_hilbert_scheme_quad_c::t8_element_is_family_array (const t8_element_t *
+                                                      elems)
+{
+  return t8_eclass_scheme::t8_element_is_family_array (elems);
+}
+
+/* Constructor */
+t8_hilbert_scheme_quad_c::t8_hilbert_scheme_quad_c (void)
+{
+  /* The element storage is set up by the default quad scheme. */
+}
+
+t8_hilbert_scheme_quad_c::~t8_hilbert_scheme_quad_c ()
+{
+  /* The mempool is destroyed by the default_common scheme. */
+}
+
+T8_EXTERN_C_END ();
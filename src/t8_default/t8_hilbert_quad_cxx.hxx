@@ -0,0 +1,141 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_hilbert_quad_cxx.hxx
+ * A quadrilateral scheme that orders the elements along a Hilbert curve.
+ * The elements are the same p4est_quadrant_t objects as in the default
+ * quad scheme, so all geometric operations are inherited.  Only the
+ * operations that depend on the order of children and on the linear
+ * index are overridden.
+ */
+
+#ifndef T8_HILBERT_QUAD_CXX_HXX
+#define T8_HILBERT_QUAD_CXX_HXX
+
+#include "t8_default_quad_cxx.hxx"
+
+struct t8_hilbert_scheme_quad_c:public t8_default_scheme_quad_c
+{
+public:
+  /** Constructor. */
+  t8_hilbert_scheme_quad_c ();
+
+  ~t8_hilbert_scheme_quad_c ();
+
+/** Compare two elements with respect to the Hilbert order.
+ *  Returns negative if elem1 < elem2, zero if elem1 equals elem2
+ *  and positive if elem1 > elem2.
+ *  An ancestor is smaller than its descendants.
+ */
+  virtual int         t8_element_compare (const t8_element_t * elem1,
+                                          const t8_element_t * elem2);
+
+/** Construct a same-size sibling of a given element.
+ *  \a sibid is the position of the sibling along the curve. */
+  virtual void        t8_element_sibling (const t8_element_t * elem,
+                                          int sibid, t8_element_t * sibling);
+
+/** Construct the child of a given element at position \a childid along
+ *  the curve. */
+  virtual void        t8_element_child (const t8_element_t * elem,
+                                        int childid, t8_element_t * child);
+
+/** Construct all children of a given element in Hilbert order. */
+  virtual void        t8_element_children (const t8_element_t * elem,
+                                           int length, t8_element_t * c[]);
+
+/** Return the position of an element among its siblings. */
+  virtual int         t8_element_child_id (const t8_element_t * elem);
+
+/** Return the position of the ancestor of \a elem at \a level among its
+ *  siblings. */
+  virtual int         t8_element_ancestor_id (const t8_element_t * elem,
+                                              int level);
+
+/** Return nonzero if collection of elements is a family in Hilbert order. */
+  virtual int         t8_element_is_family (t8_element_t ** fam);
+
+/** Construct all children of an element at a given face.
+ *  The children are returned in the order of the face, as for the default
+ *  scheme, and \a child_indices holds their positions along the curve. */
+  virtual void        t8_element_children_at_face (const t8_element_t * elem,
+                                                   int face,
+                                                   t8_element_t * children[],
+                                                   int num_children,
+                                                   int *child_indices);
+
+/** Construct the first descendant along the curve that touches a face. */
+  virtual void        t8_element_first_descendant_face (const t8_element_t *
+                                                        elem, int face,
+                                                        t8_element_t *
+                                                        first_desc,
+                                                        int level);
+
+/** Construct the last descendant along the curve that touches a face. */
+  virtual void        t8_element_last_descendant_face (const t8_element_t *
+                                                       elem, int face,
+                                                       t8_element_t *
+                                                       last_desc, int level);
+
+/** Initialize an element according to a given Hilbert index. */
+  virtual void        t8_element_set_linear_id (t8_element_t * elem,
+                                                int level, t8_linearidx_t id);
+
+/** Calculate the Hilbert index of an element. */
+  virtual t8_linearidx_t t8_element_get_linear_id (const
+                                                   t8_element_t * elem,
+                                                   int level);
+
+/** Calculate the first descendant of a given element e. */
+  virtual void        t8_element_first_descendant (const t8_element_t *
+                                                   elem,
+                                                   t8_element_t * desc,
+                                                   int level);
+
+/** Calculate the last descendant of a given element e. */
+  virtual void        t8_element_last_descendant (const t8_element_t *
+                                                  elem,
+                                                  t8_element_t * desc,
+                                                  int level);
+
+/** Compute the next element along the curve at a given level. */
+  virtual void        t8_element_successor (const t8_element_t * t,
+                                            t8_element_t * s, int level);
+
+  /** The batched queries of the default scheme hardcode the Morton order,
+   * so we fall back to the loops over the scalar versions. */
+  virtual void        t8_element_child_id_array (const t8_element_t * elems,
+                                                 size_t count,
+                                                 int *child_ids);
+
+  /** Compute the Hilbert indices of contiguous elements. */
+  virtual void        t8_element_get_linear_id_array (const t8_element_t *
+                                                      elems, size_t count,
+                                                      int level,
+                                                      t8_linearidx_t * ids);
+
+  /** Return true if the contiguous elements form a family. */
+  virtual int         t8_element_is_family_array (const t8_element_t *
+                                                  elems);
+};
+
+#endif /* !T8_HILBERT_QUAD_CXX_HXX */
@@ -36,6 +36,15 @@ T8_EXTERN_C_BEGIN ();
 /** Return the default element implementation of t8code. */
 t8_scheme_cxx_t    *t8_scheme_new_default_cxx (void);
 
+/** Return the default element implementation of t8code with the quad and
+ * hex classes replaced by schemes that order the elements along a Hilbert
+ * curve instead of the Morton curve.
+ * The elements are stored just as in the default scheme, but their linear
+ * ids and the order of children differ.  Hence a forest must not be
+ * derived from a forest that uses the other curve.
+ */
+t8_scheme_cxx_t    *t8_scheme_new_hilbert_cxx (void);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_DEFAULT_H */
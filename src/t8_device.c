@@ -20,32 +20,27 @@
   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 */
 
-#include <t8_mesh.h>
+#include <t8_device.h>
 
-struct t8_mesh
+static void        *
+t8_device_host_alloc (size_t size, void *user_data)
 {
-  int                 t8_mesh_dummy;
-};
-
-t8_mesh_t          *
-t8_mesh_new (int dimension, t8_gloidx_t Kglobal, t8_locidx_t Klocal)
-{
-  return NULL;
+  return T8_ALLOC (char, size);
 }
 
-/* setters */
-
-void
-t8_mesh_set_comm (t8_mesh_t * mesh, sc_MPI_Comm comm)
+static void
+t8_device_host_free (void *ptr, void *user_data)
 {
+  T8_FREE (ptr);
 }
 
-void
-t8_mesh_build (t8_mesh_t * mesh)
+static void
+t8_device_host_copy (void *dest, const void *src, size_t size,
+                     void *user_data)
 {
+  memcpy (dest, src, size);
 }
 
-void
-t8_mesh_destroy (t8_mesh_t * mesh)
-{
-}
+const t8_device_ops_t t8_device_ops_host = {
+  t8_device_host_alloc, t8_device_host_free, t8_device_host_copy, NULL
+};
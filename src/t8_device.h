@@ -0,0 +1,90 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_device.h
+ * Building blocks to use t8code data on an accelerator.
+ *
+ * t8code does not depend on a GPU runtime. Functions that are marked with
+ * \ref T8_DEVICE_FUNC are header-only, work on plain element structs and
+ * do not call any library function, such that they compile for the host
+ * and for the device with CUDA or HIP. With SYCL, they can be called in
+ * kernels without any annotation.
+ * Memory on the device is handled by callbacks of the application,
+ * collected in \ref t8_device_ops_t.
+ * \see t8_default/t8_default_device.h, t8_forest/t8_forest_mirror.h
+ */
+
+#ifndef T8_DEVICE_H
+#define T8_DEVICE_H
+
+#include <t8.h>
+
+/** Mark a function to be compiled for the host and the device. */
+#if defined (__CUDACC__) || defined (__HIPCC__)
+#define T8_DEVICE_FUNC __host__ __device__
+#else
+#define T8_DEVICE_FUNC
+#endif
+
+/** Allocate memory on the device.
+ * \param [in] size       The number of bytes, greater zero.
+ * \param [in] user_data  The user data of \ref t8_device_ops_t.
+ * \return                The device memory.
+ */
+typedef void       *(*t8_device_alloc_fn) (size_t size, void *user_data);
+
+/** Free memory that was allocated with a \ref t8_device_alloc_fn.
+ * \param [in] ptr        The device memory.
+ * \param [in] user_data  The user data of \ref t8_device_ops_t.
+ */
+typedef void        (*t8_device_free_fn) (void *ptr, void *user_data);
+
+/** Copy memory from the host to the device.
+ * \param [in] dest       The device memory.
+ * \param [in] src        The host memory.
+ * \param [in] size       The number of bytes.
+ * \param [in] user_data  The user data of \ref t8_device_ops_t.
+ */
+typedef void        (*t8_device_copy_fn) (void *dest, const void *src,
+                                          size_t size, void *user_data);
+
+/** The memory operations of a device. */
+typedef struct t8_device_ops
+{
+  t8_device_alloc_fn  alloc;    /**< Allocate device memory. */
+  t8_device_free_fn   free;     /**< Free device memory. */
+  t8_device_copy_fn   copy_to_device; /**< Copy from the host to the device. */
+  void               *user_data; /**< Passed to the operations, for example
+                                      a stream or a queue. */
+}
+t8_device_ops_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** The memory operations of the host, with T8_ALLOC, T8_FREE and memcpy.
+ * Use them to run device code on the host or for testing.
+ */
+extern const t8_device_ops_t t8_device_ops_host;
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_DEVICE_H */
@@ -45,6 +45,22 @@ typedef struct t8_eclass_scheme t8_eclass_scheme_c;
 
 typedef struct t8_scheme_cxx t8_scheme_cxx_t;
 
+/** The transformation from a tree face to the face of the neighbor tree
+ * that it is connected to. It holds the arguments of
+ * t8_element_transform_face and t8_element_extrude_face that only depend on
+ * the tree connection, such that it can be computed once per tree face.
+ * \see t8_element_face_neighbor_across_tree in t8_element_cxx.hxx */
+typedef struct t8_element_face_transform
+{
+  int8_t              neigh_face;       /**< The face of the neighbor tree. */
+  int8_t              orientation;      /**< The orientation of the connection. */
+  int8_t              sign;             /**< True if both tree faces have the same
+                                             topological orientation. */
+  int8_t              is_smaller;       /**< True if the face of this tree is the
+                                             smaller face of the connection. */
+}
+t8_element_face_transform_t;
+
 /** The scheme holds implementations for one or more element classes. */
 struct t8_scheme_cxx
 {
@@ -21,6 +21,7 @@
 */
 
 #include <t8_element_cxx.hxx>
+#include <t8_element_scratch.hxx>
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -47,6 +48,8 @@ t8_scheme_cxx_destroy (t8_scheme_cxx_t * s)
     }
   }
   T8_FREE (s);
+  /* The elements of the scratch arena may belong to this scheme */
+  t8_element_scratch_finalize ();
 }
 
 /* *INDENT-OFF* */
@@ -68,6 +71,171 @@ t8_eclass_scheme::t8_element_array_index (sc_array_t * array, size_t it)
   return (t8_element_t *) sc_array_index (array, it);
 }
 
+/* Default implementation for the batched element queries.
+ * These loop over the elements and call the scalar version for each. */
+void
+t8_eclass_scheme::t8_element_level_array (const t8_element_t * elems,
+                                          size_t count, int *levels)
+{
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    levels[ielem] =
+      t8_element_level ((const t8_element_t *) ((const char *) elems +
+                                                ielem * element_size));
+  }
+}
+
+void
+t8_eclass_scheme::t8_element_child_id_array (const t8_element_t * elems,
+                                             size_t count, int *child_ids)
+{
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    child_ids[ielem] =
+      t8_element_child_id ((const t8_element_t *) ((const char *) elems +
+                                                   ielem * element_size));
+  }
+}
+
+void
+t8_eclass_scheme::t8_element_get_linear_id_array (const t8_element_t *
+                                                  elems, size_t count,
+                                                  int level,
+                                                  t8_linearidx_t * ids)
+{
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    ids[ielem] =
+      t8_element_get_linear_id ((const t8_element_t *) ((const char *) elems
+                                                        +
+                                                        ielem *
+                                                        element_size),
+                                level);
+  }
+}
+
+void
+t8_eclass_scheme::t8_element_vertex_coords_array (const t8_element_t *
+                                                  elems, size_t count,
+                                                  int vertex, int *coords)
+{
+  size_t              ielem;
+
+  for (ielem = 0; ielem < count; ++ielem) {
+    t8_element_vertex_coords ((const t8_element_t *) ((const char *) elems +
+                                                      ielem * element_size),
+                              vertex, coords + T8_ECLASS_MAX_DIM * ielem);
+  }
+}
+
+int
+t8_eclass_scheme::t8_element_is_family_array (const t8_element_t * elems)
+{
+  t8_element_t       *fam_buffer[T8_ECLASS_MAX_CORNERS];
+  t8_element_t      **fam = fam_buffer;
+  int                 ichild, num_children, is_family;
+
+  /* Only the pyramid has more children than corners */
+  num_children = t8_element_num_children (elems);
+  if (num_children > T8_ECLASS_MAX_CORNERS) {
+    fam = T8_ALLOC (t8_element_t *, num_children);
+  }
+  for (ichild = 0; ichild < num_children; ++ichild) {
+    fam[ichild] = (t8_element_t *) ((const char *) elems
+                                    + ichild * element_size);
+  }
+  is_family = t8_element_is_family (fam);
+  if (fam != fam_buffer) {
+    T8_FREE (fam);
+  }
+  return is_family;
+}
+
+int
+t8_eclass_scheme::t8_element_face_neighbor_across_tree (const t8_element_t *
+                                                        elem, int face,
+                                                        t8_eclass_scheme_c *
+                                                        boundary_scheme,
+                                                        t8_eclass_scheme_c *
+                                                        neigh_scheme,
+                                                        const
+                                                        t8_element_face_transform_t
+                                                        * transform,
+                                                        t8_element_t * neigh)
+{
+  t8_element_scratch_mark_t scratch_mark;
+  t8_element_t       *face_element;
+  int                 neigh_face;
+
+  /* Get the face element from the scratch arena, such that this
+   * function does not allocate and can be called by several threads. */
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (boundary_scheme, 1, &face_element);
+  t8_element_boundary_face (elem, face, face_element, boundary_scheme);
+  boundary_scheme->t8_element_transform_face (face_element, face_element,
+                                              transform->orientation,
+                                              transform->sign,
+                                              transform->is_smaller);
+  neigh_face =
+    neigh_scheme->t8_element_extrude_face (face_element, boundary_scheme,
+                                           neigh, transform->neigh_face);
+  t8_element_scratch_release (&scratch_mark);
+  return neigh_face;
+}
+
+int
+t8_eclass_scheme::t8_element_half_face_neighbors_inside (const t8_element_t *
+                                                         elem, int face,
+                                                         t8_element_t *
+                                                         neighs[],
+                                                         int num_neighs,
+                                                         int *dual_faces)
+{
+  t8_element_scratch_mark_t scratch_mark;
+  t8_element_t       *child;
+  int                 ineigh, child_face, neigh_face, is_inside = 1;
+
+  T8_ASSERT (num_neighs == t8_element_num_face_children (elem, face));
+
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (this, 1, &child);
+  t8_element_children_at_face (elem, face, neighs, num_neighs, NULL);
+  for (ineigh = 0; ineigh < num_neighs && is_inside; ++ineigh) {
+    child_face = t8_element_face_child_face (elem, face, ineigh);
+    t8_element_copy (neighs[ineigh], child);
+    is_inside = t8_element_face_neighbor_inside (child, neighs[ineigh],
+                                                 child_face, &neigh_face);
+    if (dual_faces != NULL) {
+      dual_faces[ineigh] = neigh_face;
+    }
+  }
+  t8_element_scratch_release (&scratch_mark);
+  return is_inside;
+}
+
+void
+t8_eclass_scheme::t8_element_set_linear_id_range (t8_element_t * elems,
+                                                  size_t count, int level,
+                                                  t8_linearidx_t id)
+{
+  t8_element_t       *elem, *elem_succ;
+  size_t              ielem;
+
+  if (count == 0) {
+    return;
+  }
+  t8_element_set_linear_id (elems, level, id);
+  elem = elems;
+  for (ielem = 1; ielem < count; ++ielem) {
+    elem_succ = (t8_element_t *) ((char *) elems + ielem * element_size);
+    t8_element_successor (elem, elem_succ, level);
+    elem = elem_succ;
+  }
+}
+
 T8_EXTERN_C_END ();
 
 #if 0
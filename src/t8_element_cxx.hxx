@@ -568,6 +568,147 @@ public:
   virtual void        t8_element_vertex_coords (const t8_element_t * t,
                                                 int vertex, int coords[]) = 0;
 
+  /** Compute the refinement levels of an array of elements.
+   * The elements are stored contiguously in memory, as for example in the
+   * data of a \ref t8_element_array_t.
+   * \param [in] elems   The first of \a count contiguous elements.
+   * \param [in] count   The number of elements.
+   * \param [out] levels An array of at least \a count integers. On output
+   *                     entry i is the level of the i-th element.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_level for each element. Implementations should override
+   * it with a loop that does not go through the virtual table.
+   */
+  virtual void        t8_element_level_array (const t8_element_t * elems,
+                                              size_t count, int *levels);
+
+  /** Compute the child ids of an array of elements.
+   * \param [in] elems   The first of \a count contiguous elements.
+   * \param [in] count   The number of elements.
+   * \param [out] child_ids An array of at least \a count integers. On output
+   *                     entry i is the child id of the i-th element.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_child_id for each element.
+   */
+  virtual void        t8_element_child_id_array (const t8_element_t * elems,
+                                                 size_t count,
+                                                 int *child_ids);
+
+  /** Compute the linear ids of an array of elements in a hypothetical
+   * uniform refinement of a given level.
+   * \param [in] elems   The first of \a count contiguous elements.
+   * \param [in] count   The number of elements.
+   * \param [in] level   The level of the uniform refinement to consider.
+   * \param [out] ids    An array of at least \a count linear ids. On output
+   *                     entry i is the linear id of the i-th element.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_get_linear_id for each element.
+   */
+  virtual void        t8_element_get_linear_id_array (const t8_element_t *
+                                                      elems, size_t count,
+                                                      int level,
+                                                      t8_linearidx_t * ids);
+
+  /** Compute the integer coordinates of one vertex for an array of elements.
+   * \param [in] elems   The first of \a count contiguous elements.
+   * \param [in] count   The number of elements.
+   * \param [in] vertex  The id of the vertex whose coordinates shall be computed.
+   * \param [out] coords An array of at least T8_ECLASS_MAX_DIM * \a count integers.
+   *                     The coordinates of the i-th element's vertex are
+   *                     written to coords[T8_ECLASS_MAX_DIM * i + d] for each
+   *                     d smaller than the element's dimension.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_vertex_coords for each element.
+   */
+  virtual void        t8_element_vertex_coords_array (const t8_element_t *
+                                                      elems, size_t count,
+                                                      int vertex,
+                                                      int *coords);
+
+  /** Query whether contiguous elements form a family.
+   * \param [in] elems   The first of \ref t8_element_num_children of
+   *                     \a elems contiguous elements.
+   * \return             True if the elements form a family in their order.
+   * We provide a default implementation of this routine that collects
+   * pointers to the elements and calls \ref t8_element_is_family.
+   * Implementations should override it to test the array directly.
+   */
+  virtual int         t8_element_is_family_array (const t8_element_t *
+                                                  elems);
+
+  /** Construct the same level face neighbor of an element across a face
+   * of its root tree.
+   * \param [in] elem    The element.
+   * \param [in] face    A face of \a elem that lies on a tree face.
+   * \param [in] boundary_scheme The scheme of the class of the tree face.
+   * \param [in] neigh_scheme The scheme of the neighbor tree.
+   * \param [in] transform The transformation of the tree face to the
+   *                     neighbor tree.
+   * \param [in,out] neigh An allocated element of \a neigh_scheme. On output
+   *                     the face neighbor of \a elem in the neighbor tree.
+   * \return             The face of \a neigh that coincides with \a face.
+   * This is \ref t8_element_boundary_face followed by
+   * \ref t8_element_transform_face and \ref t8_element_extrude_face, which
+   * is what the default implementation does with a scratch face element.
+   * Implementations should override it to compute the neighbor directly.
+   */
+  virtual int         t8_element_face_neighbor_across_tree (const
+                                                            t8_element_t *
+                                                            elem, int face,
+                                                            t8_eclass_scheme_c
+                                                            * boundary_scheme,
+                                                            t8_eclass_scheme_c
+                                                            * neigh_scheme,
+                                                            const
+                                                            t8_element_face_transform_t
+                                                            * transform,
+                                                            t8_element_t *
+                                                            neigh);
+
+  /** Construct the same level face neighbors of the children of an element
+   * at a face, if they are inside the root tree.
+   * \param [in] elem    The element.
+   * \param [in] face    A face of \a elem.
+   * \param [in,out] neighs An array of \a num_neighs allocated elements.
+   *                     On output entry i is the face neighbor of the i-th
+   *                     child at \a face, in the order of
+   *                     \ref t8_element_children_at_face, across this face.
+   * \param [in] num_neighs The number of children of \a elem at \a face.
+   * \param [out] dual_faces If not NULL, an array of \a num_neighs integers.
+   *                     On output the faces of the neighbors that coincide
+   *                     with \a face.
+   * \return             True if the neighbors are inside the root tree.
+   *                     Otherwise the entries of \a neighs are undefined.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_children_at_face and \ref t8_element_face_neighbor_inside
+   * for each child. Implementations should override it with a direct
+   * computation.
+   */
+  virtual int         t8_element_half_face_neighbors_inside (const
+                                                             t8_element_t *
+                                                             elem, int face,
+                                                             t8_element_t *
+                                                             neighs[],
+                                                             int num_neighs,
+                                                             int *dual_faces);
+
+  /** Initialize an array of elements as the elements with consecutive
+   * linear ids in a uniform refinement of a given level.
+   * \param [in,out] elems The first of \a count contiguous elements.
+   * \param [in] count   The number of elements.
+   * \param [in] level   The level of the uniform refinement to consider.
+   * \param [in] id      The linear id of the first element. The last element
+   *                     gets the id \a id + \a count - 1, which must be smaller
+   *                     than the number of elements at \a level.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_set_linear_id for the first element and
+   * \ref t8_element_successor for the others.
+   */
+  virtual void        t8_element_set_linear_id_range (t8_element_t * elems,
+                                                      size_t count,
+                                                      int level,
+                                                      t8_linearidx_t id);
+
   /* TODO: deactivate */
   /** Return a pointer to a t8_element in an array indexed by a size_t.
    * \param [in] array    The \ref sc_array storing \t t8_element_t pointers.
@@ -0,0 +1,192 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_element_scratch.hxx>
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#include <omp.h>
+#endif
+
+/* The storage class for the per thread arena */
+#if defined (__GNUC__)
+#define T8_SCRATCH_THREAD_LOCAL __thread
+#else
+#define T8_SCRATCH_THREAD_LOCAL thread_local
+#endif
+
+/* The default size in bytes of a block of the arena */
+#define T8_SCRATCH_BLOCK_SIZE 16384
+
+/* The alignment in bytes of each allocation in a block */
+#define T8_SCRATCH_ALIGN 16
+
+typedef struct t8_element_scratch_block
+{
+  char               *data;
+  size_t              size;
+} t8_element_scratch_block_t;
+
+/* The arena of one thread. It is a stack of blocks, of which the blocks
+ * up to current are in use. The blocks after current are kept for reuse. */
+typedef struct t8_element_scratch_arena
+{
+  t8_element_scratch_block_t *blocks;
+  int                 num_blocks;
+  int                 current;
+  size_t              offset;
+} t8_element_scratch_arena_t;
+
+/* We use malloc and free for the arena, since the sc allocation
+ * functions count the allocations in global variables and are thus
+ * not thread-safe. */
+static T8_SCRATCH_THREAD_LOCAL t8_element_scratch_arena_t t8_scratch_arena =
+  { NULL, 0, 0, 0 };
+
+T8_EXTERN_C_BEGIN ();
+
+/* Ensure that block number iblock exists and has at least size bytes.
+ * The block must not be in use. */
+static void
+t8_element_scratch_block_ensure (t8_element_scratch_arena_t * arena,
+                                 int iblock, size_t size)
+{
+  t8_element_scratch_block_t *block;
+
+  T8_ASSERT (0 <= iblock && iblock <= arena->num_blocks);
+  if (iblock == arena->num_blocks) {
+    arena->blocks = (t8_element_scratch_block_t *)
+      realloc (arena->blocks, (iblock + 1) * sizeof (*arena->blocks));
+    SC_CHECK_ABORT (arena->blocks != NULL, "Element scratch out of memory");
+    arena->blocks[iblock].data = NULL;
+    arena->blocks[iblock].size = 0;
+    arena->num_blocks++;
+  }
+  block = arena->blocks + iblock;
+  if (block->size < size) {
+    size = SC_MAX (size, T8_SCRATCH_BLOCK_SIZE);
+    free (block->data);
+    block->data = (char *) malloc (size);
+    SC_CHECK_ABORT (block->data != NULL, "Element scratch out of memory");
+    block->size = size;
+  }
+}
+
+void
+t8_element_scratch_mark (t8_element_scratch_mark_t * mark)
+{
+  T8_ASSERT (mark != NULL);
+
+  mark->block = t8_scratch_arena.current;
+  mark->offset = t8_scratch_arena.offset;
+}
+
+void               *
+t8_element_scratch_alloc (size_t bytes)
+{
+  t8_element_scratch_arena_t *arena = &t8_scratch_arena;
+  size_t              offset;
+
+  T8_ASSERT (bytes > 0);
+
+  /* Align the start of the memory */
+  offset = (arena->offset + T8_SCRATCH_ALIGN - 1) / T8_SCRATCH_ALIGN
+    * T8_SCRATCH_ALIGN;
+  if (arena->num_blocks == 0) {
+    t8_element_scratch_block_ensure (arena, 0, bytes);
+    offset = 0;
+  }
+  else if (offset + bytes > arena->blocks[arena->current].size) {
+    /* The memory does not fit into the current block, we continue
+     * with the next one */
+    arena->current++;
+    t8_element_scratch_block_ensure (arena, arena->current, bytes);
+    offset = 0;
+  }
+  arena->offset = offset + bytes;
+  return arena->blocks[arena->current].data + offset;
+}
+
+void
+t8_element_scratch_get (t8_eclass_scheme_c * ts, int length,
+                        t8_element_t ** elems)
+{
+  const size_t        element_size = ts->t8_element_size ();
+  char               *data;
+  int                 ielem;
+
+  T8_ASSERT (0 <= length);
+  T8_ASSERT (elems != NULL);
+
+  if (length == 0) {
+    return;
+  }
+  data = (char *) t8_element_scratch_alloc (length * element_size);
+
+  for (ielem = 0; ielem < length; ++ielem) {
+    elems[ielem] = (t8_element_t *) (data + ielem * element_size);
+  }
+  ts->t8_element_init (length, (t8_element_t *) data, 0);
+}
+
+void
+t8_element_scratch_release (const t8_element_scratch_mark_t * mark)
+{
+  T8_ASSERT (mark != NULL);
+  /* We can only go back in the arena */
+  T8_ASSERT (mark->block < t8_scratch_arena.current
+             || (mark->block == t8_scratch_arena.current
+                 && mark->offset <= t8_scratch_arena.offset));
+
+  t8_scratch_arena.current = mark->block;
+  t8_scratch_arena.offset = mark->offset;
+}
+
+void
+t8_element_scratch_finalize (void)
+{
+  t8_element_scratch_arena_t *arena = &t8_scratch_arena;
+  int                 iblock;
+
+  if (arena->current != 0 || arena->offset != 0) {
+    /* Elements of the arena are still in use */
+    return;
+  }
+  for (iblock = 0; iblock < arena->num_blocks; ++iblock) {
+    free (arena->blocks[iblock].data);
+  }
+  free (arena->blocks);
+  arena->blocks = NULL;
+  arena->num_blocks = 0;
+  arena->current = 0;
+  arena->offset = 0;
+}
+
+void
+t8_element_scratch_finalize_worker (void)
+{
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+  if (omp_get_thread_num () != 0) {
+    t8_element_scratch_finalize ();
+  }
+#endif
+}
+
+T8_EXTERN_C_END ();
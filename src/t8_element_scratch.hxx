@@ -0,0 +1,116 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_element_scratch.hxx
+ * A thread-local arena for temporary elements.
+ *
+ * Algorithms that need a few elements for a limited scope, for example the
+ * children of an element during a recursion, can take them from the scratch
+ * arena instead of calling \ref t8_eclass_scheme_c::t8_element_new.
+ * The arena is a stack of memory blocks that belongs to the calling thread.
+ * Getting elements does not lock and usually only moves a pointer.
+ * The elements are not freed individually. Instead the position
+ * of the arena is stored with \ref t8_element_scratch_mark before getting
+ * elements, and all elements that were obtained after this mark are
+ * released at once by \ref t8_element_scratch_release.
+ *
+ * A typical use is
+ *
+ *     t8_element_scratch_mark_t mark;
+ *
+ *     t8_element_scratch_mark (&mark);
+ *     t8_element_scratch_get (ts, num_children, children);
+ *     ts->t8_element_children (element, num_children, children);
+ *     ...
+ *     t8_element_scratch_release (&mark);
+ *
+ * Marks must be released in reverse order.
+ * Elements from the scratch arena must not be passed to
+ * \ref t8_eclass_scheme_c::t8_element_destroy.
+ */
+
+#ifndef T8_ELEMENT_SCRATCH_HXX
+#define T8_ELEMENT_SCRATCH_HXX
+
+#include <t8_element_cxx.hxx>
+
+T8_EXTERN_C_BEGIN ();
+
+/** A position in the scratch arena of a thread. */
+typedef struct t8_element_scratch_mark
+{
+  int                 block;    /**< The index of the current block */
+  size_t              offset;   /**< The number of used bytes in this block */
+} t8_element_scratch_mark_t;
+
+/** Store the current position of the scratch arena of the calling thread.
+ * \param [out] mark   On output the current position.
+ */
+void                t8_element_scratch_mark (t8_element_scratch_mark_t *
+                                             mark);
+
+/** Get initialized temporary elements from the scratch arena of the
+ * calling thread. The elements stay valid until the arena is released
+ * to a mark that was taken before this call.
+ * \param [in] ts      The scheme of the elements.
+ * \param [in] length  The number of elements.
+ * \param [out] elems  An array of \a length element pointers. On output
+ *                     they point to contiguous elements for which
+ *                     \ref t8_eclass_scheme_c::t8_element_init was called.
+ */
+void                t8_element_scratch_get (t8_eclass_scheme_c * ts,
+                                            int length,
+                                            t8_element_t ** elems);
+
+/** Get temporary memory from the scratch arena of the calling thread,
+ * for example for an array of element pointers. The memory is released
+ * together with the elements.
+ * \param [in] bytes   The number of bytes, greater zero.
+ * \return             Memory of \a bytes bytes, aligned to 16 bytes.
+ */
+void               *t8_element_scratch_alloc (size_t bytes);
+
+/** Release all elements that were obtained from the scratch arena of the
+ * calling thread after a given mark was taken.
+ * \param [in] mark    A mark taken by this thread with \ref t8_element_scratch_mark.
+ */
+void                t8_element_scratch_release (const
+                                                t8_element_scratch_mark_t *
+                                                mark);
+
+/** Free the memory of the scratch arena of the calling thread.
+ * If elements of the arena are still in use, the arena is kept and this
+ * call has no effect. The arena can be used again after this call.
+ * The arena of the main thread is freed when a scheme is destroyed.
+ */
+void                t8_element_scratch_finalize (void);
+
+/** Free the scratch arena of the calling thread if it is a worker thread
+ * of an OpenMP team. Call this at the end of a parallel region, since the
+ * threads of the team are reused for other regions and their arenas
+ * would never be freed otherwise. The arena of the master thread is kept.
+ */
+void                t8_element_scratch_finalize_worker (void);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_ELEMENT_SCRATCH_HXX */
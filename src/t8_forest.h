@@ -31,6 +31,8 @@
 
 #include <t8_cmesh.h>
 #include <t8_element.h>
+#include <t8_quadrature.h>
+#include <t8_profile.h>
 #include <t8_data/t8_containers.h>
 
 /** Opaque pointer to a forest implementation. */
@@ -38,8 +40,9 @@ typedef struct t8_forest *t8_forest_t;
 typedef struct t8_tree *t8_tree_t;
 
 /** This type controls, which neighbors count as ghost elements.
- * Currently, we support face-neighbors. Vertex and edge neighbors
- * will eventually be added. */
+ * Face-neighbors are supported for all forests, edge and vertex neighbors
+ * for forests of only lines, only quadrilaterals or only hexahedra.
+ * In two dimensions the edge neighbors are the vertex neighbors. */
 typedef enum
 {
   T8_GHOST_NONE = 0,  /**< Do not create ghost layer. */
@@ -48,6 +51,51 @@ typedef enum
   T8_GHOST_VERTICES   /**< Consider all vertex (codimension 3) and edge and face neighbors. */
 } t8_ghost_type_t;
 
+/** The components of the memory used by a forest.
+ * \see t8_forest_memory_usage */
+typedef enum
+{
+  T8_FOREST_MEMORY_TREES = 0, /**< The forest struct and its array of trees. */
+  T8_FOREST_MEMORY_ELEMENTS,  /**< The element arrays of the local trees,
+                                   without the trees shared with other
+                                   forests. */
+  T8_FOREST_MEMORY_OFFSETS,   /**< The partition tables, that is the element,
+                                   tree and first descendant offsets. */
+  T8_FOREST_MEMORY_GHOST,     /**< The ghost trees, ghost elements and remote
+                                   element lists. */
+  T8_FOREST_MEMORY_GHOST_HASH, /**< The hash tables and memory pools of the
+                                    ghost layer. */
+  T8_FOREST_MEMORY_ADAPT_MAP, /**< The recorded adapt map. */
+  T8_FOREST_MEMORY_CONNECTIVITY, /**< The face connectivity table. */
+  T8_FOREST_MEMORY_GEOMETRY,  /**< The geometry cache and the element to
+                                   tree index. */
+  T8_FOREST_MEMORY_FIELDS,    /**< The element data fields. */
+  T8_FOREST_MEMORY_COUNT      /**< The number of components. */
+} t8_forest_memory_t;
+
+/** The values of an accumulated forest profile */
+typedef enum t8_forest_profile_value
+{
+  T8_FOREST_PROFILE_ELEMENTS = 0,       /**< The number of local elements. */
+  T8_FOREST_PROFILE_GHOSTS,     /**< The number of ghost elements. */
+  T8_FOREST_PROFILE_BYTES_SENT, /**< The bytes sent by partition. */
+  T8_FOREST_PROFILE_ADAPT_RUNTIME,      /**< The runtime of adapt. */
+  T8_FOREST_PROFILE_PARTITION_RUNTIME,  /**< The runtime of partition. */
+  T8_FOREST_PROFILE_GHOST_RUNTIME,      /**< The runtime of ghost. */
+  T8_FOREST_PROFILE_BALANCE_RUNTIME,    /**< The runtime of balance. */
+  T8_FOREST_PROFILE_COMMIT_RUNTIME,     /**< The runtime of commit. */
+  T8_FOREST_PROFILE_COUNT       /**< The number of values. */
+} t8_forest_profile_value_t;
+
+/** The sums of the profiled values of many commits on one process,
+ * \see t8_forest_profile_accumulate. */
+typedef struct t8_forest_profile_accum
+{
+  int                 num_commits;      /**< The number of accumulated commits. */
+  double              sums[T8_FOREST_PROFILE_COUNT];    /**< The sum of each value
+                                                             over the commits. */
+} t8_forest_profile_accum_t;
+
 T8_EXTERN_C_BEGIN ();
 
 /* TODO: if eclass is a vertex then num_outgoing/num_incoming are always
@@ -88,6 +136,46 @@ typedef void        (*t8_forest_replace_t) (t8_forest_t forest_old,
                                             int num_incoming,
                                             t8_locidx_t first_incoming);
 
+/** A run of the map from the elements of an adapted forest to the elements
+ * of the forest that it was adapted from.
+ * A run consists of \a count consecutive replacements of \a num_old old
+ * elements by \a num_new new elements in one tree:
+ * num_old = num_new = 1 if the elements were kept, num_old = 1 if an element
+ * was refined and num_new = 1 if a family was coarsened.
+ * All element indices are local in the tree. */
+typedef struct t8_forest_adapt_run
+{
+  t8_locidx_t         ltree_id;         /**< The local tree of the run. */
+  t8_locidx_t         first_old;        /**< The index of the first old element. */
+  t8_locidx_t         first_new;        /**< The index of the first new element. */
+  t8_locidx_t         count;            /**< The number of replacements. */
+  int                 num_old;          /**< The number of old elements of each replacement. */
+  int                 num_new;          /**< The number of new elements of each replacement. */
+}
+t8_forest_adapt_run_t;
+
+/** Callback function prototype to replace the data of all elements of a tree
+ * at once. The replacements are given as runs, each run consists of
+ * \a count replacements of the same kind: The old elements
+ * first_old, ..., first_old + count * num_old - 1 are replaced by the
+ * new elements first_new, ..., first_new + count * num_new - 1.
+ * \param [in] forest_old      The forest that is adapted
+ * \param [in] forest_new      The forest that is newly constructed from \a forest_old
+ * \param [in] which_tree      The local tree of the runs
+ * \param [in] ts              The eclass scheme of the tree
+ * \param [in] num_runs        The number of runs, at least one.
+ * \param [in] runs            The runs of the tree, sorted by their
+ *                             first element.
+ * \see t8_forest_iterate_replace_batch
+ */
+typedef void        (*t8_forest_replace_batch_t) (t8_forest_t forest_old,
+                                                  t8_forest_t forest_new,
+                                                  t8_locidx_t which_tree,
+                                                  t8_eclass_scheme_c * ts,
+                                                  size_t num_runs,
+                                                  const t8_forest_adapt_run_t
+                                                  * runs);
+
 /** Callback function prototype to decide for refining and coarsening.
  * If the \a num_elements equals the number of children then the elements
  * form a family and we decide whether this family should be coarsened
@@ -115,6 +203,49 @@ typedef int         (*t8_forest_adapt_t) (t8_forest_t forest,
                                           int num_elements,
                                           t8_element_t * elements[]);
 
+/** Callback function prototype to decide for refining and coarsening of
+ * all elements of a tree at once.
+ * The callback writes one marker for each element of the tree:
+ * a value greater zero if the element should be refined, a value smaller
+ * zero if it may be coarsened and zero else. A family is coarsened if all
+ * of its members are marked for coarsening.
+ * \param [in] forest      the forest to which the new elements belong
+ * \param [in] forest_from the forest that is adapted.
+ * \param [in] which_tree  the local tree containing \a elements
+ * \param [in] lelement_offset the local id in \a forest_from of the first
+ *                         element of the tree.
+ * \param [in] ts          the eclass scheme of the tree
+ * \param [in] elements    The elements of the tree in \a forest_from.
+ * \param [out] markers    An array with one entry for each element in
+ *                         \a elements. On output the markers.
+ */
+typedef void        (*t8_forest_adapt_tree_t) (t8_forest_t forest,
+                                               t8_forest_t forest_from,
+                                               t8_locidx_t which_tree,
+                                               t8_locidx_t lelement_offset,
+                                               t8_eclass_scheme_c * ts,
+                                               t8_element_array_t *
+                                               elements, int8_t * markers);
+
+/** Callback function prototype for the weight of an element in partition.
+ * The weight is the relative cost of the element, for example the number of
+ * time steps that it needs. Partition assigns each process a part of the
+ * elements with about the same sum of weights.
+ * \param [in] forest_from the forest that is partitioned.
+ * \param [in] which_tree  the local tree containing \a element
+ * \param [in] lelement_id the local element id of \a element in the tree
+ * \param [in] ts          the eclass scheme of the tree
+ * \param [in] element     the element
+ * \return                 The weight of \a element. Must not be negative.
+ * \see t8_forest_set_partition_weights
+ */
+typedef double      (*t8_forest_partition_weight_t) (t8_forest_t forest_from,
+                                                     t8_locidx_t which_tree,
+                                                     t8_locidx_t lelement_id,
+                                                     t8_eclass_scheme_c * ts,
+                                                     const t8_element_t *
+                                                     element);
+
   /** Create a new forest with reference count one.
  * This forest needs to be specialized with the t8_forest_set_* calls.
  * Currently it is manatory to either call the functions \ref
@@ -161,6 +292,25 @@ int                 t8_forest_is_committed (t8_forest_t forest);
 int                 t8_forest_is_equal (t8_forest_t forest_a,
                                         t8_forest_t forest_b);
 
+/** Compute a 128 bit fingerprint of the leaf elements of a committed forest.
+ * The fingerprint hashes the global tree id, the linear id and the level of
+ * each leaf together with its global index, such that two forests with the
+ * same leaves in the same order have the same fingerprint on all processes,
+ * independent of their partition. Different forests have different
+ * fingerprints with overwhelming probability, thus it detects cheaply
+ * whether a forest changed, for example to skip output or to key caches
+ * of the geometry or the connectivity of a forest.
+ * The leaves are hashed by the threads of t8code and the process results
+ * are combined with one allreduce. The result is stored in the forest, such
+ * that further calls return immediately.
+ * \param [in]  forest       A committed forest.
+ * \param [out] fingerprint  On output the two 64 bit words of the fingerprint.
+ * \note This function is collective on its first call for \a forest.
+ * \see t8_forest_is_equal for an exact, but local and slower, comparison.
+ */
+void                t8_forest_get_fingerprint (t8_forest_t forest,
+                                               uint64_t fingerprint[2]);
+
 /** Set the cmesh associated to a forest.
  * By default, the forest takes ownership of the cmesh such that it will be
  * destroyed when the forest is destroyed.  To keep ownership of the cmesh,
@@ -243,6 +393,53 @@ void                t8_forest_set_adapt (t8_forest_t forest,
                                          t8_forest_adapt_t adapt_fn,
                                          int recursive);
 
+/** Set a source forest to be adapted on commiting with a callback that
+ * decides for all elements of a tree at once.
+ * This is an alternative to \ref t8_forest_set_adapt for refinement
+ * indicators that are computed in a loop over the user's own data.
+ * The adaptation is not recursive.
+ * \param [in,out] forest   The forest
+ * \param [in] set_from     The source forest from which \b forest will be adapted.
+ *                          The same rules as for \ref t8_forest_set_adapt apply.
+ * \param [in] adapt_tree_fn The callback that computes the markers of a tree.
+ * \note This setting can be combined and not be combined with the same
+ * settings as \ref t8_forest_set_adapt.
+ */
+void                t8_forest_set_adapt_tree (t8_forest_t forest,
+                                              const t8_forest_t set_from,
+                                              t8_forest_adapt_tree_t
+                                              adapt_tree_fn);
+
+/** Set a source forest to be adapted on commiting from an array of
+ * refinement markers instead of a callback.
+ * There is one marker for each local element of \a set_from:
+ * a value greater zero refines the element, a value smaller zero coarsens
+ * it and zero keeps it. A family is coarsened if all of its members are
+ * marked for coarsening.
+ * \param [in,out] forest   The forest
+ * \param [in] set_from     The source forest from which \b forest will be adapted.
+ *                          The same rules as for \ref t8_forest_set_adapt apply.
+ * \param [in] markers      An array with one entry for each local element
+ *                          of \a set_from, indexed by the local element id.
+ *                          It must stay valid until \b forest is committed.
+ * \param [in] recursive    If nonzero, a marker m is the number of levels
+ *                          by which an element is refined (m > 0) or
+ *                          coarsened (m < 0). The children of a refined
+ *                          element are refined until they are m levels finer,
+ *                          new parents are coarsened further while they are
+ *                          less than |m| levels coarser than the element.
+ *                          A new parent is only coarsened further if this
+ *                          holds for all elements of \a set_from that it
+ *                          covers.
+ *                          If zero, each element is refined or coarsened once.
+ * \note This setting can be combined and not be combined with the same
+ * settings as \ref t8_forest_set_adapt.
+ */
+void                t8_forest_set_adapt_markers (t8_forest_t forest,
+                                                 const t8_forest_t set_from,
+                                                 const int8_t * markers,
+                                                 int recursive);
+
 /** Set the user data of a forest. This can i.e. be used to pass user defined
  * arguments to the adapt routine.
  * \param [in,out] forest   The forest
@@ -268,9 +465,11 @@ void               *t8_forest_get_user_data (t8_forest_t forest);
  *                          referencing \b set_from.
  *                          If NULL, a previously (or later) set forest will
  *                          be taken (\ref t8_forest_set_adapt, \ref t8_forest_set_balance).
- * \param [in]      set_for_coarsening CURRENTLY DISABLED. If true, then the partitions
+ * \param [in]      set_for_coarsening If true, then the partitions
  *                          are choose such that coarsening an element once is a process local
- *                          operation.
+ *                          operation. A process boundary that lies inside a family
+ *                          of leaves is moved to the first element of this family.
+ *                          Thus, the processes may differ by more than one element.
  * \note This setting can be combined with \ref t8_forest_set_adapt and \ref
  * t8_forest_set_balance. The order in which these operations are executed is always
  * 1) Adapt 2) Balance 3) Partition
@@ -278,11 +477,100 @@ void               *t8_forest_get_user_data (t8_forest_t forest);
  * false, it is not neccessary to call \ref t8_forest_set_partition additionally.
  * \note This setting may not be combined with \ref t8_forest_set_copy and overwrites
  * this setting.
+ * \note Consecutive pieces of the SFC go to consecutive ranks. To place them
+ * on the same shared memory node first, build the cmesh and forest on the
+ * communicator of \ref t8_shmem_comm_node_ordered.
  */
 void                t8_forest_set_partition (t8_forest_t forest,
                                              const t8_forest_t set_from,
                                              int set_for_coarsening);
 
+/** Partition the elements by weight instead of by count.
+ * The elements are assigned to the processes along the SFC such that each
+ * process gets about the same sum of element weights.
+ * The weights are either computed by a callback or given as an array.
+ * If the sum of all weights is zero, the elements are partitioned by count.
+ * \param [in, out] forest  The forest.
+ * \param [in]      weight_fn If not NULL, the callback that computes the
+ *                          weight of each element of the partitioned forest.
+ * \param [in]      weights  If not NULL, the weight of each local element of
+ *                          the partitioned forest, indexed by its local id.
+ *                          Must stay valid until \a forest is committed.
+ *                          Can only be used if \a forest is not adapted in
+ *                          the same commit.
+ * At most one of \a weight_fn and \a weights may be given. If both are NULL,
+ * the elements are partitioned by count.
+ * \note Balance with repartitioning partitions by count.
+ * \note The forest must not be committed before calling this function.
+ * \see t8_forest_set_partition_eclass_costs
+ */
+void                t8_forest_set_partition_weights (t8_forest_t forest,
+                                                     t8_forest_partition_weight_t
+                                                     weight_fn,
+                                                     const double *weights);
+
+/** Set the cost of an element of each element class for partition.
+ * The weight of an element is its weight from
+ * \ref t8_forest_set_partition_weights, or 1 if no weights are set,
+ * times the cost of its element class. Thus, on hybrid meshes, the
+ * processes get about the same amount of work even if the elements of
+ * different classes need different amounts of work.
+ * If no costs are set, the costs of the cmesh are used,
+ * see \ref t8_cmesh_set_partition_eclass_costs.
+ * \param [in, out] forest  The forest.
+ * \param [in]      costs   An array of \ref T8_ECLASS_COUNT positive costs,
+ *                          for example 1 for hexahedra, 0.8 for prisms and 0.6
+ *                          for tetrahedra. Must stay valid until \a forest is
+ *                          committed. If NULL, the costs of the cmesh are used.
+ * \note The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_partition_eclass_costs (t8_forest_t forest,
+                                                          const double
+                                                          *costs);
+
+/** Skip the partition if the load is already nearly balanced.
+ * On commit, the load of a process is its number of elements, or the sum
+ * of its element weights if weights or costs are set, see
+ * \ref t8_forest_set_partition_weights. One reduction computes the ratio of the
+ * maximum and the average load. If it is at most \a max_imbalance, the
+ * elements are not sent. The forest keeps the partition of the forest it is
+ * partitioned from and takes over its element offsets, first descendants
+ * and tree offsets.
+ * \param [in, out] forest  The forest.
+ * \param [in]      max_imbalance The tolerance, for example 1.05 allows
+ *                          5 percent more load on a process than on average.
+ *                          If smaller than 1, the forest is always
+ *                          partitioned. This is the default.
+ * \note The partition is never skipped if \a set_for_coarsening is
+ * true in \ref t8_forest_set_partition.
+ * \note The decision is recorded in the profile of the forest,
+ * see \ref t8_forest_set_profiling.
+ * \note The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_partition_imbalance (t8_forest_t forest,
+                                                       double max_imbalance);
+
+/** Let the nonempty processes continue on their own communicator.
+ * If after the partition on commit some processes have no elements, the
+ * communicator of the forest is split into the processes with elements and
+ * the idle processes without. Each group then holds a forest of its own,
+ * on the idle processes without any elements, such that the collective
+ * operations of the forests derived by adapt and balance, for example
+ * ghost creation and the partition tables, only involve the processes of
+ * one group. The next partition of a derived forest distributes the
+ * elements over all processes of the original communicator again.
+ * \param [in, out] forest  The forest.
+ * \param [in]      shrink  If true, the communicator is split.
+ * \note The split needs a communicator that is not duplicated by the forest,
+ * see \ref t8_forest_set_mpicomm, and a replicated cmesh.
+ * \note Output functions like \ref t8_forest_write_vtk write the elements of
+ * the nonempty processes and do nothing on the idle processes.
+ * \see t8_forest_is_idle
+ * \note The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_shrink_comm (t8_forest_t forest,
+                                               int shrink);
+
 /** Set a source forest to be balanced during commit.
  * A forest is said to be balanced if each element has face neighbors of level
  * at most +1 or -1 of the element's level.
@@ -303,6 +591,9 @@ void                t8_forest_set_partition (t8_forest_t forest,
  * \note This setting can be combined with \ref t8_forest_set_adapt and \ref
  * t8_forest_set_balance. The order in which these operations are executed is always
  * 1) Adapt 2) Balance 3) Partition.
+ * \note If a face ghost layer is set with \ref t8_forest_set_ghost, the
+ * ghost layer of the last balance round is reused instead of being created
+ * again.
  * \note This setting may not be combined with \ref t8_forest_set_copy and overwrites
  * this setting.
  */
@@ -310,13 +601,53 @@ void                t8_forest_set_balance (t8_forest_t forest,
                                            const t8_forest_t set_from,
                                            int no_repartition);
 
+/** Select the algorithm that balances a forest.
+ * By default, each round of balance refines the elements once and then
+ * creates a new ghost layer (or repartitions the forest).
+ * With the ripple algorithm, the refinement is repeated on the local
+ * elements until it is locally stable, before a new ghost layer is created.
+ * Thus only refinement that ripples across process boundaries needs another
+ * ghost round. Each local round only costs the global element count and
+ * one reduction.
+ * \param [in,out] forest  The forest to be updated.
+ * \param [in]     ripple  If true, the ripple algorithm is used.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_balance_ripple (t8_forest_t forest,
+                                                  int ripple);
+
+/** Restrict the checks of balance to the elements that may have become
+ * unbalanced by the last adaptation.
+ * Each round of balance usually checks all local elements. With this setting
+ * the adaptation before balance and each round of balance record which
+ * elements they changed (\see t8_forest_set_adapt_map), and the next round
+ * only checks these elements, the coarse face neighbors of refined elements
+ * and the elements at the process boundary.
+ * If the forest that balance starts from has no such record, for example
+ * since it was adapted recursively or partitioned, the first round checks
+ * all elements. Balance with repartitioning always checks all elements.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     incremental If true, only elements near changes are checked.
+ * \note The forest that was adapted before balance must have been balanced,
+ * otherwise the result may not be balanced.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_balance_incremental (t8_forest_t forest,
+                                                       int incremental);
+
 /** Enable or disable the creation of a layer of ghost elements.
  * On default no ghosts are created.
  * \param [in]      forest    The forest.
  * \param [in]      do_ghost  If non-zero a ghost layer will be created.
- * \param [in]      ghost_type Controls which neighbors count as ghost elements,
- *                             currently only T8_GHOST_FACES is supported. This value
- *                             is ignored if \a do_ghost = 0.
+ * \param [in]      ghost_type Controls which neighbors count as ghost elements.
+ *                             T8_GHOST_EDGES and T8_GHOST_VERTICES are supported for
+ *                             forests of only lines, only quadrilaterals or only
+ *                             hexahedra, with a single round of communication.
+ *                             This value is ignored if \a do_ghost = 0.
+ * \note Vertex ghosts of hexahedra at the corners of trees need the face
+ *       connections of trees that only share an edge with a local tree.
+ *       A partitioned cmesh does not provide them, then the cmesh has to
+ *       be replicated.
  */
 void                t8_forest_set_ghost (t8_forest_t forest, int do_ghost,
                                          t8_ghost_type_t ghost_type);
@@ -328,24 +659,102 @@ void                t8_forest_set_ghost (t8_forest_t forest, int do_ghost,
  *                                If 2, the iterativ algorithm for unbalanced forests.
  *                                If 3, the top-down search algorithm for unbalanced forests.
  * \see t8_forest_set_ghost
+ * \see t8_forest_set_ghost_ext2
  */
 void                t8_forest_set_ghost_ext (t8_forest_t forest, int do_ghost,
                                              t8_ghost_type_t ghost_type,
                                              int ghost_version);
 
-/* TODO: use assertions and document that the forest_set (..., from) and
- *       set_load are mutually exclusive. */
+/** Like \ref t8_forest_set_ghost_ext but with the additional option to
+ * create more than one layer of ghost elements.
+ * \param [in]      ghost_version As in \ref t8_forest_set_ghost_ext.
+ * \param [in]      ghost_depth   The number of layers of face neighbors in the ghost layer,
+ *                                at least 1. With depth k the ghost layer contains all
+ *                                elements that can be reached from a local element by
+ *                                crossing at most k faces, for example the neighbors of
+ *                                neighbors for k = 2. Each layer after the first is computed
+ *                                from the previous one.
+ * A depth greater than 1 requires face ghosts and a balanced forest. If the
+ * forest is not balanced as part of its commit, commit checks that its
+ * local elements are balanced and aborts otherwise.
+ * \see t8_forest_set_ghost
+ */
+void                t8_forest_set_ghost_ext2 (t8_forest_t forest,
+                                              int do_ghost,
+                                              t8_ghost_type_t ghost_type,
+                                              int ghost_version,
+                                              int ghost_depth);
+
+/** Load the elements of \b forest from a file when it is committed.
+ * The file must have been written with \ref t8_forest_save from a forest
+ * on the same coarse mesh.
+ * Each process reads the records of its range of elements directly from
+ * the file. If the file was written with the same number of processes,
+ * the saved partition is restored, otherwise the elements are distributed
+ * uniformly. The local trees must be local in the cmesh of \b forest, so a
+ * partitioned cmesh may only be used if its partition fits.
+ * Like \ref t8_forest_set_level this creates the forest from scratch and
+ * cannot be combined with any of the derived forest methods.
+ * \param [in,out] forest      The forest, with cmesh and scheme set.
+ * \param [in]     filename    The name of the file to load.
+ * \see t8_forest_load_element_data
+ */
 void                t8_forest_set_load (t8_forest_t forest,
                                         const char *filename);
 
+/** Create the elements of \b forest from given lists of leaves when it is
+ * committed. Each process passes the leaves of a range of consecutive
+ * global trees, for each tree its leaves as pairs of level and linear id
+ * at that level, sorted along the space filling curve.
+ * The leaves of all processes must form a partition of the forest, that is
+ * the processes hold consecutive ranges of trees in order of their rank,
+ * only the first and last tree of a process may be shared with other
+ * processes, and the leaves of each tree cover it without overlap.
+ * This is checked on commit, which aborts if it is violated.
+ * The elements are created directly, without adapting a uniform forest.
+ * The local trees must be local in the cmesh of \b forest.
+ * Like \ref t8_forest_set_level this creates the forest from scratch and
+ * cannot be combined with any of the derived forest methods.
+ * The arrays are not copied and must stay valid until the forest is
+ * committed.
+ * \param [in,out] forest      The forest, with cmesh and scheme set.
+ * \param [in]     first_tree  The global id of the first tree of this
+ *                             process. Ignored if \a num_trees is 0.
+ * \param [in]     num_trees   The number of trees of this process.
+ * \param [in]     tree_num_leaves The number of leaves of each of these
+ *                             trees, each must be positive.
+ * \param [in]     levels      The levels of all leaves, tree after tree.
+ * \param [in]     linear_ids  The linear ids of all leaves at their levels.
+ * \see t8_forest_new_from_leaves
+ */
+void                t8_forest_set_leaves (t8_forest_t forest,
+                                          t8_gloidx_t first_tree,
+                                          t8_locidx_t num_trees,
+                                          const t8_locidx_t *tree_num_leaves,
+                                          const int *levels,
+                                          const t8_linearidx_t *linear_ids);
+
 /** Compute the global number of elements in a forest as the sum
  *  of the local element counts.
- *  \param [in] forest    The forest.
+ *  The reduction is non-blocking and only completed when the global
+ *  number is queried with \ref t8_forest_get_global_num_elements.
+ *  Since it is collective, all processes must call this function in the
+ *  same order with respect to other collective operations on the
+ *  communicator of the forest.
+ *  \param [in,out] forest    The forest.
  */
 void                t8_forest_comm_global_num_elements (t8_forest_t forest);
 
 /** After allocating and adding properties to a forest, commit the changes.
  * This call sets up the internal state of the forest.
+ * The forest that \b forest is derived from may itself be uncommitted and
+ * derived from another uncommitted forest, for example after several calls
+ * of \ref t8_forest_set_adapt followed by \ref t8_forest_set_partition.
+ * Then commit executes the whole chain of derivations. An intermediate
+ * forest that is only referenced by the next forest of the chain does not
+ * build its ghost layer or any of its optional caches and keeps the element
+ * arrays that it grew, and it is destroyed as soon as the next forest was
+ * derived from it, so that only the last forest creates its ghosts.
  * \param [in,out] forest       Must be created with \ref t8_forest_init and
  *                              specialized with t8_forest_set_* calls first.
  */
@@ -366,8 +775,163 @@ int                 t8_forest_get_maxlevel (t8_forest_t forest);
 
 t8_locidx_t         t8_forest_get_num_element (t8_forest_t forest);
 
+/** Return the number of elements of a forest on all processes.
+ * If the count is still being reduced, wait for the reduction to complete.
+ * \param [in]      forest        A committed forest.
+ * \return                        The global number of elements.
+ */
 t8_gloidx_t         t8_forest_get_global_num_elements (t8_forest_t forest);
 
+/** Return the face connectivity table of a forest.
+ * \param [in]      forest        The forest.
+ * \param [out]     face_offsets  The faces of the local element i are the face
+ *                                entries face_offsets[i], ..., face_offsets[i + 1] - 1.
+ * \param [out]     neigh_offsets The neighbors at the face entry f are the entries
+ *                                neigh_offsets[f], ..., neigh_offsets[f + 1] - 1
+ *                                of \a neighbors and \a dual_faces.
+ * \param [out]     neighbors     The local index of each neighbor leaf. A ghost has
+ *                                the index number of local elements plus its ghost index.
+ * \param [out]     dual_faces    The face of each neighbor leaf at which it touches
+ *                                the element.
+ * \param [out]     orientations  For each face entry the orientation of the tree face
+ *                                connection. 0 if the face is inside a tree.
+ * \return                        True if the table was built, in which case the
+ *                                output arrays are set. False otherwise.
+ *                                \see t8_forest_set_face_connectivity
+ * \a forest must be committed before calling this function.
+ * The arrays belong to \a forest and are valid until it is destroyed.
+ */
+int                 t8_forest_get_face_connectivity (t8_forest_t forest,
+                                                     const t8_locidx_t **
+                                                     face_offsets,
+                                                     const t8_locidx_t **
+                                                     neigh_offsets,
+                                                     const t8_locidx_t **
+                                                     neighbors,
+                                                     const int **dual_faces,
+                                                     const int8_t **
+                                                     orientations);
+
+/** Build the face adjacency graph of the elements of a forest in the
+ * distributed compressed row format of ParMETIS. Two elements are adjacent
+ * if they share a face (or a part of a face if it is hanging).
+ * \param [in]      forest        A committed, balanced forest. If it lives on more
+ *                                than one process, it must have a ghost layer.
+ * \param [in]      with_weights  If true, the weight of each edge is the area
+ *                                of the shared face.
+ * \param [out]     pxadj         On output an array of num_local_elements + 1
+ *                                entries. The neighbors of the local element i are
+ *                                the entries xadj[i], ..., xadj[i + 1] - 1 of
+ *                                \a adjncy and \a adjwgt.
+ * \param [out]     padjncy       On output the global ids of the neighbors, see
+ *                                \ref t8_forest_get_first_local_element_id.
+ * \param [out]     padjwgt       If \a with_weights, on output the weight of each
+ *                                edge. Otherwise set to NULL if not NULL.
+ * The output arrays must be freed with T8_FREE.
+ * Each neighbor appears once per element even if it is adjacent through
+ * several faces, in which case the weights are summed. Elements are not
+ * adjacent to themselves.
+ * This function is collective over the processes of \a forest. If the
+ * face connectivity table is built (\see t8_forest_set_face_connectivity),
+ * it is used for the neighbors.
+ */
+void                t8_forest_build_dual_graph (t8_forest_t forest,
+                                                int with_weights,
+                                                t8_locidx_t ** pxadj,
+                                                t8_gloidx_t ** padjncy,
+                                                double **padjwgt);
+
+/** Return the geometry cache of a forest. If it was not built at commit, it
+ * is built now. Each output may be NULL if it is not needed.
+ * \param [in]      forest        The forest.
+ * \param [out]     volumes       The volume of each local element.
+ * \param [out]     centroids     An array of 3 pointers. On output the x, y and z
+ *                                coordinates of the centroid of each local element.
+ * \param [out]     face_offsets  The faces of the local element i are the face
+ *                                entries face_offsets[i], ..., face_offsets[i + 1] - 1.
+ * \param [out]     face_areas    The area of each face entry.
+ * \param [out]     face_normals  An array of 3 pointers. On output the x, y and z
+ *                                coordinates of the outward normal of each face entry.
+ *                                NULL if the forest has dimension smaller 2.
+ * The values are computed with \ref t8_forest_element_volume,
+ * \ref t8_forest_element_centroid, \ref t8_forest_element_face_area and
+ * \ref t8_forest_element_face_normal. The arrays belong to \a forest.
+ * If the cache was not built at commit, the first call builds it. This
+ * function may be called from several OpenMP threads at once, in which case
+ * one thread builds the cache while the others wait.
+ * \a forest must be committed before calling this function.
+ */
+void                t8_forest_get_geometry_cache (t8_forest_t forest,
+                                                  const double **volumes,
+                                                  const double **centroids,
+                                                  const t8_locidx_t **
+                                                  face_offsets,
+                                                  const double **face_areas,
+                                                  const double
+                                                  **face_normals);
+
+/** Return the cached geometry of the elements passed to an adapt callback.
+ * Call this from a \ref t8_forest_adapt_t callback to read the volume,
+ * centroid and diameter of the current elements from the geometry cache of
+ * \a forest_from instead of computing them.
+ * \param [in]      forest_from   The forest that is adapted.
+ * \param [in]      which_tree    The local tree passed to the callback.
+ * \param [in]      lelement_id   The element id passed to the callback.
+ * \param [in]      element       The first entry of the elements passed to
+ *                                the callback.
+ * \param [out]     volumes       If not NULL, the volume of the i-th
+ *                                element is (*volumes)[i] on output.
+ * \param [out]     centroids     If not NULL, an array of 3 pointers. On
+ *                                output centroids[j][i] is the j-th
+ *                                coordinate of the centroid of the i-th
+ *                                element.
+ * \param [out]     diameters     If not NULL, the diameter of the i-th
+ *                                element is (*diameters)[i] on output,
+ *                                \see t8_forest_element_diam.
+ * \return                        True if the values are cached. False if
+ *                                \a forest_from has no geometry cache or if
+ *                                \a element is a descendant created during
+ *                                recursive refinement. Then the outputs are
+ *                                not changed and the callback has to compute
+ *                                the geometry itself.
+ * The cache is not built by this function, since adapt callbacks may run
+ * in parallel threads. Build it with \ref t8_forest_set_geometry_cache
+ * or \ref t8_forest_get_geometry_cache before \a forest_from is adapted.
+ */
+int                 t8_forest_adapt_get_geometry (t8_forest_t forest_from,
+                                                  t8_locidx_t which_tree,
+                                                  t8_locidx_t lelement_id,
+                                                  const t8_element_t *
+                                                  element,
+                                                  const double **volumes,
+                                                  const double **centroids,
+                                                  const double **diameters);
+
+/** Return the neighbor leafs of a local element across a face from the
+ * face connectivity table of a forest.
+ * \param [in]      forest        The forest. Its face connectivity table must exist.
+ * \param [in]      lelement      The local index of an element.
+ * \param [in]      face          A face of this element.
+ * \param [out]     neighbors     On output the local indices of the neighbor leafs.
+ *                                See \ref t8_forest_get_face_connectivity.
+ * \param [out]     dual_faces    On output the faces of the neighbor leafs.
+ * \param [out]     orientation   If not NULL, on output the orientation of the face.
+ * \return                        The number of neighbor leafs. 0 at the domain boundary.
+ * \a forest must be committed before calling this function.
+ */
+t8_locidx_t         t8_forest_get_face_connectivity_neighbors (t8_forest_t
+                                                               forest,
+                                                               t8_locidx_t
+                                                               lelement,
+                                                               int face,
+                                                               const
+                                                               t8_locidx_t **
+                                                               neighbors,
+                                                               const int
+                                                               **dual_faces,
+                                                               int
+                                                               *orientation);
+
 /** Return the number of ghost elements of a forest.
  * \param [in]      forest      The forest.
  * \return                      The number of ghost elements stored in the ghost
@@ -377,6 +941,181 @@ t8_gloidx_t         t8_forest_get_global_num_elements (t8_forest_t forest);
  */
 t8_locidx_t         t8_forest_get_num_ghosts (t8_forest_t forest);
 
+/** The state of a ghost data exchange, started by
+ * \ref t8_forest_ghost_exchange_begin. */
+typedef struct t8_forest_ghost_exchange t8_forest_ghost_exchange_t;
+
+/** Exchange the data of the ghost elements of a forest.
+ * Each process sends the data of its local elements that are ghosts of
+ * other processes and receives the data of its own ghost elements.
+ * \param [in]      forest       A committed forest with a ghost layer.
+ * \param [in,out]  element_data An array with one entry for each local
+ *                               element and each ghost element of \a forest.
+ *                               The entries of the local elements are sent,
+ *                               the entries of the ghosts are received.
+ * This function is collective over the processes that share ghosts.
+ * It is equivalent to \ref t8_forest_ghost_exchange_begin followed by
+ * \ref t8_forest_ghost_exchange_end.
+ */
+void                t8_forest_ghost_exchange_data (t8_forest_t forest,
+                                                   sc_array_t * element_data);
+
+/** Exchange the data of several fields of the ghost elements of a forest
+ * at once. All fields are sent in one message per remote process, such
+ * that the exchange costs the latency of one
+ * \ref t8_forest_ghost_exchange_data call.
+ * \param [in]      forest       A committed forest with a ghost layer.
+ * \param [in]      num_fields   The number of fields.
+ * \param [in,out]  fields       An array of \a num_fields arrays. Each one is
+ *                               as the element data of
+ *                               \ref t8_forest_ghost_exchange_data.
+ *                               Their element sizes may differ.
+ * This function is collective over the processes that share ghosts.
+ */
+void                t8_forest_ghost_exchange_data_multi (t8_forest_t forest,
+                                                         int num_fields,
+                                                         sc_array_t **
+                                                         fields);
+
+/** Exchange ghost data with a variable number of entries per element.
+ * The data of element i is stored in the entries offsets[i] to
+ * offsets[i + 1] - 1 of \a data, as in a CSR matrix.
+ * The data of the ghosts follows the data of the local elements.
+ * \param [in]      forest       A committed forest with a ghost layer.
+ * \param [in,out]  offsets      An array of size_t with one entry for each
+ *                               local element and each ghost plus one.
+ *                               On input the entries 0 to num_elements
+ *                               are set. The entries of the ghosts are
+ *                               computed if \a exchange_sizes is true and
+ *                               must be valid from a previous call
+ *                               otherwise.
+ * \param [in,out]  data         The data of the elements, the entry size
+ *                               is data->elem_size. On input it has at
+ *                               least offsets[num_elements] entries. On
+ *                               output it is resized to hold the data of
+ *                               all ghosts, too.
+ * \param [in]      exchange_sizes If true, the number of entries of each
+ *                               ghost is exchanged first. If the sizes did
+ *                               not change since the last call, pass false
+ *                               to only send the payload.
+ * The payload is sent without padding.
+ * This function is collective over the processes that share ghosts.
+ */
+void                t8_forest_ghost_exchange_varsize (t8_forest_t forest,
+                                                      sc_array_t * offsets,
+                                                      sc_array_t * data,
+                                                      int exchange_sizes);
+
+/** Start to exchange the data of the ghost elements of a forest.
+ * The data of the local elements is copied into send buffers and all
+ * messages are posted. The call returns without waiting for them, such
+ * that the caller can work on elements whose neighbors are local while the
+ * ghost data is in flight.
+ * \param [in]      forest       A committed forest with a ghost layer.
+ * \param [in,out]  element_data As in \ref t8_forest_ghost_exchange_data.
+ *                               The entries of the local elements may be
+ *                               changed after this call returns. The entries
+ *                               of the ghosts must not be accessed until
+ *                               \ref t8_forest_ghost_exchange_end is called.
+ * \return                       The exchange that must be passed to
+ *                               \ref t8_forest_ghost_exchange_end.
+ */
+t8_forest_ghost_exchange_t *t8_forest_ghost_exchange_begin (t8_forest_t
+                                                            forest,
+                                                            sc_array_t *
+                                                            element_data);
+
+/** Wait for a ghost data exchange to complete and free it.
+ * \param [in,out]  exchange     An exchange returned by
+ *                               \ref t8_forest_ghost_exchange_begin.
+ *                               It is invalid after this call.
+ * On output, the entries of the ghosts in the element data are filled.
+ * If profiling is enabled for the forest, the time between begin and end
+ * is stored as overlap time and the time spent in this call as wait time.
+ * \see t8_forest_profile_get_ghostexchange_waittime
+ * \see t8_forest_profile_get_ghostexchange_overlaptime
+ */
+void                t8_forest_ghost_exchange_end (t8_forest_ghost_exchange_t *
+                                                  exchange);
+
+/** A precomputed ghost data exchange for a fixed forest and data size,
+ * created by \ref t8_forest_ghost_plan_new. */
+typedef struct t8_forest_ghost_plan t8_forest_ghost_plan_t;
+
+/** Create a plan to exchange ghost data of a fixed size repeatedly.
+ * The plan stores for each remote process the indices of the local
+ * elements that it needs, the send and receive buffers and persistent MPI
+ * requests. Each exchange with the plan then only packs the send buffers,
+ * starts the requests and waits for them.
+ * Use this instead of \ref t8_forest_ghost_exchange_data if the same forest
+ * exchanges data many times, for example in each step of a time loop.
+ * \param [in]      forest       A committed forest with a ghost layer.
+ *                               The plan keeps a reference of \a forest.
+ * \param [in]      data_size    The number of bytes per element.
+ * \return                       A plan for \a forest and \a data_size.
+ * This function is not collective.
+ * \see t8_forest/t8_forest_ghost_device.h for plans on device memory.
+ */
+t8_forest_ghost_plan_t *t8_forest_ghost_plan_new (t8_forest_t forest,
+                                                  size_t data_size);
+
+/** Create a plan that exchanges ghost data with one-sided communication.
+ * Each process exposes the receive buffer of the plan in an MPI window and
+ * the owners of the ghosts put their data directly into it, with one
+ * post-start-complete-wait epoch per exchange. This avoids the matching
+ * of send and receive requests, which pays off for many small messages.
+ * The plan is used with the same functions as a plan from
+ * \ref t8_forest_ghost_plan_new.
+ * \param [in]      forest       A committed forest with a ghost layer.
+ *                               The plan keeps a reference of \a forest.
+ * \param [in]      data_size    The number of bytes per element.
+ * \return                       A plan for \a forest and \a data_size.
+ * This function is collective over the communicator of \a forest and so is
+ * \ref t8_forest_ghost_plan_destroy for the returned plan.
+ */
+t8_forest_ghost_plan_t *t8_forest_ghost_plan_new_rma (t8_forest_t forest,
+                                                      size_t data_size);
+
+/** Start a ghost data exchange with a plan.
+ * \param [in]      plan         A plan, with no exchange in progress.
+ * \param [in,out]  element_data An array with one entry of the plan's data
+ *                               size for each local element and each ghost
+ *                               element of the plan's forest.
+ *                               The entries of the local elements may be
+ *                               changed after this call returns. The entries
+ *                               of the ghosts are written by
+ *                               \ref t8_forest_ghost_plan_end.
+ * This function is collective over the processes that share ghosts.
+ */
+void                t8_forest_ghost_plan_begin (t8_forest_ghost_plan_t *
+                                                plan,
+                                                sc_array_t * element_data);
+
+/** Wait for the exchange started by \ref t8_forest_ghost_plan_begin and
+ * fill the entries of the ghosts in its element data.
+ * The plan can be used for the next exchange after this call.
+ * \param [in,out]  plan         A plan with an exchange in progress.
+ */
+void                t8_forest_ghost_plan_end (t8_forest_ghost_plan_t * plan);
+
+/** Exchange ghost data with a plan.
+ * This is \ref t8_forest_ghost_plan_begin directly followed by
+ * \ref t8_forest_ghost_plan_end.
+ * \param [in,out]  plan         A plan, with no exchange in progress.
+ * \param [in,out]  element_data As in \ref t8_forest_ghost_plan_begin.
+ */
+void                t8_forest_ghost_plan_exchange (t8_forest_ghost_plan_t *
+                                                   plan,
+                                                   sc_array_t * element_data);
+
+/** Free a ghost exchange plan and release its reference of the forest.
+ * \param [in,out]  pplan        The plan, set to NULL on output.
+ * This function is collective if the plan was created with
+ * \ref t8_forest_ghost_plan_new_rma.
+ */
+void                t8_forest_ghost_plan_destroy (t8_forest_ghost_plan_t **
+                                                  pplan);
+
 /** Return the element class of a forest local tree.
  *  \param [in] forest    The forest.
  *  \param [in] ltreeid   The local id of a tree in \a forest.
@@ -429,8 +1168,244 @@ t8_locidx_t         t8_forest_cmesh_ltreeid_to_ltreeid (t8_forest_t forest,
 t8_ctree_t          t8_forest_get_coarse_tree (t8_forest_t forest,
                                                t8_locidx_t ltreeid);
 
+/** Enable or disable the specialized element kernels for a forest.
+ * If the coarse mesh of a forest has only trees of one element class and
+ * the default scheme is used for this class, populate and adapt run loops
+ * that are compiled for this scheme and do not go through the virtual table
+ * of \ref t8_eclass_scheme_c for each element.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     enable      If true, the kernels are used whenever
+ *                             possible. If false, the generic path is used.
+ *
+ * The kernels are enabled by default. A forest that is derived from another
+ * forest inherits this setting if the other forest disabled them.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_specialized_kernels (t8_forest_t forest,
+                                                       int enable);
+
+/** Record a map from the elements of the source forest to the elements
+ * of an adapted forest during \ref t8_forest_commit.
+ * The map is a run-length encoding of the refined, coarsened and kept
+ * elements of each tree. If it exists, \ref t8_forest_iterate_replace uses
+ * it instead of comparing the elements of the two forests.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     record      If true, the map is recorded.
+ *
+ * The map is only recorded if \a forest is only adapted (not balanced or
+ * partitioned) and the adaptation is not recursive. It refers to the forest
+ * that \a forest was adapted from.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_adapt_map (t8_forest_t forest,
+                                             int record);
+
+/** Set the number of threads that adapt a forest.
+ * The elements of the local trees are split into ranges that do not
+ * separate a family and these ranges are adapted concurrently.
+ * The result is the same as for serial adaptation.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     num_threads The number of threads. A value smaller
+ *                             than 2 adapts serially. The default is
+ *                             \ref t8_get_num_threads.
+ *
+ * Threads are only used if t8code was configured with --enable-openmp
+ * and compiled with OpenMP support. The adapt callback must be thread-safe
+ * in this case. Recursive adaptation is always serial.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_adapt_threads (t8_forest_t forest,
+                                                 int num_threads);
+
+/** Set the number of threads that find the remote elements when the ghost
+ * layer of a forest is created.
+ * The balanced algorithm splits the local elements into one range per
+ * thread, the top-down search distributes the local trees among the
+ * threads. The result is the same as for serial ghost creation.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     num_threads The number of threads. A value smaller
+ *                             than 2 creates the ghost layer serially.
+ *                             The default is \ref t8_get_num_threads.
+ *
+ * Threads are only used if t8code was configured with --enable-openmp and
+ * compiled with OpenMP support, and only by the balanced ghost algorithm
+ * and the top-down search (ghost versions 1 and 3 in
+ * \ref t8_forest_set_ghost_ext). Version 2 is always serial.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_ghost_threads (t8_forest_t forest,
+                                                 int num_threads);
+
+/** Update the ghost layer of an adapted forest from the ghost layer of the
+ * forest that it was adapted from, instead of building it anew.
+ * Adaptation does not change the partition of the forest, thus the elements
+ * that were kept are remote elements of the same processes as before. Only
+ * the refined and coarsened elements are checked again. If only a few
+ * elements change between two adaptation steps, this is much faster than
+ * creating the ghost layer from scratch. Each process only sends the
+ * changes of its remote elements: the kept remote elements are referenced
+ * by their position in the old ghost layer of the receiver, and only the
+ * refined and coarsened ones are sent in full.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     incremental If true, the ghost layer is updated.
+ *
+ * The ghost layer is only updated if \a forest is only adapted (not
+ * balanced or partitioned), the adaptation is not recursive and the forest
+ * it is adapted from has a ghost layer of the same type, created with
+ * the same ghost version. Otherwise the ghost layer is created as usual.
+ * In any case the result is the same.
+ * The forest must not be committed before calling this function.
+ * \see t8_forest_set_ghost
+ */
+void                t8_forest_set_ghost_incremental (t8_forest_t forest,
+                                                     int incremental);
+
+/** Build a table of the face neighbors of all local elements when the
+ * forest is committed. The table stores for each face of each local
+ * element the local or ghost indices of the neighbor leafs, their faces
+ * and the orientation of the face connection in compressed row storage.
+ * Solvers that visit all faces in each time step can read the neighbors
+ * with \ref t8_forest_get_face_connectivity or
+ * \ref t8_forest_get_face_connectivity_neighbors without allocating or
+ * searching.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     build       If true, the table is built.
+ *
+ * The table is computed with \ref t8_forest_leaf_face_neighbors, thus the
+ * forest must be balanced and, if it lives on more than one process,
+ * have a ghost layer (\see t8_forest_set_ghost).
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_face_connectivity (t8_forest_t forest,
+                                                     int build);
+
+/** Compute the volume, centroid and diameter of each local element and the
+ * area and outward normal of each of their faces when the forest is
+ * committed. The values are stored as structure of arrays and can be read
+ * with \ref t8_forest_get_geometry_cache and, in an adapt callback, with
+ * \ref t8_forest_adapt_get_geometry. They are freed with the forest.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     build       If true, the cache is built at commit.
+ *                             Otherwise it is built on the first call of
+ *                             \ref t8_forest_get_geometry_cache.
+ * The vertices of all local trees must be stored in the cmesh.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_geometry_cache (t8_forest_t forest,
+                                                  int build);
+
+/** Build a bounding volume hierarchy over the local and ghost trees of a
+ * forest when the forest is committed. The hierarchy is a binary tree over
+ * the axis-aligned bounding boxes of the tree vertices and is queried with
+ * the functions in \ref t8_forest_bvh.h. It is freed with the forest.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     build       If true, the hierarchy is built at commit.
+ *                             Otherwise it is built on the first query.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_tree_bvh (t8_forest_t forest, int build);
+
+/** Build an index from the local elements of a forest to their trees when
+ * the forest is committed. It stores the local tree of every
+ * 2^T8_FOREST_ELEMENT_BLOCK_LOG-th element, such that
+ * \ref t8_forest_get_element finds the tree of an element in constant time
+ * instead of with a binary search over the trees.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     build       If true, the index is built.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_element_tree_index (t8_forest_t forest,
+                                                      int build);
+
+/** Do not keep the partition tables of a forest after it is committed.
+ * The partition tables are the element offsets, the first descendants and
+ * the tree offsets of all processes. Each of them has one entry per process
+ * and is replicated on all processes, or on all nodes if shared memory
+ * windows are available. By default, commit creates them and they live as
+ * long as the forest.
+ * If this setting is enabled, commit frees these tables when it returns.
+ * Partition and ghost creation build the tables they need and free them
+ * afterwards. With many processes and several forests alive at once, only
+ * the forests that are currently partitioned or searched use this memory.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     lazy        If true, the tables are not kept.
+ * \note The owner search functions, for example
+ * \ref t8_forest_leaf_face_neighbors with ghost neighbors, need the tables.
+ * Call \ref t8_forest_create_partition_tables before using them on such a
+ * forest.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_lazy_partition_tables (t8_forest_t forest,
+                                                         int lazy);
+
+/** Trim the element arrays of a forest instead of packing them.
+ * Partition, balance and recursive or threaded adapt grow the element array
+ * of each tree and commit by default copies the new elements of all trees
+ * into one arena. While copying, the elements are stored twice. If this
+ * setting is enabled, commit instead frees the memory of each tree's array
+ * that is allocated beyond its element count, which keeps the peak memory
+ * of the new elements close to their final size at the cost of one
+ * allocation per tree.
+ * Non-recursive adapt with one thread counts the new elements first and
+ * creates them in their final place, in the arena or, if this setting is
+ * enabled, in one array per tree of exactly their size.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     trim        If true, the trees are trimmed and not packed.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_trim_elements (t8_forest_t forest,
+                                                 int trim);
+
+/** Do not store the elements of a uniform forest until they are needed.
+ * If this setting is enabled and the forest is created uniformly with
+ * \ref t8_forest_set_level, each local tree only stores the level and the
+ * range of linear ids of its elements, such that commit does not allocate
+ * or create any elements.
+ * The elements of a tree are created when they are first accessed, for
+ * example with \ref t8_forest_get_tree or \ref t8_forest_get_element.
+ * \ref t8_forest_leaf_cursor_begin visits the elements of such a tree
+ * without creating them.
+ * A forest adapted from this forest keeps the trees in which no element
+ * changed implicit.
+ * \param [in,out] forest      The forest to be updated.
+ * \param [in]     implicit    If true, the elements are not stored.
+ * \note Creating the elements of a tree is not thread-safe. Call
+ * \ref t8_forest_materialize before accessing a forest from several threads.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_implicit_uniform (t8_forest_t forest,
+                                                    int implicit);
+
+/** Create and store the elements of all implicit trees of a forest.
+ * \param [in,out] forest      A committed forest.
+ * \see t8_forest_set_implicit_uniform
+ */
+void                t8_forest_materialize (t8_forest_t forest);
+
+/** Create the partition tables of a committed forest if they do not exist.
+ * \param [in,out] forest      The forest.
+ * This function is collective over the communicator of \a forest.
+ * \see t8_forest_set_lazy_partition_tables
+ */
+void                t8_forest_create_partition_tables (t8_forest_t forest);
+
+/** Free the partition tables of a committed forest.
+ * They are created again when they are needed.
+ * \param [in,out] forest      The forest.
+ * This function is collective over the communicator of \a forest.
+ * \see t8_forest_set_lazy_partition_tables
+ */
+void                t8_forest_destroy_partition_tables (t8_forest_t forest);
+
 /** Enable or disable profiling for a forest. If profiling is enabled, runtimes
  * and statistics are collected during forest_commit.
+ * If t8code is configured with --enable-perf-counters, the hardware
+ * counters of adapt, partition, ghost, balance and commit are collected
+ * as well, see \ref t8_counters.h.
+ * The resident memory of the process before, during and after adapt,
+ * partition, ghost and balance is sampled with
+ * \ref t8_profile_memory_start, such that phases that transiently need
+ * much memory show up in \ref t8_forest_print_profile.
  * \param [in,out] forest        The forest to be updated.
  * \param [in]     set_profiling If true, profiling will be enabled, if false
  *                              disabled.
@@ -438,11 +1413,14 @@ t8_ctree_t          t8_forest_get_coarse_tree (t8_forest_t forest,
  * Profiling is disabled by default.
  * The forest must not be committed before calling this function.
  * \see t8_forest_print_profile
+ * \see t8_trace_enable to record the timeline of the commit phases.
  */
 void                t8_forest_set_profiling (t8_forest_t forest,
                                              int set_profiling);
 
 /** Print the collected statistics from a forest profile.
+ * Additionally, the minimum, maximum and sum over all processes of the
+ * memory used by the forest and its cmesh are printed.
  * \param [in]    forest        The forest.
  *
  * \a forest must be committed before calling this function.
@@ -450,6 +1428,38 @@ void                t8_forest_set_profiling (t8_forest_t forest,
  */
 void                t8_forest_print_profile (t8_forest_t forest);
 
+/** Compute the number of bytes that a forest uses on this process.
+ * The cmesh and the scheme of the forest are not counted, see
+ * \ref t8_cmesh_memory_usage.
+ * \param [in]    forest        The forest.
+ * \param [out]   usage         If not NULL, an array of
+ *                              \ref T8_FOREST_MEMORY_COUNT entries. On output
+ *                              entry i is the number of bytes of the
+ *                              component \ref t8_forest_memory_t i.
+ * \return                      The total number of bytes.
+ * \note Partition tables in shared memory are counted on each process.
+ * \a forest must be committed before calling this function.
+ */
+size_t              t8_forest_memory_usage (t8_forest_t forest,
+                                            size_t * usage);
+
+/** Reduce the memory usage of a forest over all of its processes.
+ * \param [in]    forest        The forest.
+ * \param [out]   min           If not NULL, an array of
+ *                              \ref T8_FOREST_MEMORY_COUNT + 1 entries. On
+ *                              output the minimum over all processes of each
+ *                              component, followed by the minimum total.
+ * \param [out]   max           As \a min for the maximum.
+ * \param [out]   sum           As \a min for the sum.
+ * This function is collective over the communicator of \a forest.
+ * If profiling is enabled, \ref t8_forest_print_profile prints these
+ * values, too.
+ */
+void                t8_forest_memory_usage_global (t8_forest_t forest,
+                                                   size_t * min,
+                                                   size_t * max,
+                                                   size_t * sum);
+
 /** Get the runtime of the last call to \ref t8_forest_adapt.
  * \param [in]   forest         The forest.
  * \return                      The runtime of adapt if profiling was activated.
@@ -501,7 +1511,8 @@ double              t8_forest_profile_get_ghost_time (t8_forest_t forest,
                                                       t8_locidx_t *
                                                       ghosts_sent);
 
-/** Get the waittime of the last call to \ref t8_forest_ghost_exchange_data.
+/** Get the waittime of the last call to \ref t8_forest_ghost_exchange_data
+ * or \ref t8_forest_ghost_exchange_end.
  * \param [in]   forest         The forest.
  * \return                      The time of ghost_exchange_data that was spent waiting
  *                              for other MPI processes, if profiling was activated.
@@ -513,6 +1524,59 @@ double              t8_forest_profile_get_ghost_time (t8_forest_t forest,
 double              t8_forest_profile_get_ghostexchange_waittime (t8_forest_t
                                                                   forest);
 
+/** Get the time between \ref t8_forest_ghost_exchange_begin and
+ * \ref t8_forest_ghost_exchange_end of the last ghost exchange.
+ * This is the time that the caller worked while the ghost data was in
+ * flight. It is 0 for \ref t8_forest_ghost_exchange_data.
+ * \param [in]   forest         The forest.
+ * \return                      The overlap time, if profiling was activated.
+ *                              0 otherwise.
+ * \a forest must be committed before calling this function.
+ * \see t8_forest_set_profiling
+ * \see t8_forest_profile_get_ghostexchange_waittime
+ */
+double              t8_forest_profile_get_ghostexchange_overlaptime (t8_forest_t
+                                                                     forest);
+
+/** Initialize an accumulated forest profile with zero values.
+ * \param [out] accum   The accumulated profile.
+ */
+void                t8_forest_profile_accum_init (t8_forest_profile_accum_t *
+                                                  accum);
+
+/** Add the values of the last commit of a forest to an accumulated
+ * profile. Call this after each commit of a simulation, for example once
+ * per time step.
+ * \param [in,out] accum   An initialized accumulated profile.
+ * \param [in]     forest  A committed forest. If profiling is enabled, the
+ *                         runtimes and the bytes sent are added,
+ *                         otherwise only the numbers of elements and ghosts.
+ */
+void                t8_forest_profile_accumulate (t8_forest_profile_accum_t *
+                                                  accum, t8_forest_t forest);
+
+/** Reduce an accumulated profile over the processes.
+ * This function is collective.
+ * \param [in]  accum    An accumulated profile.
+ * \param [in]  comm     The communicator of the forests.
+ * \param [out] values   \ref T8_FOREST_PROFILE_COUNT values, indexed by
+ *                       \ref t8_forest_profile_value_t.
+ */
+void                t8_forest_profile_accum_reduce (const
+                                                    t8_forest_profile_accum_t
+                                                    * accum, sc_MPI_Comm comm,
+                                                    t8_profile_value_t *
+                                                    values);
+
+/** Reduce an accumulated profile and print it on rank 0.
+ * This function is collective.
+ * \param [in]  accum    An accumulated profile.
+ * \param [in]  comm     The communicator of the forests.
+ */
+void                t8_forest_profile_accum_print (const
+                                                   t8_forest_profile_accum_t *
+                                                   accum, sc_MPI_Comm comm);
+
 /** Print the ghost structure of a forest. Only used for debugging. */
 void                t8_forest_ghost_print (t8_forest_t forest);
 
@@ -536,6 +1600,15 @@ void                t8_forest_partition_cmesh (t8_forest_t forest,
  */
 sc_MPI_Comm         t8_forest_get_mpicomm (t8_forest_t forest);
 
+/** Query whether a process is idle after the communicator was shrunk.
+ * \param [in]      forest      A committed forest.
+ * \return                      True if the process had no elements when the
+ *                              communicator was split and \a forest is still
+ *                              on the communicator of the idle processes.
+ * \see t8_forest_set_shrink_comm
+ */
+int                 t8_forest_is_idle (t8_forest_t forest);
+
 /** Return the global id of the first local tree of a forest.
  * \param [in]      forest      The forest.
  * \return                      The global id of the first local tree in \a forest.
@@ -574,7 +1647,10 @@ t8_gloidx_t         t8_forest_global_tree_id (t8_forest_t forest,
  * \param [in]      forest      The forest.
  * \param [in]      ltree_id    The local id of the tree.
  * \return                      A pointer to the tree with local id \a ltree_id.
+ *                              If the tree is implicit, its elements are
+ *                              created and stored first.
  * \a forest must be committed before calling this function.
+ * \see t8_forest_set_implicit_uniform
  */
 t8_tree_t           t8_forest_get_tree (t8_forest_t forest,
                                         t8_locidx_t ltree_id);
@@ -726,8 +1802,40 @@ t8_gloidx_t         t8_forest_element_face_neighbor (t8_forest_t forest,
                                                      neigh_scheme, int face,
                                                      int *neigh_face);
 
-/* TODO: implement */
-void                t8_forest_save (t8_forest_t forest);
+/** Save a forest and fixed-size data for each of its elements to a file.
+ * The file contains one record with the global tree id, level and linear
+ * id of each element followed by the element data, both sorted by global
+ * element index. It is written collectively, using MPI-IO if t8code is
+ * configured with it, such that each process writes one contiguous section.
+ * \param [in] forest       A committed forest.
+ * \param [in] filename     The name of the file to write.
+ * \param [in] element_data An array of \a data_size bytes for each local
+ *                          element. May be NULL if \a data_size is 0.
+ * \param [in] data_size    The number of bytes per element.
+ * \return                  True on all processes if the file was written.
+ * \see t8_forest_set_load
+ */
+int                 t8_forest_save (t8_forest_t forest, const char *filename,
+                                    const void *element_data,
+                                    size_t data_size);
+
+/** Read the element data of a forest that was loaded from a file.
+ * This function is collective. The forest must consist of the same elements
+ * as the saved forest, but may be partitioned differently.
+ * \param [in]  forest       A committed forest, for example created with
+ *                           \ref t8_forest_set_load.
+ * \param [in]  filename     A file written with \ref t8_forest_save.
+ * \param [out] element_data An array of \a data_size bytes for each local
+ *                           element. The data of the local elements is
+ *                           stored here on return.
+ * \param [in]  data_size    The number of bytes per element. Must match the
+ *                           size that was saved.
+ * \return                   True on all processes if the data was read.
+ */
+int                 t8_forest_load_element_data (t8_forest_t forest,
+                                                 const char *filename,
+                                                 void *element_data,
+                                                 size_t data_size);
 
 /** Write the forest in a parallel vtu format. There is one master
  * .pvtu file and each process writes in its own .vtu file.
@@ -768,6 +1876,31 @@ void                t8_forest_element_coordinate (t8_forest_t forest,
                                                   int corner_number,
                                                   double *coordinates);
 
+/** Compute the coordinates of all corners of all leaf elements of a local tree.
+ * The coordinates are stored as structure of arrays, that is in one array
+ * for each coordinate direction.
+ * This is equivalent to calling \ref t8_forest_element_coordinate for each
+ * corner of each leaf, but much faster, since the tree vertices and the
+ * interpolation coefficients are computed only once per tree.
+ * \param [in]      forest     The forest.
+ * \param [in]      ltree_id   The forest local id of the tree.
+ * \param [out]     x          An array of at least num_leafs * num_corners doubles,
+ *                             with num_leafs the number of leaf elements of the tree
+ *                             and num_corners the number of corners of the tree's
+ *                             element class. On output the x coordinate of the j-th
+ *                             corner of the i-th leaf is x[i * num_corners + j].
+ * \param [out]     y          As \a x for the y coordinates.
+ * \param [out]     z          As \a x for the z coordinates.
+ * \note The vertex coordinates of the tree must be stored in the cmesh.
+ */
+void                t8_forest_tree_leaf_corner_coordinates (t8_forest_t
+                                                            forest,
+                                                            t8_locidx_t
+                                                            ltree_id,
+                                                            double *x,
+                                                            double *y,
+                                                            double *z);
+
 /** Compute the coordinates of the centroid of an element if the
  * vertex coordinates of the surrounding tree are known.
  * The centroid is the sum of all corner vertices divided by the number of corners.
@@ -868,6 +2001,67 @@ void                t8_forest_element_face_normal (t8_forest_t forest,
                                                    *tree_vertices,
                                                    double normal[3]);
 
+/** Compute the area, the centroid and the outward normal of all faces of all
+ * leaf elements of a local tree.
+ * This is equivalent to calling \ref t8_forest_element_face_area,
+ * \ref t8_forest_element_face_centroid and
+ * \ref t8_forest_element_face_normal for each face of each leaf, but the
+ * corner coordinates of a leaf are computed only once for all its faces,
+ * as in \ref t8_forest_tree_leaf_corner_coordinates.
+ * The entry of face f of the i-th leaf is i * num_faces + f, with num_faces
+ * the number of faces of the tree's element class.
+ * At a hanging face, the entry of the coarse leaf describes its whole face
+ * and the entries of the finer neighbors describe the subfaces. The
+ * subfaces of an affine face cover it exactly, such that their areas add
+ * up to its area and their normals are opposite to its normal.
+ * \param [in]      forest     The forest.
+ * \param [in]      ltree_id   The forest local id of the tree.
+ * \param [out]     areas      If not NULL, the area of each face entry.
+ * \param [out]     centroids  If not NULL, the centroids of the face entries
+ *                             as a batch of 3 num_entries doubles, first all
+ *                             x coordinates, then all y and all z coordinates.
+ * \param [out]     normals    If not NULL, the outward unit normals of the face
+ *                             entries as a batch like \a centroids.
+ *                             Must be NULL for trees of dimension smaller 2.
+ * \note The vertex coordinates of the tree must be stored in the cmesh.
+ */
+void                t8_forest_tree_leaf_face_geometry (t8_forest_t forest,
+                                                       t8_locidx_t ltree_id,
+                                                       double *areas,
+                                                       double *centroids,
+                                                       double *normals);
+
+/** Compute the physical quadrature points and weights of a range of leaf
+ * elements of a local tree.
+ * The reference rule is mapped to each leaf and then with the map of the
+ * tree that interpolates its vertices. Each weight is the reference weight
+ * times the volume factor of the Jacobian of the composed map at the point,
+ * such that summing a function at the points times the weights integrates
+ * it over the leafs.
+ * The entry of point q of the i-th leaf of the range is
+ * i * quad->num_points + q.
+ * \param [in]      forest     The forest.
+ * \param [in]      ltree_id   The forest local id of the tree.
+ * \param [in]      first      The tree local index of the first leaf.
+ * \param [in]      num_leafs  The number of leafs.
+ * \param [in]      quad       A quadrature rule of the tree's element class,
+ *                             see \ref t8_quadrature_new.
+ * \param [out]     points     If not NULL, the physical points as a batch of
+ *                             3 num_entries doubles, first all x coordinates,
+ *                             then all y and all z coordinates, with
+ *                             num_entries = \a num_leafs * quad->num_points.
+ * \param [out]     weights    If not NULL, the num_entries weights.
+ * \note The vertex coordinates of the tree must be stored in the cmesh.
+ * Pyramids are not supported.
+ */
+void                t8_forest_tree_leaf_quadrature (t8_forest_t forest,
+                                                    t8_locidx_t ltree_id,
+                                                    t8_locidx_t first,
+                                                    t8_locidx_t num_leafs,
+                                                    const t8_quadrature_t *
+                                                    quad, double *points,
+                                                    double *weights);
+
 /* TODO: if set level and partition/adapt/balance all give NULL, then
  * refine uniformly and partition/adapt/balance the unfiform forest. */
 /** Build a uniformly refined forest on a coarse mesh.
@@ -886,6 +2080,34 @@ t8_forest_t         t8_forest_new_uniform (t8_cmesh_t cmesh,
                                            int level, int do_face_ghost,
                                            sc_MPI_Comm comm);
 
+/** Build a forest on a coarse mesh from given lists of leaves.
+ * \param [in]      cmesh     A coarse mesh.
+ * \param [in]      scheme    An eclass scheme.
+ * \param [in]      first_tree The global id of the first tree of this
+ *                            process.
+ * \param [in]      num_trees The number of trees of this process.
+ * \param [in]      tree_num_leaves The number of leaves of each tree.
+ * \param [in]      levels    The levels of all leaves.
+ * \param [in]      linear_ids The linear ids of all leaves.
+ * \param [in]      do_face_ghost If true, a layer of ghost elements is created for the forest.
+ * \param [in]      comm      MPI communicator to use.
+ * \return                    A forest with coarse mesh \a cmesh, eclass_scheme
+ *                            \a scheme and the given leaves.
+ * \note This is equivalent to calling \ref t8_forest_init, \ref t8_forest_set_cmesh,
+ * \ref t8_forest_set_scheme, \ref t8_forest_set_leaves, and \ref t8_forest_commit.
+ */
+t8_forest_t         t8_forest_new_from_leaves (t8_cmesh_t cmesh,
+                                               t8_scheme_cxx_t * scheme,
+                                               t8_gloidx_t first_tree,
+                                               t8_locidx_t num_trees,
+                                               const t8_locidx_t
+                                               *tree_num_leaves,
+                                               const int *levels,
+                                               const t8_linearidx_t
+                                               *linear_ids,
+                                               int do_face_ghost,
+                                               sc_MPI_Comm comm);
+
 /** Build a adapted forest from another forest.
  * \param [in]    forest_from The forest to refine
  * \param [in]    adapt_fn    Adapt function to use
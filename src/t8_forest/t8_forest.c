@@ -23,6 +23,8 @@
 #include <sc_statistics.h>
 #include <t8_refcount.h>
 #include <t8_forest.h>
+#include <t8_threads.h>
+#include <t8_trace.h>
 #include <t8_forest/t8_forest_private.h>
 #include <t8_forest/t8_forest_types.h>
 #include <t8_forest/t8_forest_partition.h>
@@ -45,6 +47,7 @@ t8_forest_init (t8_forest_t * pforest)
 
   /* sensible (hard error) defaults */
   forest->mpicomm = sc_MPI_COMM_NULL;
+  forest->parent_comm = sc_MPI_COMM_NULL;
   forest->dimension = -1;
   forest->from_method = T8_FOREST_FROM_LAST;
 
@@ -52,9 +55,13 @@ t8_forest_init (t8_forest_t * pforest)
   forest->mpirank = -1;
   forest->first_local_tree = -1;
   forest->global_num_elements = -1;
+  forest->global_num_request = sc_MPI_REQUEST_NULL;
+  forest->global_num_pending = 0;
   forest->set_adapt_recursive = -1;
   forest->set_balance = -1;
   forest->maxlevel_existing = -1;
+  forest->set_adapt_threads = t8_get_num_threads ();
+  forest->set_ghost_threads = t8_get_num_threads ();
 }
 
 int
@@ -156,6 +163,48 @@ t8_forest_set_level (t8_forest_t forest, int level)
   forest->set_level = level;
 }
 
+void
+t8_forest_set_load (t8_forest_t forest, const char *filename)
+{
+  size_t              length;
+
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->rc.refcount > 0);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (forest->set_from == NULL);
+
+  T8_ASSERT (filename != NULL);
+
+  T8_FREE (forest->set_load_filename);
+  length = strlen (filename) + 1;
+  forest->set_load_filename = T8_ALLOC (char, length);
+  memcpy (forest->set_load_filename, filename, length);
+}
+
+void
+t8_forest_set_leaves (t8_forest_t forest, t8_gloidx_t first_tree,
+                      t8_locidx_t num_trees,
+                      const t8_locidx_t *tree_num_leaves, const int *levels,
+                      const t8_linearidx_t *linear_ids)
+{
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->rc.refcount > 0);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (forest->set_from == NULL);
+  T8_ASSERT (forest->set_load_filename == NULL);
+
+  T8_ASSERT (num_trees >= 0);
+  T8_ASSERT (num_trees == 0 || first_tree >= 0);
+  T8_ASSERT (num_trees == 0 || tree_num_leaves != NULL);
+
+  forest->set_leaves = 1;
+  forest->set_leaves_first_tree = num_trees > 0 ? first_tree : 0;
+  forest->set_leaves_num_trees = num_trees;
+  forest->set_leaves_tree_num = tree_num_leaves;
+  forest->set_leaves_levels = levels;
+  forest->set_leaves_linear_ids = linear_ids;
+}
+
 void
 t8_forest_set_copy (t8_forest_t forest, const t8_forest_t set_from)
 {
@@ -177,9 +226,13 @@ t8_forest_set_copy (t8_forest_t forest, const t8_forest_t set_from)
 
   /* Overwrite any previous setting */
   forest->set_adapt_fn = NULL;
+  forest->set_adapt_tree_fn = NULL;
+  forest->set_adapt_markers = NULL;
   forest->set_adapt_recursive = -1;
   forest->set_balance = -1;
   forest->set_for_coarsening = -1;
+  forest->set_partition_weight_fn = NULL;
+  forest->set_partition_weights = NULL;
 }
 
 void
@@ -209,6 +262,51 @@ t8_forest_set_partition (t8_forest_t forest, const t8_forest_t set_from,
   }
 }
 
+void
+t8_forest_set_partition_weights (t8_forest_t forest,
+                                 t8_forest_partition_weight_t weight_fn,
+                                 const double *weights)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+  T8_ASSERT (weight_fn == NULL || weights == NULL);
+
+  forest->set_partition_weight_fn = weight_fn;
+  forest->set_partition_weights = weights;
+}
+
+void
+t8_forest_set_partition_eclass_costs (t8_forest_t forest,
+                                      const double *costs)
+{
+  int                 eclass;
+
+  T8_ASSERT (t8_forest_is_initialized (forest));
+  /* We check the costs as t8_cmesh_set_partition_eclass_costs does */
+  for (eclass = T8_ECLASS_ZERO; costs != NULL && eclass < T8_ECLASS_COUNT;
+       eclass++) {
+    SC_CHECK_ABORT (costs[eclass] > 0,
+                    "The partition costs of all element classes must be positive.");
+  }
+
+  forest->set_partition_eclass_costs = costs;
+}
+
+void
+t8_forest_set_partition_imbalance (t8_forest_t forest, double max_imbalance)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_partition_imbalance = max_imbalance;
+}
+
+void
+t8_forest_set_shrink_comm (t8_forest_t forest, int shrink)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_shrink_comm = shrink != 0;
+}
+
 void
 t8_forest_set_balance (t8_forest_t forest, const t8_forest_t set_from,
                        int no_repartition)
@@ -242,13 +340,25 @@ t8_forest_set_balance (t8_forest_t forest, const t8_forest_t set_from,
 void
 t8_forest_set_ghost_ext (t8_forest_t forest, int do_ghost,
                          t8_ghost_type_t ghost_type, int ghost_version)
+{
+  t8_forest_set_ghost_ext2 (forest, do_ghost, ghost_type, ghost_version, 1);
+}
+
+void
+t8_forest_set_ghost_ext2 (t8_forest_t forest, int do_ghost,
+                          t8_ghost_type_t ghost_type, int ghost_version,
+                          int ghost_depth)
 {
   T8_ASSERT (t8_forest_is_initialized (forest));
-  /* We currently only support face ghosts */
-  SC_CHECK_ABORT (do_ghost == 0 || ghost_type == T8_GHOST_FACES,
-                  "Ghost neighbors other than face-neighbors are not supported.\n");
+  /* The further layers are found across faces */
+  SC_CHECK_ABORT (do_ghost == 0 || ghost_type == T8_GHOST_FACES
+                  || ghost_depth == 1,
+                  "Ghost layers of depth greater than 1 only support "
+                  "face-neighbors.\n");
   SC_CHECK_ABORT (1 <= ghost_version && ghost_version <= 3,
                   "Invalid choice for ghost version. Choose 1, 2, or 3.\n");
+  SC_CHECK_ABORT (ghost_depth >= 1,
+                  "Invalid ghost depth. Choose at least 1.\n");
 
   if (ghost_type == T8_GHOST_NONE) {
     /* none type disables ghost */
@@ -260,9 +370,26 @@ t8_forest_set_ghost_ext (t8_forest_t forest, int do_ghost,
   if (forest->do_ghost) {
     forest->ghost_type = ghost_type;
     forest->ghost_algorithm = ghost_version;
+    forest->ghost_depth = ghost_depth;
   }
 }
 
+void
+t8_forest_set_balance_ripple (t8_forest_t forest, int ripple)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_balance_ripple = ripple != 0;
+}
+
+void
+t8_forest_set_balance_incremental (t8_forest_t forest, int incremental)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_balance_incremental = incremental != 0;
+}
+
 void
 t8_forest_set_ghost (t8_forest_t forest, int do_ghost,
                      t8_ghost_type_t ghost_type)
@@ -303,6 +430,30 @@ t8_forest_set_adapt (t8_forest_t forest, const t8_forest_t set_from,
   }
 }
 
+void
+t8_forest_set_adapt_tree (t8_forest_t forest, const t8_forest_t set_from,
+                          t8_forest_adapt_tree_t adapt_tree_fn)
+{
+  T8_ASSERT (adapt_tree_fn != NULL);
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->set_adapt_tree_fn == NULL);
+
+  t8_forest_set_adapt (forest, set_from, NULL, 0);
+  forest->set_adapt_tree_fn = adapt_tree_fn;
+}
+
+void
+t8_forest_set_adapt_markers (t8_forest_t forest, const t8_forest_t set_from,
+                             const int8_t * markers, int recursive)
+{
+  T8_ASSERT (markers != NULL);
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->set_adapt_markers == NULL);
+
+  t8_forest_set_adapt (forest, set_from, NULL, recursive);
+  forest->set_adapt_markers = markers;
+}
+
 void
 t8_forest_set_user_data (t8_forest_t forest, void *data)
 {
@@ -325,15 +476,177 @@ t8_forest_get_user_data (t8_forest_t forest)
 void
 t8_forest_comm_global_num_elements (t8_forest_t forest)
 {
-  int                 mpiret;
-  t8_gloidx_t         local_num_el;
-  t8_gloidx_t         global_num_el;
+  /* A previous reduction writes to the same buffers */
+  (void) t8_forest_comm_global_num_elements_wait (forest);
+  forest->global_num_send = (t8_gloidx_t) forest->local_num_elements;
+#ifdef SC_ENABLE_MPI
+  {
+    int                 mpiret;
+
+    /* Most steps after adapt, partition and balance only need the local
+     * count, so we do not synchronize the processes here */
+    mpiret = MPI_Iallreduce (&forest->global_num_send,
+                             &forest->global_num_elements, 1, T8_MPI_GLOIDX,
+                             MPI_SUM, forest->mpicomm,
+                             &forest->global_num_request);
+    SC_CHECK_MPI (mpiret);
+    forest->global_num_pending = 1;
+  }
+#else
+  forest->global_num_elements = forest->global_num_send;
+#endif
+}
+
+t8_gloidx_t
+t8_forest_comm_global_num_elements_wait (t8_forest_t forest)
+{
+  T8_ASSERT (forest != NULL);
 
-  local_num_el = (t8_gloidx_t) forest->local_num_elements;
-  mpiret = sc_MPI_Allreduce (&local_num_el, &global_num_el, 1,
-                             T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+  if (forest->global_num_pending) {
+#ifdef SC_ENABLE_MPI
+    int                 mpiret;
+
+    mpiret = MPI_Wait (&forest->global_num_request, MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+#endif
+    forest->global_num_pending = 0;
+  }
+  return forest->global_num_elements;
+}
+
+/* Store for each block of local elements the local tree of its first
+ * element. Since the trees store their elements consecutively, we fill
+ * the index with one pass over the trees. */
+static void
+t8_forest_element_tree_index_build (t8_forest_t forest)
+{
+  t8_locidx_t         num_blocks, iblock, ltree, num_trees;
+  t8_locidx_t         tree_end;
+  t8_tree_t           tree;
+
+  T8_ASSERT (forest->element_tree_index == NULL);
+
+  num_blocks = (forest->local_num_elements +
+                (1 << T8_FOREST_ELEMENT_BLOCK_LOG) -
+                1) >> T8_FOREST_ELEMENT_BLOCK_LOG;
+  forest->element_tree_index = T8_ALLOC (t8_locidx_t, SC_MAX (num_blocks, 1));
+  num_trees = t8_forest_get_num_local_trees (forest);
+  ltree = 0;
+  for (iblock = 0; iblock < num_blocks; iblock++) {
+    /* Find the tree that contains the first element of this block */
+    for (;;) {
+      tree = t8_forest_get_tree (forest, ltree);
+      tree_end = tree->elements_offset +
+        (t8_locidx_t) t8_element_array_get_count (&tree->elements);
+      if ((iblock << T8_FOREST_ELEMENT_BLOCK_LOG) < tree_end) {
+        break;
+      }
+      ltree++;
+      T8_ASSERT (ltree < num_trees);
+    }
+    forest->element_tree_index[iblock] = ltree;
+  }
+}
+
+/* Add the partition table counters of the profile of an intermediate forest
+ * of a commit to the profile of the committed forest. */
+static void
+t8_forest_profile_add_tables (t8_profile_t * profile,
+                              const t8_profile_t * profile_from)
+{
+  profile->element_offsets_computed += profile_from->element_offsets_computed;
+  profile->first_desc_computed += profile_from->first_desc_computed;
+  profile->tree_offsets_computed += profile_from->tree_offsets_computed;
+  profile->partition_tables_shared += profile_from->partition_tables_shared;
+}
+
+/* Split the communicator of a partitioned forest into the processes with
+ * and without elements. Afterwards the forest lives on the group of this
+ * process and owns its communicator. */
+static void
+t8_forest_comm_shrink (t8_forest_t forest)
+{
+  sc_MPI_Comm         comm_group;
+  int                 idle, num_idle, mpiret;
+
+  SC_CHECK_ABORT (!forest->do_dup,
+                  "Cannot shrink a duplicated forest communicator");
+  SC_CHECK_ABORT (!t8_cmesh_is_partitioned (forest->cmesh),
+                  "Cannot shrink the communicator of a forest with "
+                  "partitioned cmesh");
+
+  /* The idle processes reset their count below */
+  (void) t8_forest_comm_global_num_elements_wait (forest);
+  idle = forest->local_num_elements == 0;
+  mpiret = sc_MPI_Allreduce (&idle, &num_idle, 1, sc_MPI_INT, sc_MPI_SUM,
+                             forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (num_idle == 0 || num_idle == forest->mpisize) {
+    /* There is nothing to split off */
+    return;
+  }
+  /* The tables refer to the processes of the parent communicator */
+  t8_forest_destroy_partition_tables (forest);
+
+  /* Keeping the rank as key preserves the order of the elements */
+  mpiret = sc_MPI_Comm_split (forest->mpicomm, idle, forest->mpirank,
+                              &comm_group);
+  SC_CHECK_MPI (mpiret);
+  t8_debugf ("Split off %i of %i processes without elements\n", num_idle,
+             forest->mpisize);
+  forest->parent_comm = forest->mpicomm;
+  forest->mpicomm = comm_group;
+  forest->do_dup = 1;
+  forest->comm_idle = idle;
+  mpiret = sc_MPI_Comm_size (forest->mpicomm, &forest->mpisize);
   SC_CHECK_MPI (mpiret);
-  forest->global_num_elements = global_num_el;
+  mpiret = sc_MPI_Comm_rank (forest->mpicomm, &forest->mpirank);
+  SC_CHECK_MPI (mpiret);
+  if (idle) {
+    /* The forest of the idle processes has no elements */
+    forest->global_num_elements = 0;
+  }
+}
+
+/* Return a copy of a forest with shrunk communicator that lives on the
+ * parent communicator again. The copy shares the elements. */
+static              t8_forest_t
+t8_forest_new_expanded (t8_forest_t forest_from)
+{
+  t8_forest_t         forest;
+
+  T8_ASSERT (t8_forest_is_committed (forest_from));
+  T8_ASSERT (forest_from->parent_comm != sc_MPI_COMM_NULL);
+  SC_CHECK_ABORT (forest_from->fields == NULL,
+                  "Element fields cannot follow a partition that expands "
+                  "a shrunk communicator");
+
+  t8_forest_init (&forest);
+  t8_forest_ref (forest_from);
+  t8_forest_set_copy (forest, forest_from);
+  forest->set_expand_comm = 1;
+  forest->set_lazy_partition_tables = 1;
+  t8_forest_commit (forest);
+  return forest;
+}
+
+/* Commit the uncommitted forest that a forest is derived from. If no one
+ * but the derived forest holds a reference, the link is destroyed after the
+ * derivation, so it does not need ghosts, caches or packed elements. */
+static void
+t8_forest_commit_chain_link (t8_forest_t link)
+{
+  T8_ASSERT (t8_forest_is_initialized (link));
+
+  if (link->rc.refcount == 1) {
+    link->chain_link = 1;
+    link->do_ghost = 0;
+    link->set_face_connectivity = 0;
+    link->set_geometry_cache = 0;
+    link->set_tree_bvh = 0;
+    link->set_element_tree_index = 0;
+  }
+  t8_forest_commit (link);
 }
 
 void
@@ -341,7 +654,11 @@ t8_forest_commit (t8_forest_t forest)
 {
   int                 mpiret;
   int                 partitioned = 0;
+  int                 keep_adapt_map = 1;
   sc_MPI_Comm         comm_dup;
+  t8_forest_t         forest_ghost_from = NULL;
+  t8_forest_t         forest_fields_from = NULL;
+  int                 fields_method = T8_FOREST_FROM_COPY;
 
   T8_ASSERT (forest != NULL);
   T8_ASSERT (forest->rc.refcount > 0);
@@ -350,7 +667,9 @@ t8_forest_commit (t8_forest_t forest)
   if (forest->profile != NULL) {
     /* If profiling is enabled, we measure the runtime of commit */
     forest->profile->commit_runtime = sc_MPI_Wtime ();
+    t8_counters_start (forest->profile->commit_counters);
   }
+  t8_trace_begin ("commit");
 
   if (forest->set_from == NULL) {
     /* This forest is constructed solely from its cmesh as a uniform
@@ -377,12 +696,74 @@ t8_forest_commit (t8_forest_t forest)
     t8_forest_compute_maxlevel (forest);
     T8_ASSERT (forest->set_level <= forest->maxlevel);
     /* populate a new forest with tree and quadrant objects */
-    t8_forest_populate (forest);
+    if (forest->profile != NULL) {
+      forest->profile->populate_runtime = -sc_MPI_Wtime ();
+    }
+    if (forest->set_load_filename != NULL) {
+      /* read the elements from a file */
+      t8_forest_load_elements (forest);
+      T8_FREE (forest->set_load_filename);
+      forest->set_load_filename = NULL;
+    }
+    else if (forest->set_leaves) {
+      /* create the given leaves */
+      t8_forest_populate_leaves (forest);
+      forest->set_leaves = 0;
+    }
+    else {
+      t8_forest_populate (forest);
+    }
+    if (forest->profile != NULL) {
+      forest->profile->populate_runtime += sc_MPI_Wtime ();
+    }
     forest->global_num_trees = t8_cmesh_get_num_trees (forest->cmesh);
   }
   else {                        /* set_from != NULL */
     t8_forest_t         forest_from = forest->set_from; /* temporarily store set_from, since we may overwrite it */
 
+    if (!forest_from->committed) {
+      /* forest_from is the previous step of a derivation chain */
+      t8_forest_commit_chain_link (forest_from);
+    }
+
+    if (forest->set_ghost_incremental && forest->do_ghost
+        && forest->ghost_depth < 2
+        && forest->from_method == T8_FOREST_FROM_ADAPT
+        && !forest->set_adapt_recursive && forest_from->ghosts != NULL
+        && forest->ghost_type == T8_GHOST_FACES
+        && forest_from->ghost_type == forest->ghost_type
+        && forest_from->ghost_algorithm == forest->ghost_algorithm) {
+      /* We update the ghost layer of forest_from. For this we need the
+       * adapt map and forest_from must survive until the ghost layer
+       * is created. */
+      keep_adapt_map = forest->set_adapt_map;
+      forest->set_adapt_map = 1;
+      t8_forest_ref (forest_from);
+      forest_ghost_from = forest_from;
+    }
+
+    if (forest_from->fields != NULL) {
+      /* The fields are moved by the last step of this commit, which is the
+       * last of adapt, partition and balance that is set */
+      fields_method = forest->from_method & T8_FOREST_FROM_BALANCE ?
+        T8_FOREST_FROM_BALANCE : forest->from_method &
+        T8_FOREST_FROM_PARTITION ? T8_FOREST_FROM_PARTITION :
+        forest->from_method;
+      SC_CHECK_ABORT (fields_method != T8_FOREST_FROM_BALANCE
+                      || forest->set_balance != T8_FOREST_BALANCE_REPART,
+                      "Element fields cannot follow a balance with "
+                      "repartition");
+      if (forest->from_method == T8_FOREST_FROM_ADAPT
+          && !forest->set_adapt_recursive) {
+        /* Record the adapt map to replace the field data without
+         * comparing elements */
+        if (forest_ghost_from == NULL) {
+          keep_adapt_map = forest->set_adapt_map;
+        }
+        forest->set_adapt_map = 1;
+      }
+    }
+
     t8_debugf ("[h] from method %i\n", forest->from_method);
     T8_ASSERT (forest->mpicomm == sc_MPI_COMM_NULL);
     T8_ASSERT (forest->cmesh == NULL);
@@ -394,14 +775,27 @@ t8_forest_commit (t8_forest_t forest)
     /* TODO: optimize all this when forest->set_from has reference count one */
     /* TODO: Get rid of duping the communicator */
     /* we must prevent the case that set_from frees the source communicator */
-    if (!forest->set_from->do_dup) {
-      forest->mpicomm = forest->set_from->mpicomm;
+    if (forest->set_from->parent_comm != sc_MPI_COMM_NULL
+        && (forest->set_expand_comm
+            || forest->from_method & T8_FOREST_FROM_PARTITION)) {
+      /* Partition distributes the elements over the parent communicator
+       * of a shrunk forest again */
+      forest->mpicomm = forest->set_from->parent_comm;
+      forest->do_dup = 0;
     }
     else {
-      mpiret = sc_MPI_Comm_dup (forest->set_from->mpicomm, &forest->mpicomm);
-      SC_CHECK_MPI (mpiret);
+      if (!forest->set_from->do_dup) {
+        forest->mpicomm = forest->set_from->mpicomm;
+      }
+      else {
+        mpiret =
+          sc_MPI_Comm_dup (forest->set_from->mpicomm, &forest->mpicomm);
+        SC_CHECK_MPI (mpiret);
+      }
+      forest->do_dup = forest->set_from->do_dup;
+      forest->parent_comm = forest->set_from->parent_comm;
+      forest->comm_idle = forest->set_from->comm_idle;
     }
-    forest->do_dup = forest->set_from->do_dup;
 
     /* Set mpirank and mpisize */
     mpiret = sc_MPI_Comm_size (forest->mpicomm, &forest->mpisize);
@@ -417,6 +811,8 @@ t8_forest_commit (t8_forest_t forest)
     forest->cmesh = forest->set_from->cmesh;
     forest->scheme_cxx = forest->set_from->scheme_cxx;
     forest->global_num_trees = forest->set_from->global_num_trees;
+    /* Do not use specialized kernels if the old forest did not */
+    forest->set_no_kernels |= forest->set_from->set_no_kernels;
 
     /* Compute the maximum allowed refinement level */
     t8_forest_compute_maxlevel (forest);
@@ -424,12 +820,18 @@ t8_forest_commit (t8_forest_t forest)
       SC_CHECK_ABORT (forest->set_from != NULL,
                       "No forest to copy from was specified.");
       t8_forest_copy_trees (forest, forest->set_from, 1);
+      if (forest->set_expand_comm) {
+        /* Count the elements of all groups */
+        t8_forest_comm_global_num_elements (forest);
+      }
     }
     /* TODO: currently we can only handle copy, adapt, partition, and balance */
 
     /* T8_ASSERT (forest->from_method == T8_FOREST_FROM_COPY); */
     if (forest->from_method & T8_FOREST_FROM_ADAPT) {
-      SC_CHECK_ABORT (forest->set_adapt_fn != NULL,
+      SC_CHECK_ABORT (forest->set_adapt_fn != NULL
+                      || forest->set_adapt_tree_fn != NULL
+                      || forest->set_adapt_markers != NULL,
                       "No adapt function specified");
       forest->from_method -= T8_FOREST_FROM_ADAPT;
       if (forest->from_method > 0) {
@@ -449,6 +851,13 @@ t8_forest_commit (t8_forest_t forest)
                              forest->set_adapt_recursive);
         /* Set profiling if enabled */
         t8_forest_set_profiling (forest_adapt, forest->profile != NULL);
+        forest_adapt->set_no_kernels = forest->set_no_kernels;
+        forest_adapt->set_adapt_tree_fn = forest->set_adapt_tree_fn;
+        forest_adapt->set_adapt_markers = forest->set_adapt_markers;
+        forest_adapt->set_adapt_threads = forest->set_adapt_threads;
+        forest_adapt->set_trim_elements = forest->set_trim_elements;
+        /* Incremental balance needs to know which elements were changed */
+        forest_adapt->set_adapt_map = forest->set_balance_incremental;
         t8_forest_commit (forest_adapt);
         /* The new forest will be partitioned/balanced from forest_adapt */
         forest->set_from = forest_adapt;
@@ -459,18 +868,47 @@ t8_forest_commit (t8_forest_t forest)
         if (forest->profile != NULL) {
           forest->profile->adapt_runtime =
             forest_adapt->profile->adapt_runtime;
+          memcpy (forest->profile->adapt_counters,
+                  forest_adapt->profile->adapt_counters,
+                  sizeof (forest->profile->adapt_counters));
+          forest->profile->adapt_memory = forest_adapt->profile->adapt_memory;
+          forest->profile->specialized_kernels =
+            forest_adapt->profile->specialized_kernels;
+          t8_forest_profile_add_tables (forest->profile,
+                                        forest_adapt->profile);
         }
       }
       else {
         /* This forest should only be adapted */
         t8_forest_copy_trees (forest, forest->set_from, 0);
         t8_forest_adapt (forest);
+        /* Adapt does not change the first descendant of a process, since
+         * it only coarsens local families. Thus the first descendants and
+         * the tree offsets do not change. */
+        t8_forest_partition_tables_inherit (forest, forest->set_from,
+                                            T8_FOREST_TABLE_FIRST_DESC |
+                                            T8_FOREST_TABLE_TREE_OFFSETS);
       }
     }
     if (forest->from_method & T8_FOREST_FROM_PARTITION) {
       partitioned = 1;
       /* Partition this forest */
       forest->from_method -= T8_FOREST_FROM_PARTITION;
+      /* The weights array refers to the elements before adapt */
+      SC_CHECK_ABORT (forest->set_partition_weights == NULL
+                      || forest_from == forest->set_from,
+                      "Partition weights cannot be combined with adapt");
+      if (forest->set_from->parent_comm != sc_MPI_COMM_NULL) {
+        /* Partition from a copy on the parent communicator */
+        t8_forest_t         forest_expand =
+          t8_forest_new_expanded (forest->set_from);
+
+        if (forest_from != forest->set_from) {
+          /* The copy keeps the intermediate forest alive as long as needed */
+          t8_forest_unref (&forest->set_from);
+        }
+        forest->set_from = forest_expand;
+      }
 
       if (forest->from_method > 0) {
         /* The forest should also be balanced after partition */
@@ -483,8 +921,16 @@ t8_forest_commit (t8_forest_t forest)
         }
         t8_forest_set_partition (forest_partition, forest->set_from,
                                  forest->set_for_coarsening);
+        t8_forest_set_partition_weights (forest_partition,
+                                         forest->set_partition_weight_fn,
+                                         forest->set_partition_weights);
+        t8_forest_set_partition_eclass_costs (forest_partition,
+                                              forest->set_partition_eclass_costs);
+        t8_forest_set_partition_imbalance (forest_partition,
+                                           forest->set_partition_imbalance);
         /* activate profiling, if this forest has profiling */
         t8_forest_set_profiling (forest_partition, forest->profile != NULL);
+        forest_partition->set_trim_elements = forest->set_trim_elements;
         /* Commit the partitioned forest */
         t8_forest_commit (forest_partition);
         forest->set_from = forest_partition;
@@ -499,11 +945,23 @@ t8_forest_commit (t8_forest_t forest)
             forest_partition->profile->partition_procs_sent;
           forest->profile->partition_runtime =
             forest_partition->profile->partition_runtime;
+          memcpy (forest->profile->partition_counters,
+                  forest_partition->profile->partition_counters,
+                  sizeof (forest->profile->partition_counters));
+          forest->profile->partition_memory =
+            forest_partition->profile->partition_memory;
+          forest->profile->partition_imbalance =
+            forest_partition->profile->partition_imbalance;
+          forest->profile->partition_skipped =
+            forest_partition->profile->partition_skipped;
+          t8_forest_profile_add_tables (forest->profile,
+                                        forest_partition->profile);
         }
       }
       else {
         /* Partitioning is the last routine, no balance was set */
-        forest->global_num_elements = forest->set_from->global_num_elements;
+        forest->global_num_elements =
+          t8_forest_comm_global_num_elements_wait (forest->set_from);
         /* Initialize the trees array of the forest */
         forest->trees = sc_array_new (sizeof (t8_tree_struct_t));
         /* partition the forest */
@@ -528,6 +986,12 @@ t8_forest_commit (t8_forest_t forest)
       }
     }
 
+    if (forest->set_from->fields != NULL) {
+      /* Keep the forest that we derived this forest from until its
+       * fields are moved */
+      t8_forest_ref (forest->set_from);
+      forest_fields_from = forest->set_from;
+    }
     if (forest_from != forest->set_from) {
       /* decrease reference count of intermediate input forest, possibly destroying it */
       t8_forest_unref (&forest->set_from);
@@ -538,6 +1002,23 @@ t8_forest_commit (t8_forest_t forest)
     t8_forest_unref (&forest->set_from);
   }                             /* end set_from != NULL */
 
+  if (forest->chain_link) {
+    /* The next forest of the chain consumes the trees as they are.
+     * The trees that the link grew own their elements, so
+     * t8_forest_tree_share copies those that the next forest does not
+     * change, since the link is destroyed after the derivation. */
+  }
+  else if (forest->set_trim_elements) {
+    /* Free the unused memory of the trees that adapt, partition or balance
+     * grew tree by tree */
+    t8_forest_trees_trim (forest);
+  }
+  else {
+    /* Store the elements of all trees in one allocation, if adapt, partition
+     * or balance grew them tree by tree and did not share them */
+    t8_forest_trees_pack (forest);
+  }
+
   /* Compute the element offset of the trees */
   t8_forest_compute_elements_offset (forest);
 
@@ -547,14 +1028,25 @@ t8_forest_commit (t8_forest_t forest)
   /* we do not need the set parameters anymore */
   forest->set_level = 0;
   forest->set_for_coarsening = 0;
+  /* The weights refer to the elements of set_from */
+  forest->set_partition_weight_fn = NULL;
+  forest->set_partition_weights = NULL;
   forest->set_from = NULL;
   forest->committed = 1;
+#ifdef T8_ENABLE_DEBUG
+  /* Only debug builds wait for the global count here */
   t8_debugf ("Committed forest with %li local elements and %lli "
              "global elements.\n\tTree range ist from %lli to %lli.\n",
              (long) forest->local_num_elements,
-             (long long) forest->global_num_elements,
+             (long long) t8_forest_comm_global_num_elements_wait (forest),
              (long long) forest->first_local_tree,
              (long long) forest->last_local_tree);
+#endif
+
+  if (forest->set_shrink_comm && partitioned && forest->mpisize > 1) {
+    /* Let the processes without elements continue on their own */
+    t8_forest_comm_shrink (forest);
+  }
 
 #if 0
   /* TODO: Do we keep the arrays or not? */
@@ -563,17 +1055,15 @@ t8_forest_commit (t8_forest_t forest)
   T8_ASSERT (forest->tree_offsets == NULL);
   T8_ASSERT (forest->global_first_desc == NULL);
 #else
-  if (forest->tree_offsets == NULL) {
-    /* Compute the tree offset array */
-    t8_forest_partition_create_tree_offsets (forest);
+  if (forest->profile != NULL) {
+    forest->profile->offsets_runtime = -sc_MPI_Wtime ();
   }
-  if (forest->element_offsets == NULL) {
-    /* Compute element offsets */
-    t8_forest_partition_create_offsets (forest);
+  if (!forest->set_lazy_partition_tables) {
+    /* Compute the tables that partition, balance or adapt did not provide */
+    (void) t8_forest_partition_tables_require (forest, T8_FOREST_TABLE_ALL);
   }
-  if (forest->global_first_desc == NULL) {
-    /* Compute global first desc array */
-    t8_forest_partition_create_first_desc (forest);
+  if (forest->profile != NULL) {
+    forest->profile->offsets_runtime += sc_MPI_Wtime ();
   }
 #endif
 
@@ -581,6 +1071,7 @@ t8_forest_commit (t8_forest_t forest)
     /* If profiling is enabled, we measure the runtime of commit */
     forest->profile->commit_runtime = sc_MPI_Wtime () -
       forest->profile->commit_runtime;
+    t8_counters_stop (forest->profile->commit_counters);
   }
 
   /* From here on, the forest passes the t8_forest_is_committed check */
@@ -590,10 +1081,18 @@ t8_forest_commit (t8_forest_t forest)
     t8_forest_partition_cmesh (forest, forest->mpicomm,
                                forest->profile != NULL);
   }
+  /* Store the connections of the local trees to their face neighbors */
+  t8_forest_tree_faces_build (forest);
 
   if (forest->mpisize > 1) {
-    /* Construct a ghost layer, if desired */
-    if (forest->do_ghost) {
+    /* Construct a ghost layer, if desired and balance did not already
+     * provide it */
+    if (forest->do_ghost && forest->ghosts == NULL
+        && forest_ghost_from != NULL) {
+      /* Update the ghost layer of the forest that we adapted */
+      t8_forest_ghost_create_incremental (forest, forest_ghost_from);
+    }
+    else if (forest->do_ghost && forest->ghosts == NULL) {
       /* TODO: ghost type */
       switch (forest->ghost_algorithm) {
       case 1:
@@ -609,8 +1108,54 @@ t8_forest_commit (t8_forest_t forest)
         SC_ABORT ("Invalid choice of ghost algorithm");
       }
     }
+    if (forest->do_ghost && forest->ghost_depth > 1) {
+      /* The further layers are found with the balanced face neighbor
+       * search. If balance was not part of this commit, we check it. */
+      SC_CHECK_ABORT (forest->from_method & T8_FOREST_FROM_BALANCE
+                      || t8_forest_is_balanced (forest),
+                      "Ghost layers of depth greater than 1 require a "
+                      "balanced forest.\n");
+      /* Add the further layers of face neighbors */
+      t8_forest_ghost_expand (forest, forest->ghost_depth);
+    }
   forest->do_ghost = 0;
   }
+  /* Store the map of every local and ghost tree */
+  t8_forest_tree_maps_build (forest);
+  if (forest->set_tree_bvh) {
+    /* Store the hierarchy of the local and ghost tree boxes */
+    t8_forest_tree_bvh_build (forest);
+  }
+  if (forest_fields_from != NULL) {
+    /* Move the element fields to this forest */
+    t8_forest_fields_transfer (forest, forest_fields_from, fields_method);
+    t8_forest_unref (&forest_fields_from);
+  }
+  if (forest_ghost_from != NULL) {
+    t8_forest_unref (&forest_ghost_from);
+  }
+  if (!keep_adapt_map && forest->adapt_map != NULL) {
+    /* The adapt map was only recorded for the ghost layer */
+    sc_array_destroy (forest->adapt_map);
+    forest->adapt_map = NULL;
+  }
+  if (forest->set_face_connectivity) {
+    /* Store the face neighbors of all local elements */
+    t8_forest_face_connectivity_build (forest);
+  }
+  if (forest->set_geometry_cache) {
+    /* Store the geometry of all local elements */
+    t8_forest_geometry_cache_build (forest);
+  }
+  if (forest->set_element_tree_index) {
+    /* Store the tree of every block of local elements */
+    t8_forest_element_tree_index_build (forest);
+  }
+  if (forest->set_lazy_partition_tables) {
+    /* Free the tables that partition, balance or ghost left to us */
+    t8_forest_destroy_partition_tables (forest);
+  }
+  t8_trace_end ("commit");
 }
 
 t8_locidx_t
@@ -626,7 +1171,138 @@ t8_forest_get_global_num_elements (t8_forest_t forest)
 {
   T8_ASSERT (t8_forest_is_committed (forest));
 
-  return forest->global_num_elements;
+  return t8_forest_comm_global_num_elements_wait (forest);
+}
+
+int
+t8_forest_get_face_connectivity (t8_forest_t forest,
+                                 const t8_locidx_t ** face_offsets,
+                                 const t8_locidx_t ** neigh_offsets,
+                                 const t8_locidx_t ** neighbors,
+                                 const int **dual_faces,
+                                 const int8_t ** orientations)
+{
+  t8_forest_face_connectivity_t *conn;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  conn = forest->face_connectivity;
+  if (conn == NULL) {
+    return 0;
+  }
+  *face_offsets = conn->face_offsets;
+  *neigh_offsets = conn->neigh_offsets;
+  *neighbors = conn->neighbors;
+  *dual_faces = conn->dual_faces;
+  *orientations = conn->orientations;
+  return 1;
+}
+
+void
+t8_forest_get_geometry_cache (t8_forest_t forest, const double **volumes,
+                              const double **centroids,
+                              const t8_locidx_t ** face_offsets,
+                              const double **face_areas,
+                              const double **face_normals)
+{
+  t8_forest_geometry_cache_t *cache;
+  int                 i;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  /* Compute the cache on first use. Several threads may call this function
+   * at once, thus only one of them builds the cache and the others wait
+   * for it. The critical section also makes the cache visible to them. */
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp critical (t8_forest_geometry_cache)
+#endif
+  {
+    if (forest->geometry_cache == NULL) {
+      t8_forest_geometry_cache_build (forest);
+    }
+    cache = forest->geometry_cache;
+  }
+  if (volumes != NULL) {
+    *volumes = cache->volumes;
+  }
+  if (face_offsets != NULL) {
+    *face_offsets = cache->face_offsets;
+  }
+  if (face_areas != NULL) {
+    *face_areas = cache->face_areas;
+  }
+  for (i = 0; i < 3; i++) {
+    if (centroids != NULL) {
+      centroids[i] = cache->centroids[i];
+    }
+    if (face_normals != NULL) {
+      face_normals[i] = cache->face_normals[i];
+    }
+  }
+}
+
+int
+t8_forest_adapt_get_geometry (t8_forest_t forest_from,
+                              t8_locidx_t which_tree,
+                              t8_locidx_t lelement_id,
+                              const t8_element_t * element,
+                              const double **volumes,
+                              const double **centroids,
+                              const double **diameters)
+{
+  t8_forest_geometry_cache_t *cache;
+  t8_locidx_t         offset;
+  int                 i;
+
+  T8_ASSERT (t8_forest_is_committed (forest_from));
+
+  cache = forest_from->geometry_cache;
+  /* During recursive refinement the callback is also called with the
+   * descendants of the element, which are not in the cache */
+  if (cache == NULL || element !=
+      t8_forest_get_element_in_tree (forest_from, which_tree, lelement_id)) {
+    return 0;
+  }
+  offset = t8_forest_get_tree_element_offset (forest_from, which_tree)
+    + lelement_id;
+  if (volumes != NULL) {
+    *volumes = cache->volumes + offset;
+  }
+  if (diameters != NULL) {
+    *diameters = cache->diameters + offset;
+  }
+  if (centroids != NULL) {
+    for (i = 0; i < 3; i++) {
+      centroids[i] = cache->centroids[i] + offset;
+    }
+  }
+  return 1;
+}
+
+t8_locidx_t
+t8_forest_get_face_connectivity_neighbors (t8_forest_t forest,
+                                           t8_locidx_t lelement, int face,
+                                           const t8_locidx_t ** neighbors,
+                                           const int **dual_faces,
+                                           int *orientation)
+{
+  t8_forest_face_connectivity_t *conn;
+  t8_locidx_t         face_entry, first;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->face_connectivity != NULL);
+  T8_ASSERT (0 <= lelement && lelement < forest->local_num_elements);
+
+  conn = forest->face_connectivity;
+  face_entry = conn->face_offsets[lelement] + face;
+  T8_ASSERT (0 <= face && face_entry < conn->face_offsets[lelement + 1]);
+  first = conn->neigh_offsets[face_entry];
+  *neighbors = conn->neighbors + first;
+  *dual_faces = conn->dual_faces + first;
+  if (orientation != NULL) {
+    *orientation = conn->orientations[face_entry];
+  }
+  return conn->neigh_offsets[face_entry + 1] - first;
 }
 
 t8_locidx_t
@@ -665,10 +1341,9 @@ t8_forest_compute_cmesh_offset (t8_forest_t forest, sc_MPI_Comm comm)
 {
   t8_shmem_array_t    offset;
 
-  if (forest->tree_offsets == NULL) {
-    /* Create the tree offsets if necessary */
-    t8_forest_partition_create_tree_offsets (forest);
-  }
+  /* Create the tree offsets if necessary */
+  (void) t8_forest_partition_tables_require (forest,
+                                             T8_FOREST_TABLE_TREE_OFFSETS);
   /* initialize the shared memory array */
   t8_shmem_array_init (&offset, sizeof (t8_gloidx_t), forest->mpisize + 1,
                        comm);
@@ -691,9 +1366,6 @@ t8_forest_partition_cmesh (t8_forest_t forest, sc_MPI_Comm comm,
   t8_cmesh_init (&cmesh_partition);
   t8_cmesh_set_derive (cmesh_partition, forest->cmesh);
   /* set partition range of new cmesh according to forest trees */
-  if (forest->tree_offsets == NULL) {
-    t8_forest_partition_create_tree_offsets (forest);
-  }
   offsets = t8_forest_compute_cmesh_offset (forest, comm);
 
   t8_cmesh_set_partition_offsets (cmesh_partition, offsets);
@@ -713,6 +1385,13 @@ t8_forest_get_mpicomm (t8_forest_t forest)
   return forest->mpicomm;
 }
 
+int
+t8_forest_is_idle (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  return forest->comm_idle;
+}
+
 t8_gloidx_t
 t8_forest_get_first_local_tree_id (t8_forest_t forest)
 {
@@ -782,6 +1461,19 @@ t8_forest_global_tree_id (t8_forest_t forest, t8_locidx_t ltreeid)
  * forest is committed here. */
 t8_tree_t
 t8_forest_get_tree (t8_forest_t forest, t8_locidx_t ltree_id)
+{
+  t8_tree_t           tree;
+
+  tree = t8_forest_get_tree_lazy (forest, ltree_id);
+  if (tree->implicit_level >= 0
+      && t8_element_array_get_count (&tree->elements) == 0) {
+    t8_forest_tree_materialize (forest, tree);
+  }
+  return tree;
+}
+
+t8_tree_t
+t8_forest_get_tree_lazy (t8_forest_t forest, t8_locidx_t ltree_id)
 {
   T8_ASSERT (forest->trees != NULL);
   T8_ASSERT (0 <= ltree_id
@@ -855,6 +1547,24 @@ t8_forest_get_element (t8_forest_t forest, t8_locidx_t lelement_id,
   if (lelement_id >= t8_forest_get_num_element (forest)) {
     return NULL;
   }
+  if (forest->element_tree_index != NULL) {
+    /* Start at the tree of the element's block. Since a block has a fixed
+     * number of elements, we pass at most this many trees. */
+    ltree =
+      forest->element_tree_index[lelement_id >> T8_FOREST_ELEMENT_BLOCK_LOG];
+    tree = t8_forest_get_tree (forest, ltree);
+    while (tree->elements_offset +
+           (t8_locidx_t) t8_element_array_get_count (&tree->elements) <=
+           lelement_id) {
+      tree = t8_forest_get_tree (forest, ++ltree);
+    }
+    if (ltreeid != NULL) {
+      *ltreeid = ltree;
+    }
+    return t8_element_array_index_locidx (&tree->elements,
+                                          lelement_id -
+                                          tree->elements_offset);
+  }
   /* We optimized the binary search out by using sc_bsearch,
    * but keep it in for debugging. We check whether the hand-written
    * binary search matches the sc_array_bsearch. */
@@ -927,7 +1637,7 @@ t8_forest_get_tree_element_offset (t8_forest_t forest, t8_locidx_t ltreeid)
 {
   T8_ASSERT (t8_forest_is_committed (forest));
 
-  return t8_forest_get_tree (forest, ltreeid)->elements_offset;
+  return t8_forest_get_tree_lazy (forest, ltreeid)->elements_offset;
 }
 
 t8_locidx_t
@@ -936,6 +1646,9 @@ t8_forest_get_tree_element_count (t8_tree_t tree)
   t8_locidx_t         element_count;
 
   T8_ASSERT (tree != NULL);
+  if (tree->implicit_level >= 0) {
+    return tree->implicit_count;
+  }
   element_count = t8_element_array_get_count (&tree->elements);
   /* check for type conversion errors */
   T8_ASSERT ((size_t) element_count ==
@@ -950,8 +1663,9 @@ t8_forest_get_tree_num_elements (t8_forest_t forest, t8_locidx_t ltreeid)
   T8_ASSERT (0 <= ltreeid
              && ltreeid < t8_forest_get_num_local_trees (forest));
 
-  return t8_forest_get_tree_element_count (t8_forest_get_tree (forest,
-                                                               ltreeid));
+  return
+    t8_forest_get_tree_element_count (t8_forest_get_tree_lazy
+                                      (forest, ltreeid));
 }
 
 t8_eclass_t
@@ -965,7 +1679,7 @@ t8_forest_get_tree_class (t8_forest_t forest, t8_locidx_t ltreeid)
              num_local_trees + t8_forest_get_num_ghost_trees (forest));
   if (ltreeid < num_local_trees) {
     /* The id belongs to a local tree */
-    return t8_forest_get_tree (forest, ltreeid)->eclass;
+    return t8_forest_get_tree_lazy (forest, ltreeid)->eclass;
   }
   else {
     /* The id belongs to a ghost tree */
@@ -1121,6 +1835,131 @@ t8_forest_get_coarse_tree (t8_forest_t forest, t8_locidx_t ltreeid)
   return t8_forest_get_coarse_tree_ext (forest, ltreeid, NULL, NULL);
 }
 
+void
+t8_forest_set_specialized_kernels (t8_forest_t forest, int enable)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_no_kernels = !enable;
+}
+
+void
+t8_forest_set_adapt_map (t8_forest_t forest, int record)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_adapt_map = record != 0;
+}
+
+void
+t8_forest_set_adapt_threads (t8_forest_t forest, int num_threads)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_adapt_threads = num_threads;
+}
+
+void
+t8_forest_set_ghost_threads (t8_forest_t forest, int num_threads)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_ghost_threads = num_threads;
+}
+
+void
+t8_forest_set_ghost_incremental (t8_forest_t forest, int incremental)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_ghost_incremental = incremental != 0;
+}
+
+void
+t8_forest_set_face_connectivity (t8_forest_t forest, int build)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_face_connectivity = build != 0;
+}
+
+void
+t8_forest_set_geometry_cache (t8_forest_t forest, int build)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_geometry_cache = build != 0;
+}
+
+void
+t8_forest_set_tree_bvh (t8_forest_t forest, int build)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_tree_bvh = build != 0;
+}
+
+void
+t8_forest_set_element_tree_index (t8_forest_t forest, int build)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_element_tree_index = build != 0;
+}
+
+void
+t8_forest_set_lazy_partition_tables (t8_forest_t forest, int lazy)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_lazy_partition_tables = lazy != 0;
+}
+
+void
+t8_forest_set_trim_elements (t8_forest_t forest, int trim)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_trim_elements = trim != 0;
+}
+
+void
+t8_forest_set_implicit_uniform (t8_forest_t forest, int implicit)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_implicit_uniform = implicit != 0;
+}
+
+void
+t8_forest_materialize (t8_forest_t forest)
+{
+  t8_locidx_t         itree, num_trees;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    (void) t8_forest_get_tree (forest, itree);
+  }
+}
+
+void
+t8_forest_create_partition_tables (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  (void) t8_forest_partition_tables_require (forest, T8_FOREST_TABLE_ALL);
+}
+
+void
+t8_forest_destroy_partition_tables (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  t8_forest_partition_tables_release (forest, T8_FOREST_TABLE_ALL);
+}
+
 void
 t8_forest_set_profiling (t8_forest_t forest, int set_profiling)
 {
@@ -1140,14 +1979,118 @@ t8_forest_set_profiling (t8_forest_t forest, int set_profiling)
   }
 }
 
+/* The names of the components of t8_forest_memory_t for printing */
+static const char  *t8_forest_memory_names[T8_FOREST_MEMORY_COUNT] = {
+  "trees", "elements", "offsets", "ghost", "ghost hash", "adapt map",
+  "connectivity", "geometry", "fields"
+};
+
+/* The names of the components of t8_cmesh_memory_t for printing */
+static const char  *t8_cmesh_memory_names[T8_CMESH_MEMORY_COUNT] = {
+  "struct", "trees", "tree to proc", "ghost hash", "offsets"
+};
+
+/* Compute the minimum, maximum and sum over all processes of comm of
+ * num_values local numbers. Each of min, max and sum may be NULL. */
+static void
+t8_forest_memory_reduce (const size_t *local, int num_values,
+                         sc_MPI_Comm comm, size_t *min, size_t *max,
+                         size_t *sum)
+{
+  unsigned long long *send, *recv;
+  size_t             *result[3];
+  sc_MPI_Op           ops[3];
+  int                 ivalue, iop, mpiret;
+
+  send = T8_ALLOC (unsigned long long, num_values);
+  recv = T8_ALLOC (unsigned long long, num_values);
+  for (ivalue = 0; ivalue < num_values; ivalue++) {
+    send[ivalue] = (unsigned long long) local[ivalue];
+  }
+  result[0] = min;
+  result[1] = max;
+  result[2] = sum;
+  ops[0] = sc_MPI_MIN;
+  ops[1] = sc_MPI_MAX;
+  ops[2] = sc_MPI_SUM;
+  for (iop = 0; iop < 3; iop++) {
+    if (result[iop] == NULL) {
+      continue;
+    }
+    mpiret = sc_MPI_Allreduce (send, recv, num_values,
+                               sc_MPI_UNSIGNED_LONG_LONG, ops[iop], comm);
+    SC_CHECK_MPI (mpiret);
+    for (ivalue = 0; ivalue < num_values; ivalue++) {
+      result[iop][ivalue] = (size_t) recv[ivalue];
+    }
+  }
+  T8_FREE (send);
+  T8_FREE (recv);
+}
+
+/* Print the minimum, maximum and sum over all processes of the memory
+ * used by a forest and its cmesh. */
+static void
+t8_forest_print_memory_usage (t8_forest_t forest)
+{
+  size_t              usage[T8_FOREST_MEMORY_COUNT + 1];
+  size_t              min[T8_FOREST_MEMORY_COUNT + 1];
+  size_t              max[T8_FOREST_MEMORY_COUNT + 1];
+  size_t              sum[T8_FOREST_MEMORY_COUNT + 1];
+  int                 icomp;
+
+  t8_forest_memory_usage_global (forest, min, max, sum);
+  t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS,
+           "Memory usage of forest in bytes (min/max/sum):\n");
+  for (icomp = 0; icomp <= T8_FOREST_MEMORY_COUNT; icomp++) {
+    t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS, "   %-14s %llu %llu %llu\n",
+             icomp < T8_FOREST_MEMORY_COUNT ? t8_forest_memory_names[icomp]
+             : "total", (unsigned long long) min[icomp],
+             (unsigned long long) max[icomp],
+             (unsigned long long) sum[icomp]);
+  }
+
+  usage[T8_CMESH_MEMORY_COUNT] = t8_cmesh_memory_usage (forest->cmesh, usage);
+  t8_forest_memory_reduce (usage, T8_CMESH_MEMORY_COUNT + 1,
+                           forest->mpicomm, min, max, sum);
+  t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS,
+           "Memory usage of cmesh in bytes (min/max/sum):\n");
+  for (icomp = 0; icomp <= T8_CMESH_MEMORY_COUNT; icomp++) {
+    t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS, "   %-14s %llu %llu %llu\n",
+             icomp < T8_CMESH_MEMORY_COUNT ? t8_cmesh_memory_names[icomp]
+             : "total", (unsigned long long) min[icomp],
+             (unsigned long long) max[icomp],
+             (unsigned long long) sum[icomp]);
+  }
+}
+
+#ifdef T8_ENABLE_PERF_COUNTERS
+/* The names of the hardware counter stats of a forest profile */
+static const char  *t8_forest_counter_names[T8_PROFILE_NUM_COUNTED]
+[T8_COUNTER_COUNT] = {
+  {"forest: Adapt cycles.", "forest: Adapt instructions.",
+   "forest: Adapt LLC misses.", "forest: Adapt branch misses."},
+  {"forest: Partition cycles.", "forest: Partition instructions.",
+   "forest: Partition LLC misses.", "forest: Partition branch misses."},
+  {"forest: Ghost cycles.", "forest: Ghost instructions.",
+   "forest: Ghost LLC misses.", "forest: Ghost branch misses."},
+  {"forest: Balance cycles.", "forest: Balance instructions.",
+   "forest: Balance LLC misses.", "forest: Balance branch misses."},
+  {"forest: Commit cycles.", "forest: Commit instructions.",
+   "forest: Commit LLC misses.", "forest: Commit branch misses."}
+};
+#endif
+
 void
 t8_forest_print_profile (t8_forest_t forest)
 {
   T8_ASSERT (t8_forest_is_committed (forest));
   if (forest->profile != NULL) {
     /* Only print something if profiling is enabled */
-    sc_statinfo_t       stats[T8_PROFILE_NUM_STATS];
+    sc_statinfo_t       stats[T8_PROFILE_NUM_STATS +
+                              T8_PROFILE_NUM_COUNTED * T8_COUNTER_COUNT];
     t8_profile_t       *profile = forest->profile;
+    int                 num_stats = T8_PROFILE_NUM_STATS;
 
     /* Set the stats */
     sc_stats_set1 (&stats[0], profile->partition_elements_shipped,
@@ -1176,13 +2119,286 @@ t8_forest_print_profile (t8_forest_t forest)
                    "forest: Balance runtime.");
     sc_stats_set1 (&stats[12], profile->balance_rounds,
                    "forest: Balance rounds.");
+    sc_stats_set1 (&stats[13], profile->populate_runtime,
+                   "forest: Populate runtime.");
+    sc_stats_set1 (&stats[14], profile->specialized_kernels,
+                   "forest: Used single eclass kernels.");
+    sc_stats_set1 (&stats[15], profile->offsets_runtime,
+                   "forest: Partition offsets runtime.");
+    sc_stats_set1 (&stats[16], profile->offsets_saved_runtime,
+                   "forest: Partition offsets runtime saved.");
+    sc_stats_set1 (&stats[17], profile->ghost_saved_runtime,
+                   "forest: Ghost runtime saved.");
+    sc_stats_set1 (&stats[18], profile->balance_reductions_saved,
+                   "forest: Balance reductions saved.");
+    sc_stats_set1 (&stats[19], profile->partition_imbalance,
+                   "forest: Partition imbalance.");
+    sc_stats_set1 (&stats[20], profile->partition_skipped,
+                   "forest: Partition skipped.");
+    sc_stats_set1 (&stats[21], profile->ghost_overlap_time,
+                   "forest: Ghost exchange overlap time.");
+    sc_stats_set1 (&stats[22], profile->element_offsets_computed,
+                   "forest: Element offsets computed.");
+    sc_stats_set1 (&stats[23], profile->first_desc_computed,
+                   "forest: First descendants computed.");
+    sc_stats_set1 (&stats[24], profile->tree_offsets_computed,
+                   "forest: Tree offsets computed.");
+    sc_stats_set1 (&stats[25], profile->partition_tables_shared,
+                   "forest: Partition tables shared.");
+    sc_stats_set1 (&stats[26], profile->adapt_memory.before,
+                   "forest: Adapt memory before.");
+    sc_stats_set1 (&stats[27], profile->adapt_memory.peak,
+                   "forest: Adapt peak memory.");
+    sc_stats_set1 (&stats[28], profile->adapt_memory.after,
+                   "forest: Adapt memory after.");
+    sc_stats_set1 (&stats[29], profile->partition_memory.before,
+                   "forest: Partition memory before.");
+    sc_stats_set1 (&stats[30], profile->partition_memory.peak,
+                   "forest: Partition peak memory.");
+    sc_stats_set1 (&stats[31], profile->partition_memory.after,
+                   "forest: Partition memory after.");
+    sc_stats_set1 (&stats[32], profile->ghost_memory.before,
+                   "forest: Ghost memory before.");
+    sc_stats_set1 (&stats[33], profile->ghost_memory.peak,
+                   "forest: Ghost peak memory.");
+    sc_stats_set1 (&stats[34], profile->ghost_memory.after,
+                   "forest: Ghost memory after.");
+    sc_stats_set1 (&stats[35], profile->balance_memory.before,
+                   "forest: Balance memory before.");
+    sc_stats_set1 (&stats[36], profile->balance_memory.peak,
+                   "forest: Balance peak memory.");
+    sc_stats_set1 (&stats[37], profile->balance_memory.after,
+                   "forest: Balance memory after.");
+#ifdef T8_ENABLE_PERF_COUNTERS
+    /* This branch is the same on all processes, such that they compute
+     * the same stats */
+    {
+      const int64_t      *counters[T8_PROFILE_NUM_COUNTED] = {
+        profile->adapt_counters, profile->partition_counters,
+        profile->ghost_counters, profile->balance_counters,
+        profile->commit_counters
+      };
+      int                 iphase, icounter;
+
+      for (iphase = 0; iphase < T8_PROFILE_NUM_COUNTED; iphase++) {
+        for (icounter = 0; icounter < T8_COUNTER_COUNT; icounter++) {
+          sc_stats_set1 (&stats[num_stats++], counters[iphase][icounter],
+                         t8_forest_counter_names[iphase][icounter]);
+        }
+      }
+    }
+#endif
     /* compute stats */
-    sc_stats_compute (sc_MPI_COMM_WORLD, T8_PROFILE_NUM_STATS, stats);
+    sc_stats_compute (sc_MPI_COMM_WORLD, num_stats, stats);
     /* print stats */
     t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS, "Printing stats for forest.\n");
     sc_stats_print (t8_get_package_id (), SC_LP_STATISTICS,
-                    T8_PROFILE_NUM_STATS, stats, 1, 1);
+                    num_stats, stats, 1, 1);
+    t8_forest_print_memory_usage (forest);
+  }
+}
+
+void
+t8_forest_profile_accum_init (t8_forest_profile_accum_t * accum)
+{
+  T8_ASSERT (accum != NULL);
+
+  memset (accum, 0, sizeof (*accum));
+}
+
+void
+t8_forest_profile_accumulate (t8_forest_profile_accum_t * accum,
+                              t8_forest_t forest)
+{
+  double             *sums;
+
+  T8_ASSERT (accum != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  sums = accum->sums;
+  sums[T8_FOREST_PROFILE_ELEMENTS] += t8_forest_get_num_element (forest);
+  sums[T8_FOREST_PROFILE_GHOSTS] += t8_forest_get_num_ghosts (forest);
+  if (forest->profile != NULL) {
+    const t8_profile_t *profile = forest->profile;
+
+    sums[T8_FOREST_PROFILE_BYTES_SENT] += profile->partition_bytes_sent;
+    sums[T8_FOREST_PROFILE_ADAPT_RUNTIME] += profile->adapt_runtime;
+    sums[T8_FOREST_PROFILE_PARTITION_RUNTIME] += profile->partition_runtime;
+    sums[T8_FOREST_PROFILE_GHOST_RUNTIME] += profile->ghost_runtime;
+    sums[T8_FOREST_PROFILE_BALANCE_RUNTIME] += profile->balance_runtime;
+    sums[T8_FOREST_PROFILE_COMMIT_RUNTIME] += profile->commit_runtime;
   }
+  accum->num_commits++;
+}
+
+void
+t8_forest_profile_accum_reduce (const t8_forest_profile_accum_t * accum,
+                                sc_MPI_Comm comm, t8_profile_value_t * values)
+{
+  T8_ASSERT (accum != NULL);
+
+  t8_profile_reduce (T8_FOREST_PROFILE_COUNT, accum->sums, comm, values);
+}
+
+void
+t8_forest_profile_accum_print (const t8_forest_profile_accum_t * accum,
+                               sc_MPI_Comm comm)
+{
+  static const char  *names[T8_FOREST_PROFILE_COUNT] = {
+    "forest: Elements.", "forest: Ghost elements.",
+    "forest: Partition bytes sent.", "forest: Adapt runtime.",
+    "forest: Partition runtime.", "forest: Ghost runtime.",
+    "forest: Balance runtime.", "forest: Commit runtime."
+  };
+  t8_profile_value_t  values[T8_FOREST_PROFILE_COUNT];
+
+  t8_forest_profile_accum_reduce (accum, comm, values);
+  t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS,
+           "Printing the accumulated profile of %i forest commits.\n",
+           accum->num_commits);
+  t8_profile_print (T8_FOREST_PROFILE_COUNT, names, values);
+}
+
+/* The number of bytes of a shared memory array, 0 if it is NULL */
+static size_t
+t8_forest_shmem_array_bytes (t8_shmem_array_t array)
+{
+  if (array == NULL) {
+    return 0;
+  }
+  return t8_shmem_array_get_elem_size (array)
+    * t8_shmem_array_get_elem_count (array);
+}
+
+size_t
+t8_forest_memory_usage (t8_forest_t forest, size_t *usage)
+{
+  size_t              bytes[T8_FOREST_MEMORY_COUNT];
+  size_t              total;
+  t8_locidx_t         itree, num_elements, num_faces, num_neighbors;
+  t8_locidx_t         num_blocks;
+  t8_tree_t           tree;
+  t8_forest_field_t  *field;
+  size_t              ifield;
+  int                 icomp;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  memset (bytes, 0, sizeof (bytes));
+  num_elements = forest->local_num_elements;
+
+  bytes[T8_FOREST_MEMORY_TREES] = sizeof (t8_forest_struct_t);
+  if (forest->profile != NULL) {
+    bytes[T8_FOREST_MEMORY_TREES] += sizeof (t8_profile_t);
+  }
+  if (forest->trees != NULL) {
+    bytes[T8_FOREST_MEMORY_TREES] += sc_array_memory_used (forest->trees, 1);
+    for (itree = 0; itree < (t8_locidx_t) forest->trees->elem_count; itree++) {
+      /* Implicit trees store no elements and are not created here */
+      tree = t8_forest_get_tree_lazy (forest, itree);
+      bytes[T8_FOREST_MEMORY_ELEMENTS] +=
+        sc_array_memory_used (&tree->elements.array, 0);
+    }
+  }
+  /* The element arrays are views into the arenas and count zero bytes.
+   * We count our own arena, the shared trees belong to other forests. */
+  if (forest->element_arena != NULL) {
+    bytes[T8_FOREST_MEMORY_ELEMENTS] += forest->element_arena->size;
+  }
+
+  bytes[T8_FOREST_MEMORY_OFFSETS] =
+    t8_forest_shmem_array_bytes (forest->element_offsets)
+    + t8_forest_shmem_array_bytes (forest->global_first_desc)
+    + t8_forest_shmem_array_bytes (forest->tree_offsets);
+
+  if (forest->ghosts != NULL) {
+    t8_forest_ghost_memory_usage (forest->ghosts,
+                                  &bytes[T8_FOREST_MEMORY_GHOST],
+                                  &bytes[T8_FOREST_MEMORY_GHOST_HASH]);
+  }
+
+  if (forest->adapt_map != NULL) {
+    bytes[T8_FOREST_MEMORY_ADAPT_MAP] =
+      sc_array_memory_used (forest->adapt_map, 1);
+  }
+
+  if (forest->face_connectivity != NULL) {
+    t8_forest_face_connectivity_t *fc = forest->face_connectivity;
+
+    num_faces = fc->face_offsets[num_elements];
+    num_neighbors = fc->neigh_offsets[num_faces];
+    bytes[T8_FOREST_MEMORY_CONNECTIVITY] =
+      sizeof (t8_forest_face_connectivity_t)
+      + (num_elements + 1 + num_faces + 1 + num_neighbors)
+      * sizeof (t8_locidx_t) + num_neighbors * sizeof (int)
+      + num_faces * sizeof (int8_t);
+  }
+
+  if (forest->geometry_cache != NULL) {
+    t8_forest_geometry_cache_t *gc = forest->geometry_cache;
+
+    num_faces = gc->face_offsets[num_elements];
+    bytes[T8_FOREST_MEMORY_GEOMETRY] = sizeof (t8_forest_geometry_cache_t)
+      + 5 * num_elements * sizeof (double)
+      + (num_elements + 1) * sizeof (t8_locidx_t)
+      + num_faces * sizeof (double);
+    if (gc->face_normals[0] != NULL) {
+      bytes[T8_FOREST_MEMORY_GEOMETRY] += 3 * num_faces * sizeof (double);
+    }
+  }
+  if (forest->element_tree_index != NULL) {
+    num_blocks = (num_elements + (1 << T8_FOREST_ELEMENT_BLOCK_LOG) -
+                  1) >> T8_FOREST_ELEMENT_BLOCK_LOG;
+    bytes[T8_FOREST_MEMORY_GEOMETRY] +=
+      SC_MAX (num_blocks, 1) * sizeof (t8_locidx_t);
+  }
+  if (forest->tree_maps != NULL) {
+    bytes[T8_FOREST_MEMORY_GEOMETRY] +=
+      (t8_forest_get_num_local_trees (forest)
+       + t8_forest_get_num_ghost_trees (forest))
+      * sizeof (t8_forest_tree_map_t);
+  }
+  if (forest->tree_faces != NULL) {
+    bytes[T8_FOREST_MEMORY_GEOMETRY] += T8_ECLASS_MAX_FACES
+      * t8_forest_get_num_local_trees (forest)
+      * sizeof (t8_forest_tree_face_t);
+  }
+  if (forest->tree_bvh != NULL) {
+    bytes[T8_FOREST_MEMORY_GEOMETRY] += sizeof (t8_forest_tree_bvh_t)
+      + (t8_forest_get_num_local_trees (forest)
+         + t8_forest_get_num_ghost_trees (forest)) * 6 * sizeof (double)
+      + forest->tree_bvh->num_trees * sizeof (t8_locidx_t)
+      + forest->tree_bvh->num_nodes * sizeof (t8_forest_tree_bvh_node_t);
+  }
+
+  if (forest->fields != NULL) {
+    bytes[T8_FOREST_MEMORY_FIELDS] = sc_array_memory_used (forest->fields, 1);
+    for (ifield = 0; ifield < forest->fields->elem_count; ifield++) {
+      field = (t8_forest_field_t *) sc_array_index (forest->fields, ifield);
+      bytes[T8_FOREST_MEMORY_FIELDS] += strlen (field->name) + 1
+        + sc_array_memory_used (&field->data, 0);
+    }
+  }
+
+  total = 0;
+  for (icomp = 0; icomp < T8_FOREST_MEMORY_COUNT; icomp++) {
+    total += bytes[icomp];
+  }
+  if (usage != NULL) {
+    memcpy (usage, bytes, sizeof (bytes));
+  }
+  return total;
+}
+
+void
+t8_forest_memory_usage_global (t8_forest_t forest, size_t *min,
+                               size_t *max, size_t *sum)
+{
+  size_t              usage[T8_FOREST_MEMORY_COUNT + 1];
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  usage[T8_FOREST_MEMORY_COUNT] = t8_forest_memory_usage (forest, usage);
+  t8_forest_memory_reduce (usage, T8_FOREST_MEMORY_COUNT + 1,
+                           forest->mpicomm, min, max, sum);
 }
 
 double
@@ -1241,6 +2457,17 @@ t8_forest_profile_get_ghostexchange_waittime (t8_forest_t forest)
   return 0;
 }
 
+double
+t8_forest_profile_get_ghostexchange_overlaptime (t8_forest_t forest)
+{
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  if (forest->profile != NULL) {
+    return forest->profile->ghost_overlap_time;
+  }
+  return 0;
+}
+
 double
 t8_forest_profile_get_balance (t8_forest_t forest, int *balance_rounds)
 {
@@ -1267,7 +2494,7 @@ t8_forest_compute_elements_offset (t8_forest_t forest)
   /* Iterate through all trees, sum up the element counts and set it as
    * the element_offsets */
   for (itree = 0; itree < num_trees; itree++) {
-    tree = t8_forest_get_tree (forest, itree);
+    tree = t8_forest_get_tree_lazy (forest, itree);
     tree->elements_offset = current_offset;
     current_offset += t8_forest_get_tree_element_count (tree);
   }
@@ -1308,7 +2535,36 @@ t8_forest_new_uniform (t8_cmesh_t cmesh, t8_scheme_cxx_t * scheme,
   t8_forest_commit (forest);
   t8_global_productionf
     ("Constructed uniform forest with %lli global elements.\n",
-     (long long) forest->global_num_elements);
+     (long long) t8_forest_get_global_num_elements (forest));
+
+  return forest;
+}
+
+t8_forest_t
+t8_forest_new_from_leaves (t8_cmesh_t cmesh, t8_scheme_cxx_t * scheme,
+                           t8_gloidx_t first_tree, t8_locidx_t num_trees,
+                           const t8_locidx_t *tree_num_leaves,
+                           const int *levels,
+                           const t8_linearidx_t *linear_ids,
+                           int do_face_ghost, sc_MPI_Comm comm)
+{
+  t8_forest_t         forest;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (scheme != NULL);
+
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, cmesh, comm);
+  t8_forest_set_scheme (forest, scheme);
+  t8_forest_set_leaves (forest, first_tree, num_trees, tree_num_leaves,
+                        levels, linear_ids);
+  if (do_face_ghost) {
+    t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+  }
+  t8_forest_commit (forest);
+  t8_global_productionf
+    ("Constructed forest from leaves with %lli global elements.\n",
+     (long long) t8_forest_get_global_num_elements (forest));
 
   return forest;
 }
@@ -1331,7 +2587,7 @@ t8_forest_new_adapt (t8_forest_t forest_from,
 }
 
 /* Iterate through all the trees and free the element memory as well as
- * the tree memory.
+ * the tree memory. The arena of the elements is freed in one call.
  */
 static void
 t8_forest_free_trees (t8_forest_t forest)
@@ -1348,6 +2604,9 @@ t8_forest_free_trees (t8_forest_t forest)
     t8_element_array_reset (&tree->elements);
   }
   sc_array_destroy (forest->trees);
+  /* Free the elements of all trees at once and release the elements that
+   * we share with other forests */
+  t8_forest_trees_release_arenas (forest);
 }
 
 /* Completely destroy a forest and unreference all structs that the
@@ -1374,6 +2633,9 @@ t8_forest_reset (t8_forest_t * pforest)
     T8_ASSERT (forest->set_from == NULL);
   }
 
+  /* The pending reduction writes to the forest and uses its communicator */
+  (void) t8_forest_comm_global_num_elements_wait (forest);
+
   /* undup communicator if necessary */
   if (forest->committed) {
     if (forest->do_dup) {
@@ -1410,6 +2672,26 @@ t8_forest_reset (t8_forest_t * pforest)
   if (forest->profile != NULL) {
     T8_FREE (forest->profile);
   }
+  if (forest->adapt_map != NULL) {
+    sc_array_destroy (forest->adapt_map);
+  }
+  if (forest->face_connectivity != NULL) {
+    t8_forest_face_connectivity_destroy (forest);
+  }
+  if (forest->geometry_cache != NULL) {
+    t8_forest_geometry_cache_destroy (forest);
+  }
+  if (forest->fields != NULL) {
+    t8_forest_fields_destroy (forest);
+  }
+  if (forest->tree_bvh != NULL) {
+    t8_forest_tree_bvh_destroy (forest);
+  }
+  T8_FREE (forest->element_tree_index);
+  T8_FREE (forest->leaf_keys);
+  T8_FREE (forest->tree_maps);
+  T8_FREE (forest->tree_faces);
+  T8_FREE (forest->set_load_filename);
   T8_FREE (forest);
   *pforest = NULL;
 }
@@ -22,14 +22,115 @@
 
 #include <t8_forest/t8_forest_adapt.h>
 #include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_kernels.hxx>
 #include <t8_forest.h>
+#include <t8_trace.h>
 #include <t8_data/t8_containers.h>
 #include <t8_element_cxx.hxx>
+#include <t8_element_scratch.hxx>
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
 
-/* The last inserted element must be the last element of a family. */
+/* The sc allocation functions are not thread-safe. When the ranges of a
+ * tree are adapted by several threads, each thread allocates memory in
+ * this critical section only. */
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#define T8_FOREST_ADAPT_CRITICAL _Pragma ("omp critical (t8_adapt_alloc)")
+#else
+#define T8_FOREST_ADAPT_CRITICAL
+#endif
+
+/* Make room for count more elements in telements, such that pushing them
+ * does not allocate. We grow the array geometrically, since each
+ * allocation enters the critical section. */
+static void
+t8_forest_adapt_make_room (t8_element_array_t * telements, size_t count)
+{
+  sc_array_t         *array = &telements->array;
+  size_t              needed = array->elem_count + count;
+
+  if (needed * array->elem_size > (size_t) array->byte_alloc) {
+    T8_FOREST_ADAPT_CRITICAL
+      t8_element_array_reserve (telements,
+                                SC_MAX (needed, 2 * array->elem_count));
+  }
+}
+
+/* If we adapt from markers, the marker of an element of forest->set_from
+ * is the number of levels by which it is refined (if positive) or
+ * coarsened (if negative). For an element that emerged from the element
+ * lelement_id during recursive adaptation, return the number of levels that
+ * it still has to be refined (if positive) or coarsened (if negative). */
+static int
+t8_forest_adapt_marker_levels (t8_forest_t forest, t8_locidx_t ltreeid,
+                               t8_locidx_t lelement_id,
+                               t8_eclass_scheme_c * ts,
+                               const int8_t * markers,
+                               const t8_element_t * element)
+{
+  t8_tree_t           tree_from;
+  int                 level_from;
+
+  tree_from = t8_forest_get_tree_lazy (forest->set_from, ltreeid);
+  if (tree_from->implicit_level >= 0) {
+    /* All elements of an implicit tree have the same level */
+    level_from = tree_from->implicit_level;
+  }
+  else {
+    level_from =
+      ts->t8_element_level (t8_element_array_index_locidx
+                            (&tree_from->elements, lelement_id));
+  }
+  return level_from + markers[lelement_id] - ts->t8_element_level (element);
+}
+
+/* In recursive adaptation from markers, targets stores for each inserted
+ * element the level that the elements of forest->set_from that it covers
+ * want to reach, that is the finest of their levels plus markers.
+ * Set the target of the element with index count - 1 and mark the elements
+ * that were inserted since the last call, which emerged from refinement,
+ * such that they are never coarsened. */
+static void
+t8_forest_adapt_set_target (sc_array_t * targets, t8_locidx_t count,
+                            int target)
+{
+  size_t              iz, old_count = targets->elem_count;
+
+  T8_ASSERT (count > 0);
+  sc_array_resize (targets, count);
+  for (iz = old_count; iz + 1 < (size_t) count; iz++) {
+    *(int *) sc_array_index (targets, iz) = INT_MAX;
+  }
+  *(int *) sc_array_index (targets, count - 1) = target;
+}
+
+/* Return true if each of the num_children elements with indices pos, ...
+ * of a recursive adaptation from markers has a target coarser than
+ * its level. Then all elements of forest->set_from that the family
+ * covers agree to coarsen it. On output *target is the finest of the
+ * targets. */
+static int
+t8_forest_adapt_family_coarsens (sc_array_t * targets, t8_locidx_t pos,
+                                 int num_children, int level, int *target)
+{
+  int                 i, member_target;
+
+  *target = INT_MIN;
+  for (i = 0; i < num_children; i++) {
+    member_target = *(int *) sc_array_index (targets, pos + i);
+    if (member_target >= level) {
+      return 0;
+    }
+    *target = SC_MAX (*target, member_target);
+  }
+  return 1;
+}
+
+/* The last inserted element must be the last element of a family.
+ * If targets is not NULL, we adapt from markers and decide from the
+ * targets of the inserted elements instead of the adapt callback. */
 static void
 t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
                                    t8_locidx_t lelement_id,
@@ -37,13 +138,14 @@ t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
                                    t8_element_array_t * telement,
                                    t8_locidx_t el_coarsen,
                                    t8_locidx_t * el_inserted,
-                                   t8_element_t ** el_buffer)
+                                   t8_element_t ** el_buffer,
+                                   sc_array_t * targets)
 {
-  t8_element_t       *element;
+  t8_element_t       *element, *first;
   t8_element_t      **fam;
   t8_locidx_t         pos;
   size_t              elements_in_array;
-  int                 num_children, i, isfamily;
+  int                 num_children, i, isfamily, target = 0;
   /* el_inserted is the index of the last element in telement plus one.
    * el_coarsen is the index of the first element which could possibly
    * be coarsened. */
@@ -62,29 +164,37 @@ t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
   isfamily = 1;
   while (isfamily && pos >= el_coarsen && ts->t8_element_child_id (element)
          == num_children - 1) {
-    isfamily = 1;
-    /* Get all elements at indices pos, pos + 1, ... ,pos + num_children - 1 */
-    for (i = 0; i < num_children; i++) {
-      fam[i] = t8_element_array_index_locidx (telement, pos + i);
-      if (ts->t8_element_child_id (fam[i]) != i) {
-        /* These elements cannot form a family. Stop coarsening. */
-        isfamily = 0;
-        break;
-      }
-    }
-    T8_ASSERT (!isfamily || ts->t8_element_is_family (fam));
-    if (isfamily
-        && forest->set_adapt_fn (forest, forest->set_from, ltreeid,
-                                 lelement_id, ts, num_children, fam) < 0) {
+    /* The elements at indices pos, pos + 1, ... ,pos + num_children - 1
+     * are contiguous, so the scheme tests them without collecting them */
+    first = t8_element_array_index_locidx (telement, pos);
+    isfamily = ts->t8_element_is_family_array (first);
+    if (isfamily && targets == NULL) {
+      /* The callback gets pointers to the family members */
+      for (i = 0; i < num_children; i++) {
+        fam[i] = t8_element_array_index_locidx (telement, pos + i);
+      }
+    }
+    if (isfamily && (targets != NULL ?
+                     t8_forest_adapt_family_coarsens (targets, pos,
+                                                      num_children,
+                                                      ts->t8_element_level
+                                                      (first), &target) :
+                     forest->set_adapt_fn (forest, forest->set_from, ltreeid,
+                                           lelement_id, ts, num_children,
+                                           fam) < 0)) {
       /* Coarsen the element */
       *el_inserted -= num_children - 1;
       /* remove num_children - 1 elements from the array */
       T8_ASSERT (elements_in_array == t8_element_array_get_count (telement));
-      ts->t8_element_parent (fam[0], fam[0]);
+      ts->t8_element_parent (first, first);
       elements_in_array -= num_children - 1;
-      t8_element_array_resize (telement, elements_in_array);
-      /* Set element to the new constructed parent. Since resizing the array
-       * may change the position in memory, we have to do it after resizing. */
+      /* We rewind the array since it keeps its memory for the
+       * following elements */
+      t8_element_array_rewind (telement, elements_in_array);
+      if (targets != NULL) {
+        t8_forest_adapt_set_target (targets, *el_inserted, target);
+      }
+      /* Set element to the new constructed parent. */
       element = t8_element_array_index_locidx (telement, pos);
     }
     else {
@@ -96,44 +206,921 @@ t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
   }
 }
 
+/* Refine the elements on the stack elem_stack recursively and append
+ * the resulting elements to telements. The top of the stack is the last
+ * element of elem_stack, it is the first element in linear order.
+ * The stack keeps its memory, such that no element is allocated. */
 static void
 t8_forest_adapt_refine_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
                                   t8_locidx_t lelement_id,
                                   t8_eclass_scheme_c * ts,
-                                  sc_list_t * elem_list,
+                                  t8_element_array_t * elem_stack,
                                   t8_element_array_t * telements,
                                   t8_locidx_t * num_inserted,
-                                  t8_element_t ** el_buffer)
+                                  t8_element_t ** el_buffer,
+                                  const int8_t * markers)
 {
-  t8_element_t       *insert_el;
+  t8_element_t       *insert_el, *parent;
+  t8_element_scratch_mark_t mark;
+  size_t              top;
   int                 num_children;
   int                 ci;
 
-  if (elem_list->elem_count <= 0) {
+  if (t8_element_array_get_count (elem_stack) == 0) {
     return;
   }
-  while (elem_list->elem_count > 0) {
-    el_buffer[0] = (t8_element_t *) sc_list_pop (elem_list);
+  t8_element_scratch_mark (&mark);
+  t8_element_scratch_get (ts, 1, &parent);
+  while (t8_element_array_get_count (elem_stack) > 0) {
+    top = t8_element_array_get_count (elem_stack) - 1;
+    el_buffer[0] = t8_element_array_index_locidx (elem_stack, top);
     num_children = ts->t8_element_num_children (el_buffer[0]);
-    if (forest->set_adapt_fn (forest, forest->set_from, ltreeid, lelement_id,
-                              ts, 1, el_buffer) > 0) {
-      /* The element should be refined */
-      if (ts->t8_element_level (el_buffer[0]) < forest->maxlevel) {
-        /* only refine, if we do not exceed the maximum allowed level */
-        ts->t8_element_new (num_children - 1, el_buffer + 1);
-        ts->t8_element_children (el_buffer[0], num_children, el_buffer);
-        for (ci = num_children - 1; ci >= 0; ci--) {
-          (void) sc_list_prepend (elem_list, el_buffer[ci]);
-        }
+    if ((markers != NULL ?
+         t8_forest_adapt_marker_levels (forest, ltreeid, lelement_id, ts,
+                                        markers, el_buffer[0]) > 0 :
+         forest->set_adapt_fn (forest, forest->set_from, ltreeid,
+                               lelement_id, ts, 1, el_buffer) > 0)
+        && ts->t8_element_level (el_buffer[0]) < forest->maxlevel) {
+      /* The element should be refined and does not exceed the maximum
+       * allowed level. We replace it on the stack by its children, such
+       * that the first child is on top. */
+      ts->t8_element_copy (el_buffer[0], parent);
+      (void) t8_element_array_push_count (elem_stack, num_children - 1);
+      for (ci = 0; ci < num_children; ci++) {
+        el_buffer[ci] =
+          t8_element_array_index_locidx (elem_stack,
+                                         top + num_children - 1 - ci);
       }
+      ts->t8_element_children (parent, num_children, el_buffer);
     }
     else {
       insert_el = t8_element_array_push (telements);
       ts->t8_element_copy (el_buffer[0], insert_el);
-      ts->t8_element_destroy (1, el_buffer);
+      t8_element_array_rewind (elem_stack, top);
       (*num_inserted)++;
     }
   }
+  t8_element_scratch_release (&mark);
+}
+
+/* Add the replacement of num_old elements starting at first_old of a tree
+ * by num_new elements starting at first_new to an adapt map.
+ * If it continues the last run of the map, we extend this run. */
+static void
+t8_forest_adapt_map_push (sc_array_t * map, t8_locidx_t ltree_id,
+                          t8_locidx_t first_old, int num_old,
+                          t8_locidx_t first_new, int num_new)
+{
+  t8_forest_adapt_run_t *run;
+
+  if (map->elem_count > 0) {
+    run = (t8_forest_adapt_run_t *) sc_array_index (map,
+                                                    map->elem_count - 1);
+    if (run->ltree_id == ltree_id && run->num_old == num_old
+        && run->num_new == num_new
+        && run->first_old + run->count * num_old == first_old
+        && run->first_new + run->count * num_new == first_new) {
+      run->count++;
+      return;
+    }
+  }
+  if (map->elem_count * map->elem_size >= (size_t) map->byte_alloc) {
+    /* Pushing allocates */
+    T8_FOREST_ADAPT_CRITICAL
+      run = (t8_forest_adapt_run_t *) sc_array_push (map);
+  }
+  else {
+    run = (t8_forest_adapt_run_t *) sc_array_push (map);
+  }
+  run->ltree_id = ltree_id;
+  run->first_old = first_old;
+  run->first_new = first_new;
+  run->count = 1;
+  run->num_old = num_old;
+  run->num_new = num_new;
+}
+
+/* Decide whether to refine or coarsen the current elements from their
+ * markers, the return value has the same meaning as for t8_forest_adapt_t.
+ * A family is coarsened if all of its members are marked for coarsening. */
+static int
+t8_forest_adapt_from_markers (const int8_t * markers, int num_elements,
+                              int num_children)
+{
+  int                 ielem;
+
+  if (num_elements == num_children) {
+    for (ielem = 0; ielem < num_elements && markers[ielem] < 0; ielem++) {
+    }
+    if (ielem == num_elements) {
+      return -1;
+    }
+  }
+  return markers[0] > 0;
+}
+
+/* Estimate the number of new elements of the elements with indices
+ * first, ..., last - 1 of a tree of forest->set_from, such that we can
+ * reserve the memory in advance. If we adapt from markers, this is an upper
+ * bound. Otherwise we assume that the number of elements does not change. */
+static size_t
+t8_forest_adapt_estimate (t8_forest_t forest,
+                          t8_eclass_scheme_c * tscheme,
+                          t8_element_array_t * telements_from,
+                          const int8_t * markers, int num_children,
+                          t8_locidx_t first, t8_locidx_t last)
+{
+  t8_locidx_t         ielem;
+  size_t              estimate, num_new;
+  int                 levels, ilevel;
+
+  if (markers == NULL) {
+    return last - first;
+  }
+  estimate = 0;
+  for (ielem = first; ielem < last; ielem++) {
+    num_new = 1;
+    if (markers[ielem] > 0) {
+      levels = forest->set_adapt_recursive ? markers[ielem] : 1;
+      levels = SC_MIN (levels, forest->maxlevel -
+                       tscheme->t8_element_level
+                       (t8_element_array_index_locidx (telements_from,
+                                                       ielem)));
+      for (ilevel = 0; ilevel < levels; ilevel++) {
+        num_new *= num_children;
+      }
+    }
+    estimate += num_new;
+  }
+  return estimate;
+}
+
+/* Return a pointer to count new elements after the el_inserted elements
+ * of telements. If presized is true, telements already has its final
+ * number of elements and we overwrite them instead of growing it. */
+static t8_element_t *
+t8_forest_adapt_push (t8_element_array_t * telements,
+                      t8_locidx_t el_inserted, size_t count, int presized)
+{
+  if (presized) {
+    T8_ASSERT ((size_t) el_inserted + count <=
+               t8_element_array_get_count (telements));
+    return t8_element_array_index_locidx (telements, el_inserted);
+  }
+  t8_forest_adapt_make_room (telements, count);
+  return t8_element_array_push_count (telements, count);
+}
+
+/* Decide how the elements of a tree of forest->set_from starting at index
+ * el_considered are adapted, where last is one after the last element of
+ * the range. On output, *num_elements is num_children if the elements form
+ * a family and 1 otherwise, and elements_from[0] points to the first of
+ * them. The return value has the same meaning as for t8_forest_adapt_t,
+ * but we never refine an element beyond the maximum level. */
+static int
+t8_forest_adapt_decide (t8_forest_t forest, t8_locidx_t ltree_id,
+                        t8_eclass_scheme_c * tscheme,
+                        t8_element_array_t * telements_from,
+                        const int *child_ids, const int8_t * markers,
+                        t8_locidx_t el_considered, t8_locidx_t last,
+                        int num_children, t8_element_t ** elements_from,
+                        int *num_elements)
+{
+  int                 zz;
+  int                 refine;
+
+  /* The child ids decide whether the next elements form a family */
+  for (zz = 0; zz < num_children && el_considered + zz < last; zz++) {
+    T8_ASSERT (child_ids[el_considered + zz] ==
+               tscheme->t8_element_child_id (t8_element_array_index_locidx
+                                             (telements_from,
+                                              el_considered + zz)));
+    if (child_ids[el_considered + zz] != zz) {
+      break;
+    }
+  }
+  *num_elements = zz == num_children ? num_children : 1;
+  elements_from[0] = t8_element_array_index_locidx (telements_from,
+                                                    el_considered);
+  T8_ASSERT (zz != num_children
+             || tscheme->t8_element_is_family_array (elements_from[0]));
+  if (markers != NULL) {
+    refine = t8_forest_adapt_from_markers (markers + el_considered,
+                                           *num_elements, num_children);
+  }
+  else {
+    /* The callback gets pointers to the elements */
+    for (zz = 1; zz < *num_elements; zz++) {
+      elements_from[zz] =
+        t8_element_array_index_locidx (telements_from, el_considered + zz);
+    }
+    refine =
+      forest->set_adapt_fn (forest, forest->set_from, ltree_id,
+                            el_considered, tscheme, *num_elements,
+                            elements_from);
+  }
+  T8_ASSERT (*num_elements == num_children || refine >= 0);
+  if (refine > 0 && tscheme->t8_element_level (elements_from[0]) >=
+      forest->maxlevel) {
+    /* Only refine an element if it does not exceed the maximum level */
+    refine = 0;
+  }
+  return refine;
+}
+
+/* Count the elements that the non-recursive adaptation of the elements of
+ * a tree of forest->set_from yields, without creating them.
+ * If decisions is not NULL, we store a marker for each element of the tree,
+ * such that t8_forest_adapt_range with decisions as markers adapts the tree
+ * in the same way without calling the adapt callback again.
+ * *unchanged is set to true if no element is refined or coarsened. */
+static              t8_locidx_t
+t8_forest_adapt_count (t8_forest_t forest, t8_locidx_t ltree_id,
+                       t8_eclass_scheme_c * tscheme,
+                       t8_element_array_t * telements_from,
+                       const int *child_ids, const int8_t * markers,
+                       t8_locidx_t num_el_from, int8_t * decisions,
+                       int *unchanged)
+{
+  t8_locidx_t         el_considered, count;
+  t8_element_t      **elements_from;
+  int                 num_children, num_elements, refine;
+
+  T8_ASSERT (!forest->set_adapt_recursive);
+
+  *unchanged = 1;
+  if (num_el_from == 0) {
+    return 0;
+  }
+  num_children =
+    tscheme->t8_element_num_children (t8_element_array_index_locidx
+                                      (telements_from, 0));
+  elements_from = T8_ALLOC (t8_element_t *, num_children);
+  el_considered = 0;
+  count = 0;
+  while (el_considered < num_el_from) {
+    refine = t8_forest_adapt_decide (forest, ltree_id, tscheme,
+                                     telements_from, child_ids, markers,
+                                     el_considered, num_el_from,
+                                     num_children, elements_from,
+                                     &num_elements);
+    if (refine > 0) {
+      /* The first element is replaced by its children */
+      count += num_children;
+      num_elements = 1;
+    }
+    else {
+      /* The family is replaced by its parent or the first element is kept */
+      count++;
+      if (refine == 0) {
+        num_elements = 1;
+      }
+    }
+    if (refine != 0) {
+      *unchanged = 0;
+    }
+    if (decisions != NULL) {
+      memset (decisions + el_considered, refine > 0 ? 1 : refine < 0 ? -1 : 0,
+              num_elements * sizeof (int8_t));
+    }
+    el_considered += num_elements;
+  }
+  T8_FREE (elements_from);
+  return count;
+}
+
+/* Adapt the elements with indices first, ..., last - 1 of a tree of
+ * forest->set_from and append the new elements to telements.
+ * child_ids stores the child id of each element of the tree.
+ * If markers is not NULL, we decide from markers[i] for element i of the
+ * tree and not from the adapt callback. In recursive adaptation a marker
+ * is the number of levels to refine or coarsen.
+ * If map is not NULL, the replacements are added to map. The indices of
+ * the new elements are relative to the beginning of telements.
+ * We only record a map in non-recursive adaptation.
+ * If the range does not start at the beginning of the tree, first must be
+ * the index of an element with child id 0, such that no family is split.
+ * If unchanged is not NULL, telements must be empty and in non-recursive
+ * adaptation we copy the kept elements only once an element of the range
+ * is refined or coarsened. If none is, telements stays empty and
+ * *unchanged is set to true, such that the caller may use the elements of
+ * telements_from instead.
+ * If el_buffer is not NULL, it is an array of 2 * num_children element
+ * pointers that we use as temporary storage. Otherwise we allocate it.
+ * Threads that adapt ranges concurrently pass their own el_buffer, and we
+ * allocate all other memory in the critical section T8_FOREST_ADAPT_CRITICAL.
+ * If presized is true, telements already stores as many elements as the
+ * adapted range, counted by t8_forest_adapt_count, and we overwrite them.
+ * Then unchanged must be NULL and we do not adapt recursively.
+ * Returns the number of elements in the adapted range. */
+static              t8_locidx_t
+t8_forest_adapt_range (t8_forest_t forest, t8_locidx_t ltree_id,
+                       t8_eclass_scheme_c * tscheme,
+                       t8_element_array_t * telements_from,
+                       const int *child_ids, const int8_t * markers,
+                       t8_locidx_t first, t8_locidx_t last,
+                       t8_element_array_t * telements, sc_array_t * map,
+                       int *unchanged, t8_element_t ** el_buffer,
+                       int presized)
+{
+  t8_locidx_t         el_considered;
+  t8_locidx_t         el_inserted;
+  t8_locidx_t         el_coarsen;
+  t8_locidx_t         el_pending;
+  int                 lazy;
+  size_t              num_children, zz;
+  t8_element_t      **elements, **elements_from;
+  t8_element_array_t  refine_stack;     /* This is only needed when we adapt recursively */
+  /* The targets are only needed when we adapt recursively from markers */
+  sc_array_t          targets, *ptargets = NULL;
+  int                 target;
+  int                 refine;
+  int                 ci;
+  int                 num_elements;
+
+  T8_ASSERT (0 <= first && first <= last);
+  T8_ASSERT (first == 0 || child_ids[first] == 0);
+  T8_ASSERT (!forest->set_adapt_recursive || map == NULL);
+  T8_ASSERT (!presized || (unchanged == NULL
+                           && !forest->set_adapt_recursive));
+
+  el_inserted = presized ? 0 : t8_element_array_get_count (telements);
+  /* As long as lazy is true, no element was changed and we did not copy
+   * the el_pending elements before el_considered */
+  lazy = unchanged != NULL && !forest->set_adapt_recursive;
+  T8_ASSERT (unchanged == NULL || el_inserted == 0);
+  if (unchanged != NULL) {
+    *unchanged = 0;
+  }
+  if (first == last) {
+    if (unchanged != NULL) {
+      *unchanged = 1;
+    }
+    return el_inserted;
+  }
+  el_considered = first;
+  el_coarsen = 0;
+  el_pending = 0;
+  /* TODO: this will generate problems with pyramidal elements */
+  num_children =
+    tscheme->t8_element_num_children (t8_element_array_index_locidx
+                                      (telements_from, first));
+  if (el_buffer != NULL) {
+    elements = el_buffer;
+  }
+  else {
+    elements = T8_ALLOC (t8_element_t *, 2 * num_children);
+  }
+  elements_from = elements + num_children;
+  if (!lazy && !presized) {
+    /* Reserve the memory for the new elements, such that we do not
+     * reallocate telements for each new element */
+    t8_forest_adapt_make_room (telements,
+                               t8_forest_adapt_estimate (forest, tscheme,
+                                                         telements_from,
+                                                         markers,
+                                                         num_children, first,
+                                                         last));
+  }
+  if (forest->set_adapt_recursive) {
+    t8_element_array_init (&refine_stack, tscheme);
+    if (markers != NULL) {
+      sc_array_init (&targets, sizeof (int));
+      ptargets = &targets;
+    }
+  }
+  while (el_considered < last) {
+    refine = t8_forest_adapt_decide (forest, ltree_id, tscheme,
+                                     telements_from, child_ids, markers,
+                                     el_considered, last, (int) num_children,
+                                     elements_from, &num_elements);
+    if (lazy && refine != 0) {
+      /* The first change of the range. Reserve the memory for the new
+       * elements and copy the elements that we kept so far. */
+      t8_forest_adapt_make_room (telements,
+                                 t8_forest_adapt_estimate (forest, tscheme,
+                                                           telements_from,
+                                                           markers,
+                                                           num_children,
+                                                           first, last));
+      if (el_pending > 0) {
+        memcpy (t8_element_array_push_count (telements, el_pending),
+                t8_element_array_index_locidx (telements_from,
+                                               el_considered - el_pending),
+                el_pending * t8_element_array_get_size (telements));
+      }
+      lazy = 0;
+    }
+    if (refine > 0) {
+      /* The first element is to be refined */
+      if (forest->set_adapt_recursive) {
+        /* el_coarsen is the index of the first element in the new element
+         * array which could be coarsened recursively.
+         * We can set this here, since a family that emerges from a refinement will never be coarsened */
+        el_coarsen = el_inserted + num_children;
+        /* Put the children on the stack with the first child on top */
+        T8_ASSERT (t8_element_array_get_count (&refine_stack) == 0);
+        (void) t8_element_array_push_count (&refine_stack, num_children);
+        for (ci = 0; ci < (int) num_children; ci++) {
+          elements[ci] =
+            t8_element_array_index_locidx (&refine_stack,
+                                           num_children - 1 - ci);
+        }
+        tscheme->t8_element_children (elements_from[0], num_children,
+                                      elements);
+        t8_forest_adapt_refine_recursive (forest, ltree_id, el_considered,
+                                          tscheme, &refine_stack, telements,
+                                          &el_inserted, elements, markers);
+      }
+      else {
+        /* add the children to the element array of the current tree */
+        (void) t8_forest_adapt_push (telements, el_inserted, num_children,
+                                     presized);
+        for (zz = 0; zz < num_children; zz++) {
+          elements[zz] =
+            t8_element_array_index_locidx (telements, el_inserted + zz);
+        }
+        tscheme->t8_element_children (elements_from[0], num_children,
+                                      elements);
+        if (map != NULL) {
+          t8_forest_adapt_map_push (map, ltree_id, el_considered, 1,
+                                    el_inserted, num_children);
+        }
+        el_inserted += num_children;
+      }
+      el_considered++;
+    }
+    else if (refine < 0) {
+      /* The elements form a family and are to be coarsened */
+      elements[0] = t8_forest_adapt_push (telements, el_inserted, 1,
+                                          presized);
+      tscheme->t8_element_parent (elements_from[0], elements[0]);
+      if (map != NULL) {
+        t8_forest_adapt_map_push (map, ltree_id, el_considered, num_children,
+                                  el_inserted, 1);
+      }
+      el_inserted++;
+      if (ptargets != NULL) {
+        /* The family is coarsened since all of its members agree, the
+         * parent keeps the finest of their targets */
+        target = INT_MIN;
+        for (zz = 0; zz < num_children; zz++) {
+          target = SC_MAX (target, markers[el_considered + zz]);
+        }
+        t8_forest_adapt_set_target (ptargets, el_inserted,
+                                    tscheme->t8_element_level
+                                    (elements_from[0]) + target);
+      }
+      if (forest->set_adapt_recursive) {
+        if ((size_t) tscheme->t8_element_child_id (elements[0])
+            == num_children - 1) {
+          t8_forest_adapt_coarsen_recursive (forest, ltree_id,
+                                             el_considered, tscheme,
+                                             telements, el_coarsen,
+                                             &el_inserted, elements,
+                                             ptargets);
+        }
+      }
+      el_considered += num_children;
+    }
+    else {
+      /* The considered elements are neither to be coarsened nor is the first
+       * one to be refined */
+      T8_ASSERT (refine == 0);
+      if (lazy) {
+        /* We copy the element only if the range changes later */
+        el_pending++;
+      }
+      else {
+        elements[0] = t8_forest_adapt_push (telements, el_inserted, 1,
+                                            presized);
+        tscheme->t8_element_copy (elements_from[0], elements[0]);
+      }
+      if (map != NULL) {
+        t8_forest_adapt_map_push (map, ltree_id, el_considered, 1,
+                                  el_inserted, 1);
+      }
+      el_inserted++;
+      if (ptargets != NULL) {
+        t8_forest_adapt_set_target (ptargets, el_inserted,
+                                    tscheme->t8_element_level
+                                    (elements_from[0]) +
+                                    markers[el_considered]);
+      }
+      if (forest->set_adapt_recursive &&
+          (size_t) tscheme->t8_element_child_id (elements[0])
+          == num_children - 1) {
+        t8_forest_adapt_coarsen_recursive (forest, ltree_id, el_considered,
+                                           tscheme, telements, el_coarsen,
+                                           &el_inserted, elements, ptargets);
+      }
+      el_considered++;
+    }
+  }
+  if (forest->set_adapt_recursive) {
+    T8_ASSERT (t8_element_array_get_count (&refine_stack) == 0);
+    t8_element_array_reset (&refine_stack);
+  }
+  if (ptargets != NULL) {
+    sc_array_reset (ptargets);
+  }
+  if (lazy) {
+    /* No element of the range was changed */
+    T8_ASSERT (el_pending == last - first && el_inserted == el_pending);
+    *unchanged = 1;
+  }
+  else if (presized) {
+    T8_ASSERT ((size_t) el_inserted ==
+               t8_element_array_get_count (telements));
+  }
+  else {
+    T8_FOREST_ADAPT_CRITICAL
+      t8_element_array_resize (telements, el_inserted);
+  }
+
+  if (el_buffer == NULL) {
+    T8_FREE (elements);
+  }
+  return el_inserted;
+}
+
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#include <omp.h>
+
+/* The number of ranges per thread that we aim for in threaded adapt.
+ * More ranges than threads balance the load if the adapt callback is
+ * more expensive for some elements. */
+#define T8_FOREST_ADAPT_RANGES_PER_THREAD 4
+
+/* The minimum number of elements in a range of threaded adapt */
+#define T8_FOREST_ADAPT_MIN_RANGE 1024
+
+/* A range of elements of a tree that is adapted by one thread. */
+typedef struct t8_forest_adapt_range
+{
+  t8_locidx_t         ltree_id; /* The local tree of the range */
+  t8_locidx_t         first;    /* The first element of the range */
+  t8_locidx_t         last;     /* One after the last element of the range */
+  t8_element_array_t  elements; /* The adapted elements of the range */
+  sc_array_t          map;      /* If we record an adapt map, the runs of the range */
+  int                 unchanged; /* True if no element of the range changed.
+                                    Then elements is empty. */
+} t8_forest_adapt_range_t;
+
+/* Adapt the trees of forest in parallel with OpenMP.
+ * Each tree is split into ranges at elements with child id 0 and the
+ * ranges are adapted concurrently into their own element arrays.
+ * Afterwards the ranges of each tree are concatenated in order.
+ * If forest->adapt_map is not NULL, we record the map of each range and
+ * shift its new element indices when concatenating. */
+static void
+t8_forest_adapt_threaded (t8_forest_t forest, t8_eclass_t kernel_eclass)
+{
+  t8_forest_t         forest_from = forest->set_from;
+  t8_locidx_t         ltree_id, num_trees, num_el_from, num_el;
+  t8_locidx_t         first, last, range_size, new_offset;
+  t8_gloidx_t         total_elements = 0;
+  t8_tree_t           tree, tree_from;
+  t8_eclass_scheme_c *tscheme;
+  t8_forest_adapt_range_t *range;
+  sc_array_t          ranges;
+  int               **child_ids;
+  int8_t            **markers = NULL;
+  int8_t             *tree_unchanged;
+  t8_locidx_t        *tree_counts;
+  int                 num_threads, num_children, max_children = 1;
+  size_t              irange, element_size, irun;
+  t8_forest_adapt_run_t *run;
+  t8_element_t      **thread_buffers;
+  long                iirange;
+
+  num_threads = forest->set_adapt_threads;
+  num_trees = t8_forest_get_num_local_trees (forest);
+  child_ids = T8_ALLOC (int *, num_trees);
+  if (forest->set_adapt_tree_fn != NULL) {
+    markers = T8_ALLOC (int8_t *, num_trees);
+  }
+  for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+    tree_from = t8_forest_get_tree (forest_from, ltree_id);
+    num_el_from = t8_element_array_get_count (&tree_from->elements);
+    child_ids[ltree_id] = T8_ALLOC (int, num_el_from);
+    if (markers != NULL) {
+      markers[ltree_id] = T8_ALLOC (int8_t, num_el_from);
+    }
+    total_elements += num_el_from;
+  }
+  /* Compute the child ids of all elements, we need them for the splitting.
+   * If we adapt with a tree callback, we compute the markers as well. */
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+  for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+    t8_tree_t           ptree_from = t8_forest_get_tree (forest_from,
+                                                         ltree_id);
+    t8_eclass_scheme_c *ptscheme =
+      forest->scheme_cxx->eclass_schemes[ptree_from->eclass];
+
+    t8_forest_kernel_compute_child_ids (kernel_eclass, ptscheme,
+                                        &ptree_from->elements,
+                                        child_ids[ltree_id]);
+    if (markers != NULL) {
+      forest->set_adapt_tree_fn (forest, forest_from, ltree_id,
+                                 ptree_from->elements_offset, ptscheme,
+                                 &ptree_from->elements, markers[ltree_id]);
+    }
+  }
+
+  /* Split the trees into ranges that begin with an element of child id 0 */
+  range_size = total_elements /
+    (num_threads * T8_FOREST_ADAPT_RANGES_PER_THREAD);
+  range_size = SC_MAX (range_size, T8_FOREST_ADAPT_MIN_RANGE);
+  sc_array_init (&ranges, sizeof (t8_forest_adapt_range_t));
+  for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+    tree = t8_forest_get_tree (forest, ltree_id);
+    tree_from = t8_forest_get_tree (forest_from, ltree_id);
+    num_el_from = t8_element_array_get_count (&tree_from->elements);
+    tscheme = forest->scheme_cxx->eclass_schemes[tree->eclass];
+    for (first = 0; first < num_el_from; first = last) {
+      last = SC_MIN (first + range_size, num_el_from);
+      while (last < num_el_from && child_ids[ltree_id][last] != 0) {
+        last++;
+      }
+      /* The number of element pointers that the range needs */
+      num_children =
+        tscheme->t8_element_num_children (t8_element_array_index_locidx
+                                          (&tree_from->elements, first));
+      max_children = SC_MAX (max_children, num_children);
+      range = (t8_forest_adapt_range_t *) sc_array_push (&ranges);
+      range->ltree_id = ltree_id;
+      range->first = first;
+      range->last = last;
+      t8_element_array_init (&range->elements, tscheme);
+      sc_array_init (&range->map, sizeof (t8_forest_adapt_run_t));
+    }
+  }
+
+  /* Each thread gets its own element pointers for t8_forest_adapt_range */
+  thread_buffers = T8_ALLOC (t8_element_t *, 2 * max_children * num_threads);
+
+  /* Adapt all ranges */
+#pragma omp parallel num_threads(num_threads)
+  {
+    t8_element_t      **el_buffer =
+      thread_buffers + 2 * max_children * omp_get_thread_num ();
+
+#pragma omp for schedule(dynamic, 1)
+    for (iirange = 0; iirange < (long) ranges.elem_count; iirange++) {
+      t8_forest_adapt_range_t *prange =
+        (t8_forest_adapt_range_t *) sc_array_index (&ranges, iirange);
+      t8_tree_t           ptree_from =
+        t8_forest_get_tree (forest_from, prange->ltree_id);
+
+      (void) t8_forest_adapt_range (forest, prange->ltree_id,
+                                    forest->scheme_cxx->
+                                    eclass_schemes[ptree_from->eclass],
+                                    &ptree_from->elements,
+                                    child_ids[prange->ltree_id],
+                                    forest->set_adapt_markers != NULL ?
+                                    forest->set_adapt_markers +
+                                    ptree_from->elements_offset :
+                                    markers ==
+                                    NULL ? NULL : markers[prange->ltree_id],
+                                    prange->first, prange->last,
+                                    &prange->elements,
+                                    forest->adapt_map ==
+                                    NULL ? NULL : &prange->map,
+                                    &prange->unchanged, el_buffer, 0);
+    }
+    t8_element_scratch_finalize_worker ();
+  }
+  T8_FREE (thread_buffers);
+
+  /* A tree is unchanged if all of its ranges are */
+  tree_unchanged = T8_ALLOC (int8_t, num_trees);
+  memset (tree_unchanged, 1, num_trees * sizeof (int8_t));
+  for (irange = 0; irange < ranges.elem_count; irange++) {
+    range = (t8_forest_adapt_range_t *) sc_array_index (&ranges, irange);
+    if (!range->unchanged) {
+      tree_unchanged[range->ltree_id] = 0;
+    }
+  }
+  /* Reserve the final size of each changed tree, such that the
+   * concatenation does not grow the arrays step by step */
+  tree_counts = T8_ALLOC_ZERO (t8_locidx_t, num_trees);
+  for (irange = 0; irange < ranges.elem_count; irange++) {
+    range = (t8_forest_adapt_range_t *) sc_array_index (&ranges, irange);
+    tree_counts[range->ltree_id] += range->unchanged ?
+      range->last - range->first :
+      (t8_locidx_t) t8_element_array_get_count (&range->elements);
+  }
+  for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+    if (!tree_unchanged[ltree_id]) {
+      t8_element_array_reserve (&t8_forest_get_tree (forest,
+                                                     ltree_id)->elements,
+                                tree_counts[ltree_id]);
+    }
+  }
+  T8_FREE (tree_counts);
+  /* Concatenate the ranges of each changed tree */
+  for (irange = 0; irange < ranges.elem_count; irange++) {
+    range = (t8_forest_adapt_range_t *) sc_array_index (&ranges, irange);
+    tree = t8_forest_get_tree (forest, range->ltree_id);
+    tree_from = t8_forest_get_tree (forest_from, range->ltree_id);
+    new_offset = tree_unchanged[range->ltree_id] ? range->first :
+      (t8_locidx_t) t8_element_array_get_count (&tree->elements);
+    for (irun = 0; irun < range->map.elem_count; irun++) {
+      run = (t8_forest_adapt_run_t *) sc_array_push (forest->adapt_map);
+      *run = *(t8_forest_adapt_run_t *) sc_array_index (&range->map, irun);
+      run->first_new += new_offset;
+    }
+    sc_array_reset (&range->map);
+    if (!tree_unchanged[range->ltree_id]) {
+      element_size = t8_element_array_get_size (&range->elements);
+      if (range->unchanged) {
+        /* Copy the elements of the unchanged range from forest_from */
+        num_el = range->last - range->first;
+        memcpy (t8_element_array_push_count (&tree->elements, num_el),
+                t8_element_array_index_locidx (&tree_from->elements,
+                                               range->first),
+                num_el * element_size);
+      }
+      else {
+        num_el = t8_element_array_get_count (&range->elements);
+        if (num_el > 0) {
+          memcpy (t8_element_array_push_count (&tree->elements, num_el),
+                  t8_element_array_get_data (&range->elements),
+                  num_el * element_size);
+        }
+      }
+    }
+    t8_element_array_reset (&range->elements);
+  }
+  sc_array_reset (&ranges);
+  /* The unchanged trees share the elements of forest_from */
+  for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+    if (tree_unchanged[ltree_id]) {
+      t8_element_array_reset (&t8_forest_get_tree (forest,
+                                                   ltree_id)->elements);
+      t8_forest_tree_share (forest, ltree_id, forest_from, ltree_id);
+    }
+  }
+  T8_FREE (tree_unchanged);
+  for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+    T8_FREE (child_ids[ltree_id]);
+    if (markers != NULL) {
+      T8_FREE (markers[ltree_id]);
+    }
+  }
+  T8_FREE (child_ids);
+  T8_FREE (markers);
+}
+#endif
+
+/* Add the unchanged elements of a tree with num_elements elements to an
+ * adapt map */
+static void
+t8_forest_adapt_map_push_unchanged (sc_array_t * map, t8_locidx_t ltree_id,
+                                    t8_locidx_t num_elements)
+{
+  t8_forest_adapt_run_t *run;
+
+  if (num_elements == 0) {
+    return;
+  }
+  t8_forest_adapt_map_push (map, ltree_id, 0, 1, 0, 1);
+  run = (t8_forest_adapt_run_t *) sc_array_index (map, map->elem_count - 1);
+  run->count = num_elements;
+}
+
+/* Adapt the trees of forest non-recursively with one thread.
+ * In a first pass, we decide for each tree how its elements are adapted
+ * and count the new elements. Unchanged trees share the elements of
+ * forest->set_from. We then allocate the elements of all changed trees at
+ * once, such that commit does not need to copy them into an arena, and
+ * create the new elements in their final place in a second pass.
+ * If we adapt with the callback, the first pass stores its decisions as
+ * markers, such that the callback is called only once per element. */
+static void
+t8_forest_adapt_counted (t8_forest_t forest, t8_eclass_t kernel_eclass)
+{
+  t8_forest_t         forest_from = forest->set_from;
+  t8_element_array_t *telements_from;
+  t8_element_array_t  implicit_elements;
+  t8_locidx_t         ltree_id, num_trees, num_el_from;
+  t8_locidx_t        *num_tree_elements;
+  t8_tree_t           tree, tree_from;
+  t8_eclass_scheme_c *tscheme;
+  int                *child_ids = NULL;
+  int8_t            **tree_markers = NULL;
+  const int8_t       *markers;
+  size_t              child_ids_alloc = 0;
+  int                 pass, unchanged = 0;
+
+  T8_ASSERT (!forest->set_adapt_recursive);
+
+  num_trees = t8_forest_get_num_local_trees (forest);
+  num_tree_elements = T8_ALLOC (t8_locidx_t, num_trees);
+  if (forest->set_adapt_markers == NULL) {
+    /* The markers of the tree callback or the decisions of the callback */
+    tree_markers = T8_ALLOC_ZERO (int8_t *, num_trees);
+  }
+  for (pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      if (forest->set_trim_elements) {
+        /* Each changed tree gets an array of its final size */
+        for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+          if (num_tree_elements[ltree_id] >= 0) {
+            tree = t8_forest_get_tree_lazy (forest, ltree_id);
+            t8_element_array_init_size (&tree->elements,
+                                        forest->scheme_cxx->
+                                        eclass_schemes[tree->eclass],
+                                        num_tree_elements[ltree_id]);
+          }
+        }
+      }
+      else {
+        t8_forest_trees_alloc_arena (forest, num_tree_elements);
+      }
+    }
+    for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+      tree = t8_forest_get_tree_lazy (forest, ltree_id);
+      tree_from = t8_forest_get_tree_lazy (forest_from, ltree_id);
+      if (pass == 1 && num_tree_elements[ltree_id] < 0) {
+        /* The tree shares the elements of forest_from */
+        if (forest->adapt_map != NULL) {
+          t8_forest_adapt_map_push_unchanged (forest->adapt_map, ltree_id,
+                                              t8_forest_get_tree_element_count
+                                              (tree_from));
+        }
+        continue;
+      }
+      telements_from = &tree_from->elements;
+      if (tree_from->implicit_level >= 0
+          && t8_element_array_get_count (telements_from) == 0) {
+        /* We create the elements of an implicit tree only for this pass,
+         * such that the tree stays implicit in both forests if no element
+         * changes */
+        t8_forest_tree_implicit_elements (forest_from, tree_from,
+                                          &implicit_elements);
+        telements_from = &implicit_elements;
+      }
+      num_el_from =
+        (t8_locidx_t) t8_element_array_get_count (telements_from);
+      tscheme = forest->scheme_cxx->eclass_schemes[tree->eclass];
+      /* We compute the child ids of all elements of the tree at once,
+       * to detect families without a virtual call per element. */
+      if ((size_t) num_el_from > child_ids_alloc) {
+        child_ids_alloc = num_el_from;
+        child_ids = T8_REALLOC (child_ids, int, child_ids_alloc);
+      }
+      t8_forest_kernel_compute_child_ids (kernel_eclass, tscheme,
+                                          telements_from, child_ids);
+      if (forest->set_adapt_markers != NULL) {
+        markers = forest->set_adapt_markers + tree_from->elements_offset;
+      }
+      else {
+        if (pass == 0) {
+          tree_markers[ltree_id] = T8_ALLOC (int8_t, num_el_from);
+          if (forest->set_adapt_tree_fn != NULL) {
+            forest->set_adapt_tree_fn (forest, forest_from, ltree_id,
+                                       tree_from->elements_offset, tscheme,
+                                       telements_from,
+                                       tree_markers[ltree_id]);
+          }
+        }
+        markers = pass == 0 && forest->set_adapt_tree_fn == NULL ?
+          NULL : tree_markers[ltree_id];
+      }
+      if (pass == 0) {
+        num_tree_elements[ltree_id] =
+          t8_forest_adapt_count (forest, ltree_id, tscheme, telements_from,
+                                 child_ids, markers, num_el_from,
+                                 markers == NULL ? tree_markers[ltree_id] :
+                                 NULL, &unchanged);
+        if (unchanged) {
+          /* No element of the tree changes, we share its elements with
+           * forest_from instead of copying them */
+          num_tree_elements[ltree_id] = -1;
+          t8_element_array_reset (&tree->elements);
+          t8_forest_tree_share (forest, ltree_id, forest_from, ltree_id);
+        }
+      }
+      else {
+        (void) t8_forest_adapt_range (forest, ltree_id, tscheme,
+                                      telements_from, child_ids, markers, 0,
+                                      num_el_from, &tree->elements,
+                                      forest->adapt_map, NULL, NULL, 1);
+      }
+      if (tree_markers != NULL && (pass == 1 || unchanged)) {
+        T8_FREE (tree_markers[ltree_id]);
+        tree_markers[ltree_id] = NULL;
+      }
+      if (telements_from == &implicit_elements) {
+        t8_element_array_reset (&implicit_elements);
+      }
+    }
+  }
+  T8_FREE (child_ids);
+  T8_FREE (tree_markers);
+  T8_FREE (num_tree_elements);
 }
 
 /* TODO: optimize this when we own forest_from */
@@ -141,24 +1128,19 @@ void
 t8_forest_adapt (t8_forest_t forest)
 {
   t8_forest_t         forest_from;
-  sc_list_t          *refine_list = NULL;       /* This is only needed when we adapt recursively */
-  t8_element_array_t *telements, *telements_from;
+  t8_element_array_t *telements_from;
+  t8_element_array_t  implicit_elements;
   t8_locidx_t         ltree_id, num_trees;
-  t8_locidx_t         el_considered;
-  t8_locidx_t         el_inserted;
-  t8_locidx_t         el_coarsen;
   t8_locidx_t         num_el_from;
   t8_locidx_t         el_offset;
-  size_t              num_children, zz;
   t8_tree_t           tree, tree_from;
   t8_eclass_scheme_c *tscheme;
-  t8_element_t      **elements, **elements_from, *elpop;
-  int                 refine;
-  int                 ci;
-  int                 num_elements;
-#ifdef T8_ENABLE_DEBUG
-  int                 is_family;
-#endif
+  int                *child_ids = NULL;
+  int8_t             *markers = NULL;
+  size_t              child_ids_alloc = 0;
+  t8_eclass_t         kernel_eclass;
+  int                 threaded;
+  int                 unchanged;
 
   T8_ASSERT (forest != NULL);
   T8_ASSERT (forest->set_from != NULL);
@@ -167,6 +1149,8 @@ t8_forest_adapt (t8_forest_t forest)
   /* if profiling is enabled, measure runtime */
   if (forest->profile != NULL) {
     forest->profile->adapt_runtime = -sc_MPI_Wtime ();
+    t8_counters_start (forest->profile->adapt_counters);
+    t8_profile_memory_start (&forest->profile->adapt_memory);
     /* DO NOT DELETE THE FOLLOWING line.
      * even if you do not want this output. It fixes a bug that occured on JUQUEEN, where the
      * runtimes were computed to 0.
@@ -174,160 +1158,123 @@ t8_forest_adapt (t8_forest_t forest)
     t8_global_productionf ("Start adadpt %f %f\n", sc_MPI_Wtime (),
                            forest->profile->adapt_runtime);
   }
+  t8_trace_begin ("adapt");
 
   forest_from = forest->set_from;
-  t8_global_productionf ("Into t8_forest_adapt from %lld total elements\n",
-                         (long long) forest_from->global_num_elements);
+  T8_GLOBAL_INFOF ("Into t8_forest_adapt from %lld total elements\n",
+                   (long long)
+                   t8_forest_comm_global_num_elements_wait (forest_from));
 
   /* TODO: Allocate memory for the trees of forest.
    * Will we do this here or in an extra function? */
   T8_ASSERT (forest->trees->elem_count == forest_from->trees->elem_count);
 
-  if (forest->set_adapt_recursive) {
-    refine_list = sc_list_new (NULL);
+  kernel_eclass = t8_forest_get_kernel_eclass (forest);
+  if (forest->profile != NULL) {
+    forest->profile->specialized_kernels = kernel_eclass != T8_ECLASS_COUNT;
   }
-  forest->local_num_elements = 0;
-  el_offset = 0;
   num_trees = t8_forest_get_num_local_trees (forest);
-  for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
-    tree = t8_forest_get_tree (forest, ltree_id);
-    tree_from = t8_forest_get_tree (forest_from, ltree_id);
-    telements = &tree->elements;
-    telements_from = &tree_from->elements;
-    num_el_from = (t8_locidx_t) t8_element_array_get_count (telements_from);
-    tscheme = forest->scheme_cxx->eclass_schemes[tree->eclass];
-    el_considered = 0;
-    el_inserted = 0;
-    el_coarsen = 0;
-    /* TODO: this will generate problems with pyramidal elements */
-    num_children =
-      tscheme->t8_element_num_children (t8_element_array_index_locidx
-                                        (telements_from, 0));
-    elements = T8_ALLOC (t8_element_t *, num_children);
-    elements_from = T8_ALLOC (t8_element_t *, num_children);
-    while (el_considered < num_el_from) {
-#ifdef T8_ENABLE_DEBUG
-      is_family = 1;
+  if (forest->set_adapt_map && !forest->set_adapt_recursive) {
+    T8_ASSERT (forest->adapt_map == NULL);
+    forest->adapt_map = sc_array_new (sizeof (t8_forest_adapt_run_t));
+  }
+
+  /* The recursive adaptation allocates its elements with t8_element_new,
+   * which is not thread-safe. */
+  threaded = forest->set_adapt_threads > 1 && !forest->set_adapt_recursive;
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+  if (threaded) {
+    t8_forest_adapt_threaded (forest, kernel_eclass);
+  }
+#else
+  if (threaded) {
+    t8_global_productionf ("t8code was built without OpenMP support."
+                           " Adapting with one thread.\n");
+    threaded = 0;
+  }
 #endif
-      num_elements = num_children;
-      for (zz = 0; zz < num_children &&
-           el_considered + (t8_locidx_t) zz < num_el_from; zz++) {
-        elements_from[zz] = t8_element_array_index_locidx (telements_from,
-                                                           el_considered +
-                                                           zz);
-        if ((size_t) tscheme->t8_element_child_id (elements_from[zz]) != zz) {
-          break;
+  if (!threaded && !forest->set_adapt_recursive) {
+    t8_forest_adapt_counted (forest, kernel_eclass);
+  }
+  else if (!threaded) {
+    /* The recursive adaptation does not know the number of new elements in
+     * advance, commit packs the elements into an arena */
+    for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+      tree = t8_forest_get_tree (forest, ltree_id);
+      tree_from = t8_forest_get_tree_lazy (forest_from, ltree_id);
+      telements_from = &tree_from->elements;
+      if (tree_from->implicit_level >= 0
+          && t8_element_array_get_count (telements_from) == 0) {
+        /* We create the elements of an implicit tree only for this loop,
+         * such that the tree stays implicit in both forests if no element
+         * changes */
+        t8_forest_tree_implicit_elements (forest_from, tree_from,
+                                          &implicit_elements);
+        telements_from = &implicit_elements;
+      }
+      num_el_from =
+        (t8_locidx_t) t8_element_array_get_count (telements_from);
+      tscheme = forest->scheme_cxx->eclass_schemes[tree->eclass];
+      /* We compute the child ids of all elements of the tree at once,
+       * to detect families without a virtual call per element. */
+      if ((size_t) num_el_from > child_ids_alloc) {
+        child_ids_alloc = num_el_from;
+        child_ids = T8_REALLOC (child_ids, int, child_ids_alloc);
+        if (forest->set_adapt_tree_fn != NULL) {
+          markers = T8_REALLOC (markers, int8_t, child_ids_alloc);
         }
       }
-      if (zz != num_children) {
-        num_elements = 1;
-#ifdef T8_ENABLE_DEBUG
-        is_family = 0;
-#endif
+      t8_forest_kernel_compute_child_ids (kernel_eclass, tscheme,
+                                          telements_from, child_ids);
+      if (forest->set_adapt_tree_fn != NULL) {
+        forest->set_adapt_tree_fn (forest, forest_from, ltree_id,
+                                   tree_from->elements_offset, tscheme,
+                                   telements_from, markers);
       }
-      T8_ASSERT (!is_family || tscheme->t8_element_is_family (elements_from));
-      refine =
-        forest->set_adapt_fn (forest, forest->set_from, ltree_id,
-                              el_considered, tscheme, num_elements,
-                              elements_from);
-      T8_ASSERT (is_family || refine >= 0);
-      if (refine > 0 && tscheme->t8_element_level (elements_from[0]) >=
-          forest->maxlevel) {
-        /* Only refine an element if it does not exceed the maximum level */
-        refine = 0;
-      }
-      if (refine > 0) {
-        /* The first element is to be refined */
-        if (forest->set_adapt_recursive) {
-          /* el_coarsen is the index of the first element in the new element
-           * array which could be coarsened recursively.
-           * We can set this here, since a family that emerges from a refinement will never be coarsened */
-          el_coarsen = el_inserted + num_children;
-          tscheme->t8_element_new (num_children, elements);
-          tscheme->t8_element_children (elements_from[0], num_children,
-                                        elements);
-          for (ci = num_children - 1; ci >= 0; ci--) {
-            (void) sc_list_prepend (refine_list, elements[ci]);
-          }
-          t8_forest_adapt_refine_recursive (forest, ltree_id, el_considered,
-                                            tscheme, refine_list, telements,
-                                            &el_inserted, elements);
-        }
-        else {
-          /* add the children to the element array of the current tree */
-          (void) t8_element_array_push_count (telements, num_children);
-          for (zz = 0; zz < num_children; zz++) {
-            elements[zz] =
-              t8_element_array_index_locidx (telements, el_inserted + zz);
-          }
-          tscheme->t8_element_children (elements_from[0], num_children,
-                                        elements);
-          el_inserted += num_children;
-        }
-        el_considered++;
-      }
-      else if (refine < 0) {
-        /* The elements form a family and are to be coarsened */
-        elements[0] = t8_element_array_push (telements);
-        tscheme->t8_element_parent (elements_from[0], elements[0]);
-        el_inserted++;
-        if (forest->set_adapt_recursive) {
-          if ((size_t) tscheme->t8_element_child_id (elements[0])
-              == num_children - 1) {
-            t8_forest_adapt_coarsen_recursive (forest, ltree_id,
-                                               el_considered, tscheme,
-                                               telements, el_coarsen,
-                                               &el_inserted, elements);
-          }
-        }
-        el_considered += num_children;
+      (void) t8_forest_adapt_range (forest, ltree_id, tscheme,
+                                    telements_from, child_ids,
+                                    forest->set_adapt_markers != NULL ?
+                                    forest->set_adapt_markers +
+                                    tree_from->elements_offset : markers, 0,
+                                    num_el_from, &tree->elements,
+                                    forest->adapt_map, &unchanged, NULL, 0);
+      if (unchanged) {
+        /* No element of the tree changed, we share its elements with
+         * forest_from instead of copying them */
+        t8_element_array_reset (&tree->elements);
+        t8_forest_tree_share (forest, ltree_id, forest_from, ltree_id);
       }
-      else {
-        /* The considered elements are neither to be coarsened nor is the first
-         * one to be refined */
-        T8_ASSERT (refine == 0);
-        elements[0] = t8_element_array_push (telements);
-        tscheme->t8_element_copy (elements_from[0], elements[0]);
-        el_inserted++;
-        if (forest->set_adapt_recursive &&
-            (size_t) tscheme->t8_element_child_id (elements[0])
-            == num_children - 1) {
-          t8_forest_adapt_coarsen_recursive (forest, ltree_id, el_considered,
-                                             tscheme, telements, el_coarsen,
-                                             &el_inserted, elements);
-        }
-        el_considered++;
+      else if (forest->set_trim_elements) {
+        /* Free the memory of the estimate that was not used */
+        t8_element_array_shrink_to_fit (&tree->elements);
       }
-    }
-    if (forest->set_adapt_recursive) {
-      while (refine_list->elem_count > 0) {
-        SC_ABORT_NOT_REACHED ();
-        elpop = (t8_element_t *) sc_list_pop (refine_list);
-        elements[0] = t8_element_array_push (telements);
-        tscheme->t8_element_copy (elpop, elements[0]);
-        tscheme->t8_element_destroy (1, &elpop);
-        el_inserted++;
+      if (telements_from == &implicit_elements) {
+        t8_element_array_reset (&implicit_elements);
       }
     }
-    tree->elements_offset = el_offset;
-    el_offset += el_inserted;
-    forest->local_num_elements += el_inserted;
-    t8_element_array_resize (telements, el_inserted);
-
-    T8_FREE (elements);
-    T8_FREE (elements_from);
-    /* TODO: compute tree->element_offset */
+    T8_FREE (child_ids);
+    T8_FREE (markers);
   }
-  if (forest->set_adapt_recursive) {
-    sc_list_destroy (refine_list);
+
+  /* Compute the element offsets of the trees */
+  el_offset = 0;
+  for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+    tree = t8_forest_get_tree_lazy (forest, ltree_id);
+    tree->elements_offset = el_offset;
+    el_offset += t8_forest_get_tree_element_count (tree);
   }
+  forest->local_num_elements = el_offset;
   t8_forest_comm_global_num_elements (forest);
-  t8_global_productionf ("Done t8_forest_adapt with %lld total elements\n",
-                         (long long) forest->global_num_elements);
+  t8_trace_end ("adapt");
+  /* The global count is still being reduced */
+  t8_debugf ("Done t8_forest_adapt with %lld local elements\n",
+             (long long) forest->local_num_elements);
 
   /* if profiling is enabled, measure runtime */
   if (forest->profile != NULL) {
     forest->profile->adapt_runtime += sc_MPI_Wtime ();
+    t8_counters_stop (forest->profile->adapt_counters);
+    t8_profile_memory_stop (&forest->profile->adapt_memory);
     /* DO NOT DELETE THE FOLLOWING line.
      * even if you do not want this output. It fixes a bug that occured on JUQUEEN, where the
      * runtimes were computed to 0.
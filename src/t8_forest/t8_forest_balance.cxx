@@ -26,11 +26,69 @@
 #include <t8_forest/t8_forest_private.h>
 #include <t8_forest/t8_forest_ghost.h>
 #include <t8_forest.h>
+#include <t8_trace.h>
+#include <t8_threads.h>
 #include <t8_element_cxx.hxx>
+#include <t8_element_scratch.hxx>
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#include <omp.h>
+#endif
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
 
+/* The data of one round of balance that is passed to the adapt function
+ * via forest->t8code_data.
+ * Since adapt calls the function from several threads, each thread clears
+ * its own done flag and the flags are combined after the round. */
+typedef struct t8_forest_balance_data
+{
+  int                 num_threads;      /* The number of entries of thread_done */
+  int                *thread_done;      /* For each thread, set to 0 if it refines an element */
+  const int8_t       *candidates;       /* If not NULL, the flags of the elements of
+                                           forest_from that need to be checked */
+} t8_forest_balance_data_t;
+
+/* Return the number of the calling thread in its team */
+static int
+t8_forest_balance_thread_id (void)
+{
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+  return omp_get_thread_num ();
+#else
+  return 0;
+#endif
+}
+
+/* Set up the done flags of a balance round with num_threads threads */
+static void
+t8_forest_balance_data_init (t8_forest_balance_data_t * data,
+                             int num_threads, const int8_t * candidates)
+{
+  int                 ithread;
+
+  data->num_threads = SC_MAX (num_threads, 1);
+  data->thread_done = T8_ALLOC (int, data->num_threads);
+  for (ithread = 0; ithread < data->num_threads; ithread++) {
+    data->thread_done[ithread] = 1;
+  }
+  data->candidates = candidates;
+}
+
+/* Combine the done flags of all threads and free them.
+ * Returns true if no thread refined an element. */
+static int
+t8_forest_balance_data_reset (t8_forest_balance_data_t * data)
+{
+  int                 ithread, done = 1;
+
+  for (ithread = 0; ithread < data->num_threads; ithread++) {
+    done = done && data->thread_done[ithread];
+  }
+  T8_FREE (data->thread_done);
+  return done;
+}
+
 /* This is the adapt function called during one round of balance.
  * We refine an element if it has any face neighbor with a level larger
  * than the element's level + 1.
@@ -45,10 +103,12 @@ t8_forest_balance_adapt (t8_forest_t forest, t8_forest_t forest_from,
                          t8_eclass_scheme_c * ts,
                          int num_elements, t8_element_t * elements[])
 {
-  int                *pdone, iface, num_faces, num_half_neighbors, ineigh;
+  t8_forest_balance_data_t *data;
+  int                 iface, num_faces, num_half_neighbors, ineigh;
   t8_gloidx_t         neighbor_tree;
   t8_eclass_t         neigh_class;
   t8_eclass_scheme_c *neigh_scheme;
+  t8_element_scratch_mark_t scratch_mark;
   t8_element_t       *element = elements[0], **half_neighbors;
 
   /* We only need to check an element, if its level is smaller then the maximum
@@ -58,11 +118,16 @@ t8_forest_balance_adapt (t8_forest_t forest, t8_forest_t forest_from,
    * If we enter from the check function is_balanced, then it may not be set.
    */
 
+  data = (t8_forest_balance_data_t *) forest->t8code_data;
+  if (data->candidates != NULL
+      && !data->candidates[t8_forest_get_tree_lazy (forest_from, ltree_id)->
+                           elements_offset + lelement_id]) {
+    /* This element and its neighbors did not change, it stays balanced */
+    return 0;
+  }
   if (forest_from->maxlevel_existing <= 0 ||
       ts->t8_element_level (element) <= forest_from->maxlevel_existing - 2) {
 
-    pdone = (int *) forest->t8code_data;
-
     num_faces = ts->t8_element_num_faces (element);
     for (iface = 0; iface < num_faces; iface++) {
       /* Get the element class and scheme of the face neighbor */
@@ -72,8 +137,14 @@ t8_forest_balance_adapt (t8_forest_t forest, t8_forest_t forest_from,
       neigh_scheme = t8_forest_get_eclass_scheme (forest_from, neigh_class);
       /* Allocate memory for the number of half face neighbors */
       num_half_neighbors = ts->t8_element_num_face_children (element, iface);
-      half_neighbors = T8_ALLOC (t8_element_t *, num_half_neighbors);
-      neigh_scheme->t8_element_new (num_half_neighbors, half_neighbors);
+      /* The pointers come from the scratch arena of this thread as well,
+       * since this function is called by several threads at once */
+      t8_element_scratch_mark (&scratch_mark);
+      half_neighbors = (t8_element_t **)
+        t8_element_scratch_alloc (num_half_neighbors *
+                                  sizeof (t8_element_t *));
+      t8_element_scratch_get (neigh_scheme, num_half_neighbors,
+                              half_neighbors);
       /* Compute the half face neighbors of element at this face */
       neighbor_tree = t8_forest_element_half_face_neighbors (forest_from,
                                                              ltree_id,
@@ -92,18 +163,16 @@ t8_forest_balance_adapt (t8_forest_t forest, t8_forest_t forest_from,
                                                half_neighbors[ineigh],
                                                neigh_scheme)) {
             /* This element should be refined */
-            *pdone = 0;
+            T8_ASSERT (t8_forest_balance_thread_id () < data->num_threads);
+            data->thread_done[t8_forest_balance_thread_id ()] = 0;
             /* clean-up */
-            neigh_scheme->t8_element_destroy (num_half_neighbors,
-                                              half_neighbors);
-            T8_FREE (half_neighbors);
+            t8_element_scratch_release (&scratch_mark);
             return 1;
           }
         }
       }
       /* clean-up */
-      neigh_scheme->t8_element_destroy (num_half_neighbors, half_neighbors);
-      T8_FREE (half_neighbors);
+      t8_element_scratch_release (&scratch_mark);
     }
   }
 
@@ -116,10 +185,13 @@ t8_forest_compute_max_element_level (t8_forest_t forest)
 {
   t8_locidx_t         ielement, elem_in_tree;
   t8_locidx_t         itree, num_trees;
-  t8_element_t       *elem;
+  t8_element_array_t *elements;
   t8_eclass_scheme_c *scheme;
-  int                 local_max_level = 0, elem_level;
+  int                 local_max_level = 0;
+  int                *levels;
+  size_t              levels_alloc = 0;
 
+  levels = NULL;
   /* Iterate over all local trees and all local elements and comupte the maximum occurring level */
   num_trees = t8_forest_get_num_local_trees (forest);
   for (itree = 0; itree < num_trees; itree++) {
@@ -127,38 +199,231 @@ t8_forest_compute_max_element_level (t8_forest_t forest)
     scheme =
       t8_forest_get_eclass_scheme (forest,
                                    t8_forest_get_tree_class (forest, itree));
+    elements = t8_forest_get_tree_element_array (forest, itree);
+    if ((size_t) elem_in_tree > levels_alloc) {
+      levels_alloc = elem_in_tree;
+      levels = T8_REALLOC (levels, int, levels_alloc);
+    }
+    /* Compute the levels of all elements of this tree with one call */
+    scheme->t8_element_level_array (t8_element_array_get_data (elements),
+                                    elem_in_tree, levels);
     for (ielement = 0; ielement < elem_in_tree; ielement++) {
-      /* Get the element and compute its level */
-      elem = t8_forest_get_element_in_tree (forest, itree, ielement);
-      elem_level = scheme->t8_element_level (elem);
-      local_max_level = SC_MAX (local_max_level, elem_level);
+      local_max_level = SC_MAX (local_max_level, levels[ielement]);
     }
   }
+  T8_FREE (levels);
   /* Communicate the local maximum levels */
   sc_MPI_Allreduce (&local_max_level, &forest->maxlevel_existing, 1,
                     sc_MPI_INT, sc_MPI_MAX, forest->mpicomm);
 }
 
+/* Flag the elements of a forest that may need to be refined by balance,
+ * given that the forest it was adapted from was balanced.
+ * These are the elements that were changed by the adaptation, the leaves
+ * containing a face neighbor of a refined element that are more than one
+ * level coarser than it, and the local elements that are ghosts of other
+ * processes if the forest has a ghost layer.
+ * Returns NULL if forest does not store its adapt map.
+ * Otherwise the returned array has one entry for each local element and
+ * must be freed with T8_FREE. */
+static int8_t      *
+t8_forest_balance_candidates (t8_forest_t forest)
+{
+  t8_forest_adapt_run_t *run;
+  t8_tree_t           tree, neigh_tree;
+  t8_eclass_t         neigh_class;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_scratch_mark_t mark;
+  t8_element_t       *element, *neigh, *leaf;
+  t8_gloidx_t         gneigh_tree;
+  t8_locidx_t         lneigh_tree, ielem, first, last, index;
+  int8_t             *candidates;
+  size_t              irun;
+  int                 iface, num_faces, neigh_face, level;
+
+  if (forest->adapt_map == NULL) {
+    return NULL;
+  }
+  candidates = T8_ALLOC_ZERO (int8_t, t8_forest_get_num_element (forest));
+  for (irun = 0; irun < forest->adapt_map->elem_count; irun++) {
+    run = (t8_forest_adapt_run_t *) sc_array_index (forest->adapt_map, irun);
+    if (run->num_old == 1 && run->num_new == 1) {
+      /* These elements were kept */
+      continue;
+    }
+    tree = t8_forest_get_tree (forest, run->ltree_id);
+    first = tree->elements_offset + run->first_new;
+    last = first + run->count * run->num_new;
+    /* The new elements themselves need to be checked */
+    memset (candidates + first, 1, last - first);
+    if (run->num_new == 1) {
+      /* Coarsening does not unbalance the neighbors of a balanced family */
+      continue;
+    }
+    ts = t8_forest_get_eclass_scheme (forest, tree->eclass);
+    for (ielem = run->first_new;
+         ielem < run->first_new + run->count * run->num_new; ielem++) {
+      element = t8_forest_get_element_in_tree (forest, run->ltree_id,
+                                               ielem);
+      level = ts->t8_element_level (element);
+      num_faces = ts->t8_element_num_faces (element);
+      for (iface = 0; iface < num_faces; iface++) {
+        neigh_class = t8_forest_element_neighbor_eclass (forest,
+                                                         run->ltree_id,
+                                                         element, iface);
+        neigh_scheme = t8_forest_get_eclass_scheme (forest, neigh_class);
+        t8_element_scratch_mark (&mark);
+        t8_element_scratch_get (neigh_scheme, 1, &neigh);
+        gneigh_tree = t8_forest_element_face_neighbor (forest, run->ltree_id,
+                                                       element, neigh,
+                                                       neigh_scheme, iface,
+                                                       &neigh_face);
+        lneigh_tree = gneigh_tree >= 0 ?
+          t8_forest_get_local_id (forest, gneigh_tree) : -1;
+        if (lneigh_tree >= 0) {
+          /* The neighbor lies in a local tree, find the leaf containing it */
+          index = t8_forest_leaf_ancestor_index (forest, lneigh_tree, neigh,
+                                                 neigh_scheme);
+          if (index >= 0) {
+            leaf = t8_forest_get_element_in_tree (forest, lneigh_tree,
+                                                  index);
+            if (neigh_scheme->t8_element_level (leaf) < level - 1) {
+              neigh_tree = t8_forest_get_tree (forest, lneigh_tree);
+              candidates[neigh_tree->elements_offset + index] = 1;
+            }
+          }
+        }
+        t8_element_scratch_release (&mark);
+      }
+    }
+  }
+  if (forest->ghosts != NULL) {
+    /* Elements at the process boundary may be unbalanced by changes on
+     * other processes */
+    t8_forest_ghost_flag_remote_elements (forest, candidates);
+  }
+  return candidates;
+}
+
+/* Repeat the balance refinement on the local elements of a forest, until
+ * no process refines any more elements. We do not create ghost layers for the
+ * intermediate forests, thus only refinement that is caused by local
+ * neighbors is carried out.
+ * We take ownership of forest_from and return the resulting forest.
+ * The number of local rounds is added to num_rounds.
+ * If incremental is true, each round only checks the elements near the
+ * changes of the previous round. */
+static              t8_forest_t
+t8_forest_balance_ripple (t8_forest_t forest_from, int do_profile,
+                          int incremental, int num_threads, int *num_rounds)
+{
+  t8_forest_t         forest_temp;
+  t8_forest_balance_data_t data;
+  int8_t             *candidates;
+  t8_gloidx_t         num_elements_from;
+  int                 done_global = 0, done_local;
+
+  while (!done_global) {
+    t8_trace_begin ("balance_round");
+    candidates =
+      incremental ? t8_forest_balance_candidates (forest_from) : NULL;
+    t8_forest_balance_data_init (&data, num_threads, candidates);
+    t8_forest_init (&forest_temp);
+    /* Balance does not increase the maximum occurring level */
+    forest_temp->maxlevel_existing = forest_from->maxlevel_existing;
+    t8_forest_set_adapt (forest_temp, forest_from, t8_forest_balance_adapt,
+                         0);
+    t8_forest_set_adapt_threads (forest_temp, num_threads);
+    if (num_threads > 1) {
+      /* The threads of adapt read the trees of forest_from */
+      t8_forest_materialize (forest_from);
+    }
+    t8_forest_set_profiling (forest_temp, do_profile);
+    t8_forest_set_adapt_map (forest_temp, incremental);
+    forest_temp->t8code_data = &data;
+    num_elements_from = t8_forest_get_global_num_elements (forest_from);
+    t8_forest_commit (forest_temp);
+    T8_FREE (candidates);
+    done_local = t8_forest_balance_data_reset (&data);
+    /* Balance only refines, thus no process refined an element if and only
+     * if the global number of elements did not change */
+    done_global =
+      t8_forest_get_global_num_elements (forest_temp) == num_elements_from;
+    T8_ASSERT (!done_global || done_local);
+    (void) done_local;
+    forest_from = forest_temp;
+    (*num_rounds)++;
+  }
+  return forest_from;
+}
+
+/* Set the trees of forest to those of the balanced forest forest_done.
+ * If we hold the only reference to forest_done, we take over its trees and
+ * its partition arrays instead of copying them.
+ * If forest needs the ghost layer that forest_done already has, we share it. */
+static void
+t8_forest_balance_take_trees (t8_forest_t forest, t8_forest_t forest_done)
+{
+  if (t8_refcount_is_last (&forest_done->rc)) {
+    t8_forest_move_trees (forest, forest_done);
+    if (forest->mpicomm == forest_done->mpicomm
+        && forest->maxlevel == forest_done->maxlevel) {
+      /* forest has the same partition as forest_done */
+      forest->element_offsets = forest_done->element_offsets;
+      forest->tree_offsets = forest_done->tree_offsets;
+      forest->global_first_desc = forest_done->global_first_desc;
+      forest_done->element_offsets = NULL;
+      forest_done->tree_offsets = NULL;
+      forest_done->global_first_desc = NULL;
+      if (forest->profile != NULL && forest_done->profile != NULL) {
+        forest->profile->offsets_saved_runtime =
+          forest_done->profile->offsets_runtime;
+      }
+    }
+  }
+  else {
+    t8_forest_copy_trees (forest, forest_done, 1);
+  }
+  if (forest->do_ghost && forest->mpisize > 1 && forest_done->ghosts != NULL
+      && forest_done->ghosts->ghost_type == forest->ghost_type) {
+    /* The ghost layer only depends on the elements, which are the same */
+    t8_forest_ghost_ref (forest_done->ghosts);
+    forest->ghosts = forest_done->ghosts;
+    if (forest->profile != NULL && forest_done->profile != NULL) {
+      forest->profile->ghost_saved_runtime =
+        forest_done->profile->ghost_runtime;
+    }
+  }
+}
+
 void
 t8_forest_balance (t8_forest_t forest, int repartition)
 {
   t8_forest_t         forest_temp, forest_from, forest_partition;
-  int                 done = 0, done_global = 0;
+  t8_forest_balance_data_t data;
+  int8_t             *candidates;
+  t8_gloidx_t         num_elements_from;
+  int                 done_global = 0, done_local, incremental;
   int                 count = 0, num_stats, i;
+  int                 ripple_rounds = 0;
   double              ada_time, ghost_time, part_time;
   sc_statinfo_t      *adap_stats, *ghost_stats, *partition_stats;
 
-  t8_global_productionf
-    ("Into t8_forest_balance with %lli global elements.\n",
-     (long long) t8_forest_get_global_num_elements (forest->set_from));
+  T8_GLOBAL_INFOF ("Into t8_forest_balance with %lli global elements.\n",
+                   (long long)
+                   t8_forest_get_global_num_elements (forest->set_from));
   t8_log_indent_push ();
 
   /* Set default value to prevent compiler warning */
   adap_stats = ghost_stats = partition_stats = NULL;
+  /* After repartitioning the adapt map does not match the elements */
+  incremental = forest->set_balance_incremental && !repartition;
 
   if (forest->profile != NULL) {
     /* Profiling is enable, so we measure the runtime of balance */
     forest->profile->balance_runtime = -sc_MPI_Wtime ();
+    t8_counters_start (forest->profile->balance_counters);
+    t8_profile_memory_start (&forest->profile->balance_memory);
     /* We store the individual adapt, ghost, and partition runtimes */
     num_stats = 5;
     adap_stats = T8_ALLOC_ZERO (sc_statinfo_t, num_stats);
@@ -170,8 +435,8 @@ t8_forest_balance (t8_forest_t forest, int repartition)
 
   /* Compute the maximum occurring refinement level in the forest */
   t8_forest_compute_max_element_level (forest->set_from);
-  t8_global_productionf ("Computed maximum occurring level:\t%i\n",
-                         forest->set_from->maxlevel_existing);
+  T8_GLOBAL_INFOF ("Computed maximum occurring level:\t%i\n",
+                   forest->set_from->maxlevel_existing);
   /* Use set_from as the first forest to adapt */
   forest_from = forest->set_from;
   /* This function is reference neutral regarding forest_from */
@@ -182,27 +447,45 @@ t8_forest_balance (t8_forest_t forest, int repartition)
     t8_forest_ghost_create_topdown (forest->set_from);
   }
   while (!done_global) {
-    done = 1;
+    /* Only check the elements near the changes of the last adaptation */
+    candidates =
+      incremental ? t8_forest_balance_candidates (forest_from) : NULL;
+    /* The refinement decisions are made by the threads of adapt */
+    t8_forest_balance_data_init (&data, forest->set_adapt_threads,
+                                 candidates);
 
     T8_ASSERT (forest_from->maxlevel_existing >= 0);
     /* Initialize the temp forest to be adapted from forest_from */
     t8_forest_init (&forest_temp);
     /* Update the maximum occurring level */
     forest_temp->maxlevel_existing = forest_from->maxlevel_existing;
+    /* If this is the last round, forest_temp will be equal to forest_from.
+     * We keep forest_from, since it already has its ghost layer. */
+    t8_forest_ref (forest_from);
+    num_elements_from = t8_forest_get_global_num_elements (forest_from);
     /* Adapt the forest */
     t8_forest_set_adapt (forest_temp, forest_from, t8_forest_balance_adapt,
                          0);
-    if (!repartition) {
+    t8_forest_set_adapt_threads (forest_temp, data.num_threads);
+    if (data.num_threads > 1) {
+      /* The threads of adapt read the trees of forest_from */
+      t8_forest_materialize (forest_from);
+    }
+    if (!repartition && !forest->set_balance_ripple) {
       t8_forest_set_ghost (forest_temp, 1, T8_GHOST_FACES);
     }
-    forest_temp->t8code_data = &done;
+    t8_forest_set_adapt_map (forest_temp, incremental);
+    forest_temp->t8code_data = &data;
     /* If profiling is enabled, measure ghost/adapt rumtimes */
     if (forest->profile != NULL) {
       t8_forest_set_profiling (forest_temp, 1);
     }
-    t8_global_productionf ("Profiling: %i\n", forest->profile != NULL);
+    T8_GLOBAL_INFOF ("Profiling: %i\n", forest->profile != NULL);
     /* Adapt the forest */
     t8_forest_commit (forest_temp);
+    T8_FREE (candidates);
+    /* Combine the results of the threads */
+    done_local = t8_forest_balance_data_reset (&data);
     /* Store the runtimes of adapt and ghost */
     if (forest->profile != NULL) {
       while (count >= num_stats - 2) {
@@ -217,17 +500,52 @@ t8_forest_balance (t8_forest_t forest, int repartition)
       }
       sc_stats_set1 (&adap_stats[count], forest_temp->profile->adapt_runtime,
                      "forest balance: Adapt time");
-      if (!repartition) {
+      if (!repartition && !forest->set_balance_ripple) {
         sc_stats_set1 (&ghost_stats[count],
                        forest_temp->profile->ghost_runtime,
                        "forest balance: Ghost time");
       }
     }
 
-    /* Compute the logical and of all process local done values, if this results
-     * in 1 then all processes are finished */
-    sc_MPI_Allreduce (&done, &done_global, 1, sc_MPI_INT, sc_MPI_LAND,
-                      forest->mpicomm);
+    /* Balance only refines, thus all processes are finished if and only if
+     * the global number of elements did not change. Adapt already computed
+     * it, so we do not need to reduce the local done values. */
+    done_global =
+      t8_forest_get_global_num_elements (forest_temp) == num_elements_from;
+    T8_ASSERT (!done_global || done_local);
+    (void) done_local;
+    if (done_global) {
+      /* forest_temp and forest_from have the same elements */
+      t8_forest_unref (&forest_temp);
+      forest_temp = forest_from;
+    }
+    else {
+      t8_forest_unref (&forest_from);
+    }
+
+    if (forest->set_balance_ripple && !done_global) {
+      /* Continue the refinement locally until it does not change any more */
+      forest_temp = t8_forest_balance_ripple (forest_temp,
+                                              forest->profile != NULL,
+                                              incremental,
+                                              forest->set_adapt_threads,
+                                              &ripple_rounds);
+      if (!repartition) {
+        /* The next round needs the ghost elements of forest_temp */
+        forest_temp->ghost_type = T8_GHOST_FACES;
+        t8_forest_ghost_create_topdown (forest_temp);
+        if (forest->profile != NULL) {
+          sc_stats_set1 (&ghost_stats[count],
+                         forest_temp->profile->ghost_runtime,
+                         "forest balance: Ghost time");
+        }
+      }
+    }
+    else if (forest->set_balance_ripple && forest->profile != NULL
+             && !repartition) {
+      /* No ghost layer was created in this round */
+      sc_stats_set1 (&ghost_stats[count], 0, "forest balance: Ghost time");
+    }
 
     if (repartition && !done_global) {
       /* If repartitioning is used, we partition the forest */
@@ -258,29 +576,36 @@ t8_forest_balance (t8_forest_t forest, int repartition)
     /* Adapt forest_temp in the next round */
     forest_from = forest_temp;
     count++;
+    t8_trace_end ("balance_round");
   }
 
   T8_ASSERT (t8_forest_is_balanced (forest_temp));
-  /* Forest_temp is now balanced, we copy its trees and elements to forest */
-  t8_forest_copy_trees (forest, forest_temp, 1);
-  /* TODO: Also copy ghost elements if ghost creation is set */
+  /* Forest_temp is now balanced, we use its trees and elements for forest */
+  t8_forest_balance_take_trees (forest, forest_temp);
 
   t8_log_indent_pop ();
-  t8_global_productionf
-    ("Done t8_forest_balance with %lli global elements.\n",
-     (long long) t8_forest_get_global_num_elements (forest_temp));
-  t8_debugf ("t8_forest_balance needed %i rounds.\n", count);
+  T8_GLOBAL_INFOF ("Done t8_forest_balance with %lli global elements.\n",
+                   (long long)
+                   t8_forest_get_global_num_elements (forest_temp));
+  T8_DEBUGF ("t8_forest_balance needed %i rounds.\n", count);
+  if (forest->set_balance_ripple) {
+    T8_DEBUGF ("t8_forest_balance needed %i local ripple rounds.\n",
+               ripple_rounds);
+  }
   /* clean-up */
   t8_forest_unref (&forest_temp);
 
   if (forest->profile != NULL) {
     /* Profiling is enabled, so we measure the runtime of balance. */
     forest->profile->balance_runtime += sc_MPI_Wtime ();
+    t8_counters_stop (forest->profile->balance_counters);
+    t8_profile_memory_stop (&forest->profile->balance_memory);
     forest->profile->balance_rounds = count;
+    forest->profile->balance_reductions_saved = count + ripple_rounds;
     /* Print the runtime of adapt/ghost/partition */
     /* Compute the overall runtime and store in last entry */
     ada_time = ghost_time = part_time = 0;
-    t8_debugf ("ada stats %f\n", adap_stats[count].sum_values);
+    T8_DEBUGF ("ada stats %f\n", adap_stats[count].sum_values);
     for (i = 0; i < count; i++) {
       ada_time += adap_stats[i].sum_values;
       ghost_time += ghost_stats[i].sum_values;
@@ -319,52 +644,86 @@ t8_forest_balance (t8_forest_t forest, int repartition)
   }
 }
 
-/* Check whether the local elements of a forest are balanced. */
-int
-t8_forest_is_balanced (t8_forest_t forest)
+/* The number of elements that a thread checks at once in
+ * t8_forest_is_balanced */
+#define T8_FOREST_BALANCE_CHECK_GRAIN 1024
+
+/* Check the local elements begin to end - 1 of the forest in
+ * forest->t8code_data. If one of them would be refined by balance, the done
+ * flag of the thread is cleared. */
+static void
+t8_forest_is_balanced_range (size_t begin, size_t end, int thread_id,
+                             void *user_data)
 {
-  t8_forest_t         forest_from;
-  t8_locidx_t         num_trees, num_elements;
-  t8_locidx_t         itree, ielem;
+  t8_forest_t         forest = (t8_forest_t) user_data;
+  t8_forest_balance_data_t *data =
+    (t8_forest_balance_data_t *) forest->t8code_data;
+  t8_locidx_t         itree, ielem, index, first, num_elements;
   t8_element_t       *element;
   t8_eclass_scheme_c *ts;
-  void               *data_temp;
-  int                 dummy_int;
 
-  T8_ASSERT (t8_forest_is_committed (forest));
-
-  /* temporarily save forest_from */
-  forest_from = forest->set_from;
-
-  forest->set_from = forest;
-
-  /* temporarily save forest t8code_data */
-  data_temp = forest->t8code_data;
-  forest->t8code_data = &dummy_int;
-
-  num_trees = t8_forest_get_num_local_trees (forest);
-  /* Iterate over all trees */
-  for (itree = 0; itree < num_trees; itree++) {
+  T8_ASSERT (thread_id < data->num_threads);
+  if (!data->thread_done[thread_id]) {
+    /* This thread already found an unbalanced element */
+    return;
+  }
+  /* Find the tree of the first element */
+  (void) t8_forest_get_element (forest, (t8_locidx_t) begin, &itree);
+  for (index = (t8_locidx_t) begin; index < (t8_locidx_t) end; itree++) {
+    first = t8_forest_get_tree_element_offset (forest, itree);
     num_elements = t8_forest_get_tree_num_elements (forest, itree);
     ts =
       t8_forest_get_eclass_scheme (forest,
                                    t8_forest_get_tree_class (forest, itree));
-    /* Iterate over all elements of this tree */
-    for (ielem = 0; ielem < num_elements; ielem++) {
+    /* Iterate over the elements of the range in this tree */
+    for (; index < (t8_locidx_t) end && index < first + num_elements;
+         index++) {
+      ielem = index - first;
       element = t8_forest_get_element_in_tree (forest, itree, ielem);
       /* Test if this element would need to be refined in the balance step.
        * If so, the forest is not balanced locally. */
       if (t8_forest_balance_adapt
           (forest, forest, itree, ielem, ts, 1, &element)) {
-        forest->set_from = forest_from;
-        forest->t8code_data = data_temp;
-        return 0;
+        return;
       }
     }
   }
+}
+
+/* Check whether the local elements of a forest are balanced.
+ * The elements are checked by all threads. */
+int
+t8_forest_is_balanced (t8_forest_t forest)
+{
+  t8_forest_t         forest_from;
+  void               *data_temp;
+  t8_forest_balance_data_t data;
+  int                 done;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  /* temporarily save forest_from */
+  forest_from = forest->set_from;
+
+  forest->set_from = forest;
+
+  /* temporarily save forest t8code_data */
+  data_temp = forest->t8code_data;
+  t8_forest_balance_data_init (&data, t8_get_num_threads (), NULL);
+  forest->t8code_data = &data;
+
+  /* Reading an implicit tree from several threads would create its
+   * elements concurrently */
+  t8_forest_materialize (forest);
+  t8_parallel_for (0, t8_forest_get_num_element (forest),
+                   T8_FOREST_BALANCE_CHECK_GRAIN,
+                   t8_forest_is_balanced_range, forest);
+
   forest->set_from = forest_from;
   forest->t8code_data = data_temp;
-  return 1;
+  /* Reduce the results of the threads */
+  done = t8_forest_balance_data_reset (&data);
+  return done;
 }
 
 T8_EXTERN_C_END ();
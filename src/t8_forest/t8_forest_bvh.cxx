@@ -0,0 +1,428 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_threads.h>
+#include <t8_forest/t8_forest_bvh.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/* The maximum depth of the hierarchy */
+#define T8_FOREST_BVH_MAX_DEPTH 64
+
+/* The maximum number of trees in a leaf of the hierarchy */
+#define T8_FOREST_BVH_LEAF_SIZE 4
+
+/* Nodes with less trees are built by the thread that built their parent */
+#define T8_FOREST_BVH_TASK_MIN 1024
+
+/* A tree with the coordinate of its box center along the split axis */
+typedef struct
+{
+  double              key;
+  t8_locidx_t         tree;
+} t8_forest_tree_bvh_key_t;
+
+static int
+t8_forest_tree_bvh_key_compare (const void *a, const void *b)
+{
+  const double        ka = ((const t8_forest_tree_bvh_key_t *) a)->key;
+  const double        kb = ((const t8_forest_tree_bvh_key_t *) b)->key;
+
+  return ka < kb ? -1 : ka > kb;
+}
+
+/* The length of the diagonal of a box */
+static double
+t8_forest_tree_bvh_box_diameter (const double *box)
+{
+  return sqrt ((box[3] - box[0]) * (box[3] - box[0])
+               + (box[4] - box[1]) * (box[4] - box[1])
+               + (box[5] - box[2]) * (box[5] - box[2]));
+}
+
+/* Return true if a box enlarged by tol in each direction contains a point */
+static int
+t8_forest_tree_bvh_box_contains (const double *box, const double *point,
+                                 double tol)
+{
+  int                 i;
+
+  for (i = 0; i < 3; i++) {
+    if (point[i] < box[i] - tol || point[i] > box[3 + i] + tol) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Return true if two boxes intersect */
+static int
+t8_forest_tree_bvh_box_intersects (const double *box_a, const double *box_b)
+{
+  int                 i;
+
+  for (i = 0; i < 3; i++) {
+    if (box_a[3 + i] < box_b[i] || box_b[3 + i] < box_a[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* The number of nodes of the subtree with count trees whose root is at the
+ * given depth. It depends only on count and depth, such that the nodes of
+ * each subtree can be placed without knowing the other subtrees. */
+static int
+t8_forest_tree_bvh_num_nodes (t8_locidx_t count, int depth)
+{
+  if (count <= T8_FOREST_BVH_LEAF_SIZE
+      || depth + 1 >= T8_FOREST_BVH_MAX_DEPTH) {
+    return 1;
+  }
+  return 1 + t8_forest_tree_bvh_num_nodes (count / 2, depth + 1)
+    + t8_forest_tree_bvh_num_nodes (count - count / 2, depth + 1);
+}
+
+/* Build the node inode for the trees tree_order[first], ...,
+ * tree_order[first + count - 1] and its descendants.
+ * The left child of a node follows the node and the right child
+ * follows the subtree of the left child.
+ * The node sorts its trees in keys[first], ..., keys[first + count - 1].
+ * The key buffer is allocated once by the caller, since the nodes are
+ * built in omp tasks that must not call the allocator. */
+static void
+t8_forest_tree_bvh_build_node (t8_forest_tree_bvh_t * bvh, int inode,
+                               t8_locidx_t first, t8_locidx_t count,
+                               int depth, t8_forest_tree_bvh_key_t * keys)
+{
+  t8_forest_tree_bvh_node_t *node = bvh->nodes + inode;
+  t8_forest_tree_bvh_key_t *node_keys = keys + first;
+  const double       *box;
+  t8_locidx_t         itree;
+  int                 i, axis, left, right;
+  double              len, max_len;
+
+  node->first = first;
+  node->count = count;
+  node->left = node->right = -1;
+  /* The box of the node is the union of the boxes of its trees */
+  for (i = 0; i < 3; i++) {
+    node->box[i] = HUGE_VAL;
+    node->box[3 + i] = -HUGE_VAL;
+  }
+  for (itree = first; itree < first + count; itree++) {
+    box = bvh->tree_boxes + 6 * bvh->tree_order[itree];
+    for (i = 0; i < 3; i++) {
+      node->box[i] = SC_MIN (node->box[i], box[i]);
+      node->box[3 + i] = SC_MAX (node->box[3 + i], box[3 + i]);
+    }
+  }
+  if (count <= T8_FOREST_BVH_LEAF_SIZE
+      || depth + 1 >= T8_FOREST_BVH_MAX_DEPTH) {
+    return;
+  }
+  /* Split the trees at the median along the longest axis */
+  axis = 0;
+  max_len = -1;
+  for (i = 0; i < 3; i++) {
+    len = node->box[3 + i] - node->box[i];
+    if (len > max_len) {
+      max_len = len;
+      axis = i;
+    }
+  }
+  for (itree = 0; itree < count; itree++) {
+    node_keys[itree].tree = bvh->tree_order[first + itree];
+    box = bvh->tree_boxes + 6 * node_keys[itree].tree;
+    node_keys[itree].key = .5 * (box[axis] + box[3 + axis]);
+  }
+  qsort (node_keys, count, sizeof (t8_forest_tree_bvh_key_t),
+         t8_forest_tree_bvh_key_compare);
+  for (itree = 0; itree < count; itree++) {
+    bvh->tree_order[first + itree] = node_keys[itree].tree;
+  }
+  left = inode + 1;
+  right = left + t8_forest_tree_bvh_num_nodes (count / 2, depth + 1);
+  node->left = left;
+  node->right = right;
+  /* The two subtrees touch disjoint ranges of the order and the nodes */
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp task if (count >= T8_FOREST_BVH_TASK_MIN)
+#endif
+  t8_forest_tree_bvh_build_node (bvh, left, first, count / 2, depth + 1,
+                                 keys);
+  t8_forest_tree_bvh_build_node (bvh, right, first + count / 2,
+                                 count - count / 2, depth + 1, keys);
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp taskwait
+#endif
+}
+
+t8_forest_tree_bvh_t *
+t8_forest_tree_bvh_new_boxes (t8_locidx_t num_boxes, double *boxes)
+{
+  t8_forest_tree_bvh_t *bvh;
+  t8_forest_tree_bvh_key_t *keys;
+  t8_locidx_t         itree;
+
+  T8_ASSERT (num_boxes >= 0);
+  T8_ASSERT (boxes != NULL);
+
+  bvh = T8_ALLOC_ZERO (t8_forest_tree_bvh_t, 1);
+  bvh->tree_boxes = boxes;
+  bvh->tree_order = T8_ALLOC (t8_locidx_t, SC_MAX (num_boxes, 1));
+  for (itree = 0; itree < num_boxes; itree++) {
+    if (bvh->tree_boxes[6 * itree] <= bvh->tree_boxes[6 * itree + 3]) {
+      bvh->tree_order[bvh->num_trees++] = itree;
+    }
+  }
+
+  /* Build the nodes top-down, the subtrees of large nodes in parallel */
+  if (bvh->num_trees > 0) {
+    bvh->num_nodes = t8_forest_tree_bvh_num_nodes (bvh->num_trees, 0);
+    bvh->nodes = T8_ALLOC (t8_forest_tree_bvh_node_t, bvh->num_nodes);
+    /* The subtrees of a node sort disjoint slices of the keys */
+    keys = T8_ALLOC (t8_forest_tree_bvh_key_t, bvh->num_trees);
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp parallel num_threads (t8_get_num_threads ()) \
+  if (bvh->num_trees >= T8_FOREST_BVH_TASK_MIN)
+#pragma omp single
+#endif
+    t8_forest_tree_bvh_build_node (bvh, 0, 0, bvh->num_trees, 0, keys);
+    T8_FREE (keys);
+  }
+  return bvh;
+}
+
+void
+t8_forest_tree_bvh_free (t8_forest_tree_bvh_t ** pbvh)
+{
+  t8_forest_tree_bvh_t *bvh;
+
+  T8_ASSERT (pbvh != NULL && *pbvh != NULL);
+
+  bvh = *pbvh;
+  T8_FREE (bvh->tree_boxes);
+  T8_FREE (bvh->tree_order);
+  T8_FREE (bvh->nodes);
+  T8_FREE (bvh);
+  *pbvh = NULL;
+}
+
+void
+t8_forest_tree_bvh_build (t8_forest_t forest)
+{
+  const double       *vertices;
+  double             *boxes, *box;
+  t8_locidx_t         itree, num_trees;
+  int                 ivertex, num_vertices, i;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->tree_bvh == NULL);
+
+  num_trees = t8_forest_get_num_local_trees (forest)
+    + t8_forest_get_num_ghost_trees (forest);
+  boxes = T8_ALLOC (double, 6 * SC_MAX (num_trees, 1));
+
+  /* Compute the bounding box of each tree from its vertices */
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp parallel for private (vertices, box, ivertex, num_vertices, i) \
+  num_threads (t8_get_num_threads ()) if (num_trees >= T8_FOREST_BVH_TASK_MIN)
+#endif
+  for (itree = 0; itree < num_trees; itree++) {
+    box = boxes + 6 * itree;
+    vertices = t8_forest_get_tree_vertices (forest, itree);
+    if (vertices == NULL) {
+      /* An empty box */
+      for (i = 0; i < 3; i++) {
+        box[i] = HUGE_VAL;
+        box[3 + i] = -HUGE_VAL;
+      }
+      continue;
+    }
+    num_vertices =
+      t8_eclass_num_vertices[t8_forest_get_tree_class (forest, itree)];
+    for (i = 0; i < 3; i++) {
+      box[i] = box[3 + i] = vertices[i];
+    }
+    for (ivertex = 1; ivertex < num_vertices; ivertex++) {
+      for (i = 0; i < 3; i++) {
+        box[i] = SC_MIN (box[i], vertices[3 * ivertex + i]);
+        box[3 + i] = SC_MAX (box[3 + i], vertices[3 * ivertex + i]);
+      }
+    }
+  }
+  forest->tree_bvh = t8_forest_tree_bvh_new_boxes (num_trees, boxes);
+}
+
+void
+t8_forest_tree_bvh_destroy (t8_forest_t forest)
+{
+  T8_ASSERT (forest->tree_bvh != NULL);
+
+  t8_forest_tree_bvh_free (&forest->tree_bvh);
+}
+
+/* Search the hierarchy for the trees that match a point with tolerance
+ * or, if point is NULL, a box */
+static int
+t8_forest_tree_bvh_search (const t8_forest_tree_bvh_t * bvh,
+                           t8_forest_t forest, const double *point,
+                           double tolerance, const double *query_box,
+                           t8_forest_tree_bvh_fn callback, void *user_data)
+{
+  const t8_forest_tree_bvh_node_t *node;
+  const double       *box;
+  t8_locidx_t         itree, ltreeid;
+  int                 stack[2 * T8_FOREST_BVH_MAX_DEPTH], stack_size;
+  int                 found;
+
+  T8_ASSERT (bvh != NULL);
+  T8_ASSERT (callback != NULL);
+
+  if (bvh->num_nodes == 0) {
+    return 1;
+  }
+  stack[0] = 0;
+  stack_size = 1;
+  while (stack_size > 0) {
+    node = bvh->nodes + stack[--stack_size];
+    /* The diameter of a node bounds the diameters of its trees, such that
+     * a node that does not contain the point has no tree that does */
+    found = point != NULL
+      ? t8_forest_tree_bvh_box_contains (node->box, point, tolerance *
+                                         t8_forest_tree_bvh_box_diameter
+                                         (node->box))
+      : t8_forest_tree_bvh_box_intersects (node->box, query_box);
+    if (!found) {
+      continue;
+    }
+    if (node->left >= 0) {
+      T8_ASSERT (stack_size + 2 <= 2 * T8_FOREST_BVH_MAX_DEPTH);
+      stack[stack_size++] = node->right;
+      stack[stack_size++] = node->left;
+      continue;
+    }
+    for (itree = node->first; itree < node->first + node->count; itree++) {
+      ltreeid = bvh->tree_order[itree];
+      box = bvh->tree_boxes + 6 * ltreeid;
+      found = point != NULL
+        ? t8_forest_tree_bvh_box_contains (box, point, tolerance *
+                                           t8_forest_tree_bvh_box_diameter
+                                           (box))
+        : t8_forest_tree_bvh_box_intersects (box, query_box);
+      if (found && !callback (forest, ltreeid, box, user_data)) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+int
+t8_forest_tree_bvh_search_point (t8_forest_t forest, const double point[3],
+                                 double tolerance,
+                                 t8_forest_tree_bvh_fn callback,
+                                 void *user_data)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (point != NULL);
+  T8_ASSERT (tolerance >= 0);
+
+  if (forest->tree_bvh == NULL) {
+    /* Build the hierarchy on first use */
+    t8_forest_tree_bvh_build (forest);
+  }
+  return t8_forest_tree_bvh_search (forest->tree_bvh, forest, point,
+                                    tolerance, NULL, callback, user_data);
+}
+
+int
+t8_forest_tree_bvh_search_point_ext (const t8_forest_tree_bvh_t * bvh,
+                                     t8_forest_t forest,
+                                     const double point[3], double tolerance,
+                                     t8_forest_tree_bvh_fn callback,
+                                     void *user_data)
+{
+  T8_ASSERT (point != NULL);
+  T8_ASSERT (tolerance >= 0);
+
+  return t8_forest_tree_bvh_search (bvh, forest, point, tolerance, NULL,
+                                    callback, user_data);
+}
+
+int
+t8_forest_tree_bvh_search_box (t8_forest_t forest, const double box[6],
+                               t8_forest_tree_bvh_fn callback,
+                               void *user_data)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (box != NULL);
+
+  if (forest->tree_bvh == NULL) {
+    /* Build the hierarchy on first use */
+    t8_forest_tree_bvh_build (forest);
+  }
+  return t8_forest_tree_bvh_search (forest->tree_bvh, forest, NULL, 0, box,
+                                    callback, user_data);
+}
+
+/* Append each tree to the array given as user data */
+static int
+t8_forest_tree_bvh_push (t8_forest_t forest, t8_locidx_t ltreeid,
+                         const double tree_box[6], void *user_data)
+{
+  *(t8_locidx_t *) sc_array_push ((sc_array_t *) user_data) = ltreeid;
+  return 1;
+}
+
+t8_locidx_t
+t8_forest_tree_bvh_query_point (t8_forest_t forest, const double point[3],
+                                double tolerance, sc_array_t * trees)
+{
+  size_t              count;
+
+  T8_ASSERT (trees != NULL && trees->elem_size == sizeof (t8_locidx_t));
+
+  count = trees->elem_count;
+  (void) t8_forest_tree_bvh_search_point (forest, point, tolerance,
+                                          t8_forest_tree_bvh_push, trees);
+  return (t8_locidx_t) (trees->elem_count - count);
+}
+
+t8_locidx_t
+t8_forest_tree_bvh_query_box (t8_forest_t forest, const double box[6],
+                              sc_array_t * trees)
+{
+  size_t              count;
+
+  T8_ASSERT (trees != NULL && trees->elem_size == sizeof (t8_locidx_t));
+
+  count = trees->elem_count;
+  (void) t8_forest_tree_bvh_search_box (forest, box,
+                                        t8_forest_tree_bvh_push, trees);
+  return (t8_locidx_t) (trees->elem_count - count);
+}
+
+T8_EXTERN_C_END ();
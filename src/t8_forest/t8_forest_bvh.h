@@ -0,0 +1,124 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_bvh.h
+ * Find the coarse trees of a forest that may contain a point or intersect
+ * a box.
+ *
+ * A forest can store a bounding volume hierarchy over the axis-aligned
+ * bounding boxes of its local and ghost trees, see \ref t8_forest_set_tree_bvh.
+ * The boxes are computed from the tree vertices in the cmesh. They contain
+ * the trees if the trees are mapped by the linear geometry, since its maps
+ * interpolate the vertices. For curved geometries the queries only return
+ * candidates with respect to the vertices.
+ *
+ * Trees are identified by their local id, or by the number of local trees
+ * plus their ghost tree id if they are ghost trees.
+ * Trees without vertices are never returned.
+ */
+
+#ifndef T8_FOREST_BVH_H
+#define T8_FOREST_BVH_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** Callback for each tree that is found by a search in the hierarchy.
+ * \param [in] forest     The forest.
+ * \param [in] ltreeid    The local or ghost tree that was found.
+ * \param [in] tree_box   The bounding box of this tree: the minimal x, y, z
+ *                        and the maximal x, y, z coordinates.
+ * \param [in] user_data  The user data passed to the search.
+ * \return                True to continue the search, false to stop it.
+ */
+typedef int         (*t8_forest_tree_bvh_fn) (t8_forest_t forest,
+                                              t8_locidx_t ltreeid,
+                                              const double tree_box[6],
+                                              void *user_data);
+
+T8_EXTERN_C_BEGIN ();
+
+/** Call a function for each tree whose bounding box contains a point.
+ * \param [in] forest     A committed forest. If it has no hierarchy yet,
+ *                        the hierarchy is built.
+ * \param [in] point      The x, y and z coordinates of the point.
+ * \param [in] tolerance  A relative tolerance. A box contains \a point if
+ *                        each coordinate of \a point lies in the box up to
+ *                        \a tolerance times the diameter of the box.
+ * \param [in] callback   Called for each tree that is found.
+ * \param [in] user_data  Passed to \a callback.
+ * \return                False if \a callback stopped the search, true otherwise.
+ * If the hierarchy exists, this function does not allocate and can be
+ * called by several threads.
+ */
+int                 t8_forest_tree_bvh_search_point (t8_forest_t forest,
+                                                     const double point[3],
+                                                     double tolerance,
+                                                     t8_forest_tree_bvh_fn
+                                                     callback,
+                                                     void *user_data);
+
+/** Call a function for each tree whose bounding box intersects a box.
+ * \param [in] forest     A committed forest. If it has no hierarchy yet,
+ *                        the hierarchy is built.
+ * \param [in] box        The minimal x, y, z and the maximal x, y, z
+ *                        coordinates of the box.
+ * \param [in] callback   Called for each tree that is found.
+ * \param [in] user_data  Passed to \a callback.
+ * \return                False if \a callback stopped the search, true otherwise.
+ * If the hierarchy exists, this function does not allocate and can be
+ * called by several threads.
+ */
+int                 t8_forest_tree_bvh_search_box (t8_forest_t forest,
+                                                   const double box[6],
+                                                   t8_forest_tree_bvh_fn
+                                                   callback, void *user_data);
+
+/** Find the trees whose bounding box contains a point.
+ * \param [in] forest     A committed forest.
+ * \param [in] point      The x, y and z coordinates of the point.
+ * \param [in] tolerance  A relative tolerance,
+ *                        see \ref t8_forest_tree_bvh_search_point.
+ * \param [in,out] trees  An array of t8_locidx_t. The ids of the trees that
+ *                        are found are appended.
+ * \return                The number of trees that are found.
+ */
+t8_locidx_t         t8_forest_tree_bvh_query_point (t8_forest_t forest,
+                                                    const double point[3],
+                                                    double tolerance,
+                                                    sc_array_t * trees);
+
+/** Find the trees whose bounding box intersects a box.
+ * \param [in] forest     A committed forest.
+ * \param [in] box        The minimal x, y, z and the maximal x, y, z
+ *                        coordinates of the box.
+ * \param [in,out] trees  An array of t8_locidx_t. The ids of the trees that
+ *                        are found are appended.
+ * \return                The number of trees that are found.
+ */
+t8_locidx_t         t8_forest_tree_bvh_query_box (t8_forest_t forest,
+                                                  const double box[6],
+                                                  sc_array_t * trees);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_BVH_H */
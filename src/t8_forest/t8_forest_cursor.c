@@ -0,0 +1,202 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_cursor.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_ghost.h>
+
+/* The number of bytes of the next tree's elements that we prefetch
+ * when entering a tree */
+#define T8_FOREST_CURSOR_PREFETCH_BYTES 256
+
+/* The assumed size of a cache line */
+#define T8_FOREST_CURSOR_CACHE_LINE 64
+
+/* Return the elements of the tree with index itree in [0, num_trees).
+ * The indices after the local trees refer to the ghost trees. */
+static t8_element_array_t *
+t8_forest_leaf_cursor_tree_elements (const t8_forest_leaf_cursor_t * cursor,
+                                     t8_locidx_t itree)
+{
+  const t8_locidx_t   num_local_trees =
+    t8_forest_get_num_local_trees (cursor->forest);
+
+  T8_ASSERT (0 <= itree && itree < cursor->num_trees);
+  if (itree < num_local_trees) {
+    /* We do not create the elements of implicit trees */
+    return &t8_forest_get_tree_lazy (cursor->forest, itree)->elements;
+  }
+  return t8_forest_ghost_get_tree_elements (cursor->forest,
+                                            itree - num_local_trees);
+}
+
+/* Return the number of elements of the tree with index itree */
+static              t8_locidx_t
+t8_forest_leaf_cursor_tree_count (const t8_forest_leaf_cursor_t * cursor,
+                                  t8_locidx_t itree)
+{
+  const t8_locidx_t   num_local_trees =
+    t8_forest_get_num_local_trees (cursor->forest);
+
+  if (itree < num_local_trees) {
+    return
+      t8_forest_get_tree_element_count (t8_forest_get_tree_lazy
+                                        (cursor->forest, itree));
+  }
+  return (t8_locidx_t)
+    t8_element_array_get_count (t8_forest_leaf_cursor_tree_elements
+                                (cursor, itree));
+}
+
+/* Hint the processor to load the first elements of a tree into cache */
+static void
+t8_forest_leaf_cursor_prefetch (t8_element_array_t * elements)
+{
+#if defined (__GNUC__)
+  const char         *data;
+  size_t              bytes, ibyte;
+
+  data = (const char *) t8_element_array_get_data (elements);
+  if (data == NULL) {
+    return;
+  }
+  bytes = t8_element_array_get_count (elements)
+    * t8_element_array_get_size (elements);
+  bytes = SC_MIN (bytes, T8_FOREST_CURSOR_PREFETCH_BYTES);
+  for (ibyte = 0; ibyte < bytes; ibyte += T8_FOREST_CURSOR_CACHE_LINE) {
+    __builtin_prefetch (data + ibyte, 0, 1);
+  }
+#endif
+}
+
+/* Move the cursor to the first leaf of the first nonempty tree with index
+ * itree or greater. Return true if there is such a tree. */
+static int
+t8_forest_leaf_cursor_enter (t8_forest_leaf_cursor_t * cursor,
+                             t8_locidx_t itree)
+{
+  const t8_locidx_t   num_local_trees =
+    t8_forest_get_num_local_trees (cursor->forest);
+  t8_element_array_t *elements;
+  t8_tree_t           tree;
+
+  for (; itree < cursor->num_trees; itree++) {
+    if (t8_forest_leaf_cursor_tree_count (cursor, itree) > 0) {
+      break;
+    }
+  }
+  cursor->itree = itree;
+  if (itree >= cursor->num_trees) {
+    /* We are past the last leaf */
+    cursor->element = NULL;
+    cursor->ts = NULL;
+    return 0;
+  }
+  if (itree + 1 < cursor->num_trees) {
+    t8_forest_leaf_cursor_prefetch (t8_forest_leaf_cursor_tree_elements
+                                    (cursor, itree + 1));
+  }
+  cursor->is_ghost = itree >= num_local_trees;
+  if (cursor->is_ghost) {
+    cursor->ltreeid = itree - num_local_trees;
+    cursor->lelement = t8_forest_get_num_element (cursor->forest)
+      + t8_forest_ghost_get_tree_element_offset (cursor->forest,
+                                                 cursor->ltreeid);
+  }
+  else {
+    cursor->ltreeid = itree;
+    cursor->lelement =
+      t8_forest_get_tree_element_offset (cursor->forest, itree);
+  }
+  elements = t8_forest_leaf_cursor_tree_elements (cursor, itree);
+  cursor->ts = t8_element_array_get_scheme (elements);
+  cursor->element_size = t8_element_array_get_size (elements);
+  cursor->tree_num_elements = t8_forest_leaf_cursor_tree_count (cursor,
+                                                                itree);
+  cursor->tree_index = 0;
+  cursor->implicit_tree = NULL;
+  if (!cursor->is_ghost && t8_element_array_get_count (elements) == 0) {
+    /* This is an implicit tree whose elements are not stored */
+    tree = t8_forest_get_tree_lazy (cursor->forest, itree);
+    T8_ASSERT (tree->implicit_level >= 0);
+    if (cursor->element_size <= sizeof (cursor->implicit_element)) {
+      cursor->implicit_tree = tree;
+      cursor->element = (t8_element_t *) cursor->implicit_element;
+      t8_forest_tree_implicit_element (cursor->forest, tree, 0,
+                                       cursor->element);
+      return 1;
+    }
+    /* The elements do not fit into the cursor, we create them */
+    elements = t8_forest_get_tree_element_array (cursor->forest, itree);
+  }
+  cursor->element = t8_element_array_get_data (elements);
+  return 1;
+}
+
+int
+t8_forest_leaf_cursor_begin (t8_forest_leaf_cursor_t * cursor,
+                             t8_forest_t forest, int with_ghosts)
+{
+  T8_ASSERT (cursor != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (!with_ghosts || forest->ghosts != NULL);
+
+  cursor->forest = forest;
+  cursor->with_ghosts = with_ghosts;
+  cursor->num_trees = t8_forest_get_num_local_trees (forest);
+  if (with_ghosts) {
+    cursor->num_trees += t8_forest_ghost_num_trees (forest);
+  }
+  cursor->is_ghost = 0;
+  return t8_forest_leaf_cursor_enter (cursor, 0);
+}
+
+int
+t8_forest_leaf_cursor_valid (const t8_forest_leaf_cursor_t * cursor)
+{
+  T8_ASSERT (cursor != NULL);
+
+  return cursor->element != NULL;
+}
+
+int
+t8_forest_leaf_cursor_next (t8_forest_leaf_cursor_t * cursor)
+{
+  T8_ASSERT (t8_forest_leaf_cursor_valid (cursor));
+
+  cursor->tree_index++;
+  if (cursor->tree_index >= cursor->tree_num_elements) {
+    /* We leave the current tree */
+    return t8_forest_leaf_cursor_enter (cursor, cursor->itree + 1);
+  }
+  cursor->lelement++;
+  if (cursor->implicit_tree != NULL) {
+    t8_forest_tree_implicit_element (cursor->forest, cursor->implicit_tree,
+                                     cursor->tree_index, cursor->element);
+    return 1;
+  }
+  /* The elements of a tree are stored contiguously */
+  cursor->element = (t8_element_t *)
+    ((char *) cursor->element + cursor->element_size);
+  return 1;
+}
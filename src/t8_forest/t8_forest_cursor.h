@@ -0,0 +1,122 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_cursor.h
+ * Walk over all local leafs of a forest, and optionally its ghosts,
+ * in the order of the space-filling curve.
+ *
+ * A typical loop is
+ *
+ *     t8_forest_leaf_cursor_t cursor;
+ *
+ *     for (t8_forest_leaf_cursor_begin (&cursor, forest, 0);
+ *          t8_forest_leaf_cursor_valid (&cursor);
+ *          t8_forest_leaf_cursor_next (&cursor)) {
+ *       ... cursor.ltreeid, cursor.ts, cursor.element, cursor.lelement ...
+ *     }
+ *
+ * When the cursor enters a tree it prefetches the element array of the
+ * following tree, such that the first elements of this tree are in cache
+ * when the cursor reaches them.
+ *
+ * The elements of an implicit tree, see \ref t8_forest_set_implicit_uniform,
+ * are computed by the cursor one at a time and are not stored in the tree.
+ * In such a tree \a cursor.element points into the cursor and is only
+ * valid until the cursor is advanced.
+ */
+
+#ifndef T8_FOREST_CURSOR_H
+#define T8_FOREST_CURSOR_H
+
+#include <t8.h>
+#include <t8_forest.h>
+#include <t8_data/t8_containers.h>
+
+/** The number of doubles that the cursor reserves for an element of an
+ * implicit tree. Trees with larger elements are created when the cursor
+ * enters them. */
+#define T8_FOREST_LEAF_CURSOR_ELEMENT_DOUBLES 8
+
+/** A position in the leafs of a forest.
+ * The members up to \a is_ghost may be read by the user and must not be
+ * changed. The remaining members are internal.
+ */
+typedef struct t8_forest_leaf_cursor
+{
+  t8_forest_t         forest;   /**< The forest that we iterate. */
+  t8_locidx_t         ltreeid;  /**< The local id of the current tree, or its
+                                     ghost tree id if \a is_ghost is true. */
+  t8_eclass_scheme_c *ts;       /**< The scheme of the current tree. */
+  t8_element_t       *element;  /**< The current leaf. NULL if the cursor is past
+                                     the last leaf. */
+  t8_locidx_t         lelement; /**< The local index of the current leaf. For ghosts
+                                     this is the number of local elements plus
+                                     the index of the ghost. */
+  t8_locidx_t         tree_index; /**< The index of the current leaf in its tree. */
+  int                 is_ghost; /**< True if the current leaf is a ghost. */
+
+  int                 with_ghosts; /**< True if the ghosts are visited after the
+                                        local leafs. */
+  t8_locidx_t         num_trees; /**< The number of local trees plus,
+                                      if \a with_ghosts, the number of ghost trees. */
+  t8_locidx_t         itree;    /**< The index of the current tree in [0, \a num_trees). */
+  t8_locidx_t         tree_num_elements; /**< The number of leafs in the current tree. */
+  size_t              element_size; /**< The size in bytes of an element of the
+                                         current tree. */
+  t8_tree_t           implicit_tree; /**< The current tree if the cursor computes
+                                          its elements, NULL otherwise. */
+  double              implicit_element[T8_FOREST_LEAF_CURSOR_ELEMENT_DOUBLES]; /**< Memory for the
+                                          current leaf of \a implicit_tree. */
+} t8_forest_leaf_cursor_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Place a cursor at the first leaf of a forest.
+ * \param [out] cursor      The cursor.
+ * \param [in]  forest      A committed forest.
+ * \param [in]  with_ghosts If true, the ghost elements of \a forest are
+ *                          visited after all local leafs. The forest must
+ *                          have a ghost layer in this case.
+ * \return                  True if \a forest has a leaf to visit.
+ */
+int                 t8_forest_leaf_cursor_begin (t8_forest_leaf_cursor_t *
+                                                 cursor, t8_forest_t forest,
+                                                 int with_ghosts);
+
+/** Query whether a cursor points to a leaf.
+ * \param [in]  cursor  A cursor.
+ * \return              True if \a cursor is not past the last leaf.
+ */
+int                 t8_forest_leaf_cursor_valid (const t8_forest_leaf_cursor_t
+                                                 * cursor);
+
+/** Advance a cursor to the next leaf.
+ * \param [in,out] cursor  A valid cursor.
+ * \return                 True if the cursor points to a leaf on output,
+ *                         false if it is past the last leaf.
+ */
+int                 t8_forest_leaf_cursor_next (t8_forest_leaf_cursor_t *
+                                                cursor);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_CURSOR_H */
@@ -23,6 +23,9 @@
 #include <sc_statistics.h>
 #include <t8_refcount.h>
 #include <t8_vec.h>
+#include <t8_geometry.h>
+#include <t8_quadrature.h>
+#include <t8_threads.h>
 #include <t8_forest.h>
 #include <t8_forest/t8_forest_types.h>
 #include <t8_forest/t8_forest_cxx.h>
@@ -30,7 +33,9 @@
 #include <t8_forest/t8_forest_private.h>
 #include <t8_forest/t8_forest_ghost.h>
 #include <t8_forest/t8_forest_balance.h>
+#include <t8_forest/t8_forest_kernels.hxx>
 #include <t8_element_cxx.hxx>
+#include <t8_element_scratch.hxx>
 #include <t8_cmesh/t8_cmesh_trees.h>
 #include <t8_cmesh/t8_cmesh_offset.h>
 
@@ -186,6 +191,134 @@ t8_forest_is_equal (t8_forest_t forest_a, t8_forest_t forest_b)
   return 1;
 }
 
+/* The finalizer of splitmix64, a bijective mix of all bits of x. */
+static inline       uint64_t
+t8_forest_fingerprint_mix (uint64_t x)
+{
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+/* The hash of one leaf in word iword of the fingerprint. Since it depends
+ * on the global index of the leaf, the sum of all leaf hashes depends on
+ * the order of the leaves. */
+static inline       uint64_t
+t8_forest_fingerprint_leaf (int iword, t8_gloidx_t global_index,
+                            t8_gloidx_t gtreeid, t8_linearidx_t linear_id,
+                            int level)
+{
+  /* Two different seeds make the two words independent */
+  uint64_t            h = iword == 0 ? 0x9e3779b97f4a7c15ULL
+    : 0xc2b2ae3d27d4eb4fULL;
+
+  h = t8_forest_fingerprint_mix (h ^ (uint64_t) global_index);
+  h = t8_forest_fingerprint_mix (h ^ (uint64_t) gtreeid);
+  h = t8_forest_fingerprint_mix (h ^ linear_id);
+  return t8_forest_fingerprint_mix (h ^ (uint64_t) level);
+}
+
+/* The data of the threads that hash the local trees. */
+typedef struct
+{
+  t8_forest_t         forest;
+  t8_gloidx_t         first_element;     /**< Global index of the first
+                                             local element. */
+  uint64_t           *sums;     /**< Two words per thread. */
+} t8_forest_fingerprint_data_t;
+
+static void
+t8_forest_fingerprint_trees (size_t begin, size_t end, int thread_id,
+                             void *user_data)
+{
+  t8_forest_fingerprint_data_t *data =
+    (t8_forest_fingerprint_data_t *) user_data;
+  t8_forest_t         forest = data->forest;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *element;
+  t8_locidx_t         itree, ielem, num_elements, offset;
+  t8_gloidx_t         gtreeid, global_index;
+  t8_linearidx_t      linear_id;
+  uint64_t            sum0 = 0, sum1 = 0;
+  int                 level;
+
+  for (itree = (t8_locidx_t) begin; itree < (t8_locidx_t) end; itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    gtreeid = t8_forest_global_tree_id (forest, itree);
+    offset = t8_forest_get_tree_element_offset (forest, itree);
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielem);
+      level = ts->t8_element_level (element);
+      linear_id = ts->t8_element_get_linear_id (element, level);
+      global_index = data->first_element + offset + ielem;
+      sum0 += t8_forest_fingerprint_leaf (0, global_index, gtreeid,
+                                          linear_id, level);
+      sum1 += t8_forest_fingerprint_leaf (1, global_index, gtreeid,
+                                          linear_id, level);
+    }
+  }
+  data->sums[2 * thread_id] += sum0;
+  data->sums[2 * thread_id + 1] += sum1;
+}
+
+void
+t8_forest_get_fingerprint (t8_forest_t forest, uint64_t fingerprint[2])
+{
+  t8_forest_fingerprint_data_t data;
+  unsigned long long  local[2], global[2];
+  t8_gloidx_t         num_elements;
+  int                 num_threads, ithread, mpiret;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  if (!forest->have_fingerprint) {
+    /* The global index of the first local element */
+    if (forest->element_offsets != NULL) {
+      data.first_element = t8_forest_get_first_local_element_id (forest);
+    }
+    else {
+      num_elements = forest->local_num_elements;
+      mpiret = sc_MPI_Scan (&num_elements, &data.first_element, 1,
+                            T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+      SC_CHECK_MPI (mpiret);
+      data.first_element -= num_elements;
+    }
+
+    /* Each thread sums the hashes of its trees */
+    num_threads = t8_get_num_threads ();
+    if (num_threads > 1) {
+      /* Creating the elements of implicit trees is not thread-safe */
+      t8_forest_materialize (forest);
+    }
+    data.forest = forest;
+    data.sums = T8_ALLOC_ZERO (uint64_t, 2 * num_threads);
+    t8_parallel_for (0, t8_forest_get_num_local_trees (forest), 1,
+                     t8_forest_fingerprint_trees, &data);
+    local[0] = local[1] = 0;
+    for (ithread = 0; ithread < num_threads; ithread++) {
+      local[0] += data.sums[2 * ithread];
+      local[1] += data.sums[2 * ithread + 1];
+    }
+    T8_FREE (data.sums);
+
+    /* Unsigned sums wrap around, thus they do not depend on the partition */
+    mpiret = sc_MPI_Allreduce (local, global, 2, sc_MPI_UNSIGNED_LONG_LONG,
+                               sc_MPI_SUM, forest->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    forest->fingerprint[0] = (uint64_t) global[0];
+    forest->fingerprint[1] = (uint64_t) global[1];
+    forest->have_fingerprint = 1;
+  }
+  fingerprint[0] = forest->fingerprint[0];
+  fingerprint[1] = forest->fingerprint[1];
+}
+
 /* Given function values at the four edge points of a unit square and
  * a point within that square, interpolate the function value at this point.
  * \param [in]    vertex  An array of size at least dim giving the coordinates of the vertex to interpolate
@@ -234,6 +367,7 @@ t8_forest_element_coordinate (t8_forest_t forest, t8_locidx_t ltree_id,
   double              vertex_coords[3];
   t8_eclass_scheme_c *ts;
   t8_eclass_t         eclass;
+  const t8_forest_tree_map_t *map;
   double              len;
   int                 dim;
 
@@ -249,13 +383,22 @@ t8_forest_element_coordinate (t8_forest_t forest, t8_locidx_t ltree_id,
   dim = t8_eclass_to_dimension[eclass];
   len = 1. / ts->t8_element_root_len (element);
   ts->t8_element_vertex_coords (element, corner_number, corner_coords);
+  map = t8_forest_get_tree_map (forest, ltree_id);
+  if (map != NULL && map->vertices == vertices && dim > 0) {
+    /* Evaluate the precomputed map of the tree */
+    for (i = 0; i < 3; i++) {
+      vertex_coords[i] = i < dim ? len * corner_coords[i] : 0;
+    }
+    t8_forest_tree_map_evaluate (map, vertex_coords, coordinates);
+    return;
+  }
   switch (eclass) {
   case T8_ECLASS_VERTEX:
     T8_ASSERT (corner_number == 0);
     /* A vertex has exactly one corner, and we already know its coordinates, since they are
      * the same as the trees coordinates. */
-    for (i = 0;i < 3;i++) {
-      coordinates[i] = corner_coords[i];
+    for (i = 0; i < 3; i++) {
+      coordinates[i] = vertices[i];
     }
     break;
   case T8_ECLASS_LINE:
@@ -314,6 +457,85 @@ t8_forest_element_coordinate (t8_forest_t forest, t8_locidx_t ltree_id,
   return;
 }
 
+void
+t8_forest_leaf_range_corner_coordinates (t8_forest_t forest,
+                                         t8_locidx_t ltree_id,
+                                         t8_element_array_t * leafs,
+                                         t8_locidx_t first,
+                                         t8_locidx_t num_leafs, double *x,
+                                         double *y, double *z)
+{
+  t8_eclass_scheme_c *ts;
+  t8_eclass_t         eclass;
+  const double       *vertices;
+  double              coeffs[T8_GEOMETRY_LINEAR_COEFFS][3];
+  double              len, u, v, w, uv, uw, vw, uvw;
+  double             *out[3];
+  int                *corner_coords;
+  t8_locidx_t         ileaf;
+  int                 icorner, num_corners, dim, i;
+  size_t              index;
+
+  T8_ASSERT (0 <= first && first + num_leafs
+             <= (t8_locidx_t) t8_element_array_get_count (leafs));
+  if (num_leafs == 0) {
+    return;
+  }
+  eclass = t8_forest_get_tree_class (forest, ltree_id);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  dim = t8_eclass_to_dimension[eclass];
+  num_corners = t8_eclass_num_vertices[eclass];
+  vertices = t8_forest_get_tree_vertices (forest, ltree_id);
+  T8_ASSERT (vertices != NULL);
+  t8_geometry_linear_coefficients (eclass, vertices, coeffs);
+  len = 1. / ts->t8_element_root_len (t8_element_array_index_locidx (leafs,
+                                                                     first));
+  out[0] = x;
+  out[1] = y;
+  out[2] = z;
+
+  corner_coords = T8_ALLOC (int, T8_ECLASS_MAX_DIM * num_leafs);
+  for (icorner = 0; icorner < num_corners; icorner++) {
+    /* Compute the reference coordinates of this corner for all leafs */
+    ts->t8_element_vertex_coords_array (t8_element_array_index_locidx
+                                        (leafs, first), num_leafs, icorner,
+                                        corner_coords);
+    for (ileaf = 0; ileaf < num_leafs; ileaf++) {
+      const int          *cc = corner_coords + T8_ECLASS_MAX_DIM * ileaf;
+      /* Only the first dim entries of cc are set */
+      u = dim > 0 ? len * cc[0] : 0;
+      v = dim > 1 ? len * cc[1] : 0;
+      w = dim > 2 ? len * cc[2] : 0;
+      uv = u * v;
+      uw = u * w;
+      vw = v * w;
+      uvw = uv * w;
+      index = (size_t) ileaf * num_corners + icorner;
+      for (i = 0; i < 3; i++) {
+        out[i][index] = coeffs[0][i] + coeffs[1][i] * u + coeffs[2][i] * v
+          + coeffs[3][i] * w + coeffs[4][i] * uv + coeffs[5][i] * uw
+          + coeffs[6][i] * vw + coeffs[7][i] * uvw;
+      }
+    }
+  }
+  T8_FREE (corner_coords);
+}
+
+void
+t8_forest_tree_leaf_corner_coordinates (t8_forest_t forest,
+                                        t8_locidx_t ltree_id, double *x,
+                                        double *y, double *z)
+{
+  t8_element_array_t *leafs;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  leafs = t8_forest_tree_get_leafs (forest, ltree_id);
+  t8_forest_leaf_range_corner_coordinates (forest, ltree_id, leafs, 0,
+                                           t8_element_array_get_count
+                                           (leafs), x, y, z);
+}
+
 /* Compute the diameter of an element. */
 double
 t8_forest_element_diam (t8_forest_t forest, t8_locidx_t ltreeid,
@@ -425,61 +647,85 @@ t8_forest_element_triangle_area (double coordinates[3][3])
   return 0.5 * sqrt (fabs (v_1v_1 * v_2v_2 - v_1v_2 * v_1v_2));
 }
 
-static double
-t8_forest_element_tet_volume (double coordinates[4][3])
-{
-  /* We compute the volume as a sixth of the determinant of the
-   * three vectors of the corners minus the forth vector.
-   * Let the corners be a, b, c, and d.
-   * V = 1/6 |det (a-d,b-d,c-d)|
-   * This can be rewritten as
-   * V = |(a-d)*((b-d) x (c-d))|/6
-   */
-  double              cross[3];
-  int                 i;
+/* The number of elements whose volumes or face normals are computed in
+ * one batch when the geometry cache is built */
+#define T8_FOREST_GEOMETRY_BATCH 64
 
-  /* subtract the 4-th vector from the other 3 */
-  for (i = 0; i < 3; i++) {
-    t8_vec_axpy (coordinates[3], coordinates[i], -1);
+/* Return the factor of the volumes of the spanning vectors that
+ * t8_forest_element_volume_corners stores for an element class. */
+static double
+t8_forest_volume_factor (t8_eclass_t eclass)
+{
+  switch (eclass) {
+  case T8_ECLASS_TRIANGLE:
+    /* A triangle is half of the parallelogram of its two sides */
+    return 0.5;
+  case T8_ECLASS_TET:
+  case T8_ECLASS_PRISM:
+    /* A tet is a sixth of the parallelepiped of its three sides */
+    return 1. / 6;
+  default:
+    return 1;
   }
-
-  /* Compute the cross product of the 2nd and 3rd */
-  t8_vec_cross (coordinates[1], coordinates[2], cross);
-
-  /* return |(a-d) * ((b-d)x(c-d))| / 6 */
-  return fabs (t8_vec_dot (coordinates[0], cross)) / 6;
 }
 
-/* Compute an element's volume */
-double
-t8_forest_element_volume (t8_forest_t forest, t8_locidx_t ltreeid,
-                          const t8_element_t * element,
-                          const double *vertices)
+/* Return true if t8_forest_element_volume_corners supports an element
+ * class. */
+static int
+t8_forest_volume_has_corners (t8_eclass_t eclass)
 {
-  t8_eclass_t         eclass;
-
-  T8_ASSERT (t8_forest_is_committed (forest));
+  return eclass == T8_ECLASS_TRIANGLE || eclass == T8_ECLASS_QUAD
+    || eclass == T8_ECLASS_TET || eclass == T8_ECLASS_HEX
+    || eclass == T8_ECLASS_PRISM;
+}
 
-  /* get the eclass of the forest */
-  eclass = t8_forest_get_tree_class (forest, ltreeid);
+/* We compute the volume of an element as a multiple of the sum of the
+ * volumes of parallelograms (2D) or parallelepipeds (3D). Each of them is
+ * spanned by the vectors from a base corner to the corners u, v and,
+ * in 3D, w. The volume is |u x v| in 2D and |w * (u x v)| in 3D.
+ *  triangle: The parallelogram of corners 0, 1, 2, halved.
+ *  quad:     The parallelogram of corner 0 and its two neighbors, this is
+ *            an approximation.
+ *  tet:      V = 1/6 |det (a-d,b-d,c-d)| = |(a-d)*((b-d) x (c-d))|/6
+ *            for the corners a, b, c, d.
+ *  hex:      The parallelepiped of corner 0 and the corners 1, 2, 4 (in
+ *            Z-order).
+ *  prism:    We divide the prism into the 3 tetrahedra of the prism
+ *            vertices 0, 1, 2, 4 and 0, 2, 3, 4 and 2, 3, 4, 5.
+ * The corners of the spanning set number first + s of an element are
+ * stored at entry first + s of the four batches of size n in corners,
+ * the base corners, the corners u, the corners v and the corners w.
+ * Returns the number of spanning sets of the element, 3 for prisms,
+ * otherwise 1. */
+static int
+t8_forest_element_volume_corners (t8_forest_t forest, t8_locidx_t ltreeid,
+                                  const t8_element_t * element,
+                                  const double *vertices, t8_eclass_t eclass,
+                                  double *corners, size_t n, size_t first)
+{
+  /* The base corner and the corners u, v, w of each spanning set */
+  const int           tet_corners[4] = { 3, 1, 2, 0 };
+  const int           hex_corners[4] = { 0, 2, 4, 1 };
+  const int           prism_corners[3][4] = {
+    {4, 1, 2, 0}, {4, 2, 3, 0}, {5, 3, 4, 2}
+  };
+  int                 quad_corners[3];
+  const int          *set_corners[3];
+  int                 num_sets = 1, num_corners, iset, icorner;
+  double              coordinates[3];
 
   switch (eclass) {
-  case T8_ECLASS_VERTEX:
-    /* vertices do not have any volume */
-    return 0;
-  case T8_ECLASS_LINE:
-    /* for line, the volume equals the diameter */
-    return t8_forest_element_diam (forest, ltreeid, element, vertices);
+  case T8_ECLASS_TRIANGLE:
+    quad_corners[0] = 0;
+    quad_corners[1] = 1;
+    quad_corners[2] = 2;
+    set_corners[0] = quad_corners;
+    break;
   case T8_ECLASS_QUAD:
     {
-      int                 face_a, face_b, corner_a, corner_b;
-      double              coordinates[3][3];
+      int                 face_a, face_b;
       t8_eclass_scheme_c *ts;
-      /* We use this formula for computing the surface area for a parallelogram
-       * (we use parallelogram as approximation for the element).
-       *
-       *  A = | det (v_1*v_1 v_1*v_2) |
-       *      |     (v_2*v_1 v_2*v_2) |
+      /*
        * v_1
        *  x --- x
        *  |     |
@@ -487,139 +733,116 @@ t8_forest_element_volume (t8_forest_t forest, t8_locidx_t ltreeid,
        *  x --- x
        * 0       v_2
        */
-      /* Compute the faces meeting at vertex 0 */
+      /* Compute the faces meeting at vertex 0 and their other corners */
       ts = t8_forest_get_eclass_scheme (forest, T8_ECLASS_QUAD);
       face_a = ts->t8_element_get_corner_face (element, 0, 0);
       face_b = ts->t8_element_get_corner_face (element, 0, 1);
-      /* Compute the other corners of these faces */
-      corner_a = ts->t8_element_get_face_corner (element, face_a, 1);
-      corner_b = ts->t8_element_get_face_corner (element, face_b, 1);
-      T8_ASSERT (corner_a != 0 && corner_b != 0);
-      T8_ASSERT (corner_a != corner_b);
-      /* Compute the coordinates of vertex 0, a and b */
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices,
-                                    0, coordinates[0]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices,
-                                    corner_a, coordinates[1]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices,
-                                    corner_b, coordinates[2]);
-      return 2 * t8_forest_element_triangle_area (coordinates);
+      quad_corners[0] = 0;
+      quad_corners[1] = ts->t8_element_get_face_corner (element, face_a, 1);
+      quad_corners[2] = ts->t8_element_get_face_corner (element, face_b, 1);
+      T8_ASSERT (quad_corners[1] != 0 && quad_corners[2] != 0);
+      T8_ASSERT (quad_corners[1] != quad_corners[2]);
+      set_corners[0] = quad_corners;
     }
     break;
-  case T8_ECLASS_TRIANGLE:
-    {
-      double              coordinates[3][3];
-      int                 i;
-      /* We use the same formula as for quads but divide the result in half.
-       *    v_2
-       *    x
-       *   /  \
-       *  x -- x
-       * 0     v_1
-       *  A = | det (v_1*v_1 v_1*v_2) |
-       *      |     (v_2*v_1 v_2*v_2) |
-       *
-       * This is not an approximation as in the quad case, since a
-       * triangle always spans a parallelogram.
-       */
-      for (i = 0; i < 3; i++) {
-        t8_forest_element_coordinate (forest, ltreeid, element, vertices,
-                                      i, coordinates[i]);
-      }
-      return t8_forest_element_triangle_area (coordinates);
+  case T8_ECLASS_TET:
+    set_corners[0] = tet_corners;
+    break;
+  case T8_ECLASS_HEX:
+    set_corners[0] = hex_corners;
+    break;
+  case T8_ECLASS_PRISM:
+    num_sets = 3;
+    for (iset = 0; iset < num_sets; iset++) {
+      set_corners[iset] = prism_corners[iset];
     }
     break;
-  case T8_ECLASS_TET:
-    {
-      /* We compute the volume as a sixth of the determinant of the
-       * three vectors of the corners minus the forth vector.
-       * Let the corners be a, b, c, and d.
-       * V = 1/6 |det (a-d,b-d,c-d)|
-       * This can be rewritten as
-       * V = |(a-d)*((b-d) x (c-d))|/6
-       */
-      double              coordinates[4][3];
-      int                 i;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  num_corners = t8_eclass_to_dimension[eclass] + 1;
+  for (iset = 0; iset < num_sets; iset++) {
+    for (icorner = 0; icorner < num_corners; icorner++) {
+      t8_forest_element_coordinate (forest, ltreeid, element, vertices,
+                                    set_corners[iset][icorner], coordinates);
+      t8_vec_batch_set (corners + 3 * n * icorner, n, first + iset,
+                        coordinates);
+    }
+  }
+  return num_sets;
+}
 
-      /* Compute the 4 corner coordinates */
-      for (i = 0; i < 4; i++) {
-        t8_forest_element_coordinate (forest, ltreeid, element, vertices, i,
-                                      coordinates[i]);
-      }
+/* Compute the volumes of the n spanning sets that
+ * t8_forest_element_volume_corners stored in corners, without the factor
+ * of the element class. corners is overwritten, cross is a batch of n
+ * vectors for intermediate results. */
+static void
+t8_forest_volume_kernel (int dim, size_t n, double *corners, double *cross,
+                         double *volumes)
+{
+  double             *base = corners, *span_u = corners + 3 * n;
+  double             *span_v = corners + 6 * n, *span_w = corners + 9 * n;
+  size_t              i;
+
+  /* Subtract the base corners */
+  t8_vec_batch_axpy (n, base, span_u, -1);
+  t8_vec_batch_axpy (n, base, span_v, -1);
+  t8_vec_batch_cross (n, span_u, span_v, cross);
+  if (dim == 2) {
+    /* The area of the parallelogram is the norm of the cross product */
+    t8_vec_batch_norm (n, cross, volumes);
+    return;
+  }
+  T8_ASSERT (dim == 3);
+  t8_vec_batch_axpy (n, base, span_w, -1);
+  t8_vec_batch_dot (n, span_w, cross, volumes);
+  for (i = 0; i < n; i++) {
+    volumes[i] = fabs (volumes[i]);
+  }
+}
 
-      return t8_forest_element_tet_volume (coordinates);
-    }
-    break;
-  case T8_ECLASS_HEX:
-    {
-      /* We compute the volume as the determinant of the three vectors
-       * from corner 0 to 1, to 2, to 4 (in Z-order).
-       */
-      double              coordinates[4][3], cross[3];
-      int                 i;
-
-      /* Get the coordinates of the four corners */
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 0,
-                                    coordinates[0]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 1,
-                                    coordinates[1]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 2,
-                                    coordinates[2]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 4,
-                                    coordinates[3]);
-
-      /* Compute the difference of each corner with corner 0 */
-      for (i = 1; i < 4; i++) {
-        t8_vec_axpy (coordinates[0], coordinates[i], -1);
-      }
+/* Compute an element's volume */
+double
+t8_forest_element_volume (t8_forest_t forest, t8_locidx_t ltreeid,
+                          const t8_element_t * element,
+                          const double *vertices)
+{
+  t8_eclass_t         eclass;
+  double              corners[4 * 3 * 3], cross[3 * 3], volumes[3];
+  size_t              num_sets;
+  double              volume;
+  int                 iset;
 
-      /* Compute the cross product of the 2nd and 3rd */
-      t8_vec_cross (coordinates[2], coordinates[3], cross);
+  T8_ASSERT (t8_forest_is_committed (forest));
 
-      /* return |(a-d) * ((b-d)x(c-d))| */
-      return fabs (t8_vec_dot (coordinates[1], cross));
-    }
-  case T8_ECLASS_PRISM:
+  /* get the eclass of the forest */
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
 
+  switch (eclass) {
+  case T8_ECLASS_VERTEX:
+    /* vertices do not have any volume */
+    return 0;
+  case T8_ECLASS_LINE:
+    /* for line, the volume equals the diameter */
+    return t8_forest_element_diam (forest, ltreeid, element, vertices);
+  case T8_ECLASS_TRIANGLE:
+  case T8_ECLASS_QUAD:
+  case T8_ECLASS_TET:
+  case T8_ECLASS_HEX:
+  case T8_ECLASS_PRISM:
     {
-      /* We divide the prism into 3 tetrahdra and compute their
-       * volumes. */
-      double              coordinates[4][3], volume;
-
-      /* The first tetrahedron has prism vertices 0, 1, 2, and 4 */
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 0,
-                                    coordinates[0]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 1,
-                                    coordinates[1]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 2,
-                                    coordinates[2]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 4,
-                                    coordinates[3]);
-      volume = t8_forest_element_tet_volume (coordinates);
-
-      /* The second tetrahedron has prism vertices 0, 2, 3, and 4 */
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 0,
-                                    coordinates[0]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 2,
-                                    coordinates[1]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 3,
-                                    coordinates[2]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 4,
-                                    coordinates[3]);
-      volume += t8_forest_element_tet_volume (coordinates);
-
-      /* The third tetrahedron has prism vertices 2, 3, 4, and 5 */
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 2,
-                                    coordinates[0]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 3,
-                                    coordinates[1]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 4,
-                                    coordinates[2]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 5,
-                                    coordinates[3]);
-      volume += t8_forest_element_tet_volume (coordinates);
-
-      return volume;
+      /* We use the batch of the geometry cache for a single element */
+      num_sets = eclass == T8_ECLASS_PRISM ? 3 : 1;
+      (void) t8_forest_element_volume_corners (forest, ltreeid, element,
+                                               vertices, eclass, corners,
+                                               num_sets, 0);
+      t8_forest_volume_kernel (t8_eclass_to_dimension[eclass], num_sets,
+                               corners, cross, volumes);
+      volume = 0;
+      for (iset = 0; iset < (int) num_sets; iset++) {
+        volume += volumes[iset];
+      }
+      return t8_forest_volume_factor (eclass) * volume;
     }
   default:
     SC_ABORT_NOT_REACHED ();
@@ -800,6 +1023,67 @@ t8_forest_element_face_centroid (t8_forest_t forest, t8_locidx_t ltreeid,
   }
 }
 
+/* Store the corners 0, 1 and 2 of the triangle or quad face of an element
+ * and the centroid of the element at entry i of the four batches of size n
+ * in corners. */
+static void
+t8_forest_element_face_normal_corners (t8_forest_t forest,
+                                       t8_locidx_t ltreeid,
+                                       const t8_element_t * element,
+                                       int face, const double *tree_vertices,
+                                       const double centroid[3],
+                                       double *corners, size_t n, size_t i)
+{
+  t8_eclass_scheme_c *ts;
+  double              coordinates[3];
+  int                 icorner, corner;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  for (icorner = 0; icorner < 3; icorner++) {
+    /* Compute the coordinates of the icorner-th corner of the face */
+    corner = ts->t8_element_get_face_corner (element, face, icorner);
+    t8_forest_element_coordinate (forest, ltreeid, element, tree_vertices,
+                                  corner, coordinates);
+    t8_vec_batch_set (corners + 3 * n * icorner, n, i, coordinates);
+  }
+  t8_vec_batch_set (corners + 9 * n, n, i, centroid);
+}
+
+/* Compute the outward unit normals of the n faces whose corners were stored
+ * by t8_forest_element_face_normal_corners in the batch normals.
+ * We construct the normal as the cross product of two spanning vectors of
+ * the triangle of the corners 0, 1 and 2, which approximates a quad face.
+ * If the normal points to the centroid of the element, we reverse it.
+ * corners is overwritten, scratch holds 2 n doubles. */
+static void
+t8_forest_face_normal_kernel (size_t n, double *corners, double *scratch,
+                              double *normals)
+{
+  double             *base = corners, *span_u = corners + 3 * n;
+  double             *span_v = corners + 6 * n, *center = corners + 9 * n;
+  double             *norms = scratch, *c_n = scratch + n;
+  double              factor;
+  size_t              i;
+
+  /* Subtract corner 0 from the other two and the center */
+  t8_vec_batch_axpy (n, base, span_u, -1);
+  t8_vec_batch_axpy (n, base, span_v, -1);
+  t8_vec_batch_axpy (n, base, center, -1);
+  t8_vec_batch_cross (n, span_u, span_v, normals);
+  t8_vec_batch_norm (n, normals, norms);
+  t8_vec_batch_dot (n, center, normals, c_n);
+  for (i = 0; i < n; i++) {
+    T8_ASSERT (norms[i] != 0);
+    /* if c_n is positive, the normal points inwards and we reverse it */
+    factor = c_n[i] > 0 ? -1. / norms[i] : 1. / norms[i];
+    normals[i] *= factor;
+    normals[n + i] *= factor;
+    normals[2 * n + i] *= factor;
+  }
+}
+
 void
 t8_forest_element_face_normal (t8_forest_t forest, t8_locidx_t ltreeid,
                                const t8_element_t * element, int face,
@@ -896,42 +1180,16 @@ t8_forest_element_face_normal (t8_forest_t forest, t8_locidx_t ltreeid,
      */
   case T8_ECLASS_TRIANGLE:
     {
-      /* We construct the normal as the cross product of two spanning
-       * vectors for the triangle*/
-      int                 corner, i;
-      double              corner_vertices[3][3], center[3];
-      double              norm, c_n;
+      double              corners[4 * 3], center[3], scratch[2];
 
-      for (i = 0; i < 3; i++) {
-        /* Compute the i-th corner */
-        corner = ts->t8_element_get_face_corner (element, face, i);
-        /* Compute the coordinates of this corner */
-        t8_forest_element_coordinate (forest, ltreeid, element,
-                                      tree_vertices, corner,
-                                      corner_vertices[i]);
-      }
-      /* Subtract vertex 0 from the other two */
-      t8_vec_axpy (corner_vertices[0], corner_vertices[1], -1);
-      t8_vec_axpy (corner_vertices[0], corner_vertices[2], -1);
-
-      /* Compute the cross product of the two,
-       * and the norm of the cross product */
-      t8_vec_cross (corner_vertices[1], corner_vertices[2], normal);
-      norm = t8_vec_norm (normal);
-      T8_ASSERT (norm != 0);
       /* Compute the coordinates of the center of the element */
       t8_forest_element_centroid (forest, ltreeid, element, tree_vertices,
                                   center);
-      /* Compute center = center - vertex_0 */
-      t8_vec_axpy (corner_vertices[0], center, -1);
-      /* Compute the dot-product of normal and center */
-      c_n = t8_vec_dot (center, normal);
-      /* if c_n is positiv, the computed normal points inwards, so we have to reverse it */
-      if (c_n > 0) {
-        norm = -norm;
-      }
-      /* Divide normal by norm to normalize it */
-      t8_vec_ax (normal, 1. / norm);
+      /* We use the batch of the geometry cache for a single face */
+      t8_forest_element_face_normal_corners (forest, ltreeid, element, face,
+                                             tree_vertices, center, corners,
+                                             1, 0);
+      t8_forest_face_normal_kernel (1, corners, scratch, normal);
     }
     break;
   default:
@@ -939,6 +1197,274 @@ t8_forest_element_face_normal (t8_forest_t forest, t8_locidx_t ltreeid,
   }
 }
 
+/* The area of the triangle with corners a, b and c, computed as in
+ * t8_forest_element_triangle_area */
+static double
+t8_forest_triangle_area (const double a[3], const double b[3],
+                         const double c[3])
+{
+  double              coordinates[3][3];
+
+  t8_vec_axb (a, coordinates[0], 1, 0);
+  t8_vec_axb (b, coordinates[1], 1, 0);
+  t8_vec_axb (c, coordinates[2], 1, 0);
+  return t8_forest_element_triangle_area (coordinates);
+}
+
+void
+t8_forest_tree_leaf_face_geometry (t8_forest_t forest, t8_locidx_t ltree_id,
+                                   double *areas, double *centroids,
+                                   double *normals)
+{
+  t8_element_array_t *leafs;
+  t8_eclass_scheme_c *ts;
+  t8_eclass_t         eclass, face_class;
+  const t8_element_t *element;
+  t8_locidx_t         num_leafs, first, num_batch, ibatch;
+  double             *corners, *cx, *cy, *cz;
+  double              points[4][3], center[3], face_center[3];
+  double              normal[3], centroid[3], area, norm, v_v, c_v;
+  size_t              num_entries, entry, index;
+  int                 num_corners, num_faces, num_face_corners;
+  int                 iface, icorner, i;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  leafs = t8_forest_tree_get_leafs (forest, ltree_id);
+  num_leafs = t8_element_array_get_count (leafs);
+  eclass = t8_forest_get_tree_class (forest, ltree_id);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  T8_ASSERT (normals == NULL || t8_eclass_to_dimension[eclass] >= 2);
+  num_corners = t8_eclass_num_vertices[eclass];
+  num_faces = t8_eclass_num_faces[eclass];
+  num_entries = (size_t) num_leafs * num_faces;
+
+  /* The corners of a batch of leafs are computed once and shared by
+   * all faces of the leafs */
+  corners = T8_ALLOC (double, 3 * num_corners * T8_FOREST_GEOMETRY_BATCH);
+  cx = corners;
+  cy = corners + num_corners * T8_FOREST_GEOMETRY_BATCH;
+  cz = corners + 2 * num_corners * T8_FOREST_GEOMETRY_BATCH;
+  for (first = 0; first < num_leafs; first += num_batch) {
+    num_batch = SC_MIN (T8_FOREST_GEOMETRY_BATCH, num_leafs - first);
+    t8_forest_leaf_range_corner_coordinates (forest, ltree_id, leafs, first,
+                                             num_batch, cx, cy, cz);
+    for (ibatch = 0; ibatch < num_batch; ibatch++) {
+      element = t8_element_array_index_locidx (leafs, first + ibatch);
+      index = (size_t) ibatch * num_corners;
+      if (normals != NULL) {
+        /* The centroid of the element orients the normals */
+        center[0] = center[1] = center[2] = 0;
+        for (icorner = 0; icorner < num_corners; icorner++) {
+          center[0] += cx[index + icorner];
+          center[1] += cy[index + icorner];
+          center[2] += cz[index + icorner];
+        }
+        t8_vec_ax (center, 1. / num_corners);
+      }
+      for (iface = 0; iface < num_faces; iface++) {
+        entry = (size_t) (first + ibatch) * num_faces + iface;
+        face_class = ts->t8_element_face_class (element, iface);
+        num_face_corners = t8_eclass_num_vertices[face_class];
+        centroid[0] = centroid[1] = centroid[2] = 0;
+        for (icorner = 0; icorner < num_face_corners; icorner++) {
+          i = ts->t8_element_get_face_corner (element, iface, icorner);
+          points[icorner][0] = cx[index + i];
+          points[icorner][1] = cy[index + i];
+          points[icorner][2] = cz[index + i];
+          t8_vec_axpy (points[icorner], centroid, 1);
+        }
+        t8_vec_ax (centroid, 1. / num_face_corners);
+        switch (num_face_corners) {
+        case 1:
+          area = 0;
+          break;
+        case 2:
+          area = t8_vec_dist (points[0], points[1]);
+          break;
+        default:
+          /* A quad face is split into the triangles 0, 1, 2 and 1, 2, 3 */
+          area = t8_forest_triangle_area (points[0], points[1], points[2]);
+          if (num_face_corners == 4) {
+            area += t8_forest_triangle_area (points[1], points[2],
+                                             points[3]);
+          }
+        }
+        if (areas != NULL) {
+          areas[entry] = area;
+        }
+        if (centroids != NULL) {
+          t8_vec_batch_set (centroids, num_entries, entry, centroid);
+        }
+        if (normals == NULL) {
+          continue;
+        }
+        /* The normal as in t8_forest_element_face_normal, with the element
+         * center relative to corner 0 of the face in face_center */
+        t8_vec_axpyz (points[0], center, face_center, -1);
+        t8_vec_axpy (points[0], points[1], -1);
+        if (num_face_corners == 2) {
+          /* The part of the center perpendicular to the line */
+          v_v = t8_vec_dot (points[1], points[1]);
+          c_v = t8_vec_dot (face_center, points[1]);
+          t8_vec_axpyz (points[1], face_center, normal, -c_v / v_v);
+        }
+        else {
+          /* The normal of the triangle of the corners 0, 1 and 2 */
+          t8_vec_axpy (points[0], points[2], -1);
+          t8_vec_cross (points[1], points[2], normal);
+        }
+        norm = t8_vec_norm (normal);
+        T8_ASSERT (norm != 0);
+        /* If the normal points to the center, we reverse it */
+        if (t8_vec_dot (face_center, normal) > 0) {
+          norm *= -1;
+        }
+        t8_vec_ax (normal, 1. / norm);
+        t8_vec_batch_set (normals, num_entries, entry, normal);
+      }
+    }
+  }
+  T8_FREE (corners);
+}
+
+/* For each element class and reference direction the two vertices of the
+ * reference element whose difference is the unit vector of this direction */
+static const int    t8_forest_quadrature_axes[T8_ECLASS_COUNT][3][2] = {
+  {{0, 0}, {0, 0}, {0, 0}},     /* vertex */
+  {{0, 1}, {0, 0}, {0, 0}},     /* line */
+  {{0, 1}, {0, 2}, {0, 0}},     /* quad */
+  {{0, 1}, {1, 2}, {0, 0}},     /* triangle */
+  {{0, 1}, {0, 2}, {0, 4}},     /* hex */
+  {{0, 1}, {2, 3}, {1, 2}},     /* tet */
+  {{0, 1}, {1, 2}, {0, 3}},     /* prism */
+  {{0, 0}, {0, 0}, {0, 0}}      /* pyramid, not supported */
+};
+
+void
+t8_forest_tree_leaf_quadrature (t8_forest_t forest, t8_locidx_t ltree_id,
+                                t8_locidx_t first, t8_locidx_t num_leafs,
+                                const t8_quadrature_t * quad,
+                                double *points, double *weights)
+{
+  t8_element_array_t *leafs;
+  t8_eclass_scheme_c *ts;
+  t8_eclass_t         eclass;
+  const t8_forest_tree_map_t *map;
+  const double       *qu, *qv, *qw;
+  double              len, origin[3], A[3][3], J[3][3], JA[3][3];
+  double              ref[3], x[3], measure = 1, cross[3];
+  int                *corner_coords;
+  const int          *from, *to;
+  t8_locidx_t         ileaf, ibatch, num_batch;
+  int                 icorner, num_corners, dim, iq, num_points, i, j, k;
+  size_t              num_entries, entry;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  eclass = t8_forest_get_tree_class (forest, ltree_id);
+  T8_ASSERT (quad != NULL && quad->eclass == eclass);
+  leafs = t8_forest_tree_get_leafs (forest, ltree_id);
+  T8_ASSERT (0 <= first && first + num_leafs
+             <= (t8_locidx_t) t8_element_array_get_count (leafs));
+  if (num_leafs == 0) {
+    return;
+  }
+  map = t8_forest_get_tree_map (forest, ltree_id);
+  SC_CHECK_ABORT (map != NULL, "Quadrature needs the vertices of the tree "
+                  "and is not supported for pyramids.\n");
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  dim = t8_eclass_to_dimension[eclass];
+  num_corners = t8_eclass_num_vertices[eclass];
+  num_points = quad->num_points;
+  num_entries = (size_t) num_leafs * num_points;
+  qu = quad->points;
+  qv = qu + num_points;
+  qw = qv + num_points;
+  len = 1. / ts->t8_element_root_len (t8_element_array_index_locidx (leafs,
+                                                                     first));
+
+  /* We compute the corners of T8_FOREST_GEOMETRY_BATCH leafs at once */
+  corner_coords = T8_ALLOC (int, (size_t) num_corners * T8_ECLASS_MAX_DIM
+                            * T8_FOREST_GEOMETRY_BATCH);
+  for (ibatch = 0; ibatch < num_leafs; ibatch += num_batch) {
+    num_batch = SC_MIN (T8_FOREST_GEOMETRY_BATCH, num_leafs - ibatch);
+    for (icorner = 0; icorner < num_corners; icorner++) {
+      ts->t8_element_vertex_coords_array (t8_element_array_index_locidx
+                                          (leafs, first + ibatch),
+                                          num_batch, icorner,
+                                          corner_coords + (size_t) icorner *
+                                          T8_ECLASS_MAX_DIM *
+                                          T8_FOREST_GEOMETRY_BATCH);
+    }
+    for (ileaf = 0; ileaf < num_batch; ileaf++) {
+      /* The leaf is the image of the reference element under the affine
+       * map origin + A r in the reference coordinates of the tree */
+      for (j = 0; j < 3; j++) {
+        origin[j] = j < dim ? len * corner_coords[T8_ECLASS_MAX_DIM * ileaf
+                                                  + j] : 0;
+        for (k = 0; k < 3; k++) {
+          from = corner_coords + (size_t) T8_ECLASS_MAX_DIM
+            * (t8_forest_quadrature_axes[eclass][k][0]
+               * T8_FOREST_GEOMETRY_BATCH + ileaf);
+          to = corner_coords + (size_t) T8_ECLASS_MAX_DIM
+            * (t8_forest_quadrature_axes[eclass][k][1]
+               * T8_FOREST_GEOMETRY_BATCH + ileaf);
+          A[j][k] = j < dim && k < dim ? len * (to[j] - from[j]) : 0;
+        }
+      }
+      for (iq = 0; iq < num_points; iq++) {
+        for (j = 0; j < 3; j++) {
+          ref[j] = origin[j] + A[j][0] * qu[iq] + A[j][1] * qv[iq]
+            + A[j][2] * qw[iq];
+        }
+        entry = (size_t) (ibatch + ileaf) * num_points + iq;
+        if (points != NULL) {
+          t8_forest_tree_map_evaluate (map, ref, x);
+          t8_vec_batch_set (points, num_entries, entry, x);
+        }
+        if (weights == NULL) {
+          continue;
+        }
+        if (iq == 0 || !map->affine) {
+          /* The volume factor of the Jacobian of the composed map, which
+           * is constant in the leaf if the tree map is affine */
+          t8_forest_tree_map_jacobian (map, ref, J);
+          for (i = 0; i < 3; i++) {
+            for (k = 0; k < 3; k++) {
+              JA[i][k] = J[i][0] * A[0][k] + J[i][1] * A[1][k]
+                + J[i][2] * A[2][k];
+            }
+          }
+          switch (dim) {
+          case 0:
+            measure = 1;
+            break;
+          case 1:
+            measure = sqrt (JA[0][0] * JA[0][0] + JA[1][0] * JA[1][0]
+                            + JA[2][0] * JA[2][0]);
+            break;
+          case 2:
+            cross[0] = JA[1][0] * JA[2][1] - JA[2][0] * JA[1][1];
+            cross[1] = JA[2][0] * JA[0][1] - JA[0][0] * JA[2][1];
+            cross[2] = JA[0][0] * JA[1][1] - JA[1][0] * JA[0][1];
+            measure = t8_vec_norm (cross);
+            break;
+          default:
+            measure = fabs (JA[0][0] * (JA[1][1] * JA[2][2]
+                                        - JA[2][1] * JA[1][2])
+                            - JA[0][1] * (JA[1][0] * JA[2][2]
+                                          - JA[2][0] * JA[1][2])
+                            + JA[0][2] * (JA[1][0] * JA[2][1]
+                                          - JA[2][0] * JA[1][1]));
+          }
+        }
+        weights[entry] = quad->weights[iq] * measure;
+      }
+    }
+  }
+  T8_FREE (corner_coords);
+}
+
 /* For each tree in a forest compute its first and last descendant */
 void
 t8_forest_compute_desc (t8_forest_t forest)
@@ -953,9 +1479,27 @@ t8_forest_compute_desc (t8_forest_t forest)
   num_trees = t8_forest_get_num_local_trees (forest);
   for (itree_id = 0; itree_id < num_trees; itree_id++) {
     /* get a pointer to the tree */
-    itree = t8_forest_get_tree (forest, itree_id);
+    itree = t8_forest_get_tree_lazy (forest, itree_id);
     /* get the eclass scheme associated to tree */
     ts = forest->scheme_cxx->eclass_schemes[itree->eclass];
+    if (itree->implicit_level >= 0) {
+      /* We compute the first and last element from their ids */
+      T8_ASSERT (itree->implicit_count > 0);
+      ts->t8_element_new (1, &element);
+      ts->t8_element_set_linear_id (element, itree->implicit_level,
+                                    itree->implicit_first);
+      ts->t8_element_new (1, &itree->first_desc);
+      ts->t8_element_first_descendant (element, itree->first_desc,
+                                       forest->maxlevel);
+      ts->t8_element_set_linear_id (element, itree->implicit_level,
+                                    itree->implicit_first
+                                    + itree->implicit_count - 1);
+      ts->t8_element_new (1, &itree->last_desc);
+      ts->t8_element_last_descendant (element, itree->last_desc,
+                                      forest->maxlevel);
+      ts->t8_element_destroy (1, &element);
+      continue;
+    }
     /* get a pointer to the first element of itree */
     element = t8_element_array_index_locidx (&itree->elements, 0);
     /* get memory for the trees first descendant */
@@ -975,33 +1519,303 @@ t8_forest_compute_desc (t8_forest_t forest)
   }
 }
 
-/* Create the elements on this process given a uniform partition
- * of the coarse mesh. */
-void
-t8_forest_populate (t8_forest_t forest)
+/* The number of bytes that the elements of a tree use in the arena.
+ * We round up, such that the elements of each tree are aligned. */
+#define T8_FOREST_ARENA_BYTES(n,size) \
+  ((((size_t) (n) * (size)) + 15) / 16 * 16)
+
+/* Allocate the arena for the given numbers of elements per tree and
+ * set the element arrays of the trees as views into it.
+ * Trees with a negative number are left unchanged.
+ * If init is true, the elements are initialized. */
+static void
+t8_forest_trees_arena (t8_forest_t forest,
+                       const t8_locidx_t *num_tree_elements, int init)
 {
-  t8_gloidx_t         child_in_tree_begin;
+  t8_locidx_t         itree, num_trees;
+  t8_tree_t           tree;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *first;
+  t8_forest_arena_t  *arena;
+  size_t              offset;
+
+  T8_ASSERT (forest->trees != NULL);
+
+  num_trees = (t8_locidx_t) forest->trees->elem_count;
+  offset = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    if (num_tree_elements[itree] < 0) {
+      continue;
+    }
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+    offset += T8_FOREST_ARENA_BYTES (num_tree_elements[itree],
+                                     ts->t8_element_size ());
+  }
+  arena = NULL;
+  if (offset > 0) {
+    arena = T8_ALLOC (t8_forest_arena_t, 1);
+    t8_refcount_init (&arena->rc);
+    if (forest->element_arena == NULL) {
+      forest->element_arena = arena;
+    }
+    else {
+      /* Adapt allocated the arena of the forest already and commit packs
+       * the trees that it copied from a forest without arena. The forest
+       * holds the only reference to the second arena. */
+      if (forest->shared_arenas == NULL) {
+        forest->shared_arenas = sc_array_new (sizeof (t8_forest_arena_t *));
+      }
+      *(t8_forest_arena_t **) sc_array_push (forest->shared_arenas) = arena;
+    }
+    arena->size = offset;
+    /* The arena may be large and live long, so it is allocated according
+     * to the allocation policy of t8_init_ext */
+    arena->data = (char *) t8_alloc_large (offset);
+  }
+
+  offset = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    if (num_tree_elements[itree] < 0) {
+      continue;
+    }
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+    if (num_tree_elements[itree] == 0) {
+      t8_element_array_init (&tree->elements, ts);
+      continue;
+    }
+    first = (t8_element_t *) (arena->data + offset);
+    t8_element_array_init_data (&tree->elements, first, ts,
+                                num_tree_elements[itree]);
+    if (init) {
+      ts->t8_element_init (num_tree_elements[itree], first, 0);
+    }
+    offset += T8_FOREST_ARENA_BYTES (num_tree_elements[itree],
+                                     ts->t8_element_size ());
+  }
+  T8_ASSERT (arena == NULL || offset == arena->size);
+}
+
+/* Decrease the reference count of an arena and free it if it reaches
+ * zero. */
+static void
+t8_forest_arena_unref (t8_forest_arena_t ** parena)
+{
+  t8_forest_arena_t  *arena;
+
+  T8_ASSERT (parena != NULL && *parena != NULL);
+  arena = *parena;
+  if (t8_refcount_unref (&arena->rc)) {
+    t8_free_large (arena->data, arena->size);
+    T8_FREE (arena);
+  }
+  *parena = NULL;
+}
+
+void
+t8_forest_trees_alloc_arena (t8_forest_t forest,
+                             const t8_locidx_t *num_tree_elements)
+{
+  t8_forest_trees_arena (forest, num_tree_elements, 1);
+}
+
+void
+t8_forest_trees_pack (t8_forest_t forest)
+{
+  t8_locidx_t         itree, num_trees;
+  t8_locidx_t        *num_tree_elements;
+  t8_element_array_t *old_elements;
+  t8_tree_t           tree;
+  t8_locidx_t         num_elements;
+
+  T8_ASSERT (forest->trees != NULL);
+  num_trees = (t8_locidx_t) forest->trees->elem_count;
+  if (num_trees == 0) {
+    return;
+  }
+  num_tree_elements = T8_ALLOC (t8_locidx_t, num_trees);
+  old_elements = T8_ALLOC (t8_element_array_t, num_trees);
+  num_elements = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    old_elements[itree] = tree->elements;
+    num_tree_elements[itree] = -1;
+    if (SC_ARRAY_IS_OWNER (&tree->elements.array)) {
+      /* Only trees that own their elements are moved. The others are
+       * stored in an arena already. */
+      num_tree_elements[itree] =
+        (t8_locidx_t) t8_element_array_get_count (&tree->elements);
+      num_elements += num_tree_elements[itree];
+    }
+  }
+  if (num_elements > 0) {
+    /* The elements are copied, so we do not initialize them */
+    t8_forest_trees_arena (forest, num_tree_elements, 0);
+    for (itree = 0; itree < num_trees; itree++) {
+      if (num_tree_elements[itree] < 0) {
+        continue;
+      }
+      tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+      if (num_tree_elements[itree] > 0) {
+        memcpy (t8_element_array_get_data (&tree->elements),
+                t8_element_array_get_data (&old_elements[itree]),
+                num_tree_elements[itree]
+                * t8_element_array_get_size (&tree->elements));
+      }
+      t8_element_array_reset (&old_elements[itree]);
+    }
+  }
+  T8_FREE (num_tree_elements);
+  T8_FREE (old_elements);
+}
+
+void
+t8_forest_trees_trim (t8_forest_t forest)
+{
+  t8_locidx_t         itree, num_trees;
+  t8_tree_t           tree;
+
+  T8_ASSERT (forest->trees != NULL);
+  num_trees = (t8_locidx_t) forest->trees->elem_count;
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    /* Views into arenas are not changed */
+    t8_element_array_shrink_to_fit (&tree->elements);
+  }
+}
+
+/* Return the arena of a forest that stores the given element data */
+static t8_forest_arena_t *
+t8_forest_find_arena (t8_forest_t forest, const t8_element_t * data)
+{
+  t8_forest_arena_t  *arena;
+  size_t              iarena;
+
+  arena = forest->element_arena;
+  if (arena != NULL && (const char *) data >= arena->data
+      && (const char *) data < arena->data + arena->size) {
+    return arena;
+  }
+  if (forest->shared_arenas != NULL) {
+    for (iarena = 0; iarena < forest->shared_arenas->elem_count; iarena++) {
+      arena = *(t8_forest_arena_t **)
+        sc_array_index (forest->shared_arenas, iarena);
+      if ((const char *) data >= arena->data
+          && (const char *) data < arena->data + arena->size) {
+        return arena;
+      }
+    }
+  }
+  return NULL;
+}
+
+void
+t8_forest_tree_share (t8_forest_t forest, t8_locidx_t ltree_id,
+                      t8_forest_t from, t8_locidx_t from_ltree_id)
+{
+  t8_tree_t           tree, fromtree;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *data;
+  t8_forest_arena_t  *arena;
+  size_t              num_elements, iarena;
+
+  T8_ASSERT (t8_forest_is_committed (from));
+  tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, ltree_id);
+  fromtree = (t8_tree_t) t8_sc_array_index_locidx (from->trees,
+                                                   from_ltree_id);
+  T8_ASSERT (tree->eclass == fromtree->eclass);
+  ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+  tree->implicit_level = fromtree->implicit_level;
+  tree->implicit_first = fromtree->implicit_first;
+  tree->implicit_count = fromtree->implicit_count;
+  num_elements = t8_element_array_get_count (&fromtree->elements);
+  if (num_elements == 0 || fromtree->implicit_level >= 0) {
+    /* An implicit tree stays implicit, even if from created its elements */
+    t8_element_array_init (&tree->elements, ts);
+    return;
+  }
+  data = t8_element_array_get_data (&fromtree->elements);
+  arena = t8_forest_find_arena (from, data);
+  if (arena == NULL) {
+    /* The tree of from owns its elements, since from trimmed its trees or
+     * is a link of a commit chain. Its memory may be freed with from, so
+     * we copy the elements. */
+    T8_ASSERT (SC_ARRAY_IS_OWNER (&fromtree->elements.array));
+    t8_element_array_init_copy (&tree->elements, ts, data, num_elements);
+    return;
+  }
+  t8_element_array_init_data (&tree->elements, data, ts, num_elements);
+  /* Keep the arena alive as long as this forest exists */
+  if (arena != forest->element_arena) {
+    if (forest->shared_arenas == NULL) {
+      forest->shared_arenas = sc_array_new (sizeof (t8_forest_arena_t *));
+    }
+    for (iarena = 0; iarena < forest->shared_arenas->elem_count; iarena++) {
+      if (*(t8_forest_arena_t **)
+          sc_array_index (forest->shared_arenas, iarena) == arena) {
+        /* We already use this arena */
+        return;
+      }
+    }
+    t8_refcount_ref (&arena->rc);
+    *(t8_forest_arena_t **) sc_array_push (forest->shared_arenas) = arena;
+  }
+}
+
+void
+t8_forest_trees_release_arenas (t8_forest_t forest)
+{
+  size_t              iarena;
+
+  if (forest->element_arena != NULL) {
+    t8_forest_arena_unref (&forest->element_arena);
+  }
+  if (forest->shared_arenas != NULL) {
+    for (iarena = 0; iarena < forest->shared_arenas->elem_count; iarena++) {
+      t8_forest_arena_unref ((t8_forest_arena_t **)
+                             sc_array_index (forest->shared_arenas, iarena));
+    }
+    sc_array_destroy (forest->shared_arenas);
+    forest->shared_arenas = NULL;
+  }
+}
+
+/* Create the elements on this process given a uniform partition
+ * of the coarse mesh. */
+void
+t8_forest_populate (t8_forest_t forest)
+{
+  t8_gloidx_t         child_in_tree_begin;
   t8_gloidx_t         child_in_tree_end;
   t8_locidx_t         count_elements;
   t8_locidx_t         num_tree_elements;
   t8_locidx_t         num_local_trees;
+  t8_locidx_t        *tree_num_elements;
   t8_gloidx_t         jt, first_ctree;
-  t8_gloidx_t         start, end, et;
+  t8_gloidx_t         start, end;
   t8_tree_t           tree;
-  t8_element_t       *element, *element_succ;
   t8_element_array_t *telements;
   t8_eclass_t         tree_class;
   t8_eclass_scheme_c *eclass_scheme;
   t8_gloidx_t         cmesh_first_tree, cmesh_last_tree;
+  t8_eclass_t         kernel_eclass;
   int                 is_empty;
 
   SC_CHECK_ABORT (forest->set_level <= forest->maxlevel,
                   "Given refinement level exceeds the maximum.\n");
+  kernel_eclass = t8_forest_get_kernel_eclass (forest);
+  if (forest->profile != NULL) {
+    forest->profile->specialized_kernels = kernel_eclass != T8_ECLASS_COUNT;
+  }
   /* TODO: create trees and quadrants according to uniform refinement */
-  t8_cmesh_uniform_bounds (forest->cmesh, forest->set_level,
-                           &forest->first_local_tree,
-                           &child_in_tree_begin, &forest->last_local_tree,
-                           &child_in_tree_end, NULL);
+  t8_cmesh_uniform_bounds_costs (forest->cmesh, forest->set_level,
+                                 t8_cmesh_get_partition_eclass_costs
+                                 (forest->cmesh), forest->mpicomm,
+                                 &forest->first_local_tree,
+                                 &child_in_tree_begin,
+                                 &forest->last_local_tree,
+                                 &child_in_tree_end, NULL);
 
   /* True if the forest has no elements */
   is_empty = forest->first_local_tree > forest->last_local_tree
@@ -1035,13 +1849,35 @@ t8_forest_populate (t8_forest_t forest)
     forest->trees =
       sc_array_new_count (sizeof (t8_tree_struct_t), num_local_trees);
     first_ctree = t8_cmesh_get_first_treeid (forest->cmesh);
-    for (jt = forest->first_local_tree, count_elements = 0;
-         jt <= forest->last_local_tree; jt++) {
+    tree_num_elements = T8_ALLOC (t8_locidx_t, num_local_trees);
+    /* Count the elements of each tree, such that we can allocate the
+     * elements of all trees at once */
+    for (jt = forest->first_local_tree; jt <= forest->last_local_tree; jt++) {
       tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees,
                                                    jt -
                                                    forest->first_local_tree);
       tree_class = tree->eclass =
         t8_cmesh_get_tree_class (forest->cmesh, jt - first_ctree);
+      start = (jt == forest->first_local_tree) ? child_in_tree_begin : 0;
+      end = (jt == forest->last_local_tree) ? child_in_tree_end :
+        t8_eclass_count_leaf (tree_class, forest->set_level);
+      tree_num_elements[jt - forest->first_local_tree] =
+        (t8_locidx_t) (end - start);
+    }
+    if (forest->set_implicit_uniform) {
+      /* The trees do not store their elements, so we need no arena */
+      for (jt = 0; jt < num_local_trees; jt++) {
+        tree_num_elements[jt] = 0;
+      }
+    }
+    t8_forest_trees_alloc_arena (forest, tree_num_elements);
+    T8_FREE (tree_num_elements);
+    for (jt = forest->first_local_tree, count_elements = 0;
+         jt <= forest->last_local_tree; jt++) {
+      tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees,
+                                                   jt -
+                                                   forest->first_local_tree);
+      tree_class = tree->eclass;
       tree->elements_offset = count_elements;
       eclass_scheme = forest->scheme_cxx->eclass_schemes[tree_class];
       T8_ASSERT (eclass_scheme != NULL);
@@ -1052,20 +1888,21 @@ t8_forest_populate (t8_forest_t forest)
         t8_eclass_count_leaf (tree_class, forest->set_level);
       num_tree_elements = end - start;
       T8_ASSERT (num_tree_elements > 0);
-      /* Allocate elements for this processor. */
-      t8_element_array_init_size (telements, eclass_scheme,
-                                  num_tree_elements);
-      element = t8_element_array_index_locidx (telements, 0);
-      eclass_scheme->t8_element_set_linear_id (element, forest->set_level,
-                                               start);
-      count_elements++;
-      for (et = start + 1; et < end; et++, count_elements++) {
-        element_succ = t8_element_array_index_locidx (telements, et - start);
-        eclass_scheme->t8_element_successor (element, element_succ,
-                                             forest->set_level);
-        /* TODO: process elements here */
-        element = element_succ;
+      tree->implicit_level = -1;
+      if (forest->set_implicit_uniform) {
+        /* We only store the range of the elements */
+        tree->implicit_level = forest->set_level;
+        tree->implicit_first = start;
+        tree->implicit_count = num_tree_elements;
+        count_elements += num_tree_elements;
+        continue;
       }
+      T8_ASSERT ((t8_locidx_t) t8_element_array_get_count (telements)
+                 == num_tree_elements);
+      /* Create the elements */
+      t8_forest_kernel_populate (kernel_eclass, eclass_scheme, telements,
+                                 forest->set_level, start, end);
+      count_elements += num_tree_elements;
     }
   }
   forest->local_num_elements = count_elements;
@@ -1076,6 +1913,223 @@ t8_forest_populate (t8_forest_t forest)
   /* TODO: figure out global_first_position, global_first_quadrant without comm */
 }
 
+/* The range of the leaves of a process that is needed to check that the
+ * leaves of all processes form a partition of the forest */
+typedef struct
+{
+  t8_gloidx_t         num_trees;        /* 0 if the process has no leaves */
+  t8_gloidx_t         first_tree;       /* The global id of the first tree */
+  t8_gloidx_t         last_tree;        /* The global id of the last tree */
+  t8_gloidx_t         first_id;         /* The maximum level linear id of the
+                                           first descendant of the first leaf */
+  t8_gloidx_t         last_id;          /* The maximum level linear id of the
+                                           last descendant of the last leaf */
+  t8_gloidx_t         last_is_end;      /* True if the last leaf ends a tree */
+} t8_forest_leaves_range_t;
+
+/* Check whether the leaf ranges of all processes form a partition of
+ * the global trees */
+static int
+t8_forest_leaves_ranges_valid (const t8_forest_leaves_range_t * ranges,
+                               int mpisize, t8_gloidx_t global_num_trees)
+{
+  const t8_forest_leaves_range_t *prev = NULL, *range;
+  int                 iproc;
+
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    range = ranges + iproc;
+    if (range->num_trees == 0) {
+      continue;
+    }
+    if (prev == NULL) {
+      /* The first process with leaves starts the first tree */
+      if (range->first_tree != 0 || range->first_id != 0) {
+        return 0;
+      }
+    }
+    else if (prev->last_tree == range->first_tree) {
+      /* The tree is shared and continues without gap or overlap */
+      if (prev->last_is_end || range->first_id != prev->last_id + 1) {
+        return 0;
+      }
+    }
+    else if (range->first_tree != prev->last_tree + 1 || !prev->last_is_end
+             || range->first_id != 0) {
+      return 0;
+    }
+    prev = range;
+  }
+  if (prev == NULL) {
+    return global_num_trees == 0;
+  }
+  return prev->last_tree == global_num_trees - 1 && prev->last_is_end;
+}
+
+void
+t8_forest_populate_leaves (t8_forest_t forest)
+{
+  t8_forest_leaves_range_t range, *ranges;
+  t8_locidx_t         itree, num_trees, ileaf, num_leaves, count_elements;
+  t8_locidx_t         num_cmesh_trees;
+  t8_gloidx_t         cmesh_first_tree, global_num_trees;
+  t8_linearidx_t      first_id, last_id, prev_last_id, end_id;
+  t8_tree_t           tree;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *element, *desc;
+  const int          *levels;
+  const t8_linearidx_t *linear_ids;
+  int                 level, maxlevel, mpiret, ok;
+
+  T8_ASSERT (forest->set_leaves);
+  T8_ASSERT (forest->cmesh != NULL && forest->scheme_cxx != NULL);
+
+  num_trees = forest->set_leaves_num_trees;
+  cmesh_first_tree = t8_cmesh_get_first_treeid (forest->cmesh);
+  num_cmesh_trees = t8_cmesh_get_num_local_trees (forest->cmesh);
+  global_num_trees = t8_cmesh_get_num_trees (forest->cmesh);
+  SC_CHECK_ABORT (num_trees == 0
+                  || (forest->set_leaves_first_tree >= cmesh_first_tree
+                      && forest->set_leaves_first_tree + num_trees
+                      <= cmesh_first_tree + num_cmesh_trees),
+                  "cmesh partition does not match the given leaves");
+
+  /* Create the trees and allocate the elements of all trees at once */
+  forest->trees = sc_array_new_count (sizeof (t8_tree_struct_t), num_trees);
+  forest->first_local_tree = forest->set_leaves_first_tree;
+  forest->last_local_tree = forest->set_leaves_first_tree + num_trees - 1;
+  for (itree = 0; itree < num_trees; itree++) {
+    SC_CHECK_ABORT (forest->set_leaves_tree_num[itree] > 0,
+                    "Each given tree must have at least one leaf");
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    tree->eclass = t8_cmesh_get_tree_class (forest->cmesh,
+                                            (t8_locidx_t)
+                                            (forest->first_local_tree -
+                                             cmesh_first_tree + itree));
+    tree->implicit_level = -1;
+  }
+  if (num_trees > 0) {
+    t8_forest_trees_alloc_arena (forest, forest->set_leaves_tree_num);
+  }
+
+  /* Set the elements from their linear ids and check that the leaves of
+   * each tree follow each other along the space filling curve */
+  memset (&range, 0, sizeof (range));
+  range.num_trees = num_trees;
+  range.first_tree = forest->first_local_tree;
+  range.last_tree = forest->last_local_tree;
+  levels = forest->set_leaves_levels;
+  linear_ids = forest->set_leaves_linear_ids;
+  count_elements = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    tree->elements_offset = count_elements;
+    ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+    T8_ASSERT (ts != NULL);
+    maxlevel = ts->t8_element_maxlevel ();
+    end_id = t8_eclass_count_leaf (tree->eclass, maxlevel);
+    ts->t8_element_new (1, &desc);
+    num_leaves = forest->set_leaves_tree_num[itree];
+    prev_last_id = 0;
+    for (ileaf = 0; ileaf < num_leaves; ileaf++) {
+      level = levels[count_elements + ileaf];
+      SC_CHECK_ABORT (0 <= level && level <= maxlevel,
+                      "Invalid level of a given leaf");
+      SC_CHECK_ABORT (linear_ids[count_elements + ileaf]
+                      < (t8_linearidx_t) t8_eclass_count_leaf (tree->eclass,
+                                                               level),
+                      "Invalid linear id of a given leaf");
+      element = t8_element_array_index_locidx (&tree->elements, ileaf);
+      ts->t8_element_set_linear_id (element, level,
+                                    linear_ids[count_elements + ileaf]);
+      /* The range of the leaf in a uniform refinement of maximum level */
+      ts->t8_element_first_descendant (element, desc, maxlevel);
+      first_id = ts->t8_element_get_linear_id (desc, maxlevel);
+      ts->t8_element_last_descendant (element, desc, maxlevel);
+      last_id = ts->t8_element_get_linear_id (desc, maxlevel);
+      if (ileaf == 0) {
+        /* Only the first tree may start inside the tree */
+        SC_CHECK_ABORT (itree == 0 || first_id == 0,
+                        "The given leaves do not cover their tree");
+        if (itree == 0) {
+          range.first_id = first_id;
+        }
+      }
+      else {
+        SC_CHECK_ABORT (first_id == prev_last_id + 1,
+                        "The given leaves are not sorted or overlap");
+      }
+      prev_last_id = last_id;
+    }
+    /* Only the last tree may end inside the tree */
+    SC_CHECK_ABORT (itree == num_trees - 1 || prev_last_id + 1 == end_id,
+                    "The given leaves do not cover their tree");
+    if (itree == num_trees - 1) {
+      range.last_id = prev_last_id;
+      range.last_is_end = prev_last_id + 1 == end_id;
+    }
+    ts->t8_element_destroy (1, &desc);
+    count_elements += num_leaves;
+  }
+  if (num_trees == 0) {
+    /* Indicate an empty forest by a first tree larger than the last */
+    forest->first_local_tree = 0;
+    forest->last_local_tree = -1;
+  }
+  forest->local_num_elements = count_elements;
+
+  /* Check that the leaves of all processes form a partition */
+  ranges = T8_ALLOC (t8_forest_leaves_range_t, forest->mpisize);
+  mpiret = sc_MPI_Allgather (&range, sizeof (range), sc_MPI_BYTE, ranges,
+                             sizeof (range), sc_MPI_BYTE, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  ok = t8_forest_leaves_ranges_valid (ranges, forest->mpisize,
+                                      global_num_trees);
+  T8_FREE (ranges);
+  SC_CHECK_ABORT (ok, "The given leaves do not form a partition of "
+                  "the forest");
+
+  t8_forest_comm_global_num_elements (forest);
+}
+
+void
+t8_forest_tree_implicit_elements (t8_forest_t forest, t8_tree_t tree,
+                                  t8_element_array_t * telements)
+{
+  t8_eclass_scheme_c *ts;
+
+  T8_ASSERT (tree->implicit_level >= 0);
+  ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+  t8_element_array_init_size (telements, ts, tree->implicit_count);
+  t8_forest_kernel_populate (t8_forest_get_kernel_eclass (forest), ts,
+                             telements, tree->implicit_level,
+                             tree->implicit_first,
+                             tree->implicit_first + tree->implicit_count);
+}
+
+void
+t8_forest_tree_materialize (t8_forest_t forest, t8_tree_t tree)
+{
+  T8_ASSERT (tree->implicit_level >= 0);
+  T8_ASSERT (t8_element_array_get_count (&tree->elements) == 0);
+
+  t8_element_array_reset (&tree->elements);
+  t8_forest_tree_implicit_elements (forest, tree, &tree->elements);
+}
+
+void
+t8_forest_tree_implicit_element (t8_forest_t forest, t8_tree_t tree,
+                                 t8_locidx_t index, t8_element_t * element)
+{
+  t8_eclass_scheme_c *ts;
+
+  T8_ASSERT (tree->implicit_level >= 0);
+  T8_ASSERT (0 <= index && index < tree->implicit_count);
+  ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+  ts->t8_element_init (1, element, 0);
+  ts->t8_element_set_linear_id (element, tree->implicit_level,
+                                tree->implicit_first + index);
+}
+
 /* return nonzero if the first tree of a forest is shared with a smaller
  * process, or if the last tree is shared with a bigger process.
  * Which operation is performed is switched with the first_or_last parameter.
@@ -1152,14 +2206,13 @@ t8_forest_last_tree_shared (t8_forest_t forest)
 }
 
 /* Allocate memory for trees and set their values as in from.
- * For each tree allocate enough element memory to fit the elements of from.
- * If copy_elements is true, copy the elements of from into the element memory.
+ * If copy_elements is true, the trees share the elements of from,
+ * see t8_forest_tree_share. Otherwise their element arrays are empty.
  */
 void
 t8_forest_copy_trees (t8_forest_t forest, t8_forest_t from, int copy_elements)
 {
   t8_tree_t           tree, fromtree;
-  t8_gloidx_t         num_tree_elements;
   t8_locidx_t         jt, number_of_trees;
   t8_eclass_scheme_c *eclass_scheme;
 
@@ -1177,14 +2230,9 @@ t8_forest_copy_trees (t8_forest_t forest, t8_forest_t from, int copy_elements)
     fromtree = (t8_tree_t) t8_sc_array_index_locidx (from->trees, jt);
     tree->eclass = fromtree->eclass;
     eclass_scheme = forest->scheme_cxx->eclass_schemes[tree->eclass];
-    num_tree_elements = t8_element_array_get_count (&fromtree->elements);
-    t8_element_array_init_size (&tree->elements, eclass_scheme,
-                                num_tree_elements);
-    /* TODO: replace with t8_elem_copy (not existing yet), in order to
-     * eventually copy additional pointer data stored in the elements?
-     * -> i.m.o. we should not allow such pointer data at the elements */
     if (copy_elements) {
-      t8_element_array_copy (&tree->elements, &fromtree->elements);
+      /* The elements of from do not change, so we share them */
+      t8_forest_tree_share (forest, jt, from, jt);
       tree->elements_offset = fromtree->elements_offset;
       /* Copy the first and last descendant */
       eclass_scheme->t8_element_new (1, &tree->first_desc);
@@ -1193,14 +2241,17 @@ t8_forest_copy_trees (t8_forest_t forest, t8_forest_t from, int copy_elements)
       eclass_scheme->t8_element_copy (fromtree->last_desc, tree->last_desc);
     }
     else {
-      t8_element_array_truncate (&tree->elements);
+      /* The elements are created later */
+      t8_element_array_init (&tree->elements, eclass_scheme);
+      tree->implicit_level = -1;
     }
   }
   forest->first_local_tree = from->first_local_tree;
   forest->last_local_tree = from->last_local_tree;
   if (copy_elements) {
     forest->local_num_elements = from->local_num_elements;
-    forest->global_num_elements = from->global_num_elements;
+    forest->global_num_elements =
+      t8_forest_comm_global_num_elements_wait (from);
   }
   else {
     forest->local_num_elements = 0;
@@ -1208,26 +2259,65 @@ t8_forest_copy_trees (t8_forest_t forest, t8_forest_t from, int copy_elements)
   }
 }
 
+/* Move the trees and elements of from to forest without copying them.
+ * Afterwards from has no trees and may only be destroyed.
+ */
+void
+t8_forest_move_trees (t8_forest_t forest, t8_forest_t from)
+{
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (from != NULL);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (from->committed);
+  T8_ASSERT (forest->scheme_cxx == from->scheme_cxx);
+
+  forest->trees = from->trees;
+  forest->element_arena = from->element_arena;
+  forest->shared_arenas = from->shared_arenas;
+  /* Leave an empty tree array, such that from can be destroyed */
+  from->trees = sc_array_new (sizeof (t8_tree_struct_t));
+  from->element_arena = NULL;
+  from->shared_arenas = NULL;
+  forest->first_local_tree = from->first_local_tree;
+  forest->last_local_tree = from->last_local_tree;
+  forest->local_num_elements = from->local_num_elements;
+  forest->global_num_elements =
+    t8_forest_comm_global_num_elements_wait (from);
+}
+
+/* Return the linear id at maxlevel of the element at position index in a
+ * sorted array of elements. If keys is not NULL, it stores these ids. */
+static inline t8_linearidx_t
+t8_forest_bin_search_key (t8_element_array_t * elements,
+                          const t8_linearidx_t * keys, t8_locidx_t index,
+                          int maxlevel)
+{
+  if (keys != NULL) {
+    return keys[index];
+  }
+  return t8_element_array_get_scheme (elements)->t8_element_get_linear_id
+    (t8_element_array_index_locidx (elements, index), maxlevel);
+}
+
 /* Search for a linear element id (at forest->maxlevel) in a sorted array of
  * elements. If the element does not exist, return the largest index i
  * such that the element at position i has a smaller id than the given one.
  * If no such i exists, return -1.
+ * If keys is not NULL, it stores the linear ids of the elements, which we
+ * then search instead of computing the id of each visited element.
  */
 /* TODO: should return t8_locidx_t */
 static t8_locidx_t
 t8_forest_bin_search_lower (t8_element_array_t * elements,
+                            const t8_linearidx_t * keys,
                             t8_linearidx_t element_id, int maxlevel)
 {
-  t8_element_t       *query;
   t8_linearidx_t      query_id;
   t8_locidx_t         low, high, guess;
-  t8_eclass_scheme_c *ts;
 
-  ts = t8_element_array_get_scheme (elements);
   /* At first, we check whether any element has smaller id than the
    * given one. */
-  query = t8_element_array_index_int (elements, 0);
-  query_id = ts->t8_element_get_linear_id (query, maxlevel);
+  query_id = t8_forest_bin_search_key (elements, keys, 0, maxlevel);
   if (query_id > element_id) {
     /* No element has id smaller than the given one */
     return -1;
@@ -1238,8 +2328,7 @@ t8_forest_bin_search_lower (t8_element_array_t * elements,
   high = t8_element_array_get_count (elements) - 1;
   while (low < high) {
     guess = (low + high + 1) / 2;
-    query = t8_element_array_index_int (elements, guess);
-    query_id = ts->t8_element_get_linear_id (query, maxlevel);
+    query_id = t8_forest_bin_search_key (elements, keys, guess, maxlevel);
     if (query_id == element_id) {
       /* we are done */
       return guess;
@@ -1257,6 +2346,29 @@ t8_forest_bin_search_lower (t8_element_array_t * elements,
   return low;
 }
 
+/* The leaf keys of a local tree, or NULL if the forest has none */
+static const t8_linearidx_t *
+t8_forest_leaf_keys_tree (t8_forest_t forest, t8_locidx_t ltreeid)
+{
+  if (forest->leaf_keys == NULL) {
+    return NULL;
+  }
+  return forest->leaf_keys
+    + t8_forest_get_tree_element_offset (forest, ltreeid);
+}
+
+/* The leaf keys of a ghost tree, or NULL if the forest has none */
+static const t8_linearidx_t *
+t8_forest_leaf_keys_ghost_tree (t8_forest_t forest, t8_locidx_t lghost_tree)
+{
+  if (forest->leaf_keys == NULL
+      || forest->num_leaf_keys == forest->local_num_elements) {
+    return NULL;
+  }
+  return forest->leaf_keys + forest->local_num_elements
+    + t8_forest_ghost_get_tree_element_offset (forest, lghost_tree);
+}
+
 t8_eclass_t
 t8_forest_element_neighbor_eclass (t8_forest_t forest,
                                    t8_locidx_t ltreeid,
@@ -1264,7 +2376,6 @@ t8_forest_element_neighbor_eclass (t8_forest_t forest,
 {
   t8_eclass_scheme_c *ts;
   t8_tree_t           tree;
-  t8_ctree_t          coarse_tree;
   t8_eclass_t         eclass;
   int                 tree_face;
   t8_locidx_t         lcoarse_neighbor;
@@ -1285,24 +2396,111 @@ t8_forest_element_neighbor_eclass (t8_forest_t forest,
     tree_face = ts->t8_element_tree_face (elem, face);
 
     cmesh = t8_forest_get_cmesh (forest);
-    /* Get the coarse tree corresponding to tree */
-    coarse_tree = t8_forest_get_coarse_tree (forest, ltreeid);
     /* Get the (coarse) local id of the tree neighbor */
-    lcoarse_neighbor = t8_cmesh_trees_get_face_neighbor (coarse_tree,
-                                                         tree_face);
+    lcoarse_neighbor =
+      t8_cmesh_trees_get_face_neighbor_ext (cmesh->trees,
+                                            t8_forest_ltreeid_to_cmesh_ltreeid
+                                            (forest, ltreeid), tree_face,
+                                            NULL);
     T8_ASSERT (0 <= lcoarse_neighbor);
-    if (lcoarse_neighbor < t8_cmesh_get_num_local_trees (cmesh)) {
-      /* The tree neighbor is a local tree */
-      return t8_cmesh_get_tree_class (cmesh, lcoarse_neighbor);
-    }
-    else {
-      T8_ASSERT (lcoarse_neighbor - t8_cmesh_get_num_local_trees (cmesh)
-                 < cmesh->num_ghosts);
-      /* The tree neighbor is a ghost */
-      return t8_cmesh_get_ghost_class (cmesh,
-                                       lcoarse_neighbor
-                                       -
-                                       t8_cmesh_get_num_local_trees (cmesh));
+    T8_ASSERT (lcoarse_neighbor < cmesh->num_local_trees + cmesh->num_ghosts);
+    /* The tree neighbor is a local tree or a ghost */
+    return t8_cmesh_trees_get_class (cmesh->trees, lcoarse_neighbor,
+                                     t8_cmesh_get_num_local_trees (cmesh));
+  }
+}
+
+/* Compute the connection of the face tree_face of a local tree to its
+ * neighbor tree from the cmesh. */
+static void
+t8_forest_tree_face_compute (t8_forest_t forest, t8_locidx_t ltreeid,
+                             int tree_face, t8_forest_tree_face_t * tface)
+{
+  t8_cmesh_t          cmesh = forest->cmesh;
+  t8_eclass_t         eclass, neigh_eclass;
+  t8_locidx_t         lctree_id, lcneigh_id;
+  t8_cghost_t         ghost;
+  int8_t              ttf;
+  int                 tree_neigh_face;
+  int                 eclass_compare;
+  int                 F;
+
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  /* compute coarse tree id */
+  lctree_id = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltreeid);
+  tface->neigh_tree = -1;
+  if (t8_cmesh_tree_face_is_boundary (cmesh, lctree_id, tree_face)) {
+    /* This face is a domain boundary */
+    return;
+  }
+  /* Compute the local id of the face neighbor tree and the connection. */
+  lcneigh_id = t8_cmesh_trees_get_face_neighbor_ext (cmesh->trees, lctree_id,
+                                                     tree_face, &ttf);
+  /* F is needed to compute the neighbor face number and the orientation.
+   * tree_neigh_face = ttf % F
+   * or = ttf / F
+   */
+  F = t8_eclass_max_num_faces[cmesh->dimension];
+  /* compute the neighbor face */
+  tree_neigh_face = ttf % F;
+  if (lcneigh_id == lctree_id && tree_face == tree_neigh_face) {
+    /* This face is a domain boundary and there is no neighbor */
+    return;
+  }
+  /* We now compute the eclass of the neighbor tree. */
+  if (lcneigh_id < t8_cmesh_get_num_local_trees (cmesh)) {
+    /* The face neighbor is a local tree */
+    neigh_eclass = t8_cmesh_get_tree_class (cmesh, lcneigh_id);
+    tface->neigh_tree = lcneigh_id + t8_cmesh_get_first_treeid (cmesh);
+  }
+  else {
+    /* The face neighbor is a ghost tree */
+    T8_ASSERT (cmesh->num_local_trees <= lcneigh_id
+               && lcneigh_id < cmesh->num_ghosts + cmesh->num_local_trees);
+    ghost = t8_cmesh_trees_get_ghost (cmesh->trees,
+                                      lcneigh_id -
+                                      t8_cmesh_get_num_local_trees (cmesh));
+    neigh_eclass = ghost->eclass;
+    tface->neigh_tree = ghost->treeid;
+  }
+  tface->neigh_eclass = (int8_t) neigh_eclass;
+  tface->transform.neigh_face = (int8_t) tree_neigh_face;
+  tface->transform.orientation = (int8_t) (ttf / F);
+  /* We need to find out which face is the smaller one that is the one
+   * according to which the orientation was computed.
+   * face_a is smaller then face_b if either eclass_a < eclass_b
+   * or eclass_a = eclass_b and face_a < face_b. */
+  /* -1 eclass < neigh_eclass, 0 eclass = neigh_eclass, 1 eclass > neigh_eclass */
+  eclass_compare = t8_eclass_compare (eclass, neigh_eclass);
+  tface->transform.is_smaller = eclass_compare == -1
+    || (eclass_compare == 0 && tree_face <= tree_neigh_face);
+  tface->transform.sign =
+    t8_eclass_face_orientation[eclass][tree_face] ==
+    t8_eclass_face_orientation[neigh_eclass][tree_neigh_face];
+}
+
+void
+t8_forest_tree_faces_build (t8_forest_t forest)
+{
+  t8_locidx_t         itree, num_trees;
+  int                 iface, num_faces;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->tree_faces == NULL);
+
+  num_trees = t8_forest_get_num_local_trees (forest);
+  if (num_trees == 0) {
+    return;
+  }
+  forest->tree_faces = T8_ALLOC (t8_forest_tree_face_t,
+                                 T8_ECLASS_MAX_FACES * num_trees);
+  for (itree = 0; itree < num_trees; itree++) {
+    num_faces =
+      t8_eclass_num_faces[t8_forest_get_tree_class (forest, itree)];
+    for (iface = 0; iface < num_faces; iface++) {
+      t8_forest_tree_face_compute (forest, itree, iface,
+                                   forest->tree_faces
+                                   + T8_ECLASS_MAX_FACES * itree + iface);
     }
   }
 }
@@ -1331,110 +2529,37 @@ t8_forest_element_face_neighbor (t8_forest_t forest,
   else {
     /* The neighbor does not lie inside the current tree. The content of neigh
      * is undefined right now. */
-    t8_eclass_scheme_c *boundary_scheme, *neighbor_scheme;
-    t8_eclass_t         neigh_eclass, boundary_class;
-    t8_element_t       *face_element;
-    t8_cmesh_t          cmesh;
-    t8_locidx_t         lctree_id, lcneigh_id;
-    t8_locidx_t        *face_neighbor;
-    t8_gloidx_t         global_neigh_id;
-    t8_cghost_t         ghost;
-    int8_t             *ttf;
-    int                 tree_face, tree_neigh_face;
-    int                 is_smaller, eclass_compare;
-    int                 F, sign;
-
-    cmesh = forest->cmesh;
-    /* Get the scheme associated to the element class of the
-     * boundary element. */
+    t8_forest_tree_face_t tface_buffer;
+    const t8_forest_tree_face_t *tface;
+    t8_eclass_scheme_c *boundary_scheme;
+    int                 tree_face;
+
     /* Compute the face of elem_tree at which the face connection is. */
     tree_face = ts->t8_element_tree_face (elem, face);
-    /* compute coarse tree id */
-    lctree_id = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltreeid);
-    if (t8_cmesh_tree_face_is_boundary (cmesh, lctree_id, tree_face)) {
+    if (forest->tree_faces != NULL) {
+      tface = forest->tree_faces + T8_ECLASS_MAX_FACES * ltreeid + tree_face;
+    }
+    else {
+      /* During commit, before the connections are stored */
+      t8_forest_tree_face_compute (forest, ltreeid, tree_face, &tface_buffer);
+      tface = &tface_buffer;
+    }
+    if (tface->neigh_tree < 0) {
       /* This face is a domain boundary. We do not need to continue */
       return -1;
     }
     /* Get the eclass scheme for the boundary */
-    boundary_class = (t8_eclass_t) t8_eclass_face_types[eclass][tree_face];
-    boundary_scheme = t8_forest_get_eclass_scheme (forest, boundary_class);
-    /* Allocate the face element */
-    boundary_scheme->t8_element_new (1, &face_element);
-    /* Compute the face element. */
-    ts->t8_element_boundary_face (elem, face, face_element, boundary_scheme);
-    /* Get the coarse tree that contains elem.
-     * Also get the face neighbor information of the coarse tree. */
-    (void) t8_cmesh_trees_get_tree_ext (cmesh->trees,
-                                        lctree_id, &face_neighbor, &ttf);
-    /* Compute the local id of the face neighbor tree. */
-    lcneigh_id = face_neighbor[tree_face];
-    /* F is needed to compute the neighbor face number and the orientation.
-     * tree_neigh_face = ttf % F
-     * or = ttf / F
-     */
-    F = t8_eclass_max_num_faces[cmesh->dimension];
-    /* compute the neighbor face */
-    tree_neigh_face = ttf[tree_face] % F;
-    if (lcneigh_id == lctree_id && tree_face == tree_neigh_face) {
-      /* This face is a domain boundary and there is no neighbor */
-      return -1;
-    }
-    /* We now compute the eclass of the neighbor tree. */
-    if (lcneigh_id < t8_cmesh_get_num_local_trees (cmesh)) {
-      /* The face neighbor is a local tree */
-      /* Get the eclass of the neighbor tree */
-      neigh_eclass = t8_cmesh_get_tree_class (cmesh, lcneigh_id);
-      global_neigh_id = lcneigh_id + t8_cmesh_get_first_treeid (cmesh);
-    }
-    else {
-      /* The face neighbor is a ghost tree */
-      T8_ASSERT (cmesh->num_local_trees <= lcneigh_id
-                 && lcneigh_id < cmesh->num_ghosts + cmesh->num_local_trees);
-      /* Get the eclass of the neighbor tree */
-      ghost = t8_cmesh_trees_get_ghost (cmesh->trees,
-                                        lcneigh_id -
-                                        t8_cmesh_get_num_local_trees (cmesh));
-      neigh_eclass = ghost->eclass;
-      global_neigh_id = ghost->treeid;
-    }
-    /* We need to find out which face is the smaller one that is the one
-     * according to which the orientation was computed.
-     * face_a is smaller then face_b if either eclass_a < eclass_b
-     * or eclass_a = eclass_b and face_a < face_b. */
-    /* -1 eclass < neigh_eclass, 0 eclass = neigh_eclass, 1 eclass > neigh_eclass */
-    eclass_compare = t8_eclass_compare (eclass, neigh_eclass);
-    is_smaller = 0;
-    if (eclass_compare == -1) {
-      /* The face in the current tree is the smaller one */
-      is_smaller = 1;
-    }
-    else if (eclass_compare == 1) {
-      /* The face in the other tree is the smaller one */
-      is_smaller = 0;
-    }
-    else {
-
-      T8_ASSERT (eclass_compare == 0);
-      /* Check if the face of the current tree has a smaller index then
-       * the face of the neighbor tree. */
-      is_smaller = tree_face <= tree_neigh_face;
-    }
-    /* We now transform the face element to the other tree. */
-    sign =
-      t8_eclass_face_orientation[eclass][tree_face] ==
-      t8_eclass_face_orientation[neigh_eclass][tree_neigh_face];
-    boundary_scheme->t8_element_transform_face (face_element,
-                                                face_element,
-                                                ttf[tree_face] / F, sign,
-                                                is_smaller);
-    /* And now we extrude the face to the new neighbor element */
-    neighbor_scheme = forest->scheme_cxx->eclass_schemes[neigh_eclass];
+    boundary_scheme =
+      t8_forest_get_eclass_scheme (forest, (t8_eclass_t)
+                                   t8_eclass_face_types[eclass][tree_face]);
+    /* Transform the element to the neighbor tree */
     *neigh_face =
-      neighbor_scheme->t8_element_extrude_face (face_element,
-                                                boundary_scheme, neigh,
-                                                tree_neigh_face);
-
-    return global_neigh_id;
+      ts->t8_element_face_neighbor_across_tree (elem, face, boundary_scheme,
+                                                forest->
+                                                scheme_cxx->eclass_schemes
+                                                [tface->neigh_eclass],
+                                                &tface->transform, neigh);
+    return tface->neigh_tree;
   }
 }
 
@@ -1458,6 +2583,7 @@ t8_forest_element_half_face_neighbors (t8_forest_t forest,
   int                 num_children_at_face, child_it;
   int                 child_face;
   int                 neigh_face;
+  t8_element_scratch_mark_t scratch_mark;
 
   /* Get the current tree and its element class */
   tree = t8_forest_get_tree (forest, ltreeid);
@@ -1470,9 +2596,19 @@ t8_forest_element_half_face_neighbors (t8_forest_t forest,
   /* The number of children of elem at face */
   T8_ASSERT (num_neighs == ts->t8_element_num_face_children (elem, face));
   num_children_at_face = num_neighs;
-  /* Allocate memory for the children of elem that share a face with face. */
-  children_at_face = T8_ALLOC (t8_element_t *, num_children_at_face);
-  ts->t8_element_new (num_children_at_face, children_at_face);
+  if (!ts->t8_element_is_root_boundary (elem, face)
+      && ts->t8_element_half_face_neighbors_inside (elem, face, neighs,
+                                                    num_neighs, dual_faces)) {
+    /* The neighbors are in the same tree, the scheme computed them
+     * directly */
+    T8_ASSERT (neigh_scheme == ts);
+    return t8_forest_global_tree_id (forest, ltreeid);
+  }
+  /* Get memory for the children of elem that share a face with face. */
+  t8_element_scratch_mark (&scratch_mark);
+  children_at_face = (t8_element_t **)
+    t8_element_scratch_alloc (num_children_at_face * sizeof (t8_element_t *));
+  t8_element_scratch_get (ts, num_children_at_face, children_at_face);
 
   /* Construct the children of elem at face
    *
@@ -1509,28 +2645,28 @@ t8_forest_element_half_face_neighbors (t8_forest_t forest,
 #endif
   }
   /* Clean-up the memory */
-  ts->t8_element_destroy (num_children_at_face, children_at_face);
-  T8_FREE (children_at_face);
+  t8_element_scratch_release (&scratch_mark);
   return neighbor_tree;
 }
 
-void
-t8_forest_leaf_face_neighbors (t8_forest_t forest, t8_locidx_t ltreeid,
-                               const t8_element_t * leaf,
-                               t8_element_t ** pneighbor_leafs[],
-                               int face, int *dual_faces[],
-                               int *num_neighbors,
-                               t8_locidx_t ** pelement_indices,
-                               t8_eclass_scheme_c ** pneigh_scheme,
-                               int forest_is_balanced)
+int
+t8_forest_leaf_face_neighbors_ext (t8_forest_t forest, t8_locidx_t ltreeid,
+                                   const t8_element_t * leaf, int face,
+                                   int capacity,
+                                   t8_element_t * neighbor_leafs[],
+                                   int dual_faces[],
+                                   t8_locidx_t element_indices[],
+                                   t8_eclass_scheme_c ** pneigh_scheme,
+                                   int forest_is_balanced)
 {
   t8_eclass_t         neigh_class, eclass;
   t8_gloidx_t         gneigh_treeid;
   t8_locidx_t         lneigh_treeid = -1;
-  t8_locidx_t         lghost_treeid = -1, *element_indices, element_index;
+  t8_locidx_t         lghost_treeid = -1, element_index;
   t8_eclass_scheme_c *ts, *neigh_scheme;
   t8_element_array_t *element_array;
-  t8_element_t       *ancestor, **neighbor_leafs;
+  t8_element_t       *ancestor, **neighs;
+  t8_element_scratch_mark_t scratch_mark;
   t8_linearidx_t      neigh_id;
   int                 num_children_at_face, at_maxlevel;
   int                 ineigh, *owners, different_owners, have_ghosts;
@@ -1538,278 +2674,433 @@ t8_forest_leaf_face_neighbors (t8_forest_t forest, t8_locidx_t ltreeid,
   /* TODO: implement is_leaf check to apply to leaf */
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (!forest_is_balanced || t8_forest_is_balanced (forest));
+  T8_ASSERT (dual_faces != NULL && element_indices != NULL);
   SC_CHECK_ABORT (forest_is_balanced, "leaf face neighbors is not implemented " "for unbalanced forests.\n");   /* TODO: write version for unbalanced forests */
   SC_CHECK_ABORT (forest->mpisize == 1 || forest->ghosts != NULL,
                   "Ghost structure is needed for t8_forest_leaf_face_neighbors "
                   "but was not found in forest.\n");
 
-  if (forest_is_balanced) {
-    /* In a balanced forest, the leaf neighbor of a leaf is either the neighbor element itself,
-     * its parent or its children at the face. */
-    eclass = t8_forest_get_tree_class (forest, ltreeid);
-    ts = t8_forest_get_eclass_scheme (forest, eclass);
-    /* At first we compute these children of the face neighbor elements of leaf. For this, we need the
-     * neighbor tree's eclass, scheme, and tree id */
-    neigh_class =
-      t8_forest_element_neighbor_eclass (forest, ltreeid, leaf, face);
-    neigh_scheme = *pneigh_scheme =
-      t8_forest_get_eclass_scheme (forest, neigh_class);
-    /* If we are at the maximum refinement level, we compute the neighbor instead */
-    at_maxlevel =
-      ts->t8_element_level (leaf) == t8_forest_get_maxlevel (forest);
-    if (at_maxlevel) {
-      num_children_at_face = 1;
-      neighbor_leafs = *pneighbor_leafs = T8_ALLOC (t8_element_t *, 1);
-      *dual_faces = T8_ALLOC (int, 1);
-      neigh_scheme->t8_element_new (num_children_at_face, neighbor_leafs);
-      /* Compute neighbor element and global treeid of the neighbor */
-      gneigh_treeid =
-        t8_forest_element_face_neighbor (forest, ltreeid, leaf,
-                                         neighbor_leafs[0], neigh_scheme,
-                                         face, *dual_faces);
+  /* In a balanced forest, the leaf neighbor of a leaf is either the neighbor element itself,
+   * its parent or its children at the face. */
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  /* At first we compute these children of the face neighbor elements of leaf. For this, we need the
+   * neighbor tree's eclass, scheme, and tree id */
+  neigh_class =
+    t8_forest_element_neighbor_eclass (forest, ltreeid, leaf, face);
+  neigh_scheme = *pneigh_scheme =
+    t8_forest_get_eclass_scheme (forest, neigh_class);
+  /* If we are at the maximum refinement level, we compute the neighbor instead */
+  at_maxlevel =
+    ts->t8_element_level (leaf) == t8_forest_get_maxlevel (forest);
+  num_children_at_face =
+    at_maxlevel ? 1 : ts->t8_element_num_face_children (leaf, face);
+  T8_ASSERT (num_children_at_face <= capacity);
+  /* The candidate neighbors and their owners are temporary. We take them
+   * from the scratch arena, such that this function does not allocate. */
+  t8_element_scratch_mark (&scratch_mark);
+  neighs = (t8_element_t **)
+    t8_element_scratch_alloc (num_children_at_face * sizeof (t8_element_t *));
+  t8_element_scratch_get (neigh_scheme, num_children_at_face, neighs);
+  owners = (int *) t8_element_scratch_alloc (num_children_at_face *
+                                             sizeof (int));
+  if (at_maxlevel) {
+    /* Compute neighbor element and global treeid of the neighbor */
+    gneigh_treeid =
+      t8_forest_element_face_neighbor (forest, ltreeid, leaf, neighs[0],
+                                       neigh_scheme, face, dual_faces);
+  }
+  else {
+    /* Compute neighbor elements and global treeid of the neighbor */
+    gneigh_treeid =
+      t8_forest_element_half_face_neighbors (forest, ltreeid, leaf, neighs,
+                                             neigh_scheme, face,
+                                             num_children_at_face,
+                                             dual_faces);
+  }
+  if (gneigh_treeid < 0) {
+    /* There exists no face neighbor across this face, we return with this info */
+    t8_element_scratch_release (&scratch_mark);
+    return 0;
+  }
+  T8_ASSERT (gneigh_treeid >= 0 && gneigh_treeid < forest->global_num_trees);
+  /* We have computed the half face neighbor elements, we now compute their owners,
+   * if they differ, we know that the half face neighbors are the neighbor leafs.
+   * If the owners do not differ, we have to check if the neighbor leaf is their
+   * parent or grandparent. */
+  different_owners = 0;
+  have_ghosts = 0;
+  for (ineigh = 0; ineigh < num_children_at_face; ineigh++) {
+    /* At first, we check whether the current rank owns the neighbor, since
+     * this is a constant time check and it is the most common case */
+    if (t8_forest_element_check_owner (forest, neighs[ineigh],
+                                       gneigh_treeid, neigh_class,
+                                       forest->mpirank, at_maxlevel)) {
+      owners[ineigh] = forest->mpirank;
+      /* The neighbor tree is also a local tree. we store its local treeid */
+      lneigh_treeid = t8_forest_get_local_id (forest, gneigh_treeid);
     }
     else {
-      /* Allocate neighbor element */
-      num_children_at_face = ts->t8_element_num_face_children (leaf, face);
-      neighbor_leafs = *pneighbor_leafs =
-        T8_ALLOC (t8_element_t *, num_children_at_face);
-      *dual_faces = T8_ALLOC (int, num_children_at_face);
-      neigh_scheme->t8_element_new (num_children_at_face, neighbor_leafs);
-      /* Compute neighbor elements and global treeid of the neighbor */
-      gneigh_treeid =
-        t8_forest_element_half_face_neighbors (forest, ltreeid, leaf,
-                                               neighbor_leafs,
-                                               neigh_scheme, face,
-                                               num_children_at_face,
-                                               *dual_faces);
-    }
-    if (gneigh_treeid < 0) {
-      /* There exists no face neighbor across this face, we return with this info */
-      neigh_scheme->t8_element_destroy (1, neighbor_leafs);
-      T8_FREE (neighbor_leafs);
-      T8_FREE (*dual_faces);
-      *dual_faces = NULL;
-      *num_neighbors = 0;
-      *pelement_indices = NULL;
-      *pneighbor_leafs = NULL;
-      return;
+      owners[ineigh] =
+        t8_forest_element_find_owner (forest, gneigh_treeid,
+                                      neighs[ineigh], neigh_class);
+      /* Store that at least one neighbor is a ghost */
+      have_ghosts = 1;
+    }
+    if (ineigh > 0) {
+      /* Check if all owners are the same for all neighbors or not */
+      different_owners = different_owners
+        || (owners[ineigh] != owners[ineigh - 1]);
+    }
+  }
+  if (have_ghosts) {
+    /* At least one neighbor is a ghost, we compute the ghost treeid of the neighbor
+     * tree. */
+    lghost_treeid = t8_forest_ghost_get_ghost_treeid (forest, gneigh_treeid);
+    T8_ASSERT (lghost_treeid >= 0);
+  }
+  /* TODO: Maybe we do not need to compute the owners. It suffices to know
+   *       whether the neighbor is owned by mpirank or not. */
+
+  if (!different_owners) {
+    /* The face neighbors belong to the same process, we thus need to determine
+     * if they are leafs or their parent or grandparent. */
+    neigh_id =
+      neigh_scheme->t8_element_get_linear_id (neighs[0], forest->maxlevel);
+    if (owners[0] != forest->mpirank) {
+      /* The elements are ghost elements of the same owner */
+      element_array =
+        t8_forest_ghost_get_tree_elements (forest, lghost_treeid);
+      /* Find the index in element_array of the leaf ancestor of the first neighbor.
+       * This is either the neighbor itself or its parent, or its grandparent */
+      element_index =
+        t8_forest_bin_search_lower (element_array,
+                                    t8_forest_leaf_keys_ghost_tree
+                                    (forest, lghost_treeid), neigh_id,
+                                    forest->maxlevel);
+      /* Get the element */
+      ancestor =
+        t8_forest_ghost_get_element (forest, lghost_treeid, element_index);
+      /* Add the number of ghost elements on previous ghost trees and the number
+       * of local elements. */
+      element_index +=
+        t8_forest_ghost_get_tree_element_offset (forest, lghost_treeid);
+      element_index += t8_forest_get_num_element (forest);
+      T8_ASSERT (forest->local_num_elements <= element_index
+                 && element_index <
+                 forest->local_num_elements +
+                 t8_forest_get_num_ghosts (forest));
     }
-    T8_ASSERT (gneigh_treeid >= 0
-               && gneigh_treeid < forest->global_num_trees);
-    /* We have computed the half face neighbor elements, we now compute their owners,
-     * if they differ, we know that the half face neighbors are the neighbor leafs.
-     * If the owners do not differ, we have to check if the neighbor leaf is their
-     * parent or grandparent. */
-    owners = T8_ALLOC (int, num_children_at_face);
-    different_owners = 0;
-    have_ghosts = 0;
-    for (ineigh = 0; ineigh < num_children_at_face; ineigh++) {
-      /* At first, we check whether the current rank owns the neighbor, since
-       * this is a constant time check and it is the most common case */
-      if (t8_forest_element_check_owner (forest, neighbor_leafs[ineigh],
-                                         gneigh_treeid, neigh_class,
-                                         forest->mpirank, at_maxlevel)) {
-        owners[ineigh] = forest->mpirank;
-        /* The neighbor tree is also a local tree. we store its local treeid */
-        lneigh_treeid = t8_forest_get_local_id (forest, gneigh_treeid);
+    else {
+      /* the elements are local elements */
+      element_array =
+        t8_forest_get_tree_element_array (forest, lneigh_treeid);
+      /* Find the index in element_array of the leaf ancestor of the first neighbor.
+       * This is either the neighbor itself or its parent, or its grandparent */
+      element_index =
+        t8_forest_bin_search_lower (element_array,
+                                    t8_forest_leaf_keys_tree
+                                    (forest, lneigh_treeid), neigh_id,
+                                    forest->maxlevel);
+      /* Get the element */
+      ancestor =
+        t8_forest_get_tree_element (t8_forest_get_tree
+                                    (forest, lneigh_treeid), element_index);
+      /* Add the element offset of this tree to the index */
+      element_index +=
+        t8_forest_get_tree_element_offset (forest, lneigh_treeid);
+    }
+    if (neigh_scheme->t8_element_compare (ancestor, neighs[0]) < 0) {
+      /* ancestor is a real ancestor, and thus the neighbor is either the
+       * parent or grandparent of the half neighbors. we can return it and
+       * the indices. */
+      /* We need to determine the dual face */
+      if (neigh_scheme->t8_element_level (ancestor) ==
+          ts->t8_element_level (leaf)) {
+        /* The ancestor is the same-level neighbor of leaf */
+        if (!at_maxlevel) {
+          /* its dual face is the face of the parent of the first neighbor leaf */
+          dual_faces[0] =
+            neigh_scheme->t8_element_face_parent_face (neighs[0],
+                                                       dual_faces[0]);
+        }
       }
       else {
-        owners[ineigh] =
-          t8_forest_element_find_owner (forest, gneigh_treeid,
-                                        neighbor_leafs[ineigh], neigh_class);
-        /* Store that at least one neighbor is a ghost */
-        have_ghosts = 1;
+        /* The ancestor is the parent of the parent */
+        T8_ASSERT (neigh_scheme->t8_element_level (ancestor) ==
+                   ts->t8_element_level (leaf) - 1);
+
+        dual_faces[0] =
+          neigh_scheme->t8_element_face_parent_face (neighs[0],
+                                                     dual_faces[0]);
+        if (!at_maxlevel) {
+          /* We need to compute the dual face of the grandparent. */
+          /* Construct the parent of the grand child */
+          neigh_scheme->t8_element_parent (neighs[0], neighs[0]);
+          /* Compute the face id of the parent's face */
+          dual_faces[0] =
+            neigh_scheme->t8_element_face_parent_face (neighs[0],
+                                                       dual_faces[0]);
+        }
       }
-      if (ineigh > 0) {
-        /* Check if all owners are the same for all neighbors or not */
-        different_owners = different_owners
-          || (owners[ineigh] != owners[ineigh - 1]);
+      /* set return values */
+      if (neighbor_leafs != NULL) {
+        neigh_scheme->t8_element_copy (ancestor, neighbor_leafs[0]);
       }
+      element_indices[0] = element_index;
+      t8_element_scratch_release (&scratch_mark);
+      return 1;
     }
-    if (have_ghosts) {
-      /* At least one neighbor is a ghost, we compute the ghost treeid of the neighbor
-       * tree. */
-      lghost_treeid =
-        t8_forest_ghost_get_ghost_treeid (forest, gneigh_treeid);
-      T8_ASSERT (lghost_treeid >= 0);
-    }
-    /* TODO: Maybe we do not need to compute the owners. It suffices to know
-     *       whether the neighbor is owned by mpirank or not. */
-
-    if (!different_owners) {
-      /* The face neighbors belong to the same process, we thus need to determine
-       * if they are leafs or their parent or grandparent. */
-      neigh_id =
-        neigh_scheme->t8_element_get_linear_id (neighbor_leafs[0],
-                                                forest->maxlevel);
-      if (owners[0] != forest->mpirank) {
-        /* The elements are ghost elements of the same owner */
-        element_array =
-          t8_forest_ghost_get_tree_elements (forest, lghost_treeid);
-        /* Find the index in element_array of the leaf ancestor of the first neighbor.
-         * This is either the neighbor itself or its parent, or its grandparent */
-        element_index =
-          t8_forest_bin_search_lower (element_array, neigh_id,
-                                      forest->maxlevel);
-        /* Get the element */
-        ancestor =
-          t8_forest_ghost_get_element (forest, lghost_treeid, element_index);
-        /* Add the number of ghost elements on previous ghost trees and the number
-         * of local elements. */
-        element_index +=
-          t8_forest_ghost_get_tree_element_offset (forest, lghost_treeid);
-        element_index += t8_forest_get_num_element (forest);
-        T8_ASSERT (forest->local_num_elements <= element_index
-                   && element_index <
-                   forest->local_num_elements +
-                   t8_forest_get_num_ghosts (forest));
+  }
+  /* The leafs are the face neighbors that we are looking for. */
+  /* The face neighbors either belong to different processes and thus must be leafs
+   * in the forest, or the ancestor leaf of the first half neighbor is the half
+   * neighbor itself and thus all half neighbors must be leafs.
+   * Since the forest is balanced, we found all neighbor leafs.
+   * It remains to compute their local ids */
+  for (ineigh = 0; ineigh < num_children_at_face; ineigh++) {
+    /* Compute the linear id at maxlevel of the neighbor leaf */
+    neigh_id =
+      neigh_scheme->t8_element_get_linear_id (neighs[ineigh],
+                                              forest->maxlevel);
+    /* Get a pointer to the element array in which the neighbor lies and search
+     * for the element's index in this array.
+     * This is either the local leaf array of the local tree or the corresponding leaf array
+     * in the ghost structure */
+    if (owners[ineigh] == forest->mpirank) {
+      /* The neighbor is a local leaf */
+      element_array =
+        t8_forest_get_tree_element_array (forest, lneigh_treeid);
+      /* Find the index of the neighbor in the array */
+      element_indices[ineigh] =
+        t8_forest_bin_search_lower (element_array,
+                                    t8_forest_leaf_keys_tree
+                                    (forest, lneigh_treeid), neigh_id,
+                                    forest->maxlevel);
+      T8_ASSERT (element_indices[ineigh] >= 0);
+      /* We have to add the tree's element offset to the index found to get
+       * the actual local element id */
+      element_indices[ineigh] +=
+        t8_forest_get_tree_element_offset (forest, lneigh_treeid);
+#if T8_ENABLE_DEBUG
+      /* We check whether the element is really the element at this local id */
+      {
+        t8_locidx_t         check_ltreeid;
+        t8_element_t       *check_element;
+        check_element =
+          t8_forest_get_element (forest, element_indices[ineigh],
+                                 &check_ltreeid);
+        T8_ASSERT (check_ltreeid == lneigh_treeid);
+        T8_ASSERT (!neigh_scheme->t8_element_compare (check_element,
+                                                      neighs[ineigh]));
       }
-      else {
-        /* the elements are local elements */
-        element_array =
-          t8_forest_get_tree_element_array (forest, lneigh_treeid);
-        /* Find the index in element_array of the leaf ancestor of the first neighbor.
-         * This is either the neighbor itself or its parent, or its grandparent */
-        element_index =
-          t8_forest_bin_search_lower (element_array, neigh_id,
-                                      forest->maxlevel);
-        /* Get the element */
-        ancestor =
-          t8_forest_get_tree_element (t8_forest_get_tree
-                                      (forest, lneigh_treeid), element_index);
-        /* Add the element offset of this tree to the index */
-        element_index +=
-          t8_forest_get_tree_element_offset (forest, lneigh_treeid);
+#endif
+    }
+    else {
+      /* The neighbor is a ghost */
+      element_array =
+        t8_forest_ghost_get_tree_elements (forest, lghost_treeid);
+      /* Find the index of the neighbor in the array */
+      element_indices[ineigh] =
+        t8_forest_bin_search_lower (element_array,
+                                    t8_forest_leaf_keys_ghost_tree
+                                    (forest, lghost_treeid), neigh_id,
+                                    forest->maxlevel);
+
+#if T8_ENABLE_DEBUG
+      /* We check whether the element is really the element at this local id */
+      {
+        t8_element_t       *check_element;
+        check_element =
+          t8_forest_ghost_get_element (forest, lghost_treeid,
+                                       element_indices[ineigh]);
+        T8_ASSERT (!neigh_scheme->t8_element_compare (check_element,
+                                                      neighs[ineigh]));
       }
-      if (neigh_scheme->t8_element_compare (ancestor, neighbor_leafs[0]) < 0) {
-        /* ancestor is a real ancestor, and thus the neighbor is either the
-         * parent or grandparent of the half neighbors. we can return it and
-         * the indices. */
-        /* We need to determine the dual face */
-        if (neigh_scheme->t8_element_level (ancestor) ==
-            ts->t8_element_level (leaf)) {
-          /* The ancestor is the same-level neighbor of leaf */
-          if (!at_maxlevel) {
-            /* its dual face is the face of the parent of the first neighbor leaf */
-            *dual_faces[0] =
-              neigh_scheme->t8_element_face_parent_face (neighbor_leafs[0],
-                                                         *dual_faces[0]);
+#endif
+      /* Add the element offset of previous ghosts to this index */
+      element_indices[ineigh] +=
+        t8_forest_ghost_get_tree_element_offset (forest, lghost_treeid);
+      /* Add the number of all local elements to this index */
+      element_indices[ineigh] += t8_forest_get_num_element (forest);
+    }
+    if (neighbor_leafs != NULL) {
+      neigh_scheme->t8_element_copy (neighs[ineigh], neighbor_leafs[ineigh]);
+    }
+  }                             /* End for loop over neighbor leafs */
+  t8_element_scratch_release (&scratch_mark);
+  return num_children_at_face;
+}
 
-          }
-        }
-        else {
-          /* The ancestor is the parent of the parent */
-          T8_ASSERT (neigh_scheme->t8_element_level (ancestor) ==
-                     ts->t8_element_level (leaf) - 1);
-
-          *dual_faces[0] =
-            neigh_scheme->t8_element_face_parent_face (neighbor_leafs[0],
-                                                       *dual_faces[0]);
-          if (!at_maxlevel) {
-            /* We need to compute the dual face of the grandparent. */
-            /* Construct the parent of the grand child */
-            neigh_scheme->t8_element_parent (neighbor_leafs[0],
-                                             neighbor_leafs[0]);
-            /* Compute the face id of the parent's face */
-            *dual_faces[0] =
-              neigh_scheme->t8_element_face_parent_face (neighbor_leafs[0],
-                                                         *dual_faces[0]);
-          }
-        }
+int
+t8_forest_leaf_face_neighbors_scratch (t8_forest_t forest,
+                                       t8_locidx_t ltreeid,
+                                       const t8_element_t * leaf, int face,
+                                       t8_element_t *** pneighbor_leafs,
+                                       int **pdual_faces,
+                                       t8_locidx_t ** pelement_indices,
+                                       t8_eclass_scheme_c ** pneigh_scheme)
+{
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_t      **neighbor_leafs = NULL;
+  int                 capacity;
 
-        /* free memory */
-        neigh_scheme->t8_element_destroy (num_children_at_face - 1,
-                                          neighbor_leafs + 1);
-        /* copy the ancestor */
-        neigh_scheme->t8_element_copy (ancestor, neighbor_leafs[0]);
-        /* set return values */
-        *num_neighbors = 1;
-        *pelement_indices = T8_ALLOC (t8_locidx_t, 1);
-        (*pelement_indices)[0] = element_index;
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (pdual_faces != NULL && pelement_indices != NULL);
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  capacity = ts->t8_element_num_face_children (leaf, face);
+  if (pneighbor_leafs != NULL) {
+    neigh_scheme =
+      t8_forest_get_eclass_scheme (forest,
+                                   t8_forest_element_neighbor_eclass
+                                   (forest, ltreeid, leaf, face));
+    neighbor_leafs = *pneighbor_leafs = (t8_element_t **)
+      t8_element_scratch_alloc (capacity * sizeof (t8_element_t *));
+    t8_element_scratch_get (neigh_scheme, capacity, neighbor_leafs);
+  }
+  *pelement_indices = (t8_locidx_t *)
+    t8_element_scratch_alloc (capacity * sizeof (t8_locidx_t));
+  *pdual_faces = (int *) t8_element_scratch_alloc (capacity * sizeof (int));
+  return t8_forest_leaf_face_neighbors_ext (forest, ltreeid, leaf, face,
+                                            capacity, neighbor_leafs,
+                                            *pdual_faces, *pelement_indices,
+                                            pneigh_scheme, 1);
+}
 
-        T8_FREE (owners);
-        return;
-      }
+/* The bit of the return value of t8_forest_leaf_face_neighbors_begin that
+ * is set if it created the leaf keys. The other bits are partition tables. */
+#define T8_FOREST_LEAF_KEYS_CREATED 256
+
+/* Store the linear ids at maxlevel of all local elements and ghosts in
+ * forest->leaf_keys. */
+static void
+t8_forest_leaf_keys_create (t8_forest_t forest)
+{
+  t8_locidx_t         itree, num_trees, offset;
+  t8_tree_t           tree;
+  t8_element_array_t *elements;
+  t8_eclass_scheme_c *ts;
+  size_t              count;
+
+  T8_ASSERT (forest->leaf_keys == NULL);
+  forest->num_leaf_keys =
+    forest->local_num_elements + t8_forest_get_num_ghosts (forest);
+  forest->leaf_keys = T8_ALLOC (t8_linearidx_t,
+                                SC_MAX (forest->num_leaf_keys, 1));
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    count = t8_element_array_get_count (&tree->elements);
+    if (count > 0) {
+      ts = t8_forest_get_eclass_scheme (forest, tree->eclass);
+      ts->t8_element_get_linear_id_array (t8_element_array_get_data
+                                          (&tree->elements), count,
+                                          forest->maxlevel,
+                                          forest->leaf_keys +
+                                          tree->elements_offset);
     }
-    /* The leafs are the face neighbors that we are looking for. */
-    /* The face neighbors either belong to different processes and thus must be leafs
-     * in the forest, or the ancestor leaf of the first half neighbor is the half
-     * neighbor itself and thus all half neighbors must be leafs.
-     * Since the forest is balanced, we found all neighbor leafs.
-     * It remains to compute their local ids */
-    *num_neighbors = num_children_at_face;
-    *pelement_indices = T8_ALLOC (t8_locidx_t, num_children_at_face);
-    element_indices = *pelement_indices;
-    for (ineigh = 0; ineigh < num_children_at_face; ineigh++) {
-      /* Compute the linear id at maxlevel of the neighbor leaf */
-      neigh_id =
-        neigh_scheme->t8_element_get_linear_id (neighbor_leafs[ineigh],
-                                                forest->maxlevel);
-      /* Get a pointer to the element array in which the neighbor lies and search
-       * for the element's index in this array.
-       * This is either the local leaf array of the local tree or the corresponding leaf array
-       * in the ghost structure */
-      if (owners[ineigh] == forest->mpirank) {
-        /* The neighbor is a local leaf */
-        element_array =
-          t8_forest_get_tree_element_array (forest, lneigh_treeid);
-        /* Find the index of the neighbor in the array */
-        element_indices[ineigh] =
-          t8_forest_bin_search_lower (element_array, neigh_id,
-                                      forest->maxlevel);
-        T8_ASSERT (element_indices[ineigh] >= 0);
-        /* We have to add the tree's element offset to the index found to get
-         * the actual local element id */
-        element_indices[ineigh] +=
-          t8_forest_get_tree_element_offset (forest, lneigh_treeid);
-#if T8_ENABLE_DEBUG
-        /* We check whether the element is really the element at this local id */
-        {
-          t8_locidx_t         check_ltreeid;
-          t8_element_t       *check_element;
-          check_element =
-            t8_forest_get_element (forest, element_indices[ineigh],
-                                   &check_ltreeid);
-          T8_ASSERT (check_ltreeid == lneigh_treeid);
-          T8_ASSERT (!neigh_scheme->t8_element_compare (check_element,
-                                                        neighbor_leafs
-                                                        [ineigh]));
-        }
-#endif
-      }
-      else {
-        /* The neighbor is a ghost */
-        element_array =
-          t8_forest_ghost_get_tree_elements (forest, lghost_treeid);
-        /* Find the index of the neighbor in the array */
-        element_indices[ineigh] =
-          t8_forest_bin_search_lower (element_array, neigh_id,
-                                      forest->maxlevel);
+  }
+  if (forest->ghosts == NULL) {
+    return;
+  }
+  num_trees = t8_forest_ghost_num_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    elements = t8_forest_ghost_get_tree_elements (forest, itree);
+    count = t8_element_array_get_count (elements);
+    if (count > 0) {
+      ts = t8_forest_get_eclass_scheme (forest,
+                                        t8_forest_ghost_get_tree_class
+                                        (forest, itree));
+      offset = forest->local_num_elements
+        + t8_forest_ghost_get_tree_element_offset (forest, itree);
+      ts->t8_element_get_linear_id_array (t8_element_array_get_data
+                                          (elements), count,
+                                          forest->maxlevel,
+                                          forest->leaf_keys + offset);
+    }
+  }
+}
+
+int
+t8_forest_leaf_face_neighbors_begin (t8_forest_t forest)
+{
+  int                 created;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  SC_CHECK_ABORT (forest->mpisize == 1 || forest->ghosts != NULL,
+                  "The leaf face neighbors of a forest need a ghost layer.\n");
+  created = t8_forest_partition_tables_require (forest, T8_FOREST_TABLE_ALL);
+  if (forest->leaf_keys == NULL) {
+    t8_forest_leaf_keys_create (forest);
+    created |= T8_FOREST_LEAF_KEYS_CREATED;
+  }
+  return created;
+}
+
+void
+t8_forest_leaf_face_neighbors_end (t8_forest_t forest, int created_tables)
+{
+  if (created_tables & T8_FOREST_LEAF_KEYS_CREATED) {
+    T8_FREE (forest->leaf_keys);
+    forest->leaf_keys = NULL;
+    forest->num_leaf_keys = 0;
+  }
+  t8_forest_partition_tables_release (forest,
+                                      created_tables & T8_FOREST_TABLE_ALL);
+}
+
+void
+t8_forest_leaf_face_neighbors (t8_forest_t forest, t8_locidx_t ltreeid,
+                               const t8_element_t * leaf,
+                               t8_element_t ** pneighbor_leafs[],
+                               int face, int *dual_faces[],
+                               int *num_neighbors,
+                               t8_locidx_t ** pelement_indices,
+                               t8_eclass_scheme_c ** pneigh_scheme,
+                               int forest_is_balanced)
+{
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_eclass_t         neigh_class;
+  int                 capacity;
 
-#if T8_ENABLE_DEBUG
-        /* We check whether the element is really the element at this local id */
-        {
-          t8_element_t       *check_element;
-          check_element =
-            t8_forest_ghost_get_element (forest, lghost_treeid,
-                                         element_indices[ineigh]);
-          T8_ASSERT (!neigh_scheme->t8_element_compare (check_element,
-                                                        neighbor_leafs
-                                                        [ineigh]));
-        }
-#endif
-        /* Add the element offset of previous ghosts to this index */
-        element_indices[ineigh] +=
-          t8_forest_ghost_get_tree_element_offset (forest, lghost_treeid);
-        /* Add the number of all local elements to this index */
-        element_indices[ineigh] += t8_forest_get_num_element (forest);
-      }
-    }                           /* End for loop over neighbor leafs */
-    T8_FREE (owners);
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  neigh_class =
+    t8_forest_element_neighbor_eclass (forest, ltreeid, leaf, face);
+  neigh_scheme = t8_forest_get_eclass_scheme (forest, neigh_class);
+  /* Allocate the output for the maximum number of neighbors */
+  capacity = ts->t8_element_num_face_children (leaf, face);
+  *pneighbor_leafs = T8_ALLOC (t8_element_t *, capacity);
+  neigh_scheme->t8_element_new (capacity, *pneighbor_leafs);
+  *dual_faces = T8_ALLOC (int, capacity);
+  *pelement_indices = T8_ALLOC (t8_locidx_t, capacity);
+
+  *num_neighbors =
+    t8_forest_leaf_face_neighbors_ext (forest, ltreeid, leaf, face, capacity,
+                                       *pneighbor_leafs, *dual_faces,
+                                       *pelement_indices, pneigh_scheme,
+                                       forest_is_balanced);
+  T8_ASSERT (*pneigh_scheme == neigh_scheme);
+  if (*num_neighbors == 0) {
+    /* There exists no face neighbor across this face */
+    neigh_scheme->t8_element_destroy (capacity, *pneighbor_leafs);
+    T8_FREE (*pneighbor_leafs);
+    T8_FREE (*dual_faces);
+    T8_FREE (*pelement_indices);
+    *pneighbor_leafs = NULL;
+    *dual_faces = NULL;
+    *pelement_indices = NULL;
   }
-  else {
-    /* TODO: implement unbalanced version */
-    SC_ABORT_NOT_REACHED ();
+  else if (*num_neighbors < capacity) {
+    /* The neighbor is a single coarser or equal sized leaf */
+    neigh_scheme->t8_element_destroy (capacity - *num_neighbors,
+                                      *pneighbor_leafs + *num_neighbors);
   }
 }
 
@@ -1824,21 +3115,11 @@ t8_forest_print_all_leaf_neighbors (t8_forest_t forest)
   t8_locidx_t        *element_indices;
   int                *dual_faces;
   char                buffer[BUFSIZ];
-  int                 allocate_first_desc = 0, allocate_tree_offset = 0;
-  int                 allocate_el_offset = 0;
+  int                 created_tables;
+
+  created_tables =
+    t8_forest_partition_tables_require (forest, T8_FOREST_TABLE_ALL);
 
-  if (forest->tree_offsets == NULL) {
-    allocate_tree_offset = 1;
-    t8_forest_partition_create_tree_offsets (forest);
-  }
-  if (forest->global_first_desc == NULL) {
-    allocate_first_desc = 1;
-    t8_forest_partition_create_first_desc (forest);
-  }
-  if (forest->element_offsets == NULL) {
-    allocate_el_offset = 1;
-    t8_forest_partition_create_offsets (forest);
-  }
   for (ielem = 0; ielem < t8_forest_get_num_element (forest); ielem++) {
     /* Get a pointer to the ielem-th element, its eclass, treeid and scheme */
     leaf = t8_forest_get_element (forest, ielem, &ltree);
@@ -1868,15 +3149,667 @@ t8_forest_print_all_leaf_neighbors (t8_forest_t forest)
       }
     }
   }
-  if (allocate_tree_offset) {
-    t8_shmem_array_destroy (&forest->tree_offsets);
+  t8_forest_partition_tables_release (forest, created_tables);
+}
+
+/* Compute the orientation of the tree face connection at a face of a leaf.
+ * Returns 0 if the face is inside the tree or at the domain boundary. */
+static int
+t8_forest_face_connectivity_orientation (t8_forest_t forest,
+                                         t8_locidx_t ltreeid,
+                                         const t8_element_t * leaf,
+                                         t8_eclass_scheme_c * ts, int face)
+{
+  t8_cmesh_t          cmesh = forest->cmesh;
+  t8_locidx_t         lctree_id;
+  int8_t              ttf;
+  int                 tree_face, F;
+
+  if (!ts->t8_element_is_root_boundary (leaf, face)) {
+    /* The neighbor is in the same tree */
+    return 0;
+  }
+  tree_face = ts->t8_element_tree_face (leaf, face);
+  lctree_id = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltreeid);
+  if (t8_cmesh_tree_face_is_boundary (cmesh, lctree_id, tree_face)) {
+    return 0;
+  }
+  (void) t8_cmesh_trees_get_face_neighbor_ext (cmesh->trees, lctree_id,
+                                               tree_face, &ttf);
+  F = t8_eclass_max_num_faces[cmesh->dimension];
+  return ttf / F;
+}
+
+void
+t8_forest_face_connectivity_build (t8_forest_t forest)
+{
+  t8_forest_face_connectivity_t *conn;
+  t8_locidx_t         ltree, ielem, num_elements;
+  t8_locidx_t         num_face_entries, num_neigh_entries, iface_entry;
+  t8_element_t       *leaf;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  sc_array_t          neighbors, dual_faces;
+  int                 iface, num_faces, num_neighbors, capacity;
+  int                 created_tables;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->face_connectivity == NULL);
+
+  created_tables = t8_forest_leaf_face_neighbors_begin (forest);
+
+  num_elements = t8_forest_get_num_element (forest);
+  conn = T8_ALLOC (t8_forest_face_connectivity_t, 1);
+  conn->face_offsets = T8_ALLOC (t8_locidx_t, num_elements + 1);
+  /* Count the faces of all elements */
+  num_face_entries = 0;
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    leaf = t8_forest_get_element (forest, ielem, &ltree);
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltree));
+    conn->face_offsets[ielem] = num_face_entries;
+    num_face_entries += ts->t8_element_num_faces (leaf);
+  }
+  conn->face_offsets[num_elements] = num_face_entries;
+  conn->neigh_offsets = T8_ALLOC (t8_locidx_t, num_face_entries + 1);
+  conn->orientations = T8_ALLOC (int8_t, num_face_entries);
+
+  /* Collect the neighbors of all faces */
+  sc_array_init (&neighbors, sizeof (t8_locidx_t));
+  sc_array_init (&dual_faces, sizeof (int));
+  iface_entry = 0;
+  num_neigh_entries = 0;
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    leaf = t8_forest_get_element (forest, ielem, &ltree);
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltree));
+    num_faces = ts->t8_element_num_faces (leaf);
+    for (iface = 0; iface < num_faces; iface++, iface_entry++) {
+      conn->neigh_offsets[iface_entry] = num_neigh_entries;
+      conn->orientations[iface_entry] = (int8_t)
+        t8_forest_face_connectivity_orientation (forest, ltree, leaf, ts,
+                                                 iface);
+      /* Write the neighbors directly to the end of the arrays */
+      capacity = ts->t8_element_num_face_children (leaf, iface);
+      sc_array_resize (&neighbors, num_neigh_entries + capacity);
+      sc_array_resize (&dual_faces, num_neigh_entries + capacity);
+      num_neighbors =
+        t8_forest_leaf_face_neighbors_ext (forest, ltree, leaf, iface,
+                                           capacity, NULL,
+                                           (int *) sc_array_index
+                                           (&dual_faces, num_neigh_entries),
+                                           (t8_locidx_t *) sc_array_index
+                                           (&neighbors, num_neigh_entries),
+                                           &neigh_scheme, 1);
+      num_neigh_entries += num_neighbors;
+    }
+  }
+  T8_ASSERT (iface_entry == num_face_entries);
+  conn->neigh_offsets[num_face_entries] = num_neigh_entries;
+  sc_array_resize (&neighbors, num_neigh_entries);
+  sc_array_resize (&dual_faces, num_neigh_entries);
+
+  /* Copy the neighbors into arrays of their exact size */
+  conn->neighbors = T8_ALLOC (t8_locidx_t, num_neigh_entries);
+  conn->dual_faces = T8_ALLOC (int, num_neigh_entries);
+  if (num_neigh_entries > 0) {
+    memcpy (conn->neighbors, neighbors.array,
+            num_neigh_entries * sizeof (t8_locidx_t));
+    memcpy (conn->dual_faces, dual_faces.array,
+            num_neigh_entries * sizeof (int));
+  }
+  sc_array_reset (&neighbors);
+  sc_array_reset (&dual_faces);
+  forest->face_connectivity = conn;
+
+  t8_forest_leaf_face_neighbors_end (forest, created_tables);
+}
+
+void
+t8_forest_face_connectivity_destroy (t8_forest_t forest)
+{
+  t8_forest_face_connectivity_t *conn = forest->face_connectivity;
+
+  T8_ASSERT (conn != NULL);
+  T8_FREE (conn->face_offsets);
+  T8_FREE (conn->neigh_offsets);
+  T8_FREE (conn->neighbors);
+  T8_FREE (conn->dual_faces);
+  T8_FREE (conn->orientations);
+  T8_FREE (conn);
+  forest->face_connectivity = NULL;
+}
+
+/* The relative size below which a coefficient of a tree map counts as zero */
+#define T8_FOREST_TREE_MAP_EPS 1e-14
+
+/* Compute the left inverse (J^T J)^{-1} J^T of the first dim columns of J.
+ * Return false if these columns are linearly dependent. */
+static int
+t8_forest_tree_map_left_inverse (const double J[3][3], int dim,
+                                 double Jinv[3][3])
+{
+  double              A[3][3], Ainv[3][3], det, trace_pow;
+  int                 i, j, k;
+
+  T8_ASSERT (1 <= dim && dim <= 3);
+  /* The normal matrix A = J^T J, which is symmetric positive semidefinite */
+  for (j = 0; j < dim; j++) {
+    for (k = 0; k < dim; k++) {
+      A[j][k] = 0;
+      for (i = 0; i < 3; i++) {
+        A[j][k] += J[i][j] * J[i][k];
+      }
+    }
+  }
+  switch (dim) {
+  case 1:
+    det = A[0][0];
+    Ainv[0][0] = 1;
+    break;
+  case 2:
+    det = A[0][0] * A[1][1] - A[0][1] * A[1][0];
+    Ainv[0][0] = A[1][1];
+    Ainv[0][1] = -A[0][1];
+    Ainv[1][0] = -A[1][0];
+    Ainv[1][1] = A[0][0];
+    break;
+  default:
+    /* The adjugate of A */
+    Ainv[0][0] = A[1][1] * A[2][2] - A[1][2] * A[2][1];
+    Ainv[0][1] = A[0][2] * A[2][1] - A[0][1] * A[2][2];
+    Ainv[0][2] = A[0][1] * A[1][2] - A[0][2] * A[1][1];
+    Ainv[1][0] = A[1][2] * A[2][0] - A[1][0] * A[2][2];
+    Ainv[1][1] = A[0][0] * A[2][2] - A[0][2] * A[2][0];
+    Ainv[1][2] = A[0][2] * A[1][0] - A[0][0] * A[1][2];
+    Ainv[2][0] = A[1][0] * A[2][1] - A[1][1] * A[2][0];
+    Ainv[2][1] = A[0][1] * A[2][0] - A[0][0] * A[2][1];
+    Ainv[2][2] = A[0][0] * A[1][1] - A[0][1] * A[1][0];
+    det = A[0][0] * Ainv[0][0] + A[0][1] * Ainv[1][0]
+      + A[0][2] * Ainv[2][0];
+  }
+  /* Compare the determinant to the scale of A */
+  trace_pow = 1;
+  for (j = 0; j < dim; j++) {
+    trace_pow *= A[0][0] + (dim > 1 ? A[1][1] : 0) + (dim > 2 ? A[2][2] : 0);
+  }
+  if (!(det > T8_FOREST_TREE_MAP_EPS * trace_pow)) {
+    return 0;
+  }
+  for (j = 0; j < dim; j++) {
+    for (i = 0; i < 3; i++) {
+      Jinv[j][i] = 0;
+      for (k = 0; k < dim; k++) {
+        Jinv[j][i] += Ainv[j][k] * J[i][k] / det;
+      }
+    }
+  }
+  return 1;
+}
+
+void
+t8_forest_tree_maps_build (t8_forest_t forest)
+{
+  t8_forest_tree_map_t *map;
+  t8_locidx_t         itree, num_trees;
+  t8_eclass_t         eclass;
+  const double       *vertices;
+  double              scale;
+  int                 i, j, k;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->tree_maps == NULL);
+
+  num_trees = t8_forest_get_num_local_trees (forest)
+    + t8_forest_get_num_ghost_trees (forest);
+  if (num_trees == 0) {
+    return;
+  }
+  forest->tree_maps = T8_ALLOC_ZERO (t8_forest_tree_map_t, num_trees);
+  for (itree = 0; itree < num_trees; itree++) {
+    map = forest->tree_maps + itree;
+    eclass = t8_forest_get_tree_class (forest, itree);
+    vertices = t8_forest_get_tree_vertices (forest, itree);
+    if (vertices == NULL || eclass == T8_ECLASS_PYRAMID) {
+      /* This tree has no map, its vertices stay NULL */
+      continue;
+    }
+    t8_geometry_linear_coefficients (eclass, vertices, map->coeffs);
+    map->vertices = vertices;
+    map->dim = t8_eclass_to_dimension[eclass];
+    /* The map is affine if its nonlinear coefficients vanish */
+    scale = 0;
+    for (k = 1; k < 4; k++) {
+      for (i = 0; i < 3; i++) {
+        scale = SC_MAX (scale, fabs (map->coeffs[k][i]));
+      }
+    }
+    map->affine = 1;
+    for (k = 4; k < T8_GEOMETRY_LINEAR_COEFFS; k++) {
+      for (i = 0; i < 3; i++) {
+        if (fabs (map->coeffs[k][i]) > T8_FOREST_TREE_MAP_EPS * scale) {
+          map->affine = 0;
+        }
+      }
+    }
+    if (map->affine) {
+      for (i = 0; i < 3; i++) {
+        for (j = 0; j < 3; j++) {
+          map->jacobian[i][j] = j < map->dim ? map->coeffs[1 + j][i] : 0;
+        }
+      }
+      map->invertible = map->dim > 0
+        && t8_forest_tree_map_left_inverse (map->jacobian, map->dim,
+                                            map->jacobian_inv);
+    }
+  }
+}
+
+const t8_forest_tree_map_t *
+t8_forest_get_tree_map (t8_forest_t forest, t8_locidx_t ltreeid)
+{
+  const t8_forest_tree_map_t *map;
+
+  if (forest->tree_maps == NULL) {
+    return NULL;
+  }
+  T8_ASSERT (0 <= ltreeid && ltreeid < t8_forest_get_num_local_trees (forest)
+             + t8_forest_get_num_ghost_trees (forest));
+  map = forest->tree_maps + ltreeid;
+  return map->vertices != NULL ? map : NULL;
+}
+
+void
+t8_forest_tree_map_evaluate (const t8_forest_tree_map_t * map,
+                             const double ref[3], double x[3])
+{
+  const double        u = map->dim > 0 ? ref[0] : 0;
+  const double        v = map->dim > 1 ? ref[1] : 0;
+  const double        w = map->dim > 2 ? ref[2] : 0;
+  int                 i;
+
+  for (i = 0; i < 3; i++) {
+    x[i] = map->coeffs[0][i] + map->coeffs[1][i] * u
+      + map->coeffs[2][i] * v + map->coeffs[3][i] * w
+      + u * (map->coeffs[4][i] * v + map->coeffs[5][i] * w)
+      + v * w * (map->coeffs[6][i] + map->coeffs[7][i] * u);
+  }
+}
+
+void
+t8_forest_tree_map_jacobian (const t8_forest_tree_map_t * map,
+                             const double ref[3], double J[3][3])
+{
+  const double        u = map->dim > 0 ? ref[0] : 0;
+  const double        v = map->dim > 1 ? ref[1] : 0;
+  const double        w = map->dim > 2 ? ref[2] : 0;
+  int                 i;
+
+  if (map->affine) {
+    memcpy (J, map->jacobian, 9 * sizeof (double));
+    return;
+  }
+  for (i = 0; i < 3; i++) {
+    J[i][0] = map->coeffs[1][i] + map->coeffs[4][i] * v
+      + map->coeffs[5][i] * w + map->coeffs[7][i] * v * w;
+    J[i][1] = map->dim > 1 ? map->coeffs[2][i] + map->coeffs[4][i] * u
+      + map->coeffs[6][i] * w + map->coeffs[7][i] * u * w : 0;
+    J[i][2] = map->dim > 2 ? map->coeffs[3][i] + map->coeffs[5][i] * u
+      + map->coeffs[6][i] * v + map->coeffs[7][i] * u * v : 0;
+  }
+}
+
+void
+t8_forest_geometry_cache_build (t8_forest_t forest)
+{
+  t8_forest_geometry_cache_t *cache;
+  t8_locidx_t         num_elements, num_trees, num_tree_elements;
+  t8_locidx_t         ltree, ielem, lelement, num_face_entries, iface_entry;
+  t8_locidx_t         ibatch, num_batch, first_entry, num_batch_entries;
+  t8_eclass_scheme_c *ts;
+  t8_eclass_t         eclass;
+  t8_element_t       *element;
+  double             *vertices, coords[3], corner[3], volume, dist;
+  double             *corners, *cross, *set_volumes, *normals;
+  int                 iface, num_faces, i, with_normals;
+  int                 icorner, num_corners;
+  int                 batch_volumes, batch_normals, num_sets, iset;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->geometry_cache == NULL);
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_trees = t8_forest_get_num_local_trees (forest);
+  /* The face normals are only defined for faces of dimension 1 and 2 */
+  with_normals = forest->dimension >= 2;
+  cache = T8_ALLOC_ZERO (t8_forest_geometry_cache_t, 1);
+  cache->volumes = T8_ALLOC (double, num_elements);
+  cache->diameters = T8_ALLOC (double, num_elements);
+  for (i = 0; i < 3; i++) {
+    cache->centroids[i] = T8_ALLOC (double, num_elements);
+  }
+  cache->face_offsets = T8_ALLOC (t8_locidx_t, num_elements + 1);
+
+  /* Count the faces of all elements */
+  num_face_entries = 0;
+  lelement = 0;
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltree));
+    num_tree_elements = t8_forest_get_tree_num_elements (forest, ltree);
+    for (ielem = 0; ielem < num_tree_elements; ielem++, lelement++) {
+      element = t8_forest_get_element_in_tree (forest, ltree, ielem);
+      cache->face_offsets[lelement] = num_face_entries;
+      num_face_entries += ts->t8_element_num_faces (element);
+    }
+  }
+  cache->face_offsets[num_elements] = num_face_entries;
+  cache->face_areas = T8_ALLOC (double, num_face_entries);
+  if (with_normals) {
+    for (i = 0; i < 3; i++) {
+      cache->face_normals[i] = T8_ALLOC (double, num_face_entries);
+    }
+  }
+
+  /* Compute the geometry of each element and face. We compute the volumes
+   * and face normals of T8_FOREST_GEOMETRY_BATCH elements at once, such
+   * that the vector arithmetic runs over arrays of points. A batch holds
+   * up to three spanning sets per element and up to
+   * T8_ECLASS_MAX_FACES faces per element. */
+  corners = T8_ALLOC (double, 4 * 3 * T8_ECLASS_MAX_FACES
+                      * T8_FOREST_GEOMETRY_BATCH);
+  cross = T8_ALLOC (double, 3 * T8_ECLASS_MAX_FACES
+                    * T8_FOREST_GEOMETRY_BATCH);
+  set_volumes = T8_ALLOC (double, 2 * T8_ECLASS_MAX_FACES
+                          * T8_FOREST_GEOMETRY_BATCH);
+  normals = T8_ALLOC (double, 3 * T8_ECLASS_MAX_FACES
+                      * T8_FOREST_GEOMETRY_BATCH);
+  /* The face normals of 3D elements are computed in batches, the normals of
+   * line faces one by one */
+  batch_normals = forest->dimension == 3;
+  lelement = 0;
+  iface_entry = 0;
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    eclass = t8_forest_get_tree_class (forest, ltree);
+    ts = t8_forest_get_eclass_scheme (forest, eclass);
+    vertices = t8_forest_get_tree_vertices (forest, ltree);
+    SC_CHECK_ABORT (vertices != NULL,
+                    "The geometry cache needs the tree vertices.\n");
+    num_tree_elements = t8_forest_get_tree_num_elements (forest, ltree);
+    batch_volumes = t8_forest_volume_has_corners (eclass);
+    num_sets = eclass == T8_ECLASS_PRISM ? 3 : 1;
+    for (ielem = 0; ielem < num_tree_elements; ielem += num_batch) {
+      num_batch = SC_MIN (T8_FOREST_GEOMETRY_BATCH,
+                          num_tree_elements - ielem);
+      /* The volumes and centroids */
+      for (ibatch = 0; ibatch < num_batch; ibatch++) {
+        element = t8_forest_get_element_in_tree (forest, ltree,
+                                                 ielem + ibatch);
+        if (batch_volumes) {
+          (void) t8_forest_element_volume_corners (forest, ltree, element,
+                                                   vertices, eclass, corners,
+                                                   num_sets * num_batch,
+                                                   num_sets * ibatch);
+        }
+        else {
+          cache->volumes[lelement + ibatch] =
+            t8_forest_element_volume (forest, ltree, element, vertices);
+        }
+        t8_forest_element_centroid (forest, ltree, element, vertices,
+                                    coords);
+        for (i = 0; i < 3; i++) {
+          cache->centroids[i][lelement + ibatch] = coords[i];
+        }
+        /* The diameter as in t8_forest_element_diam, but with the
+         * centroid that we already have */
+        num_corners = ts->t8_element_num_corners (element);
+        dist = 0;
+        for (icorner = 0; icorner < num_corners; icorner++) {
+          t8_forest_element_coordinate (forest, ltree, element, vertices,
+                                        icorner, corner);
+          dist += t8_vec_dist (corner, coords);
+        }
+        cache->diameters[lelement + ibatch] = 2 * dist / num_corners;
+      }
+      if (batch_volumes) {
+        t8_forest_volume_kernel (t8_eclass_to_dimension[eclass],
+                                 num_sets * num_batch, corners, cross,
+                                 set_volumes);
+        for (ibatch = 0; ibatch < num_batch; ibatch++) {
+          volume = 0;
+          for (iset = 0; iset < num_sets; iset++) {
+            volume += set_volumes[num_sets * ibatch + iset];
+          }
+          cache->volumes[lelement + ibatch] =
+            t8_forest_volume_factor (eclass) * volume;
+        }
+      }
+      /* The face areas and normals */
+      first_entry = iface_entry;
+      num_batch_entries = cache->face_offsets[lelement + num_batch]
+        - first_entry;
+      for (ibatch = 0; ibatch < num_batch; ibatch++) {
+        element = t8_forest_get_element_in_tree (forest, ltree,
+                                                 ielem + ibatch);
+        for (i = 0; i < 3; i++) {
+          coords[i] = cache->centroids[i][lelement + ibatch];
+        }
+        num_faces = ts->t8_element_num_faces (element);
+        for (iface = 0; iface < num_faces; iface++, iface_entry++) {
+          cache->face_areas[iface_entry] =
+            t8_forest_element_face_area (forest, ltree, element, iface,
+                                         vertices);
+          if (batch_normals) {
+            t8_forest_element_face_normal_corners (forest, ltree, element,
+                                                   iface, vertices, coords,
+                                                   corners,
+                                                   num_batch_entries,
+                                                   iface_entry -
+                                                   first_entry);
+          }
+          else if (with_normals) {
+            t8_forest_element_face_normal (forest, ltree, element, iface,
+                                           vertices, normals);
+            for (i = 0; i < 3; i++) {
+              cache->face_normals[i][iface_entry] = normals[i];
+            }
+          }
+        }
+      }
+      if (batch_normals) {
+        t8_forest_face_normal_kernel (num_batch_entries, corners,
+                                      set_volumes, normals);
+        /* The batch and the cache store the normals as arrays of
+         * coordinates */
+        for (i = 0; i < 3; i++) {
+          memcpy (cache->face_normals[i] + first_entry,
+                  normals + i * num_batch_entries,
+                  num_batch_entries * sizeof (double));
+        }
+      }
+      lelement += num_batch;
+    }
+  }
+  T8_FREE (corners);
+  T8_FREE (cross);
+  T8_FREE (set_volumes);
+  T8_FREE (normals);
+  T8_ASSERT (iface_entry == num_face_entries);
+  forest->geometry_cache = cache;
+}
+
+void
+t8_forest_geometry_cache_destroy (t8_forest_t forest)
+{
+  t8_forest_geometry_cache_t *cache = forest->geometry_cache;
+  int                 i;
+
+  T8_ASSERT (cache != NULL);
+  T8_FREE (cache->volumes);
+  T8_FREE (cache->diameters);
+  T8_FREE (cache->face_offsets);
+  T8_FREE (cache->face_areas);
+  for (i = 0; i < 3; i++) {
+    T8_FREE (cache->centroids[i]);
+    T8_FREE (cache->face_normals[i]);
+  }
+  T8_FREE (cache);
+  forest->geometry_cache = NULL;
+}
+
+/* Add an edge to the adjacency list of the current element, which starts
+ * at entry first of adjncy. If the edge exists, we add its weight. */
+static void
+t8_forest_dual_graph_add_edge (sc_array_t * adjncy, sc_array_t * adjwgt,
+                               size_t first, t8_gloidx_t neighbor,
+                               double weight)
+{
+  size_t              iedge;
+
+  for (iedge = first; iedge < adjncy->elem_count; iedge++) {
+    if (*(t8_gloidx_t *) sc_array_index (adjncy, iedge) == neighbor) {
+      /* The neighbor is adjacent through more than one face */
+      if (adjwgt != NULL) {
+        *(double *) sc_array_index (adjwgt, iedge) += weight;
+      }
+      return;
+    }
+  }
+  *(t8_gloidx_t *) sc_array_push (adjncy) = neighbor;
+  if (adjwgt != NULL) {
+    *(double *) sc_array_push (adjwgt) = weight;
+  }
+}
+
+void
+t8_forest_build_dual_graph (t8_forest_t forest, int with_weights,
+                            t8_locidx_t ** pxadj, t8_gloidx_t ** padjncy,
+                            double **padjwgt)
+{
+  t8_locidx_t         num_elements, num_ghosts, ltree, ielem, lelement;
+  t8_locidx_t         num_trees, num_tree_elements, *xadj;
+  t8_locidx_t        *element_indices;
+  const t8_locidx_t  *neighbors;
+  t8_gloidx_t         first_id, *global_ids;
+  t8_element_t       *leaf;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_scratch_mark_t scratch_mark;
+  sc_array_t          ids, adjncy, adjwgt;
+  const int          *const_dual_faces;
+  double             *vertices = NULL, weight;
+  size_t              first;
+  int                *dual_faces;
+  int                 iface, num_faces, num_neighbors, ineigh;
+  int                 use_table;
+  int                 created_tables = 0;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (pxadj != NULL && padjncy != NULL);
+  T8_ASSERT (!with_weights || padjwgt != NULL);
+  SC_CHECK_ABORT (forest->mpisize == 1 || forest->ghosts != NULL,
+                  "The dual graph of a forest needs a ghost layer.\n");
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  /* Compute the global ids of the local elements and receive the global
+   * ids of the ghosts from their owners */
+  first_id = t8_forest_get_first_local_element_id (forest);
+  sc_array_init_size (&ids, sizeof (t8_gloidx_t), num_elements + num_ghosts);
+  global_ids = (t8_gloidx_t *) ids.array;
+  for (lelement = 0; lelement < num_elements; lelement++) {
+    global_ids[lelement] = first_id + lelement;
+  }
+  if (forest->ghosts != NULL) {
+    t8_forest_ghost_exchange_data (forest, &ids);
+  }
+
+  /* Without a face connectivity table, we compute the leaf face neighbors */
+  use_table = forest->face_connectivity != NULL;
+  if (!use_table) {
+    created_tables = t8_forest_leaf_face_neighbors_begin (forest);
+  }
+
+  xadj = *pxadj = T8_ALLOC (t8_locidx_t, num_elements + 1);
+  sc_array_init (&adjncy, sizeof (t8_gloidx_t));
+  sc_array_init (&adjwgt, sizeof (double));
+  num_trees = t8_forest_get_num_local_trees (forest);
+  lelement = 0;
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltree));
+    if (with_weights) {
+      vertices = t8_forest_get_tree_vertices (forest, ltree);
+      SC_CHECK_ABORT (vertices != NULL,
+                      "Dual graph weights need the tree vertices.\n");
+    }
+    num_tree_elements = t8_forest_get_tree_num_elements (forest, ltree);
+    for (ielem = 0; ielem < num_tree_elements; ielem++, lelement++) {
+      leaf = t8_forest_get_element_in_tree (forest, ltree, ielem);
+      first = adjncy.elem_count;
+      xadj[lelement] = (t8_locidx_t) first;
+      num_faces = ts->t8_element_num_faces (leaf);
+      for (iface = 0; iface < num_faces; iface++) {
+        t8_element_scratch_mark (&scratch_mark);
+        if (use_table) {
+          num_neighbors =
+            t8_forest_get_face_connectivity_neighbors (forest, lelement,
+                                                       iface, &neighbors,
+                                                       &const_dual_faces,
+                                                       NULL);
+        }
+        else {
+          num_neighbors =
+            t8_forest_leaf_face_neighbors_scratch (forest, ltree, leaf,
+                                                   iface, NULL, &dual_faces,
+                                                   &element_indices,
+                                                   &neigh_scheme);
+          neighbors = element_indices;
+        }
+        if (num_neighbors > 0) {
+          /* The face area is shared among the neighbors */
+          weight = with_weights ?
+            t8_forest_element_face_area (forest, ltree, leaf, iface,
+                                         vertices) / num_neighbors : 0;
+          for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+            if (neighbors[ineigh] != lelement) {
+              /* We do not store edges of an element to itself */
+              t8_forest_dual_graph_add_edge (&adjncy,
+                                             with_weights ? &adjwgt : NULL,
+                                             first,
+                                             global_ids[neighbors[ineigh]],
+                                             weight);
+            }
+          }
+        }
+        t8_element_scratch_release (&scratch_mark);
+      }
+    }
+  }
+  T8_ASSERT (lelement == num_elements);
+  xadj[num_elements] = (t8_locidx_t) adjncy.elem_count;
+
+  /* Copy the edges into arrays of their exact size */
+  *padjncy = T8_ALLOC (t8_gloidx_t, adjncy.elem_count);
+  if (adjncy.elem_count > 0) {
+    memcpy (*padjncy, adjncy.array, adjncy.elem_count * sizeof (t8_gloidx_t));
   }
-  if (allocate_first_desc) {
-    t8_shmem_array_destroy (&forest->global_first_desc);
+  if (with_weights) {
+    *padjwgt = T8_ALLOC (double, adjwgt.elem_count);
+    if (adjwgt.elem_count > 0) {
+      memcpy (*padjwgt, adjwgt.array, adjwgt.elem_count * sizeof (double));
+    }
   }
-  if (allocate_el_offset) {
-    t8_shmem_array_destroy (&forest->element_offsets);
+  else if (padjwgt != NULL) {
+    *padjwgt = NULL;
   }
+  sc_array_reset (&adjncy);
+  sc_array_reset (&adjwgt);
+  sc_array_reset (&ids);
+
+  t8_forest_leaf_face_neighbors_end (forest, created_tables);
 }
 
 /* Check if an element is owned by a specific rank */
@@ -1918,12 +3851,15 @@ t8_forest_element_check_owner (t8_forest_t forest,
       ts = t8_forest_get_eclass_scheme (forest, eclass);
       /* Compute the linear id of the first descendant of element */
       if (!element_is_desc) {
-        ts->t8_element_new (1, &first_desc);
+        t8_element_scratch_mark_t scratch_mark;
+
+        t8_element_scratch_mark (&scratch_mark);
+        t8_element_scratch_get (ts, 1, &first_desc);
         ts->t8_element_first_descendant (element, first_desc,
                                          forest->maxlevel);
         first_desc_id =
           ts->t8_element_get_linear_id (first_desc, forest->maxlevel);
-        ts->t8_element_destroy (1, &first_desc);
+        t8_element_scratch_release (&scratch_mark);
       }
       else {
         /* The element is its own first descendant */
@@ -2025,6 +3961,7 @@ t8_forest_element_find_owner_ext (t8_forest_t forest,
                                   int element_is_desc)
 {
   t8_element_t       *first_desc;
+  t8_element_scratch_mark_t scratch_mark;
   t8_eclass_scheme_c *ts;
   t8_gloidx_t        *first_trees, *element_offsets;
   t8_gloidx_t         current_first_tree;
@@ -2055,7 +3992,8 @@ t8_forest_element_find_owner_ext (t8_forest_t forest,
   }
   else {
     /* Build the first descendant of element */
-    ts->t8_element_new (1, &first_desc);
+    t8_element_scratch_mark (&scratch_mark);
+    t8_element_scratch_get (ts, 1, &first_desc);
     ts->t8_element_first_descendant (element, first_desc, forest->maxlevel);
   }
 
@@ -2177,7 +4115,7 @@ t8_forest_element_find_owner_ext (t8_forest_t forest,
 
   /* clean-up */
   if (!element_is_desc) {
-    ts->t8_element_destroy (1, &first_desc);
+    t8_element_scratch_release (&scratch_mark);
   }
   T8_ASSERT (t8_forest_element_check_owner
              (forest, element, gtreeid, eclass, guess, element_is_desc));
@@ -2193,6 +4131,105 @@ t8_forest_element_find_owner (t8_forest_t forest, t8_gloidx_t gtreeid,
                                            (forest->mpisize - 1) / 2, 0);
 }
 
+/* Return true if the nonempty process rank starts after the element with
+ * first descendant id desc_id in tree gtreeid. */
+static int
+t8_forest_owner_starts_after (t8_gloidx_t * first_trees,
+                              t8_linearidx_t * first_descs, int rank,
+                              t8_gloidx_t gtreeid, t8_linearidx_t desc_id)
+{
+  t8_gloidx_t         first_tree = t8_offset_first (rank, first_trees);
+
+  return first_tree > gtreeid
+    || (first_tree == gtreeid && first_descs[rank] > desc_id);
+}
+
+void
+t8_forest_element_find_owners (t8_forest_t forest, t8_gloidx_t gtreeid,
+                               t8_element_t ** elements, t8_eclass_t eclass,
+                               int num_elements, int elements_are_desc,
+                               int *owners)
+{
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *first_desc;
+  t8_element_scratch_mark_t scratch_mark;
+  t8_gloidx_t        *first_trees;
+  t8_linearidx_t     *first_descs, desc_id;
+  int                 ielem, owner, next_owner;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (0 <= gtreeid
+             && gtreeid < t8_forest_get_num_global_trees (forest));
+  T8_ASSERT (num_elements >= 0);
+  T8_ASSERT (num_elements == 0 || (elements != NULL && owners != NULL));
+  T8_ASSERT (forest->tree_offsets != NULL);
+  T8_ASSERT (forest->global_first_desc != NULL);
+
+  if (num_elements == 0) {
+    return;
+  }
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  first_trees = t8_shmem_array_get_gloidx_array (forest->tree_offsets);
+  first_descs =
+    (t8_linearidx_t *) t8_shmem_array_get_array (forest->global_first_desc);
+  if (!elements_are_desc) {
+    t8_element_scratch_mark (&scratch_mark);
+    t8_element_scratch_get (ts, 1, &first_desc);
+  }
+  owner = -1;
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    if (elements_are_desc) {
+      first_desc = elements[ielem];
+    }
+    else {
+      ts->t8_element_first_descendant (elements[ielem], first_desc,
+                                       forest->maxlevel);
+    }
+    desc_id = ts->t8_element_get_linear_id (first_desc,
+                                            ts->t8_element_level
+                                            (first_desc));
+    if (owner < 0) {
+      /* The first element, we search all processes */
+      owner =
+        t8_forest_element_find_owner_ext (forest, gtreeid, first_desc,
+                                          eclass, 0, forest->mpisize - 1,
+                                          (forest->mpisize - 1) / 2, 1);
+    }
+    else if (t8_forest_owner_starts_after (first_trees, first_descs, owner,
+                                           gtreeid, desc_id)) {
+      /* The elements are not in SFC order, we search the smaller
+       * processes */
+      T8_ASSERT (owner > 0);
+      owner =
+        t8_forest_element_find_owner_ext (forest, gtreeid, first_desc,
+                                          eclass, 0, owner - 1,
+                                          (owner - 1) / 2, 1);
+    }
+    else {
+      next_owner = t8_offset_next_nonempty_rank (owner, forest->mpisize,
+                                                 first_trees);
+      if (next_owner < forest->mpisize
+          && !t8_forest_owner_starts_after (first_trees, first_descs,
+                                            next_owner, gtreeid, desc_id)) {
+        /* The element lies on a greater process. In SFC order, this is
+         * usually the next one, we start to search there. */
+        owner =
+          t8_forest_element_find_owner_ext (forest, gtreeid, first_desc,
+                                            eclass, next_owner,
+                                            forest->mpisize - 1, next_owner,
+                                            1);
+      }
+      /* Otherwise the element lies on the same process as the previous one */
+    }
+    T8_ASSERT (t8_forest_element_check_owner (forest, first_desc, gtreeid,
+                                              eclass, owner, 1));
+    owners[ielem] = owner;
+  }
+  if (!elements_are_desc) {
+    t8_element_scratch_release (&scratch_mark);
+  }
+}
+
 /* This is a deprecated version of the element_find_owner algorithm which
  * searches for the owners of the coarse tree first */
 int
@@ -2210,20 +4247,12 @@ t8_forest_element_find_owner_old (t8_forest_t forest,
   ssize_t             proc_index;
   struct find_owner_data_t find_owner_data;
 
-  if (forest->tree_offsets == NULL) {
-    /* If the offset of global tree ids is not created, create it now.
-     * Once created, we do not delete it in this function, since we expect
-     * multiple calls to find_owner in a row.
-     */
-    t8_forest_partition_create_tree_offsets (forest);
-  }
-  if (forest->global_first_desc == NULL) {
-    /* If the offset of first global ids is not created, create it now.
-     * Once created, we do not delete it in this function, since we expect
-     * multiple calls to find_owner in a row.
-     */
-    t8_forest_partition_create_first_desc (forest);
-  }
+  /* If the offsets of global tree ids and first global ids are not created,
+   * create them now. Once created, we do not delete them in this function,
+   * since we expect multiple calls to find_owner in a row. */
+  (void) t8_forest_partition_tables_require (forest,
+                                             T8_FOREST_TABLE_TREE_OFFSETS |
+                                             T8_FOREST_TABLE_FIRST_DESC);
 
   /* In owners_of_tree we will store all processes that have elements of the
    * tree gtreeid. */
@@ -2327,15 +4356,20 @@ t8_forest_element_owners_at_face_recursion (t8_forest_t forest,
                                             t8_element_t * last_desc)
 {
   t8_element_t       *first_face_desc, *last_face_desc, **face_children;
+  t8_element_scratch_mark_t scratch_mark;
   int                 first_owner, last_owner;
   int                 num_children, ichild;
   int                 child_face;
   int                 last_owner_entry;
 
   T8_ASSERT (element != NULL);
+  /* All temporary elements come from the scratch arena, since the top-down
+   * ghost search calls this function from several threads. The given
+   * descendants belong to the caller and stay valid. */
+  t8_element_scratch_mark (&scratch_mark);
   /* Create first and last descendants at face */
   if (first_desc == NULL) {
-    ts->t8_element_new (1, &first_face_desc);
+    t8_element_scratch_get (ts, 1, &first_face_desc);
     ts->t8_element_first_descendant_face (element, face, first_face_desc,
                                           forest->maxlevel);
   }
@@ -2343,7 +4377,7 @@ t8_forest_element_owners_at_face_recursion (t8_forest_t forest,
     first_face_desc = first_desc;
   }
   if (last_desc == NULL) {
-    ts->t8_element_new (1, &last_face_desc);
+    t8_element_scratch_get (ts, 1, &last_face_desc);
     ts->t8_element_last_descendant_face (element, face, last_face_desc,
                                          forest->maxlevel);
   }
@@ -2355,12 +4389,11 @@ t8_forest_element_owners_at_face_recursion (t8_forest_t forest,
       /* Check if the computed or given descendants are the correct descendant */
       t8_element_t *test_desc;
 
-      ts->t8_element_new (1, &test_desc);
+      t8_element_scratch_get (ts, 1, &test_desc);
       ts->t8_element_last_descendant_face (element, face, test_desc, forest->maxlevel);
       T8_ASSERT (!ts->t8_element_compare (test_desc, last_face_desc));
       ts->t8_element_first_descendant_face (element, face, test_desc, forest->maxlevel);
       T8_ASSERT (!ts->t8_element_compare (test_desc, first_face_desc));
-      ts->t8_element_destroy (1, &test_desc);
     }
 #endif
 
@@ -2395,8 +4428,7 @@ t8_forest_element_owners_at_face_recursion (t8_forest_t forest,
     T8_ASSERT (t8_forest_element_check_owner (forest, first_face_desc, gtreeid, eclass, first_owner, 1));
     T8_ASSERT (t8_forest_element_check_owner (forest, last_face_desc, gtreeid, eclass, first_owner, 1));
     /* free memory */
-    ts->t8_element_destroy (1, &first_face_desc);
-    ts->t8_element_destroy (1, &last_face_desc);
+    t8_element_scratch_release (&scratch_mark);
     return;
   }
   else {
@@ -2406,8 +4438,9 @@ t8_forest_element_owners_at_face_recursion (t8_forest_t forest,
      * children and continue with the recursion. */
     num_children = ts->t8_element_num_face_children (element, face);
     /* allocate memory */
-    face_children = T8_ALLOC (t8_element_t *, num_children);
-    ts->t8_element_new (num_children, face_children);
+    face_children = (t8_element_t **)
+      t8_element_scratch_alloc (num_children * sizeof (t8_element_t *));
+    t8_element_scratch_get (ts, num_children, face_children);
     /* construct the children of element that touch face */
     ts->t8_element_children_at_face (element, face, face_children,
                                      num_children, NULL);
@@ -2419,15 +4452,16 @@ t8_forest_element_owners_at_face_recursion (t8_forest_t forest,
       first_desc = (ichild == 0 ? first_face_desc : NULL);
       /* For the last child, we reuse the last descendant */
       last_desc = (ichild == num_children - 1 ? last_face_desc : NULL);
+      /* The owners of all face children are between the owners of the
+       * first and the last face descendant, we use them as bounds. */
       t8_forest_element_owners_at_face_recursion (forest, gtreeid,
                                                   face_children[ichild],
                                                   eclass, ts, child_face,
                                                   owners,
-                                                  lower_bound, upper_bound,
+                                                  first_owner, last_owner,
                                                   first_desc, last_desc);
     }
-    ts->t8_element_destroy (num_children, face_children);
-    T8_FREE (face_children);
+    t8_element_scratch_release (&scratch_mark);
   }
 }
 
@@ -2444,7 +4478,8 @@ t8_forest_element_owners_at_face (t8_forest_t forest, t8_gloidx_t gtreeid,
     /* Compute lower and upper bound for the owners */
     lower_bound = *(int *) sc_array_index (owners, 0);
     upper_bound = *(int *) sc_array_index (owners, 1);
-    sc_array_resize (owners, 0);
+    /* Keep the memory of owners, such that a caller may reserve it */
+    sc_array_truncate (owners);
   }
   else {
     lower_bound = 0;
@@ -2475,25 +4510,29 @@ t8_forest_element_owners_bounds (t8_forest_t forest, t8_gloidx_t gtreeid,
                                  int * lower, int * upper)
 {
   t8_eclass_scheme_c * ts;
-  t8_element_t *first_desc, *last_desc;
+  t8_element_t *descs[2];
+  t8_element_scratch_mark_t scratch_mark;
 
   if (*lower >= *upper) {
     /* Either there is no owner or it is unique. */
     return;
   }
 
-  /* Compute the first and last descendant of element */
+  /* Compute the first and last descendant of element. This function is
+   * called on each level of the top-down ghost search, thus we take them
+   * from the scratch arena. */
   ts = t8_forest_get_eclass_scheme (forest, eclass);
-  ts->t8_element_new (1, &first_desc);
-  ts->t8_element_first_descendant (element, first_desc, forest->maxlevel);
-  ts->t8_element_new (1, &last_desc);
-  ts->t8_element_last_descendant (element, last_desc, forest->maxlevel);
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (ts, 2, descs);
+  ts->t8_element_first_descendant (element, descs[0], forest->maxlevel);
+  ts->t8_element_last_descendant (element, descs[1], forest->maxlevel);
 
   /* Compute their owners as bounds for all of element's owners */
-  *lower = t8_forest_element_find_owner_ext (forest, gtreeid, first_desc,
+  *lower = t8_forest_element_find_owner_ext (forest, gtreeid, descs[0],
                                              eclass, *lower, *upper, *lower, 1);
-  *upper = t8_forest_element_find_owner_ext (forest, gtreeid, last_desc,
+  *upper = t8_forest_element_find_owner_ext (forest, gtreeid, descs[1],
                                              eclass, *lower, *upper, *upper, 1);
+  t8_element_scratch_release (&scratch_mark);
 }
 
 void
@@ -2503,7 +4542,8 @@ t8_forest_element_owners_at_face_bounds (t8_forest_t forest, t8_gloidx_t gtreeid
                                   int * upper)
 {
   t8_eclass_scheme_c * ts;
-  t8_element_t *first_face_desc, *last_face_desc;
+  t8_element_t *face_descs[2];
+  t8_element_scratch_mark_t scratch_mark;
 
   if (*lower >= *upper) {
     /* Either there is no owner or it is unique. */
@@ -2511,20 +4551,21 @@ t8_forest_element_owners_at_face_bounds (t8_forest_t forest, t8_gloidx_t gtreeid
   }
 
   ts = t8_forest_get_eclass_scheme (forest, eclass);
-    ts->t8_element_new (1, &first_face_desc);
-    ts->t8_element_first_descendant_face (element, face, first_face_desc, forest->maxlevel);
-    ts->t8_element_new (1, &last_face_desc);
-    ts->t8_element_last_descendant_face (element, face, last_face_desc, forest->maxlevel);
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (ts, 2, face_descs);
+  ts->t8_element_first_descendant_face (element, face, face_descs[0],
+                                        forest->maxlevel);
+  ts->t8_element_last_descendant_face (element, face, face_descs[1],
+                                       forest->maxlevel);
 
   /* owner of first and last descendants */
   *lower =
-    t8_forest_element_find_owner_ext (forest, gtreeid, first_face_desc, eclass,
-                                          *lower, *upper, *lower, 1);
+    t8_forest_element_find_owner_ext (forest, gtreeid, face_descs[0], eclass,
+                                      *lower, *upper, *lower, 1);
   *upper =
-    t8_forest_element_find_owner_ext (forest, gtreeid, last_face_desc, eclass,
+    t8_forest_element_find_owner_ext (forest, gtreeid, face_descs[1], eclass,
                                       *lower, *upper, *upper, 1);
-    ts->t8_element_destroy (1, &first_face_desc);
-    ts->t8_element_destroy (1, &last_face_desc);
+  t8_element_scratch_release (&scratch_mark);
 }
 
 void
@@ -2535,14 +4576,16 @@ t8_forest_element_owners_at_neigh_face (t8_forest_t forest, t8_locidx_t ltreeid,
   t8_eclass_scheme_c *neigh_scheme;
   t8_eclass_t         neigh_class;
   t8_element_t       *face_neighbor;
+  t8_element_scratch_mark_t scratch_mark;
   int                 dual_face;
   t8_gloidx_t         neigh_tree;
 
-  /* Find out the eclass of the face neighbor tree and allocate memory for
+  /* Find out the eclass of the face neighbor tree and get memory for
    * the neighbor element */
   neigh_class = t8_forest_element_neighbor_eclass (forest, ltreeid, element, face);
   neigh_scheme = t8_forest_get_eclass_scheme (forest, neigh_class);
-  neigh_scheme->t8_element_new (1, &face_neighbor);
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (neigh_scheme, 1, &face_neighbor);
   neigh_tree = t8_forest_element_face_neighbor (forest, ltreeid, element, face_neighbor,
                                                 neigh_scheme,
                                                 face, &dual_face);
@@ -2554,9 +4597,9 @@ t8_forest_element_owners_at_neigh_face (t8_forest_t forest, t8_locidx_t ltreeid,
   else {
     /* There is no face neighbor, we indicate this by setting the
      * array to 0 */
-    sc_array_resize (owners, 0);
+    sc_array_truncate (owners);
   }
-  neigh_scheme->t8_element_destroy (1, &face_neighbor);
+  t8_element_scratch_release (&scratch_mark);
 }
 
 void
@@ -2567,6 +4610,7 @@ t8_forest_element_owners_at_neigh_face_bounds (t8_forest_t forest, t8_locidx_t l
   t8_eclass_scheme_c *neigh_scheme;
   t8_eclass_t         neigh_class;
   t8_element_t       *face_neighbor;
+  t8_element_scratch_mark_t scratch_mark;
   int                 dual_face;
   t8_gloidx_t         neigh_tree;
 
@@ -2574,11 +4618,12 @@ t8_forest_element_owners_at_neigh_face_bounds (t8_forest_t forest, t8_locidx_t l
     /* There is no owner or it is unique */
     return;
   }
-  /* Find out the eclass of the face neighbor tree and allocate memory for
+  /* Find out the eclass of the face neighbor tree and get memory for
    * the neighbor element */
   neigh_class = t8_forest_element_neighbor_eclass (forest, ltreeid, element, face);
   neigh_scheme = t8_forest_get_eclass_scheme (forest, neigh_class);
-  neigh_scheme->t8_element_new (1, &face_neighbor);
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (neigh_scheme, 1, &face_neighbor);
   neigh_tree = t8_forest_element_face_neighbor (forest, ltreeid, element, face_neighbor,
                                                 neigh_scheme,
                                                 face, &dual_face);
@@ -2592,7 +4637,7 @@ t8_forest_element_owners_at_neigh_face_bounds (t8_forest_t forest, t8_locidx_t l
     *lower = 1;
     *upper = 0;
   }
-  neigh_scheme->t8_element_destroy (1, &face_neighbor);
+  t8_element_scratch_release (&scratch_mark);
 }
 
 int
@@ -2606,6 +4651,7 @@ t8_forest_element_has_leaf_desc (t8_forest_t forest, t8_gloidx_t gtreeid,
   t8_locidx_t   ghost_treeid;
   t8_linearidx_t      last_desc_id, elem_id;
   int           index, level, level_found;
+  t8_element_scratch_mark_t mark;
 
   T8_ASSERT (t8_forest_is_committed (forest));
 
@@ -2614,7 +4660,10 @@ t8_forest_element_has_leaf_desc (t8_forest_t forest, t8_gloidx_t gtreeid,
    * We then check whether the forest has any element with id between
    * the id of element and the id of the last descendant */
   /* TODO: element interface function t8_element_last_desc_id */
-  ts->t8_element_new (1, &last_desc);
+  /* The scratch arena of the calling thread lets several threads call
+   * this function at once */
+  t8_element_scratch_mark (&mark);
+  t8_element_scratch_get (ts, 1, &last_desc);
   /* TODO: set level in last_descendant */
   ts->t8_element_last_descendant (element, last_desc, forest->maxlevel);
   last_desc_id = ts->t8_element_get_linear_id (last_desc, forest->maxlevel);
@@ -2628,7 +4677,10 @@ t8_forest_element_has_leaf_desc (t8_forest_t forest, t8_gloidx_t gtreeid,
     /* Get the elements */
     elements = t8_forest_get_tree_element_array (forest, ltreeid);
 
-    index = t8_forest_bin_search_lower (elements, last_desc_id, forest->maxlevel);
+    index = t8_forest_bin_search_lower (elements,
+                                        t8_forest_leaf_keys_tree (forest,
+                                                                  ltreeid),
+                                        last_desc_id, forest->maxlevel);
     if (index >= 0) {
       /* There exists an element in the array with id <= last_desc_id,
        * If also elem_id < id, then we found a true decsendant of element */
@@ -2640,7 +4692,7 @@ t8_forest_element_has_leaf_desc (t8_forest_t forest, t8_gloidx_t gtreeid,
         /* The element is a true descendant */
         T8_ASSERT (ts->t8_element_level (elem_found) > ts->t8_element_level (element));
         /* clean-up */
-        ts->t8_element_destroy (1, &last_desc);
+        t8_element_scratch_release (&mark);
         return 1;
       }
     }
@@ -2652,7 +4704,10 @@ t8_forest_element_has_leaf_desc (t8_forest_t forest, t8_gloidx_t gtreeid,
     if (ghost_treeid >= 0) {
       /* The tree is a ghost tree */
       elements = t8_forest_ghost_get_tree_elements (forest, ghost_treeid);
-      index = t8_forest_bin_search_lower (elements, last_desc_id, forest->maxlevel);
+      index = t8_forest_bin_search_lower (elements,
+                                          t8_forest_leaf_keys_ghost_tree
+                                          (forest, ghost_treeid),
+                                          last_desc_id, forest->maxlevel);
       if (index >= 0) {
         /* There exists an element in the array with id <= last_desc_id,
          * If also elem_id < id, then we found a true decsendant of element */
@@ -2664,14 +4719,56 @@ t8_forest_element_has_leaf_desc (t8_forest_t forest, t8_gloidx_t gtreeid,
           /* The element is a true descendant */
           T8_ASSERT (ts->t8_element_level (elem_found) > ts->t8_element_level (element));
           /* clean-up */
-          ts->t8_element_destroy (1, &last_desc);
+          t8_element_scratch_release (&mark);
           return 1;
         }
       }
     }
   }
+  t8_element_scratch_release (&mark);
   return 0;
 }
 
+t8_locidx_t
+t8_forest_leaf_ancestor_index (t8_forest_t forest, t8_locidx_t ltreeid,
+                               const t8_element_t * element,
+                               t8_eclass_scheme_c * ts)
+{
+  t8_element_array_t *elements;
+  t8_element_t       *leaf, *last_desc;
+  t8_element_scratch_mark_t mark;
+  t8_linearidx_t      elem_id, last_desc_id;
+  t8_locidx_t         index;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  elements = t8_forest_get_tree_element_array (forest, ltreeid);
+  if (t8_element_array_get_count (elements) == 0) {
+    return -1;
+  }
+  /* The leaf with the largest linear id smaller or equal to the id of
+   * element is the only candidate for an ancestor */
+  elem_id = ts->t8_element_get_linear_id (element, forest->maxlevel);
+  index = t8_forest_bin_search_lower (elements,
+                                      t8_forest_leaf_keys_tree (forest,
+                                                                ltreeid),
+                                      elem_id, forest->maxlevel);
+  if (index < 0) {
+    return -1;
+  }
+  leaf = t8_element_array_index_locidx (elements, index);
+  if (ts->t8_element_level (leaf) > ts->t8_element_level (element)) {
+    /* The leaf is a descendant of element */
+    return -1;
+  }
+  /* The leaf is an ancestor if its last descendant is not before element */
+  t8_element_scratch_mark (&mark);
+  t8_element_scratch_get (ts, 1, &last_desc);
+  ts->t8_element_last_descendant (leaf, last_desc, forest->maxlevel);
+  last_desc_id = ts->t8_element_get_linear_id (last_desc, forest->maxlevel);
+  t8_element_scratch_release (&mark);
+  return elem_id <= last_desc_id ? index : -1;
+}
+
 
 T8_EXTERN_C_END ();
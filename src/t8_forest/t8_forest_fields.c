@@ -0,0 +1,354 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_fields.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_partition.h>
+#include <t8_forest/t8_forest_iterate.h>
+
+static t8_forest_field_t *
+t8_forest_field_get (t8_forest_t forest, int field_id)
+{
+  T8_ASSERT (forest->fields != NULL);
+  T8_ASSERT (0 <= field_id && (size_t) field_id < forest->fields->elem_count);
+  return (t8_forest_field_t *) sc_array_index_int (forest->fields, field_id);
+}
+
+int
+t8_forest_field_register (t8_forest_t forest, const char *name,
+                          size_t data_size,
+                          t8_forest_field_replace_t interpolate,
+                          t8_forest_field_replace_t restrict_fn,
+                          void *user_data)
+{
+  t8_forest_field_t  *field;
+  size_t              length;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (name != NULL);
+  T8_ASSERT (data_size > 0);
+
+  if (forest->fields == NULL) {
+    forest->fields = sc_array_new (sizeof (t8_forest_field_t));
+  }
+  field = (t8_forest_field_t *) sc_array_push (forest->fields);
+  length = strlen (name) + 1;
+  field->name = T8_ALLOC (char, length);
+  memcpy (field->name, name, length);
+  field->data_size = data_size;
+  field->interpolate = interpolate;
+  field->restrict_fn = restrict_fn;
+  field->user_data = user_data;
+  sc_array_init_count (&field->data, data_size,
+                       t8_forest_get_num_element (forest)
+                       + t8_forest_get_num_ghosts (forest));
+  if (field->data.elem_count > 0) {
+    memset (field->data.array, 0, field->data.elem_count * data_size);
+  }
+  return (int) forest->fields->elem_count - 1;
+}
+
+int
+t8_forest_get_num_fields (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  return forest->fields == NULL ? 0 : (int) forest->fields->elem_count;
+}
+
+int
+t8_forest_field_find (t8_forest_t forest, const char *name)
+{
+  int                 ifield, num_fields;
+
+  T8_ASSERT (name != NULL);
+  num_fields = t8_forest_get_num_fields (forest);
+  for (ifield = 0; ifield < num_fields; ifield++) {
+    if (!strcmp (t8_forest_field_get (forest, ifield)->name, name)) {
+      return ifield;
+    }
+  }
+  return -1;
+}
+
+sc_array_t         *
+t8_forest_field_get_array (t8_forest_t forest, int field_id)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  return &t8_forest_field_get (forest, field_id)->data;
+}
+
+void               *
+t8_forest_field_get_data (t8_forest_t forest, int field_id)
+{
+  return t8_forest_field_get_array (forest, field_id)->array;
+}
+
+void
+t8_forest_fields_ghost_exchange (t8_forest_t forest)
+{
+  sc_array_t        **arrays;
+  int                 ifield, num_fields;
+
+  num_fields = t8_forest_get_num_fields (forest);
+  if (num_fields == 0 || forest->ghosts == NULL) {
+    return;
+  }
+  arrays = T8_ALLOC (sc_array_t *, num_fields);
+  for (ifield = 0; ifield < num_fields; ifield++) {
+    arrays[ifield] = &t8_forest_field_get (forest, ifield)->data;
+  }
+  /* All fields in one message per process */
+  t8_forest_ghost_exchange_data_multi (forest, num_fields, arrays);
+  T8_FREE (arrays);
+}
+
+void
+t8_forest_field_restrict_mean (t8_forest_t forest_old, t8_forest_t forest_new,
+                               t8_locidx_t which_tree,
+                               t8_eclass_scheme_c * ts, size_t data_size,
+                               int num_old, t8_locidx_t first_old,
+                               const void *data_old, int num_new,
+                               t8_locidx_t first_new, void *data_new,
+                               void *user_data)
+{
+  const double       *values_old = (const double *) data_old;
+  double             *values_new = (double *) data_new;
+  size_t              ivalue, num_values;
+  int                 iold;
+
+  T8_ASSERT (num_new == 1 && num_old > 0);
+  T8_ASSERT (data_size % sizeof (double) == 0);
+  num_values = data_size / sizeof (double);
+  for (ivalue = 0; ivalue < num_values; ivalue++) {
+    values_new[ivalue] = 0;
+    for (iold = 0; iold < num_old; iold++) {
+      values_new[ivalue] += values_old[iold * num_values + ivalue];
+    }
+    values_new[ivalue] /= num_old;
+  }
+}
+
+/* Replace the data of all fields in one tree. The runs of the tree are
+ * traversed once, and each run is applied to all fields. */
+static void
+t8_forest_fields_replace_batch (t8_forest_t forest_old,
+                                t8_forest_t forest_new,
+                                t8_locidx_t which_tree,
+                                t8_eclass_scheme_c * ts, size_t num_runs,
+                                const t8_forest_adapt_run_t * runs)
+{
+  const t8_forest_adapt_run_t *run;
+  t8_forest_field_t  *field_old, *field_new;
+  t8_locidx_t         offset_old, offset_new, ireplace, iold, inew;
+  const char         *data_old;
+  char               *data_new;
+  size_t              irun, ifield, num_fields, size;
+  int                 ichild;
+
+  num_fields = forest_old->fields->elem_count;
+  offset_old = t8_forest_get_tree_element_offset (forest_old, which_tree);
+  offset_new = t8_forest_get_tree_element_offset (forest_new, which_tree);
+  for (irun = 0; irun < num_runs; irun++) {
+    run = runs + irun;
+    for (ifield = 0; ifield < num_fields; ifield++) {
+      field_old = (t8_forest_field_t *) sc_array_index (forest_old->fields,
+                                                        ifield);
+      field_new = (t8_forest_field_t *) sc_array_index (forest_new->fields,
+                                                        ifield);
+      size = field_old->data_size;
+      data_old = (const char *) field_old->data.array
+        + (offset_old + run->first_old) * size;
+      data_new = (char *) field_new->data.array
+        + (offset_new + run->first_new) * size;
+      if (run->num_old == 1 && run->num_new == 1) {
+        /* The elements were kept */
+        memcpy (data_new, data_old, run->count * size);
+        continue;
+      }
+      for (ireplace = 0; ireplace < run->count; ireplace++) {
+        iold = ireplace * run->num_old;
+        inew = ireplace * run->num_new;
+        if (run->num_old == 1 && field_old->interpolate != NULL) {
+          field_old->interpolate (forest_old, forest_new, which_tree, ts,
+                                  size, 1, run->first_old + iold,
+                                  data_old + iold * size, run->num_new,
+                                  run->first_new + inew,
+                                  data_new + inew * size,
+                                  field_old->user_data);
+        }
+        else if (run->num_old == 1) {
+          /* Copy the data of the parent to all children */
+          for (ichild = 0; ichild < run->num_new; ichild++) {
+            memcpy (data_new + (inew + ichild) * size,
+                    data_old + iold * size, size);
+          }
+        }
+        else if (field_old->restrict_fn != NULL) {
+          T8_ASSERT (run->num_new == 1);
+          field_old->restrict_fn (forest_old, forest_new, which_tree, ts,
+                                  size, run->num_old, run->first_old + iold,
+                                  data_old + iold * size, 1,
+                                  run->first_new + inew,
+                                  data_new + inew * size,
+                                  field_old->user_data);
+        }
+        else {
+          /* Copy the data of the first family member to the parent */
+          T8_ASSERT (run->num_new == 1);
+          memcpy (data_new + inew * size, data_old + iold * size, size);
+        }
+      }
+    }
+  }
+}
+
+/* Send the data of all fields of the local elements of forest_old to the
+ * new owners in forest_new. If there is more than one field, the fields are
+ * interleaved, such that each process receives one message. */
+static void
+t8_forest_fields_partition (t8_forest_t forest_new, t8_forest_t forest_old)
+{
+  t8_forest_field_t  *field_old, *field_new;
+  sc_array_t          data_in, data_out;
+  size_t              ifield, num_fields, total_size, offset, size;
+  t8_locidx_t         ielement, num_old, num_new;
+  char               *packed;
+
+  num_fields = forest_old->fields->elem_count;
+  num_old = t8_forest_get_num_element (forest_old);
+  num_new = t8_forest_get_num_element (forest_new);
+  if (num_fields == 1) {
+    /* Send the local entries of the field directly */
+    field_old = (t8_forest_field_t *) sc_array_index (forest_old->fields, 0);
+    field_new = (t8_forest_field_t *) sc_array_index (forest_new->fields, 0);
+    sc_array_init_view (&data_in, &field_old->data, 0, num_old);
+    sc_array_init_view (&data_out, &field_new->data, 0, num_new);
+    t8_forest_partition_data (forest_old, forest_new, &data_in, &data_out);
+    return;
+  }
+
+  for (ifield = 0, total_size = 0; ifield < num_fields; ifield++) {
+    total_size += ((t8_forest_field_t *)
+                   sc_array_index (forest_old->fields, ifield))->data_size;
+  }
+  sc_array_init_count (&data_in, total_size, num_old);
+  sc_array_init_count (&data_out, total_size, num_new);
+  for (ifield = 0, offset = 0; ifield < num_fields; ifield++) {
+    field_old = (t8_forest_field_t *) sc_array_index (forest_old->fields,
+                                                      ifield);
+    size = field_old->data_size;
+    packed = data_in.array + offset;
+    for (ielement = 0; ielement < num_old; ielement++) {
+      memcpy (packed + ielement * total_size,
+              field_old->data.array + ielement * size, size);
+    }
+    offset += size;
+  }
+  t8_forest_partition_data (forest_old, forest_new, &data_in, &data_out);
+  for (ifield = 0, offset = 0; ifield < num_fields; ifield++) {
+    field_new = (t8_forest_field_t *) sc_array_index (forest_new->fields,
+                                                      ifield);
+    size = field_new->data_size;
+    packed = data_out.array + offset;
+    for (ielement = 0; ielement < num_new; ielement++) {
+      memcpy (field_new->data.array + ielement * size,
+              packed + ielement * total_size, size);
+    }
+    offset += size;
+  }
+  sc_array_reset (&data_in);
+  sc_array_reset (&data_out);
+}
+
+void
+t8_forest_fields_transfer (t8_forest_t forest_new, t8_forest_t forest_old,
+                           int from_method)
+{
+  t8_forest_field_t  *field_old, *field_new;
+  size_t              ifield, num_fields, length;
+  t8_locidx_t         num_entries;
+
+  T8_ASSERT (t8_forest_is_committed (forest_new));
+  T8_ASSERT (forest_old->fields != NULL);
+  T8_ASSERT (forest_new->fields == NULL);
+
+  /* Create the fields of the new forest */
+  num_fields = forest_old->fields->elem_count;
+  num_entries = t8_forest_get_num_element (forest_new)
+    + t8_forest_get_num_ghosts (forest_new);
+  forest_new->fields = sc_array_new_count (sizeof (t8_forest_field_t),
+                                           num_fields);
+  for (ifield = 0; ifield < num_fields; ifield++) {
+    field_old = (t8_forest_field_t *) sc_array_index (forest_old->fields,
+                                                      ifield);
+    field_new = (t8_forest_field_t *) sc_array_index (forest_new->fields,
+                                                      ifield);
+    *field_new = *field_old;
+    length = strlen (field_old->name) + 1;
+    field_new->name = T8_ALLOC (char, length);
+    memcpy (field_new->name, field_old->name, length);
+    sc_array_init_count (&field_new->data, field_old->data_size, num_entries);
+  }
+
+  switch (from_method) {
+  case T8_FOREST_FROM_COPY:
+    for (ifield = 0; ifield < num_fields; ifield++) {
+      field_old = (t8_forest_field_t *) sc_array_index (forest_old->fields,
+                                                        ifield);
+      field_new = (t8_forest_field_t *) sc_array_index (forest_new->fields,
+                                                        ifield);
+      memcpy (field_new->data.array, field_old->data.array,
+              field_old->data_size * t8_forest_get_num_element (forest_new));
+    }
+    break;
+  case T8_FOREST_FROM_ADAPT:
+  case T8_FOREST_FROM_BALANCE:
+    /* One sweep over the elements for all fields */
+    t8_forest_iterate_replace_batch (forest_new, forest_old,
+                                     t8_forest_fields_replace_batch, 1);
+    break;
+  case T8_FOREST_FROM_PARTITION:
+    t8_forest_fields_partition (forest_new, forest_old);
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  /* Fill the ghost entries */
+  t8_forest_fields_ghost_exchange (forest_new);
+}
+
+void
+t8_forest_fields_destroy (t8_forest_t forest)
+{
+  t8_forest_field_t  *field;
+  size_t              ifield;
+
+  T8_ASSERT (forest->fields != NULL);
+  for (ifield = 0; ifield < forest->fields->elem_count; ifield++) {
+    field = (t8_forest_field_t *) sc_array_index (forest->fields, ifield);
+    T8_FREE (field->name);
+    sc_array_reset (&field->data);
+  }
+  sc_array_destroy (forest->fields);
+  forest->fields = NULL;
+}
@@ -0,0 +1,164 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_fields.h
+ * Element data fields that are managed by a forest.
+ * A field stores a fixed number of bytes for each local element and each
+ * ghost element of a forest. When a new forest is committed from a forest
+ * with fields, the fields are moved to the new forest:
+ * After adapt or balance all fields are interpolated or restricted in one
+ * sweep over the elements, after partition all fields are sent in one
+ * message per process and if the new forest has a ghost layer, the ghost
+ * values of all fields are exchanged in one message per process.
+ * This replaces calling \ref t8_forest_iterate_replace,
+ * \ref t8_forest_partition_data and \ref t8_forest_ghost_exchange_data for
+ * each data array by hand.
+ */
+
+#ifndef T8_FOREST_FIELDS_H
+#define T8_FOREST_FIELDS_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** Callback to compute the data of new elements from the data of old
+ * elements when a forest is adapted or balanced.
+ * It is used for refinement, in which case \a num_old is 1 and \a num_new
+ * is the number of children, and for coarsening, in which case \a num_old
+ * is the number of family members and \a num_new is 1.
+ * \param [in] forest_old  The forest that is adapted.
+ * \param [in] forest_new  The new forest.
+ * \param [in] which_tree  The local tree of the elements.
+ * \param [in] ts          The eclass scheme of the tree.
+ * \param [in] data_size   The number of bytes per element of the field.
+ * \param [in] num_old     The number of old elements.
+ * \param [in] first_old   The tree local index of the first old element.
+ * \param [in] data_old    The data of the \a num_old old elements.
+ * \param [in] num_new     The number of new elements.
+ * \param [in] first_new   The tree local index of the first new element.
+ * \param [out] data_new   The data of the \a num_new new elements.
+ * \param [in] user_data   The user data of the field.
+ */
+typedef void        (*t8_forest_field_replace_t) (t8_forest_t forest_old,
+                                                  t8_forest_t forest_new,
+                                                  t8_locidx_t which_tree,
+                                                  t8_eclass_scheme_c * ts,
+                                                  size_t data_size,
+                                                  int num_old,
+                                                  t8_locidx_t first_old,
+                                                  const void *data_old,
+                                                  int num_new,
+                                                  t8_locidx_t first_new,
+                                                  void *data_new,
+                                                  void *user_data);
+
+T8_EXTERN_C_BEGIN ();
+
+/** Add a data field to a committed forest.
+ * The field has one entry of \a data_size bytes for each local element,
+ * followed by one entry for each ghost element. The entries are set to zero.
+ * \param [in,out] forest      A committed forest.
+ * \param [in]     name        A name of the field. It is copied.
+ * \param [in]     data_size   The number of bytes per element, at least 1.
+ * \param [in]     interpolate Computes the data of the children of a refined
+ *                             element. If NULL, the data of the parent is
+ *                             copied to each child.
+ * \param [in]     restrict_fn Computes the data of the parent of a coarsened
+ *                             family. If NULL, the data of the first family
+ *                             member is copied. Use
+ *                             \ref t8_forest_field_restrict_mean for the mean
+ *                             of fields of doubles.
+ * \param [in]     user_data   Passed to \a interpolate and \a restrict_fn.
+ * \return                     The id of the new field. It does not change
+ *                             when the fields are moved to a new forest.
+ */
+int                 t8_forest_field_register (t8_forest_t forest,
+                                              const char *name,
+                                              size_t data_size,
+                                              t8_forest_field_replace_t
+                                              interpolate,
+                                              t8_forest_field_replace_t
+                                              restrict_fn, void *user_data);
+
+/** Return the number of fields of a forest.
+ * \param [in]     forest      A committed forest.
+ * \return                     The number of fields.
+ */
+int                 t8_forest_get_num_fields (t8_forest_t forest);
+
+/** Find a field by its name.
+ * \param [in]     forest      A committed forest.
+ * \param [in]     name        The name of a field.
+ * \return                     The id of the first field with this name,
+ *                             or -1 if no such field exists.
+ */
+int                 t8_forest_field_find (t8_forest_t forest,
+                                          const char *name);
+
+/** Return the data array of a field.
+ * \param [in]     forest      A committed forest.
+ * \param [in]     field_id    The id of a field of \a forest.
+ * \return                     An array with one entry for each local element,
+ *                             followed by one entry for each ghost.
+ *                             It belongs to \a forest and must not be resized.
+ */
+sc_array_t         *t8_forest_field_get_array (t8_forest_t forest,
+                                               int field_id);
+
+/** Return the data of a field. Equivalent to the data of
+ * \ref t8_forest_field_get_array.
+ * \param [in]     forest      A committed forest.
+ * \param [in]     field_id    The id of a field of \a forest.
+ * \return                     A pointer to the data of the first local
+ *                             element.
+ */
+void               *t8_forest_field_get_data (t8_forest_t forest,
+                                              int field_id);
+
+/** Exchange the ghost values of all fields of a forest, after the values of
+ * the local elements were changed. All fields are sent in one message per
+ * remote process.
+ * \param [in]     forest      A committed forest.
+ * This function is collective over the processes that share ghosts.
+ */
+void                t8_forest_fields_ghost_exchange (t8_forest_t forest);
+
+/** A restriction callback for \ref t8_forest_field_register for fields of
+ * doubles. The data of the parent is the mean of the data of the family
+ * members, separately for each double of an entry.
+ */
+void                t8_forest_field_restrict_mean (t8_forest_t forest_old,
+                                                   t8_forest_t forest_new,
+                                                   t8_locidx_t which_tree,
+                                                   t8_eclass_scheme_c * ts,
+                                                   size_t data_size,
+                                                   int num_old,
+                                                   t8_locidx_t first_old,
+                                                   const void *data_old,
+                                                   int num_new,
+                                                   t8_locidx_t first_new,
+                                                   void *data_new,
+                                                   void *user_data);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_FIELDS_H */
@@ -21,14 +21,22 @@
 */
 
 #include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_ghost_device.h>
 #include <t8_forest/t8_forest_partition.h>
 #include <t8_forest/t8_forest_types.h>
 #include <t8_forest/t8_forest_private.h>
 #include <t8_forest/t8_forest_iterate.h>
 #include <t8_forest.h>
+#include <t8_trace.h>
+#include <t8_peer_volume.h>
+#include <t8_threads.h>
 #include <t8_cmesh/t8_cmesh_trees.h>
 #include <t8_element_cxx.hxx>
+#include <t8_element_scratch.hxx>
 #include <t8_data/t8_containers.h>
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#include <omp.h>
+#endif
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -53,14 +61,8 @@ typedef struct
   t8_eclass_t         eclass;   /* The trees element class */
 } t8_ghost_tree_t;
 
-/* The data structure stored in the global_tree_to_ghost_tree hash table. */
-typedef struct
-{
-  t8_gloidx_t         global_id;        /* global tree id */
-  size_t              index;    /* the index of that global tree in the ghost_trees array. */
-} t8_ghost_gtree_hash_t;
-
-/* The data structure stored in the process_offsets array. */
+/* The data structure stored in the process_offsets array.
+ * The array is sorted by rank. */
 typedef struct
 {
   int                 mpirank;  /* rank of the process */
@@ -68,7 +70,7 @@ typedef struct
   size_t              tree_index;       /* index of first ghost tree of this process in ghost_trees */
   size_t              first_element;    /* the index of the first element in the elements array
                                            of the ghost tree. */
-} t8_ghost_process_hash_t;
+} t8_ghost_process_t;
 
 /* The information stored for the remote trees.
  * Each remote process stores an array of these */
@@ -88,8 +90,7 @@ typedef struct
   sc_array_t          remote_trees;     /* Array of the remote trees of this process */
 } t8_ghost_remote_t;
 
-#if 0
-/* Compare two ghost_tree entries. We need this function to sort the
+/* Compare two ghost_tree entries. We need this function to search the
  * ghost_trees array by global_id. */
 static int
 t8_ghost_tree_compare (const void *tree_a, const void *tree_b)
@@ -102,60 +103,15 @@ t8_ghost_tree_compare (const void *tree_a, const void *tree_b)
   }
   return A->global_id != B->global_id;
 }
-#endif
-
-/* The hash function for the global tree hash.
- * As hash value we just return the global tree id. */
-static unsigned
-t8_ghost_gtree_hash_function (const void *ghost_gtree_hash, const void *data)
-{
-  const t8_ghost_gtree_hash_t *object =
-    (const t8_ghost_gtree_hash_t *) ghost_gtree_hash;
-
-  return (unsigned) object->global_id;
-}
-
-/* The equal function for two global tree hash objects.
- * Two t8_ghost_gtree_hash_t are considered equal if theit global
- * tree ids are the same.
- */
-static int
-t8_ghost_gtree_equal_function (const void *ghost_gtreea,
-                               const void *ghost_gtreeb, const void *user)
-{
-  const t8_ghost_gtree_hash_t *objecta =
-    (const t8_ghost_gtree_hash_t *) ghost_gtreea;
-  const t8_ghost_gtree_hash_t *objectb =
-    (const t8_ghost_gtree_hash_t *) ghost_gtreeb;
-
-  /* return true if and only if the global_ids are the same */
-  return objecta->global_id == objectb->global_id;
-}
-
-/* The hash value for an entry of the process_offsets hash is the
- * processes mpirank. */
-static unsigned
-t8_ghost_process_hash_function (const void *process_data,
-                                const void *user_data)
-{
-  const t8_ghost_process_hash_t *process =
-    (const t8_ghost_process_hash_t *) process_data;
-
-  return process->mpirank;
-}
 
-/* The equal function for the process_offsets array.
- * Two entries are the same if their mpiranks are equal. */
+/* Compare two entries of the process_offsets array by their rank. */
 static int
-t8_ghost_process_equal_function (const void *process_dataa,
-                                 const void *process_datab, const void *user)
+t8_ghost_process_compare (const void *process_a, const void *process_b)
 {
-  const t8_ghost_process_hash_t *processa =
-    (const t8_ghost_process_hash_t *) process_dataa;
-  const t8_ghost_process_hash_t *processb =
-    (const t8_ghost_process_hash_t *) process_datab;
+  const t8_ghost_process_t *A = (const t8_ghost_process_t *) process_a;
+  const t8_ghost_process_t *B = (const t8_ghost_process_t *) process_b;
 
-  return processa->mpirank == processb->mpirank;
+  return (A->mpirank > B->mpirank) - (A->mpirank < B->mpirank);
 }
 
 /* The hash funtion for the remote_ghosts hash table.
@@ -184,8 +140,10 @@ t8_ghost_remote_equal_function (const void *remote_dataa,
  * Since we use asynchronuous communication, we store the
  * send buffers and mpi requests until we end the communication.
  */
-typedef struct
+struct t8_forest_ghost_exchange
 {
+  t8_forest_t         forest;
+                    /** The forest whose ghost data is exchanged */
   int                 num_remotes;
                     /** The number of processes, we send to */
   char              **send_buffers;
@@ -194,15 +152,16 @@ typedef struct
                            /** For each process we send to, the MPI request used */
   sc_MPI_Request     *recv_requests;
                            /** For each process we receive from, the MPI request used */
-} t8_ghost_data_exchange_t;
+  double              begin_time;
+                    /** The time at which begin returned, if profiling */
+};
 
 void
 t8_forest_ghost_init (t8_forest_ghost_t * pghost, t8_ghost_type_t ghost_type)
 {
   t8_forest_ghost_t   ghost;
 
-  /* We currently only support face-neighbor ghosts */
-  T8_ASSERT (ghost_type == T8_GHOST_FACES);
+  T8_ASSERT (ghost_type != T8_GHOST_NONE);
 
   /* Allocate memory for ghost */
   ghost = *pghost = T8_ALLOC_ZERO (t8_forest_ghost_struct_t, 1);
@@ -214,18 +173,8 @@ t8_forest_ghost_init (t8_forest_ghost_t * pghost, t8_ghost_type_t ghost_type)
   /* Allocate the trees array */
   ghost->ghost_trees = sc_array_new (sizeof (t8_ghost_tree_t));
 
-  /* initialize the global_tree_to_ghost_tree hash table */
-  ghost->glo_tree_mempool = sc_mempool_new (sizeof (t8_ghost_gtree_hash_t));
-  ghost->global_tree_to_ghost_tree =
-    sc_hash_new (t8_ghost_gtree_hash_function, t8_ghost_gtree_equal_function,
-                 NULL, NULL);
-
-  /* initialize the process_offset hash table */
-  ghost->proc_offset_mempool =
-    sc_mempool_new (sizeof (t8_ghost_process_hash_t));
-  ghost->process_offsets =
-    sc_hash_new (t8_ghost_process_hash_function,
-                 t8_ghost_process_equal_function, NULL, NULL);
+  /* Allocate the process_offset array */
+  ghost->process_offsets = sc_array_new (sizeof (t8_ghost_process_t));
   /* initialize the remote ghosts hash table */
   ghost->remote_ghosts =
     sc_hash_array_new (sizeof (t8_ghost_remote_t),
@@ -261,29 +210,38 @@ t8_forest_ghost_get_remote (t8_forest_t forest, int remote)
 }
 
 /* Return a remote processes info about the stored ghost elements */
-static t8_ghost_process_hash_t *
+static t8_ghost_process_t *
 t8_forest_ghost_get_proc_info (t8_forest_t forest, int remote)
 {
-  t8_ghost_process_hash_t proc_hash_search, **pproc_hash_found,
-    *proc_hash_found;
-#ifdef T8_ENABLE_DEBUG
-  int                 ret;
-#endif
+  t8_ghost_process_t  proc_search, *proc_found;
+  ssize_t             index;
 
   T8_ASSERT (t8_forest_is_committed (forest));
 
-  proc_hash_search.mpirank = remote;
-#ifdef T8_ENABLE_DEBUG
-  ret =
-#else
-  (void)
-#endif
-    sc_hash_lookup (forest->ghosts->process_offsets, &proc_hash_search,
-                    (void ***) &pproc_hash_found);
-  T8_ASSERT (ret);
-  proc_hash_found = *pproc_hash_found;
-  T8_ASSERT (proc_hash_found->mpirank == remote);
-  return proc_hash_found;
+  proc_search.mpirank = remote;
+  index = sc_array_bsearch (forest->ghosts->process_offsets, &proc_search,
+                            t8_ghost_process_compare);
+  T8_ASSERT (index >= 0);
+  proc_found = (t8_ghost_process_t *)
+    sc_array_index_ssize_t (forest->ghosts->process_offsets, index);
+  T8_ASSERT (proc_found->mpirank == remote);
+  return proc_found;
+}
+
+/* Return the info about the stored ghost elements of the remote process at
+ * position iremote in remote_processes. */
+static t8_ghost_process_t *
+t8_forest_ghost_get_proc_info_at (t8_forest_ghost_t ghost, int iremote)
+{
+  t8_ghost_process_t *proc_entry;
+
+  T8_ASSERT (ghost->process_offsets->elem_count ==
+             ghost->remote_processes->elem_count);
+  proc_entry = (t8_ghost_process_t *)
+    sc_array_index_int (ghost->process_offsets, iremote);
+  T8_ASSERT (proc_entry->mpirank ==
+             *(int *) sc_array_index_int (ghost->remote_processes, iremote));
+  return proc_entry;
 }
 
 /* return the number of trees in a ghost */
@@ -356,22 +314,16 @@ t8_forest_ghost_get_tree_elements (t8_forest_t forest,
 t8_locidx_t
 t8_forest_ghost_get_ghost_treeid (t8_forest_t forest, t8_gloidx_t gtreeid)
 {
-  t8_ghost_gtree_hash_t query, *found, **pfound;
+  t8_ghost_tree_t     query;
 
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (forest->ghosts != NULL);
 
+  /* The ghost trees are sorted by global id. If the tree is not
+   * found, -1 is returned. */
   query.global_id = gtreeid;
-  if (sc_hash_lookup (forest->ghosts->global_tree_to_ghost_tree, &query,
-                      (void ***) &pfound)) {
-    /* The tree was found */
-    found = *pfound;
-    return found->index;
-  }
-  else {
-    /* The tree was not found */
-    return -1;
-  }
+  return (t8_locidx_t) sc_array_bsearch (forest->ghosts->ghost_trees, &query,
+                                         t8_ghost_tree_compare);
 }
 
 /* Given an index in the ghost_tree array, return this tree's element class */
@@ -814,6 +766,45 @@ t8_forest_ghost_iterate_face_add_remote (t8_forest_t forest,
 }
 #endif
 
+/* A local element that is a remote element of the process owner.
+ * The threads of t8_forest_ghost_fill_remote_threaded and the incremental
+ * update collect these and add them to the ghost structure afterwards. */
+typedef struct
+{
+  int                 owner;
+  t8_locidx_t         ltreeid;
+  t8_locidx_t         element_index;    /* The index of the element in its tree */
+} t8_ghost_remote_candidate_t;
+
+/* The remote candidates found by one thread.
+ * We use malloc and realloc, since the sc allocation functions are not
+ * thread-safe. */
+typedef struct
+{
+  t8_ghost_remote_candidate_t *candidates;
+  size_t              count;
+  size_t              alloc;
+} t8_ghost_remote_candidates_t;
+
+static void
+t8_ghost_remote_candidates_push (t8_ghost_remote_candidates_t * cands,
+                                 int owner, t8_locidx_t ltreeid,
+                                 t8_locidx_t element_index)
+{
+  t8_ghost_remote_candidate_t *cand;
+
+  if (cands->count == cands->alloc) {
+    cands->alloc = SC_MAX (2 * cands->alloc, 16);
+    cands->candidates = (t8_ghost_remote_candidate_t *)
+      realloc (cands->candidates, cands->alloc * sizeof (*cand));
+    SC_CHECK_ABORT (cands->candidates != NULL, "Ghost out of memory");
+  }
+  cand = cands->candidates + cands->count++;
+  cand->owner = owner;
+  cand->ltreeid = ltreeid;
+  cand->element_index = element_index;
+}
+
 typedef struct
 {
   sc_array_t          bounds_per_level; /* For each level from the nca to the parent of the current element
@@ -829,11 +820,34 @@ typedef struct
                                            for the parent of element. */
   int                 max_num_faces;
   t8_eclass_t         eclass;
+  t8_ghost_remote_candidates_t *cands;  /* If not NULL, the remote elements
+                                           are collected here instead of being
+                                           added to the ghost structure, since
+                                           several threads search at once. */
 #ifdef T8_ENABLE_DEBUG
   t8_locidx_t         left_out; /* Count the elements for which we skip the search */
 #endif
 } t8_forest_ghost_boundary_data_t;
 
+/* Add an element found by t8_forest_ghost_search_boundary as a remote
+ * element of remote_rank, or collect it if the search is threaded. */
+static void
+t8_forest_ghost_boundary_add_remote (t8_forest_t forest,
+                                     t8_forest_ghost_boundary_data_t * data,
+                                     int remote_rank, t8_locidx_t ltreeid,
+                                     const t8_element_t * element,
+                                     t8_locidx_t tree_leaf_index)
+{
+  if (data->cands != NULL) {
+    t8_ghost_remote_candidates_push (data->cands, remote_rank, ltreeid,
+                                     tree_leaf_index);
+  }
+  else {
+    t8_ghost_add_remote (forest, forest->ghosts, remote_rank, ltreeid,
+                         element, tree_leaf_index);
+  }
+}
+
 static int
 t8_forest_ghost_search_boundary (t8_forest_t forest, t8_locidx_t ltreeid,
                                  const t8_element_t * element,
@@ -859,9 +873,12 @@ t8_forest_ghost_search_boundary (t8_forest_t forest, t8_locidx_t ltreeid,
     data->level_nca = data->ts->t8_element_level (element);
     data->max_num_faces = data->ts->t8_element_max_num_faces (element);
     max_num_faces = data->max_num_faces;
-    sc_array_reset (&data->bounds_per_level);
-    sc_array_init_size (&data->bounds_per_level,
-                        2 * (max_num_faces + 1) * sizeof (int), 1);
+    /* The memory of the arrays was reserved before the search, thus
+     * we only truncate and push here and do not allocate. */
+    T8_ASSERT (data->bounds_per_level.elem_size >=
+               2 * (max_num_faces + 1) * sizeof (int));
+    sc_array_truncate (&data->bounds_per_level);
+    sc_array_push (&data->bounds_per_level);
     /* Set the (imaginary) owner bounds for the parent of the root element */
     bounds = (int *) sc_array_index (&data->bounds_per_level, 0);
     for (iface = 0; iface < max_num_faces + 1; iface++) {
@@ -946,7 +963,17 @@ t8_forest_ghost_search_boundary (t8_forest_t forest, t8_locidx_t ltreeid,
     else {
       /* The element is a leaf, we compute all of its face neighbor owners
        * and add the element as a remote element to all of them. */
-      sc_array_resize (&data->face_owners, 2);
+      if (lower >= upper) {
+        /* The bounds of the parent already tell us that there is no
+         * neighbor or that its owner is unique, we do not search. */
+        if (lower == upper && lower != forest->mpirank) {
+          t8_forest_ghost_boundary_add_remote (forest, data, lower, ltreeid,
+                                               element, tree_leaf_index);
+        }
+        continue;
+      }
+      sc_array_truncate (&data->face_owners);
+      sc_array_push_count (&data->face_owners, 2);
       /* The first and second entry in the face_owners array serve as lower
        * and upper bound */
       *(int *) sc_array_index (&data->face_owners, 0) = lower;
@@ -957,8 +984,9 @@ t8_forest_ghost_search_boundary (t8_forest_t forest, t8_locidx_t ltreeid,
       for (iproc = 0; iproc < (int) data->face_owners.elem_count; iproc++) {
         remote_rank = *(int *) sc_array_index (&data->face_owners, iproc);
         if (remote_rank != forest->mpirank) {
-          t8_ghost_add_remote (forest, forest->ghosts, remote_rank, ltreeid,
-                               element, tree_leaf_index);
+          t8_forest_ghost_boundary_add_remote (forest, data, remote_rank,
+                                               ltreeid, element,
+                                               tree_leaf_index);
         }
       }
     }
@@ -992,38 +1020,783 @@ t8_forest_ghost_search_boundary (t8_forest_t forest, t8_locidx_t ltreeid,
   return 1;
 }
 
+/* The number of maximum level elements around a vertex of a hexahedral
+ * mesh, the atoms of the vertex. */
+#define T8_GHOST_MAX_ATOMS 8
+
+/* The temporary data to find the remote processes of the elements across
+ * the edges and vertices of a line, quad or hex forest. For each corner of
+ * the current element we store the atoms around the corner vertex: atom m
+ * is reached from the atom of the element by crossing the faces of the
+ * axes in the bit mask m. */
+typedef struct
+{
+  t8_eclass_t         eclass;   /* The class of all trees. */
+  t8_eclass_scheme_c *ts;       /* The scheme of eclass. */
+  int                 dimension;        /* The dimension of eclass. */
+  int                 max_codim;        /* Only contacts up to this codimension are
+                                           considered, 2 for edges and 3 for vertices. */
+  int                 num_atoms;        /* 2^dimension */
+  t8_element_t      **atoms;    /* num_atoms atoms for each corner. */
+  t8_gloidx_t        *atom_trees;       /* The global tree of each atom or -1 if
+                                           there is no such atom. */
+  int                *atom_inside;      /* True if the atom was reached without
+                                           leaving the tree of the element. */
+  t8_element_t       *neigh;    /* A temporary element. */
+  sc_array_t          owners;   /* The owners at an edge. */
+} t8_ghost_corner_context_t;
+
+/* The face of a quad or hex at a corner in the direction of an axis,
+ * in the face numbering of the default scheme */
+static int
+t8_ghost_corner_face (int corner, int axis)
+{
+  return 2 * axis + ((corner >> axis) & 1);
+}
+
+/* The number of bits set in a mask of axes */
+static int
+t8_ghost_mask_count (int mask)
+{
+  int                 count = 0;
+
+  for (; mask != 0; mask >>= 1) {
+    count += mask & 1;
+  }
+  return count;
+}
+
+/* Construct the face neighbor of an atom of the tree gtreeid.
+ * Unlike t8_forest_element_face_neighbor the tree does not need to be a
+ * local tree of the forest, it suffices that the cmesh knows it as local
+ * or ghost tree. All trees must have the class of ctx.
+ * Return the global id of the tree of neigh, or -1 at a domain boundary. */
+static              t8_gloidx_t
+t8_forest_ghost_atom_neighbor (t8_forest_t forest,
+                               const t8_ghost_corner_context_t * ctx,
+                               t8_gloidx_t gtreeid,
+                               const t8_element_t * atom, int face,
+                               t8_element_t * neigh)
+{
+  t8_cmesh_t          cmesh = forest->cmesh;
+  t8_eclass_scheme_c *ts = ctx->ts;
+  t8_eclass_scheme_c *boundary_scheme;
+  t8_element_face_transform_t transform;
+  t8_locidx_t         lctreeid, num_local_trees, *face_neighbor;
+  t8_gloidx_t         neigh_tree, *ghost_neighbor;
+  int8_t             *ttf;
+  int                 tree_face, dual_face, F;
+
+  if (ts->t8_element_face_neighbor_inside (atom, neigh, face, &dual_face)) {
+    return gtreeid;
+  }
+  tree_face = ts->t8_element_tree_face (atom, face);
+  lctreeid = t8_cmesh_get_local_id (cmesh, gtreeid);
+  SC_CHECK_ABORTF (lctreeid >= 0, "Ghosts across vertices need the face "
+                   "connections of tree %lli, which is not known to the "
+                   "partitioned cmesh. Use a replicated cmesh.",
+                   (long long) gtreeid);
+  num_local_trees = t8_cmesh_get_num_local_trees (cmesh);
+  if (lctreeid < num_local_trees) {
+    (void) t8_cmesh_trees_get_tree_ext (cmesh->trees, lctreeid,
+                                        &face_neighbor, &ttf);
+    neigh_tree = t8_cmesh_get_global_id (cmesh, face_neighbor[tree_face]);
+  }
+  else {
+    (void) t8_cmesh_trees_get_ghost_ext (cmesh->trees,
+                                         lctreeid - num_local_trees,
+                                         &ghost_neighbor, &ttf);
+    neigh_tree = ghost_neighbor[tree_face];
+  }
+  F = t8_eclass_max_num_faces[cmesh->dimension];
+  transform.neigh_face = (int8_t) (ttf[tree_face] % F);
+  if (neigh_tree < 0
+      || (neigh_tree == gtreeid && transform.neigh_face == tree_face)) {
+    /* This face is a domain boundary */
+    return -1;
+  }
+  /* All trees have the same class, see t8_forest_tree_face_compute */
+  transform.orientation = (int8_t) (ttf[tree_face] / F);
+  transform.is_smaller = tree_face <= transform.neigh_face;
+  transform.sign = t8_eclass_face_orientation[ctx->eclass][tree_face] ==
+    t8_eclass_face_orientation[ctx->eclass][transform.neigh_face];
+  boundary_scheme =
+    t8_forest_get_eclass_scheme (forest, (t8_eclass_t)
+                                 t8_eclass_face_types[ctx->eclass]
+                                 [tree_face]);
+  (void) ts->t8_element_face_neighbor_across_tree (atom, face,
+                                                   boundary_scheme, ts,
+                                                   &transform, neigh);
+  return neigh_tree;
+}
+
+/* Find an atom other than r that is a face neighbor of both p and q.
+ * We need this where the atoms around a vertex lie in different trees,
+ * since the faces of the axes change between trees.
+ * Return its tree or -1 if there is no such atom. */
+static              t8_gloidx_t
+t8_forest_ghost_atom_common_neighbor (t8_forest_t forest,
+                                      t8_ghost_corner_context_t * ctx,
+                                      t8_gloidx_t tree_p,
+                                      const t8_element_t * p,
+                                      t8_gloidx_t tree_q,
+                                      const t8_element_t * q,
+                                      t8_gloidx_t tree_r,
+                                      const t8_element_t * r,
+                                      t8_element_t * result)
+{
+  t8_eclass_scheme_c *ts = ctx->ts;
+  t8_gloidx_t         tree_result, tree_neigh;
+  int                 pface, qface, num_faces;
+
+  num_faces = ts->t8_element_num_faces (p);
+  for (pface = 0; pface < num_faces; pface++) {
+    tree_result =
+      t8_forest_ghost_atom_neighbor (forest, ctx, tree_p, p, pface, result);
+    if (tree_result < 0
+        || (tree_result == tree_r && !ts->t8_element_compare (result, r))) {
+      continue;
+    }
+    for (qface = 0; qface < num_faces; qface++) {
+      tree_neigh = t8_forest_ghost_atom_neighbor (forest, ctx, tree_q, q,
+                                                  qface, ctx->neigh);
+      if (tree_neigh == tree_result
+          && !ts->t8_element_compare (ctx->neigh, result)) {
+        return tree_result;
+      }
+    }
+  }
+  return -1;
+}
+
+/* Compute the atoms around a corner of a local element */
+static void
+t8_forest_ghost_corner_atoms (t8_forest_t forest,
+                              t8_ghost_corner_context_t * ctx,
+                              t8_gloidx_t gtreeid,
+                              const t8_element_t * elem, int corner)
+{
+  t8_eclass_scheme_c *ts = ctx->ts;
+  t8_element_t      **atoms = ctx->atoms + corner * ctx->num_atoms;
+  t8_gloidx_t        *trees = ctx->atom_trees + corner * ctx->num_atoms;
+  int                *inside = ctx->atom_inside + corner * ctx->num_atoms;
+  int                 mask, prev, axis, other, level, dual_face;
+
+  /* The atom of the element at the corner, for quads and hexes the child
+   * with the id of a corner lies at that corner */
+  ts->t8_element_copy (elem, atoms[0]);
+  for (level = ts->t8_element_level (elem); level < forest->maxlevel;
+       level++) {
+    ts->t8_element_child (atoms[0], corner, atoms[0]);
+  }
+  trees[0] = gtreeid;
+  inside[0] = 1;
+
+  /* Each atom is one face away from an atom with a smaller mask */
+  for (mask = 1; mask < ctx->num_atoms; mask++) {
+    trees[mask] = -1;
+    inside[mask] = 0;
+    if (t8_ghost_mask_count (mask) > ctx->max_codim) {
+      continue;
+    }
+    for (axis = 0; axis < ctx->dimension && trees[mask] < 0; axis++) {
+      prev = mask ^ (1 << axis);
+      if ((mask & (1 << axis)) && inside[prev]
+          && ts->t8_element_face_neighbor_inside (atoms[prev], atoms[mask],
+                                                  t8_ghost_corner_face
+                                                  (corner, axis),
+                                                  &dual_face)) {
+        trees[mask] = gtreeid;
+        inside[mask] = 1;
+      }
+    }
+    if (trees[mask] >= 0) {
+      continue;
+    }
+    /* The atom lies in another tree */
+    for (axis = 0; !(mask & (1 << axis)); axis++) {
+    }
+    if (mask == (1 << axis)) {
+      trees[mask] =
+        t8_forest_ghost_atom_neighbor (forest, ctx, gtreeid, atoms[0],
+                                       t8_ghost_corner_face (corner, axis),
+                                       atoms[mask]);
+      continue;
+    }
+    for (other = axis + 1; !(mask & (1 << other)); other++) {
+    }
+    prev = mask ^ (1 << axis);
+    if (trees[prev] >= 0 && trees[mask ^ (1 << other)] >= 0
+        && trees[prev ^ (1 << other)] >= 0) {
+      trees[mask] =
+        t8_forest_ghost_atom_common_neighbor (forest, ctx, trees[prev],
+                                              atoms[prev],
+                                              trees[mask ^ (1 << other)],
+                                              atoms[mask ^ (1 << other)],
+                                              trees[prev ^ (1 << other)],
+                                              atoms[prev ^ (1 << other)],
+                                              atoms[mask]);
+    }
+  }
+}
+
+/* Collect the owners of the leaves in an element that touch the edge
+ * between two of its corners. */
+static void
+t8_forest_ghost_owners_at_edge (t8_forest_t forest,
+                                const t8_ghost_corner_context_t * ctx,
+                                t8_gloidx_t gtreeid,
+                                const t8_element_t * element, int corner0,
+                                int corner1, int lower, int upper,
+                                sc_array_t * owners)
+{
+  t8_eclass_scheme_c *ts = ctx->ts;
+  t8_element_t       *child;
+  t8_element_scratch_mark_t scratch_mark;
+
+  t8_forest_element_owners_bounds (forest, gtreeid, element, ctx->eclass,
+                                   &lower, &upper);
+  if (lower >= upper || ts->t8_element_level (element) == forest->maxlevel) {
+    /* The owner is unique */
+    *(int *) sc_array_push (owners) = lower;
+    return;
+  }
+  /* The two children at the corners of the edge cover the edge */
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (ts, 1, &child);
+  ts->t8_element_child (element, corner0, child);
+  t8_forest_ghost_owners_at_edge (forest, ctx, gtreeid, child, corner0,
+                                  corner1, lower, upper, owners);
+  ts->t8_element_child (element, corner1, child);
+  t8_forest_ghost_owners_at_edge (forest, ctx, gtreeid, child, corner0,
+                                  corner1, lower, upper, owners);
+  t8_element_scratch_release (&scratch_mark);
+}
+
+/* Add a local element as remote element of all processes that own leaves
+ * touching it only at an edge or a vertex. The face neighbors are added
+ * by the caller. */
+static void
+t8_forest_ghost_add_corner_remotes (t8_forest_t forest,
+                                    t8_forest_ghost_t ghost,
+                                    t8_ghost_corner_context_t * ctx,
+                                    t8_locidx_t ltreeid,
+                                    const t8_element_t * elem,
+                                    t8_locidx_t ielem)
+{
+  t8_eclass_scheme_c *ts = ctx->ts;
+  t8_element_t       *atom, *diag;
+  t8_gloidx_t         gtreeid, atom_tree;
+  size_t              iowner;
+  int                 num_corners, corner, corner1, mask, axis, level;
+  int                 owner, lower, upper;
+
+  gtreeid = t8_forest_global_tree_id (forest, ltreeid);
+  num_corners = ctx->num_atoms;
+  level = ts->t8_element_level (elem);
+  for (corner = 0; corner < num_corners; corner++) {
+    t8_forest_ghost_corner_atoms (forest, ctx, gtreeid, elem, corner);
+    /* The atoms with one axis are at the faces of elem */
+    for (mask = 1; mask < ctx->num_atoms; mask++) {
+      atom = ctx->atoms[corner * ctx->num_atoms + mask];
+      atom_tree = ctx->atom_trees[corner * ctx->num_atoms + mask];
+      if (t8_ghost_mask_count (mask) < 2 || atom_tree < 0
+          || t8_forest_element_check_owner (forest, atom, atom_tree,
+                                            ctx->eclass, forest->mpirank,
+                                            1)) {
+        continue;
+      }
+      owner = t8_forest_element_find_owner (forest, atom_tree, atom,
+                                            ctx->eclass);
+      if (owner != forest->mpirank) {
+        t8_ghost_add_remote (forest, ghost, owner, ltreeid, elem, ielem);
+      }
+    }
+  }
+  if (ctx->dimension < 3 || level == forest->maxlevel) {
+    /* All leaves at the edges contain an atom */
+    return;
+  }
+  /* The leaves touching the inner part of an edge from the diagonal
+   * direction lie in the element of the same level across the edge.
+   * We obtain it as the common ancestor of the atoms at both ends. */
+  diag = ctx->neigh;
+  for (corner = 0; corner < num_corners; corner++) {
+    for (axis = 0; axis < ctx->dimension; axis++) {
+      if (corner & (1 << axis)) {
+        continue;
+      }
+      corner1 = corner | (1 << axis);
+      mask = (ctx->num_atoms - 1) ^ (1 << axis);
+      atom_tree = ctx->atom_trees[corner * ctx->num_atoms + mask];
+      if (atom_tree < 0
+          || ctx->atom_trees[corner1 * ctx->num_atoms + mask] != atom_tree) {
+        continue;
+      }
+      atom = ctx->atoms[corner * ctx->num_atoms + mask];
+      ts->t8_element_nca (atom, ctx->atoms[corner1 * ctx->num_atoms + mask],
+                          diag);
+      if (ts->t8_element_level (diag) != level) {
+        continue;
+      }
+      lower = 0;
+      upper = forest->mpisize - 1;
+      sc_array_truncate (&ctx->owners);
+      t8_forest_ghost_owners_at_edge (forest, ctx, atom_tree, diag,
+                                      ts->t8_element_ancestor_id (atom,
+                                                                  level + 1),
+                                      ts->t8_element_ancestor_id
+                                      (ctx->atoms
+                                       [corner1 * ctx->num_atoms + mask],
+                                       level + 1), lower, upper,
+                                      &ctx->owners);
+      for (iowner = 0; iowner < ctx->owners.elem_count; iowner++) {
+        owner = *(int *) sc_array_index (&ctx->owners, iowner);
+        if (owner != forest->mpirank) {
+          t8_ghost_add_remote (forest, ghost, owner, ltreeid, elem, ielem);
+        }
+      }
+    }
+  }
+}
+
+/* Initialize the data for t8_forest_ghost_add_corner_remotes */
+static void
+t8_forest_ghost_corner_context_init (t8_forest_t forest,
+                                     t8_ghost_corner_context_t * ctx)
+{
+  int                 num_atoms;
+
+  ctx->eclass = t8_forest_get_eclass (forest, 0);
+  ctx->ts = t8_forest_get_eclass_scheme (forest, ctx->eclass);
+  ctx->dimension = t8_eclass_to_dimension[ctx->eclass];
+  ctx->max_codim = forest->ghost_type == T8_GHOST_EDGES ? 2 : 3;
+  ctx->num_atoms = 1 << ctx->dimension;
+  num_atoms = ctx->num_atoms * ctx->num_atoms;
+  ctx->atoms = T8_ALLOC (t8_element_t *, num_atoms);
+  ctx->ts->t8_element_new (num_atoms, ctx->atoms);
+  ctx->atom_trees = T8_ALLOC (t8_gloidx_t, num_atoms);
+  ctx->atom_inside = T8_ALLOC (int, num_atoms);
+  ctx->ts->t8_element_new (1, &ctx->neigh);
+  sc_array_init (&ctx->owners, sizeof (int));
+}
+
+static void
+t8_forest_ghost_corner_context_reset (t8_ghost_corner_context_t * ctx)
+{
+  ctx->ts->t8_element_destroy (ctx->num_atoms * ctx->num_atoms, ctx->atoms);
+  ctx->ts->t8_element_destroy (1, &ctx->neigh);
+  T8_FREE (ctx->atoms);
+  T8_FREE (ctx->atom_trees);
+  T8_FREE (ctx->atom_inside);
+  sc_array_reset (&ctx->owners);
+}
+
+/* Find the remote elements among the elements first to last - 1 of the
+ * local tree itree with the half neighbor method and store them in cands
+ * in the order in which t8_forest_ghost_fill_remote would add them.
+ * All temporary elements come from the scratch arena of the thread. */
+static void
+t8_forest_ghost_find_remote_tree_range (t8_forest_t forest, t8_locidx_t itree,
+                                        t8_locidx_t first, t8_locidx_t last,
+                                        t8_ghost_remote_candidates_t * cands)
+{
+  t8_element_t       *elem, **half_neighbors;
+  t8_element_scratch_mark_t scratch_mark;
+  t8_locidx_t         ielem;
+  t8_tree_t           tree;
+  t8_eclass_t         neigh_class;
+  t8_gloidx_t         neighbor_tree;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  int                 iface, num_faces, num_face_children, ichild;
+  int                 is_atom, *face_owners;
+
+  tree = t8_forest_get_tree (forest, itree);
+  T8_ASSERT (0 <= first && first <= last
+             && last <= t8_forest_get_tree_element_count (tree));
+  ts = t8_forest_get_eclass_scheme (forest, tree->eclass);
+  for (ielem = first; ielem < last; ielem++) {
+    elem = t8_forest_get_tree_element (tree, ielem);
+    num_faces = ts->t8_element_num_faces (elem);
+    is_atom = ts->t8_element_level (elem) == ts->t8_element_maxlevel ();
+    for (iface = 0; iface < num_faces; iface++) {
+      neigh_class =
+        t8_forest_element_neighbor_eclass (forest, itree, elem, iface);
+      neigh_scheme = t8_forest_get_eclass_scheme (forest, neigh_class);
+      num_face_children = ts->t8_element_num_face_children (elem, iface);
+
+      t8_element_scratch_mark (&scratch_mark);
+      half_neighbors = (t8_element_t **)
+        t8_element_scratch_alloc (num_face_children *
+                                  sizeof (t8_element_t *));
+      face_owners = (int *)
+        t8_element_scratch_alloc (num_face_children * sizeof (int));
+      t8_element_scratch_get (neigh_scheme, num_face_children,
+                              half_neighbors);
+      if (!is_atom) {
+        neighbor_tree =
+          t8_forest_element_half_face_neighbors (forest, itree, elem,
+                                                 half_neighbors,
+                                                 neigh_scheme, iface,
+                                                 num_face_children, NULL);
+      }
+      else {
+        int                 dummy_neigh_face;
+        neighbor_tree =
+          t8_forest_element_face_neighbor (forest, itree, elem,
+                                           half_neighbors[0],
+                                           neigh_scheme, iface,
+                                           &dummy_neigh_face);
+      }
+      if (neighbor_tree >= 0) {
+        t8_forest_element_find_owners (forest, neighbor_tree,
+                                       half_neighbors, neigh_class,
+                                       num_face_children, 0, face_owners);
+        for (ichild = 0; ichild < num_face_children; ichild++) {
+          T8_ASSERT (0 <= face_owners[ichild]
+                     && face_owners[ichild] < forest->mpisize);
+          if (face_owners[ichild] != forest->mpirank) {
+            t8_ghost_remote_candidates_push (cands, face_owners[ichild],
+                                             itree, ielem);
+          }
+        }
+      }
+      t8_element_scratch_release (&scratch_mark);
+    }
+  }
+}
+
+/* Add the remote candidates to the ghost structure and reset them. */
+static void
+t8_forest_ghost_add_remote_candidates (t8_forest_t forest,
+                                       t8_forest_ghost_t ghost,
+                                       t8_ghost_remote_candidates_t * cands)
+{
+  t8_ghost_remote_candidate_t *cand;
+  size_t              icand;
+
+  for (icand = 0; icand < cands->count; icand++) {
+    cand = cands->candidates + icand;
+    t8_ghost_add_remote (forest, ghost, cand->owner, cand->ltreeid,
+                         t8_forest_get_tree_element (t8_forest_get_tree
+                                                     (forest, cand->ltreeid),
+                                                     cand->element_index),
+                         cand->element_index);
+  }
+  free (cands->candidates);
+  cands->candidates = NULL;
+  cands->count = cands->alloc = 0;
+}
+
+/* Initialize the user data of t8_forest_ghost_search_boundary.
+ * We reserve the memory of its arrays, such that the search does not
+ * allocate and can be run by several threads. */
+static void
+t8_forest_ghost_boundary_data_init (t8_forest_t forest,
+                                    t8_forest_ghost_boundary_data_t * data,
+                                    int max_level,
+                                    t8_ghost_remote_candidates_t * cands)
+{
+  /* Start with invalid entries in the user data.
+   * These are set in t8_forest_ghost_search_boundary each time
+   * a new tree is entered */
+  data->eclass = T8_ECLASS_COUNT;
+  data->gtreeid = -1;
+  data->ts = NULL;
+  data->cands = cands;
+#ifdef T8_ENABLE_DEBUG
+  data->left_out = 0;
+#endif
+  /* The owners at a face are at most all processes */
+  sc_array_init_size (&data->face_owners, sizeof (int),
+                      SC_MAX (forest->mpisize, 2));
+  sc_array_truncate (&data->face_owners);
+  /* One entry for each level and one for the parent of the root element */
+  sc_array_init_size (&data->bounds_per_level,
+                      2 * (T8_ECLASS_MAX_FACES + 1) * sizeof (int),
+                      max_level + 2);
+  sc_array_truncate (&data->bounds_per_level);
+}
+
+static void
+t8_forest_ghost_boundary_data_reset (t8_forest_ghost_boundary_data_t * data)
+{
+  sc_array_reset (&data->face_owners);
+  sc_array_reset (&data->bounds_per_level);
+}
+
 /* Fill the remote ghosts of a ghost structure.
  * We iterate through all elements and check if their neighbors
  * lie on remote processes. If so, we add the element to the
  * remote_ghosts array of ghost.
  * We also fill the remote_processes here.
+ * With more than one ghost thread, the trees are searched in parallel.
+ * Each thread collects the remote elements of its trees and afterwards
+ * we add them in the order of the trees, which gives the same ghost
+ * structure as the serial search.
  */
 static void
 t8_forest_ghost_fill_remote_v3 (t8_forest_t forest)
 {
-
   t8_forest_ghost_boundary_data_t data;
+  t8_locidx_t         itree, num_local_trees;
+  int                 max_level = 0;
 
-  /* Start with invalid entries in the user data.
-   * These are set in t8_forest_ghost_search_boundary each time
-   * a new tree is entered */
-  data.eclass = T8_ECLASS_COUNT;
-  data.gtreeid = -1;
-  data.ts = NULL;
-#ifdef T8_ENABLE_DEBUG
-  data.left_out = 0;
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_local_trees; itree++) {
+    max_level = SC_MAX (max_level,
+                        t8_forest_get_eclass_scheme (forest,
+                                                     t8_forest_get_tree_class
+                                                     (forest, itree))->
+                        t8_element_maxlevel ());
+  }
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+  if (forest->set_ghost_threads > 1 && num_local_trees > 1) {
+    const int           num_threads = forest->set_ghost_threads;
+    t8_forest_ghost_boundary_data_t *thread_data;
+    t8_ghost_remote_candidates_t *thread_cands, merged;
+    t8_locidx_t        *tree_offsets;
+    size_t              icand;
+    void              **thread_user_data;
+    int                 ithread;
+
+    thread_data = T8_ALLOC (t8_forest_ghost_boundary_data_t, num_threads);
+    thread_cands = T8_ALLOC_ZERO (t8_ghost_remote_candidates_t, num_threads);
+    thread_user_data = T8_ALLOC (void *, num_threads);
+    for (ithread = 0; ithread < num_threads; ithread++) {
+      t8_forest_ghost_boundary_data_init (forest, thread_data + ithread,
+                                          max_level, thread_cands + ithread);
+      thread_user_data[ithread] = thread_data + ithread;
+    }
+    t8_forest_search_threaded (forest, t8_forest_ghost_search_boundary,
+                               thread_user_data, num_threads);
+
+    /* Each tree was searched by one thread. We sort the candidates
+     * by their tree, keeping the order within a tree. */
+    tree_offsets = T8_ALLOC_ZERO (t8_locidx_t, num_local_trees + 1);
+    for (ithread = 0; ithread < num_threads; ithread++) {
+      for (icand = 0; icand < thread_cands[ithread].count; icand++) {
+        tree_offsets[thread_cands[ithread].candidates[icand].ltreeid + 1]++;
+      }
+    }
+    for (itree = 0; itree < num_local_trees; itree++) {
+      tree_offsets[itree + 1] += tree_offsets[itree];
+    }
+    merged.count = merged.alloc = tree_offsets[num_local_trees];
+    merged.candidates = (t8_ghost_remote_candidate_t *)
+      malloc (SC_MAX (merged.alloc, 1) * sizeof (*merged.candidates));
+    SC_CHECK_ABORT (merged.candidates != NULL, "Ghost out of memory");
+    for (ithread = 0; ithread < num_threads; ithread++) {
+      for (icand = 0; icand < thread_cands[ithread].count; icand++) {
+        const t8_ghost_remote_candidate_t *cand =
+          thread_cands[ithread].candidates + icand;
+
+        merged.candidates[tree_offsets[cand->ltreeid]++] = *cand;
+      }
+      free (thread_cands[ithread].candidates);
+      t8_forest_ghost_boundary_data_reset (thread_data + ithread);
+    }
+    t8_forest_ghost_add_remote_candidates (forest, forest->ghosts, &merged);
+
+    T8_FREE (tree_offsets);
+    T8_FREE (thread_user_data);
+    T8_FREE (thread_cands);
+    T8_FREE (thread_data);
+    return;
+  }
 #endif
-  sc_array_init (&data.face_owners, sizeof (int));
-  /* This is a dummy init, since we call sc_array_reset in ghost_search_boundary
-   * and we should not call sc_array_reset on a non-initialized array */
-  sc_array_init (&data.bounds_per_level, 1);
+  t8_forest_ghost_boundary_data_init (forest, &data, max_level, NULL);
   /* Loop over the trees of the forest */
   t8_forest_search (forest, t8_forest_ghost_search_boundary, &data);
+  t8_forest_ghost_boundary_data_reset (&data);
+}
 
-  sc_array_reset (&data.face_owners);
-  sc_array_reset (&data.bounds_per_level);
-#ifdef T8_ENABLE_DEBUG
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+/* Fill the remote ghosts of a ghost structure with the half neighbor
+ * method using num_threads threads.
+ * The local elements are split into one contiguous range per thread.
+ * Each thread collects the remote elements of its range and afterwards
+ * we add them to the ghost structure in the order of the threads.
+ * This gives the same result as t8_forest_ghost_fill_remote. */
+static void
+t8_forest_ghost_fill_remote_threaded (t8_forest_t forest,
+                                      t8_forest_ghost_t ghost,
+                                      int num_threads)
+{
+  t8_ghost_remote_candidates_t *thread_cands;
+  t8_locidx_t         num_elements;
+  int                 ithread;
+
+  /* Creating the elements of implicit trees is not thread-safe */
+  t8_forest_materialize (forest);
+  num_elements = t8_forest_get_num_element (forest);
+  thread_cands = T8_ALLOC_ZERO (t8_ghost_remote_candidates_t, num_threads);
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    const int           thread_id = omp_get_thread_num ();
+    const int           team_size = omp_get_num_threads ();
+    const t8_locidx_t   first = (t8_locidx_t)
+      ((long long) num_elements * thread_id / team_size);
+    const t8_locidx_t   last = (t8_locidx_t)
+      ((long long) num_elements * (thread_id + 1) / team_size);
+
+    t8_locidx_t         itree, num_local_trees, tree_first, tree_last;
+    t8_tree_t           tree;
+
+    num_local_trees = t8_forest_get_num_local_trees (forest);
+    for (itree = 0; itree < num_local_trees; itree++) {
+      tree = t8_forest_get_tree (forest, itree);
+      /* The elements of the range in this tree */
+      tree_first = SC_MAX (first - tree->elements_offset, 0);
+      tree_last = SC_MIN (last - tree->elements_offset,
+                          t8_forest_get_tree_element_count (tree));
+      if (tree_first < tree_last) {
+        t8_forest_ghost_find_remote_tree_range (forest, itree, tree_first,
+                                                tree_last,
+                                                thread_cands + thread_id);
+      }
+    }
+    t8_element_scratch_finalize_worker ();
+  }
+
+  /* Add the remote elements in the order of the local elements */
+  for (ithread = 0; ithread < num_threads; ithread++) {
+    t8_forest_ghost_add_remote_candidates (forest, ghost,
+                                           thread_cands + ithread);
+  }
+  T8_FREE (thread_cands);
+
+  if (forest->profile != NULL) {
+    /* If profiling is enabled, we count the number of remote processes. */
+    forest->profile->ghosts_remotes = ghost->remote_processes->elem_count;
+  }
+}
 #endif
+
+/* Fill the remote ghosts of a ghost structure of a forest that was adapted
+ * from forest_from, using the ghost layer of forest_from and the adapt map
+ * of forest.
+ * Adapting does not change the partition tables, thus an element that was
+ * kept is a remote element of the same processes as before and we copy
+ * these processes from the ghost layer of forest_from. Only the refined and
+ * coarsened elements are checked again, with the method of
+ * t8_forest_ghost_fill_remote.
+ */
+static void
+t8_forest_ghost_fill_remote_incremental (t8_forest_t forest,
+                                         t8_forest_ghost_t ghost,
+                                         t8_forest_t forest_from,
+                                         int ghost_method)
+{
+  t8_forest_ghost_t   ghost_from;
+  t8_forest_adapt_run_t *run;
+  t8_ghost_remote_candidates_t cands = { NULL, 0, 0 };
+  t8_tree_t           tree, tree_from;
+  t8_element_t       *elem;
+  t8_locidx_t        *owner_offsets, *owner_pos, num_old_elements;
+  t8_locidx_t         iremote_elem, old_index, ielem, ilast, iowner;
+  t8_locidx_t         num_checked = 0;
+  int                *owner_ranks, num_old_remotes, iremote, remote_rank;
+  int                 iface, num_faces;
+  size_t              irun, iiowner;
+  sc_array_t          owners;
+
+  ghost_from = forest_from->ghosts;
+  T8_ASSERT (ghost_from != NULL && ghost_from->remote_offsets != NULL);
+  T8_ASSERT (forest->adapt_map != NULL);
+
+  /* For each old element, the processes for which it is a remote element.
+   * This is the transpose of the remote arrays of ghost_from. */
+  num_old_elements = t8_forest_get_num_element (forest_from);
+  num_old_remotes = ghost_from->remote_processes->elem_count;
+  owner_offsets = T8_ALLOC_ZERO (t8_locidx_t, num_old_elements + 1);
+  for (iremote_elem = 0;
+       iremote_elem < ghost_from->remote_offsets[num_old_remotes];
+       iremote_elem++) {
+    owner_offsets[ghost_from->remote_elements[iremote_elem] + 1]++;
+  }
+  for (ielem = 0; ielem < num_old_elements; ielem++) {
+    owner_offsets[ielem + 1] += owner_offsets[ielem];
+  }
+  owner_ranks = T8_ALLOC (int, owner_offsets[num_old_elements]);
+  owner_pos = T8_ALLOC (t8_locidx_t, num_old_elements);
+  memcpy (owner_pos, owner_offsets, num_old_elements * sizeof (t8_locidx_t));
+  for (iremote = 0; iremote < num_old_remotes; iremote++) {
+    remote_rank =
+      *(int *) sc_array_index_int (ghost_from->remote_processes, iremote);
+    for (iremote_elem = ghost_from->remote_offsets[iremote];
+         iremote_elem < ghost_from->remote_offsets[iremote + 1];
+         iremote_elem++) {
+      old_index = ghost_from->remote_elements[iremote_elem];
+      owner_ranks[owner_pos[old_index]++] = remote_rank;
+    }
+  }
+  T8_FREE (owner_pos);
+
+  if (ghost_method != 0) {
+    sc_array_init (&owners, sizeof (int));
+  }
+  /* The runs are sorted by tree and new element */
+  for (irun = 0; irun < forest->adapt_map->elem_count; irun++) {
+    run = (t8_forest_adapt_run_t *) sc_array_index (forest->adapt_map, irun);
+    tree = t8_forest_get_tree (forest, run->ltree_id);
+    if (run->num_old == 1 && run->num_new == 1) {
+      /* These elements were kept, they have the same remotes as before */
+      tree_from = t8_forest_get_tree (forest_from, run->ltree_id);
+      for (ielem = 0; ielem < run->count; ielem++) {
+        old_index = tree_from->elements_offset + run->first_old + ielem;
+        elem = t8_forest_get_tree_element (tree, run->first_new + ielem);
+        for (iowner = owner_offsets[old_index];
+             iowner < owner_offsets[old_index + 1]; iowner++) {
+          t8_ghost_add_remote (forest, ghost, owner_ranks[iowner],
+                               run->ltree_id, elem, run->first_new + ielem);
+        }
+      }
+      continue;
+    }
+    /* These elements were refined or coarsened, we check them again */
+    ilast = run->first_new + run->count * run->num_new;
+    num_checked += ilast - run->first_new;
+    if (ghost_method == 0) {
+      t8_forest_ghost_find_remote_tree_range (forest, run->ltree_id,
+                                              run->first_new, ilast, &cands);
+      t8_forest_ghost_add_remote_candidates (forest, ghost, &cands);
+      continue;
+    }
+    for (ielem = run->first_new; ielem < ilast; ielem++) {
+      elem = t8_forest_get_tree_element (tree, ielem);
+      num_faces =
+        t8_forest_get_eclass_scheme (forest,
+                                     tree->eclass)->t8_element_num_faces
+        (elem);
+      for (iface = 0; iface < num_faces; iface++) {
+        t8_forest_element_owners_at_neigh_face (forest, run->ltree_id, elem,
+                                                iface, &owners);
+        for (iiowner = 0; iiowner < owners.elem_count; iiowner++) {
+          remote_rank = *(int *) sc_array_index (&owners, iiowner);
+          T8_ASSERT (0 <= remote_rank && remote_rank < forest->mpisize);
+          if (remote_rank != forest->mpirank) {
+            t8_ghost_add_remote (forest, ghost, remote_rank, run->ltree_id,
+                                 elem, ielem);
+          }
+        }
+        sc_array_truncate (&owners);
+      }
+    }
+  }
+  if (ghost_method != 0) {
+    sc_array_reset (&owners);
+  }
+  T8_FREE (owner_offsets);
+  T8_FREE (owner_ranks);
+
+  T8_DEBUGF ("Incremental ghost checked %li of %li elements.\n",
+             (long) num_checked, (long) t8_forest_get_num_element (forest));
+  if (forest->profile != NULL) {
+    /* If profiling is enabled, we count the number of remote processes. */
+    forest->profile->ghosts_remotes = ghost->remote_processes->elem_count;
+  }
 }
 
 /* Fill the remote ghosts of a ghost structure.
@@ -1034,11 +1807,15 @@ t8_forest_ghost_fill_remote_v3 (t8_forest_t forest)
  * If ghost_method is 0, then we assume a balanced forest and
  * construct the remote processes by looking at the half neighbors of an element.
  * Otherwise, we use the owners_at_face method.
+ * For edge and vertex ghosts, we additionally add the processes of the
+ * leaves that touch an element only at an edge or a vertex.
  */
 static void
 t8_forest_ghost_fill_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
                              int ghost_method)
 {
+  t8_ghost_corner_context_t corner_ctx;
+  int                 corner_ghosts;
   t8_element_t       *elem, **half_neighbors = NULL;
   t8_locidx_t         num_local_trees, num_tree_elems;
   t8_locidx_t         itree, ielem;
@@ -1049,12 +1826,18 @@ t8_forest_ghost_fill_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
 
   int                 iface, num_faces;
   int                 num_face_children, max_num_face_children = 0;
-  int                 ichild, owner;
+  int                 ichild, owner, *face_owners = NULL;
   sc_array_t          owners, tree_owners;
   int                 is_atom;
 
   last_class = T8_ECLASS_COUNT;
   num_local_trees = t8_forest_get_num_local_trees (forest);
+  /* Line elements only touch at faces */
+  corner_ghosts = forest->ghost_type != T8_GHOST_FACES
+    && forest->dimension > 1;
+  if (corner_ghosts) {
+    t8_forest_ghost_corner_context_init (forest, &corner_ctx);
+  }
 
   if (ghost_method != 0) {
     sc_array_init (&owners, sizeof (int));
@@ -1107,8 +1890,10 @@ t8_forest_ghost_fill_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
               prev_neigh_scheme->t8_element_destroy (max_num_face_children,
                                                      half_neighbors);
               T8_FREE (half_neighbors);
+              T8_FREE (face_owners);
             }
             half_neighbors = T8_ALLOC (t8_element_t *, num_face_children);
+            face_owners = T8_ALLOC (int, num_face_children);
             /* Allocate memory for the half size face neighbors */
             neigh_scheme->t8_element_new (num_face_children, half_neighbors);
             max_num_face_children = num_face_children;
@@ -1135,12 +1920,12 @@ t8_forest_ghost_fill_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
           if (neighbor_tree >= 0) {
             /* If there exist face neighbor elements (we are not at a domain boundary */
             /* Find the owner process of each face_child */
+            t8_forest_element_find_owners (forest, neighbor_tree,
+                                           half_neighbors, neigh_class,
+                                           num_face_children, 0,
+                                           face_owners);
             for (ichild = 0; ichild < num_face_children; ichild++) {
-              /* find the owner */
-              owner =
-                t8_forest_element_find_owner (forest, neighbor_tree,
-                                              half_neighbors[ichild],
-                                              neigh_class);
+              owner = face_owners[ichild];
               T8_ASSERT (0 <= owner && owner < forest->mpisize);
               if (owner != forest->mpirank) {
                 /* Add the element as a remote element */
@@ -1169,6 +1954,10 @@ t8_forest_ghost_fill_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
           sc_array_truncate (&owners);
         }
       }                         /* end face loop */
+      if (corner_ghosts) {
+        t8_forest_ghost_add_corner_remotes (forest, ghost, &corner_ctx,
+                                            itree, elem, ielem);
+      }
     }                           /* end element loop */
   }                             /* end tree loop */
 
@@ -1177,11 +1966,15 @@ t8_forest_ghost_fill_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
     forest->profile->ghosts_remotes = ghost->remote_processes->elem_count;
   }
   /* Clean-up memory */
+  if (corner_ghosts) {
+    t8_forest_ghost_corner_context_reset (&corner_ctx);
+  }
   if (ghost_method == 0) {
     if (half_neighbors != NULL) {
       neigh_scheme->t8_element_destroy (max_num_face_children,
                                         half_neighbors);
       T8_FREE (half_neighbors);
+      T8_FREE (face_owners);
     }
   }
   else {
@@ -1228,7 +2021,7 @@ t8_forest_ghost_send_start (t8_forest_t forest, t8_forest_ghost_t ghost,
     /* Get the rank of the current remote process. */
     remote_rank = *(int *) sc_array_index_int (ghost->remote_processes,
                                                proc_index);
-    t8_debugf ("Filling send buffer for process %i\n", remote_rank);
+    T8_DEBUGF ("Filling send buffer for process %i\n", remote_rank);
     /* initialize the send_info for the current rank */
     current_send_info->recv_rank = remote_rank;
     current_send_info->num_bytes = 0;
@@ -1342,27 +2135,282 @@ t8_forest_ghost_send_start (t8_forest_t forest, t8_forest_ghost_t ghost,
                     T8_MPI_GHOST_FOREST, forest->mpicomm,
                     *requests + proc_index);
     SC_CHECK_MPI (mpiret);
+    t8_peer_volume_send (T8_PEER_GHOST, remote_rank, bytes_written);
   }                             /* end process loop */
   return send_info;
 }
 
-static void
-t8_forest_ghost_send_end (t8_forest_t forest, t8_forest_ghost_t ghost,
-                          t8_ghost_mpi_send_info_t * send_info,
-                          sc_MPI_Request * requests)
+/* A run of a delta message. The elements of a remote tree are sent as a
+ * sequence of runs. Each run either refers to count ghost elements that
+ * the receiver already got from us in the previous ghost layer, starting
+ * at position old_first among them, or it consists of count new elements
+ * that are stored in the message. */
+typedef struct
 {
-  int                 num_remotes;
-  int                 proc_pos, mpiret;
+  size_t              old_first;        /* T8_GHOST_DELTA_NEW for new elements */
+  size_t              count;
+} t8_ghost_delta_run_t;
 
-  T8_ASSERT (t8_forest_is_committed (forest));
-  T8_ASSERT (ghost != NULL);
+#define T8_GHOST_DELTA_NEW ((size_t) -1)
 
-  /* Get the number of remote processes */
-  num_remotes = ghost->remote_processes->elem_count;
+/* Return the position of value in the sorted array values of length count,
+ * or -1 if it is not contained. */
+static              t8_locidx_t
+t8_ghost_locidx_bsearch (const t8_locidx_t * values, t8_locidx_t count,
+                         t8_locidx_t value)
+{
+  t8_locidx_t         low = 0, high = count - 1, mid;
 
-  /* We wait for all communication to end. */
-  mpiret = sc_MPI_Waitall (num_remotes, requests, sc_MPI_STATUSES_IGNORE);
-  SC_CHECK_MPI (mpiret);
+  while (low <= high) {
+    mid = low + (high - low) / 2;
+    if (values[mid] == value) {
+      return mid;
+    }
+    if (values[mid] < value) {
+      low = mid + 1;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  return -1;
+}
+
+/* Start sending the remote elements of a forest that was adapted from
+ * forest_from as the difference to the ghost layer of forest_from.
+ * The receivers already have the old remote elements of each process as
+ * their ghost elements in forest_from's ghost layer, in the same order.
+ * A kept element that was remote to a process before is only referenced
+ * by its position among the old remote elements, the refined and coarsened
+ * elements are sent in full.
+ * The message looks like:
+ * num_trees | pad | treeid 0 | pad | eclass 0 | pad | num_elems 0 | pad | num_runs 0 | pad | runs | pad | new elements | pad | treeid 1 | ...
+ *  size_t   |     |t8_gloidx |     |t8_eclass |     | size_t      |     | size_t     |     | t8_ghost_delta_run_t | | t8_element_t |
+ */
+static t8_ghost_mpi_send_info_t *
+t8_forest_ghost_send_start_delta (t8_forest_t forest, t8_forest_ghost_t ghost,
+                                  t8_forest_t forest_from,
+                                  sc_MPI_Request ** requests)
+{
+  t8_forest_ghost_t   ghost_from = forest_from->ghosts;
+  t8_ghost_mpi_send_info_t *send_info, *current_send_info;
+  t8_ghost_remote_t  *remote_entry;
+  t8_ghost_remote_tree_t *remote_tree;
+  t8_ghost_delta_run_t *run;
+  t8_forest_adapt_run_t *adapt_run;
+  t8_tree_t           tree, tree_from;
+  sc_array_t          runs, tree_num_runs;
+  t8_locidx_t        *new_to_old, *old_remotes, num_old_remotes;
+  t8_locidx_t         num_elements, ielem, old_index, old_pos, k;
+  size_t              remote_index, irun, first_run, element_size;
+  size_t              num_new, bytes_written;
+  ssize_t             iold;
+  char               *buffer;
+  int                 proc_index, remote_rank, num_remotes, mpiret;
+
+  T8_ASSERT (ghost_from != NULL && ghost_from->remote_offsets != NULL);
+  T8_ASSERT (forest->adapt_map != NULL);
+
+  /* The old index of each new element that was kept, -1 for the others */
+  num_elements = t8_forest_get_num_element (forest);
+  new_to_old = T8_ALLOC (t8_locidx_t, num_elements);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    new_to_old[ielem] = -1;
+  }
+  for (irun = 0; irun < forest->adapt_map->elem_count; irun++) {
+    adapt_run = (t8_forest_adapt_run_t *)
+      sc_array_index (forest->adapt_map, irun);
+    if (adapt_run->num_old == 1 && adapt_run->num_new == 1) {
+      tree = t8_forest_get_tree (forest, adapt_run->ltree_id);
+      tree_from = t8_forest_get_tree (forest_from, adapt_run->ltree_id);
+      for (k = 0; k < adapt_run->count; k++) {
+        new_to_old[tree->elements_offset + adapt_run->first_new + k] =
+          tree_from->elements_offset + adapt_run->first_old + k;
+      }
+    }
+  }
+
+  num_remotes = ghost->remote_processes->elem_count;
+  send_info = T8_ALLOC (t8_ghost_mpi_send_info_t, num_remotes);
+  *requests = T8_ALLOC (sc_MPI_Request, num_remotes);
+  sc_array_init (&runs, sizeof (t8_ghost_delta_run_t));
+  sc_array_init (&tree_num_runs, sizeof (size_t));
+
+  for (proc_index = 0; proc_index < num_remotes; proc_index++) {
+    current_send_info = send_info + proc_index;
+    remote_rank = *(int *) sc_array_index_int (ghost->remote_processes,
+                                               proc_index);
+    current_send_info->recv_rank = remote_rank;
+    current_send_info->request = *requests + proc_index;
+    remote_entry = t8_forest_ghost_get_remote (forest, remote_rank);
+
+    /* The old remote elements of this process, sorted by local index */
+    iold = sc_array_bsearch (ghost_from->remote_processes, &remote_rank,
+                             sc_int_compare);
+    if (iold >= 0) {
+      old_remotes = ghost_from->remote_elements
+        + ghost_from->remote_offsets[iold];
+      num_old_remotes = ghost_from->remote_offsets[iold + 1]
+        - ghost_from->remote_offsets[iold];
+    }
+    else {
+      old_remotes = NULL;
+      num_old_remotes = 0;
+    }
+
+    /* Compute the runs of all trees and count the bytes */
+    sc_array_truncate (&runs);
+    sc_array_truncate (&tree_num_runs);
+    current_send_info->num_bytes = sizeof (size_t);
+    current_send_info->num_bytes +=
+      T8_ADD_PADDING (current_send_info->num_bytes);
+    for (remote_index = 0;
+         remote_index < remote_entry->remote_trees.elem_count;
+         remote_index++) {
+      remote_tree = (t8_ghost_remote_tree_t *)
+        sc_array_index (&remote_entry->remote_trees, remote_index);
+      tree = t8_forest_get_tree (forest,
+                                 t8_forest_get_local_id (forest,
+                                                         remote_tree->
+                                                         global_id));
+      first_run = runs.elem_count;
+      run = NULL;
+      num_new = 0;
+      for (ielem = 0;
+           ielem < (t8_locidx_t) remote_tree->element_indices.elem_count;
+           ielem++) {
+        old_index = new_to_old[tree->elements_offset + *(t8_locidx_t *)
+                               sc_array_index (&remote_tree->element_indices,
+                                               ielem)];
+        old_pos = old_index < 0 ? -1 :
+          t8_ghost_locidx_bsearch (old_remotes, num_old_remotes, old_index);
+        if (run != NULL && old_pos < 0
+            && run->old_first == T8_GHOST_DELTA_NEW) {
+          run->count++;
+        }
+        else if (run != NULL && old_pos >= 0
+                 && run->old_first != T8_GHOST_DELTA_NEW
+                 && run->old_first + run->count == (size_t) old_pos) {
+          run->count++;
+        }
+        else {
+          run = (t8_ghost_delta_run_t *) sc_array_push (&runs);
+          run->old_first = old_pos < 0 ? T8_GHOST_DELTA_NEW : old_pos;
+          run->count = 1;
+        }
+        num_new += old_pos < 0;
+      }
+      *(size_t *) sc_array_push (&tree_num_runs) = runs.elem_count
+        - first_run;
+      /* treeid, eclass, number of elements and number of runs */
+      current_send_info->num_bytes += sizeof (t8_gloidx_t);
+      current_send_info->num_bytes +=
+        T8_ADD_PADDING (current_send_info->num_bytes);
+      current_send_info->num_bytes += sizeof (t8_eclass_t);
+      current_send_info->num_bytes +=
+        T8_ADD_PADDING (current_send_info->num_bytes);
+      current_send_info->num_bytes += sizeof (size_t);
+      current_send_info->num_bytes +=
+        T8_ADD_PADDING (current_send_info->num_bytes);
+      current_send_info->num_bytes += sizeof (size_t);
+      current_send_info->num_bytes +=
+        T8_ADD_PADDING (current_send_info->num_bytes);
+      /* the runs and the new elements */
+      current_send_info->num_bytes +=
+        (runs.elem_count - first_run) * sizeof (t8_ghost_delta_run_t);
+      current_send_info->num_bytes +=
+        T8_ADD_PADDING (current_send_info->num_bytes);
+      current_send_info->num_bytes +=
+        num_new * t8_element_array_get_size (&remote_tree->elements);
+      current_send_info->num_bytes +=
+        T8_ADD_PADDING (current_send_info->num_bytes);
+    }
+
+    /* Fill the buffer */
+    buffer = current_send_info->buffer =
+      T8_ALLOC_ZERO (char, current_send_info->num_bytes);
+    memcpy (buffer, &remote_entry->remote_trees.elem_count, sizeof (size_t));
+    bytes_written = sizeof (size_t);
+    bytes_written += T8_ADD_PADDING (bytes_written);
+    first_run = 0;
+    for (remote_index = 0;
+         remote_index < remote_entry->remote_trees.elem_count;
+         remote_index++) {
+      const size_t        num_runs =
+        *(size_t *) sc_array_index (&tree_num_runs, remote_index);
+      size_t              element_count, ielement = 0;
+
+      remote_tree = (t8_ghost_remote_tree_t *)
+        sc_array_index (&remote_entry->remote_trees, remote_index);
+      T8_ASSERT (remote_tree->mpirank == remote_rank);
+      memcpy (buffer + bytes_written, &remote_tree->global_id,
+              sizeof (t8_gloidx_t));
+      bytes_written += sizeof (t8_gloidx_t);
+      bytes_written += T8_ADD_PADDING (bytes_written);
+      memcpy (buffer + bytes_written, &remote_tree->eclass,
+              sizeof (t8_eclass_t));
+      bytes_written += sizeof (t8_eclass_t);
+      bytes_written += T8_ADD_PADDING (bytes_written);
+      element_count = t8_element_array_get_count (&remote_tree->elements);
+      memcpy (buffer + bytes_written, &element_count, sizeof (size_t));
+      bytes_written += sizeof (size_t);
+      bytes_written += T8_ADD_PADDING (bytes_written);
+      memcpy (buffer + bytes_written, &num_runs, sizeof (size_t));
+      bytes_written += sizeof (size_t);
+      bytes_written += T8_ADD_PADDING (bytes_written);
+      memcpy (buffer + bytes_written, sc_array_index (&runs, first_run),
+              num_runs * sizeof (t8_ghost_delta_run_t));
+      bytes_written += num_runs * sizeof (t8_ghost_delta_run_t);
+      bytes_written += T8_ADD_PADDING (bytes_written);
+      /* Copy the elements of the new runs */
+      element_size = t8_element_array_get_size (&remote_tree->elements);
+      for (irun = first_run; irun < first_run + num_runs; irun++) {
+        run = (t8_ghost_delta_run_t *) sc_array_index (&runs, irun);
+        if (run->old_first == T8_GHOST_DELTA_NEW) {
+          memcpy (buffer + bytes_written,
+                  t8_element_array_index_locidx (&remote_tree->elements,
+                                                 ielement),
+                  run->count * element_size);
+          bytes_written += run->count * element_size;
+        }
+        ielement += run->count;
+      }
+      T8_ASSERT (ielement == element_count);
+      bytes_written += T8_ADD_PADDING (bytes_written);
+      first_run += num_runs;
+      ghost->num_remote_elements += element_count;
+    }
+    T8_ASSERT (bytes_written == current_send_info->num_bytes);
+    mpiret =
+      sc_MPI_Isend (buffer, bytes_written, sc_MPI_BYTE, remote_rank,
+                    T8_MPI_GHOST_FOREST, forest->mpicomm,
+                    *requests + proc_index);
+    SC_CHECK_MPI (mpiret);
+    t8_peer_volume_send (T8_PEER_GHOST, remote_rank, bytes_written);
+  }
+  sc_array_reset (&runs);
+  sc_array_reset (&tree_num_runs);
+  T8_FREE (new_to_old);
+  return send_info;
+}
+
+static void
+t8_forest_ghost_send_end (t8_forest_t forest, t8_forest_ghost_t ghost,
+                          t8_ghost_mpi_send_info_t * send_info,
+                          sc_MPI_Request * requests)
+{
+  int                 num_remotes;
+  int                 proc_pos, mpiret;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (ghost != NULL);
+
+  /* Get the number of remote processes */
+  num_remotes = ghost->remote_processes->elem_count;
+
+  /* We wait for all communication to end. */
+  mpiret = sc_MPI_Waitall (num_remotes, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
 
   /* Clean-up */
   for (proc_pos = 0; proc_pos < num_remotes; proc_pos++) {
@@ -1394,202 +2442,316 @@ t8_forest_ghost_receive_message (int recv_rank, sc_MPI_Comm comm,
   mpiret = sc_MPI_Recv (recv_buffer, *recv_bytes, sc_MPI_BYTE, recv_rank,
                         T8_MPI_GHOST_FOREST, comm, sc_MPI_STATUS_IGNORE);
   SC_CHECK_MPI (mpiret);
+  t8_peer_volume_receive (T8_PEER_GHOST, recv_rank, *recv_bytes);
 
   return recv_buffer;
 }
 
-/* Parse a message from a remote process and correctly include the received
- * elements in the ghost structure.
+/* The part of a message from a remote process that belongs to one tree.
+ * The elements stay in the receive buffer until they are copied into
+ * the ghost tree. */
+typedef struct
+{
+  t8_gloidx_t         global_id;        /* global id of the tree */
+  t8_eclass_t         eclass;   /* The trees element class */
+  size_t              num_elements;     /* The number of elements */
+  size_t              buffer_offset;    /* The position of the elements in the buffer */
+  size_t              num_runs; /* The number of runs of a delta message */
+  size_t              runs_offset;      /* The position of the runs in the buffer */
+  size_t              tree_index;       /* The index of the tree in ghost_trees */
+  size_t              first_element;    /* The index of the first element in the ghost tree */
+} t8_ghost_recv_tree_t;
+
+/* A message from a remote process and its trees */
+typedef struct
+{
+  int                 rank;     /* The rank of the sender */
+  char               *buffer;   /* The receive buffer */
+  int                 num_bytes;        /* The number of bytes received */
+  sc_array_t          trees;    /* The t8_ghost_recv_tree_t of the message */
+} t8_ghost_recv_message_t;
+
+/* Read the trees of a message from a remote process without copying its
+ * elements. Since no other message is needed, we do this as soon as the
+ * message arrives.
  * The message looks like:
  * num_trees | pad | treeid 0 | pad | eclass 0 | pad | num_elems 0 | pad | elements | pad | treeid 1 | ...
  *  size_t   |     |t8_gloidx |     |t8_eclass |     | size_t      |     | t8_element_t |
  *
  * pad is paddind, see T8_ADD_PADDING
- *
- * current_element_offset is updated in each step to store the element offset
- * of the next ghost tree to be inserted.
- * When called with the first message, current_element_offset must be set to 0.
+ * If is_delta is true, the message was sent by
+ * t8_forest_ghost_send_start_delta and the elements of each tree are
+ * preceded by its runs. Then only the new elements are in the buffer.
  */
-/* Currently we expect that the messages arrive in order of the sender's rank. */
 static void
-t8_forest_ghost_parse_received_message (t8_forest_t forest,
-                                        t8_forest_ghost_t ghost,
-                                        t8_locidx_t * current_element_offset,
-                                        int recv_rank, char *recv_buffer,
-                                        int recv_bytes)
-{
-  size_t              bytes_read, first_tree_index = 0, first_element_index =
-    0;
+t8_forest_ghost_scan_received_message (t8_forest_t forest, int recv_rank,
+                                       t8_ghost_recv_message_t * message,
+                                       int is_delta)
+{
+  size_t              bytes_read, num_buffer_elements, irun;
+  t8_ghost_delta_run_t *run;
   t8_locidx_t         num_trees, itree;
-  t8_gloidx_t         global_id;
-  t8_eclass_t         eclass;
-  size_t              num_elements, old_elem_count, ghosts_offset;
-  t8_ghost_gtree_hash_t *tree_hash, **pfound_tree, *found_tree;
-  t8_ghost_tree_t    *ghost_tree;
+  t8_ghost_recv_tree_t *recv_tree;
   t8_eclass_scheme_c *ts;
-  t8_element_t       *element_insert;
-  t8_ghost_process_hash_t *process_hash;
-#ifdef T8_ENABLE_DEBUG
-  int                 added_process;
-#endif
 
   bytes_read = 0;
   /* read the number of trees */
-  num_trees = *(size_t *) recv_buffer;
+  num_trees = *(size_t *) message->buffer;
   bytes_read += sizeof (size_t);
   bytes_read += T8_ADD_PADDING (bytes_read);
 
-  t8_debugf ("Received %li trees from %i (%i bytes)\n",
-             (long) num_trees, recv_rank, recv_bytes);
+  T8_DEBUGF ("Received %li trees from %i (%i bytes)\n",
+             (long) num_trees, recv_rank, message->num_bytes);
 
-  /* Count the total number of ghosts that we receive from this rank */
-  ghosts_offset = ghost->num_ghosts_elements;
+  sc_array_init_size (&message->trees, sizeof (t8_ghost_recv_tree_t),
+                      num_trees);
   for (itree = 0; itree < num_trees; itree++) {
-    /* Get tree id */
-    /* search if tree was inserted */
-    /* if not: new entry, add elements */
-    /* if yes: add the elements to the end of the tree's element array. */
-
+    recv_tree = (t8_ghost_recv_tree_t *)
+      t8_sc_array_index_locidx (&message->trees, itree);
     /* read the global id of this tree. */
-    global_id = *(t8_gloidx_t *) (recv_buffer + bytes_read);
+    recv_tree->global_id = *(t8_gloidx_t *) (message->buffer + bytes_read);
     bytes_read += sizeof (t8_gloidx_t);
     bytes_read += T8_ADD_PADDING (bytes_read);
     /* read the element class of the tree */
-    eclass = *(t8_eclass_t *) (recv_buffer + bytes_read);
+    recv_tree->eclass = *(t8_eclass_t *) (message->buffer + bytes_read);
     bytes_read += sizeof (t8_eclass_t);
     bytes_read += T8_ADD_PADDING (bytes_read);
     /* read the number of elements sent */
-    num_elements = *(size_t *) (recv_buffer + bytes_read);
-
-    /* Add to the counter of ghost elements. */
-    ghost->num_ghosts_elements += num_elements;
-
+    recv_tree->num_elements = *(size_t *) (message->buffer + bytes_read);
     bytes_read += sizeof (size_t);
     bytes_read += T8_ADD_PADDING (bytes_read);
-    /* Search for the tree in the ghost_trees array */
-    tree_hash =
-      (t8_ghost_gtree_hash_t *) sc_mempool_alloc (ghost->glo_tree_mempool);
-    tree_hash->global_id = global_id;
-
-    /* Get the element scheme for this tree */
-    ts = t8_forest_get_eclass_scheme (forest, eclass);
-    if (sc_hash_insert_unique (ghost->global_tree_to_ghost_tree, tree_hash,
-                               (void ***) &pfound_tree)) {
-      /* The tree was not stored already, tree_hash is now an entry in the hash table. */
-      /* If the tree was not contained, it is the newest tree in the array and
-       * thus has as index the number of currently inserted trees. */
-      tree_hash->index = ghost->ghost_trees->elem_count;
-      found_tree = tree_hash;
-      /* We grow the array by one and initilize the entry */
-      ghost_tree = (t8_ghost_tree_t *) sc_array_push (ghost->ghost_trees);
-      ghost_tree->global_id = global_id;
-      ghost_tree->eclass = eclass;
-      /* Initialize the element array */
-      t8_element_array_init_size (&ghost_tree->elements, ts, num_elements);
-      /* pointer to where the elements are to be inserted */
-      element_insert = t8_element_array_get_data (&ghost_tree->elements);
-      /* Compute the element offset of this new tree by adding the offset
-       * of the previous tree to the element count of the previous tree. */
-      ghost_tree->element_offset = *current_element_offset;
-      /* Allocate a new tree_hash for the next search */
-      old_elem_count = 0;
-      tree_hash =
-        (t8_ghost_gtree_hash_t *) sc_mempool_alloc (ghost->glo_tree_mempool);
+    num_buffer_elements = recv_tree->num_elements;
+    recv_tree->num_runs = 0;
+    recv_tree->runs_offset = 0;
+    if (is_delta) {
+      /* read the runs and count the new elements */
+      recv_tree->num_runs = *(size_t *) (message->buffer + bytes_read);
+      bytes_read += sizeof (size_t);
+      bytes_read += T8_ADD_PADDING (bytes_read);
+      recv_tree->runs_offset = bytes_read;
+      num_buffer_elements = 0;
+      for (irun = 0; irun < recv_tree->num_runs; irun++) {
+        run = (t8_ghost_delta_run_t *) (message->buffer + bytes_read) + irun;
+        if (run->old_first == T8_GHOST_DELTA_NEW) {
+          num_buffer_elements += run->count;
+        }
+      }
+      bytes_read += recv_tree->num_runs * sizeof (t8_ghost_delta_run_t);
+      bytes_read += T8_ADD_PADDING (bytes_read);
     }
-    else {
-      /* The entry was found in the trees array */
-      found_tree = *pfound_tree;
-      T8_ASSERT (found_tree->global_id == global_id);
-      /* Get a pointer to the tree */
-      ghost_tree = (t8_ghost_tree_t *) sc_array_index (ghost->ghost_trees,
-                                                       found_tree->index);
-      T8_ASSERT (ghost_tree->eclass == eclass);
-      T8_ASSERT (ghost_tree->global_id == global_id);
-      T8_ASSERT (ghost_tree->elements.scheme == ts);
-
-      old_elem_count = t8_element_array_get_count (&ghost_tree->elements);
-
-      /* Grow the elements array of the tree to fit the new elements */
-      t8_element_array_resize (&ghost_tree->elements,
-                               old_elem_count + num_elements);
-      /* Get a pointer to where the new elements are to be inserted */
-      element_insert = t8_element_array_index_locidx (&ghost_tree->elements,
-                                                      old_elem_count);
-    }
-    if (itree == 0) {
-      /* We store the index of the first tree and the first element of this
-       * rank */
-      first_tree_index = found_tree->index;
-      first_element_index = old_elem_count;
-    }
-    /* Insert the new elements */
-    memcpy (element_insert, recv_buffer + bytes_read,
-            num_elements * ts->t8_element_size ());
-
-    bytes_read += num_elements * ts->t8_element_size ();
+    /* skip the elements */
+    ts = t8_forest_get_eclass_scheme (forest, recv_tree->eclass);
+    recv_tree->buffer_offset = bytes_read;
+    bytes_read += num_buffer_elements * ts->t8_element_size ();
     bytes_read += T8_ADD_PADDING (bytes_read);
-    *current_element_offset += num_elements;
   }
-  T8_ASSERT (bytes_read == (size_t) recv_bytes);
-  T8_FREE (recv_buffer);
-
-  /* At last we add the receiving rank to the ghosts process_offset hash table */
-  process_hash =
-    (t8_ghost_process_hash_t *) sc_mempool_alloc (ghost->proc_offset_mempool);
-  process_hash->mpirank = recv_rank;
-  process_hash->tree_index = first_tree_index;
-  process_hash->first_element = first_element_index;
-  process_hash->ghost_offset = ghosts_offset;
-  /* Insert this rank into the hash table. We assert if the rank was not already
-   * contained. */
-#ifdef T8_ENABLE_DEBUG
-  added_process =
-#else
-  (void)
-#endif
-    sc_hash_insert_unique (ghost->process_offsets, process_hash, NULL);
-  T8_ASSERT (added_process);
+  T8_ASSERT (bytes_read == (size_t) message->num_bytes);
 }
 
-/* In forest_ghost_receive we need a lookup table to give us the position
- * of a process in the ghost->remote_processes array, given the rank of
- * a process. We implement this via a hash table with the following struct
- * as entry. */
-typedef struct t8_recv_list_entry_struct
+/* Merge the trees of all messages into the ghost structure.
+ * The messages are sorted by rank and each rank sends its trees in
+ * ascending order. Since the forest is partitioned, the trees of all
+ * messages form one run that is sorted by global id, in which only the
+ * last tree of a message and the first tree of the next message may be
+ * equal. Thus, we find the ghost trees, their sizes and the position of
+ * each received tree in them in one pass and do not need to sort.
+ * We fill the process_offsets array in the same pass. */
+static void
+t8_forest_ghost_merge_received_trees (t8_forest_t forest,
+                                      t8_forest_ghost_t ghost,
+                                      t8_ghost_recv_message_t * messages,
+                                      int num_messages)
 {
-  int                 rank;     /* The rank of this process */
-  int                 pos_in_remote_processes;  /* The position of this process in the remote_processes array */
-} t8_recv_list_entry_t;
+  t8_ghost_recv_tree_t *recv_tree;
+  t8_ghost_tree_t    *ghost_tree = NULL;
+  t8_ghost_process_t *process_entry;
+  t8_eclass_scheme_c *ts;
+  sc_array_t          tree_counts;
+  size_t              itree, num_ghost_trees;
+  t8_locidx_t         element_offset = 0;
+  int                 imessage;
+
+  T8_ASSERT (ghost->ghost_trees->elem_count == 0);
+  T8_ASSERT (ghost->process_offsets->elem_count == 0);
+
+  sc_array_init (&tree_counts, sizeof (size_t));
+  for (imessage = 0; imessage < num_messages; imessage++) {
+    process_entry = (t8_ghost_process_t *)
+      sc_array_push (ghost->process_offsets);
+    process_entry->mpirank =
+      *(int *) sc_array_index_int (ghost->remote_processes, imessage);
+    process_entry->ghost_offset = element_offset;
+    for (itree = 0; itree < messages[imessage].trees.elem_count; itree++) {
+      recv_tree = (t8_ghost_recv_tree_t *)
+        sc_array_index (&messages[imessage].trees, itree);
+      num_ghost_trees = ghost->ghost_trees->elem_count;
+      T8_ASSERT (ghost_tree == NULL
+                 || ghost_tree->global_id <= recv_tree->global_id);
+      if (ghost_tree == NULL
+          || ghost_tree->global_id != recv_tree->global_id) {
+        /* A new ghost tree. Its elements are allocated below. */
+        ghost_tree = (t8_ghost_tree_t *) sc_array_push (ghost->ghost_trees);
+        ghost_tree->global_id = recv_tree->global_id;
+        ghost_tree->eclass = recv_tree->eclass;
+        ghost_tree->element_offset = element_offset;
+        *(size_t *) sc_array_push (&tree_counts) = 0;
+        num_ghost_trees++;
+      }
+      T8_ASSERT (ghost_tree->eclass == recv_tree->eclass);
+      recv_tree->tree_index = num_ghost_trees - 1;
+      recv_tree->first_element =
+        *(size_t *) sc_array_index (&tree_counts, num_ghost_trees - 1);
+      *(size_t *) sc_array_index (&tree_counts, num_ghost_trees - 1) +=
+        recv_tree->num_elements;
+      if (itree == 0) {
+        /* We store the index of the first tree and the first element of
+         * this rank */
+        process_entry->tree_index = recv_tree->tree_index;
+        process_entry->first_element = recv_tree->first_element;
+      }
+      element_offset += recv_tree->num_elements;
+    }
+    if (messages[imessage].trees.elem_count == 0) {
+      process_entry->tree_index = ghost->ghost_trees->elem_count;
+      process_entry->first_element = 0;
+    }
+  }
+  ghost->num_ghosts_elements = element_offset;
+
+  /* Allocate the elements of the ghost trees, which we fill in parallel */
+  for (itree = 0; itree < ghost->ghost_trees->elem_count; itree++) {
+    ghost_tree = (t8_ghost_tree_t *) sc_array_index (ghost->ghost_trees,
+                                                     itree);
+    ts = t8_forest_get_eclass_scheme (forest, ghost_tree->eclass);
+    t8_element_array_init_size (&ghost_tree->elements, ts,
+                                *(size_t *) sc_array_index (&tree_counts,
+                                                            itree));
+  }
+  sc_array_reset (&tree_counts);
+}
 
-/* We hash these entries by their rank */
-unsigned
-t8_recv_list_entry_hash (const void *v1, const void *u)
+/* The data of the parallel copy of the received elements */
+typedef struct
 {
-  const t8_recv_list_entry_t *e1 = (const t8_recv_list_entry_t *) v1;
+  t8_forest_t         forest;
+  t8_forest_ghost_t   ghost;
+  t8_forest_t         forest_from;      /* If not NULL, the messages are deltas to
+                                           the ghost layer of forest_from. */
+  t8_ghost_recv_message_t *messages;
+} t8_ghost_recv_copy_t;
 
-  return e1->rank;
+/* Copy the elements of a tree of a delta message into their ghost tree.
+ * The old elements are taken from the ghost layer of forest_from. */
+static void
+t8_forest_ghost_copy_received_delta (t8_forest_t forest_from,
+                                     t8_ghost_recv_message_t * message,
+                                     t8_ghost_recv_tree_t * recv_tree,
+                                     t8_element_t * dest,
+                                     size_t element_size)
+{
+  t8_ghost_delta_run_t *runs;
+  t8_ghost_process_t *old_proc = NULL;
+  t8_ghost_tree_t    *old_tree = NULL;
+  const char         *new_elements;
+  size_t              irun;
+  char               *to = (char *) dest;
+
+  runs = (t8_ghost_delta_run_t *) (message->buffer + recv_tree->runs_offset);
+  new_elements = message->buffer + recv_tree->buffer_offset;
+  for (irun = 0; irun < recv_tree->num_runs; irun++) {
+    if (runs[irun].old_first == T8_GHOST_DELTA_NEW) {
+      memcpy (to, new_elements, runs[irun].count * element_size);
+      new_elements += runs[irun].count * element_size;
+    }
+    else {
+      if (old_tree == NULL) {
+        /* The old ghosts of the sender in this tree. The elements of a
+         * rank are consecutive in the ghost layer, thus the position
+         * among them gives the position in the ghost tree. */
+        old_proc = t8_forest_ghost_get_proc_info (forest_from, message->rank);
+        old_tree = t8_forest_ghost_get_tree (forest_from,
+                                             t8_forest_ghost_get_ghost_treeid
+                                             (forest_from,
+                                              recv_tree->global_id));
+        T8_ASSERT (old_tree->eclass == recv_tree->eclass);
+      }
+      T8_ASSERT (old_proc->ghost_offset + (t8_locidx_t) runs[irun].old_first
+                 >= old_tree->element_offset);
+      memcpy (to,
+              t8_element_array_index_locidx (&old_tree->elements,
+                                             (t8_locidx_t)
+                                             (old_proc->ghost_offset +
+                                              runs[irun].old_first -
+                                              old_tree->element_offset)),
+              runs[irun].count * element_size);
+    }
+    to += runs[irun].count * element_size;
+  }
+  T8_ASSERT (to == (char *) dest + recv_tree->num_elements * element_size);
 }
 
-/* two entries are considered equal if they have the same rank. */
-int
-t8_recv_list_entry_equal (const void *v1, const void *v2, const void *u)
+/* Copy the elements of a range of messages into their ghost trees.
+ * The messages write to disjoint parts of the trees.
+ * Since this function runs on several threads, it only copies memory.
+ * The messages are freed by the caller. */
+static void
+t8_forest_ghost_copy_received_range (size_t begin, size_t end,
+                                     int thread_id, void *user_data)
 {
-  const t8_recv_list_entry_t *e1 = (const t8_recv_list_entry_t *) v1;
-  const t8_recv_list_entry_t *e2 = (const t8_recv_list_entry_t *) v2;
-
-  return e1->rank == e2->rank;
+  t8_ghost_recv_copy_t *data = (t8_ghost_recv_copy_t *) user_data;
+  t8_ghost_recv_message_t *message;
+  t8_ghost_recv_tree_t *recv_tree;
+  t8_ghost_tree_t    *ghost_tree;
+  t8_eclass_scheme_c *ts;
+  size_t              imessage, itree;
+
+  for (imessage = begin; imessage < end; imessage++) {
+    message = data->messages + imessage;
+    for (itree = 0; itree < message->trees.elem_count; itree++) {
+      recv_tree = (t8_ghost_recv_tree_t *)
+        sc_array_index (&message->trees, itree);
+      if (recv_tree->num_elements == 0) {
+        continue;
+      }
+      ghost_tree = (t8_ghost_tree_t *)
+        sc_array_index (data->ghost->ghost_trees, recv_tree->tree_index);
+      ts = t8_forest_get_eclass_scheme (data->forest, recv_tree->eclass);
+      if (data->forest_from != NULL) {
+        t8_forest_ghost_copy_received_delta (data->forest_from, message,
+                                             recv_tree,
+                                             t8_element_array_index_locidx
+                                             (&ghost_tree->elements,
+                                              recv_tree->first_element),
+                                             ts->t8_element_size ());
+        continue;
+      }
+      memcpy (t8_element_array_index_locidx (&ghost_tree->elements,
+                                             recv_tree->first_element),
+              message->buffer + recv_tree->buffer_offset,
+              recv_tree->num_elements * ts->t8_element_size ());
+    }
+  }
 }
 
-/* Probe for all incoming messages from the remote ranks and receive them.
- * We receive the message in the order in which they arrive. To achieve this,
- * we have to use polling. */
+/* Probe for all incoming messages from the remote ranks and receive them
+ * in the order of their arrival. We read the trees of each message as soon
+ * as it arrives. After all messages are received, we merge their trees
+ * into the ghost structure and copy the elements from all messages in
+ * parallel.
+ * If forest_from is not NULL, the messages were sent with
+ * t8_forest_ghost_send_start_delta. */
 static void
-t8_forest_ghost_receive (t8_forest_t forest, t8_forest_ghost_t ghost)
+t8_forest_ghost_receive (t8_forest_t forest, t8_forest_ghost_t ghost,
+                         t8_forest_t forest_from)
 {
+  t8_ghost_recv_message_t *messages;
+  t8_ghost_recv_copy_t copy_data;
   int                 num_remotes;
   int                 proc_pos;
   int                 recv_rank;
+  int                 received_messages;
   int                 mpiret;
+  ssize_t             found;
   sc_MPI_Comm         comm;
   sc_MPI_Status       status;
 
@@ -1605,232 +2767,127 @@ t8_forest_ghost_receive (t8_forest_t forest, t8_forest_ghost_t ghost)
     return;
   }
 
-  {
-    /*       This code receives the message in order of their arrival.
-     *       This is effective in terms of runtime, but makes it more difficult
-     *       to store the received data, since the data has to be stored in order of
-     *       ascending ranks.
-     *       We include the received data into the ghost structure in order of the
-     *       ranks of the receivers and we do this as soon as the message from
-     *       the next rank that we can include was received. */
-    char              **buffer;
-    int                *recv_bytes;
-    int                 received_messages = 0;
-    int                *received_flag;
-    int                 last_rank_parsed = -1, parse_it;
-#undef T8_POLLING               /* activates polling for Mpi messages, currently used for testing */
-#ifdef T8_POLLING
-    sc_link_t          *proc_it, *prev;
-    int                 iprobe_flag;
-    sc_list_t          *receivers;
-#else
-    t8_recv_list_entry_t **pfound, *found;
-#ifdef T8_ENABLE_DEBUG
-    int                 ret;
-#endif
-    sc_hash_t          *recv_list_entries_hash;
-#endif
-    t8_recv_list_entry_t recv_list_entry, *recv_list_entries;
-    t8_locidx_t         current_element_offset = 0;
-
-    buffer = T8_ALLOC (char *, num_remotes);
-    recv_bytes = T8_ALLOC (int, num_remotes);
-    received_flag = T8_ALLOC_ZERO (int, num_remotes);
-    recv_list_entries = T8_ALLOC (t8_recv_list_entry_t, num_remotes);
-
-    /* Sort the array of remote processes, such that the ranks are in
-     * ascending order. */
-    sc_array_sort (ghost->remote_processes, sc_int_compare);
-
-    /* We build a hash table of all ranks from which we receive and their position
-     * in the remote_processes array. */
-#ifdef T8_POLLING               /* polling */
-    receivers = sc_list_new (NULL);
-#else
-    recv_list_entries_hash = sc_hash_new (t8_recv_list_entry_hash,
-                                          t8_recv_list_entry_equal, NULL,
-                                          NULL);
-#endif
-    for (proc_pos = 0; proc_pos < num_remotes; proc_pos++) {
-      recv_list_entries[proc_pos].rank =
-        *(int *) sc_array_index_int (ghost->remote_processes, proc_pos);
-      recv_list_entries[proc_pos].pos_in_remote_processes = proc_pos;
-#ifndef T8_POLLING
-#ifdef T8_ENABLE_DEBUG
-      ret =
-#else
-      (void)
-#endif
-        sc_hash_insert_unique (recv_list_entries_hash,
-                               recv_list_entries + proc_pos, NULL);
-      T8_ASSERT (ret == 1);
-#else /* polling */
-      sc_list_append (receivers, recv_list_entries + proc_pos);
-#endif
-    }
-
-  /****     Actual communication    ****/
-
-    /* Until there is only one sender left we iprobe for a message for each
-     * sender and if there is one we receive it and remove the sender from
-     * the list.
-     * The last message can be received via probe */
-#ifdef T8_POLLING
-    while (received_messages < num_remotes - 1) {
-      /* TODO: This part of the code using polling and IProbe to receive the
-       *       messages. We replaced with a non-polling version that uses the
-       *       blocking Probe. */
-      iprobe_flag = 0;
-      prev = NULL;              /* ensure that if the first receive entry is matched first,
-                                   it is removed properly. */
-      for (proc_it = receivers->first; proc_it != NULL && iprobe_flag == 0;) {
-        /* pointer to the rank of a receiver */
-        recv_rank = ((t8_recv_list_entry_t *) proc_it->data)->rank;
-        proc_pos =
-          ((t8_recv_list_entry_t *) proc_it->data)->pos_in_remote_processes;
-
-        mpiret = sc_MPI_Iprobe (recv_rank, T8_MPI_GHOST_FOREST, comm,
-                                &iprobe_flag, &status);
-        SC_CHECK_MPI (mpiret);
-#else
-    while (received_messages < num_remotes) {
-      /* blocking probe for a message. */
-      mpiret = sc_MPI_Probe (sc_MPI_ANY_SOURCE, T8_MPI_GHOST_FOREST, comm,
-                             &status);
-      SC_CHECK_MPI (mpiret);
-#endif
-#ifdef T8_POLLING
-      if (iprobe_flag == 0) {
-        /* There is no message to receive, we continue */
-        prev = proc_it;
-        proc_it = proc_it->next;
-      }
-      else {
-#else
-      /* There is a message to receive, we receive it. */
-      recv_rank = status.MPI_SOURCE;
-      /* Get the position of this rank in the remote processes array */
-      recv_list_entry.rank = recv_rank;
-#ifdef T8_ENABLE_DEBUG
-      ret =
-#else
-      (void)
-#endif
-        sc_hash_lookup (recv_list_entries_hash, &recv_list_entry,
-                        (void ***) &pfound);
-      T8_ASSERT (ret != 0);
-      found = *pfound;
-      proc_pos = found->pos_in_remote_processes;
-#endif
-      T8_ASSERT (status.MPI_TAG == T8_MPI_GHOST_FOREST);
-      buffer[proc_pos] =
-        t8_forest_ghost_receive_message (recv_rank, comm, status,
-                                         recv_bytes + proc_pos);
-      /* mark this entry as received. */
-      T8_ASSERT (received_flag[proc_pos] == 0);
-      received_flag[proc_pos] = 1;
-      received_messages++;
-      /* Parse all messages that we can parse now.
-       * We have to parse the messages in order of their rank. */
-      T8_ASSERT (last_rank_parsed < proc_pos);
-      /* For all ranks that we haven't parsed yet, but can be parsed in order */
-      for (parse_it = last_rank_parsed + 1; parse_it < num_remotes &&
-           received_flag[parse_it] == 1; parse_it++) {
-        recv_rank =
-          *(int *) sc_array_index_int (ghost->remote_processes, parse_it);
-        t8_forest_ghost_parse_received_message (forest, ghost,
-                                                &current_element_offset,
-                                                recv_rank, buffer[parse_it],
-                                                recv_bytes[parse_it]);
-        last_rank_parsed++;
-      }
+  /* Sort the array of remote processes, such that the ranks are in
+   * ascending order. We find the position of a sender by binary search. */
+  sc_array_sort (ghost->remote_processes, sc_int_compare);
+  messages = T8_ALLOC_ZERO (t8_ghost_recv_message_t, num_remotes);
 
-#ifdef T8_POLLING               /* polling */
-      /* Remove the process from the list of receivers. */
-      proc_it = proc_it->next;
-      sc_list_remove (receivers, prev);
-    }
-  }                             /* end for */
-#endif
-#if 0
-  {                             /* this is for indent */
-    {
-#endif
-    }                           /* end while */
-#ifdef T8_POLLING
-    /* polling */
-    T8_ASSERT (receivers->elem_count == 1);
-    /* Get the last rank from which we didnt receive yet */
-    recv_list_entry = *(t8_recv_list_entry_t *) sc_list_pop (receivers);
-    recv_rank = recv_list_entry.rank;
-    proc_pos = recv_list_entry.pos_in_remote_processes;
-    /* destroy the list */
-    sc_list_destroy (receivers);
-    /* Blocking probe for the last message */
-    mpiret = sc_MPI_Probe (recv_rank, T8_MPI_GHOST_FOREST, comm, &status);
+  for (received_messages = 0; received_messages < num_remotes;
+       received_messages++) {
+    /* blocking probe for a message. */
+    mpiret = sc_MPI_Probe (sc_MPI_ANY_SOURCE, T8_MPI_GHOST_FOREST, comm,
+                           &status);
     SC_CHECK_MPI (mpiret);
-    /* Receive the message */
-    T8_ASSERT (received_flag[proc_pos] == 0);
-    buffer[proc_pos] = t8_forest_ghost_receive_message (recv_rank, comm,
-                                                        status,
-                                                        recv_bytes +
-                                                        proc_pos);
-    received_flag[proc_pos] = 1;
-    received_messages++;
-    T8_ASSERT (received_messages == num_remotes);
-    /* parse all messages that are left */
-    /* For all ranks that we haven't parsed yet, but can be parsed in order */
-    for (parse_it = last_rank_parsed + 1; parse_it < num_remotes &&
-         received_flag[parse_it] == 1; parse_it++) {
-      recv_rank =
-        *(int *) sc_array_index_int (ghost->remote_processes, parse_it);
-      t8_forest_ghost_parse_received_message (forest, ghost,
-                                              &current_element_offset,
-                                              recv_rank, buffer[parse_it],
-                                              recv_bytes[parse_it]);
-      last_rank_parsed++;
-    }
-#endif
-#ifdef T8_ENABLE_DEBUG
-    for (parse_it = 0; parse_it < num_remotes; parse_it++) {
-      T8_ASSERT (received_flag[parse_it] == 1);
-    }
-#endif
-    T8_ASSERT (last_rank_parsed == num_remotes - 1);
+    recv_rank = status.MPI_SOURCE;
+    found = sc_array_bsearch (ghost->remote_processes, &recv_rank,
+                              sc_int_compare);
+    T8_ASSERT (found >= 0);
+    proc_pos = (int) found;
+    T8_ASSERT (messages[proc_pos].buffer == NULL);
+    messages[proc_pos].rank = recv_rank;
+    messages[proc_pos].buffer =
+      t8_forest_ghost_receive_message (recv_rank, comm, status,
+                                       &messages[proc_pos].num_bytes);
+    t8_forest_ghost_scan_received_message (forest, recv_rank,
+                                           messages + proc_pos,
+                                           forest_from != NULL);
+  }
 
-    /* clean-up */
-#ifndef T8_POLLING
-    sc_hash_destroy (recv_list_entries_hash);
-#endif
-    T8_FREE (buffer);
-    T8_FREE (received_flag);
-    T8_FREE (recv_list_entries);
-    T8_FREE (recv_bytes);
+  t8_forest_ghost_merge_received_trees (forest, ghost, messages,
+                                        num_remotes);
+  copy_data.forest = forest;
+  copy_data.ghost = ghost;
+  copy_data.forest_from = forest_from;
+  copy_data.messages = messages;
+  t8_parallel_for (0, num_remotes, 1, t8_forest_ghost_copy_received_range,
+                   &copy_data);
+  /* The allocator is not thread-safe, hence we free the messages here */
+  for (proc_pos = 0; proc_pos < num_remotes; proc_pos++) {
+    sc_array_reset (&messages[proc_pos].trees);
+    T8_FREE (messages[proc_pos].buffer);
+  }
+  T8_FREE (messages);
+}
+
+/* Free the remote_ghosts hash array of a ghost structure. */
+static void
+t8_forest_ghost_remote_ghosts_destroy (t8_forest_ghost_t ghost)
+{
+  t8_ghost_remote_t  *remote_entry;
+  t8_ghost_remote_tree_t *remote_tree;
+  size_t              it, it_trees;
 
+  for (it = 0; it < ghost->remote_ghosts->a.elem_count; it++) {
+    remote_entry = (t8_ghost_remote_t *)
+      sc_array_index (&ghost->remote_ghosts->a, it);
+    for (it_trees = 0; it_trees < remote_entry->remote_trees.elem_count;
+         it_trees++) {
+      remote_tree = (t8_ghost_remote_tree_t *)
+        sc_array_index (&remote_entry->remote_trees, it_trees);
+      t8_element_array_reset (&remote_tree->elements);
+      sc_array_reset (&remote_tree->element_indices);
+    }
+    sc_array_reset (&remote_entry->remote_trees);
   }
+  sc_hash_array_destroy (ghost->remote_ghosts);
+  ghost->remote_ghosts = NULL;
+}
 
-#if 0
-  /* Receive the message in order of the sender's rank,
-   * this is a non-optimized version of the code below.
-   * slow but simple. */
+/* After the ghost elements were sent, we do not need the copies of
+ * the remote elements any more. We store for each remote process the
+ * range of its local tree ids and local element indices in flat arrays
+ * and free the remote_ghosts hash array. */
+static void
+t8_forest_ghost_compact_remotes (t8_forest_t forest, t8_forest_ghost_t ghost)
+{
+  t8_ghost_remote_t  *remote_entry;
+  t8_ghost_remote_tree_t *remote_tree;
+  t8_tree_t           local_tree;
+  t8_locidx_t         ltreeid, ielement, elem_count, num_remote_elements;
+  t8_locidx_t         element_pos;
+  size_t              itree;
+  int                 iremote, num_remotes, remote_rank;
 
-  /* Sort the array of remote processes, such that the ranks are in
-   * ascending order. */
-  sc_array_sort (ghost->remote_processes, sc_int_compare);
+  T8_ASSERT (ghost->remote_ghosts != NULL);
+  num_remotes = ghost->remote_processes->elem_count;
 
-  for (proc_pos = 0; proc_pos < num_remotes; proc_pos++) {
-    recv_rank =
-      (int *) sc_array_index_int (ghost->remote_processes, proc_pos);
-    /* blocking probe for a message. */
-    mpiret = sc_MPI_Probe (*recv_rank, T8_MPI_GHOST_FOREST, comm, &status);
-    SC_CHECK_MPI (mpiret);
-    /* receive message */
-    buffer =
-      t8_forest_ghost_receive_message (*recv_rank, comm, status, &recv_bytes);
-    t8_forest_ghost_parse_received_message (forest, ghost, *recv_rank, buffer,
-                                            recv_bytes);
+  ghost->remote_offsets = T8_ALLOC (t8_locidx_t, num_remotes + 1);
+  num_remote_elements = 0;
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote_rank =
+      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+    remote_entry = t8_forest_ghost_get_remote (forest, remote_rank);
+    ghost->remote_offsets[iremote] = num_remote_elements;
+    num_remote_elements += remote_entry->num_elements;
   }
-#endif
+  ghost->remote_offsets[num_remotes] = num_remote_elements;
+  ghost->remote_ltrees = T8_ALLOC (t8_locidx_t, num_remote_elements);
+  ghost->remote_elements = T8_ALLOC (t8_locidx_t, num_remote_elements);
+
+  num_remote_elements = 0;
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote_rank =
+      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+    remote_entry = t8_forest_ghost_get_remote (forest, remote_rank);
+    for (itree = 0; itree < remote_entry->remote_trees.elem_count; itree++) {
+      remote_tree = (t8_ghost_remote_tree_t *)
+        sc_array_index (&remote_entry->remote_trees, itree);
+      ltreeid = t8_forest_get_local_id (forest, remote_tree->global_id);
+      local_tree = t8_forest_get_tree (forest, ltreeid);
+      elem_count = remote_tree->element_indices.elem_count;
+      for (ielement = 0; ielement < elem_count; ielement++) {
+        element_pos = *(t8_locidx_t *)
+          t8_sc_array_index_locidx (&remote_tree->element_indices, ielement);
+        T8_ASSERT (0 <= element_pos);
+        ghost->remote_ltrees[num_remote_elements] = ltreeid;
+        ghost->remote_elements[num_remote_elements] =
+          local_tree->elements_offset + element_pos;
+        num_remote_elements++;
+      }
+    }
+    T8_ASSERT (num_remote_elements == ghost->remote_offsets[iremote + 1]);
+  }
+  t8_forest_ghost_remote_ghosts_destroy (ghost);
 }
 
 /* Create one layer of ghost elements, following the algorithm
@@ -1845,22 +2902,42 @@ t8_forest_ghost_receive (t8_forest_t forest, t8_forest_ghost_t ghost)
  * verion 3 with top-down search
  * for unbalanced_version = -1
  */
-void
-t8_forest_ghost_create_ext (t8_forest_t forest, int unbalanced_version)
+/* Return true if all trees of the forest have the same class and it is
+ * one for which we can find the neighbors across edges and vertices */
+static int
+t8_forest_ghost_corners_supported (t8_forest_t forest)
+{
+  const t8_eclass_t   eclasses[3] =
+    { T8_ECLASS_LINE, T8_ECLASS_QUAD, T8_ECLASS_HEX };
+  int                 iclass;
+
+  for (iclass = 0; iclass < 3; iclass++) {
+    if (forest->cmesh->num_trees_per_eclass[eclasses[iclass]] ==
+        forest->global_num_trees) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void
+t8_forest_ghost_create_ext (t8_forest_t forest, int unbalanced_version,
+                            t8_forest_t forest_from)
 {
   t8_forest_ghost_t   ghost = NULL;
   t8_ghost_mpi_send_info_t *send_info;
   sc_MPI_Request     *requests;
-  int                 create_tree_array = 0, create_gfirst_desc_array = 0;
-  int                 create_element_array = 0;
+  int                 created_tables;
 
   T8_ASSERT (t8_forest_is_committed (forest));
-  t8_global_productionf ("Into t8_forest_ghost with %i local elements.\n",
-                         t8_forest_get_num_element (forest));
+  T8_GLOBAL_INFOF ("Into t8_forest_ghost with %i local elements.\n",
+                   t8_forest_get_num_element (forest));
 
   if (forest->profile != NULL) {
     /* If profiling is enabled, we measure the runtime of ghost_create */
     forest->profile->ghost_runtime = -sc_MPI_Wtime ();
+    t8_counters_start (forest->profile->ghost_counters);
+    t8_profile_memory_start (&forest->profile->ghost_memory);
     /* DO NOT DELETE THE FOLLOWING line.
      * even if you do not want this output. It fixes a bug that occured on JUQUEEN, where the
      * runtimes were computed to 0.
@@ -1869,70 +2946,88 @@ t8_forest_ghost_create_ext (t8_forest_t forest, int unbalanced_version)
                            forest->profile->ghost_runtime);
   }
 
-  if (forest->element_offsets == NULL) {
-    /* create element offset array if not done already */
-    create_element_array = 1;
-    t8_forest_partition_create_offsets (forest);
-  }
-  if (forest->tree_offsets == NULL) {
-    /* Create tree offset array if not done already */
-    create_tree_array = 1;
-    t8_forest_partition_create_tree_offsets (forest);
-  }
-  if (forest->global_first_desc == NULL) {
-    /* Create global first desc array if not done already */
-    create_gfirst_desc_array = 1;
-    t8_forest_partition_create_first_desc (forest);
-  }
+  t8_trace_begin ("ghost");
+  /* The ghost search needs the partition tables */
+  created_tables =
+    t8_forest_partition_tables_require (forest, T8_FOREST_TABLE_ALL);
 
   if (t8_forest_get_num_element (forest) > 0) {
     if (forest->ghost_type == T8_GHOST_NONE) {
-      t8_debugf ("WARNING: Trying to construct ghosts with ghost_type NONE. "
+      T8_DEBUGF ("WARNING: Trying to construct ghosts with ghost_type NONE. "
                  "Ghost layer is not constructed.\n");
+      t8_trace_end ("ghost");
       return;
     }
-    /* Currently we only support face ghosts */
-    T8_ASSERT (forest->ghost_type == T8_GHOST_FACES);
+    SC_CHECK_ABORT (forest->ghost_type == T8_GHOST_FACES
+                    || t8_forest_ghost_corners_supported (forest),
+                    "Ghosts across edges and vertices are only supported "
+                    "for forests of only lines, only quadrilaterals or only "
+                    "hexahedra.\n");
 
     /* Initialize the ghost structure */
     t8_forest_ghost_init (&forest->ghosts, forest->ghost_type);
     ghost = forest->ghosts;
 
-    if (unbalanced_version == -1) {
+    t8_trace_begin ("ghost_fill");
+    if (forest->ghost_type != T8_GHOST_FACES) {
+      /* Only the owners_at_face method knows the edge and vertex
+       * neighbors. */
+      t8_forest_ghost_fill_remote (forest, ghost, 1);
+    }
+    else if (forest_from != NULL) {
+      /* Update the remote elements of the ghost layer of forest_from */
+      t8_forest_ghost_fill_remote_incremental (forest, ghost, forest_from,
+                                               unbalanced_version != 0);
+    }
+    else if (unbalanced_version == -1) {
       t8_forest_ghost_fill_remote_v3 (forest);
     }
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+    else if (unbalanced_version == 0 && forest->set_ghost_threads > 1) {
+      /* Construct the remote elements and processes with threads. */
+      t8_forest_ghost_fill_remote_threaded (forest, ghost,
+                                            forest->set_ghost_threads);
+    }
+#endif
     else {
       /* Construct the remote elements and processes. */
       t8_forest_ghost_fill_remote (forest, ghost, unbalanced_version != 0);
     }
 
+    t8_trace_end ("ghost_fill");
+
     /* Start sending the remote elements */
-    send_info = t8_forest_ghost_send_start (forest, ghost, &requests);
+    t8_trace_begin ("ghost_send");
+    if (forest_from != NULL) {
+      /* Only send the changes to the ghost layer of forest_from */
+      send_info = t8_forest_ghost_send_start_delta (forest, ghost,
+                                                    forest_from, &requests);
+    }
+    else {
+      send_info = t8_forest_ghost_send_start (forest, ghost, &requests);
+    }
+    t8_trace_end ("ghost_send");
 
     /* Reveive the ghost elements from the remote processes */
-    t8_forest_ghost_receive (forest, ghost);
+    t8_trace_begin ("ghost_receive");
+    t8_forest_ghost_receive (forest, ghost, forest_from);
 
     /* End sending the remote elements */
     t8_forest_ghost_send_end (forest, ghost, send_info, requests);
+    t8_trace_end ("ghost_receive");
 
+    /* Replace the remote elements by their indices */
+    t8_forest_ghost_compact_remotes (forest, ghost);
   }
 
-  if (create_element_array) {
-    /* Free the offset memory, if created */
-    t8_shmem_array_destroy (&forest->element_offsets);
-  }
-  if (create_tree_array) {
-    /* Free the offset memory, if created */
-    t8_shmem_array_destroy (&forest->tree_offsets);
-  }
-  if (create_gfirst_desc_array) {
-    /* Free the offset memory, if created */
-    t8_shmem_array_destroy (&forest->global_first_desc);
-  }
+  t8_forest_partition_tables_release (forest, created_tables);
+  t8_trace_end ("ghost");
 
   if (forest->profile != NULL) {
     /* If profiling is enabled, we measure the runtime of ghost_create */
     forest->profile->ghost_runtime += sc_MPI_Wtime ();
+    t8_counters_stop (forest->profile->ghost_counters);
+    t8_profile_memory_stop (&forest->profile->ghost_memory);
     /* We also store the number of ghosts and remotes */
     if (ghost != NULL) {
       forest->profile->ghosts_received = ghost->num_ghosts_elements;
@@ -1950,10 +3045,10 @@ t8_forest_ghost_create_ext (t8_forest_t forest, int unbalanced_version)
                            forest->profile->ghost_runtime);
   }
 
-  t8_global_productionf ("Done t8_forest_ghost with %i local elements and %i"
-                         " ghost elements.\n",
-                         t8_forest_get_num_element (forest),
-                         t8_forest_get_num_ghosts (forest));
+  T8_GLOBAL_INFOF ("Done t8_forest_ghost with %i local elements and %i"
+                   " ghost elements.\n",
+                   t8_forest_get_num_element (forest),
+                   t8_forest_get_num_ghosts (forest));
 }
 
 void
@@ -1962,7 +3057,7 @@ t8_forest_ghost_create (t8_forest_t forest)
   T8_ASSERT (t8_forest_is_committed (forest));
   if (forest->mpisize > 1) {
     /* call unbalanced version of ghost algorithm */
-    t8_forest_ghost_create_ext (forest, 1);
+    t8_forest_ghost_create_ext (forest, 1, NULL);
   }
 }
 
@@ -1973,7 +3068,7 @@ t8_forest_ghost_create_balanced_only (t8_forest_t forest)
   if (forest->mpisize > 1) {
     /* TODO: assert that forest is balanced */
     /* Call balanced version of ghost algorithm */
-    t8_forest_ghost_create_ext (forest, 0);
+    t8_forest_ghost_create_ext (forest, 0, NULL);
   }
 }
 
@@ -1982,7 +3077,300 @@ t8_forest_ghost_create_topdown (t8_forest_t forest)
 {
   T8_ASSERT (t8_forest_is_committed (forest));
 
-  t8_forest_ghost_create_ext (forest, -1);
+  t8_forest_ghost_create_ext (forest, -1, NULL);
+}
+
+void
+t8_forest_ghost_create_incremental (t8_forest_t forest,
+                                    t8_forest_t forest_from)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (t8_forest_is_committed (forest_from));
+  T8_ASSERT (forest->adapt_map != NULL);
+  T8_ASSERT (forest_from->ghosts != NULL);
+
+  if (forest->mpisize > 1) {
+    /* The top-down and the unbalanced version find the same remote
+     * elements, we check the changed elements with the unbalanced one */
+    t8_forest_ghost_create_ext (forest, forest->ghost_algorithm != 1,
+                                forest_from);
+  }
+}
+
+/* A local element and a process for which it is a remote element.
+ * The ghost layers beyond the first one are computed with sorted
+ * arrays of these pairs. */
+typedef struct
+{
+  int                 rank;
+  t8_locidx_t         lelement;
+} t8_ghost_layer_pair_t;
+
+/* Compare two pairs by rank and then by local element index */
+static int
+t8_ghost_layer_pair_compare (const void *pair_a, const void *pair_b)
+{
+  const t8_ghost_layer_pair_t *a = (const t8_ghost_layer_pair_t *) pair_a;
+  const t8_ghost_layer_pair_t *b = (const t8_ghost_layer_pair_t *) pair_b;
+
+  if (a->rank != b->rank) {
+    return a->rank < b->rank ? -1 : 1;
+  }
+  if (a->lelement != b->lelement) {
+    return a->lelement < b->lelement ? -1 : 1;
+  }
+  return 0;
+}
+
+/* Given the processes for which each local and ghost element became part of
+ * the ghost layer in the last step, add all pairs of the next layer that
+ * come from the face neighbors of the local element lelement to cands.
+ * A local neighbor of lelement is in the next layer of each process for
+ * which lelement was added, and lelement is in the next layer of each process
+ * for which a ghost neighbor of lelement was added. */
+static void
+t8_forest_ghost_layer_candidates (t8_forest_t forest, t8_locidx_t lelement,
+                                  const size_t *rank_offsets,
+                                  const int *ranks, sc_array_t * cands)
+{
+  t8_ghost_layer_pair_t *pair;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_t       *leaf;
+  t8_element_scratch_mark_t scratch_mark;
+  t8_locidx_t         ltreeid, num_elements, neigh_index;
+  t8_locidx_t        *element_indices;
+  size_t              irank;
+  int                 iface, num_faces, ineigh, num_neighbors, capacity;
+  int                *dual_faces;
+
+  num_elements = t8_forest_get_num_element (forest);
+  leaf = t8_forest_get_element (forest, lelement, &ltreeid);
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  num_faces = ts->t8_element_num_faces (leaf);
+  for (iface = 0; iface < num_faces; iface++) {
+    /* We only need the indices of the neighbors */
+    t8_element_scratch_mark (&scratch_mark);
+    capacity = ts->t8_element_num_face_children (leaf, iface);
+    element_indices = (t8_locidx_t *)
+      t8_element_scratch_alloc (capacity * sizeof (t8_locidx_t));
+    dual_faces = (int *) t8_element_scratch_alloc (capacity * sizeof (int));
+    num_neighbors =
+      t8_forest_leaf_face_neighbors_ext (forest, ltreeid, leaf, iface,
+                                         capacity, NULL, dual_faces,
+                                         element_indices, &neigh_scheme, 1);
+    for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+      neigh_index = element_indices[ineigh];
+      if (neigh_index < num_elements) {
+        /* The neighbor is a local element */
+        for (irank = rank_offsets[lelement];
+             irank < rank_offsets[lelement + 1]; irank++) {
+          pair = (t8_ghost_layer_pair_t *) sc_array_push (cands);
+          pair->rank = ranks[irank];
+          pair->lelement = neigh_index;
+        }
+      }
+      else {
+        /* The neighbor is a ghost element */
+        for (irank = rank_offsets[neigh_index];
+             irank < rank_offsets[neigh_index + 1]; irank++) {
+          if (ranks[irank] != forest->mpirank) {
+            pair = (t8_ghost_layer_pair_t *) sc_array_push (cands);
+            pair->rank = ranks[irank];
+            pair->lelement = lelement;
+          }
+        }
+      }
+    }
+    t8_element_scratch_release (&scratch_mark);
+  }
+}
+
+/* Replace the ghost layer of a forest by a new one with the remote
+ * elements given as pairs sorted by rank and element. */
+static void
+t8_forest_ghost_rebuild (t8_forest_t forest, sc_array_t * pairs)
+{
+  t8_forest_ghost_t   ghost;
+  t8_ghost_mpi_send_info_t *send_info;
+  t8_ghost_layer_pair_t *pair;
+  sc_MPI_Request     *requests;
+  t8_element_t       *elem;
+  t8_locidx_t         ltreeid;
+  size_t              ipair;
+
+  t8_forest_ghost_unref (&forest->ghosts);
+  t8_forest_ghost_init (&forest->ghosts, forest->ghost_type);
+  ghost = forest->ghosts;
+
+  /* The elements of each remote are added in linear order */
+  for (ipair = 0; ipair < pairs->elem_count; ipair++) {
+    pair = (t8_ghost_layer_pair_t *) sc_array_index (pairs, ipair);
+    elem = t8_forest_get_element (forest, pair->lelement, &ltreeid);
+    t8_ghost_add_remote (forest, ghost, pair->rank, ltreeid, elem,
+                         pair->lelement -
+                         t8_forest_get_tree_element_offset (forest, ltreeid));
+  }
+
+  send_info = t8_forest_ghost_send_start (forest, ghost, &requests);
+  t8_forest_ghost_receive (forest, ghost, NULL);
+  t8_forest_ghost_send_end (forest, ghost, send_info, requests);
+  t8_forest_ghost_compact_remotes (forest, ghost);
+}
+
+void
+t8_forest_ghost_expand (t8_forest_t forest, int depth)
+{
+  t8_forest_ghost_t   ghost;
+  t8_ghost_layer_pair_t *pair, *cand, *last;
+  sc_array_t          pairs, new_pairs, cands, offsets, ranks;
+  t8_locidx_t         num_elements, num_ghosts, ielem, iremote_elem;
+  size_t             *rank_offsets, *rank_pos, ipair, icand;
+  int8_t             *in_band;
+  int                 layer, iremote, num_remotes, remote_rank;
+  int                 created_tables;
+  t8_profile_memory_t memory;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  ghost = forest->ghosts;
+  if (depth < 2 || forest->mpisize == 1 || ghost == NULL) {
+    /* There is nothing to do */
+    return;
+  }
+  T8_ASSERT (ghost->remote_offsets != NULL);
+  if (forest->profile != NULL) {
+    forest->profile->ghost_runtime -= sc_MPI_Wtime ();
+    t8_counters_resume (forest->profile->ghost_counters);
+    t8_profile_memory_start (&memory);
+  }
+  /* The owner searches of the face neighbors need the partition tables */
+  created_tables =
+    t8_forest_partition_tables_require (forest, T8_FOREST_TABLE_ALL);
+
+  /* Store the remote elements of the first layer as pairs. The remote
+   * processes are sorted and so are the remote elements of each process.
+   * The local elements with ghost neighbors are the elements of the first
+   * layer, we mark them as the band in which we search the ghost seeds. */
+  num_elements = t8_forest_get_num_element (forest);
+  in_band = T8_ALLOC_ZERO (int8_t, num_elements);
+  sc_array_init (&pairs, sizeof (t8_ghost_layer_pair_t));
+  num_remotes = ghost->remote_processes->elem_count;
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote_rank =
+      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+    for (iremote_elem = ghost->remote_offsets[iremote];
+         iremote_elem < ghost->remote_offsets[iremote + 1]; iremote_elem++) {
+      pair = (t8_ghost_layer_pair_t *) sc_array_push (&pairs);
+      pair->rank = remote_rank;
+      pair->lelement = ghost->remote_elements[iremote_elem];
+      in_band[pair->lelement] = 1;
+    }
+  }
+  sc_array_init (&new_pairs, sizeof (t8_ghost_layer_pair_t));
+  sc_array_copy (&new_pairs, &pairs);
+  sc_array_init (&cands, sizeof (t8_ghost_layer_pair_t));
+  sc_array_init (&offsets, sizeof (size_t));
+  sc_array_init (&ranks, sizeof (int));
+  rank_pos = T8_ALLOC (size_t, num_elements);
+
+  for (layer = 1; layer < depth; layer++) {
+    /* For each local element, the processes for which it was added to the
+     * ghost layer in the last step. The processes of each element are
+     * sorted, since the new pairs are. */
+    num_ghosts = t8_forest_get_num_ghosts (forest);
+    sc_array_resize (&offsets, num_elements + num_ghosts + 1);
+    rank_offsets = (size_t *) offsets.array;
+    memset (rank_offsets, 0, (num_elements + 1) * sizeof (size_t));
+    for (ipair = 0; ipair < new_pairs.elem_count; ipair++) {
+      pair = (t8_ghost_layer_pair_t *) sc_array_index (&new_pairs, ipair);
+      rank_offsets[pair->lelement + 1]++;
+    }
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      rank_pos[ielem] = rank_offsets[ielem];
+      rank_offsets[ielem + 1] += rank_offsets[ielem];
+    }
+    sc_array_resize (&ranks, rank_offsets[num_elements]);
+    for (ipair = 0; ipair < new_pairs.elem_count; ipair++) {
+      pair = (t8_ghost_layer_pair_t *) sc_array_index (&new_pairs, ipair);
+      *(int *) sc_array_index (&ranks, rank_pos[pair->lelement]++) =
+        pair->rank;
+    }
+    /* The owners of our ghosts tell us for which processes they were added */
+    t8_forest_ghost_exchange_varsize (forest, &offsets, &ranks, 1);
+
+    /* Collect the candidates of the next layer from the face neighbors of
+     * the elements that were added and of the elements in the band */
+    sc_array_truncate (&cands);
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      if (in_band[ielem] || rank_offsets[ielem + 1] > rank_offsets[ielem]) {
+        t8_forest_ghost_layer_candidates (forest, ielem, rank_offsets,
+                                          (int *) ranks.array, &cands);
+      }
+    }
+    sc_array_sort (&cands, t8_ghost_layer_pair_compare);
+
+    /* The new pairs are the candidates that are not yet pairs */
+    sc_array_truncate (&new_pairs);
+    ipair = 0;
+    for (icand = 0; icand < cands.elem_count; icand++) {
+      cand = (t8_ghost_layer_pair_t *) sc_array_index (&cands, icand);
+      while (ipair < pairs.elem_count &&
+             t8_ghost_layer_pair_compare (sc_array_index (&pairs, ipair),
+                                          cand) < 0) {
+        ipair++;
+      }
+      if (ipair < pairs.elem_count &&
+          !t8_ghost_layer_pair_compare (sc_array_index (&pairs, ipair),
+                                        cand)) {
+        continue;
+      }
+      if (new_pairs.elem_count > 0) {
+        last = (t8_ghost_layer_pair_t *)
+          sc_array_index (&new_pairs, new_pairs.elem_count - 1);
+        if (!t8_ghost_layer_pair_compare (last, cand)) {
+          continue;
+        }
+      }
+      *(t8_ghost_layer_pair_t *) sc_array_push (&new_pairs) = *cand;
+    }
+    T8_DEBUGF ("Ghost layer %i adds %li remote elements.\n", layer + 1,
+               (long) new_pairs.elem_count);
+
+    /* Add the new pairs and build the ghost layer with all pairs */
+    if (new_pairs.elem_count > 0) {
+      memcpy (sc_array_push_count (&pairs, new_pairs.elem_count),
+              new_pairs.array, new_pairs.elem_count * new_pairs.elem_size);
+      sc_array_sort (&pairs, t8_ghost_layer_pair_compare);
+    }
+    /* We rebuild the ghost layer even if we did not add pairs, since
+     * our remote processes may have added elements for us */
+    t8_forest_ghost_rebuild (forest, &pairs);
+  }
+
+  T8_FREE (rank_pos);
+  T8_FREE (in_band);
+  sc_array_reset (&pairs);
+  sc_array_reset (&new_pairs);
+  sc_array_reset (&cands);
+  sc_array_reset (&offsets);
+  sc_array_reset (&ranks);
+
+  t8_forest_partition_tables_release (forest, created_tables);
+  if (forest->profile != NULL) {
+    forest->profile->ghost_runtime += sc_MPI_Wtime ();
+    t8_counters_stop (forest->profile->ghost_counters);
+    /* The ghost memory covers the first layer and the expansion */
+    t8_profile_memory_stop (&memory);
+    forest->profile->ghost_memory.peak =
+      SC_MAX (forest->profile->ghost_memory.peak, memory.peak);
+    forest->profile->ghost_memory.after = memory.after;
+    forest->profile->ghosts_received = forest->ghosts->num_ghosts_elements;
+    forest->profile->ghosts_shipped = forest->ghosts->num_remote_elements;
+    forest->profile->ghosts_remotes =
+      forest->ghosts->remote_processes->elem_count;
+  }
 }
 
 /** Return the array of remote ranks.
@@ -2013,7 +3401,7 @@ t8_forest_ghost_get_remotes (t8_forest_t forest, int *num_remotes)
 t8_locidx_t
 t8_forest_ghost_remote_first_tree (t8_forest_t forest, int remote)
 {
-  t8_ghost_process_hash_t *proc_entry;
+  t8_ghost_process_t *proc_entry;
 
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (forest->ghosts != NULL);
@@ -2031,256 +3419,979 @@ t8_forest_ghost_remote_first_tree (t8_forest_t forest, int remote)
 t8_locidx_t
 t8_forest_ghost_remote_first_elem (t8_forest_t forest, int remote)
 {
-  t8_ghost_process_hash_t *proc_entry;
+  t8_ghost_process_t *proc_entry;
 
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (forest->ghosts != NULL);
 
-  proc_entry = t8_forest_ghost_get_proc_info (forest, remote);
-  T8_ASSERT (proc_entry->mpirank == remote);
+  proc_entry = t8_forest_ghost_get_proc_info (forest, remote);
+  T8_ASSERT (proc_entry->mpirank == remote);
+
+  return proc_entry->ghost_offset;
+}
+
+/* Fill the send buffer for a ghost data exchange for the remote process
+ * at position iremote in remote_processes.
+ * returns the number of bytes in the buffer. */
+static              size_t
+t8_forest_ghost_exchange_fill_send_buffer (t8_forest_t forest, int iremote,
+                                           char **pbuffer,
+                                           sc_array_t * element_data)
+{
+  char               *buffer;
+  t8_forest_ghost_t   ghost;
+  size_t              data_size, byte_count;
+  t8_locidx_t         ielement, first, last;
+
+  ghost = forest->ghosts;
+  data_size = element_data->elem_size;
+  first = ghost->remote_offsets[iremote];
+  last = ghost->remote_offsets[iremote + 1];
+
+  /* allocate memory for the send buffer */
+  byte_count = data_size * (last - first);
+  buffer = *pbuffer = T8_ALLOC (char, byte_count);
+
+  /* Copy the data of the remote elements from the element_data array
+   * to the send buffer */
+  for (ielement = first; ielement < last; ielement++) {
+    memcpy (buffer + (ielement - first) * data_size,
+            sc_array_index (element_data, ghost->remote_elements[ielement]),
+            data_size);
+  }
+  return byte_count;
+}
+
+t8_forest_ghost_exchange_t *
+t8_forest_ghost_exchange_begin (t8_forest_t forest, sc_array_t * element_data)
+{
+  t8_forest_ghost_exchange_t *data_exchange;
+  t8_forest_ghost_t   ghost;
+  size_t              bytes_to_send, ghost_start;
+  int                 iremote, remote_rank;
+  int                 mpiret, recv_rank, bytes_recv;
+  char              **send_buffers;
+  t8_ghost_process_t *process_entry;
+  t8_locidx_t         remote_offset, next_offset;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (element_data != NULL);
+
+  /* Allocate the new exchange context */
+  data_exchange = T8_ALLOC_ZERO (t8_forest_ghost_exchange_t, 1);
+  data_exchange->forest = forest;
+  if (forest->ghosts == NULL) {
+    /* This process has no ghosts, there is nothing to exchange */
+    if (forest->profile != NULL) {
+      data_exchange->begin_time = sc_MPI_Wtime ();
+    }
+    return data_exchange;
+  }
+  T8_ASSERT ((t8_locidx_t) element_data->elem_count ==
+             t8_forest_get_num_element (forest)
+             + t8_forest_get_num_ghosts (forest));
+
+  ghost = forest->ghosts;
+  /* The number of processes we need to send to */
+  data_exchange->num_remotes = ghost->remote_processes->elem_count;
+  /* Allocate MPI requests */
+  data_exchange->send_requests = T8_ALLOC (sc_MPI_Request,
+                                           data_exchange->num_remotes);
+  data_exchange->recv_requests = T8_ALLOC (sc_MPI_Request,
+                                           data_exchange->num_remotes);
+  /* Allocate pointers to send buffers */
+  send_buffers = data_exchange->send_buffers =
+    T8_ALLOC (char *, data_exchange->num_remotes);
+
+  for (iremote = 0; iremote < data_exchange->num_remotes; iremote++) {
+    /* Iterate over all remote processes and fill their send buffers */
+    remote_rank =
+      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+    /* Fill the send buffers and compute the number of bytes to send */
+    bytes_to_send =
+      t8_forest_ghost_exchange_fill_send_buffer (forest, iremote,
+                                                 send_buffers + iremote,
+                                                 element_data);
+
+    /* Post the asynchronuos send */
+    mpiret = sc_MPI_Isend (send_buffers[iremote], bytes_to_send, sc_MPI_BYTE,
+                           remote_rank, T8_MPI_GHOST_EXC_FOREST,
+                           forest->mpicomm,
+                           data_exchange->send_requests + iremote);
+    SC_CHECK_MPI (mpiret);
+    t8_peer_volume_send (T8_PEER_GHOST_EXCHANGE, remote_rank, bytes_to_send);
+  }
+
+  /* The index in element_data at which the ghost elements start */
+  ghost_start = t8_forest_get_num_element (forest);
+  /* Receive the incoming messages */
+#if 0
+  while (received_messages < data_exchange->num_remotes) {
+    /* Blocking test for incoming message */
+    mpiret = sc_MPI_Probe (sc_MPI_ANY_SOURCE, T8_MPI_GHOST_EXC_FOREST,
+                           forest->mpicomm, &recv_status);
+    SC_CHECK_MPI (mpiret);
+    recv_rank = recv_status.MPI_SOURCE;
+    /* Get the number of bytes to receive */
+    mpiret = sc_MPI_Get_count (&recv_status, sc_MPI_BYTE, &bytes_recv);
+    SC_CHECK_MPI (mpiret);
+
+    /* We need to compute the offset in element_data to which we can receive the message */
+    /* Search for this process' entry in the ghost struct */
+    process_entry = t8_forest_ghost_get_proc_info (forest, recv_rank);
+    /* In process_entry we stored the offset of this ranks ghosts under all
+     * ghosts. Thus in element_data we look at the position
+     *  ghost_start + offset
+     */
+    /* receive the message */
+    sc_MPI_Recv (sc_array_index
+                 (element_data, ghost_start + process_entry->ghost_offset),
+                 bytes_recv, sc_MPI_BYTE, recv_rank, T8_MPI_GHOST_EXC_FOREST,
+                 forest->mpicomm, sc_MPI_STATUS_IGNORE);
+    t8_peer_volume_receive (T8_PEER_GHOST_EXCHANGE, recv_rank, bytes_recv);
+    received_messages++;
+  }
+#endif
+  for (iremote = 0; iremote < data_exchange->num_remotes; iremote++) {
+    /* We need to compute the offset in element_data to which we can receive the message */
+    /* Search for this processes' entry in the ghost struct */
+    recv_rank =
+      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+    process_entry = t8_forest_ghost_get_proc_info_at (ghost, iremote);
+    /* In process_entry we stored the offset of this ranks ghosts under all
+     * ghosts. Thus in element_data we look at the position
+     *  ghost_start + offset
+     */
+    remote_offset = process_entry->ghost_offset;
+    /* Compute the offset of the next remote rank */
+    if (iremote + 1 < data_exchange->num_remotes) {
+      process_entry = t8_forest_ghost_get_proc_info_at (ghost, iremote + 1);
+      next_offset = process_entry->ghost_offset;
+    }
+    else {
+      /* We are the last rank, the next offset is the total number of ghosts */
+      next_offset = ghost->num_ghosts_elements;
+    }
+    /* Calculate the number of bytes to receive */
+    bytes_recv = (next_offset - remote_offset) * element_data->elem_size;
+    /* receive the message */
+    mpiret =
+      sc_MPI_Irecv (sc_array_index
+                    (element_data, ghost_start + remote_offset), bytes_recv,
+                    sc_MPI_BYTE, recv_rank, T8_MPI_GHOST_EXC_FOREST,
+                    forest->mpicomm, data_exchange->recv_requests + iremote);
+    SC_CHECK_MPI (mpiret);
+    t8_peer_volume_receive (T8_PEER_GHOST_EXCHANGE, recv_rank, bytes_recv);
+  }
+  if (forest->profile != NULL) {
+    data_exchange->begin_time = sc_MPI_Wtime ();
+  }
+  return data_exchange;
+}
+
+void
+t8_forest_ghost_exchange_end (t8_forest_ghost_exchange_t * data_exchange)
+{
+  t8_forest_t         forest;
+  double              end_time = 0;
+  int                 iproc;
+
+  T8_ASSERT (data_exchange != NULL);
+  forest = data_exchange->forest;
+  T8_ASSERT (t8_forest_is_committed (forest));
+  if (forest->profile != NULL) {
+    /* The caller worked since begin returned */
+    end_time = sc_MPI_Wtime ();
+    forest->profile->ghost_overlap_time = end_time
+      - data_exchange->begin_time;
+  }
+  /* Wait for all communications to end */
+  sc_MPI_Waitall (data_exchange->num_remotes, data_exchange->recv_requests,
+                  sc_MPI_STATUSES_IGNORE);
+  sc_MPI_Waitall (data_exchange->num_remotes, data_exchange->send_requests,
+                  sc_MPI_STATUSES_IGNORE);
+  if (forest->profile != NULL) {
+    forest->profile->ghost_waittime = sc_MPI_Wtime () - end_time;
+  }
+
+  /* Free the send buffers */
+  for (iproc = 0; iproc < data_exchange->num_remotes; iproc++) {
+    T8_FREE (data_exchange->send_buffers[iproc]);
+  }
+  T8_FREE (data_exchange->send_buffers);
+  /* free requests */
+  T8_FREE (data_exchange->send_requests);
+  T8_FREE (data_exchange->recv_requests);
+  T8_FREE (data_exchange);
+}
+
+/** A persistent ghost data exchange.
+ * The send buffer of remote i holds the data of the local elements
+ * send_indices[send_offsets[i]] to send_indices[send_offsets[i + 1] - 1].
+ * The data of all ghosts is received into recv_buffer, in the order
+ * of the ghosts in the forest.
+ * If use_rma is true, recv_buffer is exposed in window and the send buffer
+ * of remote i is put into the window of remote i at byte offset
+ * target_disps[i]. Otherwise we use persistent requests.
+ */
+struct t8_forest_ghost_plan
+{
+  t8_forest_t         forest;
+                    /** The forest, of which we hold a reference */
+  size_t              data_size;
+                    /** The number of bytes per element */
+  int                 num_remotes;
+                    /** The number of processes that we exchange with */
+  const t8_locidx_t  *send_offsets;
+                        /** For each remote the start in send_indices */
+  const t8_locidx_t  *send_indices;
+                        /** The local indices of the elements to send, owned by the ghost layer */
+  char               *send_buffer;
+                       /** The send buffers of all remotes in one block */
+  char               *recv_buffer;
+                       /** The data of all ghost elements */
+  size_t              send_bytes;
+                       /** The number of bytes of send_buffer */
+  size_t              recv_bytes;
+                       /** The number of bytes of recv_buffer */
+  sc_MPI_Request     *requests;
+                           /** The receive requests followed by the send requests */
+  char               *element_data;
+                        /** The data of the exchange in progress */
+  int                 in_progress;
+                      /** True between begin and end */
+  double              begin_time;
+                    /** The time at which begin returned, if profiling */
+  int                 on_device;
+                    /** True if the buffers are allocated with ops */
+  t8_device_ops_t     ops;
+                    /** The memory operations of a device plan */
+  t8_forest_ghost_kernels_t kernels;
+                    /** Pack and unpack the buffers */
+  t8_locidx_t        *device_indices;
+                         /** The copy of send_indices on the device, or NULL */
+  int                 use_rma;
+                    /** True if the data is put into windows */
+#ifdef SC_ENABLE_MPI
+  MPI_Win             window;
+                    /** The window of recv_buffer, if use_rma */
+  MPI_Group           group;
+                    /** The group of the remotes, if use_rma */
+  MPI_Aint           *target_disps;
+                        /** For each remote the offset of our data in its window */
+#endif
+};
+
+static void
+t8_forest_ghost_gather_host (void *send_buffer, const void *element_data,
+                             const t8_locidx_t * indices,
+                             t8_locidx_t num_indices, size_t data_size,
+                             void *user_data)
+{
+  t8_locidx_t         isend;
+
+  for (isend = 0; isend < num_indices; isend++) {
+    memcpy ((char *) send_buffer + isend * data_size,
+            (const char *) element_data + indices[isend] * data_size,
+            data_size);
+  }
+}
+
+static void
+t8_forest_ghost_scatter_host (void *ghost_data, const void *recv_buffer,
+                              size_t size, void *user_data)
+{
+  memcpy (ghost_data, recv_buffer, size);
+}
+
+const t8_forest_ghost_kernels_t t8_forest_ghost_kernels_host = {
+  t8_forest_ghost_gather_host, t8_forest_ghost_scatter_host, NULL
+};
+
+/* Compute the layout of a ghost data exchange of the forest.
+ * For the i-th remote process in ghost->remote_processes we send the data of
+ * the local elements send_indices[send_offsets[i]] to
+ * send_indices[send_offsets[i + 1] - 1] and we receive the data of the
+ * ghosts recv_offsets[i] to recv_offsets[i + 1] - 1.
+ * The send arrays belong to the ghost layer. The receive offsets are
+ * allocated and must be freed by the caller.
+ * The forest must have ghosts. */
+static void
+t8_forest_ghost_exchange_layout (t8_forest_t forest,
+                                 const t8_locidx_t ** psend_offsets,
+                                 const t8_locidx_t ** psend_indices,
+                                 t8_locidx_t ** precv_offsets)
+{
+  t8_forest_ghost_t   ghost;
+  t8_locidx_t        *recv_offsets;
+  int                 iremote, num_remotes;
+
+  ghost = forest->ghosts;
+  T8_ASSERT (ghost != NULL);
+  num_remotes = ghost->remote_processes->elem_count;
+  *psend_offsets = ghost->remote_offsets;
+  *psend_indices = ghost->remote_elements;
+
+  /* The offset of the ghosts of each remote among all ghosts */
+  recv_offsets = *precv_offsets = T8_ALLOC (t8_locidx_t, num_remotes + 1);
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    recv_offsets[iremote] =
+      t8_forest_ghost_get_proc_info_at (ghost, iremote)->ghost_offset;
+  }
+  recv_offsets[num_remotes] = ghost->num_ghosts_elements;
+}
+
+#ifdef SC_ENABLE_MPI
+/* Set up the one-sided communication of a host plan.
+ * We learn from each remote where our data goes in its receive buffer,
+ * create the window of our receive buffer and the group of the remotes.
+ * recv_offsets is as in t8_forest_ghost_exchange_layout, or NULL if this
+ * process has no ghost layer.
+ * This function is collective over the communicator of the forest. */
+static void
+t8_forest_ghost_plan_setup_rma (t8_forest_ghost_plan_t * plan,
+                                const t8_locidx_t * recv_offsets)
+{
+  t8_forest_ghost_t   ghost = plan->forest->ghosts;
+  sc_MPI_Comm         comm = plan->forest->mpicomm;
+  MPI_Group           comm_group;
+  MPI_Request        *requests;
+  t8_locidx_t        *remote_offsets;
+  int                *ranks = NULL;
+  int                 iremote, mpiret;
+
+  T8_ASSERT (!plan->on_device);
+  plan->use_rma = 1;
+  if (plan->num_remotes > 0) {
+    ranks = (int *) ghost->remote_processes->array;
+  }
+  /* The ghost relation is symmetric, so each remote sends us the offset of
+   * its ghosts from us in its receive buffer and we send it ours. */
+  requests = T8_ALLOC (MPI_Request, 2 * plan->num_remotes);
+  remote_offsets = T8_ALLOC (t8_locidx_t, plan->num_remotes);
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    mpiret = MPI_Irecv (remote_offsets + iremote, 1, T8_MPI_LOCIDX,
+                        ranks[iremote], T8_MPI_GHOST_EXC_FOREST, comm,
+                        requests + iremote);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Isend ((void *) (recv_offsets + iremote), 1, T8_MPI_LOCIDX,
+                        ranks[iremote], T8_MPI_GHOST_EXC_FOREST, comm,
+                        requests + plan->num_remotes + iremote);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_Waitall (2 * plan->num_remotes, requests,
+                        MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  plan->target_disps = T8_ALLOC (MPI_Aint, plan->num_remotes);
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    plan->target_disps[iremote] =
+      (MPI_Aint) remote_offsets[iremote] * plan->data_size;
+  }
+  T8_FREE (remote_offsets);
+  T8_FREE (requests);
+
+  /* The displacement unit is one byte */
+  mpiret = MPI_Win_create (plan->recv_buffer, (MPI_Aint) plan->recv_bytes,
+                           1, MPI_INFO_NULL, comm, &plan->window);
+  SC_CHECK_MPI (mpiret);
+  plan->group = MPI_GROUP_NULL;
+  if (plan->num_remotes > 0) {
+    mpiret = MPI_Comm_group (comm, &comm_group);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Group_incl (comm_group, plan->num_remotes, ranks,
+                             &plan->group);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Group_free (&comm_group);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+#endif
+
+/* Create a ghost exchange plan. If ops is NULL, the buffers are allocated
+ * on the host, otherwise with ops. If use_rma is true, the plan
+ * communicates one-sided and this function is collective. */
+static t8_forest_ghost_plan_t *
+t8_forest_ghost_plan_new_ext (t8_forest_t forest, size_t data_size,
+                              const t8_device_ops_t * ops,
+                              const t8_forest_ghost_kernels_t * kernels,
+                              int use_rma)
+{
+  t8_forest_ghost_plan_t *plan;
+  t8_forest_ghost_t   ghost;
+  t8_locidx_t        *recv_offsets, num_send;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (data_size > 0);
+  T8_ASSERT (kernels != NULL);
+  T8_ASSERT (kernels->gather != NULL && kernels->scatter != NULL);
+
+  plan = T8_ALLOC_ZERO (t8_forest_ghost_plan_t, 1);
+  t8_forest_ref (forest);
+  plan->forest = forest;
+  plan->data_size = data_size;
+  plan->kernels = *kernels;
+  if (ops != NULL) {
+    T8_ASSERT (ops->alloc != NULL && ops->free != NULL
+               && ops->copy_to_device != NULL);
+    plan->on_device = 1;
+    plan->ops = *ops;
+  }
+  ghost = forest->ghosts;
+  if (ghost == NULL) {
+    /* This process has no ghosts, there is nothing to exchange */
+#ifdef SC_ENABLE_MPI
+    if (use_rma) {
+      /* We still take part in the creation of the window */
+      t8_forest_ghost_plan_setup_rma (plan, NULL);
+    }
+#endif
+    return plan;
+  }
+#ifndef SC_ENABLE_MPI
+  /* Without MPI there is only one process and no remote */
+  T8_ASSERT (ghost->remote_processes->elem_count == 0);
+#endif
+  plan->num_remotes = ghost->remote_processes->elem_count;
+  t8_forest_ghost_exchange_layout (forest, &plan->send_offsets,
+                                   &plan->send_indices, &recv_offsets);
+
+  num_send = plan->send_offsets[plan->num_remotes];
+  plan->send_bytes = num_send * data_size;
+  plan->recv_bytes = recv_offsets[plan->num_remotes] * data_size;
+  if (!plan->on_device) {
+    /* The buffers live as long as the plan, so they are allocated according
+     * to the allocation policy of t8_init_ext */
+    plan->send_buffer = (char *) t8_alloc_large (plan->send_bytes);
+    plan->recv_buffer = (char *) t8_alloc_large (plan->recv_bytes);
+  }
+  else {
+    /* The device operations do not accept empty allocations */
+    if (num_send > 0) {
+      plan->send_buffer =
+        (char *) plan->ops.alloc (plan->send_bytes, plan->ops.user_data);
+      plan->device_indices = (t8_locidx_t *)
+        plan->ops.alloc (num_send * sizeof (t8_locidx_t),
+                         plan->ops.user_data);
+      plan->ops.copy_to_device (plan->device_indices, plan->send_indices,
+                                num_send * sizeof (t8_locidx_t),
+                                plan->ops.user_data);
+      plan->send_indices = plan->device_indices;
+    }
+    if (plan->recv_bytes > 0) {
+      plan->recv_buffer =
+        (char *) plan->ops.alloc (plan->recv_bytes, plan->ops.user_data);
+    }
+  }
+  plan->requests = T8_ALLOC (sc_MPI_Request, 2 * plan->num_remotes);
+
+#ifdef SC_ENABLE_MPI
+  if (use_rma) {
+    t8_forest_ghost_plan_setup_rma (plan, recv_offsets);
+  }
+  else {
+    int                 iremote, remote_rank, mpiret;
+
+    for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+      remote_rank =
+        *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+      mpiret =
+        MPI_Recv_init (plan->recv_buffer + recv_offsets[iremote] * data_size,
+                       (int) ((recv_offsets[iremote + 1] -
+                               recv_offsets[iremote]) * data_size), MPI_BYTE,
+                       remote_rank, T8_MPI_GHOST_EXC_FOREST, forest->mpicomm,
+                       plan->requests + iremote);
+      SC_CHECK_MPI (mpiret);
+      mpiret =
+        MPI_Send_init (plan->send_buffer
+                       + plan->send_offsets[iremote] * data_size,
+                       (int) ((plan->send_offsets[iremote + 1] -
+                               plan->send_offsets[iremote]) * data_size),
+                       MPI_BYTE, remote_rank, T8_MPI_GHOST_EXC_FOREST,
+                       forest->mpicomm,
+                       plan->requests + plan->num_remotes + iremote);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+#endif
+  T8_FREE (recv_offsets);
+  return plan;
+}
+
+t8_forest_ghost_plan_t *
+t8_forest_ghost_plan_new (t8_forest_t forest, size_t data_size)
+{
+  return t8_forest_ghost_plan_new_ext (forest, data_size, NULL,
+                                       &t8_forest_ghost_kernels_host, 0);
+}
+
+t8_forest_ghost_plan_t *
+t8_forest_ghost_plan_new_rma (t8_forest_t forest, size_t data_size)
+{
+  /* Without MPI there are no remotes and we fall back to the plain plan */
+  return t8_forest_ghost_plan_new_ext (forest, data_size, NULL,
+                                       &t8_forest_ghost_kernels_host, 1);
+}
+
+t8_forest_ghost_plan_t *
+t8_forest_ghost_plan_new_device (t8_forest_t forest, size_t data_size,
+                                 const t8_device_ops_t * ops,
+                                 const t8_forest_ghost_kernels_t * kernels)
+{
+  T8_ASSERT (ops != NULL);
+  return t8_forest_ghost_plan_new_ext (forest, data_size, ops, kernels, 0);
+}
+
+void
+t8_forest_ghost_plan_begin_device (t8_forest_ghost_plan_t * plan,
+                                   void *element_data)
+{
+  t8_locidx_t         num_send;
+
+  T8_ASSERT (plan != NULL);
+  T8_ASSERT (!plan->in_progress);
+  T8_ASSERT (element_data != NULL
+             || t8_forest_get_num_element (plan->forest)
+             + t8_forest_get_num_ghosts (plan->forest) == 0);
+
+  plan->element_data = (char *) element_data;
+  plan->in_progress = 1;
+  if (plan->num_remotes > 0) {
+    /* Post the receives first, then pack and send */
+#ifdef SC_ENABLE_MPI
+    int                 mpiret;
+
+    if (plan->use_rma) {
+      /* Expose our receive buffer to the remotes and open the access
+       * epoch to theirs */
+      mpiret = MPI_Win_post (plan->group, 0, plan->window);
+      SC_CHECK_MPI (mpiret);
+      mpiret = MPI_Win_start (plan->group, 0, plan->window);
+      SC_CHECK_MPI (mpiret);
+    }
+    else {
+      mpiret = MPI_Startall (plan->num_remotes, plan->requests);
+      SC_CHECK_MPI (mpiret);
+    }
+#endif
+    num_send = plan->send_offsets[plan->num_remotes];
+    if (num_send > 0) {
+      plan->kernels.gather (plan->send_buffer, element_data,
+                            plan->send_indices, num_send, plan->data_size,
+                            plan->kernels.user_data);
+    }
+#ifdef SC_ENABLE_MPI
+    if (plan->use_rma) {
+      int                 iremote, count;
+      t8_forest_ghost_t   ghost = plan->forest->ghosts;
+
+      for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+        count = (int) ((plan->send_offsets[iremote + 1] -
+                        plan->send_offsets[iremote]) * plan->data_size);
+        mpiret = MPI_Put (plan->send_buffer
+                          + plan->send_offsets[iremote] * plan->data_size,
+                          count, MPI_BYTE,
+                          *(int *) sc_array_index_int (ghost->remote_processes,
+                                                       iremote),
+                          plan->target_disps[iremote], count, MPI_BYTE,
+                          plan->window);
+        SC_CHECK_MPI (mpiret);
+      }
+    }
+    else {
+      mpiret = MPI_Startall (plan->num_remotes,
+                             plan->requests + plan->num_remotes);
+      SC_CHECK_MPI (mpiret);
+    }
+#endif
+  }
+  if (plan->forest->profile != NULL) {
+    plan->begin_time = sc_MPI_Wtime ();
+  }
+}
+
+void
+t8_forest_ghost_plan_begin (t8_forest_ghost_plan_t * plan,
+                            sc_array_t * element_data)
+{
+  T8_ASSERT (plan != NULL);
+  T8_ASSERT (!plan->on_device);
+  T8_ASSERT (element_data != NULL);
+  T8_ASSERT (element_data->elem_size == plan->data_size);
+  T8_ASSERT ((t8_locidx_t) element_data->elem_count ==
+             t8_forest_get_num_element (plan->forest)
+             + t8_forest_get_num_ghosts (plan->forest));
+
+  t8_forest_ghost_plan_begin_device (plan, element_data->array);
+}
+
+void
+t8_forest_ghost_plan_end (t8_forest_ghost_plan_t * plan)
+{
+  t8_forest_t         forest;
+  double              end_time = 0;
+  t8_locidx_t         num_ghosts;
+  int                 mpiret;
+
+  T8_ASSERT (plan != NULL);
+  T8_ASSERT (plan->in_progress);
+
+  forest = plan->forest;
+  if (forest->profile != NULL) {
+    end_time = sc_MPI_Wtime ();
+    forest->profile->ghost_overlap_time = end_time - plan->begin_time;
+  }
+#ifdef SC_ENABLE_MPI
+  if (plan->use_rma) {
+    if (plan->num_remotes > 0) {
+      /* Finish our puts and wait for the puts into our window */
+      mpiret = MPI_Win_complete (plan->window);
+      SC_CHECK_MPI (mpiret);
+      mpiret = MPI_Win_wait (plan->window);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  else
+#endif
+  {
+    mpiret = sc_MPI_Waitall (2 * plan->num_remotes, plan->requests,
+                             sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+  if (forest->profile != NULL) {
+    forest->profile->ghost_waittime = sc_MPI_Wtime () - end_time;
+  }
+  /* The ghosts are stored after the local elements in the same order as
+   * in the receive buffer */
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  if (num_ghosts > 0) {
+    plan->kernels.scatter (plan->element_data
+                           + t8_forest_get_num_element (forest)
+                           * plan->data_size, plan->recv_buffer,
+                           num_ghosts * plan->data_size,
+                           plan->kernels.user_data);
+  }
+  plan->element_data = NULL;
+  plan->in_progress = 0;
+}
+
+void
+t8_forest_ghost_plan_exchange (t8_forest_ghost_plan_t * plan,
+                               sc_array_t * element_data)
+{
+  t8_forest_ghost_plan_begin (plan, element_data);
+  t8_forest_ghost_plan_end (plan);
+}
+
+void
+t8_forest_ghost_plan_exchange_device (t8_forest_ghost_plan_t * plan,
+                                      void *element_data)
+{
+  t8_forest_ghost_plan_begin_device (plan, element_data);
+  t8_forest_ghost_plan_end (plan);
+}
+
+void
+t8_forest_ghost_plan_destroy (t8_forest_ghost_plan_t ** pplan)
+{
+  t8_forest_ghost_plan_t *plan;
+
+  T8_ASSERT (pplan != NULL);
+  plan = *pplan;
+  T8_ASSERT (plan != NULL);
+  T8_ASSERT (!plan->in_progress);
+
+#ifdef SC_ENABLE_MPI
+  if (plan->use_rma) {
+    int                 mpiret;
+
+    mpiret = MPI_Win_free (&plan->window);
+    SC_CHECK_MPI (mpiret);
+    if (plan->group != MPI_GROUP_NULL) {
+      mpiret = MPI_Group_free (&plan->group);
+      SC_CHECK_MPI (mpiret);
+    }
+    T8_FREE (plan->target_disps);
+  }
+  else {
+    int                 ireq, mpiret;
 
-  return proc_entry->ghost_offset;
+    for (ireq = 0; ireq < 2 * plan->num_remotes; ireq++) {
+      mpiret = MPI_Request_free (plan->requests + ireq);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+#endif
+  if (!plan->on_device) {
+    t8_free_large (plan->send_buffer, plan->send_bytes);
+    t8_free_large (plan->recv_buffer, plan->recv_bytes);
+  }
+  else {
+    if (plan->send_buffer != NULL) {
+      plan->ops.free (plan->send_buffer, plan->ops.user_data);
+      plan->ops.free (plan->device_indices, plan->ops.user_data);
+    }
+    if (plan->recv_buffer != NULL) {
+      plan->ops.free (plan->recv_buffer, plan->ops.user_data);
+    }
+  }
+  T8_FREE (plan->requests);
+  t8_forest_unref (&plan->forest);
+  T8_FREE (plan);
+  *pplan = NULL;
 }
 
-/* Fill the send buffer for a ghost data exchange for on remote rank.
- * returns the number of bytes in the buffer. */
-static              size_t
-t8_forest_ghost_exchange_fill_send_buffer (t8_forest_t forest, int remote,
-                                           char **pbuffer,
-                                           sc_array_t * element_data)
+void
+t8_forest_ghost_exchange_data_multi (t8_forest_t forest, int num_fields,
+                                     sc_array_t ** fields)
 {
-  char               *buffer;
-  t8_ghost_remote_t   lookup_rank, *remote_entry;
-  t8_ghost_remote_tree_t *remote_tree;
   t8_forest_ghost_t   ghost;
-  size_t              index, element_index, data_size;
-  size_t              elements_inserted, byte_count;
-  t8_tree_t           local_tree;
-#ifdef T8_ENABLE_DEBUG
-  int                 ret;
-#endif
-  t8_locidx_t         itree, ielement, element_pos;
-  t8_locidx_t         ltreeid;
-  size_t              elem_count;
+  const t8_locidx_t  *send_offsets, *send_indices;
+  t8_locidx_t        *recv_offsets;
+  t8_locidx_t         num_elements, isend, count, ghost_start;
+  size_t              total_size, field_offset, data_size;
+  char               *send_buffer, *recv_buffer, *pos;
+  sc_MPI_Request     *requests;
+  int                 ifield, iremote, num_remotes, remote_rank, mpiret;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (num_fields >= 0);
+  T8_ASSERT (num_fields == 0 || fields != NULL);
 
   ghost = forest->ghosts;
-  data_size = element_data->elem_size;
-  elements_inserted = 0;
-  lookup_rank.remote_rank = remote;
+  if (ghost == NULL) {
+    /* This process has no ghosts */
+    return;
+  }
+  num_elements = t8_forest_get_num_element (forest);
+  ghost_start = num_elements;
+  /* The number of bytes of all fields for one element */
+  total_size = 0;
+  for (ifield = 0; ifield < num_fields; ifield++) {
+    T8_ASSERT (fields[ifield] != NULL);
+    T8_ASSERT ((t8_locidx_t) fields[ifield]->elem_count ==
+               num_elements + t8_forest_get_num_ghosts (forest));
+    total_size += fields[ifield]->elem_size;
+  }
 
-  /* Lookup the remote entry of this remote process */
-#ifdef T8_ENABLE_DEBUG
-  ret =
-#else
-  (void)
-#endif
-    sc_hash_array_lookup (ghost->remote_ghosts, &lookup_rank, &index);
-  T8_ASSERT (ret != 0);
-  remote_entry =
-    (t8_ghost_remote_t *) sc_array_index (&ghost->remote_ghosts->a, index);
-  T8_ASSERT (remote_entry->remote_rank == remote);
+  t8_forest_ghost_exchange_layout (forest, &send_offsets, &send_indices,
+                                   &recv_offsets);
+  num_remotes = ghost->remote_processes->elem_count;
+  send_buffer = T8_ALLOC (char, send_offsets[num_remotes] * total_size);
+  recv_buffer = T8_ALLOC (char, recv_offsets[num_remotes] * total_size);
+  requests = T8_ALLOC (sc_MPI_Request, 2 * num_remotes);
 
-  /* allocate memory for the send buffer */
-  byte_count = data_size * remote_entry->num_elements;
-  buffer = *pbuffer = T8_ALLOC (char, byte_count);
+  /* The message to a remote holds the data of its elements for the first
+   * field, then for the second field and so on. */
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote_rank =
+      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+    count = recv_offsets[iremote + 1] - recv_offsets[iremote];
+    mpiret =
+      sc_MPI_Irecv (recv_buffer + recv_offsets[iremote] * total_size,
+                    count * total_size, sc_MPI_BYTE, remote_rank,
+                    T8_MPI_GHOST_EXC_FOREST, forest->mpicomm,
+                    requests + iremote);
+    SC_CHECK_MPI (mpiret);
+    t8_peer_volume_receive (T8_PEER_GHOST_EXCHANGE, remote_rank,
+                            count * total_size);
+  }
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote_rank =
+      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+    pos = send_buffer + send_offsets[iremote] * total_size;
+    for (ifield = 0; ifield < num_fields; ifield++) {
+      data_size = fields[ifield]->elem_size;
+      for (isend = send_offsets[iremote]; isend < send_offsets[iremote + 1];
+           isend++) {
+        memcpy (pos, sc_array_index (fields[ifield], send_indices[isend]),
+                data_size);
+        pos += data_size;
+      }
+    }
+    count = send_offsets[iremote + 1] - send_offsets[iremote];
+    mpiret =
+      sc_MPI_Isend (send_buffer + send_offsets[iremote] * total_size,
+                    count * total_size, sc_MPI_BYTE, remote_rank,
+                    T8_MPI_GHOST_EXC_FOREST, forest->mpicomm,
+                    requests + num_remotes + iremote);
+    SC_CHECK_MPI (mpiret);
+    t8_peer_volume_send (T8_PEER_GHOST_EXCHANGE, remote_rank,
+                         count * total_size);
+  }
 
-  /* We now iterate over the remote trees and their elements to find the
-   * local element indices of the remote elements */
-  for (itree = 0; itree < (t8_locidx_t) remote_entry->remote_trees.elem_count;
-       itree++) {
-    /* tree loop */
-    remote_tree = (t8_ghost_remote_tree_t *)
-      t8_sc_array_index_locidx (&remote_entry->remote_trees, itree);
-    /* Get the local id of this tree */
-    /* TODO: Why does remote_tree store the global id? could be local instead */
-    ltreeid = t8_forest_get_local_id (forest, remote_tree->global_id);
-    /* Get a pointer to the forest tree */
-    local_tree = t8_forest_get_tree (forest, ltreeid);
-    elem_count = t8_element_array_get_count (&remote_tree->elements);
-    for (ielement = 0; ielement < (t8_locidx_t) elem_count; ielement++) {
-      /* element loop */
-      /* Get the index of this remote element in its local tree */
-      element_pos = *(t8_locidx_t *)
-        t8_sc_array_index_locidx (&remote_tree->element_indices, ielement);
-      T8_ASSERT (0 <= element_pos);
-      /* Compute the index of this element in the element_data array */
-      element_index = local_tree->elements_offset + element_pos;
-      /* Copy the data of this element from the element_data array to the send buffer */
-      memcpy (buffer + elements_inserted * data_size,
-              sc_array_index (element_data, element_index), data_size);
-      elements_inserted++;
+  if (forest->profile != NULL) {
+    forest->profile->ghost_waittime = -sc_MPI_Wtime ();
+  }
+  mpiret = sc_MPI_Waitall (2 * num_remotes, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  if (forest->profile != NULL) {
+    forest->profile->ghost_waittime += sc_MPI_Wtime ();
+  }
+
+  /* Scatter the received data into the ghost section of each field.
+   * The ghosts of one remote are contiguous in each field. */
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    count = recv_offsets[iremote + 1] - recv_offsets[iremote];
+    if (count == 0) {
+      continue;
+    }
+    field_offset = 0;
+    for (ifield = 0; ifield < num_fields; ifield++) {
+      data_size = fields[ifield]->elem_size;
+      memcpy (sc_array_index (fields[ifield],
+                              ghost_start + recv_offsets[iremote]),
+              recv_buffer + recv_offsets[iremote] * total_size
+              + field_offset, count * data_size);
+      field_offset += count * data_size;
     }
   }
-  return byte_count;
+
+  T8_FREE (recv_offsets);
+  T8_FREE (send_buffer);
+  T8_FREE (recv_buffer);
+  T8_FREE (requests);
 }
 
-static t8_ghost_data_exchange_t *
-t8_forest_ghost_exchange_begin (t8_forest_t forest, sc_array_t * element_data)
+void
+t8_forest_ghost_exchange_varsize (t8_forest_t forest, sc_array_t * offsets,
+                                  sc_array_t * data, int exchange_sizes)
 {
-  t8_ghost_data_exchange_t *data_exchange;
   t8_forest_ghost_t   ghost;
-  size_t              bytes_to_send, ghost_start;
-  int                 iremote, remote_rank;
-  int                 mpiret, recv_rank, bytes_recv;
-#ifdef T8_ENABLE_DEBUG
-  int                 ret;
-#endif
-  char              **send_buffers;
-  t8_ghost_process_hash_t lookup_proc, *process_entry, **pfound;
-  t8_locidx_t         remote_offset, next_offset;
+  const t8_locidx_t  *send_offsets, *send_indices;
+  t8_locidx_t        *recv_offsets;
+  t8_locidx_t         num_elements, num_ghosts, ielem, isend;
+  size_t             *elem_offsets, data_size, first, last, length;
+  size_t              send_count, total_send;
+  char               *send_buffer, *pos;
+  sc_MPI_Request     *requests;
+  int                 iremote, num_remotes, remote_rank, mpiret;
 
   T8_ASSERT (t8_forest_is_committed (forest));
-  T8_ASSERT (element_data != NULL);
-  T8_ASSERT (forest->ghosts != NULL);
+  T8_ASSERT (offsets != NULL && data != NULL);
+  T8_ASSERT (offsets->elem_size == sizeof (size_t));
 
   ghost = forest->ghosts;
+  if (ghost == NULL) {
+    /* This process has no ghosts */
+    return;
+  }
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  T8_ASSERT ((t8_locidx_t) offsets->elem_count ==
+             num_elements + num_ghosts + 1);
+  elem_offsets = (size_t *) offsets->array;
+  data_size = data->elem_size;
+
+  if (exchange_sizes) {
+    sc_array_t          sizes;
+    size_t             *psizes;
+
+    /* Exchange the number of entries of each element and convert the
+     * sizes of the ghosts to offsets behind the local data */
+    sc_array_init_size (&sizes, sizeof (size_t), num_elements + num_ghosts);
+    psizes = (size_t *) sizes.array;
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      psizes[ielem] = elem_offsets[ielem + 1] - elem_offsets[ielem];
+    }
+    t8_forest_ghost_exchange_data (forest, &sizes);
+    for (ielem = num_elements; ielem < num_elements + num_ghosts; ielem++) {
+      elem_offsets[ielem + 1] = elem_offsets[ielem] + psizes[ielem];
+    }
+    sc_array_reset (&sizes);
+  }
+  T8_ASSERT (data->elem_count >= elem_offsets[num_elements]);
+  sc_array_resize (data, elem_offsets[num_elements + num_ghosts]);
 
-  /* Allocate the new exchange context */
-  data_exchange = T8_ALLOC (t8_ghost_data_exchange_t, 1);
-  /* The number of processes we need to send to */
-  data_exchange->num_remotes = ghost->remote_processes->elem_count;
-  /* Allocate MPI requests */
-  data_exchange->send_requests = T8_ALLOC (sc_MPI_Request,
-                                           data_exchange->num_remotes);
-  data_exchange->recv_requests = T8_ALLOC (sc_MPI_Request,
-                                           data_exchange->num_remotes);
-  /* Allocate pointers to send buffers */
-  send_buffers = data_exchange->send_buffers =
-    T8_ALLOC (char *, data_exchange->num_remotes);
+  t8_forest_ghost_exchange_layout (forest, &send_offsets, &send_indices,
+                                   &recv_offsets);
+  num_remotes = ghost->remote_processes->elem_count;
+  requests = T8_ALLOC (sc_MPI_Request, 2 * num_remotes);
 
-  for (iremote = 0; iremote < data_exchange->num_remotes; iremote++) {
-    /* Iterate over all remote processes and fill their send buffers */
+  /* Post the receives. The data of the ghosts of one remote is contiguous
+   * and we receive it in place. */
+  for (iremote = 0; iremote < num_remotes; iremote++) {
     remote_rank =
       *(int *) sc_array_index_int (ghost->remote_processes, iremote);
-    /* Fill the send buffers and compute the number of bytes to send */
-    bytes_to_send =
-      t8_forest_ghost_exchange_fill_send_buffer (forest, remote_rank,
-                                                 send_buffers + iremote,
-                                                 element_data);
-
-    /* Post the asynchronuos send */
-    mpiret = sc_MPI_Isend (send_buffers[iremote], bytes_to_send, sc_MPI_BYTE,
-                           remote_rank, T8_MPI_GHOST_EXC_FOREST,
-                           forest->mpicomm,
-                           data_exchange->send_requests + iremote);
+    first = elem_offsets[num_elements + recv_offsets[iremote]];
+    last = elem_offsets[num_elements + recv_offsets[iremote + 1]];
+    mpiret =
+      sc_MPI_Irecv (data->array + first * data_size,
+                    (int) ((last - first) * data_size), sc_MPI_BYTE,
+                    remote_rank, T8_MPI_GHOST_EXC_FOREST, forest->mpicomm,
+                    requests + iremote);
     SC_CHECK_MPI (mpiret);
+    t8_peer_volume_receive (T8_PEER_GHOST_EXCHANGE, remote_rank,
+                            (last - first) * data_size);
   }
 
-  /* The index in element_data at which the ghost elements start */
-  ghost_start = t8_forest_get_num_element (forest);
-  /* Receive the incoming messages */
-#if 0
-  while (received_messages < data_exchange->num_remotes) {
-    /* Blocking test for incoming message */
-    mpiret = sc_MPI_Probe (sc_MPI_ANY_SOURCE, T8_MPI_GHOST_EXC_FOREST,
-                           forest->mpicomm, &recv_status);
-    SC_CHECK_MPI (mpiret);
-    recv_rank = recv_status.MPI_SOURCE;
-    /* Get the number of bytes to receive */
-    mpiret = sc_MPI_Get_count (&recv_status, sc_MPI_BYTE, &bytes_recv);
-    SC_CHECK_MPI (mpiret);
-
-    /* We need to compute the offset in element_data to which we can receive the message */
-    /* Search for this process' entry in the ghost struct */
-    lookup_proc.mpirank = recv_rank;
-    ret =
-      sc_hash_lookup (ghost->process_offsets, &lookup_proc,
-                      (void ***) &pfound);
-    T8_ASSERT (ret);
-    process_entry = *pfound;
-    /* In process_entry we stored the offset of this ranks ghosts under all
-     * ghosts. Thus in element_data we look at the position
-     *  ghost_start + offset
-     */
-    /* receive the message */
-    sc_MPI_Recv (sc_array_index
-                 (element_data, ghost_start + process_entry->ghost_offset),
-                 bytes_recv, sc_MPI_BYTE, recv_rank, T8_MPI_GHOST_EXC_FOREST,
-                 forest->mpicomm, sc_MPI_STATUS_IGNORE);
-    received_messages++;
+  /* Pack the data of the elements that we send tightly */
+  total_send = 0;
+  for (isend = 0; isend < send_offsets[num_remotes]; isend++) {
+    ielem = send_indices[isend];
+    total_send += elem_offsets[ielem + 1] - elem_offsets[ielem];
   }
-#endif
-  for (iremote = 0; iremote < data_exchange->num_remotes; iremote++) {
-    /* We need to compute the offset in element_data to which we can receive the message */
-    /* Search for this processes' entry in the ghost struct */
-    recv_rank =
+  send_buffer = T8_ALLOC (char, total_send * data_size);
+  pos = send_buffer;
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote_rank =
       *(int *) sc_array_index_int (ghost->remote_processes, iremote);
-    lookup_proc.mpirank = recv_rank;
-#ifdef T8_ENABLE_DEBUG
-    ret =
-#else
-    (void)
-#endif
-      sc_hash_lookup (ghost->process_offsets, &lookup_proc,
-                      (void ***) &pfound);
-    T8_ASSERT (ret);
-    process_entry = *pfound;
-    /* In process_entry we stored the offset of this ranks ghosts under all
-     * ghosts. Thus in element_data we look at the position
-     *  ghost_start + offset
-     */
-    remote_offset = process_entry->ghost_offset;
-    /* Compute the offset of the next remote rank */
-    if (iremote + 1 < data_exchange->num_remotes) {
-      lookup_proc.mpirank =
-        *(int *) sc_array_index_int (ghost->remote_processes, iremote + 1);
-#ifdef T8_ENABLE_DEBUG
-      ret =
-#else
-      (void)
-#endif
-        sc_hash_lookup (ghost->process_offsets, &lookup_proc,
-                        (void ***) &pfound);
-      T8_ASSERT (ret);
-      process_entry = *pfound;
-      next_offset = process_entry->ghost_offset;
-    }
-    else {
-      /* We are the last rank, the next offset is the total number of ghosts */
-      next_offset = ghost->num_ghosts_elements;
+    send_count = 0;
+    for (isend = send_offsets[iremote]; isend < send_offsets[iremote + 1];
+         isend++) {
+      ielem = send_indices[isend];
+      length = elem_offsets[ielem + 1] - elem_offsets[ielem];
+      memcpy (pos + send_count * data_size,
+              data->array + elem_offsets[ielem] * data_size,
+              length * data_size);
+      send_count += length;
     }
-    /* Calculate the number of bytes to receive */
-    bytes_recv = (next_offset - remote_offset) * element_data->elem_size;
-    /* receive the message */
     mpiret =
-      sc_MPI_Irecv (sc_array_index
-                    (element_data, ghost_start + remote_offset), bytes_recv,
-                    sc_MPI_BYTE, recv_rank, T8_MPI_GHOST_EXC_FOREST,
-                    forest->mpicomm, data_exchange->recv_requests + iremote);
+      sc_MPI_Isend (pos, (int) (send_count * data_size), sc_MPI_BYTE,
+                    remote_rank, T8_MPI_GHOST_EXC_FOREST, forest->mpicomm,
+                    requests + num_remotes + iremote);
     SC_CHECK_MPI (mpiret);
+    t8_peer_volume_send (T8_PEER_GHOST_EXCHANGE, remote_rank,
+                         send_count * data_size);
+    pos += send_count * data_size;
   }
-  return data_exchange;
+
+  if (forest->profile != NULL) {
+    forest->profile->ghost_waittime = -sc_MPI_Wtime ();
+  }
+  mpiret = sc_MPI_Waitall (2 * num_remotes, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  if (forest->profile != NULL) {
+    forest->profile->ghost_waittime += sc_MPI_Wtime ();
+  }
+
+  T8_FREE (recv_offsets);
+  T8_FREE (send_buffer);
+  T8_FREE (requests);
 }
 
-static void
-t8_forest_ghost_exchange_end (t8_ghost_data_exchange_t * data_exchange)
+void
+t8_forest_ghost_flag_remote_elements (t8_forest_t forest, int8_t * flags)
 {
-  int                 iproc;
+  t8_forest_ghost_t   ghost;
+  t8_locidx_t         iremote, num_remote_elements;
 
-  T8_ASSERT (data_exchange != NULL);
-  /* Wait for all communications to end */
-  sc_MPI_Waitall (data_exchange->num_remotes, data_exchange->recv_requests,
-                  sc_MPI_STATUSES_IGNORE);
-  sc_MPI_Waitall (data_exchange->num_remotes, data_exchange->send_requests,
-                  sc_MPI_STATUSES_IGNORE);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->ghosts != NULL);
 
-  /* Free the send buffers */
-  for (iproc = 0; iproc < data_exchange->num_remotes; iproc++) {
-    T8_FREE (data_exchange->send_buffers[iproc]);
+  ghost = forest->ghosts;
+  num_remote_elements =
+    ghost->remote_offsets[ghost->remote_processes->elem_count];
+  for (iremote = 0; iremote < num_remote_elements; iremote++) {
+    flags[ghost->remote_elements[iremote]] = 1;
   }
-  T8_FREE (data_exchange->send_buffers);
-  /* free requests */
-  T8_FREE (data_exchange->send_requests);
-  T8_FREE (data_exchange->recv_requests);
-  T8_FREE (data_exchange);
 }
 
 void
 t8_forest_ghost_exchange_data (t8_forest_t forest, sc_array_t * element_data)
 {
-  t8_ghost_data_exchange_t *data_exchange;
+  t8_forest_ghost_exchange_t *data_exchange;
 
-  t8_debugf ("Entering ghost_exchange_data\n");
+  T8_DEBUGF ("Entering ghost_exchange_data\n");
   T8_ASSERT (t8_forest_is_committed (forest));
 
   if (forest->ghosts == NULL) {
@@ -2288,23 +4399,10 @@ t8_forest_ghost_exchange_data (t8_forest_t forest, sc_array_t * element_data)
     return;
   }
 
-  T8_ASSERT (forest->ghosts != NULL);
-  T8_ASSERT (element_data != NULL);
-  T8_ASSERT ((t8_locidx_t) element_data->elem_count ==
-             t8_forest_get_num_element (forest)
-             + t8_forest_get_num_ghosts (forest));
-
   data_exchange = t8_forest_ghost_exchange_begin (forest, element_data);
-  if (forest->profile != NULL) {
-    /* Measure the time for ghost_exchange_end */
-    forest->profile->ghost_waittime = -sc_MPI_Wtime ();
-  }
+  /* The wait time is measured in ghost_exchange_end */
   t8_forest_ghost_exchange_end (data_exchange);
-  if (forest->profile != NULL) {
-    /* Measure the time for ghost_exchange_end */
-    forest->profile->ghost_waittime += sc_MPI_Wtime ();
-  }
-  t8_debugf ("Finished ghost_exchange_data\n");
+  T8_DEBUGF ("Finished ghost_exchange_data\n");
 }
 
 /* Print a forest ghost structure */
@@ -2312,13 +4410,9 @@ void
 t8_forest_ghost_print (t8_forest_t forest)
 {
   t8_forest_ghost_t   ghost;
-  t8_ghost_remote_t  *remote_found;
-  t8_ghost_remote_tree_t *remote_tree;
-  t8_ghost_process_hash_t proc_hash, **pfound, *found;
-  size_t              iremote, itree;
-#ifdef T8_ENABLE_DEBUG
-  int                 ret;
-#endif
+  t8_ghost_process_t *found;
+  t8_locidx_t         first, last, ielem, next, ltreeid;
+  size_t              iremote;
   int                 remote_rank;
   char                remote_buffer[BUFSIZ] = "";
   char                buffer[BUFSIZ] = "";
@@ -2339,44 +4433,38 @@ t8_forest_ghost_print (t8_forest_t forest)
       /* Get the rank of the remote process */
       remote_rank =
         *(int *) sc_array_index (ghost->remote_processes, iremote);
-      /* Get this remote's entry */
-      remote_found = t8_forest_ghost_get_remote (forest, remote_rank);
-      /* investigate the entry of this remote process */
+      /* Print the local trees of the elements that this remote needs,
+       * the elements of one tree are stored consecutively */
+      first = ghost->remote_offsets[iremote];
+      last = ghost->remote_offsets[iremote + 1];
       snprintf (remote_buffer + strlen (remote_buffer),
-                BUFSIZ - strlen (remote_buffer), "\t[Rank %i] (%li trees):\n",
-                remote_found->remote_rank,
-                remote_found->remote_trees.elem_count);
-      for (itree = 0; itree < remote_found->remote_trees.elem_count; itree++) {
-        remote_tree = (t8_ghost_remote_tree_t *)
-          sc_array_index (&remote_found->remote_trees, itree);
+                BUFSIZ - strlen (remote_buffer),
+                "\t[Rank %i] (%li elements):\n", remote_rank,
+                (long) (last - first));
+      for (ielem = first; ielem < last; ielem = next) {
+        ltreeid = ghost->remote_ltrees[ielem];
+        for (next = ielem + 1;
+             next < last && ghost->remote_ltrees[next] == ltreeid; next++) {
+          /* Find the first element of the next tree */
+        }
         snprintf (remote_buffer + strlen (remote_buffer),
                   BUFSIZ - strlen (remote_buffer),
                   "\t\t[id: %lli, class: %s, #elem: %li]\n",
-                  (long long) remote_tree->global_id,
-                  t8_eclass_to_string[remote_tree->eclass],
-                  (long) t8_element_array_get_count (&remote_tree->elements));
+                  (long long) t8_forest_global_tree_id (forest, ltreeid),
+                  t8_eclass_to_string[t8_forest_get_tree_class
+                                      (forest, ltreeid)],
+                  (long) (next - ielem));
       }
 
       /* Investigate the elements that we received from this process */
-      proc_hash.mpirank = remote_rank;
-      /* look up this rank in the hash table */
-#ifdef T8_ENABLE_DEBUG
-      ret =
-#else
-      (void)
-#endif
-        sc_hash_lookup (ghost->process_offsets, &proc_hash,
-                        (void ***) &pfound);
-
-      T8_ASSERT (ret);
-      found = *pfound;
+      found = t8_forest_ghost_get_proc_info_at (ghost, (int) iremote);
       snprintf (buffer + strlen (buffer), BUFSIZ - strlen (buffer),
                 "\t[Rank %i] First tree: %li\n\t\t First element: %li\n",
                 remote_rank,
                 (long) found->tree_index, (long) found->first_element);
     }
   }
-  t8_debugf ("Ghost structure:\n%s\n%s\n", remote_buffer, buffer);
+  T8_DEBUGF ("Ghost structure:\n%s\n%s\n", remote_buffer, buffer);
 }
 
 /* Completely destroy a ghost structure */
@@ -2384,10 +4472,8 @@ static void
 t8_forest_ghost_reset (t8_forest_ghost_t * pghost)
 {
   t8_forest_ghost_t   ghost;
-  size_t              it, it_trees;
+  size_t              it_trees;
   t8_ghost_tree_t    *ghost_tree;
-  t8_ghost_remote_t  *remote_entry;
-  t8_ghost_remote_tree_t *remote_tree;
 
   T8_ASSERT (pghost != NULL);
   ghost = *pghost;
@@ -2403,34 +4489,51 @@ t8_forest_ghost_reset (t8_forest_ghost_t * pghost)
 
   sc_array_destroy (ghost->ghost_trees);
   sc_array_destroy (ghost->remote_processes);
-  /* Clean-up the hashtables */
-  sc_hash_destroy (ghost->global_tree_to_ghost_tree);
-  sc_hash_destroy (ghost->process_offsets);
+  sc_array_destroy (ghost->process_offsets);
   /* Clean-up the remote ghost entries */
-  for (it = 0; it < ghost->remote_ghosts->a.elem_count; it++) {
-    remote_entry = (t8_ghost_remote_t *)
-      sc_array_index (&ghost->remote_ghosts->a, it);
-    for (it_trees = 0; it_trees < remote_entry->remote_trees.elem_count;
-         it_trees++) {
-      remote_tree = (t8_ghost_remote_tree_t *)
-        sc_array_index (&remote_entry->remote_trees, it_trees);
-      t8_element_array_reset (&remote_tree->elements);
-      sc_array_reset (&remote_tree->element_indices);
-    }
-    sc_array_reset (&remote_entry->remote_trees);
+  if (ghost->remote_ghosts != NULL) {
+    t8_forest_ghost_remote_ghosts_destroy (ghost);
   }
-  sc_hash_array_destroy (ghost->remote_ghosts);
-
-  /* Clean-up the memory pools for the data inside
-   * the hash tables */
-  sc_mempool_destroy (ghost->glo_tree_mempool);
-  sc_mempool_destroy (ghost->proc_offset_mempool);
+  T8_FREE (ghost->remote_offsets);
+  T8_FREE (ghost->remote_ltrees);
+  T8_FREE (ghost->remote_elements);
 
   /* Free the ghost */
   T8_FREE (ghost);
   pghost = NULL;
 }
 
+void
+t8_forest_ghost_memory_usage (t8_forest_ghost_t ghost, size_t * ghost_bytes,
+                              size_t * hash_bytes)
+{
+  size_t              it_trees, num_remotes;
+  t8_ghost_tree_t    *ghost_tree;
+
+  T8_ASSERT (ghost != NULL);
+  T8_ASSERT (ghost_bytes != NULL && hash_bytes != NULL);
+
+  *ghost_bytes = sizeof (t8_forest_ghost_struct_t)
+    + sc_array_memory_used (ghost->ghost_trees, 1)
+    + sc_array_memory_used (ghost->process_offsets, 1)
+    + sc_array_memory_used (ghost->remote_processes, 1);
+  for (it_trees = 0; it_trees < ghost->ghost_trees->elem_count; it_trees++) {
+    ghost_tree = (t8_ghost_tree_t *) sc_array_index (ghost->ghost_trees,
+                                                     it_trees);
+    *ghost_bytes += sc_array_memory_used (&ghost_tree->elements.array, 0);
+  }
+  if (ghost->remote_offsets != NULL) {
+    num_remotes = ghost->remote_processes->elem_count;
+    *ghost_bytes += (num_remotes + 1) * sizeof (t8_locidx_t)
+      + 2 * ghost->num_remote_elements * sizeof (t8_locidx_t);
+  }
+
+  *hash_bytes = 0;
+  if (ghost->remote_ghosts != NULL) {
+    *hash_bytes += sc_hash_array_memory_used (ghost->remote_ghosts);
+  }
+}
+
 void
 t8_forest_ghost_ref (t8_forest_ghost_t ghost)
 {
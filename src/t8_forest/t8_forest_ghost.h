@@ -130,12 +130,16 @@ t8_locidx_t         t8_forest_ghost_remote_first_tree (t8_forest_t forest,
 t8_locidx_t         t8_forest_ghost_remote_first_elem (t8_forest_t forest,
                                                        int remote);
 
-/* TODO: - document
- *       - make accesible to forest API
- *       - make a begin and end version
+/** Set a flag for each local element that is a ghost element of another
+ * process.
+ * \param [in] forest   A forest with constructed ghost layer.
+ * \param [in,out] flags An array with one entry for each local element of
+ *                      \a forest. On output the entries of the local elements
+ *                      that are ghosts of another process are set to 1, the
+ *                      other entries are not changed.
  */
-void                t8_forest_ghost_exchange_data (t8_forest_t forest,
-                                                   sc_array_t * element_data);
+void                t8_forest_ghost_flag_remote_elements (t8_forest_t forest,
+                                                          int8_t * flags);
 
 /** Increase the reference count of a ghost structure.
  * \param [in,out]  ghost     On input, this ghost structure must exist with
@@ -165,6 +169,19 @@ void                t8_forest_ghost_unref (t8_forest_ghost_t * pghost);
  */
 void                t8_forest_ghost_destroy (t8_forest_ghost_t * pghost);
 
+/** Compute the memory used by a ghost structure.
+ * \param [in]      ghost      A ghost structure.
+ * \param [out]     ghost_bytes The number of bytes used by the ghost trees,
+ *                              their elements, the process offsets and the
+ *                              remote element lists.
+ * \param [out]     hash_bytes  The number of bytes used by the hash table of
+ *                              the remote ghosts. It only exists during the
+ *                              creation of the ghost layer.
+ */
+void                t8_forest_ghost_memory_usage (t8_forest_ghost_t ghost,
+                                                  size_t * ghost_bytes,
+                                                  size_t * hash_bytes);
+
 /** Create one layer of ghost elements for a forest.
  * \see t8_forest_set_ghost
  * \param [in,out]    forest     The forest.
@@ -185,6 +202,38 @@ void                t8_forest_ghost_create_balanced_only (t8_forest_t forest);
 /* experimental version using the ghost_v3 algorithm */
 void                t8_forest_ghost_create_topdown (t8_forest_t forest);
 
+/** Create the ghost layer of an adapted forest by updating the ghost layer
+ * of the forest it was adapted from.
+ * The remote elements of the kept elements are taken from the ghost layer
+ * of \a forest_from, only the refined and coarsened elements are checked.
+ * Only the changes to the remote elements of \a forest_from are sent, the
+ * receivers take the kept elements from their ghost layer of
+ * \a forest_from.
+ * \param [in,out]    forest      The forest. It must have been adapted from
+ *                                \a forest_from and store its adapt map.
+ * \param [in]        forest_from The forest that \a forest was adapted from,
+ *                                with a ghost layer.
+ * \a forest must be committed before calling this function.
+ * \see t8_forest_set_ghost_incremental
+ */
+void                t8_forest_ghost_create_incremental (t8_forest_t forest,
+                                                        t8_forest_t
+                                                        forest_from);
+
+/** Add layers to the ghost layer of a forest until it contains all elements
+ * that can be reached from a local element by crossing at most \a depth
+ * faces. Each new layer consists of the face neighbors of the elements of
+ * the previous layer, which the owners of these elements tell us about.
+ * \param [in,out]    forest      The forest. It must have a ghost layer
+ *                                with one layer and must be balanced.
+ * \param [in]        depth       The number of layers. If smaller than 2,
+ *                                nothing is done.
+ * \a forest must be committed before calling this function.
+ * This function is collective over the processes with local elements.
+ * \see t8_forest_set_ghost_ext
+ */
+void                t8_forest_ghost_expand (t8_forest_t forest, int depth);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_FOREST_GHOST_H! */
@@ -0,0 +1,181 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_ghost_device.h
+ * Exchange ghost data that lives in the memory of a device.
+ *
+ * A device plan works like a \ref t8_forest_ghost_plan_t, but its send and
+ * receive buffers and its index lists are allocated with the memory
+ * operations of a device. Packing the send buffers and copying the received
+ * data to the ghost entries is done by the gather and scatter kernels in
+ * \ref t8_forest_ghost_kernels_t, and the device buffers are passed to MPI
+ * directly, which requires a GPU-aware MPI. Only the data of the ghost
+ * layer is moved and the element data never has to be copied to the host.
+ * A typical use is
+ *
+ *     plan = t8_forest_ghost_plan_new_device (forest, data_size,
+ *                                             &my_device_ops, &my_kernels);
+ *     for (each time step) {
+ *       ... compute on the local entries of d_data ...
+ *       t8_forest_ghost_plan_exchange_device (plan, d_data);
+ *     }
+ *     t8_forest_ghost_plan_destroy (&plan);
+ *
+ * The gather kernel can be built from \ref t8_device_ghost_gather_entry,
+ * the scatter kernel is a device to device copy.
+ */
+
+#ifndef T8_FOREST_GHOST_DEVICE_H
+#define T8_FOREST_GHOST_DEVICE_H
+
+#include <t8.h>
+#include <t8_device.h>
+#include <t8_forest.h>
+
+/** Pack the send buffers of a ghost exchange.
+ * For each \a i smaller than \a num_indices, the entry \a indices[i] of
+ * \a element_data has to be copied to entry \a i of \a send_buffer.
+ * The copies must be finished when the function returns, since the buffer is
+ * handed to MPI afterwards.
+ * \param [out] send_buffer   On the device, \a num_indices entries.
+ * \param [in]  element_data  On the device, the data of the local elements.
+ * \param [in]  indices       On the device, the local indices to send.
+ * \param [in]  num_indices   The number of entries to pack, greater zero.
+ * \param [in]  data_size     The number of bytes per entry.
+ * \param [in]  user_data     The user data of \ref t8_forest_ghost_kernels_t.
+ */
+typedef void        (*t8_forest_ghost_gather_fn) (void *send_buffer,
+                                                  const void *element_data,
+                                                  const t8_locidx_t *
+                                                  indices,
+                                                  t8_locidx_t num_indices,
+                                                  size_t data_size,
+                                                  void *user_data);
+
+/** Copy the received ghost data to the ghost entries of the element data.
+ * The copy must be finished when the function returns.
+ * \param [out] ghost_data    On the device, the first ghost entry.
+ * \param [in]  recv_buffer   On the device, the data of all ghosts.
+ * \param [in]  size          The number of bytes to copy, greater zero.
+ * \param [in]  user_data     The user data of \ref t8_forest_ghost_kernels_t.
+ */
+typedef void        (*t8_forest_ghost_scatter_fn) (void *ghost_data,
+                                                   const void *recv_buffer,
+                                                   size_t size,
+                                                   void *user_data);
+
+/** The kernels that move ghost data on a device. */
+typedef struct t8_forest_ghost_kernels
+{
+  t8_forest_ghost_gather_fn gather; /**< Pack the send buffers. */
+  t8_forest_ghost_scatter_fn scatter; /**< Unpack the ghost data. */
+  void               *user_data; /**< Passed to the kernels, for example
+                                      a stream or a queue. */
+}
+t8_forest_ghost_kernels_t;
+
+/** Copy one entry of a gather, the body of a gather kernel.
+ * A kernel calls this for each \a ientry smaller than its number of
+ * indices, for example with one thread per entry.
+ * \param [out] send_buffer   The send buffer of the gather.
+ * \param [in]  element_data  The element data of the gather.
+ * \param [in]  indices       The indices of the gather.
+ * \param [in]  ientry        The entry to copy.
+ * \param [in]  data_size     The number of bytes per entry.
+ */
+static inline T8_DEVICE_FUNC void
+t8_device_ghost_gather_entry (void *send_buffer, const void *element_data,
+                              const t8_locidx_t * indices,
+                              t8_locidx_t ientry, size_t data_size)
+{
+  char               *dest = (char *) send_buffer + ientry * data_size;
+  const char         *src =
+    (const char *) element_data + indices[ientry] * data_size;
+  size_t              ibyte;
+
+  for (ibyte = 0; ibyte < data_size; ibyte++) {
+    dest[ibyte] = src[ibyte];
+  }
+}
+
+T8_EXTERN_C_BEGIN ();
+
+/** The kernels of the host, with memcpy.
+ * Use them together with \ref t8_device_ops_host to run a device plan on
+ * the host or for testing.
+ */
+extern const t8_forest_ghost_kernels_t t8_forest_ghost_kernels_host;
+
+/** Create a plan to exchange ghost data that is stored on a device.
+ * The buffers of the plan are allocated with \a ops and the indices of the
+ * local elements to send are copied to the device, once.
+ * \param [in]      forest       A committed forest with a ghost layer.
+ *                               The plan keeps a reference of \a forest.
+ * \param [in]      data_size    The number of bytes per element.
+ * \param [in]      ops          The memory operations of the device.
+ *                               They are copied.
+ * \param [in]      kernels      The kernels that move the data on the
+ *                               device. They are copied.
+ * \return                       A plan for \a forest and \a data_size.
+ *                               Exchange with it by
+ *                               \ref t8_forest_ghost_plan_begin_device and
+ *                               \ref t8_forest_ghost_plan_end and destroy it
+ *                               with \ref t8_forest_ghost_plan_destroy.
+ * This function is not collective.
+ */
+t8_forest_ghost_plan_t *t8_forest_ghost_plan_new_device (t8_forest_t forest,
+                                                         size_t data_size,
+                                                         const
+                                                         t8_device_ops_t *
+                                                         ops,
+                                                         const
+                                                         t8_forest_ghost_kernels_t
+                                                         * kernels);
+
+/** Start a ghost data exchange of device data with a plan.
+ * \param [in]      plan         A plan, with no exchange in progress.
+ * \param [in,out]  element_data In the memory of the plan, for a device
+ *                               plan on the device, one entry of the plan's
+ *                               data size for each local element and each
+ *                               ghost element of the plan's forest.
+ *                               The entries of the local elements may be
+ *                               changed after this call returns. The entries
+ *                               of the ghosts are written by
+ *                               \ref t8_forest_ghost_plan_end.
+ * This function is collective over the processes that share ghosts.
+ */
+void                t8_forest_ghost_plan_begin_device (t8_forest_ghost_plan_t
+                                                       * plan,
+                                                       void *element_data);
+
+/** Exchange ghost data of device data with a plan.
+ * This is \ref t8_forest_ghost_plan_begin_device directly followed by
+ * \ref t8_forest_ghost_plan_end.
+ * \param [in,out]  plan         A plan, with no exchange in progress.
+ * \param [in,out]  element_data As in \ref t8_forest_ghost_plan_begin_device.
+ */
+void                t8_forest_ghost_plan_exchange_device
+  (t8_forest_ghost_plan_t * plan, void *element_data);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_GHOST_DEVICE_H */
@@ -22,66 +22,79 @@
 
 #include <t8_forest/t8_forest_iterate.h>
 #include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_partition.h>
 #include <t8_forest.h>
 #include <t8_element_cxx.hxx>
+#include <t8_element_scratch.hxx>
 
 #include <t8_default/t8_dtri.h>
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#include <omp.h>
+#endif
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
 
-typedef struct
-{
-  t8_eclass_scheme_c *ts;
-  int                 level;
-  int                 num_children;
-} t8_forest_child_type_query_t;
-
-/* This is the function that we call in sc_split_array to determine for an
- * element E that is a descendant of an element e, of which of e's children,
- * E is a descendant. */
-static              size_t
-t8_forest_determine_child_type (sc_array_t * leaf_elements,
-                                size_t index, void *data)
+/* Return the index of the first element in elements[low], ..., elements[high - 1]
+ * whose linear id at level maxlevel is not smaller than id,
+ * or high if there is none. */
+static size_t
+t8_forest_split_lower_bound (t8_eclass_scheme_c * ts,
+                             t8_element_array_t * elements, size_t low,
+                             size_t high, t8_linearidx_t id, int maxlevel)
 {
-  t8_forest_child_type_query_t *query_data =
-    (t8_forest_child_type_query_t *) data;
-  t8_element_t       *element;
-
-  /* Get a pointer to the element */
-  element = (t8_element_t *) t8_sc_array_index_locidx (leaf_elements, index);
-  T8_ASSERT (query_data->level < query_data->ts->t8_element_level (element));
-  /* Compute the element's ancestor id at the stored level and return it
-   * as the element's type */
-  return query_data->ts->t8_element_ancestor_id (element,
-                                                 query_data->level + 1);
+  size_t              guess;
+
+  while (low < high) {
+    guess = low + (high - low) / 2;
+    if (ts->t8_element_get_linear_id (t8_element_array_index_locidx
+                                      (elements, guess), maxlevel) < id) {
+      low = guess + 1;
+    }
+    else {
+      high = guess;
+    }
+  }
+  return low;
 }
 
 void
 t8_forest_split_array (const t8_element_t * element,
                        t8_element_array_t * leaf_elements, size_t * offsets)
 {
-  sc_array_t          offset_view;
-  sc_array_t         *element_array;
-  t8_forest_child_type_query_t query_data;
   t8_eclass_scheme_c *ts;
+  t8_element_t       *child;
+  t8_element_scratch_mark_t scratch_mark;
+  size_t              num_leafs;
+  int                 num_children, ichild, maxlevel;
 
   ts = t8_element_array_get_scheme (leaf_elements);
-  /* Store the number of children and the level of element */
-  query_data.num_children = ts->t8_element_num_children (element);
-  query_data.level = ts->t8_element_level (element);
-  query_data.ts = ts;
-
-  element_array = t8_element_array_get_array (leaf_elements);
-  /* Split the elements array according to the elements' ancestor id at
-   * the given level. In other words for each child C of element, find
-   * the indices i, j such that all descendants of C are
-   * elements[i], ..., elements[j-1]
-   */
-  sc_array_init_data (&offset_view, offsets, sizeof (size_t),
-                      query_data.num_children + 1);
-  sc_array_split (element_array, &offset_view, query_data.num_children,
-                  t8_forest_determine_child_type, (void *) &query_data);
+  num_children = ts->t8_element_num_children (element);
+  num_leafs = t8_element_array_get_count (leaf_elements);
+  maxlevel = ts->t8_element_maxlevel ();
+
+  /* For each child C of element, find the indices i, j such that all
+   * descendants of C are elements[i], ..., elements[j-1].
+   * The leafs are sorted along the space-filling curve and the children
+   * are ordered by their child id along the curve, too. Thus the
+   * descendants of C start at the first leaf whose linear id is not
+   * smaller than the linear id of the first descendant of C, which we
+   * find with a binary search. */
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (ts, 1, &child);
+  offsets[0] = 0;
+  for (ichild = 1; ichild < num_children; ichild++) {
+    ts->t8_element_child (element, ichild, child);
+    offsets[ichild] =
+      t8_forest_split_lower_bound (ts, leaf_elements, offsets[ichild - 1],
+                                   num_leafs,
+                                   ts->t8_element_get_linear_id (child,
+                                                                 maxlevel),
+                                   maxlevel);
+  }
+  offsets[num_children] = num_leafs;
+  t8_element_scratch_release (&scratch_mark);
 }
 
 void
@@ -98,6 +111,7 @@ t8_forest_iterate_faces (t8_forest_t forest, t8_locidx_t ltreeid,
   int                *child_indices;
   size_t             *split_offsets, indexa, indexb, elem_count;
   t8_element_array_t  face_child_leafs;
+  t8_element_scratch_mark_t scratch_mark;
 
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (0 <= ltreeid
@@ -140,7 +154,8 @@ t8_forest_iterate_faces (t8_forest_t forest, t8_locidx_t ltreeid,
     /* allocate the memory to store the face children */
     num_face_children = ts->t8_element_num_face_children (element, face);
     face_children = T8_ALLOC (t8_element_t *, num_face_children);
-    ts->t8_element_new (num_face_children, face_children);
+    t8_element_scratch_mark (&scratch_mark);
+    t8_element_scratch_get (ts, num_face_children, face_children);
     /* Memory for the child indices of the face children */
     child_indices = T8_ALLOC (int, num_face_children);
     /* Memory for the indices that split the leaf_elements array */
@@ -170,7 +185,7 @@ t8_forest_iterate_faces (t8_forest_t forest, t8_locidx_t ltreeid,
       }
     }
     /* clean-up */
-    ts->t8_element_destroy (num_face_children, face_children);
+    t8_element_scratch_release (&scratch_mark);
     T8_FREE (face_children);
     T8_FREE (child_indices);
     T8_FREE (split_offsets);
@@ -196,6 +211,7 @@ t8_forest_search_recursion (t8_forest_t forest, t8_locidx_t ltreeid,
   t8_element_array_t  child_leafs;
   size_t              elem_count;
   int                 ret;
+  t8_element_scratch_mark_t scratch_mark;
 
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (0 <= ltreeid
@@ -235,10 +251,15 @@ t8_forest_search_recursion (t8_forest_t forest, t8_locidx_t ltreeid,
      * call search_recursion */
     /* allocate the memory to store the children */
     num_children = ts->t8_element_num_children (element);
-    children = T8_ALLOC (t8_element_t *, num_children);
-    ts->t8_element_new (num_children, children);
+    /* The children and offsets come from the scratch arena of this thread,
+     * since the allocation functions of sc are not thread-safe */
+    t8_element_scratch_mark (&scratch_mark);
+    children = (t8_element_t **)
+      t8_element_scratch_alloc (num_children * sizeof (t8_element_t *));
+    t8_element_scratch_get (ts, num_children, children);
     /* Memory for the indices that split the leaf_elements array */
-    split_offsets = T8_ALLOC (size_t, num_children + 1);
+    split_offsets = (size_t *)
+      t8_element_scratch_alloc ((num_children + 1) * sizeof (size_t));
     /* Compute the children */
     ts->t8_element_children (element, num_children, children);
     /* Split the leafs array in portions belonging to the children of element */
@@ -260,9 +281,7 @@ t8_forest_search_recursion (t8_forest_t forest, t8_locidx_t ltreeid,
       }
     }
     /* clean-up */
-    ts->t8_element_destroy (num_children, children);
-    T8_FREE (children);
-    T8_FREE (split_offsets);
+    t8_element_scratch_release (&scratch_mark);
   }
 }
 
@@ -275,6 +294,7 @@ t8_forest_search_tree (t8_forest_t forest, t8_locidx_t ltreeid,
   t8_eclass_scheme_c *ts;
   t8_element_t       *nca, *first_el, *last_el;
   t8_element_array_t *leaf_elements;
+  t8_element_scratch_mark_t scratch_mark;
 
   /* Get the element class, scheme and leaf elements of this tree */
   eclass = t8_forest_get_eclass (forest, ltreeid);
@@ -290,11 +310,13 @@ t8_forest_search_tree (t8_forest_t forest, t8_locidx_t ltreeid,
                                    t8_element_array_get_count (leaf_elements)
                                    - 1);
   /* Compute their nearest common ancestor */
-  ts->t8_element_new (1, &nca);
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (ts, 1, &nca);
   ts->t8_element_nca (first_el, last_el, nca);
   /* Start the top-down search */
   t8_forest_search_recursion (forest, ltreeid, eclass, nca, ts, leaf_elements,
                               0, search_fn, user_data);
+  t8_element_scratch_release (&scratch_mark);
 }
 
 void
@@ -310,82 +332,588 @@ t8_forest_search (t8_forest_t forest, t8_forest_search_query_fn search_fn,
 }
 
 void
-t8_forest_iterate_replace (t8_forest_t forest_new,
-                           t8_forest_t forest_old,
-                           t8_forest_replace_t replace_fn)
+t8_forest_search_threaded (t8_forest_t forest,
+                           t8_forest_search_query_fn search_fn,
+                           void **thread_user_data, int num_threads)
+{
+  t8_locidx_t         num_local_trees, itree;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (num_threads >= 1);
+  T8_ASSERT (thread_user_data != NULL);
+
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  if (num_threads > 1) {
+    /* Creating the elements of implicit trees is not thread-safe */
+    t8_forest_materialize (forest);
+  }
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp parallel num_threads(num_threads) if (num_threads > 1)
+  {
+#pragma omp for schedule(dynamic)
+    for (itree = 0; itree < num_local_trees; itree++) {
+      t8_forest_search_tree (forest, itree, search_fn,
+                             thread_user_data[omp_get_thread_num ()]);
+    }
+    t8_element_scratch_finalize_worker ();
+  }
+#else
+  /* Without OpenMP we search with one thread */
+  (void) num_threads;
+  for (itree = 0; itree < num_local_trees; itree++) {
+    t8_forest_search_tree (forest, itree, search_fn, thread_user_data[0]);
+  }
+#endif
+}
+
+/* The recursion of t8_forest_search_queries. The active queries of element
+ * are given by their indices. We evaluate them and continue with the
+ * children of element for the queries that match. All temporary memory
+ * comes from the scratch arena. */
+static void
+t8_forest_search_queries_recursion (t8_forest_t forest, t8_locidx_t ltreeid,
+                                    t8_element_t * element,
+                                    t8_eclass_scheme_c * ts,
+                                    t8_element_array_t * leaf_elements,
+                                    t8_locidx_t tree_lindex_of_first_leaf,
+                                    t8_forest_search_query_fn search_fn,
+                                    t8_forest_search_queries_fn query_fn,
+                                    sc_array_t * queries,
+                                    const size_t *query_indices,
+                                    size_t num_active, void *user_data)
+{
+  t8_element_t       *leaf, **children;
+  t8_element_array_t  child_leafs;
+  t8_element_scratch_mark_t scratch_mark;
+  size_t             *split_offsets, *new_indices, indexa, indexb;
+  size_t              elem_count, iquery, num_new;
+  int                *matches;
+  int                 num_children, ichild, is_leaf;
+
+  T8_ASSERT (num_active > 0);
+
+  elem_count = t8_element_array_get_count (leaf_elements);
+  if (elem_count == 0) {
+    /* There are no leafs left, so we have nothing to do */
+    return;
+  }
+  is_leaf = 0;
+  if (elem_count == 1) {
+    /* Check whether element is the remaining leaf */
+    leaf = t8_element_array_index_locidx (leaf_elements, 0);
+    SC_CHECK_ABORT (ts->t8_element_level (element) <=
+                    ts->t8_element_level (leaf),
+                    "Search: element level greater than leaf level\n");
+    is_leaf = ts->t8_element_level (element) == ts->t8_element_level (leaf);
+  }
+  if (search_fn != NULL
+      && !search_fn (forest, ltreeid, element, leaf_elements, user_data,
+                     is_leaf ? tree_lindex_of_first_leaf :
+                     -tree_lindex_of_first_leaf - 1)) {
+    /* The user does not want to continue below this element */
+    return;
+  }
+
+  t8_element_scratch_mark (&scratch_mark);
+  matches = (int *) t8_element_scratch_alloc (num_active * sizeof (int));
+  query_fn (forest, ltreeid, element, is_leaf, leaf_elements,
+            tree_lindex_of_first_leaf, queries, query_indices, matches,
+            num_active, user_data);
+  if (is_leaf) {
+    /* We are at the last stage of the recursion */
+    t8_element_scratch_release (&scratch_mark);
+    return;
+  }
+  /* Collect the queries that remain active for the children */
+  new_indices =
+    (size_t *) t8_element_scratch_alloc (num_active * sizeof (size_t));
+  num_new = 0;
+  for (iquery = 0; iquery < num_active; iquery++) {
+    if (matches[iquery]) {
+      new_indices[num_new++] = query_indices[iquery];
+    }
+  }
+  if (num_new > 0) {
+    /* Compute the children and split the leafs among them */
+    num_children = ts->t8_element_num_children (element);
+    children = (t8_element_t **)
+      t8_element_scratch_alloc (num_children * sizeof (t8_element_t *));
+    t8_element_scratch_get (ts, num_children, children);
+    split_offsets = (size_t *)
+      t8_element_scratch_alloc ((num_children + 1) * sizeof (size_t));
+    ts->t8_element_children (element, num_children, children);
+    t8_forest_split_array (element, leaf_elements, split_offsets);
+    for (ichild = 0; ichild < num_children; ichild++) {
+      indexa = split_offsets[ichild];
+      indexb = split_offsets[ichild + 1];
+      if (indexa < indexb) {
+        t8_element_array_init_view (&child_leafs, leaf_elements, indexa,
+                                    indexb - indexa);
+        t8_forest_search_queries_recursion (forest, ltreeid,
+                                            children[ichild], ts,
+                                            &child_leafs,
+                                            indexa +
+                                            tree_lindex_of_first_leaf,
+                                            search_fn, query_fn, queries,
+                                            new_indices, num_new, user_data);
+      }
+    }
+  }
+  t8_element_scratch_release (&scratch_mark);
+}
+
+/* Search one tree of the forest with all queries active at its root */
+static void
+t8_forest_search_queries_tree (t8_forest_t forest, t8_locidx_t ltreeid,
+                               t8_forest_search_query_fn search_fn,
+                               t8_forest_search_queries_fn query_fn,
+                               sc_array_t * queries,
+                               const size_t *query_indices, void *user_data)
+{
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *nca, *first_el, *last_el;
+  t8_element_array_t *leaf_elements;
+  t8_element_scratch_mark_t scratch_mark;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_eclass (forest, ltreeid));
+  leaf_elements = t8_forest_tree_get_leafs (forest, ltreeid);
+  if (t8_element_array_get_count (leaf_elements) == 0) {
+    return;
+  }
+  /* Start the search at the nearest common ancestor of the leafs */
+  first_el = t8_element_array_index_locidx (leaf_elements, 0);
+  last_el =
+    t8_element_array_index_locidx (leaf_elements,
+                                   t8_element_array_get_count
+                                   (leaf_elements) - 1);
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (ts, 1, &nca);
+  ts->t8_element_nca (first_el, last_el, nca);
+  t8_forest_search_queries_recursion (forest, ltreeid, nca, ts,
+                                      leaf_elements, 0, search_fn,
+                                      query_fn, queries, query_indices,
+                                      queries->elem_count, user_data);
+  t8_element_scratch_release (&scratch_mark);
+}
+
+/* Search all local trees for the queries with up to num_threads threads.
+ * If thread_user_data is not NULL, thread i passes thread_user_data[i] to
+ * the callbacks, otherwise user_data is passed. */
+static void
+t8_forest_search_queries_trees (t8_forest_t forest,
+                                t8_forest_search_query_fn search_fn,
+                                t8_forest_search_queries_fn query_fn,
+                                sc_array_t * queries, void *user_data,
+                                void **thread_user_data, int num_threads)
+{
+  t8_locidx_t         num_local_trees, itree;
+  size_t              num_queries, iquery, *query_indices;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (query_fn != NULL && queries != NULL);
+  T8_ASSERT (num_threads >= 1);
+
+  num_queries = queries->elem_count;
+  if (num_queries == 0) {
+    return;
+  }
+  /* At the root of each tree all queries are active */
+  query_indices = T8_ALLOC (size_t, num_queries);
+  for (iquery = 0; iquery < num_queries; iquery++) {
+    query_indices[iquery] = iquery;
+  }
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  if (num_threads > 1) {
+    /* Creating the elements of implicit trees is not thread-safe */
+    t8_forest_materialize (forest);
+  }
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp parallel num_threads(num_threads) if (num_threads > 1)
+  {
+#pragma omp for schedule(dynamic)
+    for (itree = 0; itree < num_local_trees; itree++) {
+      t8_forest_search_queries_tree (forest, itree, search_fn, query_fn,
+                                     queries, query_indices,
+                                     thread_user_data == NULL ? user_data :
+                                     thread_user_data[omp_get_thread_num ()]);
+    }
+    t8_element_scratch_finalize_worker ();
+  }
+#else
+  /* Without OpenMP we search with one thread */
+  (void) num_threads;
+  for (itree = 0; itree < num_local_trees; itree++) {
+    t8_forest_search_queries_tree (forest, itree, search_fn, query_fn,
+                                   queries, query_indices,
+                                   thread_user_data == NULL ? user_data :
+                                   thread_user_data[0]);
+  }
+#endif
+  T8_FREE (query_indices);
+}
+
+void
+t8_forest_search_queries (t8_forest_t forest,
+                          t8_forest_search_query_fn search_fn,
+                          t8_forest_search_queries_fn query_fn,
+                          sc_array_t * queries, void *user_data)
+{
+  t8_forest_search_queries_trees (forest, search_fn, query_fn, queries,
+                                  user_data, NULL, 1);
+}
+
+void
+t8_forest_search_queries_threaded (t8_forest_t forest,
+                                   t8_forest_search_query_fn search_fn,
+                                   t8_forest_search_queries_fn query_fn,
+                                   sc_array_t * queries,
+                                   void **thread_user_data, int num_threads)
+{
+  T8_ASSERT (thread_user_data != NULL);
+  t8_forest_search_queries_trees (forest, search_fn, query_fn, queries,
+                                  NULL, thread_user_data, num_threads);
+}
+
+/* Decide whether the face of a leaf with exactly one neighbor leaf is
+ * visited from this leaf. */
+static int
+t8_forest_iterate_face_is_owned (t8_forest_t forest, t8_locidx_t lelement,
+                                 int level, int face,
+                                 t8_eclass_scheme_c * neigh_scheme,
+                                 const t8_element_t * neighbor,
+                                 t8_locidx_t neigh_index, int dual_face)
+{
+  int                 neigh_level;
+
+  if (neigh_index >= t8_forest_get_num_element (forest)) {
+    /* The neighbor is a ghost, only this process sees the face from
+     * its local side */
+    return 1;
+  }
+  neigh_level = neigh_scheme->t8_element_level (neighbor);
+  if (neigh_level != level) {
+    /* The neighbor is the coarse side of a hanging face and visits it */
+    T8_ASSERT (neigh_level < level);
+    return 0;
+  }
+  /* Both leafs have the same size, the smaller index visits the face.
+   * A leaf may be its own neighbor in a periodic mesh. */
+  return lelement < neigh_index || (lelement == neigh_index
+                                    && face < dual_face);
+}
+
+void
+t8_forest_iterate_unique_faces (t8_forest_t forest,
+                                t8_forest_iterate_unique_face_fn face_fn,
+                                void *user_data)
+{
+  t8_locidx_t         num_local_trees, itree, ielem, num_elements;
+  t8_locidx_t         lelement, *neigh_indices;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_t       *element, **neighbors;
+  t8_element_scratch_mark_t scratch_mark;
+  int                *dual_faces;
+  int                 iface, num_faces, num_neighbors, level;
+  int                 created_tables;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  created_tables = t8_forest_leaf_face_neighbors_begin (forest);
+
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  lelement = 0;
+  for (itree = 0; itree < num_local_trees; itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielem = 0; ielem < num_elements; ielem++, lelement++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielem);
+      level = ts->t8_element_level (element);
+      num_faces = ts->t8_element_num_faces (element);
+      for (iface = 0; iface < num_faces; iface++) {
+        /* Compute the neighbor leafs into scratch buffers */
+        t8_element_scratch_mark (&scratch_mark);
+        num_neighbors =
+          t8_forest_leaf_face_neighbors_scratch (forest, itree, element,
+                                                 iface, &neighbors,
+                                                 &dual_faces, &neigh_indices,
+                                                 &neigh_scheme);
+        if (num_neighbors != 1
+            || t8_forest_iterate_face_is_owned (forest, lelement, level,
+                                                iface, neigh_scheme,
+                                                neighbors[0],
+                                                neigh_indices[0],
+                                                dual_faces[0])) {
+          /* This leaf is at the boundary, is the coarse side of a hanging
+           * face or owns the face */
+          face_fn (forest, itree, element, lelement, iface, neigh_scheme,
+                   num_neighbors, neighbors, neigh_indices, dual_faces,
+                   user_data);
+        }
+        t8_element_scratch_release (&scratch_mark);
+      }
+    }
+  }
+
+  t8_forest_leaf_face_neighbors_end (forest, created_tables);
+}
+
+/* Append a replacement of num_old old elements by num_new new elements in
+ * tree ltree_id to runs. If it continues the last run, we extend this run. */
+static void
+t8_forest_iterate_replace_push (sc_array_t * runs, t8_locidx_t ltree_id,
+                                int num_old, t8_locidx_t first_old,
+                                int num_new, t8_locidx_t first_new)
+{
+  t8_forest_adapt_run_t *run;
+
+  if (runs->elem_count > 0) {
+    run = (t8_forest_adapt_run_t *) sc_array_index (runs,
+                                                    runs->elem_count - 1);
+    if (run->ltree_id == ltree_id
+        && run->num_old == num_old && run->num_new == num_new
+        && run->first_old + run->count * num_old == first_old
+        && run->first_new + run->count * num_new == first_new) {
+      run->count++;
+      return;
+    }
+  }
+  run = (t8_forest_adapt_run_t *) sc_array_push (runs);
+  run->ltree_id = ltree_id;
+  run->first_old = first_old;
+  run->first_new = first_new;
+  run->count = 1;
+  run->num_old = num_old;
+  run->num_new = num_new;
+}
+
+/* Compare the elements of a tree in forest_new and forest_old and store
+ * the replacements as runs of type t8_forest_adapt_run_t in runs. */
+static void
+t8_forest_iterate_replace_compare (t8_forest_t forest_new,
+                                   t8_forest_t forest_old, t8_locidx_t itree,
+                                   t8_eclass_scheme_c * ts, sc_array_t * runs)
 {
   t8_locidx_t         ielem_new, ielem_old, elems_per_tree_old,
     elems_per_tree_new;
-  t8_locidx_t         itree, num_local_trees;
   t8_locidx_t         family_size;
   t8_element_t       *elem_new, *elem_old;
-  t8_eclass_scheme_c *ts;
-  t8_eclass_t         eclass;
   int                 level_new, level_old;
 
-  t8_global_productionf ("Into t8_forest_iterate_replace\n");
+  /* Get the number of elements of this tree in old and new forest */
+  elems_per_tree_new = t8_forest_get_tree_num_elements (forest_new, itree);
+  elems_per_tree_old = t8_forest_get_tree_num_elements (forest_old, itree);
+  for (ielem_new = 0, ielem_old = 0; ielem_new < elems_per_tree_new
+       || ielem_old < elems_per_tree_old;) {
+    /* Iterate over the elements */
+    /* Get pointers to the elements */
+    elem_new = t8_forest_get_element_in_tree (forest_new, itree, ielem_new);
+    elem_old = t8_forest_get_element_in_tree (forest_old, itree, ielem_old);
+    /* Get the levels of these elements */
+    level_new = ts->t8_element_level (elem_new);
+    level_old = ts->t8_element_level (elem_old);
+    /* If the levels differ, elem_new was refined or its family coarsened */
+    if (level_old < level_new) {
+      T8_ASSERT (level_new == level_old + 1);
+      /* elem_old was refined */
+      family_size = ts->t8_element_num_children (elem_old);
+      t8_forest_iterate_replace_push (runs, itree, 1, ielem_old,
+                                      family_size, ielem_new);
+      /* Advance to the next element */
+      ielem_new += family_size;
+      ielem_old++;
+    }
+    else if (level_old > level_new) {
+      T8_ASSERT (level_new == level_old - 1);
+      /* elem_old was coarsened */
+      family_size = ts->t8_element_num_children (elem_new);
+      t8_forest_iterate_replace_push (runs, itree, family_size, ielem_old,
+                                      1, ielem_new);
+      /* Advance to the next element */
+      ielem_new++;
+      ielem_old += family_size;
+    }
+    else {
+      /* elem_new = elem_old */
+      T8_ASSERT (!ts->t8_element_compare (elem_new, elem_old));
+      t8_forest_iterate_replace_push (runs, itree, 1, ielem_old, 1,
+                                      ielem_new);
+      /* Advance to the next element */
+      ielem_new++;
+      ielem_old++;
+    }
+  }                             /* element loop */
+  T8_ASSERT (ielem_new == elems_per_tree_new);
+  T8_ASSERT (ielem_old == elems_per_tree_old);
+}
+
+/* Call either the batched replace callback once for all runs of a tree,
+ * or the replace callback for each replacement in these runs. */
+static void
+t8_forest_iterate_replace_runs (t8_forest_t forest_new,
+                                t8_forest_t forest_old, t8_locidx_t itree,
+                                t8_eclass_scheme_c * ts, size_t num_runs,
+                                const t8_forest_adapt_run_t * runs,
+                                t8_forest_replace_t replace_fn,
+                                t8_forest_replace_batch_t batch_fn)
+{
+  const t8_forest_adapt_run_t *run;
+  t8_locidx_t         ireplace, ielem_old, ielem_new;
+  size_t              irun;
+
+  if (batch_fn != NULL) {
+    if (num_runs > 0) {
+      batch_fn (forest_old, forest_new, itree, ts, num_runs, runs);
+    }
+    return;
+  }
+  for (irun = 0; irun < num_runs; irun++) {
+    run = runs + irun;
+    T8_ASSERT (run->ltree_id == itree);
+    T8_ASSERT (run->first_old + run->count * run->num_old <=
+               t8_forest_get_tree_num_elements (forest_old, itree));
+    T8_ASSERT (run->first_new + run->count * run->num_new <=
+               t8_forest_get_tree_num_elements (forest_new, itree));
+    ielem_old = run->first_old;
+    ielem_new = run->first_new;
+    for (ireplace = 0; ireplace < run->count; ireplace++) {
+      replace_fn (forest_old, forest_new, itree, ts, run->num_old,
+                  ielem_old, run->num_new, ielem_new);
+      ielem_old += run->num_old;
+      ielem_new += run->num_new;
+    }
+  }
+}
+
+/* Iterate over the replacements of all local trees with up to num_threads
+ * threads. Exactly one of replace_fn and batch_fn must be given.
+ * If forest_new stores an adapt map, we use it. Otherwise we compare the
+ * elements of each tree before the threads start, since the runs are
+ * allocated and the allocator is not thread-safe. */
+static void
+t8_forest_iterate_replace_trees (t8_forest_t forest_new,
+                                 t8_forest_t forest_old,
+                                 t8_forest_replace_t replace_fn,
+                                 t8_forest_replace_batch_t batch_fn,
+                                 int num_threads)
+{
+  t8_locidx_t         itree, num_local_trees;
+  t8_forest_adapt_run_t *map_runs;
+  sc_array_t          compared_runs, *all_runs;
+  size_t             *tree_first_run, irun;
+
   T8_ASSERT (t8_forest_is_committed (forest_old));
   T8_ASSERT (t8_forest_is_committed (forest_new));
+  T8_ASSERT ((replace_fn == NULL) != (batch_fn == NULL));
+  T8_ASSERT (num_threads >= 1);
 
   num_local_trees = t8_forest_get_num_local_trees (forest_new);
   T8_ASSERT (num_local_trees == t8_forest_get_num_local_trees (forest_old));
+#if !defined (T8_ENABLE_OPENMP) || !defined (_OPENMP)
+  /* Without OpenMP we iterate with one thread */
+  (void) num_threads;
+#endif
 
+  if (forest_new->adapt_map != NULL) {
+    /* The adapt map stores all replacements sorted by tree, we do not need
+     * to compare the elements. */
+    all_runs = forest_new->adapt_map;
+  }
+  else {
+    /* Compare the elements of all trees, the runs are sorted by tree */
+    sc_array_init (&compared_runs, sizeof (t8_forest_adapt_run_t));
+    for (itree = 0; itree < num_local_trees; itree++) {
+      t8_forest_iterate_replace_compare (forest_new, forest_old, itree,
+                                         t8_forest_get_eclass_scheme
+                                         (forest_new,
+                                          t8_forest_get_tree_class
+                                          (forest_new, itree)),
+                                         &compared_runs);
+    }
+    all_runs = &compared_runs;
+  }
+  /* Compute the first run of each tree */
+  map_runs = (t8_forest_adapt_run_t *) all_runs->array;
+  tree_first_run = T8_ALLOC (size_t, num_local_trees + 1);
+  irun = 0;
   for (itree = 0; itree < num_local_trees; itree++) {
-    /* Loop over the trees */
-    /* Get the number of elements of this tree in old and new forest */
-    elems_per_tree_new = t8_forest_get_tree_num_elements (forest_new, itree);
-    elems_per_tree_old = t8_forest_get_tree_num_elements (forest_old, itree);
-    /* Get the eclass and scheme of the tree */
-    eclass = t8_forest_get_tree_class (forest_new, itree);
-    T8_ASSERT (eclass == t8_forest_get_tree_class (forest_old, itree));
-    ts = t8_forest_get_eclass_scheme (forest_new, eclass);
-    T8_ASSERT (ts == t8_forest_get_eclass_scheme (forest_new, eclass));
-    for (ielem_new = 0, ielem_old = 0; ielem_new < elems_per_tree_new
-         || ielem_old < elems_per_tree_old;) {
-      /* Iterate over the elements */
-      /* Get pointers to the elements */
-      elem_new = t8_forest_get_element_in_tree (forest_new, itree, ielem_new);
-      elem_old = t8_forest_get_element_in_tree (forest_old, itree, ielem_old);
-      /* Get the levels of these elements */
-      level_new = ts->t8_element_level (elem_new);
-      level_old = ts->t8_element_level (elem_old);
-      /* If the levels differ, elem_new was refined or its family coarsened */
-      if (level_old < level_new) {
-        T8_ASSERT (level_new == level_old + 1);
-        /* elem_old was refined */
-        family_size = ts->t8_element_num_children (elem_old);
-        replace_fn (forest_old, forest_new, itree, ts, 1, ielem_old,
-                    family_size, ielem_new);
-        /* Advance to the next element */
-        ielem_new += family_size;
-        ielem_old++;
-      }
-      else if (level_old > level_new) {
-        T8_ASSERT (level_new == level_old - 1);
-        /* elem_old was coarsened */
-        family_size = ts->t8_element_num_children (elem_new);
-        replace_fn (forest_old, forest_new, itree, ts, family_size, ielem_old,
-                    1, ielem_new);
-        /* Advance to the next element */
-        ielem_new++;
-        ielem_old += family_size;
-      }
-      else {
-        /* elem_new = elem_old */
-        T8_ASSERT (!ts->t8_element_compare (elem_new, elem_old));
-        replace_fn (forest_old, forest_new, itree, ts, 1, ielem_old, 1,
-                    ielem_new);
-        /* Advance to the next element */
-        ielem_new++;
-        ielem_old++;
-      }
-    }                           /* element loop */
-    T8_ASSERT (ielem_new ==
-               t8_forest_get_tree_num_elements (forest_new, itree));
-    T8_ASSERT (ielem_old ==
-               t8_forest_get_tree_num_elements (forest_old, itree));
-  }                             /* tree loop */
+    tree_first_run[itree] = irun;
+    while (irun < all_runs->elem_count && map_runs[irun].ltree_id == itree) {
+      irun++;
+    }
+  }
+  tree_first_run[num_local_trees] = irun;
+  T8_ASSERT (irun == all_runs->elem_count);
+
+  if (num_threads > 1) {
+    /* Creating the elements of implicit trees is not thread-safe */
+    t8_forest_materialize (forest_new);
+    t8_forest_materialize (forest_old);
+  }
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp parallel num_threads(num_threads) if (num_threads > 1)
+#endif
+  {
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp for schedule(dynamic)
+#endif
+    for (itree = 0; itree < num_local_trees; itree++) {
+      t8_eclass_t         eclass;
+      t8_eclass_scheme_c *ts;
+
+      /* Get the eclass and scheme of the tree */
+      eclass = t8_forest_get_tree_class (forest_new, itree);
+      T8_ASSERT (eclass == t8_forest_get_tree_class (forest_old, itree));
+      ts = t8_forest_get_eclass_scheme (forest_new, eclass);
+      t8_forest_iterate_replace_runs (forest_new, forest_old, itree, ts,
+                                      tree_first_run[itree + 1] -
+                                      tree_first_run[itree],
+                                      map_runs + tree_first_run[itree],
+                                      replace_fn, batch_fn);
+    }                           /* tree loop */
+    t8_element_scratch_finalize_worker ();
+  }
+  T8_FREE (tree_first_run);
+  if (all_runs == &compared_runs) {
+    sc_array_reset (&compared_runs);
+  }
+}
+
+void
+t8_forest_iterate_replace (t8_forest_t forest_new,
+                           t8_forest_t forest_old,
+                           t8_forest_replace_t replace_fn)
+{
+  t8_global_productionf ("Into t8_forest_iterate_replace\n");
+  t8_forest_iterate_replace_trees (forest_new, forest_old, replace_fn, NULL,
+                                   1);
   t8_global_productionf ("Done t8_forest_iterate_replace\n");
 }
 
+void
+t8_forest_iterate_replace_threaded (t8_forest_t forest_new,
+                                    t8_forest_t forest_old,
+                                    t8_forest_replace_t replace_fn,
+                                    int num_threads)
+{
+  t8_global_productionf ("Into t8_forest_iterate_replace_threaded\n");
+  t8_forest_iterate_replace_trees (forest_new, forest_old, replace_fn, NULL,
+                                   num_threads);
+  t8_global_productionf ("Done t8_forest_iterate_replace_threaded\n");
+}
+
+void
+t8_forest_iterate_replace_batch (t8_forest_t forest_new,
+                                 t8_forest_t forest_old,
+                                 t8_forest_replace_batch_t batch_fn,
+                                 int num_threads)
+{
+  t8_global_productionf ("Into t8_forest_iterate_replace_batch\n");
+  t8_forest_iterate_replace_trees (forest_new, forest_old, NULL, batch_fn,
+                                   num_threads);
+  t8_global_productionf ("Done t8_forest_iterate_replace_batch\n");
+}
+
 T8_EXTERN_C_END ();
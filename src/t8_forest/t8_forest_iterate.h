@@ -51,9 +51,89 @@ typedef int         (*t8_forest_search_query_fn) (t8_forest_t forest,
                                                   t8_locidx_t
                                                   tree_leaf_index);
 
+/** Callback function prototype to evaluate several queries on an element
+ * at once in \ref t8_forest_search_queries.
+ * \param [in] forest          The forest.
+ * \param [in] ltreeid         The local tree of \a element.
+ * \param [in] element         The current element of the search.
+ * \param [in] is_leaf         True if \a element is a leaf of \a forest.
+ * \param [in] leaf_elements   The leafs of \a forest that are descendants of
+ *                             \a element (or the element itself if \a is_leaf).
+ * \param [in] tree_leaf_index The index in the tree of the first leaf of
+ *                             \a leaf_elements.
+ * \param [in] queries         The array of all queries of the search.
+ * \param [in] query_indices   The indices in \a queries of the queries that
+ *                             are active at \a element.
+ * \param [out] query_matches  For each active query, on output true if the
+ *                             query matches \a element and the search for it
+ *                             continues in the children of \a element.
+ *                             Ignored if \a is_leaf.
+ * \param [in] num_active_queries The number of entries of \a query_indices
+ *                             and \a query_matches, greater zero.
+ * \param [in] user_data       The user data of the search.
+ */
+typedef void        (*t8_forest_search_queries_fn) (t8_forest_t forest,
+                                                    t8_locidx_t ltreeid,
+                                                    const t8_element_t *
+                                                    element, int is_leaf,
+                                                    t8_element_array_t *
+                                                    leaf_elements,
+                                                    t8_locidx_t
+                                                    tree_leaf_index,
+                                                    sc_array_t * queries,
+                                                    const size_t *
+                                                    query_indices,
+                                                    int *query_matches,
+                                                    size_t
+                                                    num_active_queries,
+                                                    void *user_data);
+
+/** Callback function prototype for \ref t8_forest_iterate_unique_faces.
+ * It is called once for each face of the forest.
+ * \param [in] forest          The forest.
+ * \param [in] ltreeid         The local tree of \a element.
+ * \param [in] element         A local leaf at the face. If the face is hanging,
+ *                             this is the coarse leaf.
+ * \param [in] lelement        The local index of \a element.
+ * \param [in] face            The face of \a element.
+ * \param [in] neigh_scheme    The eclass scheme of the neighbor leafs.
+ * \param [in] num_neighbors   The number of neighbor leafs at \a face.
+ *                             0 if \a face is at the domain boundary.
+ * \param [in] neighbors       The neighbor leafs.
+ * \param [in] neigh_indices   The indices of the neighbor leafs. Ghosts have
+ *                             the number of local elements plus their ghost index.
+ * \param [in] dual_faces      The faces of the neighbor leafs at \a face.
+ * \param [in] user_data       The user data of the iteration.
+ */
+typedef void        (*t8_forest_iterate_unique_face_fn) (t8_forest_t forest,
+                                                         t8_locidx_t ltreeid,
+                                                         const t8_element_t *
+                                                         element,
+                                                         t8_locidx_t lelement,
+                                                         int face,
+                                                         t8_eclass_scheme_c *
+                                                         neigh_scheme,
+                                                         int num_neighbors,
+                                                         t8_element_t **
+                                                         neighbors,
+                                                         const t8_locidx_t *
+                                                         neigh_indices,
+                                                         const int
+                                                         *dual_faces,
+                                                         void *user_data);
+
 T8_EXTERN_C_BEGIN ();
 
-/* TODO: Document */
+/** Split an array of leafs that are descendants of an element among the
+ * children of the element. The leafs must be sorted along the space-filling
+ * curve. The split is computed with a binary search for the first
+ * descendant of each child.
+ * \param [in]  element       An element.
+ * \param [in]  leaf_elements Leafs that are descendants of \a element.
+ * \param [out] offsets       An array of num_children + 1 entries. On output
+ *                            the descendants of the i-th child are the leafs
+ *                            offsets[i], ..., offsets[i + 1] - 1.
+ */
 void                t8_forest_split_array (const t8_element_t * element,
                                            t8_element_array_t * leaf_elements,
                                            size_t * offsets);
@@ -86,6 +166,90 @@ void                t8_forest_search (t8_forest_t forest,
                                       t8_forest_search_query_fn search_fn,
                                       void *user_data);
 
+/** Perform \ref t8_forest_search with multiple threads.
+ * Each tree is searched by one thread, thus \a search_fn may be called
+ * concurrently for different trees.
+ * \param [in]  forest      A committed forest.
+ * \param [in]  search_fn   The search callback. It must be thread-safe
+ *                          for different trees.
+ * \param [in]  thread_user_data An array of \a num_threads pointers.
+ *                          The thread with number i passes
+ *                          \a thread_user_data[i] to \a search_fn, such
+ *                          that each thread can collect its results without
+ *                          locking.
+ * \param [in]  num_threads The maximum number of threads. If t8code is not
+ *                          configured with --enable-openmp, one thread is used
+ *                          and it passes \a thread_user_data[0].
+ */
+void                t8_forest_search_threaded (t8_forest_t forest,
+                                               t8_forest_search_query_fn
+                                               search_fn,
+                                               void **thread_user_data,
+                                               int num_threads);
+
+/** Perform a top-down search of the forest for many queries at once.
+ * At each element the queries that matched the parent element are active.
+ * They are evaluated together by one call of \a query_fn, and only the
+ * queries that match the element are passed on to its children.
+ * The recursion stops at elements without active queries.
+ * \param [in]  forest      A committed forest.
+ * \param [in]  search_fn   If not NULL, it is called on each element before
+ *                          \a query_fn. If it returns false, the descendants of
+ *                          the element are not searched.
+ * \param [in]  query_fn    The callback to evaluate the active queries.
+ * \param [in]  queries     An array of queries. Its entries are passed to
+ *                          \a query_fn and not interpreted otherwise.
+ * \param [in]  user_data   A pointer that is passed to both callbacks.
+ */
+void                t8_forest_search_queries (t8_forest_t forest,
+                                              t8_forest_search_query_fn
+                                              search_fn,
+                                              t8_forest_search_queries_fn
+                                              query_fn, sc_array_t * queries,
+                                              void *user_data);
+
+/** Perform \ref t8_forest_search_queries with multiple threads.
+ * Each tree is searched by one thread, thus the callbacks may be called
+ * concurrently for different trees.
+ * \param [in]  thread_user_data An array of \a num_threads pointers.
+ *                          The thread with number i passes
+ *                          \a thread_user_data[i] to the callbacks.
+ * \param [in]  num_threads The maximum number of threads. If t8code is not
+ *                          configured with --enable-openmp, one thread is used
+ *                          and it passes \a thread_user_data[0].
+ * \see t8_forest_search_queries for the other parameters.
+ */
+void                t8_forest_search_queries_threaded (t8_forest_t forest,
+                                                       t8_forest_search_query_fn
+                                                       search_fn,
+                                                       t8_forest_search_queries_fn
+                                                       query_fn,
+                                                       sc_array_t * queries,
+                                                       void
+                                                       **thread_user_data,
+                                                       int num_threads);
+
+/** Iterate over the faces of the local leafs of a forest such that each
+ * face is visited exactly once. A face is visited
+ * - from the coarse leaf with all its neighbor leafs if it is hanging,
+ * - from the leaf with the smaller index if both leafs have the same size,
+ * - from the local leaf if the neighbor is a ghost, and
+ * - with no neighbors if it lies on the domain boundary.
+ * If a local leaf touches a coarser ghost, the part of the face of the
+ * ghost that the local leaf covers is visited from the local leaf.
+ * Faces between two processes are thus visited on both processes.
+ * Faces between trees are found through the tree connectivity.
+ * Since all leafs at a face are passed together, the callback can compute
+ * the fluxes of all of them at once. Each flux is computed once.
+ * \param [in]  forest      A committed, balanced forest. If it lives on
+ *                          more than one process, it must have a ghost layer.
+ * \param [in]  face_fn     The callback that is called for each face.
+ * \param [in]  user_data   A pointer that is passed to \a face_fn.
+ */
+void                t8_forest_iterate_unique_faces (t8_forest_t forest,
+                                                    t8_forest_iterate_unique_face_fn
+                                                    face_fn, void *user_data);
+
 /** Given two forest where the elemnts in one forest are either direct children or
  * parents of the elements in the other forest.
  * Compare the two forests and for each refined element or coarsened
@@ -96,12 +260,51 @@ void                t8_forest_search (t8_forest_t forest,
  * \param [in]  replace_fn  A replace callback function.
  * \note To pass a user pointer to \a replace_fn use \ref t8_forest_set_user_data
  * and \ref t8_forest_get_user_data.
+ * \note If \a forest_new was adapted from \a forest_old with
+ * \ref t8_forest_set_adapt_map, the recorded map is used and the elements
+ * are not compared.
  */
 void                t8_forest_iterate_replace (t8_forest_t forest_new,
                                                t8_forest_t forest_old,
                                                t8_forest_replace_t
                                                replace_fn);
 
+/** Perform \ref t8_forest_iterate_replace with multiple threads.
+ * Each tree is handled by one thread, thus \a replace_fn may be called
+ * concurrently for different trees, but it is called in order within a tree.
+ * \param [in]  forest_new  A forest, each element is a parent or child of an element in \a forest_old.
+ * \param [in]  forest_old  The initial forest.
+ * \param [in]  replace_fn  A replace callback function. It must be
+ *                          thread-safe for different trees.
+ * \param [in]  num_threads The maximum number of threads. If t8code is not
+ *                          configured with --enable-openmp, one thread is used.
+ */
+void                t8_forest_iterate_replace_threaded (t8_forest_t
+                                                        forest_new,
+                                                        t8_forest_t
+                                                        forest_old,
+                                                        t8_forest_replace_t
+                                                        replace_fn,
+                                                        int num_threads);
+
+/** As \ref t8_forest_iterate_replace_threaded, but call a batched callback
+ * once for each local tree that contains elements. The callback receives all
+ * replacements of the tree as runs of equal replacements. Thus it can
+ * process the kept elements, the refined elements and the coarsened
+ * families of a run with one vectorized loop each.
+ * \param [in]  forest_new  A forest, each element is a parent or child of an element in \a forest_old.
+ * \param [in]  forest_old  The initial forest.
+ * \param [in]  batch_fn    A batched replace callback function. It must be
+ *                          thread-safe for different trees.
+ * \param [in]  num_threads The maximum number of threads. If t8code is not
+ *                          configured with --enable-openmp, one thread is used.
+ */
+void                t8_forest_iterate_replace_batch (t8_forest_t forest_new,
+                                                     t8_forest_t forest_old,
+                                                     t8_forest_replace_batch_t
+                                                     batch_fn,
+                                                     int num_threads);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_FOREST_ITERATE_H! */
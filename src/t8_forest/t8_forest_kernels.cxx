@@ -0,0 +1,184 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_kernels.hxx>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <typeinfo>
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+t8_eclass_t
+t8_forest_get_kernel_eclass (t8_forest_t forest)
+{
+  int                 eclass_int, num_classes = 0;
+  t8_eclass_t         eclass = T8_ECLASS_COUNT;
+  t8_eclass_scheme_c *ts;
+  int                 is_default;
+
+  T8_ASSERT (forest->cmesh != NULL);
+  T8_ASSERT (forest->scheme_cxx != NULL);
+
+  if (forest->set_no_kernels) {
+    return T8_ECLASS_COUNT;
+  }
+  /* We use the global number of trees per class, such that all processes
+   * take the same path. */
+  for (eclass_int = T8_ECLASS_ZERO; eclass_int < T8_ECLASS_COUNT;
+       ++eclass_int) {
+    if (forest->cmesh->num_trees_per_eclass[eclass_int] > 0) {
+      num_classes++;
+      eclass = (t8_eclass_t) eclass_int;
+    }
+  }
+  if (num_classes != 1) {
+    return T8_ECLASS_COUNT;
+  }
+  /* Check whether the scheme of this class is a default scheme.
+   * We compare the exact type, since the kernels call the functions of the
+   * default scheme with a qualified name. A scheme that derives from a
+   * default scheme, such as the Hilbert schemes, may override them and
+   * must take the generic path through the virtual table. */
+  ts = forest->scheme_cxx->eclass_schemes[eclass];
+  switch (eclass) {
+  case T8_ECLASS_VERTEX:
+    is_default = typeid (*ts) == typeid (t8_default_scheme_vertex_c);
+    break;
+  case T8_ECLASS_LINE:
+    is_default = typeid (*ts) == typeid (t8_default_scheme_line_c);
+    break;
+  case T8_ECLASS_QUAD:
+    is_default = typeid (*ts) == typeid (t8_default_scheme_quad_c);
+    break;
+  case T8_ECLASS_TRIANGLE:
+    is_default = typeid (*ts) == typeid (t8_default_scheme_tri_c);
+    break;
+  case T8_ECLASS_HEX:
+    is_default = typeid (*ts) == typeid (t8_default_scheme_hex_c);
+    break;
+  case T8_ECLASS_TET:
+    is_default = typeid (*ts) == typeid (t8_default_scheme_tet_c);
+    break;
+  case T8_ECLASS_PRISM:
+    is_default = typeid (*ts) == typeid (t8_default_scheme_prism_c);
+    break;
+  default:
+    is_default = 0;
+  }
+  return is_default ? eclass : T8_ECLASS_COUNT;
+}
+
+void
+t8_forest_kernel_populate (t8_eclass_t kernel_eclass,
+                           t8_eclass_scheme_c * ts,
+                           t8_element_array_t * telements, int level,
+                           t8_gloidx_t start, t8_gloidx_t end)
+{
+  T8_ASSERT (kernel_eclass == T8_ECLASS_COUNT || kernel_eclass == ts->eclass);
+
+  switch (kernel_eclass) {
+  case T8_ECLASS_VERTEX:
+    t8_forest_kernel_populate_tree ((t8_default_scheme_vertex_c *) ts,
+                                    telements, level, start, end);
+    break;
+  case T8_ECLASS_LINE:
+    t8_forest_kernel_populate_tree ((t8_default_scheme_line_c *) ts,
+                                    telements, level, start, end);
+    break;
+  case T8_ECLASS_QUAD:
+    t8_forest_kernel_populate_tree ((t8_default_scheme_quad_c *) ts,
+                                    telements, level, start, end);
+    break;
+  case T8_ECLASS_TRIANGLE:
+    t8_forest_kernel_populate_tree ((t8_default_scheme_tri_c *) ts,
+                                    telements, level, start, end);
+    break;
+  case T8_ECLASS_HEX:
+    t8_forest_kernel_populate_tree ((t8_default_scheme_hex_c *) ts,
+                                    telements, level, start, end);
+    break;
+  case T8_ECLASS_TET:
+    t8_forest_kernel_populate_tree ((t8_default_scheme_tet_c *) ts,
+                                    telements, level, start, end);
+    break;
+  case T8_ECLASS_PRISM:
+    t8_forest_kernel_populate_tree ((t8_default_scheme_prism_c *) ts,
+                                    telements, level, start, end);
+    break;
+  default:
+    /* The generic path through the virtual table */
+    if (start < end) {
+      ts->t8_element_set_linear_id_range (t8_element_array_index_locidx
+                                          (telements, 0), end - start,
+                                          level, start);
+    }
+  }
+}
+
+void
+t8_forest_kernel_compute_child_ids (t8_eclass_t kernel_eclass,
+                                    t8_eclass_scheme_c * ts,
+                                    t8_element_array_t * telements,
+                                    int *child_ids)
+{
+  T8_ASSERT (kernel_eclass == T8_ECLASS_COUNT || kernel_eclass == ts->eclass);
+
+  switch (kernel_eclass) {
+  case T8_ECLASS_VERTEX:
+    t8_forest_kernel_child_ids ((t8_default_scheme_vertex_c *) ts,
+                                telements, child_ids);
+    break;
+  case T8_ECLASS_LINE:
+    t8_forest_kernel_child_ids ((t8_default_scheme_line_c *) ts,
+                                telements, child_ids);
+    break;
+  case T8_ECLASS_QUAD:
+    t8_forest_kernel_child_ids ((t8_default_scheme_quad_c *) ts,
+                                telements, child_ids);
+    break;
+  case T8_ECLASS_TRIANGLE:
+    t8_forest_kernel_child_ids ((t8_default_scheme_tri_c *) ts,
+                                telements, child_ids);
+    break;
+  case T8_ECLASS_HEX:
+    t8_forest_kernel_child_ids ((t8_default_scheme_hex_c *) ts,
+                                telements, child_ids);
+    break;
+  case T8_ECLASS_TET:
+    t8_forest_kernel_child_ids ((t8_default_scheme_tet_c *) ts,
+                                telements, child_ids);
+    break;
+  case T8_ECLASS_PRISM:
+    t8_forest_kernel_child_ids ((t8_default_scheme_prism_c *) ts,
+                                telements, child_ids);
+    break;
+  default:
+    /* One virtual call for the whole array */
+    ts->t8_element_child_id_array (t8_element_array_get_data (telements),
+                                   t8_element_array_get_count (telements),
+                                   child_ids);
+  }
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,127 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_kernels.hxx
+ * Element loops of the forest algorithms that are compiled for one
+ * particular default element scheme.
+ *
+ * If all trees of a forest have the same element class and the scheme of
+ * this class is exactly a default scheme, we call the scheme functions with
+ * a qualified name (ts->TScheme::t8_element_...). These are direct calls
+ * that do not go through the virtual table and can be inlined by the
+ * compiler. Since the dynamic type of the scheme is TScheme, they call the
+ * same functions as the virtual table would. Schemes that derive from a
+ * default scheme are not specialized, since they may override them.
+ * The generic path through \ref t8_eclass_scheme_c is used otherwise.
+ * \see t8_forest_get_kernel_eclass
+ */
+
+#ifndef T8_FOREST_KERNELS_HXX
+#define T8_FOREST_KERNELS_HXX
+
+#include <t8_forest.h>
+#include <t8_element_cxx.hxx>
+#include <t8_data/t8_containers.h>
+#include <t8_default/t8_default_vertex_cxx.hxx>
+#include <t8_default/t8_default_line_cxx.hxx>
+#include <t8_default/t8_default_quad_cxx.hxx>
+#include <t8_default/t8_default_hex_cxx.hxx>
+#include <t8_default/t8_default_tri_cxx.hxx>
+#include <t8_default/t8_default_tet_cxx.hxx>
+#include <t8_default/t8_default_prism_cxx.hxx>
+
+/** Fill the element array of a tree with the elements of a uniform
+ * refinement with linear ids in [\a start, \a end).
+ * \param [in] ts         The scheme of the tree.
+ * \param [in,out] telements The element array of the tree. Must have
+ *                        \a end - \a start elements.
+ * \param [in] level      The refinement level.
+ * \param [in] start      The linear id of the first element.
+ * \param [in] end        The linear id after the last element.
+ */
+template < class TScheme > void
+t8_forest_kernel_populate_tree (TScheme * ts, t8_element_array_t * telements,
+                                int level, t8_gloidx_t start, t8_gloidx_t end)
+{
+  T8_ASSERT ((t8_gloidx_t) t8_element_array_get_count (telements) ==
+             end - start);
+  if (start == end) {
+    return;
+  }
+  ts->TScheme::t8_element_set_linear_id_range
+    (t8_element_array_index_locidx (telements, 0), end - start, level,
+     start);
+}
+
+/** Compute the child ids of all elements of an element array.
+ * \param [in] ts         The scheme of the elements.
+ * \param [in] telements  The element array.
+ * \param [out] child_ids An array with one entry for each element
+ *                        in \a telements.
+ */
+template < class TScheme > void
+t8_forest_kernel_child_ids (TScheme * ts, t8_element_array_t * telements,
+                            int *child_ids)
+{
+  t8_locidx_t         ielem, num_elements;
+
+  num_elements = t8_element_array_get_count (telements);
+  for (ielem = 0; ielem < num_elements; ++ielem) {
+    child_ids[ielem] =
+      ts->TScheme::t8_element_child_id (t8_element_array_index_locidx
+                                        (telements, ielem));
+  }
+}
+
+T8_EXTERN_C_BEGIN ();
+
+/** Populate one tree of a forest with uniform elements.
+ * Uses \ref t8_forest_kernel_populate_tree if \a kernel_eclass is not
+ * T8_ECLASS_COUNT and the generic scheme functions otherwise.
+ * \param [in] kernel_eclass The result of \ref t8_forest_get_kernel_eclass.
+ * \see t8_forest_kernel_populate_tree for the other parameters.
+ */
+void                t8_forest_kernel_populate (t8_eclass_t kernel_eclass,
+                                               t8_eclass_scheme_c * ts,
+                                               t8_element_array_t *
+                                               telements, int level,
+                                               t8_gloidx_t start,
+                                               t8_gloidx_t end);
+
+/** Compute the child ids of all elements in an element array.
+ * Uses \ref t8_forest_kernel_child_ids if \a kernel_eclass is not
+ * T8_ECLASS_COUNT and \ref t8_eclass_scheme_c::t8_element_child_id_array
+ * otherwise.
+ * \param [in] kernel_eclass The result of \ref t8_forest_get_kernel_eclass.
+ * \see t8_forest_kernel_child_ids for the other parameters.
+ */
+void                t8_forest_kernel_compute_child_ids (t8_eclass_t
+                                                        kernel_eclass,
+                                                        t8_eclass_scheme_c *
+                                                        ts,
+                                                        t8_element_array_t *
+                                                        telements,
+                                                        int *child_ids);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_KERNELS_HXX */
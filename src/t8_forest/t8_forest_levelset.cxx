@@ -0,0 +1,162 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_levelset.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_element_cxx.hxx>
+
+T8_EXTERN_C_BEGIN ();
+
+/* The number of leafs whose level-set values are computed at once */
+#define T8_FOREST_LEVELSET_BATCH 256
+
+void
+t8_forest_levelset_markers (t8_forest_t forest_from, t8_locidx_t which_tree,
+                            const t8_forest_levelset_t * levelset,
+                            int8_t * markers)
+{
+  t8_element_array_t *leafs;
+  t8_eclass_scheme_c *ts;
+  t8_eclass_t         eclass;
+  t8_locidx_t         num_leafs, first, num_batch, ileaf;
+  size_t              num_points;
+  double             *corners, *centroids, *diameters, *values;
+  double             *x, *y, *z, dx, dy, dz, dist, value;
+  int                 num_corners, icorner, within, sign, level;
+
+  T8_ASSERT (t8_forest_is_committed (forest_from));
+  T8_ASSERT (levelset != NULL && levelset->levelset != NULL);
+  T8_ASSERT (levelset->band_width >= 0);
+
+  eclass = t8_forest_get_tree_class (forest_from, which_tree);
+  ts = t8_forest_get_eclass_scheme (forest_from, eclass);
+  leafs = t8_forest_get_tree_element_array (forest_from, which_tree);
+  num_leafs = (t8_locidx_t) t8_element_array_get_count (leafs);
+  num_corners = t8_eclass_num_vertices[eclass];
+
+  /* The corners of a batch are a batch of points themselves */
+  num_points = (size_t) T8_FOREST_LEVELSET_BATCH * num_corners;
+  corners = T8_ALLOC (double, 3 * num_points);
+  centroids = T8_ALLOC (double, 3 * T8_FOREST_LEVELSET_BATCH);
+  diameters = T8_ALLOC (double, T8_FOREST_LEVELSET_BATCH);
+  values = T8_ALLOC (double, num_points);
+  for (first = 0; first < num_leafs; first += num_batch) {
+    num_batch = SC_MIN (T8_FOREST_LEVELSET_BATCH, num_leafs - first);
+    num_points = (size_t) num_batch * num_corners;
+    x = corners;
+    y = corners + num_points;
+    z = corners + 2 * num_points;
+    t8_forest_leaf_range_corner_coordinates (forest_from, which_tree, leafs,
+                                             first, num_batch, x, y, z);
+    if (levelset->band_width > 0) {
+      /* The centroid is the average of the corners and the diameter twice
+       * the average distance of the corners to the centroid, as in
+       * t8_forest_element_centroid and t8_forest_element_diam */
+      for (ileaf = 0; ileaf < num_batch; ileaf++) {
+        double              c[3] = { 0, 0, 0 };
+
+        for (icorner = 0; icorner < num_corners; icorner++) {
+          c[0] += x[ileaf * num_corners + icorner];
+          c[1] += y[ileaf * num_corners + icorner];
+          c[2] += z[ileaf * num_corners + icorner];
+        }
+        c[0] /= num_corners;
+        c[1] /= num_corners;
+        c[2] /= num_corners;
+        dist = 0;
+        for (icorner = 0; icorner < num_corners; icorner++) {
+          dx = x[ileaf * num_corners + icorner] - c[0];
+          dy = y[ileaf * num_corners + icorner] - c[1];
+          dz = z[ileaf * num_corners + icorner] - c[2];
+          dist += sqrt (dx * dx + dy * dy + dz * dz);
+        }
+        diameters[ileaf] = 2 * dist / num_corners;
+        centroids[ileaf] = c[0];
+        centroids[num_batch + ileaf] = c[1];
+        centroids[2 * num_batch + ileaf] = c[2];
+      }
+      levelset->levelset (num_batch, centroids, levelset->t, levelset->user,
+                          values);
+    }
+    else {
+      /* Evaluate the level-set at all corners */
+      levelset->levelset (num_points, corners, levelset->t, levelset->user,
+                          values);
+    }
+    for (ileaf = 0; ileaf < num_batch; ileaf++) {
+      level = ts->t8_element_level (t8_element_array_index_locidx (leafs,
+                                                                   first +
+                                                                   ileaf));
+      if (level > levelset->max_level) {
+        markers[first + ileaf] = -1;
+        continue;
+      }
+      if (level < levelset->min_level) {
+        markers[first + ileaf] = 1;
+        continue;
+      }
+      if (levelset->band_width > 0) {
+        within = fabs (values[ileaf])
+          < levelset->band_width * diameters[ileaf];
+      }
+      else {
+        /* The zero level-set passes through the element if the sign of
+         * the level-set changes between its corners */
+        within = 0;
+        value = values[ileaf * num_corners];
+        sign = value > 0 ? 1 : -(value < 0);
+        for (icorner = 1; icorner < num_corners && !within; icorner++) {
+          value = values[ileaf * num_corners + icorner];
+          within = (value > 0 && sign <= 0) || (value == 0 && sign != 0)
+            || (value < 0 && sign >= 0);
+        }
+      }
+      if (within) {
+        markers[first + ileaf] = level < levelset->max_level;
+      }
+      else {
+        markers[first + ileaf] = -(level > levelset->min_level);
+      }
+    }
+  }
+  T8_FREE (corners);
+  T8_FREE (centroids);
+  T8_FREE (diameters);
+  T8_FREE (values);
+}
+
+void
+t8_forest_adapt_levelset (t8_forest_t forest, t8_forest_t forest_from,
+                          t8_locidx_t which_tree,
+                          t8_locidx_t lelement_offset,
+                          t8_eclass_scheme_c * ts,
+                          t8_element_array_t * elements, int8_t * markers)
+{
+  const t8_forest_levelset_t *levelset;
+
+  T8_ASSERT (elements ==
+             t8_forest_get_tree_element_array (forest_from, which_tree));
+  levelset = (const t8_forest_levelset_t *) t8_forest_get_user_data (forest);
+  t8_forest_levelset_markers (forest_from, which_tree, levelset, markers);
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,109 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_levelset.h
+ * Adapt a forest to the zero level-set of a function.
+ *
+ * The level-set function is evaluated for many points at once, see
+ * \ref t8_forest_levelset_fn. For each tree the corner coordinates of a
+ * batch of leafs are computed with the multilinear map of the tree, the
+ * centroids and diameters are derived from them, and the function is
+ * evaluated at all centroids of the batch in one call.
+ * The refinement decisions of a whole tree are written as markers, such
+ * that the helper can be used with \ref t8_forest_set_adapt_tree.
+ */
+
+#ifndef T8_FOREST_LEVELSET_H
+#define T8_FOREST_LEVELSET_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** A level-set function evaluated at many points.
+ * \param [in]  n       The number of points.
+ * \param [in]  points  The points as a batch of 3 \a n doubles, first the
+ *                      \a n x coordinates, then the y and then the z
+ *                      coordinates, see \ref t8_vec_batch_set.
+ * \param [in]  t       The time passed in \ref t8_forest_levelset_t.
+ * \param [in]  user    The user data passed in \ref t8_forest_levelset_t.
+ * \param [out] values  On output the value of the function at each point.
+ */
+typedef void        (*t8_forest_levelset_fn) (size_t n, const double *points,
+                                              double t, void *user,
+                                              double *values);
+
+/** The parameters of the level-set refinement. */
+typedef struct t8_forest_levelset
+{
+  t8_forest_levelset_fn levelset; /**< The level-set function. */
+  double              t;        /**< The time passed to \b levelset. */
+  void               *user;     /**< The user data passed to \b levelset. */
+  double              band_width; /**< An element is in the band if the
+                                       absolute value of \b levelset at its
+                                       centroid is smaller than this times its
+                                       diameter. If 0, an element is in the
+                                       band if the zero level-set passes
+                                       through it, which is checked at its
+                                       corners. */
+  int                 min_level; /**< Elements are refined up to this level
+                                      and not coarsened below it. */
+  int                 max_level; /**< Elements in the band are refined up to
+                                      this level, finer elements are
+                                      coarsened. */
+} t8_forest_levelset_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Compute the refinement markers of the leafs of a local tree.
+ * An element finer than \b max_level or outside of the band is marked for
+ * coarsening, unless it is not finer than \b min_level. An element coarser
+ * than \b min_level or inside the band is marked for refinement, unless it
+ * is not coarser than \b max_level. The other elements are kept.
+ * These are the rules of t8_common_adapt_level_set of the examples.
+ * \param [in]  forest_from  A committed forest.
+ * \param [in]  which_tree   A local tree of \a forest_from.
+ * \param [in]  levelset     The level-set parameters.
+ * \param [out] markers      One marker for each leaf of the tree, see
+ *                           \ref t8_forest_adapt_tree_t.
+ * \note The vertex coordinates of the tree must be stored in the cmesh.
+ * Pyramids are not supported.
+ */
+void                t8_forest_levelset_markers (t8_forest_t forest_from,
+                                                t8_locidx_t which_tree,
+                                                const t8_forest_levelset_t *
+                                                levelset, int8_t * markers);
+
+/** An adapt callback for \ref t8_forest_set_adapt_tree that refines along
+ * the zero level-set of a function with \ref t8_forest_levelset_markers.
+ * The user data of \a forest must point to a \ref t8_forest_levelset_t.
+ */
+void                t8_forest_adapt_levelset (t8_forest_t forest,
+                                              t8_forest_t forest_from,
+                                              t8_locidx_t which_tree,
+                                              t8_locidx_t lelement_offset,
+                                              t8_eclass_scheme_c * ts,
+                                              t8_element_array_t * elements,
+                                              int8_t * markers);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_LEVELSET_H */
@@ -0,0 +1,572 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_lnodes.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_partition.h>
+#include <t8_element_cxx.hxx>
+#include <t8_element_scratch.hxx>
+#include <algorithm>
+
+/* Each element has one slot for each possible corner. The slot of corner c
+ * of the element with local or ghost index e is e * T8_LNODES_SLOTS + c. */
+#define T8_LNODES_SLOTS T8_ECLASS_MAX_CORNERS
+
+/* The width of a constraint record: the number of parents and their ids */
+#define T8_LNODES_CONSTRAINT_WIDTH (T8_FOREST_LNODES_MAX_PARENTS + 1)
+
+/* The number of parents that marks a corner without constraint. It is
+ * larger than any valid number, such that a constraint wins against no
+ * constraint in the comparison of records. */
+#define T8_LNODES_NO_CONSTRAINT (T8_FOREST_LNODES_MAX_PARENTS + 1)
+
+/* The coordinates of the corners of an element */
+typedef struct
+{
+  double              coords[T8_LNODES_SLOTS][3];
+} t8_lnodes_corner_coords_t;
+
+/* The state of the numbering while we compute it */
+typedef struct
+{
+  t8_forest_t         forest;
+  t8_locidx_t         num_elements;     /* local elements */
+  t8_locidx_t         num_slots;        /* slots of local and ghost elements */
+  t8_locidx_t        *uf;       /* union-find parent of each slot */
+  int8_t             *num_parents;      /* constraints found locally */
+  t8_locidx_t        *parent_slots;     /* T8_FOREST_LNODES_MAX_PARENTS per slot */
+  t8_lnodes_corner_coords_t *coords;    /* one per local and ghost element */
+} t8_lnodes_context_t;
+
+/* Compare two records of width entries. Return true if a is better than b. */
+typedef int         (*t8_lnodes_better_t) (const t8_gloidx_t * a,
+                                           const t8_gloidx_t * b, int width);
+
+static              t8_locidx_t
+t8_lnodes_find (t8_locidx_t * uf, t8_locidx_t slot)
+{
+  while (uf[slot] != slot) {
+    /* Path halving */
+    uf[slot] = uf[uf[slot]];
+    slot = uf[slot];
+  }
+  return slot;
+}
+
+static void
+t8_lnodes_union (t8_locidx_t * uf, t8_locidx_t slot_a, t8_locidx_t slot_b)
+{
+  slot_a = t8_lnodes_find (uf, slot_a);
+  slot_b = t8_lnodes_find (uf, slot_b);
+  if (slot_a < slot_b) {
+    uf[slot_b] = slot_a;
+  }
+  else if (slot_b < slot_a) {
+    uf[slot_a] = slot_b;
+  }
+}
+
+/* The lexicographic order of records */
+static int
+t8_lnodes_less (const t8_gloidx_t * a, const t8_gloidx_t * b, int width)
+{
+  int                 i;
+
+  for (i = 0; i < width; i++) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i];
+    }
+  }
+  return 0;
+}
+
+static int
+t8_lnodes_greater (const t8_gloidx_t * a, const t8_gloidx_t * b, int width)
+{
+  return t8_lnodes_less (b, a, width);
+}
+
+/* Among the points of a coarse face find the one closest to a point x.
+ * The points are the corners of the face and, if allow_hanging is true,
+ * the midpoints of its edges and for quadrilateral faces its center.
+ * Return the number of face corners that define this point and store their
+ * indices in parents. A return value of 1 means that x is a corner of the
+ * coarse face. */
+static int
+t8_lnodes_match_point (const double x[3], int num_face_corners,
+                       const double face_coords[][3], int allow_hanging,
+                       int parents[T8_FOREST_LNODES_MAX_PARENTS])
+{
+  /* The edges of a face given by its corners. A line face uses the first
+   * triangle edge. Quadrilateral faces are in z-order, their diagonals are
+   * no edges. */
+  static const int    tri_edges[3][2] = { {0, 1}, {0, 2}, {1, 2} };
+  static const int    quad_edges[4][2] = { {0, 1}, {2, 3}, {0, 2}, {1, 3} };
+  const int           (*face_edges)[2];
+  double              point[3], dist, best_dist;
+  int                 icorner, iedge, num_edges, num_best, i;
+
+  T8_ASSERT (1 <= num_face_corners
+             && num_face_corners <= T8_FOREST_LNODES_MAX_PARENTS);
+  best_dist = -1;
+  num_best = 0;
+  /* The corners */
+  for (icorner = 0; icorner < num_face_corners; icorner++) {
+    dist = 0;
+    for (i = 0; i < 3; i++) {
+      dist += (x[i] - face_coords[icorner][i])
+        * (x[i] - face_coords[icorner][i]);
+    }
+    if (best_dist < 0 || dist < best_dist) {
+      best_dist = dist;
+      num_best = 1;
+      parents[0] = icorner;
+    }
+  }
+  if (!allow_hanging || num_face_corners == 1) {
+    return num_best;
+  }
+  /* The edge midpoints */
+  if (num_face_corners == 4) {
+    face_edges = quad_edges;
+    num_edges = 4;
+  }
+  else {
+    face_edges = tri_edges;
+    num_edges = num_face_corners == 2 ? 1 : 3;
+  }
+  for (iedge = 0; iedge < num_edges; iedge++) {
+    dist = 0;
+    for (i = 0; i < 3; i++) {
+      point[i] = 0.5 * (face_coords[face_edges[iedge][0]][i]
+                        + face_coords[face_edges[iedge][1]][i]);
+      dist += (x[i] - point[i]) * (x[i] - point[i]);
+    }
+    if (dist < best_dist) {
+      best_dist = dist;
+      num_best = 2;
+      parents[0] = face_edges[iedge][0];
+      parents[1] = face_edges[iedge][1];
+    }
+  }
+  /* The center of a quadrilateral face */
+  if (num_face_corners == 4) {
+    dist = 0;
+    for (i = 0; i < 3; i++) {
+      point[i] = 0.25 * (face_coords[0][i] + face_coords[1][i]
+                         + face_coords[2][i] + face_coords[3][i]);
+      dist += (x[i] - point[i]) * (x[i] - point[i]);
+    }
+    if (dist < best_dist) {
+      num_best = 4;
+      for (icorner = 0; icorner < 4; icorner++) {
+        parents[icorner] = icorner;
+      }
+    }
+  }
+  return num_best;
+}
+
+/* Match the corners at a face of a fine element with a coarse element
+ * of the same or a smaller level. Corners at the same vertex are joined,
+ * corners at a hanging vertex get a constraint. The corners are given by
+ * their element indices and the element corner number of each face corner. */
+static void
+t8_lnodes_match_face (t8_lnodes_context_t * ctx,
+                      t8_locidx_t fine_index, const int *fine_corners,
+                      int num_fine_corners, t8_locidx_t coarse_index,
+                      const int *coarse_corners, int num_coarse_corners,
+                      int allow_hanging)
+{
+  double              coarse_coords[T8_FOREST_LNODES_MAX_PARENTS][3];
+  int                 parents[T8_FOREST_LNODES_MAX_PARENTS];
+  int                 icorner, num_parents, iparent, i;
+  t8_locidx_t         slot, coarse_slot;
+
+  for (icorner = 0; icorner < num_coarse_corners; icorner++) {
+    for (i = 0; i < 3; i++) {
+      coarse_coords[icorner][i] =
+        ctx->coords[coarse_index].coords[coarse_corners[icorner]][i];
+    }
+  }
+  for (icorner = 0; icorner < num_fine_corners; icorner++) {
+    slot = fine_index * T8_LNODES_SLOTS + fine_corners[icorner];
+    num_parents =
+      t8_lnodes_match_point (ctx->coords[fine_index].coords
+                             [fine_corners[icorner]], num_coarse_corners,
+                             coarse_coords, allow_hanging, parents);
+    if (num_parents == 1) {
+      /* The corners are at the same vertex */
+      coarse_slot =
+        coarse_index * T8_LNODES_SLOTS + coarse_corners[parents[0]];
+      t8_lnodes_union (ctx->uf, slot, coarse_slot);
+    }
+    else {
+      /* The vertex is hanging on the coarse face */
+      ctx->num_parents[slot] = num_parents;
+      for (iparent = 0; iparent < num_parents; iparent++) {
+        ctx->parent_slots[slot * T8_FOREST_LNODES_MAX_PARENTS + iparent] =
+          coarse_index * T8_LNODES_SLOTS + coarse_corners[parents[iparent]];
+      }
+    }
+  }
+}
+
+/* Join the corners of all local elements with the corners of their face
+ * neighbors. */
+static void
+t8_lnodes_join_faces (t8_lnodes_context_t * ctx)
+{
+  t8_forest_t         forest = ctx->forest;
+  t8_locidx_t         ltree, num_trees, ielem, num_tree_elements, lelement;
+  t8_locidx_t        *element_indices;
+  t8_element_t       *leaf, **neighbors;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_scratch_mark_t scratch_mark;
+  int                 corners[T8_FOREST_LNODES_MAX_PARENTS];
+  int                 neigh_corners[T8_FOREST_LNODES_MAX_PARENTS];
+  int                 iface, num_faces, num_corners, num_neigh_corners;
+  int                 ineigh, num_neighbors, level, icorner;
+  int                *dual_faces;
+
+  num_trees = t8_forest_get_num_local_trees (forest);
+  lelement = 0;
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltree));
+    num_tree_elements = t8_forest_get_tree_num_elements (forest, ltree);
+    for (ielem = 0; ielem < num_tree_elements; ielem++, lelement++) {
+      leaf = t8_forest_get_element_in_tree (forest, ltree, ielem);
+      level = ts->t8_element_level (leaf);
+      num_faces = ts->t8_element_num_faces (leaf);
+      for (iface = 0; iface < num_faces; iface++) {
+        t8_element_scratch_mark (&scratch_mark);
+        num_neighbors =
+          t8_forest_leaf_face_neighbors_scratch (forest, ltree, leaf, iface,
+                                                 &neighbors, &dual_faces,
+                                                 &element_indices,
+                                                 &neigh_scheme);
+        num_corners =
+          t8_eclass_num_vertices[ts->t8_element_face_class (leaf, iface)];
+        for (icorner = 0; icorner < num_corners; icorner++) {
+          corners[icorner] = ts->t8_element_get_face_corner (leaf, iface,
+                                                             icorner);
+        }
+        for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+          num_neigh_corners =
+            t8_eclass_num_vertices[neigh_scheme->t8_element_face_class
+                                   (neighbors[ineigh], dual_faces[ineigh])];
+          for (icorner = 0; icorner < num_neigh_corners; icorner++) {
+            neigh_corners[icorner] =
+              neigh_scheme->t8_element_get_face_corner (neighbors[ineigh],
+                                                        dual_faces[ineigh],
+                                                        icorner);
+          }
+          if (neigh_scheme->t8_element_level (neighbors[ineigh]) < level) {
+            /* The neighbor is coarser, our corners may be hanging */
+            t8_lnodes_match_face (ctx, lelement, corners, num_corners,
+                                  element_indices[ineigh], neigh_corners,
+                                  num_neigh_corners, 1);
+          }
+          else {
+            /* The neighbor has our level or is finer */
+            t8_lnodes_match_face (ctx, element_indices[ineigh],
+                                  neigh_corners, num_neigh_corners, lelement,
+                                  corners, num_corners,
+                                  neigh_scheme->t8_element_level (neighbors
+                                                                  [ineigh])
+                                  > level);
+          }
+        }
+        t8_element_scratch_release (&scratch_mark);
+      }
+    }
+  }
+  T8_ASSERT (lelement == ctx->num_elements);
+}
+
+/* Give all slots of a vertex the best record among them. The records of
+ * the local elements are sent to the processes that have them as ghosts,
+ * which may improve the record of a vertex there. We repeat this until no
+ * local record changes on any process.
+ * records has one entry of T8_LNODES_SLOTS * width ids for each local and
+ * ghost element. */
+static void
+t8_lnodes_propagate (t8_lnodes_context_t * ctx, sc_array_t * records,
+                     int width, t8_lnodes_better_t better)
+{
+  t8_gloidx_t        *rec = (t8_gloidx_t *) records->array;
+  t8_locidx_t        *best, slot, root;
+  const t8_locidx_t   num_local_slots = ctx->num_elements * T8_LNODES_SLOTS;
+  const size_t        rec_size = width * sizeof (t8_gloidx_t);
+  int                 changed, global_changed, mpiret;
+
+  best = T8_ALLOC (t8_locidx_t, ctx->num_slots);
+  do {
+    if (ctx->forest->ghosts != NULL) {
+      t8_forest_ghost_exchange_data (ctx->forest, records);
+    }
+    for (slot = 0; slot < ctx->num_slots; slot++) {
+      best[slot] = -1;
+    }
+    for (slot = 0; slot < ctx->num_slots; slot++) {
+      root = t8_lnodes_find (ctx->uf, slot);
+      if (best[root] < 0
+          || better (rec + slot * width, rec + best[root] * width, width)) {
+        best[root] = slot;
+      }
+    }
+    changed = 0;
+    for (slot = 0; slot < ctx->num_slots; slot++) {
+      root = best[t8_lnodes_find (ctx->uf, slot)];
+      if (root != slot
+          && memcmp (rec + slot * width, rec + root * width, rec_size)) {
+        memcpy (rec + slot * width, rec + root * width, rec_size);
+        /* Changes of ghost records are overwritten by their owners */
+        changed = changed || slot < num_local_slots;
+      }
+    }
+    mpiret = sc_MPI_Allreduce (&changed, &global_changed, 1, sc_MPI_INT,
+                               sc_MPI_MAX, ctx->forest->mpicomm);
+    SC_CHECK_MPI (mpiret);
+  } while (global_changed);
+  T8_FREE (best);
+}
+
+/* Compute the coordinates of the corners of all local elements and
+ * receive those of the ghosts. */
+static void
+t8_lnodes_compute_coords (t8_lnodes_context_t * ctx, sc_array_t * coords)
+{
+  t8_forest_t         forest = ctx->forest;
+  t8_locidx_t         ltree, num_trees, ielem, num_tree_elements, lelement;
+  t8_element_t       *leaf;
+  t8_eclass_scheme_c *ts;
+  t8_lnodes_corner_coords_t *element_coords;
+  double             *vertices;
+  int                 icorner, num_corners;
+
+  element_coords = (t8_lnodes_corner_coords_t *) coords->array;
+  memset (element_coords, 0, coords->elem_count * coords->elem_size);
+  num_trees = t8_forest_get_num_local_trees (forest);
+  lelement = 0;
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltree));
+    vertices = t8_forest_get_tree_vertices (forest, ltree);
+    SC_CHECK_ABORT (vertices != NULL,
+                    "The vertex numbering needs the tree vertices.\n");
+    num_tree_elements = t8_forest_get_tree_num_elements (forest, ltree);
+    for (ielem = 0; ielem < num_tree_elements; ielem++, lelement++) {
+      leaf = t8_forest_get_element_in_tree (forest, ltree, ielem);
+      num_corners = ts->t8_element_num_corners (leaf);
+      for (icorner = 0; icorner < num_corners; icorner++) {
+        t8_forest_element_coordinate (forest, ltree, leaf, vertices, icorner,
+                                      element_coords[lelement].coords
+                                      [icorner]);
+      }
+    }
+  }
+  if (forest->ghosts != NULL) {
+    t8_forest_ghost_exchange_data (forest, coords);
+  }
+  ctx->coords = (t8_lnodes_corner_coords_t *) coords->array;
+}
+
+t8_forest_lnodes_t *
+t8_forest_lnodes_new (t8_forest_t forest)
+{
+  t8_forest_lnodes_t *lnodes;
+  t8_lnodes_context_t ctx;
+  t8_locidx_t         num_ghosts, slot, lelement, ltree, num_trees;
+  t8_locidx_t         num_tree_elements, ielem, entry, owned;
+  t8_gloidx_t         first_id, offset, *key, *node, *constraint;
+  t8_element_t       *leaf;
+  t8_eclass_scheme_c *ts;
+  sc_array_t          coords, keys, nodes, constraints;
+  int                 icorner, num_corners, iparent, mpiret;
+  int                 created_tables;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  created_tables = t8_forest_leaf_face_neighbors_begin (forest);
+
+  ctx.forest = forest;
+  ctx.num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  ctx.num_slots = (ctx.num_elements + num_ghosts) * T8_LNODES_SLOTS;
+  ctx.uf = T8_ALLOC (t8_locidx_t, ctx.num_slots);
+  ctx.num_parents = T8_ALLOC_ZERO (int8_t, ctx.num_slots);
+  ctx.parent_slots =
+    T8_ALLOC (t8_locidx_t, ctx.num_slots * T8_FOREST_LNODES_MAX_PARENTS);
+  for (slot = 0; slot < ctx.num_slots; slot++) {
+    ctx.uf[slot] = slot;
+  }
+  lnodes = T8_ALLOC_ZERO (t8_forest_lnodes_t, 1);
+
+  /* Count the corners of the local elements */
+  lnodes->num_local_elements = ctx.num_elements;
+  lnodes->element_offsets = T8_ALLOC (t8_locidx_t, ctx.num_elements + 1);
+  num_trees = t8_forest_get_num_local_trees (forest);
+  entry = lelement = 0;
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltree));
+    num_tree_elements = t8_forest_get_tree_num_elements (forest, ltree);
+    for (ielem = 0; ielem < num_tree_elements; ielem++, lelement++) {
+      leaf = t8_forest_get_element_in_tree (forest, ltree, ielem);
+      lnodes->element_offsets[lelement] = entry;
+      entry += ts->t8_element_num_corners (leaf);
+    }
+  }
+  lnodes->element_offsets[ctx.num_elements] = entry;
+
+  sc_array_init_size (&coords, sizeof (t8_lnodes_corner_coords_t),
+                      ctx.num_elements + num_ghosts);
+  t8_lnodes_compute_coords (&ctx, &coords);
+
+  /* Join the corners at the same vertex */
+  t8_lnodes_join_faces (&ctx);
+  sc_array_reset (&coords);
+
+  /* Identify each vertex by its least slot in the global element order */
+  first_id = t8_forest_get_first_local_element_id (forest);
+  sc_array_init_size (&keys, T8_LNODES_SLOTS * sizeof (t8_gloidx_t),
+                      ctx.num_elements + num_ghosts);
+  key = (t8_gloidx_t *) keys.array;
+  for (slot = 0; slot < ctx.num_elements * T8_LNODES_SLOTS; slot++) {
+    key[slot] = first_id * T8_LNODES_SLOTS + slot;
+  }
+  /* The keys of the ghosts are received in the first exchange */
+  t8_lnodes_propagate (&ctx, &keys, 1, t8_lnodes_less);
+
+  /* We own the vertices whose least slot is local and number them */
+  sc_array_init_size (&nodes, T8_LNODES_SLOTS * sizeof (t8_gloidx_t),
+                      ctx.num_elements + num_ghosts);
+  node = (t8_gloidx_t *) nodes.array;
+  for (slot = 0; slot < ctx.num_slots; slot++) {
+    node[slot] = -1;
+  }
+  owned = 0;
+  for (lelement = 0; lelement < ctx.num_elements; lelement++) {
+    num_corners = lnodes->element_offsets[lelement + 1]
+      - lnodes->element_offsets[lelement];
+    for (icorner = 0; icorner < num_corners; icorner++) {
+      slot = lelement * T8_LNODES_SLOTS + icorner;
+      if (key[slot] == first_id * T8_LNODES_SLOTS + slot) {
+        node[slot] = owned++;
+      }
+    }
+  }
+  lnodes->owned_count = owned;
+  offset = owned;
+  mpiret = sc_MPI_Scan (&offset, &lnodes->global_offset, 1, T8_MPI_GLOIDX,
+                        sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  lnodes->global_offset -= owned;
+  mpiret = sc_MPI_Allreduce (&offset, &lnodes->global_num_nodes, 1,
+                             T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  for (slot = 0; slot < ctx.num_elements * T8_LNODES_SLOTS; slot++) {
+    if (node[slot] >= 0) {
+      node[slot] += lnodes->global_offset;
+    }
+  }
+  /* Each vertex has exactly one numbered slot */
+  t8_lnodes_propagate (&ctx, &nodes, 1, t8_lnodes_greater);
+  sc_array_reset (&keys);
+
+  /* Translate the constraints to vertex ids and share them among all
+   * slots of a hanging vertex */
+  sc_array_init_size (&constraints,
+                      T8_LNODES_SLOTS * T8_LNODES_CONSTRAINT_WIDTH *
+                      sizeof (t8_gloidx_t), ctx.num_elements + num_ghosts);
+  constraint = (t8_gloidx_t *) constraints.array;
+  for (slot = 0; slot < ctx.num_slots; slot++) {
+    t8_gloidx_t        *c = constraint + slot * T8_LNODES_CONSTRAINT_WIDTH;
+    int                 num_parents = ctx.num_parents[slot];
+
+    for (iparent = 0; iparent < T8_FOREST_LNODES_MAX_PARENTS; iparent++) {
+      c[1 + iparent] = iparent < num_parents ?
+        node[ctx.parent_slots[slot * T8_FOREST_LNODES_MAX_PARENTS + iparent]]
+        : -1;
+    }
+    /* Sort the parents, such that equal constraints have equal records */
+    std::sort (c + 1, c + 1 + num_parents);
+    c[0] = num_parents > 0 ? num_parents : T8_LNODES_NO_CONSTRAINT;
+  }
+  t8_lnodes_propagate (&ctx, &constraints, T8_LNODES_CONSTRAINT_WIDTH,
+                       t8_lnodes_less);
+
+  /* Store the vertices of the corners of each local element */
+  entry = lnodes->element_offsets[ctx.num_elements];
+  lnodes->element_nodes = T8_ALLOC (t8_gloidx_t, entry);
+  lnodes->num_parents = T8_ALLOC (int8_t, entry);
+  lnodes->parents =
+    T8_ALLOC (t8_gloidx_t, entry * T8_FOREST_LNODES_MAX_PARENTS);
+  for (lelement = 0; lelement < ctx.num_elements; lelement++) {
+    num_corners = lnodes->element_offsets[lelement + 1]
+      - lnodes->element_offsets[lelement];
+    for (icorner = 0; icorner < num_corners; icorner++) {
+      const t8_gloidx_t  *c;
+
+      slot = lelement * T8_LNODES_SLOTS + icorner;
+      entry = lnodes->element_offsets[lelement] + icorner;
+      c = constraint + slot * T8_LNODES_CONSTRAINT_WIDTH;
+      T8_ASSERT (node[slot] >= 0);
+      lnodes->element_nodes[entry] = node[slot];
+      lnodes->num_parents[entry] =
+        c[0] == T8_LNODES_NO_CONSTRAINT ? 0 : (int8_t) c[0];
+      for (iparent = 0; iparent < T8_FOREST_LNODES_MAX_PARENTS; iparent++) {
+        lnodes->parents[entry * T8_FOREST_LNODES_MAX_PARENTS + iparent] =
+          c[1 + iparent];
+      }
+    }
+  }
+
+  sc_array_reset (&nodes);
+  sc_array_reset (&constraints);
+  T8_FREE (ctx.uf);
+  T8_FREE (ctx.num_parents);
+  T8_FREE (ctx.parent_slots);
+  t8_forest_leaf_face_neighbors_end (forest, created_tables);
+  return lnodes;
+}
+
+void
+t8_forest_lnodes_destroy (t8_forest_lnodes_t ** plnodes)
+{
+  t8_forest_lnodes_t *lnodes;
+
+  T8_ASSERT (plnodes != NULL && *plnodes != NULL);
+  lnodes = *plnodes;
+  T8_FREE (lnodes->element_offsets);
+  T8_FREE (lnodes->element_nodes);
+  T8_FREE (lnodes->num_parents);
+  T8_FREE (lnodes->parents);
+  T8_FREE (lnodes);
+  *plnodes = NULL;
+}
@@ -0,0 +1,96 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_lnodes.h
+ * A global numbering of the vertices of the leafs of a forest.
+ *
+ * Each corner of a local leaf is assigned the global id of its vertex.
+ * Corners of different leafs that are at the same vertex, also across tree
+ * and process boundaries, get the same id. A vertex is hanging if it lies
+ * in the interior of a face or an edge of a coarser leaf. For each corner at
+ * a hanging vertex we store the vertices of this coarser face or edge from
+ * which a continuous function is interpolated.
+ *
+ * The vertices are identified with the face connectivity of the leafs.
+ * The corners of two leafs at a common face are matched by comparing their
+ * coordinates among the few candidates of this face, such that no global
+ * tolerance is involved. Each process owns the vertices whose least corner,
+ * ordered by the global element id, is on this process. The ids of the
+ * owned vertices are consecutive and ordered by the process rank.
+ */
+
+#ifndef T8_FOREST_LNODES_H
+#define T8_FOREST_LNODES_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** The maximum number of vertices that a hanging vertex depends on.
+ * This is the number of corners of a quadrilateral face. */
+#define T8_FOREST_LNODES_MAX_PARENTS 4
+
+/** The vertex numbering of the local leafs of a forest. */
+typedef struct t8_forest_lnodes
+{
+  t8_locidx_t         num_local_elements; /**< The number of local leafs. */
+  t8_locidx_t        *element_offsets; /**< For each local leaf the index of its first
+                                            corner in \a element_nodes and
+                                            \a num_parents. The corners of leaf i
+                                            are the entries element_offsets[i]
+                                            to element_offsets[i + 1] - 1.
+                                            Has num_local_elements + 1 entries. */
+  t8_gloidx_t        *element_nodes; /**< The global vertex id of each corner. */
+  int8_t             *num_parents; /**< For each corner 0 if its vertex is not
+                                        hanging, and otherwise the number of
+                                        vertices it depends on, 2 for an edge
+                                        and 4 for a quadrilateral face. */
+  t8_gloidx_t        *parents; /**< For each corner T8_FOREST_LNODES_MAX_PARENTS
+                                    entries. If the vertex of the corner is hanging,
+                                    the first num_parents entries are the global
+                                    ids of the vertices it depends on, in ascending
+                                    order. These may be hanging themselves. */
+  t8_locidx_t         owned_count; /**< The number of vertices owned by this process. */
+  t8_gloidx_t         global_offset; /**< The global id of the first owned vertex. */
+  t8_gloidx_t         global_num_nodes; /**< The number of vertices of the forest. */
+} t8_forest_lnodes_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Number the vertices of the leafs of a forest.
+ * \param [in] forest   A committed and face balanced forest. If it is
+ *                      distributed over several processes, it must have a
+ *                      face ghost layer. The vertices of all local trees
+ *                      must be stored in its cmesh.
+ * \return              The vertex numbering of the local leafs.
+ * This function is collective over the communicator of \a forest.
+ * \note Pyramids are not supported.
+ */
+t8_forest_lnodes_t *t8_forest_lnodes_new (t8_forest_t forest);
+
+/** Free the memory of a vertex numbering.
+ * \param [in,out] plnodes  The numbering. Set to NULL on output.
+ */
+void                t8_forest_lnodes_destroy (t8_forest_lnodes_t ** plnodes);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_LNODES_H */
@@ -0,0 +1,1027 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_locate.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_iterate.h>
+#include <t8_forest/t8_forest_bvh.h>
+#include <t8_forest/t8_forest_partition.h>
+#include <t8_cmesh/t8_cmesh_offset.h>
+#include <t8_element_cxx.hxx>
+#include <t8_element_scratch.hxx>
+#include <t8_threads.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/* The maximum number of Newton iterations to invert a tree map */
+#define T8_LOCATE_MAX_NEWTON 20
+
+/* The number of points per chunk of t8_forest_locator_find_points */
+#define T8_LOCATE_GRAIN 256
+
+struct t8_forest_locator
+{
+  t8_forest_t         forest;
+  double              tolerance;
+  t8_locidx_t         num_trees;
+  t8_forest_tree_bvh_t *global_bvh;     /* If not NULL, the hierarchy over the
+                                           boxes of all global trees */
+};
+
+t8_forest_locator_t
+t8_forest_locator_new (t8_forest_t forest, double tolerance)
+{
+  t8_forest_locator_t locator;
+  t8_locidx_t         itree;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (tolerance >= 0);
+
+  locator = T8_ALLOC_ZERO (struct t8_forest_locator, 1);
+  t8_forest_ref (forest);
+  locator->forest = forest;
+  locator->tolerance = tolerance;
+  locator->num_trees = t8_forest_get_num_local_trees (forest);
+
+  for (itree = 0; itree < locator->num_trees; itree++) {
+    SC_CHECK_ABORT (t8_forest_get_tree_vertices (forest, itree) != NULL,
+                    "Point location needs the vertices of all trees.\n");
+    SC_CHECK_ABORT (t8_forest_get_tree_map (forest, itree) != NULL,
+                    "Point location is supported only for "
+                    "vertices/lines/triangles/tets/quads/prisms/hexes.\n");
+  }
+  /* We search the trees in the bounding volume hierarchy of the forest.
+   * Since the tree maps interpolate the vertices, the trees lie within
+   * their boxes. We build it here, such that finding points does not
+   * modify the forest. */
+  if (forest->tree_bvh == NULL) {
+    t8_forest_tree_bvh_build (forest);
+  }
+  /* The points are found by several threads, which must not create the
+   * elements of implicit trees */
+  t8_forest_materialize (forest);
+  return locator;
+}
+
+void
+t8_forest_locator_destroy (t8_forest_locator_t * plocator)
+{
+  t8_forest_locator_t locator;
+
+  T8_ASSERT (plocator != NULL && *plocator != NULL);
+
+  locator = *plocator;
+  if (locator->global_bvh != NULL) {
+    t8_forest_tree_bvh_free (&locator->global_bvh);
+  }
+  t8_forest_unref (&locator->forest);
+  T8_FREE (locator);
+  *plocator = NULL;
+}
+
+/* Solve the dim x dim system A y = b by Gaussian elimination with
+ * partial pivoting. Return false if A is singular. */
+static int
+t8_forest_locator_solve (double A[3][3], double *b, int dim)
+{
+  int                 i, j, k, pivot;
+  double              factor, tmp;
+
+  for (k = 0; k < dim; k++) {
+    pivot = k;
+    for (i = k + 1; i < dim; i++) {
+      if (fabs (A[i][k]) > fabs (A[pivot][k])) {
+        pivot = i;
+      }
+    }
+    if (A[pivot][k] == 0) {
+      return 0;
+    }
+    if (pivot != k) {
+      for (j = 0; j < dim; j++) {
+        tmp = A[k][j];
+        A[k][j] = A[pivot][j];
+        A[pivot][j] = tmp;
+      }
+      tmp = b[k];
+      b[k] = b[pivot];
+      b[pivot] = tmp;
+    }
+    for (i = k + 1; i < dim; i++) {
+      factor = A[i][k] / A[k][k];
+      for (j = k; j < dim; j++) {
+        A[i][j] -= factor * A[k][j];
+      }
+      b[i] -= factor * b[k];
+    }
+  }
+  for (k = dim - 1; k >= 0; k--) {
+    for (j = k + 1; j < dim; j++) {
+      b[k] -= A[k][j] * b[j];
+    }
+    b[k] /= A[k][k];
+  }
+  return 1;
+}
+
+/* Compute the reference coordinates of a point in a tree. For an affine
+ * tree map with full rank we apply its precomputed left inverse, otherwise
+ * we use the Gauss-Newton method with the Jacobian of the map.
+ * Return false if the point does not lie in the image of the tree map
+ * within dist_tol. The result may lie outside of the reference element. */
+static int
+t8_forest_locator_invert (const t8_forest_tree_map_t * map,
+                          const double *point, double dist_tol, double *ref)
+{
+  const int           dim = map->dim;
+  double              x[3], res[3], J[3][3], A[3][3], b[3];
+  double              step, dist;
+  int                 iter, i, j, k;
+
+  ref[0] = ref[1] = ref[2] = 0;
+  for (i = 0; i < dim; i++) {
+    ref[i] = .5;
+  }
+  if (map->invertible) {
+    /* One step is exact for an affine map */
+    for (j = 0; j < dim; j++) {
+      ref[j] = 0;
+      for (i = 0; i < 3; i++) {
+        ref[j] += map->jacobian_inv[j][i] * (point[i] - map->coeffs[0][i]);
+      }
+    }
+    t8_forest_tree_map_evaluate (map, ref, x);
+    for (i = 0; i < 3; i++) {
+      res[i] = point[i] - x[i];
+    }
+  }
+  else {
+    for (iter = 0; iter < T8_LOCATE_MAX_NEWTON; iter++) {
+      t8_forest_tree_map_evaluate (map, ref, x);
+      for (i = 0; i < 3; i++) {
+        res[i] = point[i] - x[i];
+      }
+      if (dim == 0) {
+        break;
+      }
+      t8_forest_tree_map_jacobian (map, ref, J);
+      /* Solve the normal equations J^T J dref = J^T res */
+      for (j = 0; j < dim; j++) {
+        b[j] = 0;
+        for (i = 0; i < 3; i++) {
+          b[j] += J[i][j] * res[i];
+        }
+        for (k = 0; k < dim; k++) {
+          A[j][k] = 0;
+          for (i = 0; i < 3; i++) {
+            A[j][k] += J[i][j] * J[i][k];
+          }
+        }
+      }
+      if (!t8_forest_locator_solve (A, b, dim)) {
+        /* The tree is degenerate */
+        return 0;
+      }
+      step = 0;
+      for (j = 0; j < dim; j++) {
+        ref[j] += b[j];
+        step = SC_MAX (step, fabs (b[j]));
+      }
+      if (step < 1e-14) {
+        t8_forest_tree_map_evaluate (map, ref, x);
+        for (i = 0; i < 3; i++) {
+          res[i] = point[i] - x[i];
+        }
+        break;
+      }
+    }
+  }
+  dist = sqrt (res[0] * res[0] + res[1] * res[1] + res[2] * res[2]);
+  return dist <= dist_tol;
+}
+
+/* Compute the barycentric coordinates of p with respect to the simplex
+ * with the given corners and check that they are not smaller than -tol. */
+static int
+t8_forest_locator_simplex_contains (const double corners[][3], int dim,
+                                    const double *p, double tol)
+{
+  double              A[3][3], lambda[3], sum;
+  int                 i, j;
+
+  for (i = 0; i < dim; i++) {
+    for (j = 0; j < dim; j++) {
+      A[i][j] = corners[j + 1][i] - corners[0][i];
+    }
+    lambda[i] = p[i] - corners[0][i];
+  }
+  if (!t8_forest_locator_solve (A, lambda, dim)) {
+    return 0;
+  }
+  sum = 0;
+  for (i = 0; i < dim; i++) {
+    if (lambda[i] < -tol) {
+      return 0;
+    }
+    sum += lambda[i];
+  }
+  return sum <= 1 + tol;
+}
+
+/* Check whether an element contains a point given in reference coordinates
+ * of its tree. Within its tree each element is an image of its reference
+ * element under a scaling, a translation and possibly a reflection. */
+static int
+t8_forest_locator_element_contains (t8_eclass_scheme_c * ts,
+                                    t8_eclass_t eclass,
+                                    const t8_element_t * element,
+                                    const double *ref, double tol)
+{
+  double              corners[8][3], len;
+  int                 num_corners, icorner, i, coords[3];
+
+  len = 1. / ts->t8_element_root_len (element);
+  num_corners = ts->t8_element_num_corners (element);
+  for (icorner = 0; icorner < num_corners; icorner++) {
+    coords[0] = coords[1] = coords[2] = 0;
+    ts->t8_element_vertex_coords (element, icorner, coords);
+    for (i = 0; i < 3; i++) {
+      corners[icorner][i] = len * coords[i];
+    }
+  }
+  switch (eclass) {
+  case T8_ECLASS_VERTEX:
+    return 1;
+  case T8_ECLASS_TRIANGLE:
+    return t8_forest_locator_simplex_contains (corners, 2, ref, tol);
+  case T8_ECLASS_TET:
+    return t8_forest_locator_simplex_contains (corners, 3, ref, tol);
+  case T8_ECLASS_PRISM:
+    /* A triangle times an interval */
+    return ref[2] >= SC_MIN (corners[0][2], corners[3][2]) - tol
+      && ref[2] <= SC_MAX (corners[0][2], corners[3][2]) + tol
+      && t8_forest_locator_simplex_contains (corners, 2, ref, tol);
+  default:
+    /* Lines, quads and hexes are boxes */
+    for (i = 0; i < t8_eclass_to_dimension[eclass]; i++) {
+      if (ref[i] < SC_MIN (corners[0][i], corners[num_corners - 1][i]) - tol
+          || ref[i] > SC_MAX (corners[0][i],
+                              corners[num_corners - 1][i]) + tol) {
+        return 0;
+      }
+    }
+    return 1;
+  }
+}
+
+/* Descend in a local tree from the nearest common ancestor of its leafs to
+ * the leaf that contains the reference coordinates ref.
+ * Return its local element index or -1. */
+static t8_locidx_t
+t8_forest_locator_find_in_tree (t8_forest_locator_t locator,
+                                t8_locidx_t ltreeid, const double *ref)
+{
+  t8_forest_t         forest = locator->forest;
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+  t8_element_array_t *leafs, views[2];
+  t8_element_t       *element, *leaf, **children;
+  t8_element_scratch_mark_t scratch_mark;
+  t8_locidx_t         offset, result = -1;
+  size_t              count, *split_offsets;
+  int                 num_children, ichild, found, iview = 0;
+
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  leafs = t8_forest_tree_get_leafs (forest, ltreeid);
+  count = t8_element_array_get_count (leafs);
+  if (count == 0) {
+    return -1;
+  }
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (ts, 1, &element);
+  ts->t8_element_nca (t8_element_array_index_locidx (leafs, 0),
+                      t8_element_array_index_locidx (leafs, count - 1),
+                      element);
+  offset = 0;
+  if (t8_forest_locator_element_contains (ts, eclass, element, ref,
+                                          locator->tolerance)) {
+    for (;;) {
+      leaf = t8_element_array_index_locidx (leafs, 0);
+      if (count == 1
+          && ts->t8_element_level (leaf) == ts->t8_element_level (element)) {
+        /* We arrived at the leaf */
+        result = t8_forest_get_tree_element_offset (forest, ltreeid) + offset;
+        break;
+      }
+      /* Continue with the first child that contains the point and
+       * has local leafs */
+      num_children = ts->t8_element_num_children (element);
+      children = (t8_element_t **)
+        t8_element_scratch_alloc (num_children * sizeof (t8_element_t *));
+      t8_element_scratch_get (ts, num_children, children);
+      split_offsets = (size_t *)
+        t8_element_scratch_alloc ((num_children + 1) * sizeof (size_t));
+      ts->t8_element_children (element, num_children, children);
+      t8_forest_split_array (element, leafs, split_offsets);
+      found = 0;
+      for (ichild = 0; ichild < num_children && !found; ichild++) {
+        if (split_offsets[ichild] < split_offsets[ichild + 1]
+            && t8_forest_locator_element_contains (ts, eclass,
+                                                   children[ichild], ref,
+                                                   locator->tolerance)) {
+          found = 1;
+          offset += split_offsets[ichild];
+          count = split_offsets[ichild + 1] - split_offsets[ichild];
+          /* We alternate between two views, since a view cannot be
+           * initialized from itself */
+          t8_element_array_init_view (&views[iview], leafs,
+                                      split_offsets[ichild], count);
+          leafs = &views[iview];
+          iview = 1 - iview;
+          element = children[ichild];
+        }
+      }
+      if (!found) {
+        /* The leaf that contains the point is not local */
+        break;
+      }
+    }
+  }
+  t8_element_scratch_release (&scratch_mark);
+  return result;
+}
+
+/* The state of a point search in the tree hierarchy */
+typedef struct
+{
+  t8_forest_locator_t locator;
+  const double       *point;
+  t8_locidx_t         ltreeid;
+  t8_locidx_t         lelement;
+  double              ref[3];
+} t8_forest_locator_search_t;
+
+/* Look for the point in a tree whose box contains it.
+ * Return false to stop the search if a leaf is found. */
+static int
+t8_forest_locator_search_tree (t8_forest_t forest, t8_locidx_t ltreeid,
+                               const double tree_box[6], void *user_data)
+{
+  t8_forest_locator_search_t *search =
+    (t8_forest_locator_search_t *) user_data;
+  double              tol;
+
+  if (ltreeid >= search->locator->num_trees) {
+    /* Ghost trees have no local leafs */
+    return 1;
+  }
+  tol = search->locator->tolerance
+    * sqrt ((tree_box[3] - tree_box[0]) * (tree_box[3] - tree_box[0])
+            + (tree_box[4] - tree_box[1]) * (tree_box[4] - tree_box[1])
+            + (tree_box[5] - tree_box[2]) * (tree_box[5] - tree_box[2]));
+  if (!t8_forest_locator_invert (t8_forest_get_tree_map (forest, ltreeid),
+                                 search->point, tol, search->ref)) {
+    return 1;
+  }
+  search->lelement =
+    t8_forest_locator_find_in_tree (search->locator, ltreeid, search->ref);
+  if (search->lelement >= 0) {
+    search->ltreeid = ltreeid;
+    return 0;
+  }
+  return 1;
+}
+
+/* Descend in a local or ghost tree from the root to the first element that
+ * contains the reference coordinates ref and has a unique owner.
+ * Return this owner or -1 if the root does not contain ref. */
+static int
+t8_forest_locator_owner_in_tree (t8_forest_locator_t locator,
+                                 t8_locidx_t ltreeid, const double *ref)
+{
+  t8_forest_t         forest = locator->forest;
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *elements[2], *element, *child, *tmp;
+  t8_element_scratch_mark_t scratch_mark;
+  t8_gloidx_t         gtreeid;
+  int                 lower, upper, owner = -1;
+  int                 level, maxlevel, num_children, ichild, found;
+
+  if (ltreeid < locator->num_trees) {
+    gtreeid = t8_forest_global_tree_id (forest, ltreeid);
+    eclass = t8_forest_get_tree_class (forest, ltreeid);
+  }
+  else {
+    gtreeid = t8_forest_ghost_get_global_treeid (forest,
+                                                 ltreeid -
+                                                 locator->num_trees);
+    eclass = t8_forest_ghost_get_tree_class (forest,
+                                             ltreeid - locator->num_trees);
+  }
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  t8_element_scratch_mark (&scratch_mark);
+  t8_element_scratch_get (ts, 2, elements);
+  element = elements[0];
+  child = elements[1];
+  ts->t8_element_set_linear_id (element, 0, 0);
+  if (t8_forest_locator_element_contains (ts, eclass, element, ref,
+                                          locator->tolerance)) {
+    lower = 0;
+    upper = forest->mpisize - 1;
+    maxlevel = ts->t8_element_maxlevel ();
+    for (level = 0;; level++) {
+      t8_forest_element_owners_bounds (forest, gtreeid, element, eclass,
+                                       &lower, &upper);
+      if (lower >= upper || level == maxlevel) {
+        break;
+      }
+      num_children = ts->t8_element_num_children (element);
+      found = 0;
+      for (ichild = 0; ichild < num_children && !found; ichild++) {
+        ts->t8_element_child (element, ichild, child);
+        if (t8_forest_locator_element_contains (ts, eclass, child, ref,
+                                                locator->tolerance)) {
+          found = 1;
+          /* Continue with the child and reuse the parent's memory */
+          tmp = element;
+          element = child;
+          child = tmp;
+        }
+      }
+      if (!found) {
+        /* Only possible for points outside of the tolerance of all
+         * children, we stop at the current element */
+        break;
+      }
+    }
+    owner = lower >= upper ? lower
+      : t8_forest_element_find_owner (forest, gtreeid, element, eclass);
+  }
+  t8_element_scratch_release (&scratch_mark);
+  return owner;
+}
+
+/* The state of an owner search in the tree hierarchy */
+typedef struct
+{
+  t8_forest_locator_t locator;
+  const double       *point;
+  int                 owner;
+} t8_forest_locator_owner_search_t;
+
+/* Look for the owner of the point in a tree whose box contains it.
+ * Return false to stop the search if an owner is found. */
+static int
+t8_forest_locator_search_owner (t8_forest_t forest, t8_locidx_t ltreeid,
+                                const double tree_box[6], void *user_data)
+{
+  t8_forest_locator_owner_search_t *search =
+    (t8_forest_locator_owner_search_t *) user_data;
+  const t8_forest_tree_map_t *map;
+  double              tol, ref[3];
+
+  map = t8_forest_get_tree_map (forest, ltreeid);
+  if (map == NULL) {
+    /* A ghost tree of a class without a map */
+    return 1;
+  }
+  tol = search->locator->tolerance
+    * sqrt ((tree_box[3] - tree_box[0]) * (tree_box[3] - tree_box[0])
+            + (tree_box[4] - tree_box[1]) * (tree_box[4] - tree_box[1])
+            + (tree_box[5] - tree_box[2]) * (tree_box[5] - tree_box[2]));
+  if (!t8_forest_locator_invert (map, search->point, tol, ref)) {
+    return 1;
+  }
+  search->owner =
+    t8_forest_locator_owner_in_tree (search->locator, ltreeid, ref);
+  return search->owner < 0;
+}
+
+int
+t8_forest_locator_find_owner (t8_forest_locator_t locator,
+                              const double point[3])
+{
+  t8_forest_locator_owner_search_t search;
+
+  T8_ASSERT (locator != NULL);
+
+  search.locator = locator;
+  search.point = point;
+  search.owner = -1;
+  t8_forest_tree_bvh_search_point (locator->forest, point,
+                                   locator->tolerance,
+                                   t8_forest_locator_search_owner, &search);
+  return search.owner;
+}
+
+t8_forest_t
+t8_forest_locator_get_forest (t8_forest_locator_t locator)
+{
+  T8_ASSERT (locator != NULL);
+  return locator->forest;
+}
+
+t8_locidx_t
+t8_forest_locator_find (t8_forest_locator_t locator, const double point[3],
+                        t8_locidx_t * pltreeid, double ref_coords[3])
+{
+  t8_forest_locator_search_t search;
+  int                 i;
+
+  T8_ASSERT (locator != NULL);
+
+  search.locator = locator;
+  search.point = point;
+  search.ltreeid = -1;
+  search.lelement = -1;
+  /* Search the hierarchy for the trees whose boxes contain the point */
+  if (t8_forest_tree_bvh_search_point (locator->forest, point,
+                                       locator->tolerance,
+                                       t8_forest_locator_search_tree,
+                                       &search)) {
+    return -1;
+  }
+  if (pltreeid != NULL) {
+    *pltreeid = search.ltreeid;
+  }
+  if (ref_coords != NULL) {
+    for (i = 0; i < 3; i++) {
+      ref_coords[i] = search.ref[i];
+    }
+  }
+  return search.lelement;
+}
+
+/* The arguments of t8_forest_locator_find_points */
+typedef struct
+{
+  t8_forest_locator_t locator;
+  const double       *points;
+  t8_locidx_t        *element_indices;
+  double             *ref_coords;       /* If not NULL, 3 doubles per point */
+} t8_forest_locator_points_t;
+
+/* Locate a chunk of the points */
+static void
+t8_forest_locator_find_range (size_t begin, size_t end, int thread_id,
+                              void *user_data)
+{
+  t8_forest_locator_points_t *data =
+    (t8_forest_locator_points_t *) user_data;
+  size_t              ipoint;
+
+  for (ipoint = begin; ipoint < end; ipoint++) {
+    data->element_indices[ipoint] =
+      t8_forest_locator_find (data->locator, data->points + 3 * ipoint,
+                              NULL, data->ref_coords != NULL ?
+                              data->ref_coords + 3 * ipoint : NULL);
+  }
+}
+
+/* Locate a set of points in the local leafs and store their reference
+ * coordinates if ref_coords is not NULL */
+static void
+t8_forest_locator_find_points_ext (t8_forest_locator_t locator,
+                                   size_t num_points, const double *points,
+                                   t8_locidx_t * element_indices,
+                                   double *ref_coords)
+{
+  t8_forest_locator_points_t data;
+
+  T8_ASSERT (locator != NULL);
+
+  data.locator = locator;
+  data.points = points;
+  data.element_indices = element_indices;
+  data.ref_coords = ref_coords;
+  t8_parallel_for (0, num_points, T8_LOCATE_GRAIN,
+                   t8_forest_locator_find_range, &data);
+}
+
+void
+t8_forest_locator_find_points (t8_forest_locator_t locator,
+                               size_t num_points, const double *points,
+                               t8_locidx_t * element_indices)
+{
+  t8_forest_locator_find_points_ext (locator, num_points, points,
+                                     element_indices, NULL);
+}
+
+/* The bounding box of a local tree, sent to all processes */
+typedef struct
+{
+  double              box[6];
+  t8_gloidx_t         gtreeid;
+} t8_forest_locator_tree_box_t;
+
+/* Gather the bounding boxes of the local trees of all processes and build
+ * the hierarchy over them. Since a global tree id is a box index of the
+ * hierarchy, all global trees must fit into t8_locidx_t. */
+static void
+t8_forest_locator_build_global (t8_forest_locator_t locator)
+{
+  t8_forest_t         forest = locator->forest;
+  t8_forest_locator_tree_box_t *local_boxes, *all_boxes;
+  t8_gloidx_t         global_num_trees;
+  t8_locidx_t         itree;
+  double             *boxes;
+  int                *counts, *displs, num_local, iproc, i, mpiret;
+  size_t              num_all, ibox;
+
+  T8_ASSERT (locator->global_bvh == NULL);
+  T8_ASSERT (forest->tree_bvh != NULL);
+
+  /* The owner search and the global element ids need the partition
+   * tables. They are kept with the forest. */
+  (void) t8_forest_partition_tables_require (forest, T8_FOREST_TABLE_ALL);
+
+  global_num_trees = t8_forest_get_num_global_trees (forest);
+  SC_CHECK_ABORT (global_num_trees <= (t8_gloidx_t) T8_LOCIDX_MAX,
+                  "Too many trees for the global point location.\n");
+
+  /* The boxes of the local trees with vertices */
+  local_boxes = T8_ALLOC (t8_forest_locator_tree_box_t,
+                          SC_MAX (locator->num_trees, 1));
+  num_local = 0;
+  for (itree = 0; itree < locator->num_trees; itree++) {
+    const double       *box = forest->tree_bvh->tree_boxes + 6 * itree;
+
+    if (box[0] > box[3]) {
+      continue;
+    }
+    memcpy (local_boxes[num_local].box, box, 6 * sizeof (double));
+    local_boxes[num_local].gtreeid = t8_forest_global_tree_id (forest, itree);
+    num_local++;
+  }
+
+  /* Gather the boxes of all processes */
+  counts = T8_ALLOC (int, forest->mpisize);
+  displs = T8_ALLOC (int, forest->mpisize + 1);
+  num_local *= sizeof (t8_forest_locator_tree_box_t);
+  mpiret = sc_MPI_Allgather (&num_local, 1, sc_MPI_INT, counts, 1,
+                             sc_MPI_INT, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  displs[0] = 0;
+  for (iproc = 0; iproc < forest->mpisize; iproc++) {
+    displs[iproc + 1] = displs[iproc] + counts[iproc];
+  }
+  num_all = displs[forest->mpisize] / sizeof (t8_forest_locator_tree_box_t);
+  all_boxes = T8_ALLOC (t8_forest_locator_tree_box_t, SC_MAX (num_all, 1));
+  mpiret = sc_MPI_Allgatherv (local_boxes, num_local, sc_MPI_BYTE, all_boxes,
+                              counts, displs, sc_MPI_BYTE, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (local_boxes);
+  T8_FREE (counts);
+  T8_FREE (displs);
+
+  /* A tree shared by several processes has the same box on each of them */
+  boxes = T8_ALLOC (double, 6 * SC_MAX (global_num_trees, 1));
+  for (itree = 0; itree < (t8_locidx_t) global_num_trees; itree++) {
+    for (i = 0; i < 3; i++) {
+      boxes[6 * itree + i] = HUGE_VAL;
+      boxes[6 * itree + 3 + i] = -HUGE_VAL;
+    }
+  }
+  for (ibox = 0; ibox < num_all; ibox++) {
+    T8_ASSERT (0 <= all_boxes[ibox].gtreeid
+               && all_boxes[ibox].gtreeid < global_num_trees);
+    memcpy (boxes + 6 * all_boxes[ibox].gtreeid, all_boxes[ibox].box,
+            6 * sizeof (double));
+  }
+  T8_FREE (all_boxes);
+  locator->global_bvh =
+    t8_forest_tree_bvh_new_boxes ((t8_locidx_t) global_num_trees, boxes);
+}
+
+/* Append each global tree to the array given as user data */
+static int
+t8_forest_locator_push_tree (t8_forest_t forest, t8_locidx_t gtreeid,
+                             const double tree_box[6], void *user_data)
+{
+  *(t8_locidx_t *) sc_array_push ((sc_array_t *) user_data) = gtreeid;
+  return 1;
+}
+
+/* A point that is sent to another process */
+typedef struct
+{
+  int                 rank;
+  size_t              index;
+} t8_forest_locator_send_t;
+
+/* Sort the sent points by their target and keep their order */
+static int
+t8_forest_locator_send_compare (const void *a, const void *b)
+{
+  const t8_forest_locator_send_t *sa = (const t8_forest_locator_send_t *) a;
+  const t8_forest_locator_send_t *sb = (const t8_forest_locator_send_t *) b;
+
+  if (sa->rank != sb->rank) {
+    return sa->rank < sb->rank ? -1 : 1;
+  }
+  return sa->index < sb->index ? -1 : sa->index > sb->index;
+}
+
+/* The header of a query or reply message */
+typedef struct
+{
+  int64_t             rank;             /* The sending process */
+  int64_t             count;            /* The number of records that follow */
+} t8_forest_locator_header_t;
+
+/* A point of a query message */
+typedef struct
+{
+  double              point[3];
+  int64_t             index;            /* The point index on the sender */
+} t8_forest_locator_query_t;
+
+/* A located point of a reply message */
+typedef struct
+{
+  int64_t             index;            /* The point index on the receiver */
+  int64_t             element_id;
+  double              ref_coords[3];
+} t8_forest_locator_reply_t;
+
+/* Pack the records of the points that are sent, sorted by target, into one
+ * message per target with a header each */
+static void
+t8_forest_locator_pack (sc_array_t * sends, int mpirank,
+                        size_t record_size, const char *records,
+                        int *num_targets, int **targets,
+                        char **send_buffer, size_t **send_offsets)
+{
+  t8_forest_locator_send_t *send;
+  t8_forest_locator_header_t *header = NULL;
+  size_t              isend, num_sends, offset;
+  int                 num_messages;
+
+  num_sends = sends->elem_count;
+  /* Count the messages to allocate the buffer */
+  num_messages = 0;
+  for (isend = 0; isend < num_sends; isend++) {
+    send = (t8_forest_locator_send_t *) sc_array_index (sends, isend);
+    if (isend == 0 || send[-1].rank != send->rank) {
+      num_messages++;
+    }
+  }
+  *targets = T8_ALLOC (int, SC_MAX (num_messages, 1));
+  *send_offsets = T8_ALLOC (size_t, num_messages + 1);
+  *send_buffer = T8_ALLOC (char, SC_MAX (num_messages
+                                         * sizeof (*header)
+                                         + num_sends * record_size, 1));
+  *num_targets = 0;
+  offset = 0;
+  for (isend = 0; isend < num_sends; isend++) {
+    send = (t8_forest_locator_send_t *) sc_array_index (sends, isend);
+    if (isend == 0 || send[-1].rank != send->rank) {
+      /* Start a message with its header */
+      (*targets)[*num_targets] = send->rank;
+      (*send_offsets)[*num_targets] = offset;
+      (*num_targets)++;
+      header = (t8_forest_locator_header_t *) (*send_buffer + offset);
+      header->rank = mpirank;
+      header->count = 0;
+      offset += sizeof (*header);
+    }
+    memcpy (*send_buffer + offset, records + send->index * record_size,
+            record_size);
+    header->count++;
+    offset += record_size;
+  }
+  (*send_offsets)[*num_targets] = offset;
+  T8_ASSERT (*num_targets == num_messages);
+}
+
+void
+t8_forest_locator_find_points_global (t8_forest_locator_t locator,
+                                      size_t num_points,
+                                      const double *points,
+                                      t8_forest_locate_result_t * results)
+{
+  t8_forest_t         forest;
+  t8_forest_locator_send_t *send;
+  t8_forest_locator_header_t header;
+  t8_forest_locator_query_t *queries;
+  t8_forest_locator_reply_t *replies;
+  t8_gloidx_t         first_element, *tree_offsets;
+  t8_locidx_t        *indices, gtreeid;
+  sc_array_t          sends, trees, recv_buffer;
+  size_t              ipoint, itree, isend, offset, num_recv, irecv;
+  size_t             *send_offsets;
+  size_t              first_send;
+  double             *ref_coords, *recv_points;
+  char               *send_buffer;
+  int                *targets, num_targets, mpirank, mpisize, owner;
+  int                 rank, some_owner;
+  int64_t             irecord;
+
+  T8_ASSERT (locator != NULL);
+  T8_ASSERT (num_points == 0 || (points != NULL && results != NULL));
+
+  forest = locator->forest;
+  mpirank = forest->mpirank;
+  mpisize = forest->mpisize;
+  if (locator->global_bvh == NULL) {
+    t8_forest_locator_build_global (locator);
+  }
+  first_element = t8_forest_get_first_local_element_id (forest);
+  tree_offsets = t8_shmem_array_get_gloidx_array (forest->tree_offsets);
+
+  /* Locate the points in the local leafs */
+  indices = T8_ALLOC (t8_locidx_t, SC_MAX (num_points, 1));
+  ref_coords = T8_ALLOC (double, 3 * SC_MAX (num_points, 1));
+  t8_forest_locator_find_points_ext (locator, num_points, points, indices,
+                                     ref_coords);
+
+  /* Route the other points to the owner found in the local and ghost
+   * trees, or else to all other owners of the global trees whose boxes
+   * contain them */
+  sc_array_init (&sends, sizeof (t8_forest_locator_send_t));
+  sc_array_init (&trees, sizeof (t8_locidx_t));
+  for (ipoint = 0; ipoint < num_points; ipoint++) {
+    results[ipoint].rank = -1;
+    results[ipoint].element_id = -1;
+    if (indices[ipoint] >= 0) {
+      results[ipoint].rank = mpirank;
+      results[ipoint].element_id = first_element + indices[ipoint];
+      memcpy (results[ipoint].ref_coords, ref_coords + 3 * ipoint,
+              3 * sizeof (double));
+      continue;
+    }
+    memset (results[ipoint].ref_coords, 0, 3 * sizeof (double));
+    owner = t8_forest_locator_find_owner (locator, points + 3 * ipoint);
+    if (owner >= 0 && owner != mpirank) {
+      send = (t8_forest_locator_send_t *) sc_array_push (&sends);
+      send->rank = owner;
+      send->index = ipoint;
+      continue;
+    }
+    first_send = sends.elem_count;
+    sc_array_truncate (&trees);
+    (void) t8_forest_tree_bvh_search_point_ext (locator->global_bvh, forest,
+                                                points + 3 * ipoint,
+                                                locator->tolerance,
+                                                t8_forest_locator_push_tree,
+                                                &trees);
+    for (itree = 0; itree < trees.elem_count; itree++) {
+      gtreeid = *(t8_locidx_t *) sc_array_index (&trees, itree);
+      some_owner = -1;
+      for (rank = t8_offset_first_owner_of_tree (mpisize, gtreeid,
+                                                 tree_offsets, &some_owner);
+           rank >= 0;
+           rank = t8_offset_next_owner_of_tree (mpisize, gtreeid,
+                                                tree_offsets, rank)) {
+        if (rank == mpirank) {
+          continue;
+        }
+        for (isend = first_send; isend < sends.elem_count; isend++) {
+          if (((t8_forest_locator_send_t *)
+               sc_array_index (&sends, isend))->rank == rank) {
+            break;
+          }
+        }
+        if (isend == sends.elem_count) {
+          send = (t8_forest_locator_send_t *) sc_array_push (&sends);
+          send->rank = rank;
+          send->index = ipoint;
+        }
+      }
+    }
+  }
+  sc_array_reset (&trees);
+  T8_FREE (indices);
+  T8_FREE (ref_coords);
+
+  /* Send the queries */
+  queries = T8_ALLOC (t8_forest_locator_query_t, SC_MAX (num_points, 1));
+  for (ipoint = 0; ipoint < num_points; ipoint++) {
+    memcpy (queries[ipoint].point, points + 3 * ipoint, 3 * sizeof (double));
+    queries[ipoint].index = ipoint;
+  }
+  sc_array_sort (&sends, t8_forest_locator_send_compare);
+  t8_forest_locator_pack (&sends, mpirank, sizeof (*queries),
+                          (const char *) queries, &num_targets, &targets,
+                          &send_buffer, &send_offsets);
+  sc_array_reset (&sends);
+  T8_FREE (queries);
+  sc_array_init (&recv_buffer, 1);
+  t8_forest_exchange_sparse (forest->mpicomm, T8_MPI_LOCATE_FOREST,
+                             num_targets, targets, send_buffer, send_offsets,
+                             &recv_buffer);
+  T8_FREE (send_buffer);
+  T8_FREE (targets);
+  T8_FREE (send_offsets);
+
+  /* Collect the received points and locate them all at once */
+  num_recv = 0;
+  for (offset = 0; offset < recv_buffer.elem_count;) {
+    memcpy (&header, recv_buffer.array + offset, sizeof (header));
+    offset += sizeof (header) + header.count * sizeof (*queries);
+    num_recv += header.count;
+  }
+  T8_ASSERT (offset == recv_buffer.elem_count);
+  queries = T8_ALLOC (t8_forest_locator_query_t, SC_MAX (num_recv, 1));
+  sc_array_init (&sends, sizeof (t8_forest_locator_send_t));
+  irecv = 0;
+  for (offset = 0; offset < recv_buffer.elem_count;) {
+    memcpy (&header, recv_buffer.array + offset, sizeof (header));
+    offset += sizeof (header);
+    memcpy (queries + irecv, recv_buffer.array + offset,
+            header.count * sizeof (*queries));
+    offset += header.count * sizeof (*queries);
+    for (irecord = 0; irecord < header.count; irecord++, irecv++) {
+      send = (t8_forest_locator_send_t *) sc_array_push (&sends);
+      send->rank = (int) header.rank;
+      send->index = irecv;
+    }
+  }
+  sc_array_reset (&recv_buffer);
+  recv_points = T8_ALLOC (double, 3 * SC_MAX (num_recv, 1));
+  for (irecv = 0; irecv < num_recv; irecv++) {
+    memcpy (recv_points + 3 * irecv, queries[irecv].point,
+            3 * sizeof (double));
+  }
+  indices = T8_ALLOC (t8_locidx_t, SC_MAX (num_recv, 1));
+  ref_coords = T8_ALLOC (double, 3 * SC_MAX (num_recv, 1));
+  t8_forest_locator_find_points_ext (locator, num_recv, recv_points,
+                                     indices, ref_coords);
+  T8_FREE (recv_points);
+
+  /* Reply with the points that we found, in the order of the senders */
+  replies = T8_ALLOC (t8_forest_locator_reply_t, SC_MAX (num_recv, 1));
+  for (isend = 0, irecv = 0; irecv < num_recv; irecv++) {
+    if (indices[irecv] < 0) {
+      continue;
+    }
+    replies[irecv].index = queries[irecv].index;
+    replies[irecv].element_id = first_element + indices[irecv];
+    memcpy (replies[irecv].ref_coords, ref_coords + 3 * irecv,
+            3 * sizeof (double));
+    *(t8_forest_locator_send_t *) sc_array_index (&sends, isend++) =
+      *(t8_forest_locator_send_t *) sc_array_index (&sends, irecv);
+  }
+  sc_array_resize (&sends, isend);
+  T8_FREE (queries);
+  T8_FREE (ref_coords);
+  T8_FREE (indices);
+  t8_forest_locator_pack (&sends, mpirank, sizeof (*replies),
+                          (const char *) replies, &num_targets, &targets,
+                          &send_buffer, &send_offsets);
+  sc_array_reset (&sends);
+  T8_FREE (replies);
+  sc_array_init (&recv_buffer, 1);
+  t8_forest_exchange_sparse (forest->mpicomm, T8_MPI_LOCATE_REPLY_FOREST,
+                             num_targets, targets, send_buffer, send_offsets,
+                             &recv_buffer);
+  T8_FREE (send_buffer);
+  T8_FREE (targets);
+  T8_FREE (send_offsets);
+
+  /* The replies arrive in the order of their senders, we keep the first
+   * reply for each point */
+  for (offset = 0; offset < recv_buffer.elem_count;) {
+    t8_forest_locator_reply_t reply;
+
+    memcpy (&header, recv_buffer.array + offset, sizeof (header));
+    offset += sizeof (header);
+    for (irecord = 0; irecord < header.count; irecord++) {
+      memcpy (&reply, recv_buffer.array + offset, sizeof (reply));
+      offset += sizeof (reply);
+      T8_ASSERT (0 <= reply.index && (size_t) reply.index < num_points);
+      if (results[reply.index].rank < 0) {
+        results[reply.index].rank = (int) header.rank;
+        results[reply.index].element_id = reply.element_id;
+        memcpy (results[reply.index].ref_coords, reply.ref_coords,
+                3 * sizeof (double));
+      }
+    }
+  }
+  sc_array_reset (&recv_buffer);
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,170 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_locate.h
+ * Find the local leaf of a forest that contains a given point.
+ *
+ * A point locator uses the bounding volume hierarchy over the trees of the
+ * forest, see \ref t8_forest_bvh.h. To locate a point we search the
+ * hierarchy for the local trees whose box contains the point, invert
+ * the map of each such tree to obtain the reference coordinates of the
+ * point and descend from the root of the tree to the leaf that contains
+ * these reference coordinates.
+ * Points that are known to any process can be located collectively with
+ * \ref t8_forest_locator_find_points_global, which sends each point to the
+ * processes that may own its leaf.
+ */
+
+#ifndef T8_FOREST_LOCATE_H
+#define T8_FOREST_LOCATE_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** Opaque pointer to a point locator. */
+typedef struct t8_forest_locator *t8_forest_locator_t;
+
+/** The leaf that contains a point, as found by
+ * \ref t8_forest_locator_find_points_global. */
+typedef struct t8_forest_locate_result
+{
+  int                 rank;             /**< The process that owns the leaf, -1 if the point
+                                             was not found. */
+  t8_gloidx_t         element_id;       /**< The global index of the leaf. */
+  double              ref_coords[3];    /**< The reference coordinates of the point in the
+                                             tree of the leaf. */
+} t8_forest_locate_result_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Create a point locator for the local leafs of a forest.
+ * \param [in]  forest    A committed forest. The vertices of all local trees
+ *                        must be stored in its cmesh. The locator keeps a
+ *                        reference of \a forest.
+ * \param [in]  tolerance A relative tolerance, for example 1e-10.
+ *                        A point is found in a tree if its distance to the
+ *                        tree is smaller than \a tolerance times the diameter
+ *                        of the tree's bounding box, and in a leaf if its
+ *                        reference coordinates lie within \a tolerance of the leaf.
+ * \return                The new locator.
+ * \note Pyramids are not supported.
+ */
+t8_forest_locator_t t8_forest_locator_new (t8_forest_t forest,
+                                           double tolerance);
+
+/** Destroy a point locator and release its reference of the forest.
+ * \param [in,out] plocator  The locator. Set to NULL on output.
+ */
+void                t8_forest_locator_destroy (t8_forest_locator_t *
+                                               plocator);
+
+/** Find the local leaf that contains a point.
+ * \param [in]  locator     A point locator.
+ * \param [in]  point       The x, y and z coordinates of the point.
+ * \param [out] pltreeid    If not NULL and a leaf is found, on output the
+ *                          local tree of the leaf.
+ * \param [out] ref_coords  If not NULL and a leaf is found, on output the
+ *                          reference coordinates of the point in this tree.
+ *                          Must have room for 3 doubles.
+ * \return                  The local index of a leaf that contains \a point,
+ *                          or -1 if no local leaf contains it.
+ * If \a point lies on the boundary of several leafs, one of them is returned.
+ * This function does not allocate and can be called by several threads.
+ */
+t8_locidx_t         t8_forest_locator_find (t8_forest_locator_t locator,
+                                            const double point[3],
+                                            t8_locidx_t * pltreeid,
+                                            double ref_coords[3]);
+
+/** Find the process that owns the leaf that contains a point.
+ * The point is searched in the local and the ghost trees of the forest.
+ * Within a tree we descend from the root to the first element that
+ * contains the point and lies on a single process, using the global first
+ * descendants of the processes.
+ * \param [in]  locator     A point locator.
+ * \param [in]  point       The x, y and z coordinates of the point.
+ * \return                  The rank of the process, or -1 if the point lies
+ *                          in none of the local and ghost trees.
+ * If \a point lies on the boundary of several leafs, the owner of one of
+ * them is returned. Thus, the owner may be this process even if
+ * \ref t8_forest_locator_find does not find the point.
+ * This function does not allocate and can be called by several threads.
+ */
+int                 t8_forest_locator_find_owner (t8_forest_locator_t
+                                                  locator,
+                                                  const double point[3]);
+
+/** Return the forest of a point locator.
+ * \param [in]  locator     A point locator.
+ * \return                  The forest. The locator keeps its reference.
+ */
+t8_forest_t         t8_forest_locator_get_forest (t8_forest_locator_t
+                                                  locator);
+
+/** Find the local leafs that contain a set of points.
+ * The points are distributed over the threads of t8code.
+ * \param [in]  locator     A point locator.
+ * \param [in]  num_points  The number of points.
+ * \param [in]  points      The coordinates of the points, 3 doubles each.
+ * \param [out] element_indices An array of \a num_points entries. On output
+ *                          the result of \ref t8_forest_locator_find for each point.
+ */
+void                t8_forest_locator_find_points (t8_forest_locator_t
+                                                   locator,
+                                                   size_t num_points,
+                                                   const double *points,
+                                                   t8_locidx_t *
+                                                   element_indices);
+
+/** Find the leafs that contain a set of points on any process.
+ * Each process passes its own points. A point that is not found in the
+ * local leafs is sent to the processes that may own it: the owner found
+ * in the local and ghost trees of the forest, or else all processes whose
+ * trees have a bounding box that contains the point. These processes
+ * locate the received points in their local leafs and reply to the
+ * process that asked.
+ * The first call builds a replicated index of the bounding boxes of all
+ * trees and keeps it with the locator. It also builds the partition tables
+ * of the forest.
+ * The messages are exchanged with a nonblocking consensus, such that the
+ * messages of a process depend only on its points.
+ * This function is collective over the communicator of the forest.
+ * \param [in]  locator     A point locator.
+ * \param [in]  num_points  The number of points of this process.
+ * \param [in]  points      The coordinates of the points, 3 doubles each.
+ * \param [out] results     An array of \a num_points entries. On output the
+ *                          owner, the global element index and the reference
+ *                          coordinates for each point. If several leafs
+ *                          contain a point, one of them is returned,
+ *                          preferably a local one.
+ */
+void                t8_forest_locator_find_points_global (t8_forest_locator_t
+                                                          locator,
+                                                          size_t num_points,
+                                                          const double
+                                                          *points,
+                                                          t8_forest_locate_result_t
+                                                          * results);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_LOCATE_H */
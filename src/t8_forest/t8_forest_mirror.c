@@ -0,0 +1,130 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_mirror.h>
+#include <t8_data/t8_containers.h>
+
+/* The leafs of each tree start at a multiple of this many bytes */
+#define T8_FOREST_MIRROR_ALIGN 8
+
+void
+t8_forest_mirror_init (t8_forest_mirror_t * mirror,
+                       const t8_device_ops_t * ops)
+{
+  T8_ASSERT (mirror != NULL);
+  T8_ASSERT (ops != NULL && ops->alloc != NULL && ops->free != NULL
+             && ops->copy_to_device != NULL);
+
+  memset (mirror, 0, sizeof (*mirror));
+  mirror->ops = *ops;
+}
+
+void
+t8_forest_mirror_update (t8_forest_mirror_t * mirror, t8_forest_t forest)
+{
+  const t8_device_ops_t *ops = &mirror->ops;
+  t8_element_array_t *leafs;
+  t8_forest_mirror_tree_t *tree;
+  t8_locidx_t         itree, num_trees, element_offset;
+  size_t              byte_offset, num_bytes;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  /* The leafs of implicit trees are not stored */
+  t8_forest_materialize (forest);
+  num_trees = t8_forest_get_num_local_trees (forest);
+  if (num_trees > mirror->trees_capacity) {
+    if (mirror->trees != NULL) {
+      ops->free (mirror->trees, ops->user_data);
+    }
+    mirror->trees = (t8_forest_mirror_tree_t *)
+      ops->alloc ((size_t) num_trees * sizeof (t8_forest_mirror_tree_t),
+                  ops->user_data);
+    mirror->host_trees = T8_REALLOC (mirror->host_trees,
+                                     t8_forest_mirror_tree_t, num_trees);
+    mirror->trees_capacity = num_trees;
+  }
+  /* Lay out the trees in the leaf buffer */
+  byte_offset = 0;
+  element_offset = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    leafs = t8_forest_tree_get_leafs (forest, itree);
+    tree = mirror->host_trees + itree;
+    tree->byte_offset = byte_offset;
+    tree->element_offset = element_offset;
+    tree->num_leafs = (t8_locidx_t) t8_element_array_get_count (leafs);
+    tree->gtreeid = t8_forest_global_tree_id (forest, itree);
+    tree->element_size = (int32_t) t8_element_array_get_size (leafs);
+    tree->eclass = (int32_t) t8_forest_get_tree_class (forest, itree);
+    num_bytes = (size_t) tree->num_leafs * tree->element_size;
+    byte_offset += (num_bytes + T8_FOREST_MIRROR_ALIGN - 1)
+      / T8_FOREST_MIRROR_ALIGN * T8_FOREST_MIRROR_ALIGN;
+    element_offset += tree->num_leafs;
+  }
+  if (byte_offset > mirror->leafs_capacity) {
+    if (mirror->leafs != NULL) {
+      ops->free (mirror->leafs, ops->user_data);
+    }
+    mirror->leafs = ops->alloc (byte_offset, ops->user_data);
+    mirror->leafs_capacity = byte_offset;
+  }
+  /* Copy the leafs and the trees */
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = mirror->host_trees + itree;
+    if (tree->num_leafs > 0) {
+      leafs = t8_forest_tree_get_leafs (forest, itree);
+      ops->copy_to_device ((char *) mirror->leafs + tree->byte_offset,
+                           t8_element_array_get_data (leafs),
+                           (size_t) tree->num_leafs * tree->element_size,
+                           ops->user_data);
+    }
+  }
+  if (num_trees > 0) {
+    ops->copy_to_device (mirror->trees, mirror->host_trees,
+                         (size_t) num_trees *
+                         sizeof (t8_forest_mirror_tree_t), ops->user_data);
+  }
+  mirror->num_trees = num_trees;
+  mirror->num_leafs = element_offset;
+  T8_ASSERT (mirror->num_leafs == t8_forest_get_num_element (forest));
+}
+
+void
+t8_forest_mirror_reset (t8_forest_mirror_t * mirror)
+{
+  const t8_device_ops_t *ops = &mirror->ops;
+
+  if (mirror->leafs != NULL) {
+    ops->free (mirror->leafs, ops->user_data);
+  }
+  if (mirror->trees != NULL) {
+    ops->free (mirror->trees, ops->user_data);
+  }
+  T8_FREE (mirror->host_trees);
+  mirror->num_trees = 0;
+  mirror->num_leafs = 0;
+  mirror->leafs = NULL;
+  mirror->trees = NULL;
+  mirror->host_trees = NULL;
+  mirror->leafs_capacity = 0;
+  mirror->trees_capacity = 0;
+}
@@ -0,0 +1,109 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_mirror.h
+ * Copy the leaf arrays of a forest to the memory of a device.
+ *
+ * The leafs of all local trees are stored in one device buffer, tree after
+ * tree, in the layout of the element scheme. With the default scheme, lines,
+ * quadrilaterals and hexahedra can be processed on the device with the
+ * functions in t8_default/t8_default_device.h. A typical use is
+ *
+ *     t8_forest_mirror_t mirror;
+ *
+ *     t8_forest_mirror_init (&mirror, &my_device_ops);
+ *     t8_forest_mirror_update (&mirror, forest);
+ *     ... launch kernels on mirror.leafs and mirror.trees ...
+ *     t8_forest_mirror_update (&mirror, forest_adapt);
+ *     ...
+ *     t8_forest_mirror_reset (&mirror);
+ *
+ * The buffers are only reallocated if a new forest does not fit, such that
+ * updating the mirror after each adaptation is one copy of the leafs.
+ * Ghost elements are not mirrored.
+ */
+
+#ifndef T8_FOREST_MIRROR_H
+#define T8_FOREST_MIRROR_H
+
+#include <t8.h>
+#include <t8_device.h>
+#include <t8_forest.h>
+
+/** The description of one local tree in a \ref t8_forest_mirror_t. */
+typedef struct t8_forest_mirror_tree
+{
+  uint64_t            byte_offset; /**< The position of the first leaf of the
+                                        tree in the leaf buffer, in bytes. */
+  t8_locidx_t         element_offset; /**< The local index of the first leaf. */
+  t8_locidx_t         num_leafs; /**< The number of leafs of the tree. */
+  t8_gloidx_t         gtreeid;  /**< The global id of the tree. */
+  int32_t             element_size; /**< The size of one leaf in bytes. */
+  int32_t             eclass;   /**< The element class of the tree. */
+}
+t8_forest_mirror_tree_t;
+
+/** The leafs of a forest in device memory.
+ * The members may be read by the user and must not be changed.
+ */
+typedef struct t8_forest_mirror
+{
+  t8_device_ops_t     ops;      /**< The memory operations of the device. */
+  t8_locidx_t         num_trees; /**< The number of local trees. */
+  t8_locidx_t         num_leafs; /**< The number of local leafs. */
+  void               *leafs;    /**< On the device, the leafs of all trees. */
+  t8_forest_mirror_tree_t *trees; /**< On the device, the \a num_trees trees. */
+  t8_forest_mirror_tree_t *host_trees; /**< A copy of \a trees on the host. */
+  size_t              leafs_capacity; /**< The allocated bytes of \a leafs. */
+  t8_locidx_t         trees_capacity; /**< The allocated entries of \a trees
+                                           and \a host_trees. */
+}
+t8_forest_mirror_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Initialize an empty mirror.
+ * \param [out] mirror  The mirror.
+ * \param [in]  ops     The memory operations of the device. They are copied.
+ *                      Use \ref t8_device_ops_host to mirror on the host.
+ */
+void                t8_forest_mirror_init (t8_forest_mirror_t * mirror,
+                                           const t8_device_ops_t * ops);
+
+/** Copy the leafs of a forest to the device.
+ * The previous content of the mirror is replaced.
+ * \param [in,out] mirror  An initialized mirror.
+ * \param [in]     forest  A committed forest. Its implicit trees are
+ *                         materialized, see \ref t8_forest_materialize.
+ */
+void                t8_forest_mirror_update (t8_forest_mirror_t * mirror,
+                                             t8_forest_t forest);
+
+/** Free the device memory of a mirror.
+ * \param [in,out] mirror  An initialized mirror. It is empty on output and
+ *                         can be updated again.
+ */
+void                t8_forest_mirror_reset (t8_forest_mirror_t * mirror);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_MIRROR_H */
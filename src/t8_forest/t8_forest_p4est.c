@@ -0,0 +1,262 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_p4est.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_data/t8_containers.h>
+#ifndef P4_TO_P8
+#include <p4est_algorithms.h>
+#include <p4est_bits.h>
+#else
+#include <p8est_algorithms.h>
+#include <p8est_bits.h>
+#endif
+
+/* This file is compiled a second time for hexahedra by t8_forest_p8est.c */
+#ifndef P4_TO_P8
+#define T8_FOREST_P4EST_ECLASS T8_ECLASS_QUAD
+#else
+#define T8_FOREST_P4EST_ECLASS T8_ECLASS_HEX
+#endif
+
+/* The number of integers that describe a position in the forest */
+#define T8_FOREST_P4EST_POSITION (P4EST_DIM + 1)
+
+p4est_connectivity_t *
+t8_cmesh_to_p4est_connectivity (t8_cmesh_t cmesh)
+{
+  p4est_connectivity_t *conn;
+  p4est_topidx_t      itree, num_trees, num_vertices;
+  t8_locidx_t        *face_neighbor;
+  int8_t             *ttf;
+  double             *vertices;
+  int                 iface, ivertex;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  SC_CHECK_ABORT (!t8_cmesh_is_partitioned (cmesh),
+                  "The p4est conversion needs a replicated cmesh");
+  num_trees = (p4est_topidx_t) t8_cmesh_get_num_trees (cmesh);
+  /* We store the vertices of each tree separately, if all trees have some */
+  num_vertices = P4EST_CHILDREN * num_trees;
+  for (itree = 0; itree < num_trees; itree++) {
+    SC_CHECK_ABORT (t8_cmesh_get_tree_class (cmesh, itree) ==
+                    T8_FOREST_P4EST_ECLASS,
+                    "The p4est conversion needs a cmesh of one class");
+    if (t8_cmesh_get_tree_vertices (cmesh, itree) == NULL) {
+      num_vertices = 0;
+    }
+  }
+#ifndef P4_TO_P8
+  conn = p4est_connectivity_new (num_vertices, num_trees, 0, 0);
+#else
+  conn = p8est_connectivity_new (num_vertices, num_trees, 0, 0, 0, 0);
+#endif
+  for (itree = 0; itree < num_trees; itree++) {
+    if (num_vertices > 0) {
+      vertices = t8_cmesh_get_tree_vertices (cmesh, itree);
+      for (ivertex = 0; ivertex < P4EST_CHILDREN; ivertex++) {
+        conn->tree_to_vertex[P4EST_CHILDREN * itree + ivertex] =
+          P4EST_CHILDREN * itree + ivertex;
+      }
+      memcpy (conn->vertices + 3 * P4EST_CHILDREN * itree, vertices,
+              3 * P4EST_CHILDREN * sizeof (double));
+    }
+    (void) t8_cmesh_trees_get_tree_ext (cmesh->trees, itree,
+                                        &face_neighbor, &ttf);
+    for (iface = 0; iface < P4EST_FACES; iface++) {
+      if (t8_cmesh_tree_face_is_boundary (cmesh, itree, iface)) {
+        /* p4est connects a boundary face to itself */
+        conn->tree_to_tree[P4EST_FACES * itree + iface] = itree;
+        conn->tree_to_face[P4EST_FACES * itree + iface] = iface;
+      }
+      else {
+        /* The cmesh encodes neighbor face and orientation as p4est does */
+        conn->tree_to_tree[P4EST_FACES * itree + iface] =
+          face_neighbor[iface];
+        conn->tree_to_face[P4EST_FACES * itree + iface] = ttf[iface];
+      }
+    }
+  }
+  T8_ASSERT (p4est_connectivity_is_valid (conn));
+  return conn;
+}
+
+p4est_t            *
+t8_forest_to_p4est (t8_forest_t forest, p4est_connectivity_t * conn)
+{
+  p4est_t            *p4est;
+  p4est_tree_t       *ptree;
+  p4est_quadrant_t   *quads;
+  p4est_quadrant_t    desc;
+  t8_element_array_t *leafs;
+  t8_locidx_t         itree, num_quads, offset;
+  p4est_topidx_t      gtree, num_trees;
+  size_t              iquad;
+  int                 iproc, mpiret, level;
+  int                 position[T8_FOREST_P4EST_POSITION];
+  int                *positions;
+  t8_gloidx_t         local_num_quads, *num_quads_per_proc;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (conn->num_trees == t8_cmesh_get_num_trees (forest->cmesh));
+  SC_CHECK_ABORT (!t8_cmesh_is_partitioned (forest->cmesh),
+                  "The p4est conversion needs a replicated cmesh");
+  /* The leafs of implicit trees are not stored */
+  t8_forest_materialize (forest);
+  num_trees = conn->num_trees;
+
+  p4est = P4EST_ALLOC_ZERO (p4est_t, 1);
+  p4est->mpicomm = forest->mpicomm;
+  p4est->mpisize = forest->mpisize;
+  p4est->mpirank = forest->mpirank;
+  p4est->data_size = 0;
+  p4est->connectivity = conn;
+  p4est->local_num_quadrants = t8_forest_get_num_element (forest);
+  p4est->global_num_quadrants = t8_forest_get_global_num_elements (forest);
+  p4est->user_data_pool = NULL;
+  p4est->quadrant_pool = sc_mempool_new (sizeof (p4est_quadrant_t));
+  p4est->first_local_tree = -1;
+  p4est->last_local_tree = -2;
+
+  /* Build the trees, the local ones view the leafs of the forest */
+  p4est->trees = sc_array_new_count (sizeof (p4est_tree_t), num_trees);
+  offset = 0;
+  for (gtree = 0; gtree < num_trees; gtree++) {
+    ptree = p4est_tree_array_index (p4est->trees, gtree);
+    memset (ptree, 0, sizeof (*ptree));
+    P4EST_QUADRANT_INIT (&ptree->first_desc);
+    P4EST_QUADRANT_INIT (&ptree->last_desc);
+    itree = t8_forest_get_local_id (forest, gtree);
+    leafs = itree >= 0 ? t8_forest_tree_get_leafs (forest, itree) : NULL;
+    num_quads = leafs != NULL ? t8_element_array_get_count (leafs) : 0;
+    ptree->quadrants_offset = offset;
+    if (num_quads == 0) {
+      sc_array_init (&ptree->quadrants, sizeof (p4est_quadrant_t));
+      continue;
+    }
+    SC_CHECK_ABORT (t8_forest_get_tree_class (forest, itree) ==
+                    T8_FOREST_P4EST_ECLASS
+                    && t8_element_array_get_size (leafs) ==
+                    sizeof (p4est_quadrant_t),
+                    "The p4est conversion needs the default scheme");
+    quads = (p4est_quadrant_t *) t8_element_array_get_data (leafs);
+    sc_array_init_data (&ptree->quadrants, quads, sizeof (p4est_quadrant_t),
+                        num_quads);
+    for (iquad = 0; iquad < (size_t) num_quads; iquad++) {
+      level = quads[iquad].level;
+      ptree->quadrants_per_level[level]++;
+      ptree->maxlevel = SC_MAX (ptree->maxlevel, level);
+    }
+    p4est_quadrant_first_descendant (quads, &ptree->first_desc,
+                                     P4EST_QMAXLEVEL);
+    p4est_quadrant_last_descendant (quads + num_quads - 1,
+                                    &ptree->last_desc, P4EST_QMAXLEVEL);
+    if (p4est->first_local_tree < 0) {
+      p4est->first_local_tree = gtree;
+    }
+    p4est->last_local_tree = gtree;
+    offset += num_quads;
+  }
+  T8_ASSERT (offset == p4est->local_num_quadrants);
+
+  /* The partition of the quadrants */
+  num_quads_per_proc = T8_ALLOC (t8_gloidx_t, p4est->mpisize);
+  local_num_quads = p4est->local_num_quadrants;
+  mpiret = sc_MPI_Allgather (&local_num_quads, 1, T8_MPI_GLOIDX,
+                             num_quads_per_proc, 1, T8_MPI_GLOIDX,
+                             p4est->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  p4est->global_first_quadrant =
+    P4EST_ALLOC (p4est_gloidx_t, p4est->mpisize + 1);
+  p4est->global_first_quadrant[0] = 0;
+  for (iproc = 0; iproc < p4est->mpisize; iproc++) {
+    p4est->global_first_quadrant[iproc + 1] =
+      p4est->global_first_quadrant[iproc] + num_quads_per_proc[iproc];
+  }
+  T8_FREE (num_quads_per_proc);
+
+  /* The first position of each process, empty processes get the position
+   * of the next nonempty one */
+  memset (position, 0, sizeof (position));
+  position[0] = -1;
+  if (p4est->local_num_quadrants > 0) {
+    ptree = p4est_tree_array_index (p4est->trees, p4est->first_local_tree);
+    position[0] = (int) p4est->first_local_tree;
+    position[1] = ptree->first_desc.x;
+    position[2] = ptree->first_desc.y;
+#ifdef P4_TO_P8
+    position[3] = ptree->first_desc.z;
+#endif
+  }
+  positions = T8_ALLOC (int, T8_FOREST_P4EST_POSITION * p4est->mpisize);
+  mpiret = sc_MPI_Allgather (position, T8_FOREST_P4EST_POSITION, sc_MPI_INT,
+                             positions, T8_FOREST_P4EST_POSITION,
+                             sc_MPI_INT, p4est->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  p4est->global_first_position =
+    P4EST_ALLOC_ZERO (p4est_quadrant_t, p4est->mpisize + 1);
+  P4EST_QUADRANT_INIT (&desc);
+  desc.level = P4EST_QMAXLEVEL;
+  desc.p.which_tree = num_trees;
+  p4est->global_first_position[p4est->mpisize] = desc;
+  for (iproc = p4est->mpisize - 1; iproc >= 0; iproc--) {
+    if (positions[T8_FOREST_P4EST_POSITION * iproc] >= 0) {
+      desc.p.which_tree = positions[T8_FOREST_P4EST_POSITION * iproc];
+      desc.x = positions[T8_FOREST_P4EST_POSITION * iproc + 1];
+      desc.y = positions[T8_FOREST_P4EST_POSITION * iproc + 2];
+#ifdef P4_TO_P8
+      desc.z = positions[T8_FOREST_P4EST_POSITION * iproc + 3];
+#endif
+    }
+    p4est->global_first_position[iproc] = desc;
+  }
+  T8_FREE (positions);
+
+  T8_ASSERT (p4est_is_valid (p4est));
+  return p4est;
+}
+
+void
+t8_forest_p4est_set_user_data (p4est_t * p4est, void *data, size_t data_size)
+{
+  p4est_topidx_t      gtree;
+  p4est_tree_t       *ptree;
+  p4est_quadrant_t   *quad;
+  size_t              iquad;
+  char               *entry = (char *) data;
+
+  T8_ASSERT (p4est->data_size == 0);
+  if (p4est->local_num_quadrants == 0) {
+    return;
+  }
+  for (gtree = p4est->first_local_tree; gtree <= p4est->last_local_tree;
+       gtree++) {
+    ptree = p4est_tree_array_index (p4est->trees, gtree);
+    for (iquad = 0; iquad < ptree->quadrants.elem_count; iquad++) {
+      quad = p4est_quadrant_array_index (&ptree->quadrants, iquad);
+      quad->p.user_data = entry;
+      entry += data_size;
+    }
+  }
+}
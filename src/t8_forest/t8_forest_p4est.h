@@ -0,0 +1,106 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_p4est.h
+ * Convert forests of quadrilaterals and hexahedra to p4est and p8est.
+ *
+ * The default schemes store quadrilaterals and hexahedra as
+ * p4est_quadrant_t and p8est_quadrant_t. The conversion does not copy the
+ * leafs, the quadrant arrays of the p4est trees are views on the leaf
+ * arrays of the forest. The connectivity is built from the cmesh, it is
+ * the reverse of \ref t8_cmesh_new_from_p4est.
+ *
+ * Since the quadrants are shared, the p4est is read-only. It can be
+ * iterated, written and given to p4est_ghost_new, p4est_lnodes_new or
+ * p4est_iterate, but it must not be refined, coarsened, balanced or
+ * partitioned. It must be destroyed with p4est_destroy before the forest
+ * is changed or destroyed.
+ */
+
+#ifndef T8_FOREST_P4EST_H
+#define T8_FOREST_P4EST_H
+
+#include <t8.h>
+#include <t8_forest.h>
+#include <p4est.h>
+#include <p8est.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Build a p4est connectivity from a replicated cmesh of quadrilaterals.
+ * The trees, their vertices and their face connections are taken over.
+ * Connections of trees across corners only are not part of a cmesh and
+ * the connectivity has no corner information.
+ * \param [in] cmesh  A committed, replicated cmesh of quadrilaterals.
+ * \return            The connectivity. Destroy it with
+ *                    p4est_connectivity_destroy.
+ */
+p4est_connectivity_t *t8_cmesh_to_p4est_connectivity (t8_cmesh_t cmesh);
+
+/** Build a p8est connectivity from a replicated cmesh of hexahedra.
+ * The connectivity has no edge and no corner information.
+ * \see t8_cmesh_to_p4est_connectivity
+ */
+p8est_connectivity_t *t8_cmesh_to_p8est_connectivity (t8_cmesh_t cmesh);
+
+/** Create a p4est that shares the leafs of a forest of quadrilaterals.
+ * \param [in] forest  A committed forest of quadrilaterals with the default
+ *                     scheme and a replicated cmesh. Its implicit trees are
+ *                     materialized, see \ref t8_forest_materialize.
+ * \param [in] conn    A connectivity of the cmesh of \a forest, see
+ *                     \ref t8_cmesh_to_p4est_connectivity. It must exist
+ *                     as long as the p4est.
+ * \return             The p4est on the communicator of \a forest. Its
+ *                     data_size is zero.
+ */
+p4est_t            *t8_forest_to_p4est (t8_forest_t forest,
+                                        p4est_connectivity_t * conn);
+
+/** Create a p8est that shares the leafs of a forest of hexahedra.
+ * \see t8_forest_to_p4est
+ */
+p8est_t            *t8_forest_to_p8est (t8_forest_t forest,
+                                        p8est_connectivity_t * conn);
+
+/** Let the quadrants of a p4est point to the entries of a data array.
+ * The data is not copied, the user_data of the i-th local quadrant is set
+ * to \a data + i * \a data_size. The data_size of \a p4est stays zero,
+ * such that p4est does not free or move the data.
+ * \param [in,out] p4est     A p4est created with \ref t8_forest_to_p4est.
+ * \param [in]     data      An array with one entry per local quadrant, for
+ *                           example the element data of the forest.
+ * \param [in]     data_size The size of one entry in bytes.
+ */
+void                t8_forest_p4est_set_user_data (p4est_t * p4est,
+                                                   void *data,
+                                                   size_t data_size);
+
+/** Let the quadrants of a p8est point to the entries of a data array.
+ * \see t8_forest_p4est_set_user_data
+ */
+void                t8_forest_p8est_set_user_data (p8est_t * p8est,
+                                                   void *data,
+                                                   size_t data_size);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_P4EST_H */
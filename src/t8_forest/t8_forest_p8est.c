@@ -0,0 +1,38 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* The p8est conversion is the p4est conversion compiled for hexahedra.
+ * The t8code headers are included before the p4est names are redefined. */
+#include <t8_forest/t8_forest_p4est.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_data/t8_containers.h>
+#include <p8est_algorithms.h>
+#include <p8est_bits.h>
+#include <p4est_to_p8est.h>
+
+#define t8_cmesh_to_p4est_connectivity t8_cmesh_to_p8est_connectivity
+#define t8_forest_to_p4est t8_forest_to_p8est
+#define t8_forest_p4est_set_user_data t8_forest_p8est_set_user_data
+
+#include "t8_forest_p4est.c"
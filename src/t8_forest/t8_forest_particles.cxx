@@ -0,0 +1,294 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_particles.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_threads.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/* The number of particles per chunk of the owner search */
+#define T8_PARTICLES_GRAIN 256
+
+/* A particle that leaves this process */
+typedef struct
+{
+  int                 owner;
+  size_t              index;
+} t8_forest_particle_send_t;
+
+/* Sort the leaving particles by their owner and keep their order */
+static int
+t8_forest_particle_send_compare (const void *a, const void *b)
+{
+  const t8_forest_particle_send_t *sa = (const t8_forest_particle_send_t *) a;
+  const t8_forest_particle_send_t *sb = (const t8_forest_particle_send_t *) b;
+
+  if (sa->owner != sb->owner) {
+    return sa->owner < sb->owner ? -1 : 1;
+  }
+  return sa->index < sb->index ? -1 : sa->index > sb->index;
+}
+
+/* The arguments of the owner search */
+typedef struct
+{
+  t8_forest_locator_t locator;
+  int                 mpirank;
+  const double       *points;
+  const t8_locidx_t  *element_indices;
+  int                *owners;
+} t8_forest_particles_owners_t;
+
+/* Find the owners of a chunk of the particles. The owner of a particle in
+ * a local leaf is this process. A particle that does not lie in any known
+ * tree, or whose leaf should be local but was not found, gets owner -1. */
+static void
+t8_forest_particles_owners_range (size_t begin, size_t end, int thread_id,
+                                  void *user_data)
+{
+  t8_forest_particles_owners_t *data =
+    (t8_forest_particles_owners_t *) user_data;
+  size_t              ipart;
+  int                 owner;
+
+  for (ipart = begin; ipart < end; ipart++) {
+    if (data->element_indices[ipart] >= 0) {
+      data->owners[ipart] = data->mpirank;
+    }
+    else {
+      owner = t8_forest_locator_find_owner (data->locator,
+                                            data->points + 3 * ipart);
+      data->owners[ipart] = owner == data->mpirank ? -1 : owner;
+    }
+  }
+}
+
+size_t
+t8_forest_particles_migrate (t8_forest_locator_t locator,
+                             sc_array_t * coordinates, sc_array_t * payloads,
+                             sc_array_t * element_indices)
+{
+  t8_forest_t         forest;
+  t8_forest_particles_owners_t data;
+  t8_forest_particle_send_t *send;
+  sc_array_t          sends, recv_buffer;
+  t8_locidx_t        *indices, *recv_indices;
+  size_t              num_particles, payload_size, record_size;
+  size_t              num_sends, isend, ipart, num_kept, num_recv;
+  size_t              num_final;
+  size_t              num_lost = 0, *send_offsets;
+  char               *send_buffer, *record;
+  int                *owners, *targets, num_targets, mpirank;
+
+  T8_ASSERT (locator != NULL);
+  T8_ASSERT (coordinates != NULL
+             && coordinates->elem_size == 3 * sizeof (double));
+  T8_ASSERT (payloads == NULL
+             || payloads->elem_count == coordinates->elem_count);
+  T8_ASSERT (element_indices == NULL
+             || element_indices->elem_size == sizeof (t8_locidx_t));
+
+  forest = t8_forest_locator_get_forest (locator);
+  mpirank = forest->mpirank;
+  num_particles = coordinates->elem_count;
+  payload_size = payloads != NULL ? payloads->elem_size : 0;
+  record_size = 3 * sizeof (double) + payload_size;
+
+  /* Locate the particles in the local leafs and find the owners of the
+   * others */
+  indices = T8_ALLOC (t8_locidx_t, SC_MAX (num_particles, 1));
+  owners = T8_ALLOC (int, SC_MAX (num_particles, 1));
+  t8_forest_locator_find_points (locator, num_particles,
+                                 (const double *) coordinates->array,
+                                 indices);
+  data.locator = locator;
+  data.mpirank = mpirank;
+  data.points = (const double *) coordinates->array;
+  data.element_indices = indices;
+  data.owners = owners;
+  t8_parallel_for (0, num_particles, T8_PARTICLES_GRAIN,
+                   t8_forest_particles_owners_range, &data);
+
+  /* Pack one message per target process */
+  sc_array_init (&sends, sizeof (t8_forest_particle_send_t));
+  for (ipart = 0; ipart < num_particles; ipart++) {
+    if (owners[ipart] >= 0 && owners[ipart] != mpirank) {
+      send = (t8_forest_particle_send_t *) sc_array_push (&sends);
+      send->owner = owners[ipart];
+      send->index = ipart;
+    }
+  }
+  sc_array_sort (&sends, t8_forest_particle_send_compare);
+  num_sends = sends.elem_count;
+  send_buffer = T8_ALLOC (char, SC_MAX (num_sends * record_size, 1));
+  targets = T8_ALLOC (int, SC_MAX (num_sends, 1));
+  send_offsets = T8_ALLOC (size_t, num_sends + 1);
+  num_targets = 0;
+  for (isend = 0; isend < num_sends; isend++) {
+    send = (t8_forest_particle_send_t *) sc_array_index (&sends, isend);
+    if (num_targets == 0 || targets[num_targets - 1] != send->owner) {
+      targets[num_targets] = send->owner;
+      send_offsets[num_targets] = isend * record_size;
+      num_targets++;
+    }
+    record = send_buffer + isend * record_size;
+    memcpy (record, sc_array_index (coordinates, send->index),
+            3 * sizeof (double));
+    if (payload_size > 0) {
+      memcpy (record + 3 * sizeof (double),
+              sc_array_index (payloads, send->index), payload_size);
+    }
+  }
+  send_offsets[num_targets] = num_sends * record_size;
+  sc_array_reset (&sends);
+
+  sc_array_init (&recv_buffer, 1);
+  t8_forest_exchange_sparse (forest->mpicomm, T8_MPI_PARTICLES_FOREST,
+                             num_targets, targets, send_buffer, send_offsets,
+                             &recv_buffer);
+  T8_FREE (send_buffer);
+  T8_FREE (targets);
+  T8_FREE (send_offsets);
+
+  /* Keep the particles of the local leafs in their order */
+  num_kept = 0;
+  for (ipart = 0; ipart < num_particles; ipart++) {
+    if (owners[ipart] == mpirank) {
+      if (num_kept < ipart) {
+        memcpy (sc_array_index (coordinates, num_kept),
+                sc_array_index (coordinates, ipart), 3 * sizeof (double));
+        if (payload_size > 0) {
+          memcpy (sc_array_index (payloads, num_kept),
+                  sc_array_index (payloads, ipart), payload_size);
+        }
+      }
+      indices[num_kept++] = indices[ipart];
+    }
+    else if (owners[ipart] < 0) {
+      num_lost++;
+    }
+  }
+  T8_FREE (owners);
+
+  /* Append the received particles and locate them */
+  T8_ASSERT (recv_buffer.elem_count % record_size == 0);
+  num_recv = recv_buffer.elem_count / record_size;
+  sc_array_resize (coordinates, num_kept + num_recv);
+  if (payloads != NULL) {
+    sc_array_resize (payloads, num_kept + num_recv);
+  }
+  for (ipart = 0; ipart < num_recv; ipart++) {
+    record = recv_buffer.array + ipart * record_size;
+    memcpy (sc_array_index (coordinates, num_kept + ipart), record,
+            3 * sizeof (double));
+    if (payload_size > 0) {
+      memcpy (sc_array_index (payloads, num_kept + ipart),
+              record + 3 * sizeof (double), payload_size);
+    }
+  }
+  sc_array_reset (&recv_buffer);
+  recv_indices = T8_ALLOC (t8_locidx_t, SC_MAX (num_recv, 1));
+  t8_forest_locator_find_points (locator, num_recv,
+                                 num_recv > 0 ? (const double *)
+                                 sc_array_index (coordinates, num_kept)
+                                 : NULL, recv_indices);
+
+  /* Store the leafs and remove the received particles that we cannot
+   * locate */
+  if (element_indices != NULL) {
+    sc_array_resize (element_indices, num_kept + num_recv);
+    if (num_kept > 0) {
+      memcpy (element_indices->array, indices,
+              num_kept * sizeof (t8_locidx_t));
+    }
+  }
+  T8_FREE (indices);
+  num_final = num_kept;
+  for (ipart = 0; ipart < num_recv; ipart++) {
+    if (recv_indices[ipart] < 0) {
+      num_lost++;
+      continue;
+    }
+    if (num_final < num_kept + ipart) {
+      memcpy (sc_array_index (coordinates, num_final),
+              sc_array_index (coordinates, num_kept + ipart),
+              3 * sizeof (double));
+      if (payload_size > 0) {
+        memcpy (sc_array_index (payloads, num_final),
+                sc_array_index (payloads, num_kept + ipart), payload_size);
+      }
+    }
+    if (element_indices != NULL) {
+      *(t8_locidx_t *) sc_array_index (element_indices, num_final) =
+        recv_indices[ipart];
+    }
+    num_final++;
+  }
+  sc_array_resize (coordinates, num_final);
+  if (payloads != NULL) {
+    sc_array_resize (payloads, num_final);
+  }
+  if (element_indices != NULL) {
+    sc_array_resize (element_indices, num_final);
+  }
+  T8_FREE (recv_indices);
+  return num_lost;
+}
+
+void
+t8_forest_particles_bin (t8_forest_t forest, size_t num_particles,
+                         const t8_locidx_t * element_indices,
+                         size_t *leaf_offsets, size_t *particle_ids)
+{
+  t8_locidx_t         num_elements, ielem;
+  size_t              ipart;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  num_elements = t8_forest_get_num_element (forest);
+  memset (leaf_offsets, 0, (num_elements + 1) * sizeof (size_t));
+  /* Count the particles of each leaf and compute the start of each leaf */
+  for (ipart = 0; ipart < num_particles; ipart++) {
+    if (element_indices[ipart] >= 0) {
+      T8_ASSERT (element_indices[ipart] < num_elements);
+      leaf_offsets[element_indices[ipart] + 1]++;
+    }
+  }
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    leaf_offsets[ielem + 1] += leaf_offsets[ielem];
+  }
+  /* Insert the particles. Afterwards, leaf_offsets[i] is the end of leaf i,
+   * so we shift the offsets by one */
+  for (ipart = 0; ipart < num_particles; ipart++) {
+    if (element_indices[ipart] >= 0) {
+      particle_ids[leaf_offsets[element_indices[ipart]]++] = ipart;
+    }
+  }
+  for (ielem = num_elements; ielem > 0; ielem--) {
+    leaf_offsets[ielem] = leaf_offsets[ielem - 1];
+  }
+  leaf_offsets[0] = 0;
+}
+
+T8_EXTERN_C_END ();
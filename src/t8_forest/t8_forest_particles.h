@@ -0,0 +1,99 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_particles.h
+ * Bin particles by the local leafs of a forest and migrate them to the
+ * processes that own their leafs.
+ *
+ * A particle is a point with a payload of fixed size. We locate the local
+ * leaf of each particle with a point locator, see \ref t8_forest_locate.h.
+ * A particle that does not lie in a local leaf is sent to the process whose
+ * leaf contains it. We find this process in the local and ghost trees,
+ * such that a particle can move by about one tree between two migrations.
+ * The messages are exchanged with a nonblocking consensus, such that the
+ * processes do not need to know beforehand from whom they receive.
+ * After the migration, the particles of each local leaf can be listed in
+ * compressed sparse row format.
+ */
+
+#ifndef T8_FOREST_PARTICLES_H
+#define T8_FOREST_PARTICLES_H
+
+#include <t8.h>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_locate.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Send each particle to the process that owns the leaf that contains it.
+ * This function is collective over the communicator of the forest.
+ * \param [in]  locator     A point locator of a forest. If the forest has a
+ *                          ghost layer, particles in ghost trees are found.
+ * \param [in,out] coordinates An array with 3 doubles per particle.
+ *                          On output it holds the particles that lie in the
+ *                          local leafs, first the particles that stay on
+ *                          this process in their original order, then the
+ *                          received particles.
+ * \param [in,out] payloads If not NULL, an array with one entry of any size
+ *                          per particle. It is reordered and resized as
+ *                          \a coordinates.
+ * \param [in,out] element_indices If not NULL, an array of t8_locidx_t.
+ *                          On output it holds the local leaf of each
+ *                          particle in \a coordinates.
+ * \return                  The number of particles that this process
+ *                          removed, since they lie in none of its local and
+ *                          ghost trees or could not be located on the
+ *                          process that received them.
+ */
+size_t              t8_forest_particles_migrate (t8_forest_locator_t
+                                                 locator,
+                                                 sc_array_t * coordinates,
+                                                 sc_array_t * payloads,
+                                                 sc_array_t *
+                                                 element_indices);
+
+/** Sort particles by the local leafs of a forest in compressed sparse row
+ * format. The particles of each leaf keep their order.
+ * \param [in]  forest      A committed forest.
+ * \param [in]  num_particles The number of particles.
+ * \param [in]  element_indices The local leaf of each particle, for example
+ *                          from \ref t8_forest_particles_migrate or
+ *                          \ref t8_forest_locator_find_points. Particles
+ *                          with a negative index are left out.
+ * \param [out] leaf_offsets An array of the number of local elements plus
+ *                          one entries. On output the particles of leaf i
+ *                          are stored from leaf_offsets[i] to
+ *                          leaf_offsets[i + 1] - 1 in \a particle_ids.
+ * \param [out] particle_ids An array of \a num_particles entries. On output
+ *                          its first leaf_offsets[num_elements] entries
+ *                          hold the particle indices sorted by leaf.
+ */
+void                t8_forest_particles_bin (t8_forest_t forest,
+                                             size_t num_particles,
+                                             const t8_locidx_t *
+                                             element_indices,
+                                             size_t *leaf_offsets,
+                                             size_t *particle_ids);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_PARTICLES_H */
@@ -24,8 +24,11 @@
 #include <t8_forest/t8_forest_types.h>
 #include <t8_forest/t8_forest_private.h>
 #include <t8_forest.h>
+#include <t8_trace.h>
+#include <t8_peer_volume.h>
 #include <t8_cmesh/t8_cmesh_offset.h>
 #include <t8_element_cxx.hxx>
+#include <t8_element_scratch.hxx>
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -40,6 +43,27 @@ typedef struct
   t8_locidx_t         num_elements;     /* The number of elements from this tree that were sent */
 } t8_forest_partition_tree_info_t;
 
+/* The maximum number of children of an element. Pyramids have 10. */
+#define T8_FOREST_PARTITION_MAX_FAMILY 10
+
+/* Describes the family of an element. Two leaves belong to the same
+ * family if their keys are equal and their level is positive. */
+typedef struct
+{
+  t8_gloidx_t         gtree_id; /* The global id of the tree */
+  t8_linearidx_t      parent_id;        /* The linear id of the parent */
+  int                 level;    /* The level of the element */
+  int                 num_siblings;     /* The number of children of the parent */
+} t8_forest_partition_family_key_t;
+
+/* The requests of a data exchange between two partitions.
+ * The receives come first, then the sends. */
+struct t8_forest_partition_data_exchange
+{
+  int                 num_requests;     /* The number of requests */
+  sc_MPI_Request     *requests; /* The receive and send requests */
+};
+
 /* Given the element offset array and a rank, return the first
  * local element id of this rank */
 static              t8_gloidx_t
@@ -101,7 +125,10 @@ t8_forest_partition_create_offsets (t8_forest_t forest)
   T8_ASSERT (t8_forest_is_committed (forest));
 
   T8_ASSERT (forest->element_offsets == NULL);
-  t8_debugf ("Building offsets for forest %p\n", forest);
+  T8_DEBUGF ("Building offsets for forest %p\n", forest);
+  if (forest->profile != NULL) {
+    forest->profile->element_offsets_computed++;
+  }
   comm = forest->mpicomm;
   /* Set the shmem array type of comm */
   t8_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
@@ -116,7 +143,8 @@ t8_forest_partition_create_offsets (t8_forest_t forest)
   t8_shmem_array_allgather (&first_local_element, 1, T8_MPI_GLOIDX,
                             forest->element_offsets, 1, T8_MPI_GLOIDX);
   t8_shmem_array_set_gloidx (forest->element_offsets, forest->mpisize,
-                             forest->global_num_elements);
+                             t8_forest_comm_global_num_elements_wait
+                             (forest));
 }
 
 #ifdef T8_ENABLE_DEBUG
@@ -170,7 +198,10 @@ t8_forest_partition_create_first_desc (t8_forest_t forest)
   T8_ASSERT (t8_forest_is_committed (forest));
 
   T8_ASSERT (forest->global_first_desc == NULL);
-  t8_debugf ("Building global first descendants for forest %p\n", forest);
+  T8_DEBUGF ("Building global first descendants for forest %p\n", forest);
+  if (forest->profile != NULL) {
+    forest->profile->first_desc_computed++;
+  }
   comm = forest->mpicomm;
 
   if (forest->global_first_desc == NULL) {
@@ -191,6 +222,15 @@ t8_forest_partition_create_first_desc (t8_forest_t forest)
     /* This process is empty, we store 0 in the array */
     local_first_desc = 0;
   }
+  else if (t8_forest_get_tree_lazy (forest, 0)->implicit_level >= 0) {
+    /* The first descendant of an implicit tree was computed at commit,
+     * we do not create the elements of the tree */
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest, 0));
+    local_first_desc =
+      ts->t8_element_get_linear_id (t8_forest_get_tree_lazy (forest, 0)->
+                                    first_desc, forest->maxlevel);
+  }
   else {
     /* Get a pointer to the first local element. */
     first_element = t8_forest_get_element_in_tree (forest, 0, 0);
@@ -249,6 +289,9 @@ t8_forest_partition_create_tree_offsets (t8_forest_t forest)
 
   T8_ASSERT (t8_forest_is_committed (forest));
 
+  if (forest->profile != NULL) {
+    forest->profile->tree_offsets_computed++;
+  }
   comm = forest->mpicomm;
   /* *INDENT-OFF* */
   /* Calculate this process's tree offset */
@@ -358,6 +401,327 @@ t8_forest_partition_compute_new_offset (t8_forest_t forest)
                              forest->global_num_elements);
 }
 
+/* Decide whether forest can keep the partition of forest->set_from, since
+ * the ratio of the maximum and the average load is at most
+ * forest->set_partition_imbalance. This needs one reduction if the
+ * tolerance is set and none otherwise. The result is the same on
+ * all processes. */
+static int
+t8_forest_partition_is_balanced (t8_forest_t forest, double local_load,
+                                 double total_load)
+{
+  double              max_load, imbalance;
+  int                 mpiret;
+
+  if (forest->set_partition_imbalance < 1 || forest->set_for_coarsening > 0) {
+    /* We always partition */
+    return 0;
+  }
+  mpiret = sc_MPI_Allreduce (&local_load, &max_load, 1, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  imbalance = total_load > 0 ? max_load * forest->mpisize / total_load : 1;
+  if (forest->profile != NULL) {
+    forest->profile->partition_imbalance = imbalance;
+  }
+  T8_GLOBAL_INFOF ("Partition imbalance %f, tolerance %f\n",
+                   imbalance, forest->set_partition_imbalance);
+  return imbalance <= forest->set_partition_imbalance;
+}
+
+/* Create a copy of a shared memory array on all processes of comm.
+ * Does nothing if source is NULL. */
+static void
+t8_forest_partition_copy_shmem (t8_shmem_array_t * pdest,
+                                t8_shmem_array_t source, sc_MPI_Comm comm)
+{
+  T8_ASSERT (pdest != NULL && *pdest == NULL);
+  if (source == NULL) {
+    return;
+  }
+  t8_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
+  t8_shmem_array_init (pdest, t8_shmem_array_get_elem_size (source),
+                       t8_shmem_array_get_elem_count (source), comm);
+  t8_shmem_array_copy (*pdest, source);
+}
+
+int
+t8_forest_partition_tables_require (t8_forest_t forest, int tables)
+{
+  int                 created = 0;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  if ((tables & T8_FOREST_TABLE_TREE_OFFSETS)
+      && forest->tree_offsets == NULL) {
+    t8_forest_partition_create_tree_offsets (forest);
+    created |= T8_FOREST_TABLE_TREE_OFFSETS;
+  }
+  if ((tables & T8_FOREST_TABLE_FIRST_DESC)
+      && forest->global_first_desc == NULL) {
+    t8_forest_partition_create_first_desc (forest);
+    created |= T8_FOREST_TABLE_FIRST_DESC;
+  }
+  if ((tables & T8_FOREST_TABLE_ELEMENT_OFFSETS)
+      && forest->element_offsets == NULL) {
+    t8_forest_partition_create_offsets (forest);
+    created |= T8_FOREST_TABLE_ELEMENT_OFFSETS;
+  }
+  return created;
+}
+
+void
+t8_forest_partition_tables_release (t8_forest_t forest, int tables)
+{
+  if ((tables & T8_FOREST_TABLE_TREE_OFFSETS)
+      && forest->tree_offsets != NULL) {
+    t8_shmem_array_destroy (&forest->tree_offsets);
+  }
+  if ((tables & T8_FOREST_TABLE_FIRST_DESC)
+      && forest->global_first_desc != NULL) {
+    t8_shmem_array_destroy (&forest->global_first_desc);
+  }
+  if ((tables & T8_FOREST_TABLE_ELEMENT_OFFSETS)
+      && forest->element_offsets != NULL) {
+    t8_shmem_array_destroy (&forest->element_offsets);
+  }
+}
+
+void
+t8_forest_partition_tables_inherit (t8_forest_t forest,
+                                    t8_forest_t forest_from, int tables)
+{
+  int                 shared = 0;
+
+  T8_ASSERT (t8_forest_is_committed (forest_from));
+  if ((tables & T8_FOREST_TABLE_ELEMENT_OFFSETS)
+      && forest_from->element_offsets != NULL) {
+    t8_forest_partition_copy_shmem (&forest->element_offsets,
+                                    forest_from->element_offsets,
+                                    forest->mpicomm);
+    shared++;
+  }
+  if ((tables & T8_FOREST_TABLE_FIRST_DESC)
+      && forest_from->global_first_desc != NULL) {
+    t8_forest_partition_copy_shmem (&forest->global_first_desc,
+                                    forest_from->global_first_desc,
+                                    forest->mpicomm);
+    shared++;
+  }
+  if ((tables & T8_FOREST_TABLE_TREE_OFFSETS)
+      && forest_from->tree_offsets != NULL) {
+    t8_forest_partition_copy_shmem (&forest->tree_offsets,
+                                    forest_from->tree_offsets,
+                                    forest->mpicomm);
+    shared++;
+  }
+  if (forest->profile != NULL) {
+    forest->profile->partition_tables_shared += shared;
+  }
+}
+
+/* Keep the partition of forest->set_from. The elements are shared with
+ * forest->set_from and the partition arrays are taken over, such that no
+ * element and no offset is communicated or copied. */
+static void
+t8_forest_partition_keep (t8_forest_t forest)
+{
+  t8_forest_t         forest_from = forest->set_from;
+  t8_locidx_t         itree, num_trees;
+
+  T8_ASSERT (forest->trees != NULL && forest->trees->elem_count == 0);
+  sc_array_destroy (forest->trees);
+  /* We share the elements but do not copy the descendants, since the
+   * commit computes them */
+  t8_forest_copy_trees (forest, forest_from, 0);
+  num_trees = t8_forest_get_num_local_trees (forest_from);
+  for (itree = 0; itree < num_trees; itree++) {
+    t8_element_array_reset (&t8_forest_get_tree (forest, itree)->elements);
+    t8_forest_tree_share (forest, itree, forest_from, itree);
+  }
+  forest->local_num_elements = forest_from->local_num_elements;
+  forest->global_num_elements = forest_from->global_num_elements;
+  t8_forest_partition_tables_inherit (forest, forest_from,
+                                      T8_FOREST_TABLE_ALL);
+}
+
+/* Return the element class costs that are used to partition forest.
+ * These are the costs of the forest if set and the costs of the cmesh
+ * otherwise. NULL if neither is set. */
+static const double *
+t8_forest_partition_eclass_costs (t8_forest_t forest)
+{
+  if (forest->set_partition_eclass_costs != NULL) {
+    return forest->set_partition_eclass_costs;
+  }
+  return t8_cmesh_get_partition_eclass_costs (forest->cmesh);
+}
+
+/* The process that an element with weight prefix sum prefix (not counting
+ * its own weight) is assigned to in a weighted partition. */
+static int
+t8_forest_partition_weight_owner (long double prefix, double total_weight,
+                                  int mpisize)
+{
+  return (int) SC_MIN (floorl (prefix * mpisize / total_weight),
+                       (long double) (mpisize - 1));
+}
+
+/* Calculate the new element_offset for forest from the elements in
+ * forest->set_from, such that each process gets about the same sum of
+ * element weights. The element with weight prefix sum c (not counting its
+ * own weight) and total weight W is assigned to process
+ * floor (c * mpisize / W). Processes may be empty.
+ * A process p starts at the first element that is assigned to p or a
+ * bigger process. Each process proposes its first element with this
+ * property for each p and we take the minimum over all processes, as
+ * t8_cmesh_uniform_offsets_costs does.
+ * Return true if the weights are already balanced up to the tolerance of
+ * forest. In this case, no offsets are computed. */
+static int
+t8_forest_partition_compute_new_offset_weighted (t8_forest_t forest)
+{
+  t8_forest_t         forest_from;
+  sc_MPI_Comm         comm;
+  t8_gloidx_t         first_element, *local_first, *new_offsets;
+  t8_locidx_t         itree, num_trees, ielem, num_elements, lelem;
+  t8_eclass_scheme_c *ts;
+  t8_eclass_t         tree_class;
+  double             *weights;
+  const double       *eclass_costs;
+  double              local_weight, weight_before, total_weight;
+  long double         prefix;
+  int                 iproc, owner, mpiret;
+
+  T8_ASSERT (t8_forest_is_initialized (forest));
+  T8_ASSERT (forest->set_from != NULL);
+
+  forest_from = forest->set_from;
+  comm = forest->mpicomm;
+  num_elements = t8_forest_get_num_element (forest_from);
+  eclass_costs = t8_forest_partition_eclass_costs (forest);
+  T8_ASSERT (forest->set_partition_weight_fn != NULL
+             || forest->set_partition_weights != NULL
+             || eclass_costs != NULL);
+
+  /* Get the weights of the local elements */
+  if (forest->set_partition_weights != NULL && eclass_costs == NULL) {
+    weights = (double *) forest->set_partition_weights;
+  }
+  else {
+    weights = T8_ALLOC (double, num_elements);
+    num_trees = t8_forest_get_num_local_trees (forest_from);
+    for (itree = 0, lelem = 0; itree < num_trees; itree++) {
+      tree_class = t8_forest_get_tree_class (forest_from, itree);
+      ts = t8_forest_get_eclass_scheme (forest_from, tree_class);
+      for (ielem = 0; ielem < t8_forest_get_tree_num_elements (forest_from,
+                                                               itree);
+           ielem++, lelem++) {
+        if (forest->set_partition_weight_fn != NULL) {
+          weights[lelem] =
+            forest->set_partition_weight_fn (forest_from, itree, ielem, ts,
+                                             t8_forest_get_element_in_tree
+                                             (forest_from, itree, ielem));
+        }
+        else if (forest->set_partition_weights != NULL) {
+          weights[lelem] = forest->set_partition_weights[lelem];
+        }
+        else {
+          weights[lelem] = 1;
+        }
+        if (eclass_costs != NULL) {
+          weights[lelem] *= eclass_costs[tree_class];
+        }
+      }
+    }
+  }
+  local_weight = 0;
+  for (lelem = 0; lelem < num_elements; lelem++) {
+    T8_ASSERT (weights[lelem] >= 0);
+    local_weight += weights[lelem];
+  }
+  /* Compute the weight on the smaller ranks and the total weight */
+  mpiret = sc_MPI_Scan (&local_weight, &weight_before, 1, sc_MPI_DOUBLE,
+                        sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  weight_before -= local_weight;
+  mpiret = sc_MPI_Allreduce (&local_weight, &total_weight, 1, sc_MPI_DOUBLE,
+                             sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+
+  if (total_weight <= 0) {
+    /* There is nothing to balance, we partition by count */
+    if (weights != forest->set_partition_weights) {
+      T8_FREE (weights);
+    }
+    if (t8_forest_partition_is_balanced (forest,
+                                         forest_from->local_num_elements,
+                                         forest_from->global_num_elements)) {
+      return 1;
+    }
+    t8_forest_partition_compute_new_offset (forest);
+    return 0;
+  }
+  if (t8_forest_partition_is_balanced (forest, local_weight, total_weight)) {
+    if (weights != forest->set_partition_weights) {
+      T8_FREE (weights);
+    }
+    return 1;
+  }
+
+  /* Propose the first element of each process. Our element lelem is the
+   * first element of each process p <= owner that no smaller element is
+   * assigned to. The smaller elements on other processes win the minimum. */
+  first_element = t8_shmem_array_get_gloidx (forest_from->element_offsets,
+                                             forest->mpirank);
+  local_first = T8_ALLOC (t8_gloidx_t, forest->mpisize + 1);
+  iproc = 0;
+  prefix = weight_before;
+  for (lelem = 0; lelem < num_elements; lelem++) {
+    owner = t8_forest_partition_weight_owner (prefix, total_weight,
+                                              forest->mpisize);
+    for (; iproc <= owner; iproc++) {
+      local_first[iproc] = first_element + lelem;
+    }
+    prefix += weights[lelem];
+  }
+  for (; iproc <= forest->mpisize; iproc++) {
+    local_first[iproc] = forest_from->global_num_elements;
+  }
+  new_offsets = T8_ALLOC (t8_gloidx_t, forest->mpisize + 1);
+  mpiret = sc_MPI_Allreduce (local_first, new_offsets, forest->mpisize + 1,
+                             T8_MPI_GLOIDX, sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  T8_ASSERT (new_offsets[0] == 0);
+  T8_ASSERT (new_offsets[forest->mpisize] ==
+             forest_from->global_num_elements);
+
+  T8_ASSERT (forest->element_offsets == NULL);
+  /* Set the shmem array type to comm */
+  t8_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
+  /* Initialize the shmem array */
+  t8_shmem_array_init (&forest->element_offsets, sizeof (t8_gloidx_t),
+                       forest->mpisize + 1, comm);
+  if (t8_shmem_array_start_writing (forest->element_offsets)) {
+    memcpy (t8_shmem_array_get_gloidx_array (forest->element_offsets),
+            new_offsets, (forest->mpisize + 1) * sizeof (t8_gloidx_t));
+  }
+  t8_shmem_array_end_writing (forest->element_offsets);
+#ifdef T8_ENABLE_DEBUG
+  for (iproc = 1; iproc <= forest->mpisize; iproc++) {
+    T8_ASSERT (t8_shmem_array_get_gloidx (forest->element_offsets, iproc - 1)
+               <= t8_shmem_array_get_gloidx (forest->element_offsets,
+                                             iproc));
+  }
+#endif
+
+  T8_FREE (local_first);
+  T8_FREE (new_offsets);
+  if (weights != forest->set_partition_weights) {
+    T8_FREE (weights);
+  }
+  return 0;
+}
+
 /* Find the owner of a given element.
  */
 static int
@@ -412,7 +776,7 @@ t8_forest_partition_sendrange (t8_forest_t forest, int *send_first,
   t8_gloidx_t         first_element, last_element;
   t8_gloidx_t        *offset_old, *offset_new;
 
-  t8_debugf ("Calculate sendrange\n");
+  T8_DEBUGF ("Calculate sendrange\n");
   if (forest->set_from->local_num_elements == 0) {
     /* There are no elements to send */
     *send_first = 0;
@@ -422,11 +786,11 @@ t8_forest_partition_sendrange (t8_forest_t forest, int *send_first,
   /* Get the old element offset array */
   offset_old =
     t8_shmem_array_get_gloidx_array (forest->set_from->element_offsets);
-  t8_debugf ("Partition forest from:\n");
+  T8_DEBUGF ("Partition forest from:\n");
   t8_offset_print (forest->set_from->element_offsets, forest->mpicomm);
   /* Get the new element offset array */
   offset_new = t8_shmem_array_get_gloidx_array (forest->element_offsets);
-  t8_debugf ("Partition forest to:\n");
+  T8_DEBUGF ("Partition forest to:\n");
   t8_offset_print (forest->element_offsets, forest->mpicomm);
   /* Compute old first and last element on this process from offset array */
   first_element =
@@ -601,54 +965,18 @@ t8_forest_partition_fill_buffer (t8_forest_t forest_from,
   }
   *current_tree += num_trees_send - 1 + last_element_is_last_tree_element;
   *buffer_alloc = byte_alloc;
-  t8_debugf ("Post send of %i trees\n", num_trees_send);
-}
-
-/* Fill the send buffers for one send operation in send_data mode.
- * \param [in]  forest_from     The original forest
- * \param [in]  send_buffer     Unallocated send_buffer
- * \param [out] buffer_alloc    The number of bytes in the send buffer
- * \param [in]  first_element_send The local id of the first element that we need to send.
- * \param [in]  last_element_send The local id of the last element that we need to send.
- */
-static void
-t8_forest_partition_fill_buffer_data (t8_forest_t forest_from,
-                                      char **send_buffer, int *buffer_alloc,
-                                      t8_locidx_t first_element_send,
-                                      t8_locidx_t last_element_send,
-                                      const sc_array_t * data)
-{
-  void               *data_entry;
-
-  /* Check dimensions of data */
-  T8_ASSERT (data != NULL);
-  T8_ASSERT (data->elem_count == (size_t) forest_from->local_num_elements);
-
-  /* Calculate the byte count */
-  *buffer_alloc =
-    (last_element_send - first_element_send + 1) * data->elem_size;
-  T8_ASSERT (*buffer_alloc >= 0);
-  /* Must be a multiple of T8_PADDING_SIZE */
-  T8_ASSERT (T8_ADD_PADDING (*buffer_alloc) == 0);
-
-  /* Allocate the send buffer */
-  *send_buffer = T8_ALLOC (char, *buffer_alloc);
-  /* Copy the data to the send_buffer */
-  data_entry =
-    t8_sc_array_index_locidx ((sc_array_t *) data, first_element_send);
-  memcpy (*send_buffer, data_entry, *buffer_alloc);
+  T8_DEBUGF ("Post send of %i trees\n", num_trees_send);
 }
 
 /* Carry out all sending of elements */
-/* If send_data is true, the elements are not send but element data
- * stored in an sc_array of length forest->set_from->num_local_elements.
+/* On output, sent_to_self points to the send buffer of the message to
+ * ourselves, or is NULL if there is no such message.
  * Returns true if we sent to ourselves. */
 static int
 t8_forest_partition_sendloop (t8_forest_t forest, const int send_first,
                               const int send_last, sc_MPI_Request ** requests,
                               int *num_request_alloc, char ***send_buffer,
-                              const int send_data, const sc_array_t * data_in,
-                              size_t * byte_to_self)
+                              char **sent_to_self, size_t * byte_to_self)
 {
   int                 iproc, mpiret;
   t8_gloidx_t         gfirst_element_send, glast_element_send;
@@ -663,18 +991,12 @@ t8_forest_partition_sendloop (t8_forest_t forest, const int send_first,
   sc_MPI_Comm         comm;
   int                 to_self = 0;
 
-  t8_debugf ("Start send loop\n");
-  /* If send_data is false, the forest must not be committed but initialized.
-   * If send_data is true, the forest must be committed */
-  T8_ASSERT (send_data || t8_forest_is_initialized (forest));
-  T8_ASSERT (!send_data || t8_forest_is_committed (forest));
+  *sent_to_self = NULL;
+  T8_DEBUGF ("Start send loop\n");
+  /* The forest must not be committed but initialized. */
+  T8_ASSERT (t8_forest_is_initialized (forest));
   forest_from = forest->set_from;
   T8_ASSERT (t8_forest_is_committed (forest_from));
-  /* If send data is true, data_in must be non-zero and of length num_local_elements */
-  T8_ASSERT (!send_data || data_in != NULL);
-  T8_ASSERT (!send_data
-             || data_in->elem_count ==
-             (size_t) forest_from->local_num_elements);
 
   comm = forest->mpicomm;
   /* Determine the number of requests for MPI communication. */
@@ -739,37 +1061,29 @@ t8_forest_partition_sendloop (t8_forest_t forest, const int send_first,
       if (iproc == forest->mpirank) {
         to_self = 1;
       }
-      if (!send_data) {
-        /* Fill the buffer with the elements and calculate the next tree
-         * from which to send elements */
-        t8_forest_partition_fill_buffer (forest_from,
-                                         buffer, &buffer_alloc,
-                                         &current_tree, first_element_send,
-                                         last_element_send);
-      }
-      else {
-        T8_ASSERT (send_data);
-        /* We are in send data mode. Fill the send buffer with the data */
-        t8_forest_partition_fill_buffer_data (forest_from, buffer,
-                                              &buffer_alloc,
-                                              first_element_send,
-                                              last_element_send, data_in);
-      }
+      /* Fill the buffer with the elements and calculate the next tree
+       * from which to send elements */
+      t8_forest_partition_fill_buffer (forest_from,
+                                       buffer, &buffer_alloc,
+                                       &current_tree, first_element_send,
+                                       last_element_send);
       /* Post the MPI Send.
        * TODO: This will also send to ourselves if proc==mpirank */
       if (iproc != forest->mpirank) {
-        t8_debugf ("Post send of %li elements (%i bytes) to process %i\n",
+        T8_DEBUGF ("Post send of %li elements (%i bytes) to process %i\n",
                    (long) num_elements_send, buffer_alloc, iproc);
         mpiret = sc_MPI_Isend (*buffer, buffer_alloc, sc_MPI_BYTE, iproc,
                                T8_MPI_PARTITION_FOREST, comm,
                                *requests + iproc - send_first);
         SC_CHECK_MPI (mpiret);
+        t8_peer_volume_send (T8_PEER_FOREST_PARTITION, iproc, buffer_alloc);
       }
       else {
+        *sent_to_self = *buffer;
         *byte_to_self = buffer_alloc;
         *(*requests + iproc - send_first) = sc_MPI_REQUEST_NULL;
       }
-      if (!send_data && forest->profile != NULL) {
+      if (forest->profile != NULL) {
         if (iproc != forest->mpirank) {
           /* If profiling is enabled we count the number of elements sent to
            * other processes */
@@ -788,82 +1102,10 @@ t8_forest_partition_sendloop (t8_forest_t forest, const int send_first,
       *(*requests + iproc - send_first) = sc_MPI_REQUEST_NULL;
     }
   }
-  t8_debugf ("End send loop\n");
+  T8_DEBUGF ("End send loop\n");
   return to_self;
 }
 
-/* Receive a message in data sending mode, send in sendloop.
- * \param [in]  forest      The new forest.
- * \param [in]  comm        The MPI communicator.
- * \param [in]  proc        The rank from which we receive.
- * \param [in]  status      MPI status with which we probed for the message.
- * \param [in,out] last_loc_elem_recv On input the local index of the last element
- *                          that was received by this rank. Updated on output.
- * \param [out] data_out    The received data.
- * \param [in]  sent_to_self If proc equals the rank of this process, the message
- *                          should be passed as this parameter.
- * \param [in]  byte_to_self If proc equals the rank of this process, the number of
- *                          bytes in the message.
- * It is important, that we receive the messages in order to properly fill the
- * data_out array.
- */
-static void
-t8_forest_partition_recv_message_data (t8_forest_t forest, sc_MPI_Comm comm,
-                                       int proc, sc_MPI_Status * status,
-                                       t8_locidx_t * last_loc_elem_recvd,
-                                       sc_array_t * data_out,
-                                       char *sent_to_self,
-                                       size_t byte_to_self)
-{
-  int                 mpiret, recv_bytes;
-  char               *recv_buffer;
-  size_t              data_offset;
-
-  /* data_out must have the correct dimensions */
-  T8_ASSERT (data_out != NULL);
-  T8_ASSERT (data_out->elem_count == (size_t) forest->local_num_elements);
-
-  /* TODO: The next part is duplicated in t8_forest_partition_recv_message.
-   *       Put duplicated code in function */
-  /* further assertions */
-
-  if (proc != forest->mpirank) {
-    T8_ASSERT (proc == status->MPI_SOURCE);
-    T8_ASSERT (status->MPI_TAG == T8_MPI_PARTITION_FOREST);
-
-    /* Get the number of bytes to receive */
-    mpiret = sc_MPI_Get_count (status, sc_MPI_BYTE, &recv_bytes);
-    SC_CHECK_MPI (mpiret);
-    t8_debugf ("Receiving message of %i bytes from process %i\n", recv_bytes,
-               proc);
-    /* allocate the receive buffer */
-    recv_buffer = T8_ALLOC (char, recv_bytes);
-    /* receive the message */
-    mpiret = sc_MPI_Recv (recv_buffer, recv_bytes, sc_MPI_BYTE, proc,
-                          T8_MPI_PARTITION_FOREST, comm,
-                          sc_MPI_STATUS_IGNORE);
-    SC_CHECK_MPI (mpiret);
-  }
-  else {
-    recv_buffer = sent_to_self;
-    recv_bytes = byte_to_self;
-  }
-
-  /* Compute the place where to insert the data */
-  data_offset = data_out->elem_size * *last_loc_elem_recvd;
-  /* Copy the data */
-  memcpy (data_out->array + data_offset, recv_buffer, recv_bytes);
-
-  /* update the last element received */
-  T8_ASSERT (recv_bytes % data_out->elem_size == 0);
-  *last_loc_elem_recvd += recv_bytes / data_out->elem_size;
-
-  if (proc != forest->mpirank) {
-    /* free the receive buffer */
-    T8_FREE (recv_buffer);
-  }
-}
-
 /* Receive a message send in sendloop to this rank.
  * \param [in]  forest      The new forest.
  * \param [in]  comm        The MPI communicator.
@@ -903,7 +1145,7 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
     mpiret = sc_MPI_Get_count (status, sc_MPI_BYTE, &recv_bytes);
     SC_CHECK_MPI (mpiret);
   }
-  t8_debugf ("Receiving message of %i bytes from process %i\n", recv_bytes,
+  T8_DEBUGF ("Receiving message of %i bytes from process %i\n", recv_bytes,
              proc);
 
   if (proc != forest->mpirank) {
@@ -914,6 +1156,7 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
                           T8_MPI_PARTITION_FOREST, comm,
                           sc_MPI_STATUS_IGNORE);
     SC_CHECK_MPI (mpiret);
+    t8_peer_volume_receive (T8_PEER_FOREST_PARTITION, proc, recv_bytes);
   }
   else {
     recv_buffer = sent_to_self;
@@ -943,6 +1186,7 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
       /* We will insert a new tree in the forest */
       tree = (t8_tree_t) sc_array_push (forest->trees);
       tree->eclass = tree_info->eclass;
+      tree->implicit_level = -1;
       /* Calculate the element offset of the new tree */
       if (forest->last_local_tree >= forest->first_local_tree) {
         /* If there is a previous tree, we read it */
@@ -968,14 +1212,14 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
       /* initialize the elements array and copy the elements from the receive buffer */
       T8_ASSERT (element_cursor + tree_info->num_elements * element_size <=
                  (size_t) recv_bytes);
-      t8_debugf ("[H} init array for tree %i\n", itree);
+      T8_DEBUGF ("[H} init array for tree %i\n", itree);
       t8_element_array_init_copy (&tree->elements, eclass_scheme,
                                   (t8_element_t *) (recv_buffer +
                                                     element_cursor),
                                   tree_info->num_elements);
 #if 0
       /* Debugging output */
-      t8_debugf ("receive %li elements for tree %lli\n",
+      T8_DEBUGF ("receive %li elements for tree %lli\n",
                  (long) tree_info->num_elements,
                  (long long) tree_info->gtree_id);
 #endif
@@ -999,7 +1243,7 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
                                                          old_num_elements);
 #if 0
       /* Debugging output */
-      t8_debugf ("receive %li elements for tree %lli\n",
+      T8_DEBUGF ("receive %li elements for tree %lli\n",
                  (long) tree_info->num_elements,
                  (long long) tree_info->gtree_id);
 #endif
@@ -1042,12 +1286,10 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
  */
 static void
 t8_forest_partition_recvloop (t8_forest_t forest, int recv_first,
-                              int recv_last, const int recv_data,
-                              sc_array_t * data_out, char *sent_to_self,
+                              int recv_last, char *sent_to_self,
                               size_t byte_to_self)
 {
   int                 iproc, num_receive, prev_recvd;
-  t8_locidx_t         last_received_local_element = 0;
   t8_forest_t         forest_from;
   t8_gloidx_t        *offset_from;
   int                 mpiret;
@@ -1055,10 +1297,7 @@ t8_forest_partition_recvloop (t8_forest_t forest, int recv_first,
   sc_MPI_Status       status;
 
   /* Initial checks and inits */
-  T8_ASSERT (recv_data || t8_forest_is_initialized (forest));
-  T8_ASSERT (!recv_data || t8_forest_is_committed (forest));
-  T8_ASSERT (!recv_data
-             || data_out->elem_count == (size_t) forest->local_num_elements);
+  T8_ASSERT (t8_forest_is_initialized (forest));
   forest_from = forest->set_from;
   T8_ASSERT (t8_forest_is_committed (forest_from));
   offset_from =
@@ -1072,9 +1311,7 @@ t8_forest_partition_recvloop (t8_forest_t forest, int recv_first,
 
   num_receive = 0;
   prev_recvd = 0;
-  if (!recv_data) {
-    forest->local_num_elements = 0;
-  }
+  forest->local_num_elements = 0;
   for (iproc = recv_first; iproc <= recv_last; iproc++) {
     if (!t8_forest_partition_empty (offset_from, iproc)) {
       /* We receive from each nonempty rank between recv_first and recv_last */
@@ -1088,20 +1325,9 @@ t8_forest_partition_recvloop (t8_forest_t forest, int recv_first,
         T8_ASSERT (status.MPI_TAG == T8_MPI_PARTITION_FOREST);
       }
       /* Receive the actual message */
-      if (!recv_data) {
-        t8_forest_partition_recv_message (forest, comm, iproc, &status,
-                                          prev_recvd, sent_to_self,
-                                          byte_to_self);
-      }
-      else {
-        T8_ASSERT (data_out != NULL);
-        T8_ASSERT (data_out->elem_count ==
-                   (size_t) forest->local_num_elements);
-        t8_forest_partition_recv_message_data (forest, comm, iproc, &status,
-                                               &last_received_local_element,
-                                               data_out, sent_to_self,
-                                               byte_to_self);
-      }
+      t8_forest_partition_recv_message (forest, comm, iproc, &status,
+                                        prev_recvd, sent_to_self,
+                                        byte_to_self);
       prev_recvd++;
     }
   }
@@ -1111,8 +1337,7 @@ t8_forest_partition_recvloop (t8_forest_t forest, int recv_first,
  * set in forest->element_offsets
  */
 static void
-t8_forest_partition_given (t8_forest_t forest, const int send_data,
-                           const sc_array_t * data_in, sc_array_t * data_out)
+t8_forest_partition_given (t8_forest_t forest)
 {
   int                 send_first, send_last, recv_first, recv_last;
   sc_MPI_Request     *requests = NULL;
@@ -1122,46 +1347,37 @@ t8_forest_partition_given (t8_forest_t forest, const int send_data,
   t8_locidx_t         num_new_elements;
   size_t              byte_to_self = 0;
 
-  t8_debugf ("Start partition_given\n");
-  T8_ASSERT (send_data || t8_forest_is_initialized (forest));
-  T8_ASSERT (!send_data || t8_forest_is_committed (forest));
+  T8_DEBUGF ("Start partition_given\n");
+  T8_ASSERT (t8_forest_is_initialized (forest));
   T8_ASSERT (forest->set_from != NULL);
   T8_ASSERT (t8_forest_is_committed (forest->set_from));
   /* Compute the first and last rank that we send to */
   t8_forest_partition_sendrange (forest, &send_first, &send_last);
-  t8_debugf ("send_first = %i\n", send_first);
-  t8_debugf ("send_last = %i\n", send_last);
+  T8_DEBUGF ("send_first = %i\n", send_first);
+  T8_DEBUGF ("send_last = %i\n", send_last);
 
   /* Send all elements to other ranks */
+  t8_trace_begin ("partition_send");
   to_self =
     t8_forest_partition_sendloop (forest, send_first, send_last, &requests,
-                                  &num_request_alloc, &send_buffer, send_data,
-                                  data_in, &byte_to_self);
-  if (to_self) {
-    /* We have sent data to ourselves. */
-    sent_to_self = *(send_buffer + forest->mpirank - send_first);
-  }
-  else {
-    sent_to_self = NULL;
-  }
+                                  &num_request_alloc, &send_buffer,
+                                  &sent_to_self, &byte_to_self);
+  T8_ASSERT (to_self || sent_to_self == NULL);
+  t8_trace_end ("partition_send");
 
   /* Compute the number of new elements on this forest */
-  if (!send_data) {
-    num_new_elements =
-      t8_shmem_array_get_gloidx (forest->element_offsets, forest->mpirank + 1)
-      - t8_shmem_array_get_gloidx (forest->element_offsets, forest->mpirank);
-  }
-  else {
-    num_new_elements = t8_forest_get_num_element (forest);
-  }
+  num_new_elements =
+    t8_shmem_array_get_gloidx (forest->element_offsets, forest->mpirank + 1)
+    - t8_shmem_array_get_gloidx (forest->element_offsets, forest->mpirank);
 
+  t8_trace_begin ("partition_recv");
   if (num_new_elements > 0) {
     /* Receive all element from other ranks */
     t8_forest_partition_recvrange (forest, &recv_first, &recv_last);
-    t8_forest_partition_recvloop (forest, recv_first, recv_last, send_data,
-                                  data_out, sent_to_self, byte_to_self);
+    t8_forest_partition_recvloop (forest, recv_first, recv_last,
+                                  sent_to_self, byte_to_self);
   }
-  else if (!send_data) {
+  else {
     /* This forest is empty, set first and last local tree such
      * that t8_forest_get_num_local_trees return 0 */
     forest->first_local_tree = 0;
@@ -1169,19 +1385,340 @@ t8_forest_partition_given (t8_forest_t forest, const int send_data,
     forest->local_num_elements = 0;
   }
   /* Wait for all sends to complete */
-  t8_debugf ("[HH] waiting...\n");
+  T8_DEBUGF ("[HH] waiting...\n");
   if (num_request_alloc > 0) {
     mpiret =
       sc_MPI_Waitall (num_request_alloc, requests, sc_MPI_STATUSES_IGNORE);
     SC_CHECK_MPI (mpiret);
   }
+  t8_trace_end ("partition_recv");
   T8_FREE (requests);
   for (i = 0; i < num_request_alloc; i++) {
     T8_FREE (send_buffer[i]);
   }
   T8_FREE (send_buffer);
 
-  t8_debugf ("Done partition_given\n");
+  T8_DEBUGF ("Done partition_given\n");
+}
+
+/* Compute the family key of a local element of a committed forest. */
+static void
+t8_forest_partition_family_key (t8_forest_t forest, t8_locidx_t lelement,
+                                t8_forest_partition_family_key_t * key)
+{
+  t8_locidx_t         ltreeid;
+  t8_element_t       *element, *parent;
+  t8_eclass_scheme_c *ts;
+  t8_element_scratch_mark_t mark;
+
+  memset (key, 0, sizeof (*key));
+  element = t8_forest_get_element (forest, lelement, &ltreeid);
+  T8_ASSERT (element != NULL);
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  key->gtree_id = t8_forest_global_tree_id (forest, ltreeid);
+  key->level = ts->t8_element_level (element);
+  if (key->level == 0) {
+    /* This element has no family */
+    key->num_siblings = 1;
+    return;
+  }
+  t8_element_scratch_mark (&mark);
+  t8_element_scratch_get (ts, 1, &parent);
+  ts->t8_element_parent (element, parent);
+  key->parent_id = ts->t8_element_get_linear_id (parent, key->level - 1);
+  key->num_siblings = ts->t8_element_num_children (parent);
+  t8_element_scratch_release (&mark);
+}
+
+/* Return true if two family keys describe the same family */
+static int
+t8_forest_partition_family_key_equal (const t8_forest_partition_family_key_t
+                                      * keya,
+                                      const t8_forest_partition_family_key_t
+                                      * keyb)
+{
+  return keya->level > 0 && keya->level == keyb->level
+    && keya->gtree_id == keyb->gtree_id
+    && keya->parent_id == keyb->parent_id;
+}
+
+/* The elements [*first, *end) around the boundary element that we need
+ * to decide whether a new partition boundary cuts a complete family.
+ * A family has at most T8_FOREST_PARTITION_MAX_FAMILY elements. */
+static void
+t8_forest_partition_family_window (t8_gloidx_t boundary,
+                                   t8_gloidx_t global_num_elements,
+                                   t8_gloidx_t * first, t8_gloidx_t * end)
+{
+  *first = SC_MAX (boundary - T8_FOREST_PARTITION_MAX_FAMILY + 1, 0);
+  *end = SC_MIN (boundary + T8_FOREST_PARTITION_MAX_FAMILY - 1,
+                 global_num_elements);
+}
+
+/* Return true if a boundary in the new offsets is a real boundary
+ * between two elements, which we may need to move. */
+static int
+t8_forest_partition_family_boundary (t8_gloidx_t * offset_new, int iproc,
+                                     t8_gloidx_t global_num_elements)
+{
+  return 0 < offset_new[iproc] && offset_new[iproc] < global_num_elements;
+}
+
+/* Return the smallest process p in [1, mpisize] with offset[p] >= value.
+ * offset must be increasing. */
+static int
+t8_forest_partition_offset_lower_bound (t8_gloidx_t * offset, int mpisize,
+                                        t8_gloidx_t value)
+{
+  int                 low = 1, high = mpisize, mid;
+
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (offset[mid] < value) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/* Decide whether a boundary cuts a complete family, given the family keys
+ * of the elements in its window [wfirst, wend). Return the new boundary,
+ * which is the first element of the family, or the boundary itself. */
+static              t8_gloidx_t
+t8_forest_partition_family_decide (const t8_forest_partition_family_key_t *
+                                   keys, t8_gloidx_t wfirst, t8_gloidx_t wend,
+                                   t8_gloidx_t boundary)
+{
+  const t8_forest_partition_family_key_t *bkey = keys + boundary - wfirst;
+  t8_gloidx_t         first, end;
+
+  if (!t8_forest_partition_family_key_equal (keys + boundary - 1 - wfirst,
+                                             bkey)) {
+    /* The boundary is between two families */
+    return boundary;
+  }
+  /* The boundary lies inside a run of siblings, we compute the run */
+  first = boundary - 1;
+  while (first > wfirst
+         && t8_forest_partition_family_key_equal (keys + first - 1 - wfirst,
+                                                  bkey)) {
+    first--;
+  }
+  end = boundary + 1;
+  while (end < wend
+         && t8_forest_partition_family_key_equal (keys + end - wfirst,
+                                                  bkey)) {
+    end++;
+  }
+  /* The siblings are leaves of the same level, thus they are a complete
+   * family if all of them are there */
+  return end - first == bkey->num_siblings ? first : boundary;
+}
+
+/* Change the new element offsets of forest such that no boundary between
+ * two processes lies inside a family of leaves of forest->set_from.
+ * Such a boundary is moved to the first element of the family.
+ * Thus, coarsening the new forest once is a process local operation.
+ * The process that owns the element at a boundary receives the family keys
+ * of the elements around it from the processes that own them, decides
+ * and sends the new boundary to the process that starts there.
+ * Each process only communicates with processes that own elements near
+ * its own boundaries. */
+static void
+t8_forest_partition_for_coarsening (t8_forest_t forest)
+{
+  t8_forest_t         forest_from = forest->set_from;
+  sc_MPI_Comm         comm = forest->mpicomm;
+  const int           mpirank = forest->mpirank;
+  const int           mpisize = forest->mpisize;
+  const t8_gloidx_t   global_num_elements = forest_from->global_num_elements;
+  const size_t        key_size = sizeof (t8_forest_partition_family_key_t);
+  t8_gloidx_t        *offset_old, *offset_new, *new_first;
+  t8_gloidx_t         my_first, my_end, wfirst, wend, first, end, gelem;
+  t8_gloidx_t         boundary, recv_first;
+  t8_forest_partition_family_key_t **windows, *send_keys, *keys;
+  sc_MPI_Request     *requests;
+  int                 iproc, q, q_first, q_last, p_first, p_last;
+  int                 send_start, send_stop, num_own, iown;
+  int                 num_requests, max_requests, mpiret;
+
+  T8_ASSERT (t8_forest_is_committed (forest_from));
+  T8_ASSERT (forest->element_offsets != NULL);
+  offset_old = t8_shmem_array_get_gloidx_array (forest_from->element_offsets);
+  offset_new = t8_shmem_array_get_gloidx_array (forest->element_offsets);
+  my_first = offset_old[mpirank];
+  my_end = offset_old[mpirank + 1];
+
+  /* The processes p_first, ..., p_last start at one of our old elements */
+  if (my_first < my_end) {
+    p_first = t8_forest_partition_offset_lower_bound (offset_new, mpisize,
+                                                      my_first);
+    p_last = t8_forest_partition_offset_lower_bound (offset_new, mpisize,
+                                                     my_end) - 1;
+    /* The processes send_start, ..., send_stop - 1 start near our
+     * elements, such that their window intersects our elements */
+    send_start =
+      t8_forest_partition_offset_lower_bound (offset_new, mpisize,
+                                              my_first -
+                                              T8_FOREST_PARTITION_MAX_FAMILY +
+                                              2);
+    send_stop =
+      t8_forest_partition_offset_lower_bound (offset_new, mpisize,
+                                              my_end +
+                                              T8_FOREST_PARTITION_MAX_FAMILY -
+                                              1);
+  }
+  else {
+    p_first = send_start = 1;
+    p_last = send_stop = 0;
+  }
+  num_own = SC_MAX (p_last - p_first + 1, 0);
+  windows = T8_ALLOC_ZERO (t8_forest_partition_family_key_t *,
+                           SC_MAX (num_own, 1));
+  /* Each window has less than 2 * T8_FOREST_PARTITION_MAX_FAMILY
+   * elements, we receive at most one message for each element */
+  max_requests = num_own * 2 * T8_FOREST_PARTITION_MAX_FAMILY
+    + SC_MAX (send_stop - send_start, 0);
+  requests = T8_ALLOC (sc_MPI_Request, SC_MAX (max_requests, 1));
+  num_requests = 0;
+
+  /* Receive the keys of the windows of our boundaries and compute the
+   * keys of our own elements in them */
+  for (iproc = p_first, iown = 0; iproc <= p_last; iproc++, iown++) {
+    if (!t8_forest_partition_family_boundary (offset_new, iproc,
+                                              global_num_elements)) {
+      continue;
+    }
+    t8_forest_partition_family_window (offset_new[iproc],
+                                       global_num_elements, &wfirst, &wend);
+    windows[iown] = T8_ALLOC (t8_forest_partition_family_key_t,
+                              wend - wfirst);
+    q_first = t8_forest_partition_owner_of_element (mpisize, wfirst,
+                                                    offset_old);
+    q_last = t8_forest_partition_owner_of_element (mpisize, wend - 1,
+                                                   offset_old);
+    for (q = q_first; q <= q_last; q++) {
+      first = SC_MAX (wfirst, offset_old[q]);
+      end = SC_MIN (wend, offset_old[q + 1]);
+      if (first >= end) {
+        /* q is empty */
+        continue;
+      }
+      if (q == mpirank) {
+        for (gelem = first; gelem < end; gelem++) {
+          t8_forest_partition_family_key (forest_from, gelem - my_first,
+                                          windows[iown] + gelem - wfirst);
+        }
+      }
+      else {
+        T8_ASSERT (num_requests < max_requests);
+        mpiret = sc_MPI_Irecv (windows[iown] + first - wfirst,
+                               (end - first) * key_size, sc_MPI_BYTE, q,
+                               T8_MPI_PARTITION_FAMILY_FOREST, comm,
+                               requests + num_requests++);
+        SC_CHECK_MPI (mpiret);
+      }
+    }
+  }
+  /* Send the keys of our elements to the owners of the boundaries near
+   * them, in the same order in which they post their receives */
+  send_keys = T8_ALLOC (t8_forest_partition_family_key_t,
+                        SC_MAX (send_stop - send_start, 1)
+                        * (2 * T8_FOREST_PARTITION_MAX_FAMILY - 2));
+  keys = send_keys;
+  for (iproc = send_start; iproc < send_stop; iproc++) {
+    if (!t8_forest_partition_family_boundary (offset_new, iproc,
+                                              global_num_elements)) {
+      continue;
+    }
+    boundary = offset_new[iproc];
+    q = t8_forest_partition_owner_of_element (mpisize, boundary, offset_old);
+    if (q == mpirank) {
+      continue;
+    }
+    t8_forest_partition_family_window (boundary, global_num_elements,
+                                       &wfirst, &wend);
+    first = SC_MAX (wfirst, my_first);
+    end = SC_MIN (wend, my_end);
+    if (first >= end) {
+      continue;
+    }
+    for (gelem = first; gelem < end; gelem++) {
+      t8_forest_partition_family_key (forest_from, gelem - my_first,
+                                      keys + gelem - first);
+    }
+    T8_ASSERT (num_requests < max_requests);
+    mpiret = sc_MPI_Isend (keys, (end - first) * key_size, sc_MPI_BYTE, q,
+                           T8_MPI_PARTITION_FAMILY_FOREST, comm,
+                           requests + num_requests++);
+    SC_CHECK_MPI (mpiret);
+    keys += end - first;
+  }
+  mpiret = sc_MPI_Waitall (num_requests, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (send_keys);
+
+  /* Decide on our boundaries and send them to the processes that start
+   * there. The messages use the same tag as the keys, the order of the
+   * messages between two processes keeps them apart. */
+  new_first = T8_ALLOC (t8_gloidx_t, SC_MAX (num_own, 1));
+  num_requests = 0;
+  for (iproc = p_first, iown = 0; iproc <= p_last; iproc++, iown++) {
+    new_first[iown] = offset_new[iproc];
+    if (windows[iown] == NULL) {
+      /* This is not a boundary between two elements */
+      continue;
+    }
+    t8_forest_partition_family_window (offset_new[iproc],
+                                       global_num_elements, &wfirst, &wend);
+    new_first[iown] =
+      t8_forest_partition_family_decide (windows[iown], wfirst, wend,
+                                         offset_new[iproc]);
+    T8_FREE (windows[iown]);
+    if (iproc != mpirank) {
+      T8_ASSERT (num_requests < max_requests);
+      mpiret = sc_MPI_Isend (new_first + iown, 1, T8_MPI_GLOIDX, iproc,
+                             T8_MPI_PARTITION_FAMILY_FOREST, comm,
+                             requests + num_requests++);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  /* Receive our new first element */
+  recv_first = offset_new[mpirank];
+  if (t8_forest_partition_family_boundary (offset_new, mpirank,
+                                           global_num_elements)) {
+    q = t8_forest_partition_owner_of_element (mpisize, offset_new[mpirank],
+                                              offset_old);
+    if (q != mpirank) {
+      mpiret = sc_MPI_Recv (&recv_first, 1, T8_MPI_GLOIDX, q,
+                            T8_MPI_PARTITION_FAMILY_FOREST, comm,
+                            sc_MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+    }
+    else {
+      recv_first = new_first[mpirank - p_first];
+    }
+  }
+  mpiret = sc_MPI_Waitall (num_requests, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+
+  /* Build the new offset array */
+  t8_shmem_array_destroy (&forest->element_offsets);
+  t8_shmem_array_init (&forest->element_offsets, sizeof (t8_gloidx_t),
+                       mpisize + 1, comm);
+  t8_shmem_array_allgather (&recv_first, 1, T8_MPI_GLOIDX,
+                            forest->element_offsets, 1, T8_MPI_GLOIDX);
+  t8_shmem_array_set_gloidx (forest->element_offsets, mpisize,
+                             global_num_elements);
+
+  T8_FREE (new_first);
+  T8_FREE (windows);
+  T8_FREE (requests);
 }
 
 /* Populate a forest with the partitioned elements of
@@ -1193,17 +1730,22 @@ void
 t8_forest_partition (t8_forest_t forest)
 {
   t8_forest_t         forest_from;
-  int                 create_offset_from = 0;
+  int                 created_tables;
+  int                 skip;
 
-  t8_global_productionf ("Enter  forest partition.\n");
+  T8_GLOBAL_INFOF ("Enter  forest partition.\n");
   t8_log_indent_push ();
   T8_ASSERT (t8_forest_is_initialized (forest));
   forest_from = forest->set_from;
   T8_ASSERT (t8_forest_is_committed (forest_from));
+  /* The new offsets depend on the global number of elements */
+  (void) t8_forest_comm_global_num_elements_wait (forest_from);
 
   if (forest->profile != NULL) {
     /* If profiling is enabled, we measure the runtime of partition */
     forest->profile->partition_runtime = sc_MPI_Wtime ();
+    t8_counters_start (forest->profile->partition_counters);
+    t8_profile_memory_start (&forest->profile->partition_memory);
 
     /* DO NOT DELETE THE FOLLOWING line.
      * even if you do not want this output. It fixes a bug that occured on JUQUEEN, where the
@@ -1213,31 +1755,59 @@ t8_forest_partition (t8_forest_t forest)
                            forest->profile->partition_runtime);
   }
 
-  if (forest_from->element_offsets == NULL) {
-    /* We create the partition table of forest_from */
-    create_offset_from = 1;
-    t8_forest_partition_create_offsets (forest_from);
-  }
+  t8_trace_begin ("partition");
+  /* We need the partition table of forest_from */
+  t8_trace_begin ("partition_offsets");
+  created_tables =
+    t8_forest_partition_tables_require (forest_from,
+                                        T8_FOREST_TABLE_ELEMENT_OFFSETS);
   /* TODO: if offsets already exist on forest_from, check it for consistency */
 
   /* We now calculate the new element offsets */
-  t8_forest_partition_compute_new_offset (forest);
-  t8_forest_partition_given (forest, 0, NULL, NULL);
+  if (forest->set_partition_weight_fn != NULL
+      || forest->set_partition_weights != NULL
+      || t8_forest_partition_eclass_costs (forest) != NULL) {
+    skip = t8_forest_partition_compute_new_offset_weighted (forest);
+  }
+  else {
+    skip = t8_forest_partition_is_balanced (forest,
+                                            forest_from->local_num_elements,
+                                            forest_from->global_num_elements);
+    if (!skip) {
+      t8_forest_partition_compute_new_offset (forest);
+    }
+  }
+  t8_trace_end ("partition_offsets");
+  if (forest->profile != NULL) {
+    forest->profile->partition_skipped = skip;
+  }
+  if (skip) {
+    /* The load is balanced enough, we keep the partition */
+    t8_forest_partition_keep (forest);
+  }
+  else {
+    if (forest->set_for_coarsening > 0) {
+      /* Do not cut families of leaves */
+      t8_forest_partition_for_coarsening (forest);
+    }
+    t8_forest_partition_given (forest);
+  }
 
   T8_ASSERT ((size_t) t8_forest_get_num_local_trees (forest_from)
              == forest_from->trees->elem_count);
   T8_ASSERT ((size_t) t8_forest_get_num_local_trees (forest)
              == forest->trees->elem_count);
 
-  if (create_offset_from) {
-    /* Delete the offset memory that we allocated */
-    t8_shmem_array_destroy (&forest_from->element_offsets);
-  }
+  /* Delete the offset memory that we allocated */
+  t8_forest_partition_tables_release (forest_from, created_tables);
+  t8_trace_end ("partition");
 
   if (forest->profile != NULL) {
     /* If profiling is enabled, we measure the runtime of partition */
     forest->profile->partition_runtime = sc_MPI_Wtime () -
       forest->profile->partition_runtime;
+    t8_counters_stop (forest->profile->partition_counters);
+    t8_profile_memory_stop (&forest->profile->partition_memory);
 
     /* DO NOT DELETE THE FOLLOWING line.
      * even if you do not want this output. It fixes a bug that occured on JUQUEEN, where the
@@ -1248,21 +1818,98 @@ t8_forest_partition (t8_forest_t forest)
   }
 
   t8_log_indent_pop ();
-  t8_global_productionf ("Done forest partition.\n");
+  T8_GLOBAL_INFOF ("Done forest partition.\n");
 }
 
-void
-t8_forest_partition_data (t8_forest_t forest_from, t8_forest_t forest_to,
-                          const sc_array_t * data_in, sc_array_t * data_out)
+/* Compute the first and last rank in offset_to whose elements overlap
+ * with the elements of rank in offset_from. If rank has no elements in
+ * offset_from, last < first. */
+static void
+t8_forest_partition_overlap_range (int mpisize, int rank,
+                                   t8_gloidx_t * offset_from,
+                                   t8_gloidx_t * offset_to, int *first,
+                                   int *last)
 {
-  t8_forest_t         save_set_from;
+  t8_gloidx_t         first_element, last_element;
 
-  t8_global_productionf ("Enter forest partition data.\n");
-  t8_log_indent_push ();
+  first_element = t8_forest_partition_first_element (offset_from, rank);
+  last_element = t8_forest_partition_last_element (offset_from, rank);
+  if (last_element < first_element) {
+    *first = 0;
+    *last = -1;
+    return;
+  }
+  *first = t8_forest_partition_owner_of_element (mpisize, first_element,
+                                                 offset_to);
+  *last = t8_forest_partition_owner_of_element (mpisize, last_element,
+                                                offset_to);
+}
+
+/* Post the send or receive of the data of the elements that are on
+ * this process in offset_local and on iproc in offset_remote.
+ * data are the data of the local elements in offset_local.
+ * The number of bytes of the message is returned in num_bytes and the
+ * position of the first element in data in local_begin. If there are
+ * no such elements, the request is set to NULL and num_bytes to 0. */
+static void
+t8_forest_partition_data_post (t8_forest_t forest, int iproc, int is_send,
+                               t8_gloidx_t * offset_local,
+                               t8_gloidx_t * offset_remote,
+                               sc_array_t * data, char **local_begin,
+                               size_t * num_bytes, sc_MPI_Request * request)
+{
+  t8_gloidx_t         first, end;
+  int                 mpiret;
+
+  *request = sc_MPI_REQUEST_NULL;
+  *num_bytes = 0;
+  /* The intersection of our elements and the elements of iproc */
+  first = SC_MAX (offset_local[forest->mpirank], offset_remote[iproc]);
+  end = SC_MIN (offset_local[forest->mpirank + 1], offset_remote[iproc + 1]);
+  if (first >= end) {
+    return;
+  }
+  *local_begin = (char *) t8_sc_array_index_locidx (data, (t8_locidx_t)
+                                                    (first -
+                                                     offset_local
+                                                     [forest->mpirank]));
+  *num_bytes = (end - first) * data->elem_size;
+  if (iproc == forest->mpirank) {
+    /* We copy the data to ourselves without a message */
+    return;
+  }
+  if (is_send) {
+    mpiret = sc_MPI_Isend (*local_begin, *num_bytes, sc_MPI_BYTE, iproc,
+                           T8_MPI_PARTITION_DATA_FOREST, forest->mpicomm,
+                           request);
+    t8_peer_volume_send (T8_PEER_FOREST_PARTITION, iproc, *num_bytes);
+  }
+  else {
+    mpiret = sc_MPI_Irecv (*local_begin, *num_bytes, sc_MPI_BYTE, iproc,
+                           T8_MPI_PARTITION_DATA_FOREST, forest->mpicomm,
+                           request);
+    t8_peer_volume_receive (T8_PEER_FOREST_PARTITION, iproc, *num_bytes);
+  }
+  SC_CHECK_MPI (mpiret);
+}
+
+t8_forest_partition_data_exchange_t *
+t8_forest_partition_data_begin (t8_forest_t forest_from,
+                                t8_forest_t forest_to,
+                                const sc_array_t * data_in,
+                                sc_array_t * data_out)
+{
+  t8_forest_partition_data_exchange_t *exchange;
+  t8_gloidx_t        *offset_from, *offset_to;
+  int                 send_first, send_last, recv_first, recv_last;
+  int                 num_send, num_recv, iproc;
+  char               *send_begin, *recv_begin = NULL, *self_begin = NULL;
+  size_t              num_bytes, self_bytes = 0;
 
   /* Assertions */
   T8_ASSERT (t8_forest_is_committed (forest_from));
   T8_ASSERT (t8_forest_is_committed (forest_to));
+  T8_ASSERT (forest_from->mpisize == forest_to->mpisize);
   T8_ASSERT (data_in != NULL && data_out != NULL);
   T8_ASSERT (data_in->elem_size == data_out->elem_size);
 
@@ -1272,24 +1919,86 @@ t8_forest_partition_data (t8_forest_t forest_from, t8_forest_t forest_to,
   T8_ASSERT (data_out->elem_count == (size_t) forest_to->local_num_elements);
 
   /* Create partition tables if not existent yet */
-  if (forest_from->element_offsets == NULL) {
-    /* We create the partition table of forest_from */
-    t8_forest_partition_create_offsets (forest_from);
+  (void) t8_forest_partition_tables_require (forest_from,
+                                             T8_FOREST_TABLE_ELEMENT_OFFSETS);
+  (void) t8_forest_partition_tables_require (forest_to,
+                                             T8_FOREST_TABLE_ELEMENT_OFFSETS);
+  offset_from = t8_shmem_array_get_gloidx_array (forest_from->element_offsets);
+  offset_to = t8_shmem_array_get_gloidx_array (forest_to->element_offsets);
+
+  /* The ranks that we send to and receive from */
+  t8_forest_partition_overlap_range (forest_to->mpisize, forest_to->mpirank,
+                                     offset_from, offset_to, &send_first,
+                                     &send_last);
+  t8_forest_partition_overlap_range (forest_to->mpisize, forest_to->mpirank,
+                                     offset_to, offset_from, &recv_first,
+                                     &recv_last);
+  num_send = SC_MAX (send_last - send_first + 1, 0);
+  num_recv = SC_MAX (recv_last - recv_first + 1, 0);
+
+  exchange = T8_ALLOC (t8_forest_partition_data_exchange_t, 1);
+  exchange->num_requests = num_recv + num_send;
+  exchange->requests =
+    T8_ALLOC (sc_MPI_Request, SC_MAX (exchange->num_requests, 1));
+
+  /* Post all receives directly into data_out, then all sends directly
+   * from data_in. Since the number of elements from each rank is known
+   * from the offsets, we do not need to probe. */
+  for (iproc = recv_first; iproc <= recv_last; iproc++) {
+    t8_forest_partition_data_post (forest_to, iproc, 0, offset_to,
+                                   offset_from, data_out, &recv_begin,
+                                   &num_bytes,
+                                   exchange->requests + iproc - recv_first);
+    if (iproc == forest_to->mpirank) {
+      self_begin = num_bytes > 0 ? recv_begin : NULL;
+    }
   }
-
-  if (forest_to->element_offsets == NULL) {
-    /* We create the partition table of forest_to */
-    t8_forest_partition_create_offsets (forest_to);
+  for (iproc = send_first; iproc <= send_last; iproc++) {
+    t8_forest_partition_data_post (forest_to, iproc, 1, offset_from,
+                                   offset_to, (sc_array_t *) data_in,
+                                   &send_begin, &num_bytes,
+                                   exchange->requests + num_recv + iproc -
+                                   send_first);
+    if (iproc == forest_to->mpirank && num_bytes > 0) {
+      /* Copy the data that stays on this process */
+      T8_ASSERT (self_begin != NULL);
+      self_bytes = num_bytes;
+      memcpy (self_begin, send_begin, self_bytes);
+    }
   }
+  T8_ASSERT (self_bytes > 0 || self_begin == NULL);
+  return exchange;
+}
+
+void
+t8_forest_partition_data_end (t8_forest_partition_data_exchange_t *
+                              exchange)
+{
+  int                 mpiret;
+
+  T8_ASSERT (exchange != NULL);
+  mpiret = sc_MPI_Waitall (exchange->num_requests, exchange->requests,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (exchange->requests);
+  T8_FREE (exchange);
+}
+
+void
+t8_forest_partition_data (t8_forest_t forest_from, t8_forest_t forest_to,
+                          const sc_array_t * data_in, sc_array_t * data_out)
+{
+  t8_forest_partition_data_exchange_t *exchange;
+
+  T8_GLOBAL_INFOF ("Enter forest partition data.\n");
+  t8_log_indent_push ();
 
-  /* perform the actual partitioning */
-  save_set_from = forest_to->set_from;
-  forest_to->set_from = forest_from;
-  t8_forest_partition_given (forest_to, 1, data_in, data_out);
-  forest_to->set_from = save_set_from;
+  exchange = t8_forest_partition_data_begin (forest_from, forest_to,
+                                             data_in, data_out);
+  t8_forest_partition_data_end (exchange);
 
   t8_log_indent_pop ();
-  t8_global_productionf ("Done forest partition data.\n");
+  T8_GLOBAL_INFOF ("Done forest partition data.\n");
 }
 
 T8_EXTERN_C_END ();
@@ -33,6 +33,23 @@
 #include <t8_forest.h>
 
 T8_EXTERN_C_BEGIN ();
+
+/** The partition tables of a committed forest. They are combined bitwise
+ * in \ref t8_forest_partition_tables_require. */
+typedef enum t8_forest_partition_table
+{
+  T8_FOREST_TABLE_ELEMENT_OFFSETS = 1, /**< The element offsets of all processes. */
+  T8_FOREST_TABLE_FIRST_DESC = 2,      /**< The first descendant of each process. */
+  T8_FOREST_TABLE_TREE_OFFSETS = 4,    /**< The first tree of each process. */
+  T8_FOREST_TABLE_ALL = 7              /**< All partition tables. */
+}
+t8_forest_partition_table_t;
+
+/** The state of an element data exchange between two partitions of a forest,
+ * started by \ref t8_forest_partition_data_begin. */
+typedef struct t8_forest_partition_data_exchange
+  t8_forest_partition_data_exchange_t;
+
 /* TODO: document */
 void                t8_forest_partition (t8_forest_t forest);
 
@@ -69,6 +86,45 @@ void                t8_forest_partition_create_first_desc (t8_forest_t
 void                t8_forest_partition_create_tree_offsets (t8_forest_t
                                                              forest);
 
+/** Make sure that partition tables of a committed forest exist.
+ * The tables that do not exist are computed once and kept with the forest,
+ * such that each table is computed at most once per forest unless it is
+ * released. If profiling is enabled, the profile counts the computations.
+ * \param [in,out]  forest  The forest.
+ * \param [in]      tables  The required tables, a bitwise or of
+ *                          \ref t8_forest_partition_table_t values.
+ * \return                  The tables that were computed by this call.
+ * This function is collective over the communicator of \a forest.
+ */
+int                 t8_forest_partition_tables_require (t8_forest_t forest,
+                                                        int tables);
+
+/** Free partition tables of a forest, usually the ones that were returned by
+ * \ref t8_forest_partition_tables_require.
+ * \param [in,out]  forest  The forest.
+ * \param [in]      tables  A bitwise or of \ref t8_forest_partition_table_t
+ *                          values. Tables that do not exist are ignored.
+ * This function is collective over the communicator of \a forest.
+ */
+void                t8_forest_partition_tables_release (t8_forest_t forest,
+                                                        int tables);
+
+/** Copy partition tables from a forest to a forest derived from it, if the
+ * tables of both forests are equal. The copies do not need communication.
+ * \param [in,out]  forest      A forest whose tables do not exist yet.
+ * \param [in]      forest_from A committed forest.
+ * \param [in]      tables      The tables that are equal for both forests,
+ *                              a bitwise or of
+ *                              \ref t8_forest_partition_table_t values.
+ *                              Tables that \a forest_from does not have
+ *                              are not copied.
+ * This function is collective over the communicator of \a forest.
+ */
+void                t8_forest_partition_tables_inherit (t8_forest_t forest,
+                                                        t8_forest_t
+                                                        forest_from,
+                                                        int tables);
+
 /* TODO: document */
 /* data_in has length forest_from->num_local_elements
  * data_out   --  --  forest_to->num_local_elements
@@ -78,6 +134,38 @@ void                t8_forest_partition_data (t8_forest_t forest_from,
                                               const sc_array_t * data_in,
                                               sc_array_t * data_out);
 
+/** Start to move the data of the elements of a forest to a repartitioned
+ * forest, see \ref t8_forest_partition_data.
+ * All messages are posted and the call returns without waiting for them.
+ * The data is sent directly from \a data_in and received directly into
+ * \a data_out. Both arrays must not be changed or freed until
+ * \ref t8_forest_partition_data_end is called.
+ * Several exchanges may be active at the same time, if all processes
+ * begin them in the same order.
+ * \param [in]     forest_from The forest with the old partition.
+ * \param [in]     forest_to   The forest with the new partition.
+ * \param [in]     data_in     The data of the local elements of \a forest_from.
+ * \param [in,out] data_out    An array of the same element size with one
+ *                             entry for each local element of \a forest_to.
+ *                             Filled with the data when the exchange ends.
+ * \return                     The exchange that must be passed to
+ *                             \ref t8_forest_partition_data_end.
+ * This call is collective if the element offsets of the forests do not
+ * exist yet.
+ */
+t8_forest_partition_data_exchange_t *t8_forest_partition_data_begin
+  (t8_forest_t forest_from, t8_forest_t forest_to,
+   const sc_array_t * data_in, sc_array_t * data_out);
+
+/** Wait for an element data exchange to complete and free it.
+ * \param [in,out] exchange    An exchange returned by
+ *                             \ref t8_forest_partition_data_begin.
+ *                             It is invalid after this call.
+ * On output, the \a data_out array of the exchange is filled.
+ */
+void                t8_forest_partition_data_end
+  (t8_forest_partition_data_exchange_t * exchange);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_FOREST_PARTITION_H! */
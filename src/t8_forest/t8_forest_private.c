@@ -42,3 +42,117 @@ t8_forest_get_tree_element_array (t8_forest_t forest, t8_locidx_t ltreeid)
 
   return &t8_forest_get_tree (forest, ltreeid)->elements;
 }
+
+#ifdef SC_ENABLE_MPI
+/* A message received by t8_forest_exchange_sparse */
+typedef struct
+{
+  int                 source;
+  size_t              offset;
+  size_t              size;
+} t8_forest_sparse_message_t;
+
+static int
+t8_forest_sparse_message_compare (const void *a, const void *b)
+{
+  const t8_forest_sparse_message_t *ma =
+    (const t8_forest_sparse_message_t *) a;
+  const t8_forest_sparse_message_t *mb =
+    (const t8_forest_sparse_message_t *) b;
+
+  return ma->source < mb->source ? -1 : ma->source > mb->source;
+}
+#endif
+
+void
+t8_forest_exchange_sparse (sc_MPI_Comm comm, int tag, int num_targets,
+                           const int *targets, const char *send_buffer,
+                           const size_t *send_offsets,
+                           sc_array_t * recv_buffer)
+{
+#ifdef SC_ENABLE_MPI
+  MPI_Request        *requests, barrier;
+  MPI_Status          status;
+  sc_array_t          messages, unsorted;
+  t8_forest_sparse_message_t *message;
+  int                 itarget, flag, count, barrier_active = 0, done = 0;
+  int                 mpiret;
+  size_t              imessage, first;
+
+  T8_ASSERT (recv_buffer != NULL && recv_buffer->elem_size == 1);
+
+  requests = T8_ALLOC (MPI_Request, SC_MAX (num_targets, 1));
+  for (itarget = 0; itarget < num_targets; itarget++) {
+    T8_ASSERT (send_offsets[itarget + 1] - send_offsets[itarget]
+               <= (size_t) INT_MAX);
+    mpiret = MPI_Issend ((void *) (send_buffer + send_offsets[itarget]),
+                         (int) (send_offsets[itarget + 1]
+                                - send_offsets[itarget]), MPI_BYTE,
+                         targets[itarget], tag, comm, requests + itarget);
+    SC_CHECK_MPI (mpiret);
+  }
+  /* We receive the messages in the order of their arrival */
+  sc_array_init (&messages, sizeof (t8_forest_sparse_message_t));
+  sc_array_init (&unsorted, 1);
+  while (!done) {
+    mpiret = MPI_Iprobe (MPI_ANY_SOURCE, tag, comm, &flag, &status);
+    SC_CHECK_MPI (mpiret);
+    if (flag) {
+      mpiret = MPI_Get_count (&status, MPI_BYTE, &count);
+      SC_CHECK_MPI (mpiret);
+      message = (t8_forest_sparse_message_t *) sc_array_push (&messages);
+      message->source = status.MPI_SOURCE;
+      message->offset = unsorted.elem_count;
+      message->size = count;
+      sc_array_resize (&unsorted, unsorted.elem_count + count);
+      mpiret = MPI_Recv (unsorted.array + message->offset, count, MPI_BYTE,
+                         status.MPI_SOURCE, tag, comm, MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+    }
+    if (!barrier_active) {
+      /* Once all our messages are received we enter the barrier */
+      mpiret = MPI_Testall (num_targets, requests, &flag,
+                            MPI_STATUSES_IGNORE);
+      SC_CHECK_MPI (mpiret);
+      if (flag) {
+        mpiret = MPI_Ibarrier (comm, &barrier);
+        SC_CHECK_MPI (mpiret);
+        barrier_active = 1;
+      }
+    }
+    else {
+      mpiret = MPI_Test (&barrier, &done, MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  T8_FREE (requests);
+
+  /* Append the messages in the order of the senders */
+  sc_array_sort (&messages, t8_forest_sparse_message_compare);
+  first = recv_buffer->elem_count;
+  sc_array_resize (recv_buffer, first + unsorted.elem_count);
+  for (imessage = 0; imessage < messages.elem_count; imessage++) {
+    message =
+      (t8_forest_sparse_message_t *) sc_array_index (&messages, imessage);
+    memcpy (recv_buffer->array + first, unsorted.array + message->offset,
+            message->size);
+    first += message->size;
+  }
+  sc_array_reset (&messages);
+  sc_array_reset (&unsorted);
+#else
+  /* There is only one process, which may send to itself */
+  int                 itarget;
+  size_t              first;
+
+  for (itarget = 0; itarget < num_targets; itarget++) {
+    T8_ASSERT (targets[itarget] == 0);
+    first = recv_buffer->elem_count;
+    sc_array_resize (recv_buffer, first + send_offsets[itarget + 1]
+                     - send_offsets[itarget]);
+    memcpy (recv_buffer->array + first,
+            send_buffer + send_offsets[itarget],
+            send_offsets[itarget + 1] - send_offsets[itarget]);
+  }
+#endif
+}
@@ -32,6 +32,7 @@
 
 #include <t8.h>
 #include <t8_forest.h>
+#include <t8_forest/t8_forest_bvh.h>
 
 T8_EXTERN_C_BEGIN ();
 
@@ -44,6 +45,27 @@ void                t8_forest_compute_desc (t8_forest_t forest);
  * of the coarse mesh. */
 void                t8_forest_populate (t8_forest_t forest);
 
+/* Create the elements on this process by reading the range of elements
+ * from the file set with t8_forest_set_load. */
+void                t8_forest_load_elements (t8_forest_t forest);
+
+/* Create the elements on this process from the leaves set with
+ * t8_forest_set_leaves and check that the leaves of all processes
+ * form a partition of the forest. */
+void                t8_forest_populate_leaves (t8_forest_t forest);
+
+/** Query whether the specialized element kernels can be used for a forest.
+ * This is the case if all trees of the coarse mesh have the same element class,
+ * the scheme of this class is a default scheme and not a class derived
+ * from it, and the kernels were not disabled
+ * with \ref t8_forest_set_specialized_kernels.
+ * \param [in]      forest  A forest with cmesh and scheme set.
+ * \return          The element class of all trees if the kernels can be used.
+ *                  T8_ECLASS_COUNT otherwise.
+ * \see t8_forest_kernels.hxx
+ */
+t8_eclass_t         t8_forest_get_kernel_eclass (t8_forest_t forest);
+
 /** Return the eclass scheme of a given element class associated to a forest.
  * This function does not check whether the given forest is committed, use with
  * caution and only if you are sure that the eclass_scheme was set.
@@ -88,6 +110,16 @@ int                 t8_forest_min_nonempty_level (t8_cmesh_t cmesh,
  */
 int                 t8_forest_first_tree_shared (t8_forest_t forest);
 
+/** Complete the reduction started by \ref t8_forest_comm_global_num_elements,
+ * if it is still pending.
+ * Unlike \ref t8_forest_get_global_num_elements, the forest does not need
+ * to be committed.
+ * \param [in,out] forest    The forest.
+ * \return                   The global number of elements of \a forest.
+ */
+t8_gloidx_t         t8_forest_comm_global_num_elements_wait (t8_forest_t
+                                                             forest);
+
 /** return nonzero if the last tree of a forest is shared with a bigger
  * process.
  * This is the case if and only if the first descendant of the first tree that we store is
@@ -100,13 +132,87 @@ int                 t8_forest_first_tree_shared (t8_forest_t forest);
 int                 t8_forest_last_tree_shared (t8_forest_t forest);
 
 /* Allocate memory for trees and set their values as in from.
- * For each tree allocate enough element memory to fit the elements of from.
- * If copy_elements is true, copy the elements of from into the element memory.
+ * If copy_elements is true, the trees share the elements of from,
+ * see t8_forest_tree_share. Otherwise their element arrays are empty.
  */
 void                t8_forest_copy_trees (t8_forest_t forest,
                                           t8_forest_t from,
                                           int copy_elements);
 
+/* Move the trees and elements of from to forest without copying them.
+ * Afterwards from has no trees and may only be destroyed.
+ */
+void                t8_forest_move_trees (t8_forest_t forest,
+                                          t8_forest_t from);
+
+/* Allocate the element storage of all local trees of a forest from one
+ * arena, that is released with the trees. The element array of each tree is
+ * initialized as a view of num_tree_elements[itree] initialized elements
+ * and must not be resized. The eclass of each tree must be set.
+ */
+void                t8_forest_trees_alloc_arena (t8_forest_t forest,
+                                                 const t8_locidx_t *
+                                                 num_tree_elements);
+
+/* Move the elements of all local trees of a forest that own their element
+ * array into one arena. Afterwards the element arrays must not be resized.
+ */
+void                t8_forest_trees_pack (t8_forest_t forest);
+
+/* Free the memory of each local tree's element array that is allocated
+ * beyond its element count. Trees that share their elements are not
+ * changed. \see t8_forest_set_trim_elements
+ */
+void                t8_forest_trees_trim (t8_forest_t forest);
+
+/* Let a local tree of a forest share the elements of a local tree of
+ * another, committed forest, instead of copying them. The element array
+ * of the tree becomes a view into the arena of from, which is kept alive
+ * by forest. If the tree of from owns its elements, for example since from
+ * trimmed its trees, they are copied instead. The eclass of the tree must
+ * be set and its element array must be uninitialized or reset.
+ */
+void                t8_forest_tree_share (t8_forest_t forest,
+                                          t8_locidx_t ltree_id,
+                                          t8_forest_t from,
+                                          t8_locidx_t from_ltree_id);
+
+/* Return a local tree of a forest without creating the elements of an
+ * implicit tree. Only the members other than the elements may be read,
+ * see t8_forest_get_tree_element_count for the number of elements.
+ * \see t8_forest_set_implicit_uniform
+ */
+t8_tree_t           t8_forest_get_tree_lazy (t8_forest_t forest,
+                                             t8_locidx_t ltree_id);
+
+/* Create the elements of an implicit tree of a forest and store them in
+ * its element array, which must be empty. The tree stays implicit, such
+ * that forests that share it do not copy the elements.
+ */
+void                t8_forest_tree_materialize (t8_forest_t forest,
+                                                t8_tree_t tree);
+
+/* Create the elements of an implicit tree of a forest in an uninitialized
+ * element array, without changing the tree.
+ */
+void                t8_forest_tree_implicit_elements (t8_forest_t forest,
+                                                      t8_tree_t tree,
+                                                      t8_element_array_t *
+                                                      telements);
+
+/* Compute an element of an implicit tree of a forest in memory for one
+ * element of the tree's scheme. The element is initialized by this call.
+ * \param [in] index  The index of the element in the tree.
+ */
+void                t8_forest_tree_implicit_element (t8_forest_t forest,
+                                                     t8_tree_t tree,
+                                                     t8_locidx_t index,
+                                                     t8_element_t * element);
+
+/* Release the element arenas of a forest, after its trees were reset.
+ */
+void                t8_forest_trees_release_arenas (t8_forest_t forest);
+
 /** Given the local id of a tree in a forest, return the coarse tree of the
  * cmesh that corresponds to this tree, also return the neighbor information of
  * the tree.
@@ -230,6 +336,33 @@ int                 t8_forest_element_find_owner_ext (t8_forest_t forest,
                                                       int guess,
                                                       int element_is_desc);
 
+/** Find the owner processes of many elements of one tree at once.
+ * The owner of each element is found as with \ref t8_forest_element_find_owner.
+ * If the elements are sorted in SFC order, we walk along the partition
+ * table. All elements that lie on the same process as their predecessor
+ * are resolved with a constant time check, and a search is only needed
+ * when the owner changes. Unsorted elements give the same result, but
+ * need more searches.
+ * \param [in]    forest  The forest.
+ * \param [in]    gtreeid The global id of the tree in which the elements lie.
+ * \param [in]    elements An array of \a num_elements elements of this tree.
+ * \param [in]    eclass  The element class of the tree \a gtreeid.
+ * \param [in]    num_elements The number of elements.
+ * \param [in]    elements_are_desc If true, each element is its own first
+ *                        descendant at the maximum level.
+ * \param [out]   owners  An array of \a num_elements integers. On output the
+ *                        mpirank of the owner of each element.
+ * \note \a forest must be committed before calling this function.
+ * \see t8_forest_element_find_owner
+ */
+void                t8_forest_element_find_owners (t8_forest_t forest,
+                                                   t8_gloidx_t gtreeid,
+                                                   t8_element_t ** elements,
+                                                   t8_eclass_t eclass,
+                                                   int num_elements,
+                                                   int elements_are_desc,
+                                                   int *owners);
+
 /** Perform a constant runtime check if a given rank is owner of a given element.
  * If the element is owned by more than one rank, then this check is only true
  * for the smallest.
@@ -444,6 +577,100 @@ void                t8_forest_leaf_face_neighbors (t8_forest_t forest,
                                                    pneigh_scheme,
                                                    int forest_is_balanced);
 
+/** Compute the leaf face neighbors of a forest into buffers of the caller.
+ * In contrast to \ref t8_forest_leaf_face_neighbors this function does not
+ * allocate, such that it can be called for each face in an inner loop.
+ * \param [in]    forest  The forest. Must have a valid ghost layer.
+ * \param [in]    ltreeid A local tree id.
+ * \param [in]    leaf    A leaf in tree \a ltreeid of \a forest.
+ * \param [in]    face    The index of the face across which the face neighbors
+ *                        are searched.
+ * \param [in]    capacity The length of the output arrays. Must be at least
+ *                        t8_element_num_face_children (\a leaf, \a face).
+ * \param [in,out] neighbor_leafs If not NULL, an array of \a capacity elements
+ *                        of the scheme of the neighbor tree
+ *                        (\see t8_forest_element_neighbor_eclass).
+ *                        On output the first entries are the neighbor leafs.
+ * \param [out]   dual_faces An array of \a capacity entries. On output the face
+ *                        id's of the neighboring elements' faces.
+ * \param [out]   element_indices An array of \a capacity entries. On output the
+ *                        element indices of the neighbor leafs as in
+ *                        \ref t8_forest_leaf_face_neighbors.
+ * \param [out]   pneigh_scheme On output the eclass scheme of the neighbor elements.
+ * \param [in]    forest_is_balanced True if we know that \a forest is balanced, false
+ *                        otherwise.
+ * \return                The number of neighbor leafs. 0 if there is no neighbor.
+ * \note Currently \a forest must be balanced.
+ * \note \a forest must be committed before calling this function.
+ */
+int                 t8_forest_leaf_face_neighbors_ext (t8_forest_t forest,
+                                                       t8_locidx_t ltreeid,
+                                                       const t8_element_t *
+                                                       leaf, int face,
+                                                       int capacity,
+                                                       t8_element_t *
+                                                       neighbor_leafs[],
+                                                       int dual_faces[],
+                                                       t8_locidx_t
+                                                       element_indices[],
+                                                       t8_eclass_scheme_c **
+                                                       pneigh_scheme,
+                                                       int
+                                                       forest_is_balanced);
+
+/** Compute the leaf face neighbors of a forest into the scratch arena.
+ * The output arrays are allocated with \ref t8_element_scratch_alloc and are
+ * valid until the caller releases a scratch mark that was set before.
+ * \param [in]    forest  The forest. Must have a valid ghost layer.
+ * \param [in]    ltreeid A local tree id.
+ * \param [in]    leaf    A leaf in tree \a ltreeid of \a forest.
+ * \param [in]    face    The index of the face across which the face neighbors
+ *                        are searched.
+ * \param [out]   pneighbor_leafs If not NULL, on output the neighbor leafs.
+ * \param [out]   pdual_faces On output the face id's of the neighboring
+ *                        elements' faces.
+ * \param [out]   pelement_indices On output the element indices of the
+ *                        neighbor leafs as in \ref t8_forest_leaf_face_neighbors.
+ * \param [out]   pneigh_scheme On output the eclass scheme of the neighbor
+ *                        elements.
+ * \return                The number of neighbor leafs. 0 if there is no neighbor.
+ * \note \a forest must be balanced and committed.
+ */
+int                 t8_forest_leaf_face_neighbors_scratch (t8_forest_t forest,
+                                                           t8_locidx_t
+                                                           ltreeid,
+                                                           const t8_element_t
+                                                           * leaf, int face,
+                                                           t8_element_t ***
+                                                           pneighbor_leafs,
+                                                           int **pdual_faces,
+                                                           t8_locidx_t **
+                                                           pelement_indices,
+                                                           t8_eclass_scheme_c
+                                                           ** pneigh_scheme);
+
+/** Prepare a forest for the computation of leaf face neighbors of all its
+ * leafs. We check that the forest has a ghost layer and create the partition
+ * tables if they are not present.
+ * We also store the linear ids of all leafs and ghosts, such that the
+ * neighbor leafs are found by a binary search over these ids instead of
+ * the elements.
+ * \param [in]    forest  A committed forest. It must not get a new ghost
+ *                        layer before \ref t8_forest_leaf_face_neighbors_end.
+ * \return                The tables that were created and have to be
+ *                        passed to \ref t8_forest_leaf_face_neighbors_end.
+ */
+int                 t8_forest_leaf_face_neighbors_begin (t8_forest_t forest);
+
+/** Destroy the partition tables and linear ids that
+ * \ref t8_forest_leaf_face_neighbors_begin created.
+ * \param [in]    forest  A committed forest.
+ * \param [in]    created_tables The return value of
+ *                        \ref t8_forest_leaf_face_neighbors_begin.
+ */
+void                t8_forest_leaf_face_neighbors_end (t8_forest_t forest,
+                                                       int created_tables);
+
 /** Iterate over all leafs of a forest and for each face compute the face neighbor
  * leafs with \ref t8_forest_leaf_face_neighbors and print their local element ids.
  * This function is meant for debugging only.
@@ -453,6 +680,177 @@ void                t8_forest_leaf_face_neighbors (t8_forest_t forest,
  */
 void                t8_forest_print_all_leaf_neighbors (t8_forest_t forest);
 
+/** Build the face connectivity table of a forest with
+ * \ref t8_forest_leaf_face_neighbors for each face of each local element.
+ * \param [in,out] forest The forest. It must be balanced and, if it lives
+ *                        on more than one process, have a ghost layer.
+ * \note \a forest must be committed before calling this function.
+ * \see t8_forest_set_face_connectivity
+ */
+void                t8_forest_face_connectivity_build (t8_forest_t forest);
+
+/** Free the face connectivity table of a forest.
+ * \param [in,out] forest The forest. Its table must exist.
+ */
+void                t8_forest_face_connectivity_destroy (t8_forest_t forest);
+
+/** Compute the corner coordinates of a range of leafs of a local tree, as
+ * \ref t8_forest_tree_leaf_corner_coordinates does for all leafs.
+ * \param [in]      forest     The forest.
+ * \param [in]      ltree_id   The forest local id of the tree.
+ * \param [in]      leafs      The leaf elements of the tree.
+ * \param [in]      first      The index of the first leaf of the range.
+ * \param [in]      num_leafs  The number of leafs of the range.
+ * \param [out]     x          On output the x coordinate of the j-th corner
+ *                             of the i-th leaf of the range is
+ *                             x[i * num_corners + j].
+ * \param [out]     y          As \a x for the y coordinates.
+ * \param [out]     z          As \a x for the z coordinates.
+ * \note The vertex coordinates of the tree must be stored in the cmesh.
+ */
+void                t8_forest_leaf_range_corner_coordinates (t8_forest_t
+                                                             forest,
+                                                             t8_locidx_t
+                                                             ltree_id,
+                                                             t8_element_array_t
+                                                             * leafs,
+                                                             t8_locidx_t
+                                                             first,
+                                                             t8_locidx_t
+                                                             num_leafs,
+                                                             double *x,
+                                                             double *y,
+                                                             double *z);
+
+/** Compute the geometry cache of a forest.
+ * \param [in,out] forest The forest. The vertices of all local trees must
+ *                        be stored in its cmesh.
+ * \note \a forest must be committed before calling this function.
+ * \see t8_forest_set_geometry_cache
+ */
+void                t8_forest_geometry_cache_build (t8_forest_t forest);
+
+/** Free the geometry cache of a forest.
+ * \param [in,out] forest The forest. Its cache must exist.
+ */
+void                t8_forest_geometry_cache_destroy (t8_forest_t forest);
+
+/** Compute the connections of all faces of the local trees of a forest to
+ * their neighbor trees, such that \ref t8_forest_element_face_neighbor does
+ * not need to decode them from the cmesh.
+ * \param [in,out] forest The forest.
+ * \note \a forest must be committed before calling this function.
+ */
+void                t8_forest_tree_faces_build (t8_forest_t forest);
+
+/** Compute the maps of all local and ghost trees of a forest.
+ * \param [in,out] forest The forest. Trees without vertices or of a class
+ *                        without a multilinear map get no map.
+ * \note \a forest must be committed before calling this function.
+ */
+void                t8_forest_tree_maps_build (t8_forest_t forest);
+
+/** Return the precomputed map of a local or ghost tree.
+ * \param [in] forest    A committed forest.
+ * \param [in] ltreeid   A local tree id, or the number of local trees plus
+ *                       a ghost tree id.
+ * \return               The map of the tree, or NULL if the tree has none.
+ */
+const t8_forest_tree_map_t *t8_forest_get_tree_map (t8_forest_t forest,
+                                                    t8_locidx_t ltreeid);
+
+/** Evaluate the map of a tree at reference coordinates.
+ * \param [in]  map      A tree map.
+ * \param [in]  ref      The reference coordinates in [0,1]^dim.
+ *                       The entries beyond the dimension are ignored.
+ * \param [out] x        The physical coordinates.
+ */
+void                t8_forest_tree_map_evaluate (const t8_forest_tree_map_t *
+                                                 map, const double ref[3],
+                                                 double x[3]);
+
+/** Evaluate the Jacobian of the map of a tree at reference coordinates.
+ * \param [in]  map      A tree map.
+ * \param [in]  ref      The reference coordinates in [0,1]^dim.
+ * \param [out] J        Entry [i][j] is the derivative of coordinate i by
+ *                       reference coordinate j.
+ */
+void                t8_forest_tree_map_jacobian (const t8_forest_tree_map_t *
+                                                 map, const double ref[3],
+                                                 double J[3][3]);
+
+/** Build the bounding volume hierarchy over the local and ghost trees of a
+ * forest from the vertices of the trees.
+ * \param [in,out] forest The forest. Trees without vertices are left out.
+ * \note \a forest must be committed before calling this function.
+ * \see t8_forest_set_tree_bvh
+ */
+void                t8_forest_tree_bvh_build (t8_forest_t forest);
+
+/** Free the bounding volume hierarchy of a forest.
+ * \param [in,out] forest The forest. Its hierarchy must exist.
+ */
+void                t8_forest_tree_bvh_destroy (t8_forest_t forest);
+
+/** Build a bounding volume hierarchy over a given array of boxes.
+ * \param [in] num_boxes  The number of boxes.
+ * \param [in] boxes      6 doubles per box, allocated with T8_ALLOC.
+ *                        The hierarchy takes ownership of the array.
+ *                        Boxes with a minimum larger than their maximum
+ *                        are left out.
+ * \return                The hierarchy. The search callbacks get the index
+ *                        of a box as tree id.
+ */
+t8_forest_tree_bvh_t *t8_forest_tree_bvh_new_boxes (t8_locidx_t num_boxes,
+                                                    double *boxes);
+
+/** Free a bounding volume hierarchy created with
+ * \ref t8_forest_tree_bvh_new_boxes.
+ * \param [in,out] pbvh  The hierarchy. Set to NULL on output.
+ */
+void                t8_forest_tree_bvh_free (t8_forest_tree_bvh_t ** pbvh);
+
+/** Call a function for each box of a hierarchy that contains a point.
+ * \param [in] bvh        A hierarchy.
+ * \param [in] forest     Passed to \a callback.
+ * \param [in] point      The x, y and z coordinates of the point.
+ * \param [in] tolerance  A relative tolerance,
+ *                        see \ref t8_forest_tree_bvh_search_point.
+ * \param [in] callback   Called for each box that is found.
+ * \param [in] user_data  Passed to \a callback.
+ * \return                False if \a callback stopped the search, true otherwise.
+ * This function does not allocate and can be called by several threads.
+ */
+int                 t8_forest_tree_bvh_search_point_ext (const
+                                                         t8_forest_tree_bvh_t
+                                                         * bvh,
+                                                         t8_forest_t forest,
+                                                         const double
+                                                         point[3],
+                                                         double tolerance,
+                                                         t8_forest_tree_bvh_fn
+                                                         callback,
+                                                         void *user_data);
+
+/** Move the element fields of a forest to a forest that was committed
+ * from it, see \ref t8_forest_fields.h.
+ * \param [in,out] forest_new  The new forest. It has no fields yet.
+ * \param [in]     forest_old  The forest with fields that \a forest_new was
+ *                             derived from in one step.
+ * \param [in]     from_method The step, T8_FOREST_FROM_COPY,
+ *                             T8_FOREST_FROM_ADAPT, T8_FOREST_FROM_PARTITION
+ *                             or T8_FOREST_FROM_BALANCE without repartition.
+ * \note \a forest_new must be committed and have its ghost layer, if any.
+ */
+void                t8_forest_fields_transfer (t8_forest_t forest_new,
+                                               t8_forest_t forest_old,
+                                               int from_method);
+
+/** Free the element fields of a forest.
+ * \param [in,out] forest The forest. Its fields must exist.
+ */
+void                t8_forest_fields_destroy (t8_forest_t forest);
+
 /** Compute whether for a given element there exist leaf or ghost leaf elements in
  * the local forest that are a descendant of the element but not the element itself
  * \param [in]  forest    The forest.
@@ -470,6 +868,51 @@ int                 t8_forest_element_has_leaf_desc (t8_forest_t forest,
                                                      element,
                                                      t8_eclass_scheme_c * ts);
 
+/** Find the local leaf that is an ancestor of a given element or equal to it.
+ * \param [in]  forest    The forest.
+ * \param [in]  ltreeid   The local id of the tree the element is in.
+ * \param [in]  element   The element.
+ * \param [in]  ts        The eclass scheme of \a element.
+ * \return                The index in the tree \a ltreeid of the local leaf that
+ *                        is an ancestor of \a element or \a element itself.
+ *                        -1 if there is no such local leaf, for example if
+ *                        \a element is refined in the forest or if it lies
+ *                        in the partition of another process.
+ * \note \a forest must be committed before calling this function.
+ */
+t8_locidx_t         t8_forest_leaf_ancestor_index (t8_forest_t forest,
+                                                   t8_locidx_t ltreeid,
+                                                   const t8_element_t *
+                                                   element,
+                                                   t8_eclass_scheme_c * ts);
+
+/** Send messages to processes that do not know that they receive them and
+ * receive all messages that are sent to this process.
+ * We use a nonblocking consensus: after all our synchronous sends are
+ * matched we enter a nonblocking barrier and receive until the barrier is
+ * complete. The number of messages of a process does not depend on the
+ * number of processes.
+ * This function is collective over \a comm.
+ * \param [in]  comm        The communicator.
+ * \param [in]  tag         The tag of the messages.
+ * \param [in]  num_targets The number of messages that we send.
+ * \param [in]  targets     The rank of each message. A rank may be this
+ *                          process.
+ * \param [in]  send_buffer The messages one after the other.
+ * \param [in]  send_offsets The message to targets[i] starts at byte
+ *                          send_offsets[i] of \a send_buffer and ends before
+ *                          send_offsets[i + 1]. \a num_targets + 1 entries.
+ * \param [in,out] recv_buffer An array of element size 1. On output the
+ *                          received messages are appended in the order of
+ *                          their senders' ranks.
+ */
+void                t8_forest_exchange_sparse (sc_MPI_Comm comm, int tag,
+                                               int num_targets,
+                                               const int *targets,
+                                               const char *send_buffer,
+                                               const size_t *send_offsets,
+                                               sc_array_t * recv_buffer);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_FOREST_PRIVATE_H! */
@@ -0,0 +1,364 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_save.cxx
+ *
+ * We define routines to save a forest with element data to a single file
+ * and to restore it from there.
+ * The file starts with a header and the element offsets of the saving
+ * processes. Then follows one fixed-size record per element and the
+ * element data, both sorted by global element index. Thus, any range of
+ * elements maps to a contiguous byte range that each process can access
+ * without reading the rest of the file.
+ */
+
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_data/t8_file.h>
+#include <t8_element_cxx.hxx>
+
+T8_EXTERN_C_BEGIN ();
+
+#define T8_FOREST_SAVE_MAGIC "T8FOREST"
+#define T8_FOREST_SAVE_FORMAT 0x0001
+
+typedef struct
+{
+  char                magic[8];         /**< T8_FOREST_SAVE_MAGIC without the terminating 0 */
+  int32_t             format;           /**< T8_FOREST_SAVE_FORMAT */
+  int32_t             record_size;      /**< The size of an element record in bytes */
+  int32_t             dimension;        /**< The dimension of the forest */
+  int32_t             mpisize;          /**< The number of saving processes */
+  int64_t             global_num_trees; /**< The number of trees of the cmesh */
+  int64_t             global_num_elements;      /**< The number of elements */
+  int64_t             data_size;        /**< The number of data bytes per element */
+  int64_t             record_offset;    /**< The position of the first record */
+  int64_t             data_offset;      /**< The position of the first element data */
+} t8_forest_save_header_t;
+
+typedef struct
+{
+  int64_t             gtree;            /**< The global id of the element's tree */
+  uint64_t            linear_id;        /**< The linear id of the element at its level */
+  int32_t             level;            /**< The level of the element */
+  int32_t             padding;
+} t8_forest_save_record_t;
+
+/* Fill the header of a file for a forest and a data size */
+static void
+t8_forest_save_fill_header (t8_forest_t forest, size_t data_size,
+                            t8_forest_save_header_t * header)
+{
+  memset (header, 0, sizeof (*header));
+  memcpy (header->magic, T8_FOREST_SAVE_MAGIC, sizeof (header->magic));
+  header->format = T8_FOREST_SAVE_FORMAT;
+  header->record_size = sizeof (t8_forest_save_record_t);
+  header->dimension = forest->dimension;
+  header->mpisize = forest->mpisize;
+  header->global_num_trees = forest->global_num_trees;
+  header->global_num_elements = t8_forest_get_global_num_elements (forest);
+  header->data_size = data_size;
+  header->record_offset = sizeof (*header)
+    + (forest->mpisize + 1) * sizeof (int64_t);
+  header->data_offset = header->record_offset
+    + header->global_num_elements * header->record_size;
+}
+
+/* Read the header of an open file on all processes and check
+ * whether it is valid. */
+static int
+t8_forest_save_read_header (t8_file_t * file,
+                            t8_forest_save_header_t * header)
+{
+  int                 ok;
+
+  ok = t8_file_read_at (file, 1, 0, header, 1, sizeof (*header));
+  return ok && !memcmp (header->magic, T8_FOREST_SAVE_MAGIC,
+                        sizeof (header->magic))
+    && header->format == T8_FOREST_SAVE_FORMAT
+    && header->record_size == (int32_t) sizeof (t8_forest_save_record_t)
+    && header->mpisize > 0 && header->global_num_elements >= 0
+    && header->data_size >= 0
+    && header->record_offset == (int64_t) (sizeof (*header)
+                                           + (header->mpisize + 1)
+                                           * sizeof (int64_t))
+    && header->data_offset == header->record_offset
+    + header->global_num_elements * header->record_size;
+}
+
+/* Compute the logical and of a flag on all processes */
+static int
+t8_forest_save_all_ok (int ok, sc_MPI_Comm comm)
+{
+  int                 all_ok, mpiret;
+
+  mpiret = sc_MPI_Allreduce (&ok, &all_ok, 1, sc_MPI_INT, sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  return all_ok;
+}
+
+int
+t8_forest_save (t8_forest_t forest, const char *filename,
+                const void *element_data, size_t data_size)
+{
+  t8_forest_save_header_t header;
+  t8_forest_save_record_t *records, *record;
+  t8_file_t           file;
+  t8_gloidx_t        *offsets, num_local_elements;
+  t8_locidx_t         itree, num_local_trees, ielem, num_elems;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *element;
+  int                 iproc, mpiret, ok;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (element_data != NULL || data_size == 0);
+  if (forest->comm_idle) {
+    /* The processes with elements save the forest */
+    return 1;
+  }
+
+  /* Gather the element offsets of all processes */
+  offsets = T8_ALLOC (t8_gloidx_t, forest->mpisize + 1);
+  num_local_elements = forest->local_num_elements;
+  offsets[0] = 0;
+  mpiret = sc_MPI_Allgather (&num_local_elements, 1, T8_MPI_GLOIDX,
+                             offsets + 1, 1, T8_MPI_GLOIDX,
+                             forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  for (iproc = 0; iproc < forest->mpisize; iproc++) {
+    offsets[iproc + 1] += offsets[iproc];
+  }
+  T8_ASSERT (offsets[forest->mpisize] ==
+             t8_forest_get_global_num_elements (forest));
+
+  /* Store the tree, level and linear id of each local element */
+  records = T8_ALLOC_ZERO (t8_forest_save_record_t,
+                           forest->local_num_elements);
+  record = records;
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_local_trees; itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    num_elems = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielem = 0; ielem < num_elems; ielem++, record++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielem);
+      record->gtree = t8_forest_global_tree_id (forest, itree);
+      record->level = ts->t8_element_level (element);
+      record->linear_id = ts->t8_element_get_linear_id (element,
+                                                        record->level);
+    }
+  }
+  T8_ASSERT (record - records == forest->local_num_elements);
+
+  t8_forest_save_fill_header (forest, data_size, &header);
+  ok = t8_file_open (&file, filename, 1, forest->mpicomm);
+  if (ok) {
+    if (forest->mpirank == 0) {
+      ok = t8_file_write_at (&file, 0, 0, &header, 1, sizeof (header))
+        && t8_file_write_at (&file, 0, sizeof (header), offsets,
+                             forest->mpisize + 1, sizeof (int64_t));
+    }
+    /* Each process writes its records and its element data
+     * to one contiguous section each */
+    ok = t8_file_write_at (&file, 1, header.record_offset
+                           + offsets[forest->mpirank] * header.record_size,
+                           records, forest->local_num_elements,
+                           header.record_size) && ok;
+    ok = t8_file_write_at (&file, 1, header.data_offset
+                           + offsets[forest->mpirank] * data_size,
+                           element_data, data_size > 0 ?
+                           forest->local_num_elements : 0,
+                           SC_MAX (data_size, 1)) && ok;
+    ok = t8_file_close (&file) && ok;
+    ok = t8_forest_save_all_ok (ok, forest->mpicomm);
+    if (!ok) {
+      t8_global_errorf ("Error when writing to file %s.\n", filename);
+    }
+  }
+  T8_FREE (records);
+  T8_FREE (offsets);
+  return ok;
+}
+
+void
+t8_forest_load_elements (t8_forest_t forest)
+{
+  t8_forest_save_header_t header;
+  t8_forest_save_record_t *records;
+  t8_file_t           file;
+  t8_gloidx_t        *offsets, first_element, num_elements, ielem;
+  t8_gloidx_t         quotient, remainder, cmesh_first_tree;
+  t8_locidx_t         num_cmesh_trees, count_elements;
+  t8_tree_t           tree = NULL;
+  t8_eclass_scheme_c *ts = NULL;
+  t8_element_t       *element;
+  int                 ok, maxlevel;
+
+  T8_ASSERT (forest->set_load_filename != NULL);
+  T8_ASSERT (forest->cmesh != NULL && forest->scheme_cxx != NULL);
+
+  SC_CHECK_ABORTF (t8_file_open (&file, forest->set_load_filename, 0,
+                                 forest->mpicomm),
+                   "Could not open forest file %s",
+                   forest->set_load_filename);
+  ok = t8_forest_save_read_header (&file, &header)
+    && header.dimension == forest->dimension
+    && header.global_num_trees == t8_cmesh_get_num_trees (forest->cmesh);
+  SC_CHECK_ABORTF (t8_forest_save_all_ok (ok, forest->mpicomm),
+                   "File %s does not store a forest on this cmesh",
+                   forest->set_load_filename);
+
+  /* Determine the range of elements of this process */
+  if (header.mpisize == forest->mpisize) {
+    /* Restore the saved partition */
+    offsets = T8_ALLOC (t8_gloidx_t, forest->mpisize + 1);
+    ok = t8_file_read_at (&file, 1, sizeof (header), offsets,
+                          forest->mpisize + 1, sizeof (int64_t));
+    ok = ok && offsets[forest->mpirank] >= 0
+      && offsets[forest->mpirank] <= offsets[forest->mpirank + 1]
+      && offsets[forest->mpirank + 1] <= header.global_num_elements;
+    first_element = offsets[forest->mpirank];
+    num_elements = offsets[forest->mpirank + 1] - first_element;
+    T8_FREE (offsets);
+  }
+  else {
+    /* Distribute the elements uniformly */
+    quotient = header.global_num_elements / forest->mpisize;
+    remainder = header.global_num_elements % forest->mpisize;
+    first_element = forest->mpirank * quotient
+      + (forest->mpirank * remainder) / forest->mpisize;
+    num_elements = (forest->mpirank + 1) * quotient
+      + ((forest->mpirank + 1) * remainder) / forest->mpisize
+      - first_element;
+    ok = 1;
+  }
+  SC_CHECK_ABORTF (t8_forest_save_all_ok (ok, forest->mpicomm),
+                   "File %s has an invalid partition table",
+                   forest->set_load_filename);
+
+  /* Read the records of this process's elements */
+  records = T8_ALLOC (t8_forest_save_record_t, num_elements);
+  ok = t8_file_read_at (&file, 1, header.record_offset
+                        + first_element * header.record_size, records,
+                        num_elements, header.record_size);
+  ok = t8_file_close (&file) && ok;
+  SC_CHECK_ABORTF (t8_forest_save_all_ok (ok, forest->mpicomm),
+                   "Error when reading from file %s",
+                   forest->set_load_filename);
+
+  /* Build the trees. The elements of a tree are consecutive and each
+   * tree between the first and last one has at least one element. */
+  cmesh_first_tree = t8_cmesh_get_first_treeid (forest->cmesh);
+  num_cmesh_trees = t8_cmesh_get_num_local_trees (forest->cmesh);
+  forest->trees = sc_array_new (sizeof (t8_tree_struct_t));
+  forest->first_local_tree = num_elements > 0 ? records[0].gtree : 0;
+  forest->last_local_tree = num_elements > 0 ?
+    records[num_elements - 1].gtree : -1;
+  ok = num_elements == 0
+    || (forest->first_local_tree >= cmesh_first_tree
+        && forest->last_local_tree < cmesh_first_tree + num_cmesh_trees);
+  SC_CHECK_ABORT (ok,
+                  "cmesh partition does not match the loaded forest partition");
+  maxlevel = 0;
+  count_elements = 0;
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    if (tree == NULL || records[ielem].gtree
+        != forest->first_local_tree + (t8_gloidx_t) forest->trees->elem_count
+        - 1) {
+      /* This element starts a new tree */
+      SC_CHECK_ABORT (records[ielem].gtree
+                      == forest->first_local_tree
+                      + (t8_gloidx_t) forest->trees->elem_count,
+                      "Forest file does not store a valid element order");
+      tree = (t8_tree_t) sc_array_push (forest->trees);
+      tree->eclass = t8_cmesh_get_tree_class (forest->cmesh,
+                                              (t8_locidx_t)
+                                              (records[ielem].gtree -
+                                               cmesh_first_tree));
+      tree->elements_offset = count_elements;
+      tree->implicit_level = -1;
+      ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+      T8_ASSERT (ts != NULL);
+      t8_element_array_init (&tree->elements, ts);
+      maxlevel = ts->t8_element_maxlevel ();
+    }
+    SC_CHECK_ABORT (0 <= records[ielem].level
+                    && records[ielem].level <= maxlevel,
+                    "Forest file stores an invalid element level");
+    element = t8_element_array_push (&tree->elements);
+    ts->t8_element_set_linear_id (element, records[ielem].level,
+                                  records[ielem].linear_id);
+    count_elements++;
+  }
+  T8_FREE (records);
+
+  forest->local_num_elements = count_elements;
+  forest->global_num_elements = header.global_num_elements;
+}
+
+int
+t8_forest_load_element_data (t8_forest_t forest, const char *filename,
+                             void *element_data, size_t data_size)
+{
+  t8_forest_save_header_t header;
+  t8_file_t           file;
+  t8_gloidx_t         first_element, num_local_elements;
+  int                 ok, mpiret;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (element_data != NULL || data_size == 0);
+
+  if (!t8_file_open (&file, filename, 0, forest->mpicomm)) {
+    return 0;
+  }
+  ok = t8_forest_save_read_header (&file, &header)
+    && header.global_num_elements ==
+    t8_forest_get_global_num_elements (forest)
+    && header.data_size == (int64_t) data_size;
+  if (!t8_forest_save_all_ok (ok, forest->mpicomm)) {
+    t8_global_errorf ("File %s does not store data of size %zu for this "
+                      "forest.\n", filename, data_size);
+    t8_file_close (&file);
+    return 0;
+  }
+  /* The data is sorted by global element index, so each process reads
+   * the section of its elements regardless of the saved partition. */
+  num_local_elements = forest->local_num_elements;
+  mpiret = sc_MPI_Scan (&num_local_elements, &first_element, 1,
+                        T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  first_element -= num_local_elements;
+  ok = t8_file_read_at (&file, 1, header.data_offset
+                        + first_element * data_size, element_data,
+                        data_size > 0 ? forest->local_num_elements : 0,
+                        SC_MAX (data_size, 1));
+  ok = t8_file_close (&file) && ok;
+  ok = t8_forest_save_all_ok (ok, forest->mpicomm);
+  if (!ok) {
+    t8_global_errorf ("Error when reading from file %s.\n", filename);
+  }
+  return ok;
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,286 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_transfer.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_partition.h>
+#include <t8_element_cxx.hxx>
+
+T8_EXTERN_C_BEGIN ();
+
+/* A local leaf of the source forest that is sent to a process */
+typedef struct
+{
+  int                 rank;
+  t8_locidx_t         lelement;
+} t8_forest_transfer_send_t;
+
+/* The description of a leaf in a message, followed by its data */
+typedef struct
+{
+  t8_gloidx_t         gtreeid;
+  t8_linearidx_t      id;
+  int                 level;
+} t8_forest_transfer_header_t;
+
+/* Sort the leafs that we send by rank and keep their order */
+static int
+t8_forest_transfer_send_compare (const void *a, const void *b)
+{
+  const t8_forest_transfer_send_t *sa = (const t8_forest_transfer_send_t *) a;
+  const t8_forest_transfer_send_t *sb = (const t8_forest_transfer_send_t *) b;
+
+  if (sa->rank != sb->rank) {
+    return sa->rank < sb->rank ? -1 : 1;
+  }
+  return sa->lelement < sb->lelement ? -1 : sa->lelement > sb->lelement;
+}
+
+/* Collect for each local leaf of forest_from the nonempty processes of
+ * forest_to that own a part of it. These are all processes between the
+ * owners of its first and its last descendant. */
+static void
+t8_forest_transfer_targets (t8_forest_t forest_from, t8_forest_t forest_to,
+                            sc_array_t * sends)
+{
+  const t8_gloidx_t  *offsets_to;
+  t8_forest_transfer_send_t *send;
+  t8_eclass_scheme_c *ts;
+  t8_eclass_t         eclass;
+  t8_element_t       *element, *desc;
+  t8_gloidx_t         gtreeid;
+  t8_locidx_t         itree, ielem, num_elems, lelement = 0;
+  int                 first, last, rank;
+
+  offsets_to = t8_shmem_array_get_gloidx_array (forest_to->element_offsets);
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest_from);
+       itree++) {
+    gtreeid = t8_forest_global_tree_id (forest_from, itree);
+    eclass = t8_forest_get_tree_class (forest_from, itree);
+    ts = t8_forest_get_eclass_scheme (forest_from, eclass);
+    ts->t8_element_new (1, &desc);
+    num_elems = t8_forest_get_tree_num_elements (forest_from, itree);
+    for (ielem = 0; ielem < num_elems; ielem++, lelement++) {
+      element = t8_forest_get_element_in_tree (forest_from, itree, ielem);
+      ts->t8_element_last_descendant (element, desc,
+                                      ts->t8_element_maxlevel ());
+      first = t8_forest_element_find_owner (forest_to, gtreeid, element,
+                                            eclass);
+      last = t8_forest_element_find_owner (forest_to, gtreeid, desc, eclass);
+      for (rank = first; rank <= last; rank++) {
+        if (offsets_to[rank] < offsets_to[rank + 1]) {
+          send = (t8_forest_transfer_send_t *) sc_array_push (sends);
+          send->rank = rank;
+          send->lelement = lelement;
+        }
+      }
+    }
+    ts->t8_element_destroy (1, &desc);
+  }
+  sc_array_sort (sends, t8_forest_transfer_send_compare);
+}
+
+/* Walk the local leafs of a tree of forest_to and the received leafs of
+ * this tree together and pass the overlapping pairs to interpolate.
+ * Both sequences are sorted along the space-filling curve. If two leafs
+ * overlap, we continue with the next leaf of the finer sequence, since the
+ * coarser leaf may overlap with it as well. Otherwise, we continue after
+ * the leaf that comes first. */
+static void
+t8_forest_transfer_tree (t8_forest_t forest_to, t8_locidx_t ltreeid,
+                         size_t num_from, t8_element_t ** elements_from,
+                         const char *records, size_t record_size,
+                         t8_forest_transfer_fn interpolate, void *user_data)
+{
+  t8_eclass_scheme_c *ts;
+  t8_element_array_t *leafs;
+  t8_forest_transfer_pair_t *pair;
+  const t8_element_t *leaf;
+  t8_element_t       *nca;
+  sc_array_t          pairs;
+  t8_locidx_t         offset;
+  size_t              ileaf, ifrom, num_leafs;
+  int                 level_to, level_from;
+
+  ts = t8_forest_get_eclass_scheme (forest_to,
+                                    t8_forest_get_tree_class (forest_to,
+                                                              ltreeid));
+  leafs = t8_forest_tree_get_leafs (forest_to, ltreeid);
+  num_leafs = t8_element_array_get_count (leafs);
+  offset = t8_forest_get_tree_element_offset (forest_to, ltreeid);
+  ts->t8_element_new (1, &nca);
+  sc_array_init (&pairs, sizeof (t8_forest_transfer_pair_t));
+  ileaf = ifrom = 0;
+  while (ileaf < num_leafs && ifrom < num_from) {
+    leaf = t8_element_array_index_locidx (leafs, ileaf);
+    level_to = ts->t8_element_level (leaf);
+    level_from = ts->t8_element_level (elements_from[ifrom]);
+    ts->t8_element_nca (leaf, elements_from[ifrom], nca);
+    if (ts->t8_element_level (nca) == SC_MIN (level_to, level_from)) {
+      /* One leaf is an ancestor of the other or they are equal */
+      pair = (t8_forest_transfer_pair_t *) sc_array_push (&pairs);
+      pair->element_from = elements_from[ifrom];
+      pair->data_from = records + ifrom * record_size
+        + sizeof (t8_forest_transfer_header_t);
+      pair->element_to = leaf;
+      pair->lelement_to = offset + (t8_locidx_t) ileaf;
+      if (level_to >= level_from) {
+        ileaf++;
+      }
+      if (level_from >= level_to) {
+        ifrom++;
+      }
+    }
+    else if (ts->t8_element_compare (leaf, elements_from[ifrom]) < 0) {
+      ileaf++;
+    }
+    else {
+      ifrom++;
+    }
+  }
+  if (pairs.elem_count > 0) {
+    interpolate (forest_to, ltreeid, ts, pairs.elem_count,
+                 (const t8_forest_transfer_pair_t *) pairs.array, user_data);
+  }
+  sc_array_reset (&pairs);
+  ts->t8_element_destroy (1, &nca);
+}
+
+void
+t8_forest_transfer_data (t8_forest_t forest_from, t8_forest_t forest_to,
+                         const sc_array_t * data_from,
+                         t8_forest_transfer_fn interpolate, void *user_data)
+{
+  t8_forest_transfer_send_t *send;
+  t8_forest_transfer_header_t *header;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *element, **elements_from;
+  sc_array_t          sends, recv_buffer;
+  t8_gloidx_t         first_tree;
+  t8_locidx_t         ltreeid, itree, ielem;
+  size_t              record_size, num_sends, isend, num_records;
+  size_t              irecord, tree_begin, *send_offsets;
+  char               *send_buffer, *record;
+  int                *targets, num_targets, created_tables;
+
+  T8_ASSERT (t8_forest_is_committed (forest_from));
+  T8_ASSERT (t8_forest_is_committed (forest_to));
+  T8_ASSERT (forest_from->mpisize == forest_to->mpisize);
+  T8_ASSERT (data_from != NULL && data_from->elem_count
+             == (size_t) t8_forest_get_num_element (forest_from));
+  T8_ASSERT (interpolate != NULL);
+
+  T8_GLOBAL_INFOF ("Enter forest transfer data.\n");
+  t8_log_indent_push ();
+
+  /* We find the owners in forest_to with its partition tables */
+  created_tables = t8_forest_partition_tables_require (forest_to,
+                                                       T8_FOREST_TABLE_ALL);
+  sc_array_init (&sends, sizeof (t8_forest_transfer_send_t));
+  t8_forest_transfer_targets (forest_from, forest_to, &sends);
+
+  /* Pack one message per target process */
+  record_size = sizeof (t8_forest_transfer_header_t) + data_from->elem_size;
+  num_sends = sends.elem_count;
+  send_buffer = T8_ALLOC (char, SC_MAX (num_sends * record_size, 1));
+  targets = T8_ALLOC (int, SC_MAX (num_sends, 1));
+  send_offsets = T8_ALLOC (size_t, num_sends + 1);
+  num_targets = 0;
+  for (isend = 0; isend < num_sends; isend++) {
+    send = (t8_forest_transfer_send_t *) sc_array_index (&sends, isend);
+    if (num_targets == 0 || targets[num_targets - 1] != send->rank) {
+      targets[num_targets] = send->rank;
+      send_offsets[num_targets] = isend * record_size;
+      num_targets++;
+    }
+    element = t8_forest_get_element (forest_from, send->lelement, &itree);
+    ts = t8_forest_get_eclass_scheme (forest_from,
+                                      t8_forest_get_tree_class (forest_from,
+                                                                itree));
+    record = send_buffer + isend * record_size;
+    header = (t8_forest_transfer_header_t *) record;
+    header->gtreeid = t8_forest_global_tree_id (forest_from, itree);
+    header->level = ts->t8_element_level (element);
+    header->id = ts->t8_element_get_linear_id (element, header->level);
+    memcpy (record + sizeof (t8_forest_transfer_header_t),
+            t8_sc_array_index_locidx ((sc_array_t *) data_from,
+                                      send->lelement), data_from->elem_size);
+  }
+  send_offsets[num_targets] = num_sends * record_size;
+  sc_array_reset (&sends);
+
+  sc_array_init (&recv_buffer, 1);
+  t8_forest_exchange_sparse (forest_to->mpicomm, T8_MPI_TRANSFER_FOREST,
+                             num_targets, targets, send_buffer, send_offsets,
+                             &recv_buffer);
+  T8_FREE (send_buffer);
+  T8_FREE (targets);
+  T8_FREE (send_offsets);
+  t8_forest_partition_tables_release (forest_to, created_tables);
+
+  /* The messages are sorted by the ranks of the senders, thus the received
+   * leafs are sorted by tree and along the space-filling curve */
+  T8_ASSERT (recv_buffer.elem_count % record_size == 0);
+  num_records = recv_buffer.elem_count / record_size;
+  first_tree = t8_forest_get_first_local_tree_id (forest_to);
+  tree_begin = 0;
+  while (tree_begin < num_records) {
+    header = (t8_forest_transfer_header_t *)
+      (recv_buffer.array + tree_begin * record_size);
+    ltreeid = (t8_locidx_t) (header->gtreeid - first_tree);
+    T8_ASSERT (0 <= ltreeid
+               && ltreeid < t8_forest_get_num_local_trees (forest_to));
+    for (irecord = tree_begin + 1; irecord < num_records; irecord++) {
+      if (((t8_forest_transfer_header_t *)
+           (recv_buffer.array + irecord * record_size))->gtreeid
+          != header->gtreeid) {
+        break;
+      }
+    }
+    /* Build the received leafs of this tree */
+    ts = t8_forest_get_eclass_scheme (forest_to,
+                                      t8_forest_get_tree_class (forest_to,
+                                                                ltreeid));
+    elements_from = T8_ALLOC (t8_element_t *, irecord - tree_begin);
+    ts->t8_element_new ((int) (irecord - tree_begin), elements_from);
+    for (ielem = 0; ielem < (t8_locidx_t) (irecord - tree_begin); ielem++) {
+      header = (t8_forest_transfer_header_t *)
+        (recv_buffer.array + (tree_begin + ielem) * record_size);
+      ts->t8_element_set_linear_id (elements_from[ielem], header->level,
+                                    header->id);
+    }
+    t8_forest_transfer_tree (forest_to, ltreeid, irecord - tree_begin,
+                             elements_from,
+                             recv_buffer.array + tree_begin * record_size,
+                             record_size, interpolate, user_data);
+    ts->t8_element_destroy ((int) (irecord - tree_begin), elements_from);
+    T8_FREE (elements_from);
+    tree_begin = irecord;
+  }
+  sc_array_reset (&recv_buffer);
+
+  t8_log_indent_pop ();
+  T8_GLOBAL_INFOF ("Done forest transfer data.\n");
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,101 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_transfer.h
+ * Transfer element data between two forests on the same coarse mesh that
+ * were not derived from each other, for example to restart a computation
+ * on a different mesh.
+ *
+ * Each local leaf of the source forest is sent to the processes of the
+ * target forest whose partition it overlaps, which we compute from the
+ * first descendants of the target partition. Within each tree the
+ * received leafs and the local leafs of the target forest are both sorted
+ * along the space-filling curve, such that we find all overlapping pairs
+ * of leafs by walking both sequences together. Two leafs overlap if one is
+ * an ancestor of the other or if they are equal.
+ */
+
+#ifndef T8_FOREST_TRANSFER_H
+#define T8_FOREST_TRANSFER_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** A leaf of the source forest that overlaps a local leaf of the target
+ * forest. */
+typedef struct t8_forest_transfer_pair
+{
+  const t8_element_t *element_from;     /**< The leaf of the source forest.
+                                             It is an ancestor or a
+                                             descendant of \a element_to,
+                                             or equal to it. */
+  const void         *data_from;        /**< The data of \a element_from. */
+  const t8_element_t *element_to;       /**< The leaf of the target forest. */
+  t8_locidx_t         lelement_to;      /**< The local index of
+                                             \a element_to in the target
+                                             forest. */
+} t8_forest_transfer_pair_t;
+
+/** The callback of \ref t8_forest_transfer_data that interpolates the data
+ * of the leafs of one tree.
+ * \param [in] forest_to  The target forest.
+ * \param [in] ltreeid    A local tree of \a forest_to.
+ * \param [in] ts         The eclass scheme of the tree.
+ * \param [in] num_pairs  The number of pairs.
+ * \param [in] pairs      The overlapping pairs of the tree, sorted by
+ *                        \a lelement_to. All pairs of a leaf of the target
+ *                        forest are consecutive: either one coarser or
+ *                        equal source leaf or all finer source leafs.
+ * \param [in] user_data  The user data passed to \ref t8_forest_transfer_data.
+ */
+typedef void        (*t8_forest_transfer_fn) (t8_forest_t forest_to,
+                                              t8_locidx_t ltreeid,
+                                              t8_eclass_scheme_c * ts,
+                                              size_t num_pairs,
+                                              const t8_forest_transfer_pair_t
+                                              * pairs, void *user_data);
+
+T8_EXTERN_C_BEGIN ();
+
+/** Transfer the data of the elements of a forest to another forest on the
+ * same coarse mesh with the same scheme.
+ * This function is collective over the communicator of the forests.
+ * \param [in] forest_from  The committed source forest.
+ * \param [in] forest_to    The committed target forest, with the same number
+ *                          of processes as \a forest_from. The partitions of
+ *                          the forests may differ arbitrarily.
+ * \param [in] data_from    The data of the local elements of \a forest_from,
+ *                          one entry of any size per element.
+ * \param [in] interpolate  Called once for each local tree of \a forest_to
+ *                          with at least one overlapping pair.
+ * \param [in] user_data    Passed to \a interpolate, for example the array
+ *                          of the data of the local elements of \a forest_to.
+ */
+void                t8_forest_transfer_data (t8_forest_t forest_from,
+                                             t8_forest_t forest_to,
+                                             const sc_array_t * data_from,
+                                             t8_forest_transfer_fn
+                                             interpolate, void *user_data);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_TRANSFER_H */
@@ -31,8 +31,12 @@
 #include <t8_refcount.h>
 #include <t8_cmesh.h>
 #include <t8_element.h>
+#include <t8_geometry.h>
+#include <t8_counters.h>
+#include <t8_profile.h>
 #include <t8_data/t8_containers.h>
 #include <t8_forest/t8_forest_adapt.h>
+#include <t8_forest/t8_forest_fields.h>
 #include <t8_forest.h>
 
 typedef struct t8_profile t8_profile_t; /* Defined below */
@@ -57,17 +61,149 @@ typedef int8_t      t8_forest_from_t;
 #define T8_FOREST_FROM_NONE 0x8 /* A value that is not reached by adding up the other values. No from method used */
 #define T8_FOREST_FROM_LAST T8_FOREST_FROM_NONE
 
+/** The face neighbors of all local elements of a forest in compressed row
+ * storage. \see t8_forest_set_face_connectivity */
+typedef struct t8_forest_face_connectivity
+{
+  t8_locidx_t        *face_offsets;     /**< The faces of local element i are the face entries
+                                             face_offsets[i], ..., face_offsets[i + 1] - 1. */
+  t8_locidx_t        *neigh_offsets;    /**< The neighbors at face entry f are the entries
+                                             neigh_offsets[f], ..., neigh_offsets[f + 1] - 1. */
+  t8_locidx_t        *neighbors;        /**< For each neighbor its local index, or the number of local
+                                             elements plus its ghost index if it is a ghost. */
+  int                *dual_faces;       /**< For each neighbor the face at which it touches the element. */
+  int8_t             *orientations;     /**< For each face entry the orientation of the tree face
+                                             connection, 0 if the face is inside the tree. */
+} t8_forest_face_connectivity_t;
+
+/** Geometric quantities of all local elements of a forest as structure of
+ * arrays. \see t8_forest_set_geometry_cache */
+typedef struct t8_forest_geometry_cache
+{
+  double             *volumes;          /**< The volume of each local element. */
+  double             *centroids[3];     /**< The x, y and z coordinates of the
+                                             centroid of each local element. */
+  double             *diameters;        /**< The diameter of each local element,
+                                             \see t8_forest_element_diam. */
+  t8_locidx_t        *face_offsets;     /**< The faces of local element i are the face entries
+                                             face_offsets[i], ..., face_offsets[i + 1] - 1. */
+  double             *face_areas;       /**< The area of each face entry. */
+  double             *face_normals[3];  /**< The x, y and z coordinates of the outward
+                                             normal of each face entry. NULL for
+                                             forests of dimension smaller 2. */
+} t8_forest_geometry_cache_t;
+
+/** The map of a tree from its reference coordinates to physical space,
+ * precomputed from the tree vertices at commit.
+ * \see t8_forest_get_tree_map */
+typedef struct t8_forest_tree_map
+{
+  double              coeffs[T8_GEOMETRY_LINEAR_COEFFS][3]; /**< The coefficients of the map,
+                                                               see \ref t8_geometry_linear_coefficients. */
+  double              jacobian[3][3];   /**< If \b affine, the constant Jacobian. Entry [i][j] is the
+                                             derivative of coordinate i by reference coordinate j. */
+  double              jacobian_inv[3][3]; /**< If \b invertible, the left inverse (J^T J)^{-1} J^T of the
+                                               Jacobian J. Entry [j][i] belongs to reference coordinate j. */
+  const double       *vertices;         /**< The tree vertices the map was computed from.
+                                             NULL if the tree has no map. */
+  int                 dim;              /**< The dimension of the tree. */
+  int                 affine;           /**< True if the map is affine. */
+  int                 invertible;       /**< True if the map is affine with a Jacobian of full rank. */
+} t8_forest_tree_map_t;
+
+/** The connection of a local tree face to its neighbor tree, precomputed
+ * from the cmesh at commit. \see t8_forest_element_face_neighbor */
+typedef struct t8_forest_tree_face
+{
+  t8_gloidx_t         neigh_tree;       /**< The global id of the neighbor tree,
+                                             -1 if the face is a domain boundary. */
+  t8_element_face_transform_t transform; /**< The transformation to the neighbor tree. */
+  int8_t              neigh_eclass;     /**< The class of the neighbor tree. */
+} t8_forest_tree_face_t;
+
+/** A node of the bounding volume hierarchy over the trees of a forest.
+ * The node is a leaf of the hierarchy if \b left is negative. */
+typedef struct t8_forest_tree_bvh_node
+{
+  double              box[6];           /**< The minimal x, y, z and maximal x, y, z coordinates. */
+  t8_locidx_t         first;            /**< The first entry of \b tree_order below this node. */
+  t8_locidx_t         count;            /**< The number of trees below this node. */
+  int                 left;             /**< The index of the left child, -1 for a leaf. */
+  int                 right;            /**< The index of the right child, -1 for a leaf. */
+} t8_forest_tree_bvh_node_t;
+
+/** A bounding volume hierarchy over the axis-aligned bounding boxes of the
+ * local and ghost trees of a forest. \see t8_forest_set_tree_bvh */
+typedef struct t8_forest_tree_bvh
+{
+  t8_locidx_t         num_trees;        /**< The number of local plus ghost trees with vertices. */
+  double             *tree_boxes;       /**< 6 doubles for each local tree followed by each ghost tree.
+                                             Trees without vertices have empty boxes. */
+  t8_locidx_t        *tree_order;       /**< The \b num_trees trees with vertices, sorted by the nodes. */
+  t8_forest_tree_bvh_node_t *nodes;     /**< The nodes, the root first. */
+  int                 num_nodes;        /**< The number of nodes. */
+} t8_forest_tree_bvh_t;
+
+/** The binary logarithm of the number of elements per entry of the
+ * element to tree index. \see t8_forest_set_element_tree_index */
+#define T8_FOREST_ELEMENT_BLOCK_LOG 6
+
 #define T8_FOREST_BALANCE_REPART 1 /**< Value of forest->set_balance if balancing with repartitioning */
 #define T8_FOREST_BALANCE_NO_REPART 2 /**< Value of forest->set_balance if balancing without repartitioning */
 
+/** A data field of the elements of a forest.
+ * \see t8_forest_fields.h */
+typedef struct t8_forest_field
+{
+  char               *name;             /**< The name of the field. */
+  size_t              data_size;        /**< The number of bytes per element. */
+  t8_forest_field_replace_t interpolate; /**< Computes the data of the children
+                                              of a refined element, may be NULL. */
+  t8_forest_field_replace_t restrict_fn; /**< Computes the data of the parent
+                                              of a coarsened family, may be NULL. */
+  void               *user_data;        /**< Passed to \a interpolate and \a restrict_fn. */
+  sc_array_t          data;             /**< One entry for each local element,
+                                             followed by one entry for each ghost. */
+}
+t8_forest_field_t;
+
+/** The element storage of the trees of a forest. Unchanged trees of
+ * derived forests are views into the arena of their source forest, which
+ * is therefore reference counted. */
+typedef struct t8_forest_arena
+{
+  t8_refcount_t       rc;               /**< The number of forests using the arena. */
+  size_t              size;             /**< The number of bytes of \a data. */
+  char               *data;             /**< The elements of the trees. */
+}
+t8_forest_arena_t;
+
 /** This structure is private to the implementation. */
 typedef struct t8_forest
 {
   t8_refcount_t       rc;               /**< Reference counter. */
 
   int                 set_level;        /**< Level to use in new construction. */
+  char               *set_load_filename;        /**< If not NULL, the elements are read from this file
+                                                     in new construction. \see t8_forest_set_load */
+  int                 set_leaves;       /**< If true, the elements are created from the set_leaves_ arrays
+                                             in new construction. \see t8_forest_set_leaves */
+  t8_gloidx_t         set_leaves_first_tree;    /**< The global id of the first tree of the leaves */
+  t8_locidx_t         set_leaves_num_trees;     /**< The number of trees of the leaves */
+  const t8_locidx_t  *set_leaves_tree_num;      /**< The number of leaves of each tree */
+  const int          *set_leaves_levels;        /**< The levels of the leaves */
+  const t8_linearidx_t *set_leaves_linear_ids;  /**< The linear ids of the leaves */
   int                 set_for_coarsening;       /**< Change partition to allow
                                                      for one round of coarsening */
+  t8_forest_partition_weight_t set_partition_weight_fn; /**< If not NULL, partition by the weights of this callback.
+                                                             \see t8_forest_set_partition_weights */
+  const double       *set_partition_weights; /**< If not NULL, partition by these weights of the local elements
+                                                  of \b set_from. \see t8_forest_set_partition_weights */
+  const double       *set_partition_eclass_costs; /**< If not NULL, the weights are multiplied by these costs
+                                                       of the element classes. \see t8_forest_set_partition_eclass_costs */
+  double              set_partition_imbalance; /**< If at least 1, partition is skipped if the ratio of the
+                                                    maximum and the average load is at most this value.
+                                                    \see t8_forest_set_partition_imbalance */
 
   sc_MPI_Comm         mpicomm;          /**< MPI communicator to use. */
   t8_cmesh_t          cmesh;            /**< Coarse mesh to use. */
@@ -87,26 +223,68 @@ typedef struct t8_forest
 #endif
   t8_forest_adapt_t   set_adapt_fn;     /**< refinement and coarsen function. Called when \b from_method
                                              is set to T8_FOREST_FROM_ADAPT. */
+  t8_forest_adapt_tree_t set_adapt_tree_fn; /**< Tree wise refinement and coarsen function.
+                                             Used instead of \b set_adapt_fn if not NULL. */
+  const int8_t       *set_adapt_markers;        /**< Refinement markers for each local element of \b set_from.
+                                             Used instead of \b set_adapt_fn if not NULL.
+                                             \see t8_forest_set_adapt_markers */
   int                 set_adapt_recursive; /**< Flag to decide whether coarsen and refine
                                                 are carried out recursive */
   int                 set_balance;      /**< Flag to decide whether to forest will be balance in \ref t8_forest_commit.
                                              See \ref t8_forest_set_balance.
                                              If 0, no balance. If 1 balance with repartitioning, if 2 balance without
                                              repartitioning, \see t8_forest_balance */
+  int                 set_balance_ripple; /**< If true, balance uses the ripple algorithm. \see t8_forest_set_balance_ripple */
+  int                 set_balance_incremental; /**< If true, balance only checks elements near changes.
+                                                    \see t8_forest_set_balance_incremental */
   int                 do_ghost;         /**< If True, a ghost layer will be created when the forest is committed. */
   t8_ghost_type_t     ghost_type;       /**< If a ghost layer will be created, the type of neighbors that count as ghost. */
   int                 ghost_algorithm;  /**< Controls the algorithm used for ghost. 1 = balanced only. 2 = also unbalanced
                                              3 = top-down search and unbalanced. */
+  int                 ghost_depth;      /**< The number of layers of face neighbors in the ghost layer. */
+  int                 set_no_kernels;   /**< If true, do not use the single element class kernels.
+                                             \see t8_forest_set_specialized_kernels */
+  int                 set_adapt_threads;        /**< The number of threads used by adapt. \see t8_forest_set_adapt_threads */
+  int                 set_ghost_threads;        /**< The number of threads used by ghost. \see t8_forest_set_ghost_threads */
+  int                 set_ghost_incremental;    /**< If true, the ghost layer of an adapted forest is updated from
+                                                     the ghost layer of \b set_from. \see t8_forest_set_ghost_incremental */
+  int                 set_adapt_map;    /**< If true, adapt records \b adapt_map. \see t8_forest_set_adapt_map */
+  int                 set_face_connectivity; /**< If true, commit builds \b face_connectivity.
+                                                  \see t8_forest_set_face_connectivity */
+  int                 set_geometry_cache; /**< If true, commit builds \b geometry_cache.
+                                               \see t8_forest_set_geometry_cache */
+  int                 set_tree_bvh;     /**< If true, commit builds \b tree_bvh.
+                                             \see t8_forest_set_tree_bvh */
+  int                 set_element_tree_index; /**< If true, commit builds \b element_tree_index.
+                                                   \see t8_forest_set_element_tree_index */
+  int                 set_lazy_partition_tables; /**< If true, \b element_offsets, \b global_first_desc and \b tree_offsets
+                                                      are not kept after commit. \see t8_forest_set_lazy_partition_tables */
+  int                 set_trim_elements; /**< If true, commit frees the unused capacity of each tree's element array
+                                              instead of packing the trees into one arena. \see t8_forest_set_trim_elements */
+  int                 set_implicit_uniform; /**< If true, a uniform forest does not store its elements until they
+                                                 are accessed. \see t8_forest_set_implicit_uniform */
+  int                 set_shrink_comm; /**< If true, commit splits off the processes without elements.
+                                            \see t8_forest_set_shrink_comm */
+  int                 set_expand_comm; /**< If true, copy the forest to the parent communicator of set_from. */
   void               *user_data;        /**< Pointer for arbitrary user data. \see t8_forest_set_user_data. */
   void               *t8code_data;      /**< Pointer for arbitrary data that is used internally. */
   int                 committed;        /**< \ref t8_forest_commit called? */
+  int                 chain_link;       /**< True if only the next forest of a derivation chain uses
+                                             this forest. \see t8_forest_commit */
   int                 mpisize;          /**< Number of MPI processes. */
   int                 mpirank;          /**< Number of this MPI process. */
+  sc_MPI_Comm         parent_comm;      /**< If not sc_MPI_COMM_NULL, mpicomm was split from this communicator.
+                                             \see t8_forest_set_shrink_comm */
+  int                 comm_idle;        /**< True if mpicomm is the communicator of the idle processes. */
 
   t8_gloidx_t         first_local_tree;
   t8_gloidx_t         last_local_tree;
   t8_gloidx_t         global_num_trees; /**< The total number of global trees */
   sc_array_t         *trees;
+  t8_forest_arena_t  *element_arena;    /**< If not NULL, one allocation that stores the elements of all
+                                             local trees that are not shared. Their element arrays are views into it. */
+  sc_array_t         *shared_arenas;    /**< If not NULL, the \ref t8_forest_arena_t pointers of the arenas of other
+                                             forests whose trees this forest shares. \see t8_forest_tree_share */
   t8_forest_ghost_t   ghosts;           /**< If not NULL, the ghost elements. \see t8_forest_ghost.h */
   t8_shmem_array_t    element_offsets; /**< If partitioned, for each process the global index
                                             of its first element. Since it is memory consuming,
@@ -123,8 +301,39 @@ typedef struct t8_forest
                                           This array follows the same logic as \a tree_offsets in \a t8_cmesh_t */
 
   t8_locidx_t         local_num_elements;  /**< Number of elements on this processor. */
-  t8_gloidx_t         global_num_elements; /**< Number of elements on all processors. */
+  t8_gloidx_t         global_num_elements; /**< Number of elements on all processors.
+                                                Only valid if \a global_num_pending is false. */
+  t8_gloidx_t         global_num_send;  /**< The local contribution to \a global_num_request. */
+  sc_MPI_Request      global_num_request; /**< The non-blocking reduction of \a global_num_elements. */
+  int                 global_num_pending; /**< True while \a global_num_request is active. */
   t8_profile_t       *profile; /**< If not NULL, runtimes and statistics about forest_commit are stored here. */
+  sc_array_t         *adapt_map; /**< If not NULL, the runs of type \ref t8_forest_adapt_run_t that map the
+                                      elements of the forest this forest was adapted from to the elements
+                                      of this forest. \see t8_forest_set_adapt_map */
+  t8_forest_face_connectivity_t *face_connectivity; /**< If not NULL, the face neighbors of the local elements.
+                                                         \see t8_forest_set_face_connectivity */
+  t8_forest_geometry_cache_t *geometry_cache; /**< If not NULL, the geometry of the local elements.
+                                                   \see t8_forest_set_geometry_cache */
+  t8_forest_tree_map_t *tree_maps;     /**< The maps of the local trees followed by the maps of
+                                             the ghost trees. \see t8_forest_get_tree_map */
+  t8_forest_tree_face_t *tree_faces;   /**< If not NULL, T8_ECLASS_MAX_FACES connections for each
+                                             local tree. \see t8_forest_tree_faces_build */
+  t8_forest_tree_bvh_t *tree_bvh;      /**< If not NULL, the bounding volume hierarchy over the trees.
+                                            \see t8_forest_set_tree_bvh */
+  t8_locidx_t        *element_tree_index; /**< If not NULL, entry i is the local tree that contains
+                                               the local element with index
+                                               i * 2^T8_FOREST_ELEMENT_BLOCK_LOG.
+                                               \see t8_forest_set_element_tree_index */
+  t8_linearidx_t     *leaf_keys; /**< If not NULL, the linear ids at maxlevel of the local elements followed by
+                                      the linear ids of the ghosts. The leafs can be searched by these keys
+                                      without decoding them. \see t8_forest_leaf_face_neighbors_begin */
+  t8_locidx_t         num_leaf_keys; /**< The number of entries of \a leaf_keys. If it equals
+                                          \a local_num_elements, \a leaf_keys stores no ghosts. */
+  sc_array_t         *fields; /**< If not NULL, the \ref t8_forest_field_t data fields of the elements.
+                                   \see t8_forest_fields.h */
+  int                 have_fingerprint; /**< True if \b fingerprint was computed. */
+  uint64_t            fingerprint[2]; /**< The fingerprint of the leaves.
+                                           \see t8_forest_get_fingerprint */
 
 }
 t8_forest_struct_t;
@@ -140,6 +349,15 @@ typedef struct t8_tree
   t8_locidx_t         elements_offset;      /**< cumulative sum over earlier
                                                   trees on this processor
                                                   (locals only) */
+  int                 implicit_level;       /**< If nonnegative, the elements of the tree
+                                                 are the \b implicit_count consecutive
+                                                 elements of this level starting at
+                                                 \b implicit_first. \b elements is empty
+                                                 until they are accessed. -1 otherwise.
+                                                 \see t8_forest_set_implicit_uniform */
+  t8_linearidx_t      implicit_first;       /**< The linear id of the first element of
+                                                 an implicit tree. */
+  t8_locidx_t         implicit_count;       /**< The number of elements of an implicit tree. */
 }
 t8_tree_struct_t;
 
@@ -150,7 +368,9 @@ t8_tree_struct_t;
  */
 
 /** The number of statistics collected by a profile struct. */
-#define T8_PROFILE_NUM_STATS 13
+#define T8_PROFILE_NUM_STATS 38
+/** The number of phases whose hardware counters a profile struct stores. */
+#define T8_PROFILE_NUM_COUNTED 5
 typedef struct t8_profile
 {
   t8_locidx_t         partition_elements_shipped; /**< The number of elements this process has
@@ -169,8 +389,41 @@ typedef struct t8_profile
   double              partition_runtime;  /**< The runtime of  the last call to \a t8_cmesh_partition (not countint partition in t8_forest_balance). */
   double              ghost_runtime;      /**< The runtime of the last call to \a t8_forest_ghost_create. */
   double              ghost_waittime;     /**< Amount of synchronisation time in ghost. */
+  double              ghost_overlap_time; /**< The time between begin and end of the last ghost exchange. */
   double              balance_runtime;    /**< The runtime of the last call to \a t8_forest_balance. */
   double              commit_runtime;     /**< The runtime of the last call to \a t8_cmesh_commit. */
+  double              populate_runtime;   /**< The runtime of the last call to \a t8_forest_populate. */
+  int                 specialized_kernels; /**< True if the last adapt or populate used the
+                                                single element class kernels, \see t8_forest_kernels.hxx. */
+  double              offsets_runtime;    /**< The runtime of computing the partition offsets in the last commit. */
+  double              offsets_saved_runtime; /**< The runtime of the partition offsets that the last commit
+                                                  took over from balance instead of computing them. */
+  double              ghost_saved_runtime; /**< The runtime of the ghost layer that the last commit
+                                                took over from balance instead of creating it. */
+  int                 balance_reductions_saved; /**< The number of reductions that balance did not need,
+                                                     since it used the global element count to stop. */
+  double              partition_imbalance; /**< The ratio of the maximum and the average load before the
+                                                last partition call, if it was measured. */
+  int                 partition_skipped; /**< True if the last partition call kept the old partition,
+                                              since the imbalance was below the tolerance. */
+  int                 element_offsets_computed; /**< The number of times the element offsets were computed
+                                                     in the last commit and afterwards. */
+  int                 first_desc_computed; /**< The number of times the global first descendants were
+                                                computed in the last commit and afterwards. */
+  int                 tree_offsets_computed; /**< The number of times the tree offsets were computed
+                                                  in the last commit and afterwards. */
+  int                 partition_tables_shared; /**< The number of partition tables that the last commit
+                                                    copied from the forest it was derived from. */
+  int64_t             adapt_counters[T8_COUNTER_COUNT]; /**< The hardware counts of the last adapt,
+                                                             \see t8_counters.h. */
+  int64_t             partition_counters[T8_COUNTER_COUNT]; /**< The hardware counts of the last partition. */
+  int64_t             ghost_counters[T8_COUNTER_COUNT]; /**< The hardware counts of the last ghost creation. */
+  int64_t             balance_counters[T8_COUNTER_COUNT]; /**< The hardware counts of the last balance. */
+  int64_t             commit_counters[T8_COUNTER_COUNT]; /**< The hardware counts of the last commit. */
+  t8_profile_memory_t adapt_memory;       /**< The resident memory of the process during the last adapt. */
+  t8_profile_memory_t partition_memory;   /**< The resident memory during the last partition. */
+  t8_profile_memory_t ghost_memory;       /**< The resident memory during the last ghost creation. */
+  t8_profile_memory_t balance_memory;     /**< The resident memory during the last balance. */
 
 }
 t8_profile_struct_t;
@@ -187,13 +440,13 @@ typedef struct t8_forest_ghost
   sc_array_t         *ghost_trees;      /* ghost tree data:
                                            global_id.
                                            eclass.
-                                           elements. In linear id order */
-  sc_hash_t          *global_tree_to_ghost_tree;        /* Indexes into ghost_trees.
-                                                           Given a global tree id I give the index
-                                                           i such that the tree is in ghost_trees[i]
-                                                         */
-  sc_hash_t          *process_offsets;  /* Given a process, return the first ghost tree and
-                                           whithin it the first element of that process. */
+                                           elements. In linear id order.
+                                           Sorted by global_id, such that a global tree id
+                                           is found by binary search. */
+  sc_array_t         *process_offsets;  /* For each process, the first ghost tree and
+                                           whithin it the first element of that process.
+                                           The i-th entry belongs to the i-th process in
+                                           remote_processes. */
 #if 0
   /* TODO: obsolete by remote_processes below. */
   sc_array_t         *processes;        /* ranks of the processes */
@@ -203,12 +456,16 @@ typedef struct t8_forest_ghost
                                            Also an array of t8_locidx_t of the local indices of these elements whithin the tree.
                                            It is a hash table, hashed with the rank of a remote process.
                                            Sorted within each process by linear id.
+                                           Only used during the creation of the ghost layer, NULL afterwards.
                                          */
   sc_array_t         *remote_processes; /* The ranks of the processes for which local elements are ghost.
                                            Array of int's. */
-
-  sc_mempool_t       *glo_tree_mempool;
-  sc_mempool_t       *proc_offset_mempool;
+  t8_locidx_t        *remote_offsets;   /* The remote elements of the i-th process in remote_processes
+                                           are remote_offsets[i] to remote_offsets[i + 1] - 1.
+                                           One entry for each remote process plus one. */
+  t8_locidx_t        *remote_ltrees;    /* For each remote element the local id of its tree. */
+  t8_locidx_t        *remote_elements;  /* For each remote element its local index in the forest.
+                                           Within each process sorted by linear id. */
 } t8_forest_ghost_struct_t;
 
 #endif /* ! T8_FOREST_TYPES_H! */
@@ -26,14 +26,19 @@
 #include <t8_element_cxx.hxx>
 #include <t8_forest/t8_forest_ghost.h>
 #include <t8_vec.h>
+#include <t8_trace.h>
 #include "t8_cmesh/t8_cmesh_trees.h"
 #include "t8_forest_types.h"
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
 
-/* TODO: Currently we only use ASCII mode and no data compression.
- *       We also do not use sc_io to buffer our output stream. */
+/* By default the data arrays are written in ASCII mode. If t8code is
+ * configured with --enable-vtk-binary, they are written base64 encoded and
+ * with --enable-vtk-zlib additionally compressed, see t8_vtk.h. */
 
 /* There are different cell data to write, e.g. connectivity, type, vertices, ...
  * The structure is always the same:
@@ -71,7 +76,10 @@ typedef enum
  * \param [in] is_ghost Non-zero if the current element is a ghost element.
  *                      In this cas \a tree is NULL.
  *                      All ghost element will be traversed after all elements are
- * \param [in,out] vtufile The open file stream to which we write the forest.
+ * \param [in,out] buffer  The buffer of the data array. Use
+ *                         \ref t8_vtk_buffer_write_int and
+ *                         \ref t8_vtk_buffer_write_float to write values,
+ *                         they are written to the file after the last element.
  * \param [in,out] columns An integer counting the number of written columns.
  *                         The callback should increase this value by the number
  *                         of values written to the file.
@@ -79,7 +87,7 @@ typedef enum
  *                         Between modi INIT and CLEANUP, \a data will not be
  *                         modified outside of this callback.
  * \param [in]     modus   The modus in which the callback is called. See above.
- * \return                 True if successful, false if not (i.e. file i/o error).
+ * \return                 True if successful, false if not.
  */
 typedef int         (*t8_forest_vtk_cell_data_kernel) (t8_forest_t forest,
                                                        t8_locidx_t ltree_id,
@@ -89,7 +97,8 @@ typedef int         (*t8_forest_vtk_cell_data_kernel) (t8_forest_t forest,
                                                        t8_element_t * element,
                                                        t8_eclass_scheme_c *
                                                        ts, int is_ghost,
-                                                       FILE * vtufile,
+                                                       t8_vtk_buffer_t *
+                                                       buffer,
                                                        int *columns,
                                                        void **data,
                                                        T8_VTK_KERNEL_MODUS
@@ -108,7 +117,7 @@ t8_forest_num_points (t8_forest_t forest, int count_ghosts)
     tree = (t8_tree_t) t8_sc_array_index_topidx (forest->trees, itree);
     /* TODO: This will cause problems when pyramids are introduced. */
     num_points += t8_eclass_num_vertices[tree->eclass] *
-      t8_element_array_get_count (&tree->elements);
+      t8_forest_get_tree_element_count (tree);
   }
   if (count_ghosts) {
     T8_ASSERT (forest->ghosts != NULL);
@@ -134,7 +143,8 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
                                      t8_element_t * element,
                                      t8_eclass_scheme_c * ts,
                                      int is_ghost,
-                                     FILE * vtufile, int *columns,
+                                     t8_vtk_buffer_t * buffer,
+                                     int *columns,
                                      void **data, T8_VTK_KERNEL_MODUS modus)
 {
   struct t8_forest_vtk_vertices_t
@@ -149,8 +159,7 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
   double              midpoint[3];
 #endif
   double              element_coordinates[3];
-  int                 num_tree_vertices, ivertex;
-  int                 freturn;
+  int                 num_tree_vertices, ivertex, idim;
 
   if (modus == T8_VTK_KERNEL_INIT) {
     /* We initialize the user data to store NULL as the current tree */
@@ -211,22 +220,17 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
     t8_vec_ax (element_coordinates, 0.9);
     t8_vec_axpy (midpoint, element_coordinates, 0.1);
 #endif
-    freturn = fprintf (vtufile, "         ");
-    if (freturn <= 0) {
-      return 0;
-    }
+    t8_vtk_buffer_write_string (buffer, "         ");
+    for (idim = 0; idim < 3; idim++) {
 #ifdef T8_VTK_DOUBLES
-    freturn = fprintf (vtufile, " %24.16e %24.16e %24.16e\n",
-                       element_coordinates[0], element_coordinates[1],
-                       element_coordinates[2]);
+      t8_vtk_buffer_write_float (buffer, " %24.16e",
+                                 element_coordinates[idim]);
 #else
-    freturn = fprintf (vtufile, " %16.8e %16.8e %16.8e\n",
-                       element_coordinates[0], element_coordinates[1],
-                       element_coordinates[2]);
+      t8_vtk_buffer_write_float (buffer, " %16.8e",
+                                 element_coordinates[idim]);
 #endif
-    if (freturn <= 0) {
-      return 0;
     }
+    t8_vtk_buffer_write_string (buffer, "\n");
     /* We switch of the colum control of the surrounding function
      * by keeping the columns value constant. */
     *columns = 1;
@@ -350,12 +354,12 @@ t8_forest_vtk_cells_connectivity_kernel (t8_forest_t forest,
                                          t8_element_t * elements,
                                          t8_eclass_scheme_c * ts,
                                          int is_ghost,
-                                         FILE * vtufile, int *columns,
+                                         t8_vtk_buffer_t * buffer,
+                                         int *columns,
                                          void **data,
                                          T8_VTK_KERNEL_MODUS modus)
 {
   int                 ivertex;
-  int                 freturn;
   t8_locidx_t        *count_vertices;
 
   if (modus == T8_VTK_KERNEL_INIT) {
@@ -376,10 +380,7 @@ t8_forest_vtk_cells_connectivity_kernel (t8_forest_t forest,
                   "No vtk support for pyramids.");
   for (ivertex = 0; ivertex < t8_eclass_num_vertices[ts->eclass];
        ++ivertex, (*count_vertices)++) {
-    freturn = fprintf (vtufile, " %ld", (long) *count_vertices);
-    if (freturn <= 0) {
-      return 0;
-    }
+    t8_vtk_buffer_write_int (buffer, *count_vertices);
   }
   *columns += t8_eclass_num_vertices[ts->eclass];
   return 1;
@@ -392,11 +393,11 @@ t8_forest_vtk_cells_offset_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   t8_vtk_buffer_t * buffer,
+                                   int *columns,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   long long          *offset;
-  int                 freturn;
 
   if (modus == T8_VTK_KERNEL_INIT) {
     *data = T8_ALLOC_ZERO (long long, 1);
@@ -414,10 +415,7 @@ t8_forest_vtk_cells_offset_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
   SC_CHECK_ABORT (ts->eclass != T8_ECLASS_PYRAMID,
                   "Pyramids not supported in vtk");
   *offset += t8_eclass_num_vertices[ts->eclass];
-  freturn = fprintf (vtufile, " %lld", *offset);
-  if (freturn <= 0) {
-    return 0;
-  }
+  t8_vtk_buffer_write_int (buffer, *offset);
   *columns += 1;
 
   return 1;
@@ -430,16 +428,13 @@ t8_forest_vtk_cells_type_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
                                  t8_element_t * element,
                                  t8_eclass_scheme_c * ts,
                                  int is_ghost,
-                                 FILE * vtufile, int *columns,
+                                 t8_vtk_buffer_t * buffer,
+                                 int *columns,
                                  void **data, T8_VTK_KERNEL_MODUS modus)
 {
-  int                 freturn;
   if (modus == T8_VTK_KERNEL_EXECUTE) {
     /* print the vtk type of the element */
-    freturn = fprintf (vtufile, " %d", t8_eclass_vtk_type[ts->eclass]);
-    if (freturn <= 0) {
-      return 0;
-    }
+    t8_vtk_buffer_write_int (buffer, t8_eclass_vtk_type[ts->eclass]);
     *columns += 1;
   }
   return 1;
@@ -452,11 +447,12 @@ t8_forest_vtk_cells_level_kernel (t8_forest_t forest,
                                   t8_element_t * element,
                                   t8_eclass_scheme_c * ts,
                                   int is_ghost,
-                                  FILE * vtufile, int *columns,
+                                  t8_vtk_buffer_t * buffer,
+                                  int *columns,
                                   void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
-    fprintf (vtufile, "%i ", ts->t8_element_level (element));
+    t8_vtk_buffer_write_int (buffer, ts->t8_element_level (element));
     *columns += 1;
   }
   return 1;
@@ -469,11 +465,12 @@ t8_forest_vtk_cells_rank_kernel (t8_forest_t forest,
                                  t8_element_t * element,
                                  t8_eclass_scheme_c * ts,
                                  int is_ghost,
-                                 FILE * vtufile, int *columns,
+                                 t8_vtk_buffer_t * buffer,
+                                 int *columns,
                                  void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
-    fprintf (vtufile, "%i ", forest->mpirank);
+    t8_vtk_buffer_write_int (buffer, forest->mpirank);
     *columns += 1;
   }
   return 1;
@@ -486,7 +483,8 @@ t8_forest_vtk_cells_treeid_kernel (t8_forest_t forest,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   t8_vtk_buffer_t * buffer,
+                                   int *columns,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
@@ -499,7 +497,7 @@ t8_forest_vtk_cells_treeid_kernel (t8_forest_t forest,
       /* Otherwise the global tree id */
       tree_id = (long long) ltree_id + forest->first_local_tree;
     }
-    fprintf (vtufile, "%lli ", tree_id);
+    t8_vtk_buffer_write_int (buffer, tree_id);
     *columns += 1;
   }
   return 1;
@@ -512,16 +510,18 @@ t8_forest_vtk_cells_elementid_kernel (t8_forest_t forest,
                                       t8_element_t * element,
                                       t8_eclass_scheme_c * ts,
                                       int is_ghost,
-                                      FILE * vtufile, int *columns,
+                                      t8_vtk_buffer_t * buffer,
+                                      int *columns,
                                       void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
     if (!is_ghost) {
-      fprintf (vtufile, "%lli ", element_index + tree->elements_offset +
-               (long long) t8_forest_get_first_local_element_id (forest));
+      t8_vtk_buffer_write_int (buffer, element_index + tree->elements_offset
+                               + (long long)
+                               t8_forest_get_first_local_element_id (forest));
     }
     else {
-      fprintf (vtufile, "%lli ", (long long) -1);
+      t8_vtk_buffer_write_int (buffer, -1);
     }
     *columns += 1;
   }
@@ -535,7 +535,8 @@ t8_forest_vtk_cells_scalar_kernel (t8_forest_t forest,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   t8_vtk_buffer_t * buffer,
+                                   int *columns,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double              element_value = 0;
@@ -551,7 +552,7 @@ t8_forest_vtk_cells_scalar_kernel (t8_forest_t forest,
     else {
       element_value = 0;
     }
-    fprintf (vtufile, "%g ", element_value);
+    t8_vtk_buffer_write_float (buffer, "%g ", element_value);
     *columns += 1;
   }
   return 1;
@@ -564,7 +565,8 @@ t8_forest_vtk_cells_vector_kernel (t8_forest_t forest,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   t8_vtk_buffer_t * buffer,
+                                   int *columns,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double             *element_values, null_vec[3] = { 0, 0, 0 };
@@ -585,7 +587,7 @@ t8_forest_vtk_cells_vector_kernel (t8_forest_t forest,
       element_values = null_vec;
     }
     for (idim = 0; idim < dim; idim++) {
-      fprintf (vtufile, "%g ", element_values[idim]);
+      t8_vtk_buffer_write_float (buffer, "%g ", element_values[idim]);
     }
     *columns += dim;
   }
@@ -600,7 +602,8 @@ t8_forest_vtk_vertices_scalar_kernel (t8_forest_t forest,
                                       t8_element_t * element,
                                       t8_eclass_scheme_c * ts,
                                       int is_ghost,
-                                      FILE * vtufile, int *columns,
+                                      t8_vtk_buffer_t * buffer,
+                                      int *columns,
                                       void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double              element_value = 0;
@@ -620,7 +623,7 @@ t8_forest_vtk_vertices_scalar_kernel (t8_forest_t forest,
       else {
         element_value = 0;
       }
-      fprintf (vtufile, "%g ", element_value);
+      t8_vtk_buffer_write_float (buffer, "%g ", element_value);
       *columns += 1;
     }
   }
@@ -635,7 +638,8 @@ t8_forest_vtk_vertices_vector_kernel (t8_forest_t forest,
                                       t8_element_t * element,
                                       t8_eclass_scheme_c * ts,
                                       int is_ghost,
-                                      FILE * vtufile, int *columns,
+                                      t8_vtk_buffer_t * buffer,
+                                      int *columns,
                                       void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double             *element_values, null_vec[3] = { 0, 0, 0 };
@@ -659,7 +663,7 @@ t8_forest_vtk_vertices_vector_kernel (t8_forest_t forest,
         element_values = null_vec;
       }
       for (idim = 0; idim < dim; idim++) {
-        fprintf (vtufile, "%g ", element_values[idim]);
+        t8_vtk_buffer_write_float (buffer, "%g ", element_values[idim]);
       }
       *columns += dim;
     }
@@ -668,7 +672,9 @@ t8_forest_vtk_vertices_vector_kernel (t8_forest_t forest,
 }
 
 /* Iterate over all cells and write cell data to the file using
- * the cell_data_kernel as callback */
+ * the cell_data_kernel as callback.
+ * The values of all elements are collected in memory and written to the
+ * file with a single call. */
 static int
 t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
                                const char *dataname,
@@ -676,26 +682,32 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
                                const char *component_string,
                                int max_columns,
                                t8_forest_vtk_cell_data_kernel kernel,
-                               int write_ghosts, void *udata)
+                               int write_ghosts, const int8_t * keep,
+                               void *udata)
 {
   int                 freturn;
   int                 countcols;
   t8_tree_t           tree;
   t8_locidx_t         itree, ighost;
-  t8_locidx_t         element_index, elems_in_tree;
+  t8_locidx_t         element_index, elems_in_tree, ielement;
   t8_locidx_t         num_local_trees, num_ghost_trees;
   t8_element_t       *element;
   t8_eclass_scheme_c *ts;
   void               *data = NULL;
+  t8_vtk_buffer_t     buffer;
 
   /* Write the connectivity information.
    * Thus for each tree we write the indices of its corner vertices. */
   freturn = fprintf (vtufile, "        <DataArray type=\"%s\" "
-                     "Name=\"%s\" %s format=\"ascii\">\n         ",
-                     datatype, dataname, component_string);
+                     "Name=\"%s\" %s format=\"%s\">\n",
+                     datatype, dataname, component_string,
+                     T8_VTK_FORMAT_STRING);
   if (freturn <= 0) {
     return 0;
   }
+  /* The kernels fill this buffer, we write it after the last element */
+  t8_vtk_buffer_init (&buffer);
+  t8_vtk_buffer_write_string (&buffer, "         ");
 
   /* if udata != NULL, use it as the data pointer, in this case, the kernel
    * should not modify it */
@@ -711,7 +723,8 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
    * we add this to the already counted vertices and write it to the file */
   /* TODO: replace with an element iterator */
   num_local_trees = t8_forest_get_num_local_trees (forest);
-  for (itree = 0, countcols = 0; itree < num_local_trees; itree++) {
+  for (itree = 0, countcols = 0, ielement = 0; itree < num_local_trees;
+       itree++) {
     /* Get the tree that stores the elements */
     tree = t8_forest_get_tree (forest, itree);
     /* Get the eclass scheme of the tree */
@@ -720,7 +733,12 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
                                                                 itree));
     elems_in_tree =
       (t8_locidx_t) t8_element_array_get_count (&tree->elements);
-    for (element_index = 0; element_index < elems_in_tree; element_index++) {
+    for (element_index = 0; element_index < elems_in_tree;
+         element_index++, ielement++) {
+      if (keep != NULL && !keep[ielement]) {
+        /* This element is filtered out */
+        continue;
+      }
       /* Get a pointer to the element */
       element =
         t8_forest_get_element (forest, tree->elements_offset + element_index,
@@ -728,30 +746,19 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
       T8_ASSERT (element != NULL);
       /* Execute the given callback on each element */
       if (!kernel
-          (forest, itree, tree, element_index, element, ts, 0, vtufile,
+          (forest, itree, tree, element_index, element, ts, 0, &buffer,
            &countcols, &data, T8_VTK_KERNEL_EXECUTE)) {
         /* call the kernel in clean-up modus */
         kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
                 T8_VTK_KERNEL_CLEANUP);
+        t8_vtk_buffer_reset (&buffer);
         return 0;
       }
       /* After max_columns we break the line */
       if (!(countcols % max_columns)) {
-        freturn = fprintf (vtufile, "\n         ");
-        if (freturn <= 0) {
-          /* call the kernel in clean-up modus */
-          kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
-                  T8_VTK_KERNEL_CLEANUP);
-          return 0;
-        }
+        t8_vtk_buffer_write_string (&buffer, "\n         ");
       }
     }                           /* element loop ends here */
-    if (freturn <= 0) {
-      /* call the kernel in clean-up modus */
-      kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
-              T8_VTK_KERNEL_CLEANUP);
-      return 0;
-    }
   }                             /* tree loop ends here */
 
   if (write_ghosts) {
@@ -768,41 +775,40 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
       /* The number of ghosts in this tree */
       num_ghosts_in_tree = t8_forest_ghost_tree_num_elements (forest, ighost);
       for (element_index = 0;
-           element_index < num_ghosts_in_tree; element_index++) {
+           element_index < num_ghosts_in_tree; element_index++, ielement++) {
+        if (keep != NULL && !keep[ielement]) {
+          /* This ghost is filtered out */
+          continue;
+        }
         /* Get a pointer to the element */
         element = t8_forest_ghost_get_element (forest, ighost, element_index);
         /* Execute the given callback on each element */
         if (!kernel
             (forest, ighost + num_local_trees, NULL, element_index, element,
-             ts, 1, vtufile, &countcols, &data, T8_VTK_KERNEL_EXECUTE)) {
+             ts, 1, &buffer, &countcols, &data, T8_VTK_KERNEL_EXECUTE)) {
           /* call the kernel in clean-up modus */
           kernel (NULL, 0, NULL, 0, NULL, NULL, 1, NULL, NULL, &data,
                   T8_VTK_KERNEL_CLEANUP);
+          t8_vtk_buffer_reset (&buffer);
           return 0;
         }
         /* After max_columns we break the line */
         if (!(countcols % max_columns)) {
-          freturn = fprintf (vtufile, "\n         ");
-          if (freturn <= 0) {
-            /* call the kernel in clean-up modus */
-            kernel (NULL, 0, NULL, 0, NULL, NULL, 1, NULL, NULL, &data,
-                    T8_VTK_KERNEL_CLEANUP);
-            return 0;
-          }
+          t8_vtk_buffer_write_string (&buffer, "\n         ");
         }
       }                         /* element loop ends here */
-      if (freturn <= 0) {
-        /* call the kernel in clean-up modus */
-        kernel (NULL, 0, NULL, 0, NULL, NULL, 1, NULL, NULL, &data,
-                T8_VTK_KERNEL_CLEANUP);
-        return 0;
-      }
     }                           /* ghost loop ends here */
   }                             /* write_ghosts ends here */
   /* call the kernel in clean-up modus */
   kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
           T8_VTK_KERNEL_CLEANUP);
-  freturn = fprintf (vtufile, "\n        </DataArray>\n");
+  /* Write the values of all elements at once */
+  freturn = !t8_vtk_buffer_flush (&buffer, vtufile);
+  t8_vtk_buffer_reset (&buffer);
+  if (freturn <= 0) {
+    return 0;
+  }
+  freturn = fprintf (vtufile, "        </DataArray>\n");
   if (freturn <= 0) {
     return 0;
   }
@@ -819,8 +825,8 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
                            int write_treeid,
                            int write_mpirank,
                            int write_level, int write_element_id,
-                           int write_ghosts, int num_data,
-                           t8_vtk_data_field_t * data)
+                           int write_ghosts, const int8_t * keep,
+                           int num_data, t8_vtk_data_field_t * data)
 {
   int                 freturn;
   int                 idata;
@@ -838,7 +844,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "connectivity",
                                            T8_VTK_LOCIDX, "", 8,
                                            t8_forest_vtk_cells_connectivity_kernel,
-                                           write_ghosts, NULL);
+                                           write_ghosts, keep, NULL);
   if (!freturn) {
     goto t8_forest_vtk_cell_failure;
   }
@@ -853,7 +859,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "offsets",
                                            T8_VTK_LOCIDX, "", 8,
                                            t8_forest_vtk_cells_offset_kernel,
-                                           write_ghosts, NULL);
+                                           write_ghosts, keep, NULL);
   if (!freturn) {
     goto t8_forest_vtk_cell_failure;
   }
@@ -865,7 +871,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "types",
                                            "Int32", "", 8,
                                            t8_forest_vtk_cells_type_kernel,
-                                           write_ghosts, NULL);
+                                           write_ghosts, keep, NULL);
 
   if (!freturn) {
     goto t8_forest_vtk_cell_failure;
@@ -888,7 +894,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
     freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "treeid",
                                              T8_VTK_GLOIDX, "", 8,
                                              t8_forest_vtk_cells_treeid_kernel,
-                                             write_ghosts, NULL);
+                                             write_ghosts, keep, NULL);
     if (!freturn) {
       goto t8_forest_vtk_cell_failure;
     }
@@ -900,7 +906,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
     freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "mpirank",
                                              "Int32", "", 8,
                                              t8_forest_vtk_cells_rank_kernel,
-                                             write_ghosts, NULL);
+                                             write_ghosts, keep, NULL);
     if (!freturn) {
       goto t8_forest_vtk_cell_failure;
     }
@@ -912,7 +918,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
     freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "level",
                                              "Int32", "", 8,
                                              t8_forest_vtk_cells_level_kernel,
-                                             write_ghosts, NULL);
+                                             write_ghosts, keep, NULL);
     if (!freturn) {
       goto t8_forest_vtk_cell_failure;
     }
@@ -929,7 +935,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
     freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "element_id",
                                              datatype, "", 8,
                                              t8_forest_vtk_cells_elementid_kernel,
-                                             write_ghosts, NULL);
+                                             write_ghosts, keep, NULL);
     if (!freturn) {
       goto t8_forest_vtk_cell_failure;
     }
@@ -944,7 +950,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
                                        data[idata].description,
                                        T8_VTK_FLOAT_NAME, "", 8,
                                        t8_forest_vtk_cells_scalar_kernel,
-                                       write_ghosts, data[idata].data);
+                                       write_ghosts, keep, data[idata].data);
     }
     else {
       char                component_string[BUFSIZ];
@@ -957,7 +963,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
                                        component_string,
                                        8 * forest->dimension,
                                        t8_forest_vtk_cells_vector_kernel,
-                                       write_ghosts, data[idata].data);
+                                       write_ghosts, keep, data[idata].data);
     }
     if (!freturn) {
       goto t8_forest_vtk_cell_failure;
@@ -983,7 +989,7 @@ t8_forest_vtk_cell_failure:
  * cells was successful or not. */
 static int
 t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
-                            int write_ghosts,
+                            int write_ghosts, const int8_t * keep,
                             int num_data, t8_vtk_data_field_t * data)
 {
   int                 freturn;
@@ -1004,7 +1010,7 @@ t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
                                            "NumberOfComponents=\"3\"",
                                            8,
                                            t8_forest_vtk_cells_vertices_kernel,
-                                           write_ghosts, NULL);
+                                           write_ghosts, keep, NULL);
   if (!freturn) {
     goto t8_forest_vtk_cell_failure;
   }
@@ -1025,7 +1031,7 @@ t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
           t8_forest_vtk_write_cell_data (forest, vtufile, description,
                                          T8_VTK_FLOAT_NAME, "", 8,
                                          t8_forest_vtk_vertices_scalar_kernel,
-                                         write_ghosts, data[idata].data);
+                                         write_ghosts, keep, data[idata].data);
       }
       else {
         char                component_string[BUFSIZ];
@@ -1038,7 +1044,7 @@ t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
                                          T8_VTK_FLOAT_NAME, component_string,
                                          8 * forest->dimension,
                                          t8_forest_vtk_vertices_vector_kernel,
-                                         write_ghosts, data[idata].data);
+                                         write_ghosts, keep, data[idata].data);
       }
       if (!freturn) {
         goto t8_forest_vtk_cell_failure;
@@ -1054,6 +1060,96 @@ t8_forest_vtk_cell_failure:
   return 0;
 }
 
+/* Evaluate the filter once for each local element and, if write_ghosts
+ * is true, for each ghost element (stored after the local elements).
+ * Returns an array of flags that is true for each element to output.
+ * On output num_elements and num_points are the number of elements and
+ * points (counted with multiplicity) that pass the filter. */
+static int8_t      *
+t8_forest_vtk_filter_elements (t8_forest_t forest, int write_ghosts,
+                               t8_forest_vtk_filter_t filter,
+                               void *filter_data, t8_locidx_t * num_elements,
+                               t8_locidx_t * num_points)
+{
+  t8_locidx_t         itree, ighost, num_local_trees, num_ghost_trees;
+  t8_locidx_t         element_index, elems_in_tree, ielement;
+  t8_eclass_t         eclass;
+  const t8_element_t *element;
+  int8_t             *keep;
+
+  T8_ASSERT (filter != NULL);
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  num_ghost_trees = write_ghosts ? t8_forest_ghost_num_trees (forest) : 0;
+  ielement = t8_forest_get_num_element (forest);
+  if (write_ghosts) {
+    ielement += t8_forest_get_num_ghosts (forest);
+  }
+  keep = T8_ALLOC (int8_t, SC_MAX (ielement, 1));
+
+  *num_elements = *num_points = 0;
+  for (itree = 0, ielement = 0; itree < num_local_trees + num_ghost_trees;
+       itree++) {
+    eclass = t8_forest_get_tree_class (forest, itree);
+    SC_CHECK_ABORT (eclass != T8_ECLASS_PYRAMID,
+                    "Pyramids are not supported in vtk output");
+    ighost = itree - num_local_trees;
+    elems_in_tree = ighost < 0 ? t8_forest_get_tree_num_elements (forest,
+                                                                  itree)
+      : t8_forest_ghost_tree_num_elements (forest, ighost);
+    for (element_index = 0; element_index < elems_in_tree;
+         element_index++, ielement++) {
+      element = ighost < 0 ?
+        t8_forest_get_element_in_tree (forest, itree, element_index)
+        : t8_forest_ghost_get_element (forest, ighost, element_index);
+      keep[ielement] = filter (forest, itree, element, ighost >= 0,
+                               filter_data) != 0;
+      if (keep[ielement]) {
+        ++*num_elements;
+        *num_points += t8_eclass_num_vertices[eclass];
+      }
+    }
+  }
+  return keep;
+}
+
+int
+t8_forest_vtk_filter_level (t8_forest_t forest, t8_locidx_t ltreeid,
+                            const t8_element_t * element, int is_ghost,
+                            void *user_data)
+{
+  const int          *levels = (const int *) user_data;
+  t8_eclass_scheme_c *ts;
+  int                 level;
+
+  T8_ASSERT (levels != NULL);
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  level = ts->t8_element_level (element);
+  return levels[0] <= level && level <= levels[1];
+}
+
+int
+t8_forest_vtk_filter_box (t8_forest_t forest, t8_locidx_t ltreeid,
+                          const t8_element_t * element, int is_ghost,
+                          void *user_data)
+{
+  const double       *box = (const double *) user_data;
+  double              centroid[3];
+  int                 idim;
+
+  T8_ASSERT (box != NULL);
+  t8_forest_element_centroid (forest, ltreeid, element,
+                              t8_forest_get_tree_vertices (forest, ltreeid),
+                              centroid);
+  for (idim = 0; idim < 3; idim++) {
+    if (centroid[idim] < box[idim] || centroid[idim] > box[3 + idim]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
 int
 t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
                           int write_treeid,
@@ -1061,11 +1157,27 @@ t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
                           int write_level, int write_element_id,
                           int write_ghosts,
                           int num_data, t8_vtk_data_field_t * data)
+{
+  return t8_forest_vtk_write_file_filtered (forest, fileprefix, write_treeid,
+                                            write_mpirank, write_level,
+                                            write_element_id, write_ghosts,
+                                            NULL, NULL, num_data, data);
+}
+
+int
+t8_forest_vtk_write_file_filtered (t8_forest_t forest,
+                                   const char *fileprefix, int write_treeid,
+                                   int write_mpirank, int write_level,
+                                   int write_element_id, int write_ghosts,
+                                   t8_forest_vtk_filter_t filter,
+                                   void *filter_data, int num_data,
+                                   t8_vtk_data_field_t * data)
 {
   FILE               *vtufile = NULL;
   t8_locidx_t         num_elements, num_points;
   char                vtufilename[BUFSIZ];
   int                 freturn;
+  int8_t             *keep = NULL;
 
   T8_ASSERT (forest != NULL);
   T8_ASSERT (t8_forest_is_committed (forest));
@@ -1075,9 +1187,11 @@ t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
     write_ghosts = 0;
   }
   T8_ASSERT (forest->ghosts != NULL || !write_ghosts);
-
-  /* Currently we only support output in ascii format, not binary */
-  T8_ASSERT (T8_VTK_ASCII == 1);
+  if (forest->comm_idle) {
+    /* The processes with elements write the forest */
+    return 1;
+  }
+  t8_trace_begin ("vtk");
 
   /* process 0 creates the .pvtu file */
   if (forest->mpirank == 0) {
@@ -1089,13 +1203,21 @@ t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
     }
   }
 
-  /* The local number of elements */
-  num_elements = t8_forest_get_num_element (forest);
-  if (write_ghosts) {
-    num_elements += t8_forest_get_num_ghosts (forest);
+  if (filter != NULL) {
+    /* Decide once which elements to write, all data arrays skip the others */
+    keep = t8_forest_vtk_filter_elements (forest, write_ghosts, filter,
+                                          filter_data, &num_elements,
+                                          &num_points);
+  }
+  else {
+    /* The local number of elements */
+    num_elements = t8_forest_get_num_element (forest);
+    if (write_ghosts) {
+      num_elements += t8_forest_get_num_ghosts (forest);
+    }
+    /* The local number of points, counted with multiplicity */
+    num_points = t8_forest_num_points (forest, write_ghosts);
   }
-  /* The local number of points, counted with multiplicity */
-  num_points = t8_forest_num_points (forest, write_ghosts);
 
   /* The filename for this processes file */
   freturn =
@@ -1123,6 +1245,12 @@ t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
   if (freturn <= 0) {
     goto t8_forest_vtk_failure;
   }
+#if defined T8_VTK_BINARY && defined T8_VTK_COMPRESSION
+  freturn = fprintf (vtufile, " compressor=\"vtkZLibDataCompressor\"");
+  if (freturn <= 0) {
+    goto t8_forest_vtk_failure;
+  }
+#endif
 #ifdef SC_IS_BIGENDIAN
   freturn = fprintf (vtufile, " byte_order=\"BigEndian\">\n");
 #else
@@ -1144,14 +1272,14 @@ t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
 
   /* write the point data */
   if (!t8_forest_vtk_write_points
-      (forest, vtufile, write_ghosts, num_data, data)) {
+      (forest, vtufile, write_ghosts, keep, num_data, data)) {
     /* writings points was not succesful */
     goto t8_forest_vtk_failure;
   }
   /* write the cell data */
   if (!t8_forest_vtk_write_cells
       (forest, vtufile, write_treeid, write_mpirank, write_level,
-       write_element_id, write_ghosts, num_data, data)) {
+       write_element_id, write_ghosts, keep, num_data, data)) {
     /* Writing cells was not successful */
     goto t8_forest_vtk_failure;
   }
@@ -1173,13 +1301,252 @@ t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
     goto t8_forest_vtk_failure;
   }
   /* Writing was successful */
+  T8_FREE (keep);
+  t8_trace_end ("vtk");
   return 1;
 t8_forest_vtk_failure:
   if (vtufile != NULL) {
     fclose (vtufile);
   }
+  T8_FREE (keep);
+  t8_trace_end ("vtk");
   t8_errorf ("Error when writing vtk file.\n");
   return 0;
 }
 
+void
+t8_forest_vtk_get_array_sizes (t8_forest_t forest, int include_ghosts,
+                               t8_locidx_t * num_cells,
+                               t8_locidx_t * num_points)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (num_cells != NULL && num_points != NULL);
+
+  include_ghosts = include_ghosts && forest->ghosts != NULL;
+  *num_cells = t8_forest_get_num_element (forest);
+  if (include_ghosts) {
+    *num_cells += t8_forest_get_num_ghosts (forest);
+  }
+  *num_points = t8_forest_num_points (forest, include_ghosts);
+}
+
+void
+t8_forest_vtk_get_arrays (t8_forest_t forest, int include_ghosts,
+                          double *points, int64_t * connectivity,
+                          int64_t * offsets, uint8_t * types)
+{
+  t8_locidx_t         itree, ighost, num_local_trees, num_ghost_trees;
+  t8_locidx_t         ileaf, num_leafs, max_values, num_values;
+  t8_locidx_t         icell, ipoint, ltreeid;
+  t8_eclass_t         eclass;
+  const double       *vertices;
+  const t8_element_t *element;
+  double             *xyz = NULL;
+  int                 ivertex, num_vertices, idim;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  include_ghosts = include_ghosts && forest->ghosts != NULL;
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  num_ghost_trees = include_ghosts ? t8_forest_ghost_num_trees (forest) : 0;
+
+  if (points != NULL) {
+    /* Scratch space for the batched corner coordinates of the largest tree */
+    for (itree = 0, max_values = 0; itree < num_local_trees; itree++) {
+      num_values = t8_forest_get_tree_num_elements (forest, itree)
+        * t8_eclass_num_vertices[t8_forest_get_tree_class (forest, itree)];
+      max_values = SC_MAX (max_values, num_values);
+    }
+    xyz = T8_ALLOC (double, 3 * SC_MAX (max_values, 1));
+  }
+
+  icell = ipoint = 0;
+  if (offsets != NULL) {
+    offsets[0] = 0;
+  }
+  for (ltreeid = 0; ltreeid < num_local_trees + num_ghost_trees; ltreeid++) {
+    eclass = t8_forest_get_tree_class (forest, ltreeid);
+    SC_CHECK_ABORT (eclass != T8_ECLASS_PYRAMID,
+                    "Pyramids are not supported in vtk output");
+    num_vertices = t8_eclass_num_vertices[eclass];
+    itree = ltreeid < num_local_trees ? ltreeid : -1;
+    ighost = ltreeid - num_local_trees;
+    num_leafs = itree >= 0 ? t8_forest_get_tree_num_elements (forest, itree)
+      : t8_forest_ghost_tree_num_elements (forest, ighost);
+
+    if (points != NULL) {
+      if (itree >= 0) {
+        /* Compute all corners of the tree at once and reorder them into
+         * the interleaved vtk vertex order */
+        num_values = num_leafs * num_vertices;
+        t8_forest_tree_leaf_corner_coordinates (forest, itree, xyz,
+                                                xyz + num_values,
+                                                xyz + 2 * num_values);
+        for (ileaf = 0; ileaf < num_leafs; ileaf++) {
+          for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+            const t8_locidx_t   index = ileaf * num_vertices
+              + t8_eclass_vtk_corner_number[eclass][ivertex];
+            double             *point = points + 3 *
+              ((size_t) ipoint + ileaf * num_vertices + ivertex);
+            for (idim = 0; idim < 3; idim++) {
+              point[idim] = xyz[idim * num_values + index];
+            }
+          }
+        }
+      }
+      else {
+        /* Ghost trees are not covered by the batched evaluation */
+        vertices = t8_forest_get_tree_vertices (forest, ltreeid);
+        for (ileaf = 0; ileaf < num_leafs; ileaf++) {
+          element = t8_forest_ghost_get_element (forest, ighost, ileaf);
+          for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+            t8_forest_element_coordinate (forest, ltreeid, element, vertices,
+                                          t8_eclass_vtk_corner_number[eclass]
+                                          [ivertex], points + 3 *
+                                          ((size_t) ipoint
+                                           + ileaf * num_vertices + ivertex));
+          }
+        }
+      }
+    }
+    for (ileaf = 0; ileaf < num_leafs; ileaf++, icell++) {
+      if (connectivity != NULL) {
+        /* Each cell has its own copy of its vertices */
+        for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+          connectivity[ipoint + ileaf * num_vertices + ivertex] =
+            (int64_t) ipoint + ileaf * num_vertices + ivertex;
+        }
+      }
+      if (offsets != NULL) {
+        offsets[icell + 1] = (int64_t) ipoint + (ileaf + 1) * num_vertices;
+      }
+      if (types != NULL) {
+        types[icell] = (uint8_t) t8_eclass_vtk_type[eclass];
+      }
+    }
+    ipoint += num_leafs * num_vertices;
+  }
+  T8_FREE (xyz);
+}
+
+/* An output that is written in the background.
+ * It holds a reference of the forest and copies of all other parameters
+ * of t8_forest_vtk_write_file. */
+struct t8_forest_vtk_async
+{
+  t8_forest_t         forest;
+  char               *fileprefix;
+  int                 write_treeid;
+  int                 write_mpirank;
+  int                 write_level;
+  int                 write_element_id;
+  int                 write_ghosts;
+  int                 num_data;
+  t8_vtk_data_field_t *data;    /* Copies of the data fields and their values */
+  int                 result;   /* The return value of the output */
+#ifdef SC_ENABLE_PTHREAD
+  pthread_t           thread;   /* The thread that writes the output */
+  int                 thread_started;   /* True if thread was created */
+#endif
+};
+
+/* Write the output of an async handle. This is the thread function. */
+static void        *
+t8_forest_vtk_async_run (void *arg)
+{
+  t8_forest_vtk_async_t async = (t8_forest_vtk_async_t) arg;
+
+  async->result =
+    t8_forest_vtk_write_file (async->forest, async->fileprefix,
+                              async->write_treeid, async->write_mpirank,
+                              async->write_level, async->write_element_id,
+                              async->write_ghosts, async->num_data,
+                              async->data);
+  return NULL;
+}
+
+t8_forest_vtk_async_t
+t8_forest_vtk_write_file_async (t8_forest_t forest, const char *fileprefix,
+                                int write_treeid,
+                                int write_mpirank,
+                                int write_level, int write_element_id,
+                                int write_ghosts,
+                                int num_data, t8_vtk_data_field_t * data)
+{
+  t8_forest_vtk_async_t async;
+  size_t              length, num_values;
+  int                 idata;
+
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (fileprefix != NULL);
+  T8_ASSERT (num_data >= 0 && (num_data == 0 || data != NULL));
+
+  async = T8_ALLOC_ZERO (struct t8_forest_vtk_async, 1);
+  /* Reading an implicit tree creates its elements, which must not happen
+   * in the writing thread while the caller reads or derives from the
+   * forest. Once all trees store their elements, the writing thread only
+   * reads the forest and our reference keeps it alive. */
+  t8_forest_materialize (forest);
+  t8_forest_ref (forest);
+  async->forest = forest;
+  length = strlen (fileprefix) + 1;
+  async->fileprefix = T8_ALLOC (char, length);
+  memcpy (async->fileprefix, fileprefix, length);
+  async->write_treeid = write_treeid;
+  async->write_mpirank = write_mpirank;
+  async->write_level = write_level;
+  async->write_element_id = write_element_id;
+  async->write_ghosts = write_ghosts;
+  /* Copy the data, since the caller may change it after we return */
+  async->num_data = num_data;
+  async->data = T8_ALLOC (t8_vtk_data_field_t, SC_MAX (num_data, 1));
+  for (idata = 0; idata < num_data; idata++) {
+    async->data[idata] = data[idata];
+    num_values = (data[idata].type == T8_VTK_VECTOR ? 3 : 1)
+      * (size_t) t8_forest_get_num_element (forest);
+    async->data[idata].data = T8_ALLOC (double, SC_MAX (num_values, 1));
+    memcpy (async->data[idata].data, data[idata].data,
+            num_values * sizeof (double));
+  }
+
+#ifdef SC_ENABLE_PTHREAD
+  async->thread_started =
+    !pthread_create (&async->thread, NULL, t8_forest_vtk_async_run, async);
+  if (!async->thread_started) {
+    /* No thread available, write the output now */
+    t8_forest_vtk_async_run (async);
+  }
+#else
+  t8_forest_vtk_async_run (async);
+#endif
+  return async;
+}
+
+int
+t8_forest_vtk_write_wait (t8_forest_vtk_async_t * phandle)
+{
+  t8_forest_vtk_async_t async;
+  int                 idata, result;
+
+  T8_ASSERT (phandle != NULL && *phandle != NULL);
+  async = *phandle;
+#ifdef SC_ENABLE_PTHREAD
+  if (async->thread_started) {
+    SC_CHECK_ABORT (!pthread_join (async->thread, NULL),
+                    "Could not join vtk output thread");
+  }
+#endif
+  result = async->result;
+
+  t8_forest_unref (&async->forest);
+  for (idata = 0; idata < async->num_data; idata++) {
+    T8_FREE (async->data[idata].data);
+  }
+  T8_FREE (async->data);
+  T8_FREE (async->fileprefix);
+  T8_FREE (async);
+  *phandle = NULL;
+  return result;
+}
+
 T8_EXTERN_C_END ();
@@ -0,0 +1,340 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_xdmf.cxx
+ *
+ * We write a forest into a binary mesh file and one binary data file per
+ * output step, together with an XDMF file describing both.
+ * As in the vtu output, each element stores its own copy of its vertices.
+ * The mesh file holds the coordinates of all vertices followed by the
+ * connectivity of all elements in the XDMF mixed topology format.
+ * A data file holds the values of all elements for each data field.
+ * All arrays are sorted by global element index, so each process writes
+ * one contiguous section of each array.
+ */
+
+#include <t8_forest_xdmf.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_data/t8_file.h>
+
+T8_EXTERN_C_BEGIN ();
+
+#ifdef SC_IS_BIGENDIAN
+#define T8_FOREST_XDMF_ENDIAN "Big"
+#else
+#define T8_FOREST_XDMF_ENDIAN "Little"
+#endif
+
+/* The XDMF cell type of each element class in a mixed topology */
+static const int    t8_forest_xdmf_cell_type[T8_ECLASS_COUNT] = {
+  1,                            /* Polyvertex */
+  2,                            /* Polyline */
+  5,                            /* Quadrilateral */
+  4,                            /* Triangle */
+  9,                            /* Hexahedron */
+  6,                            /* Tetrahedron */
+  8,                            /* Wedge */
+  7                             /* Pyramid */
+};
+
+/* The sizes of the arrays of a forest mesh */
+typedef struct
+{
+  t8_gloidx_t         num_elements;     /* The number of elements */
+  t8_gloidx_t         num_points;       /* The number of element vertices */
+  t8_gloidx_t         num_connectivity; /* The number of connectivity entries */
+} t8_forest_xdmf_sizes_t;
+
+/* Compute the logical and of a flag on all processes */
+static int
+t8_forest_xdmf_all_ok (int ok, sc_MPI_Comm comm)
+{
+  int                 all_ok, mpiret;
+
+  mpiret = sc_MPI_Allreduce (&ok, &all_ok, 1, sc_MPI_INT, sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  return all_ok;
+}
+
+/* The number of connectivity entries of an element.
+ * Poly-vertices and poly-lines store their number of vertices after
+ * the cell type. */
+static int
+t8_forest_xdmf_num_entries (t8_eclass_t eclass)
+{
+  return 1 + (eclass == T8_ECLASS_VERTEX || eclass == T8_ECLASS_LINE)
+    + t8_eclass_num_vertices[eclass];
+}
+
+/* Compute the sizes of the local arrays, the position of the local arrays
+ * in the global ones and the sizes of the global arrays. */
+static void
+t8_forest_xdmf_compute_sizes (t8_forest_t forest,
+                              t8_forest_xdmf_sizes_t * local,
+                              t8_forest_xdmf_sizes_t * offset,
+                              t8_forest_xdmf_sizes_t * global)
+{
+  t8_locidx_t         itree, num_local_trees, num_elems;
+  t8_eclass_t         eclass;
+  int                 mpiret;
+
+  local->num_elements = forest->local_num_elements;
+  local->num_points = 0;
+  local->num_connectivity = 0;
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_local_trees; itree++) {
+    eclass = t8_forest_get_tree_class (forest, itree);
+    num_elems = t8_forest_get_tree_num_elements (forest, itree);
+    local->num_points += num_elems * t8_eclass_num_vertices[eclass];
+    local->num_connectivity +=
+      num_elems * t8_forest_xdmf_num_entries (eclass);
+  }
+  mpiret = sc_MPI_Scan (local, offset, 3, T8_MPI_GLOIDX, sc_MPI_SUM,
+                        forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  offset->num_elements -= local->num_elements;
+  offset->num_points -= local->num_points;
+  offset->num_connectivity -= local->num_connectivity;
+  T8_ASSERT (offset->num_elements ==
+             t8_forest_get_first_local_element_id (forest));
+  mpiret = sc_MPI_Allreduce (local, global, 3, T8_MPI_GLOIDX, sc_MPI_SUM,
+                             forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+}
+
+/* Return the file name of a path without its directory, since the
+ * XDMF file refers to the binary files relative to its own location. */
+static const char  *
+t8_forest_xdmf_basename (const char *path)
+{
+  const char         *slash = strrchr (path, '/');
+
+  return slash != NULL ? slash + 1 : path;
+}
+
+/* Write the XDMF file that describes the mesh and the data of one step.
+ * This function is called by one process. Returns true on success. */
+static int
+t8_forest_xdmf_write_description (const char *filename,
+                                  const char *meshfile,
+                                  const char *datafile, double time,
+                                  const t8_forest_xdmf_sizes_t * global,
+                                  int num_data, t8_vtk_data_field_t * data)
+{
+  FILE               *xmffile;
+  long long           seek;
+  int                 idata, ok;
+
+  xmffile = fopen (filename, "w");
+  if (xmffile == NULL) {
+    t8_errorf ("Error when opening file %s\n", filename);
+    return 0;
+  }
+  fprintf (xmffile, "<?xml version=\"1.0\" ?>\n"
+           "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n"
+           "<Xdmf Version=\"2.0\">\n"
+           "  <Domain>\n"
+           "    <Grid Name=\"forest\" GridType=\"Uniform\">\n"
+           "      <Time Value=\"%.16g\"/>\n", time);
+  /* The connectivity follows the coordinates in the mesh file */
+  seek = (long long) global->num_points * 3 * sizeof (double);
+  fprintf (xmffile, "      <Topology TopologyType=\"Mixed\" "
+           "NumberOfElements=\"%lld\">\n"
+           "        <DataItem Dimensions=\"%lld\" NumberType=\"Int\" "
+           "Precision=\"8\" Format=\"Binary\" Endian=\"%s\" Seek=\"%lld\">"
+           "%s</DataItem>\n"
+           "      </Topology>\n",
+           (long long) global->num_elements,
+           (long long) global->num_connectivity, T8_FOREST_XDMF_ENDIAN,
+           seek, meshfile);
+  fprintf (xmffile, "      <Geometry GeometryType=\"XYZ\">\n"
+           "        <DataItem Dimensions=\"%lld 3\" NumberType=\"Float\" "
+           "Precision=\"8\" Format=\"Binary\" Endian=\"%s\" Seek=\"0\">"
+           "%s</DataItem>\n"
+           "      </Geometry>\n",
+           (long long) global->num_points, T8_FOREST_XDMF_ENDIAN, meshfile);
+  for (idata = 0, seek = 0; idata < num_data; idata++) {
+    const int           is_vector = data[idata].type == T8_VTK_VECTOR;
+
+    fprintf (xmffile, "      <Attribute Name=\"%s\" AttributeType=\"%s\" "
+             "Center=\"Cell\">\n"
+             "        <DataItem Dimensions=\"%lld%s\" NumberType=\"Float\" "
+             "Precision=\"8\" Format=\"Binary\" Endian=\"%s\" "
+             "Seek=\"%lld\">%s</DataItem>\n"
+             "      </Attribute>\n", data[idata].description,
+             is_vector ? "Vector" : "Scalar",
+             (long long) global->num_elements, is_vector ? " 3" : "",
+             T8_FOREST_XDMF_ENDIAN, seek, datafile);
+    seek += (long long) global->num_elements * (is_vector ? 3 : 1)
+      * sizeof (double);
+  }
+  fprintf (xmffile, "    </Grid>\n" "  </Domain>\n" "</Xdmf>\n");
+  ok = !ferror (xmffile);
+  ok = !fclose (xmffile) && ok;
+  if (!ok) {
+    t8_errorf ("Error when writing to file %s\n", filename);
+  }
+  return ok;
+}
+
+int
+t8_forest_write_xdmf_mesh (t8_forest_t forest, const char *meshprefix)
+{
+  t8_forest_xdmf_sizes_t local, offset, global;
+  t8_locidx_t         itree, num_local_trees, ielem, num_elems;
+  t8_eclass_t         eclass;
+  t8_file_t           file;
+  t8_gloidx_t         point_id;
+  double             *points, *point, *x, *y, *z;
+  int64_t            *connectivity, *entry;
+  int                 ivertex, num_vertices, corner, ok;
+  char                filename[BUFSIZ];
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  if (forest->comm_idle) {
+    /* The processes with elements write the forest */
+    return 1;
+  }
+
+  /* The default scheme has no pyramid elements, so we cannot know the
+   * shape of the leaves of a pyramid tree. */
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  ok = 1;
+  for (itree = 0; itree < num_local_trees; itree++) {
+    ok = ok && t8_forest_get_tree_class (forest, itree) != T8_ECLASS_PYRAMID;
+  }
+  if (!t8_forest_xdmf_all_ok (ok, forest->mpicomm)) {
+    t8_global_errorf ("Pyramids are not supported in xdmf output.\n");
+    return 0;
+  }
+
+  t8_forest_xdmf_compute_sizes (forest, &local, &offset, &global);
+  points = T8_ALLOC (double, 3 * local.num_points);
+  connectivity = T8_ALLOC (int64_t, local.num_connectivity);
+  point = points;
+  entry = connectivity;
+  point_id = offset.num_points;
+  for (itree = 0; itree < num_local_trees; itree++) {
+    eclass = t8_forest_get_tree_class (forest, itree);
+    num_elems = t8_forest_get_tree_num_elements (forest, itree);
+    num_vertices = t8_eclass_num_vertices[eclass];
+    /* Compute all corner coordinates of the tree at once */
+    x = T8_ALLOC (double, 3 * num_elems * num_vertices);
+    y = x + num_elems * num_vertices;
+    z = y + num_elems * num_vertices;
+    t8_forest_tree_leaf_corner_coordinates (forest, itree, x, y, z);
+    for (ielem = 0; ielem < num_elems; ielem++) {
+      *entry++ = t8_forest_xdmf_cell_type[eclass];
+      if (eclass == T8_ECLASS_VERTEX || eclass == T8_ECLASS_LINE) {
+        *entry++ = num_vertices;
+      }
+      /* XDMF uses the vtk vertex order */
+      for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+        corner = ielem * num_vertices
+          + t8_eclass_vtk_corner_number[eclass][ivertex];
+        *point++ = x[corner];
+        *point++ = y[corner];
+        *point++ = z[corner];
+        *entry++ = point_id++;
+      }
+    }
+    T8_FREE (x);
+  }
+  T8_ASSERT (point - points == 3 * local.num_points);
+  T8_ASSERT (entry - connectivity == local.num_connectivity);
+
+  snprintf (filename, BUFSIZ, "%s.bin", meshprefix);
+  ok = t8_file_open (&file, filename, 1, forest->mpicomm);
+  if (ok) {
+    ok = t8_file_write_at (&file, 1, offset.num_points * 3 * sizeof (double),
+                           points, 3 * local.num_points, sizeof (double));
+    ok = t8_file_write_at (&file, 1, global.num_points * 3 * sizeof (double)
+                           + offset.num_connectivity * sizeof (int64_t),
+                           connectivity, local.num_connectivity,
+                           sizeof (int64_t)) && ok;
+    ok = t8_file_close (&file) && ok;
+    ok = t8_forest_xdmf_all_ok (ok, forest->mpicomm);
+    if (!ok) {
+      t8_global_errorf ("Error when writing to file %s.\n", filename);
+    }
+  }
+  T8_FREE (points);
+  T8_FREE (connectivity);
+  return ok;
+}
+
+int
+t8_forest_write_xdmf_step (t8_forest_t forest, const char *meshprefix,
+                           const char *fileprefix, int step, double time,
+                           int num_data, t8_vtk_data_field_t * data)
+{
+  t8_forest_xdmf_sizes_t local, offset, global;
+  t8_file_t           file;
+  int64_t             field_offset;
+  int                 idata, num_values, ok;
+  char                datafile[BUFSIZ], meshfile[BUFSIZ];
+  char                xmffile[BUFSIZ];
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (num_data >= 0 && (num_data == 0 || data != NULL));
+  if (forest->comm_idle) {
+    /* The processes with elements write the forest */
+    return 1;
+  }
+
+  t8_forest_xdmf_compute_sizes (forest, &local, &offset, &global);
+  snprintf (meshfile, BUFSIZ, "%s.bin", meshprefix);
+  snprintf (datafile, BUFSIZ, "%s_%04d.bin", fileprefix, step);
+  snprintf (xmffile, BUFSIZ, "%s_%04d.xmf", fileprefix, step);
+
+  /* Each data field is one array of all elements */
+  ok = t8_file_open (&file, datafile, 1, forest->mpicomm);
+  if (!ok) {
+    return 0;
+  }
+  for (idata = 0, field_offset = 0; idata < num_data; idata++) {
+    num_values = data[idata].type == T8_VTK_VECTOR ? 3 : 1;
+    ok = t8_file_write_at (&file, 1, field_offset + offset.num_elements
+                           * num_values * sizeof (double), data[idata].data,
+                           num_values * local.num_elements,
+                           sizeof (double)) && ok;
+    field_offset += global.num_elements * num_values * sizeof (double);
+  }
+  ok = t8_file_close (&file) && ok;
+  if (!t8_forest_xdmf_all_ok (ok, forest->mpicomm)) {
+    t8_global_errorf ("Error when writing to file %s.\n", datafile);
+    return 0;
+  }
+
+  /* Process 0 describes the mesh and the data */
+  if (forest->mpirank == 0) {
+    ok = t8_forest_xdmf_write_description (xmffile,
+                                           t8_forest_xdmf_basename
+                                           (meshfile),
+                                           t8_forest_xdmf_basename
+                                           (datafile), time, &global,
+                                           num_data, data);
+  }
+  return t8_forest_xdmf_all_ok (ok, forest->mpicomm);
+}
+
+T8_EXTERN_C_END ();
@@ -31,6 +31,27 @@
 #include <t8_vtk.h>
 #include <t8_forest.h>
 
+/** The handle of an output that is written in the background,
+ * see \ref t8_forest_vtk_write_file_async. */
+typedef struct t8_forest_vtk_async *t8_forest_vtk_async_t;
+
+/** Callback that decides which elements are written to a vtk file,
+ * see \ref t8_forest_vtk_write_file_filtered.
+ * \param [in] forest    The forest.
+ * \param [in] ltreeid   The local id of the element's tree. For ghost
+ *                       elements this is the number of local trees plus
+ *                       the id of the ghost tree.
+ * \param [in] element   The element.
+ * \param [in] is_ghost  True if \a element is a ghost element.
+ * \param [in] user_data The user data given to the output function.
+ * \return True if \a element should be written, false if not.
+ */
+typedef int         (*t8_forest_vtk_filter_t) (t8_forest_t forest,
+                                               t8_locidx_t ltreeid,
+                                               const t8_element_t *
+                                               element, int is_ghost,
+                                               void *user_data);
+
 T8_EXTERN_C_BEGIN ();
 /* function declarations */
 
@@ -61,6 +82,139 @@ int                 t8_forest_vtk_write_file (t8_forest_t forest,
                                               int num_data,
                                               t8_vtk_data_field_t * data);
 
+/** Write the forest in .pvtu file format, but only those elements that
+ * pass a filter. Excluded elements contribute no points, connectivity or
+ * data, and the piece sizes and offsets of each .vtu file count only the
+ * written elements. A process that writes no element writes an empty piece.
+ * The filter is evaluated once per element and must not communicate.
+ * \param [in]  filter      Decides for each element whether it is written.
+ *                          If NULL, all elements are written, which is the
+ *                          same as \ref t8_forest_vtk_write_file.
+ *                          See \ref t8_forest_vtk_filter_level and
+ *                          \ref t8_forest_vtk_filter_box.
+ * \param [in]  filter_data User data passed to \a filter.
+ * All other parameters are the same as for \ref t8_forest_vtk_write_file.
+ * \return  True if succesful, false if not (process local).
+ */
+int                 t8_forest_vtk_write_file_filtered (t8_forest_t forest,
+                                                       const char
+                                                       *fileprefix,
+                                                       int write_treeid,
+                                                       int write_mpirank,
+                                                       int write_level,
+                                                       int write_element_id,
+                                                       int write_ghosts,
+                                                       t8_forest_vtk_filter_t
+                                                       filter,
+                                                       void *filter_data,
+                                                       int num_data,
+                                                       t8_vtk_data_field_t *
+                                                       data);
+
+/** A filter for \ref t8_forest_vtk_write_file_filtered that writes only
+ * elements within a range of refinement levels.
+ * \param [in] user_data  Pointer to two ints, the minimum and the maximum
+ *                        level to write (both inclusive).
+ */
+int                 t8_forest_vtk_filter_level (t8_forest_t forest,
+                                                t8_locidx_t ltreeid,
+                                                const t8_element_t * element,
+                                                int is_ghost,
+                                                void *user_data);
+
+/** A filter for \ref t8_forest_vtk_write_file_filtered that writes only
+ * elements whose centroid lies in an axis aligned box.
+ * \param [in] user_data  Pointer to six doubles, the minimum x, y, z
+ *                        coordinates of the box followed by the maximum x, y
+ *                        and z coordinates.
+ */
+int                 t8_forest_vtk_filter_box (t8_forest_t forest,
+                                              t8_locidx_t ltreeid,
+                                              const t8_element_t * element,
+                                              int is_ghost, void *user_data);
+
+/** Query the sizes of the arrays filled by \ref t8_forest_vtk_get_arrays.
+ * \param [in]  forest         The forest.
+ * \param [in]  include_ghosts If true, the ghost elements are counted, too.
+ * \param [out] num_cells      The number of cells, that is the number of
+ *                             local elements, plus the ghosts if requested.
+ * \param [out] num_points     The number of points. Points are not shared
+ *                             between cells, thus this is also the length of
+ *                             the connectivity array.
+ */
+void                t8_forest_vtk_get_array_sizes (t8_forest_t forest,
+                                                   int include_ghosts,
+                                                   t8_locidx_t * num_cells,
+                                                   t8_locidx_t * num_points);
+
+/** Fill caller-provided arrays with the unstructured grid of the process
+ * local part of a forest, in the layout that vtkPoints, vtkCellArray and
+ * vtkUnstructuredGrid use. This allows in-situ adaptors (e.g. Catalyst) to
+ * pass the arrays to VTK without writing and reading files.
+ * The cells are the local elements in the forest's order, followed by the
+ * ghost elements if \a include_ghosts is true. Hence a per element data
+ * array of the forest, such as the data of a \ref t8_vtk_data_field_t, is
+ * already in cell order and can be wrapped by VTK without copying if ghosts
+ * are not included.
+ * Any of the arrays may be NULL, in which case it is not filled.
+ * The point coordinates of local trees are computed with
+ * \ref t8_forest_tree_leaf_corner_coordinates.
+ * \param [in]  forest         The forest.
+ * \param [in]  include_ghosts If true, the ghost elements are added.
+ * \param [out] points         3 * num_points doubles, the interleaved x, y, z
+ *                             coordinates of the points.
+ * \param [out] connectivity   num_points ids, the point ids of each cell.
+ * \param [out] offsets        num_cells + 1 entries, the start of each
+ *                             cell in \a connectivity and the total length.
+ * \param [out] types          num_cells vtk cell types.
+ * The sizes num_cells and num_points are given by
+ * \ref t8_forest_vtk_get_array_sizes.
+ */
+void                t8_forest_vtk_get_arrays (t8_forest_t forest,
+                                              int include_ghosts,
+                                              double *points,
+                                              int64_t * connectivity,
+                                              int64_t * offsets,
+                                              uint8_t * types);
+
+/** Start writing the forest in .pvtu file format in the background.
+ * The parameters are the same as for \ref t8_forest_vtk_write_file.
+ * We take a reference of \a forest and copy \a data, so the caller may
+ * change the data and unref the forest as soon as this function returns.
+ * The elements of all implicit trees of \a forest are created before the
+ * output starts, see \ref t8_forest_materialize, such that the caller may
+ * read \a forest and derive from it while the output is written.
+ * If sc is configured with --enable-pthread, the files are written by a
+ * separate thread while the caller continues. Otherwise they are written
+ * before this function returns.
+ * \param [in]  forest    The forest.
+ * \param [in]  fileprefix  The prefix of the output files.
+ * \return  A handle of the output that must be passed to
+ *          \ref t8_forest_vtk_write_wait.
+ * \note This function uses no communication, so different processes may
+ *       wait for their output at different times.
+ */
+t8_forest_vtk_async_t t8_forest_vtk_write_file_async (t8_forest_t forest,
+                                                      const char *fileprefix,
+                                                      int write_treeid,
+                                                      int write_mpirank,
+                                                      int write_level,
+                                                      int write_element_id,
+                                                      int write_ghosts,
+                                                      int num_data,
+                                                      t8_vtk_data_field_t *
+                                                      data);
+
+/** Wait until an output that was started with
+ * \ref t8_forest_vtk_write_file_async is complete.
+ * Call this before the next output or before finalizing.
+ * \param [in,out] phandle  The handle of the output.
+ *                          On output it is freed and set to NULL.
+ * \return  True if the output was successful, false if not (process local).
+ */
+int                 t8_forest_vtk_write_wait (t8_forest_vtk_async_t *
+                                              phandle);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_FOREST_VTK_H */
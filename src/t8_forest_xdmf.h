@@ -0,0 +1,77 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_xdmf.h
+ * We define routines to write a forest collectively into single files
+ * that are described by an XDMF file, which can be read with ParaView
+ * or VisIt.
+ * The mesh is written to one binary file and the element data of each
+ * output step to another one. Thus, the mesh only needs to be written
+ * again when the forest changes.
+ */
+
+#ifndef T8_FOREST_XDMF_H
+#define T8_FOREST_XDMF_H
+
+#include <t8_vtk.h>
+#include <t8_forest.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Write the mesh of a forest to the binary file meshprefix.bin.
+ * All processes write their element vertices and connectivity into
+ * this file, at the offsets given by their first element.
+ * This function is collective.
+ * \param [in]  forest      A committed forest.
+ * \param [in]  meshprefix  The prefix of the mesh file.
+ * \return  True on all processes if successful, false if not.
+ *          Forests with pyramid trees are not supported and give false.
+ */
+int                 t8_forest_write_xdmf_mesh (t8_forest_t forest,
+                                               const char *meshprefix);
+
+/** Write element data of a forest to the binary file fileprefix_NNNN.bin
+ * and an XDMF description fileprefix_NNNN.xmf of the data and the mesh,
+ * with NNNN the output step.
+ * The mesh must have been written with \ref t8_forest_write_xdmf_mesh
+ * for the same forest and be located in the same directory.
+ * This function is collective.
+ * \param [in]  forest      A committed forest.
+ * \param [in]  meshprefix  The prefix that was used to write the mesh.
+ * \param [in]  fileprefix  The prefix of the data files.
+ * \param [in]  step        The number of the output step.
+ * \param [in]  time        The simulation time of this step.
+ * \param [in]  num_data    Number of user defined double valued data fields to write.
+ * \param [in]  data        Array of t8_vtk_data_field_t of length \a num_data
+ *                          providing the user defined per element data.
+ * \return  True on all processes if successful, false if not.
+ */
+int                 t8_forest_write_xdmf_step (t8_forest_t forest,
+                                               const char *meshprefix,
+                                               const char *fileprefix,
+                                               int step, double time,
+                                               int num_data,
+                                               t8_vtk_data_field_t * data);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_XDMF_H */
@@ -22,6 +22,14 @@
 
 #include <t8_refcount.h>
 #include <t8_geometry.h>
+#include <t8_vec.h>
+
+/* Let the compiler vectorize the loops over the points of a batch */
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP) && _OPENMP >= 201307
+#define T8_GEOMETRY_SIMD _Pragma ("omp simd")
+#else
+#define T8_GEOMETRY_SIMD
+#endif
 
 /** This structure can be filled or allocated by the user.
  * t8_forest will never change its contents.
@@ -32,6 +40,8 @@ typedef struct t8_geometry
   const char         *name;     /**< User's choice is arbitrary. */
   void               *user;     /**< User's choice is arbitrary. */
   t8_geometry_X_t     X;     /**< Coordinate transformation. */
+  t8_geometry_X_batch_t X_batch; /**< Coordinate transformation of many
+                                       points, or NULL. */
   t8_geometry_reset_t reset;     /**< Destructor called by
                                              t8_geometry_reset.  If
                                              NULL, T8_FREE is called. */
@@ -64,6 +74,14 @@ t8_geometry_set_user (t8_geometry_t geom, void *user)
   geom->user = user;
 }
 
+void               *
+t8_geometry_get_user (t8_geometry_t geom)
+{
+  T8_ASSERT (geom != NULL);
+
+  return geom->user;
+}
+
 void
 t8_geometry_set_transformation (t8_geometry_t geom, t8_geometry_X_t X)
 {
@@ -72,6 +90,15 @@ t8_geometry_set_transformation (t8_geometry_t geom, t8_geometry_X_t X)
   geom->X = X;
 }
 
+void
+t8_geometry_set_batch_transformation (t8_geometry_t geom,
+                                      t8_geometry_X_batch_t X_batch)
+{
+  T8_ASSERT (geom != NULL);
+
+  geom->X_batch = X_batch;
+}
+
 void
 t8_geometry_set_reset (t8_geometry_t geom, t8_geometry_reset_t reset)
 {
@@ -119,6 +146,39 @@ t8_geometry_reset (t8_geometry_t * pgeom)
   }
 }
 
+void
+t8_geometry_evaluate (t8_geometry_t geom, t8_topidx_t which_tree,
+                      const double abc[3], double xyz[3])
+{
+  T8_ASSERT (geom != NULL);
+  T8_ASSERT (geom->X != NULL);
+
+  geom->X (geom, which_tree, abc, xyz);
+}
+
+void
+t8_geometry_evaluate_batch (t8_geometry_t geom, t8_topidx_t which_tree,
+                            size_t n, const double *abc, double *xyz)
+{
+  double              point_abc[3], point_xyz[3];
+  size_t              ipoint;
+
+  T8_ASSERT (geom != NULL);
+  T8_ASSERT (n == 0 || (abc + 3 * n <= xyz || xyz + 3 * n <= abc));
+
+  if (geom->X_batch != NULL) {
+    geom->X_batch (geom, which_tree, n, abc, xyz);
+    return;
+  }
+  /* The geometry can only map single points */
+  T8_ASSERT (geom->X != NULL);
+  for (ipoint = 0; ipoint < n; ipoint++) {
+    t8_vec_batch_get (abc, n, ipoint, point_abc);
+    geom->X (geom, which_tree, point_abc, point_xyz);
+    t8_vec_batch_set (xyz, n, ipoint, point_xyz);
+  }
+}
+
 static void
 t8_geometry_identity_X (t8_geometry_t geom, t8_topidx_t which_tree,
                         const double abc[3], double xyz[3])
@@ -128,6 +188,13 @@ t8_geometry_identity_X (t8_geometry_t geom, t8_topidx_t which_tree,
   xyz[2] = abc[2];
 }
 
+static void
+t8_geometry_identity_X_batch (t8_geometry_t geom, t8_topidx_t which_tree,
+                              size_t n, const double *abc, double *xyz)
+{
+  memcpy (xyz, abc, 3 * n * sizeof (double));
+}
+
 t8_geometry_t
 t8_geometry_new_identity (void)
 {
@@ -136,5 +203,525 @@ t8_geometry_new_identity (void)
   t8_geometry_init (&geom);
   t8_geometry_set_name (geom, "Identity");
   t8_geometry_set_transformation (geom, t8_geometry_identity_X);
+  t8_geometry_set_batch_transformation (geom, t8_geometry_identity_X_batch);
+  return geom;
+}
+
+void
+t8_geometry_linear_coefficients (t8_eclass_t eclass, const double *vertices,
+                                 double
+                                 coeffs[T8_GEOMETRY_LINEAR_COEFFS][3])
+{
+  int                 i;
+  /* The i-th coordinate of the k-th tree vertex */
+#define V(k) vertices[3 * (k) + i]
+
+  memset (coeffs, 0, T8_GEOMETRY_LINEAR_COEFFS * 3 * sizeof (double));
+  for (i = 0; i < 3; i++) {
+    coeffs[0][i] = V (0);
+    switch (eclass) {
+    case T8_ECLASS_VERTEX:
+      break;
+    case T8_ECLASS_LINE:
+      coeffs[1][i] = V (1) - V (0);
+      break;
+    case T8_ECLASS_TRIANGLE:
+      coeffs[1][i] = V (1) - V (0);
+      coeffs[2][i] = V (2) - V (1);
+      break;
+    case T8_ECLASS_TET:
+      coeffs[1][i] = V (1) - V (0);
+      coeffs[2][i] = V (3) - V (2);
+      coeffs[3][i] = V (2) - V (1);
+      break;
+    case T8_ECLASS_PRISM:
+      /* The triangle at height w interpolated between base and top */
+      coeffs[1][i] = V (1) - V (0);
+      coeffs[2][i] = V (2) - V (1);
+      coeffs[3][i] = V (3) - V (0);
+      coeffs[5][i] = V (4) - V (3) - V (1) + V (0);
+      coeffs[6][i] = V (5) - V (4) - V (2) + V (1);
+      break;
+    case T8_ECLASS_HEX:
+      coeffs[3][i] = V (4) - V (0);
+      coeffs[5][i] = V (5) - V (4) - V (1) + V (0);
+      coeffs[6][i] = V (6) - V (4) - V (2) + V (0);
+      coeffs[7][i] = V (7) - V (6) - V (5) + V (4)
+        - V (3) + V (2) + V (1) - V (0);
+      /* fall through */
+    case T8_ECLASS_QUAD:
+      coeffs[1][i] = V (1) - V (0);
+      coeffs[2][i] = V (2) - V (0);
+      coeffs[4][i] = V (3) - V (2) - V (1) + V (0);
+      break;
+    default:
+      SC_ABORT ("Linear geometry is supported only for "
+                "triangles/tets/quads/prisms/hexes.");
+    }
+  }
+#undef V
+}
+
+void
+t8_geometry_linear_map_batch (const double
+                              coeffs[T8_GEOMETRY_LINEAR_COEFFS][3],
+                              size_t n, const double *abc, double *xyz)
+{
+  const double       *u = abc, *v = abc + n, *w = abc + 2 * n;
+  double             *out;
+  size_t              ipoint;
+  int                 i;
+
+  for (i = 0; i < 3; i++) {
+    /* The coefficients of coordinate i, such that the loop only reads
+     * the batches */
+    const double        c0 = coeffs[0][i], c1 = coeffs[1][i];
+    const double        c2 = coeffs[2][i], c3 = coeffs[3][i];
+    const double        c4 = coeffs[4][i], c5 = coeffs[5][i];
+    const double        c6 = coeffs[6][i], c7 = coeffs[7][i];
+
+    out = xyz + i * n;
+    T8_GEOMETRY_SIMD
+    for (ipoint = 0; ipoint < n; ipoint++) {
+      out[ipoint] = c0 + c1 * u[ipoint] + c2 * v[ipoint] + c3 * w[ipoint]
+        + u[ipoint] * (c4 * v[ipoint] + c5 * w[ipoint])
+        + v[ipoint] * w[ipoint] * (c6 + c7 * u[ipoint]);
+    }
+  }
+}
+
+static void
+t8_geometry_linear_X_batch (t8_geometry_t geom, t8_topidx_t which_tree,
+                            size_t n, const double *abc, double *xyz)
+{
+  t8_cmesh_t          cmesh = (t8_cmesh_t) geom->user;
+  double              coeffs[T8_GEOMETRY_LINEAR_COEFFS][3];
+  const double       *vertices;
+
+  vertices = t8_cmesh_get_tree_vertices (cmesh, which_tree);
+  T8_ASSERT (vertices != NULL);
+  /* The coefficients are computed once for all points */
+  t8_geometry_linear_coefficients (t8_cmesh_get_tree_class (cmesh,
+                                                            which_tree),
+                                   vertices, coeffs);
+  t8_geometry_linear_map_batch ((const double (*)[3]) coeffs, n, abc, xyz);
+}
+
+static void
+t8_geometry_linear_X (t8_geometry_t geom, t8_topidx_t which_tree,
+                      const double abc[3], double xyz[3])
+{
+  /* A batch of one point has the same layout as a single point */
+  t8_geometry_linear_X_batch (geom, which_tree, 1, abc, xyz);
+}
+
+static void
+t8_geometry_linear_reset (t8_geometry_t * pgeom)
+{
+  t8_cmesh_t          cmesh;
+
+  cmesh = (t8_cmesh_t) (*pgeom)->user;
+  t8_cmesh_unref (&cmesh);
+  T8_FREE (*pgeom);
+  *pgeom = NULL;
+}
+
+t8_geometry_t
+t8_geometry_new_linear (t8_cmesh_t cmesh)
+{
+  t8_geometry_t       geom;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+
+  t8_geometry_init (&geom);
+  t8_geometry_set_name (geom, "Linear");
+  t8_cmesh_ref (cmesh);
+  t8_geometry_set_user (geom, cmesh);
+  t8_geometry_set_transformation (geom, t8_geometry_linear_X);
+  t8_geometry_set_batch_transformation (geom, t8_geometry_linear_X_batch);
+  t8_geometry_set_reset (geom, t8_geometry_linear_reset);
+  return geom;
+}
+
+/* A curved tree stores its nodes as one attribute of doubles: the degree,
+ * the number of nodes n, the 3 n reference coordinates and the 3 n
+ * physical coordinates of the nodes. */
+#define T8_GEOMETRY_LAGRANGE_HEADER 2
+
+/* The maximum number of monomials of a tree map */
+#define T8_GEOMETRY_LAGRANGE_MAX_TERMS \
+  ((T8_GEOMETRY_LAGRANGE_MAX_DEGREE + 1) * (T8_GEOMETRY_LAGRANGE_MAX_DEGREE \
+                                            + 1) * \
+   (T8_GEOMETRY_LAGRANGE_MAX_DEGREE + 1))
+
+/* One monomial of a tree map with its coefficient for each coordinate */
+typedef struct t8_geometry_lagrange_term
+{
+  double              coeffs[3];
+  int                 exponents[3];
+} t8_geometry_lagrange_term_t;
+
+/* The user data of the Lagrange geometry */
+typedef struct t8_geometry_lagrange
+{
+  t8_cmesh_t          cmesh;
+  t8_locidx_t         num_trees;
+  size_t             *tree_offsets;     /* The first term of each tree,
+                                           num_trees + 1 entries */
+  sc_array_t         *terms;    /* The terms of all trees */
+} t8_geometry_lagrange_t;
+
+void
+t8_geometry_set_tree_lagrange_nodes (t8_cmesh_t cmesh, t8_gloidx_t gtree_id,
+                                     int degree, int num_nodes,
+                                     const double *ref_coords,
+                                     const double *coords)
+{
+  double             *data;
+  size_t              size;
+
+  T8_ASSERT (cmesh != NULL);
+  T8_ASSERT (1 <= degree && degree <= T8_GEOMETRY_LAGRANGE_MAX_DEGREE);
+  T8_ASSERT (0 < num_nodes && num_nodes <= T8_GEOMETRY_LAGRANGE_MAX_TERMS);
+
+  size = T8_GEOMETRY_LAGRANGE_HEADER + 6 * (size_t) num_nodes;
+  data = T8_ALLOC (double, size);
+  data[0] = degree;
+  data[1] = num_nodes;
+  memcpy (data + T8_GEOMETRY_LAGRANGE_HEADER, ref_coords,
+          3 * num_nodes * sizeof (double));
+  memcpy (data + T8_GEOMETRY_LAGRANGE_HEADER + 3 * num_nodes, coords,
+          3 * num_nodes * sizeof (double));
+  /* The attribute is copied to the stash */
+  t8_cmesh_set_attribute (cmesh, gtree_id, t8_get_package_id (),
+                          T8_GEOMETRY_LAGRANGE_KEY, data,
+                          size * sizeof (double), 1);
+  T8_FREE (data);
+}
+
+int
+t8_geometry_get_tree_lagrange_nodes (t8_cmesh_t cmesh, t8_locidx_t ltree_id,
+                                     int *degree, int *num_nodes,
+                                     const double **ref_coords,
+                                     const double **coords)
+{
+  const double       *data;
+  int                 n;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+
+  data = (const double *) t8_cmesh_get_attribute (cmesh,
+                                                  t8_get_package_id (),
+                                                  T8_GEOMETRY_LAGRANGE_KEY,
+                                                  ltree_id);
+  if (data == NULL) {
+    return 0;
+  }
+  n = (int) data[1];
+  *degree = (int) data[0];
+  *num_nodes = n;
+  *ref_coords = data + T8_GEOMETRY_LAGRANGE_HEADER;
+  *coords = data + T8_GEOMETRY_LAGRANGE_HEADER + 3 * n;
+  return 1;
+}
+
+/* Compute the exponents of the monomials that span the maps of degree
+ * degree of a tree class. Return their number, or -1 if the class is not
+ * supported. */
+static int
+t8_geometry_lagrange_monomials (t8_eclass_t eclass, int degree,
+                                int exponents[][3])
+{
+  int                 a, b, c, num_terms = 0, include;
+
+  for (c = 0; c <= degree; c++) {
+    for (b = 0; b <= degree; b++) {
+      for (a = 0; a <= degree; a++) {
+        switch (eclass) {
+        case T8_ECLASS_VERTEX:
+          include = a == 0 && b == 0 && c == 0;
+          break;
+        case T8_ECLASS_LINE:
+          include = b == 0 && c == 0;
+          break;
+        case T8_ECLASS_TRIANGLE:
+          include = c == 0 && a + b <= degree;
+          break;
+        case T8_ECLASS_TET:
+          include = a + b + c <= degree;
+          break;
+        case T8_ECLASS_QUAD:
+          include = c == 0;
+          break;
+        case T8_ECLASS_HEX:
+          include = 1;
+          break;
+        case T8_ECLASS_PRISM:
+          include = a + b <= degree;
+          break;
+        default:
+          return -1;
+        }
+        if (include) {
+          exponents[num_terms][0] = a;
+          exponents[num_terms][1] = b;
+          exponents[num_terms][2] = c;
+          num_terms++;
+        }
+      }
+    }
+  }
+  return num_terms;
+}
+
+/* Solve the n x n system A X = B with 3 right hand sides by Gaussian
+ * elimination with partial pivoting. A is stored row-major and is
+ * overwritten, B has 3 entries per row and is overwritten by X.
+ * Return false if A is singular. */
+static int
+t8_geometry_lagrange_solve (int n, double *A, double *B)
+{
+  int                 i, j, k, pivot;
+  double              factor, tmp, max_abs = 0;
+
+  for (i = 0; i < n * n; i++) {
+    max_abs = SC_MAX (max_abs, fabs (A[i]));
+  }
+  for (k = 0; k < n; k++) {
+    pivot = k;
+    for (i = k + 1; i < n; i++) {
+      if (fabs (A[i * n + k]) > fabs (A[pivot * n + k])) {
+        pivot = i;
+      }
+    }
+    if (fabs (A[pivot * n + k]) <= 1e-12 * max_abs) {
+      return 0;
+    }
+    if (pivot != k) {
+      for (j = 0; j < n; j++) {
+        tmp = A[k * n + j];
+        A[k * n + j] = A[pivot * n + j];
+        A[pivot * n + j] = tmp;
+      }
+      for (j = 0; j < 3; j++) {
+        tmp = B[3 * k + j];
+        B[3 * k + j] = B[3 * pivot + j];
+        B[3 * pivot + j] = tmp;
+      }
+    }
+    for (i = k + 1; i < n; i++) {
+      factor = A[i * n + k] / A[k * n + k];
+      for (j = k; j < n; j++) {
+        A[i * n + j] -= factor * A[k * n + j];
+      }
+      for (j = 0; j < 3; j++) {
+        B[3 * i + j] -= factor * B[3 * k + j];
+      }
+    }
+  }
+  for (k = n - 1; k >= 0; k--) {
+    for (j = k + 1; j < n; j++) {
+      for (i = 0; i < 3; i++) {
+        B[3 * k + i] -= A[k * n + j] * B[3 * j + i];
+      }
+    }
+    for (i = 0; i < 3; i++) {
+      B[3 * k + i] /= A[k * n + k];
+    }
+  }
+  return 1;
+}
+
+/* Compute the monomial coefficients of the map of a curved tree */
+static void
+t8_geometry_lagrange_tree_terms (t8_eclass_t eclass, int degree,
+                                 int num_nodes, const double *ref_coords,
+                                 const double *coords, sc_array_t * terms)
+{
+  int                 exponents[T8_GEOMETRY_LAGRANGE_MAX_TERMS][3];
+  double             *A, *B, value;
+  t8_geometry_lagrange_term_t *term;
+  int                 num_terms, inode, iterm, i, e;
+
+  num_terms = t8_geometry_lagrange_monomials (eclass, degree, exponents);
+  SC_CHECK_ABORT (num_terms == num_nodes,
+                  "The number of nodes of a curved tree does not match "
+                  "its class and degree.\n");
+  /* The Vandermonde matrix of the monomials at the nodes */
+  A = T8_ALLOC (double, num_terms * num_terms);
+  B = T8_ALLOC (double, 3 * num_terms);
+  for (inode = 0; inode < num_nodes; inode++) {
+    for (iterm = 0; iterm < num_terms; iterm++) {
+      value = 1;
+      for (i = 0; i < 3; i++) {
+        for (e = 0; e < exponents[iterm][i]; e++) {
+          value *= ref_coords[3 * inode + i];
+        }
+      }
+      A[inode * num_terms + iterm] = value;
+    }
+  }
+  memcpy (B, coords, 3 * num_nodes * sizeof (double));
+  SC_CHECK_ABORT (t8_geometry_lagrange_solve (num_terms, A, B),
+                  "The nodes of a curved tree do not determine its map.\n");
+  for (iterm = 0; iterm < num_terms; iterm++) {
+    if (B[3 * iterm] == 0 && B[3 * iterm + 1] == 0 && B[3 * iterm + 2] == 0
+        && iterm > 0) {
+      /* Skip vanishing terms */
+      continue;
+    }
+    term = (t8_geometry_lagrange_term_t *) sc_array_push (terms);
+    for (i = 0; i < 3; i++) {
+      term->coeffs[i] = B[3 * iterm + i];
+      term->exponents[i] = exponents[iterm][i];
+    }
+  }
+  T8_FREE (A);
+  T8_FREE (B);
+}
+
+/* Store the coefficients of a multilinear tree map as terms */
+static void
+t8_geometry_lagrange_linear_terms (t8_eclass_t eclass,
+                                   const double *vertices, sc_array_t * terms)
+{
+  /* The exponents of the coefficients of t8_geometry_linear_coefficients */
+  const int           exponents[T8_GEOMETRY_LINEAR_COEFFS][3] = {
+    {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+    {1, 1, 0}, {1, 0, 1}, {0, 1, 1}, {1, 1, 1}
+  };
+  double              coeffs[T8_GEOMETRY_LINEAR_COEFFS][3];
+  t8_geometry_lagrange_term_t *term;
+  int                 iterm, i;
+
+  t8_geometry_linear_coefficients (eclass, vertices, coeffs);
+  for (iterm = 0; iterm < T8_GEOMETRY_LINEAR_COEFFS; iterm++) {
+    if (coeffs[iterm][0] == 0 && coeffs[iterm][1] == 0
+        && coeffs[iterm][2] == 0 && iterm > 0) {
+      continue;
+    }
+    term = (t8_geometry_lagrange_term_t *) sc_array_push (terms);
+    for (i = 0; i < 3; i++) {
+      term->coeffs[i] = coeffs[iterm][i];
+      term->exponents[i] = exponents[iterm][i];
+    }
+  }
+}
+
+static void
+t8_geometry_lagrange_X_batch (t8_geometry_t geom, t8_topidx_t which_tree,
+                              size_t n, const double *abc, double *xyz)
+{
+  const t8_geometry_lagrange_t *lagrange =
+    (const t8_geometry_lagrange_t *) geom->user;
+  const t8_geometry_lagrange_term_t *term;
+  const double       *u = abc, *v = abc + n, *w = abc + 2 * n;
+  double             *x = xyz, *y = xyz + n, *z = xyz + 2 * n;
+  size_t              ipoint, iterm;
+
+  T8_ASSERT (0 <= which_tree && which_tree < lagrange->num_trees);
+  SC_CHECK_ABORT (lagrange->tree_offsets[which_tree]
+                  < lagrange->tree_offsets[which_tree + 1],
+                  "The tree has neither nodes nor vertices.\n");
+
+  memset (xyz, 0, 3 * n * sizeof (double));
+  for (iterm = lagrange->tree_offsets[which_tree];
+       iterm < lagrange->tree_offsets[which_tree + 1]; iterm++) {
+    term = (const t8_geometry_lagrange_term_t *)
+      sc_array_index (lagrange->terms, iterm);
+    {
+      /* Copy the term, such that the loop only reads the batches */
+      const double        c0 = term->coeffs[0], c1 = term->coeffs[1];
+      const double        c2 = term->coeffs[2];
+      const int           eu = term->exponents[0], ev = term->exponents[1];
+      const int           ew = term->exponents[2];
+      double              m;
+      int                 e;
+
+      T8_GEOMETRY_SIMD
+      for (ipoint = 0; ipoint < n; ipoint++) {
+        m = 1;
+        for (e = 0; e < eu; e++) {
+          m *= u[ipoint];
+        }
+        for (e = 0; e < ev; e++) {
+          m *= v[ipoint];
+        }
+        for (e = 0; e < ew; e++) {
+          m *= w[ipoint];
+        }
+        x[ipoint] += c0 * m;
+        y[ipoint] += c1 * m;
+        z[ipoint] += c2 * m;
+      }
+    }
+  }
+}
+
+static void
+t8_geometry_lagrange_X (t8_geometry_t geom, t8_topidx_t which_tree,
+                        const double abc[3], double xyz[3])
+{
+  /* A batch of one point has the same layout as a single point */
+  t8_geometry_lagrange_X_batch (geom, which_tree, 1, abc, xyz);
+}
+
+static void
+t8_geometry_lagrange_reset (t8_geometry_t * pgeom)
+{
+  t8_geometry_lagrange_t *lagrange;
+
+  lagrange = (t8_geometry_lagrange_t *) (*pgeom)->user;
+  t8_cmesh_unref (&lagrange->cmesh);
+  T8_FREE (lagrange->tree_offsets);
+  sc_array_destroy (lagrange->terms);
+  T8_FREE (lagrange);
+  T8_FREE (*pgeom);
+  *pgeom = NULL;
+}
+
+t8_geometry_t
+t8_geometry_new_lagrange (t8_cmesh_t cmesh)
+{
+  t8_geometry_t       geom;
+  t8_geometry_lagrange_t *lagrange;
+  t8_locidx_t         itree;
+  t8_eclass_t         eclass;
+  const double       *vertices, *ref_coords, *coords;
+  int                 degree, num_nodes;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+
+  lagrange = T8_ALLOC_ZERO (t8_geometry_lagrange_t, 1);
+  t8_cmesh_ref (cmesh);
+  lagrange->cmesh = cmesh;
+  lagrange->num_trees = t8_cmesh_get_num_local_trees (cmesh);
+  lagrange->tree_offsets = T8_ALLOC (size_t, lagrange->num_trees + 1);
+  lagrange->terms = sc_array_new (sizeof (t8_geometry_lagrange_term_t));
+  for (itree = 0; itree < lagrange->num_trees; itree++) {
+    lagrange->tree_offsets[itree] = lagrange->terms->elem_count;
+    eclass = t8_cmesh_get_tree_class (cmesh, itree);
+    if (t8_geometry_get_tree_lagrange_nodes (cmesh, itree, &degree,
+                                             &num_nodes, &ref_coords,
+                                             &coords)) {
+      t8_geometry_lagrange_tree_terms (eclass, degree, num_nodes,
+                                       ref_coords, coords, lagrange->terms);
+    }
+    else {
+      vertices = t8_cmesh_get_tree_vertices (cmesh, itree);
+      if (vertices != NULL && eclass != T8_ECLASS_PYRAMID) {
+        t8_geometry_lagrange_linear_terms (eclass, vertices,
+                                           lagrange->terms);
+      }
+    }
+  }
+  lagrange->tree_offsets[lagrange->num_trees] = lagrange->terms->elem_count;
+
+  t8_geometry_init (&geom);
+  t8_geometry_set_name (geom, "Lagrange");
+  t8_geometry_set_user (geom, lagrange);
+  t8_geometry_set_transformation (geom, t8_geometry_lagrange_X);
+  t8_geometry_set_batch_transformation (geom, t8_geometry_lagrange_X_batch);
+  t8_geometry_set_reset (geom, t8_geometry_lagrange_reset);
   return geom;
 }
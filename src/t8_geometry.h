@@ -29,6 +29,8 @@
 #define T8_GEOMETRY_H
 
 #include <t8.h>
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
 
 T8_EXTERN_C_BEGIN ();
 
@@ -47,6 +49,22 @@ typedef void        (*t8_geometry_X_t) (t8_geometry_t geom,
                                         t8_topidx_t which_tree,
                                         const double abc[3], double xyz[3]);
 
+/** Forward transformation of many reference points of one tree.
+ * The points are stored as a batch of 3 \a n doubles, first the \a n x
+ * coordinates, then the \a n y and then the \a n z coordinates,
+ * see \ref t8_vec_batch_set.
+ * \param [in] geom The underlying t8_geometry_t struct.
+ * \param [in] which_tree The tree_id of the coarse tree to be considered.
+ * \param [in] n    The number of points.
+ * \param [in] abc  The batch of reference coordinates in [0,1]^d.
+ * \param [out] xyz The batch of physical coordinates that abc get mapped to.
+ *                  It must not overlap \a abc.
+ */
+typedef void        (*t8_geometry_X_batch_t) (t8_geometry_t geom,
+                                              t8_topidx_t which_tree,
+                                              size_t n, const double *abc,
+                                              double *xyz);
+
 /** Destructor prototype for a user-allocated \a t8_geometry_t.
  * It is invoked by t8_geometry_reset.  If the user chooses to
  * reserve the structure statically, simply don't call t8_geometry_reset.
@@ -63,9 +81,27 @@ void                t8_geometry_set_name (t8_geometry_t geom,
 
 void                t8_geometry_set_user (t8_geometry_t geom, void *user);
 
+/** Return the user data of a geometry.
+ * \param [in] geom    The geometry.
+ * \return             The pointer set by \ref t8_geometry_set_user.
+ */
+void               *t8_geometry_get_user (t8_geometry_t geom);
+
 void                t8_geometry_set_transformation (t8_geometry_t geom,
                                                     t8_geometry_X_t X);
 
+/** Set the batched transformation of a geometry.
+ * If it is not set, \ref t8_geometry_evaluate_batch calls the
+ * transformation of \ref t8_geometry_set_transformation for each point.
+ * \param [in,out] geom    The geometry.
+ * \param [in]     X_batch The batched transformation. It must compute the
+ *                         same points as the single point transformation.
+ */
+void                t8_geometry_set_batch_transformation (t8_geometry_t
+                                                          geom,
+                                                          t8_geometry_X_batch_t
+                                                          X_batch);
+
 void                t8_geometry_set_reset (t8_geometry_t geom,
                                            t8_geometry_reset_t reset);
 
@@ -75,12 +111,154 @@ void                t8_geometry_unref (t8_geometry_t * pgeom);
 
 void                t8_geometry_reset (t8_geometry_t * pgeom);
 
+/** Map one reference point of a tree to physical space.
+ * \param [in] geom        A geometry with a transformation.
+ * \param [in] which_tree  The tree_id of the coarse tree to be considered.
+ * \param [in] abc         The reference coordinates in [0,1]^d.
+ * \param [out] xyz        The physical coordinates.
+ */
+void                t8_geometry_evaluate (t8_geometry_t geom,
+                                          t8_topidx_t which_tree,
+                                          const double abc[3],
+                                          double xyz[3]);
+
+/** Map a batch of reference points of one tree to physical space.
+ * \param [in] geom        A geometry with a transformation.
+ * \param [in] which_tree  The tree_id of the coarse tree to be considered.
+ * \param [in] n           The number of points.
+ * \param [in] abc         The reference coordinates of the points as a batch
+ *                         of 3 \a n doubles, see \ref t8_geometry_X_batch_t.
+ * \param [out] xyz        The physical coordinates as a batch of 3 \a n
+ *                         doubles. It must not overlap \a abc.
+ */
+void                t8_geometry_evaluate_batch (t8_geometry_t geom,
+                                                t8_topidx_t which_tree,
+                                                size_t n, const double *abc,
+                                                double *xyz);
+
 /** Create a geometry that maps the unit square to itself via the identity mapping.
  * This function exists to provide the minimal example of a t8_geometry_t.
  * It should not be used for coarse meshes with more than one tree.
  */
 t8_geometry_t       t8_geometry_new_identity (void);
 
+/** Create a geometry that maps each tree of a coarse mesh from its reference
+ * element to its vertices, as \ref t8_forest_element_coordinate does.
+ * Lines, triangles and tetrahedra are mapped affinely, quadrilaterals,
+ * prisms and hexahedra multilinearly.
+ * The tree ids passed to the transformation are local tree ids of \a cmesh.
+ * \param [in] cmesh  A committed coarse mesh with tree vertices.
+ *                    The geometry keeps a reference to it.
+ */
+t8_geometry_t       t8_geometry_new_linear (t8_cmesh_t cmesh);
+
+/** The number of coefficients of a multilinear tree map. */
+#define T8_GEOMETRY_LINEAR_COEFFS 8
+
+/** Compute the coefficients c of the linear map of a tree from its reference
+ * coordinates (u, v, w) to its physical coordinates, such that coordinate i is
+ *   c[0][i] + c[1][i] u + c[2][i] v + c[3][i] w
+ *   + c[4][i] uv + c[5][i] uw + c[6][i] vw + c[7][i] uvw.
+ * \param [in]  eclass    The class of the tree. Pyramids are not supported.
+ * \param [in]  vertices  The coordinates of the tree vertices.
+ * \param [out] coeffs    The coefficients.
+ */
+void                t8_geometry_linear_coefficients (t8_eclass_t eclass,
+                                                     const double *vertices,
+                                                     double
+                                                     coeffs
+                                                     [T8_GEOMETRY_LINEAR_COEFFS]
+                                                     [3]);
+
+/** Evaluate a multilinear tree map at a batch of reference points.
+ * \param [in]  coeffs    The coefficients of the map, see
+ *                        \ref t8_geometry_linear_coefficients.
+ * \param [in]  n         The number of points.
+ * \param [in]  abc       The reference coordinates as a batch of 3 \a n doubles.
+ * \param [out] xyz       The physical coordinates as a batch of 3 \a n doubles.
+ *                        It must not overlap \a abc.
+ */
+void                t8_geometry_linear_map_batch (const double
+                                                  coeffs
+                                                  [T8_GEOMETRY_LINEAR_COEFFS]
+                                                  [3], size_t n,
+                                                  const double *abc,
+                                                  double *xyz);
+
+/** The key of the tree attribute of package t8 that stores the nodes of a
+ * curved tree, see \ref t8_geometry_set_tree_lagrange_nodes. */
+#define T8_GEOMETRY_LAGRANGE_KEY 1
+
+/** The maximum polynomial degree of a curved tree. */
+#define T8_GEOMETRY_LAGRANGE_MAX_DEGREE 3
+
+/** Store the nodes of a curved high-order tree in a cmesh.
+ * The map of the tree is the polynomial of degree \a degree that
+ * interpolates the nodes. For lines, triangles and tetrahedra it has total
+ * degree \a degree, for quadrilaterals and hexahedra degree \a degree in
+ * each coordinate and for prisms total degree \a degree in the first two
+ * and degree \a degree in the third coordinate. There must be exactly as
+ * many nodes as this polynomial space has dimensions and they must
+ * determine the polynomial uniquely, such as the nodes of the Lagrange
+ * elements of gmsh.
+ * The tree vertices should be set as well, they are used for the
+ * topology and for the bounding boxes of point location.
+ * It is not allowed to call this function after \ref t8_cmesh_commit.
+ * \param [in,out] cmesh        The cmesh to be updated.
+ * \param [in]     gtree_id     The global id of the tree.
+ * \param [in]     degree       The degree, between 1 and
+ *                              \ref T8_GEOMETRY_LAGRANGE_MAX_DEGREE.
+ * \param [in]     num_nodes    The number of nodes.
+ * \param [in]     ref_coords   The 3 \a num_nodes reference coordinates of
+ *                              the nodes in the tree, as passed to
+ *                              \ref t8_geometry_evaluate.
+ * \param [in]     coords       The 3 \a num_nodes physical coordinates of
+ *                              the nodes.
+ * The nodes are copied.
+ */
+void                t8_geometry_set_tree_lagrange_nodes (t8_cmesh_t cmesh,
+                                                         t8_gloidx_t
+                                                         gtree_id,
+                                                         int degree,
+                                                         int num_nodes,
+                                                         const double
+                                                         *ref_coords,
+                                                         const double
+                                                         *coords);
+
+/** Return the nodes of a curved tree of a committed cmesh.
+ * \param [in]  cmesh         A committed cmesh.
+ * \param [in]  ltree_id      A local tree of \a cmesh.
+ * \param [out] degree        The degree of the tree map.
+ * \param [out] num_nodes     The number of nodes.
+ * \param [out] ref_coords    The reference coordinates of the nodes.
+ * \param [out] coords        The physical coordinates of the nodes.
+ * \return                    True if the tree stores nodes. Otherwise
+ *                            false and the output arguments are not set.
+ */
+int                 t8_geometry_get_tree_lagrange_nodes (t8_cmesh_t cmesh,
+                                                         t8_locidx_t
+                                                         ltree_id,
+                                                         int *degree,
+                                                         int *num_nodes,
+                                                         const double
+                                                         **ref_coords,
+                                                         const double
+                                                         **coords);
+
+/** Create a geometry that maps the curved trees of a coarse mesh by the
+ * polynomials that interpolate their nodes, see
+ * \ref t8_geometry_set_tree_lagrange_nodes, and the other trees as
+ * \ref t8_geometry_new_linear does.
+ * The polynomials are converted to monomial coefficients for all local trees
+ * when the geometry is created, such that the batched transformation only
+ * evaluates sums of monomials.
+ * The tree ids passed to the transformation are local tree ids of \a cmesh.
+ * \param [in] cmesh  A committed coarse mesh with tree vertices or nodes.
+ *                    The geometry keeps a reference to it.
+ */
+t8_geometry_t       t8_geometry_new_lagrange (t8_cmesh_t cmesh);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_GEOMETRY_H! */
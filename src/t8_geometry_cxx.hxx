@@ -0,0 +1,139 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_geometry_cxx.hxx
+ * Analytic geometries that are compiled into the batched transformation.
+ *
+ * A transformation set with \ref t8_geometry_set_transformation is called
+ * through a function pointer for each point and cannot be inlined.
+ * Instead, an analytic geometry can be written as a class with a static
+ * member function
+ *
+ *     static void evaluate (const void *user, t8_topidx_t which_tree,
+ *                           const double abc[3], double xyz[3]);
+ *
+ * that maps one point. \ref t8_geometry_static_evaluate_batch instantiates
+ * the loop over the points of a batch for this class, such that evaluate is
+ * inlined and the loop can be vectorized. \ref t8_geometry_new_static
+ * wraps the instantiated loop in a regular \ref t8_geometry_t, which can be
+ * used wherever the C interface expects a geometry:
+ *
+ *     struct my_cylinder
+ *     {
+ *       static void evaluate (const void *user, t8_topidx_t which_tree,
+ *                             const double abc[3], double xyz[3])
+ *       {
+ *         const double r = 1 + abc[0], phi = 2 * M_PI * abc[1];
+ *         xyz[0] = r * cos (phi);
+ *         xyz[1] = r * sin (phi);
+ *         xyz[2] = abc[2];
+ *       }
+ *     };
+ *
+ *     t8_geometry_t geom = t8_geometry_new_static < my_cylinder > ("Cylinder",
+ *                                                                NULL);
+ */
+
+#ifndef T8_GEOMETRY_CXX_HXX
+#define T8_GEOMETRY_CXX_HXX
+
+#include <t8_geometry.h>
+
+/* Let the compiler vectorize the loops over the points of a batch */
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP) && _OPENMP >= 201307
+#define T8_GEOMETRY_CXX_SIMD _Pragma ("omp simd")
+#else
+#define T8_GEOMETRY_CXX_SIMD
+#endif
+
+/** Map a batch of reference points of one tree with an analytic geometry.
+ * \param [in] user        Passed to TGeometry::evaluate.
+ * \param [in] which_tree  The tree_id of the coarse tree to be considered.
+ * \param [in] n           The number of points.
+ * \param [in] abc         The reference coordinates as a batch of 3 \a n
+ *                         doubles, see \ref t8_geometry_X_batch_t.
+ * \param [out] xyz        The physical coordinates as a batch of 3 \a n
+ *                         doubles. It must not overlap \a abc.
+ */
+template < class TGeometry > inline void
+t8_geometry_static_evaluate_batch (const void *user, t8_topidx_t which_tree,
+                                   size_t n, const double *abc, double *xyz)
+{
+  const double       *u = abc, *v = abc + n, *w = abc + 2 * n;
+  double             *x = xyz, *y = xyz + n, *z = xyz + 2 * n;
+  size_t              ipoint;
+
+  T8_GEOMETRY_CXX_SIMD
+  for (ipoint = 0; ipoint < n; ipoint++) {
+    double              point_abc[3], point_xyz[3];
+
+    point_abc[0] = u[ipoint];
+    point_abc[1] = v[ipoint];
+    point_abc[2] = w[ipoint];
+    TGeometry::evaluate (user, which_tree, point_abc, point_xyz);
+    x[ipoint] = point_xyz[0];
+    y[ipoint] = point_xyz[1];
+    z[ipoint] = point_xyz[2];
+  }
+}
+
+/** The transformation of \ref t8_geometry_new_static. */
+template < class TGeometry > void
+t8_geometry_static_X (t8_geometry_t geom, t8_topidx_t which_tree,
+                      const double abc[3], double xyz[3])
+{
+  TGeometry::evaluate (t8_geometry_get_user (geom), which_tree, abc, xyz);
+}
+
+/** The batched transformation of \ref t8_geometry_new_static. */
+template < class TGeometry > void
+t8_geometry_static_X_batch (t8_geometry_t geom, t8_topidx_t which_tree,
+                            size_t n, const double *abc, double *xyz)
+{
+  t8_geometry_static_evaluate_batch < TGeometry >
+    (t8_geometry_get_user (geom), which_tree, n, abc, xyz);
+}
+
+/** Create a geometry from an analytic geometry class.
+ * Its single point and its batched transformation call
+ * TGeometry::evaluate directly.
+ * \param [in] name        The name of the geometry. It is not copied.
+ * \param [in] user        Passed to TGeometry::evaluate.
+ *                         It is not freed by \ref t8_geometry_reset.
+ * \return                 A geometry with reference count 1.
+ */
+template < class TGeometry > t8_geometry_t
+t8_geometry_new_static (const char *name, void *user)
+{
+  t8_geometry_t       geom;
+
+  t8_geometry_init (&geom);
+  t8_geometry_set_name (geom, name);
+  t8_geometry_set_user (geom, user);
+  t8_geometry_set_transformation (geom, t8_geometry_static_X < TGeometry >);
+  t8_geometry_set_batch_transformation (geom,
+                                        t8_geometry_static_X_batch <
+                                        TGeometry >);
+  return geom;
+}
+
+#endif /* !T8_GEOMETRY_CXX_HXX */
@@ -0,0 +1,364 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_mesh.h>
+#include <t8_threads.h>
+#include <t8_element_cxx.hxx>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_partition.h>
+
+/* The data of the parallel pass over the local trees */
+typedef struct
+{
+  t8_forest_t         forest;
+  t8_mesh_t          *mesh;
+  t8_locidx_t        *tree_vertex_offsets; /* The first vertex entry of each tree */
+} t8_mesh_build_data_t;
+
+/* Fill the entries of the elements of one tree, local or ghost,
+ * except for the global ids of ghosts. */
+static void
+t8_mesh_fill_tree (t8_forest_t forest, t8_mesh_t * mesh, t8_locidx_t ltreeid,
+                   t8_locidx_t first_element, t8_locidx_t first_vertex)
+{
+  t8_locidx_t         num_local_trees, num_elements, ielem, ientry;
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *element;
+  const double       *vertices;
+  t8_gloidx_t         gtreeid;
+  int                 is_ghost, num_vertices, ivertex;
+
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  is_ghost = ltreeid >= num_local_trees;
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  vertices = t8_forest_get_tree_vertices (forest, ltreeid);
+  T8_ASSERT (vertices != NULL);
+  num_vertices = t8_eclass_num_vertices[eclass];
+  if (is_ghost) {
+    num_elements = t8_forest_ghost_tree_num_elements (forest, ltreeid -
+                                                      num_local_trees);
+    gtreeid = t8_forest_ghost_get_global_treeid (forest,
+                                                 ltreeid - num_local_trees);
+  }
+  else {
+    num_elements = t8_forest_get_tree_num_elements (forest, ltreeid);
+    gtreeid = t8_forest_global_tree_id (forest, ltreeid);
+  }
+  ientry = first_vertex;
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    const t8_locidx_t   index = first_element + ielem;
+
+    if (is_ghost) {
+      element = t8_forest_ghost_get_element (forest,
+                                             ltreeid - num_local_trees,
+                                             ielem);
+    }
+    else {
+      element = t8_forest_get_element_in_tree (forest, ltreeid, ielem);
+      mesh->gloids[index] = mesh->first_global_element + index;
+    }
+    mesh->eclasses[index] = (int8_t) eclass;
+    mesh->levels[index] = (int8_t) ts->t8_element_level (element);
+    mesh->gtreeids[index] = gtreeid;
+    mesh->vertex_offsets[index] = ientry;
+    for (ivertex = 0; ivertex < num_vertices; ivertex++, ientry++) {
+      t8_forest_element_coordinate (forest, ltreeid, element, vertices,
+                                    ivertex, mesh->vertex_coords + 3 * ientry);
+    }
+  }
+}
+
+static void
+t8_mesh_fill_local_trees (size_t begin, size_t end, int thread_id,
+                          void *user_data)
+{
+  t8_mesh_build_data_t *data = (t8_mesh_build_data_t *) user_data;
+  size_t              itree;
+
+  for (itree = begin; itree < end; itree++) {
+    t8_mesh_fill_tree (data->forest, data->mesh, (t8_locidx_t) itree,
+                       t8_forest_get_tree_element_offset (data->forest,
+                                                          (t8_locidx_t)
+                                                          itree),
+                       data->tree_vertex_offsets[itree]);
+  }
+}
+
+t8_mesh_t          *
+t8_mesh_new_from_forest (t8_forest_t forest)
+{
+  t8_mesh_t          *mesh;
+  t8_mesh_build_data_t data;
+  t8_forest_face_connectivity_t *conn;
+  t8_locidx_t         num_local_trees, num_ghost_trees, itree, ielem;
+  t8_locidx_t         num_elements, num_ghosts, num_all, num_vertices;
+  t8_locidx_t         num_face_entries, num_neigh_entries, element_offset;
+  t8_eclass_t         eclass;
+  sc_array_t          gloids;
+  int                 mpiret, support, created_tables;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  SC_CHECK_ABORT (forest->mpisize == 1 || forest->ghosts != NULL,
+                  "The mesh of a forest needs a ghost layer.\n");
+
+  /* Creating the elements of implicit trees is not thread-safe */
+  t8_forest_materialize (forest);
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  num_ghost_trees = t8_forest_get_num_ghost_trees (forest);
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  num_all = num_elements + num_ghosts;
+
+  mesh = T8_ALLOC_ZERO (t8_mesh_t, 1);
+  mesh->comm = forest->mpicomm;
+  mesh->dimension = forest->dimension;
+  mesh->num_local_elements = num_elements;
+  mesh->num_ghosts = num_ghosts;
+  mesh->global_num_elements = t8_forest_get_global_num_elements (forest);
+  {
+    t8_gloidx_t         local = num_elements;
+
+    mpiret = sc_MPI_Scan (&local, &mesh->first_global_element, 1,
+                          T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    mesh->first_global_element -= local;
+  }
+  mesh->eclasses = T8_ALLOC (int8_t, num_all);
+  mesh->levels = T8_ALLOC (int8_t, num_all);
+  mesh->gloids = T8_ALLOC (t8_gloidx_t, num_all);
+  mesh->gtreeids = T8_ALLOC (t8_gloidx_t, num_all);
+  mesh->ghost_owners = T8_ALLOC (int, num_ghosts);
+  mesh->vertex_offsets = T8_ALLOC (t8_locidx_t, num_all + 1);
+
+  /* The vertex entries of each tree, local trees first */
+  data.tree_vertex_offsets =
+    T8_ALLOC (t8_locidx_t, num_local_trees + num_ghost_trees + 1);
+  num_vertices = 0;
+  for (itree = 0; itree < num_local_trees + num_ghost_trees; itree++) {
+    data.tree_vertex_offsets[itree] = num_vertices;
+    eclass = t8_forest_get_tree_class (forest, itree);
+    SC_CHECK_ABORT (eclass != T8_ECLASS_PYRAMID,
+                    "Pyramids are not supported by the mesh");
+    num_vertices += t8_eclass_num_vertices[eclass] *
+      (itree < num_local_trees ?
+       t8_forest_get_tree_num_elements (forest, itree) :
+       t8_forest_ghost_tree_num_elements (forest, itree - num_local_trees));
+  }
+  data.tree_vertex_offsets[num_local_trees + num_ghost_trees] = num_vertices;
+  mesh->vertex_offsets[num_all] = num_vertices;
+  mesh->vertex_coords = T8_ALLOC (double, 3 * num_vertices);
+
+  /* Fill the local elements in parallel, then the ghosts */
+  data.forest = forest;
+  data.mesh = mesh;
+  t8_parallel_for (0, num_local_trees, 1, t8_mesh_fill_local_trees, &data);
+  for (itree = 0; itree < num_ghost_trees; itree++) {
+    element_offset = num_elements
+      + t8_forest_ghost_get_tree_element_offset (forest, itree);
+    t8_mesh_fill_tree (forest, mesh, num_local_trees + itree, element_offset,
+                       data.tree_vertex_offsets[num_local_trees + itree]);
+  }
+  T8_FREE (data.tree_vertex_offsets);
+
+  if (forest->ghosts != NULL) {
+    /* The owners of the ghosts */
+    created_tables =
+      t8_forest_partition_tables_require (forest, T8_FOREST_TABLE_ALL);
+    for (itree = 0; itree < num_ghost_trees; itree++) {
+      element_offset = t8_forest_ghost_get_tree_element_offset (forest,
+                                                                itree);
+      eclass = t8_forest_ghost_get_tree_class (forest, itree);
+      for (ielem = 0; ielem < t8_forest_ghost_tree_num_elements (forest,
+                                                                 itree);
+           ielem++) {
+        mesh->ghost_owners[element_offset + ielem] =
+          t8_forest_element_find_owner (forest,
+                                        t8_forest_ghost_get_global_treeid
+                                        (forest, itree),
+                                        t8_forest_ghost_get_element (forest,
+                                                                     itree,
+                                                                     ielem),
+                                        eclass);
+      }
+    }
+    t8_forest_partition_tables_release (forest, created_tables);
+    /* The global ids of the ghosts are known to their owners */
+    sc_array_init_data (&gloids, mesh->gloids, sizeof (t8_gloidx_t),
+                        num_all);
+    t8_forest_ghost_exchange_data (forest, &gloids);
+  }
+
+  /* Take over the face connectivity of the forest, or build our own */
+  if (forest->face_connectivity == NULL) {
+    t8_forest_face_connectivity_build (forest);
+    conn = forest->face_connectivity;
+    forest->face_connectivity = NULL;
+    mesh->face_offsets = conn->face_offsets;
+    mesh->neigh_offsets = conn->neigh_offsets;
+    mesh->face_neighbors = conn->neighbors;
+    mesh->dual_faces = conn->dual_faces;
+    mesh->orientations = conn->orientations;
+    T8_FREE (conn);
+  }
+  else {
+    conn = forest->face_connectivity;
+    num_face_entries = conn->face_offsets[num_elements];
+    num_neigh_entries = conn->neigh_offsets[num_face_entries];
+    mesh->face_offsets = T8_ALLOC (t8_locidx_t, num_elements + 1);
+    mesh->neigh_offsets = T8_ALLOC (t8_locidx_t, num_face_entries + 1);
+    mesh->face_neighbors = T8_ALLOC (t8_locidx_t, num_neigh_entries);
+    mesh->dual_faces = T8_ALLOC (int, num_neigh_entries);
+    mesh->orientations = T8_ALLOC (int8_t, num_face_entries);
+    memcpy (mesh->face_offsets, conn->face_offsets,
+            (num_elements + 1) * sizeof (t8_locidx_t));
+    memcpy (mesh->neigh_offsets, conn->neigh_offsets,
+            (num_face_entries + 1) * sizeof (t8_locidx_t));
+    memcpy (mesh->face_neighbors, conn->neighbors,
+            num_neigh_entries * sizeof (t8_locidx_t));
+    memcpy (mesh->dual_faces, conn->dual_faces,
+            num_neigh_entries * sizeof (int));
+    memcpy (mesh->orientations, conn->orientations,
+            num_face_entries * sizeof (int8_t));
+  }
+  mesh->maximum_support = 0;
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    support = mesh->neigh_offsets[mesh->face_offsets[ielem + 1]]
+      - mesh->neigh_offsets[mesh->face_offsets[ielem]];
+    mesh->maximum_support = SC_MAX (mesh->maximum_support, support);
+  }
+  return mesh;
+}
+
+sc_MPI_Comm
+t8_mesh_get_comm (t8_mesh_t * mesh)
+{
+  return mesh->comm;
+}
+
+t8_locidx_t
+t8_mesh_get_element_count (t8_mesh_t * mesh, t8_eclass_t theclass)
+{
+  t8_locidx_t         ielem, count = 0;
+
+  for (ielem = 0; ielem < mesh->num_local_elements; ielem++) {
+    count += mesh->eclasses[ielem] == theclass;
+  }
+  return count;
+}
+
+t8_eclass_t
+t8_mesh_get_element_class (t8_mesh_t * mesh, t8_locidx_t locid)
+{
+  T8_ASSERT (0 <= locid
+             && locid < mesh->num_local_elements + mesh->num_ghosts);
+  return (t8_eclass_t) mesh->eclasses[locid];
+}
+
+t8_locidx_t
+t8_mesh_get_element_locid (t8_mesh_t * mesh, t8_gloidx_t gloid)
+{
+  if (mesh->first_global_element <= gloid
+      && gloid < mesh->first_global_element + mesh->num_local_elements) {
+    return (t8_locidx_t) (gloid - mesh->first_global_element);
+  }
+  return -1;
+}
+
+t8_gloidx_t
+t8_mesh_get_element_gloid (t8_mesh_t * mesh, t8_locidx_t locid)
+{
+  T8_ASSERT (0 <= locid
+             && locid < mesh->num_local_elements + mesh->num_ghosts);
+  return mesh->gloids[locid];
+}
+
+int
+t8_mesh_get_element_boundary (t8_mesh_t * mesh, t8_locidx_t locid,
+                              int face, const t8_locidx_t ** elemid,
+                              const int **dual_faces)
+{
+  t8_locidx_t         face_entry;
+
+  T8_ASSERT (0 <= locid && locid < mesh->num_local_elements);
+  face_entry = mesh->face_offsets[locid] + face;
+  T8_ASSERT (face_entry < mesh->face_offsets[locid + 1]);
+  if (elemid != NULL) {
+    *elemid = mesh->face_neighbors + mesh->neigh_offsets[face_entry];
+  }
+  if (dual_faces != NULL) {
+    *dual_faces = mesh->dual_faces + mesh->neigh_offsets[face_entry];
+  }
+  return mesh->neigh_offsets[face_entry + 1]
+    - mesh->neigh_offsets[face_entry];
+}
+
+int
+t8_mesh_get_maximum_support (t8_mesh_t * mesh)
+{
+  return mesh->maximum_support;
+}
+
+void
+t8_mesh_get_element_support (t8_mesh_t * mesh, t8_locidx_t locid,
+                             int *length_support, t8_locidx_t * elemid,
+                             int *orientation)
+{
+  t8_locidx_t         face_entry, ineigh;
+  int                 count = 0;
+
+  T8_ASSERT (0 <= locid && locid < mesh->num_local_elements);
+  for (face_entry = mesh->face_offsets[locid];
+       face_entry < mesh->face_offsets[locid + 1]; face_entry++) {
+    for (ineigh = mesh->neigh_offsets[face_entry];
+         ineigh < mesh->neigh_offsets[face_entry + 1]; ineigh++, count++) {
+      SC_CHECK_ABORT (count < *length_support,
+                      "The support array is too short");
+      elemid[count] = mesh->face_neighbors[ineigh];
+      if (orientation != NULL) {
+        orientation[count] = mesh->orientations[face_entry];
+      }
+    }
+  }
+  *length_support = count;
+}
+
+void
+t8_mesh_destroy (t8_mesh_t * mesh)
+{
+  T8_FREE (mesh->eclasses);
+  T8_FREE (mesh->levels);
+  T8_FREE (mesh->gloids);
+  T8_FREE (mesh->gtreeids);
+  T8_FREE (mesh->ghost_owners);
+  T8_FREE (mesh->vertex_offsets);
+  T8_FREE (mesh->vertex_coords);
+  T8_FREE (mesh->face_offsets);
+  T8_FREE (mesh->neigh_offsets);
+  T8_FREE (mesh->face_neighbors);
+  T8_FREE (mesh->dual_faces);
+  T8_FREE (mesh->orientations);
+  T8_FREE (mesh);
+}
@@ -24,107 +24,149 @@
  * The mesh object is defined here.
  * The mesh object is intended for interfacing from and to other codes.  It can
  * be conforming or adaptive, and replicated or distributed in parallel.
- * On input to the creation of a forest, it provides the conforming mesh of
- * coarse elements that are the roots of the tree-based subdivision.  The
- * coarse input mesh must be conforming (have no hanging nodes).
  * On output this mesh contains the connectivity of a mesh that has possibly
  * been adaptively refined (has hanging nodes), including information on remote
  * neighbors.
+ *
+ * A mesh is built from a committed forest with \ref t8_mesh_new_from_forest.
+ * It is a flat copy of the local leafs, followed by the ghost leafs, in
+ * arrays that a solver can loop over without querying the forest:
+ * element classes, levels, global element and tree ids, the coordinates of
+ * the element vertices and the face neighbors of the local elements. Arrays
+ * with a variable number of entries per element are stored in compressed
+ * row storage (CSR), the entries of element i are offsets[i], ...,
+ * offsets[i + 1] - 1. The mesh does not reference the forest, which may be
+ * destroyed or adapted afterwards.
  */
 
 #ifndef T8_MESH_H
 #define T8_MESH_H
 
 #include <t8_element.h>
+#include <t8_forest.h>
 
-typedef struct t8_mesh t8_mesh_t;
-
-/************************* preallocate **************************/
-
-t8_mesh_t          *t8_mesh_new (int dimension,
-                                 t8_gloidx_t Kglobal, t8_locidx_t Klocal);
-
-/************* all-in-one convenience constructors **************/
-
-t8_mesh_t          *t8_mesh_new_unitcube (t8_eclass_t theclass);
-
-/***************************** setters **************************/
-
-void                t8_mesh_set_comm (t8_mesh_t * mesh, sc_MPI_Comm comm);
-
-/** Determine whether we partition in \ref t8_mesh_build.
- * Default true.
+/** The explicit mesh of the leafs of a forest.
+ * Element indices up to num_local_elements - 1 are local elements,
+ * the ghosts follow. All members may be read and must not be changed.
  */
-void                t8_mesh_set_partition (t8_mesh_t * mesh, int enable);
-
-void                t8_mesh_set_element (t8_mesh_t * mesh,
-                                         t8_eclass_t theclass,
-                                         t8_gloidx_t gloid,
-                                         t8_locidx_t locid);
-
-void                t8_mesh_set_local_to_global (t8_mesh_t * mesh,
-                                                 t8_locidx_t ltog_length,
-                                                 const t8_gloidx_t * ltog);
-
-void                t8_mesh_set_face (t8_mesh_t * mesh,
-                                      t8_locidx_t locid1, int face1,
-                                      t8_locidx_t locid2, int face2,
-                                      int orientation);
-
-void                t8_mesh_set_element_vertices (t8_mesh_t * mesh,
-                                                  t8_locidx_t locid,
-                                                  t8_locidx_t vids_length,
-                                                  const t8_locidx_t * vids);
-
-#if 0
-void                t8_mesh_set_element_scheme (t8_mesh_t * mesh,
-                                                t8_locidx_t locid,
-                                                t8_scheme_t * scheme);
-#endif
+typedef struct t8_mesh
+{
+  sc_MPI_Comm         comm;     /**< The communicator of the forest. */
+  int                 dimension; /**< The dimension of the elements. */
+  t8_locidx_t         num_local_elements; /**< The number of local elements. */
+  t8_locidx_t         num_ghosts; /**< The number of ghost elements. */
+  t8_gloidx_t         global_num_elements; /**< The number of elements on all
+                                                processes. */
+  t8_gloidx_t         first_global_element; /**< The global id of the first
+                                                 local element. */
+  int8_t             *eclasses; /**< The class of each element. */
+  int8_t             *levels;   /**< The refinement level of each element. */
+  t8_gloidx_t        *gloids;   /**< The global id of each element. */
+  t8_gloidx_t        *gtreeids; /**< The global id of the tree of each element. */
+  int                *ghost_owners; /**< For each ghost the rank that owns it. */
+  t8_locidx_t        *vertex_offsets; /**< The vertices of element i are
+                                           vertex_offsets[i], ..., vertex_offsets[i + 1] - 1.
+                                           One entry per element plus one. */
+  double             *vertex_coords; /**< Three coordinates per vertex entry. */
+  t8_locidx_t        *face_offsets; /**< The faces of the local element i are the face
+                                         entries face_offsets[i], ..., face_offsets[i + 1] - 1. */
+  t8_locidx_t        *neigh_offsets; /**< The neighbors at face entry f are the entries
+                                          neigh_offsets[f], ..., neigh_offsets[f + 1] - 1. */
+  t8_locidx_t        *face_neighbors; /**< The element index of each neighbor, a local
+                                           element or a ghost. */
+  int                *dual_faces; /**< For each neighbor the face at which it touches the element. */
+  int8_t             *orientations; /**< For each face entry the orientation of the tree face
+                                         connection, 0 if the face is inside a tree. */
+  int                 maximum_support; /**< The maximum number of face neighbors of a
+                                            local element. */
+}
+t8_mesh_t;
+
+T8_EXTERN_C_BEGIN ();
 
 /***************************** construct ************************/
 
-/** Setup a mesh and turn it into a usable object.
+/** Build the explicit mesh of a forest.
+ * The element data of the local elements is computed in one pass over the
+ * trees with \ref t8_parallel_for. The global ids of the ghosts are
+ * exchanged with the ghost layer.
+ * \param [in] forest   A committed and balanced forest. If it is distributed
+ *                      over several processes, it must have a face ghost
+ *                      layer. The vertices of all local and ghost trees must
+ *                      be stored in its cmesh. If \a forest has a face
+ *                      connectivity table, it is copied, see
+ *                      \ref t8_forest_set_face_connectivity.
+ * \return              The mesh.
+ * This function is collective over the communicator of \a forest.
  */
-void                t8_mesh_build (t8_mesh_t * mesh);
+t8_mesh_t          *t8_mesh_new_from_forest (t8_forest_t forest);
 
 /****************************** queries *************************/
 
 sc_MPI_Comm         t8_mesh_get_comm (t8_mesh_t * mesh);
 
+/** Return the number of local elements of one class.
+ * \param [in] mesh     The mesh.
+ * \param [in] theclass An element class.
+ * \return              The number of local elements of class \a theclass.
+ */
 t8_locidx_t         t8_mesh_get_element_count (t8_mesh_t * mesh,
                                                t8_eclass_t theclass);
 
-/** 
- * \param [in] locid            The local number can specify a point of any
- *                              dimension that is locally relevant.
- *                              The points are ordered in reverse to the
- *                              element classes in \ref t8_eclass_t.  The local
- *                              index is cumulative in this order.
+/** Return the class of an element.
+ * \param [in] mesh     The mesh.
+ * \param [in] locid    The index of a local element or a ghost.
+ * \return              The class of the element.
  */
-t8_locidx_t         t8_mesh_get_element_class (t8_mesh_t * mesh,
+t8_eclass_t         t8_mesh_get_element_class (t8_mesh_t * mesh,
                                                t8_locidx_t locid);
 
+/** Return the index of a local element given its global id.
+ * \param [in] mesh     The mesh.
+ * \param [in] gloid    A global element id.
+ * \return              The index of the element if it is local, -1 otherwise.
+ */
 t8_locidx_t         t8_mesh_get_element_locid (t8_mesh_t * mesh,
                                                t8_gloidx_t gloid);
 
+/** Return the global id of an element.
+ * \param [in] mesh     The mesh.
+ * \param [in] locid    The index of a local element or a ghost.
+ * \return              The global id of the element.
+ */
 t8_gloidx_t         t8_mesh_get_element_gloid (t8_mesh_t * mesh,
                                                t8_locidx_t locid);
 
-t8_element_t        t8_mesh_get_element (t8_mesh_t * mesh, t8_locidx_t locid);
-
-void                t8_mesh_get_element_boundary (t8_mesh_t * mesh,
+/** Return the neighbors of a local element across one of its faces.
+ * \param [in] mesh     The mesh.
+ * \param [in] locid    The index of a local element.
+ * \param [in] face     A face of the element.
+ * \param [out] elemid  If not NULL, the element indices of the neighbors.
+ * \param [out] dual_faces If not NULL, the faces of the neighbors.
+ * \return              The number of neighbors, 0 at the domain boundary.
+ * The output arrays point into the mesh.
+ */
+int                 t8_mesh_get_element_boundary (t8_mesh_t * mesh,
                                                   t8_locidx_t locid,
-                                                  int length_boundary,
-                                                  t8_locidx_t * elemid,
-                                                  int *orientation);
+                                                  int face,
+                                                  const t8_locidx_t **
+                                                  elemid,
+                                                  const int **dual_faces);
 
 /** Return the maximum of the length of the support of any local element.
  */
 int                 t8_mesh_get_maximum_support (t8_mesh_t * mesh);
 
-/**
- * \param [in,out] length_support
+/** Return all face neighbors of a local element.
+ * \param [in] mesh     The mesh.
+ * \param [in] locid    The index of a local element.
+ * \param [in,out] length_support On input the length of \a elemid and
+ *                      \a orientation, at least the number of neighbors,
+ *                      see \ref t8_mesh_get_maximum_support. On output the
+ *                      number of neighbors.
+ * \param [out] elemid  The element indices of the neighbors, face by face.
+ * \param [out] orientation If not NULL, for each neighbor the orientation
+ *                      of the face connection.
  */
 void                t8_mesh_get_element_support (t8_mesh_t * mesh,
                                                  t8_locidx_t locid,
@@ -136,4 +178,6 @@ void                t8_mesh_get_element_support (t8_mesh_t * mesh,
 
 void                t8_mesh_destroy (t8_mesh_t * mesh);
 
+T8_EXTERN_C_END ();
+
 #endif /* !T8_MESH_H */
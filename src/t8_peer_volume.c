@@ -0,0 +1,268 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_peer_volume.h>
+
+/* The maximum number of bytes of a CSV row */
+#define T8_PEER_VOLUME_ROW_BYTES 160
+
+const char         *t8_peer_phase_to_string[T8_PEER_PHASE_COUNT] = {
+  "forest_partition", "cmesh_partition", "ghost", "ghost_exchange"
+};
+
+/* The table of volumes, NULL if recording is disabled */
+static sc_hash_array_t *t8_peer_volumes = NULL;
+
+static unsigned
+t8_peer_volume_hash (const void *v, const void *u)
+{
+  const t8_peer_volume_t *volume = (const t8_peer_volume_t *) v;
+
+  return (unsigned) volume->peer * T8_PEER_PHASE_COUNT + volume->phase;
+}
+
+static int
+t8_peer_volume_equal (const void *v1, const void *v2, const void *u)
+{
+  const t8_peer_volume_t *volume1 = (const t8_peer_volume_t *) v1;
+  const t8_peer_volume_t *volume2 = (const t8_peer_volume_t *) v2;
+
+  return volume1->peer == volume2->peer && volume1->phase == volume2->phase;
+}
+
+/* Sort the volumes by phase and peer */
+static int
+t8_peer_volume_compare (const void *v1, const void *v2)
+{
+  const t8_peer_volume_t *volume1 = (const t8_peer_volume_t *) v1;
+  const t8_peer_volume_t *volume2 = (const t8_peer_volume_t *) v2;
+
+  if (volume1->phase != volume2->phase) {
+    return volume1->phase < volume2->phase ? -1 : 1;
+  }
+  return volume1->peer < volume2->peer ? -1 : volume1->peer > volume2->peer;
+}
+
+void
+t8_peer_volume_enable (void)
+{
+  t8_peer_volume_disable ();
+  t8_peer_volumes = sc_hash_array_new (sizeof (t8_peer_volume_t),
+                                       t8_peer_volume_hash,
+                                       t8_peer_volume_equal, NULL);
+}
+
+void
+t8_peer_volume_disable (void)
+{
+  if (t8_peer_volumes != NULL) {
+    sc_hash_array_destroy (t8_peer_volumes);
+    t8_peer_volumes = NULL;
+  }
+}
+
+int
+t8_peer_volume_is_enabled (void)
+{
+  return t8_peer_volumes != NULL;
+}
+
+void
+t8_peer_volume_reset (void)
+{
+  if (t8_peer_volumes != NULL) {
+    t8_peer_volume_enable ();
+  }
+}
+
+/* Return the entry of a phase and peer, which is created if necessary */
+static t8_peer_volume_t *
+t8_peer_volume_find (t8_peer_phase_t phase, int peer)
+{
+  t8_peer_volume_t    key, *volume;
+  size_t              position;
+
+  T8_ASSERT (0 <= phase && phase < T8_PEER_PHASE_COUNT);
+  T8_ASSERT (peer >= 0);
+  memset (&key, 0, sizeof (key));
+  key.phase = phase;
+  key.peer = peer;
+  volume = (t8_peer_volume_t *)
+    sc_hash_array_insert_unique (t8_peer_volumes, &key, &position);
+  if (volume != NULL) {
+    /* This is a new entry */
+    *volume = key;
+    return volume;
+  }
+  return (t8_peer_volume_t *) sc_array_index (&t8_peer_volumes->a, position);
+}
+
+void
+t8_peer_volume_send (t8_peer_phase_t phase, int peer, size_t bytes)
+{
+  t8_peer_volume_t   *volume;
+
+  if (t8_peer_volumes == NULL) {
+    return;
+  }
+  volume = t8_peer_volume_find (phase, peer);
+  volume->bytes_sent += bytes;
+  volume->messages_sent++;
+}
+
+void
+t8_peer_volume_receive (t8_peer_phase_t phase, int peer, size_t bytes)
+{
+  t8_peer_volume_t   *volume;
+
+  if (t8_peer_volumes == NULL) {
+    return;
+  }
+  volume = t8_peer_volume_find (phase, peer);
+  volume->bytes_received += bytes;
+  volume->messages_received++;
+}
+
+void
+t8_peer_volume_get (sc_array_t * volumes)
+{
+  T8_ASSERT (volumes != NULL);
+  T8_ASSERT (volumes->elem_size == sizeof (t8_peer_volume_t));
+
+  if (t8_peer_volumes == NULL) {
+    sc_array_resize (volumes, 0);
+    return;
+  }
+  sc_array_copy (volumes, &t8_peer_volumes->a);
+  sc_array_sort (volumes, t8_peer_volume_compare);
+}
+
+/* Print the CSV rows of this process. Return the allocated string and
+ * store its length in plength. */
+static char        *
+t8_peer_volume_serialize (int rank, int *plength)
+{
+  sc_array_t          volumes;
+  const t8_peer_volume_t *volume;
+  char               *buffer;
+  size_t              ivolume, size, length = 0;
+
+  sc_array_init (&volumes, sizeof (t8_peer_volume_t));
+  t8_peer_volume_get (&volumes);
+  size = (volumes.elem_count + 1) * T8_PEER_VOLUME_ROW_BYTES;
+  buffer = T8_ALLOC (char, size);
+  buffer[0] = '\0';
+  for (ivolume = 0; ivolume < volumes.elem_count; ivolume++) {
+    volume = (const t8_peer_volume_t *) sc_array_index (&volumes, ivolume);
+    length += snprintf (buffer + length, size - length,
+                        "%i,%s,%i,%lld,%lld,%lld,%lld\n", rank,
+                        t8_peer_phase_to_string[volume->phase], volume->peer,
+                        (long long) volume->bytes_sent,
+                        (long long) volume->messages_sent,
+                        (long long) volume->bytes_received,
+                        (long long) volume->messages_received);
+  }
+  T8_ASSERT (length < size);
+  sc_array_reset (&volumes);
+  *plength = (int) length;
+  return buffer;
+}
+
+/* Write CSV rows with a header to a file. Return true on success. */
+static int
+t8_peer_volume_write_file (const char *filename, const char *rows,
+                           size_t length)
+{
+  FILE               *file;
+  int                 success;
+
+  file = fopen (filename, "w");
+  if (file == NULL) {
+    t8_errorf ("Could not open file %s\n", filename);
+    return 0;
+  }
+  success = fprintf (file, "rank,phase,peer,bytes_sent,messages_sent,"
+                     "bytes_received,messages_received\n") > 0
+    && fwrite (rows, 1, length, file) == length;
+  success = fclose (file) == 0 && success;
+  if (!success) {
+    t8_errorf ("Error when writing file %s\n", filename);
+  }
+  return success;
+}
+
+int
+t8_peer_volume_write_csv (const char *fileprefix, sc_MPI_Comm comm,
+                          int gathered)
+{
+  char                filename[BUFSIZ];
+  char               *rows, *all_rows = NULL;
+  int                *lengths = NULL, *displs = NULL;
+  int                 rank, size, length, iproc, total = 0;
+  int                 success = 1, global_success;
+  int                 mpiret;
+
+  T8_ASSERT (fileprefix != NULL);
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  rows = t8_peer_volume_serialize (rank, &length);
+  if (!gathered) {
+    snprintf (filename, BUFSIZ, "%s_%04d.csv", fileprefix, rank);
+    success = t8_peer_volume_write_file (filename, rows, length);
+  }
+  else {
+    /* Collect the rows of all ranks on rank 0 */
+    if (rank == 0) {
+      lengths = T8_ALLOC (int, size);
+      displs = T8_ALLOC (int, size);
+    }
+    mpiret = sc_MPI_Gather (&length, 1, sc_MPI_INT, lengths, 1, sc_MPI_INT,
+                            0, comm);
+    SC_CHECK_MPI (mpiret);
+    if (rank == 0) {
+      for (iproc = 0; iproc < size; iproc++) {
+        displs[iproc] = total;
+        total += lengths[iproc];
+      }
+      all_rows = T8_ALLOC (char, SC_MAX (total, 1));
+    }
+    mpiret = sc_MPI_Gatherv (rows, length, sc_MPI_BYTE, all_rows, lengths,
+                             displs, sc_MPI_BYTE, 0, comm);
+    SC_CHECK_MPI (mpiret);
+    if (rank == 0) {
+      snprintf (filename, BUFSIZ, "%s.csv", fileprefix);
+      success = t8_peer_volume_write_file (filename, all_rows, total);
+      T8_FREE (all_rows);
+      T8_FREE (lengths);
+      T8_FREE (displs);
+    }
+  }
+  T8_FREE (rows);
+
+  mpiret = sc_MPI_Allreduce (&success, &global_success, 1, sc_MPI_INT,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  return global_success;
+}
@@ -0,0 +1,128 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_peer_volume.h
+ * Record the bytes and messages that this process exchanges with each
+ * other process.
+ *
+ * The profiles of forests and cmeshes store the total volume of the last
+ * partition or ghost creation. To find hot spots of the network, the
+ * volume can additionally be recorded per remote rank and per phase.
+ * Recording is disabled by default. After \ref t8_peer_volume_enable,
+ * each message of the forest partition, the cmesh partition, the ghost
+ * creation and the ghost data exchange adds to a sparse table with one
+ * entry per phase and remote rank, which holds the sums over all calls
+ * until \ref t8_peer_volume_reset. Messages of this process to itself are
+ * not recorded.
+ * \ref t8_peer_volume_write_csv writes the table of each rank, or of all
+ * ranks into one file.
+ */
+
+#ifndef T8_PEER_VOLUME_H
+#define T8_PEER_VOLUME_H
+
+#include <t8.h>
+
+/** The phases whose messages are recorded */
+typedef enum t8_peer_phase
+{
+  T8_PEER_FOREST_PARTITION = 0, /**< The elements sent by forest partition. */
+  T8_PEER_CMESH_PARTITION,      /**< The trees sent by cmesh partition. */
+  T8_PEER_GHOST,                /**< The elements sent by ghost creation. */
+  T8_PEER_GHOST_EXCHANGE,       /**< The data sent by ghost exchanges. */
+  T8_PEER_PHASE_COUNT           /**< The number of phases. */
+} t8_peer_phase_t;
+
+/** The volume exchanged with one remote rank in one phase */
+typedef struct t8_peer_volume
+{
+  int                 phase;    /**< The \ref t8_peer_phase_t. */
+  int                 peer;     /**< The remote rank. */
+  int64_t             bytes_sent;       /**< The bytes sent to the peer. */
+  int64_t             messages_sent;    /**< The messages sent to the peer. */
+  int64_t             bytes_received;   /**< The bytes received from the peer. */
+  int64_t             messages_received;        /**< The messages received
+                                                     from the peer. */
+} t8_peer_volume_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** The names of the phases, as written to the CSV files. */
+extern const char  *t8_peer_phase_to_string[T8_PEER_PHASE_COUNT];
+
+/** Start to record the messages with an empty table. */
+void                t8_peer_volume_enable (void);
+
+/** Stop to record the messages and free the table. */
+void                t8_peer_volume_disable (void);
+
+/** Query whether the messages are recorded.
+ * \return          True between \ref t8_peer_volume_enable and
+ *                  \ref t8_peer_volume_disable.
+ */
+int                 t8_peer_volume_is_enabled (void);
+
+/** Remove all entries of the table, for example after each time step. */
+void                t8_peer_volume_reset (void);
+
+/** Record a message to a remote rank.
+ * It is ignored if the recording is disabled.
+ * \param [in] phase   The phase that sends the message.
+ * \param [in] peer    The receiving rank.
+ * \param [in] bytes   The size of the message.
+ */
+void                t8_peer_volume_send (t8_peer_phase_t phase, int peer,
+                                         size_t bytes);
+
+/** Record a message from a remote rank.
+ * It is ignored if the recording is disabled.
+ * \param [in] phase   The phase that receives the message.
+ * \param [in] peer    The sending rank.
+ * \param [in] bytes   The size of the message.
+ */
+void                t8_peer_volume_receive (t8_peer_phase_t phase, int peer,
+                                            size_t bytes);
+
+/** Copy the table of this process.
+ * \param [in,out] volumes  An array of \ref t8_peer_volume_t. On output it
+ *                          holds the entries sorted by phase and peer.
+ */
+void                t8_peer_volume_get (sc_array_t * volumes);
+
+/** Write the tables as CSV files with the columns rank, phase, peer,
+ * bytes_sent, messages_sent, bytes_received and messages_received.
+ * This function is collective.
+ * \param [in] fileprefix  The prefix of the files.
+ * \param [in] comm        The communicator of the recorded messages.
+ * \param [in] gathered    If true, rank 0 writes the entries of all ranks
+ *                         to fileprefix.csv. Otherwise, each rank writes
+ *                         its entries to fileprefix_RANK.csv, where RANK
+ *                         has at least four digits.
+ * \return                 True on all processes if all files were
+ *                         written, false otherwise.
+ */
+int                 t8_peer_volume_write_csv (const char *fileprefix,
+                                              sc_MPI_Comm comm, int gathered);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_PEER_VOLUME_H */
@@ -0,0 +1,150 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_profile.h>
+
+void
+t8_profile_reduce (int num_values, const double *local, sc_MPI_Comm comm,
+                   t8_profile_value_t * values)
+{
+  double             *extrema, *global_extrema, *sums;
+  int                *ranks, *global_ranks;
+  int                 mpirank, mpisize, mpiret, ivalue;
+
+  T8_ASSERT (num_values >= 0);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  extrema = T8_ALLOC (double, 4 * num_values);
+  global_extrema = extrema + 2 * num_values;
+  sums = T8_ALLOC (double, num_values);
+  ranks = T8_ALLOC (int, 2 * num_values);
+  global_ranks = ranks + num_values;
+
+  /* Reduce the maximum and the negative minimum at once */
+  for (ivalue = 0; ivalue < num_values; ivalue++) {
+    extrema[ivalue] = local[ivalue];
+    extrema[num_values + ivalue] = -local[ivalue];
+  }
+  mpiret = sc_MPI_Allreduce (extrema, global_extrema, 2 * num_values,
+                             sc_MPI_DOUBLE, sc_MPI_MAX, comm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Allreduce ((void *) local, sums, num_values,
+                             sc_MPI_DOUBLE, sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  /* The smallest rank whose value is the maximum */
+  for (ivalue = 0; ivalue < num_values; ivalue++) {
+    ranks[ivalue] =
+      local[ivalue] == global_extrema[ivalue] ? mpirank : mpisize;
+  }
+  mpiret = sc_MPI_Allreduce (ranks, global_ranks, num_values, sc_MPI_INT,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+
+  for (ivalue = 0; ivalue < num_values; ivalue++) {
+    values[ivalue].local = local[ivalue];
+    values[ivalue].max = global_extrema[ivalue];
+    values[ivalue].min = -global_extrema[num_values + ivalue];
+    values[ivalue].avg = sums[ivalue] / mpisize;
+    values[ivalue].imbalance = values[ivalue].avg > 0 ?
+      values[ivalue].max / values[ivalue].avg : 1;
+    values[ivalue].rank_of_max = global_ranks[ivalue];
+  }
+  T8_FREE (extrema);
+  T8_FREE (sums);
+  T8_FREE (ranks);
+}
+
+void
+t8_profile_print (int num_values, const char *const *names,
+                  const t8_profile_value_t * values)
+{
+  int                 ivalue;
+
+  for (ivalue = 0; ivalue < num_values; ivalue++) {
+    t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS,
+             "%-32s min %-10g avg %-10g max %-10g (rank %i) "
+             "imbalance %.3f\n", names[ivalue], values[ivalue].min,
+             values[ivalue].avg, values[ivalue].max,
+             values[ivalue].rank_of_max, values[ivalue].imbalance);
+  }
+}
+
+/* The number of started and not yet stopped memory phases */
+static int          t8_profile_memory_depth = 0;
+
+/* Read an entry in kB of /proc/self/status and return it in bytes.
+ * Return 0 if it cannot be read. */
+static size_t
+t8_profile_memory_read (const char *key)
+{
+  FILE               *file;
+  char                line[BUFSIZ];
+  size_t              len = strlen (key);
+  unsigned long       kbytes = 0;
+
+  file = fopen ("/proc/self/status", "r");
+  if (file == NULL) {
+    return 0;
+  }
+  while (fgets (line, BUFSIZ, file) != NULL) {
+    if (!strncmp (line, key, len) && line[len] == ':') {
+      if (sscanf (line + len + 1, "%lu", &kbytes) != 1) {
+        kbytes = 0;
+      }
+      break;
+    }
+  }
+  fclose (file);
+  return (size_t) kbytes * 1024;
+}
+
+void
+t8_profile_memory_start (t8_profile_memory_t * memory)
+{
+  FILE               *file;
+
+  T8_ASSERT (memory != NULL);
+  if (t8_profile_memory_depth++ == 0) {
+    /* Writing 5 resets the peak resident memory (Linux 4.0 and later) */
+    file = fopen ("/proc/self/clear_refs", "w");
+    if (file != NULL) {
+      fputs ("5", file);
+      fclose (file);
+    }
+  }
+  memory->before = t8_profile_memory_read ("VmRSS");
+  memory->peak = memory->after = 0;
+}
+
+void
+t8_profile_memory_stop (t8_profile_memory_t * memory)
+{
+  T8_ASSERT (memory != NULL);
+  T8_ASSERT (t8_profile_memory_depth > 0);
+  t8_profile_memory_depth--;
+  memory->after = t8_profile_memory_read ("VmRSS");
+  memory->peak = SC_MAX (t8_profile_memory_read ("VmHWM"),
+                         SC_MAX (memory->before, memory->after));
+}
@@ -0,0 +1,110 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_profile.h
+ * Reduce profiled values over the processes and find the outliers.
+ *
+ * \ref t8_forest_print_profile and \ref t8_cmesh_print_profile print the
+ * statistics of the last commit. To follow a simulation over many time
+ * steps, the values of each commit can be summed up in a
+ * \ref t8_forest_profile_accum_t or a \ref t8_cmesh_profile_accum_t.
+ * \ref t8_profile_reduce computes their minimum, average and maximum over
+ * the processes, the rank that has the maximum and the imbalance, which
+ * can be logged by the application or printed by \ref t8_profile_print.
+ *
+ * \ref t8_profile_memory_start and \ref t8_profile_memory_stop sample the
+ * resident memory of the process around a phase, such that phases that
+ * transiently need much memory can be found.
+ */
+
+#ifndef T8_PROFILE_H
+#define T8_PROFILE_H
+
+#include <t8.h>
+
+/** A profiled value reduced over the processes */
+typedef struct t8_profile_value
+{
+  double              local;    /**< The value of this process. */
+  double              min;      /**< The minimum over all processes. */
+  double              max;      /**< The maximum over all processes. */
+  double              avg;      /**< The average over all processes. */
+  double              imbalance; /**< The ratio of max and avg, 1 if avg
+                                      is not positive. */
+  int                 rank_of_max; /**< The smallest rank with the
+                                        maximum. */
+}
+t8_profile_value_t;
+
+/** The resident memory of the process during a phase, in bytes.
+ * The values are read from /proc/self/status and are 0 on systems
+ * without it. */
+typedef struct t8_profile_memory
+{
+  size_t              before;   /**< The resident memory at the start. */
+  size_t              peak;     /**< The peak resident memory during the
+                                     phase. */
+  size_t              after;    /**< The resident memory at the end. */
+}
+t8_profile_memory_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Reduce values over the processes of a communicator.
+ * This function is collective.
+ * \param [in] num_values  The number of values of each process.
+ * \param [in] local       The \a num_values values of this process.
+ * \param [in] comm        The communicator.
+ * \param [out] values     The \a num_values reduced values.
+ */
+void                t8_profile_reduce (int num_values, const double *local,
+                                       sc_MPI_Comm comm,
+                                       t8_profile_value_t * values);
+
+/** Print reduced values on rank 0 with the statistics log level.
+ * \param [in] num_values  The number of values.
+ * \param [in] names       The names of the values.
+ * \param [in] values      The values from \ref t8_profile_reduce.
+ */
+void                t8_profile_print (int num_values,
+                                      const char *const *names,
+                                      const t8_profile_value_t * values);
+
+/** Start to sample the memory of a phase.
+ * The peak resident memory of the process is reset, if the system allows
+ * it, such that \ref t8_profile_memory_stop reports the peak of this phase.
+ * Otherwise the peak is the peak since the start of the process.
+ * Phases may be nested. Then the peak is not reset by the inner phases
+ * and they report the peak since the outermost phase started.
+ * \param [out] memory  The memory of the phase.
+ */
+void                t8_profile_memory_start (t8_profile_memory_t * memory);
+
+/** Stop to sample the memory of a phase.
+ * \param [in,out] memory  The memory of a phase passed to
+ *                         \ref t8_profile_memory_start.
+ */
+void                t8_profile_memory_stop (t8_profile_memory_t * memory);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_PROFILE_H */
@@ -0,0 +1,192 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_quadrature.h>
+
+/* The maximum number of Newton iterations for a Gauss-Legendre point */
+#define T8_QUADRATURE_MAX_NEWTON 100
+
+/* The number of Gauss-Legendre points that integrate a degree exactly */
+#define T8_QUADRATURE_GAUSS_POINTS(degree) ((degree) / 2 + 1)
+
+void
+t8_quadrature_gauss_legendre (int num_points, double *points,
+                              double *weights)
+{
+  double              x, dx, p0, p1, p2, dp;
+  int                 i, k, iter;
+
+  T8_ASSERT (num_points >= 1);
+
+  for (i = 0; i < (num_points + 1) / 2; i++) {
+    /* Find the i-th largest root of the Legendre polynomial on [-1,1] with
+     * Newton's method, starting from an asymptotic approximation */
+    x = cos (M_PI * (i + .75) / (num_points + .5));
+    dp = 1;
+    for (iter = 0; iter < T8_QUADRATURE_MAX_NEWTON; iter++) {
+      /* Evaluate P_n and P_{n-1} with the three term recurrence */
+      p0 = 1;
+      p1 = x;
+      for (k = 2; k <= num_points; k++) {
+        p2 = ((2 * k - 1) * x * p1 - (k - 1) * p0) / k;
+        p0 = p1;
+        p1 = p2;
+      }
+      dp = num_points * (x * p1 - p0) / (x * x - 1);
+      dx = p1 / dp;
+      x -= dx;
+      if (fabs (dx) < 1e-16) {
+        break;
+      }
+    }
+    /* Map the root and its mirror image to [0,1] */
+    points[i] = .5 * (1 - x);
+    points[num_points - 1 - i] = .5 * (1 + x);
+    weights[i] = weights[num_points - 1 - i] = 1 / ((1 - x * x) * dp * dp);
+  }
+}
+
+/* Allocate a rule with a given number of points */
+static t8_quadrature_t *
+t8_quadrature_alloc (t8_eclass_t eclass, int degree, int num_points)
+{
+  t8_quadrature_t    *quad;
+
+  quad = T8_ALLOC (t8_quadrature_t, 1);
+  quad->eclass = eclass;
+  quad->degree = degree;
+  quad->num_points = num_points;
+  quad->points = T8_ALLOC_ZERO (double, 3 * num_points);
+  quad->weights = T8_ALLOC (double, num_points);
+  return quad;
+}
+
+t8_quadrature_t    *
+t8_quadrature_new (t8_eclass_t eclass, int degree)
+{
+  t8_quadrature_t    *quad;
+  double             *u, *v, *w;
+  double             *pa, *wa, *pb, *wb, *pc, *wc;
+  int                 na, nb, nc, ia, ib, ic, dim, ipoint;
+
+  T8_ASSERT (degree >= 0);
+  SC_CHECK_ABORT (eclass != T8_ECLASS_PYRAMID,
+                  "Quadrature is not supported for pyramids.\n");
+
+  /* The rules are products of Gauss-Legendre rules in the directions a, b
+   * and c. In a simplex the density of the collapsed coordinates raises
+   * the degree in a and b. */
+  dim = t8_eclass_to_dimension[eclass];
+  switch (eclass) {
+  case T8_ECLASS_TRIANGLE:
+    na = T8_QUADRATURE_GAUSS_POINTS (degree + 1);
+    nb = T8_QUADRATURE_GAUSS_POINTS (degree);
+    nc = 1;
+    break;
+  case T8_ECLASS_TET:
+    na = T8_QUADRATURE_GAUSS_POINTS (degree + 2);
+    nb = T8_QUADRATURE_GAUSS_POINTS (degree + 1);
+    nc = T8_QUADRATURE_GAUSS_POINTS (degree);
+    break;
+  case T8_ECLASS_PRISM:
+    na = T8_QUADRATURE_GAUSS_POINTS (degree + 1);
+    nb = nc = T8_QUADRATURE_GAUSS_POINTS (degree);
+    break;
+  default:
+    na = dim > 0 ? T8_QUADRATURE_GAUSS_POINTS (degree) : 1;
+    nb = dim > 1 ? na : 1;
+    nc = dim > 2 ? na : 1;
+  }
+  pa = T8_ALLOC (double, 2 * (na + nb + nc));
+  wa = pa + na;
+  pb = wa + na;
+  wb = pb + nb;
+  pc = wb + nb;
+  wc = pc + nc;
+  t8_quadrature_gauss_legendre (na, pa, wa);
+  t8_quadrature_gauss_legendre (nb, pb, wb);
+  t8_quadrature_gauss_legendre (nc, pc, wc);
+  if (dim == 0) {
+    wa[0] = 1;
+  }
+  if (dim < 2) {
+    wb[0] = 1;
+  }
+  if (dim < 3) {
+    wc[0] = 1;
+  }
+
+  quad = t8_quadrature_alloc (eclass, degree, na * nb * nc);
+  u = quad->points;
+  v = u + quad->num_points;
+  w = v + quad->num_points;
+  ipoint = 0;
+  for (ic = 0; ic < nc; ic++) {
+    for (ib = 0; ib < nb; ib++) {
+      for (ia = 0; ia < na; ia++, ipoint++) {
+        quad->weights[ipoint] = wa[ia] * wb[ib] * wc[ic];
+        switch (eclass) {
+        case T8_ECLASS_VERTEX:
+          break;
+        case T8_ECLASS_TRIANGLE:
+          /* u = a, v = a b with density a */
+          u[ipoint] = pa[ia];
+          v[ipoint] = pa[ia] * pb[ib];
+          quad->weights[ipoint] *= pa[ia];
+          break;
+        case T8_ECLASS_TET:
+          /* u = a, w = a b, v = a b c with density a^2 b */
+          u[ipoint] = pa[ia];
+          w[ipoint] = pa[ia] * pb[ib];
+          v[ipoint] = pa[ia] * pb[ib] * pc[ic];
+          quad->weights[ipoint] *= pa[ia] * pa[ia] * pb[ib];
+          break;
+        case T8_ECLASS_PRISM:
+          /* The triangle rule times the rule in w */
+          u[ipoint] = pa[ia];
+          v[ipoint] = pa[ia] * pb[ib];
+          w[ipoint] = pc[ic];
+          quad->weights[ipoint] *= pa[ia];
+          break;
+        default:
+          /* A tensor rule */
+          u[ipoint] = pa[ia];
+          v[ipoint] = dim > 1 ? pb[ib] : 0;
+          w[ipoint] = dim > 2 ? pc[ic] : 0;
+        }
+      }
+    }
+  }
+  T8_FREE (pa);
+  return quad;
+}
+
+void
+t8_quadrature_destroy (t8_quadrature_t ** pquad)
+{
+  T8_ASSERT (pquad != NULL && *pquad != NULL);
+
+  T8_FREE ((*pquad)->points);
+  T8_FREE ((*pquad)->weights);
+  T8_FREE (*pquad);
+  *pquad = NULL;
+}
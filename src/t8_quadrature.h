@@ -0,0 +1,90 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_quadrature.h
+ * Quadrature rules on the reference elements of the element classes.
+ *
+ * A rule is a table of reference points and weights that is computed once
+ * and can then be mapped to many elements, for example with
+ * \ref t8_forest_tree_leaf_quadrature.
+ * The reference elements are those of the tree vertices:
+ * the line and the square or cube [0,1]^d, the triangle
+ * 0 <= v <= u <= 1, the tetrahedron 0 <= v <= w <= u <= 1 and the prism,
+ * which is the triangle times [0,1].
+ * Lines, quadrilaterals and hexahedra use tensor Gauss-Legendre rules.
+ * Triangles and tetrahedra use Gauss-Legendre rules on the square or cube
+ * that are collapsed onto the simplex, prisms combine the triangle rule
+ * with a Gauss-Legendre rule. All weights are positive and all points lie
+ * in the interior of the reference element.
+ */
+
+#ifndef T8_QUADRATURE_H
+#define T8_QUADRATURE_H
+
+#include <t8.h>
+#include <t8_eclass.h>
+
+/** A quadrature rule on a reference element. */
+typedef struct t8_quadrature
+{
+  t8_eclass_t         eclass;           /**< The element class. */
+  int                 degree;           /**< The rule integrates all polynomials of this
+                                             total degree exactly. */
+  int                 num_points;       /**< The number of points. */
+  double             *points;           /**< The reference coordinates of the points as a
+                                             batch of 3 \b num_points doubles, first all u,
+                                             then all v and all w coordinates. The
+                                             coordinates beyond the dimension are 0. */
+  double             *weights;          /**< The weight of each point. They add up to the
+                                             volume of the reference element. */
+} t8_quadrature_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Compute the Gauss-Legendre rule with a given number of points on the
+ * interval [0,1]. It integrates polynomials of degree 2 \a num_points - 1
+ * exactly.
+ * \param [in]  num_points  The number of points, at least 1.
+ * \param [out] points      The \a num_points points in increasing order.
+ * \param [out] weights     The \a num_points weights.
+ */
+void                t8_quadrature_gauss_legendre (int num_points,
+                                                  double *points,
+                                                  double *weights);
+
+/** Create a quadrature rule on the reference element of an element class.
+ * \param [in] eclass  The element class. Pyramids are not supported.
+ * \param [in] degree  The polynomial degree that is integrated exactly,
+ *                     at least 0. Tensor rules integrate polynomials of this
+ *                     degree in each coordinate exactly.
+ * \return             The rule. Free it with \ref t8_quadrature_destroy.
+ */
+t8_quadrature_t    *t8_quadrature_new (t8_eclass_t eclass, int degree);
+
+/** Free a quadrature rule.
+ * \param [in,out] pquad  The rule. Set to NULL on output.
+ */
+void                t8_quadrature_destroy (t8_quadrature_t ** pquad);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_QUADRATURE_H */
@@ -42,6 +42,57 @@ t8_refcount_new (void)
 void
 t8_refcount_destroy (t8_refcount_t * rc)
 {
-  T8_ASSERT (!sc_refcount_is_active (rc));
+  T8_ASSERT (!t8_refcount_is_active (rc));
   T8_FREE (rc);
 }
+
+#ifdef T8_REFCOUNT_ATOMIC
+
+/* We use the atomic builtins of GCC, which clang and the Intel compilers
+ * provide as well. Other than C11 atomics they can be used in C and C++
+ * on the int counter of sc_refcount_t. */
+
+void
+t8_refcount_ref_atomic (t8_refcount_t * rc)
+{
+#ifdef T8_ENABLE_DEBUG
+  int                 old_count;
+
+  old_count = __atomic_fetch_add (&rc->refcount, 1, __ATOMIC_RELAXED);
+  T8_ASSERT (old_count > 0);
+#else
+  /* A new reference does not publish any data, a relaxed increment is
+   * sufficient */
+  (void) __atomic_fetch_add (&rc->refcount, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+int
+t8_refcount_unref_atomic (t8_refcount_t * rc)
+{
+  int                 old_count;
+
+  /* Release our changes of the object to the thread that destroys it */
+  old_count = __atomic_fetch_sub (&rc->refcount, 1, __ATOMIC_RELEASE);
+  T8_ASSERT (old_count > 0);
+  if (old_count == 1) {
+    /* Acquire the changes of all threads that released the object */
+    __atomic_thread_fence (__ATOMIC_ACQUIRE);
+    return 1;
+  }
+  return 0;
+}
+
+int
+t8_refcount_is_active_atomic (const t8_refcount_t * rc)
+{
+  return __atomic_load_n (&rc->refcount, __ATOMIC_ACQUIRE) > 0;
+}
+
+int
+t8_refcount_is_last_atomic (const t8_refcount_t * rc)
+{
+  return __atomic_load_n (&rc->refcount, __ATOMIC_ACQUIRE) == 1;
+}
+
+#endif /* T8_REFCOUNT_ATOMIC */
@@ -25,6 +25,16 @@
  * We inherit the reference counting mechanism from libsc.
  * The only customization is to pass the package id of the t8code.
  * This file is compatible with sc_refcount_ref and sc_refcount_unref.
+ *
+ * If t8code is configured with --enable-atomic-refcount or --enable-openmp,
+ * the counters are changed with atomic operations, such that threads may
+ * reference and release the same forest, cmesh or scheme concurrently.
+ * Increments are relaxed, decrements release the changes of the calling
+ * thread and the thread that releases the last reference acquires the
+ * changes of all others before the object is destroyed.
+ * Otherwise the counters are the ones of libsc without any overhead.
+ * A counter must not be changed concurrently with sc_refcount_ref and
+ * sc_refcount_unref, since they are not atomic.
  */
 
 #ifndef T8_REFCOUNT_H
@@ -33,6 +43,11 @@
 #include <t8.h>
 #include <sc_refcount.h>
 
+#if defined (T8_ENABLE_ATOMIC_REFCOUNT) || defined (T8_ENABLE_OPENMP)
+/** If defined, the reference counters are changed atomically. */
+#define T8_REFCOUNT_ATOMIC 1
+#endif
+
 T8_EXTERN_C_BEGIN ();
 
 /** We can reuse the reference counter type from libsc. */
@@ -57,6 +72,38 @@ t8_refcount_t      *t8_refcount_new (void);
  */
 void                t8_refcount_destroy (t8_refcount_t * rc);
 
+#ifdef T8_REFCOUNT_ATOMIC
+
+/** Increase the reference count by one atomically.
+ * \param [in,out] rc      A reference counter with positive count.
+ */
+void                t8_refcount_ref_atomic (t8_refcount_t * rc);
+
+/** Decrease the reference count by one atomically.
+ * \param [in,out] rc      A reference counter with positive count.
+ * \return                 True if the count reached zero.
+ */
+int                 t8_refcount_unref_atomic (t8_refcount_t * rc);
+
+/** Query atomically whether a reference counter has a positive value.
+ * \param [in] rc          A reference counter.
+ * \return                 True if the count is positive.
+ */
+int                 t8_refcount_is_active_atomic (const t8_refcount_t * rc);
+
+/** Query atomically whether a reference counter has value one.
+ * \param [in] rc          A reference counter.
+ * \return                 True if the count is one.
+ */
+int                 t8_refcount_is_last_atomic (const t8_refcount_t * rc);
+
+#define t8_refcount_ref(rc) t8_refcount_ref_atomic(rc)
+#define t8_refcount_unref(rc) t8_refcount_unref_atomic(rc)
+#define t8_refcount_is_active(rc) t8_refcount_is_active_atomic(rc)
+#define t8_refcount_is_last(rc) t8_refcount_is_last_atomic(rc)
+
+#else
+
 /** Increase the reference count by one.
  * It is not necessary to duplicate this functionality as a function. */
 #define t8_refcount_ref(rc) sc_refcount_ref(rc)
@@ -76,6 +123,8 @@ void                t8_refcount_destroy (t8_refcount_t * rc);
 /** Query wether a reference counter has value one. */
 #define t8_refcount_is_last(rc) sc_refcount_is_last(rc)
 
+#endif /* !T8_REFCOUNT_ATOMIC */
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_REFCOUNT_H */
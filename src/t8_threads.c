@@ -0,0 +1,166 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_threads.h>
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#include <omp.h>
+#endif
+
+/* The number of threads set by t8_set_num_threads */
+static int          t8_num_threads = 1;
+
+/* A task of a task group */
+typedef struct
+{
+  t8_task_fn          fn;
+  void               *task_data;
+} t8_task_t;
+
+void
+t8_set_num_threads (int num_threads)
+{
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+  const char         *env;
+
+  if (num_threads < 1) {
+    env = getenv (T8_NUM_THREADS_ENV);
+    num_threads = env != NULL ? atoi (env) : 1;
+  }
+  t8_num_threads = SC_MAX (num_threads, 1);
+#else
+  (void) num_threads;
+  t8_num_threads = 1;
+#endif
+}
+
+int
+t8_get_num_threads (void)
+{
+  return t8_num_threads;
+}
+
+/* Return the number of threads for a parallel region of num_work items.
+ * Within a parallel region we do not start nested threads. */
+static int
+t8_threads_for_work (size_t num_work)
+{
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+  if (omp_in_parallel ()) {
+    return 1;
+  }
+#endif
+  return (int) SC_MIN ((size_t) t8_num_threads, SC_MAX (num_work, 1));
+}
+
+/* Return the number of the calling thread in its team */
+static int
+t8_thread_id (void)
+{
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+  return omp_get_thread_num ();
+#else
+  return 0;
+#endif
+}
+
+void
+t8_parallel_for (size_t begin, size_t end, size_t grain,
+                 t8_parallel_for_fn fn, void *user_data)
+{
+  long                ichunk, num_chunks;
+  int                 num_threads;
+
+  T8_ASSERT (begin <= end);
+  T8_ASSERT (grain >= 1);
+  T8_ASSERT (fn != NULL);
+
+  num_chunks = (long) ((end - begin + grain - 1) / grain);
+  num_threads = t8_threads_for_work ((size_t) num_chunks);
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads) \
+  if (num_threads > 1)
+#else
+  (void) num_threads;
+#endif
+  for (ichunk = 0; ichunk < num_chunks; ichunk++) {
+    const size_t        first = begin + (size_t) ichunk * grain;
+
+    fn (first, SC_MIN (first + grain, end), t8_thread_id (), user_data);
+  }
+}
+
+void
+t8_task_group_init (t8_task_group_t * group)
+{
+  T8_ASSERT (group != NULL);
+
+  sc_array_init (&group->tasks, sizeof (t8_task_t));
+}
+
+void
+t8_task_group_add (t8_task_group_t * group, t8_task_fn fn, void *task_data)
+{
+  t8_task_t          *task;
+
+  T8_ASSERT (group != NULL);
+  T8_ASSERT (fn != NULL);
+
+  task = (t8_task_t *) sc_array_push (&group->tasks);
+  task->fn = fn;
+  task->task_data = task_data;
+}
+
+void
+t8_task_group_run (t8_task_group_t * group)
+{
+  long                itask, num_tasks;
+  int                 num_threads;
+
+  T8_ASSERT (group != NULL);
+
+  num_tasks = (long) group->tasks.elem_count;
+  num_threads = t8_threads_for_work ((size_t) num_tasks);
+  /* The tasks are handed out one by one, such that idle threads take the
+   * tasks that are left */
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads) \
+  if (num_threads > 1)
+#else
+  (void) num_threads;
+#endif
+  for (itask = 0; itask < num_tasks; itask++) {
+    const t8_task_t    *task =
+      (const t8_task_t *) sc_array_index (&group->tasks, (size_t) itask);
+
+    task->fn (task->task_data, t8_thread_id ());
+  }
+  sc_array_truncate (&group->tasks);
+}
+
+void
+t8_task_group_reset (t8_task_group_t * group)
+{
+  T8_ASSERT (group != NULL);
+  T8_ASSERT (group->tasks.elem_count == 0);
+
+  sc_array_reset (&group->tasks);
+}
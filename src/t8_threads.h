@@ -0,0 +1,128 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_threads.h
+ * The threads that t8code uses within one MPI process.
+ *
+ * The number of threads is set by \ref t8_init_ext or by the environment
+ * variable T8_NUM_THREADS and is the default for the threaded algorithms
+ * of t8code, for example \ref t8_forest_set_adapt_threads.
+ * \ref t8_parallel_for and \ref t8_task_group_run distribute work over
+ * these threads. They are built on OpenMP, whose runtime keeps the threads
+ * alive between the calls, and run serially if t8code was configured
+ * without OpenMP or if they are called from within a parallel region.
+ *
+ * Both functions return only when all work is done, and the calling
+ * thread takes part in the work. Thus MPI stays on the thread that calls
+ * them, which is safe with MPI_THREAD_FUNNELED, as long as the callbacks
+ * do not call MPI themselves.
+ */
+
+#ifndef T8_THREADS_H
+#define T8_THREADS_H
+
+#include <t8.h>
+
+/** The name of the environment variable that sets the number of threads
+ * if \ref t8_init_ext does not. */
+#define T8_NUM_THREADS_ENV "T8_NUM_THREADS"
+
+/** The callback of \ref t8_parallel_for.
+ * \param [in] begin      The first index of a chunk.
+ * \param [in] end        One past the last index of the chunk.
+ * \param [in] thread_id  The thread that works on the chunk, smaller than
+ *                        \ref t8_get_num_threads. Use it to select
+ *                        thread local buffers.
+ * \param [in] user_data  The user data passed to \ref t8_parallel_for.
+ */
+typedef void        (*t8_parallel_for_fn) (size_t begin, size_t end,
+                                           int thread_id, void *user_data);
+
+/** The callback of a task of a \ref t8_task_group_t.
+ * \param [in] task_data  The data given to \ref t8_task_group_add.
+ * \param [in] thread_id  The thread that runs the task, smaller than
+ *                        \ref t8_get_num_threads.
+ */
+typedef void        (*t8_task_fn) (void *task_data, int thread_id);
+
+/** A group of independent tasks that are run at once. */
+typedef struct t8_task_group
+{
+  sc_array_t          tasks;    /**< The tasks that were added. */
+}
+t8_task_group_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Set the number of threads of t8code. This is called by \ref t8_init_ext.
+ * \param [in] num_threads  The number of threads. If smaller than 1, the
+ *                          value of T8_NUM_THREADS is used, or 1 if it is
+ *                          not set. Without OpenMP the number is always 1.
+ */
+void                t8_set_num_threads (int num_threads);
+
+/** Return the number of threads of t8code.
+ * \return          At least 1.
+ */
+int                 t8_get_num_threads (void);
+
+/** Call a function for chunks of an index range on all threads.
+ * The range is cut into chunks of \a grain indices, which the threads take
+ * one after the other, such that threads that finish early take more
+ * chunks. The chunks are disjoint and cover the range.
+ * \param [in] begin      The first index.
+ * \param [in] end        One past the last index.
+ * \param [in] grain      The number of indices per chunk, at least 1.
+ * \param [in] fn         Called for each chunk. It must be thread-safe.
+ * \param [in] user_data  Passed to \a fn.
+ */
+void                t8_parallel_for (size_t begin, size_t end, size_t grain,
+                                     t8_parallel_for_fn fn, void *user_data);
+
+/** Initialize an empty task group.
+ * \param [out] group   The group.
+ */
+void                t8_task_group_init (t8_task_group_t * group);
+
+/** Add a task to a group. It is only run by \ref t8_task_group_run.
+ * \param [in,out] group      An initialized group.
+ * \param [in]     fn         The function of the task.
+ * \param [in]     task_data  Passed to \a fn.
+ */
+void                t8_task_group_add (t8_task_group_t * group,
+                                       t8_task_fn fn, void *task_data);
+
+/** Run all tasks of a group on the threads of t8code and wait until they
+ * are done. Idle threads take the tasks that were not started yet.
+ * Afterwards the group is empty and can be reused.
+ * \param [in,out] group   An initialized group.
+ */
+void                t8_task_group_run (t8_task_group_t * group);
+
+/** Free the memory of a task group.
+ * \param [in,out] group   An initialized group without tasks.
+ */
+void                t8_task_group_reset (t8_task_group_t * group);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_THREADS_H */
@@ -0,0 +1,247 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_trace.h>
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#include <omp.h>
+#endif
+
+/* The number of bytes of an event in the output without its name */
+#define T8_TRACE_EVENT_BYTES 96
+
+/* An event of the trace */
+typedef struct
+{
+  const char         *name;     /* The name of the phase */
+  double              time;     /* The time of the event */
+  int                 thread;   /* The thread that recorded the event */
+  char                phase;    /* 'B' for begin and 'E' for end */
+} t8_trace_event_t;
+
+/* The ring buffer of events. It is NULL if tracing is disabled. */
+static t8_trace_event_t *t8_trace_events = NULL;
+static size_t       t8_trace_capacity = 0;
+/* The position of the oldest event and the number of stored events */
+static size_t       t8_trace_first = 0;
+static size_t       t8_trace_count = 0;
+static size_t       t8_trace_dropped = 0;
+/* The time of t8_trace_enable */
+static double       t8_trace_start = 0;
+
+void
+t8_trace_enable (sc_MPI_Comm comm, size_t capacity)
+{
+  int                 mpiret;
+
+  t8_trace_disable ();
+  t8_trace_capacity = capacity > 0 ? capacity : T8_TRACE_DEFAULT_CAPACITY;
+  t8_trace_events = T8_ALLOC (t8_trace_event_t, t8_trace_capacity);
+  mpiret = sc_MPI_Barrier (comm);
+  SC_CHECK_MPI (mpiret);
+  t8_trace_start = sc_MPI_Wtime ();
+}
+
+void
+t8_trace_disable (void)
+{
+  T8_FREE (t8_trace_events);
+  t8_trace_events = NULL;
+  t8_trace_capacity = 0;
+  t8_trace_first = t8_trace_count = t8_trace_dropped = 0;
+}
+
+int
+t8_trace_is_enabled (void)
+{
+  return t8_trace_events != NULL;
+}
+
+/* Store an event in the ring buffer, overwriting the oldest if it is full */
+static void
+t8_trace_record (const char *name, char phase)
+{
+  t8_trace_event_t   *event;
+  double              time;
+  int                 thread = 0;
+
+  if (t8_trace_events == NULL) {
+    return;
+  }
+  T8_ASSERT (name != NULL);
+  time = sc_MPI_Wtime ();
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+  thread = omp_get_thread_num ();
+#pragma omp critical (t8_trace)
+#endif
+  {
+    if (t8_trace_count < t8_trace_capacity) {
+      event = t8_trace_events
+        + (t8_trace_first + t8_trace_count) % t8_trace_capacity;
+      t8_trace_count++;
+    }
+    else {
+      event = t8_trace_events + t8_trace_first;
+      t8_trace_first = (t8_trace_first + 1) % t8_trace_capacity;
+      t8_trace_dropped++;
+    }
+    event->name = name;
+    event->time = time;
+    event->thread = thread;
+    event->phase = phase;
+  }
+}
+
+void
+t8_trace_begin (const char *name)
+{
+  t8_trace_record (name, 'B');
+}
+
+void
+t8_trace_end (const char *name)
+{
+  t8_trace_record (name, 'E');
+}
+
+size_t
+t8_trace_num_events (void)
+{
+  return t8_trace_count;
+}
+
+size_t
+t8_trace_num_dropped (void)
+{
+  return t8_trace_dropped;
+}
+
+/* Print the events of this process in the order of their time as JSON
+ * objects. Each object is preceded by a comma and a newline.
+ * Return the allocated string and store its length in plength. */
+static char        *
+t8_trace_serialize (int rank, int *plength)
+{
+  const t8_trace_event_t *event;
+  char               *buffer;
+  size_t              ievent, size, length;
+
+  size = 2 * T8_TRACE_EVENT_BYTES;
+  for (ievent = 0; ievent < t8_trace_count; ievent++) {
+    event = t8_trace_events + (t8_trace_first + ievent) % t8_trace_capacity;
+    size += strlen (event->name) + T8_TRACE_EVENT_BYTES;
+  }
+  buffer = T8_ALLOC (char, size);
+  /* Name the process by its rank */
+  length = snprintf (buffer, size,
+                     ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%i,"
+                     "\"tid\":0,\"args\":{\"name\":\"rank %i\"}}", rank, rank);
+  for (ievent = 0; ievent < t8_trace_count; ievent++) {
+    event = t8_trace_events + (t8_trace_first + ievent) % t8_trace_capacity;
+    length += snprintf (buffer + length, size - length,
+                        ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,"
+                        "\"pid\":%i,\"tid\":%i}", event->name, event->phase,
+                        1e6 * (event->time - t8_trace_start), rank,
+                        event->thread);
+  }
+  T8_ASSERT (length < size);
+  *plength = (int) length;
+  return buffer;
+}
+
+/* Write serialized events to a file. Return true on success. */
+static int
+t8_trace_write_file (const char *filename, const char *events, size_t length)
+{
+  FILE               *file;
+  int                 success;
+
+  file = fopen (filename, "w");
+  if (file == NULL) {
+    t8_errorf ("Could not open file %s\n", filename);
+    return 0;
+  }
+  /* Skip the comma before the first event */
+  success = fprintf (file, "{\"traceEvents\":[\n") > 0
+    && fwrite (events + 2, 1, length - 2, file) == length - 2
+    && fprintf (file, "\n],\"displayTimeUnit\":\"ms\"}\n") > 0;
+  success = fclose (file) == 0 && success;
+  if (!success) {
+    t8_errorf ("Error when writing file %s\n", filename);
+  }
+  return success;
+}
+
+int
+t8_trace_write (const char *fileprefix, sc_MPI_Comm comm, int merged)
+{
+  char                filename[BUFSIZ];
+  char               *events, *all_events = NULL;
+  int                *lengths = NULL, *displs = NULL;
+  int                 rank, size, length, iproc, total;
+  int                 success = 1, global_success;
+  int                 mpiret;
+
+  T8_ASSERT (fileprefix != NULL);
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  events = t8_trace_serialize (rank, &length);
+  if (!merged) {
+    snprintf (filename, BUFSIZ, "%s_%04d.json", fileprefix, rank);
+    success = t8_trace_write_file (filename, events, length);
+  }
+  else {
+    /* Collect the events of all ranks on rank 0 */
+    if (rank == 0) {
+      lengths = T8_ALLOC (int, size);
+      displs = T8_ALLOC (int, size);
+    }
+    mpiret = sc_MPI_Gather (&length, 1, sc_MPI_INT, lengths, 1, sc_MPI_INT,
+                            0, comm);
+    SC_CHECK_MPI (mpiret);
+    if (rank == 0) {
+      for (iproc = 0, total = 0; iproc < size; iproc++) {
+        displs[iproc] = total;
+        total += lengths[iproc];
+      }
+      all_events = T8_ALLOC (char, total);
+    }
+    mpiret = sc_MPI_Gatherv (events, length, sc_MPI_BYTE, all_events,
+                             lengths, displs, sc_MPI_BYTE, 0, comm);
+    SC_CHECK_MPI (mpiret);
+    if (rank == 0) {
+      snprintf (filename, BUFSIZ, "%s.json", fileprefix);
+      success = t8_trace_write_file (filename, all_events, total);
+      T8_FREE (all_events);
+      T8_FREE (lengths);
+      T8_FREE (displs);
+    }
+  }
+  T8_FREE (events);
+
+  mpiret = sc_MPI_Allreduce (&success, &global_success, 1, sc_MPI_INT,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  return global_success;
+}
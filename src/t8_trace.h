@@ -0,0 +1,112 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_trace.h
+ * Record the begin and end of the phases of t8code as a timeline.
+ *
+ * \ref t8_forest_set_profiling collects aggregate runtimes of the last
+ * commit. In contrast, tracing records an event each time a phase begins
+ * or ends, for example the adapt step, the offsets and the messages of
+ * partition, the ghost search and messages, each balance round and the
+ * VTK output. The events are stored in a ring buffer of fixed size per
+ * process, such that a long run keeps its most recent events.
+ * \ref t8_trace_write stores them in the Chrome trace event format, which
+ * can be viewed with chrome://tracing or Perfetto.
+ *
+ * Tracing is disabled by default, and then each event costs one branch.
+ */
+
+#ifndef T8_TRACE_H
+#define T8_TRACE_H
+
+#include <t8.h>
+
+/** The number of events that \ref t8_trace_enable stores by default. */
+#define T8_TRACE_DEFAULT_CAPACITY 65536
+
+T8_EXTERN_C_BEGIN ();
+
+/** Start to record events on all processes of a communicator.
+ * Any events of a previous trace are discarded.
+ * This function is collective. The time of each event is measured from
+ * the end of a barrier in this call, such that the timelines of the
+ * processes roughly coincide.
+ * \param [in] comm      The communicator of the processes to trace.
+ * \param [in] capacity  The number of events that are kept per process.
+ *                       If 0, \ref T8_TRACE_DEFAULT_CAPACITY is used.
+ *                       If more events occur, the oldest are overwritten.
+ */
+void                t8_trace_enable (sc_MPI_Comm comm, size_t capacity);
+
+/** Stop recording events and free the ring buffer. */
+void                t8_trace_disable (void);
+
+/** Query whether events are recorded.
+ * \return          True if \ref t8_trace_enable was called and
+ *                  \ref t8_trace_disable was not called afterwards.
+ */
+int                 t8_trace_is_enabled (void);
+
+/** Record the begin of a phase. Each begin must be followed by an end
+ * with the same name on the same thread. Phases may be nested.
+ * \param [in] name  The name of the phase. It is not copied and must stay
+ *                   valid until the trace is written, thus it should be a
+ *                   string literal. It must not contain quotes.
+ */
+void                t8_trace_begin (const char *name);
+
+/** Record the end of a phase.
+ * \param [in] name  The name given to \ref t8_trace_begin.
+ */
+void                t8_trace_end (const char *name);
+
+/** Return the number of events that are currently stored.
+ * \return          At most the capacity of the buffer.
+ */
+size_t              t8_trace_num_events (void);
+
+/** Return the number of events that were overwritten because the buffer
+ * was full.
+ * \return          The number of lost events.
+ */
+size_t              t8_trace_num_dropped (void);
+
+/** Write the stored events in the Chrome trace event format.
+ * The process id of the events is the rank of the process in \a comm and
+ * the thread id is the OpenMP thread that recorded them. If the oldest
+ * events were overwritten, the trace may contain ends without a begin.
+ * This function is collective. The events stay stored.
+ * \param [in] fileprefix  The prefix of the files.
+ * \param [in] comm        The communicator given to \ref t8_trace_enable.
+ * \param [in] merged      If true, rank 0 writes the events of all ranks
+ *                         to fileprefix.json. Otherwise, each rank writes
+ *                         its events to fileprefix_RANK.json, where RANK
+ *                         has at least four digits.
+ * \return                 True on all processes if all files were
+ *                         written, false otherwise.
+ */
+int                 t8_trace_write (const char *fileprefix,
+                                    sc_MPI_Comm comm, int merged);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_TRACE_H */
@@ -22,6 +22,13 @@
 
 #include <t8_vec.h>
 
+/* Let the compiler vectorize the loops of the batch routines */
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP) && _OPENMP >= 201307
+#define T8_VEC_SIMD _Pragma ("omp simd")
+#else
+#define T8_VEC_SIMD
+#endif
+
 double
 t8_vec_norm (const double vec[3])
 {
@@ -114,3 +121,80 @@ t8_vec_cross (const double vec_x[3], const double vec_y[3], double cross[3])
       vec_x[(i + 2) % 3] * vec_y[(i + 1) % 3];
   }
 }
+
+void
+t8_vec_batch_set (double *batch, size_t n, size_t i, const double vec[3])
+{
+  T8_ASSERT (i < n);
+  batch[i] = vec[0];
+  batch[n + i] = vec[1];
+  batch[2 * n + i] = vec[2];
+}
+
+void
+t8_vec_batch_get (const double *batch, size_t n, size_t i, double vec[3])
+{
+  T8_ASSERT (i < n);
+  vec[0] = batch[i];
+  vec[1] = batch[n + i];
+  vec[2] = batch[2 * n + i];
+}
+
+void
+t8_vec_batch_axpy (size_t n, const double *batch_x, double *batch_y,
+                   double alpha)
+{
+  size_t              i;
+
+  /* The three coordinate arrays are consecutive, so we use one loop */
+  T8_VEC_SIMD
+  for (i = 0; i < 3 * n; i++) {
+    batch_y[i] += alpha * batch_x[i];
+  }
+}
+
+void
+t8_vec_batch_dot (size_t n, const double *batch_x, const double *batch_y,
+                  double *dots)
+{
+  const double       *x_1 = batch_x + n, *x_2 = batch_x + 2 * n;
+  const double       *y_1 = batch_y + n, *y_2 = batch_y + 2 * n;
+  size_t              i;
+
+  T8_VEC_SIMD
+  for (i = 0; i < n; i++) {
+    dots[i] = batch_x[i] * batch_y[i] + x_1[i] * y_1[i] + x_2[i] * y_2[i];
+  }
+}
+
+void
+t8_vec_batch_cross (size_t n, const double *batch_x, const double *batch_y,
+                    double *cross)
+{
+  const double       *x_1 = batch_x + n, *x_2 = batch_x + 2 * n;
+  const double       *y_1 = batch_y + n, *y_2 = batch_y + 2 * n;
+  double             *c_1 = cross + n, *c_2 = cross + 2 * n;
+  size_t              i;
+
+  T8_ASSERT (cross + 3 * n <= batch_x || batch_x + 3 * n <= cross);
+  T8_ASSERT (cross + 3 * n <= batch_y || batch_y + 3 * n <= cross);
+  T8_VEC_SIMD
+  for (i = 0; i < n; i++) {
+    cross[i] = x_1[i] * y_2[i] - x_2[i] * y_1[i];
+    c_1[i] = x_2[i] * batch_y[i] - batch_x[i] * y_2[i];
+    c_2[i] = batch_x[i] * y_1[i] - x_1[i] * batch_y[i];
+  }
+}
+
+void
+t8_vec_batch_norm (size_t n, const double *batch, double *norms)
+{
+  const double       *x_1 = batch + n, *x_2 = batch + 2 * n;
+  size_t              i;
+
+  T8_VEC_SIMD
+  for (i = 0; i < n; i++) {
+    norms[i] = sqrt (batch[i] * batch[i] + x_1[i] * x_1[i]
+                     + x_2[i] * x_2[i]);
+  }
+}
@@ -96,6 +96,69 @@ double              t8_vec_dot (const double vec_x[3], const double vec_y[3]);
 void                t8_vec_cross (const double vec_x[3],
                                   const double vec_y[3], double cross[3]);
 
+/* The batch routines below work on n 3D vectors stored as a structure of
+ * arrays: a batch is an array of 3 n doubles that holds the x coordinates
+ * of all vectors, followed by the y and the z coordinates. Thus the loops
+ * over the vectors have unit stride and are vectorized by the compiler. */
+
+/** Store a 3D vector in a batch.
+ * \param [in,out] batch  A batch of \a n vectors.
+ * \param [in]     n      The number of vectors of \a batch.
+ * \param [in]     i      The index of the vector to set, smaller \a n.
+ * \param [in]     vec    A 3D vector that is copied to entry \a i.
+ */
+void                t8_vec_batch_set (double *batch, size_t n, size_t i,
+                                      const double vec[3]);
+
+/** Retrieve a 3D vector from a batch.
+ * \param [in]  batch  A batch of \a n vectors.
+ * \param [in]  n      The number of vectors of \a batch.
+ * \param [in]  i      The index of the vector to get, smaller \a n.
+ * \param [out] vec    On output the vector at entry \a i.
+ */
+void                t8_vec_batch_get (const double *batch, size_t n,
+                                      size_t i, double vec[3]);
+
+/** Y_i = Y_i + alpha * X_i for all vectors of a batch.
+ * \param [in]     n        The number of vectors.
+ * \param [in]     batch_x  A batch of \a n vectors.
+ * \param [in,out] batch_y  A batch of \a n vectors, on output set to
+ *                          \a batch_y + \a alpha * \a batch_x.
+ * \param [in]     alpha    A factor.
+ */
+void                t8_vec_batch_axpy (size_t n, const double *batch_x,
+                                       double *batch_y, double alpha);
+
+/** Dot products of the vectors of two batches.
+ * \param [in]  n        The number of vectors.
+ * \param [in]  batch_x  A batch of \a n vectors.
+ * \param [in]  batch_y  A batch of \a n vectors.
+ * \param [out] dots     An array of \a n doubles, on output entry i is
+ *                       the dot product of the vectors i of both batches.
+ */
+void                t8_vec_batch_dot (size_t n, const double *batch_x,
+                                      const double *batch_y, double *dots);
+
+/** Cross products of the vectors of two batches.
+ * \param [in]  n        The number of vectors.
+ * \param [in]  batch_x  A batch of \a n vectors.
+ * \param [in]  batch_y  A batch of \a n vectors.
+ * \param [out] cross    A batch of \a n vectors, on output vector i is
+ *                       the cross product of the vectors i of both batches.
+ *                       It must not overlap \a batch_x or \a batch_y.
+ */
+void                t8_vec_batch_cross (size_t n, const double *batch_x,
+                                        const double *batch_y,
+                                        double *cross);
+
+/** Norms of the vectors of a batch.
+ * \param [in]  n      The number of vectors.
+ * \param [in]  batch  A batch of \a n vectors.
+ * \param [out] norms  An array of \a n doubles, on output the norms.
+ */
+void                t8_vec_batch_norm (size_t n, const double *batch,
+                                       double *norms);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_VEC_H! */
@@ -21,6 +21,7 @@
 */
 
 #include <t8_vtk.h>
+#include <sc_vtk.h>
 
 /* Writes the pvtu header file that links to the processor local files.
  * This function should only be called by one process.
@@ -243,3 +244,118 @@ t8_write_pvtu (const char *filename, int num_procs, int write_tree,
   }
   return 0;
 }
+
+int
+t8_vtk_write_binary (FILE * vtufile, const void *data, size_t num_bytes)
+{
+  int                 retval;
+
+  if (fprintf (vtufile, "          ") <= 0) {
+    return -1;
+  }
+#ifdef T8_VTK_COMPRESSION
+  retval = sc_vtk_write_compressed (vtufile, (char *) data, num_bytes);
+#else
+  retval = sc_vtk_write_binary (vtufile, (char *) data, num_bytes);
+#endif
+  if (retval || fprintf (vtufile, "\n") <= 0) {
+    return -1;
+  }
+  return 0;
+}
+
+/* Append bytes to a buffer */
+static void
+t8_vtk_buffer_write_bytes (t8_vtk_buffer_t * buffer, const void *bytes,
+                           size_t num_bytes)
+{
+  memcpy (sc_array_push_count (&buffer->bytes, num_bytes), bytes,
+          num_bytes);
+}
+
+void
+t8_vtk_buffer_init (t8_vtk_buffer_t * buffer)
+{
+  sc_array_init (&buffer->bytes, sizeof (char));
+}
+
+void
+t8_vtk_buffer_write_string (t8_vtk_buffer_t * buffer, const char *string)
+{
+#ifdef T8_VTK_ASCII
+  t8_vtk_buffer_write_bytes (buffer, string, strlen (string));
+#endif
+}
+
+void
+t8_vtk_buffer_write_int (t8_vtk_buffer_t * buffer, long long value)
+{
+#ifdef T8_VTK_ASCII
+  char                digits[24];
+  char               *pos = digits + sizeof (digits);
+  unsigned long long  magnitude;
+
+  /* We convert the digits ourselves, since this is much faster than
+   * a printf call per value */
+  magnitude = value < 0 ? 0ULL - (unsigned long long) value
+    : (unsigned long long) value;
+  /* Fill the digits from the back, starting with the separator */
+  *--pos = ' ';
+  do {
+    *--pos = (char) ('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude > 0);
+  if (value < 0) {
+    *--pos = '-';
+  }
+  t8_vtk_buffer_write_bytes (buffer, pos, digits + sizeof (digits) - pos);
+#else
+  int32_t             value32 = (int32_t) value;
+
+  t8_vtk_buffer_write_bytes (buffer, &value32, sizeof (value32));
+#endif
+}
+
+void
+t8_vtk_buffer_write_float (t8_vtk_buffer_t * buffer, const char *format,
+                           double value)
+{
+#ifdef T8_VTK_ASCII
+  char                text[64];
+  int                 length;
+
+  length = snprintf (text, sizeof (text), format, value);
+  T8_ASSERT (0 < length && length < (int) sizeof (text));
+  t8_vtk_buffer_write_bytes (buffer, text, length);
+#else
+  T8_VTK_FLOAT_TYPE   float_value = (T8_VTK_FLOAT_TYPE) value;
+
+  t8_vtk_buffer_write_bytes (buffer, &float_value, sizeof (float_value));
+#endif
+}
+
+int
+t8_vtk_buffer_flush (t8_vtk_buffer_t * buffer, FILE * vtufile)
+{
+  int                 retval;
+
+#ifdef T8_VTK_ASCII
+  t8_vtk_buffer_write_string (buffer, "\n");
+  /* Write the text of the whole array at once */
+  retval = fwrite (buffer->bytes.array, 1, buffer->bytes.elem_count,
+                   vtufile) != buffer->bytes.elem_count;
+#else
+  /* Encode and write the values of the whole array at once */
+  retval = t8_vtk_write_binary (vtufile, buffer->bytes.array,
+                                buffer->bytes.elem_count);
+#endif
+  /* Keep the memory for the next array */
+  sc_array_truncate (&buffer->bytes);
+  return retval;
+}
+
+void
+t8_vtk_buffer_reset (t8_vtk_buffer_t * buffer)
+{
+  sc_array_reset (&buffer->bytes);
+}
@@ -40,6 +40,20 @@
  *       Investigate this further. See also vtk makro VTK_USE_64BIT_IDS */
 #define T8_VTK_GLOIDX "Int32"
 
+/* The binary format and its compression are set by configure */
+#if defined (T8_ENABLE_VTK_BINARY) && !defined (T8_VTK_BINARY)
+#define T8_VTK_BINARY
+#endif
+#if defined (T8_ENABLE_VTK_ZLIB) && !defined (T8_VTK_COMPRESSION)
+#define T8_VTK_COMPRESSION
+#endif
+#if defined (T8_VTK_COMPRESSION) && !defined (SC_HAVE_ZLIB)
+#error "Compressed vtk output requires libsc with zlib support"
+#endif
+#if defined (T8_VTK_COMPRESSION) && !defined (T8_VTK_BINARY)
+#error "Compressed vtk output requires the binary vtk format"
+#endif
+
 /* TODO: these macros need to be set by configure */
 #ifndef T8_VTK_DOUBLES
 #define T8_VTK_FLOAT_NAME "Float32"
@@ -71,6 +85,15 @@ typedef struct
                       n = 1 if type = T8_VTK_SCALAR, n = 3 if type = T8_VTK_VECTOR */
 } t8_vtk_data_field_t;
 
+/** A buffer that collects the values of one vtu data array in memory,
+ * so that the whole array is written to the file with a single call.
+ * In ASCII mode it holds the formatted text, in binary mode the raw
+ * values that are encoded when the buffer is written. */
+typedef struct
+{
+  sc_array_t          bytes; /**< The bytes of the current data array */
+} t8_vtk_buffer_t;
+
 T8_EXTERN_C_BEGIN ();
 
 /* function declarations */
@@ -84,6 +107,68 @@ int                 t8_write_pvtu (const char *filename, int num_procs,
                                    int write_level, int write_id,
                                    int num_data, t8_vtk_data_field_t * data);
 
+/** Write a block of binary data base64 encoded to a vtu file.
+ * If t8code is configured with --enable-vtk-zlib, the data is compressed
+ * with zlib before encoding.
+ * The data is written on one line, indented to match the data arrays of
+ * the t8code vtu files.
+ * \param [in,out] vtufile   An open file.
+ * \param [in]     data      The data to write.
+ * \param [in]     num_bytes The number of bytes of \a data.
+ * \return                   0 on success, nonzero otherwise.
+ */
+int                 t8_vtk_write_binary (FILE * vtufile, const void *data,
+                                         size_t num_bytes);
+
+/** Initialize an empty vtu data array buffer.
+ * \param [out] buffer    The buffer, must be reset with
+ *                        \ref t8_vtk_buffer_reset after use.
+ */
+void                t8_vtk_buffer_init (t8_vtk_buffer_t * buffer);
+
+/** Append a separator string to a buffer, for example a line break.
+ * Only ASCII output contains separators, in binary mode this does nothing.
+ * \param [in,out] buffer An initialized buffer.
+ * \param [in]     string The string to append.
+ */
+void                t8_vtk_buffer_write_string (t8_vtk_buffer_t * buffer,
+                                                const char *string);
+
+/** Append an integer value to a buffer.
+ * In ASCII mode the value is followed by a space. In binary mode, it is
+ * stored as Int32, matching T8_VTK_LOCIDX and T8_VTK_GLOIDX.
+ * \param [in,out] buffer An initialized buffer.
+ * \param [in]     value  The value to append.
+ */
+void                t8_vtk_buffer_write_int (t8_vtk_buffer_t * buffer,
+                                             long long value);
+
+/** Append a floating point value to a buffer.
+ * In binary mode, it is stored as T8_VTK_FLOAT_TYPE.
+ * \param [in,out] buffer An initialized buffer.
+ * \param [in]     format The printf format of \a value in ASCII mode.
+ * \param [in]     value  The value to append.
+ */
+void                t8_vtk_buffer_write_float (t8_vtk_buffer_t * buffer,
+                                               const char *format,
+                                               double value);
+
+/** Write the contents of a buffer to a vtu file and empty the buffer.
+ * In ASCII mode the text is followed by a line break, in binary mode the
+ * values are written with \ref t8_vtk_write_binary.
+ * \param [in,out] buffer  An initialized buffer. On output it is empty
+ *                         and may be reused for the next data array.
+ * \param [in,out] vtufile An open file.
+ * \return                 0 on success, nonzero otherwise.
+ */
+int                 t8_vtk_buffer_flush (t8_vtk_buffer_t * buffer,
+                                         FILE * vtufile);
+
+/** Free the memory of a buffer.
+ * \param [in,out] buffer An initialized buffer.
+ */
+void                t8_vtk_buffer_reset (t8_vtk_buffer_t * buffer);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_VTK_H */
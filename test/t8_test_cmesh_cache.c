@@ -0,0 +1,120 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+
+/* The number of calls to the build function */
+static int          test_num_builds = 0;
+
+static t8_cmesh_t
+test_cmesh_cache_build (sc_MPI_Comm comm, void *user_data)
+{
+  test_num_builds++;
+  return t8_cmesh_new_hypercube (*(t8_eclass_t *) user_data, comm, 0, 1, 0);
+}
+
+/* Build a cmesh twice from the same input and check that the second
+ * cmesh is loaded from the cache and equals the first one. */
+static void
+test_cmesh_cache (sc_MPI_Comm comm)
+{
+  const char         *input_file = "t8_test_cmesh_cache.txt";
+  t8_cmesh_t          cmesh, cached;
+  t8_eclass_t         eclass = T8_ECLASS_HEX;
+  t8_locidx_t         itree;
+  FILE               *fp;
+  double              stamp;
+  int                 mpirank, mpiret;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  /* Write an input file with new content, such that the cache misses */
+  stamp = sc_MPI_Wtime ();
+  mpiret = sc_MPI_Bcast (&stamp, 1, sc_MPI_DOUBLE, 0, comm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    fp = fopen (input_file, "w");
+    SC_CHECK_ABORT (fp != NULL, "Could not write the input file.");
+    fprintf (fp, "hypercube %s %.17g\n", t8_eclass_to_string[eclass], stamp);
+    fclose (fp);
+  }
+  mpiret = sc_MPI_Barrier (comm);
+  SC_CHECK_MPI (mpiret);
+
+  cmesh = t8_cmesh_new_cached (input_file, "uniform", ".", comm,
+                               test_cmesh_cache_build, &eclass);
+  SC_CHECK_ABORT (test_num_builds == 1, "The cmesh was not built.");
+  cached = t8_cmesh_new_cached (input_file, "uniform", ".", comm,
+                                test_cmesh_cache_build, &eclass);
+  SC_CHECK_ABORT (test_num_builds == 1, "The cmesh was not cached.");
+  SC_CHECK_ABORT (t8_cmesh_is_committed (cached), "Cmesh commit failed.");
+  SC_CHECK_ABORT (t8_cmesh_get_num_trees (cached) ==
+                  t8_cmesh_get_num_trees (cmesh), "Wrong number of trees.");
+  SC_CHECK_ABORT (t8_cmesh_get_num_local_trees (cached) ==
+                  t8_cmesh_get_num_local_trees (cmesh),
+                  "Wrong number of local trees.");
+  for (itree = 0; itree < t8_cmesh_get_num_local_trees (cmesh); itree++) {
+    SC_CHECK_ABORT (t8_cmesh_get_tree_class (cached, itree) ==
+                    t8_cmesh_get_tree_class (cmesh, itree),
+                    "Wrong tree class.");
+  }
+
+  /* Other options give another key */
+  t8_cmesh_destroy (&cached);
+  cached = t8_cmesh_new_cached (input_file, "reordered", ".", comm,
+                                test_cmesh_cache_build, &eclass);
+  SC_CHECK_ABORT (test_num_builds == 2, "The cmesh was wrongly cached.");
+
+  t8_cmesh_destroy (&cached);
+  t8_cmesh_destroy (&cmesh);
+  mpiret = sc_MPI_Barrier (comm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    remove (input_file);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         comm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  comm = sc_MPI_COMM_WORLD;
+  sc_init (comm, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing cmesh cache.\n");
+  test_cmesh_cache (comm);
+  t8_global_productionf ("Done testing cmesh cache.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -61,9 +61,14 @@ test_cmesh_copy (sc_MPI_Comm comm)
     /* Check for equality */
     retval = t8_cmesh_is_equal (cmesh_copy, cmesh_original);
     SC_CHECK_ABORT (retval == 1, "Cmesh copy failed.");
+    /* The copy does not duplicate the trees */
+    SC_CHECK_ABORT (cmesh_copy->trees == cmesh_original->trees,
+                    "Cmesh copy does not share the trees.");
+    /* The trees of the copy stay valid without the original */
+    t8_cmesh_destroy (&cmesh_original);
+    test_cmesh_committed (cmesh_copy);
     /* Clean-up */
     t8_cmesh_destroy (&cmesh_copy);
-    t8_cmesh_destroy (&cmesh_original);
   }
 }
 
@@ -0,0 +1,120 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+
+/* In this test we check the compact layout of the face neighbors and the
+ * element classes of committed cmeshes. The neighbors, tree to face values
+ * and classes that the lookups read from the compact arrays must be the
+ * ones that are stored with the trees and ghosts in the part memory. */
+
+static void
+t8_test_face_layout_check (t8_cmesh_t cmesh)
+{
+  t8_ctree_t          tree;
+  t8_cghost_t         ghost;
+  t8_locidx_t         num_trees, num_ghosts, itree, ighost, *face_neigh;
+  int8_t             *ttf, compact_ttf;
+  int                 iface;
+
+  SC_CHECK_ABORT (t8_cmesh_is_committed (cmesh), "Cmesh commit failed.");
+  num_trees = t8_cmesh_get_num_local_trees (cmesh);
+  num_ghosts = t8_cmesh_get_num_ghosts (cmesh);
+  SC_CHECK_ABORT (cmesh->trees->compact_num_trees == num_trees
+                  && cmesh->trees->compact_num_ghosts == num_ghosts,
+                  "The compact layout was not built.");
+  SC_CHECK_ABORT (num_trees + num_ghosts == 0
+                  || t8_cmesh_trees_compact_size (cmesh->trees) > 0,
+                  "The compact layout has no memory.");
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_cmesh_trees_get_tree_ext (cmesh->trees, itree, &face_neigh,
+                                        &ttf);
+    SC_CHECK_ABORT (t8_cmesh_trees_get_class (cmesh->trees, itree,
+                                              num_trees) == tree->eclass,
+                    "Wrong class of a tree.");
+    for (iface = 0; iface < t8_eclass_num_faces[tree->eclass]; iface++) {
+      SC_CHECK_ABORT (t8_cmesh_trees_get_face_neighbor_ext
+                      (cmesh->trees, itree, iface, &compact_ttf)
+                      == face_neigh[iface]
+                      && compact_ttf == ttf[iface],
+                      "Wrong face neighbor of a tree.");
+    }
+  }
+  for (ighost = 0; ighost < num_ghosts; ighost++) {
+    ghost = t8_cmesh_trees_get_ghost (cmesh->trees, ighost);
+    SC_CHECK_ABORT (t8_cmesh_trees_get_class (cmesh->trees,
+                                              num_trees + ighost,
+                                              num_trees) == ghost->eclass,
+                    "Wrong class of a ghost.");
+  }
+}
+
+/* Check a cmesh and a copy of it */
+static void
+t8_test_face_layout (t8_cmesh_t cmesh, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh_copy;
+
+  t8_test_face_layout_check (cmesh);
+  t8_cmesh_init (&cmesh_copy);
+  t8_cmesh_set_derive (cmesh_copy, cmesh);
+  t8_cmesh_commit (cmesh_copy, comm);
+  t8_test_face_layout_check (cmesh_copy);
+  t8_cmesh_destroy (&cmesh_copy);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 eclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    t8_global_productionf ("Testing the face layout with eclass %s.\n",
+                           t8_eclass_to_string[eclass]);
+    t8_test_face_layout (t8_cmesh_new_hypercube ((t8_eclass_t) eclass, mpic,
+                                                 0, 0, 0), mpic);
+    t8_test_face_layout (t8_cmesh_new_bigmesh ((t8_eclass_t) eclass, 20,
+                                               mpic), mpic);
+  }
+  t8_test_face_layout (t8_cmesh_new_hypercube_hybrid (3, mpic, 0, 0), mpic);
+  t8_test_face_layout (t8_cmesh_new_periodic (mpic, 2), mpic);
+  t8_test_face_layout (t8_cmesh_new_periodic (mpic, 3), mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,183 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+#include <t8_cmesh/t8_cmesh_face_matching.h>
+
+/* In this test we compute the face connections of the hypercube cmeshes
+ * with the face matching of the mesh readers from the vertices of their
+ * trees. Each tree must have the face neighbors and neighbor faces that
+ * the hypercube sets by hand. The orientation of each connection must
+ * map vertex 0 of the face of the smaller tree to the vertex of the face
+ * of the bigger tree with the same coordinates. */
+
+/* Return the index of a point in a list of points. If the point is not in
+ * the list, it is appended. */
+static long
+t8_test_matching_point_index (double *points, long *num_points,
+                              const double *point)
+{
+  long                ipoint;
+
+  for (ipoint = 0; ipoint < *num_points; ipoint++) {
+    if (points[3 * ipoint] == point[0] && points[3 * ipoint + 1] == point[1]
+        && points[3 * ipoint + 2] == point[2]) {
+      return ipoint;
+    }
+  }
+  memcpy (points + 3 * ipoint, point, 3 * sizeof (double));
+  (*num_points)++;
+  return ipoint;
+}
+
+/* Return true if the vertex iv of face of tree has the given coordinates */
+static int
+t8_test_matching_vertex_is (t8_cmesh_t cmesh, t8_locidx_t tree, int face,
+                            int iv, const double *coords)
+{
+  const t8_eclass_t   eclass = t8_cmesh_get_tree_class (cmesh, tree);
+  const double       *vertices = t8_cmesh_get_tree_vertices (cmesh, tree);
+  const int           vertex = t8_face_vertex_to_tree_vertex[eclass][face][iv];
+
+  return !memcmp (vertices + 3 * vertex, coords, 3 * sizeof (double));
+}
+
+static void
+t8_test_matching (t8_cmesh_t cmesh_ref, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_locidx_t         num_trees, itree, *neigh, *neigh_ref, smaller;
+  t8_eclass_t        *eclasses, eclass;
+  t8_ctree_t          tree;
+  long               *tree_vertices, num_points = 0;
+  double             *points, *vertices;
+  int8_t             *ttf, *ttf_ref;
+  int                 iface, iv, F, orientation, compare, num_vertices;
+  int                 neigh_face;
+
+  num_trees = t8_cmesh_get_num_local_trees (cmesh_ref);
+  F = t8_eclass_max_num_faces[cmesh_ref->dimension];
+  eclasses = T8_ALLOC (t8_eclass_t, num_trees);
+  tree_vertices = T8_ALLOC (long, num_trees * T8_ECLASS_MAX_CORNERS);
+  points = T8_ALLOC (double, 3 * num_trees * T8_ECLASS_MAX_CORNERS);
+  /* Number the vertices of the trees by their coordinates */
+  t8_cmesh_init (&cmesh);
+  for (itree = 0; itree < num_trees; itree++) {
+    eclasses[itree] = t8_cmesh_get_tree_class (cmesh_ref, itree);
+    vertices = t8_cmesh_get_tree_vertices (cmesh_ref, itree);
+    num_vertices = t8_eclass_num_vertices[eclasses[itree]];
+    for (iv = 0; iv < num_vertices; iv++) {
+      tree_vertices[itree * T8_ECLASS_MAX_CORNERS + iv] =
+        t8_test_matching_point_index (points, &num_points,
+                                      vertices + 3 * iv);
+    }
+    t8_cmesh_set_tree_class (cmesh, itree, eclasses[itree]);
+    t8_cmesh_set_tree_vertices (cmesh, itree, t8_get_package_id (), 0,
+                                vertices, num_vertices);
+  }
+  SC_CHECK_ABORT (t8_cmesh_face_matching_set_joins (cmesh, num_trees, 0,
+                                                    eclasses, tree_vertices,
+                                                    T8_ECLASS_MAX_CORNERS, 1,
+                                                    2) >= 0,
+                  "The face matching failed.");
+  t8_cmesh_commit (cmesh, comm);
+  SC_CHECK_ABORT (t8_cmesh_get_num_trees (cmesh) == num_trees,
+                  "Wrong number of trees.");
+
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_cmesh_trees_get_tree_ext (cmesh->trees, itree, &neigh, &ttf);
+    (void) t8_cmesh_trees_get_tree_ext (cmesh_ref->trees, itree, &neigh_ref,
+                                        &ttf_ref);
+    eclass = tree->eclass;
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      SC_CHECK_ABORTF (neigh[iface] == neigh_ref[iface]
+                       && ttf[iface] % F == ttf_ref[iface] % F,
+                       "Wrong neighbor at face %i of tree %li.", iface,
+                       (long) itree);
+      if (neigh[iface] == itree && ttf[iface] % F == iface) {
+        /* A domain boundary */
+        continue;
+      }
+      /* Find the smaller tree of the connection */
+      orientation = ttf[iface] / F;
+      neigh_face = ttf[iface] % F;
+      compare = t8_eclass_compare (eclass, eclasses[neigh[iface]]);
+      smaller = compare < 0 || (compare == 0 && itree < neigh[iface]) ?
+        itree : neigh[iface];
+      vertices = t8_cmesh_get_tree_vertices (cmesh, smaller);
+      if (smaller == itree) {
+        iv = t8_face_vertex_to_tree_vertex[eclass][iface][0];
+        SC_CHECK_ABORTF (t8_test_matching_vertex_is
+                         (cmesh, neigh[iface], neigh_face, orientation,
+                          vertices + 3 * iv),
+                         "Wrong orientation at face %i of tree %li.", iface,
+                         (long) itree);
+      }
+      else {
+        iv = t8_face_vertex_to_tree_vertex[eclasses[smaller]][neigh_face][0];
+        SC_CHECK_ABORTF (t8_test_matching_vertex_is
+                         (cmesh, itree, iface, orientation,
+                          vertices + 3 * iv),
+                         "Wrong orientation at face %i of tree %li.", iface,
+                         (long) itree);
+      }
+    }
+  }
+  T8_FREE (eclasses);
+  T8_FREE (tree_vertices);
+  T8_FREE (points);
+  t8_cmesh_destroy (&cmesh);
+  t8_cmesh_destroy (&cmesh_ref);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 eclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_COUNT; eclass++) {
+    t8_global_productionf ("Testing the face matching with eclass %s.\n",
+                           t8_eclass_to_string[eclass]);
+    t8_test_matching (t8_cmesh_new_hypercube ((t8_eclass_t) eclass, mpic,
+                                              0, 0, 0), mpic);
+  }
+  t8_test_matching (t8_cmesh_new_hypercube_hybrid (3, mpic, 0, 0), mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -181,6 +181,95 @@ test_cmesh_partition (sc_MPI_Comm comm)
   }
 }
 
+/* Create partitioned bigmeshes and check that they are committed properly
+ * and can be repartitioned. */
+static void
+test_cmesh_bigmesh_partitioned (sc_MPI_Comm comm)
+{
+  int                 eci, mpisize, mpiret;
+  t8_gloidx_t         num_trees = 11;   /* prime number */
+  t8_cmesh_t          cmesh, cmesh_concentrate;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  for (eci = T8_ECLASS_VERTEX; eci < T8_ECLASS_COUNT; ++eci) {
+    if (eci == T8_ECLASS_PYRAMID) {
+      /* cmesh_partition does not work with pyramids yet. */
+      continue;
+    }
+    t8_global_productionf ("Testing partitioned bigmesh of eclass %s.\n",
+                           t8_eclass_to_string[eci]);
+    cmesh = t8_cmesh_new_bigmesh_partitioned ((t8_eclass_t) eci, num_trees,
+                                              comm);
+    test_cmesh_committed (cmesh);
+    SC_CHECK_ABORT (t8_cmesh_is_partitioned (cmesh),
+                    "Cmesh is not partitioned.");
+    SC_CHECK_ABORT (t8_cmesh_get_num_trees (cmesh) == num_trees,
+                    "Wrong number of trees.");
+    /* Concentrate all trees on the last process */
+    t8_cmesh_init (&cmesh_concentrate);
+    t8_cmesh_set_derive (cmesh_concentrate, cmesh);
+    t8_cmesh_set_partition_offsets (cmesh_concentrate,
+                                    t8_cmesh_offset_concentrate (mpisize - 1,
+                                                                 comm,
+                                                                 num_trees));
+    t8_cmesh_commit (cmesh_concentrate, comm);
+    test_cmesh_committed (cmesh_concentrate);
+    t8_cmesh_destroy (&cmesh_concentrate);
+  }
+}
+
+/* Partition a hypercube without ghost attributes, fetch the vertices of
+ * the ghosts and compare them to the vertices of the replicated cmesh. */
+static void
+test_cmesh_partition_ghost_attributes (sc_MPI_Comm comm)
+{
+  const t8_eclass_t   eclasses[2] = { T8_ECLASS_TRIANGLE, T8_ECLASS_TET };
+  int                 iclass, num_vertices;
+  t8_locidx_t         ighost, num_local_trees;
+  t8_gloidx_t         gtree_id;
+  t8_cmesh_t          cmesh_original, cmesh;
+  double             *vertices, *vertices_original;
+
+  for (iclass = 0; iclass < 2; iclass++) {
+    cmesh_original = t8_cmesh_new_hypercube (eclasses[iclass], comm, 0, 0, 0);
+    t8_cmesh_ref (cmesh_original);
+    t8_cmesh_init (&cmesh);
+    t8_cmesh_set_derive (cmesh, cmesh_original);
+    t8_cmesh_set_partition_uniform (cmesh, 2);
+    t8_cmesh_set_partition_ghost_attributes (cmesh, 0);
+    t8_cmesh_commit (cmesh, comm);
+    test_cmesh_committed (cmesh);
+    SC_CHECK_ABORT (!t8_cmesh_get_partition_ghost_attributes (cmesh),
+                    "Ghost attribute setting is not kept.");
+
+    num_local_trees = t8_cmesh_get_num_local_trees (cmesh);
+    for (ighost = 0; ighost < t8_cmesh_get_num_ghosts (cmesh); ighost++) {
+      SC_CHECK_ABORT (t8_cmesh_get_attribute (cmesh, t8_get_package_id (), 0,
+                                              num_local_trees + ighost)
+                      == NULL, "Ghost was shipped with its vertices.");
+    }
+    t8_cmesh_fetch_ghost_attribute (cmesh, t8_get_package_id (), 0, comm);
+    num_vertices = t8_eclass_num_vertices[eclasses[iclass]];
+    for (ighost = 0; ighost < t8_cmesh_get_num_ghosts (cmesh); ighost++) {
+      gtree_id = t8_cmesh_get_global_id (cmesh, num_local_trees + ighost);
+      vertices = (double *) t8_cmesh_get_attribute (cmesh,
+                                                    t8_get_package_id (), 0,
+                                                    num_local_trees + ighost);
+      vertices_original = t8_cmesh_get_tree_vertices (cmesh_original,
+                                                      (t8_locidx_t)
+                                                      gtree_id);
+      SC_CHECK_ABORT (vertices != NULL
+                      && !memcmp (vertices, vertices_original,
+                                  3 * num_vertices * sizeof (double)),
+                      "Wrong fetched ghost vertices.");
+    }
+    t8_cmesh_destroy (&cmesh);
+    t8_cmesh_destroy (&cmesh_original);
+  }
+}
+
 int
 main (int argc, char **argv)
 {
@@ -197,6 +286,8 @@ main (int argc, char **argv)
 
   t8_global_productionf ("Testing cmesh partition.\n");
   test_cmesh_partition (comm);
+  test_cmesh_bigmesh_partitioned (comm);
+  test_cmesh_partition_ghost_attributes (comm);
   t8_global_productionf ("Done testing cmesh partition.\n");
 
   sc_finalize ();
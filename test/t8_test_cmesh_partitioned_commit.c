@@ -0,0 +1,190 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+
+/* In this test we build partitioned cmeshes from local stash data only and
+ * compare them with replicated versions of the same meshes.
+ * Each local tree must have the same class and face neighbors as the tree
+ * with the same global id in the replicated cmesh. Each non-local face
+ * neighbor of a local tree must be a ghost and the ghosts must agree with
+ * the replicated cmesh. */
+
+/* Translate a local face neighbor of a partitioned cmesh to a global id */
+static              t8_gloidx_t
+t8_test_partitioned_global_neighbor (t8_cmesh_t cmesh, t8_locidx_t neigh)
+{
+  SC_CHECK_ABORTF (0 <= neigh && neigh < t8_cmesh_get_num_local_trees (cmesh)
+                   + t8_cmesh_get_num_ghosts (cmesh),
+                   "Face neighbor %li out of range.", (long) neigh);
+  return t8_cmesh_get_global_id (cmesh, neigh);
+}
+
+/* Compare a partitioned cmesh with its replicated version.
+ * If the stash of the partitioned cmesh contained all face joins, then
+ * all_ghost_faces is true and every face of a ghost must match. Otherwise
+ * only the faces of ghosts that connect to a local tree are checked. */
+static void
+t8_test_partitioned_compare (t8_cmesh_t cmesh, t8_cmesh_t cmesh_ref,
+                             int all_ghost_faces)
+{
+  t8_locidx_t         num_trees, num_ghosts, itree, ighost, lneigh;
+  t8_locidx_t        *face_neigh, *face_neigh_ref;
+  t8_gloidx_t         first_tree, gtree, gneigh, *gface_neigh;
+  t8_ctree_t          tree, tree_ref;
+  t8_cghost_t         ghost;
+  int8_t             *ttf, *ttf_ref;
+  int                 iface;
+  int                *is_neighbor;
+
+  SC_CHECK_ABORT (t8_cmesh_is_committed (cmesh), "Cmesh commit failed.");
+  SC_CHECK_ABORT (t8_cmesh_is_partitioned (cmesh),
+                  "The cmesh is not partitioned.");
+  SC_CHECK_ABORT (t8_cmesh_get_num_trees (cmesh) ==
+                  t8_cmesh_get_num_trees (cmesh_ref),
+                  "Wrong number of trees.");
+  num_trees = t8_cmesh_get_num_local_trees (cmesh);
+  num_ghosts = t8_cmesh_get_num_ghosts (cmesh);
+  first_tree = t8_cmesh_get_first_treeid (cmesh);
+  /* Count for each ghost whether it is a face neighbor of a local tree */
+  is_neighbor = T8_ALLOC_ZERO (int, num_ghosts);
+  for (itree = 0; itree < num_trees; itree++) {
+    gtree = first_tree + itree;
+    tree = t8_cmesh_trees_get_tree_ext (cmesh->trees, itree, &face_neigh,
+                                        &ttf);
+    tree_ref = t8_cmesh_trees_get_tree_ext (cmesh_ref->trees,
+                                            (t8_locidx_t) gtree,
+                                            &face_neigh_ref, &ttf_ref);
+    SC_CHECK_ABORTF (tree->eclass == tree_ref->eclass,
+                     "Wrong class of tree %li.", (long) gtree);
+    for (iface = 0; iface < t8_eclass_num_faces[tree->eclass]; iface++) {
+      gneigh = t8_test_partitioned_global_neighbor (cmesh, face_neigh[iface]);
+      SC_CHECK_ABORTF (gneigh == face_neigh_ref[iface]
+                       && ttf[iface] == ttf_ref[iface],
+                       "Wrong neighbor at face %i of tree %li.", iface,
+                       (long) gtree);
+      /* A non-local neighbor must be a ghost */
+      lneigh = t8_cmesh_get_local_id (cmesh, face_neigh_ref[iface]);
+      SC_CHECK_ABORTF (lneigh >= 0, "Neighbor %li of tree %li is missing.",
+                       (long) face_neigh_ref[iface], (long) gtree);
+      if (lneigh >= num_trees) {
+        is_neighbor[lneigh - num_trees] = 1;
+      }
+    }
+  }
+  for (ighost = 0; ighost < num_ghosts; ighost++) {
+    ghost = t8_cmesh_trees_get_ghost_ext (cmesh->trees, ighost,
+                                          &gface_neigh, &ttf);
+    SC_CHECK_ABORTF (is_neighbor[ighost],
+                     "Ghost %li is no face neighbor of a local tree.",
+                     (long) ghost->treeid);
+    tree_ref = t8_cmesh_trees_get_tree_ext (cmesh_ref->trees,
+                                            (t8_locidx_t) ghost->treeid,
+                                            &face_neigh_ref, &ttf_ref);
+    SC_CHECK_ABORTF (ghost->eclass == tree_ref->eclass,
+                     "Wrong class of ghost %li.", (long) ghost->treeid);
+    for (iface = 0; iface < t8_eclass_num_faces[ghost->eclass]; iface++) {
+      if (all_ghost_faces || (first_tree <= face_neigh_ref[iface]
+                              && face_neigh_ref[iface] <
+                              first_tree + num_trees)) {
+        SC_CHECK_ABORTF (gface_neigh[iface] == face_neigh_ref[iface]
+                         && ttf[iface] == ttf_ref[iface],
+                         "Wrong neighbor at face %i of ghost %li.", iface,
+                         (long) ghost->treeid);
+      }
+    }
+  }
+  T8_FREE (is_neighbor);
+}
+
+/* Compare the partitioned hypercube with the replicated one */
+static void
+t8_test_partitioned_hypercube (t8_eclass_t eclass, int periodic,
+                               sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh, cmesh_ref;
+
+  t8_global_productionf ("Testing partitioned %s hypercube%s.\n",
+                         t8_eclass_to_string[eclass],
+                         periodic ? " with periodic boundaries" : "");
+  cmesh = t8_cmesh_new_hypercube (eclass, comm, 0, 1, periodic);
+  cmesh_ref = t8_cmesh_new_hypercube (eclass, comm, 0, 0, periodic);
+  t8_test_partitioned_compare (cmesh, cmesh_ref, 1);
+  t8_cmesh_destroy (&cmesh);
+  t8_cmesh_destroy (&cmesh_ref);
+}
+
+/* Compare the partitioned bigmesh with the replicated one. Only the face
+ * joins of the local trees are added to the stash, hence the faces of
+ * ghosts that do not connect to a local tree are unknown. */
+static void
+t8_test_partitioned_bigmesh (t8_eclass_t eclass, int num_trees,
+                             sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh, cmesh_ref;
+
+  t8_global_productionf ("Testing partitioned %s bigmesh with %i trees.\n",
+                         t8_eclass_to_string[eclass], num_trees);
+  cmesh = t8_cmesh_new_bigmesh_partitioned (eclass, num_trees, comm);
+  cmesh_ref = t8_cmesh_new_bigmesh (eclass, num_trees, comm);
+  t8_test_partitioned_compare (cmesh, cmesh_ref, 0);
+  t8_cmesh_destroy (&cmesh);
+  t8_cmesh_destroy (&cmesh_ref);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, mpisize, eclass;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpic, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_COUNT; eclass++) {
+    t8_test_partitioned_hypercube ((t8_eclass_t) eclass, 0, mpic);
+    if (eclass != T8_ECLASS_PYRAMID) {
+      t8_test_partitioned_hypercube ((t8_eclass_t) eclass, 1, mpic);
+    }
+  }
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_COUNT; eclass++) {
+    t8_test_partitioned_bigmesh ((t8_eclass_t) eclass, 1, mpic);
+    t8_test_partitioned_bigmesh ((t8_eclass_t) eclass, 3 * mpisize + 2,
+                                 mpic);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,503 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_cmesh_readmshfile.h>
+#include <t8_cmesh_triangle.h>
+#include <t8_cmesh_tetgen.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+
+/* In this test we read mesh files with the parallel readers and compare
+ * the partitioned cmeshes with the replicated cmeshes of the serial
+ * readers. Each local tree and each ghost must have the vertices, the face
+ * neighbors and the tree to face values of its tree in the replicated
+ * cmesh. In particular the ghosts must know their connections to other
+ * ghosts and to trees that are neither local trees nor ghosts.
+ * The .msh files are written as ASCII files of version 2 and as binary
+ * files of version 4.1, which must give the same cmesh. Binary files of
+ * version 4.0 must be rejected.
+ * The TRIANGLE and TETGEN files have no .neigh file, such that both the
+ * serial and the parallel reader compute the neighbors from the vertices.
+ * If the serial reader reorders the trees with METIS, the tree ids differ
+ * and we skip these files. */
+
+/* The formats of the .msh files that we write */
+typedef enum
+{
+  T8_TEST_MSH_ASCII_V2,         /* ASCII of version 2.2 */
+  T8_TEST_MSH_BINARY_V41,       /* binary of version 4.1 */
+  T8_TEST_MSH_BINARY_V40        /* binary of version 4.0, which we
+                                   do not read */
+} t8_test_msh_format_t;
+
+/* Write a size_t to a binary .msh file */
+static void
+t8_test_reader_write_size (FILE * fp, size_t value)
+{
+  fwrite (&value, sizeof (size_t), 1, fp);
+}
+
+/* Write an int to a binary .msh file */
+static void
+t8_test_reader_write_int (FILE * fp, int value)
+{
+  fwrite (&value, sizeof (int), 1, fp);
+}
+
+/* Write a .msh file with a grid of num_per_dim^dim quads or hexes on the
+ * first process. The node indices are not in the order of the
+ * coordinates, so that the face orientations are not all zero.
+ * A binary file has one block of nodes and one block of elements. */
+static void
+t8_test_reader_write_msh (const char *fileprefix, int dim, int num_per_dim,
+                          t8_test_msh_format_t format, sc_MPI_Comm comm)
+{
+  const int           num_nodes_per_dim = num_per_dim + 1;
+  const int           num_nodes = dim == 2 ? num_nodes_per_dim
+    * num_nodes_per_dim : num_nodes_per_dim * num_nodes_per_dim
+    * num_nodes_per_dim;
+  const int           num_trees = dim == 2 ? num_per_dim * num_per_dim
+    : num_per_dim * num_per_dim * num_per_dim;
+  const int           num_vertices = dim == 2 ? 4 : 8;
+  /* quads have gmsh type 3 and hexes have type 5 */
+  const int           element_type = dim == 2 ? 3 : 5;
+  const int           binary = format != T8_TEST_MSH_ASCII_V2;
+  /* The offsets of the gmsh vertices of a quad or hex in the grid */
+  const int           corners[8][3] = { {0, 0, 0}, {1, 0, 0}, {1, 1, 0},
+  {0, 1, 0}, {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}
+  };
+  char                filename[BUFSIZ];
+  FILE               *fp;
+  double              coords[3];
+  int                 mpirank, mpiret, inode, itree, ivertex, i;
+  int                 x, y, z;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    snprintf (filename, BUFSIZ, "%s.msh", fileprefix);
+    fp = fopen (filename, binary ? "wb" : "w");
+    SC_CHECK_ABORTF (fp != NULL, "Could not open file %s.\n", filename);
+    fprintf (fp, "$MeshFormat\n");
+    if (binary) {
+      fprintf (fp, "%s 1 %i\n", format == T8_TEST_MSH_BINARY_V41 ? "4.1" :
+               "4.0", (int) sizeof (size_t));
+      /* The one that tells the endianness */
+      t8_test_reader_write_int (fp, 1);
+      fprintf (fp, "\n$EndMeshFormat\n$Nodes\n");
+      /* One block with all nodes */
+      t8_test_reader_write_size (fp, 1);
+      t8_test_reader_write_size (fp, num_nodes);
+      t8_test_reader_write_size (fp, 1);
+      t8_test_reader_write_size (fp, num_nodes);
+      t8_test_reader_write_int (fp, dim);
+      t8_test_reader_write_int (fp, 1);
+      t8_test_reader_write_int (fp, 0);
+      t8_test_reader_write_size (fp, num_nodes);
+      for (inode = 0; inode < num_nodes; inode++) {
+        t8_test_reader_write_size (fp, num_nodes - inode);
+      }
+    }
+    else {
+      fprintf (fp, "2.2 0 8\n$EndMeshFormat\n$Nodes\n%i\n", num_nodes);
+    }
+    for (inode = 0; inode < num_nodes; inode++) {
+      coords[0] = inode % num_nodes_per_dim;
+      coords[1] = inode / num_nodes_per_dim % num_nodes_per_dim;
+      coords[2] = inode / (num_nodes_per_dim * num_nodes_per_dim);
+      if (binary) {
+        fwrite (coords, sizeof (double), 3, fp);
+      }
+      else {
+        /* The nodes are numbered backwards */
+        fprintf (fp, "%i %g %g %g\n", num_nodes - inode, coords[0],
+                 coords[1], coords[2]);
+      }
+    }
+    if (binary) {
+      fprintf (fp, "\n$EndNodes\n$Elements\n");
+      /* One block with all elements */
+      t8_test_reader_write_size (fp, 1);
+      t8_test_reader_write_size (fp, num_trees);
+      t8_test_reader_write_size (fp, 1);
+      t8_test_reader_write_size (fp, num_trees);
+      t8_test_reader_write_int (fp, dim);
+      t8_test_reader_write_int (fp, 1);
+      t8_test_reader_write_int (fp, element_type);
+      t8_test_reader_write_size (fp, num_trees);
+    }
+    else {
+      fprintf (fp, "$EndNodes\n$Elements\n%i\n", num_trees);
+    }
+    for (itree = 0; itree < num_trees; itree++) {
+      x = itree % num_per_dim;
+      y = itree / num_per_dim % num_per_dim;
+      z = itree / (num_per_dim * num_per_dim);
+      if (binary) {
+        t8_test_reader_write_size (fp, itree + 1);
+      }
+      else {
+        fprintf (fp, "%i %i 2 0 0", itree + 1, element_type);
+      }
+      for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+        i = x + corners[ivertex][0] + num_nodes_per_dim
+          * (y + corners[ivertex][1] + num_nodes_per_dim
+             * (z + corners[ivertex][2]));
+        if (binary) {
+          t8_test_reader_write_size (fp, num_nodes - i);
+        }
+        else {
+          fprintf (fp, " %i", num_nodes - i);
+        }
+      }
+      if (!binary) {
+        fprintf (fp, "\n");
+      }
+    }
+    fprintf (fp, "%s$EndElements\n", binary ? "\n" : "");
+    fclose (fp);
+  }
+  mpiret = sc_MPI_Barrier (comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+/* Check that a tree with given face neighbors has the vertices and face
+ * neighbors of the tree gtree_id of the replicated cmesh. */
+static void
+t8_test_reader_compare_tree (t8_cmesh_t cmesh_ref, t8_gloidx_t gtree_id,
+                             t8_eclass_t eclass, const t8_gloidx_t * neigh,
+                             const int8_t * ttf, const double *vertices)
+{
+  t8_ctree_t          tree_ref;
+  t8_locidx_t        *neigh_ref;
+  int8_t             *ttf_ref;
+  double             *vertices_ref;
+  int                 iface, i;
+
+  SC_CHECK_ABORT (0 <= gtree_id
+                  && gtree_id < t8_cmesh_get_num_trees (cmesh_ref),
+                  "Tree id out of range.");
+  tree_ref = t8_cmesh_trees_get_tree_ext (cmesh_ref->trees,
+                                          (t8_locidx_t) gtree_id,
+                                          &neigh_ref, &ttf_ref);
+  SC_CHECK_ABORTF (tree_ref->eclass == eclass, "Wrong class of tree %li.",
+                   (long) gtree_id);
+  for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+    SC_CHECK_ABORTF (neigh[iface] == neigh_ref[iface]
+                     && ttf[iface] == ttf_ref[iface],
+                     "Wrong neighbor at face %i of tree %li.", iface,
+                     (long) gtree_id);
+  }
+  if (vertices != NULL) {
+    vertices_ref = t8_cmesh_get_tree_vertices (cmesh_ref,
+                                               (t8_locidx_t) gtree_id);
+    for (i = 0; i < 3 * t8_eclass_num_vertices[eclass]; i++) {
+      SC_CHECK_ABORTF (vertices[i] == vertices_ref[i],
+                       "Wrong vertices of tree %li.", (long) gtree_id);
+    }
+  }
+}
+
+/* Compare the local trees and ghosts of a partitioned cmesh with the trees
+ * of a replicated cmesh */
+static void
+t8_test_reader_compare (t8_cmesh_t cmesh, t8_cmesh_t cmesh_ref)
+{
+  t8_locidx_t         num_trees, itree, ighost, *face_neigh;
+  t8_gloidx_t         first_tree, neigh[T8_ECLASS_MAX_FACES];
+  t8_gloidx_t        *gface_neigh;
+  t8_ctree_t          tree;
+  t8_cghost_t         ghost;
+  int8_t             *ttf;
+  int                 iface;
+
+  SC_CHECK_ABORT (cmesh != NULL && t8_cmesh_is_committed (cmesh),
+                  "The parallel reader failed.");
+  SC_CHECK_ABORT (t8_cmesh_get_num_trees (cmesh) ==
+                  t8_cmesh_get_num_trees (cmesh_ref),
+                  "Wrong number of trees.");
+  num_trees = t8_cmesh_get_num_local_trees (cmesh);
+  first_tree = t8_cmesh_get_first_treeid (cmesh);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_cmesh_trees_get_tree_ext (cmesh->trees, itree, &face_neigh,
+                                        &ttf);
+    /* Translate the neighbors to global ids */
+    for (iface = 0; iface < t8_eclass_num_faces[tree->eclass]; iface++) {
+      neigh[iface] = face_neigh[iface] < num_trees ?
+        first_tree + face_neigh[iface] :
+        t8_cmesh_trees_get_ghost (cmesh->trees,
+                                  face_neigh[iface] - num_trees)->treeid;
+    }
+    t8_test_reader_compare_tree (cmesh_ref, first_tree + itree,
+                                 tree->eclass, neigh, ttf,
+                                 t8_cmesh_get_tree_vertices (cmesh, itree));
+  }
+  for (ighost = 0; ighost < t8_cmesh_get_num_ghosts (cmesh); ighost++) {
+    ghost = t8_cmesh_trees_get_ghost_ext (cmesh->trees, ighost,
+                                          &gface_neigh, &ttf);
+    t8_test_reader_compare_tree (cmesh_ref, ghost->treeid, ghost->eclass,
+                                 gface_neigh, ttf, NULL);
+  }
+}
+
+static void
+t8_test_reader_msh (int dim, int num_per_dim, sc_MPI_Comm comm)
+{
+  const char         *fileprefix = "t8_test_cmesh_reader";
+  t8_cmesh_t          cmesh, cmesh_ref;
+
+  t8_global_productionf ("Testing the msh readers in dimension %i.\n", dim);
+  t8_test_reader_write_msh (fileprefix, dim, num_per_dim,
+                            T8_TEST_MSH_ASCII_V2, comm);
+  cmesh_ref = t8_cmesh_from_msh_file (fileprefix, 0, comm, dim, 0);
+  SC_CHECK_ABORT (cmesh_ref != NULL, "The serial reader failed.");
+  cmesh = t8_cmesh_from_msh_file_parallel (fileprefix, comm, dim);
+  t8_test_reader_compare (cmesh, cmesh_ref);
+  t8_cmesh_destroy (&cmesh);
+
+  /* The same mesh in a binary file of version 4.1 */
+  t8_test_reader_write_msh (fileprefix, dim, num_per_dim,
+                            T8_TEST_MSH_BINARY_V41, comm);
+  cmesh = t8_cmesh_from_msh_file (fileprefix, 0, comm, dim, 0);
+  t8_test_reader_compare (cmesh, cmesh_ref);
+  t8_cmesh_destroy (&cmesh);
+  cmesh = t8_cmesh_from_msh_file_parallel (fileprefix, comm, dim);
+  t8_test_reader_compare (cmesh, cmesh_ref);
+  t8_cmesh_destroy (&cmesh);
+
+  /* Binary files of version 4.0 are rejected */
+  t8_test_reader_write_msh (fileprefix, dim, num_per_dim,
+                            T8_TEST_MSH_BINARY_V40, comm);
+  cmesh = t8_cmesh_from_msh_file (fileprefix, 0, comm, dim, 0);
+  SC_CHECK_ABORT (cmesh == NULL, "The serial reader read version 4.0.");
+  cmesh = t8_cmesh_from_msh_file_parallel (fileprefix, comm, dim);
+  SC_CHECK_ABORT (cmesh == NULL, "The parallel reader read version 4.0.");
+  t8_cmesh_destroy (&cmesh_ref);
+}
+
+/* Write a .node and a .ele file of TRIANGLE or TETGEN with a grid of
+ * num_per_dim^dim squares or cubes on the first process. Each square is
+ * split into two triangles and each cube into the six tetrahedra around
+ * its diagonal. The nodes and trees are numbered starting with one. */
+static void
+t8_test_reader_write_tetgen (const char *fileprefix, int dim,
+                             int num_per_dim, sc_MPI_Comm comm)
+{
+  const int           num_nodes_per_dim = num_per_dim + 1;
+  const int           num_nodes = dim == 2 ? num_nodes_per_dim
+    * num_nodes_per_dim : num_nodes_per_dim * num_nodes_per_dim
+    * num_nodes_per_dim;
+  const int           num_cubes = dim == 2 ? num_per_dim * num_per_dim
+    : num_per_dim * num_per_dim * num_per_dim;
+  const int           num_simplices = dim == 2 ? 2 : 6;
+  /* The corners of the simplices of a square or cube, where bit i of a
+   * corner is its offset in direction i */
+  const int           simplices[6][4] = { {0, 1, 3, 7}, {0, 1, 5, 7},
+  {0, 2, 3, 7}, {0, 2, 6, 7}, {0, 4, 5, 7}, {0, 4, 6, 7}
+  };
+  const int           triangles[2][3] = { {0, 1, 3}, {0, 2, 3} };
+  char                filename[BUFSIZ];
+  FILE               *fp;
+  int                 mpirank, mpiret, inode, icube, isimplex, icorner;
+  int                 corner, x, y, z;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    snprintf (filename, BUFSIZ, "%s.node", fileprefix);
+    fp = fopen (filename, "w");
+    SC_CHECK_ABORTF (fp != NULL, "Could not open file %s.\n", filename);
+    fprintf (fp, "# The nodes of a grid\n%i %i 0 0\n", num_nodes, dim);
+    for (inode = 0; inode < num_nodes; inode++) {
+      fprintf (fp, "%i %i %i", inode + 1, inode % num_nodes_per_dim,
+               inode / num_nodes_per_dim % num_nodes_per_dim);
+      if (dim == 3) {
+        fprintf (fp, " %i", inode / (num_nodes_per_dim * num_nodes_per_dim));
+      }
+      fprintf (fp, "\n");
+    }
+    fclose (fp);
+    snprintf (filename, BUFSIZ, "%s.ele", fileprefix);
+    fp = fopen (filename, "w");
+    SC_CHECK_ABORTF (fp != NULL, "Could not open file %s.\n", filename);
+    fprintf (fp, "%i %i 0\n", num_cubes * num_simplices, dim + 1);
+    for (icube = 0; icube < num_cubes; icube++) {
+      x = icube % num_per_dim;
+      y = icube / num_per_dim % num_per_dim;
+      z = icube / (num_per_dim * num_per_dim);
+      for (isimplex = 0; isimplex < num_simplices; isimplex++) {
+        fprintf (fp, "%i", icube * num_simplices + isimplex + 1);
+        for (icorner = 0; icorner <= dim; icorner++) {
+          corner = dim == 2 ? triangles[isimplex][icorner] :
+            simplices[isimplex][icorner];
+          inode = x + (corner & 1) + num_nodes_per_dim
+            * (y + ((corner >> 1) & 1) + num_nodes_per_dim
+               * (z + ((corner >> 2) & 1)));
+          fprintf (fp, " %i", inode + 1);
+        }
+        fprintf (fp, "\n");
+      }
+    }
+    fclose (fp);
+  }
+  mpiret = sc_MPI_Barrier (comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+static void
+t8_test_reader_tetgen (int dim, int num_per_dim, sc_MPI_Comm comm)
+{
+  const char         *fileprefix = "t8_test_cmesh_reader_tetgen";
+  t8_cmesh_t          cmesh, cmesh_ref;
+  int                 do_dup;
+
+  t8_global_productionf ("Testing the %s readers.\n",
+                         dim == 2 ? "TRIANGLE" : "TETGEN");
+  t8_test_reader_write_tetgen (fileprefix, dim, num_per_dim, comm);
+  cmesh_ref = dim == 2 ?
+    t8_cmesh_from_triangle_file ((char *) fileprefix, 0, comm, 0) :
+    t8_cmesh_from_tetgen_file ((char *) fileprefix, 0, comm, 0);
+  SC_CHECK_ABORT (cmesh_ref != NULL, "The serial reader failed.");
+  for (do_dup = 0; do_dup <= 1; do_dup++) {
+    cmesh = dim == 2 ?
+      t8_cmesh_from_triangle_file ((char *) fileprefix, 1, comm, do_dup) :
+      t8_cmesh_from_tetgen_file ((char *) fileprefix, 1, comm, do_dup);
+    t8_test_reader_compare (cmesh, cmesh_ref);
+    t8_cmesh_destroy (&cmesh);
+  }
+  t8_cmesh_destroy (&cmesh_ref);
+}
+
+/* Write two triangles to a TRIANGLE file, whose node coordinates have the
+ * given strings. If index is not NULL it is the index of the first node. */
+static void
+t8_test_reader_write_triangles (const char *fileprefix,
+                                const char *coords[4][2], const char *index,
+                                sc_MPI_Comm comm)
+{
+  char                filename[BUFSIZ];
+  FILE               *fp;
+  int                 mpirank, mpiret, inode;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    snprintf (filename, BUFSIZ, "%s.node", fileprefix);
+    fp = fopen (filename, "w");
+    SC_CHECK_ABORTF (fp != NULL, "Could not open file %s.\n", filename);
+    fprintf (fp, "4 2 0 0\n");
+    for (inode = 0; inode < 4; inode++) {
+      if (inode == 0 && index != NULL) {
+        fprintf (fp, "%s", index);
+      }
+      else {
+        fprintf (fp, "%i", inode + 1);
+      }
+      fprintf (fp, " %s %s\n", coords[inode][0], coords[inode][1]);
+    }
+    fclose (fp);
+    snprintf (filename, BUFSIZ, "%s.ele", fileprefix);
+    fp = fopen (filename, "w");
+    SC_CHECK_ABORTF (fp != NULL, "Could not open file %s.\n", filename);
+    fprintf (fp, "2 3 0\n1 1 2 4\n2 1 3 4\n");
+    fclose (fp);
+  }
+  mpiret = sc_MPI_Barrier (comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+/* Check that the readers convert the coordinates exactly as strtod and
+ * that the parallel reader rejects an index that does not fit into a
+ * long. */
+static void
+t8_test_reader_numbers (sc_MPI_Comm comm)
+{
+  const char         *fileprefix = "t8_test_cmesh_reader_numbers";
+  const char         *coords[4][2] = { {"0.1", "0.33333333333333331"},
+  {"1e-300", "-2.5E10"}, {"+7.00000000000000001", "123456789.123456789"},
+  {"4.9406564584124654e-324", "1.7976931348623157e308"}
+  };
+  const int           tree_nodes[2][3] = { {0, 1, 3}, {0, 2, 3} };
+  t8_cmesh_t          cmesh;
+  t8_locidx_t         itree;
+  double             *vertices;
+  int                 partition, iv, icoord;
+
+  t8_global_productionf ("Testing the number parsing of the TRIANGLE "
+                         "readers.\n");
+  t8_test_reader_write_triangles (fileprefix, coords, NULL, comm);
+  for (partition = 0; partition <= 1; partition++) {
+    cmesh = t8_cmesh_from_triangle_file ((char *) fileprefix, partition,
+                                         comm, 0);
+    SC_CHECK_ABORT (cmesh != NULL, "Reading the triangles failed.");
+    for (itree = 0; itree < t8_cmesh_get_num_local_trees (cmesh); itree++) {
+      vertices = t8_cmesh_get_tree_vertices (cmesh, itree);
+      for (iv = 0; iv < 3; iv++) {
+        for (icoord = 0; icoord < 2; icoord++) {
+          SC_CHECK_ABORT (vertices[3 * iv + icoord] ==
+                          strtod (coords[tree_nodes[t8_cmesh_get_first_treeid
+                                                    (cmesh) + itree][iv]]
+                                  [icoord], NULL),
+                          "A coordinate was not read exactly.");
+        }
+      }
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+
+  /* The first index does not fit into a long */
+  t8_test_reader_write_triangles (fileprefix, coords,
+                                  "100000000000000000000000000000", comm);
+  cmesh = t8_cmesh_from_triangle_file ((char *) fileprefix, 1, comm, 0);
+  SC_CHECK_ABORT (cmesh == NULL, "An overflowing index was read.");
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_reader_msh (2, 6, mpic);
+  t8_test_reader_msh (3, 4, mpic);
+#ifndef T8_WITH_METIS
+  t8_test_reader_tetgen (2, 6, mpic);
+  t8_test_reader_tetgen (3, 3, mpic);
+  t8_test_reader_numbers (mpic);
+#endif
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,190 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_default_cxx.hxx>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+
+/* In this test we refine a partitioned cmesh and a replicated copy of it.
+ * The global ids of the children only depend on the global id of their
+ * parent, hence each local tree and ghost of the refined partitioned cmesh
+ * must have the same class, face neighbors and tree to face values as the
+ * tree with the same global id in the refined replicated cmesh. */
+
+/* Refine a cmesh once. The cmesh is taken over by the refined cmesh. */
+static t8_cmesh_t
+t8_test_refine_cmesh (t8_cmesh_t cmesh, int level, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh_refined;
+
+  t8_cmesh_init (&cmesh_refined);
+  t8_cmesh_set_derive (cmesh_refined, cmesh);
+  t8_cmesh_set_refine (cmesh_refined, level, t8_scheme_new_default_cxx ());
+  t8_cmesh_commit (cmesh_refined, comm);
+  SC_CHECK_ABORT (t8_cmesh_is_committed (cmesh_refined),
+                  "Cmesh commit failed.");
+  return cmesh_refined;
+}
+
+/* Compare the tree or ghost with global id gtree_id of a partitioned cmesh
+ * with the same tree of a replicated cmesh */
+static void
+t8_test_refine_compare_tree (t8_cmesh_t cmesh_ref, t8_gloidx_t gtree_id,
+                             t8_eclass_t eclass, const t8_gloidx_t * neigh,
+                             const int8_t * ttf)
+{
+  t8_ctree_t          tree_ref;
+  t8_locidx_t        *neigh_ref;
+  int8_t             *ttf_ref;
+  int                 iface;
+
+  SC_CHECK_ABORTF (0 <= gtree_id
+                   && gtree_id < t8_cmesh_get_num_trees (cmesh_ref),
+                   "Tree id %li out of range.", (long) gtree_id);
+  tree_ref = t8_cmesh_trees_get_tree_ext (cmesh_ref->trees,
+                                          (t8_locidx_t) gtree_id,
+                                          &neigh_ref, &ttf_ref);
+  SC_CHECK_ABORTF (tree_ref->eclass == eclass, "Wrong class of tree %li.",
+                   (long) gtree_id);
+  for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+    SC_CHECK_ABORTF (neigh[iface] == neigh_ref[iface]
+                     && ttf[iface] == ttf_ref[iface],
+                     "Wrong neighbor at face %i of tree %li.", iface,
+                     (long) gtree_id);
+  }
+}
+
+/* Compare the local trees and ghosts of a refined partitioned cmesh with
+ * the trees of a refined replicated cmesh */
+static void
+t8_test_refine_compare (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
+                        t8_cmesh_t cmesh_ref, int factor)
+{
+  t8_locidx_t         num_trees, itree, ighost, *face_neigh;
+  t8_gloidx_t         first_tree, neigh[T8_ECLASS_MAX_FACES];
+  t8_gloidx_t        *gface_neigh;
+  t8_ctree_t          tree;
+  t8_cghost_t         ghost;
+  int8_t             *ttf;
+  int                 iface;
+
+  SC_CHECK_ABORT (cmesh->set_partition && !cmesh->first_tree_shared,
+                  "The refined cmesh is not partitioned.");
+  SC_CHECK_ABORT (t8_cmesh_get_num_trees (cmesh) ==
+                  t8_cmesh_get_num_trees (cmesh_ref),
+                  "Wrong number of trees.");
+  num_trees = t8_cmesh_get_num_local_trees (cmesh);
+  first_tree = t8_cmesh_get_first_treeid (cmesh);
+  /* The partition table is the old one times the refinement factor */
+  SC_CHECK_ABORT (first_tree == t8_cmesh_get_first_treeid (cmesh_from)
+                  * factor
+                  && num_trees ==
+                  t8_cmesh_get_num_local_trees (cmesh_from) * factor,
+                  "Wrong partition of the refined cmesh.");
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_cmesh_trees_get_tree_ext (cmesh->trees, itree, &face_neigh,
+                                        &ttf);
+    /* Translate the neighbors to global ids */
+    for (iface = 0; iface < t8_eclass_num_faces[tree->eclass]; iface++) {
+      neigh[iface] = face_neigh[iface] < num_trees ?
+        first_tree + face_neigh[iface] :
+        t8_cmesh_trees_get_ghost (cmesh->trees,
+                                  face_neigh[iface] - num_trees)->treeid;
+    }
+    t8_test_refine_compare_tree (cmesh_ref, first_tree + itree,
+                                 tree->eclass, neigh, ttf);
+  }
+  for (ighost = 0; ighost < t8_cmesh_get_num_ghosts (cmesh); ighost++) {
+    ghost = t8_cmesh_trees_get_ghost_ext (cmesh->trees, ighost,
+                                          &gface_neigh, &ttf);
+    SC_CHECK_ABORTF (ghost->treeid < first_tree
+                     || ghost->treeid >= first_tree + num_trees,
+                     "Ghost %li is a local tree.", (long) ghost->treeid);
+    t8_test_refine_compare_tree (cmesh_ref, ghost->treeid, ghost->eclass,
+                                 gface_neigh, ttf);
+  }
+}
+
+/* Refine a replicated hypercube to get enough trees for all processes,
+ * partition it and refine the partitioned and the replicated cmesh. */
+static void
+t8_test_refine_partitioned (t8_eclass_t eclass, int periodic,
+                            sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh_ref, cmesh_part, cmesh;
+  const int           factor = 1 << t8_eclass_to_dimension[eclass];
+
+  t8_global_productionf ("Testing the refinement of a partitioned %s cmesh"
+                         "%s.\n", t8_eclass_to_string[eclass],
+                         periodic ? " with periodic boundaries" : "");
+  cmesh_ref = t8_cmesh_new_hypercube (eclass, comm, 0, 0, periodic);
+  cmesh_ref = t8_test_refine_cmesh (cmesh_ref, 2, comm);
+
+  /* Partition the replicated cmesh as a level 0 forest, such that no
+   * process has a shared first tree */
+  t8_cmesh_ref (cmesh_ref);
+  t8_cmesh_init (&cmesh_part);
+  t8_cmesh_set_derive (cmesh_part, cmesh_ref);
+  t8_cmesh_set_partition_uniform (cmesh_part, 0);
+  t8_cmesh_commit (cmesh_part, comm);
+  SC_CHECK_ABORT (!cmesh_part->first_tree_shared,
+                  "The partitioned cmesh has a shared first tree.");
+
+  t8_cmesh_ref (cmesh_part);
+  cmesh = t8_test_refine_cmesh (cmesh_part, 1, comm);
+  cmesh_ref = t8_test_refine_cmesh (cmesh_ref, 1, comm);
+  t8_test_refine_compare (cmesh, cmesh_part, cmesh_ref, factor);
+  t8_cmesh_destroy (&cmesh);
+  t8_cmesh_destroy (&cmesh_part);
+  t8_cmesh_destroy (&cmesh_ref);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 periodic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  /* The face neighbors of refined cmeshes are only implemented for quads
+   * and triangles */
+  for (periodic = 0; periodic <= 1; periodic++) {
+    t8_test_refine_partitioned (T8_ECLASS_QUAD, periodic, mpic);
+  }
+  t8_test_refine_partitioned (T8_ECLASS_TRIANGLE, 0, mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
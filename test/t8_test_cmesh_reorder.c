@@ -0,0 +1,273 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#include <t8_cmesh.h>
+#include "t8_cmesh/t8_cmesh_trees.h"
+#include "t8_cmesh/t8_cmesh_types.h"
+
+/* Compute the sum of all vertex coordinates of all trees */
+static double
+test_cmesh_vertex_sum (t8_cmesh_t cmesh, sc_MPI_Comm comm)
+{
+  t8_locidx_t         itree;
+  double             *vertices, sum = 0, global_sum;
+  int                 ivertex, num_vertices, mpiret;
+
+  /* A shared first tree is counted on the previous process */
+  for (itree = cmesh->first_tree_shared; itree < cmesh->num_local_trees;
+       itree++) {
+    vertices = t8_cmesh_get_tree_vertices (cmesh, itree);
+    SC_CHECK_ABORT (vertices != NULL, "Tree without vertices.");
+    num_vertices =
+      t8_eclass_num_vertices[t8_cmesh_get_tree_class (cmesh, itree)];
+    for (ivertex = 0; ivertex < 3 * num_vertices; ivertex++) {
+      sum += vertices[ivertex];
+    }
+  }
+  mpiret = sc_MPI_Allreduce (&sum, &global_sum, 1, sc_MPI_DOUBLE,
+                             sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  return global_sum;
+}
+
+/* Reorder partitioned hypercubes along the Morton curve and check that the
+ * result is a valid cmesh with the same trees. */
+static void
+test_cmesh_reorder_sfc (sc_MPI_Comm comm)
+{
+  int                 eci, periodic, retval;
+  t8_cmesh_t          cmesh;
+  t8_gloidx_t         num_trees;
+  double              vertex_sum;
+
+  for (eci = T8_ECLASS_LINE; eci < T8_ECLASS_COUNT; ++eci) {
+    for (periodic = 0; periodic < 2; periodic++) {
+      if (periodic && eci == T8_ECLASS_PYRAMID) {
+        /* The pyramid cube mesh cannot be periodic */
+        continue;
+      }
+      t8_global_productionf ("Testing eclass %s%s.\n",
+                             t8_eclass_to_string[eci],
+                             periodic ? " periodic" : "");
+      cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eci, comm, 0, 1,
+                                      periodic);
+      num_trees = t8_cmesh_get_num_trees (cmesh);
+      vertex_sum = test_cmesh_vertex_sum (cmesh, comm);
+
+      cmesh = t8_cmesh_reorder_sfc (cmesh, comm);
+      retval = t8_cmesh_is_committed (cmesh);
+      SC_CHECK_ABORT (retval == 1, "Cmesh commit failed.");
+      SC_CHECK_ABORT (t8_cmesh_is_partitioned (cmesh),
+                      "Reordered cmesh is not partitioned.");
+      retval = t8_cmesh_trees_is_face_consistend (cmesh, cmesh->trees);
+      SC_CHECK_ABORT (retval == 1, "Cmesh face consistency failed.");
+      SC_CHECK_ABORT (t8_cmesh_get_num_trees (cmesh) == num_trees,
+                      "Wrong number of trees after reordering.");
+      SC_CHECK_ABORT (fabs (test_cmesh_vertex_sum (cmesh, comm) - vertex_sum)
+                      < 1e-10, "Wrong vertices after reordering.");
+      t8_cmesh_destroy (&cmesh);
+    }
+  }
+}
+
+/* The key of the attribute that stores the original id of a tree */
+#define T8_TEST_REORDER_ID_KEY 1
+
+/* Create a replicated grid of nx times nx quads. Each tree stores its id
+ * as an attribute. */
+static              t8_cmesh_t
+test_cmesh_reorder_grid (int nx, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_gloidx_t         gtree;
+  double              vertices[12];
+  int                 i, j, ivertex;
+
+  t8_cmesh_init (&cmesh);
+  for (j = 0; j < nx; j++) {
+    for (i = 0; i < nx; i++) {
+      gtree = (t8_gloidx_t) j * nx + i;
+      t8_cmesh_set_tree_class (cmesh, gtree, T8_ECLASS_QUAD);
+      for (ivertex = 0; ivertex < 4; ivertex++) {
+        vertices[3 * ivertex] = i + (ivertex & 1);
+        vertices[3 * ivertex + 1] = j + (ivertex >> 1);
+        vertices[3 * ivertex + 2] = 0;
+      }
+      t8_cmesh_set_tree_vertices (cmesh, gtree, t8_get_package_id (), 0,
+                                  vertices, 4);
+      t8_cmesh_set_attribute (cmesh, gtree, t8_get_package_id (),
+                              T8_TEST_REORDER_ID_KEY, &gtree,
+                              sizeof (t8_gloidx_t), 0);
+      if (i + 1 < nx) {
+        t8_cmesh_set_join (cmesh, gtree, gtree + 1, 1, 0, 0);
+      }
+      if (j + 1 < nx) {
+        t8_cmesh_set_join (cmesh, gtree, gtree + nx, 3, 2, 0);
+      }
+    }
+  }
+  t8_cmesh_commit (cmesh, comm);
+  return cmesh;
+}
+
+/* Return the original id of a local tree or ghost */
+static              t8_gloidx_t
+test_cmesh_reorder_original_id (t8_cmesh_t cmesh, t8_locidx_t ltree)
+{
+  t8_gloidx_t        *id;
+
+  id = (t8_gloidx_t *) t8_cmesh_get_attribute (cmesh, t8_get_package_id (),
+                                               T8_TEST_REORDER_ID_KEY,
+                                               ltree);
+  SC_CHECK_ABORTF (id != NULL, "Tree %li has no original id.",
+                   (long) t8_cmesh_get_global_id (cmesh, ltree));
+  return *id;
+}
+
+/* Check one face connection of a local tree or ghost with the original id
+ * gtree against the replicated cmesh. neighbor is the new global id of the
+ * face neighbor. */
+static void
+test_cmesh_reorder_check_face (t8_cmesh_t cmesh, t8_cmesh_t cmesh_ref,
+                               t8_gloidx_t gtree, int iface,
+                               t8_gloidx_t neighbor, int8_t ttf,
+                               int is_boundary)
+{
+  t8_locidx_t        *faces_ref, lneighbor;
+  int8_t             *ttf_ref;
+
+  (void) t8_cmesh_trees_get_tree_ext (cmesh_ref->trees, (t8_locidx_t) gtree,
+                                      &faces_ref, &ttf_ref);
+  if (faces_ref[iface] == gtree && ttf_ref[iface] == iface) {
+    SC_CHECK_ABORTF (is_boundary, "Face %i of tree %li is not a boundary.",
+                     iface, (long) gtree);
+    return;
+  }
+  SC_CHECK_ABORTF (!is_boundary && ttf == ttf_ref[iface],
+                   "Wrong connection at face %i of tree %li.", iface,
+                   (long) gtree);
+  lneighbor = t8_cmesh_get_local_id (cmesh, neighbor);
+  if (lneighbor >= 0) {
+    /* We can only compare the neighbors that are local trees or ghosts */
+    SC_CHECK_ABORTF (test_cmesh_reorder_original_id (cmesh, lneighbor)
+                     == faces_ref[iface],
+                     "Wrong neighbor at face %i of tree %li.", iface,
+                     (long) gtree);
+  }
+}
+
+/* Compare the face connections of the local trees and ghosts of a
+ * reordered grid with the original grid. Each tree and each ghost must
+ * know its original id. */
+static void
+test_cmesh_reorder_check_ghosts (t8_cmesh_t cmesh, t8_cmesh_t cmesh_ref)
+{
+  const int           F = t8_eclass_max_num_faces[cmesh->dimension];
+  t8_locidx_t         num_trees, itree, ighost, *faces;
+  t8_gloidx_t         first_tree, *gfaces, gtree, neighbor;
+  t8_ctree_t          tree;
+  t8_cghost_t         ghost;
+  int8_t             *ttf;
+  int                 iface;
+
+  SC_CHECK_ABORT (t8_cmesh_is_committed (cmesh)
+                  && t8_cmesh_is_partitioned (cmesh),
+                  "Reordered cmesh is not partitioned.");
+  SC_CHECK_ABORT (t8_cmesh_trees_is_face_consistend (cmesh, cmesh->trees),
+                  "Cmesh face consistency failed.");
+  num_trees = t8_cmesh_get_num_local_trees (cmesh);
+  first_tree = t8_cmesh_get_first_treeid (cmesh);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_cmesh_trees_get_tree_ext (cmesh->trees, itree, &faces, &ttf);
+    gtree = test_cmesh_reorder_original_id (cmesh, itree);
+    for (iface = 0; iface < t8_eclass_num_faces[tree->eclass]; iface++) {
+      neighbor = t8_cmesh_get_global_id (cmesh, faces[iface]);
+      test_cmesh_reorder_check_face (cmesh, cmesh_ref, gtree, iface,
+                                     neighbor, ttf[iface],
+                                     faces[iface] == itree
+                                     && ttf[iface] % F == iface);
+    }
+  }
+  for (ighost = 0; ighost < t8_cmesh_get_num_ghosts (cmesh); ighost++) {
+    ghost = t8_cmesh_trees_get_ghost_ext (cmesh->trees, ighost, &gfaces,
+                                          &ttf);
+    SC_CHECK_ABORT (ghost->treeid < first_tree
+                    || ghost->treeid >= first_tree + num_trees,
+                    "A ghost is a local tree.");
+    gtree = test_cmesh_reorder_original_id (cmesh, num_trees + ighost);
+    for (iface = 0; iface < t8_eclass_num_faces[ghost->eclass]; iface++) {
+      test_cmesh_reorder_check_face (cmesh, cmesh_ref, gtree, iface,
+                                     gfaces[iface], ttf[iface],
+                                     gfaces[iface] == ghost->treeid
+                                     && ttf[iface] % F == iface);
+    }
+  }
+}
+
+/* Partition a grid, reorder it and check the ghosts of the result */
+static void
+test_cmesh_reorder_ghosts (sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh_ref, cmesh;
+
+  t8_global_productionf ("Testing the ghosts of reordered cmeshes.\n");
+  cmesh_ref = test_cmesh_reorder_grid (8, comm);
+  t8_cmesh_ref (cmesh_ref);
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_derive (cmesh, cmesh_ref);
+  t8_cmesh_set_partition_uniform (cmesh, 0);
+  t8_cmesh_commit (cmesh, comm);
+  cmesh = t8_cmesh_reorder_sfc (cmesh, comm);
+  test_cmesh_reorder_check_ghosts (cmesh, cmesh_ref);
+#if defined (T8_WITH_PARMETIS) && defined (SC_ENABLE_MPI)
+  cmesh = t8_cmesh_reorder_partitioned (cmesh, comm);
+  test_cmesh_reorder_check_ghosts (cmesh, cmesh_ref);
+#endif
+  t8_cmesh_destroy (&cmesh);
+  t8_cmesh_destroy (&cmesh_ref);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         comm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  comm = sc_MPI_COMM_WORLD;
+  sc_init (comm, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing cmesh reorder.\n");
+  test_cmesh_reorder_sfc (comm);
+  test_cmesh_reorder_ghosts (comm);
+  t8_global_productionf ("Done testing cmesh reorder.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,161 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_data/t8_shmem.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+
+/* In this test we store the trees of replicated cmeshes in shared memory
+ * with t8_cmesh_set_shared_trees. The shared cmeshes must be equal to the
+ * cmeshes they are copied from and the node communicators that the shared
+ * memory needs must be freed again when the cmeshes are destroyed. */
+
+/* Return true if comm has node communicators */
+static int
+t8_test_shared_has_node_comms (sc_MPI_Comm comm)
+{
+  sc_MPI_Comm         intranode = sc_MPI_COMM_NULL;
+  sc_MPI_Comm         internode = sc_MPI_COMM_NULL;
+
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  return intranode != sc_MPI_COMM_NULL;
+}
+
+/* Check that a cmesh has shared trees and is equal to cmesh_ref */
+static void
+t8_test_shared_check (t8_cmesh_t cmesh, t8_cmesh_t cmesh_ref)
+{
+  SC_CHECK_ABORT (t8_cmesh_is_committed (cmesh), "Cmesh commit failed.");
+  SC_CHECK_ABORT (t8_cmesh_trees_is_shared (cmesh->trees),
+                  "The trees are not shared.");
+  SC_CHECK_ABORT (t8_cmesh_is_equal (cmesh, cmesh_ref),
+                  "The shared cmesh is not equal to the original one.");
+  SC_CHECK_ABORT (t8_cmesh_trees_is_face_consistend (cmesh, cmesh->trees),
+                  "Cmesh face consistency failed.");
+}
+
+/* Copy a replicated cmesh to a cmesh with shared trees and derive another
+ * cmesh from the shared one, which uses the same trees. */
+static void
+t8_test_shared_derive (t8_cmesh_t cmesh_ref, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh_shared, cmesh_derived;
+
+  t8_cmesh_ref (cmesh_ref);
+  t8_cmesh_init (&cmesh_shared);
+  t8_cmesh_set_derive (cmesh_shared, cmesh_ref);
+  t8_cmesh_set_shared_trees (cmesh_shared, 1);
+  t8_cmesh_commit (cmesh_shared, comm);
+  t8_test_shared_check (cmesh_shared, cmesh_ref);
+  SC_CHECK_ABORT (!t8_cmesh_trees_is_shared (cmesh_ref->trees),
+                  "The trees of the original cmesh are shared.");
+
+  t8_cmesh_ref (cmesh_shared);
+  t8_cmesh_init (&cmesh_derived);
+  t8_cmesh_set_derive (cmesh_derived, cmesh_shared);
+  t8_cmesh_set_shared_trees (cmesh_derived, 1);
+  t8_cmesh_commit (cmesh_derived, comm);
+  SC_CHECK_ABORT (cmesh_derived->trees == cmesh_shared->trees,
+                  "The derived cmesh does not reuse the shared trees.");
+  /* The shared trees must outlive the cmesh they were created for */
+  t8_cmesh_destroy (&cmesh_shared);
+  t8_test_shared_check (cmesh_derived, cmesh_ref);
+  t8_cmesh_destroy (&cmesh_derived);
+  t8_cmesh_destroy (&cmesh_ref);
+}
+
+/* Build a cmesh of two triangles with shared trees from a stash */
+static void
+t8_test_shared_stash (sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_locidx_t        *face_neigh;
+  int8_t             *ttf;
+  double             *vertices;
+  double              tree_vertices[2][9] = {
+    {0, 0, 0, 1, 0, 0, 1, 1, 0},
+    {0, 0, 0, 1, 1, 0, 0, 1, 0}
+  };
+  int                 itree, i;
+
+  t8_cmesh_init (&cmesh);
+  for (itree = 0; itree < 2; itree++) {
+    t8_cmesh_set_tree_class (cmesh, itree, T8_ECLASS_TRIANGLE);
+    t8_cmesh_set_tree_vertices (cmesh, itree, t8_get_package_id (), 0,
+                                tree_vertices[itree], 3);
+  }
+  t8_cmesh_set_join (cmesh, 0, 1, 1, 2, 0);
+  t8_cmesh_set_shared_trees (cmesh, 1);
+  t8_cmesh_commit (cmesh, comm);
+  SC_CHECK_ABORT (t8_cmesh_is_committed (cmesh)
+                  && t8_cmesh_trees_is_shared (cmesh->trees),
+                  "The trees are not shared.");
+  for (itree = 0; itree < 2; itree++) {
+    vertices = t8_cmesh_get_tree_vertices (cmesh, itree);
+    for (i = 0; i < 9; i++) {
+      SC_CHECK_ABORT (vertices[i] == tree_vertices[itree][i],
+                      "Wrong vertices of a shared tree.");
+    }
+  }
+  (void) t8_cmesh_trees_get_tree_ext (cmesh->trees, 0, &face_neigh, &ttf);
+  SC_CHECK_ABORT (face_neigh[1] == 1 && ttf[1] == 2,
+                  "Wrong face neighbor of a shared tree.");
+  t8_cmesh_destroy (&cmesh);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, eclass, had_node_comms;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  had_node_comms = t8_test_shared_has_node_comms (mpic);
+  for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_COUNT; eclass++) {
+    t8_global_productionf ("Testing shared trees with eclass %s.\n",
+                           t8_eclass_to_string[eclass]);
+    t8_test_shared_derive (t8_cmesh_new_hypercube ((t8_eclass_t) eclass,
+                                                   mpic, 0, 0, 0), mpic);
+  }
+  t8_test_shared_derive (t8_cmesh_new_hypercube_hybrid (3, mpic, 0, 0),
+                         mpic);
+  t8_test_shared_stash (mpic);
+  /* All shared memory is freed, so are the node communicators that were
+   * created for it */
+  SC_CHECK_ABORT (t8_test_shared_has_node_comms (mpic) == had_node_comms,
+                  "The node communicators were not freed.");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,105 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+
+/* In this test we validate the geometry of a cmesh with a unit hexahedron
+ * and a tangled hexahedron, whose vertices 6 and 7 are swapped, and of a
+ * cmesh with a folded and a flat quadrilateral. The tangled hexahedron has
+ * positive volume at vertex 0, such that only the check of all corners
+ * finds it. */
+
+static void
+t8_test_cmesh_validate (sc_MPI_Comm comm)
+{
+  double              hex[24] = {
+    0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0,
+    0, 0, 1, 1, 0, 1, 0, 1, 1, 1, 1, 1
+  };
+  double              tangled[24] = {
+    2, 0, 0, 3, 0, 0, 2, 1, 0, 3, 1, 0,
+    2, 0, 1, 3, 0, 1, 3, 1, 1, 2, 1, 1
+  };
+  double              folded[12] = { 0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0 };
+  double              flat[12] = { 2, 0, 0, 3, 0, 0, 4, 0, 0, 5, 0, 0 };
+  t8_cmesh_t          cmesh;
+  t8_cmesh_geometry_report_t report;
+
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_tree_class (cmesh, 0, T8_ECLASS_HEX);
+  t8_cmesh_set_tree_class (cmesh, 1, T8_ECLASS_HEX);
+  t8_cmesh_set_tree_vertices (cmesh, 0, t8_get_package_id (), 0, hex, 8);
+  t8_cmesh_set_tree_vertices (cmesh, 1, t8_get_package_id (), 0, tangled,
+                              8);
+  t8_cmesh_set_validate_geometry (cmesh, 1);
+  t8_cmesh_commit (cmesh, comm);
+  t8_cmesh_validate_geometry (cmesh, T8_CMESH_VALIDATE_TOLERANCE, comm,
+                              &report);
+  SC_CHECK_ABORT (report.num_checked == 2, "Wrong number of checked trees");
+  SC_CHECK_ABORT (report.num_inverted == 1 && report.first_inverted == 1,
+                  "The tangled hexahedron was not found");
+  SC_CHECK_ABORT (report.num_degenerate == 0
+                  && report.first_degenerate == -1,
+                  "Found a wrong degenerate hexahedron");
+  SC_CHECK_ABORT (report.min_quality < 0, "Wrong minimal quality");
+  t8_cmesh_destroy (&cmesh);
+
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_tree_class (cmesh, 0, T8_ECLASS_QUAD);
+  t8_cmesh_set_tree_class (cmesh, 1, T8_ECLASS_QUAD);
+  t8_cmesh_set_tree_vertices (cmesh, 0, t8_get_package_id (), 0, folded, 4);
+  t8_cmesh_set_tree_vertices (cmesh, 1, t8_get_package_id (), 0, flat, 4);
+  t8_cmesh_commit (cmesh, comm);
+  t8_cmesh_validate_geometry (cmesh, T8_CMESH_VALIDATE_TOLERANCE, comm,
+                              &report);
+  SC_CHECK_ABORT (report.num_checked == 2, "Wrong number of checked trees");
+  SC_CHECK_ABORT (report.num_inverted == 1 && report.first_inverted == 0,
+                  "The folded quadrilateral was not found");
+  SC_CHECK_ABORT (report.num_degenerate == 1
+                  && report.first_degenerate == 1,
+                  "The flat quadrilateral was not found");
+  t8_cmesh_destroy (&cmesh);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_cmesh_validate (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test we check t8_element_is_family_array on the element arrays
+ * of adapted forests. For each run of contiguous elements it must return
+ * the same as t8_element_is_family on pointers to these elements.
+ * We then coarsen a uniform forest recursively, which detects the
+ * families with t8_element_is_family_array, until only the trees remain. */
+
+/* Refine some of the elements, such that the leafs have different levels */
+static int
+t8_test_family_refine (t8_forest_t forest, t8_forest_t forest_from,
+                       t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                       t8_eclass_scheme_c * ts, int num_elements,
+                       t8_element_t * elements[])
+{
+  return lelement_id % 5 == 0;
+}
+
+/* Coarsen every family */
+static int
+t8_test_family_coarsen (t8_forest_t forest, t8_forest_t forest_from,
+                        t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                        t8_eclass_scheme_c * ts, int num_elements,
+                        t8_element_t * elements[])
+{
+  return num_elements > 1 ? -1 : 0;
+}
+
+/* Compare t8_element_is_family_array with t8_element_is_family for each
+ * run of elements in the trees of a forest. */
+static void
+t8_test_family_check (t8_forest_t forest)
+{
+  t8_eclass_scheme_c *ts;
+  t8_element_array_t *elements;
+  t8_element_t      **family;
+  t8_locidx_t         itree, ielement, num_elements;
+  int                 num_children, ichild, num_families;
+
+  num_families = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    elements = t8_forest_tree_get_leafs (forest, itree);
+    num_elements = (t8_locidx_t) t8_element_array_get_count (elements);
+    if (num_elements == 0) {
+      continue;
+    }
+    /* All elements of a tree have the same number of children */
+    num_children = ts->t8_element_num_children
+      (t8_element_array_index_locidx (elements, 0));
+    family = T8_ALLOC (t8_element_t *, num_children);
+    for (ielement = 0; ielement + num_children <= num_elements; ielement++) {
+      for (ichild = 0; ichild < num_children; ichild++) {
+        family[ichild] =
+          t8_element_array_index_locidx (elements, ielement + ichild);
+      }
+      SC_CHECK_ABORTF (ts->t8_element_is_family_array (family[0])
+                       == ts->t8_element_is_family (family),
+                       "The family test of the elements from %li in tree"
+                       " %li differs.\n", (long) ielement, (long) itree);
+      num_families += ts->t8_element_is_family (family);
+    }
+    T8_FREE (family);
+  }
+  SC_CHECK_ABORT (t8_forest_get_num_element (forest) == 0
+                  || num_families > 0, "We did not test any family");
+}
+
+static void
+t8_test_family (t8_eclass_t eclass)
+{
+  t8_forest_t         forest, forest_adapt;
+
+  t8_debugf ("Testing the family detection with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  forest =
+    t8_forest_new_uniform (t8_cmesh_new_hypercube
+                           (eclass, sc_MPI_COMM_WORLD, 0, 0, 0),
+                           t8_scheme_new_default_cxx (), 2, 0,
+                           sc_MPI_COMM_WORLD);
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_family_refine, 0);
+  t8_forest_commit (forest_adapt);
+  t8_test_family_check (forest_adapt);
+  t8_forest_unref (&forest_adapt);
+
+  /* On a single process no family is split, so the recursive coarsening
+   * reaches the trees */
+  forest =
+    t8_forest_new_uniform (t8_cmesh_new_hypercube
+                           (eclass, sc_MPI_COMM_SELF, 0, 0, 0),
+                           t8_scheme_new_default_cxx (), 3, 0,
+                           sc_MPI_COMM_SELF);
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_family_coarsen, 1);
+  t8_forest_commit (forest_adapt);
+  SC_CHECK_ABORT (t8_forest_get_num_element (forest_adapt)
+                  == t8_forest_get_num_local_trees (forest_adapt),
+                  "The recursive coarsening missed a family");
+  t8_forest_unref (&forest_adapt);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 ieclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (ieclass = T8_ECLASS_LINE; ieclass < T8_ECLASS_PYRAMID; ieclass++) {
+    t8_test_family ((t8_eclass_t) ieclass);
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
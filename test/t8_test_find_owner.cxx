@@ -167,6 +167,60 @@ t8_test_find_multiple_owners (sc_MPI_Comm comm, t8_eclass_t eclass)
   sc_array_reset (&owners);
 }
 
+/* Find the owners of all elements of each tree of a uniform forest at once,
+ * in SFC order and in reverse order. Compare them with the owners that
+ * t8_forest_element_find_owner computes for each element. */
+static void
+t8_test_find_owners_batch (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  t8_scheme_cxx_t    *default_scheme;
+  t8_eclass_scheme_c *ts;
+  t8_element_t      **elements, **reversed;
+  t8_gloidx_t         itree;
+  int                *owners, *owners_reversed;
+  int                 ielem, num_elements, owner;
+  int                 level = 3;
+
+  t8_global_productionf ("Testing batched find_owners with eclass %s\n",
+                         t8_eclass_to_string[eclass]);
+  default_scheme = t8_scheme_new_default_cxx ();
+  cmesh = t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0);
+  forest = t8_forest_new_uniform (cmesh, default_scheme, level, 0, comm);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  num_elements = t8_eclass_count_leaf (eclass, level);
+  elements = T8_ALLOC (t8_element_t *, num_elements);
+  reversed = T8_ALLOC (t8_element_t *, num_elements);
+  owners = T8_ALLOC (int, num_elements);
+  owners_reversed = T8_ALLOC (int, num_elements);
+  ts->t8_element_new (num_elements, elements);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    ts->t8_element_set_linear_id (elements[ielem], level, ielem);
+    reversed[num_elements - 1 - ielem] = elements[ielem];
+  }
+  for (itree = 0; itree < t8_forest_get_num_global_trees (forest); itree++) {
+    t8_forest_element_find_owners (forest, itree, elements, eclass,
+                                   num_elements, 0, owners);
+    t8_forest_element_find_owners (forest, itree, reversed, eclass,
+                                   num_elements, 0, owners_reversed);
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      owner = t8_forest_element_find_owner (forest, itree, elements[ielem],
+                                            eclass);
+      SC_CHECK_ABORTF (owners[ielem] == owner
+                       && owners_reversed[num_elements - 1 - ielem] == owner,
+                       "Batched owner of element %i in tree %lli is wrong.\n",
+                       ielem, (long long) itree);
+    }
+  }
+  ts->t8_element_destroy (num_elements, elements);
+  T8_FREE (elements);
+  T8_FREE (reversed);
+  T8_FREE (owners);
+  T8_FREE (owners_reversed);
+  t8_forest_unref (&forest);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -187,6 +241,9 @@ main (int argc, char **argv)
       /* TODO: does not work with pyramids yet */
       t8_test_find_multiple_owners (mpic, (t8_eclass_t) ieclass);
     }
+    if (ieclass != T8_ECLASS_VERTEX && ieclass != T8_ECLASS_PYRAMID) {
+      t8_test_find_owners_batch (mpic, (t8_eclass_t) ieclass);
+    }
   }
 
   sc_finalize ();
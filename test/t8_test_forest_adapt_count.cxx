@@ -0,0 +1,255 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* In this test we adapt forests non-recursively with one thread, which
+ * counts the new elements before creating them in their final place.
+ * We compare the forests to the same adaptation in recursive mode, whose
+ * callback stops after one level, and to uniform forests. We also check
+ * that the committed trees are stored in an arena, or in arrays of exactly
+ * their size if the forest trims its elements, also if we adapt from a
+ * forest that trimmed its elements.
+ * Each process tests its own forests, such that families are never split
+ * between processes. */
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_default_cxx.hxx>
+
+/* The callbacks of this test only change elements of the level at which
+ * we start, such that recursive adaptation stops after one step. */
+typedef struct
+{
+  int                 level;    /* The level of the uniform forest */
+  int                 mode;     /* 0: refine all, 1: coarsen all,
+                                   2: mixed, 3: mixed in the first tree,
+                                   4: refine all but the first tree */
+} t8_test_adapt_count_t;
+
+static int
+t8_test_adapt_count_callback (t8_forest_t forest, t8_forest_t forest_from,
+                              t8_locidx_t which_tree,
+                              t8_locidx_t lelement_id,
+                              t8_eclass_scheme_c * ts, int num_elements,
+                              t8_element_t * elements[])
+{
+  const t8_test_adapt_count_t *data =
+    (const t8_test_adapt_count_t *) t8_forest_get_user_data (forest);
+  t8_linearidx_t      id;
+  int                 level, first_tree;
+
+  level = ts->t8_element_level (elements[0]);
+  first_tree =
+    t8_forest_ltreeid_to_cmesh_ltreeid (forest_from, which_tree) == 0;
+  if (level != data->level || (data->mode == 3 && !first_tree)
+      || (data->mode == 4 && first_tree)) {
+    return 0;
+  }
+  if (data->mode == 0 || data->mode == 4) {
+    return 1;
+  }
+  if (data->mode == 1) {
+    return num_elements > 1 ? -1 : 0;
+  }
+  id = ts->t8_element_get_linear_id (elements[0], level);
+  if (num_elements > 1 && id % 5 == 0) {
+    return -1;
+  }
+  return id % 3 == 1;
+}
+
+/* Adapt a forest with the callback in the given mode */
+static              t8_forest_t
+t8_test_adapt_count_forest (t8_forest_t forest_from,
+                            t8_test_adapt_count_t * data, int recursive,
+                            int trim)
+{
+  t8_forest_t         forest;
+
+  t8_forest_ref (forest_from);
+  t8_forest_init (&forest);
+  t8_forest_set_user_data (forest, data);
+  t8_forest_set_adapt (forest, forest_from, t8_test_adapt_count_callback,
+                       recursive);
+  t8_forest_set_trim_elements (forest, trim);
+  t8_forest_commit (forest);
+  return forest;
+}
+
+/* Check that no tree of a forest owns an array with more memory than its
+ * elements need. If trim is false, no tree may own its array at all. */
+static void
+t8_test_adapt_count_storage (t8_forest_t forest, int trim)
+{
+  t8_locidx_t         itree;
+  t8_tree_t           tree;
+  sc_array_t         *array;
+
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    tree = t8_forest_get_tree_lazy (forest, itree);
+    if (tree->implicit_level >= 0) {
+      /* The tree stores no elements */
+      continue;
+    }
+    array = &tree->elements.array;
+    SC_CHECK_ABORT (!SC_ARRAY_IS_OWNER (array) || trim,
+                    "Adapted tree is not stored in an arena");
+    SC_CHECK_ABORT (!SC_ARRAY_IS_OWNER (array)
+                    || (size_t) array->byte_alloc ==
+                    array->elem_count * array->elem_size,
+                    "Adapted tree does not have the size of its elements");
+  }
+}
+
+/* Adapt from a forest whose first tree owns its trimmed elements, such that
+ * this tree is unchanged and must not refer to the memory of the trimmed
+ * forest, which is destroyed when the adapted forest is committed. */
+static void
+t8_test_adapt_count_from_trimmed (t8_forest_t forest,
+                                  t8_test_adapt_count_t * data)
+{
+  t8_forest_t         forest_trimmed, forest_packed;
+  t8_forest_t         forest_counted, forest_compare;
+  int                 trim;
+
+  for (trim = 0; trim <= 1; trim++) {
+    data->mode = 3;
+    forest_trimmed = t8_test_adapt_count_forest (forest, data, 0, 1);
+    forest_packed = t8_test_adapt_count_forest (forest, data, 0, 0);
+    data->mode = 4;
+    /* The adapted forests take the references of their sources */
+    forest_counted =
+      t8_test_adapt_count_forest (forest_trimmed, data, 0, trim);
+    t8_forest_unref (&forest_trimmed);
+    forest_compare =
+      t8_test_adapt_count_forest (forest_packed, data, 0, trim);
+    t8_forest_unref (&forest_packed);
+    SC_CHECK_ABORT (t8_forest_is_equal (forest_counted, forest_compare),
+                    "Adapting from a trimmed forest differs");
+    t8_test_adapt_count_storage (forest_counted, trim);
+    t8_forest_unref (&forest_counted);
+    t8_forest_unref (&forest_compare);
+  }
+}
+
+static void
+t8_test_adapt_count_cmesh (t8_cmesh_t cmesh, int level)
+{
+  t8_forest_t         forest, forest_counted, forest_compare;
+  t8_test_adapt_count_t data;
+  int                 trim;
+
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, cmesh, sc_MPI_COMM_SELF);
+  t8_forest_set_scheme (forest, t8_scheme_new_default_cxx ());
+  t8_forest_set_level (forest, level);
+  t8_forest_commit (forest);
+
+  data.level = level;
+  for (trim = 0; trim <= 1; trim++) {
+    /* Refining all elements gives the uniform forest of the next level */
+    data.mode = 0;
+    forest_counted = t8_test_adapt_count_forest (forest, &data, 0, trim);
+    t8_cmesh_ref (t8_forest_get_cmesh (forest));
+    forest_compare =
+      t8_forest_new_uniform (t8_forest_get_cmesh (forest),
+                             t8_scheme_new_default_cxx (), level + 1, 0,
+                             sc_MPI_COMM_SELF);
+    SC_CHECK_ABORT (t8_forest_is_equal (forest_counted, forest_compare),
+                    "Refined forest is not uniform");
+    t8_test_adapt_count_storage (forest_counted, trim);
+    t8_forest_unref (&forest_counted);
+    t8_forest_unref (&forest_compare);
+
+    /* Coarsening all elements gives the uniform forest of the level before */
+    data.mode = 1;
+    forest_counted = t8_test_adapt_count_forest (forest, &data, 0, trim);
+    t8_cmesh_ref (t8_forest_get_cmesh (forest));
+    forest_compare =
+      t8_forest_new_uniform (t8_forest_get_cmesh (forest),
+                             t8_scheme_new_default_cxx (), level - 1, 0,
+                             sc_MPI_COMM_SELF);
+    SC_CHECK_ABORT (t8_forest_is_equal (forest_counted, forest_compare),
+                    "Coarsened forest is not uniform");
+    t8_test_adapt_count_storage (forest_counted, trim);
+    t8_forest_unref (&forest_counted);
+    t8_forest_unref (&forest_compare);
+
+    /* The mixed adaptation, in all trees or in the first tree only,
+     * equals the recursive adaptation with the same callback */
+    for (data.mode = 2; data.mode <= 3; data.mode++) {
+      forest_counted = t8_test_adapt_count_forest (forest, &data, 0, trim);
+      forest_compare = t8_test_adapt_count_forest (forest, &data, 1, trim);
+      SC_CHECK_ABORT (t8_forest_is_equal (forest_counted, forest_compare),
+                      "Counted and recursive adapt differ");
+      t8_test_adapt_count_storage (forest_counted, trim);
+      t8_forest_unref (&forest_counted);
+      t8_forest_unref (&forest_compare);
+    }
+  }
+  t8_test_adapt_count_from_trimmed (forest, &data);
+  t8_forest_unref (&forest);
+}
+
+static void
+t8_test_adapt_count ()
+{
+  int                 eclass;
+
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing counted adapt with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    t8_test_adapt_count_cmesh (t8_cmesh_new_hypercube ((t8_eclass_t) eclass,
+                                                       sc_MPI_COMM_SELF, 0,
+                                                       0, 0),
+                               eclass <= T8_ECLASS_QUAD ? 3 : 2);
+  }
+  t8_global_productionf ("Testing counted adapt with the hybrid cube\n");
+  t8_test_adapt_count_cmesh (t8_cmesh_new_hypercube_hybrid
+                             (3, sc_MPI_COMM_SELF, 0, 0), 2);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_adapt_count ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* In this test we adapt uniform forests of each element class with one
+ * and with several threads. The forests are large enough to be split into
+ * several ranges, and the adapted forests must be equal.
+ * Without OpenMP both forests are adapted serially. */
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* Coarsen some families and refine some of the other elements.
+ * The decision only depends on the element index, such that it does not
+ * depend on the thread adapting the element. */
+static int
+t8_test_adapt_threads_callback (t8_forest_t forest, t8_forest_t forest_from,
+                                t8_locidx_t which_tree,
+                                t8_locidx_t lelement_id,
+                                t8_eclass_scheme_c * ts, int num_elements,
+                                t8_element_t * elements[])
+{
+  if (num_elements > 1 && lelement_id % 7 == 0) {
+    return -1;
+  }
+  return lelement_id % 3 == 0;
+}
+
+/* Adapt a uniform forest with a given number of threads */
+static              t8_forest_t
+t8_test_adapt_threads_forest (t8_cmesh_t cmesh, int level, int num_threads)
+{
+  t8_forest_t         forest, forest_adapt;
+
+  t8_cmesh_ref (cmesh);
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, cmesh, sc_MPI_COMM_WORLD);
+  t8_forest_set_scheme (forest, t8_scheme_new_default_cxx ());
+  t8_forest_set_level (forest, level);
+  t8_forest_commit (forest);
+
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_adapt_threads_callback,
+                       0);
+  t8_forest_set_adapt_threads (forest_adapt, num_threads);
+  t8_forest_commit (forest_adapt);
+  return forest_adapt;
+}
+
+static void
+t8_test_forest_adapt_threads (void)
+{
+  /* The levels give at least 4096 elements per tree */
+  const int           levels[T8_ECLASS_PYRAMID] = { 0, 12, 6, 6, 4, 4, 4 };
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest_serial, forest_threads;
+  int                 eclass;
+
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing threaded adapt with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    forest_serial = t8_test_adapt_threads_forest (cmesh, levels[eclass], 1);
+    forest_threads = t8_test_adapt_threads_forest (cmesh, levels[eclass], 4);
+    SC_CHECK_ABORT (t8_forest_is_equal (forest_serial, forest_threads),
+                    "Serial and threaded adapt differ");
+    t8_forest_unref (&forest_serial);
+    t8_forest_unref (&forest_threads);
+    t8_cmesh_destroy (&cmesh);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_adapt_threads ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,400 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_iterate.h>
+
+/* In this test, we adapt a uniform forest once with an element wise adapt
+ * callback, once with a tree wise callback that computes markers and once
+ * from a marker array. All three describe the same refinement and we check
+ * that the resulting forests are equal.
+ * We also refine recursively from markers by two levels and compare to a
+ * uniform forest, and we coarsen recursively by two levels with one element
+ * that only allows one level. The family of the parent of that element must
+ * not be coarsened.
+ * Furthermore, we record the adapt map and check that t8_forest_iterate_replace
+ * calls the replace callback in the same way with and without the map,
+ * and that t8_forest_iterate_replace_batch passes the same replacements.
+ * With several threads, t8_forest_iterate_replace_threaded and
+ * t8_forest_iterate_replace_batch must make the same calls as the serial
+ * iteration. */
+
+/* The marker of the element with index lelement_id in its tree.
+ * We coarsen every third family and refine all second children. */
+static int
+t8_test_adapt_marker (t8_eclass_scheme_c * ts, t8_element_t * element,
+                      t8_locidx_t lelement_id)
+{
+  int                 num_children;
+
+  num_children = ts->t8_element_num_children (element);
+  if ((lelement_id / num_children) % 3 == 0) {
+    return -1;
+  }
+  return ts->t8_element_child_id (element) == 1;
+}
+
+static int
+t8_test_adapt_element (t8_forest_t forest, t8_forest_t forest_from,
+                       t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                       t8_eclass_scheme_c * ts, int num_elements,
+                       t8_element_t * elements[])
+{
+  int                 marker;
+
+  marker = t8_test_adapt_marker (ts, elements[0], lelement_id);
+  if (marker < 0) {
+    /* We can only coarsen families */
+    return num_elements > 1 ? -1 : 0;
+  }
+  return marker;
+}
+
+static void
+t8_test_adapt_tree (t8_forest_t forest, t8_forest_t forest_from,
+                    t8_locidx_t which_tree, t8_locidx_t lelement_offset,
+                    t8_eclass_scheme_c * ts, t8_element_array_t * elements,
+                    int8_t * markers)
+{
+  t8_locidx_t         ielem, num_elements;
+
+  num_elements = t8_element_array_get_count (elements);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    markers[ielem] =
+      t8_test_adapt_marker (ts, t8_element_array_index_locidx (elements,
+                                                               ielem),
+                            ielem);
+  }
+}
+
+/* Store the arguments of each call in the array that is the user data
+ * of forest_new. */
+static void
+t8_test_replace (t8_forest_t forest_old, t8_forest_t forest_new,
+                 t8_locidx_t which_tree, t8_eclass_scheme_c * ts,
+                 int num_outgoing, t8_locidx_t first_outgoing,
+                 int num_incoming, t8_locidx_t first_incoming)
+{
+  sc_array_t         *calls;
+  t8_locidx_t        *call;
+
+  calls = (sc_array_t *) t8_forest_get_user_data (forest_new);
+  call = (t8_locidx_t *) sc_array_push (calls);
+  call[0] = which_tree;
+  call[1] = num_outgoing;
+  call[2] = first_outgoing;
+  call[3] = num_incoming;
+  call[4] = first_incoming;
+}
+
+/* Store the arguments of each call in the array of 5 entries per element of
+ * forest_old that is the user data of forest_new. We use the entries of
+ * the first outgoing element, such that the threads write to distinct
+ * entries without allocating memory. */
+static void
+t8_test_replace_slot (t8_forest_t forest_old, t8_forest_t forest_new,
+                      t8_locidx_t which_tree, t8_eclass_scheme_c * ts,
+                      int num_outgoing, t8_locidx_t first_outgoing,
+                      int num_incoming, t8_locidx_t first_incoming)
+{
+  t8_locidx_t        *call;
+
+  call = (t8_locidx_t *) t8_forest_get_user_data (forest_new)
+    + 5 * (t8_forest_get_tree_element_offset (forest_old, which_tree)
+           + first_outgoing);
+  SC_CHECK_ABORT (call[0] == -1, "An element is replaced twice");
+  call[0] = which_tree;
+  call[1] = num_outgoing;
+  call[2] = first_outgoing;
+  call[3] = num_incoming;
+  call[4] = first_incoming;
+}
+
+/* Store the replacements of each run as t8_test_replace_slot would */
+static void
+t8_test_replace_slot_batch (t8_forest_t forest_old, t8_forest_t forest_new,
+                            t8_locidx_t which_tree, t8_eclass_scheme_c * ts,
+                            size_t num_runs,
+                            const t8_forest_adapt_run_t * runs)
+{
+  size_t              irun;
+  t8_locidx_t         ireplace;
+
+  for (irun = 0; irun < num_runs; irun++) {
+    for (ireplace = 0; ireplace < runs[irun].count; ireplace++) {
+      t8_test_replace_slot (forest_old, forest_new, which_tree, ts,
+                            runs[irun].num_old,
+                            runs[irun].first_old +
+                            ireplace * runs[irun].num_old,
+                            runs[irun].num_new,
+                            runs[irun].first_new +
+                            ireplace * runs[irun].num_new);
+    }
+  }
+}
+
+/* Check that the threaded iteration over the replacements from forest_old
+ * to forest_new makes the same calls as the serial iteration */
+static void
+t8_test_replace_threaded (t8_forest_t forest_new, t8_forest_t forest_old)
+{
+  t8_locidx_t        *calls, *calls_threaded;
+  void               *user_data;
+  size_t              num_entries;
+
+  num_entries = 5 * (size_t) t8_forest_get_num_element (forest_old);
+  calls = T8_ALLOC (t8_locidx_t, SC_MAX (num_entries, 1));
+  calls_threaded = T8_ALLOC (t8_locidx_t, SC_MAX (num_entries, 1));
+  memset (calls, -1, num_entries * sizeof (t8_locidx_t));
+  memset (calls_threaded, -1, num_entries * sizeof (t8_locidx_t));
+  user_data = t8_forest_get_user_data (forest_new);
+  t8_forest_set_user_data (forest_new, calls);
+  t8_forest_iterate_replace (forest_new, forest_old, t8_test_replace_slot);
+  t8_forest_set_user_data (forest_new, calls_threaded);
+  t8_forest_iterate_replace_threaded (forest_new, forest_old,
+                                      t8_test_replace_slot, 4);
+  SC_CHECK_ABORT (!memcmp (calls, calls_threaded,
+                           num_entries * sizeof (t8_locidx_t)),
+                  "The threaded replacements are not equal");
+  memset (calls_threaded, -1, num_entries * sizeof (t8_locidx_t));
+  t8_forest_iterate_replace_batch (forest_new, forest_old,
+                                   t8_test_replace_slot_batch, 4);
+  SC_CHECK_ABORT (!memcmp (calls, calls_threaded,
+                           num_entries * sizeof (t8_locidx_t)),
+                  "The threaded batched replacements are not equal");
+  t8_forest_set_user_data (forest_new, user_data);
+  T8_FREE (calls);
+  T8_FREE (calls_threaded);
+}
+
+/* Store the replacements of each run as t8_test_replace would */
+static void
+t8_test_replace_batch (t8_forest_t forest_old, t8_forest_t forest_new,
+                       t8_locidx_t which_tree, t8_eclass_scheme_c * ts,
+                       size_t num_runs, const t8_forest_adapt_run_t * runs)
+{
+  size_t              irun;
+  t8_locidx_t         ireplace;
+
+  SC_CHECK_ABORT (num_runs > 0, "Batched replace called without runs");
+  for (irun = 0; irun < num_runs; irun++) {
+    for (ireplace = 0; ireplace < runs[irun].count; ireplace++) {
+      t8_test_replace (forest_old, forest_new, which_tree, ts,
+                       runs[irun].num_old,
+                       runs[irun].first_old + ireplace * runs[irun].num_old,
+                       runs[irun].num_new,
+                       runs[irun].first_new + ireplace * runs[irun].num_new);
+    }
+  }
+}
+
+/* Fill an array with the markers of all local elements of a forest */
+static int8_t      *
+t8_test_adapt_markers_new (t8_forest_t forest)
+{
+  t8_locidx_t         itree, ielem, num_elements, offset;
+  t8_eclass_scheme_c *ts;
+  int8_t             *markers;
+
+  markers = T8_ALLOC (int8_t, t8_forest_get_num_element (forest));
+  offset = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      markers[offset + ielem] =
+        t8_test_adapt_marker (ts, t8_forest_get_element_in_tree (forest,
+                                                                 itree,
+                                                                 ielem),
+                              ielem);
+    }
+    offset += num_elements;
+  }
+  return markers;
+}
+
+static void
+t8_test_forest_adapt_tree (void)
+{
+  int                 level, eclass;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_element, forest_tree, forest_markers;
+  t8_forest_t         forest_uniform, forest_map;
+  sc_array_t          calls, calls_map;
+  t8_scheme_cxx_t    *scheme;
+  int8_t             *markers;
+  t8_locidx_t         ielem, num_elements;
+  int                 num_children, mpisize, mpiret;
+
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    for (level = 1; level < 4; level++) {
+      t8_global_productionf ("Testing tree adapt with eclass %s, level %i\n",
+                             t8_eclass_to_string[eclass], level);
+      t8_cmesh_ref (cmesh);
+      t8_scheme_cxx_ref (scheme);
+      forest = t8_forest_new_uniform (cmesh, scheme, level, 0,
+                                      sc_MPI_COMM_WORLD);
+      /* We use forest five times and keep it for the replace,
+       * so we ref it five times */
+      t8_forest_ref (forest);
+      t8_forest_ref (forest);
+      t8_forest_ref (forest);
+      t8_forest_ref (forest);
+      t8_forest_ref (forest);
+      markers = t8_test_adapt_markers_new (forest);
+
+      t8_forest_init (&forest_element);
+      t8_forest_set_adapt (forest_element, forest, t8_test_adapt_element, 0);
+      t8_forest_commit (forest_element);
+
+      t8_forest_init (&forest_tree);
+      t8_forest_set_adapt_tree (forest_tree, forest, t8_test_adapt_tree);
+      t8_forest_commit (forest_tree);
+
+      t8_forest_init (&forest_markers);
+      t8_forest_set_adapt_markers (forest_markers, forest, markers, 0);
+      t8_forest_commit (forest_markers);
+      T8_FREE (markers);
+
+      SC_CHECK_ABORT (t8_forest_is_equal (forest_element, forest_tree),
+                      "The forests are not equal");
+      SC_CHECK_ABORT (t8_forest_is_equal (forest_element, forest_markers),
+                      "The forests are not equal");
+
+      /* Check the replacements with and without the adapt map */
+      t8_forest_init (&forest_map);
+      t8_forest_set_adapt (forest_map, forest, t8_test_adapt_element, 0);
+      t8_forest_set_adapt_map (forest_map, 1);
+      t8_forest_commit (forest_map);
+      sc_array_init (&calls, 5 * sizeof (t8_locidx_t));
+      sc_array_init (&calls_map, 5 * sizeof (t8_locidx_t));
+      t8_forest_set_user_data (forest_element, &calls);
+      t8_forest_set_user_data (forest_map, &calls_map);
+      t8_forest_iterate_replace (forest_element, forest, t8_test_replace);
+      t8_forest_iterate_replace (forest_map, forest, t8_test_replace);
+      SC_CHECK_ABORT (sc_array_is_equal (&calls, &calls_map),
+                      "The replacements are not equal");
+      /* Check the batched replacements with and without the adapt map */
+      sc_array_truncate (&calls_map);
+      t8_forest_iterate_replace_batch (forest_map, forest,
+                                       t8_test_replace_batch, 1);
+      SC_CHECK_ABORT (sc_array_is_equal (&calls, &calls_map),
+                      "The batched replacements are not equal");
+      sc_array_truncate (&calls_map);
+      t8_forest_set_user_data (forest_element, &calls_map);
+      t8_forest_iterate_replace_batch (forest_element, forest,
+                                       t8_test_replace_batch, 1);
+      SC_CHECK_ABORT (sc_array_is_equal (&calls, &calls_map),
+                      "The batched replacements are not equal");
+      /* Check the threaded replacements with and without the adapt map */
+      t8_test_replace_threaded (forest_element, forest);
+      t8_test_replace_threaded (forest_map, forest);
+      sc_array_reset (&calls);
+      sc_array_reset (&calls_map);
+      t8_forest_unref (&forest_map);
+      t8_forest_unref (&forest_element);
+      t8_forest_unref (&forest_tree);
+      t8_forest_unref (&forest_markers);
+
+      /* Refine all elements recursively by two levels */
+      markers = T8_ALLOC (int8_t, t8_forest_get_num_element (forest));
+      for (ielem = 0; ielem < t8_forest_get_num_element (forest); ielem++) {
+        markers[ielem] = 2;
+      }
+      t8_forest_init (&forest_markers);
+      t8_forest_set_adapt_markers (forest_markers, forest, markers, 1);
+      t8_forest_commit (forest_markers);
+      T8_FREE (markers);
+      t8_cmesh_ref (cmesh);
+      t8_scheme_cxx_ref (scheme);
+      forest_uniform = t8_forest_new_uniform (cmesh, scheme, level + 2, 0,
+                                              sc_MPI_COMM_WORLD);
+      SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest_markers) ==
+                      t8_forest_get_global_num_elements (forest_uniform),
+                      "Wrong number of elements");
+      t8_forest_unref (&forest_markers);
+      t8_forest_unref (&forest_uniform);
+
+      if (level >= 2 && mpisize == 1) {
+        /* Coarsen all elements recursively by two levels, but the first
+         * element only by one level */
+        num_elements = t8_forest_get_num_element (forest);
+        markers = T8_ALLOC (int8_t, num_elements);
+        for (ielem = 0; ielem < num_elements; ielem++) {
+          markers[ielem] = ielem == 0 ? -1 : -2;
+        }
+        num_children =
+          t8_forest_get_eclass_scheme (forest, (t8_eclass_t) eclass)->
+          t8_element_num_children (t8_forest_get_element_in_tree (forest, 0,
+                                                                  0));
+        t8_forest_ref (forest);
+        t8_forest_init (&forest_markers);
+        t8_forest_set_adapt_markers (forest_markers, forest, markers, 1);
+        t8_forest_commit (forest_markers);
+        T8_FREE (markers);
+        /* Each family of grandchildren became one element, except the
+         * first, which is a family of children */
+        SC_CHECK_ABORT (t8_forest_get_num_element (forest_markers) ==
+                        num_elements / (num_children * num_children) - 1
+                        + num_children, "Wrong number of elements");
+        t8_forest_unref (&forest_markers);
+      }
+      t8_forest_unref (&forest);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_adapt_tree ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
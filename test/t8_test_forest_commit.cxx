@@ -31,8 +31,16 @@
  * We do this in two ways:
  * 1st  All operations are performed in one single call to t8_forest_commit
  * 2nd  Each intermediate step is performed in a seperate commit
+ * 3rd  As 2nd, but balance uses the ripple algorithm
+ * 4th  As 2nd, but balance only checks the elements near changes
+ * 5th  As 1st, but the forest does not keep its partition tables
+ * 6th  As 2nd, but the intermediate forests are committed by the last one
+ * 7th  As 2nd and 6th, but only the first tree is adapted, such that the
+ *      other trees stay unchanged through balance and partition
  *
- * After these two forests are created, we check for equality.
+ * After these forests are created, we check for equality.
+ * We also check that their fingerprints are equal and that they differ
+ * from the fingerprint of the uniform forest if the adaptation changed it.
  */
 
 /* Adapt a forest such that always the first child of a
@@ -66,10 +74,26 @@ t8_test_adapt_balance (t8_forest_t forest, t8_forest_t forest_from,
   return 0;
 }
 
+/* As t8_test_adapt_balance, but only the elements of the first tree of the
+ * cmesh are refined */
+static int
+t8_test_adapt_first_tree (t8_forest_t forest, t8_forest_t forest_from,
+                          t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                          t8_eclass_scheme_c * ts, int num_elements,
+                          t8_element_t * elements[])
+{
+  if (t8_forest_ltreeid_to_cmesh_ltreeid (forest_from, which_tree) != 0) {
+    return 0;
+  }
+  return t8_test_adapt_balance (forest, forest_from, which_tree,
+                                lelement_id, ts, num_elements, elements);
+}
+
 /* Depending on an integer i create a different cmesh.
  * i = 0: cmesh_new_class
  * i = 1: cmesh_new_hypercube
  * i = 2: cmesh_new_bigmesh (2 trees)
+ * i = 3: cmesh_new_bigmesh (8 trees)
  * else:  cmesh_new_class
  */
 static              t8_cmesh_t
@@ -82,14 +106,17 @@ t8_test_create_cmesh (int i, t8_eclass_t eclass, sc_MPI_Comm comm)
     return t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0);
   case 2:
     return t8_cmesh_new_bigmesh (eclass, 2, comm);
+  case 3:
+    return t8_cmesh_new_bigmesh (eclass, 8, comm);
   default:
     return t8_cmesh_new_from_class (eclass, comm);
   }
 }
 
-/* adapt, balance and partition a given forest in one step */
+/* adapt, balance and partition a given forest in one step.
+ * If lazy is true, the forest does not keep its partition tables. */
 static              t8_forest_t
-t8_test_forest_commit_abp (t8_forest_t forest, int maxlevel)
+t8_test_forest_commit_abp (t8_forest_t forest, int maxlevel, int lazy)
 {
   t8_forest_t         forest_ada_bal_par;
 
@@ -100,14 +127,22 @@ t8_test_forest_commit_abp (t8_forest_t forest, int maxlevel)
   t8_forest_set_adapt (forest_ada_bal_par, forest, t8_test_adapt_balance, 1);
   t8_forest_set_balance (forest_ada_bal_par, NULL, 0);
   t8_forest_set_partition (forest_ada_bal_par, NULL, 0);
+  t8_forest_set_lazy_partition_tables (forest_ada_bal_par, lazy);
   t8_forest_commit (forest_ada_bal_par);
 
   return forest_ada_bal_par;
 }
 
-/* adapt, balance and partition a given forest in 3 steps */
+/* adapt, balance and partition a given forest in 3 steps.
+ * If ripple is true, use the ripple balance algorithm.
+ * If incremental is true, use incremental balance.
+ * If chain is true, only the partitioned forest is committed, which
+ * commits the uncommitted adapted and balanced forests.
+ * If first_tree is true, only the first tree is adapted. */
 static              t8_forest_t
-t8_test_forest_commit_abp_3step (t8_forest_t forest, int maxlevel)
+t8_test_forest_commit_abp_3step (t8_forest_t forest, int maxlevel,
+                                 int ripple, int incremental, int chain,
+                                 int first_tree)
 {
   t8_forest_t         forest_adapt, forest_balance, forest_partition;
 
@@ -117,12 +152,19 @@ t8_test_forest_commit_abp_3step (t8_forest_t forest, int maxlevel)
 
   /* adapt the forest */
   t8_forest_set_user_data (forest_adapt, &maxlevel);
-  t8_forest_set_adapt (forest_adapt, forest, t8_test_adapt_balance, 1);
-  t8_forest_commit (forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, first_tree ?
+                       t8_test_adapt_first_tree : t8_test_adapt_balance, 1);
+  if (!chain) {
+    t8_forest_commit (forest_adapt);
+  }
 
   /* balance the forest */
   t8_forest_set_balance (forest_balance, forest_adapt, 0);
-  t8_forest_commit (forest_balance);
+  t8_forest_set_balance_ripple (forest_balance, ripple);
+  t8_forest_set_balance_incremental (forest_balance, incremental);
+  if (!chain) {
+    t8_forest_commit (forest_balance);
+  }
 
   /* partrition the forest */
   t8_forest_set_partition (forest_partition, forest_balance, 0);
@@ -138,11 +180,16 @@ t8_test_forest_commit ()
   int                 eclass;
   t8_cmesh_t          cmesh;
   t8_forest_t         forest, forest_ada_bal_part, forest_abp_3part;
+  t8_forest_t         forest_abp_ripple, forest_abp_incremental;
+  t8_forest_t         forest_abp_lazy, forest_abp_chain;
+  t8_forest_t         forest_first_3part, forest_first_chain;
   t8_scheme_cxx_t    *scheme;
+  uint64_t            fp_uniform[2], fp_3part[2], fp_other[2];
+  t8_gloidx_t         num_uniform;
 
   for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_PYRAMID; eclass++) {
     /* TODO: Activate the other eclass as soon as they support ghosts */
-    for (ctype = 0; ctype < 3; ctype++) {
+    for (ctype = 0; ctype < 4; ctype++) {
       scheme = t8_scheme_new_default_cxx ();
       /* Construct a cmesh */
       cmesh =
@@ -161,22 +208,90 @@ t8_test_forest_commit ()
         /* Create a uniformly refined forest */
         forest = t8_forest_new_uniform (cmesh, scheme, level, 1,
                                         sc_MPI_COMM_WORLD);
-        /* We need to use forest twice, so we ref it */
+        t8_forest_get_fingerprint (forest, fp_uniform);
+        num_uniform = t8_forest_get_global_num_elements (forest);
+        /* We need to use forest eight times, so we ref it seven times */
+        t8_forest_ref (forest);
+        t8_forest_ref (forest);
+        t8_forest_ref (forest);
+        t8_forest_ref (forest);
+        t8_forest_ref (forest);
+        t8_forest_ref (forest);
         t8_forest_ref (forest);
         /* Adapt, balance and partition the forest */
-        forest_ada_bal_part = t8_test_forest_commit_abp (forest, maxlevel);
+        forest_ada_bal_part = t8_test_forest_commit_abp (forest, maxlevel,
+                                                         0);
+        /* The same without partition tables */
+        forest_abp_lazy = t8_test_forest_commit_abp (forest, maxlevel, 1);
         /* Adapt, balance and partition the forest using three seperate steps */
-        forest_abp_3part = t8_test_forest_commit_abp_3step (forest, maxlevel);
-        if (ctype != 2) {
+        forest_abp_3part =
+          t8_test_forest_commit_abp_3step (forest, maxlevel, 0, 0, 0, 0);
+        /* The same with ripple balance */
+        forest_abp_ripple =
+          t8_test_forest_commit_abp_3step (forest, maxlevel, 1, 0, 0, 0);
+        /* The same with incremental balance */
+        forest_abp_incremental =
+          t8_test_forest_commit_abp_3step (forest, maxlevel, 0, 1, 0, 0);
+        /* The same as a chain of uncommitted forests */
+        forest_abp_chain =
+          t8_test_forest_commit_abp_3step (forest, maxlevel, 0, 0, 1, 0);
+        /* Adapt only the first tree with and without a chain */
+        forest_first_3part =
+          t8_test_forest_commit_abp_3step (forest, maxlevel, 0, 0, 0, 1);
+        forest_first_chain =
+          t8_test_forest_commit_abp_3step (forest, maxlevel, 0, 0, 1, 1);
+        if (ctype < 2) {
           t8_forest_write_vtk (forest_ada_bal_part, "test_1step");
           t8_forest_write_vtk (forest_abp_3part, "test_3step");
         }
         SC_CHECK_ABORT (t8_forest_is_equal
                         (forest_abp_3part, forest_ada_bal_part),
                         "The forests are not equal");
+        SC_CHECK_ABORT (t8_forest_is_equal
+                        (forest_abp_3part, forest_abp_ripple),
+                        "The ripple balanced forest is not equal");
+        SC_CHECK_ABORT (t8_forest_is_equal
+                        (forest_abp_3part, forest_abp_incremental),
+                        "The incremental balanced forest is not equal");
+        SC_CHECK_ABORT (t8_forest_is_equal
+                        (forest_abp_3part, forest_abp_lazy),
+                        "The forest without partition tables is not equal");
+        SC_CHECK_ABORT (t8_forest_is_equal
+                        (forest_abp_3part, forest_abp_chain),
+                        "The forest of the derivation chain is not equal");
+        SC_CHECK_ABORT (t8_forest_is_equal
+                        (forest_first_3part, forest_first_chain),
+                        "The chain with unchanged trees is not equal");
+        /* Compare the fingerprints. The lazy forest computes the offset
+         * of its first element without partition tables. */
+        t8_forest_get_fingerprint (forest_abp_3part, fp_3part);
+        t8_forest_get_fingerprint (forest_ada_bal_part, fp_other);
+        SC_CHECK_ABORT (fp_3part[0] == fp_other[0]
+                        && fp_3part[1] == fp_other[1],
+                        "The fingerprints are not equal");
+        t8_forest_get_fingerprint (forest_abp_lazy, fp_other);
+        SC_CHECK_ABORT (fp_3part[0] == fp_other[0]
+                        && fp_3part[1] == fp_other[1],
+                        "The fingerprint without partition tables"
+                        " is not equal");
+        if (num_uniform
+            != t8_forest_get_global_num_elements (forest_abp_3part)) {
+          SC_CHECK_ABORT (fp_3part[0] != fp_uniform[0]
+                          || fp_3part[1] != fp_uniform[1],
+                          "The fingerprint did not change");
+        }
+        /* The tables can be created and freed again */
+        t8_forest_create_partition_tables (forest_abp_lazy);
+        t8_forest_destroy_partition_tables (forest_abp_lazy);
         t8_scheme_cxx_ref (scheme);
         t8_forest_unref (&forest_ada_bal_part);
         t8_forest_unref (&forest_abp_3part);
+        t8_forest_unref (&forest_abp_ripple);
+        t8_forest_unref (&forest_abp_incremental);
+        t8_forest_unref (&forest_abp_lazy);
+        t8_forest_unref (&forest_abp_chain);
+        t8_forest_unref (&forest_first_3part);
+        t8_forest_unref (&forest_first_chain);
 
       }
       t8_scheme_cxx_unref (&scheme);
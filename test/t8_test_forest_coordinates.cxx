@@ -0,0 +1,261 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* In this test we compute the corner coordinates of all leafs of a tree
+ * with t8_forest_tree_leaf_corner_coordinates and compare them to the
+ * coordinates from t8_forest_element_coordinate. We test adapted forests
+ * of a hypercube of each element class and a forest of a single vertex
+ * that is not at the origin.
+ * For the adapted forests of the hypercubes we also compare the geometry
+ * cache with the volume, centroid, face areas and face normals of each
+ * element. */
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_cmesh_vtk.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* Refine every element with child id 1 */
+static int
+t8_test_coordinates_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                           t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                           t8_eclass_scheme_c * ts, int num_elements,
+                           t8_element_t * elements[])
+{
+  return ts->t8_element_child_id (elements[0]) == 1;
+}
+
+/* Compare the batched corner coordinates of each tree with the ones
+ * computed for each corner individually. */
+static void
+t8_test_coordinates_check (t8_forest_t forest)
+{
+  t8_locidx_t         itree, ielem, num_elems;
+  t8_element_t       *element;
+  const double       *vertices;
+  double             *xyz, coords[3];
+  int                 icorner, num_corners;
+  size_t              index;
+
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    num_elems = t8_forest_get_tree_num_elements (forest, itree);
+    num_corners =
+      t8_eclass_num_vertices[t8_forest_get_tree_class (forest, itree)];
+    vertices = t8_forest_get_tree_vertices (forest, itree);
+    xyz = T8_ALLOC (double, 3 * num_elems * num_corners);
+    t8_forest_tree_leaf_corner_coordinates (forest, itree, xyz,
+                                            xyz + num_elems * num_corners,
+                                            xyz +
+                                            2 * num_elems * num_corners);
+    for (ielem = 0; ielem < num_elems; ielem++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielem);
+      for (icorner = 0; icorner < num_corners; icorner++) {
+        t8_forest_element_coordinate (forest, itree, element, vertices,
+                                      icorner, coords);
+        index = (size_t) ielem * num_corners + icorner;
+        SC_CHECK_ABORT (fabs (coords[0] - xyz[index]) < 1e-12
+                        && fabs (coords[1] -
+                                 xyz[index + num_elems * num_corners]) < 1e-12
+                        && fabs (coords[2] -
+                                 xyz[index + 2 * num_elems * num_corners])
+                        < 1e-12, "Corner coordinates differ");
+      }
+    }
+    T8_FREE (xyz);
+  }
+}
+
+/* Return true if two values agree up to rounding */
+static int
+t8_test_geometry_equal (double value, double reference)
+{
+  return fabs (value - reference) <= 1e-10 * SC_MAX (fabs (reference), 1);
+}
+
+/* Compare the geometry cache of a forest with the geometry of each element
+ * and face. */
+static void
+t8_test_geometry_cache_check (t8_forest_t forest)
+{
+  t8_locidx_t         itree, ielem, lelement;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *element;
+  const t8_locidx_t  *face_offsets;
+  const double       *volumes, *centroids[3], *face_areas, *face_normals[3];
+  double             *vertices, coords[3], normal[3];
+  int                 iface, num_faces, i, with_normals;
+
+  t8_forest_get_geometry_cache (forest, &volumes, centroids, &face_offsets,
+                                &face_areas, face_normals);
+  lelement = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    /* The normals of vertex faces are not cached */
+    with_normals =
+      t8_eclass_to_dimension[t8_forest_get_tree_class (forest, itree)] >= 2;
+    vertices = t8_forest_get_tree_vertices (forest, itree);
+    for (ielem = 0; ielem < t8_forest_get_tree_num_elements (forest, itree);
+         ielem++, lelement++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielem);
+      SC_CHECK_ABORT (t8_test_geometry_equal (volumes[lelement],
+                                              t8_forest_element_volume
+                                              (forest, itree, element,
+                                               vertices)),
+                      "Cached volume differs");
+      t8_forest_element_centroid (forest, itree, element, vertices, coords);
+      for (i = 0; i < 3; i++) {
+        SC_CHECK_ABORT (t8_test_geometry_equal (centroids[i][lelement],
+                                                coords[i]),
+                        "Cached centroid differs");
+      }
+      num_faces = ts->t8_element_num_faces (element);
+      SC_CHECK_ABORT (face_offsets[lelement + 1] - face_offsets[lelement]
+                      == num_faces, "Wrong number of cached faces");
+      for (iface = 0; iface < num_faces; iface++) {
+        SC_CHECK_ABORT (t8_test_geometry_equal
+                        (face_areas[face_offsets[lelement] + iface],
+                         t8_forest_element_face_area (forest, itree, element,
+                                                      iface, vertices)),
+                        "Cached face area differs");
+        if (with_normals) {
+          t8_forest_element_face_normal (forest, itree, element, iface,
+                                         vertices, normal);
+          for (i = 0; i < 3; i++) {
+            SC_CHECK_ABORT (t8_test_geometry_equal
+                            (face_normals[i][face_offsets[lelement] + iface],
+                             normal[i]), "Cached face normal differs");
+          }
+        }
+      }
+    }
+  }
+}
+
+/* Check the geometry cache of a forest. We let several threads build the
+ * cache on first use, they must all get the same arrays. We then compare
+ * the cache with the directly computed geometry and with the cache of a
+ * copy that builds it at commit. */
+static void
+t8_test_geometry_cache (t8_forest_t forest)
+{
+  t8_forest_t         forest_copy;
+  const double       *volumes[4];
+  int                 ithread;
+
+#if defined (T8_ENABLE_OPENMP) && defined (_OPENMP)
+#pragma omp parallel for num_threads(4)
+#endif
+  for (ithread = 0; ithread < 4; ithread++) {
+    t8_forest_get_geometry_cache (forest, &volumes[ithread], NULL, NULL,
+                                  NULL, NULL);
+  }
+  for (ithread = 1; ithread < 4; ithread++) {
+    SC_CHECK_ABORT (volumes[ithread] == volumes[0],
+                    "Threads built different geometry caches");
+  }
+  t8_test_geometry_cache_check (forest);
+
+  t8_forest_init (&forest_copy);
+  t8_forest_ref (forest);
+  t8_forest_set_copy (forest_copy, forest);
+  t8_forest_set_geometry_cache (forest_copy, 1);
+  t8_forest_commit (forest_copy);
+  t8_test_geometry_cache_check (forest_copy);
+  t8_forest_unref (&forest_copy);
+}
+
+/* Check the coordinates of a uniform forest and of an adapted forest.
+ * If check_geometry is true, we also check the geometry cache of the
+ * adapted forest. */
+static void
+t8_test_coordinates_forest (t8_cmesh_t cmesh, int level, int check_geometry)
+{
+  t8_forest_t         forest, forest_adapt;
+
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, cmesh, sc_MPI_COMM_WORLD);
+  t8_forest_set_scheme (forest, t8_scheme_new_default_cxx ());
+  t8_forest_set_level (forest, level);
+  t8_forest_commit (forest);
+  t8_test_coordinates_check (forest);
+
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_coordinates_adapt, 0);
+  t8_forest_commit (forest_adapt);
+  t8_test_coordinates_check (forest_adapt);
+  if (check_geometry) {
+    t8_test_geometry_cache (forest_adapt);
+  }
+  t8_forest_unref (&forest_adapt);
+}
+
+static void
+t8_test_forest_coordinates (void)
+{
+  double              vertex[3] = { 1, 2, 3 };
+  t8_cmesh_t          cmesh;
+  int                 level, eclass;
+
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    for (level = 0; level < 3; level++) {
+      t8_global_productionf ("Testing coordinates with eclass %s, level %i\n",
+                             t8_eclass_to_string[eclass], level);
+      cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass,
+                                      sc_MPI_COMM_WORLD, 0, 0, 0);
+      t8_test_coordinates_forest (cmesh, level, 1);
+    }
+  }
+
+  /* A vertex element has the coordinates of its tree */
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_tree_class (cmesh, 0, T8_ECLASS_VERTEX);
+  t8_cmesh_set_tree_vertices (cmesh, 0, t8_get_package_id (), 0, vertex, 1);
+  t8_cmesh_commit (cmesh, sc_MPI_COMM_WORLD);
+  t8_test_coordinates_forest (cmesh, 0, 0);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_coordinates ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,159 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_cursor.h>
+#include <t8_forest/t8_forest_ghost.h>
+
+/* In this test we walk the leafs and the ghosts of adapted forests with the
+ * leaf cursor. It must visit the same elements in the same order as a loop
+ * over the trees with t8_forest_get_element_in_tree and
+ * t8_forest_ghost_get_element, and report the same tree ids, schemes and
+ * indices. */
+
+/* Refine some of the elements, such that the leafs have different levels */
+static int
+t8_test_cursor_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                      t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                      t8_eclass_scheme_c * ts, int num_elements,
+                      t8_element_t * elements[])
+{
+  return (lelement_id + which_tree) % 3 == 0;
+}
+
+/* Check the cursor at one leaf against the reference loop */
+static void
+t8_test_cursor_check (t8_forest_leaf_cursor_t * cursor,
+                      t8_locidx_t ltreeid, t8_eclass_scheme_c * ts,
+                      t8_element_t * element, t8_locidx_t lelement,
+                      t8_locidx_t tree_index, int is_ghost)
+{
+  SC_CHECK_ABORT (t8_forest_leaf_cursor_valid (cursor),
+                  "The cursor stopped too early");
+  SC_CHECK_ABORT (cursor->ltreeid == ltreeid && cursor->ts == ts
+                  && cursor->lelement == lelement
+                  && cursor->tree_index == tree_index
+                  && cursor->is_ghost == is_ghost,
+                  "Wrong cursor position");
+  SC_CHECK_ABORT (cursor->element == element, "Wrong cursor element");
+}
+
+static void
+t8_test_cursor (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_forest_t         forest, forest_adapt;
+  t8_forest_leaf_cursor_t cursor;
+  t8_eclass_scheme_c *ts;
+  t8_locidx_t         itree, ielement, lelement, num_elements;
+  int                 with_ghosts, mpisize, mpiret;
+
+  t8_debugf ("Testing the leaf cursor with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  forest =
+    t8_forest_new_uniform (t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0),
+                           t8_scheme_new_default_cxx (), 2, 0, comm);
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_cursor_adapt, 0);
+  t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_adapt);
+  num_elements = t8_forest_get_num_element (forest_adapt);
+
+  /* A forest on a single process has no ghost layer */
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  for (with_ghosts = 0; with_ghosts <= (mpisize > 1); with_ghosts++) {
+    t8_forest_leaf_cursor_begin (&cursor, forest_adapt, with_ghosts);
+    lelement = 0;
+    for (itree = 0; itree < t8_forest_get_num_local_trees (forest_adapt);
+         itree++) {
+      ts = t8_forest_get_eclass_scheme (forest_adapt,
+                                        t8_forest_get_tree_class
+                                        (forest_adapt, itree));
+      for (ielement = 0;
+           ielement < t8_forest_get_tree_num_elements (forest_adapt, itree);
+           ielement++, lelement++) {
+        t8_test_cursor_check (&cursor, itree, ts,
+                              t8_forest_get_element_in_tree (forest_adapt,
+                                                             itree,
+                                                             ielement),
+                              lelement, ielement, 0);
+        t8_forest_leaf_cursor_next (&cursor);
+      }
+    }
+    SC_CHECK_ABORT (lelement == num_elements, "Wrong number of leafs");
+    if (with_ghosts) {
+      for (itree = 0; itree < t8_forest_get_num_ghost_trees (forest_adapt);
+           itree++) {
+        ts = t8_forest_get_eclass_scheme (forest_adapt,
+                                          t8_forest_ghost_get_tree_class
+                                          (forest_adapt, itree));
+        for (ielement = 0;
+             ielement < t8_forest_ghost_tree_num_elements (forest_adapt,
+                                                           itree);
+             ielement++, lelement++) {
+          t8_test_cursor_check (&cursor, itree, ts,
+                                t8_forest_ghost_get_element (forest_adapt,
+                                                             itree,
+                                                             ielement),
+                                lelement, ielement, 1);
+          t8_forest_leaf_cursor_next (&cursor);
+        }
+      }
+      SC_CHECK_ABORT (lelement == num_elements
+                      + t8_forest_get_num_ghosts (forest_adapt),
+                      "Wrong number of ghosts");
+    }
+    SC_CHECK_ABORT (!t8_forest_leaf_cursor_valid (&cursor)
+                    && cursor.element == NULL,
+                    "The cursor did not stop after the last leaf");
+  }
+  t8_forest_unref (&forest_adapt);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 ieclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (ieclass = T8_ECLASS_LINE; ieclass < T8_ECLASS_PYRAMID; ieclass++) {
+    t8_test_cursor (mpic, (t8_eclass_t) ieclass);
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,235 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_fields.h>
+#include <t8_forest/t8_forest_ghost.h>
+
+/* In this test we attach two fields to a uniform forest with ghosts:
+ * The level of each element, which is updated by interpolation and
+ * restriction callbacks, and a vector of constant doubles, which uses the
+ * default interpolation and the mean as restriction.
+ * We refine, partition, and coarsen the forest and check after each
+ * commit that the fields of the local and ghost elements are correct. */
+
+/* Refine the second child of each family up to the maximum level given as
+ * user data and coarsen every family above the level given as user data
+ * if it is negative. */
+static int
+t8_test_fields_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                      t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                      t8_eclass_scheme_c * ts, int num_elements,
+                      t8_element_t * elements[])
+{
+  int                 level, maxlevel;
+
+  level = ts->t8_element_level (elements[0]);
+  maxlevel = *(int *) t8_forest_get_user_data (forest);
+  if (maxlevel < 0) {
+    /* Coarsen to level -maxlevel */
+    return num_elements > 1 && level > -maxlevel ? -1 : 0;
+  }
+  return level < maxlevel && ts->t8_element_child_id (elements[0]) == 1;
+}
+
+static void
+t8_test_fields_level_interpolate (t8_forest_t forest_old,
+                                  t8_forest_t forest_new,
+                                  t8_locidx_t which_tree,
+                                  t8_eclass_scheme_c * ts, size_t data_size,
+                                  int num_old, t8_locidx_t first_old,
+                                  const void *data_old, int num_new,
+                                  t8_locidx_t first_new, void *data_new,
+                                  void *user_data)
+{
+  int                 ichild;
+
+  SC_CHECK_ABORT (num_old == 1 && data_size == sizeof (int),
+                  "Wrong interpolation arguments");
+  for (ichild = 0; ichild < num_new; ichild++) {
+    ((int *) data_new)[ichild] = *(const int *) data_old + 1;
+  }
+}
+
+static void
+t8_test_fields_level_restrict (t8_forest_t forest_old,
+                               t8_forest_t forest_new,
+                               t8_locidx_t which_tree,
+                               t8_eclass_scheme_c * ts, size_t data_size,
+                               int num_old, t8_locidx_t first_old,
+                               const void *data_old, int num_new,
+                               t8_locidx_t first_new, void *data_new,
+                               void *user_data)
+{
+  SC_CHECK_ABORT (num_new == 1 && data_size == sizeof (int),
+                  "Wrong restriction arguments");
+  *(int *) data_new = *(const int *) data_old - 1;
+}
+
+/* Check the fields of all local and ghost elements */
+static void
+t8_test_fields_check (t8_forest_t forest, int level_id, int value_id)
+{
+  t8_locidx_t         itree, ielement, num_elements, index;
+  t8_locidx_t         num_trees;
+  t8_eclass_scheme_c *ts;
+  const int          *levels;
+  const double       *values;
+  const t8_element_t *element;
+  int                 idim;
+
+  SC_CHECK_ABORT (t8_forest_get_num_fields (forest) == 2,
+                  "Wrong number of fields");
+  SC_CHECK_ABORT (t8_forest_field_find (forest, "level") == level_id,
+                  "Field not found");
+  levels = (const int *) t8_forest_field_get_data (forest, level_id);
+  values = (const double *) t8_forest_field_get_data (forest, value_id);
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0, index = 0; itree < num_trees; itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_elements; ielement++, index++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielement);
+      SC_CHECK_ABORT (levels[index] == ts->t8_element_level (element),
+                      "Wrong level field of a local element");
+      for (idim = 0; idim < 3; idim++) {
+        SC_CHECK_ABORT (values[3 * index + idim] == idim + 1,
+                        "Wrong value field of a local element");
+      }
+    }
+  }
+  num_trees = t8_forest_ghost_num_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_ghost_get_tree_class (forest,
+                                                                      itree));
+    num_elements = t8_forest_ghost_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_elements; ielement++, index++) {
+      element = t8_forest_ghost_get_element (forest, itree, ielement);
+      SC_CHECK_ABORT (levels[index] == ts->t8_element_level (element),
+                      "Wrong level field of a ghost element");
+      SC_CHECK_ABORT (values[3 * index] == 1,
+                      "Wrong value field of a ghost element");
+    }
+  }
+}
+
+static void
+t8_test_forest_fields (sc_MPI_Comm comm)
+{
+  int                 eclass, level, maxlevel, coarsen_level;
+  int                 level_id, value_id, idim;
+  t8_locidx_t         ielement, num_elements;
+  t8_forest_t         forest, forest_adapt;
+  t8_scheme_cxx_t    *scheme;
+  double             *values;
+  int                *levels;
+
+  level = 2;
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing forest fields with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    scheme = t8_scheme_new_default_cxx ();
+    forest =
+      t8_forest_new_uniform (t8_cmesh_new_hypercube
+                             ((t8_eclass_t) eclass, comm, 0, 0, 0), scheme,
+                             level, 1, comm);
+    level_id = t8_forest_field_register (forest, "level", sizeof (int),
+                                         t8_test_fields_level_interpolate,
+                                         t8_test_fields_level_restrict, NULL);
+    value_id = t8_forest_field_register (forest, "value", 3 * sizeof (double),
+                                         NULL, t8_forest_field_restrict_mean,
+                                         NULL);
+    /* Initialize the local entries and exchange the ghost entries */
+    levels = (int *) t8_forest_field_get_data (forest, level_id);
+    values = (double *) t8_forest_field_get_data (forest, value_id);
+    num_elements = t8_forest_get_num_element (forest);
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      levels[ielement] = level;
+      for (idim = 0; idim < 3; idim++) {
+        values[3 * ielement + idim] = idim + 1;
+      }
+    }
+    t8_forest_fields_ghost_exchange (forest);
+    t8_test_fields_check (forest, level_id, value_id);
+
+    /* Refine and partition in one commit */
+    maxlevel = level + 2;
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_user_data (forest_adapt, &maxlevel);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_fields_adapt, 1);
+    t8_forest_set_partition (forest_adapt, NULL, 0);
+    t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+    t8_forest_commit (forest_adapt);
+    forest = forest_adapt;
+    t8_test_fields_check (forest, level_id, value_id);
+
+    /* Coarsen back to the initial level */
+    coarsen_level = -level;
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_user_data (forest_adapt, &coarsen_level);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_fields_adapt, 0);
+    t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+    t8_forest_commit (forest_adapt);
+    forest = forest_adapt;
+    t8_test_fields_check (forest, level_id, value_id);
+
+    /* Partition again */
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_partition (forest_adapt, forest, 0);
+    t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+    t8_forest_commit (forest_adapt);
+    forest = forest_adapt;
+    t8_test_fields_check (forest, level_id, value_id);
+
+    t8_forest_unref (&forest);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_fields (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,187 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_cursor.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_types.h>
+
+/* In this test we create the same uniform forest with stored and with
+ * implicit trees. We check that the cursor visits the same elements in
+ * both forests without creating the elements of the implicit trees.
+ * Then we refine the first element of the first tree in both forests and
+ * check that the other trees stay implicit and that the adapted forests
+ * have the same elements. */
+
+/* Refine the first element of the first local tree */
+static int
+t8_test_implicit_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                        t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                        t8_eclass_scheme_c * ts, int num_elements,
+                        t8_element_t * elements[])
+{
+  return which_tree == 0 && lelement_id == 0;
+}
+
+/* Return the number of local trees of a forest that do not store their
+ * elements */
+static t8_locidx_t
+t8_test_implicit_num_lazy_trees (t8_forest_t forest)
+{
+  t8_locidx_t         itree, num_lazy;
+  t8_tree_t           tree;
+
+  num_lazy = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    tree = t8_forest_get_tree_lazy (forest, itree);
+    if (tree->implicit_level >= 0
+        && t8_element_array_get_count (&tree->elements) == 0) {
+      num_lazy++;
+    }
+  }
+  return num_lazy;
+}
+
+/* Check that two forests have the same elements */
+static void
+t8_test_implicit_compare (t8_forest_t forest_a, t8_forest_t forest_b)
+{
+  t8_locidx_t         itree, ielement, num_elements;
+  t8_eclass_scheme_c *ts;
+
+  SC_CHECK_ABORT (t8_forest_get_num_element (forest_a)
+                  == t8_forest_get_num_element (forest_b),
+                  "Wrong number of elements");
+  SC_CHECK_ABORT (t8_forest_get_num_local_trees (forest_a)
+                  == t8_forest_get_num_local_trees (forest_b),
+                  "Wrong number of trees");
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest_a); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest_a,
+                                      t8_forest_get_tree_class (forest_a,
+                                                                itree));
+    num_elements = t8_forest_get_tree_num_elements (forest_a, itree);
+    SC_CHECK_ABORT (num_elements ==
+                    t8_forest_get_tree_num_elements (forest_b, itree),
+                    "Wrong number of tree elements");
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      SC_CHECK_ABORT (!ts->t8_element_compare
+                      (t8_forest_get_element_in_tree
+                       (forest_a, itree, ielement),
+                       t8_forest_get_element_in_tree
+                       (forest_b, itree, ielement)), "Elements differ");
+    }
+  }
+}
+
+static void
+t8_test_forest_implicit (sc_MPI_Comm comm)
+{
+  int                 eclass, level;
+  t8_locidx_t         lelement, num_trees;
+  t8_forest_t         forest, forest_implicit, forest_adapt;
+  t8_cmesh_t          cmesh;
+  t8_scheme_cxx_t    *scheme;
+  t8_forest_leaf_cursor_t cursor;
+
+  level = 3;
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing implicit forests with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    scheme = t8_scheme_new_default_cxx ();
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_cmesh_ref (cmesh);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, level, 0, comm);
+    t8_forest_init (&forest_implicit);
+    t8_forest_set_cmesh (forest_implicit, cmesh, comm);
+    t8_forest_set_scheme (forest_implicit, scheme);
+    t8_forest_set_level (forest_implicit, level);
+    t8_forest_set_implicit_uniform (forest_implicit, 1);
+    t8_forest_commit (forest_implicit);
+    num_trees = t8_forest_get_num_local_trees (forest_implicit);
+    SC_CHECK_ABORT (t8_test_implicit_num_lazy_trees (forest_implicit)
+                    == num_trees, "Commit created implicit elements");
+
+    /* The cursor computes the elements of the implicit forest */
+    lelement = 0;
+    for (t8_forest_leaf_cursor_begin (&cursor, forest_implicit, 0);
+         t8_forest_leaf_cursor_valid (&cursor);
+         t8_forest_leaf_cursor_next (&cursor), lelement++) {
+      SC_CHECK_ABORT (cursor.lelement == lelement, "Wrong element index");
+      SC_CHECK_ABORT (!cursor.ts->t8_element_compare
+                      (cursor.element,
+                       t8_forest_get_element_in_tree (forest,
+                                                      cursor.ltreeid,
+                                                      cursor.tree_index)),
+                      "Cursor computed a wrong element");
+    }
+    SC_CHECK_ABORT (lelement == t8_forest_get_num_element (forest),
+                    "Cursor visited a wrong number of elements");
+    SC_CHECK_ABORT (t8_test_implicit_num_lazy_trees (forest_implicit)
+                    == num_trees, "Cursor created implicit elements");
+
+    /* Only the changed tree stores its elements after adapt */
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_adapt (forest_adapt, forest_implicit,
+                         t8_test_implicit_adapt, 0);
+    t8_forest_commit (forest_adapt);
+    forest_implicit = forest_adapt;
+    SC_CHECK_ABORT (t8_test_implicit_num_lazy_trees (forest_implicit)
+                    == (num_trees > 0 ? num_trees - 1 : 0),
+                    "Adapt created unchanged implicit elements");
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_implicit_adapt, 0);
+    t8_forest_commit (forest_adapt);
+    forest = forest_adapt;
+    t8_test_implicit_compare (forest, forest_implicit);
+
+    t8_forest_unref (&forest);
+    t8_forest_unref (&forest_implicit);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_implicit (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
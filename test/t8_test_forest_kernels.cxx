@@ -0,0 +1,114 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* In this test, we construct uniform forests with and without the
+ * specialized element kernels and adapt them with and without kernels.
+ * For the default and the Hilbert scheme the resulting forests must be
+ * equal. The Hilbert schemes derive from the default schemes and must not
+ * be treated as default schemes by the kernels. */
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* Refine every element with child id 1 */
+static int
+t8_test_kernels_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                       t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                       t8_eclass_scheme_c * ts, int num_elements,
+                       t8_element_t * elements[])
+{
+  return ts->t8_element_child_id (elements[0]) == 1;
+}
+
+/* Construct a uniform forest and adapt it once. */
+static              t8_forest_t
+t8_test_kernels_forest (t8_cmesh_t cmesh, t8_scheme_cxx_t * scheme,
+                        int level, int use_kernels)
+{
+  t8_forest_t         forest, forest_adapt;
+
+  t8_cmesh_ref (cmesh);
+  t8_scheme_cxx_ref (scheme);
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, cmesh, sc_MPI_COMM_WORLD);
+  t8_forest_set_scheme (forest, scheme);
+  t8_forest_set_level (forest, level);
+  t8_forest_set_specialized_kernels (forest, use_kernels);
+  t8_forest_commit (forest);
+
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_kernels_adapt, 0);
+  t8_forest_commit (forest_adapt);
+  return forest_adapt;
+}
+
+static void
+t8_test_forest_kernels (t8_scheme_cxx_t * scheme)
+{
+  int                 level, eclass;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_kernels;
+
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    for (level = 0; level < 4; level++) {
+      t8_global_productionf ("Testing kernels with eclass %s, level %i\n",
+                             t8_eclass_to_string[eclass], level);
+      forest = t8_test_kernels_forest (cmesh, scheme, level, 0);
+      forest_kernels = t8_test_kernels_forest (cmesh, scheme, level, 1);
+      SC_CHECK_ABORT (t8_forest_is_equal (forest, forest_kernels),
+                      "The forests with and without kernels differ");
+      t8_forest_unref (&forest);
+      t8_forest_unref (&forest_kernels);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_kernels (t8_scheme_new_default_cxx ());
+  t8_test_forest_kernels (t8_scheme_new_hilbert_cxx ());
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
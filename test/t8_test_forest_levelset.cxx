@@ -0,0 +1,174 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_levelset.h>
+
+/* In this test, we compute the level-set markers of uniform forests with
+ * t8_forest_levelset_markers and compare them to the markers computed
+ * element by element with t8_forest_element_centroid,
+ * t8_forest_element_diam and t8_forest_element_coordinate. */
+
+/* The plane x + y + z = 0.7 */
+static double
+t8_test_plane (const double x[3])
+{
+  return x[0] + x[1] + x[2] - .7;
+}
+
+static void
+t8_test_plane_batch (size_t n, const double *points, double t, void *user,
+                     double *values)
+{
+  size_t              i;
+
+  for (i = 0; i < n; i++) {
+    const double        x[3] =
+      { points[i], points[n + i], points[2 * n + i] };
+
+    values[i] = t8_test_plane (x);
+  }
+}
+
+/* The marker of one element as documented for t8_forest_levelset_markers */
+static int
+t8_test_levelset_marker (t8_forest_t forest, t8_locidx_t itree,
+                         const t8_element_t * element,
+                         const t8_forest_levelset_t * levelset)
+{
+  t8_eclass_scheme_c *ts;
+  const double       *vertices;
+  double              coords[3], value;
+  int                 level, within, icorner, num_corners, sign;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest, itree));
+  vertices = t8_forest_get_tree_vertices (forest, itree);
+  level = ts->t8_element_level (element);
+  if (level > levelset->max_level) {
+    return -1;
+  }
+  if (level < levelset->min_level) {
+    return 1;
+  }
+  if (levelset->band_width > 0) {
+    t8_forest_element_centroid (forest, itree, element, vertices, coords);
+    within = fabs (t8_test_plane (coords)) < levelset->band_width
+      * t8_forest_element_diam (forest, itree, element, vertices);
+  }
+  else {
+    num_corners = ts->t8_element_num_corners (element);
+    t8_forest_element_coordinate (forest, itree, element, vertices, 0,
+                                  coords);
+    value = t8_test_plane (coords);
+    sign = value > 0 ? 1 : -(value < 0);
+    within = 0;
+    for (icorner = 1; icorner < num_corners; icorner++) {
+      t8_forest_element_coordinate (forest, itree, element, vertices,
+                                    icorner, coords);
+      value = t8_test_plane (coords);
+      within |= (value > 0 && sign <= 0) || (value == 0 && sign != 0)
+        || (value < 0 && sign >= 0);
+    }
+  }
+  return within ? level < levelset->max_level : -(level >
+                                                  levelset->min_level);
+}
+
+static void
+t8_test_forest_levelset ()
+{
+  int                 level, eclass, iband;
+  const double        band_widths[2] = { 0, .5 };
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  t8_forest_levelset_t levelset;
+  t8_locidx_t         itree, ielem, num_elements;
+  t8_element_t       *element;
+  int8_t             *markers;
+  int                 num_refined;
+
+  levelset.levelset = t8_test_plane_batch;
+  levelset.t = 0;
+  levelset.user = NULL;
+  levelset.min_level = 2;
+  levelset.max_level = 3;
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    for (level = 1; level < 5; level++) {
+      t8_global_productionf ("Testing level-set markers with eclass %s, "
+                             "level %i\n", t8_eclass_to_string[eclass],
+                             level);
+      t8_cmesh_ref (cmesh);
+      forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (),
+                                      level, 0, sc_MPI_COMM_WORLD);
+      for (iband = 0; iband < 2; iband++) {
+        levelset.band_width = band_widths[iband];
+        num_refined = 0;
+        for (itree = 0; itree < t8_forest_get_num_local_trees (forest);
+             itree++) {
+          num_elements = t8_forest_get_tree_num_elements (forest, itree);
+          markers = T8_ALLOC (int8_t, num_elements);
+          t8_forest_levelset_markers (forest, itree, &levelset, markers);
+          for (ielem = 0; ielem < num_elements; ielem++) {
+            element = t8_forest_get_element_in_tree (forest, itree, ielem);
+            SC_CHECK_ABORT (markers[ielem] ==
+                            t8_test_levelset_marker (forest, itree, element,
+                                                     &levelset),
+                            "Wrong level-set marker");
+            num_refined += markers[ielem] > 0;
+          }
+          T8_FREE (markers);
+        }
+        t8_debugf ("%i elements marked for refinement\n", num_refined);
+      }
+      t8_forest_unref (&forest);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_levelset ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
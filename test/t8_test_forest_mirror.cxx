@@ -0,0 +1,254 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_default/t8_default_device.h>
+#include <t8_forest/t8_forest_mirror.h>
+
+/* In this test, we mirror uniform and adapted forests of lines,
+ * quadrilaterals and hexahedra on the host and compare the functions of
+ * t8_default_device.h on the mirrored leafs to the scheme functions. */
+
+static int
+t8_test_adapt_first_child (t8_forest_t forest, t8_forest_t forest_from,
+                           t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                           t8_eclass_scheme_c * ts, int num_elements,
+                           t8_element_t * elements[])
+{
+  return ts->t8_element_level (elements[0]) < 4
+    && ts->t8_element_child_id (elements[0]) == 0;
+}
+
+/* Check one mirrored leaf with the device functions */
+static void
+t8_test_mirror_leaf (t8_eclass_scheme_c * ts, const t8_element_t * leaf,
+                     const void *mirrored, t8_element_t * neigh,
+                     t8_element_t * parent)
+{
+  int                 level, face, num_faces, vertex, idim, dim;
+  int                 neigh_face, device_neigh_face, inside;
+  int                 coords[3], device_coords[3];
+  t8_linearidx_t      device_id = 0;
+  t8_eclass_t         eclass = ts->eclass;
+  double              device_elem[8], device_other[8];
+
+  T8_ASSERT (ts->t8_element_size () <= sizeof (device_elem));
+  SC_CHECK_ABORT (!memcmp (leaf, mirrored, ts->t8_element_size ()),
+                  "Wrong mirrored leaf");
+  level = ts->t8_element_level (leaf);
+  dim = t8_eclass_to_dimension[eclass];
+  num_faces = t8_eclass_num_faces[eclass];
+  memcpy (device_elem, mirrored, ts->t8_element_size ());
+  switch (eclass) {
+  case T8_ECLASS_LINE:
+    device_id = t8_device_line_linear_id ((t8_dline_t *) device_elem, level);
+    break;
+  case T8_ECLASS_QUAD:
+    device_id = t8_device_quad_linear_id ((p4est_quadrant_t *) device_elem,
+                                          level);
+    break;
+  default:
+    device_id = t8_device_hex_linear_id ((p8est_quadrant_t *) device_elem,
+                                         level);
+  }
+  SC_CHECK_ABORT (device_id == ts->t8_element_get_linear_id (leaf, level),
+                  "Wrong linear id");
+  if (level > 0) {
+    int                 child_id;
+
+    ts->t8_element_parent (leaf, parent);
+    switch (eclass) {
+    case T8_ECLASS_LINE:
+      child_id = t8_device_line_child_id ((t8_dline_t *) device_elem);
+      t8_device_line_parent ((t8_dline_t *) device_elem,
+                             (t8_dline_t *) device_other);
+      break;
+    case T8_ECLASS_QUAD:
+      child_id = t8_device_quad_child_id ((p4est_quadrant_t *) device_elem);
+      t8_device_quad_parent ((p4est_quadrant_t *) device_elem,
+                             (p4est_quadrant_t *) device_other);
+      break;
+    default:
+      child_id = t8_device_hex_child_id ((p8est_quadrant_t *) device_elem);
+      t8_device_hex_parent ((p8est_quadrant_t *) device_elem,
+                            (p8est_quadrant_t *) device_other);
+    }
+    SC_CHECK_ABORT (child_id == ts->t8_element_child_id (leaf),
+                    "Wrong child id");
+    SC_CHECK_ABORT (!ts->t8_element_compare
+                    (parent, (t8_element_t *) device_other)
+                    && ts->t8_element_level (parent) ==
+                    ts->t8_element_level ((t8_element_t *) device_other),
+                    "Wrong parent");
+  }
+  for (face = 0; face < num_faces; face++) {
+    inside = ts->t8_element_face_neighbor_inside (leaf, neigh, face,
+                                                  &neigh_face);
+    switch (eclass) {
+    case T8_ECLASS_LINE:
+      device_neigh_face =
+        t8_device_line_face_neighbor ((t8_dline_t *) device_elem, face,
+                                      (t8_dline_t *) device_other);
+      SC_CHECK_ABORT (inside == t8_device_line_is_inside_root
+                      ((t8_dline_t *) device_other), "Wrong inside root");
+      break;
+    case T8_ECLASS_QUAD:
+      device_neigh_face =
+        t8_device_quad_face_neighbor ((p4est_quadrant_t *) device_elem,
+                                      face,
+                                      (p4est_quadrant_t *) device_other);
+      SC_CHECK_ABORT (inside == t8_device_quad_is_inside_root
+                      ((p4est_quadrant_t *) device_other),
+                      "Wrong inside root");
+      break;
+    default:
+      device_neigh_face =
+        t8_device_hex_face_neighbor ((p8est_quadrant_t *) device_elem,
+                                     face,
+                                     (p8est_quadrant_t *) device_other);
+      SC_CHECK_ABORT (inside == t8_device_hex_is_inside_root
+                      ((p8est_quadrant_t *) device_other),
+                      "Wrong inside root");
+    }
+    SC_CHECK_ABORT (device_neigh_face == neigh_face, "Wrong neighbor face");
+    if (inside) {
+      SC_CHECK_ABORT (!ts->t8_element_compare
+                      (neigh, (t8_element_t *) device_other),
+                      "Wrong face neighbor");
+    }
+  }
+  for (vertex = 0; vertex < t8_eclass_num_vertices[eclass]; vertex++) {
+    ts->t8_element_vertex_coords (leaf, vertex, coords);
+    switch (eclass) {
+    case T8_ECLASS_LINE:
+      t8_device_line_vertex_coords ((t8_dline_t *) device_elem, vertex,
+                                    device_coords);
+      break;
+    case T8_ECLASS_QUAD:
+      t8_device_quad_vertex_coords ((p4est_quadrant_t *) device_elem, vertex,
+                                    device_coords);
+      break;
+    default:
+      t8_device_hex_vertex_coords ((p8est_quadrant_t *) device_elem, vertex,
+                                   device_coords);
+    }
+    for (idim = 0; idim < dim; idim++) {
+      SC_CHECK_ABORT (coords[idim] == device_coords[idim],
+                      "Wrong vertex coordinates");
+    }
+  }
+}
+
+static void
+t8_test_mirror_forest (t8_forest_t forest, t8_forest_mirror_t * mirror)
+{
+  t8_locidx_t         itree, ielem;
+  t8_eclass_scheme_c *ts;
+  const t8_forest_mirror_tree_t *tree;
+  t8_element_t       *neigh, *parent;
+
+  t8_forest_mirror_update (mirror, forest);
+  SC_CHECK_ABORT (mirror->num_trees == t8_forest_get_num_local_trees (forest)
+                  && mirror->num_leafs == t8_forest_get_num_element (forest),
+                  "Wrong mirror size");
+  for (itree = 0; itree < mirror->num_trees; itree++) {
+    /* With the host operations, trees points to host memory */
+    tree = mirror->trees + itree;
+    SC_CHECK_ABORT (!memcmp (tree, mirror->host_trees + itree,
+                             sizeof (*tree)), "Wrong mirrored tree");
+    SC_CHECK_ABORT (tree->num_leafs ==
+                    t8_forest_get_tree_num_elements (forest, itree)
+                    && tree->gtreeid ==
+                    t8_forest_global_tree_id (forest, itree),
+                    "Wrong mirrored tree");
+    ts = t8_forest_get_eclass_scheme (forest, (t8_eclass_t) tree->eclass);
+    ts->t8_element_new (1, &neigh);
+    ts->t8_element_new (1, &parent);
+    for (ielem = 0; ielem < tree->num_leafs; ielem++) {
+      t8_test_mirror_leaf (ts,
+                           t8_forest_get_element_in_tree (forest, itree,
+                                                          ielem),
+                           (char *) mirror->leafs + tree->byte_offset
+                           + (size_t) ielem * tree->element_size, neigh,
+                           parent);
+    }
+    ts->t8_element_destroy (1, &neigh);
+    ts->t8_element_destroy (1, &parent);
+  }
+}
+
+static void
+t8_test_forest_mirror ()
+{
+  const t8_eclass_t   eclasses[3] =
+    { T8_ECLASS_LINE, T8_ECLASS_QUAD, T8_ECLASS_HEX };
+  int                 ieclass, level;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt;
+  t8_forest_mirror_t  mirror;
+
+  t8_forest_mirror_init (&mirror, &t8_device_ops_host);
+  for (ieclass = 0; ieclass < 3; ieclass++) {
+    cmesh = t8_cmesh_new_hypercube (eclasses[ieclass], sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    for (level = 0; level < 3; level++) {
+      t8_global_productionf ("Testing the mirror with eclass %s, level %i\n",
+                             t8_eclass_to_string[eclasses[ieclass]], level);
+      t8_cmesh_ref (cmesh);
+      forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (),
+                                      level, 0, sc_MPI_COMM_WORLD);
+      t8_test_mirror_forest (forest, &mirror);
+      forest_adapt = t8_forest_new_adapt (forest, t8_test_adapt_first_child,
+                                          1, 0, NULL);
+      /* The mirror reuses its buffers or grows them */
+      t8_test_mirror_forest (forest_adapt, &mirror);
+      t8_forest_unref (&forest_adapt);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+  t8_forest_mirror_reset (&mirror);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_mirror ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
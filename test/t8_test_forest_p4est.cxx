@@ -0,0 +1,171 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_p4est.h>
+#include <p4est_extended.h>
+#include <p4est_ghost.h>
+#include <p8est_extended.h>
+#include <p8est_ghost.h>
+
+/* In this test, we build uniform forests on bricks, convert them to p4est
+ * and p8est and compare them to the p4est and p8est that are built
+ * directly on the brick connectivity. We also check that the quadrants
+ * are shared with the forest and build a ghost layer on the result. */
+
+static void
+t8_test_forest_p4est (int level)
+{
+  p4est_connectivity_t *brick, *conn;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  p4est_t            *p4est, *p4est_ref;
+  p4est_ghost_t      *ghost;
+  p4est_tree_t       *ptree;
+  p4est_topidx_t      itree;
+  t8_locidx_t         ielem, num_elements;
+  int                *data;
+  int                 iface;
+  size_t              iquad;
+
+  brick = p4est_connectivity_new_brick (3, 2, 0, 1);
+  cmesh = t8_cmesh_new_from_p4est (brick, sc_MPI_COMM_WORLD, 0);
+  forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), level,
+                                  0, sc_MPI_COMM_WORLD);
+  conn = t8_cmesh_to_p4est_connectivity (t8_forest_get_cmesh (forest));
+  for (itree = 0; itree < brick->num_trees; itree++) {
+    for (iface = 0; iface < P4EST_FACES; iface++) {
+      SC_CHECK_ABORT (conn->tree_to_tree[P4EST_FACES * itree + iface] ==
+                      brick->tree_to_tree[P4EST_FACES * itree + iface]
+                      && conn->tree_to_face[P4EST_FACES * itree + iface] ==
+                      brick->tree_to_face[P4EST_FACES * itree + iface],
+                      "Wrong p4est connectivity");
+    }
+  }
+  p4est = t8_forest_to_p4est (forest, conn);
+  p4est_ref = p4est_new_ext (sc_MPI_COMM_WORLD, brick, 0, level, 1, 0,
+                             NULL, NULL);
+  SC_CHECK_ABORT (p4est->global_num_quadrants ==
+                  p4est_ref->global_num_quadrants
+                  && p4est_checksum (p4est) == p4est_checksum (p4est_ref),
+                  "Wrong p4est");
+  /* The quadrants are the leafs of the forest */
+  if (p4est->local_num_quadrants > 0) {
+    ptree = p4est_tree_array_index (p4est->trees, p4est->first_local_tree);
+    SC_CHECK_ABORT ((void *) p4est_quadrant_array_index (&ptree->quadrants,
+                                                         0) ==
+                    (void *) t8_forest_get_element_in_tree
+                    (forest, t8_forest_get_local_id (forest,
+                                                     p4est->first_local_tree),
+                     0), "The quadrants are not shared");
+  }
+  /* Map an array of element data */
+  num_elements = t8_forest_get_num_element (forest);
+  data = T8_ALLOC (int, num_elements);
+  t8_forest_p4est_set_user_data (p4est, data, sizeof (int));
+  ielem = 0;
+  for (itree = p4est->first_local_tree; itree <= p4est->last_local_tree;
+       itree++) {
+    ptree = p4est_tree_array_index (p4est->trees, itree);
+    for (iquad = 0; iquad < ptree->quadrants.elem_count; iquad++) {
+      SC_CHECK_ABORT (p4est_quadrant_array_index (&ptree->quadrants, iquad)
+                      ->p.user_data == data + ielem, "Wrong user data");
+      ielem++;
+    }
+  }
+  SC_CHECK_ABORT (ielem == num_elements, "Wrong number of quadrants");
+  ghost = p4est_ghost_new (p4est, P4EST_CONNECT_FULL);
+  p4est_ghost_destroy (ghost);
+
+  p4est_destroy (p4est_ref);
+  p4est_destroy (p4est);
+  T8_FREE (data);
+  t8_forest_unref (&forest);
+  p4est_connectivity_destroy (conn);
+  p4est_connectivity_destroy (brick);
+}
+
+static void
+t8_test_forest_p8est (int level)
+{
+  p8est_connectivity_t *brick, *conn;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  p8est_t            *p8est, *p8est_ref;
+  p8est_ghost_t      *ghost;
+
+  brick = p8est_connectivity_new_brick (2, 2, 1, 1, 0, 0);
+  cmesh = t8_cmesh_new_from_p8est (brick, sc_MPI_COMM_WORLD, 0);
+  forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), level,
+                                  0, sc_MPI_COMM_WORLD);
+  conn = t8_cmesh_to_p8est_connectivity (t8_forest_get_cmesh (forest));
+  SC_CHECK_ABORT (!memcmp (conn->tree_to_tree, brick->tree_to_tree,
+                           P8EST_FACES * brick->num_trees *
+                           sizeof (p4est_topidx_t))
+                  && !memcmp (conn->tree_to_face, brick->tree_to_face,
+                              P8EST_FACES * brick->num_trees),
+                  "Wrong p8est connectivity");
+  p8est = t8_forest_to_p8est (forest, conn);
+  p8est_ref = p8est_new_ext (sc_MPI_COMM_WORLD, brick, 0, level, 1, 0,
+                             NULL, NULL);
+  SC_CHECK_ABORT (p8est->global_num_quadrants ==
+                  p8est_ref->global_num_quadrants
+                  && p8est_checksum (p8est) == p8est_checksum (p8est_ref),
+                  "Wrong p8est");
+  ghost = p8est_ghost_new (p8est, P8EST_CONNECT_FULL);
+  p8est_ghost_destroy (ghost);
+
+  p8est_destroy (p8est_ref);
+  p8est_destroy (p8est);
+  t8_forest_unref (&forest);
+  p8est_connectivity_destroy (conn);
+  p8est_connectivity_destroy (brick);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, level;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (level = 0; level < 4; level++) {
+    t8_global_productionf ("Testing the p4est conversion at level %i\n",
+                           level);
+    t8_test_forest_p4est (level);
+    t8_test_forest_p8est (level);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,142 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we partition a uniform forest for coarsening, such that
+ * no process boundary cuts a family. Since all families of a uniform forest
+ * are complete, coarsening every family of the partitioned forest once
+ * must give the uniform forest of the next coarser level. To place the
+ * boundaries away from the families, we first partition the forest by
+ * element weights. We also partition by weights and for coarsening in
+ * one step. */
+
+/* The weight of an element depends on its child id */
+static double
+t8_test_weight (t8_forest_t forest_from, t8_locidx_t which_tree,
+                t8_locidx_t lelement_id, t8_eclass_scheme_c * ts,
+                const t8_element_t * element)
+{
+  return 1 + ts->t8_element_child_id (element) % 3;
+}
+
+/* Coarsen every family */
+static int
+t8_test_coarsen_all (t8_forest_t forest, t8_forest_t forest_from,
+                     t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                     t8_eclass_scheme_c * ts, int num_elements,
+                     t8_element_t * elements[])
+{
+  return num_elements > 1 ? -1 : 0;
+}
+
+static void
+t8_test_forest_partition_coarsening ()
+{
+  int                 level, eclass;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_weighted, forest_partition;
+  t8_forest_t         forest_coarse, forest_uniform;
+  t8_scheme_cxx_t    *scheme;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    for (level = 1; level < 4; level++) {
+      t8_global_productionf
+        ("Testing partition for coarsening with eclass %s, level %i\n",
+         t8_eclass_to_string[eclass], level);
+      t8_cmesh_ref (cmesh);
+      t8_scheme_cxx_ref (scheme);
+      forest = t8_forest_new_uniform (cmesh, scheme, level, 0,
+                                      sc_MPI_COMM_WORLD);
+
+      t8_forest_init (&forest_weighted);
+      t8_forest_set_partition (forest_weighted, forest, 0);
+      t8_forest_set_partition_weights (forest_weighted, t8_test_weight,
+                                       NULL);
+      t8_forest_commit (forest_weighted);
+
+      t8_forest_init (&forest_partition);
+      t8_forest_set_partition (forest_partition, forest_weighted, 1);
+      t8_forest_commit (forest_partition);
+
+      /* The weights must not cut families either */
+      t8_forest_ref (forest_partition);
+      t8_forest_init (&forest_weighted);
+      t8_forest_set_partition (forest_weighted, forest_partition, 1);
+      t8_forest_set_partition_weights (forest_weighted, t8_test_weight,
+                                       NULL);
+      t8_forest_commit (forest_weighted);
+
+      t8_cmesh_ref (cmesh);
+      t8_scheme_cxx_ref (scheme);
+      forest_uniform = t8_forest_new_uniform (cmesh, scheme, level - 1, 0,
+                                              sc_MPI_COMM_WORLD);
+      forest_coarse = t8_forest_new_adapt (forest_partition,
+                                           t8_test_coarsen_all, 0, 0, NULL);
+      SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest_coarse)
+                      ==
+                      t8_forest_get_global_num_elements (forest_uniform),
+                      "A process boundary cuts a family");
+      t8_forest_unref (&forest_coarse);
+      forest_coarse = t8_forest_new_adapt (forest_weighted,
+                                           t8_test_coarsen_all, 0, 0, NULL);
+      SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest_coarse)
+                      ==
+                      t8_forest_get_global_num_elements (forest_uniform),
+                      "A weighted process boundary cuts a family");
+      t8_forest_unref (&forest_coarse);
+      t8_forest_unref (&forest_uniform);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_partition_coarsening ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
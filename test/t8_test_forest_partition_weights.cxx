@@ -0,0 +1,313 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_types.h>
+
+/* In this test, we partition a uniform forest by element weights, once with
+ * a weight callback and once with a weight array. We check that both
+ * forests are equal and that the sum of the weights on each process differs
+ * from the average by at most the maximum weight of an element.
+ * We also partition a hybrid cmesh and forest by element class costs and
+ * check that a partition within the imbalance tolerance is skipped. */
+
+/* The maximum weight that t8_test_weight returns */
+#define T8_TEST_MAX_WEIGHT 4
+
+/* The element class costs of the hybrid test */
+static const double t8_test_eclass_costs[T8_ECLASS_COUNT] =
+  { 1, 1, 1, 1, 1, 0.6, 0.8, 1 };
+
+/* All costs equal to 1 */
+static const double t8_test_unit_costs[T8_ECLASS_COUNT] =
+  { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+/* The weight of an element, it depends on its child id */
+static double
+t8_test_weight (t8_forest_t forest_from, t8_locidx_t which_tree,
+                t8_locidx_t lelement_id, t8_eclass_scheme_c * ts,
+                const t8_element_t * element)
+{
+  return 1 + ts->t8_element_child_id (element) % T8_TEST_MAX_WEIGHT;
+}
+
+/* Compute the sum of the weights of the local elements of a forest.
+ * If weights is not NULL, store the weight of each element in it. */
+static double
+t8_test_local_weight (t8_forest_t forest, double *weights)
+{
+  t8_locidx_t         itree, ielem, lelem;
+  t8_eclass_scheme_c *ts;
+  double              weight, sum = 0;
+
+  for (itree = 0, lelem = 0; itree < t8_forest_get_num_local_trees (forest);
+       itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    for (ielem = 0; ielem < t8_forest_get_tree_num_elements (forest, itree);
+         ielem++, lelem++) {
+      weight = t8_test_weight (forest, itree, ielem, ts,
+                               t8_forest_get_element_in_tree (forest, itree,
+                                                              ielem));
+      if (weights != NULL) {
+        weights[lelem] = weight;
+      }
+      sum += weight;
+    }
+  }
+  return sum;
+}
+
+/* The weight of an element is the cost of its element class */
+static double
+t8_test_eclass_weight (t8_forest_t forest_from, t8_locidx_t which_tree,
+                       t8_locidx_t lelement_id, t8_eclass_scheme_c * ts,
+                       const t8_element_t * element)
+{
+  return t8_test_eclass_costs[t8_forest_get_tree_class (forest_from,
+                                                        which_tree)];
+}
+
+/* Compute the sum of the element class costs of the local elements */
+static double
+t8_test_local_cost (t8_forest_t forest)
+{
+  t8_locidx_t         itree;
+  double              sum = 0;
+
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    sum += t8_test_eclass_costs[t8_forest_get_tree_class (forest, itree)]
+      * t8_forest_get_tree_num_elements (forest, itree);
+  }
+  return sum;
+}
+
+static void
+t8_test_forest_partition_weights ()
+{
+  int                 level, eclass, mpiret, mpisize;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_fn, forest_array;
+  t8_scheme_cxx_t    *scheme;
+  double             *weights, local_weight, total_weight;
+
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    for (level = 1; level < 4; level++) {
+      t8_global_productionf
+        ("Testing weighted partition with eclass %s, level %i\n",
+         t8_eclass_to_string[eclass], level);
+      t8_cmesh_ref (cmesh);
+      t8_scheme_cxx_ref (scheme);
+      forest = t8_forest_new_uniform (cmesh, scheme, level, 0,
+                                      sc_MPI_COMM_WORLD);
+      /* We use forest twice */
+      t8_forest_ref (forest);
+      weights = T8_ALLOC (double, t8_forest_get_num_element (forest));
+      (void) t8_test_local_weight (forest, weights);
+
+      t8_forest_init (&forest_fn);
+      t8_forest_set_partition (forest_fn, forest, 0);
+      t8_forest_set_partition_weights (forest_fn, t8_test_weight, NULL);
+      t8_forest_commit (forest_fn);
+
+      t8_forest_init (&forest_array);
+      t8_forest_set_partition (forest_array, forest, 0);
+      t8_forest_set_partition_weights (forest_array, NULL, weights);
+      t8_forest_commit (forest_array);
+      T8_FREE (weights);
+
+      SC_CHECK_ABORT (t8_forest_is_equal (forest_fn, forest_array),
+                      "The weighted partitions are not equal");
+      /* Check that the weights are balanced */
+      local_weight = t8_test_local_weight (forest_fn, NULL);
+      mpiret = sc_MPI_Allreduce (&local_weight, &total_weight, 1,
+                                 sc_MPI_DOUBLE, sc_MPI_SUM,
+                                 sc_MPI_COMM_WORLD);
+      SC_CHECK_MPI (mpiret);
+      SC_CHECK_ABORT (fabs (local_weight - total_weight / mpisize)
+                      <= T8_TEST_MAX_WEIGHT, "The weights are not balanced");
+
+      t8_forest_unref (&forest_fn);
+      t8_forest_unref (&forest_array);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+/* Partition a hybrid cmesh with element class costs and check that a
+ * uniform forest on it is balanced by cost. Then check that partitioning
+ * by the cmesh costs is the same as partitioning by weights that equal
+ * the costs. */
+static void
+t8_test_forest_partition_eclass_costs ()
+{
+  int                 level, mpiret, mpisize;
+  t8_cmesh_t          cmesh_gate, cmesh;
+  t8_forest_t         forest, forest_costs, forest_fn;
+  t8_scheme_cxx_t    *scheme;
+  double              local_cost, total_cost;
+
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  scheme = t8_scheme_new_default_cxx ();
+  cmesh_gate = t8_cmesh_new_hybrid_gate (sc_MPI_COMM_WORLD);
+  for (level = 0; level < 3; level++) {
+    t8_global_productionf
+      ("Testing element class costs with the hybrid gate, level %i\n",
+       level);
+    t8_cmesh_ref (cmesh_gate);
+    t8_cmesh_init (&cmesh);
+    t8_cmesh_set_derive (cmesh, cmesh_gate);
+    t8_cmesh_set_partition_uniform (cmesh, level);
+    t8_cmesh_set_partition_eclass_costs (cmesh, t8_test_eclass_costs);
+    t8_cmesh_commit (cmesh, sc_MPI_COMM_WORLD);
+
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, level, 0,
+                                    sc_MPI_COMM_WORLD);
+    /* Each process starts at the first element whose cost prefix sum
+     * reaches its share, thus it differs by less than one element cost */
+    local_cost = t8_test_local_cost (forest);
+    mpiret = sc_MPI_Allreduce (&local_cost, &total_cost, 1, sc_MPI_DOUBLE,
+                               sc_MPI_SUM, sc_MPI_COMM_WORLD);
+    SC_CHECK_MPI (mpiret);
+    SC_CHECK_ABORT (fabs (local_cost - total_cost / mpisize) <= 1,
+                    "The uniform forest is not balanced by cost");
+
+    t8_forest_ref (forest);
+    t8_forest_init (&forest_costs);
+    t8_forest_set_partition (forest_costs, forest, 0);
+    t8_forest_commit (forest_costs);
+
+    t8_forest_init (&forest_fn);
+    t8_forest_set_partition (forest_fn, forest, 0);
+    t8_forest_set_partition_weights (forest_fn, t8_test_eclass_weight, NULL);
+    t8_forest_set_partition_eclass_costs (forest_fn, t8_test_unit_costs);
+    t8_forest_commit (forest_fn);
+
+    SC_CHECK_ABORT (t8_forest_is_equal (forest_costs, forest_fn),
+                    "The partitions by costs and by weights are not equal");
+    t8_forest_unref (&forest_costs);
+    t8_forest_unref (&forest_fn);
+  }
+  t8_cmesh_destroy (&cmesh_gate);
+  t8_scheme_cxx_unref (&scheme);
+}
+
+/* Partition a forest that is balanced by weights again with an imbalance
+ * tolerance. Since the weight of each process differs from the average by
+ * at most the maximum weight, the imbalance is at most
+ * 1 + mpisize * T8_TEST_MAX_WEIGHT / total weight. With this tolerance the
+ * partition is skipped and the forest must not change. */
+static void
+t8_test_forest_partition_imbalance ()
+{
+  int                 level, mpiret, mpisize;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_weighted, forest_skip;
+  t8_scheme_cxx_t    *scheme;
+  double              local_weight, total_weight, tolerance;
+
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  scheme = t8_scheme_new_default_cxx ();
+  cmesh = t8_cmesh_new_hypercube (T8_ECLASS_QUAD, sc_MPI_COMM_WORLD, 0, 0, 0);
+  for (level = 2; level < 5; level++) {
+    t8_global_productionf ("Testing partition imbalance at level %i\n",
+                           level);
+    t8_cmesh_ref (cmesh);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, level, 0,
+                                    sc_MPI_COMM_WORLD);
+    t8_forest_init (&forest_weighted);
+    t8_forest_set_partition (forest_weighted, forest, 0);
+    t8_forest_set_partition_weights (forest_weighted, t8_test_weight, NULL);
+    t8_forest_commit (forest_weighted);
+
+    local_weight = t8_test_local_weight (forest_weighted, NULL);
+    mpiret = sc_MPI_Allreduce (&local_weight, &total_weight, 1,
+                               sc_MPI_DOUBLE, sc_MPI_SUM, sc_MPI_COMM_WORLD);
+    SC_CHECK_MPI (mpiret);
+    tolerance = 1 + mpisize * T8_TEST_MAX_WEIGHT / total_weight;
+
+    t8_forest_ref (forest_weighted);
+    t8_forest_init (&forest_skip);
+    t8_forest_set_partition (forest_skip, forest_weighted, 0);
+    t8_forest_set_partition_weights (forest_skip, t8_test_weight, NULL);
+    t8_forest_set_partition_imbalance (forest_skip, tolerance);
+    t8_forest_set_profiling (forest_skip, 1);
+    t8_forest_commit (forest_skip);
+
+    SC_CHECK_ABORT (forest_skip->profile->partition_imbalance >= 1
+                    && forest_skip->profile->partition_imbalance
+                    <= tolerance, "The imbalance exceeds its bound");
+    SC_CHECK_ABORT (forest_skip->profile->partition_skipped,
+                    "The balanced partition was not skipped");
+
+    SC_CHECK_ABORT (t8_forest_get_num_element (forest_skip)
+                    == t8_forest_get_num_element (forest_weighted),
+                    "The skipped partition moved elements");
+    SC_CHECK_ABORT (t8_forest_is_equal (forest_skip, forest_weighted),
+                    "The skipped partition changed the forest");
+    t8_forest_unref (&forest_skip);
+    t8_forest_unref (&forest_weighted);
+  }
+  t8_cmesh_destroy (&cmesh);
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_partition_weights ();
+  t8_test_forest_partition_eclass_costs ();
+  t8_test_forest_partition_imbalance ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
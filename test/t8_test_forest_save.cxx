@@ -0,0 +1,462 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+
+/* In this test, we save an adapted forest together with the global index
+ * of each element as element data. We load it again and check that the
+ * forest and the data are restored. */
+
+/* Refine every element with child id 1 up to a maximum level. */
+static int
+t8_test_save_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                    t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                    t8_eclass_scheme_c * ts, int num_elements,
+                    t8_element_t * elements[])
+{
+  int                 maxlevel;
+
+  maxlevel = *(int *) t8_forest_get_user_data (forest);
+  if (ts->t8_element_level (elements[0]) >= maxlevel) {
+    return 0;
+  }
+  return ts->t8_element_child_id (elements[0]) == 1;
+}
+
+static void
+t8_test_forest_save (sc_MPI_Comm comm)
+{
+  int                 eclass, level, maxlevel;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt, forest_load;
+  t8_scheme_cxx_t    *scheme;
+  t8_gloidx_t        *data, first_element;
+  t8_locidx_t         ielem;
+  const char         *filename = "test_forest_save.t8f";
+
+  level = 1;
+  maxlevel = level + 2;
+  for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing forest save with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    scheme = t8_scheme_new_default_cxx ();
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_cmesh_ref (cmesh);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, level, 0, comm);
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_user_data (forest_adapt, &maxlevel);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_save_adapt, 1);
+    t8_forest_set_partition (forest_adapt, NULL, 0);
+    t8_forest_commit (forest_adapt);
+
+    /* Store the global index of each element as element data */
+    first_element = t8_forest_get_first_local_element_id (forest_adapt);
+    data = T8_ALLOC (t8_gloidx_t,
+                     t8_forest_get_num_element (forest_adapt));
+    for (ielem = 0; ielem < t8_forest_get_num_element (forest_adapt);
+         ielem++) {
+      data[ielem] = first_element + ielem;
+    }
+    SC_CHECK_ABORT (t8_forest_save (forest_adapt, filename, data,
+                                    sizeof (t8_gloidx_t)),
+                    "Could not save the forest");
+    T8_FREE (data);
+
+    /* Load the forest on the same cmesh */
+    t8_forest_init (&forest_load);
+    t8_forest_set_cmesh (forest_load, cmesh, comm);
+    t8_forest_set_scheme (forest_load, scheme);
+    t8_forest_set_load (forest_load, filename);
+    t8_forest_commit (forest_load);
+    SC_CHECK_ABORT (t8_forest_is_equal (forest_adapt, forest_load),
+                    "The loaded forest is not equal");
+
+    /* Load and check the element data */
+    data = T8_ALLOC (t8_gloidx_t, t8_forest_get_num_element (forest_load));
+    SC_CHECK_ABORT (t8_forest_load_element_data (forest_load, filename,
+                                                 data, sizeof (t8_gloidx_t)),
+                    "Could not load the element data");
+    first_element = t8_forest_get_first_local_element_id (forest_load);
+    for (ielem = 0; ielem < t8_forest_get_num_element (forest_load);
+         ielem++) {
+      SC_CHECK_ABORT (data[ielem] == first_element + ielem,
+                      "The loaded element data is not equal");
+    }
+    T8_FREE (data);
+
+    t8_forest_unref (&forest_adapt);
+    t8_forest_unref (&forest_load);
+  }
+}
+
+/* Build an adapted forest again from the levels and linear ids of its
+ * local leaves and check that both forests are equal. */
+static void
+t8_test_forest_from_leaves (sc_MPI_Comm comm)
+{
+  int                 eclass, level, maxlevel;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt, forest_leaves;
+  t8_scheme_cxx_t    *scheme;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *element;
+  t8_locidx_t         itree, num_trees, ielem, num_elems, ileaf;
+  t8_locidx_t        *tree_num_leaves;
+  int                *levels;
+  t8_linearidx_t     *linear_ids;
+
+  level = 1;
+  maxlevel = level + 2;
+  for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing forest from leaves with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    scheme = t8_scheme_new_default_cxx ();
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_cmesh_ref (cmesh);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, level, 0, comm);
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_user_data (forest_adapt, &maxlevel);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_save_adapt, 1);
+    t8_forest_set_partition (forest_adapt, NULL, 0);
+    t8_forest_commit (forest_adapt);
+
+    /* Collect the leaves of each local tree */
+    num_trees = t8_forest_get_num_local_trees (forest_adapt);
+    tree_num_leaves = T8_ALLOC (t8_locidx_t, num_trees);
+    levels = T8_ALLOC (int, t8_forest_get_num_element (forest_adapt));
+    linear_ids = T8_ALLOC (t8_linearidx_t,
+                           t8_forest_get_num_element (forest_adapt));
+    for (itree = 0, ileaf = 0; itree < num_trees; itree++) {
+      ts = t8_forest_get_eclass_scheme (forest_adapt,
+                                        t8_forest_get_tree_class
+                                        (forest_adapt, itree));
+      num_elems = t8_forest_get_tree_num_elements (forest_adapt, itree);
+      tree_num_leaves[itree] = num_elems;
+      for (ielem = 0; ielem < num_elems; ielem++, ileaf++) {
+        element = t8_forest_get_element_in_tree (forest_adapt, itree, ielem);
+        levels[ileaf] = ts->t8_element_level (element);
+        linear_ids[ileaf] = ts->t8_element_get_linear_id (element,
+                                                          levels[ileaf]);
+      }
+    }
+
+    forest_leaves =
+      t8_forest_new_from_leaves (cmesh, scheme,
+                                 t8_forest_get_first_local_tree_id
+                                 (forest_adapt), num_trees, tree_num_leaves,
+                                 levels, linear_ids, 0, comm);
+    SC_CHECK_ABORT (t8_forest_is_equal (forest_adapt, forest_leaves),
+                    "The forest from leaves is not equal");
+    T8_FREE (tree_num_leaves);
+    T8_FREE (levels);
+    T8_FREE (linear_ids);
+    t8_forest_unref (&forest_adapt);
+    t8_forest_unref (&forest_leaves);
+  }
+}
+
+/* Save a replicated cmesh to a single file and load it again */
+static void
+t8_test_cmesh_save_parallel (sc_MPI_Comm comm)
+{
+  int                 eclass;
+  t8_cmesh_t          cmesh, cmesh_load;
+  const char         *filename = "test_cmesh_save.t8c";
+
+  for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_COUNT; eclass++) {
+    t8_global_productionf ("Testing cmesh save with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    SC_CHECK_ABORT (t8_cmesh_save_parallel (cmesh, filename, comm),
+                    "Could not save the cmesh");
+    cmesh_load = t8_cmesh_load_parallel (filename, comm);
+    SC_CHECK_ABORT (cmesh_load != NULL, "Could not load the cmesh");
+    SC_CHECK_ABORT (t8_cmesh_is_equal (cmesh, cmesh_load),
+                    "The loaded cmesh is not equal");
+    t8_cmesh_destroy (&cmesh);
+    t8_cmesh_destroy (&cmesh_load);
+  }
+}
+
+/* Check that a tree or ghost with global id gtree of a partitioned cmesh
+ * has the same class and face neighbors as in the replicated cmesh_ref */
+static void
+t8_test_cmesh_load_compare_tree (t8_cmesh_t cmesh_ref, t8_gloidx_t gtree,
+                                 t8_eclass_t eclass,
+                                 const t8_gloidx_t * neighbors,
+                                 const int8_t * ttf)
+{
+  t8_ctree_t          tree_ref;
+  t8_locidx_t        *neighbors_ref;
+  int8_t             *ttf_ref;
+  int                 iface;
+
+  tree_ref = t8_cmesh_trees_get_tree_ext (cmesh_ref->trees,
+                                          (t8_locidx_t) gtree,
+                                          &neighbors_ref, &ttf_ref);
+  SC_CHECK_ABORTF (tree_ref->eclass == eclass, "Wrong class of tree %li",
+                   (long) gtree);
+  for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+    SC_CHECK_ABORTF (neighbors[iface] == neighbors_ref[iface]
+                     && ttf[iface] == ttf_ref[iface],
+                     "Wrong neighbor at face %i of tree %li", iface,
+                     (long) gtree);
+  }
+}
+
+/* Save a partitioned cmesh to a single file and load it again.
+ * The local trees and ghosts of the loaded cmesh, including the face
+ * connections between ghosts, must match the replicated cmesh. */
+static void
+t8_test_cmesh_load_partitioned (t8_cmesh_t cmesh, t8_cmesh_t cmesh_ref,
+                                sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh_load;
+  t8_locidx_t         num_trees, itree, ighost, *face_neigh;
+  t8_gloidx_t         neighbors[T8_ECLASS_MAX_FACES], *ghost_neigh;
+  t8_ctree_t          tree;
+  t8_cghost_t         ghost;
+  int8_t             *ttf;
+  int                 iface;
+  const char         *filename = "test_cmesh_save_partitioned.t8c";
+
+  SC_CHECK_ABORT (t8_cmesh_save_parallel (cmesh, filename, comm),
+                  "Could not save the cmesh");
+  cmesh_load = t8_cmesh_load_parallel (filename, comm);
+  SC_CHECK_ABORT (cmesh_load != NULL, "Could not load the cmesh");
+  SC_CHECK_ABORT (t8_cmesh_is_partitioned (cmesh_load),
+                  "The loaded cmesh is not partitioned");
+  num_trees = t8_cmesh_get_num_local_trees (cmesh_load);
+  /* The saved partition is reused */
+  SC_CHECK_ABORT (t8_cmesh_get_first_treeid (cmesh_load) ==
+                  t8_cmesh_get_first_treeid (cmesh)
+                  && num_trees == t8_cmesh_get_num_local_trees (cmesh)
+                  && t8_cmesh_get_num_ghosts (cmesh_load) ==
+                  t8_cmesh_get_num_ghosts (cmesh),
+                  "The loaded cmesh has a different partition");
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_cmesh_trees_get_tree_ext (cmesh_load->trees, itree,
+                                        &face_neigh, &ttf);
+    for (iface = 0; iface < t8_eclass_num_faces[tree->eclass]; iface++) {
+      neighbors[iface] = t8_cmesh_get_global_id (cmesh_load,
+                                                 face_neigh[iface]);
+    }
+    t8_test_cmesh_load_compare_tree (cmesh_ref,
+                                     t8_cmesh_get_global_id (cmesh_load,
+                                                             itree),
+                                     tree->eclass, neighbors, ttf);
+  }
+  for (ighost = 0; ighost < t8_cmesh_get_num_ghosts (cmesh_load); ighost++) {
+    ghost = t8_cmesh_trees_get_ghost_ext (cmesh_load->trees, ighost,
+                                          &ghost_neigh, &ttf);
+    t8_test_cmesh_load_compare_tree (cmesh_ref, ghost->treeid,
+                                     ghost->eclass, ghost_neigh, ttf);
+  }
+  t8_cmesh_destroy (&cmesh_load);
+}
+
+/* Save partitioned hypercubes and load them again */
+static void
+t8_test_cmesh_save_partitioned (sc_MPI_Comm comm)
+{
+  int                 eclass;
+  t8_cmesh_t          cmesh, cmesh_ref;
+
+  for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_COUNT; eclass++) {
+    t8_global_productionf ("Testing partitioned cmesh save with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 1, 0);
+    cmesh_ref = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_test_cmesh_load_partitioned (cmesh, cmesh_ref, comm);
+    t8_cmesh_destroy (&cmesh);
+    t8_cmesh_destroy (&cmesh_ref);
+  }
+  /* The ghosts of the hybrid cube are connected to each other and to
+   * trees that are neither local nor ghosts */
+  cmesh_ref = t8_cmesh_new_hypercube_hybrid (3, comm, 0, 0);
+  t8_cmesh_ref (cmesh_ref);
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_derive (cmesh, cmesh_ref);
+  t8_cmesh_set_partition_uniform (cmesh, 0);
+  t8_cmesh_commit (cmesh, comm);
+  t8_test_cmesh_load_partitioned (cmesh, cmesh_ref, comm);
+  t8_cmesh_destroy (&cmesh);
+  t8_cmesh_destroy (&cmesh_ref);
+}
+
+/* Save a replicated cmesh in the mapped format and load it again */
+static void
+t8_test_cmesh_save_mapped (sc_MPI_Comm comm)
+{
+  int                 eclass, mpiret;
+  t8_cmesh_t          cmesh, cmesh_load;
+  const char         *filename = "test_cmesh_save.t8m";
+
+  for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_COUNT; eclass++) {
+    t8_global_productionf ("Testing mapped cmesh save with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    SC_CHECK_ABORT (t8_cmesh_save_mapped (cmesh, filename),
+                    "Could not save the cmesh");
+    /* Only rank 0 writes the file */
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+    cmesh_load = t8_cmesh_load_mapped (filename, comm);
+    SC_CHECK_ABORT (cmesh_load != NULL, "Could not load the cmesh");
+    SC_CHECK_ABORT (t8_cmesh_is_equal (cmesh, cmesh_load),
+                    "The loaded cmesh is not equal");
+    t8_cmesh_destroy (&cmesh);
+    t8_cmesh_destroy (&cmesh_load);
+    /* Wait until all processes released the file before it is rewritten */
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+/* The ways in which we corrupt the first tree of a mapped cmesh file */
+enum
+{
+  T8_TEST_CORRUPT_FACE_NEIGHBOR,
+  T8_TEST_CORRUPT_ATTRIBUTE_OFFSET,
+  T8_TEST_CORRUPT_ATTRIBUTE_SIZE,
+  T8_TEST_CORRUPT_COUNT
+};
+
+/* Write a copy of a mapped cmesh file where one entry of the first tree
+ * is out of range. The trees are stored at the end of the file. */
+static void
+t8_test_cmesh_corrupt_mapped (const char *filename, const char *corrupt_name,
+                              size_t trees_bytes, int corruption)
+{
+  FILE               *fp;
+  char               *contents, *first_tree;
+  long                size;
+  t8_ctree_t          tree;
+  t8_attribute_info_struct_t *info;
+
+  fp = fopen (filename, "rb");
+  SC_CHECK_ABORT (fp != NULL, "Could not open the mapped file");
+  SC_CHECK_ABORT (fseek (fp, 0, SEEK_END) == 0, "Could not seek file");
+  size = ftell (fp);
+  rewind (fp);
+  contents = T8_ALLOC (char, size);
+  SC_CHECK_ABORT (fread (contents, 1, size, fp) == (size_t) size,
+                  "Could not read the mapped file");
+  fclose (fp);
+
+  SC_CHECK_ABORT ((size_t) size >= trees_bytes, "The mapped file is short");
+  first_tree = contents + size - trees_bytes;
+  tree = (t8_ctree_t) first_tree;
+  info = T8_TREE_ATTR_INFO (tree, 0);
+  SC_CHECK_ABORT (tree->treeid == 0 && tree->num_attributes > 0,
+                  "Could not find the first tree");
+  switch (corruption) {
+  case T8_TEST_CORRUPT_FACE_NEIGHBOR:
+    ((t8_locidx_t *) T8_TREE_FACE (tree))[0] = T8_LOCIDX_MAX;
+    break;
+  case T8_TEST_CORRUPT_ATTRIBUTE_OFFSET:
+    info->attribute_offset = trees_bytes;
+    break;
+  case T8_TEST_CORRUPT_ATTRIBUTE_SIZE:
+    info->attribute_size = (size_t) -1;
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+
+  fp = fopen (corrupt_name, "wb");
+  SC_CHECK_ABORT (fp != NULL, "Could not open the corrupted file");
+  SC_CHECK_ABORT (fwrite (contents, 1, size, fp) == (size_t) size,
+                  "Could not write the corrupted file");
+  fclose (fp);
+  T8_FREE (contents);
+}
+
+/* Load mapped cmesh files whose trees point outside of the file.
+ * They must be rejected when loading instead of failing when they are
+ * used. */
+static void
+t8_test_cmesh_load_mapped_corrupt (sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh, cmesh_load;
+  int                 mpirank, mpiret, corruption;
+  const char         *filename = "test_cmesh_save_valid.t8m";
+  const char         *corrupt_name = "test_cmesh_save_corrupt.t8m";
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  t8_global_productionf ("Testing corrupted mapped cmesh files\n");
+  cmesh = t8_cmesh_new_hypercube (T8_ECLASS_QUAD, comm, 0, 0, 0);
+  SC_CHECK_ABORT (t8_cmesh_save_mapped (cmesh, filename),
+                  "Could not save the cmesh");
+  for (corruption = 0; corruption < T8_TEST_CORRUPT_COUNT; corruption++) {
+    if (mpirank == 0) {
+      t8_test_cmesh_corrupt_mapped (filename, corrupt_name,
+                                    t8_cmesh_trees_size (cmesh->trees),
+                                    corruption);
+    }
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+    cmesh_load = t8_cmesh_load_mapped (corrupt_name, comm);
+    SC_CHECK_ABORTF (cmesh_load == NULL,
+                     "Corrupted file %i was loaded", corruption);
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+  }
+  t8_cmesh_destroy (&cmesh);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_cmesh_save_parallel (mpic);
+  t8_test_cmesh_save_partitioned (mpic);
+  t8_test_cmesh_save_mapped (mpic);
+  t8_test_cmesh_load_mapped_corrupt (mpic);
+  t8_test_forest_save (mpic);
+  t8_test_forest_from_leaves (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
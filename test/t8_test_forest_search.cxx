@@ -0,0 +1,326 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* In this test we search a forest for many queries at once with
+ * t8_forest_search_queries and compare the result with a search of each
+ * leaf for all queries with t8_forest_search.
+ * A query is a descendant of a tree at a fixed level, given by its global
+ * tree id and linear id. It matches an element if it is a descendant of the
+ * element. Each query must be found in exactly one leaf on all processes.
+ * Both searches are also run with several threads. Each thread collects its
+ * own result and the merged results must equal the serial ones. */
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_iterate.h>
+#include <t8_default_cxx.hxx>
+
+/* The level of the queries, greater than the level of all leafs */
+#define T8_TEST_SEARCH_LEVEL 4
+/* The number of queries per tree */
+#define T8_TEST_SEARCH_QUERIES 10
+/* The number of threads of the threaded searches */
+#define T8_TEST_SEARCH_THREADS 4
+
+typedef struct
+{
+  t8_gloidx_t         gtreeid;
+  t8_linearidx_t      id;
+} t8_test_search_query_t;
+
+/* For each query, the number of leafs that match it and the local index of
+ * the last one */
+typedef struct
+{
+  sc_array_t         *queries;
+  int                *count;
+  t8_locidx_t        *leaf;
+} t8_test_search_result_t;
+
+static void
+t8_test_search_result_init (t8_test_search_result_t * result,
+                            sc_array_t * queries)
+{
+  size_t              iquery;
+
+  result->queries = queries;
+  result->count = T8_ALLOC_ZERO (int, queries->elem_count);
+  result->leaf = T8_ALLOC (t8_locidx_t, queries->elem_count);
+  for (iquery = 0; iquery < queries->elem_count; iquery++) {
+    result->leaf[iquery] = -1;
+  }
+}
+
+static void
+t8_test_search_result_reset (t8_test_search_result_t * result)
+{
+  T8_FREE (result->count);
+  T8_FREE (result->leaf);
+}
+
+/* Merge the results of several threads into the first one */
+static void
+t8_test_search_result_merge (t8_test_search_result_t * results,
+                             int num_threads)
+{
+  size_t              iquery;
+  int                 ithread;
+
+  for (ithread = 1; ithread < num_threads; ithread++) {
+    for (iquery = 0; iquery < results[0].queries->elem_count; iquery++) {
+      if (results[ithread].count[iquery] > 0) {
+        results[0].count[iquery] += results[ithread].count[iquery];
+        results[0].leaf[iquery] = results[ithread].leaf[iquery];
+      }
+    }
+  }
+}
+
+/* Check that two searches found the same leafs */
+static void
+t8_test_search_result_compare (t8_test_search_result_t * result_a,
+                               t8_test_search_result_t * result_b)
+{
+  size_t              iquery;
+
+  for (iquery = 0; iquery < result_a->queries->elem_count; iquery++) {
+    SC_CHECK_ABORTF (result_a->count[iquery] == result_b->count[iquery]
+                     && result_a->leaf[iquery] == result_b->leaf[iquery],
+                     "Query %li was found in different leafs.\n",
+                     (long) iquery);
+  }
+}
+
+/* Return true if a query is a descendant of an element */
+static int
+t8_test_search_match (t8_forest_t forest, t8_locidx_t ltreeid,
+                      const t8_element_t * element,
+                      const t8_test_search_query_t * query)
+{
+  t8_eclass_scheme_c *ts;
+  t8_linearidx_t      first_id, num_descendants;
+  int                 level;
+
+  if (query->gtreeid != t8_forest_global_tree_id (forest, ltreeid)) {
+    return 0;
+  }
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  level = ts->t8_element_level (element);
+  first_id = ts->t8_element_get_linear_id (element, T8_TEST_SEARCH_LEVEL);
+  num_descendants = (t8_linearidx_t) 1 <<
+    (t8_eclass_to_dimension[ts->eclass] * (T8_TEST_SEARCH_LEVEL - level));
+  return first_id <= query->id && query->id < first_id + num_descendants;
+}
+
+static void
+t8_test_search_record (t8_forest_t forest, t8_locidx_t ltreeid,
+                       t8_locidx_t tree_leaf_index, size_t iquery,
+                       t8_test_search_result_t * result)
+{
+  result->count[iquery]++;
+  result->leaf[iquery] =
+    t8_forest_get_tree_element_offset (forest, ltreeid) + tree_leaf_index;
+}
+
+/* The reference search: at each leaf we check all queries */
+static int
+t8_test_search_all_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                       const t8_element_t * element,
+                       t8_element_array_t * leaf_elements, void *user_data,
+                       t8_locidx_t tree_leaf_index)
+{
+  t8_test_search_result_t *result = (t8_test_search_result_t *) user_data;
+  size_t              iquery;
+
+  if (tree_leaf_index >= 0) {
+    for (iquery = 0; iquery < result->queries->elem_count; iquery++) {
+      if (t8_test_search_match (forest, ltreeid, element,
+                                (t8_test_search_query_t *)
+                                sc_array_index (result->queries, iquery))) {
+        t8_test_search_record (forest, ltreeid, tree_leaf_index, iquery,
+                               result);
+      }
+    }
+  }
+  return 1;
+}
+
+/* Evaluate the active queries at an element */
+static void
+t8_test_search_queries_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                           const t8_element_t * element, int is_leaf,
+                           t8_element_array_t * leaf_elements,
+                           t8_locidx_t tree_leaf_index, sc_array_t * queries,
+                           const size_t *query_indices, int *query_matches,
+                           size_t num_active_queries, void *user_data)
+{
+  t8_test_search_result_t *result = (t8_test_search_result_t *) user_data;
+  size_t              iactive;
+  int                 match;
+
+  for (iactive = 0; iactive < num_active_queries; iactive++) {
+    match = t8_test_search_match (forest, ltreeid, element,
+                                  (t8_test_search_query_t *)
+                                  sc_array_index (queries,
+                                                  query_indices[iactive]));
+    query_matches[iactive] = match;
+    if (is_leaf && match) {
+      t8_test_search_record (forest, ltreeid, tree_leaf_index,
+                             query_indices[iactive], result);
+    }
+  }
+}
+
+/* Refine some of the elements, such that the leafs have different levels */
+static int
+t8_test_search_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                      t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                      t8_eclass_scheme_c * ts, int num_elements,
+                      t8_element_t * elements[])
+{
+  return lelement_id % 3 == 0;
+}
+
+/* Create the same queries on all processes */
+static void
+t8_test_search_create_queries (t8_forest_t forest, t8_eclass_t eclass,
+                               sc_array_t * queries)
+{
+  t8_test_search_query_t *query;
+  t8_gloidx_t         itree;
+  t8_linearidx_t      num_ids;
+  int                 i;
+
+  num_ids = (t8_linearidx_t) 1 <<
+    (t8_eclass_to_dimension[eclass] * T8_TEST_SEARCH_LEVEL);
+  for (itree = 0; itree < t8_forest_get_num_global_trees (forest); itree++) {
+    for (i = 0; i < T8_TEST_SEARCH_QUERIES; i++) {
+      query = (t8_test_search_query_t *) sc_array_push (queries);
+      query->gtreeid = itree;
+      query->id = ((t8_linearidx_t) (itree * T8_TEST_SEARCH_QUERIES + i)
+                   * 2654435761u) % num_ids;
+    }
+  }
+}
+
+static void
+t8_test_search (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_forest_t         forest, forest_adapt;
+  t8_test_search_result_t result_all, result_queries;
+  t8_test_search_result_t thread_results[T8_TEST_SEARCH_THREADS];
+  void               *thread_data[T8_TEST_SEARCH_THREADS];
+  sc_array_t          queries;
+  int                *global_count;
+  size_t              iquery, num_queries;
+  int                 mpiret, ithread;
+
+  t8_debugf ("Testing the search with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  forest =
+    t8_forest_new_uniform (t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0),
+                           t8_scheme_new_default_cxx (), 2, 0, comm);
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_search_adapt, 0);
+  t8_forest_commit (forest_adapt);
+
+  sc_array_init (&queries, sizeof (t8_test_search_query_t));
+  t8_test_search_create_queries (forest_adapt, eclass, &queries);
+  num_queries = queries.elem_count;
+  t8_test_search_result_init (&result_all, &queries);
+  t8_test_search_result_init (&result_queries, &queries);
+
+  t8_forest_search (forest_adapt, t8_test_search_all_fn, &result_all);
+  t8_forest_search_queries (forest_adapt, NULL, t8_test_search_queries_fn,
+                            &queries, &result_queries);
+
+  t8_test_search_result_compare (&result_all, &result_queries);
+
+  /* Search again with threads, each of them with its own result */
+  for (ithread = 0; ithread < T8_TEST_SEARCH_THREADS; ithread++) {
+    t8_test_search_result_init (&thread_results[ithread], &queries);
+    thread_data[ithread] = &thread_results[ithread];
+  }
+  t8_forest_search_threaded (forest_adapt, t8_test_search_all_fn,
+                             thread_data, T8_TEST_SEARCH_THREADS);
+  t8_test_search_result_merge (thread_results, T8_TEST_SEARCH_THREADS);
+  t8_test_search_result_compare (&result_all, &thread_results[0]);
+  for (ithread = 0; ithread < T8_TEST_SEARCH_THREADS; ithread++) {
+    t8_test_search_result_reset (&thread_results[ithread]);
+    t8_test_search_result_init (&thread_results[ithread], &queries);
+  }
+  t8_forest_search_queries_threaded (forest_adapt, NULL,
+                                     t8_test_search_queries_fn, &queries,
+                                     thread_data, T8_TEST_SEARCH_THREADS);
+  t8_test_search_result_merge (thread_results, T8_TEST_SEARCH_THREADS);
+  t8_test_search_result_compare (&result_all, &thread_results[0]);
+  for (ithread = 0; ithread < T8_TEST_SEARCH_THREADS; ithread++) {
+    t8_test_search_result_reset (&thread_results[ithread]);
+  }
+
+  /* Each query is found once on all processes */
+  global_count = T8_ALLOC (int, num_queries);
+  mpiret = sc_MPI_Allreduce (result_queries.count, global_count,
+                             (int) num_queries, sc_MPI_INT, sc_MPI_SUM,
+                             comm);
+  SC_CHECK_MPI (mpiret);
+  for (iquery = 0; iquery < num_queries; iquery++) {
+    SC_CHECK_ABORTF (global_count[iquery] == 1,
+                     "Query %li was found %i times.\n", (long) iquery,
+                     global_count[iquery]);
+  }
+  T8_FREE (global_count);
+
+  t8_test_search_result_reset (&result_all);
+  t8_test_search_result_reset (&result_queries);
+  sc_array_reset (&queries);
+  t8_forest_unref (&forest_adapt);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 ieclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (ieclass = T8_ECLASS_LINE; ieclass < T8_ECLASS_PYRAMID; ieclass++) {
+    t8_test_search (mpic, (t8_eclass_t) ieclass);
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,148 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* In this test we partition a forest with one element, such that all but
+ * one process are idle, and let the processes with and without elements
+ * continue on their own communicators. We then adapt the forest on both
+ * groups and partition it over all processes again. The result must equal
+ * the uniform forest of the same level. On one process the communicator
+ * is never split. */
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_default_cxx.hxx>
+
+/* Refine all elements recursively up to the level in the user data */
+static int
+t8_test_shrink_comm_refine (t8_forest_t forest, t8_forest_t forest_from,
+                            t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                            t8_eclass_scheme_c * ts, int num_elements,
+                            t8_element_t * elements[])
+{
+  const int           level = *(int *) t8_forest_get_user_data (forest);
+
+  return ts->t8_element_level (elements[0]) < level;
+}
+
+/* Check that this process is in the expected group of a forest and that
+ * the group has the given size and number of elements. */
+static void
+t8_test_shrink_comm_check (t8_forest_t forest, int idle, int group_size,
+                           t8_gloidx_t num_elements)
+{
+  int                 mpisize, mpiret;
+
+  SC_CHECK_ABORT (t8_forest_is_idle (forest) == idle,
+                  "The process is in the wrong group");
+  mpiret = sc_MPI_Comm_size (t8_forest_get_mpicomm (forest), &mpisize);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (mpisize == group_size,
+                  "The communicator has the wrong size");
+  SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest) ==
+                  num_elements, "The forest has the wrong element count");
+}
+
+static void
+t8_test_shrink_comm (sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_scheme_cxx_t    *scheme;
+  t8_forest_t         forest, forest_shrunk, forest_adapt, forest_back;
+  t8_forest_t         forest_uniform;
+  t8_gloidx_t         num_elements;
+  int                 mpisize, mpiret, level, ilevel;
+  int                 idle, group_size;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  /* The communicator can only be split with a replicated cmesh */
+  cmesh = t8_cmesh_new_hypercube (T8_ECLASS_QUAD, comm, 0, 0, 0);
+  scheme = t8_scheme_new_default_cxx ();
+  /* After adapting, each process gets elements again */
+  level = SC_MAX (t8_forest_min_nonempty_level (cmesh, scheme), 1);
+  num_elements = 1;
+  for (ilevel = 0; ilevel < level; ilevel++) {
+    num_elements *= 4;
+  }
+
+  /* A forest of level 0 has one element */
+  t8_cmesh_ref (cmesh);
+  t8_scheme_cxx_ref (scheme);
+  forest = t8_forest_new_uniform (cmesh, scheme, 0, 0, comm);
+  t8_forest_init (&forest_shrunk);
+  t8_forest_set_partition (forest_shrunk, forest, 0);
+  t8_forest_set_shrink_comm (forest_shrunk, 1);
+  t8_forest_commit (forest_shrunk);
+  idle = mpisize > 1 && t8_forest_get_num_element (forest_shrunk) == 0;
+  group_size = mpisize == 1 ? 1 : idle ? mpisize - 1 : 1;
+  t8_test_shrink_comm_check (forest_shrunk, idle, group_size, idle ? 0 : 1);
+
+  /* Adapt and create ghosts on each group on its own */
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_user_data (forest_adapt, &level);
+  t8_forest_set_adapt (forest_adapt, forest_shrunk,
+                       t8_test_shrink_comm_refine, 1);
+  t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_adapt);
+  t8_test_shrink_comm_check (forest_adapt, idle, group_size,
+                             idle ? 0 : num_elements);
+
+  /* Partition over all processes again */
+  t8_forest_init (&forest_back);
+  t8_forest_set_partition (forest_back, forest_adapt, 0);
+  t8_forest_commit (forest_back);
+  t8_test_shrink_comm_check (forest_back, 0, mpisize, num_elements);
+  SC_CHECK_ABORT (t8_forest_get_num_element (forest_back) > 0,
+                  "A process has no elements after the partition");
+
+  forest_uniform = t8_forest_new_uniform (cmesh, scheme, level, 0, comm);
+  SC_CHECK_ABORT (t8_forest_is_equal (forest_back, forest_uniform),
+                  "The repartitioned forest is not uniform");
+  t8_forest_unref (&forest_back);
+  t8_forest_unref (&forest_uniform);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_shrink_comm (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,176 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_transfer.h>
+
+/* This test program checks the data transfer between two forests.
+ * We transfer the tree and the linear id of each element from a uniform
+ * forest of level 2 to a uniform forest of level 3 and back. Both forests
+ * have different partitions. We check that each pair of elements overlaps,
+ * that the data belongs to its element and that each element of level 3
+ * gets one element of level 2, while each element of level 2 gets its
+ * children. */
+
+/* The data of each element */
+typedef struct
+{
+  t8_gloidx_t         gtreeid;
+  t8_linearidx_t      id;
+} t8_test_transfer_data_t;
+
+/* Check the pairs and count them for each element of forest_to */
+static void
+t8_test_transfer_interpolate (t8_forest_t forest_to, t8_locidx_t ltreeid,
+                              t8_eclass_scheme_c * ts, size_t num_pairs,
+                              const t8_forest_transfer_pair_t * pairs,
+                              void *user_data)
+{
+  int                *counts = (int *) user_data;
+  const t8_test_transfer_data_t *data;
+  t8_element_t       *nca;
+  size_t              ipair;
+  int                 level_from, level_to;
+
+  ts->t8_element_new (1, &nca);
+  for (ipair = 0; ipair < num_pairs; ipair++) {
+    data = (const t8_test_transfer_data_t *) pairs[ipair].data_from;
+    level_from = ts->t8_element_level (pairs[ipair].element_from);
+    level_to = ts->t8_element_level (pairs[ipair].element_to);
+    SC_CHECK_ABORT (data->gtreeid
+                    == t8_forest_global_tree_id (forest_to, ltreeid)
+                    && data->id
+                    == ts->t8_element_get_linear_id (pairs[ipair].
+                                                     element_from,
+                                                     level_from),
+                    "The data does not belong to its element.\n");
+    ts->t8_element_nca (pairs[ipair].element_from, pairs[ipair].element_to,
+                        nca);
+    SC_CHECK_ABORT (ts->t8_element_level (nca)
+                    == SC_MIN (level_from, level_to),
+                    "The elements of a pair do not overlap.\n");
+    SC_CHECK_ABORT (ipair == 0 || pairs[ipair - 1].lelement_to
+                    <= pairs[ipair].lelement_to,
+                    "The pairs are not sorted.\n");
+    counts[pairs[ipair].lelement_to]++;
+  }
+  ts->t8_element_destroy (1, &nca);
+}
+
+/* Transfer the data from forest_from to forest_to and check that each
+ * element of forest_to gets num_pairs pairs */
+static void
+t8_test_transfer (t8_forest_t forest_from, t8_forest_t forest_to,
+                  int num_pairs)
+{
+  t8_test_transfer_data_t *data;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *element;
+  sc_array_t          data_from;
+  t8_locidx_t         itree, ielem, num_elements, lelement = 0;
+  int                *counts;
+
+  sc_array_init_size (&data_from, sizeof (t8_test_transfer_data_t),
+                      t8_forest_get_num_element (forest_from));
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest_from);
+       itree++) {
+    ts = t8_forest_get_eclass_scheme (forest_from,
+                                      t8_forest_get_tree_class (forest_from,
+                                                                itree));
+    for (ielem = 0;
+         ielem < t8_forest_get_tree_num_elements (forest_from, itree);
+         ielem++, lelement++) {
+      element = t8_forest_get_element_in_tree (forest_from, itree, ielem);
+      data = (t8_test_transfer_data_t *)
+        t8_sc_array_index_locidx (&data_from, lelement);
+      data->gtreeid = t8_forest_global_tree_id (forest_from, itree);
+      data->id = ts->t8_element_get_linear_id (element,
+                                               ts->t8_element_level
+                                               (element));
+    }
+  }
+
+  num_elements = t8_forest_get_num_element (forest_to);
+  counts = T8_ALLOC_ZERO (int, SC_MAX (num_elements, 1));
+  t8_forest_transfer_data (forest_from, forest_to, &data_from,
+                           t8_test_transfer_interpolate, counts);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    SC_CHECK_ABORTF (counts[ielem] == num_pairs,
+                     "Element %li has %i pairs instead of %i.\n",
+                     (long) ielem, counts[ielem], num_pairs);
+  }
+  T8_FREE (counts);
+  sc_array_reset (&data_from);
+}
+
+static void
+t8_test_forest_transfer (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_forest_t         forest_coarse, forest_fine;
+  t8_cmesh_t          cmesh;
+  t8_scheme_cxx_t    *scheme;
+
+  t8_debugf ("Testing data transfer with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  cmesh = t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0);
+  scheme = t8_scheme_new_default_cxx ();
+  t8_cmesh_ref (cmesh);
+  t8_scheme_cxx_ref (scheme);
+  forest_coarse = t8_forest_new_uniform (cmesh, scheme, 2, 0, comm);
+  forest_fine = t8_forest_new_uniform (cmesh, scheme, 3, 0, comm);
+
+  t8_test_transfer (forest_coarse, forest_fine, 1);
+  /* Quads and tets have 2^dim children */
+  t8_test_transfer (forest_fine, forest_coarse,
+                    1 << t8_eclass_to_dimension[eclass]);
+
+  t8_forest_unref (&forest_coarse);
+  t8_forest_unref (&forest_fine);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_transfer (mpic, T8_ECLASS_QUAD);
+  t8_test_forest_transfer (mpic, T8_ECLASS_TET);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,221 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest.h>
+#include <t8_forest_vtk.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test we write forests to vtu files and check that the files are
+ * written in the format that was chosen at configure time.
+ * We also write forests in the background and check that the files are
+ * the same as those written directly. If sc is configured without
+ * pthreads, the background output falls back to writing the files before
+ * it returns, which must give the same files. The background output of a
+ * forest with implicit trees creates their elements before it starts.
+ * The vtk output does not support pyramids. */
+
+/* Read the vtu file of this process into a nul-terminated string.
+ * The string must be freed with T8_FREE. */
+static char        *
+t8_test_vtk_read_file (const char *fileprefix, int mpirank)
+{
+  char                filename[BUFSIZ];
+  char               *contents;
+  FILE               *fp;
+  long                size;
+  size_t              num_read;
+
+  snprintf (filename, BUFSIZ, "%s_%04d.vtu", fileprefix, mpirank);
+  fp = fopen (filename, "rb");
+  SC_CHECK_ABORTF (fp != NULL, "Could not open file %s", filename);
+  SC_CHECK_ABORT (fseek (fp, 0, SEEK_END) == 0, "Could not seek file");
+  size = ftell (fp);
+  SC_CHECK_ABORT (size > 0, "The vtu file is empty");
+  rewind (fp);
+  contents = T8_ALLOC (char, size + 1);
+  num_read = fread (contents, 1, size, fp);
+  SC_CHECK_ABORT (num_read == (size_t) size, "Could not read file");
+  contents[size] = '\0';
+  fclose (fp);
+  return contents;
+}
+
+/* Check that a vtu file has the configured data format */
+static void
+t8_test_vtk_check_format (const char *fileprefix, int mpirank)
+{
+  char               *contents;
+
+  contents = t8_test_vtk_read_file (fileprefix, mpirank);
+  SC_CHECK_ABORT (strstr (contents, "</VTKFile>") != NULL,
+                  "The vtu file is incomplete");
+#ifdef T8_VTK_BINARY
+  SC_CHECK_ABORT (strstr (contents, "format=\"binary\"") != NULL
+                  && strstr (contents, "format=\"ascii\"") == NULL,
+                  "The vtu file is not binary");
+#else
+  SC_CHECK_ABORT (strstr (contents, "format=\"ascii\"") != NULL
+                  && strstr (contents, "format=\"binary\"") == NULL,
+                  "The vtu file is not ascii");
+#endif
+#ifdef T8_VTK_COMPRESSION
+  SC_CHECK_ABORT (strstr (contents, "compressor=\"vtkZLibDataCompressor\"")
+                  != NULL, "The vtu file is not compressed");
+#else
+  SC_CHECK_ABORT (strstr (contents, "compressor=") == NULL,
+                  "The vtu file is compressed");
+#endif
+  T8_FREE (contents);
+}
+
+/* Write a uniform forest and check the format of the vtu file */
+static void
+t8_test_vtk_format (t8_eclass_t eclass, sc_MPI_Comm comm)
+{
+  t8_forest_t         forest;
+  t8_cmesh_t          cmesh;
+  int                 mpirank, mpiret;
+  const char         *fileprefix = "test_forest_vtk_format";
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  cmesh = t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0);
+  forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), 1, 0,
+                                  comm);
+  SC_CHECK_ABORT (t8_forest_vtk_write_file (forest, fileprefix, 1, 1, 1, 1,
+                                            0, 0, NULL),
+                  "Could not write the vtu file");
+  t8_test_vtk_check_format (fileprefix, mpirank);
+  t8_forest_unref (&forest);
+}
+
+/* Write a forest with user data in the background and directly.
+ * While the background output runs, we write the forest directly, change
+ * the data and derive a new forest from the written one.
+ * If implicit is true, the trees of the forest do not store their elements
+ * until the background output starts. */
+static void
+t8_test_vtk_async (t8_eclass_t eclass, int implicit, sc_MPI_Comm comm)
+{
+  t8_forest_t         forest, forest_adapt;
+  t8_cmesh_t          cmesh;
+  t8_tree_t           tree;
+  t8_forest_vtk_async_t async;
+  t8_vtk_data_field_t data;
+  t8_locidx_t         ielem, num_elements, itree;
+  char               *contents, *contents_async;
+  int                 mpirank, mpiret;
+  const char         *fileprefix = "test_forest_vtk_sync";
+  const char         *fileprefix_async = "test_forest_vtk_async";
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  cmesh = t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0);
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, cmesh, comm);
+  t8_forest_set_scheme (forest, t8_scheme_new_default_cxx ());
+  t8_forest_set_level (forest, 2);
+  t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+  t8_forest_set_implicit_uniform (forest, implicit);
+  t8_forest_commit (forest);
+  num_elements = t8_forest_get_num_element (forest);
+  data.type = T8_VTK_SCALAR;
+  snprintf (data.description, BUFSIZ, "value");
+  data.data = T8_ALLOC (double, num_elements);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    data.data[ielem] = ielem;
+  }
+
+  async = t8_forest_vtk_write_file_async (forest, fileprefix_async, 1, 1,
+                                          1, 1, 1, 1, &data);
+  SC_CHECK_ABORT (async != NULL, "Could not start the output");
+  /* The trees store their elements before the output starts, such that
+   * reading them does not change the forest */
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    tree = t8_forest_get_tree_lazy (forest, itree);
+    SC_CHECK_ABORT ((t8_locidx_t)
+                    t8_element_array_get_count (&tree->elements) ==
+                    t8_forest_get_tree_element_count (tree),
+                    "The output did not create the elements of a tree");
+  }
+  SC_CHECK_ABORT (t8_forest_vtk_write_file (forest, fileprefix, 1, 1, 1, 1,
+                                            1, 1, &data),
+                  "Could not write the vtu file");
+  /* The output copied the data and holds a reference of the forest */
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    data.data[ielem] = -1;
+  }
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_partition (forest_adapt, forest, 0);
+  t8_forest_commit (forest_adapt);
+  SC_CHECK_ABORT (t8_forest_vtk_write_wait (&async),
+                  "The output in the background failed");
+  SC_CHECK_ABORT (async == NULL, "The output handle was not freed");
+
+  contents = t8_test_vtk_read_file (fileprefix, mpirank);
+  contents_async = t8_test_vtk_read_file (fileprefix_async, mpirank);
+  SC_CHECK_ABORT (!strcmp (contents, contents_async),
+                  "The output in the background differs");
+  T8_FREE (contents);
+  T8_FREE (contents_async);
+  T8_FREE (data.data);
+  t8_forest_unref (&forest_adapt);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, eclass;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing the vtu format with eclass %s.\n",
+                           t8_eclass_to_string[eclass]);
+    t8_test_vtk_format ((t8_eclass_t) eclass, mpic);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  t8_global_productionf ("Testing vtu output in a thread.\n");
+#else
+  t8_global_productionf ("Testing vtu output without threads.\n");
+#endif
+  for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_test_vtk_async ((t8_eclass_t) eclass, 0, mpic);
+    t8_test_vtk_async ((t8_eclass_t) eclass, 1, mpic);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
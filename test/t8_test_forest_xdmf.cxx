@@ -0,0 +1,190 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest.h>
+#include <t8_forest_xdmf.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test we write uniform forests and their global element indices
+ * with the XDMF output and check the contents of the binary files.
+ * Pyramid forests cannot be tested, since the default scheme has no
+ * pyramid elements. */
+
+/* The XDMF cell types of the element classes tested here */
+static const int    t8_test_xdmf_cell_type[T8_ECLASS_COUNT] =
+  { 1, 2, 5, 4, 9, 6, 8, 7 };
+
+/* Read a whole binary file and return its size in bytes.
+ * The contents must be freed with T8_FREE. */
+static char        *
+t8_test_xdmf_read_file (const char *filename, long *size)
+{
+  char               *contents;
+  FILE               *fp;
+
+  fp = fopen (filename, "rb");
+  SC_CHECK_ABORTF (fp != NULL, "Could not open file %s", filename);
+  SC_CHECK_ABORT (fseek (fp, 0, SEEK_END) == 0, "Could not seek file");
+  *size = ftell (fp);
+  rewind (fp);
+  contents = T8_ALLOC (char, *size + 1);
+  SC_CHECK_ABORT (fread (contents, 1, *size, fp) == (size_t) * size,
+                  "Could not read file");
+  fclose (fp);
+  return contents;
+}
+
+/* Check the mesh file of a uniform forest of one element class */
+static void
+t8_test_xdmf_check_mesh (const char *filename, t8_eclass_t eclass,
+                         t8_gloidx_t num_elements)
+{
+  char               *contents;
+  int64_t             connectivity;
+  t8_gloidx_t         ielem, point_id = 0;
+  long                size, expected_size;
+  int                 num_vertices, num_entries, ientry;
+  size_t              position;
+
+  num_vertices = t8_eclass_num_vertices[eclass];
+  num_entries = (eclass == T8_ECLASS_VERTEX || eclass == T8_ECLASS_LINE);
+  contents = t8_test_xdmf_read_file (filename, &size);
+  /* Each element has its own copy of its vertices */
+  expected_size = num_elements * num_vertices * 3 * sizeof (double)
+    + num_elements * (1 + num_entries + num_vertices) * sizeof (int64_t);
+  SC_CHECK_ABORT (size == expected_size, "Wrong size of the mesh file");
+  /* The connectivity follows the points */
+  position = num_elements * num_vertices * 3 * sizeof (double);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    memcpy (&connectivity, contents + position, sizeof (int64_t));
+    position += sizeof (int64_t);
+    SC_CHECK_ABORT (connectivity == t8_test_xdmf_cell_type[eclass],
+                    "Wrong cell type");
+    if (num_entries) {
+      memcpy (&connectivity, contents + position, sizeof (int64_t));
+      position += sizeof (int64_t);
+      SC_CHECK_ABORT (connectivity == num_vertices,
+                      "Wrong number of vertices");
+    }
+    for (ientry = 0; ientry < num_vertices; ientry++) {
+      memcpy (&connectivity, contents + position, sizeof (int64_t));
+      position += sizeof (int64_t);
+      SC_CHECK_ABORT (connectivity == point_id++, "Wrong point id");
+    }
+  }
+  T8_FREE (contents);
+}
+
+/* Check the data file that holds the global index of each element */
+static void
+t8_test_xdmf_check_data (const char *filename, t8_gloidx_t num_elements)
+{
+  char               *contents;
+  double              value;
+  t8_gloidx_t         ielem;
+  long                size;
+
+  contents = t8_test_xdmf_read_file (filename, &size);
+  SC_CHECK_ABORT (size == num_elements * (long) sizeof (double),
+                  "Wrong size of the data file");
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    memcpy (&value, contents + ielem * sizeof (double), sizeof (double));
+    SC_CHECK_ABORT (value == (double) ielem, "Wrong element data");
+  }
+  T8_FREE (contents);
+}
+
+static void
+t8_test_xdmf (t8_eclass_t eclass, sc_MPI_Comm comm)
+{
+  t8_forest_t         forest;
+  t8_cmesh_t          cmesh;
+  t8_vtk_data_field_t data;
+  t8_locidx_t         ielem, num_elements;
+  t8_gloidx_t         first_element;
+  FILE               *fp;
+  int                 mpirank, mpiret;
+  const char         *meshprefix = "test_forest_xdmf_mesh";
+  const char         *fileprefix = "test_forest_xdmf";
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  cmesh = t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0);
+  forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), 2, 0,
+                                  comm);
+  num_elements = t8_forest_get_num_element (forest);
+  first_element = t8_forest_get_first_local_element_id (forest);
+  data.type = T8_VTK_SCALAR;
+  snprintf (data.description, BUFSIZ, "element_id");
+  data.data = T8_ALLOC (double, num_elements);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    data.data[ielem] = first_element + ielem;
+  }
+
+  SC_CHECK_ABORT (t8_forest_write_xdmf_mesh (forest, meshprefix),
+                  "Could not write the xdmf mesh");
+  SC_CHECK_ABORT (t8_forest_write_xdmf_step (forest, meshprefix, fileprefix,
+                                             3, 0.5, 1, &data),
+                  "Could not write the xdmf step");
+  if (mpirank == 0) {
+    t8_test_xdmf_check_mesh ("test_forest_xdmf_mesh.bin", eclass,
+                             t8_forest_get_global_num_elements (forest));
+    t8_test_xdmf_check_data ("test_forest_xdmf_0003.bin",
+                             t8_forest_get_global_num_elements (forest));
+    fp = fopen ("test_forest_xdmf_0003.xmf", "r");
+    SC_CHECK_ABORT (fp != NULL, "The xdmf description was not written");
+    fclose (fp);
+  }
+  T8_FREE (data.data);
+  t8_forest_unref (&forest);
+  /* Wait until process 0 checked the files before they are rewritten */
+  mpiret = sc_MPI_Barrier (comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, eclass;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing xdmf output with eclass %s.\n",
+                           t8_eclass_to_string[eclass]);
+    t8_test_xdmf ((t8_eclass_t) eclass, mpic);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,173 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_cmesh_vtk.h>
+#include <t8_geometry.h>
+#include <t8_vec.h>
+
+/* In this test we build a cmesh with a curved quadrilateral of degree 2,
+ * a curved triangle of degree 3 and a hexahedron without nodes.
+ * The nodes of the curved trees are sampled from polynomials of their
+ * degree, such that the Lagrange geometry must reproduce these polynomials.
+ * The hexahedron must be mapped as by the linear geometry.
+ * We check single and batched evaluations at random reference points. */
+
+#define T8_TEST_LAGRANGE_POINTS 17
+
+/* The polynomial maps of the curved trees */
+static void
+t8_test_lagrange_map (int tree, const double ref[3], double x[3])
+{
+  const double        u = ref[0], v = ref[1];
+
+  if (tree == 0) {
+    /* Degree 2 in each coordinate */
+    x[0] = u + .25 * u * u * v * v;
+    x[1] = v - .5 * u * v;
+    x[2] = .1 * v * v;
+  }
+  else {
+    /* Total degree 3 */
+    x[0] = 2 + u + .5 * u * u * u;
+    x[1] = v - u * v * v;
+    x[2] = .1 * u * u * v;
+  }
+}
+
+/* Sample the nodes of a tree on the lattice of its degree */
+static void
+t8_test_lagrange_set_nodes (t8_cmesh_t cmesh, int tree, int degree,
+                            int simplex)
+{
+  double              ref_coords[3 * 16], coords[3 * 16];
+  int                 i, j, num_nodes = 0;
+
+  for (i = 0; i <= degree; i++) {
+    for (j = 0; j <= (simplex ? i : degree); j++) {
+      /* The reference triangle is 0 <= v <= u <= 1 */
+      ref_coords[3 * num_nodes] = i / (double) degree;
+      ref_coords[3 * num_nodes + 1] = j / (double) degree;
+      ref_coords[3 * num_nodes + 2] = 0;
+      t8_test_lagrange_map (tree, ref_coords + 3 * num_nodes,
+                            coords + 3 * num_nodes);
+      num_nodes++;
+    }
+  }
+  t8_geometry_set_tree_lagrange_nodes (cmesh, tree, degree, num_nodes,
+                                       ref_coords, coords);
+}
+
+static void
+t8_test_geometry_lagrange (sc_MPI_Comm comm)
+{
+  double              quad[12] = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0 };
+  double              triangle[9] = { 2, 0, 0, 3, 0, 0, 3, 1, 0 };
+  double              hex[24] = {
+    0, 0, 1, 1, 0, 1, 0, 1, 1, 1, 1, 1,
+    0, 0, 2, 1.5, 0, 2, 0, 1, 2.5, 1, 1, 3
+  };
+  double              abc[3 * T8_TEST_LAGRANGE_POINTS];
+  double              xyz[3 * T8_TEST_LAGRANGE_POINTS];
+  double              ref[3], x[3], y[3], xb[3];
+  t8_cmesh_t          cmesh;
+  t8_geometry_t       lagrange, linear;
+  int                 tree, ipoint, i;
+
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_tree_class (cmesh, 0, T8_ECLASS_QUAD);
+  t8_cmesh_set_tree_class (cmesh, 1, T8_ECLASS_TRIANGLE);
+  t8_cmesh_set_tree_class (cmesh, 2, T8_ECLASS_HEX);
+  t8_cmesh_set_tree_vertices (cmesh, 0, t8_get_package_id (), 0, quad, 4);
+  t8_cmesh_set_tree_vertices (cmesh, 1, t8_get_package_id (), 0, triangle,
+                              3);
+  t8_cmesh_set_tree_vertices (cmesh, 2, t8_get_package_id (), 0, hex, 8);
+  t8_test_lagrange_set_nodes (cmesh, 0, 2, 0);
+  t8_test_lagrange_set_nodes (cmesh, 1, 3, 1);
+  t8_cmesh_commit (cmesh, comm);
+
+  lagrange = t8_geometry_new_lagrange (cmesh);
+  linear = t8_geometry_new_linear (cmesh);
+  srand (0);
+  for (tree = 0; tree < 3; tree++) {
+    for (ipoint = 0; ipoint < T8_TEST_LAGRANGE_POINTS; ipoint++) {
+      for (i = 0; i < 3; i++) {
+        ref[i] = rand () / (double) RAND_MAX;
+      }
+      if (tree == 1) {
+        /* A point in the reference triangle */
+        ref[1] *= ref[0];
+        ref[2] = 0;
+      }
+      else if (tree == 0) {
+        ref[2] = 0;
+      }
+      t8_vec_batch_set (abc, T8_TEST_LAGRANGE_POINTS, ipoint, ref);
+    }
+    t8_geometry_evaluate_batch (lagrange, tree, T8_TEST_LAGRANGE_POINTS, abc,
+                                xyz);
+    for (ipoint = 0; ipoint < T8_TEST_LAGRANGE_POINTS; ipoint++) {
+      t8_vec_batch_get (abc, T8_TEST_LAGRANGE_POINTS, ipoint, ref);
+      t8_vec_batch_get (xyz, T8_TEST_LAGRANGE_POINTS, ipoint, xb);
+      t8_geometry_evaluate (lagrange, tree, ref, x);
+      if (tree < 2) {
+        t8_test_lagrange_map (tree, ref, y);
+      }
+      else {
+        t8_geometry_evaluate (linear, tree, ref, y);
+      }
+      for (i = 0; i < 3; i++) {
+        SC_CHECK_ABORT (fabs (x[i] - y[i]) < 1e-12,
+                        "Wrong coordinates of a tree");
+        SC_CHECK_ABORT (fabs (x[i] - xb[i]) < 1e-14,
+                        "Batched and single evaluation differ");
+      }
+    }
+  }
+  t8_geometry_unref (&lagrange);
+  t8_geometry_unref (&linear);
+  t8_cmesh_destroy (&cmesh);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_geometry_lagrange (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
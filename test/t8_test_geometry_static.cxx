@@ -0,0 +1,112 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_geometry_cxx.hxx>
+#include <t8_vec.h>
+
+/* In this test we create a geometry from an analytic spherical shell class
+ * and check that its batched and single point transformations through the
+ * C interface agree with the class and map the corners of the reference
+ * cube to the expected points. */
+
+#define T8_TEST_STATIC_POINTS 13
+
+/* A spherical shell between the radii given as user data.
+ * The first reference coordinate is the radius, the others are the
+ * angles. */
+struct t8_test_shell
+{
+  static void         evaluate (const void *user, t8_topidx_t which_tree,
+                                const double abc[3], double xyz[3])
+  {
+    const double       *radii = (const double *) user;
+    const double        r = radii[0] + abc[0] * (radii[1] - radii[0]);
+    const double        theta = M_PI * abc[1], phi = 2 * M_PI * abc[2];
+
+    xyz[0] = r * sin (theta) * cos (phi);
+    xyz[1] = r * sin (theta) * sin (phi);
+    xyz[2] = r * cos (theta);
+  }
+};
+
+static void
+t8_test_geometry_static ()
+{
+  double              radii[2] = { 1, 2 };
+  double              abc[3 * T8_TEST_STATIC_POINTS];
+  double              xyz[3 * T8_TEST_STATIC_POINTS];
+  double              ref[3], x[3], y[3], xb[3];
+  t8_geometry_t       geom;
+  int                 ipoint, i;
+
+  geom = t8_geometry_new_static < t8_test_shell > ("Shell", radii);
+  SC_CHECK_ABORT (t8_geometry_get_user (geom) == radii, "Wrong user data");
+  srand (0);
+  for (ipoint = 0; ipoint < T8_TEST_STATIC_POINTS; ipoint++) {
+    for (i = 0; i < 3; i++) {
+      ref[i] = rand () / (double) RAND_MAX;
+    }
+    t8_vec_batch_set (abc, T8_TEST_STATIC_POINTS, ipoint, ref);
+  }
+  t8_geometry_evaluate_batch (geom, 0, T8_TEST_STATIC_POINTS, abc, xyz);
+  for (ipoint = 0; ipoint < T8_TEST_STATIC_POINTS; ipoint++) {
+    t8_vec_batch_get (abc, T8_TEST_STATIC_POINTS, ipoint, ref);
+    t8_vec_batch_get (xyz, T8_TEST_STATIC_POINTS, ipoint, xb);
+    t8_geometry_evaluate (geom, 0, ref, x);
+    t8_test_shell::evaluate (radii, 0, ref, y);
+    for (i = 0; i < 3; i++) {
+      SC_CHECK_ABORT (fabs (x[i] - y[i]) < 1e-14 && fabs (xb[i] - y[i])
+                      < 1e-14, "Wrong coordinates of a point");
+    }
+  }
+  /* The outer north pole */
+  ref[0] = 1;
+  ref[1] = ref[2] = 0;
+  t8_geometry_evaluate (geom, 0, ref, x);
+  SC_CHECK_ABORT (fabs (x[0]) < 1e-14 && fabs (x[1]) < 1e-14
+                  && fabs (x[2] - 2) < 1e-14, "Wrong pole of the shell");
+  t8_geometry_unref (&geom);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_geometry_static ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -31,6 +31,8 @@
  * We adapt a forest and create its ghost layer. Afterwards, we
  * parse through all ghost elements and test whether the owner of an
  * element is in face the owner that is stored in the ghost layer.
+ * We also compare the lookup of ghost trees and remote processes with a
+ * linear search.
   */
 
 static int
@@ -129,6 +131,65 @@ t8_test_gao_check (t8_forest_t forest)
   }
 }
 
+/* Compare the binary searches for ghost trees and remote processes with a
+ * linear search. The first ghost element and tree of a remote process are
+ * found with the owners of the ghost elements. */
+static void
+t8_test_gao_lookup (t8_forest_t forest)
+{
+  t8_locidx_t         num_ghost_trees, itree, ielem, lelement_id;
+  t8_locidx_t         ghost_treeid, first_elem, first_tree;
+  t8_gloidx_t         gtreeid;
+  t8_element_t       *ghost_element;
+  int                 num_remotes, *remotes, iremote, owner;
+
+  remotes = t8_forest_ghost_get_remotes (forest, &num_remotes);
+  if (num_remotes == 0) {
+    return;
+  }
+  num_ghost_trees = t8_forest_ghost_num_trees (forest);
+  for (gtreeid = 0; gtreeid < t8_forest_get_num_global_trees (forest);
+       gtreeid++) {
+    ghost_treeid = -1;
+    for (itree = 0; itree < num_ghost_trees; itree++) {
+      if (t8_forest_ghost_get_global_treeid (forest, itree) == gtreeid) {
+        ghost_treeid = itree;
+      }
+    }
+    SC_CHECK_ABORT (t8_forest_ghost_get_ghost_treeid (forest, gtreeid)
+                    == ghost_treeid, "Wrong ghost tree found.\n");
+  }
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    /* Find the first ghost element of this remote process */
+    first_elem = first_tree = -1;
+    for (itree = 0, lelement_id = 0;
+         itree < num_ghost_trees && first_elem < 0; itree++) {
+      gtreeid = t8_forest_ghost_get_global_treeid (forest, itree);
+      for (ielem = 0; ielem < t8_forest_ghost_tree_num_elements (forest,
+                                                                 itree);
+           ielem++, lelement_id++) {
+        ghost_element = t8_forest_ghost_get_element (forest, itree, ielem);
+        owner = t8_forest_element_find_owner (forest, gtreeid, ghost_element,
+                                              t8_forest_ghost_get_tree_class
+                                              (forest, itree));
+        if (owner == remotes[iremote]) {
+          first_elem = lelement_id;
+          first_tree = itree;
+          break;
+        }
+      }
+    }
+    SC_CHECK_ABORT (first_elem >= 0, "A remote process has no ghosts.\n");
+    SC_CHECK_ABORT (t8_forest_ghost_remote_first_elem (forest,
+                                                       remotes[iremote])
+                    == first_elem
+                    && t8_forest_ghost_remote_first_tree (forest,
+                                                          remotes[iremote])
+                    == first_tree,
+                    "Wrong first ghost of a remote process.\n");
+  }
+}
+
 static void
 t8_test_ghost_owner ()
 {
@@ -162,12 +223,14 @@ t8_test_ghost_owner ()
                                         sc_MPI_COMM_WORLD);
         /* Check the owners of the ghost elements */
         t8_test_gao_check (forest);
+        t8_test_gao_lookup (forest);
         /* Adapt the forest and exchange data again */
         maxlevel = level + 2;
         forest_adapt =
           t8_forest_new_adapt (forest, t8_test_gao_adapt, 1, 1, &maxlevel);
         /* Check the owners of the ghost elements */
         t8_test_gao_check (forest_adapt);
+        t8_test_gao_lookup (forest_adapt);
         t8_forest_unref (&forest_adapt);
       }
       t8_cmesh_destroy (&cmesh);
@@ -24,6 +24,7 @@
 #include <t8_default_cxx.hxx>
 #include <t8_forest.h>
 #include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_ghost_device.h>
 #include <t8_forest/t8_forest_private.h>
 #include <t8_cmesh.h>
 
@@ -189,6 +190,422 @@ t8_test_ghost_exchange_data_int (t8_forest_t forest)
   sc_array_reset (&element_data);
 }
 
+/* Perform the same exchange as t8_test_ghost_exchange_data_int with
+ * begin and end. Between the two calls we overwrite the local entries,
+ * which must not change the data that the ghosts receive.
+ */
+static void
+t8_test_ghost_exchange_begin_end (t8_forest_t forest)
+{
+  sc_array_t          element_data;
+  t8_forest_ghost_exchange_t *exchange;
+  t8_locidx_t         num_elements, ielem, num_ghosts;
+  int                 ghost_int;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  sc_array_init_size (&element_data, sizeof (int), num_elements + num_ghosts);
+
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    *(int *) t8_sc_array_index_locidx (&element_data, ielem) = 42;
+  }
+  exchange = t8_forest_ghost_exchange_begin (forest, &element_data);
+  /* The local data was copied to the send buffers */
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    *(int *) t8_sc_array_index_locidx (&element_data, ielem) = -1;
+  }
+  t8_forest_ghost_exchange_end (exchange);
+
+  for (ielem = 0; ielem < num_ghosts; ielem++) {
+    ghost_int =
+      *(int *) t8_sc_array_index_locidx (&element_data, num_elements + ielem);
+    SC_CHECK_ABORT (ghost_int == 42,
+                    "Error when exchanging ghost data with begin and end."
+                    " Received wrong data.\n");
+  }
+  sc_array_reset (&element_data);
+}
+
+/* Exchange data with a ghost plan in several rounds with different values.
+ * In each round the ghosts must receive the values of that round.
+ */
+static void
+t8_test_ghost_exchange_plan (t8_forest_t forest)
+{
+  sc_array_t          element_data;
+  t8_forest_ghost_plan_t *plan;
+  t8_locidx_t         num_elements, ielem, num_ghosts;
+  int                 ghost_int, iround;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  sc_array_init_size (&element_data, sizeof (int), num_elements + num_ghosts);
+  plan = t8_forest_ghost_plan_new (forest, sizeof (int));
+
+  for (iround = 0; iround < 3; iround++) {
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      *(int *) t8_sc_array_index_locidx (&element_data, ielem) = 42 + iround;
+    }
+    t8_forest_ghost_plan_exchange (plan, &element_data);
+    for (ielem = 0; ielem < num_ghosts; ielem++) {
+      ghost_int =
+        *(int *) t8_sc_array_index_locidx (&element_data,
+                                           num_elements + ielem);
+      SC_CHECK_ABORT (ghost_int == 42 + iround,
+                      "Error when exchanging ghost data with a plan."
+                      " Received wrong data.\n");
+    }
+  }
+  t8_forest_ghost_plan_destroy (&plan);
+  sc_array_reset (&element_data);
+}
+
+/* A gather kernel on the host that is built from the device entry function
+ * and counts its calls. */
+static void
+t8_test_ghost_gather (void *send_buffer, const void *element_data,
+                      const t8_locidx_t * indices, t8_locidx_t num_indices,
+                      size_t data_size, void *user_data)
+{
+  t8_locidx_t         ientry;
+
+  for (ientry = 0; ientry < num_indices; ientry++) {
+    t8_device_ghost_gather_entry (send_buffer, element_data, indices, ientry,
+                                  data_size);
+  }
+  ++*(int *) user_data;
+}
+
+static void
+t8_test_ghost_scatter (void *ghost_data, const void *recv_buffer,
+                       size_t size, void *user_data)
+{
+  memcpy (ghost_data, recv_buffer, size);
+}
+
+/* Exchange the global element ids with a one-sided plan in several rounds
+ * and compare the ghost entries to those of a two-sided exchange.
+ * Since every element has a different value, this also checks that each
+ * process puts its data at the right position of the remote buffers.
+ */
+static void
+t8_test_ghost_exchange_plan_rma (t8_forest_t forest)
+{
+  sc_array_t          element_data, reference;
+  t8_forest_ghost_plan_t *plan;
+  t8_locidx_t         num_elements, ielem, num_ghosts;
+  t8_gloidx_t         first_id;
+  int                 iround;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  first_id = t8_forest_get_first_local_element_id (forest);
+  sc_array_init_size (&element_data, sizeof (t8_gloidx_t),
+                      num_elements + num_ghosts);
+  sc_array_init_size (&reference, sizeof (t8_gloidx_t),
+                      num_elements + num_ghosts);
+  plan = t8_forest_ghost_plan_new_rma (forest, sizeof (t8_gloidx_t));
+
+  for (iround = 0; iround < 3; iround++) {
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      *(t8_gloidx_t *) t8_sc_array_index_locidx (&element_data, ielem) =
+        *(t8_gloidx_t *) t8_sc_array_index_locidx (&reference, ielem) =
+        first_id + ielem + iround;
+    }
+    t8_forest_ghost_exchange_data (forest, &reference);
+    t8_forest_ghost_plan_exchange (plan, &element_data);
+    for (ielem = num_elements; ielem < num_elements + num_ghosts; ielem++) {
+      SC_CHECK_ABORT (*(t8_gloidx_t *)
+                      t8_sc_array_index_locidx (&element_data, ielem) ==
+                      *(t8_gloidx_t *)
+                      t8_sc_array_index_locidx (&reference, ielem),
+                      "Error when exchanging ghost data with a one-sided "
+                      "plan. Received wrong data.\n");
+    }
+  }
+  t8_forest_ghost_plan_destroy (&plan);
+  sc_array_reset (&reference);
+  sc_array_reset (&element_data);
+}
+
+/* Exchange with a device plan on the host memory and check that the
+ * gather kernel is used whenever there is data to send. */
+static void
+t8_test_ghost_exchange_plan_device (t8_forest_t forest)
+{
+  t8_forest_ghost_plan_t *plan;
+  t8_forest_ghost_kernels_t kernels;
+  t8_locidx_t         num_elements, ielem, num_ghosts;
+  int                *data, iround, num_gathers = 0, num_remotes;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  data = T8_ALLOC (int, num_elements + num_ghosts);
+  kernels.gather = t8_test_ghost_gather;
+  kernels.scatter = t8_test_ghost_scatter;
+  kernels.user_data = &num_gathers;
+  plan = t8_forest_ghost_plan_new_device (forest, sizeof (int),
+                                          &t8_device_ops_host, &kernels);
+
+  for (iround = 0; iround < 3; iround++) {
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      data[ielem] = 42 + iround;
+    }
+    t8_forest_ghost_plan_exchange_device (plan, data);
+    for (ielem = 0; ielem < num_ghosts; ielem++) {
+      SC_CHECK_ABORT (data[num_elements + ielem] == 42 + iround,
+                      "Error when exchanging ghost data with a device plan."
+                      " Received wrong data.\n");
+    }
+  }
+  (void) t8_forest_ghost_get_remotes (forest, &num_remotes);
+  SC_CHECK_ABORT (num_gathers == (num_remotes > 0 ? 3 : 0),
+                  "Error when exchanging ghost data with a device plan."
+                  " The gather kernel was not used.\n");
+  t8_forest_ghost_plan_destroy (&plan);
+  T8_FREE (data);
+}
+
+/* Exchange two fields with different element sizes at once.
+ * The first field stores the global tree id of each element as int,
+ * the second field stores the element's linear id. Together they
+ * identify the element globally, so each ghost must receive exactly
+ * the values that we compute from the ghost element itself.
+ */
+static void
+t8_test_ghost_exchange_multi (t8_forest_t forest)
+{
+  t8_eclass_scheme_c *ts;
+  sc_array_t          tree_data, id_data;
+  sc_array_t         *fields[2];
+  t8_locidx_t         num_elements, ielem, num_ghosts, itree;
+  t8_element_t       *elem;
+  t8_linearidx_t      elem_id;
+  int                 gtree;
+  size_t              array_pos = 0;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  sc_array_init_size (&tree_data, sizeof (int), num_elements + num_ghosts);
+  sc_array_init_size (&id_data, sizeof (t8_linearidx_t),
+                      num_elements + num_ghosts);
+
+  /* Fill the local entries with the global tree id and the linear id */
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    gtree = (int) t8_forest_global_tree_id (forest, itree);
+    for (ielem = 0; ielem < t8_forest_get_tree_num_elements (forest, itree);
+         ielem++) {
+      elem = t8_forest_get_element_in_tree (forest, itree, ielem);
+      elem_id = ts->t8_element_get_linear_id (elem,
+                                              ts->t8_element_level (elem));
+      *(int *) sc_array_index (&tree_data, array_pos) = gtree;
+      *(t8_linearidx_t *) sc_array_index (&id_data, array_pos) = elem_id;
+      array_pos++;
+    }
+  }
+  fields[0] = &tree_data;
+  fields[1] = &id_data;
+  t8_forest_ghost_exchange_data_multi (forest, 2, fields);
+
+  /* Check both fields of each ghost against the ghost element */
+  for (itree = 0; itree < t8_forest_get_num_ghost_trees (forest); itree++) {
+    ts =
+      t8_forest_get_eclass_scheme (forest,
+                                   t8_forest_ghost_get_tree_class (forest,
+                                                                   itree));
+    gtree = (int) t8_forest_ghost_get_global_treeid (forest, itree);
+    for (ielem = 0; ielem < t8_forest_ghost_tree_num_elements (forest, itree);
+         ielem++) {
+      elem = t8_forest_ghost_get_element (forest, itree, ielem);
+      elem_id = ts->t8_element_get_linear_id (elem,
+                                              ts->t8_element_level (elem));
+      SC_CHECK_ABORT (*(int *) sc_array_index (&tree_data, array_pos)
+                      == gtree, "Error when exchanging several fields."
+                      " Received wrong tree id.\n");
+      SC_CHECK_ABORT (*(t8_linearidx_t *) sc_array_index (&id_data,
+                                                          array_pos)
+                      == elem_id, "Error when exchanging several fields."
+                      " Received wrong element id.\n");
+      array_pos++;
+    }
+  }
+  T8_ASSERT (array_pos == (size_t) (num_elements + num_ghosts));
+  sc_array_reset (&tree_data);
+  sc_array_reset (&id_data);
+}
+
+/* Exchange a variable number of ints per element. Each local element
+ * stores n entries with value n, for n between 1 and 3. Each ghost must
+ * receive entries whose value equals their number. We exchange twice,
+ * the second time with the sizes of the first exchange.
+ */
+static void
+t8_test_ghost_exchange_varsize (t8_forest_t forest)
+{
+  sc_array_t          offsets, data;
+  t8_locidx_t         num_elements, ielem, num_ghosts;
+  size_t             *poffsets, ientry, length;
+  int                 iround;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  sc_array_init_size (&offsets, sizeof (size_t),
+                      num_elements + num_ghosts + 1);
+  poffsets = (size_t *) offsets.array;
+  poffsets[0] = 0;
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    poffsets[ielem + 1] = poffsets[ielem] + ielem % 3 + 1;
+  }
+  sc_array_init_size (&data, sizeof (int), poffsets[num_elements]);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    length = poffsets[ielem + 1] - poffsets[ielem];
+    for (ientry = poffsets[ielem]; ientry < poffsets[ielem + 1]; ientry++) {
+      *(int *) sc_array_index (&data, ientry) = (int) length;
+    }
+  }
+
+  for (iround = 0; iround < 2; iround++) {
+    t8_forest_ghost_exchange_varsize (forest, &offsets, &data, iround == 0);
+    SC_CHECK_ABORT (data.elem_count == poffsets[num_elements + num_ghosts],
+                    "Error when exchanging variable size ghost data."
+                    " Wrong data size.\n");
+    for (ielem = num_elements; ielem < num_elements + num_ghosts; ielem++) {
+      length = poffsets[ielem + 1] - poffsets[ielem];
+      SC_CHECK_ABORT (1 <= length && length <= 3,
+                      "Error when exchanging variable size ghost data."
+                      " Received wrong size.\n");
+      for (ientry = poffsets[ielem]; ientry < poffsets[ielem + 1]; ientry++) {
+        SC_CHECK_ABORT (*(int *) sc_array_index (&data, ientry) ==
+                        (int) length,
+                        "Error when exchanging variable size ghost data."
+                        " Received wrong data.\n");
+      }
+    }
+  }
+  sc_array_reset (&offsets);
+  sc_array_reset (&data);
+}
+
+/* Create a copy of a uniform forest with two ghost layers.
+ * We compute the expected ghost layer with a serial copy of the forest:
+ * starting from the local elements of this process, we visit the face
+ * neighbors twice. The visited elements that are not local must be
+ * exactly the ghosts. The data exchange must work for all of them.
+ */
+static void
+t8_test_ghost_exchange_depth (t8_forest_t forest, int ctype,
+                              t8_eclass_t eclass, int level)
+{
+  t8_forest_t         forest_depth, forest_serial;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_t       *elem, **neigh_leafs;
+  sc_array_t          front, next_front;
+  t8_locidx_t         num_serial, num_local, ielem, itree, ltree;
+  t8_locidx_t         serial_index, *neigh_indices, num_expected = 0;
+  t8_gloidx_t         first_local;
+  size_t              ifront;
+  int                *distance, *dual_faces, depth, iface, ineigh;
+  int                 num_neighs;
+
+  t8_forest_init (&forest_depth);
+  t8_forest_ref (forest);
+  t8_forest_set_copy (forest_depth, forest);
+  t8_forest_set_ghost_ext2 (forest_depth, 1, T8_GHOST_FACES, 3, 2);
+  t8_forest_commit (forest_depth);
+
+  /* The serial copy has the elements in the same order */
+  t8_scheme_cxx_ref (t8_forest_get_scheme (forest));
+  forest_serial =
+    t8_forest_new_uniform (t8_test_create_cmesh (ctype, eclass,
+                                                 sc_MPI_COMM_SELF),
+                           t8_forest_get_scheme (forest), level, 0,
+                           sc_MPI_COMM_SELF);
+  num_serial = t8_forest_get_num_element (forest_serial);
+  num_local = t8_forest_get_num_element (forest);
+  first_local = t8_forest_get_first_local_element_id (forest);
+  distance = T8_ALLOC (int, num_serial);
+  for (ielem = 0; ielem < num_serial; ielem++) {
+    distance[ielem] = -1;
+  }
+  sc_array_init (&front, sizeof (t8_locidx_t));
+  sc_array_init (&next_front, sizeof (t8_locidx_t));
+  for (ielem = 0; ielem < num_local; ielem++) {
+    distance[first_local + ielem] = 0;
+    *(t8_locidx_t *) sc_array_push (&front) = first_local + ielem;
+  }
+  for (depth = 1; depth <= 2; depth++) {
+    for (ifront = 0; ifront < front.elem_count; ifront++) {
+      serial_index = *(t8_locidx_t *) sc_array_index (&front, ifront);
+      elem = t8_forest_get_element (forest_serial, serial_index, &ltree);
+      ts = t8_forest_get_eclass_scheme (forest_serial,
+                                        t8_forest_get_tree_class
+                                        (forest_serial, ltree));
+      for (iface = 0; iface < ts->t8_element_num_faces (elem); iface++) {
+        t8_forest_leaf_face_neighbors (forest_serial, ltree, elem,
+                                       &neigh_leafs, iface, &dual_faces,
+                                       &num_neighs, &neigh_indices,
+                                       &neigh_scheme, 1);
+        for (ineigh = 0; ineigh < num_neighs; ineigh++) {
+          if (distance[neigh_indices[ineigh]] < 0) {
+            distance[neigh_indices[ineigh]] = depth;
+            *(t8_locidx_t *) sc_array_push (&next_front) =
+              neigh_indices[ineigh];
+            num_expected++;
+          }
+        }
+        if (num_neighs > 0) {
+          neigh_scheme->t8_element_destroy (num_neighs, neigh_leafs);
+          T8_FREE (neigh_indices);
+          T8_FREE (neigh_leafs);
+          T8_FREE (dual_faces);
+        }
+      }
+    }
+    sc_array_reset (&front);
+    front = next_front;
+    sc_array_init (&next_front, sizeof (t8_locidx_t));
+  }
+  sc_array_reset (&front);
+  sc_array_reset (&next_front);
+
+  if (forest->mpisize > 1) {
+    SC_CHECK_ABORT (t8_forest_get_num_ghosts (forest_depth) == num_expected,
+                    "Error when creating two ghost layers."
+                    " Wrong number of ghosts.\n");
+    /* In a uniform forest the index of an element in its tree is its
+     * linear id */
+    for (itree = 0; itree < t8_forest_get_num_ghost_trees (forest_depth);
+         itree++) {
+      ts = t8_forest_get_eclass_scheme (forest_depth,
+                                        t8_forest_ghost_get_tree_class
+                                        (forest_depth, itree));
+      ltree = (t8_locidx_t)
+        t8_forest_ghost_get_global_treeid (forest_depth, itree);
+      for (ielem = 0;
+           ielem < t8_forest_ghost_tree_num_elements (forest_depth, itree);
+           ielem++) {
+        elem = t8_forest_ghost_get_element (forest_depth, itree, ielem);
+        serial_index = t8_forest_get_tree_element_offset (forest_serial,
+                                                          ltree)
+          + (t8_locidx_t) ts->t8_element_get_linear_id (elem, level);
+        SC_CHECK_ABORT (distance[serial_index] == 1
+                        || distance[serial_index] == 2,
+                        "Error when creating two ghost layers."
+                        " Wrong ghost element.\n");
+      }
+    }
+  }
+  T8_FREE (distance);
+  t8_forest_unref (&forest_serial);
+
+  t8_test_ghost_exchange_data_int (forest_depth);
+  t8_test_ghost_exchange_data_id (forest_depth);
+  t8_forest_unref (&forest_depth);
+}
+
 static void
 t8_test_ghost_exchange ()
 {
@@ -223,6 +640,14 @@ t8_test_ghost_exchange ()
         /* exchange ghost data */
         t8_test_ghost_exchange_data_int (forest);
         t8_test_ghost_exchange_data_id (forest);
+        t8_test_ghost_exchange_begin_end (forest);
+        t8_test_ghost_exchange_plan (forest);
+        t8_test_ghost_exchange_plan_rma (forest);
+        t8_test_ghost_exchange_plan_device (forest);
+        t8_test_ghost_exchange_multi (forest);
+        t8_test_ghost_exchange_varsize (forest);
+        t8_test_ghost_exchange_depth (forest, ctype, (t8_eclass_t) eclass,
+                                      level);
         /* Adapt the forest and exchange data again */
         maxlevel = level + 2;
         forest_adapt =
@@ -0,0 +1,182 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* In this test we adapt partitioned forests with ghosts several times in a
+ * row, once updating the ghost layer incrementally and once creating it
+ * anew. The incremental update only sends the changes to the previous
+ * ghost layer, and each step builds on the ghost layer of the previous
+ * step. After each step the ghost layers must be equal.
+ * One step does not change the forest, such that all ghosts are taken
+ * from the previous ghost layer. */
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_default_cxx.hxx>
+
+#define T8_TEST_GHOST_INCREMENTAL_STEPS 4
+
+/* Refine and coarsen a few elements. The decision depends on the step,
+ * which is passed as user data. Step 2 keeps all elements. */
+static int
+t8_test_ghost_incremental_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                                 t8_locidx_t which_tree,
+                                 t8_locidx_t lelement_id,
+                                 t8_eclass_scheme_c * ts, int num_elements,
+                                 t8_element_t * elements[])
+{
+  const int           step = *(int *) t8_forest_get_user_data (forest);
+
+  if (step == 2) {
+    return 0;
+  }
+  if (num_elements > 1 && (lelement_id + step) % 11 == 0) {
+    return -1;
+  }
+  return (lelement_id + step) % 7 == 0
+    && ts->t8_element_level (elements[0]) < 5;
+}
+
+/* Adapt forest_from with a face ghost layer */
+static              t8_forest_t
+t8_test_ghost_incremental_step (t8_forest_t forest_from, int *step,
+                                int incremental)
+{
+  t8_forest_t         forest;
+
+  t8_forest_init (&forest);
+  t8_forest_set_user_data (forest, step);
+  t8_forest_set_adapt (forest, forest_from, t8_test_ghost_incremental_adapt,
+                       0);
+  t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+  t8_forest_set_ghost_incremental (forest, incremental);
+  t8_forest_commit (forest);
+  return forest;
+}
+
+/* Check that two forests with the same elements have equal ghost layers */
+static void
+t8_test_ghost_incremental_compare (t8_forest_t forest_a,
+                                   t8_forest_t forest_b)
+{
+  t8_eclass_scheme_c *ts;
+  t8_locidx_t         num_ghost_trees, itree, num_elems, ielem;
+  int                 num_remotes_a, num_remotes_b, iremote;
+  int                *remotes_a, *remotes_b;
+
+  SC_CHECK_ABORT (t8_forest_is_equal (forest_a, forest_b),
+                  "Incrementally and fully ghosted forests differ");
+  SC_CHECK_ABORT (t8_forest_get_num_ghosts (forest_a)
+                  == t8_forest_get_num_ghosts (forest_b),
+                  "Incremental and full ghost counts differ");
+  num_ghost_trees = t8_forest_get_num_ghost_trees (forest_a);
+  SC_CHECK_ABORT (num_ghost_trees == t8_forest_get_num_ghost_trees (forest_b),
+                  "Incremental and full ghost tree counts differ");
+  for (itree = 0; itree < num_ghost_trees; itree++) {
+    SC_CHECK_ABORT (t8_forest_ghost_get_global_treeid (forest_a, itree)
+                    == t8_forest_ghost_get_global_treeid (forest_b, itree),
+                    "Incremental and full ghost trees differ");
+    num_elems = t8_forest_ghost_tree_num_elements (forest_a, itree);
+    SC_CHECK_ABORT (num_elems ==
+                    t8_forest_ghost_tree_num_elements (forest_b, itree),
+                    "Incremental and full ghost trees differ");
+    ts = t8_forest_get_eclass_scheme (forest_a,
+                                      t8_forest_ghost_get_tree_class
+                                      (forest_a, itree));
+    for (ielem = 0; ielem < num_elems; ielem++) {
+      SC_CHECK_ABORT (!ts->t8_element_compare
+                      (t8_forest_ghost_get_element (forest_a, itree, ielem),
+                       t8_forest_ghost_get_element (forest_b, itree,
+                                                    ielem)),
+                      "Incremental and full ghost elements differ");
+    }
+  }
+  if (t8_forest_get_num_ghosts (forest_a) == 0) {
+    return;
+  }
+  remotes_a = t8_forest_ghost_get_remotes (forest_a, &num_remotes_a);
+  remotes_b = t8_forest_ghost_get_remotes (forest_b, &num_remotes_b);
+  SC_CHECK_ABORT (num_remotes_a == num_remotes_b,
+                  "Incremental and full remote counts differ");
+  for (iremote = 0; iremote < num_remotes_a; iremote++) {
+    SC_CHECK_ABORT (remotes_a[iremote] == remotes_b[iremote]
+                    && t8_forest_ghost_remote_first_elem (forest_a,
+                                                          remotes_a[iremote])
+                    == t8_forest_ghost_remote_first_elem (forest_b,
+                                                          remotes_b
+                                                          [iremote]),
+                    "Incremental and full remotes differ");
+  }
+}
+
+static void
+t8_test_ghost_incremental (t8_cmesh_t cmesh)
+{
+  t8_forest_t         forest_inc, forest_full;
+  int                 step;
+
+  t8_cmesh_ref (cmesh);
+  forest_inc = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (),
+                                      3, 1, sc_MPI_COMM_WORLD);
+  forest_full = forest_inc;
+  t8_forest_ref (forest_full);
+  for (step = 0; step < T8_TEST_GHOST_INCREMENTAL_STEPS; step++) {
+    forest_inc = t8_test_ghost_incremental_step (forest_inc, &step, 1);
+    forest_full = t8_test_ghost_incremental_step (forest_full, &step, 0);
+    t8_test_ghost_incremental_compare (forest_inc, forest_full);
+  }
+  t8_forest_unref (&forest_inc);
+  t8_forest_unref (&forest_full);
+  t8_cmesh_destroy (&cmesh);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 eclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing incremental ghost with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    t8_test_ghost_incremental (t8_cmesh_new_bigmesh ((t8_eclass_t) eclass,
+                                                     8, mpic));
+  }
+  t8_test_ghost_incremental (t8_cmesh_new_hypercube_hybrid (3, mpic, 0, 0));
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,174 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* In this test we create the ghost layer of partitioned forests with one
+ * and with several threads, for the balanced algorithm (ghost version 1)
+ * on uniform forests and for the top-down search (ghost version 3) on
+ * adapted forests. The ghost layers must be equal.
+ * Without OpenMP both ghost layers are created serially. */
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_default_cxx.hxx>
+
+/* Refine some of the elements, such that the forest is not balanced */
+static int
+t8_test_ghost_threads_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                             t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                             t8_eclass_scheme_c * ts, int num_elements,
+                             t8_element_t * elements[])
+{
+  return (lelement_id + which_tree) % 5 == 0;
+}
+
+/* Create a partitioned forest with ghosts from a uniform level 3 forest.
+ * For ghost version 3 we also adapt the forest. */
+static              t8_forest_t
+t8_test_ghost_threads_forest (t8_cmesh_t cmesh, int ghost_version,
+                              int num_threads)
+{
+  t8_forest_t         forest_uniform, forest;
+
+  t8_cmesh_ref (cmesh);
+  forest_uniform = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (),
+                                          3, 0, sc_MPI_COMM_WORLD);
+  t8_forest_init (&forest);
+  if (ghost_version == 3) {
+    t8_forest_set_adapt (forest, forest_uniform,
+                         t8_test_ghost_threads_adapt, 0);
+  }
+  t8_forest_set_partition (forest, ghost_version == 3 ? NULL :
+                           forest_uniform, 0);
+  t8_forest_set_ghost_ext (forest, 1, T8_GHOST_FACES, ghost_version);
+  t8_forest_set_ghost_threads (forest, num_threads);
+  t8_forest_commit (forest);
+  return forest;
+}
+
+/* Check that two forests with the same elements have equal ghost layers */
+static void
+t8_test_ghost_threads_compare (t8_forest_t forest_a, t8_forest_t forest_b)
+{
+  t8_eclass_scheme_c *ts;
+  t8_locidx_t         num_ghost_trees, itree, num_elems, ielem;
+  int                 num_remotes_a, num_remotes_b, iremote;
+  int                *remotes_a, *remotes_b;
+
+  SC_CHECK_ABORT (t8_forest_get_num_ghosts (forest_a)
+                  == t8_forest_get_num_ghosts (forest_b),
+                  "Serial and threaded ghost counts differ");
+  num_ghost_trees = t8_forest_get_num_ghost_trees (forest_a);
+  SC_CHECK_ABORT (num_ghost_trees == t8_forest_get_num_ghost_trees (forest_b),
+                  "Serial and threaded ghost tree counts differ");
+  for (itree = 0; itree < num_ghost_trees; itree++) {
+    SC_CHECK_ABORT (t8_forest_ghost_get_global_treeid (forest_a, itree)
+                    == t8_forest_ghost_get_global_treeid (forest_b, itree),
+                    "Serial and threaded ghost trees differ");
+    num_elems = t8_forest_ghost_tree_num_elements (forest_a, itree);
+    SC_CHECK_ABORT (num_elems ==
+                    t8_forest_ghost_tree_num_elements (forest_b, itree),
+                    "Serial and threaded ghost trees differ");
+    ts = t8_forest_get_eclass_scheme (forest_a,
+                                      t8_forest_ghost_get_tree_class
+                                      (forest_a, itree));
+    for (ielem = 0; ielem < num_elems; ielem++) {
+      SC_CHECK_ABORT (!ts->t8_element_compare
+                      (t8_forest_ghost_get_element (forest_a, itree, ielem),
+                       t8_forest_ghost_get_element (forest_b, itree,
+                                                    ielem)),
+                      "Serial and threaded ghost elements differ");
+    }
+  }
+  if (t8_forest_get_num_ghosts (forest_a) == 0) {
+    return;
+  }
+  remotes_a = t8_forest_ghost_get_remotes (forest_a, &num_remotes_a);
+  remotes_b = t8_forest_ghost_get_remotes (forest_b, &num_remotes_b);
+  SC_CHECK_ABORT (num_remotes_a == num_remotes_b,
+                  "Serial and threaded remote counts differ");
+  for (iremote = 0; iremote < num_remotes_a; iremote++) {
+    SC_CHECK_ABORT (remotes_a[iremote] == remotes_b[iremote]
+                    && t8_forest_ghost_remote_first_elem (forest_a,
+                                                          remotes_a[iremote])
+                    == t8_forest_ghost_remote_first_elem (forest_b,
+                                                          remotes_b
+                                                          [iremote]),
+                    "Serial and threaded remotes differ");
+  }
+}
+
+static void
+t8_test_ghost_threads (t8_cmesh_t cmesh)
+{
+  t8_forest_t         forest_serial, forest_threads;
+  const int           ghost_versions[2] = { 1, 3 };
+  int                 iversion;
+
+  for (iversion = 0; iversion < 2; iversion++) {
+    forest_serial =
+      t8_test_ghost_threads_forest (cmesh, ghost_versions[iversion], 1);
+    forest_threads =
+      t8_test_ghost_threads_forest (cmesh, ghost_versions[iversion], 4);
+    SC_CHECK_ABORT (t8_forest_is_equal (forest_serial, forest_threads),
+                    "Serial and threaded forests differ");
+    t8_test_ghost_threads_compare (forest_serial, forest_threads);
+    t8_forest_unref (&forest_serial);
+    t8_forest_unref (&forest_threads);
+  }
+  t8_cmesh_destroy (&cmesh);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 eclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  /* Meshes with several trees, such that the top-down search distributes
+   * the trees among the threads */
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing threaded ghost with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    t8_test_ghost_threads (t8_cmesh_new_bigmesh ((t8_eclass_t) eclass, 8,
+                                                 mpic));
+  }
+  t8_test_ghost_threads (t8_cmesh_new_hypercube_hybrid (3, mpic, 0, 0));
+  t8_test_ghost_threads (t8_cmesh_new_periodic (mpic, 2));
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,230 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <p4est_connectivity.h>
+#include <p8est_connectivity.h>
+
+/* In this test we build ghost layers across faces, edges and vertices of
+ * adapted forests on bricks and compare the number of ghosts with a brute
+ * force search over the bounding boxes of all elements. */
+
+/* Refine every second element up to a maximum level */
+static int
+t8_test_ghost_vertices_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                              t8_locidx_t which_tree,
+                              t8_locidx_t lelement_id,
+                              t8_eclass_scheme_c * ts, int num_elements,
+                              t8_element_t * elements[])
+{
+  int                 level;
+
+  level = ts->t8_element_level (elements[0]);
+  if (lelement_id % 2 && level < 3) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Store min and max coordinates of each local element */
+static double      *
+t8_test_ghost_vertices_boxes (t8_forest_t forest)
+{
+  t8_locidx_t         itree, ielem, num_elems, ibox = 0;
+  t8_element_t       *elem;
+  t8_eclass_scheme_c *ts;
+  double             *boxes, *vertices, coords[3];
+  int                 icorner, idim;
+
+  boxes = T8_ALLOC (double, 6 * SC_MAX (1,
+                                        t8_forest_get_num_element (forest)));
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    vertices = t8_forest_get_tree_vertices (forest, itree);
+    num_elems = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielem = 0; ielem < num_elems; ielem++, ibox++) {
+      elem = t8_forest_get_element_in_tree (forest, itree, ielem);
+      for (icorner = 0; icorner < ts->t8_element_num_corners (elem);
+           icorner++) {
+        t8_forest_element_coordinate (forest, itree, elem, vertices,
+                                      icorner, coords);
+        for (idim = 0; idim < 3; idim++) {
+          if (icorner == 0 || coords[idim] < boxes[6 * ibox + idim]) {
+            boxes[6 * ibox + idim] = coords[idim];
+          }
+          if (icorner == 0 || coords[idim] > boxes[6 * ibox + 3 + idim]) {
+            boxes[6 * ibox + 3 + idim] = coords[idim];
+          }
+        }
+      }
+    }
+  }
+  return boxes;
+}
+
+/* Return true if the boxes intersect in a set of dimension at least
+ * min_dim */
+static int
+t8_test_ghost_vertices_touch (const double *box_a, const double *box_b,
+                              int min_dim)
+{
+  double              overlap;
+  int                 idim, contact_dim = 0;
+
+  for (idim = 0; idim < 3; idim++) {
+    overlap = SC_MIN (box_a[3 + idim], box_b[3 + idim])
+      - SC_MAX (box_a[idim], box_b[idim]);
+    if (overlap < -1e-10) {
+      return 0;
+    }
+    contact_dim += overlap > 1e-10;
+  }
+  return contact_dim >= min_dim;
+}
+
+static void
+t8_test_ghost_vertices_check (t8_forest_t forest, t8_ghost_type_t type,
+                              int dim, sc_MPI_Comm comm)
+{
+  double             *boxes, *all_boxes;
+  int                *counts, *displs;
+  int                 mpisize, mpirank, mpiret, iproc, min_dim;
+  t8_locidx_t         num_elems, ibox, iother, num_ghosts;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  min_dim = dim - (type == T8_GHOST_FACES ? 1 :
+                   type == T8_GHOST_EDGES ? 2 : 3);
+
+  /* Gather the boxes of all elements */
+  num_elems = t8_forest_get_num_element (forest);
+  boxes = t8_test_ghost_vertices_boxes (forest);
+  counts = T8_ALLOC (int, mpisize);
+  displs = T8_ALLOC (int, mpisize + 1);
+  num_elems *= 6;
+  mpiret = sc_MPI_Allgather (&num_elems, 1, sc_MPI_INT, counts, 1,
+                             sc_MPI_INT, comm);
+  SC_CHECK_MPI (mpiret);
+  num_elems /= 6;
+  displs[0] = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    displs[iproc + 1] = displs[iproc] + counts[iproc];
+  }
+  all_boxes = T8_ALLOC (double, SC_MAX (1, displs[mpisize]));
+  mpiret = sc_MPI_Allgatherv (boxes, 6 * num_elems, sc_MPI_DOUBLE,
+                              all_boxes, counts, displs, sc_MPI_DOUBLE,
+                              comm);
+  SC_CHECK_MPI (mpiret);
+
+  /* Count the elements of other processes that touch a local element */
+  num_ghosts = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    if (iproc == mpirank) {
+      continue;
+    }
+    for (iother = displs[iproc] / 6; iother < displs[iproc + 1] / 6;
+         iother++) {
+      for (ibox = 0; ibox < num_elems; ibox++) {
+        if (t8_test_ghost_vertices_touch (boxes + 6 * ibox,
+                                          all_boxes + 6 * iother,
+                                          min_dim)) {
+          num_ghosts++;
+          break;
+        }
+      }
+    }
+  }
+  SC_CHECK_ABORTF (num_ghosts == t8_forest_get_num_ghosts (forest),
+                   "Wrong number of ghosts %i, expected %i.",
+                   t8_forest_get_num_ghosts (forest), num_ghosts);
+
+  T8_FREE (all_boxes);
+  T8_FREE (displs);
+  T8_FREE (counts);
+  T8_FREE (boxes);
+}
+
+static void
+t8_test_ghost_vertices (t8_cmesh_t cmesh, int dim, sc_MPI_Comm comm)
+{
+  t8_forest_t         forest_uniform, forest;
+  int                 type;
+
+  forest_uniform = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (),
+                                          1, 0, comm);
+  for (type = T8_GHOST_FACES; type <= T8_GHOST_VERTICES; type++) {
+    t8_global_productionf ("Testing ghost type %i.\n", type);
+    t8_forest_ref (forest_uniform);
+    t8_forest_init (&forest);
+    t8_forest_set_adapt (forest, forest_uniform,
+                         t8_test_ghost_vertices_adapt, 1);
+    t8_forest_set_partition (forest, NULL, 0);
+    t8_forest_set_ghost (forest, 1, (t8_ghost_type_t) type);
+    t8_forest_commit (forest);
+    t8_test_ghost_vertices_check (forest, (t8_ghost_type_t) type, dim,
+                                  comm);
+    t8_forest_unref (&forest);
+  }
+  t8_forest_unref (&forest_uniform);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         comm;
+  p4est_connectivity_t *brick;
+  p8est_connectivity_t *brick3;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  comm = sc_MPI_COMM_WORLD;
+  sc_init (comm, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing quad ghosts.\n");
+  brick = p4est_connectivity_new_brick (3, 2, 0, 0);
+  t8_test_ghost_vertices (t8_cmesh_new_from_p4est (brick, comm, 0), 2, comm);
+  p4est_connectivity_destroy (brick);
+
+  t8_global_productionf ("Testing hex ghosts.\n");
+  brick3 = p8est_connectivity_new_brick (2, 2, 2, 0, 0, 0);
+  t8_test_ghost_vertices (t8_cmesh_new_from_p8est (brick3, comm, 0), 3,
+                          comm);
+  p8est_connectivity_destroy (brick3);
+  t8_global_productionf ("Done testing ghosts across vertices.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -29,6 +29,9 @@
 #include <t8_cmesh/t8_cmesh_offset.h>
 #include <t8_forest/t8_forest_partition.h>
 #include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_iterate.h>
+#include <algorithm>
+#include <vector>
 
 #if 0
 /* Depending on an integer i create a different cmesh.
@@ -142,6 +145,385 @@ t8_test_half_neighbors (sc_MPI_Comm comm, t8_eclass_t eclass)
   }
 }
 
+/* Refine every third element of a tree once */
+static int
+t8_test_face_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                    t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                    t8_eclass_scheme_c * ts, int num_elements,
+                    t8_element_t * elements[])
+{
+  return lelement_id % 3 == 0;
+}
+
+/* Build a balanced forest with ghosts on the hypercube that has hanging
+ * faces. The elements have level 2 and 3. */
+static              t8_forest_t
+t8_test_face_new_forest (sc_MPI_Comm comm, t8_eclass_t eclass,
+                         int do_face_connectivity)
+{
+  t8_forest_t         forest, forest_adapt;
+
+  forest =
+    t8_forest_new_uniform (t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0),
+                           t8_scheme_new_default_cxx (), 2, 0, comm);
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_face_adapt, 0);
+  t8_forest_commit (forest_adapt);
+  t8_forest_init (&forest);
+  t8_forest_set_balance (forest, forest_adapt, 0);
+  t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+  t8_forest_set_face_connectivity (forest, do_face_connectivity);
+  t8_forest_commit (forest);
+  return forest;
+}
+
+/* Check that the table stores element at its face as a neighbor of the
+ * local leaf neighbor at its face dual_face. */
+static void
+t8_test_face_connectivity_symmetric (t8_forest_t forest, t8_locidx_t element,
+                                     int face, t8_locidx_t neighbor,
+                                     int dual_face)
+{
+  const t8_locidx_t  *neighbors;
+  const int          *dual_faces;
+  t8_locidx_t         num_neighbors, ineigh;
+
+  num_neighbors =
+    t8_forest_get_face_connectivity_neighbors (forest, neighbor, dual_face,
+                                               &neighbors, &dual_faces, NULL);
+  for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+    if (neighbors[ineigh] == element) {
+      SC_CHECK_ABORTF (dual_faces[ineigh] == face,
+                       "Element %li is stored at the wrong face of its"
+                       " neighbor %li.\n", (long) element, (long) neighbor);
+      return;
+    }
+  }
+  SC_ABORTF ("Element %li is not a neighbor of its neighbor %li.\n",
+             (long) element, (long) neighbor);
+}
+
+/* Build the face connectivity table of a forest with hanging faces and
+ * check its entries independently of t8_forest_leaf_face_neighbors, which
+ * builds it. Each neighbor relation must be stored from both sides, a
+ * face has one neighbor or as many as the face has children and each
+ * local neighbor leaf must be the same size face neighbor of the element,
+ * its parent or one of its children. */
+static void
+t8_test_face_connectivity (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_forest_t         forest;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_t       *element, *face_neighbor, *neigh_leaf, *parent;
+  t8_locidx_t         itree, ielement, lelement, num_cached, num_elements;
+  t8_locidx_t         neigh_tree, ineigh;
+  t8_gloidx_t         gneigh_tree, num_hanging = 0, global_hanging;
+  const t8_locidx_t  *cached_neighbors;
+  const int          *cached_dual_faces;
+  int                 face, dual_face, level, neigh_level, orientation;
+  int                 mpiret;
+
+  t8_debugf ("Testing the face connectivity with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  forest = t8_test_face_new_forest (comm, eclass, 1);
+  num_elements = t8_forest_get_num_element (forest);
+
+  lelement = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    for (ielement = 0;
+         ielement < t8_forest_get_tree_num_elements (forest, itree);
+         ielement++, lelement++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielement);
+      level = ts->t8_element_level (element);
+      for (face = 0; face < ts->t8_element_num_faces (element); face++) {
+        num_cached =
+          t8_forest_get_face_connectivity_neighbors (forest, lelement, face,
+                                                     &cached_neighbors,
+                                                     &cached_dual_faces,
+                                                     &orientation);
+        SC_CHECK_ABORTF (num_cached <= 1
+                         || num_cached ==
+                         ts->t8_element_num_face_children (element, face),
+                         "Wrong number of cached neighbors at face %i"
+                         " of element %li.\n", face, (long) lelement);
+        num_hanging += num_cached > 1;
+        if (num_cached == 0) {
+          continue;
+        }
+        /* Compute the same size face neighbor */
+        neigh_scheme =
+          t8_forest_get_eclass_scheme (forest,
+                                       t8_forest_element_neighbor_eclass
+                                       (forest, itree, element, face));
+        neigh_scheme->t8_element_new (1, &face_neighbor);
+        neigh_scheme->t8_element_new (1, &parent);
+        gneigh_tree =
+          t8_forest_element_face_neighbor (forest, itree, element,
+                                           face_neighbor, neigh_scheme, face,
+                                           &dual_face);
+        SC_CHECK_ABORT (gneigh_tree >= 0, "Cached neighbor at the domain"
+                        " boundary.\n");
+        for (ineigh = 0; ineigh < num_cached; ineigh++) {
+          if (cached_neighbors[ineigh] >= num_elements) {
+            /* We only check local neighbors */
+            continue;
+          }
+          t8_test_face_connectivity_symmetric (forest, lelement, face,
+                                               cached_neighbors[ineigh],
+                                               cached_dual_faces[ineigh]);
+          neigh_leaf = t8_forest_get_element (forest,
+                                              cached_neighbors[ineigh],
+                                              &neigh_tree);
+          SC_CHECK_ABORT (t8_forest_global_tree_id (forest, neigh_tree)
+                          == gneigh_tree, "Cached neighbor in the wrong"
+                          " tree.\n");
+          neigh_level = neigh_scheme->t8_element_level (neigh_leaf);
+          if (neigh_level == level) {
+            SC_CHECK_ABORT (num_cached == 1
+                            && cached_dual_faces[ineigh] == dual_face
+                            && !neigh_scheme->t8_element_compare
+                            (neigh_leaf, face_neighbor),
+                            "Wrong cached neighbor of the same level.\n");
+          }
+          else if (neigh_level == level - 1) {
+            neigh_scheme->t8_element_parent (face_neighbor, parent);
+            SC_CHECK_ABORT (num_cached == 1
+                            && !neigh_scheme->t8_element_compare
+                            (neigh_leaf, parent),
+                            "Wrong cached coarser neighbor.\n");
+          }
+          else {
+            SC_CHECK_ABORT (neigh_level == level + 1, "Cached neighbor of a"
+                            " wrong level.\n");
+            neigh_scheme->t8_element_parent (neigh_leaf, parent);
+            SC_CHECK_ABORT (!neigh_scheme->t8_element_compare
+                            (parent, face_neighbor),
+                            "Wrong cached finer neighbor.\n");
+          }
+        }
+        neigh_scheme->t8_element_destroy (1, &face_neighbor);
+        neigh_scheme->t8_element_destroy (1, &parent);
+      }
+    }
+  }
+  /* Make sure that we tested hanging faces */
+  mpiret = sc_MPI_Allreduce (&num_hanging, &global_hanging, 1,
+                             T8_MPI_GLOIDX, sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (eclass == T8_ECLASS_LINE || global_hanging > 0,
+                  "The forest has no hanging faces.\n");
+  t8_forest_unref (&forest);
+}
+
+/* Count the visits of each face of the local leafs */
+static void
+t8_test_unique_faces_count (t8_forest_t forest, t8_locidx_t ltreeid,
+                            const t8_element_t * element,
+                            t8_locidx_t lelement, int face,
+                            t8_eclass_scheme_c * neigh_scheme,
+                            int num_neighbors, t8_element_t ** neighbors,
+                            const t8_locidx_t * neigh_indices,
+                            const int *dual_faces, void *user_data)
+{
+  int                *visits = (int *) user_data;
+  int                 ineigh, level;
+
+  /* A hanging face between two local leafs is visited from the coarse
+   * leaf */
+  level = t8_forest_get_eclass_scheme (forest,
+                                       t8_forest_get_tree_class (forest,
+                                                                 ltreeid))
+    ->t8_element_level (element);
+  for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+    SC_CHECK_ABORTF (neigh_indices[ineigh] >= t8_forest_get_num_element
+                     (forest)
+                     || neigh_scheme->t8_element_level (neighbors[ineigh])
+                     >= level, "Face %i of element %li is visited from the"
+                     " fine side.\n", face, (long) lelement);
+    SC_CHECK_ABORT (num_neighbors == 1
+                    || neigh_scheme->t8_element_level (neighbors[ineigh])
+                    == level + 1, "Wrong neighbors at a hanging face.\n");
+  }
+  visits[lelement * T8_ECLASS_MAX_FACES + face]++;
+  for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+    if (neigh_indices[ineigh] < t8_forest_get_num_element (forest)) {
+      visits[neigh_indices[ineigh] * T8_ECLASS_MAX_FACES +
+             dual_faces[ineigh]]++;
+    }
+  }
+}
+
+/* Check that the unique face iteration visits each face of each local
+ * leaf exactly once, either from the leaf or from its neighbor. The forest
+ * has hanging faces, which must be visited from the coarse leaf. */
+static void
+t8_test_unique_faces (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_forest_t         forest;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *element;
+  t8_locidx_t         itree, ielement, lelement;
+  int                *visits;
+  int                 face;
+
+  t8_debugf ("Testing the unique face iteration with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  forest = t8_test_face_new_forest (comm, eclass, 0);
+  visits = T8_ALLOC_ZERO (int, t8_forest_get_num_element (forest) *
+                          T8_ECLASS_MAX_FACES);
+  t8_forest_iterate_unique_faces (forest, t8_test_unique_faces_count, visits);
+
+  lelement = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    for (ielement = 0;
+         ielement < t8_forest_get_tree_num_elements (forest, itree);
+         ielement++, lelement++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielement);
+      for (face = 0; face < ts->t8_element_num_faces (element); face++) {
+        SC_CHECK_ABORTF (visits[lelement * T8_ECLASS_MAX_FACES + face] == 1,
+                         "Face %i of element %li was visited %i times.\n",
+                         face, (long) lelement,
+                         visits[lelement * T8_ECLASS_MAX_FACES + face]);
+      }
+    }
+  }
+  T8_FREE (visits);
+  t8_forest_unref (&forest);
+}
+
+/* Sort the entries of each row of a graph */
+static void
+t8_test_dual_graph_sort (t8_locidx_t num_rows, const t8_locidx_t * xadj,
+                         t8_gloidx_t * adjncy)
+{
+  t8_locidx_t         irow;
+
+  for (irow = 0; irow < num_rows; irow++) {
+    std::sort (adjncy + xadj[irow], adjncy + xadj[irow + 1]);
+  }
+}
+
+/* Build the dual graph of a forest with hanging faces with and without the
+ * face connectivity table and compare both with a graph that we build from
+ * t8_forest_leaf_face_neighbors. The weights of the edges of an element
+ * must sum up to the area of its faces that are not at the boundary. */
+static void
+t8_test_dual_graph (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_forest_t         forest, forest_table;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_t       *element, **neighbor_leafs;
+  t8_locidx_t         itree, ielement, lelement, num_elements, num_ghosts;
+  t8_locidx_t        *xadj, *xadj_table, *element_indices, ientry;
+  t8_gloidx_t        *adjncy, *adjncy_table, *global_ids, first_id;
+  t8_gloidx_t         neighbor;
+  sc_array_t          ids;
+  std::vector < t8_gloidx_t > ref_adjncy;
+  std::vector < t8_locidx_t > ref_xadj;
+  double             *adjwgt, *adjwgt_table, *vertices, area, weight;
+  int                 face, num_neighbors, ineigh, *dual_faces;
+
+  t8_debugf ("Testing the dual graph with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  forest = t8_test_face_new_forest (comm, eclass, 0);
+  forest_table = t8_test_face_new_forest (comm, eclass, 1);
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+
+  t8_forest_build_dual_graph (forest, 1, &xadj, &adjncy, &adjwgt);
+  t8_forest_build_dual_graph (forest_table, 1, &xadj_table, &adjncy_table,
+                              &adjwgt_table);
+
+  /* The global ids of all local elements and ghosts */
+  first_id = t8_forest_get_first_local_element_id (forest);
+  sc_array_init_size (&ids, sizeof (t8_gloidx_t), num_elements + num_ghosts);
+  global_ids = (t8_gloidx_t *) ids.array;
+  for (lelement = 0; lelement < num_elements; lelement++) {
+    global_ids[lelement] = first_id + lelement;
+  }
+  if (forest->ghosts != NULL) {
+    t8_forest_ghost_exchange_data (forest, &ids);
+  }
+
+  lelement = 0;
+  ref_xadj.push_back (0);
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    vertices = t8_forest_get_tree_vertices (forest, itree);
+    for (ielement = 0;
+         ielement < t8_forest_get_tree_num_elements (forest, itree);
+         ielement++, lelement++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielement);
+      area = 0;
+      for (face = 0; face < ts->t8_element_num_faces (element); face++) {
+        t8_forest_leaf_face_neighbors (forest, itree, element,
+                                       &neighbor_leafs, face, &dual_faces,
+                                       &num_neighbors, &element_indices,
+                                       &neigh_scheme, 1);
+        for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+          neighbor = global_ids[element_indices[ineigh]];
+          if (neighbor != first_id + lelement
+              && std::find (ref_adjncy.begin () + ref_xadj.back (),
+                            ref_adjncy.end (), neighbor)
+              == ref_adjncy.end ()) {
+            ref_adjncy.push_back (neighbor);
+          }
+        }
+        if (num_neighbors > 0) {
+          area += t8_forest_element_face_area (forest, itree, element, face,
+                                               vertices);
+          neigh_scheme->t8_element_destroy (num_neighbors, neighbor_leafs);
+          T8_FREE (element_indices);
+          T8_FREE (neighbor_leafs);
+          T8_FREE (dual_faces);
+        }
+      }
+      ref_xadj.push_back ((t8_locidx_t) ref_adjncy.size ());
+      SC_CHECK_ABORTF (xadj[lelement + 1] == ref_xadj.back ()
+                       && xadj_table[lelement + 1] == ref_xadj.back (),
+                       "Wrong number of neighbors of element %li.\n",
+                       (long) lelement);
+      weight = 0;
+      for (ientry = xadj[lelement]; ientry < xadj[lelement + 1]; ientry++) {
+        weight += adjwgt[ientry];
+        SC_CHECK_ABORTF (fabs (adjwgt[ientry] - adjwgt_table[ientry])
+                         < 1e-12, "Wrong edge weight of element %li.\n",
+                         (long) lelement);
+      }
+      SC_CHECK_ABORTF (fabs (weight - area) < 1e-10 * SC_MAX (area, 1),
+                       "Wrong sum of the edge weights of element %li.\n",
+                       (long) lelement);
+    }
+  }
+  /* Compare the neighbors independently of their order */
+  t8_test_dual_graph_sort (num_elements, xadj, adjncy);
+  t8_test_dual_graph_sort (num_elements, xadj_table, adjncy_table);
+  t8_test_dual_graph_sort (num_elements, ref_xadj.data (), ref_adjncy.data ());
+  for (ientry = 0; ientry < xadj[num_elements]; ientry++) {
+    SC_CHECK_ABORT (adjncy[ientry] == ref_adjncy[ientry]
+                    && adjncy_table[ientry] == ref_adjncy[ientry],
+                    "Wrong neighbor in the dual graph.\n");
+  }
+
+  sc_array_reset (&ids);
+  T8_FREE (xadj);
+  T8_FREE (adjncy);
+  T8_FREE (adjwgt);
+  T8_FREE (xadj_table);
+  T8_FREE (adjncy_table);
+  T8_FREE (adjwgt_table);
+  t8_forest_unref (&forest);
+  t8_forest_unref (&forest_table);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -162,6 +544,9 @@ main (int argc, char **argv)
       /* TODO: activate prism test as soon as prism can create a uniform forest. */
       /* TODO: does not work with pyramids yet */
       t8_test_half_neighbors (mpic, (t8_eclass_t) ieclass);
+      t8_test_face_connectivity (mpic, (t8_eclass_t) ieclass);
+      t8_test_unique_faces (mpic, (t8_eclass_t) ieclass);
+      t8_test_dual_graph (mpic, (t8_eclass_t) ieclass);
     }
   }
   sc_finalize ();
@@ -0,0 +1,248 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* This test program checks the linear id computation of the default
+ * element schemes.
+ * For each element class and each id of a uniform refinement of small
+ * levels we construct the element with this id and check that computing
+ * its id yields the original id, that its successor has the next id and
+ * that the batched versions of the id, level, child id and vertex
+ * computations yield the same values as the scalar ones and that
+ * initializing a range of ids yields the same elements.
+ * All checks are repeated for the Hilbert scheme, for which we additionally
+ * check that consecutive elements are face neighbors.
+ */
+
+#include <t8_eclass.h>
+#include <t8_element_cxx.hxx>
+#include <t8_default_cxx.hxx>
+#include <t8_data/t8_containers.h>
+
+static void
+t8_test_linear_id_level (t8_eclass_scheme_c * ts, t8_eclass_t eclass,
+                         int level)
+{
+  t8_element_array_t  elements;
+  t8_element_t       *elem, *succ;
+  t8_linearidx_t      id, num_elements, *ids;
+  const int           dim = t8_eclass_to_dimension[eclass];
+
+  num_elements = t8_eclass_count_leaf (eclass, level);
+  t8_element_array_init_size (&elements, ts, num_elements);
+  ts->t8_element_new (1, &succ);
+  for (id = 0; id < num_elements; id++) {
+    elem = t8_element_array_index_locidx (&elements, id);
+    ts->t8_element_set_linear_id (elem, level, id);
+    SC_CHECK_ABORTF (ts->t8_element_get_linear_id (elem, level) == id,
+                     "Wrong linear id for %s at level %i\n",
+                     t8_eclass_to_string[eclass], level);
+    /* The first descendant two levels finer has the id shifted by two levels */
+    if (level + 2 <= ts->t8_element_maxlevel ()) {
+      SC_CHECK_ABORTF (ts->t8_element_get_linear_id (elem, level + 2) ==
+                       id << (2 * dim),
+                       "Wrong descendant id for %s at level %i\n",
+                       t8_eclass_to_string[eclass], level);
+    }
+    if (id + 1 < num_elements) {
+      ts->t8_element_successor (elem, succ, level);
+      SC_CHECK_ABORTF (ts->t8_element_get_linear_id (succ, level) == id + 1,
+                       "Wrong successor id for %s at level %i\n",
+                       t8_eclass_to_string[eclass], level);
+    }
+  }
+  /* Check the batched version */
+  ids = T8_ALLOC (t8_linearidx_t, num_elements);
+  ts->t8_element_get_linear_id_array (t8_element_array_get_data (&elements),
+                                      num_elements, level, ids);
+  for (id = 0; id < num_elements; id++) {
+    SC_CHECK_ABORTF (ids[id] == id,
+                     "Wrong batched linear id for %s at level %i\n",
+                     t8_eclass_to_string[eclass], level);
+  }
+  T8_FREE (ids);
+  /* Check the other batched queries against the scalar versions */
+  {
+    int                *levels, *child_ids, *coords;
+    int                 vertex, num_vertices, coord[3], idim;
+    t8_element_t       *first;
+
+    first = (t8_element_t *) t8_element_array_get_data (&elements);
+    levels = T8_ALLOC (int, num_elements);
+    child_ids = T8_ALLOC (int, num_elements);
+    coords = T8_ALLOC (int, T8_ECLASS_MAX_DIM * num_elements);
+    ts->t8_element_level_array (first, num_elements, levels);
+    ts->t8_element_child_id_array (first, num_elements, child_ids);
+    num_vertices = t8_eclass_num_vertices[eclass];
+    for (vertex = 0; vertex < num_vertices; vertex++) {
+      ts->t8_element_vertex_coords_array (first, num_elements, vertex,
+                                          coords);
+      for (id = 0; id < num_elements; id++) {
+        elem = t8_element_array_index_locidx (&elements, id);
+        ts->t8_element_vertex_coords (elem, vertex, coord);
+        for (idim = 0; idim < dim; idim++) {
+          SC_CHECK_ABORTF (coords[T8_ECLASS_MAX_DIM * id + idim] ==
+                           coord[idim],
+                           "Wrong batched vertex coordinates for %s at "
+                           "level %i\n", t8_eclass_to_string[eclass], level);
+        }
+      }
+    }
+    for (id = 0; id < num_elements; id++) {
+      elem = t8_element_array_index_locidx (&elements, id);
+      SC_CHECK_ABORTF (levels[id] == ts->t8_element_level (elem),
+                       "Wrong batched level for %s at level %i\n",
+                       t8_eclass_to_string[eclass], level);
+      SC_CHECK_ABORTF (child_ids[id] == ts->t8_element_child_id (elem),
+                       "Wrong batched child id for %s at level %i\n",
+                       t8_eclass_to_string[eclass], level);
+    }
+    T8_FREE (coords);
+    T8_FREE (child_ids);
+    T8_FREE (levels);
+  }
+  /* Check that the range initialization produces the same elements */
+  {
+    t8_element_array_t  range;
+
+    t8_element_array_init_size (&range, ts, num_elements);
+    ts->t8_element_set_linear_id_range (t8_element_array_get_data (&range),
+                                        num_elements, level, 0);
+    for (id = 0; id < num_elements; id++) {
+      SC_CHECK_ABORTF (!ts->t8_element_compare
+                       (t8_element_array_index_locidx (&elements, id),
+                        t8_element_array_index_locidx (&range, id)),
+                       "Wrong element in linear id range for %s at level %i\n",
+                       t8_eclass_to_string[eclass], level);
+    }
+    t8_element_array_reset (&range);
+  }
+  ts->t8_element_destroy (1, &succ);
+  t8_element_array_reset (&elements);
+}
+
+/* Check that consecutive elements along the Hilbert curve share a face and
+ * that the children are consistent with the curve order. */
+static void
+t8_test_hilbert_level (t8_eclass_scheme_c * ts, t8_eclass_t eclass,
+                       int level)
+{
+  t8_element_t       *elem, *parent, *children[8];
+  t8_linearidx_t      id, first_child_id;
+  const int           dim = t8_eclass_to_dimension[eclass];
+  const int           num_children = 1 << dim;
+  int                 coords[3], prev_coords[3], idim, dist, ichild, len;
+
+  ts->t8_element_new (1, &elem);
+  ts->t8_element_new (1, &parent);
+  ts->t8_element_new (num_children, children);
+  len = ts->t8_element_root_len (elem) >> level;
+  for (id = 0; id < t8_eclass_count_leaf (eclass, level); id++) {
+    ts->t8_element_set_linear_id (elem, level, id);
+    ts->t8_element_anchor (elem, coords);
+    if (id > 0) {
+      for (idim = 0, dist = 0; idim < dim; idim++) {
+        dist += abs (coords[idim] - prev_coords[idim]);
+      }
+      SC_CHECK_ABORTF (dist == len,
+                       "Consecutive %s elements at level %i are not "
+                       "face neighbors\n", t8_eclass_to_string[eclass],
+                       level);
+    }
+    for (idim = 0; idim < 3; idim++) {
+      prev_coords[idim] = coords[idim];
+    }
+    if (level + 1 > ts->t8_element_maxlevel ()) {
+      continue;
+    }
+    ts->t8_element_children (elem, num_children, children);
+    SC_CHECK_ABORT (ts->t8_element_is_family (children),
+                    "Children are not a family");
+    first_child_id = id << dim;
+    for (ichild = 0; ichild < num_children; ichild++) {
+      SC_CHECK_ABORT (ts->t8_element_child_id (children[ichild]) == ichild,
+                      "Wrong child id");
+      SC_CHECK_ABORT (ts->t8_element_get_linear_id (children[ichild],
+                                                    level + 1) ==
+                      first_child_id + ichild, "Wrong child order");
+      ts->t8_element_parent (children[ichild], parent);
+      SC_CHECK_ABORT (!ts->t8_element_compare (parent, elem),
+                      "Wrong parent");
+    }
+  }
+  ts->t8_element_destroy (num_children, children);
+  ts->t8_element_destroy (1, &parent);
+  ts->t8_element_destroy (1, &elem);
+}
+
+static void
+t8_test_linear_id (t8_scheme_cxx_t * scheme, int hilbert)
+{
+  int                 eclassi, level, maxlevel;
+  t8_eclass_t         eclass;
+
+  for (eclassi = T8_ECLASS_ZERO; eclassi < T8_ECLASS_COUNT; eclassi++) {
+    eclass = (t8_eclass_t) eclassi;
+    if (scheme->eclass_schemes[eclass] == NULL) {
+      continue;
+    }
+    t8_global_productionf ("Testing eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    /* We test up to roughly 4096 elements per class and level */
+    maxlevel = t8_eclass_to_dimension[eclass] == 0 ? 3 :
+      12 / t8_eclass_to_dimension[eclass];
+    for (level = 0; level <= maxlevel; level++) {
+      t8_test_linear_id_level (scheme->eclass_schemes[eclass], eclass,
+                               level);
+      if (hilbert && (eclass == T8_ECLASS_QUAD || eclass == T8_ECLASS_HEX)) {
+        t8_test_hilbert_level (scheme->eclass_schemes[eclass], eclass,
+                               level);
+      }
+    }
+  }
+  t8_scheme_cxx_unref (&scheme);
+  t8_global_productionf ("Test done\n");
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_linear_id (t8_scheme_new_default_cxx (), 0);
+  t8_test_linear_id (t8_scheme_new_hilbert_cxx (), 1);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,161 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_lnodes.h>
+#include <vector>
+
+/* This test program checks the vertex numbering of a forest.
+ * A uniform forest of level l on the hypercube has (2^l + 1)^d vertices
+ * and none of them is hanging. If we refine the first of the four quads of
+ * a uniform level 1 forest, there are 14 vertices of which 2 are hanging. */
+
+/* Count the vertices and the hanging vertices of a numbering and check
+ * that all ids are valid. */
+static void
+t8_test_lnodes_count (t8_forest_lnodes_t * lnodes, sc_MPI_Comm comm,
+                      t8_gloidx_t * num_hanging)
+{
+  t8_locidx_t         ientry, num_entries;
+  t8_gloidx_t         node, local_hanging = 0;
+  int                 mpiret;
+  std::vector < int > counted (lnodes->owned_count, 0);
+
+  num_entries = lnodes->element_offsets[lnodes->num_local_elements];
+  for (ientry = 0; ientry < num_entries; ientry++) {
+    node = lnodes->element_nodes[ientry];
+    SC_CHECK_ABORT (0 <= node && node < lnodes->global_num_nodes,
+                    "Invalid vertex id.\n");
+    node -= lnodes->global_offset;
+    if (0 <= node && node < lnodes->owned_count && !counted[node]) {
+      counted[node] = 1;
+      local_hanging += lnodes->num_parents[ientry] > 0;
+    }
+  }
+  mpiret = sc_MPI_Allreduce (&local_hanging, num_hanging, 1, T8_MPI_GLOIDX,
+                             sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+static void
+t8_test_lnodes_uniform (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_forest_t         forest;
+  t8_forest_lnodes_t *lnodes;
+  t8_gloidx_t         num_vertices, num_hanging;
+  int                 level = 2, idim;
+
+  t8_debugf ("Testing the vertex numbering with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  forest =
+    t8_forest_new_uniform (t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0),
+                           t8_scheme_new_default_cxx (), level, 1, comm);
+  lnodes = t8_forest_lnodes_new (forest);
+
+  num_vertices = 1;
+  for (idim = 0; idim < t8_eclass_to_dimension[eclass]; idim++) {
+    num_vertices *= (1 << level) + 1;
+  }
+  SC_CHECK_ABORTF (lnodes->global_num_nodes == num_vertices,
+                   "Wrong number of vertices %lli instead of %lli.\n",
+                   (long long) lnodes->global_num_nodes,
+                   (long long) num_vertices);
+  t8_test_lnodes_count (lnodes, comm, &num_hanging);
+  SC_CHECK_ABORT (num_hanging == 0, "A uniform forest has no hanging "
+                  "vertices.\n");
+
+  t8_forest_lnodes_destroy (&lnodes);
+  t8_forest_unref (&forest);
+}
+
+/* Refine the first element of the first tree */
+static int
+t8_test_lnodes_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                      t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                      t8_eclass_scheme_c * ts, int num_elements,
+                      t8_element_t * elements[])
+{
+  return t8_forest_global_tree_id (forest_from, which_tree) == 0
+    && ts->t8_element_get_linear_id (elements[0],
+                                     ts->t8_element_level (elements[0])) == 0;
+}
+
+static void
+t8_test_lnodes_hanging (sc_MPI_Comm comm)
+{
+  t8_forest_t         forest, forest_adapt;
+  t8_forest_lnodes_t *lnodes;
+  t8_gloidx_t         num_hanging;
+
+  forest =
+    t8_forest_new_uniform (t8_cmesh_new_hypercube
+                           (T8_ECLASS_QUAD, comm, 0, 0, 0),
+                           t8_scheme_new_default_cxx (), 1, 0, comm);
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_lnodes_adapt, 0);
+  t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_adapt);
+  lnodes = t8_forest_lnodes_new (forest_adapt);
+
+  SC_CHECK_ABORTF (lnodes->global_num_nodes == 14,
+                   "Wrong number of vertices %lli instead of 14.\n",
+                   (long long) lnodes->global_num_nodes);
+  t8_test_lnodes_count (lnodes, comm, &num_hanging);
+  SC_CHECK_ABORTF (num_hanging == 2,
+                   "Wrong number of hanging vertices %lli instead of 2.\n",
+                   (long long) num_hanging);
+
+  t8_forest_lnodes_destroy (&lnodes);
+  t8_forest_unref (&forest_adapt);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 ieclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (ieclass = T8_ECLASS_LINE; ieclass < T8_ECLASS_COUNT; ieclass++) {
+    if (ieclass != T8_ECLASS_PYRAMID) {
+      t8_test_lnodes_uniform (mpic, (t8_eclass_t) ieclass);
+    }
+  }
+  t8_test_lnodes_hanging (mpic);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,184 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_mesh.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we build the explicit mesh of uniform forests and compare
+ * it to the forest. The element data and the vertex coordinates must match
+ * the forest, the face connections must be symmetric and the global ids of
+ * the ghosts must belong to other processes. */
+
+static void
+t8_test_mesh_forest (t8_forest_t forest)
+{
+  t8_mesh_t          *mesh;
+  t8_locidx_t         itree, ielem, index, ineigh, ientry, num_all;
+  t8_locidx_t        *support;
+  const t8_locidx_t  *neighs, *back_neighs;
+  const int          *dual_faces, *back_dual_faces;
+  t8_element_t       *element;
+  t8_eclass_scheme_c *ts;
+  const double       *vertices;
+  double              coords[3];
+  int                 iface, num_faces, num_neighs, num_back, ivertex;
+  int                 length_support, found, idim, mpirank, mpiret, iback;
+
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mesh = t8_mesh_new_from_forest (forest);
+  SC_CHECK_ABORT (mesh->num_local_elements ==
+                  t8_forest_get_num_element (forest)
+                  && mesh->num_ghosts == t8_forest_get_num_ghosts (forest)
+                  && mesh->global_num_elements ==
+                  t8_forest_get_global_num_elements (forest),
+                  "Wrong number of mesh elements");
+  num_all = mesh->num_local_elements + mesh->num_ghosts;
+
+  /* The local elements */
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    vertices = t8_forest_get_tree_vertices (forest, itree);
+    for (ielem = 0; ielem < t8_forest_get_tree_num_elements (forest, itree);
+         ielem++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielem);
+      index = t8_forest_get_tree_element_offset (forest, itree) + ielem;
+      SC_CHECK_ABORT (t8_mesh_get_element_class (mesh, index) == ts->eclass
+                      && mesh->levels[index] ==
+                      ts->t8_element_level (element)
+                      && mesh->gtreeids[index] ==
+                      t8_forest_global_tree_id (forest, itree)
+                      && t8_mesh_get_element_locid (mesh,
+                                                    t8_mesh_get_element_gloid
+                                                    (mesh, index)) == index,
+                      "Wrong mesh element");
+      for (ivertex = 0; ivertex < t8_eclass_num_vertices[ts->eclass];
+           ivertex++) {
+        t8_forest_element_coordinate (forest, itree, element, vertices,
+                                      ivertex, coords);
+        ientry = mesh->vertex_offsets[index] + ivertex;
+        for (idim = 0; idim < 3; idim++) {
+          SC_CHECK_ABORT (fabs (coords[idim] -
+                                mesh->vertex_coords[3 * ientry + idim]) <
+                          1e-12, "Wrong mesh vertex");
+        }
+      }
+    }
+  }
+
+  /* The ghosts belong to other processes */
+  for (index = mesh->num_local_elements; index < num_all; index++) {
+    SC_CHECK_ABORT (mesh->ghost_owners[index - mesh->num_local_elements]
+                    != mpirank
+                    && t8_mesh_get_element_locid (mesh,
+                                                  mesh->gloids[index]) < 0
+                    && 0 <= mesh->gloids[index]
+                    && mesh->gloids[index] < mesh->global_num_elements,
+                    "Wrong mesh ghost");
+  }
+
+  /* The face connections are symmetric */
+  support = T8_ALLOC (t8_locidx_t, SC_MAX (t8_mesh_get_maximum_support
+                                           (mesh), 1));
+  for (index = 0; index < mesh->num_local_elements; index++) {
+    num_faces = mesh->face_offsets[index + 1] - mesh->face_offsets[index];
+    length_support = t8_mesh_get_maximum_support (mesh);
+    t8_mesh_get_element_support (mesh, index, &length_support, support,
+                                 NULL);
+    ientry = 0;
+    for (iface = 0; iface < num_faces; iface++) {
+      num_neighs = t8_mesh_get_element_boundary (mesh, index, iface,
+                                                 &neighs, &dual_faces);
+      for (ineigh = 0; ineigh < num_neighs; ineigh++, ientry++) {
+        SC_CHECK_ABORT (support[ientry] == neighs[ineigh]
+                        && 0 <= neighs[ineigh] && neighs[ineigh] < num_all,
+                        "Wrong mesh support");
+        if (neighs[ineigh] >= mesh->num_local_elements) {
+          continue;
+        }
+        num_back = t8_mesh_get_element_boundary (mesh, neighs[ineigh],
+                                                 dual_faces[ineigh],
+                                                 &back_neighs,
+                                                 &back_dual_faces);
+        found = 0;
+        for (iback = 0; iback < num_back; iback++) {
+          found |= back_neighs[iback] == index
+            && back_dual_faces[iback] == iface;
+        }
+        SC_CHECK_ABORT (found, "The mesh face connection is not symmetric");
+      }
+    }
+    SC_CHECK_ABORT (ientry == length_support, "Wrong mesh support length");
+  }
+  T8_FREE (support);
+  t8_mesh_destroy (mesh);
+}
+
+static void
+t8_test_mesh ()
+{
+  int                 eclass, level;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    for (level = 0; level < 3; level++) {
+      t8_global_productionf ("Testing the mesh with eclass %s, level %i\n",
+                             t8_eclass_to_string[eclass], level);
+      t8_cmesh_ref (cmesh);
+      forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (),
+                                      level, 1, sc_MPI_COMM_WORLD);
+      t8_test_mesh_forest (forest);
+      t8_forest_unref (&forest);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_mesh ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
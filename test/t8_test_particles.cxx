@@ -0,0 +1,169 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_particles.h>
+
+/* This test program checks the particle migration of a forest.
+ * We place particles on a grid in the unit hypercube and give each one to
+ * a process in round robin fashion. After the migration, each particle must
+ * lie in a local leaf of its process and no particle may be lost.
+ * The payload of each particle is its grid index, with which we check that
+ * the coordinates arrived with their payloads.
+ * Finally, we check that binning the particles by leaf lists each particle
+ * at its leaf. */
+
+/* The number of grid points per coordinate direction */
+#define T8_TEST_PARTICLES_N 7
+
+/* Compute the coordinates of the grid point with index id */
+static void
+t8_test_particles_point (int dim, int64_t id, double *point)
+{
+  int                 i;
+
+  point[0] = point[1] = point[2] = 0;
+  for (i = 0; i < dim; i++) {
+    point[i] = (id % T8_TEST_PARTICLES_N + .5) / T8_TEST_PARTICLES_N;
+    id /= T8_TEST_PARTICLES_N;
+  }
+}
+
+static void
+t8_test_particles (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_forest_t         forest;
+  t8_forest_locator_t locator;
+  sc_array_t          coordinates, payloads, element_indices;
+  t8_locidx_t         num_elements, ielem, lelement;
+  size_t              ipart, num_particles, num_lost, *leaf_offsets, *ids;
+  int64_t             id, num_points;
+  long long           local_count, global_count;
+  double             *point, expected[3];
+  int                 dim, i, mpirank, mpisize, mpiret;
+
+  t8_debugf ("Testing particle migration with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  forest =
+    t8_forest_new_uniform (t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0),
+                           t8_scheme_new_default_cxx (), 2, 1, comm);
+  locator = t8_forest_locator_new (forest, 1e-10);
+
+  dim = t8_eclass_to_dimension[eclass];
+  num_points = 1;
+  for (i = 0; i < dim; i++) {
+    num_points *= T8_TEST_PARTICLES_N;
+  }
+  sc_array_init (&coordinates, 3 * sizeof (double));
+  sc_array_init (&payloads, sizeof (int64_t));
+  sc_array_init (&element_indices, sizeof (t8_locidx_t));
+  for (id = mpirank; id < num_points; id += mpisize) {
+    t8_test_particles_point (dim, id, (double *) sc_array_push (&coordinates));
+    *(int64_t *) sc_array_push (&payloads) = id;
+  }
+
+  num_lost = t8_forest_particles_migrate (locator, &coordinates, &payloads,
+                                          &element_indices);
+  SC_CHECK_ABORTF (num_lost == 0, "Lost %zu particles.\n", num_lost);
+  num_particles = coordinates.elem_count;
+  SC_CHECK_ABORT (payloads.elem_count == num_particles
+                  && element_indices.elem_count == num_particles,
+                  "Wrong number of payloads or leafs.\n");
+  local_count = num_particles;
+  mpiret = sc_MPI_Allreduce (&local_count, &global_count, 1,
+                             sc_MPI_LONG_LONG_INT, sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (global_count == num_points,
+                  "The number of particles changed.\n");
+  for (ipart = 0; ipart < num_particles; ipart++) {
+    point = (double *) sc_array_index (&coordinates, ipart);
+    id = *(int64_t *) sc_array_index (&payloads, ipart);
+    t8_test_particles_point (dim, id, expected);
+    for (i = 0; i < 3; i++) {
+      SC_CHECK_ABORT (point[i] == expected[i],
+                      "A payload does not match its particle.\n");
+    }
+    lelement = *(t8_locidx_t *) sc_array_index (&element_indices, ipart);
+    SC_CHECK_ABORT (lelement >= 0
+                    && lelement == t8_forest_locator_find (locator, point,
+                                                           NULL, NULL),
+                    "A particle is not in its local leaf.\n");
+  }
+
+  num_elements = t8_forest_get_num_element (forest);
+  leaf_offsets = T8_ALLOC (size_t, num_elements + 1);
+  ids = T8_ALLOC (size_t, SC_MAX (num_particles, 1));
+  t8_forest_particles_bin (forest, num_particles,
+                           (t8_locidx_t *) element_indices.array,
+                           leaf_offsets, ids);
+  SC_CHECK_ABORT (leaf_offsets[num_elements] == num_particles,
+                  "Binning missed particles.\n");
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    for (ipart = leaf_offsets[ielem]; ipart < leaf_offsets[ielem + 1];
+         ipart++) {
+      SC_CHECK_ABORT (*(t8_locidx_t *)
+                      sc_array_index (&element_indices, ids[ipart])
+                      == ielem, "A particle is binned at a wrong leaf.\n");
+    }
+  }
+
+  T8_FREE (leaf_offsets);
+  T8_FREE (ids);
+  sc_array_reset (&coordinates);
+  sc_array_reset (&payloads);
+  sc_array_reset (&element_indices);
+  t8_forest_locator_destroy (&locator);
+  t8_forest_unref (&forest);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  /* The hypercubes of these classes consist of a single tree */
+  t8_test_particles (mpic, T8_ECLASS_QUAD);
+  t8_test_particles (mpic, T8_ECLASS_HEX);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,137 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_peer_volume.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test we record the messages of a refinement with partition and
+ * ghost creation. Each byte that is sent must be received, thus the sums
+ * of the bytes and messages sent and received over all ranks must agree
+ * for each phase. We also write the table of all ranks to a CSV file. */
+
+/* Refine the first elements of the first tree */
+static int
+t8_test_peer_volume_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                           t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                           t8_eclass_scheme_c * ts, int num_elements,
+                           t8_element_t * elements[])
+{
+  return t8_forest_global_tree_id (forest_from, which_tree) == 0
+    && lelement_id < 8;
+}
+
+static void
+t8_test_peer_volume (sc_MPI_Comm comm)
+{
+  t8_forest_t         forest, forest_adapt;
+  sc_array_t          volumes;
+  t8_peer_volume_t   *volume;
+  t8_gloidx_t         sums[4 * T8_PEER_PHASE_COUNT];
+  t8_gloidx_t         global_sums[4 * T8_PEER_PHASE_COUNT];
+  size_t              ivolume;
+  int                 mpirank, mpiret, iphase;
+  FILE               *file;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  forest = t8_forest_new_uniform (t8_cmesh_new_hypercube (T8_ECLASS_HEX,
+                                                          comm, 0, 0, 0),
+                                  t8_scheme_new_default_cxx (), 2, 0, comm);
+  t8_peer_volume_enable ();
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_peer_volume_adapt, 0);
+  t8_forest_set_partition (forest_adapt, NULL, 0);
+  t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_adapt);
+  forest = forest_adapt;
+
+  sc_array_init (&volumes, sizeof (t8_peer_volume_t));
+  t8_peer_volume_get (&volumes);
+  memset (sums, 0, sizeof (sums));
+  for (ivolume = 0; ivolume < volumes.elem_count; ivolume++) {
+    volume = (t8_peer_volume_t *) sc_array_index (&volumes, ivolume);
+    SC_CHECK_ABORT (volume->peer != mpirank, "Recorded a message to self");
+    if (ivolume > 0) {
+      SC_CHECK_ABORT (volume->phase > volume[-1].phase
+                      || (volume->phase == volume[-1].phase
+                          && volume->peer > volume[-1].peer),
+                      "Volumes are not sorted");
+    }
+    sums[4 * volume->phase] += volume->bytes_sent;
+    sums[4 * volume->phase + 1] += volume->messages_sent;
+    sums[4 * volume->phase + 2] += volume->bytes_received;
+    sums[4 * volume->phase + 3] += volume->messages_received;
+  }
+  mpiret = sc_MPI_Allreduce (sums, global_sums, 4 * T8_PEER_PHASE_COUNT,
+                             T8_MPI_GLOIDX, sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  for (iphase = 0; iphase < T8_PEER_PHASE_COUNT; iphase++) {
+    SC_CHECK_ABORT (global_sums[4 * iphase] == global_sums[4 * iphase + 2],
+                    "Bytes sent and received differ");
+    SC_CHECK_ABORT (global_sums[4 * iphase + 1]
+                    == global_sums[4 * iphase + 3],
+                    "Messages sent and received differ");
+  }
+
+  SC_CHECK_ABORT (t8_peer_volume_write_csv ("test_peer_volume", comm, 1),
+                  "Writing the volumes failed");
+  if (mpirank == 0) {
+    file = fopen ("test_peer_volume.csv", "r");
+    SC_CHECK_ABORT (file != NULL, "Could not open the volume file");
+    fclose (file);
+  }
+
+  /* Reset removes all entries */
+  t8_peer_volume_reset ();
+  t8_peer_volume_get (&volumes);
+  SC_CHECK_ABORT (volumes.elem_count == 0, "Reset kept entries");
+  t8_peer_volume_disable ();
+  sc_array_reset (&volumes);
+  t8_forest_unref (&forest);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_peer_volume (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
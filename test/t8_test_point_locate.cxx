@@ -0,0 +1,224 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_locate.h>
+#include <t8_forest/t8_forest_bvh.h>
+
+/* This test program checks the point locator of a forest.
+ * For each leaf of a uniform forest on the hypercube we locate its
+ * centroid and check that the leaf itself is found. We also check that a
+ * point outside of the domain is not found.
+ * Then we check that the tree hierarchy finds each tree at the centroid
+ * of its vertices and all trees in a box around the domain.
+ * Finally, all processes locate the same points with the distributed
+ * query and we check that they agree and that the owners find the points. */
+
+static void
+t8_test_tree_bvh (t8_forest_t forest)
+{
+  sc_array_t          trees;
+  double             *vertices, center[3];
+  const double        domain[6] = { -1, -1, -1, 2, 2, 2 };
+  t8_locidx_t         itree, num_trees, num_found, ifound;
+  int                 ivertex, num_vertices, i, found;
+
+  sc_array_init (&trees, sizeof (t8_locidx_t));
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    vertices = t8_forest_get_tree_vertices (forest, itree);
+    num_vertices =
+      t8_eclass_num_vertices[t8_forest_get_tree_class (forest, itree)];
+    center[0] = center[1] = center[2] = 0;
+    for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+      for (i = 0; i < 3; i++) {
+        center[i] += vertices[3 * ivertex + i] / num_vertices;
+      }
+    }
+    sc_array_truncate (&trees);
+    num_found = t8_forest_tree_bvh_query_point (forest, center, 1e-10,
+                                                &trees);
+    SC_CHECK_ABORT (num_found == (t8_locidx_t) trees.elem_count,
+                    "Wrong number of trees returned.\n");
+    found = 0;
+    for (ifound = 0; ifound < num_found; ifound++) {
+      found = found || *(t8_locidx_t *) sc_array_index (&trees, ifound)
+        == itree;
+    }
+    SC_CHECK_ABORT (found, "The tree hierarchy missed a tree.\n");
+  }
+  sc_array_truncate (&trees);
+  num_found = t8_forest_tree_bvh_query_box (forest, domain, &trees);
+  SC_CHECK_ABORT (num_found == num_trees
+                  + t8_forest_get_num_ghost_trees (forest),
+                  "The tree hierarchy missed a tree in the domain.\n");
+  sc_array_reset (&trees);
+}
+
+/* Locate the same grid of points on all processes */
+static void
+t8_test_point_locate_global (t8_forest_t forest,
+                             t8_forest_locator_t locator, int dim,
+                             sc_MPI_Comm comm)
+{
+  const int           num_per_dim = 5;
+  const double        shift[3] = { .37, .29, .13 };
+  t8_forest_locate_result_t *results;
+  t8_gloidx_t        *ids, *min_ids, *max_ids;
+  t8_locidx_t         found;
+  double             *points;
+  int                 num_points, ipoint, i, mpirank, mpiret;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  num_points = 1;
+  for (i = 0; i < dim; i++) {
+    num_points *= num_per_dim;
+  }
+  /* The last point lies outside of the domain */
+  num_points++;
+  points = T8_ALLOC_ZERO (double, 3 * num_points);
+  for (ipoint = 0; ipoint < num_points - 1; ipoint++) {
+    int                 index = ipoint;
+
+    for (i = 0; i < dim; i++) {
+      /* The shifts keep the points off the faces of the elements */
+      points[3 * ipoint + i] = (index % num_per_dim + shift[i]) / num_per_dim;
+      index /= num_per_dim;
+    }
+  }
+  for (i = 0; i < 3; i++) {
+    points[3 * (num_points - 1) + i] = 2;
+  }
+  results = T8_ALLOC (t8_forest_locate_result_t, num_points);
+  t8_forest_locator_find_points_global (locator, num_points, points,
+                                        results);
+  SC_CHECK_ABORT (results[num_points - 1].rank == -1,
+                  "Located a point outside of the domain globally.\n");
+
+  ids = T8_ALLOC (t8_gloidx_t, num_points - 1);
+  min_ids = T8_ALLOC (t8_gloidx_t, num_points - 1);
+  max_ids = T8_ALLOC (t8_gloidx_t, num_points - 1);
+  for (ipoint = 0; ipoint < num_points - 1; ipoint++) {
+    SC_CHECK_ABORT (results[ipoint].rank >= 0,
+                    "A point in the domain was not located globally.\n");
+    ids[ipoint] = results[ipoint].element_id;
+    if (results[ipoint].rank == mpirank) {
+      found = t8_forest_locator_find (locator, points + 3 * ipoint, NULL,
+                                      NULL);
+      SC_CHECK_ABORT (found >= 0 && found
+                      + t8_forest_get_first_local_element_id (forest)
+                      == results[ipoint].element_id,
+                      "The owner did not locate the point.\n");
+    }
+  }
+  /* All processes located the same elements */
+  mpiret = sc_MPI_Allreduce (ids, min_ids, num_points - 1, T8_MPI_GLOIDX,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Allreduce (ids, max_ids, num_points - 1, T8_MPI_GLOIDX,
+                             sc_MPI_MAX, comm);
+  SC_CHECK_MPI (mpiret);
+  for (ipoint = 0; ipoint < num_points - 1; ipoint++) {
+    SC_CHECK_ABORT (min_ids[ipoint] == max_ids[ipoint],
+                    "The processes located different elements.\n");
+  }
+  T8_FREE (ids);
+  T8_FREE (min_ids);
+  T8_FREE (max_ids);
+  T8_FREE (results);
+  T8_FREE (points);
+}
+
+static void
+t8_test_point_locate (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_forest_t         forest;
+  t8_forest_locator_t locator;
+  t8_element_t       *element;
+  t8_locidx_t         itree, ielement, lelement, found, found_tree;
+  double             *vertices, centroid[3], ref[3];
+  const double        outside[3] = { 2, 2, 2 };
+  int                 level = 2;
+
+  t8_debugf ("Testing point location with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  forest =
+    t8_forest_new_uniform (t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0),
+                           t8_scheme_new_default_cxx (), level, 0, comm);
+  locator = t8_forest_locator_new (forest, 1e-10);
+
+  lelement = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    vertices = t8_forest_get_tree_vertices (forest, itree);
+    for (ielement = 0;
+         ielement < t8_forest_get_tree_num_elements (forest, itree);
+         ielement++, lelement++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielement);
+      t8_forest_element_centroid (forest, itree, element, vertices,
+                                  centroid);
+      found = t8_forest_locator_find (locator, centroid, &found_tree, ref);
+      SC_CHECK_ABORTF (found == lelement && found_tree == itree,
+                       "Located element %li instead of %li.\n",
+                       (long) found, (long) lelement);
+    }
+  }
+  found = t8_forest_locator_find (locator, outside, NULL, NULL);
+  SC_CHECK_ABORT (found == -1, "Located a point outside of the domain.\n");
+  t8_test_tree_bvh (forest);
+  t8_test_point_locate_global (forest, locator,
+                               t8_eclass_to_dimension[eclass], comm);
+
+  t8_forest_locator_destroy (&locator);
+  t8_forest_unref (&forest);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 ieclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (ieclass = T8_ECLASS_LINE; ieclass < T8_ECLASS_COUNT; ieclass++) {
+    if (ieclass != T8_ECLASS_PYRAMID) {
+      t8_test_point_locate (mpic, (t8_eclass_t) ieclass);
+    }
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
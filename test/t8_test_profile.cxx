@@ -0,0 +1,121 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test we refine a forest with profiling in several commits and
+ * accumulate the profile of each commit. We check the accumulated numbers
+ * of elements and that the reduced values are consistent over the ranks. */
+
+#define T8_TEST_PROFILE_COMMITS 3
+
+/* Refine the first element of each tree */
+static int
+t8_test_profile_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                       t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                       t8_eclass_scheme_c * ts, int num_elements,
+                       t8_element_t * elements[])
+{
+  return lelement_id == 0;
+}
+
+static void
+t8_test_profile (sc_MPI_Comm comm)
+{
+  t8_forest_t         forest, forest_adapt;
+  t8_forest_profile_accum_t accum;
+  t8_profile_value_t  values[T8_FOREST_PROFILE_COUNT];
+  double              num_elements = 0, max;
+  int                 icommit, ivalue, mpisize, mpiret;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  forest = t8_forest_new_uniform (t8_cmesh_new_hypercube (T8_ECLASS_QUAD,
+                                                          comm, 0, 0, 0),
+                                  t8_scheme_new_default_cxx (), 2, 0, comm);
+  t8_forest_profile_accum_init (&accum);
+  for (icommit = 0; icommit < T8_TEST_PROFILE_COMMITS; icommit++) {
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_profile_adapt, 0);
+    t8_forest_set_partition (forest_adapt, NULL, 0);
+    t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+    t8_forest_set_profiling (forest_adapt, 1);
+    t8_forest_commit (forest_adapt);
+    forest = forest_adapt;
+    t8_forest_profile_accumulate (&accum, forest);
+    num_elements += t8_forest_get_num_element (forest);
+  }
+  SC_CHECK_ABORT (accum.num_commits == T8_TEST_PROFILE_COMMITS,
+                  "Wrong number of accumulated commits");
+  SC_CHECK_ABORT (accum.sums[T8_FOREST_PROFILE_ELEMENTS] == num_elements,
+                  "Wrong accumulated number of elements");
+
+  t8_forest_profile_accum_reduce (&accum, comm, values);
+  for (ivalue = 0; ivalue < T8_FOREST_PROFILE_COUNT; ivalue++) {
+    SC_CHECK_ABORT (values[ivalue].local == accum.sums[ivalue],
+                    "Wrong local value");
+    SC_CHECK_ABORT (values[ivalue].min <= values[ivalue].avg
+                    && values[ivalue].avg <= values[ivalue].max,
+                    "Wrong order of min, avg and max");
+    SC_CHECK_ABORT (0 <= values[ivalue].rank_of_max
+                    && values[ivalue].rank_of_max < mpisize,
+                    "Wrong rank of the maximum");
+    SC_CHECK_ABORT (values[ivalue].imbalance >= 1,
+                    "Wrong imbalance");
+    /* The rank of the maximum must own it */
+    max = values[ivalue].local;
+    mpiret = sc_MPI_Bcast (&max, 1, sc_MPI_DOUBLE,
+                           values[ivalue].rank_of_max, comm);
+    SC_CHECK_MPI (mpiret);
+    SC_CHECK_ABORT (max == values[ivalue].max,
+                    "The rank of the maximum has another value");
+  }
+  t8_forest_profile_accum_print (&accum, comm);
+  t8_forest_unref (&forest);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_profile (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,125 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_quadrature.h>
+#include <t8_vec.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test we check that the weights of the reference quadrature rules
+ * add up to the volumes of the reference elements. Then we integrate
+ * 1 and x^2 y over a uniform forest on the unit hypercube of each element
+ * class with the physical quadrature points and weights of all leafs. */
+
+/* The volumes of the reference elements */
+static const double t8_test_quadrature_volume[T8_ECLASS_COUNT] = {
+  1, 1, 1, .5, 1, 1. / 6, .5, 1. / 3
+};
+
+static void
+t8_test_quadrature (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_forest_t         forest;
+  t8_quadrature_t    *quad;
+  t8_locidx_t         itree, num_leafs;
+  double             *points, *weights, x[3];
+  double              local[2], global[2], exact;
+  size_t              ientry, num_entries;
+  int                 degree, ipoint, mpiret;
+
+  t8_debugf ("Testing quadrature with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  for (degree = 0; degree < 6; degree++) {
+    quad = t8_quadrature_new (eclass, degree);
+    local[0] = 0;
+    for (ipoint = 0; ipoint < quad->num_points; ipoint++) {
+      SC_CHECK_ABORT (quad->weights[ipoint] > 0, "Negative weight.\n");
+      local[0] += quad->weights[ipoint];
+    }
+    SC_CHECK_ABORT (fabs (local[0] - t8_test_quadrature_volume[eclass])
+                    < 1e-14, "Wrong sum of reference weights.\n");
+    t8_quadrature_destroy (&quad);
+  }
+
+  forest =
+    t8_forest_new_uniform (t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0),
+                           t8_scheme_new_default_cxx (), 2, 0, comm);
+  /* x^2 y has degree 3 */
+  quad = t8_quadrature_new (eclass, 3);
+  local[0] = local[1] = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    num_leafs = t8_forest_get_tree_num_elements (forest, itree);
+    num_entries = (size_t) num_leafs * quad->num_points;
+    points = T8_ALLOC (double, 3 * num_entries);
+    weights = T8_ALLOC (double, num_entries);
+    t8_forest_tree_leaf_quadrature (forest, itree, 0, num_leafs, quad,
+                                    points, weights);
+    for (ientry = 0; ientry < num_entries; ientry++) {
+      t8_vec_batch_get (points, num_entries, ientry, x);
+      local[0] += weights[ientry];
+      local[1] += weights[ientry] * x[0] * x[0] * x[1];
+    }
+    T8_FREE (points);
+    T8_FREE (weights);
+  }
+  mpiret = sc_MPI_Allreduce (local, global, 2, sc_MPI_DOUBLE, sc_MPI_SUM,
+                             comm);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (fabs (global[0] - 1) < 1e-12,
+                  "Wrong volume of the forest.\n");
+  /* The integral of x^2 y over the unit square or cube, 0 for a line */
+  exact = t8_eclass_to_dimension[eclass] > 1 ? 1. / 6 : 0;
+  SC_CHECK_ABORT (fabs (global[1] - exact) < 1e-12,
+                  "Wrong integral over the forest.\n");
+  t8_quadrature_destroy (&quad);
+  t8_forest_unref (&forest);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 ieclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (ieclass = T8_ECLASS_LINE; ieclass < T8_ECLASS_COUNT; ieclass++) {
+    if (ieclass != T8_ECLASS_PYRAMID) {
+      t8_test_quadrature (mpic, (t8_eclass_t) ieclass);
+    }
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_data/t8_shmem.h>
+
+/* Check that the node ordered communicator contains the same processes
+ * and numbers the processes of each node consecutively. */
+static void
+t8_test_comm_node_ordered (sc_MPI_Comm comm)
+{
+  sc_MPI_Comm         node_ordered, intranode, internode;
+  int                 mpisize, ordered_size, ordered_rank;
+  int                 intrasize, min_rank, max_rank, mpiret;
+
+  /* We keep the node communicators of comm until the end of the test */
+  t8_shmem_init (comm);
+  t8_shmem_comm_node_ordered (comm, &node_ordered);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (node_ordered, &ordered_size);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (ordered_size == mpisize,
+                  "The node ordered communicator has the wrong size");
+  mpiret = sc_MPI_Comm_rank (node_ordered, &ordered_rank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  if (intranode != sc_MPI_COMM_NULL) {
+    /* The new ranks of a node form a contiguous range */
+    mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Allreduce (&ordered_rank, &min_rank, 1, sc_MPI_INT,
+                               sc_MPI_MIN, intranode);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Allreduce (&ordered_rank, &max_rank, 1, sc_MPI_INT,
+                               sc_MPI_MAX, intranode);
+    SC_CHECK_MPI (mpiret);
+    SC_CHECK_ABORT (max_rank - min_rank + 1 == intrasize,
+                    "The ranks of a node are not consecutive");
+  }
+  t8_shmem_finalize (comm);
+  mpiret = sc_MPI_Comm_free (&node_ordered);
+  SC_CHECK_MPI (mpiret);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing node ordered communicator.\n");
+  t8_test_comm_node_ordered (sc_MPI_COMM_WORLD);
+  t8_global_productionf ("Done testing node ordered communicator.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
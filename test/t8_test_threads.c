@@ -0,0 +1,110 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+
+#include <t8_threads.h>
+
+/* In this test we check that t8_parallel_for visits each index of a range
+ * exactly once and that a task group runs each of its tasks exactly once,
+ * also when the group is reused. */
+
+#define T8_TEST_THREADS_RANGE 1000
+#define T8_TEST_THREADS_TASKS 37
+
+static void
+t8_test_threads_count (size_t begin, size_t end, int thread_id,
+                       void *user_data)
+{
+  int                *counts = (int *) user_data;
+  size_t              i;
+
+  SC_CHECK_ABORT (0 <= thread_id && thread_id < t8_get_num_threads (),
+                  "Wrong thread id");
+  SC_CHECK_ABORT (begin < end && end - begin <= 7, "Wrong chunk");
+  for (i = begin; i < end; i++) {
+    counts[i]++;
+  }
+}
+
+static void
+t8_test_threads_task (void *task_data, int thread_id)
+{
+  SC_CHECK_ABORT (0 <= thread_id && thread_id < t8_get_num_threads (),
+                  "Wrong thread id");
+  (*(int *) task_data)++;
+}
+
+static void
+t8_test_threads (void)
+{
+  int                 counts[T8_TEST_THREADS_RANGE];
+  int                 tasks[T8_TEST_THREADS_TASKS];
+  int                 i, round;
+  t8_task_group_t     group;
+
+  SC_CHECK_ABORT (t8_get_num_threads () >= 1, "Wrong number of threads");
+  memset (counts, 0, sizeof (counts));
+  t8_parallel_for (3, T8_TEST_THREADS_RANGE, 7, t8_test_threads_count,
+                   counts);
+  for (i = 0; i < T8_TEST_THREADS_RANGE; i++) {
+    SC_CHECK_ABORT (counts[i] == (i >= 3), "Index visited wrongly");
+  }
+  /* An empty range does not call the function */
+  t8_parallel_for (5, 5, 1, t8_test_threads_count, counts);
+
+  memset (tasks, 0, sizeof (tasks));
+  t8_task_group_init (&group);
+  for (round = 1; round <= 2; round++) {
+    for (i = 0; i < T8_TEST_THREADS_TASKS; i++) {
+      t8_task_group_add (&group, t8_test_threads_task, tasks + i);
+    }
+    t8_task_group_run (&group);
+    for (i = 0; i < T8_TEST_THREADS_TASKS; i++) {
+      SC_CHECK_ABORT (tasks[i] == round, "Task run wrongly");
+    }
+  }
+  t8_task_group_reset (&group);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_threads ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+
+#include <t8_trace.h>
+
+/* In this test we record nested events, check that a full ring buffer
+ * keeps the newest events, and write the trace per rank and merged.
+ * We check that each written file is a JSON object with the events. */
+
+/* Check that a file starts with the trace header and contains a name */
+static void
+t8_test_trace_check_file (const char *filename, const char *name)
+{
+  FILE               *file;
+  char                buffer[BUFSIZ];
+  size_t              length;
+
+  file = fopen (filename, "r");
+  SC_CHECK_ABORT (file != NULL, "Could not open trace file");
+  length = fread (buffer, 1, BUFSIZ - 1, file);
+  buffer[length] = '\0';
+  fclose (file);
+  SC_CHECK_ABORT (!strncmp (buffer, "{\"traceEvents\":[\n{", 18),
+                  "Wrong trace header");
+  SC_CHECK_ABORT (strstr (buffer, name) != NULL, "Event not written");
+}
+
+static void
+t8_test_trace (sc_MPI_Comm comm)
+{
+  char                filename[BUFSIZ];
+  int                 rank, mpiret, i;
+
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* Events are ignored while tracing is disabled */
+  t8_trace_begin ("ignored");
+  t8_trace_end ("ignored");
+  SC_CHECK_ABORT (!t8_trace_is_enabled () && t8_trace_num_events () == 0,
+                  "Recorded events while disabled");
+
+  t8_trace_enable (comm, 8);
+  t8_trace_begin ("outer");
+  t8_trace_begin ("inner");
+  t8_trace_end ("inner");
+  t8_trace_end ("outer");
+  SC_CHECK_ABORT (t8_trace_num_events () == 4, "Wrong number of events");
+  for (i = 0; i < 3; i++) {
+    t8_trace_begin ("round");
+    t8_trace_end ("round");
+  }
+  SC_CHECK_ABORT (t8_trace_num_events () == 8
+                  && t8_trace_num_dropped () == 2,
+                  "Wrong number of events in a full buffer");
+
+  SC_CHECK_ABORT (t8_trace_write ("test_trace", comm, 0),
+                  "Writing the trace per rank failed");
+  snprintf (filename, BUFSIZ, "test_trace_%04d.json", rank);
+  t8_test_trace_check_file (filename, "\"round\"");
+  SC_CHECK_ABORT (t8_trace_write ("test_trace", comm, 1),
+                  "Writing the merged trace failed");
+  if (rank == 0) {
+    t8_test_trace_check_file ("test_trace.json", "\"inner\"");
+  }
+  t8_trace_disable ();
+  SC_CHECK_ABORT (t8_trace_num_events () == 0, "Disable kept the events");
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_trace (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}